@@ -1,7 +1,9 @@
 #ifndef AMBIENT_H
 #define AMBIENT_H
 
-#include <Wire.h>
+#include <Arduino.h>
+#include "i2c_bus.h"
+#include "sensor_window.h"
 
 #define AMB_I2C_SDA 32 
 #define AMB_I2C_SCL 33
@@ -10,7 +12,18 @@
 #define ONE_TIME_H_RESOLUTION_MODE 0x20 // 1lux for 120ms
 #define ONE_TIME_H_RESOLUTION_MODE2 0x21 // 0.5lux for 120ms
 #define ONE_TIME_L_RESOLUTION_MODE 0x23 // 4lux for 16ms
+#define CONTINUOUS_H_RESOLUTION_MODE 0x10 // 1lux for 120ms
+#define CONTINUOUS_H_RESOLUTION_MODE2 0x11 // 0.5lux for 120ms
+#define CONTINUOUS_L_RESOLUTION_MODE 0x13 // 4lux for 16ms
 
+/**
+ * BH1750环境光传感器
+ * 工作在连续测量模式，模式字节只在init时写一次；
+ * 传感器总线（sensor_bus.h）在传感器任务中按测量周期调用sample()提交异步读取，
+ * 回调中更新5点滑动平均并以32位原子写发布，同时把读数发布到总线的SENSOR_AMBIENT快照；
+ * getLux()只读取已发布的值，不产生总线访问；
+ * 每个读数同时计入统计窗口，takeWindow()取走上次以来的最小/最大/平均（传感器中枢用，见sensor_hub.h）
+ */
 class Ambient
 {
 private:
@@ -22,11 +35,28 @@ private:
 
 	unsigned int lux[5];
 	long sample_time = 125;
-	long last_time;
+
+	// 异步读取：tx/rx缓冲区需保持到总线任务回调
+	uint8_t cmd;
+	uint8_t raw[2];
+	volatile bool busy;
+	int64_t submit_us;      // 本次读取的提交时间（渲染计时用）
+	volatile bool valid;    // 至少成功读到过一次（传感器存在）
+	volatile uint32_t published;
+	SensorWindow window;    // 上次takeWindow以来的照度（lx，未经滑动平均）
+
+	static void onRead(esp_err_t err, void* user);
 
 public:
 	void init(int mode);
+	// 提交一次异步读取（上次还未完成时跳过），由传感器总线按getPeriod()调用
+	void sample();
+	// 测量周期（毫秒）
+	uint16_t getPeriod();
 	unsigned int getLux();
+	bool available();
+	// 取走统计窗口并清零（任意任务，不访问总线）
+	void takeWindow(SensorWindow* out);
 };
 
-#endif
\ No newline at end of file
+#endif
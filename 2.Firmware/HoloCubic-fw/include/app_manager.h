@@ -0,0 +1,145 @@
+#ifndef APP_MANAGER_H
+#define APP_MANAGER_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+
+#define APP_MAX 8
+// 前台默认周期约30Hz（fg_period_ms为0时使用）；后台建议周期1Hz
+#define APP_FG_PERIOD_MS 33
+#define APP_BG_PERIOD_MS 1000
+// 单次回调超出CPU预算时周期加倍，最多放慢到原周期的APP_THROTTLE_MAX倍
+#define APP_THROTTLE_MAX 8
+// 已放慢到最大倍数仍连续超预算的次数，超过后停止该应用（前台应用只限速不停止）
+#define APP_CPU_STRIKES 5
+// 连续多少次回调低于预算一半后恢复一级周期
+#define APP_RECOVER_RUNS 10
+// 应用停止后仍未释放的内存超过该值时输出警告
+#define APP_LEAK_WARN 256
+// on_enter期间样式属性表与本地样式的分配区（字节，见lv_style_arena_open），界面对象全部删除后整块释放
+#define APP_STYLE_ARENA 1024
+
+typedef void (*app_hook_t)(void* user);
+
+/**
+ * 应用资源（预热器在切换到该应用之前提前加载，见app_prefetch.h）
+ * APP_ASSET_IMAGE:  src为LVGL图像源（"S:/..."路径或lv_img_dsc_t*）
+ * APP_ASSET_BUNDLE: src为资源包中的图像名（assets.getImage）
+ * APP_ASSET_FONT:   src为lv_font_t*（NULL为当前语言的界面字体i18n.getFont()），text为界面上会用到的文字
+ * APP_ASSET_FILE:   src为LVGL文件路径
+ */
+enum AppAssetType
+{
+	APP_ASSET_IMAGE = 0,
+	APP_ASSET_BUNDLE,
+	APP_ASSET_FONT,
+	APP_ASSET_FILE
+};
+
+struct AppAsset
+{
+	uint8_t type;
+	const void* src;
+	const char* text;
+};
+
+/**
+ * 应用定义
+ * on_enter:      切换到前台，创建界面（可调用gui_load）
+ * on_loop:       周期回调，前台按fg_period_ms，后台按bg_period_ms（用apps.isForeground()区分）
+ * on_background: 离开前台，释放界面对象，只保留后台需要的状态
+ * on_exit:       停止，释放全部资源
+ * 回调均在LVGL任务中执行，可以为NULL
+ *
+ * ram_budget:    应用占用的内存上限（字节，LVGL堆与系统堆合计，0表示不限）
+ * cpu_budget_us: 单次回调的CPU时间上限（微秒，0表示不限）
+ * bg_period_ms:  0表示不在后台运行，离开前台即停止
+ * assets:        界面用到的资源（asset_count项，可以为NULL），供预热器提前加载
+ */
+struct App
+{
+	const char* name;
+	app_hook_t on_enter;
+	app_hook_t on_loop;
+	app_hook_t on_background;
+	app_hook_t on_exit;
+	uint32_t ram_budget;
+	uint32_t cpu_budget_us;
+	uint16_t fg_period_ms;
+	uint16_t bg_period_ms;
+	void* user;
+	const AppAsset* assets;
+	uint8_t asset_count;
+};
+
+/**
+ * 应用状态
+ */
+enum AppState
+{
+	APP_STOPPED = 0,
+	APP_FOREGROUND,
+	APP_BACKGROUND
+};
+
+/**
+ * 应用框架
+ * 同一时间只有一个前台应用；后台应用降低回调频率。
+ * 每次回调前后统计CPU时间与内存变化并记到该应用名下：
+ * - 内存：启动前检查剩余内存是否满足预算，运行中累计占用超过预算时停止应用
+ * - CPU：超出预算时周期加倍（限速），持续超预算的后台应用被停止
+ * 内存统计以回调前后的堆变化计算，其他任务同时分配内存时会有误差
+ * 所有接口必须在LVGL任务中调用（runtime.begin之前可在setup中调用，之后其他任务通过runtime.post）
+ */
+class AppManager
+{
+private:
+	struct Entry
+	{
+		App app;
+		AppState state;
+		uint32_t due;          // 下次on_loop的millis
+		int32_t ram_used;      // on_enter以来归属该应用的内存（字节）
+		uint32_t cpu_avg_us;   // 回调耗时的滑动平均
+		uint32_t cpu_max_us;
+		uint8_t throttle;      // 周期倍数（1、2、4……）
+		uint8_t strikes;
+		uint8_t good_runs;
+	};
+
+	Entry entries[APP_MAX];
+	uint8_t count;
+	int fg;
+	lv_task_t* task;
+
+	bool call(uint8_t id, app_hook_t hook);
+	void enterBackground(uint8_t id);
+	bool enter(uint8_t id);
+	void schedule();
+	static int32_t heapUsed();
+	static void taskCb(lv_task_t* t);
+
+public:
+	void begin();
+	int add(const App& app);
+	bool open(uint8_t id);
+	// 轮播：切换到登记顺序中的下一个（dir>0）或上一个应用，首尾相接
+	bool openNext(int8_t dir);
+	void stop(uint8_t id);
+	// 重新进入前台应用（界面重建）
+	void reload();
+
+	int foreground();
+	uint8_t getCount();
+	const App* getApp(uint8_t id);
+	bool isForeground(uint8_t id);
+	// 按名称查找应用编号，没有时返回-1
+	int find(const char* name);
+	const char* getName(uint8_t id);
+	AppState getState(uint8_t id);
+	void report();
+};
+
+extern AppManager apps;
+
+#endif
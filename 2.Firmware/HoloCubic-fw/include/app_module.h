@@ -0,0 +1,146 @@
+#ifndef APP_MODULE_H
+#define APP_MODULE_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+#include "app_manager.h"
+#include "app_module_format.h"
+
+// SD卡上的模块目录（*.ham），资源包中名称以AMOD_ASSET_PREFIX开头的数据也作为模块
+#define AMOD_DIR "/apps"
+#define AMOD_ASSET_PREFIX "mod_"
+#define AMOD_PATH_MAX 48
+// 同时登记的模块数（与内置应用共用APP_MAX）
+#define AMOD_MAX_MODULES 4
+// 沙箱上限：代码（跳转目标为u16）、常量数据、全局变量、栈深度、调用深度、界面对象数
+#define AMOD_CODE_MAX 65535U
+#define AMOD_DATA_MAX (16U * 1024U)
+#define AMOD_GLOBALS_MAX 256
+#define AMOD_STACK_MAX 256
+#define AMOD_CALL_DEPTH 16
+#define AMOD_OBJ_MAX 24
+// 模块未指定时的单次回调指令预算与内存预算
+#define AMOD_STEPS_DEFAULT 20000
+#define AMOD_RAM_DEFAULT (24U * 1024U)
+// SYS_NUM格式化后的最大长度
+#define AMOD_TEXT_MAX 64
+
+/**
+ * 模块出错的原因（出错后模块不再执行，屏幕上显示原因与位置）
+ */
+enum AmodFault
+{
+	AMOD_OK = 0,
+	AMOD_FAULT_BUDGET,      // 超出单次回调的指令预算（死循环等）
+	AMOD_FAULT_STACK,       // 栈或调用栈溢出、下溢
+	AMOD_FAULT_OPCODE,
+	AMOD_FAULT_ADDRESS,     // 代码、全局变量越界
+	AMOD_FAULT_DIV0,
+	AMOD_FAULT_SYSCALL,     // 未知的系统调用
+	AMOD_FAULT_OBJECT,      // 对象编号无效或类型不符、对象数超出上限
+	AMOD_FAULT_STRING       // 字符串偏移越界或没有结尾
+};
+
+/**
+ * 模块解释器（一个模块一个实例，只在LVGL任务中执行）
+ *
+ * 32位整数栈机：代码与常量数据只读（可直接指向flash映射），全局变量与栈按模块头分配并检查上限。
+ * 每条指令检查栈与地址，每次回调按指令数计预算，系统调用只能操作本模块屏幕上自己创建的对象，
+ * 任何越界都使模块停止而不影响固件
+ */
+class ModuleVm
+{
+private:
+	const uint8_t* code;
+	uint32_t code_size;
+	const uint8_t* data;
+	uint32_t data_size;
+	int32_t* globals;
+	uint16_t global_count;
+	int32_t* stack;
+	uint16_t stack_size;
+	uint16_t sp;
+	uint16_t calls[AMOD_CALL_DEPTH];
+	uint8_t depth;
+	lv_obj_t* scr;
+	lv_obj_t* objs[AMOD_OBJ_MAX];
+	uint8_t obj_types[AMOD_OBJ_MAX];
+	uint8_t obj_count;
+	uint32_t step_budget;
+	uint32_t steps;
+	AmodFault fault;
+	uint32_t fault_pc;
+
+	bool trap(AmodFault f, uint32_t pc);
+	const char* str(int32_t off);
+	lv_obj_t* obj(int32_t h, uint8_t type);
+	int32_t newObj(lv_obj_t* o, uint8_t type);
+	bool sys(uint8_t id, uint32_t pc);
+
+public:
+	ModuleVm();
+	/**
+	 * 准备执行：image为代码与紧随其后的常量数据，scr为模块的屏幕
+	 * @return 内存不足时返回false
+	 */
+	bool init(const AppModuleHeader* h, const uint8_t* image, lv_obj_t* scr);
+	void release();
+	// 执行一个回调（entry为AMOD_NO_ENTRY时什么也不做），出错后返回false且不再执行
+	bool run(uint16_t entry);
+
+	AmodFault getFault();
+	uint32_t getFaultPc();
+	// 上一次回调执行的指令数
+	uint32_t getSteps();
+	static const char* faultName(AmodFault f);
+};
+
+/**
+ * 应用模块（从SD卡或资源包加载，不需要重新编译固件）
+ *
+ * addApps()只读取各模块的文件头（每个约60字节），按模块头中的预算登记为应用；
+ * 代码在应用进入前台时才载入（SD卡上的模块读入BUF_BULK，有PSRAM时在PSRAM中；
+ * 资源包中的模块直接在flash映射上执行，不占RAM），应用停止时释放。
+ * 预算：内存与CPU时间交给AppManager记账（超出时限速或停止），指令预算与沙箱上限由解释器保证。
+ * 所有接口必须在LVGL任务中调用
+ */
+class AppModules
+{
+private:
+	struct Slot
+	{
+		char path[AMOD_PATH_MAX];  // SD上的路径，资源包中的模块为资源名
+		bool flash;
+		AppModuleHeader h;
+		const uint8_t* image;
+		uint8_t* loaded;
+		ModuleVm vm;
+		lv_obj_t* scr;
+		lv_obj_t* prev_scr;
+		App app;
+	};
+
+	Slot slots[AMOD_MAX_MODULES];
+	uint8_t count;
+
+	static bool check(AppModuleHeader* h, uint32_t size);
+	Slot* addSlot(const AppModuleHeader* h, const char* path, bool flash);
+	uint8_t scanSd();
+	uint8_t scanAssets();
+	bool load(Slot* s);
+	void showFault(Slot* s);
+	static void enterCb(void* user);
+	static void loopCb(void* user);
+	static void exitCb(void* user);
+
+public:
+	AppModules();
+	// 查找SD卡AMOD_DIR与资源包中的模块并登记为应用，返回登记的模块数
+	uint8_t addApps();
+	uint8_t getCount();
+	const char* getName(uint8_t i);
+};
+
+extern AppModules modules;
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef APP_MODULE_FORMAT_H
+#define APP_MODULE_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * .ham 应用模块格式（3.Software/HoloApp/holo_app.py由汇编源文件生成，固件app_module.cpp解释执行）
+ *
+ * 文件布局（小端）：
+ *   [AppModuleHeader][代码 code_size][常量数据 data_size]
+ *
+ * - 代码为32位整数栈机的字节码，立即数小端；跳转与调用的目标为代码内的绝对偏移（u16）
+ * - 常量数据为以'\0'结尾的字符串，通过数据内的偏移引用（SYS_TEXT等）
+ * - entry_*为各回调的代码偏移，AMOD_NO_ENTRY表示没有该回调
+ * - globals/stack为模块需要的全局变量数与栈深度（32位整数），由固件按上限检查后分配
+ */
+
+#define AMOD_MAGIC "HAPM"
+#define AMOD_VERSION 1
+// 系统调用表版本：只增加调用、不改变已有调用的参数时不变
+#define AMOD_API_VERSION 1
+#define AMOD_NAME_LEN 16
+#define AMOD_NO_ENTRY 0xFFFF
+
+#pragma pack(push, 1)
+
+struct AppModuleHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	char name[AMOD_NAME_LEN];   // 以'\0'结尾，作为应用名
+	uint16_t api_version;
+	uint16_t globals;
+	uint16_t stack;
+	uint16_t fg_period_ms;      // on_loop周期，0为APP_FG_PERIOD_MS
+	uint16_t entry_enter;
+	uint16_t entry_loop;
+	uint16_t entry_exit;
+	uint16_t reserved;
+	uint32_t code_size;
+	uint32_t data_size;
+	uint32_t ram_budget;        // 交给AppManager的内存预算（字节，0为AMOD_RAM_DEFAULT）
+	uint32_t cpu_budget_us;     // 交给AppManager的单次回调CPU预算（0为不限，仍受指令预算限制）
+	uint32_t step_budget;       // 单次回调最多执行的指令数（0为AMOD_STEPS_DEFAULT）
+};
+
+#pragma pack(pop)
+
+/**
+ * 指令（操作码u8，之后为立即数）
+ */
+enum AmodOp
+{
+	AMOD_NOP = 0x00,
+	AMOD_PUSH = 0x01,       // i32
+	AMOD_PUSH8 = 0x02,      // i8（符号扩展）
+	AMOD_DUP = 0x03,
+	AMOD_DROP = 0x04,
+	AMOD_SWAP = 0x05,
+	AMOD_OVER = 0x06,
+	AMOD_LOAD = 0x08,       // u16 全局变量编号
+	AMOD_STORE = 0x09,      // u16
+	AMOD_LOADI = 0x0A,      // 栈顶为编号
+	AMOD_STOREI = 0x0B,     // 栈顶为值，其下为编号
+
+	AMOD_ADD = 0x10,
+	AMOD_SUB = 0x11,
+	AMOD_MUL = 0x12,
+	AMOD_DIV = 0x13,        // 除数为0时出错
+	AMOD_MOD = 0x14,
+	AMOD_NEG = 0x15,
+	AMOD_AND = 0x16,
+	AMOD_OR = 0x17,
+	AMOD_XOR = 0x18,
+	AMOD_SHL = 0x19,        // 移位数取低5位
+	AMOD_SHR = 0x1A,        // 算术右移
+	AMOD_NOT = 0x1B,        // 逻辑非
+
+	AMOD_EQ = 0x20,
+	AMOD_NE = 0x21,
+	AMOD_LT = 0x22,
+	AMOD_LE = 0x23,
+	AMOD_GT = 0x24,
+	AMOD_GE = 0x25,
+
+	AMOD_JMP = 0x30,        // u16 目标
+	AMOD_JZ = 0x31,         // 弹出，为0时跳转
+	AMOD_JNZ = 0x32,
+	AMOD_CALL = 0x33,       // u16
+	AMOD_RET = 0x34,        // 调用栈为空时结束回调
+	AMOD_SYS = 0x38,        // u8 系统调用编号
+	AMOD_HALT = 0x3F        // 结束回调
+};
+
+/**
+ * 系统调用（API版本1）：参数按顺序压栈（最后一个在栈顶），返回值压栈
+ * 界面对象编号从1开始，只能操作本模块创建的对象；坐标相对模块屏幕
+ */
+enum AmodSys
+{
+	AMOD_SYS_MILLIS = 0,    // () -> 毫秒
+	AMOD_SYS_LABEL,         // (x, y) -> 对象
+	AMOD_SYS_TEXT,          // (对象, 字符串)：字符串为常量数据内的偏移
+	AMOD_SYS_NUM,           // (对象, 格式, 值)：格式中的第一个"%d"替换为值
+	AMOD_SYS_COLOR,         // (对象, 0xRRGGBB)：文字或进度条颜色
+	AMOD_SYS_POS,           // (对象, x, y)
+	AMOD_SYS_BAR,           // (x, y, w, h) -> 对象，范围0~100
+	AMOD_SYS_BAR_SET,       // (对象, 值)
+	AMOD_SYS_HIDE,          // (对象, 是否隐藏)
+	AMOD_SYS_BG,            // (0xRRGGBB)：屏幕背景色
+	AMOD_SYS_ACCEL,         // (轴0~2) -> 加速度（mg）
+	AMOD_SYS_GYRO,          // (轴0~2) -> 角速度（0.01°/s）
+	AMOD_SYS_LUX,           // () -> 环境光（lx，没有传感器时为-1）
+	AMOD_SYS_TIME,          // () -> Unix时间（时钟尚未同步时为0）
+	AMOD_SYS_RAND,          // (n) -> 0~n-1
+	AMOD_SYS_LOG,           // (字符串)：输出到日志
+	AMOD_SYS_COUNT
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef APP_PREFETCH_H
+#define APP_PREFETCH_H
+
+#include <Arduino.h>
+#include "app_manager.h"
+
+// 预热定时器周期（每次最多预热一项资源）
+#define APP_PREFETCH_PERIOD_MS 50
+// 切换应用后等待多久开始预热（切换动画SCR_MGR_ANIM_TIME与新界面的首次绘制优先）
+#define APP_PREFETCH_DELAY_MS 500
+// LVGL任务空闲率低于此值（%）或有动画运行时不预热
+#define APP_PREFETCH_IDLE_MIN 50
+// 每次切换后预热几个最可能进入的应用
+#define APP_PREFETCH_DEPTH 2
+// 一轮预热解码进图像缓存的字节上限（另受缓存本身剩余空间限制）
+#define APP_PREFETCH_BUDGET (64U * 1024U)
+// 切换计数饱和后整行减半，较早的习惯逐渐淡出
+#define APP_PREFETCH_COUNT_MAX 255
+
+/**
+ * 应用预热器
+ *
+ * 切换应用时新界面的图像要从SD卡/资源包解码、字形要从flash读取、文件要查找目录，
+ * 都落在切换后的第一帧上。预热器在前台应用稳定、LVGL任务空闲时提前做这些事：
+ * - 导航图：记录应用之间的实际切换次数（from -> to），候选按次数排序，
+ *   没有记录时取轮播中的相邻应用（AppManager::openNext的前后一个）
+ * - 图像：解码进LVGL图像缓存（整幅预解码的文件图像下次直接绘制），只使用缓存的剩余空间，
+ *   不会挤出当前界面的图像；合计不超过APP_PREFETCH_BUDGET
+ * - 字体：按App::assets中给出的文字查找字形并读取位图（flash中的字形表与位图进入cache）
+ * - 文件：打开后关闭，句柄留在lv_fs的句柄缓存中（LV_FS_HANDLE_CACHE），再次打开不查找目录
+ *
+ * 注意事项：
+ * - 只在LVGL任务中运行（低优先级定时器），不另建任务；预热的图像不固定，之后仍按LRU淘汰
+ * - 预热的内容不记入应用的内存预算
+ */
+class AppPrefetch
+{
+private:
+	lv_task_t* task;
+	int last_fg;
+	uint32_t start_at;     // 本轮开始预热的millis
+	uint8_t counts[APP_MAX][APP_MAX];
+	uint8_t plan[APP_PREFETCH_DEPTH];
+	uint8_t plan_count;
+	uint8_t plan_pos;      // 正在预热的候选
+	uint8_t asset_pos;     // 该候选的下一项资源
+	uint32_t spent;        // 本轮解码进缓存的字节
+	uint32_t warmed;
+	uint32_t skipped;
+
+	void record(int from, int to);
+	void buildPlan(int fg);
+	bool warm(const AppAsset* a);
+	bool warmImage(const void* src);
+	static void warmFont(const lv_font_t* font, const char* text);
+	static void warmFile(const char* path);
+	static void taskCb(lv_task_t* t);
+
+public:
+	AppPrefetch();
+	// 创建预热定时器（apps.begin之后调用）
+	void begin();
+	// 清空导航记录
+	void reset();
+	// 输出统计：PREFETCH,预热项数,跳过项数,本轮字节
+	void report();
+};
+
+extern AppPrefetch prefetcher;
+
+#endif
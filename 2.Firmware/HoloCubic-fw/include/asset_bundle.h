@@ -0,0 +1,92 @@
+#ifndef ASSET_BUNDLE_H
+#define ASSET_BUNDLE_H
+
+#include <stdint.h>
+#include <lvgl.h>
+
+// 资源包分区（partitions.csv中的自定义数据分区）
+#define ASSET_PARTITION_LABEL "assets"
+#define ASSET_PARTITION_SUBTYPE 0x40
+// 固件内是否仍编译images.h中的Logo（资源包中没有"logo"时使用）；
+// 资源包已烧录时可设为0，固件减小约14KB
+#ifndef ASSET_BUILTIN_LOGO
+#define ASSET_BUILTIN_LOGO 1
+#endif
+
+/**
+ * 资源包格式（与3.Software/ImageToHolo/convertor/assets.py保持一致，小端）
+ *
+ *   [AssetHeader][AssetEntry * count][资源0][资源1]...
+ *
+ * - 每个资源为完整的LVGL .bin内容（4字节lv_img_header_t + 数据），起始偏移4字节对齐
+ * - 整个分区经esp_partition_mmap映射到数据地址空间，lv_img_dsc_t.data直接指向flash，
+ *   读取走flash cache，不占用RAM、不经过SD卡
+ */
+#define ASSET_MAGIC "HOLA"
+#define ASSET_VERSION 1
+#define ASSET_NAME_LEN 24
+
+#pragma pack(push, 1)
+
+struct AssetHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t count;
+	uint32_t size;         // 资源包总字节数（映射长度）
+	uint8_t reserved[4];
+};
+
+struct AssetEntry
+{
+	char name[ASSET_NAME_LEN];   // 以'\0'结尾，不含扩展名
+	uint32_t offset;
+	uint32_t size;
+};
+
+#pragma pack(pop)
+
+#ifdef __cplusplus
+
+#include <esp_partition.h>
+
+/**
+ * flash资源包
+ * begin()映射分区并为每个资源建立lv_img_dsc_t（仅描述符占用RAM，每个约16字节），
+ * 之后getImage()返回的描述符可直接交给lv_img_set_src
+ */
+class AssetBundle
+{
+private:
+	spi_flash_mmap_handle_t map;
+	const uint8_t* base;
+	const AssetEntry* entries;
+	uint16_t count;
+	lv_img_dsc_t* dscs;
+
+public:
+	AssetBundle();
+
+	bool begin();
+	void end();
+
+	const lv_img_dsc_t* getImage(const char* name);
+	const uint8_t* getData(const char* name, uint32_t* size);
+	uint16_t getCount();
+	// 第i个资源的名称（遍历资源包，如查找应用模块），超出范围时返回NULL
+	const char* getName(uint16_t i);
+};
+
+extern AssetBundle assets;
+
+extern "C" {
+#endif
+
+// 供C代码（GUI）使用：按名称取图像，资源包未烧录或没有该资源时返回NULL
+const lv_img_dsc_t* asset_image(const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef ASYNC_IMAGE_H
+#define ASYNC_IMAGE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "lvgl.h"
+#include "runtime.h"
+#include "jpeg_decoder.h"
+
+// 解码结果的缓存槽数（每槽一张解码后的真彩色图像，BUF_BULK）
+#define IMGLOAD_SLOTS 4
+// 同时绑定的lv_img对象数
+#define IMGLOAD_BINDINGS 16
+// 文件路径最大长度（SD_FS路径，不带"S:"）
+#define IMGLOAD_PATH_MAX 64
+// 后台任务：与LVGL任务不在同一个核
+#define IMGLOAD_TASK_CORE 0
+#define IMGLOAD_TASK_PRIORITY 1
+#define IMGLOAD_TASK_STACK 4096
+// SD卡正在重新挂载时的重试间隔
+#define IMGLOAD_RETRY_MS 200
+
+/**
+ * 缓存槽
+ * state只在mux内修改；path/max_w/max_h由LVGL任务在槽为空时填写，
+ * buf/dsc由后台任务在解码期间填写，LVGL任务只在READY之后读取
+ */
+struct ImgSlot
+{
+	char path[IMGLOAD_PATH_MAX];
+	uint16_t max_w;
+	uint16_t max_h;
+	volatile uint8_t state;
+	volatile bool cancel;      // 解码期间已没有对象引用：后台任务中止并释放
+	bool nomem;                // 缓冲分配失败（显示时退回LVGL的S:解码器）
+	uint8_t refs;              // 绑定到该槽的对象数
+	uint32_t used;             // 最近使用序号（淘汰引用为0且最久未用的槽）
+	uint8_t* buf;
+	lv_img_dsc_t dsc;
+};
+
+/**
+ * lv_img对象与缓存槽的绑定
+ */
+struct ImgBinding
+{
+	lv_obj_t* img;
+	int8_t slot;
+};
+
+/**
+ * 异步图像加载
+ *
+ * LVGL的文件图像（"S:xxx.jpg"）在绘制时同步解码，一张大JPEG会让lv_task_handler停住几百毫秒，
+ * 期间输入与动画都停止。这里改为：
+ * - set()在LVGL任务中调用：已解码的直接显示；否则先显示占位图（图标、缩略图等），请求交给后台任务
+ * - 后台任务（IMGLOAD_TASK_CORE）把JPEG（tjpgd，IDCT阶段按1/2~1/8缩小到不超过max_w x max_h）
+ *   或真彩色.bin解码到缓存槽（面板字节序），完成后通过runtime.post通知
+ * - LVGL任务收到通知后把绑定的对象换成解码结果（lv_img_set_src使对象失效重绘），
+ *   显示时由LVGL直接读取缓存槽中的像素，不再解码
+ *
+ * 注意事项：
+ * - 接口（begin除外）必须在LVGL任务中调用
+ * - 对象删除时自动解除绑定（包装lv_img的signal回调），不必调用cancel()
+ * - 其他格式（PNG等）没有解码器，后台任务按失败处理，保留占位图
+ * - 缓存槽只在LVGL任务中淘汰（引用为0的READY/FAILED槽），淘汰前先使LVGL的图像缓存失效
+ */
+class AsyncImage
+{
+private:
+	ImgSlot slots[IMGLOAD_SLOTS];
+	ImgBinding binds[IMGLOAD_BINDINGS];
+	uint32_t use_seq;
+	TaskHandle_t worker;
+	JpegDecoder jpeg;
+	File src_file;
+	ImgSlot* decoding;
+	volatile bool aborted;     // 解码因引用归零而中止
+	uint16_t out_w;
+	uint16_t out_h;
+	uint32_t decoded;
+	uint32_t failed;
+
+	int8_t findSlot(const char* path, uint16_t max_w, uint16_t max_h);
+	int8_t freeSlot();
+	ImgBinding* findBinding(lv_obj_t* img);
+	void release(int8_t slot);
+	void apply(lv_obj_t* img, ImgSlot* s);
+
+	bool serve();
+	bool decode(ImgSlot* s);
+	bool decodeJpeg(ImgSlot* s);
+	bool decodeBin(ImgSlot* s);
+	static void workerEntry(void* arg);
+	static uint32_t jpegRead(void* user, uint8_t* buf, uint32_t len);
+	static bool jpegBand(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px);
+	static void onReady(const UiMsg* msg);
+	static lv_res_t signalCb(lv_obj_t* obj, lv_signal_t sign, void* param);
+
+public:
+	AsyncImage();
+	// 创建后台任务（setup中调用）
+	bool begin();
+
+	/**
+	 * 为img加载path（SD_FS路径），解码结果不超过max_w x max_h
+	 * @param placeholder 解码完成前显示的图像源（lv_img_set_src可接受的任意源），NULL时不改变（原来显示的是其他缓存槽时清空）
+	 * @return 已直接显示解码结果或已加入队列时返回true；缓存槽或绑定已满时返回false（显示占位图）
+	 */
+	bool set(lv_obj_t* img, const char* path, const void* placeholder = NULL,
+			 uint16_t max_w = LV_HOR_RES_MAX, uint16_t max_h = LV_VER_RES_MAX);
+	// 解除img的绑定（尚未开始的解码取消，正在进行的在下一个条带中止）
+	void cancel(lv_obj_t* img);
+	// 释放所有未被引用的缓存槽
+	void flush();
+
+	uint32_t getDecoded();
+	uint32_t getFailed();
+};
+
+extern AsyncImage imgloader;
+
+#endif
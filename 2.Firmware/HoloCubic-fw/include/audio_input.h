@@ -0,0 +1,103 @@
+#ifndef AUDIO_INPUT_H
+#define AUDIO_INPUT_H
+
+#include <Arduino.h>
+#include <driver/i2s.h>
+
+// I2S数字麦克风（INMP441/SPH0645等，L/R接地为左声道），需外接：BCLK、WS、数据三根线
+#define AUDIO_I2S_PORT I2S_NUM_0
+#ifndef AUDIO_PIN_BCLK
+#define AUDIO_PIN_BCLK 26
+#endif
+#ifndef AUDIO_PIN_WS
+#define AUDIO_PIN_WS 25
+#endif
+#ifndef AUDIO_PIN_DIN
+#define AUDIO_PIN_DIN 35
+#endif
+// 部分IDF版本的ONLY_LEFT/ONLY_RIGHT与实际声道相反，读到全0时改为I2S_CHANNEL_FMT_ONLY_RIGHT
+#ifndef AUDIO_CHANNEL_FMT
+#define AUDIO_CHANNEL_FMT I2S_CHANNEL_FMT_ONLY_LEFT
+#endif
+
+#define AUDIO_SAMPLE_RATE 16000
+// FFT点数（实数输入，按N/2点复数FFT计算），频率分辨率 16000/512 = 31.25Hz
+#define AUDIO_FFT_BITS 9
+#define AUDIO_FFT_N (1 << AUDIO_FFT_BITS)
+// 帧移：每256个新样本（16ms）分析一次，相邻两帧重叠一半，约62帧/秒
+#define AUDIO_HOP 256
+// DMA缓冲：每个一个帧移，共约64ms，分析任务偶尔被抢占时不丢样本
+#define AUDIO_DMA_BUFS 4
+// 频带数（对数间隔，60Hz ~ 8kHz）
+#define AUDIO_BANDS 16
+#define AUDIO_BAND_MIN_HZ 60
+// 样本右移位数：24位样本取高位得到约±32768（麦克风灵敏度较低时减小）
+#define AUDIO_SAMPLE_SHIFT 14
+// 自动增益：频带功率取log2（Q4，每单位约0.19dB），满格参考跟随最响的频带上升、每次分析回落1单位（约12dB/秒）
+// 显示动态范围约42dB；满格参考不低于下限，安静时不会把底噪放大成满格
+#define AUDIO_RANGE_Q4 224
+#define AUDIO_AGC_DECAY_Q4 1
+#define AUDIO_CEIL_MIN_Q4 192
+// 频带下落速度（每次分析，0~255）
+#define AUDIO_FALL 12
+
+#define AUDIO_TASK_CORE 0
+#define AUDIO_TASK_PRIORITY 2
+#define AUDIO_TASK_STACK 3072
+
+/**
+ * 一次分析的结果
+ */
+struct AudioSpectrum
+{
+	uint8_t bands[AUDIO_BANDS];  // 0~255，已按自动增益归一化并做了下落平滑
+	uint8_t level;               // 整体响度 0~255
+	uint32_t seq;                // 每次分析加1
+};
+
+// 分析完成回调（在音频任务中执行，不可调用LVGL）
+typedef void (*audio_spectrum_cb_t)(const AudioSpectrum* s, void* user);
+
+/**
+ * I2S麦克风输入与定点频谱分析
+ *
+ * I2S外设按DMA连续采集，音频任务每凑齐一个帧移唤醒一次：
+ * 去直流 -> Hann窗（Q15） -> 512点实数FFT（打包为256点复数基2 FFT，每级右移1位防溢出，
+ * 再拆分出实数频谱） -> 按对数间隔的频带累加功率 -> log2 -> 自动增益与下落平滑。
+ * 分析全部为16/32位整数运算，只占一个帧移（16ms）的一小部分；结果经自旋锁复制，任何任务都可读取
+ */
+class AudioInput
+{
+private:
+	TaskHandle_t task;
+	volatile bool running;
+	SemaphoreHandle_t done;
+	audio_spectrum_cb_t listener;
+	void* listener_user;
+
+	int32_t* raw;                 // I2S读取缓冲（32位样本，一个帧移）
+	uint16_t fill;                // raw中已读到的样本数
+	int16_t* frame;               // 最近AUDIO_FFT_N个样本（环形拼接后顺序存放）
+	int16_t* fft;                 // 复数工作区 2 * AUDIO_FFT_N / 2
+	int32_t dc;                   // 直流分量（Q8）
+	uint16_t band_edge[AUDIO_BANDS + 1]; // 各频带的起始频点，最后一项为结束频点
+	int16_t ceiling;              // 满格参考，log2功率（Q4）
+	AudioSpectrum result;
+
+	void analyze();
+	static void fftRadix2(int16_t* data, uint8_t bits);
+	static uint16_t log2Q4(uint64_t v);
+	static void taskEntry(void* arg);
+
+public:
+	AudioInput();
+	bool begin();
+	void end();
+	bool isRunning();
+	bool get(AudioSpectrum* out);
+	void setListener(audio_spectrum_cb_t cb, void* user);
+};
+
+extern AudioInput audio;
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef AUDIO_VIZ_H
+#define AUDIO_VIZ_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "display.h"
+#include "rgb_led.h"
+#include "app_manager.h"
+#include "audio_input.h"
+
+// 刷新率（频谱约62次/秒更新，没有新结果的帧不写屏）
+#define AUDIO_VIZ_FPS 40
+// 频谱条：AUDIO_BANDS根，每根宽BAR_W、间隔GAP，共 16 * 15 = 240像素
+#define AUDIO_VIZ_BAR_W 12
+#define AUDIO_VIZ_GAP 3
+// 条顶端到屏幕顶部的最小距离
+#define AUDIO_VIZ_TOP 16
+#define AUDIO_VIZ_MAX_H (LV_VER_RES_MAX - AUDIO_VIZ_TOP)
+// 清除条时每次写入的行数（黑色块缓冲的大小）
+#define AUDIO_VIZ_BLANK_LINES 32
+// LED色相：低频为红色（0），高频为蓝色（160）
+#define AUDIO_VIZ_HUE_MAX 160
+
+/**
+ * 音频频谱可视化
+ *
+ * 频谱条只写变化的部分：条升高时从预先生成的渐变列（面板字节序，DMA内存）取对应的行写入，
+ * 降低时用黑色块抹掉多出的部分，每帧写屏的像素数与频谱变化量成正比，不需要帧缓冲。
+ * 板载LED在音频任务中更新：色相取频谱重心，亮度取整体响度。
+ *
+ * 注意事项：
+ * - start()/stop()会切换LVGL屏幕并创建lv_task，需在LVGL任务中调用
+ * - 运行期间载入一个空白屏幕（与待机效果相同），stop()恢复原屏幕
+ */
+class AudioViz
+{
+private:
+	Display* display;
+	Pixel* leds;
+	bool running;
+	uint16_t* bar_px;          // 渐变列 BAR_W * MAX_H，第0行为条的最高处
+	uint16_t* blank_px;        // 黑色块 BAR_W * BLANK_LINES
+	uint8_t heights[AUDIO_BANDS];
+	uint32_t seq;
+
+	lv_task_t* frame_task;
+	lv_obj_t* screen;
+	lv_obj_t* prev_screen;
+
+	static void frameCb(lv_task_t* task);
+	static void onSpectrum(const AudioSpectrum* s, void* user);
+
+public:
+	AudioViz();
+
+	void setDisplay(Display* disp);
+	void setLeds(Pixel* pixel);
+	bool start();
+	void stop();
+	bool isRunning();
+};
+
+extern AudioViz audioviz;
+// 以应用形式运行（apps.open(apps.add(audio_viz_app))），离开前台时停止
+extern const App audio_viz_app;
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef AUTO_ROTATE_H
+#define AUTO_ROTATE_H
+
+#include <Arduino.h>
+#include "display.h"
+#include "imu.h"
+#include "runtime.h"
+
+// 检查周期：订阅传感器总线的IMU样本（100Hz），每AUTO_ROTATE_CHECK_MS取一个，不访问I2C总线
+#define AUTO_ROTATE_CHECK_MS 100
+#define AUTO_ROTATE_EVERY (AUTO_ROTATE_CHECK_MS * IMU_FIFO_RATE_HZ / 1000)
+// 加速度一阶低通（每次检查新值占1/2^N）
+#define AUTO_ROTATE_LPF_SHIFT 2
+// 屏幕平面内的两个轴（0/1/2对应X/Y/Z）与符号：右边朝下放置时RIGHT轴读数乘以符号为正，正放时DOWN轴同理
+// 静止时加速度计读数与重力方向相反，默认值按X轴朝右、Y轴朝下安装，与实物不符时调整
+#define AUTO_ROTATE_AXIS_RIGHT 0
+#define AUTO_ROTATE_SIGN_RIGHT -1
+#define AUTO_ROTATE_AXIS_DOWN 1
+#define AUTO_ROTATE_SIGN_DOWN -1
+// 屏幕平面内重力分量小于该值（原始值，±2g量程下约0.5g）时不判断方向（平放或正在翻转）
+#define AUTO_ROTATE_MIN_PLANE 8192
+// 总加速度偏离1g超过该值时视为正在晃动/手持移动，不判断方向
+#define AUTO_ROTATE_MAX_SHAKE 4096
+// 滞回：新方向的分量超过当前方向分量的N/10倍才切换（17约为偏离当前方向60°，比45°分界多15°）
+#define AUTO_ROTATE_HYST_X10 17
+// 新方向需要持续保持的时间（倾斜手势保持时间较短且倾角小于60°，不会触发旋转）
+#define AUTO_ROTATE_DEBOUNCE_MS 800
+// 方向变化订阅者上限
+#define AUTO_ROTATE_MAX_SUBSCRIBERS 4
+// 1：启动后立即启用自动旋转
+#ifndef AUTO_ROTATE_ON_BOOT
+#define AUTO_ROTATE_ON_BOOT 0
+#endif
+
+/**
+ * 方向变化回调，在LVGL任务中执行（面板方向已切换、整屏已失效）
+ * @param rotation DISP_ROTATE_x
+ */
+typedef void (*auto_rotate_cb_t)(uint8_t rotation, void* user);
+
+/**
+ * 按重力方向自动旋转显示
+ *
+ * 以传感器总线的抽取订阅每AUTO_ROTATE_CHECK_MS取一个加速度样本，低通后取屏幕平面内的重力方向，按90°量化；
+ * 超过滞回角并持续AUTO_ROTATE_DEBOUNCE_MS后向LVGL任务发送一条消息：
+ * 写入一次MADCTL（Display::setOrientation，整屏失效一次）并依次通知订阅者重新排列界面。
+ * 旋转由面板完成，每帧的绘制与发送量不变；方向不变时不产生任何LVGL工作。
+ *
+ * 注意事项：
+ * - begin时显示的镜像位（如分光棱镜需要的左右镜像）保持不变；奇数个镜像时旋转方向相反，已自动换算
+ * - 单独设置了方向的屏幕（Display::setScreenOrientation）不跟随自动旋转
+ * - 240x240面板旋转后尺寸不变，订阅者只需调整与方向有关的布局（如文字基线、箭头方向）
+ */
+class AutoRotate
+{
+private:
+	Display* disp;
+	IMU* imu;
+	volatile bool enabled;
+
+	uint8_t mirror;            // 保持不变的镜像位
+	int32_t lpf[3];
+	bool lpf_init;
+	uint8_t rotation;          // 已应用（或已发送给LVGL任务）的方向
+	int8_t candidate;          // 等待去抖的新方向，-1表示没有
+	uint32_t candidate_since;
+	uint32_t changes;
+
+	auto_rotate_cb_t subs[AUTO_ROTATE_MAX_SUBSCRIBERS];
+	void* subs_user[AUTO_ROTATE_MAX_SUBSCRIBERS];
+	uint8_t sub_count;
+
+	int8_t detect(const SensorSample* s);
+	void check(const SensorSample* s);
+	static void onSample(const SensorSample* s, void* user);
+	static void applyMsg(const UiMsg* msg);
+
+public:
+	bool begin(Display* display, IMU* sensor);
+	void setEnabled(bool en);
+	bool isEnabled();
+	bool subscribe(auto_rotate_cb_t cb, void* user = NULL);
+	uint8_t getRotation();
+	uint32_t getChangeCount();
+};
+
+extern AutoRotate autorotate;
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef BACKLIGHT_H
+#define BACKLIGHT_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "display.h"
+#include "ambient.h"
+
+// 定时器周期（渐变步进间隔）
+#define BACKLIGHT_TICK_MS 20
+// 每隔多少个周期读取一次照度（BH1750一次测量约120ms）
+#define BACKLIGHT_LUX_TICKS 10
+// 亮度到达目标后停止20ms周期：自动模式改为每BACKLIGHT_IDLE_MS采样一次照度，手动模式完全停止，
+// CPU在两次LVGL刷新之间不再被背光定时器唤醒（空闲采样的间隔远小于平滑时间常数，调整不会变慢）
+#define BACKLIGHT_IDLE_MS 1000
+// 指数平滑时间常数：环境光突变后约该时长内完成大部分调整，避免人走过时闪烁
+#define BACKLIGHT_SMOOTH_MS 2000
+// 渐变速度：每个周期最多变化的占空比
+#define BACKLIGHT_RAMP_STEP 0.01f
+// 曲线点数
+#define BACKLIGHT_CURVE_POINTS 5
+
+/**
+ * 亮度档案
+ * BACKLIGHT_DAY:   白天，亮环境下可到满亮度
+ * BACKLIGHT_NIGHT: 夜间，整体压暗，暗室中接近最低
+ * BACKLIGHT_ECO:   省电，上限较低（USB供电桌面常亮时使用）
+ */
+enum BacklightProfile
+{
+	BACKLIGHT_DAY = 0,
+	BACKLIGHT_NIGHT,
+	BACKLIGHT_ECO,
+	BACKLIGHT_PROFILE_COUNT
+};
+
+// 照度（lux）到占空比的分段线性曲线，lux递增
+struct BacklightCurve
+{
+	uint16_t lux[BACKLIGHT_CURVE_POINTS];
+	float duty[BACKLIGHT_CURVE_POINTS];
+};
+
+/**
+ * 自动背光
+ * esp_timer周期回调中完成照度采样、曲线映射、指数平滑与渐变写入，不占用主循环；
+ * 关闭自动模式后setManual()设定的亮度同样以渐变方式到达；
+ * 亮度稳定后定时器降到BACKLIGHT_IDLE_MS（手动模式停止），目标变化时恢复渐变周期
+ */
+class Backlight
+{
+private:
+	Display* display;
+	Ambient* ambient;
+	esp_timer_handle_t timer;
+
+	BacklightProfile profile;
+	bool auto_mode;
+	volatile float target;     // 手动模式目标或曲线映射结果
+	float smooth;              // 平滑后的目标
+	float duty;                // 当前输出
+	uint16_t ticks;
+	bool idle;                 // 已到达目标，定时器为空闲采样或已停止
+	bool suspended;
+
+	float curve(unsigned int lux);
+	void tick();
+	void enterIdle();
+	void wake();
+	static void timerCb(void* arg);
+
+public:
+	bool begin(Display* disp, Ambient* amb, float initial = 0.2f);
+	void setProfile(BacklightProfile p);
+	BacklightProfile getProfile();
+	void setAuto(bool enable);
+	void setManual(float duty);
+	bool isAuto();
+	float getTarget();
+	float getDuty();
+	void suspend();
+	void resume();
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef BIN_DECODER_H
+#define BIN_DECODER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+// 条带缓冲区大小（按整行取整）；不小于LV_FS_RA_SIZE时整条带由FatFs直接读入，不经预读缓冲区复制
+#define BIN_DECODER_BUF_SIZE 8192
+
+/**
+ * 注册文件图像流式解码器（需在lv_init与lv_fs_if_init之后调用）
+ * 接管文件源（"S:/xxx.bin"）的TRUE_COLOR/TRUE_COLOR_ALPHA/TRUE_COLOR_CHROMA_KEYED图像：
+ * 逐行读取按顺序进行时一次读入若干整行，之后的行直接从缓冲区取出，不再逐行seek与read
+ */
+void bin_decoder_lv_init();
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/semphr.h>
+
+// 最多记录的启动阶段数（事件组每个异步阶段占一位，不超过24）
+#define BOOT_MAX_STAGES 24
+// 异步初始化任务：每个阶段一个临时任务，固定在核心0（与LVGL核心1并行）
+#define BOOT_TASK_STACK 6144
+#define BOOT_TASK_PRIORITY 2
+#define BOOT_TASK_CORE 0
+// 等待异步阶段的默认超时
+#define BOOT_WAIT_MS 10000
+
+typedef void (*boot_job_t)(void* arg);
+
+/**
+ * 一个启动阶段的记录（距Boot::begin的微秒数）
+ * end为0表示尚未完成；start == end的记录是时间点（如首帧）
+ */
+struct BootStage
+{
+	const char* name;
+	int64_t start;
+	int64_t end;
+	uint8_t core;
+	bool async;
+	boot_job_t job;
+	void* arg;
+};
+
+/**
+ * 启动计时与并行初始化
+ * run()    在当前任务中执行并计时一个阶段
+ * async()  在核心0的临时任务中执行一个阶段，立即返回阶段编号
+ * wait()   等待异步阶段完成（超时后继续启动，阶段在后台照常执行）
+ * report() 按开始时间输出启动时间线（串口，BOOT,开头的行为CSV）
+ * 异步阶段之间互不等待，只能做不依赖LVGL的工作（LVGL此时仍在setup中单线程使用）
+ */
+class Boot
+{
+private:
+	BootStage stages[BOOT_MAX_STAGES];
+	volatile uint8_t count;
+	int64_t t0;
+	SemaphoreHandle_t mutex;
+	EventGroupHandle_t done;
+
+	int add(const char* name, bool async);
+	void finish(int id);
+	static void taskEntry(void* arg);
+
+public:
+	void begin();
+	bool run(const char* name, boot_job_t job, void* arg = NULL);
+	int async(const char* name, boot_job_t job, void* arg = NULL);
+	bool wait(int id, uint32_t timeout_ms = BOOT_WAIT_MS);
+	void mark(const char* name);
+	void report();
+};
+
+extern Boot boot;
+
+#endif
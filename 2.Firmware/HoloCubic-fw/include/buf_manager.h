@@ -0,0 +1,49 @@
+#ifndef BUF_MANAGER_H
+#define BUF_MANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// 大块缓存退回片内RAM时至少保留的最大空闲块（WiFi、TLS与LVGL堆追加需要）
+#define BUF_INTERNAL_RESERVE (24U * 1024U)
+// 有PSRAM时LVGL图像缓存的字节预算与整幅预解码的上限（无PSRAM时保持lv_conf.h中的值）
+#define BUF_IMG_CACHE_PSRAM_BUDGET (512U * 1024U)
+#define BUF_IMG_CACHE_PSRAM_PRELOAD (240U * 240U * 2U)
+
+/**
+ * 缓冲区类别
+ * BUF_DMA:  SPI/SD的传输缓冲，片内可DMA内存
+ * BUF_FAST: 频繁随机访问的工作区（解码器状态、查找表），片内内存，不要求可DMA
+ * BUF_BULK: 大块且多为顺序访问的缓存（帧环形缓冲、整文件缓冲），有PSRAM时放PSRAM，
+ *           否则退回片内内存，但不会把片内最大空闲块压到BUF_INTERNAL_RESERVE以下
+ */
+typedef enum
+{
+	BUF_DMA = 0,
+	BUF_FAST,
+	BUF_BULK,
+} buf_class_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	// LVGL初始化之后调用一次：检测PSRAM，并按硬件放大LVGL图像缓存
+	void buf_manager_init(void);
+	bool buf_has_psram(void);
+
+	// 失败时返回NULL；BUF_BULK的调用方应能以更小的配置（或关闭该功能）继续运行
+	void* buf_alloc(buf_class_t cls, size_t size);
+	void* buf_calloc(buf_class_t cls, size_t n, size_t size);
+	void buf_free(void* p);
+
+	// 该类别当前能分配的最大块（决定帧环深度、缓存大小等可伸缩的配置）
+	size_t buf_largest(buf_class_t cls);
+	bool buf_is_dma(const void* p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef CACHE_PROF_H
+#define CACHE_PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "render_prof.h"
+
+// 1：按渲染计时的阶段统计取指停顿（构建配置env:pico32_cacheprof），0：不编译，钩子为空
+#ifndef CACHE_PROF
+#define CACHE_PROF 0
+#endif
+// 日志输出周期（开始统计后在LVGL任务中每周期输出一次并清零）
+#define CACHE_PROF_LOG_MS 5000
+
+/**
+ * 计数项
+ * CYCLES:  CCOUNT周期数
+ * INSN:    完成的指令数（性能计数器0）
+ * I_STALL: 取指引起的流水线停顿周期（性能计数器1）
+ *
+ * ESP32的Flash缓存位于Xtensa核之外，核内没有"缓存未命中"事件；
+ * 从IRAM取指不停顿，从Flash（经缓存）取指未命中时核在取指上等待，
+ * 因此取指停顿周期即为Flash缓存未命中的代价，停顿占比高的阶段是放入IRAM的候选（见lv_conf.h的LV_IRAM_HOT）
+ */
+typedef enum
+{
+	CACHE_PROF_CYCLES = 0,
+	CACHE_PROF_INSN,
+	CACHE_PROF_I_STALL,
+	CACHE_PROF_CNT
+} cache_prof_counter_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CACHE_PROF
+	// 由render_prof_begin/end调用（计时启用时）；计数器按调用所在的核读取，第一次调用时初始化该核的计数器
+	void cache_prof_begin(render_prof_phase_t phase);
+	void cache_prof_end(render_prof_phase_t phase);
+	// 取各阶段的累计值（上次清零以来）
+	void cache_prof_get(render_prof_phase_t phase, uint64_t out[CACHE_PROF_CNT]);
+	void cache_prof_reset(void);
+	// 输出各阶段的CPI与停顿占比（LOG_I）并清零；统计期间每CACHE_PROF_LOG_MS自动调用，必须在LVGL任务中调用
+	void cache_prof_log(void);
+	// 开始/停止统计（同时启用渲染计时；必须在LVGL任务中调用）
+	bool cache_prof_enable(bool en);
+#else
+#define cache_prof_begin(phase)
+#define cache_prof_end(phase)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef COLOR_GRADE_H
+#define COLOR_GRADE_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "display.h"
+#include "ambient.h"
+
+// 启动后按环境光自动调色（1为启用；0时可在运行中调用colorgrade.begin）
+#define COLOR_GRADE_ON_BOOT 1
+// 检查照度的周期（LVGL定时任务）
+#define COLOR_GRADE_PERIOD_MS 500
+// 指数平滑时间常数，与背光相近，避免人走过时整屏闪变
+#define COLOR_GRADE_SMOOTH_MS 3000
+// 强度从0开始增加与达到最大时的照度（lux）
+#define COLOR_GRADE_LUX_LOW 300
+#define COLOR_GRADE_LUX_HIGH 3000
+// 强度的级数：级别变化时才重建调色表并整屏重绘一次
+#define COLOR_GRADE_LEVELS 16
+// 高光压缩的起点与最大强度时白色降低的量（0~255），DROP不超过(255 - KNEE) / 2时曲线单调
+#define COLOR_GRADE_KNEE 128
+#define COLOR_GRADE_MAX_DROP 60
+
+/**
+ * 按环境光调色
+ *
+ * 强光下全息棱镜把亮色冲淡成一片，只调背光无法改善。这里按照度给每个通道一条高光压缩曲线：
+ * 低于COLOR_GRADE_KNEE的部分不变，以上部分按强度平滑压低（曲线单调，白色最多降低COLOR_GRADE_MAX_DROP），
+ * 亮色不再冲成一片。曲线由Display::setColorCurve在刷新时查表，与字节交换是同一遍，
+ * 不重新编码素材、不增加绘制。
+ * 照度取自Ambient::getLux（只读已发布的值，不访问总线），平滑后量化为COLOR_GRADE_LEVELS级，
+ * 级别变化时重建曲线（整屏重绘一次）。
+ * 所有接口必须在LVGL任务中调用
+ */
+class ColorGrade
+{
+private:
+	Display* display;
+	Ambient* ambient;
+	lv_task_t* task;
+	bool auto_mode;
+	float smooth;              // 平滑后的强度（0~1）
+	int8_t level;              // 当前生效的级别，-1为尚未设置
+	uint32_t last_ms;
+
+	void apply(uint8_t lvl);
+	static uint8_t curve(uint8_t in, uint8_t bits, float strength);
+	static void taskCb(lv_task_t* t);
+
+public:
+	ColorGrade();
+	bool begin(Display* disp, Ambient* amb);
+	void end();
+	// 关闭自动模式后以setStrength设定的强度调色
+	void setAuto(bool enable);
+	bool isAuto();
+	// 强度0~1（0为不调色），自动模式下由照度决定
+	void setStrength(float strength);
+	float getStrength();
+};
+
+extern ColorGrade colorgrade;
+
+#endif
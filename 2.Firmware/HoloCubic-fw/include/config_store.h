@@ -0,0 +1,123 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+
+// SD卡上的配置文件（JSON），修改后下次启动时自动导入
+#define CONFIG_FILE "/config.json"
+// 旧格式：第1行SSID、第2行密码（没有config.json时导入一次）
+#define CONFIG_LEGACY_WIFI_FILE "/wifi.txt"
+// NVS命名空间；配置值与文件标记（大小、修改时间）都保存在这里
+#define CONFIG_NAMESPACE "config"
+// 密码类配置项所在的NVS分区（partitions.csv）：CONFIG_NVS_ENCRYPTION时用nvs_keys分区中的密钥加密，
+// 分区不存在时退回默认分区
+#define CONFIG_SECURE_PARTITION "nvs_sec"
+// 配置文件大小上限（解析时整个读入ArduinoJson文档）
+#define CONFIG_FILE_MAX 4096
+
+/**
+ * 配置项（Config::get*按编号查找，O(1)）
+ * 新增配置项：在这里加编号，并在config.cpp的schema表中加一行（JSON路径、NVS键、类型、范围、默认值）
+ */
+enum ConfigKey
+{
+	CFG_WIFI_SSID = 0,
+	CFG_WIFI_PASSWORD,
+	CFG_BILI_UID,
+	CFG_WEATHER_LAT,
+	CFG_WEATHER_LON,
+	CFG_LOG_SINKS,
+	CFG_DEVICE_NAME,
+	CFG_FLEET_KEY,
+	CFG_MQTT_URI,
+	CFG_MQTT_USER,
+	CFG_MQTT_PASSWORD,
+	CFG_UI_LANG,
+	CFG_HUB_ENABLE,
+	CFG_HUB_LUX_S,
+	CFG_HUB_MOTION_S,
+	CFG_HUB_ORIENT_S,
+	CFG_HUB_PRESENCE_S,
+	CFG_HUB_DISCOVERY,
+	CFG_SYNC_GROUP,
+	CFG_KEY_COUNT
+};
+
+enum ConfigType
+{
+	CFG_TYPE_STR = 0,
+	CFG_TYPE_INT,
+	CFG_TYPE_BOOL
+};
+
+// ConfigSchema.flags
+#define CFG_FLAG_SECRET 0x01   // 保存在CONFIG_SECURE_PARTITION，不输出到日志
+
+/**
+ * 配置项描述
+ * path:   JSON中的路径，以'.'分隔层级，如"wifi.ssid"对应{"wifi":{"ssid":...}}
+ * nvs:    NVS键名（不超过15字符）
+ * max:    字符串的最大长度（不含结尾0），整数的上限
+ * flags:  CFG_FLAG_x（表中省略时为0）
+ */
+struct ConfigSchema
+{
+	const char* path;
+	const char* nvs;
+	ConfigType type;
+	int32_t min;
+	int32_t max;
+	const char* def_str;
+	int32_t def_int;
+	uint8_t flags;
+};
+
+/**
+ * 配置系统
+ *
+ * 配置值以类型化的键缓存在NVS中，启动时begin()从NVS读入内存，不需要SD卡；
+ * SD卡挂载后sync()只比较config.json的大小与修改时间，文件变化时才解析、校验并写回NVS。
+ * 其他模块通过get*()读取内存中的值：
+ *
+ *   const char* ssid = config.getStr(CFG_WIFI_SSID);
+ *
+ * 校验失败的项保留原值并输出警告；文件中没有的项保留原值（删除文件不会清空配置）
+ * 读取可在任意任务中进行；set()与sync()应在初始化阶段或同一个任务中调用
+ */
+class Config
+{
+private:
+	char* str_pool;
+	uint16_t str_offset[CFG_KEY_COUNT];
+	int32_t int_value[CFG_KEY_COUNT];
+	bool loaded;
+
+	bool importJson(const char* path);
+	bool importLegacy(const char* path);
+	bool fileChanged(const char* path, const char* stamp_key, uint32_t* size, uint32_t* mtime);
+	void saveStamp(const char* stamp_key, uint32_t size, uint32_t mtime);
+	bool store(ConfigKey key, const char* s, int32_t v);
+	static const char* partition(const ConfigSchema* s);
+	static bool secureBegin();
+	void migrateSecrets();
+
+public:
+	Config();
+	bool begin();
+	bool sync();
+
+	const char* getStr(ConfigKey key);
+	int32_t getInt(ConfigKey key);
+	bool getBool(ConfigKey key);
+
+	bool set(ConfigKey key, const char* value);
+	bool set(ConfigKey key, int32_t value);
+
+	// 按JSON路径查找编号，找不到时返回CFG_KEY_COUNT
+	static ConfigKey find(const char* path);
+	static const ConfigSchema* schema(ConfigKey key);
+};
+
+extern Config config;
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+#include "display.h"
+#include "scene_player.h"
+#include "scene_index.h"
+#include "runtime.h"
+
+// 1：启动后接受串口命令（现场诊断，终端以115200连接，回车结束一行）
+#ifndef CONSOLE_ON_BOOT
+#define CONSOLE_ON_BOOT 0
+#endif
+
+// 接收环形缓冲（2的幂）：串口任务写入，命令任务取出；满时丢弃新字节
+#define CONSOLE_RX_BUF 256
+// 一行的最大长度与参数个数（超长的行整行丢弃）
+#define CONSOLE_LINE_MAX 96
+#define CONSOLE_ARGS_MAX 4
+// 命令任务：收到行结束符时唤醒，否则每CONSOLE_POLL_MS检查一次
+#define CONSOLE_POLL_MS 200
+#define CONSOLE_TASK_CORE 0
+#define CONSOLE_TASK_PRIORITY 1
+#define CONSOLE_TASK_STACK 4096
+
+class Console;
+typedef void (*console_cmd_t)(Console* con, int argc, char** argv);
+
+/**
+ * 命令表的一项：name为第一个词，sub不为NULL时还须匹配第二个词
+ */
+struct ConsoleCmd
+{
+	const char* name;
+	const char* sub;
+	console_cmd_t fn;
+	const char* help;
+};
+
+/**
+ * 串口诊断命令
+ *
+ * 串口由传输模块（serial_link）独占读取：握手前寻找帧头时跳过的字节逐个交给feed()放入环形缓冲，
+ * 不阻塞、不加锁（单生产者单消费者）；命令任务按行取出、切分参数后查命令表执行。
+ * 回复全部经异步日志输出（标签"con"），与其他日志按时间顺序混在一起，也会写入已启用的SD卡/UDP目标。
+ *
+ *   help                    列出命令
+ *   stats                   帧率、刷新耗时、SD吞吐、场景节奏（需遥测已启动）与画质级别
+ *   heap                    系统堆、PSRAM与LVGL分配器
+ *   cache stats             异步图像缓存的解码/失败次数；CACHE_PROF构建时输出各渲染阶段的CPI并清零
+ *   log level [e|w|i|d]     查看/设置日志运行时级别
+ *   bench sd                存储基准（BENCH,...，约数十秒，期间不接受命令）
+ *   bench draw              绘制原语微基准（PRIMBENCH,...，在LVGL任务中运行）
+ *   bench scene [名称] [秒] 场景播放基准（SCENEBENCH,...，默认SCENE_BENCH_PACK，期间不接受命令）
+ *   scene play <名称> [fps] 播放SCENE_ROOT下的场景
+ *   scene stop              停止播放
+ *
+ * 注意事项：
+ * - 高速传输期间（isActive）串口上是帧数据，不解析命令
+ * - 终端不回显时需打开本地回显；退格（0x08/0x7f）删除前一个字符
+ * - 需要LVGL的命令通过runtime.post执行，上一条尚未执行时拒绝新的（参数只有一份）
+ */
+class Console
+{
+private:
+	TaskHandle_t task;
+	Display* screen;
+	ScenePlayer* player;
+	uint8_t rx[CONSOLE_RX_BUF];
+	volatile uint16_t rx_head;
+	volatile uint16_t rx_tail;
+	uint32_t overrun;
+	char line[CONSOLE_LINE_MAX];
+	uint8_t line_len;
+	bool line_drop;
+	// 交给LVGL任务的命令参数
+	volatile bool ui_busy;
+	char ui_arg[SCENE_INDEX_NAME_MAX];
+	uint8_t ui_fps;
+
+	static const ConsoleCmd commands[];
+
+	bool readLine();
+	void exec(char* text);
+	bool postUi(ui_msg_cb_t cb);
+	static void taskEntry(void* arg);
+
+	static void cmdHelp(Console* con, int argc, char** argv);
+	static void cmdStats(Console* con, int argc, char** argv);
+	static void cmdHeap(Console* con, int argc, char** argv);
+	static void cmdCache(Console* con, int argc, char** argv);
+	static void cmdLogLevel(Console* con, int argc, char** argv);
+	static void cmdBenchSd(Console* con, int argc, char** argv);
+	static void cmdBenchDraw(Console* con, int argc, char** argv);
+	static void cmdBenchScene(Console* con, int argc, char** argv);
+	static void cmdScenePlay(Console* con, int argc, char** argv);
+	static void cmdSceneStop(Console* con, int argc, char** argv);
+
+public:
+	Console();
+	// 启动命令任务（seriallink.begin之后调用）；display/scene为bench draw与scene命令的对象
+	bool begin(Display* display, ScenePlayer* scene);
+	// 串口任务调用：放入收到的一个字节，不阻塞（未启动时忽略）
+	void feed(uint8_t c);
+	uint32_t getOverrun();
+};
+
+extern Console console;
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef DATA_LOG_FORMAT_H
+#define DATA_LOG_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * .hdl 传感器数据记录格式（固件data_logger.cpp写入，3.Software/HoloLog/holo_log.py转换为CSV）
+ *
+ * 文件布局（小端）：
+ *   [DataLogHeader][块][块]...
+ *   块 = [DataLogBlock][DataLogImu * count]
+ *
+ * - 每块是一次SdWriter::write，写入来不及时整块丢弃；块头带有绝对时间，丢块不影响之后的时间
+ * - t_us为块中第一个样本相对文件开始（start_ms）的微秒数，dt_us为距上一个样本的微秒数（块内第一个为0）
+ * - lux为块期间最新的环境光读数（lx），期间没有新读数时为DATALOG_LUX_NONE
+ * - IMU样本为原始六轴（加速度16384/g，已扣除零偏；陀螺仪131/(°/s)），200Hz时约2.9KB/s
+ * - 文件没有块数字段，读取到文件末尾为止（断电时末尾不完整的块忽略）
+ */
+
+#define DATALOG_MAGIC "HDLG"
+#define DATALOG_VERSION 1
+#define DATALOG_BLOCK_TAG 0xB1
+#define DATALOG_LUX_NONE 0xFFFF
+
+#pragma pack(push, 1)
+
+struct DataLogHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	uint16_t imu_rate_hz;  // IMU标称采样率
+	uint16_t seq;          // 文件序号（轮换时加1）
+	uint32_t start_ms;     // 文件开始时的millis()
+	uint32_t start_epoch;  // 文件开始时的Unix时间，时钟尚未同步时为0
+	uint8_t block_size;    // sizeof(DataLogBlock)
+	uint8_t sample_size;   // sizeof(DataLogImu)
+	uint16_t reserved;
+};
+
+struct DataLogBlock
+{
+	uint8_t tag;           // DATALOG_BLOCK_TAG
+	uint8_t count;         // 之后的IMU样本数
+	uint16_t lux;
+	uint32_t t_us;
+};
+
+struct DataLogImu
+{
+	uint16_t dt_us;
+	int16_t v[6];          // ax ay az gx gy gz
+};
+
+#pragma pack(pop)
+
+#endif
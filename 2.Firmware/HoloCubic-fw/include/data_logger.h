@@ -0,0 +1,146 @@
+#ifndef DATA_LOGGER_H
+#define DATA_LOGGER_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+#include "imu.h"
+#include "sd_writer.h"
+#include "stream_chart.h"
+#include "app_manager.h"
+#include "data_log_format.h"
+
+// 1：启动后开始记录（不打开界面）
+#ifndef DATALOG_ON_BOOT
+#define DATALOG_ON_BOOT 0
+#endif
+
+// 记录文件目录（log_00001.hdl……），用3.Software/HoloLog/holo_log.py转换为CSV
+#define DATALOG_DIR "/log/data"
+// IMU采样率（FIFO/融合模式下经原始样本流；DMP、轮询模式下按总线的100Hz记录）
+#define DATALOG_IMU_RATE_HZ 200
+// 每块的IMU样本数（一次SdWriter::write，200Hz时每秒10块，每块288字节）
+#define DATALOG_BLOCK_SAMPLES 20
+// 文件轮换：记录满DATALOG_ROTATE_MIN分钟或文件达到DATALOG_ROTATE_BYTES时换下一个文件
+#define DATALOG_ROTATE_MIN 60
+#define DATALOG_ROTATE_BYTES (32UL * 1024UL * 1024UL)
+// 只保留最近的文件数（按小时轮换时为14天，200Hz每个文件约10MB），更早的文件在轮换时删除
+#define DATALOG_KEEP_FILES 336
+// 记录任务检查轮换条件的周期；轮换时等待传感器任务在块边界切换到新文件的最长时间
+#define DATALOG_CHECK_MS 1000
+#define DATALOG_SWITCH_MS 500
+#define DATALOG_TASK_CORE 0
+#define DATALOG_TASK_PRIORITY 1
+#define DATALOG_TASK_STACK 4096
+// 实时曲线：加速度三轴按DATALOG_CHART_HZ抽取，传感器任务与LVGL任务之间经DATALOG_CHART_RING个样本的环形缓冲
+#define DATALOG_CHART_HZ 25
+#define DATALOG_CHART_RING 16
+#define DATALOG_CHART_W 200
+#define DATALOG_CHART_H 100
+// 状态文字的刷新周期
+#define DATALOG_INFO_MS 1000
+
+/**
+ * 传感器数据记录（格式见data_log_format.h）
+ *
+ * 长时间（数天）记录房间内的移动与光照，不影响界面刷新：
+ * - IMU样本在传感器任务中组成块（DATALOG_BLOCK_SAMPLES个样本），每块一次SdWriter::write（只复制进内存缓冲），
+ *   SD卡的写入与同步在SdWriter的写入任务中进行；环境光读数记在块头
+ * - 文件轮换、删除旧文件在记录任务中进行：先打开新文件、写入文件头，传感器任务在下一个块边界切换过去，
+ *   之后再关闭旧文件，轮换期间不丢样本
+ * - SD卡重新挂载后（tf.generation()变化，见sd_hotplug.h）旧文件句柄失效，立即轮换到新文件
+ * - 界面（应用datalog_app）只显示加速度实时曲线（StreamChart，每个采样一列）与状态，离开前台后记录继续
+ *
+ * 注意事项：
+ * - 200Hz需要IMU工作在FIFO模式或软件融合（DMP可用时为100Hz的DMP输出，采样率记在文件头中）
+ * - 记录期间IMU不进入运动唤醒（电源模块的待机仍会关闭背光）
+ * - start()/stop()不等待SD卡，可在LVGL任务中调用；界面接口必须在LVGL任务中调用
+ */
+class DataLogger
+{
+private:
+	IMU* imu;
+	SdWriter writers[2];
+	uint32_t start_us[2];      // 各文件开始时的micros()，块时间相对于此
+	volatile int8_t cur;       // 传感器任务写入的文件，-1为没有
+	volatile int8_t next;      // 已打开、等待在块边界切换的新文件
+	uint16_t seq;
+	uint32_t file_ms;
+	uint16_t sd_gen;           // 当前文件打开时SD卡的挂载次数
+	int32_t scan_gen;          // 上次查找已有文件序号时的挂载次数，-1为尚未查找
+	uint16_t rate_hz;
+	bool subscribed;
+	bool raw;                  // 经原始样本流（false为传感器总线）
+	volatile bool active;      // 传感器任务接收样本
+	volatile bool stop_req;
+	volatile bool rotate_req;
+	TaskHandle_t task;
+	portMUX_TYPE mux;
+
+	// 传感器任务中组装的块
+	uint8_t block[sizeof(DataLogBlock) + DATALOG_BLOCK_SAMPLES * sizeof(DataLogImu)];
+	uint8_t block_count;
+	int8_t block_file;
+	uint32_t last_us;
+	volatile uint16_t lux;
+	volatile bool lux_new;
+
+	// 实时曲线的环形缓冲（mux保护）
+	int16_t ring[DATALOG_CHART_RING][3];
+	uint8_t ring_head;
+	uint8_t ring_count;
+	uint16_t chart_every;
+	uint16_t chart_phase;
+
+	// 统计（结束的文件累计 + 当前文件）
+	uint32_t samples;
+	uint32_t bytes_done;
+	uint32_t lost_done;
+
+	// 界面
+	lv_obj_t* scr;
+	lv_obj_t* prev_scr;
+	lv_obj_t* info;
+	StreamChart chart;
+	uint32_t info_due;
+
+	void pushSample(const int16_t* accel, const int16_t* gyro, uint32_t t_us);
+	void flushBlock();
+	uint16_t lastSeq();
+	bool rotateFile();
+	void closeFile(int8_t f);
+	void run();
+	static void taskEntry(void* arg);
+	static void onRaw(const int16_t* accel, const int16_t* gyro, uint32_t t_us, void* user);
+	static void onBusImu(const SensorSample* s, void* user);
+	static void onBusLux(const SensorSample* s, void* user);
+
+public:
+	DataLogger();
+	// 指定IMU并订阅传感器总线（setup中调用一次；总线订阅不能取消，停止记录后回调直接返回）
+	void begin(IMU* imu);
+	// 开始记录（启动记录任务，文件在任务中打开）
+	bool start();
+	// 请求停止：写入最后一块、关闭文件后记录任务退出（不等待）
+	void stop();
+	bool isRunning();
+	// 请求立即换下一个文件
+	void rotate();
+
+	uint16_t getRate();
+	uint16_t getSeq();
+	uint32_t getSamples();
+	// 已写入（含当前文件仍在缓冲中）与写入来不及丢弃的字节数
+	uint32_t getBytes();
+	uint32_t getLost();
+
+	// 界面：实时曲线与状态（LVGL任务）
+	bool showUi();
+	void hideUi();
+	void updateUi();
+};
+
+extern DataLogger datalogger;
+// 以应用形式运行（apps.open(apps.add(datalog_app))）：进入时开始记录，离开前台后继续记录，停止应用时结束
+extern const App datalog_app;
+
+#endif
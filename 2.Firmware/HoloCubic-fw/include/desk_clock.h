@@ -0,0 +1,60 @@
+#ifndef DESK_CLOCK_H
+#define DESK_CLOCK_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+#include "app_manager.h"
+#include "network.h"
+
+// 数字字体（platformio.ini中按"0123456789:-"子集化，与天气温度共用，只占几KB flash）
+#define CLOCK_FONT lv_font_montserrat_48
+// 数字与背景颜色（预渲染进字形图像，改动后重新进入应用生效）
+#define CLOCK_FG_COLOR LV_COLOR_MAKE(0xF0, 0xF0, 0xF0)
+#define CLOCK_BG_COLOR LV_COLOR_BLACK
+// 1：冒号每秒闪烁（只重绘冒号所在的区域）
+#define CLOCK_BLINK 1
+// 时钟界面的刷新周期：每秒的定时器在有变化时立即触发一次刷新，其余时间LVGL任务休眠
+#define CLOCK_REFR_MS 1000
+// 秒定时器在整秒之后多少毫秒触发（避免因定时误差落在整秒之前而重复显示同一秒）
+#define CLOCK_TICK_SLACK_MS 5
+
+/**
+ * 桌面时钟
+ * 进入时把"0"~"9"和":"各渲染一次为真彩色字形图像（底色已填好，绘制时直接复制），
+ * 时、分每一位是一个lv_img，每秒只替换变化的那一位图像，只有该位的区域被重绘；
+ * 日期标签只在日期变化时更新。
+ * 时间取自时间服务（后台抓取窗口中校时，重启后从RTC内存恢复），时间同步之前不显示数字。
+ * 所有接口必须在LVGL任务中调用
+ */
+class DeskClock
+{
+private:
+	lv_obj_t* scr;
+	lv_obj_t* prev_scr;
+	lv_obj_t* digit[4];     // 时十位、时个位、分十位、分个位
+	lv_obj_t* colon;
+	lv_obj_t* date;
+	lv_task_t* task;
+	lv_img_dsc_t glyph[11]; // '0'~'9'，':'
+	int8_t shown[4];        // 当前显示的数字，-1为未显示
+	int16_t shown_yday;
+	Network* net;
+
+	bool renderGlyphs();
+	void freeGlyphs();
+	void tick();
+	static void taskCb(lv_task_t* t);
+
+public:
+	DeskClock();
+	void setNetwork(Network* n);
+	bool start();
+	void stop();
+	bool isRunning();
+};
+
+extern DeskClock deskclock;
+// 以应用形式运行（apps.open(apps.add(clock_app))），离开前台时停止
+extern const App clock_app;
+
+#endif
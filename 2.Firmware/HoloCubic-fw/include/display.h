@@ -6,16 +6,200 @@
 #define LCD_BL_PIN 5
 #define LCD_BL_PWM_CHANNEL 0
 
+// 默认显示缓冲区行数（每个缓冲区）
+#define DISP_BUF_LINES 10
+// 不少于该像素数的整行填充交给内存DMA（仅支持esp_async_memcpy的芯片；ESP32上使用IRAM软件内核）
+#define DISP_GPU_DMA_MIN_PX 2400
+// 垂直同步：等待TE脉冲的超时（面板60Hz时一帧16.7ms），以及TE之后多久以内开始发送可不再等待
+// TE引脚在TFT_eSPI用户配置中以TFT_TE设置，未设置时不做同步
+#define DISP_TE_TIMEOUT_MS 20
+#define DISP_TE_WINDOW_US 1500
+// 刷新合并：不大于该像素数的小区域先复制到暂存区，一帧结束（或暂存区满）时在一次总线会话中连续写出
+#define DISP_COALESCE_MAX_PX 1200
+#define DISP_COALESCE_BUF_PX 2400
+#define DISP_COALESCE_AREAS 16
+// SPI写时钟自检：在面板顶部写入伪随机图案并经RAMRD读回，按CRC比较，从低到高逐档尝试
+// ESP32 SPI时钟为80MHz整数分频，默认SPI_FREQUENCY（40MHz）之上只有80MHz一档
+#define DISP_SPI_TUNE 1
+#define DISP_SPI_TUNE_FREQS { 40000000, 80000000 }
+#define DISP_SPI_TUNE_ROWS 8
+#define DISP_SPI_TUNE_ROUNDS 3
+#define DISP_SPI_NAMESPACE "display"
+// 启动画面：LVGL初始化之前直接把资源包中的"splash"（没有时用"logo"/内置Logo）写屏并点亮背光
+// 支持索引色1/2/4/8位与16位真彩色，按条带解码，DMA可用时解码与发送重叠
+#define DISP_SPLASH 1
+#define DISP_SPLASH_ASSET "splash"
+#define DISP_SPLASH_LINES 16
+#define DISP_SPLASH_BACKLIGHT 0.2f
+// 显示方向（Display::setOrientation）：旋转与镜像由ST7789的MADCTL在面板内完成，不做逐像素变换
+#define DISP_ROTATE_0 0x00
+#define DISP_ROTATE_90 0x01
+#define DISP_ROTATE_180 0x02
+#define DISP_ROTATE_270 0x03
+#define DISP_MIRROR_H 0x04     // 左右镜像
+#define DISP_MIRROR_V 0x08     // 上下镜像
+// 默认方向：左右镜像（原setRotation(4)，经分光棱镜反射后为正像）
+#define DISP_ORIENT_DEFAULT DISP_MIRROR_H
+// 可单独设置方向的屏幕数（每个显示）
+#define DISP_ORIENT_SCREENS 8
+// 队列刷新（DISP_FLUSH_QUEUED）的描述符组数：每组为一条带的6个事务，循环使用
+#define DISP_QUEUE_BANDS 2
+// 同一SPI总线上的面板数（均为TFT_eSPI用户配置中的面板型号）
+// 多于一块时在用户配置中设置TFT_CS为-1，片选由各Display的cs_pin控制
+#define DISP_MAX 2
+
+/**
+ * 刷新模式
+ * DISP_FLUSH_BLOCKING: pushColors阻塞发送，单缓冲
+ * DISP_FLUSH_DMA:      pushImageDMA异步发送，双缓冲（LVGL绘制下一条带时上一条带正在DMA传输）
+ * DISP_FLUSH_QUEUED:   同DMA模式，但每条带的CASET/RASET/RAMWR命令与像素作为一组预先编码的SPI事务一次排队，
+ *                      命令之间CPU不再等待总线，像素发送完成时在SPI中断中通知LVGL
+ *                      （需DISP_PANEL_FAST；有镜像面板时逐条带退回DMA模式）
+ */
+enum DispFlushMode
+{
+	DISP_FLUSH_BLOCKING = 0,
+	DISP_FLUSH_DMA,
+	DISP_FLUSH_QUEUED
+};
+
+/**
+ * 缓冲区存放位置
+ * DISP_BUF_INTERNAL: 片内可DMA内存（MALLOC_CAP_DMA）
+ * DISP_BUF_PSRAM:    外部PSRAM（ESP32的SPI DMA无法直接读取PSRAM，此时刷新退回阻塞模式）
+ */
+enum DispBufPlacement
+{
+	DISP_BUF_INTERNAL = 0,
+	DISP_BUF_PSRAM
+};
+
+/**
+ * 显示配置
+ * buf_lines:  每个缓冲区的行数，常用10/20/40/240（整帧）
+ * double_buf: 是否使用双缓冲（仅DMA模式有意义）
+ * cs_pin:     面板片选，-1表示由TFT_eSPI按TFT_CS控制（只能有一块面板）
+ * bl_pin:     背光PWM引脚（-1表示没有），bl_channel为LEDC通道，各面板不能相同
+ * refr_ms:    LVGL刷新周期（毫秒），各显示独立
+ */
+struct DisplayConfig
+{
+	DispFlushMode flush_mode;
+	uint16_t buf_lines;
+	bool double_buf;
+	DispBufPlacement placement;
+	int8_t cs_pin;
+	int8_t bl_pin;
+	uint8_t bl_channel;
+	uint16_t refr_ms;
+};
+
+#define DISPLAY_CONFIG_DEFAULT { DISP_FLUSH_DMA, DISP_BUF_LINES, true, DISP_BUF_INTERNAL, -1, LCD_BL_PIN, LCD_BL_PWM_CHANNEL, LV_DISP_DEF_REFR_PERIOD }
+
+/**
+ * 刷新旁路：每个刷新区域在调色、字节交换与发送之前调用（LVGL任务中执行），
+ * 像素为LVGL绘制的结果（LVGL颜色格式），回调返回后缓冲区即被发送与改写
+ */
+typedef void (*disp_tap_cb_t)(const lv_area_t* area, const lv_color_t* color_p, void* user);
+
+/**
+ * 刷新合并中暂存的一个小区域
+ */
+struct CoalesceArea
+{
+	lv_area_t area;
+	uint16_t offset;     // 在暂存区中的起始像素
+};
+
+/**
+ * ST7789面板与对应的LVGL显示
+ *
+ * 每个实例有自己的显示缓冲区、刷新合并暂存区、方向与LVGL刷新周期，由同一个LVGL实例绘制。
+ * 第一个init的实例为LVGL默认显示（lv_scr_act()），其他显示的屏幕用lv_disp_get_scr_act(getDisp())取得。
+ * init时指定mirror_of则不注册LVGL显示，源显示刷新的区域同时发送到本面板（内容相同）。
+ *
+ * 注意事项：
+ * - 面板共用一条SPI总线与一个DMA通道（TFT_eSPI只支持一组总线配置），
+ *   切换面板前等待上一块面板的DMA完成，两块面板的刷新不会重叠
+ * - TE垂直同步与SPI时钟自检只作用于第一块面板（自检得到的时钟对整条总线生效）
+ * - 所有接口必须在LVGL任务中调用
+ */
 
 class Display
 {
 private:
+	DisplayConfig config;
+	uint32_t buf_bytes;
+	lv_disp_buf_t disp_buf;
+	lv_disp_t* disp;              // 注册的LVGL显示，镜像面板为NULL
+	Display* mirror;              // 同时显示本显示内容的面板
+	bool te_frame_start;          // 下一次刷新是新一帧的第一个区域
+	bool strip_swap;              // beginStrips之前的字节交换设置
 
+	lv_color_t* coal_buf;
+	CoalesceArea coal_areas[DISP_COALESCE_AREAS];
+	uint8_t coal_count;
+	uint16_t coal_used;
+
+	uint8_t orient_cur;
+	uint8_t orient_base;          // 没有单独设置的屏幕使用的方向
+	lv_obj_t* orient_scr[DISP_ORIENT_SCREENS];
+	uint8_t orient_val[DISP_ORIENT_SCREENS];
+	lv_obj_t* orient_last_scr;
+
+	uint16_t* lut;                // 调色表（面板字节序，lv_gpu_esp32_copy_lut），NULL为不调色
+	disp_tap_cb_t tap;            // 刷新旁路（截图），设置期间不直出
+	void* tap_user;
+
+	bool allocBuffers(lv_color_t** b1, lv_color_t** b2);
+	bool spiSelfTest(uint32_t freq);
+	void tuneSpi();
+	void select();
+	void frameBegin();
+	void coalFlush();
+	bool coalAdd(const lv_area_t* area, const lv_color_t* color_p);
+	void sendArea(const lv_area_t* area, lv_color_t* color_p, bool swap);
+	void orientApply(uint8_t orient);
+	uint8_t orientOf(lv_obj_t* scr);
+	void orientUpdate();
+	static Display* of(lv_disp_drv_t* drv);
+	static void flushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p);
+	static void flushDmaCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p);
+	static void flushQueuedCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p);
+	static bool directCb(lv_disp_drv_t* drv, const lv_area_t* area, const lv_color_t* src, lv_coord_t src_stride);
 
 public:
-	void init();
-	void routine();
+	Display();
+	void init(DispFlushMode mode = DISP_FLUSH_DMA);
+	void init(const DisplayConfig& cfg, Display* mirror_of = NULL);
+	uint32_t routine();
 	void setBackLight(float);
+	bool splash(const lv_img_dsc_t* img = NULL);
+	void pushRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* px);
+	void beginStrips();
+	void pushStrip(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* px);
+	void endStrips();
+	bool pushFrame(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* px);
+	void frameWait();
+	void setVsync(bool enable);
+	bool getVsync();
+	void waitVsync();
+	void setOrientation(uint8_t orient);
+	uint8_t getOrientation();
+	void setScreenOrientation(lv_obj_t* scr, int16_t orient);
+	bool setColorCurve(const uint8_t* red, const uint8_t* green, const uint8_t* blue);
+	bool hasColorCurve();
+	// 设置刷新旁路（cb为NULL时取消），同一时刻只有一个
+	void setFlushTap(disp_tap_cb_t cb, void* user = NULL);
+	disp_tap_cb_t getFlushTap();
+
+	DispFlushMode getFlushMode();
+	const DisplayConfig& getConfig();
+	lv_disp_t* getDisp();
+	void setRefreshPeriod(uint16_t ms);
+	uint32_t getBufBytes();
+	uint32_t getSpiFrequency();
+	static void clearSpiTuning();
 };
 
-#endif
\ No newline at end of file
+#endif
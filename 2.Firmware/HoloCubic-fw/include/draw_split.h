@@ -0,0 +1,66 @@
+#ifndef DRAW_SPLIT_H
+#define DRAW_SPLIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 绘制工作任务：固定在核心0（LVGL任务在核心1），优先级高于传感器与日志任务、低于WiFi
+#define DRAW_SPLIT_TASK_CORE 0
+#define DRAW_SPLIT_TASK_PRIORITY 4
+#define DRAW_SPLIT_TASK_STACK 3072
+// 不少于该像素数的逐像素运算才拆分：一次跨核唤醒与等待约10微秒，相当于约1000个像素的混合
+#define DRAW_SPLIT_MIN_PX 1024
+// 1：启动后立即启用（实验性，默认关闭）
+#ifndef DRAW_SPLIT_ON_BOOT
+#define DRAW_SPLIT_ON_BOOT 0
+#endif
+
+/**
+ * 按行拆分的绘制工作：处理第y1行到第y2行（含，相对于工作区域的第一行）
+ */
+typedef void (*draw_split_cb_t)(void* ctx, int32_t y1, int32_t y2);
+
+/**
+ * 统计信息（单调递增）
+ */
+typedef struct
+{
+	uint32_t jobs;       // 拆分执行的次数
+	uint32_t stolen;     // 工作任务未及时开始、由LVGL任务自己完成后半部分的次数
+	uint32_t worker_us;  // 工作任务累计绘制时间
+} draw_split_stats_t;
+
+/**
+ * 双核绘制（实验性）
+ *
+ * LVGL的对象遍历、样式、图像缓存与堆都不是线程安全的，两个核心不能同时渲染两个区域；
+ * 这里只拆分其中不访问共享状态的逐像素运算：绘制缓冲中的一块区域按行分成上下两半，
+ * LVGL任务做上半部分，核心0上的工作任务同时做下半部分，两半写入同一绘制缓冲中不相交的行。
+ * 调用点见lv_draw_blend.c（带透明度的填充与图像混合）与lv_draw_img.c（缩放/旋转、ARGB、色键与重新着色）。
+ *
+ * 工作任务没有及时开始（如核心0正忙于WiFi）时，LVGL任务做完上半部分后直接接手下半部分，
+ * 最坏情况与单核相同，不会等待。
+ *
+ * 注意事项：
+ * - 只能在LVGL任务中调用；工作任务内再次调用或上一次拆分未结束时按单核执行
+ * - 工作回调不能分配LVGL内存、读写图像缓存或遮罩链表（半径遮罩有行缓存），需要的缓冲由调用者预先分配
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	// 启用/停用（第一次启用时创建工作任务，失败返回false）
+	bool draw_split_enable(bool en);
+	bool draw_split_is_enabled(void);
+	// px个像素的工作是否会拆分（调用者据此为工作任务预先分配缓冲）
+	bool draw_split_ready(uint32_t px);
+	// 执行cb：rows行中前一半在当前任务，后一半在工作任务；draw_split_ready为false或rows < 2时全部在当前任务
+	void draw_split_run(draw_split_cb_t cb, void* ctx, int32_t rows);
+	void draw_split_get_stats(draw_split_stats_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
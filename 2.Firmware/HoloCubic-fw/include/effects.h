@@ -0,0 +1,107 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "display.h"
+
+// 每条带行数：两个条带缓冲（DMA内存）共 2 * 240 * 8 * 2 = 7.5KB
+#define EFFECT_STRIP_LINES 8
+#define EFFECT_FPS 40
+// 噪声类效果（火焰、噪声）按N*N像素块计算：inoise8逐像素计算整屏约需36ms
+#define EFFECT_NOISE_BLOCK 2
+#define EFFECT_STARS 96
+// 自动轮换间隔（秒），0表示不轮换
+#define EFFECT_CYCLE_S 30
+
+/**
+ * 效果类型
+ */
+enum EffectType
+{
+	EFFECT_PLASMA = 0,     // 正弦叠加等离子
+	EFFECT_STARFIELD,      // 星空穿梭
+	EFFECT_FIRE,           // 噪声火焰
+	EFFECT_NOISE,          // 熔岩噪声
+	EFFECT_COUNT
+};
+
+/**
+ * 统计信息
+ */
+struct EffectStats
+{
+	uint32_t frames;
+	uint32_t frame_us;     // 最近一帧渲染与写屏耗时
+	uint32_t max_us;
+};
+
+/**
+ * 程序化效果（待机画面）
+ * 不使用整屏帧缓冲（16位整屏需115KB）：每帧由上到下逐条带计算像素，直接写成面板字节序，
+ * 两个条带缓冲交替使用，DMA发送上一条带时计算下一条带。
+ * 计算全部使用FastLED lib8tion定点函数（sin8/cos8/inoise8/qadd8/qsub8）与256色调色板查表。
+ *
+ * 注意事项：
+ * - start()/stop()会切换LVGL屏幕并创建lv_task，需在LVGL任务中调用
+ * - 运行期间载入一个空白屏幕，避免LVGL重绘覆盖效果画面；stop()恢复原屏幕
+ */
+class EffectEngine
+{
+private:
+	struct Star
+	{
+		int16_t x;             // 空间坐标 -1024 ~ 1023
+		int16_t y;
+		uint16_t z;            // 深度，越小越近
+		int16_t sx;            // 本帧投影位置，-1表示不可见
+		int16_t sy;
+		uint16_t color;        // 本帧颜色（面板字节序）
+		uint8_t size;
+	};
+
+	Display* display;
+	EffectType type;
+	bool running;
+	uint16_t* strips[2];
+	uint16_t palette[256];     // 面板字节序
+	uint8_t cols[LV_HOR_RES_MAX];                   // 等离子的列项；噪声效果的一行像素块
+	uint8_t diag[LV_HOR_RES_MAX + LV_VER_RES_MAX];  // 等离子的对角项（按x+y查表）
+	Star stars[EFFECT_STARS];
+
+	uint32_t t;                // 效果时间（ms）
+	uint32_t last_ms;
+	uint32_t switch_ms;
+	uint16_t cycle_s;
+
+	lv_task_t* frame_task;
+	lv_obj_t* screen;
+	lv_obj_t* prev_screen;
+	EffectStats stats;
+
+	void select(EffectType next);
+	void resetStar(Star* s, bool far);
+	void beginFrame(uint32_t dt);
+	void render(uint16_t* out, int32_t y0, int32_t lines);
+	void renderPlasma(uint16_t* out, int32_t y0, int32_t lines);
+	void renderStars(uint16_t* out, int32_t y0, int32_t lines);
+	void renderNoise(uint16_t* out, int32_t y0, int32_t lines);
+
+	static void frameCb(lv_task_t* task);
+
+public:
+	EffectEngine();
+
+	void setDisplay(Display* disp);
+	bool start(EffectType first = EFFECT_PLASMA);
+	void stop();
+	void next();
+	void setCycle(uint16_t seconds);
+
+	bool isRunning();
+	EffectType getType();
+	const char* getName();
+	void getStats(EffectStats* out);
+};
+
+#endif
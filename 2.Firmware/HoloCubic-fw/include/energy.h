@@ -0,0 +1,130 @@
+#ifndef ENERGY_H
+#define ENERGY_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+
+/*
+ * 各部件的电流模型（微安），按实测或数据手册的典型值估计，换硬件（背光LED、LDO、SD卡）时按实测修改
+ */
+// 常开部分：面板控制器、IMU、LDO静态电流、USB串口芯片
+#define ENERGY_UA_BOARD 8000
+// CPU：两核都空闲（80MHz）时的芯片电流，每个核满载（240MHz）增加的电流
+#define ENERGY_UA_CPU_IDLE 15000
+#define ENERGY_UA_CPU_CORE 25000
+// 背光：占空比100%时的电流（与占空比成正比）
+#define ENERGY_UA_BACKLIGHT 45000
+// WiFi：最大省电（每几个信标周期醒来一次）的平均电流；射频常开（连接、配网、数据窗口）的电流
+#define ENERGY_UA_WIFI_SLEEP 3000
+#define ENERGY_UA_WIFI_ON 95000
+// SD卡：空闲电流、读写期间的电流，以及估计读写时间所用的吞吐（字节/秒）
+#define ENERGY_UA_SD_IDLE 300
+#define ENERGY_UA_SD_ACTIVE 40000
+#define ENERGY_SD_READ_BPS 1200000
+#define ENERGY_SD_WRITE_BPS 400000
+// WS2812：每颗的静态电流，每个通道满亮度的电流（与发送的通道值成正比）
+#define ENERGY_UA_LED_IDLE 600
+#define ENERGY_UA_LED_CHANNEL 12000
+
+struct TelemetryTask;
+
+/**
+ * WiFi射频状态（Network按连接状态与省电窗口报告）
+ */
+enum EnergyWifi
+{
+	ENERGY_WIFI_OFF = 0,
+	ENERGY_WIFI_SLEEP,     // 已连接，最大省电
+	ENERGY_WIFI_ON         // 射频常开
+};
+
+/**
+ * 按部件估计的平均电流（0.1mA，两次采样之间的平均值）与所依据的负载
+ */
+struct EnergyStats
+{
+	uint16_t total_ma_x10;
+	uint16_t board_ma_x10;
+	uint16_t cpu_ma_x10;
+	uint16_t backlight_ma_x10;
+	uint16_t wifi_ma_x10;
+	uint16_t sd_ma_x10;
+	uint16_t led_ma_x10;
+
+	uint16_t backlight_permille;   // 背光平均占空比
+	int16_t cpu_load[2];           // 各核负载千分比，无法测得时为-1（按空闲计）
+	uint16_t radio_permille;       // 射频常开的时间比例
+	uint16_t sd_permille;          // 估计的SD读写时间比例
+	uint16_t led_permille;         // LED平均亮度（相对所有通道满亮度）
+	uint32_t total_uah;            // 遥测开始以来的估计耗电（微安时）
+};
+
+/**
+ * 能耗估计
+ *
+ * 为电池供电的版本挑选功能时，需要知道每项功能大约消耗多少电流。
+ * 各部件把负载变化报告给本模块，本模块按时间积分得到平均负载，再乘以各部件的电流模型：
+ * - 背光：Display::setBackLight的占空比
+ * - LED：Pixel每次发送的通道值之和（伽马校正与全局亮度之后）
+ * - WiFi：Network的连接状态与省电窗口（射频关闭 / 最大省电 / 常开）
+ * - CPU：遥测采样的各核空闲任务占用；未开启FreeRTOS运行时统计时LVGL所在的核按LVGL空闲率估计，另一核记为-1
+ * - SD卡：遥测的读写字节数按ENERGY_SD_x_BPS换算为读写时间
+ * 结果随遥测采样输出（TelemetrySample::energy，JSON的"power"）。
+ *
+ * 注意事项：
+ * - 只是估计：模型值为典型电流，CPU按满频计（动态调频与浅睡眠会使实际值更低），SD卡按吞吐折算时间
+ * - 报告接口可在任意任务中调用，只做一次积分（自旋锁内几条运算）
+ */
+class EnergyMeter
+{
+private:
+	struct Channel
+	{
+		uint32_t value;
+		uint64_t acc;          // value * 微秒
+		int64_t mark_us;
+	};
+
+	enum
+	{
+		CH_BACKLIGHT = 0,
+		CH_LED,
+		CH_RADIO,
+		CH_WIFI_UA,
+		CH_COUNT
+	};
+
+	Channel ch[CH_COUNT];
+	portMUX_TYPE lock;
+	uint8_t led_count;
+	int64_t mark_us;
+	uint64_t total_acc;        // 微安 * 微秒
+
+	void set(uint8_t id, uint32_t value);
+	uint32_t take(uint8_t id, int64_t now, uint32_t span_us);
+
+public:
+	EnergyMeter();
+
+	// 背光占空比0.0~1.0（Display::setBackLight）
+	void setBacklight(float duty);
+	// LED发送的各通道值之和（伽马校正与全局亮度之后，0~count * 3 * 255）与LED数（Pixel）
+	void setLed(uint32_t level, uint8_t count);
+	// WiFi射频状态（Network）
+	void setWifi(EnergyWifi state);
+
+	/**
+	 * 计算距上一次调用的平均电流（遥测任务调用）
+	 * @param sd_read/sd_write 期间SD卡读写的字节数
+	 * @param tasks 遥测的任务占用（cpu_permille为-1时不可用）
+	 */
+	void sample(EnergyStats* out, uint32_t sd_read, uint32_t sd_write, const TelemetryTask* tasks, uint8_t task_count);
+	// 清零累计耗电
+	void reset();
+
+	static int format(const EnergyStats* s, char* buf, size_t len);
+};
+
+extern EnergyMeter energy;
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef FETCH_SCHEDULER_H
+#define FETCH_SCHEDULER_H
+
+#include <Arduino.h>
+#include <freertos/semphr.h>
+#include "network.h"
+
+#define FETCH_MAX_SOURCES 8
+// 缓存值以字符串保存（数字、短文本），超长部分截断
+#define FETCH_VALUE_LEN 48
+// 数据源URL保存在条目内（调用方可在栈上拼接后传入）
+#define FETCH_URL_LEN NET_URL_MAX
+// 抓取任务：调度、读写SD缓存并执行值变化回调；HTTP请求与JSON解析（含parse）在Network的网络任务中执行
+#define FETCH_TASK_CORE 0
+#define FETCH_TASK_PRIORITY 1
+#define FETCH_TASK_STACK 8192
+// 断网时的检查周期、空闲时最长休眠（refresh()会提前唤醒）与请求失败后的重试间隔
+#define FETCH_TICK_MS 1000
+#define FETCH_IDLE_MAX_MS 60000
+#define FETCH_RETRY_S 60
+// 合并窗口：有数据源到期时，之后FETCH_BATCH_AHEAD_S内到期的数据源一起提前请求，
+// 但提前量不超过其刷新间隔的1/FETCH_BATCH_AHEAD_DIV（避免短间隔的数据源被过度请求）
+#define FETCH_BATCH_AHEAD_S 120
+#define FETCH_BATCH_AHEAD_DIV 4
+// SD卡缓存目录（每个数据源一个文件：时间戳 + 值）
+#define FETCH_CACHE_DIR "/cache"
+
+// 从过滤后的JSON中取出值写入out，失败返回false（在网络任务中执行）
+typedef net_parse_t fetch_parse_t;
+// 值变化通知（在抓取任务中执行，更新界面需通过runtime.post）
+typedef void (*fetch_change_t)(uint8_t id, const char* value, void* user);
+
+/**
+ * 数据源
+ * name:       缓存文件名，只能包含字母数字
+ * url:        完整URL（保存在条目内，调用方拼接时检查长度）
+ * interval_s: 刷新间隔
+ * ttl_s:      缓存有效期，超过后get()返回false（开机时SD缓存也按此判断）
+ * filter:     JSON过滤文档，需在整个运行期间有效
+ */
+struct FetchSource
+{
+	const char* name;
+	char url[FETCH_URL_LEN];
+	uint32_t interval_s;
+	uint32_t ttl_s;
+	const JsonDocument* filter;
+	fetch_parse_t parse;
+	fetch_change_t on_change;
+	void* user;
+};
+
+/**
+ * 后台数据抓取调度
+ * 抓取任务休眠到最近一个数据源到期，WiFi已连接时把到期与即将到期的数据源合并为一个窗口依次请求
+ * （同主机复用连接），窗口期间Network关闭省电，窗口之间射频处于最大省电；
+ * 结果缓存在内存与SD卡中，值变化时才通知界面；渲染任务只读缓存，不会等待HTTP
+ * 时间服务的NTP校时也在窗口中进行（缓存时间戳需要实时时钟，见time_service.h）
+ */
+class FetchScheduler
+{
+private:
+	struct Entry
+	{
+		FetchSource src;
+		char value[FETCH_VALUE_LEN];
+		time_t fetched_at;     // 取得该值的实时时间，0表示未知
+		uint32_t due;          // 下次请求的millis
+		bool has_value;
+	};
+
+	Network* net;
+	NetRequest req;            // 同一时刻只有一个请求在进行
+	Entry entries[FETCH_MAX_SOURCES];
+	uint8_t count;
+	SemaphoreHandle_t mutex;
+	TaskHandle_t task;
+
+	void fetch(uint8_t id);
+	bool inWindow(const Entry& e, uint32_t now);
+	uint32_t nextDue(uint32_t now);
+	void loadCache(uint8_t id);
+	void saveCache(uint8_t id);
+	bool fresh(const Entry& e);
+	static void taskEntry(void* arg);
+
+public:
+	bool begin(Network* network);
+	int add(const FetchSource& src);
+	bool get(uint8_t id, char* out, size_t len);
+	void refresh(uint8_t id);
+};
+
+extern FetchScheduler fetcher;
+
+#endif
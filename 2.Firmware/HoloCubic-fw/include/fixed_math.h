@@ -0,0 +1,106 @@
+#ifndef FIXED_MATH_H
+#define FIXED_MATH_H
+
+#include <stdint.h>
+#include <FastLED.h>
+#include <lvgl.h>
+
+/**
+ * 定点数学工具
+ *
+ * 逐采样（IMU、传感器回调）与逐像素（特效、视差）的运算用整数完成：
+ * 中断与总线回调中不使用浮点，免去FPU现场保存；浮点只留在初始化与界面设置等低频路径。
+ *
+ * 数值格式：
+ * - q15_t：Q1.15，[-1, 1)，1.0记为FX_Q15_ONE（与FastLED sin16、LVGL _lv_trigo_sin的输出一致）
+ * - q16_t：Q16.16，约±32768，1.0记为FX_Q16_ONE
+ * - fx_angle_t：二进制角度，65536为一整圈（与FastLED sin16/cos16的输入一致，溢出即回绕）
+ *
+ * 注意事项：
+ * - fx_sin/fx_cos直接使用FastLED的sin16/cos16（误差不超过0.69%），查找表在闪存中，
+ *   不能在闪存缓存关闭期间调用；fixed_math.cpp中的函数与查找表在IRAM/DRAM中，可在中断中使用
+ * - 乘法结果超出格式范围时回绕，不做饱和
+ */
+
+typedef int16_t q15_t;
+typedef int32_t q16_t;
+typedef uint16_t fx_angle_t;
+
+#define FX_Q15_ONE 32767
+#define FX_Q16_ONE 65536
+// 编译期常量，如FX_Q16(0.8333f)；不要用于运行时的浮点变量
+#define FX_Q16(x) ((q16_t)((x) * 65536.0f + ((x) >= 0 ? 0.5f : -0.5f)))
+#define FX_Q15(x) ((q15_t)((x) * 32767.0f + ((x) >= 0 ? 0.5f : -0.5f)))
+#define FX_ANGLE_90 16384
+#define FX_ANGLE_180 32768
+
+static inline q15_t fx_mul_q15(q15_t a, q15_t b)
+{
+	return (q15_t)(((int32_t)a * b + (1 << 14)) >> 15);
+}
+
+static inline q16_t fx_mul_q16(q16_t a, q16_t b)
+{
+	return (q16_t)(((int64_t)a * b + (1 << 15)) >> 16);
+}
+
+static inline q16_t fx_from_int(int32_t v)
+{
+	return (q16_t)(v * FX_Q16_ONE);
+}
+
+// 四舍五入取整
+static inline int32_t fx_round(q16_t v)
+{
+	return (v + (1 << 15)) >> 16;
+}
+
+// a到b之间按t（Q15，0~FX_Q15_ONE）线性插值
+static inline int32_t fx_lerp(int32_t a, int32_t b, q15_t t)
+{
+	return a + (int32_t)(((int64_t)(b - a) * t) >> 15);
+}
+
+static inline fx_angle_t fx_deg_to_angle(int32_t deg)
+{
+	return (fx_angle_t)(deg * 65536 / 360);
+}
+
+static inline int32_t fx_angle_to_deg(fx_angle_t a)
+{
+	return ((int32_t)a * 360 + FX_ANGLE_180) >> 16;
+}
+
+static inline q15_t fx_sin(fx_angle_t a)
+{
+	return sin16(a);
+}
+
+static inline q15_t fx_cos(fx_angle_t a)
+{
+	return cos16(a);
+}
+
+// 整数角度（度）的正弦，使用LVGL的查找表（精确到1度）
+static inline q15_t fx_sin_deg(int16_t deg)
+{
+	return _lv_trigo_sin(deg);
+}
+
+// 0~255的亮度按0~255缩放（FastLED scale8，scale为255时接近原值）
+static inline uint8_t fx_scale8(uint8_t v, uint8_t scale)
+{
+	return scale8(v, scale);
+}
+
+// 向量(x, y)的方向角：x轴正方向为0，逆时针增加；查找表加线性插值，误差小于0.01度
+fx_angle_t fx_atan2(int32_t y, int32_t x);
+// 整数平方根（向下取整）
+uint16_t fx_isqrt(uint32_t x);
+// 向量长度，x、y绝对值不超过32767
+uint16_t fx_hypot(int16_t x, int16_t y);
+// 平方根倒数1/sqrt(x)（Q16.16输入与输出），x <= 0时返回INT32_MAX；
+// 相对误差约1/32768，x较大、结果较小时受Q16分辨率限制（误差不超过1个最低位）
+q16_t fx_rsqrt(q16_t x);
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <Arduino.h>
+#include "scene_index.h"
+#include "runtime.h"
+
+// 管理协议UDP端口与mDNS服务名（_holocubic._udp）
+#define FLEET_PORT 7010
+#define FLEET_MDNS_SERVICE "holocubic"
+// 设备名（mDNS主机名，<name>.local）：未配置device.name时为holocubic-后接MAC后3字节
+#define FLEET_NAME_MAX 24
+#define FLEET_NAME_PREFIX "holocubic-"
+// 共享密钥：未配置fleet.key时只响应STATUS，不接受写操作
+#define FLEET_KEY_MAX 32
+// 接收任务
+#define FLEET_TASK_CORE 0
+#define FLEET_TASK_PRIORITY 1
+#define FLEET_TASK_STACK 4096
+// 单个请求/回复的最大长度（一个UDP包，不分片）
+#define FLEET_PKT_MAX 1024
+// 一次SYNC查询的最大条目数（回复中每条一位）
+#define FLEET_SYNC_MAX 32
+// 一次CHUNKS回复的最大块CRC数（受FLEET_PKT_MAX限制）
+#define FLEET_CHUNKS_MAX 240
+
+#define FLEET_MAGIC0 'H'
+#define FLEET_MAGIC1 'F'
+#define FLEET_VERSION 1
+// 写操作的认证标签：HMAC-SHA256(fleet.key, 包头 + 载荷)的前8字节，附在载荷之后
+#define FLEET_TAG_LEN 8
+
+// FleetHeader.op（回复为op | FLEET_REPLY）
+#define FLEET_OP_STATUS 0x01   // 无载荷，可广播；回复FleetStatus（不需要认证）
+#define FLEET_OP_CONFIG 0x02   // 载荷为若干"路径\0值\0"（路径同config.json，如"log.sinks"）；回复FleetConfigResult
+#define FLEET_OP_SCENE 0x03    // 载荷为uint8_t帧率 + 场景名\0（场景根目录下，空名为停止）
+#define FLEET_OP_SYNC 0x04     // 载荷为若干FleetSyncEntry + 路径\0；回复uint8_t条数 + 位图（需要上传的条目为1）
+#define FLEET_OP_RESTART 0x05  // 回复后重启（新的WiFi配置在重启后生效）
+#define FLEET_OP_CHUNKS 0x06   // 载荷为uint16_t起始块号 + 路径\0；回复FleetChunks + uint32_t块CRC * n
+#define FLEET_REPLY 0x80
+
+// FleetHeader.status（回复）
+#define FLEET_OK 0
+#define FLEET_ERR_AUTH 1       // 未配置密钥、标签不符、会话号不符或序号未递增
+#define FLEET_ERR_FORMAT 2     // 载荷格式错误
+#define FLEET_ERR_OP 3         // 不支持的操作
+#define FLEET_ERR_BUSY 4       // 无法执行（界面消息队列已满、没有设置场景处理函数）
+
+// FleetStatus.flags
+#define FLEET_STATUS_WRITABLE 0x01   // 已配置密钥，接受写操作
+#define FLEET_STATUS_UPLOAD 0x02     // 无线上传服务正在运行（SYNC之后按upload_server.h推送文件）
+
+#pragma pack(push, 1)
+
+/**
+ * 包头（小端，16字节）
+ * session为设备本次启动时的随机数（STATUS回复中给出），写操作须带上当前会话号；
+ * seq由主机递增，回复原样带回；写操作的seq须比本会话上一次接受的大（按有符号差比较），重放的包被拒绝
+ */
+struct FleetHeader
+{
+	uint8_t magic[2];
+	uint8_t version;
+	uint8_t op;
+	uint32_t session;
+	uint32_t seq;
+	uint16_t len;          // 载荷长度（不含认证标签）
+	uint8_t status;        // 回复的FLEET_OK/FLEET_ERR_x，请求为0
+	uint8_t reserved;
+};
+
+/**
+ * STATUS回复载荷
+ */
+struct FleetStatus
+{
+	uint8_t mac[6];
+	int8_t rssi;
+	uint8_t flags;             // FLEET_STATUS_x
+	uint32_t uptime_s;
+	uint32_t heap_free;
+	uint32_t heap_min;
+	uint32_t frames;           // 开机以来的刷新帧数（两次查询求差得到帧率）
+	uint32_t scene_count;      // 场景索引中的场景数
+	uint16_t http_port;        // 上传服务端口，未运行时为0
+	uint16_t reserved;
+	char name[FLEET_NAME_MAX];
+	char firmware[32];         // 固件版本（esp_app_desc_t.version）
+	char scene[SCENE_INDEX_NAME_MAX];  // 最近一次经SCENE触发的场景，没有时为空
+};
+
+/**
+ * CONFIG回复载荷
+ */
+struct FleetConfigResult
+{
+	uint8_t applied;
+	uint8_t rejected;          // 未知路径、类型或范围不符的项（保留原值）
+};
+
+/**
+ * SYNC条目（后接以0结尾的SD卡路径，须在UPLOAD_ROOT下）
+ * 大小与CRC32（与zlib相同）都一致时视为已同步；比较用文件内容清单（scene_manifest.h），未修改的文件不读取
+ */
+struct FleetSyncEntry
+{
+	uint32_t size;
+	uint32_t crc32;
+};
+
+/**
+ * CHUNKS回复载荷（文件不存在时status为FLEET_ERR_FORMAT）
+ * 文件按chunk_size分块，主机比较本地的块CRC后用PUT /upload?patch=1只上传不同的块
+ */
+struct FleetChunks
+{
+	uint32_t size;
+	uint32_t crc32;
+	uint32_t chunk_size;
+	uint16_t chunk_count;  // 文件的总块数
+	uint16_t first;        // 本回复中第一块的块号
+	uint16_t n;            // 本回复中的块数（不超过FLEET_CHUNKS_MAX）
+	uint16_t reserved;
+};
+
+#pragma pack(pop)
+
+// 场景触发回调（在LVGL任务中执行）：name为场景根目录下的名称，空字符串表示停止
+typedef void (*fleet_scene_cb_t)(const char* name, uint8_t fps, void* user);
+
+/**
+ * 多设备管理服务
+ *
+ * 联网后由Network启动：mDNS主机名为设备名，发布_holocubic._udp（本协议）与_http._tcp（上传服务）；
+ * 接收任务处理主机工具（3.Software/HoloFleet）发来的UDP请求，每个请求一个回复：
+ *
+ *   STATUS   运行状态（可广播发现设备，不依赖mDNS）
+ *   CONFIG   写入配置项（与config.json相同的路径与校验，保存在NVS）
+ *   SCENE    切换场景（按场景名打开并播放）
+ *   SYNC     比较一批文件的大小与CRC，回复需要上传的条目，主机随后经PUT /upload推送
+ *   CHUNKS   取文件的块CRC，主机只上传变化的块（差量同步）
+ *   RESTART  重启
+ *
+ * 写操作都需要认证标签（fleet.key），并检查会话号与序号防止重放；
+ * 请求在接收任务中依次处理，SYNC/CHUNKS计算清单期间不响应其他请求（主机按超时重试）
+ */
+class FleetServer
+{
+private:
+	int sock;
+	TaskHandle_t task;
+	volatile bool running;
+	uint32_t session;
+	uint32_t last_seq;
+	bool seq_valid;
+	char name[FLEET_NAME_MAX];
+	char key[FLEET_KEY_MAX + 1];
+	uint16_t http_port;
+
+	fleet_scene_cb_t scene_cb;
+	void* scene_user;
+	portMUX_TYPE scene_lock;
+	char scene_name[SCENE_INDEX_NAME_MAX];
+	uint8_t scene_fps;
+
+	bool authorize(const FleetHeader* h, const uint8_t* payload);
+	uint16_t handle(const FleetHeader* h, const uint8_t* payload, uint8_t* out, uint8_t* status);
+	uint16_t opStatus(uint8_t* out);
+	uint16_t opConfig(const uint8_t* payload, uint16_t len, uint8_t* out, uint8_t* status);
+	uint8_t opScene(const uint8_t* payload, uint16_t len);
+	uint16_t opSync(const uint8_t* payload, uint16_t len, uint8_t* out, uint8_t* status);
+	uint16_t opChunks(const uint8_t* payload, uint16_t len, uint8_t* out, uint8_t* status);
+	static bool validPath(const char* path);
+	static void sceneMsg(const UiMsg* msg);
+	static void taskEntry(void* arg);
+
+public:
+	FleetServer();
+	// 设备名与密钥（在begin之前设置；name为NULL或空时按MAC生成）
+	void setIdentity(const char* device_name, const char* fleet_key);
+	void setSceneCallback(fleet_scene_cb_t cb, void* user = NULL);
+	void setHttpPort(uint16_t port);
+	bool begin(uint16_t port = FLEET_PORT);
+	void end();
+	bool isRunning();
+	const char* getName();
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef FOCUS_NAV_H
+#define FOCUS_NAV_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+
+// 每个屏幕最多可聚焦的对象数
+#define FOCUS_MAX_ITEMS 32
+// 焦点框的线宽与距对象边缘的外扩（像素）
+#define FOCUS_EDGE_W 2
+#define FOCUS_PAD 2
+// 焦点框从上一个对象移到下一个对象的动画时长（0为直接跳过去）
+#define FOCUS_ANIM_MS 120
+// 1：首尾相接（最后一个之后回到第一个）
+#define FOCUS_WRAP 1
+
+/**
+ * 焦点指示的形状
+ */
+enum FocusStyle
+{
+	FOCUS_FRAME = 0,       // 四条边框
+	FOCUS_UNDERLINE        // 只有下边框（重绘面积最小）
+};
+
+/**
+ * 一个屏幕的编码器焦点导航（IMU倾斜 -> lv_port_indev编码器）
+ *
+ * LVGL的分组每次切换焦点都会改变新旧两个对象的LV_STATE_FOCUSED，触发样式过渡，
+ * 两个对象（连同阴影、子对象）整体失效重绘。这里对象不加入分组：
+ * - 分组中只有一个不可见的0尺寸代理对象（编辑模式），倾斜得到的LV_KEY_LEFT/RIGHT由代理接收，
+ *   焦点顺序保存在本屏幕的数组中，上一个/下一个只需移动下标
+ * - 焦点由屏幕上另外的焦点框表示（2~4个细长的纯色矩形，无阴影、无圆角），动画只移动焦点框，
+ *   每帧失效的只是几条边框所在的窄条；被聚焦对象的状态与样式不变
+ * - 按下、长按等转发给当前焦点对象（只发事件，不改变对象状态），焦点变化时发送LV_EVENT_FOCUSED/DEFOCUSED
+ *
+ * 用法：屏幕建好后create(scr)，按顺序add()，attach()接管编码器；离开屏幕时detach()恢复原来的分组
+ * （屏幕删除时自动恢复）。
+ *
+ * 注意事项：
+ * - 所有接口必须在LVGL任务中调用
+ * - 删除已加入的对象前先remove()；对象移动或改变尺寸后调用refresh()
+ * - 隐藏的对象导航时跳过
+ */
+class FocusScope
+{
+private:
+	lv_obj_t* scr;
+	lv_obj_t* proxy;
+	lv_group_t* group;
+	lv_group_t* prev_group;
+	bool attached;
+	lv_obj_t* edges[4];
+	uint8_t edge_count;
+	lv_obj_t* items[FOCUS_MAX_ITEMS];
+	uint8_t count;
+	int8_t index;              // 当前焦点，-1为没有
+	lv_area_t from;            // 焦点框动画的起止位置（屏幕坐标）
+	lv_area_t to;
+	lv_area_t shown;           // 焦点框当前显示的位置
+
+	bool target(uint8_t i, lv_area_t* area);
+	void place(const lv_area_t* area);
+	void moveTo(bool animate);
+	void select(int8_t i, bool animate);
+	void step(int8_t dir);
+	static void animCb(void* var, lv_anim_value_t v);
+	static void proxyCb(lv_obj_t* obj, lv_event_t event);
+
+public:
+	FocusScope();
+	/**
+	 * 在屏幕上建立代理对象与焦点框
+	 * @param color 焦点框颜色
+	 */
+	bool create(lv_obj_t* scr, lv_color_t color = LV_COLOR_WHITE, FocusStyle style = FOCUS_FRAME);
+	void destroy();
+	// 按导航顺序加入对象（返回false表示已满）
+	bool add(lv_obj_t* obj);
+	void remove(lv_obj_t* obj);
+	// 编码器交给本屏幕（保存原来的分组）/ 恢复原来的分组
+	void attach();
+	void detach();
+
+	void next();
+	void prev();
+	bool focus(lv_obj_t* obj, bool animate = false);
+	lv_obj_t* getFocused();
+	int8_t getIndex();
+	// 对象位置或尺寸改变后重新放置焦点框（无动画）
+	void refresh();
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <Arduino.h>
+#include "lv_port_indev.h"
+
+// 规则表最大条数
+#define GESTURE_MAX_RULES 8
+// 一阶低通滤波系数：f += (x - f) >> SHIFT（100Hz采样时时间常数约40ms）
+#define GESTURE_LPF_SHIFT 2
+// 两次敲击的最大间隔，超过视为两次单击
+#define GESTURE_DOUBLE_TAP_MS 400
+
+// 倾斜滚动（setScrollAccel开启时代替左右倾斜的固定周期重复）
+// 速率单位为0.1格/秒：进入倾斜阈值时为MIN_RATE（与原重复周期400ms相同），
+// 每多倾斜TILT_SPAN（LSB）增加TILT_RATE，保持倾斜时每ACCEL_MS再加一倍，最高MAX_RATE
+#define GESTURE_SCROLL_TILT_MIN 3000
+#define GESTURE_SCROLL_MIN_RATE 25
+#define GESTURE_SCROLL_TILT_RATE 150
+#define GESTURE_SCROLL_TILT_SPAN 9000
+#define GESTURE_SCROLL_ACCEL_MS 1000
+#define GESTURE_SCROLL_ACCEL_MAX 3
+#define GESTURE_SCROLL_MAX_RATE 400
+// 速度跟随的时间常数：加速时较快；回正后按FRICTION_MS衰减（惯性滑行），低于STOP_RATE时停止
+#define GESTURE_SCROLL_RISE_MS 80
+#define GESTURE_SCROLL_FRICTION_MS 350
+#define GESTURE_SCROLL_STOP_RATE 20
+// 累计的步数合并为一个编码器事件的周期（事件缓冲区不会被连续滚动占满）
+#define GESTURE_SCROLL_PERIOD_MS 40
+
+/**
+ * 手势类型
+ * TILT_*为持续型，识别时产生开始事件，回落到退出阈值以下时产生结束事件；
+ * SHAKE/TAP/DOUBLE_TAP为瞬时型，只产生开始事件
+ */
+enum GestureType
+{
+	GESTURE_NONE = 0,
+	GESTURE_TILT_LEFT,
+	GESTURE_TILT_RIGHT,
+	GESTURE_TILT_FORWARD,
+	GESTURE_TILT_BACK,
+	GESTURE_SHAKE,
+	GESTURE_TAP,
+	GESTURE_DOUBLE_TAP,
+	GESTURE_TYPE_COUNT
+};
+
+/**
+ * 规则输入信号（均为滤波后的值，单位为传感器原始LSB）
+ * SIG_AX/SIG_AY:  低通滤波后的加速度，反映倾斜方向
+ * SIG_JERK:       加速度高通分量的L1范数，反映敲击冲击
+ * SIG_ROTATION:   低通滤波后的角速度L1范数，反映晃动强度
+ */
+enum GestureSignal
+{
+	GESTURE_SIG_AX = 0,
+	GESTURE_SIG_AY,
+	GESTURE_SIG_JERK,
+	GESTURE_SIG_ROTATION,
+	GESTURE_SIG_COUNT
+};
+
+/**
+ * 识别规则
+ * 信号超过enter并持续hold_ms后触发；低于exit（滞回）后结束，此后refractory_ms内不再触发；
+ * repeat_ms非0时保持期间按该周期重复触发。enter为负数时比较方向取反
+ */
+struct GestureRule
+{
+	GestureType type;
+	GestureSignal signal;
+	int16_t enter;
+	int16_t exit;
+	uint16_t hold_ms;
+	uint16_t repeat_ms;
+	uint16_t refractory_ms;
+};
+
+struct GestureEvent
+{
+	GestureType type;
+	bool active;           // true: 手势开始（或重复），false: 持续型手势结束
+	uint32_t time;         // 产生该事件的样本时间（millis）
+};
+
+// 手势名称（tilt_left、double_tap等，用于轨迹标注与报告）；未知名称返回GESTURE_NONE
+const char* gesture_name(GestureType type);
+GestureType gesture_from_name(const char* name);
+
+typedef void (*gesture_cb_t)(const GestureEvent* ev, void* user);
+
+/**
+ * 手势识别引擎
+ * 每个样本调用一次feed()，按规则表逐条运行状态机（空闲→预备→触发），
+ * 识别结果默认转换为LVGL编码器事件（左右倾斜→旋转，前倾/双击→按压），
+ * 同时回调给应用注册的监听者
+ */
+class GestureEngine
+{
+private:
+	enum RuleState
+	{
+		RULE_IDLE = 0,
+		RULE_ARMED,
+		RULE_ACTIVE
+	};
+
+	const GestureRule* rules;
+	uint8_t rule_count;
+	RuleState state[GESTURE_MAX_RULES];
+	uint32_t since[GESTURE_MAX_RULES];      // 进入预备或上次触发的时间
+	uint32_t blocked[GESTURE_MAX_RULES];    // 不应期截止时间
+
+	bool primed;
+	int32_t lpf_ax, lpf_ay, lpf_az;
+	int32_t lpf_rot;
+	int32_t signals[GESTURE_SIG_COUNT];
+	uint32_t last_tap;
+
+	bool to_encoder;
+	bool external_tap;                     // 敲击由IMU的高采样率检测送入，规则表中的TAP规则不运行
+	lv_indev_state_t enc_state;            // 前倾产生的按键状态，旋转事件沿用
+
+	// 倾斜滚动：速度为0.1格/秒（Q8），步数小数部分累计在frac中（单位0.1格·毫秒）
+	bool scroll_accel;
+	int8_t scroll_dir;                     // 正在保持的倾斜方向（右为+1）
+	int32_t scroll_vel;
+	int32_t scroll_frac;
+	int16_t scroll_pending;                // 尚未写入事件缓冲区的步数
+	uint32_t scroll_since;                 // 开始倾斜的时间
+	uint32_t scroll_last;                  // 上一个样本的时间
+	uint32_t scroll_pushed;                // 上次写入滚动事件的时间
+	gesture_cb_t cb;
+	void* cb_user;
+
+	void filter(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz);
+	void step(uint8_t i, uint32_t now);
+	void emit(GestureType type, bool active, uint32_t now);
+	void toEncoder(const GestureEvent* ev);
+	void scroll(uint32_t now);
+
+public:
+	GestureEngine();
+	void init(const GestureRule* table = NULL, uint8_t count = 0);
+	void feed(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz, uint32_t now);
+
+	// 送入外部检测到的一次敲击（传感器任务中调用），与规则识别的敲击一样组合双击
+	void tap(uint32_t now);
+	// 敲击改由tap()送入（IMU启用高采样率敲击检测时调用），规则表中的TAP规则停用
+	void setExternalTap(bool enable);
+
+	void setCallback(gesture_cb_t callback, void* user = NULL);
+	void setEncoderOutput(bool enable);
+	// 倾斜滚动加速与惯性（默认开启）：倾斜越大、保持越久滚动越快，回正后减速滑行；关闭时每400ms一格
+	void setScrollAccel(bool enable);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef GESTURE_REPLAY_H
+#define GESTURE_REPLAY_H
+
+#include <Arduino.h>
+#include "gesture.h"
+#include "imu_trace_format.h"
+
+// 一条轨迹中最多统计的标注数与识别次数（超出的部分计入dropped）
+#define GESTURE_REPLAY_MAX_LABELS 64
+#define GESTURE_REPLAY_MAX_EVENTS 256
+
+/**
+ * 单一手势类型的统计
+ * hits:      落在同类标注窗口内的第一次识别（延迟=识别时间-标注时间）
+ * misses:    窗口内没有识别到的标注
+ * false_pos: 不在任何同类标注窗口内的识别，以及同一窗口内的重复识别
+ */
+struct GestureReplayStats
+{
+	uint16_t labels;
+	uint16_t hits;
+	uint16_t misses;
+	uint16_t false_pos;
+	uint32_t latency_sum_ms;
+	uint32_t latency_max_ms;
+};
+
+struct GestureReplayReport
+{
+	uint32_t samples;
+	uint32_t duration_ms;
+	uint16_t labels;
+	uint16_t events;
+	uint16_t dropped;
+	GestureReplayStats type[GESTURE_TYPE_COUNT];
+};
+
+/**
+ * 手势回放评估
+ * 把.imt轨迹记录逐条送入一个独立的手势引擎（不输出编码器事件），
+ * 结束时按轨迹中的标注统计每类手势的识别延迟、漏检与误触发。
+ * 只依赖gesture.cpp，固件与主机端（LvglBench）共用同一份代码
+ *
+ * 识别次数按“激活”计：持续型手势保持期间的重复事件不重复计数，
+ * 双击标注窗口内组成双击的单击不算误触发
+ */
+class GestureReplay
+{
+private:
+	struct Label
+	{
+		uint32_t time;
+		uint16_t window;
+		uint8_t type;
+		bool hit;
+	};
+
+	GestureEngine engine;
+	Label labels[GESTURE_REPLAY_MAX_LABELS];
+	GestureEvent events[GESTURE_REPLAY_MAX_EVENTS];
+	uint16_t label_count;
+	uint16_t event_count;
+	uint16_t dropped;
+	bool active[GESTURE_TYPE_COUNT];
+	uint32_t now;
+	uint32_t start;
+	uint32_t samples;
+
+	bool inWindow(GestureType type, uint32_t t, int* label);
+	static void onEvent(const GestureEvent* ev, void* user);
+
+public:
+	void begin(uint32_t start_ms, const GestureRule* rules = NULL, uint8_t count = 0);
+	void feed(const ImuTraceRecord* r);
+	void finish(GestureReplayReport* out);
+	uint32_t time();
+};
+
+#endif
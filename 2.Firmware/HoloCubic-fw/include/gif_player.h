@@ -0,0 +1,108 @@
+#ifndef GIF_PLAYER_H
+#define GIF_PLAYER_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+
+// 文件读取缓冲（字节）：LZW数据按子块顺序读取，每次lv_fs_read读入一整块
+#define GIF_READ_BUF 512
+// 帧延时为0或1（1/100秒）的GIF按该间隔播放（与常见浏览器一致），其余帧延时不短于GIF_MIN_DELAY_MS
+#define GIF_DEFAULT_DELAY_MS 100
+#define GIF_MIN_DELAY_MS 20
+// 画布上限（字节，宽 * 高 * 2）：没有PSRAM时240x240的画布占115KB
+#define GIF_MAX_CANVAS_BYTES (240U * 240U * 2U)
+// LZW字典（GIF规定最多4096个码）
+#define GIF_LZW_CODES 4096
+
+/**
+ * GIF动画控件
+ *
+ * 从LVGL文件系统（"S:/xxx.gif"）流式读取，不需要预先转换：
+ * 每帧只把LZW解码得到的子矩形写入常驻画布（RGB565），并只让该子矩形失效，
+ * 上一帧的处置方式（不处理/恢复背景/恢复上一状态）同样只作用于上一帧的子矩形。
+ * 文件保持打开，每帧从上一帧结束处继续读取，解码与重绘的开销随变化的像素数增加，与画布大小无关。
+ *
+ * 注意事项：
+ * - 所有接口必须在LVGL任务中调用；控件随父对象删除时自动停止播放并释放缓冲
+ * - 循环次数（NETSCAPE扩展）被忽略，始终循环播放
+ * - "恢复背景"填充setBackground设置的颜色（默认黑色），不做透明处理
+ */
+class GifPlayer
+{
+private:
+	lv_obj_t* obj;
+	lv_task_t* task;
+
+	lv_fs_file_t file;
+	bool file_open;
+	uint8_t rbuf[GIF_READ_BUF];
+	uint32_t rbuf_pos;         // rbuf[0]在文件中的偏移
+	uint16_t rpos;
+	uint16_t rlen;
+	uint32_t first_frame;      // 第一帧的扩展块或图像描述符偏移，循环时回到这里
+
+	uint16_t w;
+	uint16_t h;
+	lv_color_t* canvas;
+	lv_color_t bg;
+	lv_color_t gct[256];       // 全局调色板
+	lv_color_t lct[256];       // 局部调色板
+	bool has_gct;
+
+	// LZW字典：每个码为前缀码加一个末尾字节，解码时逆序展开到stack
+	uint16_t* prefix;
+	uint8_t* suffix;
+	uint8_t* stack;
+
+	// 图形控制扩展（作用于下一幅图像）
+	uint8_t next_disposal;
+	int16_t next_transparent;  // -1表示没有透明色
+	uint16_t next_delay;       // 1/100秒
+
+	// 上一帧：处置方式与子矩形（画布坐标）
+	uint8_t disposal;
+	lv_area_t rect;
+	lv_color_t* backup;        // 处置方式3时保存的子矩形原内容
+
+	uint16_t delay_ms;         // 当前帧的显示时间
+	uint32_t frames;
+
+	bool readByte(uint8_t* out);
+	bool readBytes(void* out, uint32_t n);
+	uint16_t readWord(bool* ok);
+	uint32_t tell();
+	bool seek(uint32_t pos);
+	bool skipSubBlocks();
+	bool readPalette(lv_color_t* pal, uint16_t n);
+	bool readHeader();
+	bool nextFrame();
+	bool decodeImage(const lv_area_t* r, bool interlace, const lv_color_t* pal, int16_t transparent);
+	void dispose();
+	void invalidate(const lv_area_t* r);
+	void release();
+	void detach();
+
+	static GifPlayer* of(lv_obj_t* o);
+	static lv_design_res_t designCb(lv_obj_t* o, const lv_area_t* clip, lv_design_mode_t mode);
+	static lv_res_t signalCb(lv_obj_t* o, lv_signal_t sign, void* param);
+	static void taskCb(lv_task_t* t);
+
+public:
+	GifPlayer();
+	bool create(lv_obj_t* parent);
+	void destroy();
+	lv_obj_t* getObj();
+
+	bool open(const char* path);
+	void close();
+	bool play();
+	void stop();
+	void setBackground(lv_color_t color);
+
+	bool isPlaying();
+	uint32_t getFrameCount();
+	uint16_t getWidth();
+	uint16_t getHeight();
+};
+
+#endif
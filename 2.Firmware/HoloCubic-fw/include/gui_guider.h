@@ -15,10 +15,22 @@ extern "C" {
 		lv_obj_t* scenes_canvas;
 	}lv_ui;
 
+	/* 屏幕编号（screen_manager中的登记顺序） */
+	typedef enum
+	{
+		GUI_SCR_HOME = 0,
+		GUI_SCR_SCENES,
+		GUI_SCR_CNT
+	} gui_scr_t;
+
 	void setup_ui(lv_ui* ui);
+	void setup_ui_at(lv_ui* ui, gui_scr_t first);
+	lv_obj_t* gui_load(gui_scr_t id, lv_scr_load_anim_t anim);
 	extern lv_ui guider_ui;
 	void setup_scr_home(lv_ui* ui);
 	void setup_scr_scenes(lv_ui* ui);
+	void cleanup_scr_home(lv_ui* ui);
+	void cleanup_scr_scenes(lv_ui* ui);
 
 #ifdef __cplusplus
 }
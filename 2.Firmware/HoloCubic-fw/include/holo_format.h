@@ -0,0 +1,122 @@
+#ifndef HOLO_FORMAT_H
+#define HOLO_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * .holo 动画包格式（与3.Software/ImageToHolo/convertor/holo.py保持一致）
+ *
+ * 文件布局（小端）：
+ *   [HoloHeader][HoloFrameEntry * frame_count][共用调色板][填充][帧0][填充][帧1]...
+ *
+ * - 每帧为完整的LVGL .bin内容（4字节lv_img_header_t + 数据），可直接作为lv_img_dsc_t使用
+ * - 带HOLO_FLAG_PALETTE时索引色调色板（4 << bpp字节）只在palette_offset处保存一份，
+ *   完整帧为[lv_img_header_t][索引数据]，读取时把调色板插回图像头之后
+ * - 帧起始偏移按align对齐（默认4096，即FAT簇大小），seek后一次read即可读完整帧
+ * - entry_size为单条索引长度，新版本可在条目末尾追加字段，读取时按entry_size步进
+ * - entry_size >= HOLO_ENTRY_SIZE_AMBIENT时条目带ambient（帧的平均色），较早的包只有offset与size
+ * - entry_size >= HOLO_ENTRY_SIZE_CRC时条目带crc（帧在文件中size字节的CRC32，与zlib相同）：
+ *   不提高版本号，播放器在每帧第一次读取时校验，损坏的帧不交给解码器；整包校验过一次后记录在场景索引中
+ * - 带HOLO_FLAG_Q565时（版本3起）每帧为[lv_img_header_t（cf为LV_IMG_CF_RAW）][Q565压缩数据]，
+ *   文件头的cf为解码后的LV_IMG_CF_TRUE_COLOR，压缩格式见q565_decoder.h；
+ *   压缩后不小于原始大小的帧（如噪点）保持未压缩的.bin（cf为LV_IMG_CF_TRUE_COLOR）
+ * - header_size >= sizeof(HoloHeader)时带缩略图表（mip_offset处HoloMipEntry * mip_count）：
+ *   关键帧的1/2、1/4、1/8尺寸缩略图（240x240的包为120、60、30），每幅为完整的LVGL .bin
+ *   （LV_IMG_CF_TRUE_COLOR，透明像素合成到黑色），与帧格式无关；浏览界面按需要的尺寸一次read读出直接显示。
+ *   缩略图不影响播放，不提高版本号；header_size较小的旧包读取时把追加字段补0
+ * - 带HOLO_FLAG_CROP时（版本4起）帧只保存整段动画非黑内容的外接矩形：width/height为裁剪后的帧尺寸，
+ *   画布（full_w x full_h，分光棱镜前的整幅画面）中其余部分全黑；播放时控件放在画布内(crop_x, crop_y)处，
+ *   画布在父对象中居中，其余区域不再读取、解码与刷新。缩略图、平均色仍按完整画布
+ */
+
+#define HOLO_MAGIC "HOLO"
+// 读取端支持的最高版本；只有用到对应标志的包才写为较高版本，旧固件可以播放其余的包
+#define HOLO_VERSION 4
+#define HOLO_VERSION_PALETTE 2
+#define HOLO_VERSION_Q565 3
+#define HOLO_VERSION_CROP 4
+
+// HoloHeader.flags
+#define HOLO_FLAG_DELTA 0x01   // 帧0为完整关键帧，其余帧为相对上一帧的分块差分（HoloDeltaHeader）
+#define HOLO_FLAG_JPEG 0x02    // 每帧为一幅基线JPEG（MJPEG），cf字段无意义
+#define HOLO_FLAG_PALETTE 0x04 // 全部帧共用一个调色板（索引色格式，版本2起）
+#define HOLO_FLAG_Q565 0x08    // 每帧为Q565压缩的16位真彩色（版本3起），不与其他标志组合
+#define HOLO_FLAG_CROP 0x10    // 帧为画布中裁剪出的区域（版本4起），可与其他标志组合
+
+// 读取端可接受的最短索引条目（只有offset与size）
+#define HOLO_ENTRY_SIZE_MIN 8
+// 带平均色、带帧校验值的索引条目长度
+#define HOLO_ENTRY_SIZE_AMBIENT 12
+#define HOLO_ENTRY_SIZE_CRC 16
+// 没有缩略图表的文件头长度（版本1~3的HoloHeader）
+#define HOLO_HEADER_SIZE_MIN 32
+// 带裁剪字段的文件头长度（版本4的HoloHeader）
+#define HOLO_HEADER_SIZE_CROP 48
+// 缩略图级数：第n级（1起）为原尺寸的1/2^n
+#define HOLO_MIP_LEVELS 3
+
+#pragma pack(push, 1)
+
+struct HoloHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	uint16_t width;
+	uint16_t height;
+	uint8_t cf;            // LVGL颜色格式（lv_img_cf_t）
+	uint8_t flags;
+	uint8_t fps;
+	uint8_t entry_size;    // HOLO_ENTRY_SIZE_MIN或更大
+	uint32_t frame_count;
+	uint32_t index_offset;
+	uint32_t align;
+	uint32_t palette_offset;   // 共用调色板偏移，0表示没有（版本1中为保留的0）
+	// 以下字段在header_size > HOLO_HEADER_SIZE_MIN时有效
+	uint32_t mip_offset;       // 缩略图表偏移，0表示没有
+	uint16_t mip_count;        // 缩略图条目数（关键帧数 * 级数）
+	uint8_t mip_entry_size;    // 单条长度，可在末尾追加字段
+	uint8_t reserved;
+	// 以下字段在header_size >= HOLO_HEADER_SIZE_CROP且带HOLO_FLAG_CROP时有效
+	uint16_t crop_x;           // 帧在画布中的位置
+	uint16_t crop_y;
+	uint16_t full_w;           // 画布尺寸
+	uint16_t full_h;
+};
+
+/**
+ * 缩略图条目：按关键帧、级别升序排列，第一个关键帧通常为帧0（场景索引记录它的各级位置）
+ */
+struct HoloMipEntry
+{
+	uint32_t offset;       // 缩略图.bin在文件中的绝对偏移
+	uint32_t size;         // 字节数（含4字节图像头）
+	uint16_t frame;        // 关键帧的帧号
+	uint8_t level;         // 1~HOLO_MIP_LEVELS
+	uint8_t reserved;
+};
+
+struct HoloFrameEntry
+{
+	uint32_t offset;       // 帧在文件中的绝对偏移
+	uint32_t size;         // 帧字节数（含4字节图像头）
+	uint32_t ambient;      // 帧的平均色0x00RRGGBB（透明像素按黑色计），用于LED环境色
+	uint32_t crc;          // 帧字节的CRC32（entry_size >= HOLO_ENTRY_SIZE_CRC时有效）
+};
+
+/**
+ * 差分帧（HOLO_FLAG_DELTA）
+ * 布局：[HoloDeltaHeader][uint16_t tile_id * tile_count][分块数据 * tile_count]
+ * - 全部帧共用关键帧的调色板，只替换变化了的tile_w x tile_h分块
+ * - tile_id按行优先编号，分块数据为该块逐行的像素字节（格式同关键帧）
+ */
+struct HoloDeltaHeader
+{
+	uint8_t tile_w;
+	uint8_t tile_h;
+	uint16_t tile_count;
+};
+
+#pragma pack(pop)
+
+#endif
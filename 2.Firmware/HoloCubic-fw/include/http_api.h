@@ -0,0 +1,61 @@
+#ifndef HTTP_API_H
+#define HTTP_API_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <ArduinoJson.h>
+#include "tls_client.h"
+
+// 单次请求的超时
+#define HTTP_API_TIMEOUT_MS 5000
+// JSON文档使用的固定内存池（经过过滤后只保留所需字段，4KB足够）
+#define HTTP_JSON_POOL_SIZE 4096
+// 分片：解析响应时每读这么多字节让出一次CPU，一次解析不会长时间占用核心0（WiFi、传感器任务）
+#define HTTP_API_SLICE_BYTES 1024
+
+/**
+ * 固定内存池分配器
+ * 每次请求开始时reset()，文档的所有分配都从静态缓冲区中顺序切分，请求之间不产生堆碎片
+ */
+class JsonPoolAllocator : public ArduinoJson::Allocator
+{
+private:
+	uint8_t* pool;
+	size_t size;
+	size_t used;
+
+public:
+	JsonPoolAllocator(uint8_t* buf, size_t len);
+	void reset();
+
+	void* allocate(size_t n) override;
+	void deallocate(void* ptr) override;
+	void* reallocate(void* ptr, size_t n) override;
+};
+
+/**
+ * 共用HTTP客户端
+ * 同一主机的连续请求复用TCP连接（HTTP/1.1 keep-alive），https经TlsClient并复用TLS会话，
+ * 响应体直接从连接上流式解析，按过滤文档只保留需要的字段，不再整体读入String。
+ * 只能在一个任务中使用（Network的网络任务）
+ */
+class HttpApi
+{
+private:
+	WiFiClient client;
+	TlsClient tls;
+	WiFiClient* current;
+	HTTPClient http;
+	uint8_t pool_buf[HTTP_JSON_POOL_SIZE];
+	JsonPoolAllocator pool;
+	JsonDocument doc;
+
+public:
+	HttpApi();
+
+	JsonDocument* getJson(const char* url, const JsonDocument& filter);
+	void close();
+};
+
+#endif
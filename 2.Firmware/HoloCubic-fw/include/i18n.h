@@ -0,0 +1,147 @@
+#ifndef I18N_H
+#define I18N_H
+
+#include <stdint.h>
+#include <lvgl.h>
+
+// 语言包在资源包（asset_bundle.h）中的名称：I18N_ASSET_PREFIX + 语言代码，如"lang_zh"
+#define I18N_ASSET_PREFIX "lang_"
+#define I18N_CODE_LEN 8
+// 语言包中没有字形的字符（以及没有字体的语言包）使用的字体
+#define I18N_FALLBACK_FONT LV_THEME_DEFAULT_FONT_NORMAL
+
+/**
+ * 文字编号（i18n_strings.h），STR_前缀
+ */
+typedef enum
+{
+#define I18N_STRING(id, text) STR_##id,
+#include "i18n_strings.h"
+#undef I18N_STRING
+	STR_COUNT
+} i18n_id_t;
+
+/**
+ * 语言包格式（与3.Software/ImageToHolo/convertor/i18n.py保持一致，小端，各部分4字节对齐）
+ *
+ *   [I18nHeader][uint32 文字偏移 * count][UTF-8文字，'\0'结尾...][字体（可选）]
+ *
+ * - 文字偏移按编号排列，编号直接作下标（O(1)），偏移为0表示该项未翻译
+ * - 字体只包含该语言文字用到的字符与可打印ASCII：
+ *     [I18nFontHeader][uint32 码位 * glyph_count（升序）][I18nGlyph * glyph_count][位图]
+ *   位图为LVGL格式（逐行连续存放，行之间不补齐，高位在前），字形按码位二分查找
+ * - 语言包作为资源包中的一项随整个分区映射，文字与字形都直接引用flash，不复制到RAM
+ */
+#define I18N_MAGIC "HOLI"
+#define I18N_VERSION 1
+
+#pragma pack(push, 1)
+
+struct I18nHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t count;            // 文字数（可少于STR_COUNT）
+	char code[I18N_CODE_LEN];  // 语言代码，'\0'结尾
+	char name[16];             // 语言名称（该语言自身的写法，如"中文"）
+	uint32_t font;             // 字体的偏移，0表示没有字体
+	uint32_t size;             // 语言包总字节数
+};
+
+struct I18nFontHeader
+{
+	uint16_t line_height;
+	int16_t base_line;
+	uint16_t glyph_count;
+	uint8_t bpp;
+	int8_t underline_position;
+	uint8_t underline_thickness;
+	uint8_t reserved[3];
+};
+
+struct I18nGlyph
+{
+	uint32_t bitmap;           // 位图相对字体起始的偏移
+	uint16_t adv_w;            // 前进宽度（1/16像素）
+	uint8_t box_w;
+	uint8_t box_h;
+	int8_t ofs_x;
+	int8_t ofs_y;
+	uint8_t reserved[2];
+};
+
+#pragma pack(pop)
+
+#ifdef __cplusplus
+
+/**
+ * 多语言文字
+ *
+ * 语言包编译为按编号排列的二进制表，放在资源包分区中（不需要SD卡），setLanguage只检查并记下指针：
+ * str()按编号直接取flash中的文字，没有逐条的堆分配；
+ * getFont()返回的字体只查当前语言包中的字形（flash cache按需读取），其他语言的字形不会被加载。
+ *
+ * 切换语言后：
+ * - 屏幕管理器中离开的屏幕被删除，下次打开时按新语言重建，当前屏幕立即重建（scr_mgr_rebuild）
+ * - 前台应用重新进入一次（AppManager::reload）
+ * 界面创建标签时取文字与字体即可：
+ *
+ *   lv_label_set_text_static(label, i18n.str(STR_WEATHER_TODAY));
+ *   lv_obj_set_style_local_text_font(label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, i18n.getFont());
+ *
+ * 注意事项：
+ * - setLanguage与界面重建在LVGL任务中调用；str()可在任意任务中调用（语言包不会被释放）
+ * - 语言包只能在固件文字表末尾追加编号时兼容，旧语言包缺少的项使用内置文字
+ * - 设置了keep的屏幕（如被播放器引用的画布）不重建
+ */
+class I18n
+{
+private:
+	const I18nHeader* pack;
+	const uint32_t* offsets;
+	const uint8_t* font_base;
+	const I18nFontHeader* font_hdr;
+	const uint32_t* codes;
+	const I18nGlyph* glyphs;
+	lv_font_t font;
+
+	bool check(const uint8_t* data, uint32_t size);
+	const I18nGlyph* findGlyph(uint32_t letter) const;
+	static bool glyphDscCb(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next);
+	static const uint8_t* glyphBitmapCb(const lv_font_t* font, uint32_t letter);
+
+public:
+	I18n();
+	// 按配置（ui.lang）选择语言，资源包映射之后调用（不重建界面）
+	void begin();
+	/**
+	 * 切换语言（LVGL任务）
+	 * @param code 语言代码，NULL或""为内置文字
+	 * @param save 保存到配置（下次启动时使用）
+	 * @return 资源包中没有该语言包或格式错误时返回false（保持原语言）
+	 */
+	bool setLanguage(const char* code, bool save = true);
+	// 当前语言代码，内置文字时为""
+	const char* getLanguage();
+	// 当前语言名称，内置文字时为"English"
+	const char* getName();
+
+	const char* str(i18n_id_t id);
+	// 当前语言的字体（没有语言包字体时为I18N_FALLBACK_FONT），对象长期有效
+	const lv_font_t* getFont();
+};
+
+extern I18n i18n;
+
+extern "C" {
+#endif
+
+// 供C代码（GUI）使用
+const char* i18n_str(i18n_id_t id);
+const lv_font_t* i18n_font(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
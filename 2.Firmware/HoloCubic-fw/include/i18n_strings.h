@@ -0,0 +1,31 @@
+/*
+ * 界面文字表：I18N_STRING(编号, 内置文字)
+ *
+ * 内置文字（英文）编译在固件中，没有语言包或语言包中没有该项时使用；
+ * 3.Software/ImageToHolo/convertor/i18n.py读取本文件得到编号顺序，把.lang翻译文件编译为语言包。
+ * 编号只能在末尾追加：语言包按编号顺序保存，旧语言包中没有的编号使用内置文字。
+ * strftime格式与printf格式的文字在翻译中应保留相同的格式符。
+ */
+I18N_STRING(CLOCK_SYNCING,    "Syncing time...")
+I18N_STRING(CLOCK_NO_WIFI,    "Waiting for WiFi")
+I18N_STRING(CLOCK_DATE,       "%Y-%m-%d")
+I18N_STRING(WEATHER_WAITING,  "Waiting for data...")
+I18N_STRING(WEATHER_NO_DATA,  "No weather data")
+I18N_STRING(WEATHER_OFFLINE,  "Offline")
+I18N_STRING(WEATHER_UPDATED,  "Updated %H:%M")
+I18N_STRING(WEATHER_TODAY,    "Today")
+I18N_STRING(WX_CLEAR,         "Clear")
+I18N_STRING(WX_PARTLY,        "Partly cloudy")
+I18N_STRING(WX_CLOUDY,        "Cloudy")
+I18N_STRING(WX_FOG,           "Fog")
+I18N_STRING(WX_DRIZZLE,       "Drizzle")
+I18N_STRING(WX_RAIN,          "Rain")
+I18N_STRING(WX_SNOW,          "Snow")
+I18N_STRING(WX_THUNDER,       "Thunderstorm")
+I18N_STRING(WEEKDAY_SUN,      "Sun")
+I18N_STRING(WEEKDAY_MON,      "Mon")
+I18N_STRING(WEEKDAY_TUE,      "Tue")
+I18N_STRING(WEEKDAY_WED,      "Wed")
+I18N_STRING(WEEKDAY_THU,      "Thu")
+I18N_STRING(WEEKDAY_FRI,      "Fri")
+I18N_STRING(WEEKDAY_SAT,      "Sat")
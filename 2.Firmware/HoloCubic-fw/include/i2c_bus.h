@@ -0,0 +1,82 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <driver/i2c.h>
+
+// 事务队列深度
+#define I2C_BUS_QUEUE_LEN 16
+// 总线任务：与传感器任务同在核心0，优先级略高，保证排队事务及时执行
+#define I2C_BUS_TASK_STACK 3072
+#define I2C_BUS_TASK_PRIO 3
+#define I2C_BUS_TASK_CORE 0
+// 单个事务的驱动超时（设备无应答或总线被拉死时返回错误而不是卡住）
+#define I2C_BUS_TIMEOUT_MS 20
+// 总线任务一个事务超过该时间视为停顿（见supervisor.h），连续失败时同样恢复总线
+#define I2C_BUS_STALL_MS 200
+// 恢复总线时最多输出的SCL时钟数（从机最多还要发出8位数据与应答位）
+#define I2C_BUS_CLEAR_CLOCKS 9
+
+typedef void (*i2c_done_cb_t)(esp_err_t err, void* user);
+
+/**
+ * I2C事务：先写tx（通常是寄存器地址），再重复起始读rx；tx_len或rx_len可为0
+ * tx/rx缓冲区由调用方提供，需保持有效直到回调
+ */
+struct I2cTransaction
+{
+	uint8_t addr;
+	const uint8_t* tx;
+	uint8_t tx_len;
+	uint8_t* rx;
+	uint16_t rx_len;
+	i2c_done_cb_t cb;
+	void* user;
+};
+
+/**
+ * I2C总线管理
+ * 每条总线只初始化一次（多个传感器共用时以第一次begin的引脚与速率为准），
+ * 事务排队后由总线任务用IDF命令链（i2c_cmd_link）执行，完成时在总线任务中回调。
+ * 需要结果的调用方用transfer()阻塞等待信号量，等待期间让出CPU而不是忙等。
+ * 传感器库（I2Cdev）的配置类同步读写与DMP数据包读取在调用方任务中直接执行IDF命令链
+ * （I2CDEV_ESP_IDF，整块读取为一个事务，不经过Wire的缓冲区），与总线任务共用同一个IDF驱动，
+ * 驱动内部按事务加锁，两者可以交错执行
+ * 总线任务的每个事务登记在任务监视器（"i2c"阶段），连续失败或停顿时由recover()清除总线
+ */
+class I2cBus
+{
+private:
+	i2c_port_t port;
+	TwoWire& wire;
+	QueueHandle_t queue;
+	TaskHandle_t task;
+	bool started;
+	int pin_sda;
+	int pin_scl;
+	SemaphoreHandle_t mutex;   // 总线任务的事务与recover()互斥
+	int8_t sup_id;
+
+	esp_err_t execute(const I2cTransaction& t);
+	static bool recoverCb(void* user);
+	static void taskEntry(void* arg);
+
+public:
+	I2cBus(i2c_port_t p, TwoWire& w);
+
+	bool begin(int sda, int scl, uint32_t freq = 400000);
+	bool submit(const I2cTransaction& t);
+	esp_err_t transfer(uint8_t addr, const uint8_t* tx, uint8_t tx_len, uint8_t* rx, uint16_t rx_len);
+
+	esp_err_t writeReg(uint8_t addr, uint8_t reg, uint8_t value);
+	esp_err_t readRegs(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t len);
+
+	// 清除卡住的总线（从机拉低SDA）并复位控制器，不重新安装驱动；可在任意任务中调用
+	bool recover();
+};
+
+// 板载I2C总线（GPIO32/33，MPU6050与BH1750共用）
+extern I2cBus i2c_bus;
+
+#endif
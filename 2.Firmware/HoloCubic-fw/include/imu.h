@@ -2,33 +2,200 @@
 #define IMU_H
 
 
+#include <Arduino.h>
 #include <I2Cdev.h>
 #include <MPU6050.h>
 #include "lv_port_indev.h"
 #include "rgb_led.h"
+#include "orientation.h"
+#include "gesture.h"
+#include "imu_calib.h"
+#include "imu_trace.h"
+#include "sensor_window.h"
+#include "sensor_bus.h"
 
 #define IMU_I2C_SDA 32 
 #define IMU_I2C_SCL 33
 
+// 开机探测MPU6050的超时时间，超时后跳过IMU继续启动
+#define IMU_PROBE_TIMEOUT_MS 500
+// 没有保存的零偏时是否在开机时自动校准（需静止放置约2秒）
+#define IMU_CALIB_ON_FIRST_BOOT 1
 
-extern int32_t encoder_diff;
-extern lv_indev_state_t encoder_state;
+// MPU6050 INT引脚，-1表示未连接（FIFO模式下退化为定时批量读取）
+#define IMU_INT_PIN -1
+// FIFO模式采样率与数字低通滤波（DLPF开启时陀螺仪输出率1kHz）
+#define IMU_FIFO_RATE_HZ 100
+#define IMU_FIFO_DLPF MPU6050_DLPF_BW_42
+// 累计多少个样本唤醒一次读取任务
+#define IMU_FIFO_BURST 5
+// 每个FIFO样本：加速度XYZ + 陀螺仪XYZ，大端16位
+#define IMU_FIFO_PACKET 12
+// 原始样本流（setRawStream）的最高采样率，FIFO（1024字节）在传感器任务等待期间不会写满
+#define IMU_RAW_RATE_MAX 500
+// 运动唤醒（suspend后）：陀螺仪与温度传感器待机，加速度计按低功耗周期采样，由片上运动检测产生中断
+// 阈值约2mg/LSB（经数字高通滤波后的加速度变化），持续时间为连续超过阈值的采样数
+#define IMU_MOTION_THRESHOLD 20
+#define IMU_MOTION_DURATION 1
+// LP_WAKE_CTRL=3：寄存器手册4.2版为40Hz（库中宏名MPU6050_WAKE_FREQ_10沿用旧版文档），检测延迟不超过25ms
+#define IMU_MOTION_WAKE_FREQ 3
+// 运动唤醒期间传感器任务检查运动标志的周期：连接INT引脚时由中断立即唤醒，只需兜底
+#define IMU_SLEEP_POLL_MS (IMU_INT_PIN >= 0 ? 1000 : 40)
+
+// 敲击检测（FIFO/融合模式）：片上运动检测（逐个1kHz加速度样本经数字高通后比较）超过阈值时，
+// FIFO临时切换到1kHz、低通260Hz采集一个短窗口，按峰值/能量分类后只向手势引擎送入一个GESTURE_TAP
+// 连接INT引脚时INT只用于运动中断（立即唤醒采集），FIFO按超时批量读取；否则在每次读取FIFO时检查运动标志
+#define IMU_TAP_ENABLE 1
+// 触发阈值，约2mg/LSB（150约0.3g）
+#define IMU_TAP_MOT_THRESHOLD 150
+#define IMU_TAP_RATE_HZ 1000
+// 采集窗口（40个样本480字节，不会写满FIFO）；以下的毫秒数均按1kHz时每毫秒一个样本计
+#define IMU_TAP_CAPTURE_MS 40
+// 分类阈值，单位为相对触发前基线的加速度L1偏差（16384/g）：
+// 偏差超过SEG时为一个冲击段，段后连续QUIET个样本低于SEG时结束；窗口最后QUIET个样本也需安静
+#define IMU_TAP_SEG_LSB 1500
+#define IMU_TAP_QUIET_MS 8
+// 窗口内另一次敲击（快速双击）的最小峰值
+#define IMU_TAP_PEAK_LSB 5000
+// 每段的等效宽度（能量 / 峰值²，毫秒）上限：敲击是短促脉冲，搬动、晃动与放下的能量分布宽得多
+#define IMU_TAP_WIDTH_MS 6
+
+/**
+ * IMU工作模式
+ * IMU_MODE_POLL: 每次update()都用getMotion6读取一次（原有方式）
+ * IMU_MODE_FIFO: 传感器按固定采样率写入片上FIFO，update()批量读出全部样本
+ * IMU_MODE_DMP:  运行片上DMP姿态融合（见orientation.h），原始值取自DMP数据包
+ * IMU_MODE_FUSION: DMP不可用时的退路：FIFO以ORIENT_SW_RATE_HZ采样，每个样本送入软件姿态融合，
+ *                  按IMU_FIFO_RATE_HZ抽取后送入手势引擎与传感器总线（不能直接选择，由DMP初始化失败时切换）
+ */
+enum ImuMode
+{
+	IMU_MODE_POLL = 0,
+	IMU_MODE_FIFO,
+	IMU_MODE_DMP,
+	IMU_MODE_FUSION
+};
+
+/**
+ * 原始样本回调（setRawStream，传感器任务中执行）：加速度16384/g（已扣除零偏）、陀螺仪原始值，
+ * t_us为采样时刻的micros()（按采样间隔倒推）。应尽快返回，不能访问I2C总线或调用lv_*接口
+ */
+typedef void (*imu_raw_cb_t)(const int16_t* accel, const int16_t* gyro, uint32_t t_us, void* user);
+
+/**
+ * 统计窗口（takeWindows，传感器中枢用，见sensor_hub.h），每个送入手势引擎的样本都计入
+ * IMU_WINDOW_AX~AZ:  原始加速度（16384/g，已扣除零偏）
+ * IMU_WINDOW_MOTION: 动态加速度 | |a| - 1g |（mg），静止时接近0
+ */
+enum ImuWindow
+{
+	IMU_WINDOW_AX = 0,
+	IMU_WINDOW_AY,
+	IMU_WINDOW_AZ,
+	IMU_WINDOW_MOTION,
+	IMU_WINDOW_COUNT
+};
 
 class IMU
 {
 private:
 	MPU6050 imu;
-	int flag;
 	int16_t ax, ay, az;
 	int16_t gx, gy, gz;
 
-	long  last_update_time;
+	GestureEngine gesture;
+	ImuTrace trace;
+	ImuCalibration calib;
+	ImuOffsets offsets;
+	bool connected;
+	bool calibrated;
+
+	ImuMode mode;
+	uint16_t fifo_rate;        // 当前FIFO采样率（敲击采集期间为IMU_TAP_RATE_HZ）
+	uint16_t base_rate;        // 平时的FIFO采样率
+	uint16_t fifo_phase;       // 样本序号（模fifo_rate），按采样率抽取送入手势引擎与姿态融合
+	uint16_t init_rate;        // 初始化时的FIFO采样率（没有原始样本流时恢复为该值）
+	volatile uint16_t raw_rate; // 原始样本流要求的采样率，传感器任务中切换到该值
+	imu_raw_cb_t raw_cb;
+	void* raw_user;
+	TaskHandle_t notify_task;
+	volatile uint8_t pending;
+	volatile bool want_suspend;
+	volatile bool suspended;
+	bool int_attached;
+	uint8_t saved_int;
+	void (*motion_cb)(void* user);
+	void* motion_user;
+	uint32_t sample_count;
+	uint32_t overflow_count;
+
+	// 敲击检测
+	bool tap_enabled;
+	bool tap_int;              // INT引脚只用于运动中断
+	bool tap_capturing;
+	uint32_t tap_start;        // 开始采集的时间（敲击事件时间）
+	uint8_t tap_len;
+	int32_t tap_base[3];       // 触发前的加速度基线（低通，Q3）
+	uint16_t tap_buf[IMU_TAP_CAPTURE_MS];
+	uint32_t tap_count;
+	uint32_t tap_rejects;
+	SensorWindow windows[IMU_WINDOW_COUNT];
+
+	bool probe();
+	void accumulate(int16_t x, int16_t y, int16_t z);
+	void feed(uint32_t now);
+	void initFifo();
+	void setFifoRate(uint16_t rate, uint8_t dlpf);
+	void initTap();
+	void beginTap();
+	void endTap();
+	uint8_t classifyTap();
+	void attachInt();
+	void drainFifo();
+	void readDmp();
+	void enterMotionWake();
+	void exitMotionWake();
+	void checkMotionWake();
+	static void IRAM_ATTR intISR(void* arg);
+	static void onOrientation(const OrientationData* d, void* user);
+	static void onSample(const SensorSample* s, void* user);
 
 public:
-	void init();
+	bool init(ImuMode m = IMU_MODE_POLL);
+	bool calibrate();
+	bool isConnected();
+
+	void update();
+	GestureEngine* getGesture();
+	bool startTrace(const char* path);
+	void stopTrace();
+	ImuTrace* getTrace();
 
-	void update(int interval);
+	ImuMode getMode();
+	void attachTask(TaskHandle_t task);
+	void waitData(TickType_t timeout);
+	void suspend();
+	void resume();
+	bool isSuspended();
+	void setMotionCallback(void (*cb)(void* user), void* user);
+	/**
+	 * 原始样本流（FIFO/融合模式，数据记录等需要高于手势采样率的功能）：
+	 * FIFO采样率提高到rate_hz，每个样本在传感器任务中回调一次，手势引擎与总线仍按原来的采样率抽取；
+	 * 敲击采集期间（1kHz、低通260Hz）按rate_hz抽取回调。期间不进入运动唤醒。
+	 * cb为NULL时停止回调并恢复原来的采样率。任意任务中调用，下一次读取FIFO后生效
+	 * @param rate_hz 初始化时采样率的整数倍，能整除1000，不超过IMU_RAW_RATE_MAX
+	 * @return 轮询/DMP模式、未连接或采样率不符时返回false
+	 */
+	bool setRawStream(imu_raw_cb_t cb, void* user, uint16_t rate_hz);
+	uint32_t getSampleCount();
+	uint32_t getOverflowCount();
+	// 敲击检测：识别出的敲击数与采集后判定为非敲击（搬动、晃动）的次数
+	uint32_t getTapCount();
+	uint32_t getTapRejects();
+	// 取走统计窗口并清零（out为IMU_WINDOW_COUNT个，任意任务，不访问总线）
+	void takeWindows(SensorWindow* out);
 
+	// 最后一个样本的单个分量；需要同一样本的三轴数值时用sensorbus.get(SENSOR_IMU, ...)
 	int16_t getAccelX();
 	int16_t getAccelY();
 	int16_t getAccelZ();
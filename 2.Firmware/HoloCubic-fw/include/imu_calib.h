@@ -0,0 +1,49 @@
+#ifndef IMU_CALIB_H
+#define IMU_CALIB_H
+
+#include <Arduino.h>
+#include <MPU6050.h>
+
+// NVS命名空间与存储格式版本（结构变化时加一，旧数据作废后重新校准）
+#define IMU_CALIB_NAMESPACE "imu"
+#define IMU_CALIB_VERSION 1
+
+// 每轮求平均的样本数与最大迭代轮数（约1~2秒完成）
+#define IMU_CALIB_SAMPLES 200
+#define IMU_CALIB_MAX_ROUNDS 12
+// 收敛判定：与目标值的偏差小于该值（原始LSB）
+#define IMU_CALIB_ACCEL_TOL 16
+#define IMU_CALIB_GYRO_TOL 2
+// 静止判定：单轮内陀螺仪读数跨度超过该值说明设备在移动，放弃本次校准
+#define IMU_CALIB_MOTION_LIMIT 400
+
+/**
+ * 传感器零偏（写入MPU6050偏移寄存器的值）
+ */
+struct ImuOffsets
+{
+	int16_t accel[3];
+	int16_t gyro[3];
+};
+
+/**
+ * IMU校准存储
+ * 首次开机在静止状态下搜索零偏并写入NVS，此后每次开机直接读出并写入偏移寄存器。
+ * 搜索方法与IMU_Zero示例的目标一致（静止时加速度只剩重力轴±16384、其余为0），
+ * 但用"求平均→按比例修正"迭代代替二分搜索，把耗时从几分钟缩短到开机可接受的范围
+ */
+class ImuCalibration
+{
+private:
+	bool measure(MPU6050& dev, int32_t mean[6]);
+
+public:
+	bool load(ImuOffsets* out);
+	bool save(const ImuOffsets& offsets);
+	void erase();
+
+	bool run(MPU6050& dev, ImuOffsets* out);
+	void apply(MPU6050& dev, const ImuOffsets& offsets);
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef IMU_TRACE_H
+#define IMU_TRACE_H
+
+#include <Arduino.h>
+#include "sd_card.h"
+#include "gesture_replay.h"
+#include "imu_trace_format.h"
+
+// 每块缓冲的记录数（两块交替，录制时共分配2 * 128 * 14字节）
+#define IMU_TRACE_CHUNK 128
+#define IMU_TRACE_TASK_CORE 0
+#define IMU_TRACE_TASK_PRIORITY 1
+#define IMU_TRACE_TASK_STACK 3072
+// 标注的默认识别窗口
+#define IMU_TRACE_LABEL_WINDOW_MS 1000
+// 回放时每次从SD卡读取的记录数
+#define IMU_TRACE_READ_RECORDS 64
+
+/**
+ * IMU轨迹录制与回放
+ *
+ * 录制：传感器任务每个样本调用push()写入当前缓冲块，写满后交给写入任务保存到SD卡，
+ * 传感器任务不等待SD卡；写入任务来不及时丢弃样本并计数（回放时表现为时间间隔变大）。
+ * mark()插入标注记录，表示此刻开始做某个手势，回放时以此统计识别延迟与误触发。
+ *
+ * 回放：replay()把轨迹送入独立的手势引擎（不影响当前界面），在调用任务中运行，
+ * 以串口输出报告；同一份轨迹也可以在主机端用LvglBench --gesture回放
+ */
+class ImuTrace
+{
+private:
+	File file;
+	ImuTraceRecord* buf[2];
+	uint16_t fill;
+	uint8_t cur;
+	volatile int8_t full;          // 等待写入的缓冲块，-1表示没有
+	volatile bool recording;
+	volatile bool stopping;
+	uint32_t last_ms;
+	uint32_t count;
+	uint32_t dropped;
+	TaskHandle_t writer;
+	SemaphoreHandle_t done;
+
+	bool append(const ImuTraceRecord* r);
+	static void writerEntry(void* arg);
+
+public:
+	ImuTrace();
+	bool start(const char* path, uint16_t rate_hz, uint8_t mode);
+	void stop();
+	bool isRecording();
+
+	void push(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz, uint32_t now);
+	void mark(GestureType type, uint16_t window_ms = IMU_TRACE_LABEL_WINDOW_MS);
+
+	uint32_t getCount();
+	uint32_t getDropped();
+
+	static bool replay(const char* path, GestureReplayReport* out,
+		const GestureRule* rules = NULL, uint8_t count = 0);
+	static void printReport(const char* path, const GestureReplayReport* r);
+};
+
+#endif
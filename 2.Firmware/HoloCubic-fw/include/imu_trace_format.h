@@ -0,0 +1,44 @@
+#ifndef IMU_TRACE_FORMAT_H
+#define IMU_TRACE_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * .imt IMU轨迹格式（固件imu_trace.cpp录制，gesture_replay.cpp与3.Software/LvglBench回放）
+ *
+ * 文件布局（小端）：
+ *   [ImuTraceHeader][ImuTraceRecord][ImuTraceRecord]...
+ *
+ * - 样本记录为送入手势引擎的原始六轴值（getMotion6量程，加速度16384/g），
+ *   dt_ms为距上一条样本的毫秒数，第一条相对start_ms；每条14字节，100Hz时约1.4KB/s
+ * - dt_ms为IMU_TRACE_LABEL时为标注记录：v[0]为期望的GestureType，v[1]为识别窗口（毫秒），
+ *   时间取上一条样本的时间，用于回放时统计识别延迟与误触发
+ * - 文件没有样本总数字段，读取到文件末尾为止（录制中断电时已写入的部分仍可回放）
+ */
+
+#define IMU_TRACE_MAGIC "IMUT"
+#define IMU_TRACE_VERSION 1
+#define IMU_TRACE_LABEL 0xFFFF
+
+#pragma pack(push, 1)
+
+struct ImuTraceHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	uint16_t rate_hz;      // 录制时的标称采样率（轮询模式为传感器任务周期），仅供参考
+	uint8_t mode;          // 录制时的ImuMode
+	uint8_t reserved;
+	uint32_t start_ms;
+};
+
+struct ImuTraceRecord
+{
+	uint16_t dt_ms;
+	int16_t v[6];          // ax ay az gx gy gz
+};
+
+#pragma pack(pop)
+
+#endif
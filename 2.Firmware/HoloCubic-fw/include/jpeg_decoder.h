@@ -0,0 +1,78 @@
+#ifndef JPEG_DECODER_H
+#define JPEG_DECODER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <rom/tjpgd.h>
+
+// tjpgd工作区大小（ROM版本要求至少3100字节）
+#define JPEG_WORK_SIZE 3100
+// 最大MCU高度（4:2:0采样时为16行）
+#define JPEG_MCU_MAX_H 16
+// 获取图像信息时读取的文件头字节数
+#define JPEG_INFO_READ_MAX 4096
+
+/**
+ * 条带输出回调
+ * 每解码完整的一行MCU调用一次，px为RGB565（本机字节序），宽度为图像宽度
+ * 返回false则中止解码
+ */
+typedef bool (*jpeg_band_cb_t)(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px);
+
+/**
+ * 流式输入回调（数据不在内存中时，如后台任务直接读取SD卡文件）
+ * 读入最多len字节到buf，buf为NULL时跳过len字节；返回实际处理的字节数
+ */
+typedef uint32_t (*jpeg_read_cb_t)(void* user, uint8_t* buf, uint32_t len);
+
+/**
+ * 基于ESP32 ROM tjpgd的基线JPEG解码器
+ * 按MCU行输出条带（宽度 x 8/16行），不需要整帧解码缓冲区
+ */
+class JpegDecoder
+{
+private:
+	JDEC jdec;
+	uint8_t* work;
+	const uint8_t* src;
+	uint32_t src_len;
+	uint32_t src_pos;
+	jpeg_read_cb_t reader;
+	void* reader_user;
+	uint8_t scale;
+
+	uint16_t* band;
+	uint16_t band_w;
+	uint16_t out_w;        // 缩小后的输出宽度（条带行距）
+	uint16_t band_y;
+	uint16_t band_h;
+	jpeg_band_cb_t band_cb;
+	void* band_user;
+
+	bool prepare();
+	static UINT inputFunc(JDEC* jd, BYTE* buf, UINT len);
+	static UINT outputFunc(JDEC* jd, void* bitmap, JRECT* rect);
+
+public:
+	JpegDecoder();
+	~JpegDecoder();
+
+	bool open(const uint8_t* data, uint32_t len);
+	bool open(jpeg_read_cb_t read, void* user);
+	// scale: 0~3，按1/2^scale缩小输出（tjpgd在IDCT阶段缩小，缩得越小解码越快）
+	bool decode(jpeg_band_cb_t cb, void* user, uint8_t scale = 0);
+	void release();
+
+	uint16_t getWidth();
+	uint16_t getHeight();
+	uint16_t getMcuHeight();
+	static uint16_t scaledSize(uint16_t size, uint8_t scale);
+};
+
+/**
+ * 注册LVGL图像解码器
+ * 支持文件源（"S:/xxx.jpg"/".jpeg"）与内存源（cf为LV_IMG_CF_RAW、数据为JPEG的lv_img_dsc_t）
+ */
+void jpeg_decoder_lv_init();
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef LIVE_LINK_H
+#define LIVE_LINK_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <esp_now.h>
+#include "scene_player.h"
+#include "network.h"
+
+// 未连接WiFi时接收使用的信道（已连接时ESP-NOW只能使用AP所在信道，伴侣板须与之一致）
+#define LIVE_CHANNEL 1
+// 单帧最多分片数（按位图去重），JPEG帧的最大字节数由此得出
+#define LIVE_CHUNKS_MAX 128
+#define LIVE_JPEG_MAX (LIVE_CHUNKS_MAX * (ESP_NOW_MAX_DATA_LEN - sizeof(LivePacketHeader)))
+// 未收齐的帧超过该时间后放弃（伴侣板中途停止发送时释放槽位）
+#define LIVE_FRAME_TIMEOUT_MS 100
+
+#define LIVE_MAGIC0 'H'
+#define LIVE_MAGIC1 'N'
+
+// LivePacketHeader.type（与openLive的格式对应，其他类型的包丢弃）
+#define LIVE_TYPE_RLE 1        // 载荷为(uint16_t 重复次数, uint16_t RGB565)对，从第offset个像素起按行优先展开
+#define LIVE_TYPE_JPEG 2       // 载荷为一幅基线JPEG从第offset字节起的一段
+
+// LivePacketHeader.flags
+#define LIVE_FLAG_END 0x01     // 本帧最后一个分片（本帧分片数 = chunk + 1）
+
+#pragma pack(push, 1)
+
+/**
+ * ESP-NOW包头（小端，12字节，载荷随后，整包不超过ESP_NOW_MAX_DATA_LEN）
+ * 每个分片带有在帧内的位置（offset），按任意顺序到达都直接写入槽位；
+ * frame为16位递增帧号（回绕按有符号差比较），比已显示帧旧的包丢弃
+ */
+struct LivePacketHeader
+{
+	uint8_t magic[2];
+	uint8_t type;
+	uint8_t flags;
+	uint16_t frame;
+	uint16_t chunk;
+	uint32_t offset;
+};
+
+#pragma pack(pop)
+
+struct LiveLinkStats
+{
+	uint32_t frames;       // 收齐并提交显示的帧
+	uint32_t dropped;      // 未收齐（丢包、超时、被新帧取代）而放弃的帧
+	uint32_t late;         // 比已提交帧旧的包
+	uint32_t busy;         // 没有空闲槽位（显示跟不上）而跳过的帧
+};
+
+/**
+ * ESP-NOW实时画面（伴侣板摄像头等）
+ *
+ * 伴侣ESP32把每帧JPEG（或RLE压缩的RGB565）切成ESP-NOW分片发送，不需要连接AP，没有TCP/UDP协议栈开销。
+ * 接收回调（WiFi任务）中按offset把分片直接写入场景播放器环形缓冲区的槽位：
+ * JPEG分片原样复制，RLE分片直接展开为槽位中的像素，中间没有包缓冲与重组缓冲；
+ * 收齐一帧后提交给播放器，LVGL任务中最多SCENE_LIVE_POLL_MS即解码/写屏（见ScenePlayer::openLive）。
+ *
+ * 延迟：一帧的空中时间取决于伴侣板的ESP-NOW速率（esp_wifi_config_espnow_rate），
+ * 默认1Mbps时8KB的JPEG约需70ms；提高到较高速率、使用120x120等小画面（控件放大显示）时一帧可在50ms内上屏。
+ *
+ * 注意事项：
+ * - start()/stop()会切换播放器并创建/删除lv_task，需在LVGL任务中调用
+ * - 运行期间关闭WiFi省电（Network::acquire），否则射频休眠期间的分片会丢失
+ * - SCENE_LIVE_RAW的槽位为整幅像素，片内RAM只够较小的画面（120x120三个槽位约86KB）
+ * - peer不为NULL时只接收该MAC地址的包
+ */
+class LiveLink
+{
+private:
+	ScenePlayer* player;
+	Network* net;
+	SceneLiveFormat format;
+	uint8_t type;
+	uint16_t width;
+	uint16_t height;
+	uint8_t peer[6];
+	bool has_peer;
+	volatile bool running;
+	volatile bool in_cb;
+
+	// 正在接收的帧（只在接收回调中访问）
+	int8_t cur;
+	uint16_t cur_frame;
+	uint32_t first_ms;
+	uint32_t chunks[LIVE_CHUNKS_MAX / 32];
+	uint16_t received;
+	uint16_t expected;     // 0表示尚未收到结束分片
+	uint32_t jpeg_len;
+	bool skipping;         // 没有空闲槽位，跳过skip_frame的其余分片
+	uint16_t skip_frame;
+	bool has_last;
+	uint16_t last_frame;
+
+	LiveLinkStats stats;
+
+	void onPacket(const uint8_t* mac, const uint8_t* data, int len);
+	bool writeChunk(const LivePacketHeader* hdr, const uint8_t* payload, uint16_t len);
+	void abandon();
+	static void recvCb(const uint8_t* mac, const uint8_t* data, int len);
+
+public:
+	LiveLink();
+	/**
+	 * 开始接收并在img上显示
+	 * @param net 运行期间关闭其省电，可为NULL
+	 * @param w/h 画面尺寸（JPEG帧的尺寸以图像为准，w/h只用于检查）
+	 */
+	bool start(ScenePlayer* scene, lv_obj_t* img, Network* net, SceneLiveFormat fmt, uint16_t w, uint16_t h,
+			   const uint8_t* peer_mac = NULL);
+	void stop();
+	bool isRunning();
+	void getStats(LiveLinkStats* out);
+};
+
+extern LiveLink livelink;
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>
+#include <stdarg.h>
+
+/**
+ * 日志级别（数值越小越重要）
+ */
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// 编译时级别：低于该级别的LOG_x调用连同参数一起被去掉（如build_flags = -DLOG_LEVEL=4）
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// 环形缓冲区：槽数（2的幂）与每条日志的最大长度（含标签，超出截断）
+#define LOG_RING_SLOTS 32
+#define LOG_LINE_MAX 112
+// 输出任务：每LOG_DRAIN_MS检查一次，缓冲区过半时提前唤醒
+#define LOG_DRAIN_MS 50
+#define LOG_TASK_CORE 0
+#define LOG_TASK_PRIORITY 1
+#define LOG_TASK_STACK 3072
+// 限速（令牌桶）：每秒最多LOG_RATE_PER_S条，允许LOG_RATE_BURST条突发；ERROR不限速
+#define LOG_RATE_PER_S 40
+#define LOG_RATE_BURST 24
+// SD卡输出：追加写入的文件，超过LOG_SD_MAX_SIZE时改名为.old重新开始
+#define LOG_SD_PATH "/log/holo.log"
+#define LOG_SD_MAX_SIZE (256 * 1024)
+// UDP输出的默认端口（logger.setUdpTarget未指定端口时使用）
+#define LOG_UDP_PORT 9126
+
+// 输出目标（可组合）
+#define LOG_SINK_UART 0x01
+#define LOG_SINK_SD   0x02
+#define LOG_SINK_UDP  0x04
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	// 写入一条日志（不含换行）；只做格式化与一次原子操作，不等待输出，缓冲区满或超速时丢弃并计数
+	// 可在任意任务中调用，不能在中断中调用
+	void log_write(uint8_t level, const char* tag, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+	void log_vwrite(uint8_t level, const char* tag, const char* fmt, va_list ap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(tag, fmt, ...) log_write(LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(tag, fmt, ...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(tag, fmt, ...) log_write(LOG_LEVEL_WARN, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(tag, fmt, ...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(tag, fmt, ...) log_write(LOG_LEVEL_INFO, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(tag, fmt, ...) ((void)0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(tag, fmt, ...) log_write(LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(tag, fmt, ...) ((void)0)
+#endif
+
+#ifdef __cplusplus
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "sd_card.h"
+
+/**
+ * 异步日志
+ *
+ * 生产者（任意任务）用LOG_E/W/I/D把日志格式化进环形缓冲区的一个槽位：
+ * 以CAS占用槽位序号，写完后发布，期间不加锁、不等待串口，渲染任务不会被日志突发拖慢。
+ * 低优先级的输出任务按顺序取出，依次写到已启用的目标（串口/SD卡/UDP）。
+ *
+ * begin()之前写入的日志保存在缓冲区中，begin()后一并输出（缓冲区满后丢弃），
+ * 丢弃与限速的条数在恢复后以一条WARN日志报告
+ */
+class Logger
+{
+private:
+	TaskHandle_t task;
+	uint8_t sinks;
+	File file;
+	uint32_t file_size;
+	uint32_t last_flush;
+	WiFiUDP udp;
+	IPAddress udp_ip;
+	uint16_t udp_port;
+	uint32_t reported_drops;
+	uint32_t reported_limited;
+
+	void emit(const char* line, size_t len);
+	void openFile();
+	static void taskEntry(void* arg);
+
+public:
+	Logger();
+	bool begin(uint8_t sinks = LOG_SINK_UART);
+	void setSinks(uint8_t sinks);
+	uint8_t getSinks();
+	// 运行时级别（默认为LOG_LEVEL，只能调低），如现场调试时临时关闭INFO
+	void setLevel(uint8_t level);
+	uint8_t getLevel();
+	void setUdpTarget(IPAddress ip, uint16_t port = LOG_UDP_PORT);
+	// 在当前任务中输出缓冲区中的全部日志（重启或断言前调用，之后再写入仍走输出任务）
+	void flush();
+
+	uint32_t getDropped();
+	uint32_t getLimited();
+
+	// 供输出任务以外的调用者唤醒输出（生产者内部使用）
+	void kick();
+};
+
+extern Logger logger;
+
+#endif
+
+#endif
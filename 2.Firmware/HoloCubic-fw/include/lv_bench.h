@@ -0,0 +1,78 @@
+#ifndef LV_BENCH_H
+#define LV_BENCH_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+#include "app_manager.h"
+
+// 1：启动后运行一次LVGL基准测试（结果写入SD卡后回到原界面）
+#ifndef LV_BENCH_ON_BOOT
+#define LV_BENCH_ON_BOOT 0
+#endif
+
+// 每个场景的运行时间；场景内的帧记录取自render_prof环形缓冲区，
+// 刷新周期30ms时1秒约33帧，不能超过RENDER_PROF_RING_LEN
+#define LV_BENCH_SCENE_MS 1000
+// 场景切换后丢弃的时间（对象创建与首帧整屏重绘不计入）
+#define LV_BENCH_WARMUP_MS 100
+// 每个场景的对象数与测试图像尺寸（与lv_demo_benchmark一致）
+#define LV_BENCH_OBJ_NUM 8
+#define LV_BENCH_IMG_SIZE 100
+// JSON报告路径（SD卡）
+#define LV_BENCH_REPORT_DIR "/bench"
+#define LV_BENCH_REPORT_PATH "/bench/lvgl.json"
+
+/**
+ * 一个场景（普通或半透明模式）的测试结果（微秒为所有帧的合计）
+ */
+struct LvBenchResult
+{
+	uint16_t frames;
+	uint8_t skipped;       // 测试图像内存不足时跳过
+	uint32_t px;
+	uint32_t elapsed_ms;
+	uint32_t frame_us;     // 刷新任务总耗时
+	uint32_t render_us;    // DRAW：绘制到条带缓冲
+	uint32_t flush_us;     // FLUSH：条带送屏（含等待上一条带DMA）
+	uint32_t spi_us;       // SPI：flush_cb内部
+	uint32_t imu_us;       // 同期传感器任务的IMU读取耗时
+	uint32_t max_frame_us;
+};
+
+/**
+ * 设备端LVGL基准测试
+ * 场景与权重取自lv_demo_benchmark（矩形、边框、阴影、图像、文字、线条、圆弧、减法混合），
+ * 每个场景先以不透明、再以半透明模式各运行LV_BENCH_SCENE_MS，
+ * 在真实的ST7789刷新路径与传感器任务下按render_prof分阶段计时，
+ * 绘制（DRAW）与送屏（FLUSH/SPI）分开统计，结束后输出串口摘要并写入JSON报告。
+ * 所有接口必须在LVGL任务中调用
+ */
+class LvBench
+{
+private:
+	lv_obj_t* scr;
+	lv_obj_t* prev_scr;
+	lv_task_t* task;
+	LvBenchResult* results;
+	uint8_t scene;
+	bool opa_mode;
+	bool prof_was_enabled;
+	uint32_t scene_start;
+
+	void startScene();
+	void collect(LvBenchResult* r);
+	void finish();
+	bool writeReport(const char* path);
+	static void taskCb(lv_task_t* t);
+
+public:
+	bool start();
+	void stop();
+	bool isRunning();
+};
+
+extern LvBench lvbench;
+// 以应用形式运行（apps.open(apps.add(lv_bench_app))），离开前台时停止测试
+extern const App lv_bench_app;
+
+#endif
@@ -18,10 +18,25 @@ extern "C" {
 	 *********************/
 #include "lvgl.h"
 #include "ff.h"
+
+/* LVGL文件读取的预读缓冲区大小（须为2的幂，建议等于SD卡簇大小） */
+#ifndef LV_FS_RA_SIZE
+#define LV_FS_RA_SIZE 4096
+#endif
+/* 只读打开的文件关闭后保持打开的句柄数（再次打开同一路径时不再查找目录），0表示不缓存 */
+#ifndef LV_FS_HANDLE_CACHE
+#define LV_FS_HANDLE_CACHE 4
+#endif
+/* 可缓存的最长路径（含结尾0） */
+#define LV_FS_CACHE_PATH_MAX 64
+/* 快速定位的簇链表长度（FF_USE_FASTSEEK时，每个连续片段2项，碎片更多的文件按普通方式定位） */
+#define LV_FS_CLMT_SIZE 32
 	 /*********************
 	  *      DEFINES
 	  *********************/
 	void lv_fs_if_init(void);
+	/* SD卡上的文件被其他代码改写、删除或改名后调用：缓存的句柄在LVGL下次打开文件时关闭（可在任意任务中调用） */
+	void lv_fs_if_invalidate(void);
 	/**********************
 	 *      TYPEDEFS
 	 **********************/
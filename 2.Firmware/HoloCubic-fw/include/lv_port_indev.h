@@ -21,8 +21,25 @@ extern "C" {
 
 	extern lv_indev_t* indev_encoder;
 
+	/* 编码器事件统计 */
+	typedef struct
+	{
+		uint32_t delivered;       // 已交付给LVGL的事件数
+		uint32_t overflow;        // 缓冲区满丢弃的事件数
+		uint32_t expired;         // 超时未读取而丢弃的事件数
+		uint32_t max_latency_ms;  // 产生到交付的最大延迟
+	} lv_port_indev_stats_t;
+
 	void lv_port_indev_init(void);
 
+	/* 手势引擎写入编码器事件（单写者，缓冲区满时返回false） */
+	bool lv_port_indev_push(int16_t diff, lv_indev_state_t state, uint32_t time);
+	void lv_port_indev_get_stats(lv_port_indev_stats_t* stats);
+	/* 空闲时暂停周期读取：事件写入后调用cb唤醒LVGL任务，再由LVGL任务调用resume立即读取，
+	 * 读到事件后刷新任务随即就绪，手势到画面更新只需一帧 */
+	void lv_port_indev_set_wake_cb(void (*cb)(void));
+	void lv_port_indev_resume(void);
+
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,76 @@
+/**
+ * @file lv_port_mem.h
+ *
+ */
+
+#ifndef LV_PORT_MEM_H
+#define LV_PORT_MEM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/*********************
+	 *      INCLUDES
+	 *********************/
+#include "lvgl.h"
+
+	/*********************
+	 *      DEFINES
+	 *********************/
+
+/* 初始内部RAM堆大小（替代原LV_MEM_SIZE的静态数组，首次分配时从系统堆申请） */
+#ifndef LV_PORT_MEM_INTERNAL_SIZE
+#define LV_PORT_MEM_INTERNAL_SIZE (40U * 1024U)
+#endif
+/* 内部堆不足时每次向系统堆追加的区域大小与最多追加次数 */
+#define LV_PORT_MEM_GROW_SIZE (16U * 1024U)
+#define LV_PORT_MEM_GROW_MAX 6
+/* 有PSRAM时追加的PSRAM区域大小（内部堆用尽后才使用，无PSRAM时忽略） */
+#ifndef LV_PORT_MEM_PSRAM_SIZE
+#define LV_PORT_MEM_PSRAM_SIZE (512U * 1024U)
+#endif
+
+/* 小块固定池：样式属性、lv_ll节点、动画等频繁分配的小对象（大小含lv_mem的4字节头） */
+#define LV_PORT_MEM_POOL_CNT 3
+#define LV_PORT_MEM_POOL_SIZES { 16, 32, 64 }
+#define LV_PORT_MEM_POOL_BLOCKS { 128, 128, 64 }
+
+	/**********************
+	 *      TYPEDEFS
+	 **********************/
+
+	/* 分配器统计 */
+	typedef struct
+	{
+		uint32_t internal_size;      // 内部RAM堆总大小（含追加区域）
+		uint32_t psram_size;         // PSRAM堆大小
+		uint32_t heap_free;          // TLSF堆空闲字节
+		uint32_t heap_biggest;       // TLSF最大空闲块
+		uint16_t heap_free_cnt;      // TLSF空闲块数
+		uint16_t grow_cnt;           // 已追加的内部区域数
+		uint32_t pool_used[LV_PORT_MEM_POOL_CNT];
+		uint32_t pool_max_used[LV_PORT_MEM_POOL_CNT];
+		uint32_t pool_fallback;      // 池满后转由TLSF分配的次数
+		uint32_t used_cnt;           // 当前已分配块数
+		uint32_t used_size;          // 当前已分配字节
+		uint32_t max_used;           // 已分配字节峰值
+		uint32_t fail_cnt;           // 分配失败次数
+	} lv_port_mem_stats_t;
+
+	/**********************
+	 * GLOBAL PROTOTYPES
+	 **********************/
+
+	/* 可在lv_init前调用；未调用时首次分配自动初始化 */
+	void lv_port_mem_init(void);
+	void* lv_port_mem_alloc(size_t size);
+	void lv_port_mem_free(void* ptr);
+	void lv_port_mem_monitor(lv_mem_monitor_t* mon);
+	void lv_port_mem_get_stats(lv_port_mem_stats_t* stats);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_PORT_MEM_H*/
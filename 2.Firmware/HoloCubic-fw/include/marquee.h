@@ -0,0 +1,76 @@
+#ifndef MARQUEE_H
+#define MARQUEE_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+
+// 滚动定时器周期（约30帧/秒）与默认速度（像素/秒）
+#define MARQUEE_PERIOD_MS 33
+#define MARQUEE_SPEED 40
+// 循环滚动时文字末尾与下一遍开头之间的空白（像素）
+#define MARQUEE_GAP 48
+// 条带缓冲上限（字节）：montserrat 14的A8条带约16字节/像素列，32KB约可放2000像素宽的文字
+#define MARQUEE_MAX_BYTES (32U * 1024U)
+
+/**
+ * 条带格式
+ */
+enum MarqueeFormat
+{
+	MARQUEE_A8 = 0,        // 每像素1字节覆盖率，绘制时按前景色与下层内容混合（背景透明）
+	MARQUEE_RGB565         // 每像素2字节，背景色预先填好，绘制时直接复制（不透明）
+};
+
+/**
+ * 跑马灯（滚动文字）
+ *
+ * lv_label的循环滚动每移动一个像素都要重新排版并逐字形混合整段文字。
+ * 这里在设置文字时把整段文字渲染一次到条带缓冲（A8或RGB565），
+ * 之后每帧只把条带中可见的窗口按行绘制到显示缓冲：A8作为遮罩做一次填充混合，
+ * RGB565直接复制，与文字长度和字形数量无关。
+ * 文字不超过控件宽度时不滚动、不创建定时器。
+ *
+ * 注意事项：
+ * - 所有接口必须在LVGL任务中调用；控件随父对象删除时自动释放条带与定时器
+ * - 不处理圆角裁剪等绘制遮罩，请放在没有圆角裁剪的父对象上
+ */
+class Marquee
+{
+private:
+	lv_obj_t* obj;
+	lv_task_t* task;
+	uint8_t* strip;           // A8为覆盖率，RGB565为lv_color_t；strip_w * strip_h像素
+	MarqueeFormat format;
+	const lv_font_t* font;
+	lv_color_t fg;
+	lv_color_t bg;
+	lv_coord_t strip_w;       // 滚动时为文字宽度加MARQUEE_GAP，否则为文字宽度
+	lv_coord_t strip_h;
+	bool scrolling;
+	uint16_t speed;
+	uint32_t pos_q8;          // 可见窗口左端在条带中的位置（1/256像素）
+	lv_coord_t shown;         // 当前显示的位置（整像素）
+	uint32_t last_ms;
+	uint16_t loops;
+
+	void release();
+	void detach();
+	void render(const char* txt, lv_coord_t text_w);
+	static lv_coord_t measure(const lv_font_t* font, const char* txt);
+	static Marquee* of(lv_obj_t* o);
+	static lv_design_res_t designCb(lv_obj_t* o, const lv_area_t* clip, lv_design_mode_t mode);
+	static lv_res_t signalCb(lv_obj_t* o, lv_signal_t sign, void* param);
+	static void taskCb(lv_task_t* t);
+
+public:
+	Marquee();
+	bool create(lv_obj_t* parent, lv_coord_t w, const lv_font_t* font, lv_color_t fg, lv_color_t bg,
+				MarqueeFormat fmt = MARQUEE_A8);
+	void destroy();
+	lv_obj_t* getObj();
+	bool setText(const char* txt);
+	void setSpeed(uint16_t px_per_s);
+	uint16_t getLoops();
+};
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef MESH_SCENE_H
+#define MESH_SCENE_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "display.h"
+#include "fixed_math.h"
+
+// 目标帧率（姿态不变且不自转时不重绘）
+#define MESH_FPS 30
+// 每条带行数：两个条带缓冲（DMA内存）共 2 * 240 * 16 * 2 = 15KB
+#define MESH_STRIP_LINES 16
+// 网格上限（顶点数、三角形数），每个三角形约占24字节
+#define MESH_MAX_VERTS 1024
+#define MESH_MAX_FACES 2048
+// 透视投影：焦距与相机到模型中心的距离（模型单位，1约为屏幕中心处1像素）
+#define MESH_FOCAL 320
+#define MESH_CAMERA_Z 400
+// 模型顶点到中心的最大距离，保证所有顶点都在相机前方
+#define MESH_MAX_RADIUS 280
+// 光照：环境光下限（0~255），其余按面法线与光线方向的夹角
+#define MESH_AMBIENT 56
+// 没有DMP姿态时的默认自转速度（度/秒）与固定倾角（度）
+#define MESH_SPIN_DPS 40
+#define MESH_IDLE_TILT 20
+// 1：模型在世界中保持不动，转动立方体即从不同角度观察（画面中按相反方向旋转）；0：模型跟随立方体转动
+#define MESH_WORLD_FIXED 1
+
+/**
+ * 绘制方式
+ */
+enum MeshMode
+{
+	MESH_SOLID = 0,        // 平面着色的实体
+	MESH_WIRE,             // 线框（只画朝向观察者的面的边）
+	MESH_SOLID_WIRE        // 实体加边线
+};
+
+/**
+ * 模型坐标：x向右、y向上、z指向观察者，中心在原点
+ */
+struct MeshVertex
+{
+	int16_t x;
+	int16_t y;
+	int16_t z;
+};
+
+/**
+ * 三角形：三个顶点序号，从模型外侧看为逆时针
+ */
+struct MeshFace
+{
+	uint16_t a;
+	uint16_t b;
+	uint16_t c;
+};
+
+/**
+ * 统计信息
+ */
+struct MeshStats
+{
+	uint32_t frames;       // 有重绘的帧数
+	uint32_t idle;         // 姿态未变、跳过重绘的帧数
+	uint16_t visible;      // 最近一帧通过背面剔除的三角形数
+	uint32_t pixels;       // 最近一帧写屏的像素数
+	uint32_t frame_us;     // 最近一帧变换、光栅化与写屏耗时
+	uint32_t max_us;
+};
+
+/**
+ * 实时三维网格场景
+ * DMP姿态（orientation）驱动模型旋转；姿态不可用时按MESH_SPIN_DPS自转。
+ *
+ * 每帧用定点运算（Q14旋转矩阵、Q4亚像素屏幕坐标）变换顶点，按屏幕空间绕向剔除背面，
+ * 按面法线做平面着色，再按三个顶点深度之和由远到近排序（画家算法，不需要深度缓冲）。
+ * 光栅化逐条带进行：两个条带缓冲交替，DMA发送上一条带时扫描线填充下一条带中落入的三角形，
+ * 只重绘本帧与上一帧模型包围盒的并集，不经过LVGL绘制。
+ *
+ * 注意事项：
+ * - start()/stop()会切换LVGL屏幕并创建lv_task，需在LVGL任务中调用
+ * - 运行期间载入一个空白屏幕，避免LVGL重绘覆盖画面；stop()恢复原屏幕
+ * - 画家算法对互相穿插的三角形会有少量排序错误，凸体与环面等常见网格不受影响
+ * - 传感器坐标轴与模型坐标轴直接对应，安装方向不同时调整mesh_scene.cpp中的quatToMatrix
+ */
+class MeshScene
+{
+private:
+	struct Proj
+	{
+		int16_t x;             // 屏幕坐标（1/16像素）
+		int16_t y;
+		int16_t z;             // 旋转后的深度，越大越近
+	};
+
+	struct Tri
+	{
+		uint16_t face;
+		int16_t y1;            // 覆盖的像素行
+		int16_t y2;
+		int32_t depth;         // 三个顶点深度之和
+		uint16_t color;        // 面板字节序
+	};
+
+	Display* display;
+	bool running;
+
+	MeshVertex* verts;
+	MeshFace* faces;
+	int16_t* normals;          // 每个面的单位法线（Q15，x/y/z）
+	uint16_t vert_count;
+	uint16_t face_count;
+	bool owned;                // verts/faces由make*分配
+
+	Proj* proj;
+	Tri* tris;
+	uint16_t tri_count;
+	uint16_t* strips[2];
+
+	MeshMode mode;
+	lv_color_t color;
+	uint16_t bg;               // 面板字节序
+	uint16_t edge;
+
+	bool has_zero;
+	float zero[4];             // 初始姿态四元数（w, x, y, z）
+	int16_t m[9];              // 本帧旋转矩阵（Q14，行优先）
+	fx_angle_t spin;
+	uint16_t spin_dps;
+	uint32_t last_ms;
+	bool full;
+	lv_area_t view;
+	lv_area_t area;            // 本帧模型包围盒
+	lv_area_t shown;           // 上一帧绘制的包围盒
+	bool shown_valid;
+
+	lv_task_t* frame_task;
+	lv_obj_t* screen;
+	lv_obj_t* prev_screen;
+	MeshStats stats;
+
+	bool alloc(uint16_t nv, uint16_t nf);
+	void release();
+	void computeNormals();
+	bool updateRotation(uint32_t dt);
+	void transform();
+	void render(uint16_t* out, const lv_area_t* a);
+	void fillTri(uint16_t* out, const lv_area_t* a, const Tri* t);
+	void drawEdge(uint16_t* out, const lv_area_t* a, const Proj* p, const Proj* q);
+
+	static void frameCb(lv_task_t* task);
+
+public:
+	MeshScene();
+
+	void setDisplay(Display* disp);
+	bool setMesh(const MeshVertex* v, uint16_t nv, const MeshFace* f, uint16_t nf);
+	bool makeTorus(int16_t major, int16_t minor, uint8_t seg_u, uint8_t seg_v);
+	bool makeSphere(int16_t radius, uint8_t seg_u, uint8_t seg_v);
+	bool makeCube(int16_t half);
+	void setStyle(lv_color_t fg, lv_color_t bg_color = LV_COLOR_BLACK, MeshMode m = MESH_SOLID);
+	void setSpin(uint16_t deg_per_s);
+
+	bool start();
+	void stop();
+	void close();
+
+	void recenter();
+	bool isRunning();
+	void getStats(MeshStats* out);
+};
+
+#endif
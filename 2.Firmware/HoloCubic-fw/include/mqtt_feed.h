@@ -0,0 +1,110 @@
+#ifndef MQTT_FEED_H
+#define MQTT_FEED_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <esp_timer.h>
+#include <mqtt_client.h>
+#include "runtime.h"
+
+// 绑定数上限（每个绑定一个主题、一个控件）
+#define MQTT_MAX_BINDINGS 8
+#define MQTT_TOPIC_LEN 64
+// 值以字符串保存（数字、短文本），超长部分截断
+#define MQTT_VALUE_LEN 48
+// 保活间隔：推送模式下两次保活之间射频可以休眠，取较长的值
+#define MQTT_KEEPALIVE_S 120
+// 连接断开后的重连间隔
+#define MQTT_RECONNECT_MS 10000
+// 客户端任务（esp-mqtt，核心由sdkconfig决定）
+#define MQTT_TASK_PRIORITY 1
+#define MQTT_TASK_STACK 4096
+// 绑定未指定刷新周期时，同一控件两次更新的最小间隔
+#define MQTT_DEFAULT_PERIOD_MS 500
+
+// 从消息内容中取出显示的值写入out，返回false时丢弃该消息（在MQTT任务中执行）
+typedef bool (*mqtt_parse_t)(const char* data, int len, char* out, size_t out_len);
+// 把值更新到控件（在LVGL任务中执行）；为NULL时对标签调用lv_label_set_text
+typedef void (*mqtt_apply_t)(lv_obj_t* obj, const char* value, void* user);
+
+/**
+ * 主题与控件的绑定
+ * topic:     完整主题（不支持通配符）
+ * qos:       订阅的QoS（0或1）
+ * period_ms: 同一控件两次更新的最小间隔，0为MQTT_DEFAULT_PERIOD_MS
+ * parse:     为NULL时取消息原文
+ */
+struct MqttBinding
+{
+	const char* topic;
+	uint8_t qos;
+	uint16_t period_ms;
+	lv_obj_t* obj;
+	mqtt_parse_t parse;
+	mqtt_apply_t apply;
+	void* user;
+};
+
+/**
+ * MQTT实时数据（推送代替轮询）
+ *
+ * 基于esp-mqtt的常驻连接：连上后订阅所有绑定的主题，断开后自动重连并重新订阅。
+ * 消息在MQTT任务中解析后只写入绑定的缓存并标记为脏，界面更新合并：
+ *   每个控件在一个刷新周期内最多经runtime.post更新一次，周期内的后续消息只覆盖缓存，
+ *   周期结束时由定时器补发一次，控件总是显示最近的值
+ * 同一时刻每个绑定最多有一条消息在界面队列中，消息再多也不会占满队列
+ */
+class MqttFeed
+{
+private:
+	struct Entry
+	{
+		MqttBinding b;
+		char topic[MQTT_TOPIC_LEN];
+		char value[MQTT_VALUE_LEN];
+		uint32_t applied_ms;   // 上次更新控件的millis
+		bool dirty;            // 缓存中有未显示的值
+		bool posted;           // 已有更新消息在界面队列中
+	};
+
+	esp_mqtt_client_handle_t client;
+	esp_timer_handle_t flush_timer;
+	bool timer_armed;
+	volatile bool connected;
+	volatile uint32_t connect_count;
+	portMUX_TYPE lock;
+	Entry entries[MQTT_MAX_BINDINGS];
+	uint8_t count;
+	uint32_t received;
+	uint32_t updates;
+
+	void onMessage(const char* topic, int topic_len, const char* data, int len);
+	void schedule();
+	void subscribeAll();
+	static void eventHandler(void* arg, esp_event_base_t base, int32_t id, void* data);
+	static void flushCb(void* arg);
+	static void applyMsg(const UiMsg* msg);
+
+public:
+	MqttFeed();
+	// 添加绑定（begin之前或之后都可以，连接后自动订阅），返回编号，已满时返回-1
+	int bind(const MqttBinding& b);
+	// 连接代理，uri如"mqtt://192.168.1.10"；client_id为NULL时用esp-mqtt的默认值
+	bool begin(const char* uri, const char* user = NULL, const char* password = NULL, const char* client_id = NULL);
+	void end();
+	bool isConnected();
+	// 连接成功的次数：发布方据此在每次（重新）连接后补发retain消息
+	uint32_t getConnectCount();
+	/**
+	 * 发布一条消息（任意任务，消息进入esp-mqtt的发送队列后立即返回）
+	 * @param len 0时按字符串长度
+	 * @return 未连接或队列已满时返回false（消息丢弃，不在断线期间积压）
+	 */
+	bool publish(const char* topic, const char* data, int len = 0, int qos = 0, bool retain = false);
+	// 收到的消息数与实际的界面更新次数（两者之差为合并掉的更新）
+	void getStats(uint32_t* rx, uint32_t* ui);
+};
+
+extern MqttFeed mqtt;
+
+#endif
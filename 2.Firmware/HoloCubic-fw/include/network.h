@@ -3,16 +3,182 @@
 
 #include <WiFi.h>
 #include <HTTPClient.h>
+#include <esp_timer.h>
+#include <freertos/queue.h>
+#include "http_api.h"
+#include "runtime.h"
+#include "upload_server.h"
+#include "ota_update.h"
+#include "fleet.h"
 
- 
+// 重连退避：首次断开后NET_BACKOFF_MIN_MS重试，每次失败翻倍，上限NET_BACKOFF_MAX_MS
+#define NET_BACKOFF_MIN_MS 250
+#define NET_BACKOFF_MAX_MS 60000
+// 按缓存的BSSID/信道连续失败多少次后改为全信道扫描（路由器换信道或更换AP）
+#define NET_CACHE_RETRIES 3
+// 省电：无网络任务时为WIFI_PS_MAX_MODEM（每NET_LISTEN_INTERVAL个信标周期醒来一次），
+// acquire()期间关闭省电（数据抓取窗口内吞吐与延迟优先），0：保持驱动默认的WIFI_PS_MIN_MODEM
+#define NET_POWER_SAVE 1
+// 最大省电模式下的监听间隔（信标周期数，通常一个为102.4ms）；AP缓存下行帧的时间有限，不宜过大
+#define NET_LISTEN_INTERVAL 10
+// 联网后自动启动无线上传服务（见upload_server.h）
+#define NET_UPLOAD_SERVER 1
+// 联网后自动启动mDNS与多设备管理服务（见fleet.h）
+#define NET_FLEET 1
+// ESP-Touch配网：没有配置SSID时启动，超时后停止（可再调用startProvisioning）
+#define NET_PROVISION_TIMEOUT_S 180
+// SSID/密码保存在固定数组中（802.11上限32/64字节）
+#define NET_SSID_MAX 33
+#define NET_PASSWORD_MAX 65
+// URL在栈上拼接的最大长度
+#define NET_URL_MAX 256
+// 网络任务：HTTP/TLS请求与JSON解析、联网后的NVS写入与服务启动都在这里执行，不占用LVGL所在的核心1
+#define NET_TASK_CORE 0
+#define NET_TASK_PRIORITY 1
+#define NET_TASK_STACK 8192
+// 待处理的请求与WiFi事件
+#define NET_QUEUE_LEN 8
+// 异步请求的结果（定长字符串，随请求交给界面）
+#define NET_RESULT_LEN 48
+// B站粉丝数API（%s为UID）
+#define NET_BILI_FANS_URL "http://api.bilibili.com/x/relation/stat?vmid=%s"
+
+/**
+ * 网络状态
+ */
+enum NetState
+{
+	NET_IDLE = 0,          // 未启动
+	NET_CONNECTING,        // 正在连接（含退避等待重连）
+	NET_CONNECTED,         // 已获取IP
+	NET_DISCONNECTED,      // 连接断开，等待重连
+	NET_PROVISIONING       // 等待手机经ESP-Touch发送WiFi配置
+};
+
+// 状态回调在WiFi事件任务、定时器任务或网络任务中执行，更新界面需通过runtime.post
+typedef void (*net_state_cb_t)(NetState state, void* user);
+// 配网收到新的SSID/密码（在网络任务中执行，通常写入配置保存）
+typedef void (*net_creds_cb_t)(const char* ssid, const char* password, void* user);
+// 从过滤后的JSON中取出结果写入out（在网络任务中执行），失败返回false
+typedef bool (*net_parse_t)(JsonDocument* doc, char* out, size_t len);
+
+/**
+ * 异步HTTP请求
+ * 由调用方持有（静态或成员变量，不需要动态内存），Network::request提交后在网络任务中请求并解析，
+ * 结果写入result；完成后经runtime.post在LVGL任务中调用done（msg->obj为本请求），
+ * notify不为NULL时改为通知该任务（供其他后台任务等待结果）。
+ * busy期间不要修改；界面只读取定长的result，不接触连接与JSON文档
+ */
+struct NetRequest
+{
+	char url[NET_URL_MAX];
+	const JsonDocument* filter;
+	net_parse_t parse;
+	ui_msg_cb_t done;
+	TaskHandle_t notify;
+	void* user;
+	char result[NET_RESULT_LEN];
+	volatile bool ok;
+	volatile bool busy;
+};
+
+/**
+ * WiFi连接与网络任务
+ * 所有HTTP/TLS套接字读写与JSON解析都在核心0的网络任务中进行，界面只经消息队列收到定长结果，
+ * 下载与解析不会造成掉帧。WiFi事件回调（Arduino事件任务）中只更新状态与重连计时，
+ * 写NVS、启动上传与多设备管理服务、配网凭据回调等较慢的工作交给网络任务
+ */
 class Network
 {
 private:
-	 
+	enum JobType
+	{
+		NET_JOB_REQUEST = 0,   // 异步HTTP请求
+		NET_JOB_ONLINE,        // 已获取IP：保存缓存、启动服务
+		NET_JOB_CREDS,         // 配网收到凭据
+		NET_JOB_DROP_CACHE     // 清除NVS中的重连缓存
+	};
+
+	struct Job
+	{
+		JobType type;
+		NetRequest* req;
+	};
+
+	char ssid[NET_SSID_MAX];
+	char password[NET_PASSWORD_MAX];
+	volatile NetState state;
+	net_state_cb_t state_cb;
+	void* state_user;
+
+	// 快速重连缓存（NVS）：上次成功连接的BSSID与信道
+	bool cache_valid;
+	uint8_t cache_bssid[6];
+	uint8_t cache_channel;
+	uint8_t cache_fails;
+
+	uint32_t backoff_ms;
+	esp_timer_handle_t retry_timer;
+	esp_timer_handle_t prov_timer;
+	net_creds_cb_t creds_cb;
+	void* creds_user;
+
+	portMUX_TYPE ps_lock;
+	uint8_t active;        // acquire()计数
+
+	QueueHandle_t queue;
+	TaskHandle_t task;
+
+	HttpApi api;
+	UploadServer upload;
+	OtaUpdate ota;
+	FleetServer fleet;
+
+	void setState(NetState s);
+	void applyPowerSave();
+	void reportEnergy();
+	bool post(JobType type, NetRequest* req = NULL);
+	void onEvent(arduino_event_id_t event, arduino_event_info_t info);
+	void onOnline();
+	void runRequest(NetRequest* req);
+	void scheduleRetry();
+	void connect();
+	void loadCache();
+	void saveCache(const uint8_t* bssid, uint8_t channel);
+	void dropCache();
+	static void retryCb(void* arg);
+	static void provTimeoutCb(void* arg);
+	static void taskEntry(void* arg);
+
 public:
-	void init(String ssid, String password);
-	unsigned int getBilibiliFans(String url);
+	void init(const char* ssid, const char* password);
+	// 设备名（DHCP/mDNS主机名）与多设备管理密钥，在init之前调用
+	void setIdentity(const char* device_name, const char* fleet_key);
+	void setStateCallback(net_state_cb_t cb, void* user = NULL);
+	void setCredentialsCallback(net_creds_cb_t cb, void* user = NULL);
+	// ESP-Touch配网（init之后调用；init时没有SSID会自动启动）
+	bool startProvisioning();
+	void stopProvisioning();
+	NetState getState();
+	bool isConnected();
+	// 网络工作窗口：acquire到release之间关闭省电，可嵌套，任意任务中调用
+	void acquire();
+	void release();
+
+	/**
+	 * 提交异步请求（任意任务中调用，立即返回）
+	 * @return 请求仍在进行、队列已满或缺少filter/parse时返回false
+	 */
+	bool request(NetRequest* req);
+	// 异步获取B站粉丝数，完成后done中取req->result（十进制字符串）
+	bool requestBilibiliFans(NetRequest* req, const char* uid, ui_msg_cb_t done, void* user = NULL);
+	// 共用HTTP客户端，只能在网络任务中使用（其他任务经request提交）
+	HttpApi* getApi();
+	TaskHandle_t getTask();
+	UploadServer* getUploadServer();
+	OtaUpdate* getOta();
+	FleetServer* getFleet();
 
 };
 
-#endif
\ No newline at end of file
+#endif
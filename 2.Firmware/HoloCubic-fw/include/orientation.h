@@ -0,0 +1,112 @@
+#ifndef ORIENTATION_H
+#define ORIENTATION_H
+
+#include <Arduino.h>
+#include <helper_3dmath.h>
+
+// 注意：本头文件不能包含MPU6050.h，DMP版本的MPU6050类布局不同，只在orientation.cpp中使用
+
+// 订阅者上限
+#define ORIENT_MAX_SUBSCRIBERS 4
+// DMP数据包最大长度（MotionApps 2.0为42字节）
+#define ORIENT_PACKET_MAX 64
+
+// 软件融合（DMP不可用时，见beginSoftware）：输入采样率与输出抽取倍数（输出与DMP同为100Hz）
+#define ORIENT_SW_RATE_HZ 200
+#define ORIENT_SW_DECIM 2
+// 陀螺仪灵敏度：MPU6050::initialize()设为±250dps，131 LSB/(°/s)
+#define ORIENT_SW_GYRO_LSB 131
+// Mahony比例/积分增益（rad/s每单位误差）：比例项约1秒收敛到重力方向，积分项补偿零偏残差
+#define ORIENT_SW_KP 1.0
+#define ORIENT_SW_KI 0.02
+// 加速度模长在0.5g~1.5g之外（晃动、撞击）时只积分陀螺仪，不做重力校正（16384/g）
+#define ORIENT_SW_ACC_MIN 8192
+#define ORIENT_SW_ACC_MAX 24576
+// 每步融合的CPU预算：约70次32x32位乘法与一次64位除法，按240MHz估计10~20us，
+// 200Hz时不到传感器核的0.5%；超出时计入over_budget（见getStats）
+#define ORIENT_SW_BUDGET_US 40
+
+/**
+ * 姿态快照
+ * q/gravity/ypr由片上DMP（或软件融合）得到，accel/gyro为同一时刻的原始值
+ * ypr单位为弧度：yaw绕Z轴，pitch绕Y轴，roll绕X轴；没有磁力计，yaw会缓慢漂移
+ * 软件融合时accel同样换算为DMP数据包的8192/g，两种来源对使用方没有区别
+ */
+struct OrientationData
+{
+	Quaternion q;
+	VectorFloat gravity;
+	float ypr[3];
+	VectorInt16 accel;
+	VectorInt16 gyro;
+	uint32_t timestamp;    // 读出该数据包时（软件融合为该样本采样时）的micros()
+	uint32_t count;        // 累计数据包序号
+};
+
+/**
+ * 软件融合的耗时统计（getStats）
+ */
+struct OrientationStats
+{
+	uint32_t steps;        // 累计融合步数
+	uint16_t avg_us;       // 每步平均耗时
+	uint16_t max_us;       // 最大耗时
+	uint32_t over_budget;  // 超出ORIENT_SW_BUDGET_US的步数
+};
+
+typedef void (*orientation_cb_t)(const OrientationData* data, void* user);
+
+/**
+ * DMP姿态服务
+ * 运行MPU6050片上DMP（MotionApps 2.0，默认100Hz），在传感器任务中调用poll()读出数据包，
+ * 最新结果以序列锁快照发布：写方只有传感器任务，读方在任意任务中调用get()，不需要互斥锁
+ *
+ * 部分兼容芯片的DMP固件加载失败或运行不稳定，此时改用软件融合：IMU以ORIENT_SW_RATE_HZ
+ * 读出FIFO原始样本并逐个调用feed()，由定点Mahony滤波（Q30四元数，只有整数运算）更新姿态，
+ * 每ORIENT_SW_DECIM步发布一次，get()/subscribe()与DMP模式完全相同
+ */
+class Orientation
+{
+private:
+	volatile uint32_t seq;     // 奇数表示正在写入
+	OrientationData data;
+	bool ready;
+	uint16_t packet_size;
+	uint8_t packet[ORIENT_PACKET_MAX];
+
+	orientation_cb_t subs[ORIENT_MAX_SUBSCRIBERS];
+	void* subs_user[ORIENT_MAX_SUBSCRIBERS];
+	uint8_t sub_count;
+
+	// 软件融合状态（只在传感器任务中访问）
+	bool software;
+	bool sw_init;
+	int32_t sq[4];             // 四元数w/x/y/z，Q30
+	int64_t integ[3];          // 积分项（半角增量，Q62）
+	uint8_t decim;
+	OrientationStats stats;
+	uint64_t cost_total;
+
+	void publish(const OrientationData& d);
+	void initFromAccel(const int16_t accel[3]);
+	void step(const int16_t accel[3], const int16_t gyro[3]);
+
+public:
+	bool begin();
+	uint16_t poll();
+
+	// 软件融合（需先把传感器配置为采样率ORIENT_SW_RATE_HZ、陀螺仪±250dps的FIFO模式）
+	bool beginSoftware();
+	// 送入一个原始样本（加速度16384/g，已扣除零偏），t_us为采样时刻的micros()
+	void feed(const int16_t accel[3], const int16_t gyro[3], uint32_t t_us);
+	bool isSoftware();
+	void getStats(OrientationStats* out);
+
+	bool get(OrientationData* out);
+	bool subscribe(orientation_cb_t cb, void* user = NULL);
+	bool isReady();
+};
+
+extern Orientation orientation;
+
+#endif
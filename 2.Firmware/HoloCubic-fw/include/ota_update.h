@@ -0,0 +1,73 @@
+#ifndef OTA_UPDATE_H
+#define OTA_UPDATE_H
+
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+
+// 下载任务（低于LVGL与网络任务，写flash间隙让出CPU）
+#define OTA_TASK_CORE 0
+#define OTA_TASK_PRIORITY 1
+#define OTA_TASK_STACK 8192
+// 单次写入大小（flash扇区大小，esp_ota_write按扇区擦写）
+#define OTA_CHUNK_SIZE 4096
+// 新固件启动后运行这么久未出错则确认有效
+#define OTA_VALID_AFTER_MS 30000
+// 新固件连续启动这么多次仍未确认有效则回滚到旧固件
+#define OTA_BOOT_TRIES 3
+#define OTA_URL_MAX 160
+
+enum OtaState
+{
+	OTA_IDLE = 0,
+	OTA_RUNNING,
+	OTA_DONE,          // 已写入并校验，重启后生效
+	OTA_FAILED
+};
+
+/**
+ * OTA固件升级（A/B分区）
+ * 固件按OTA_CHUNK_SIZE分段写入非运行分区，不在内存中缓存整个镜像：
+ * - 数据来源可以是HTTP(S)下载（startFromUrl，后台任务）或调用方推送（begin/write/end，
+ *   无线上传服务的PUT /ota即用此方式）
+ * - end()时由esp_ota_end校验镜像，另可校验调用方给出的SHA-256
+ * - 重启后新固件处于待确认状态，运行OTA_VALID_AFTER_MS后自动确认；
+ *   确认前连续启动OTA_BOOT_TRIES次（崩溃重启）则切回旧分区
+ * 擦写按扇区随写入进行，避免一次性擦除整个分区导致两个核心长时间停顿
+ */
+class OtaUpdate
+{
+private:
+	esp_ota_handle_t handle;
+	const esp_partition_t* target;
+	volatile OtaState state;
+	uint32_t total;
+	volatile uint32_t written;
+	bool check_sha;
+	uint8_t expect_sha[32];
+	mbedtls_sha256_context sha;
+	char url[OTA_URL_MAX];
+	TaskHandle_t task;
+
+	static void taskEntry(void* arg);
+	static void validCb(void* arg);
+	void download();
+
+public:
+	OtaUpdate();
+
+	bool begin(uint32_t size = 0, const char* sha256_hex = NULL);
+	bool write(const uint8_t* data, size_t len);
+	bool end();
+	void abort();
+
+	bool startFromUrl(const char* url, const char* sha256_hex = NULL);
+
+	OtaState getState();
+	uint8_t getProgress();
+
+	static void checkBoot();
+	static void markValid();
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef PALETTE_DECODER_H
+#define PALETTE_DECODER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+
+// 主界面颜色选择器的着色强度（与image_recolor_opa含义相同）
+#define PALETTE_TINT_OPA LV_OPA_50
+// 记录的已打开图像数（LVGL图像缓存的条目数加超出字节预算时的临时条目；超出时着色变化使整个图像缓存失效）
+#define PALETTE_TINT_TRACK (LV_IMG_CACHE_DEF_SIZE + 1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * 注册索引色图像解码器（需在lv_init之后调用）
+ * 接管内存中（LV_IMG_SRC_VARIABLE）调色板全部不透明的INDEXED_1/2/4/8BIT图像：
+ * 打开时把调色板换算为lv_color_t查找表，逐行读取时按索引查表直接输出TRUE_COLOR像素
+ */
+void palette_decoder_lv_init();
+
+/**
+ * 索引色图像着色（LVGL任务中调用）
+ * 建查找表时把每个调色板颜色与color按opa混合（结果与image_recolor相同），逐像素查表不增加开销；
+ * 着色变化时只使本解码器打开的图像在LVGL图像缓存中失效并重绘，下次打开时重算16/256项调色板。
+ * opa为LV_OPA_TRANSP时取消着色。真彩色图像不受影响
+ */
+void palette_decoder_set_tint(lv_color_t color, lv_opa_t opa);
+lv_opa_t palette_decoder_get_tint(lv_color_t* color);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
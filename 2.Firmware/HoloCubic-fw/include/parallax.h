@@ -0,0 +1,124 @@
+#ifndef PARALLAX_H
+#define PARALLAX_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "display.h"
+
+#define PARALLAX_MAX_LAYERS 4
+// 目标帧率（姿态不变的帧不重绘，只有倾斜时才有写屏开销）
+#define PARALLAX_FPS 30
+// 倾斜到该角度（弧度，约17°）时各图层达到其最大位移，超出部分截断
+#define PARALLAX_MAX_TILT 0.3f
+// 姿态低通滤波：每帧新值所占比例
+#define PARALLAX_SMOOTH 0.35f
+// 位移滞回（像素）：计算位移与当前位移相差超过该值才移动，避免姿态噪声使图层在两个位置间来回跳
+#define PARALLAX_HYSTERESIS 0.75f
+// 合成条带缓冲（像素数，DMA内存），每个脏矩形按条带逐段合成并写屏
+#define PARALLAX_BAND_PX (LV_HOR_RES_MAX * 16)
+// 每帧最多记录的脏矩形数，超出时并入最后一个
+#define PARALLAX_DIRTY_MAX 8
+// 场景描述文件中资源名的最大长度
+#define PARALLAX_NAME_MAX 24
+
+/**
+ * 图层定义
+ * img:   LV_IMG_CF_TRUE_COLOR（不透明）或LV_IMG_CF_TRUE_COLOR_ALPHA（RGB565 + 8位alpha），
+ *        通常来自flash资源包，数据在场景运行期间须保持有效
+ * x/y:   设备处于初始姿态时图层左上角的屏幕坐标
+ * depth: 倾斜PARALLAX_MAX_TILT时的位移（像素）；远景取小值（0为不动），近景取大值，负值反向移动
+ * 会移动的背景应比屏幕大出2*depth，否则边缘露出底色
+ */
+struct ParallaxLayer
+{
+	const lv_img_dsc_t* img;
+	int16_t x;
+	int16_t y;
+	int16_t depth;
+};
+
+/**
+ * 统计信息
+ */
+struct ParallaxStats
+{
+	uint32_t frames;       // 有重绘的帧数
+	uint32_t idle;         // 姿态未变、跳过重绘的帧数
+	uint32_t pixels;       // 最近一帧写屏的像素数
+	uint32_t frame_us;     // 最近一帧合成与写屏耗时
+	uint32_t max_us;
+};
+
+/**
+ * IMU视差场景
+ * 2~4个图层由远到近叠放，DMP姿态（orientation）的横滚/俯仰驱动各图层按depth平移，
+ * 形成随视角变化的深度感。
+ *
+ * 渲染不经过LVGL对象：每帧比较各图层的新旧位置，只把移动图层的旧区域与新区域记为脏矩形，
+ * 在条带缓冲中由下到上合成（被不透明图层完全覆盖的下层跳过），经Display::pushRect直接写屏。
+ * 静止时没有脏矩形，不占用SPI总线。
+ *
+ * 注意事项：
+ * - start()/stop()会切换LVGL屏幕并创建lv_task，需在LVGL任务中调用
+ * - 运行期间载入一个空白屏幕，避免LVGL重绘覆盖合成画面；stop()恢复原屏幕
+ * - 姿态来自DMP模式（IMU_MODE_DMP，DMP不可用时为软件融合IMU_MODE_FUSION），没有IMU时各图层保持初始位置
+ */
+class ParallaxScene
+{
+private:
+	struct Layer
+	{
+		ParallaxLayer def;
+		bool alpha;
+		int16_t ox;            // 当前位移
+		int16_t oy;
+		lv_area_t area;        // 当前所在区域（屏幕坐标，未裁剪）
+	};
+
+	Display* display;
+	Layer layers[PARALLAX_MAX_LAYERS];
+	uint8_t layer_count;
+	uint16_t bg;               // 底色，本机字节序RGB565
+	lv_area_t view;
+	lv_area_t dirty[PARALLAX_DIRTY_MAX];
+	uint8_t dirty_count;
+	uint16_t* band;
+
+	bool running;
+	bool full;                 // 下一帧整屏重绘
+	bool has_zero;
+	float zero_roll;
+	float zero_pitch;
+	float tilt_x;              // 滤波后的倾角（弧度）
+	float tilt_y;
+
+	lv_task_t* frame_task;
+	lv_obj_t* screen;
+	lv_obj_t* prev_screen;
+	ParallaxStats stats;
+
+	bool addLayer(const ParallaxLayer& def);
+	void updateTilt();
+	bool move(Layer* l);
+	void markDirty(const lv_area_t* a);
+	void compose(const lv_area_t* a);
+	void composeBand(const lv_area_t* a);
+
+	static void frameCb(lv_task_t* task);
+
+public:
+	ParallaxScene();
+
+	void setDisplay(Display* disp);
+	bool open(const ParallaxLayer* defs, uint8_t count, lv_color_t bg_color = LV_COLOR_BLACK);
+	bool load(const char* path);
+	bool start();
+	void stop();
+	void close();
+
+	void recenter();
+	bool isRunning();
+	void getStats(ParallaxStats* out);
+};
+
+#endif
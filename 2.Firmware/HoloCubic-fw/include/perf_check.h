@@ -0,0 +1,94 @@
+#ifndef PERF_CHECK_H
+#define PERF_CHECK_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+
+// 1：启动后运行一次性能回归检查（结果写入SD卡/bench/perf.json，串口输出PERF,...）
+#ifndef PERF_CHECK_ON_BOOT
+#define PERF_CHECK_ON_BOOT 0
+#endif
+
+#define PERF_DIR "/bench"
+#define PERF_REPORT_PATH "/bench/perf.json"
+// 基线：不存在时以本次结果建立；确认性能变化是预期的之后删除该文件或以update=true运行以更新
+#define PERF_BASELINE_PATH "/bench/perf_base.json"
+// 手势回放使用的轨迹（imu_trace录制，带标注），不存在时跳过手势项
+#define PERF_GESTURE_TRACE "/bench/gesture.imt"
+// SD读取测试文件（首次运行时写入）与读取块大小
+#define PERF_SD_FILE "/bench/perf.tmp"
+#define PERF_SD_FILE_SIZE (256U * 1024U)
+#define PERF_SD_CHUNK (16U * 1024U)
+// 每项重复的轮数，取最好的一轮（排除中断、缓存未命中等偶发干扰）
+#define PERF_ROUNDS 3
+// 默认容差（百分比），单项可在表中另设
+#define PERF_TOLERANCE_PCT 10
+
+/**
+ * 一项的检查结果
+ */
+enum PerfStatus
+{
+	PERF_PASS = 0,     // 在基线的容差范围内（或更好）
+	PERF_REGRESS,      // 比基线差超过容差
+	PERF_NEW,          // 基线中没有该项
+	PERF_SKIP          // 无法运行（没有SD卡、没有轨迹、内存不足）
+};
+
+struct PerfResult
+{
+	const char* name;
+	const char* unit;
+	float value;
+	float baseline;        // 没有基线时为0
+	PerfStatus status;
+};
+
+/**
+ * 性能回归检查（设备端）
+ *
+ * 把几条热路径各自单独计时，与SD卡上保存的基线比较，超出容差的项报告为回归：
+ *   - ESP32混合内核：填充、复制交换、半透明混合（240x10条带）
+ *   - 图像解码器read_line（4位索引色，逐行解码）
+ *   - SD卡顺序读取吞吐
+ *   - 整屏刷新帧率（真实的绘制与ST7789刷新路径）
+ *   - 手势识别：回放带标注的IMU轨迹，平均识别延迟、漏检数与每个样本的处理时间
+ *   - lv_task调度开销（没有任务就绪时的一次lv_task_handler）
+ * 各项取PERF_ROUNDS轮中最好的一轮。结果写入PERF_REPORT_PATH，可用HoloLink的bench命令拉取。
+ * 基线随固件与硬件而定（CPU频率、SD卡、面板时钟），应在同一台设备上建立与比较。
+ *
+ * 注意事项：
+ * - 在LVGL任务中且不在lv_task_handler内调用（如runtime.post的回调），运行期间界面停止响应约数秒
+ * - 刷新测试会整屏重绘当前屏幕
+ */
+class PerfCheck
+{
+private:
+	PerfResult* results;
+	uint8_t count;
+
+	void add(const char* name, const char* unit, float value);
+	void skip(const char* name, const char* unit, const char* reason);
+	void benchKernels();
+	void benchDecoder();
+	void benchSd();
+	void benchFlush();
+	void benchGesture();
+	void benchScheduler();
+	bool compare(const char* path);
+	bool writeReport(const char* path, bool baseline);
+
+public:
+	PerfCheck();
+	/**
+	 * 运行全部项并与基线比较
+	 * @param update 以本次结果覆盖基线
+	 * @return 没有回归时返回true（首次建立基线时也为true）
+	 */
+	bool run(bool update = false);
+	uint8_t getResults(const PerfResult** out);
+};
+
+extern PerfCheck perfcheck;
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef PHOTO_ALBUM_H
+#define PHOTO_ALBUM_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "lvgl.h"
+#include "app_manager.h"
+#include "jpeg_decoder.h"
+#include "tile_image.h"
+#include "imu.h"
+
+// 照片目录（JPEG、真彩色LVGL .bin与.htl分块大图），缩略图与索引放在其下的隐藏目录
+#define ALBUM_ROOT "/Photos"
+#define ALBUM_CACHE_DIR ALBUM_ROOT "/.thumbs"
+#define ALBUM_INDEX_FILE ALBUM_CACHE_DIR "/index.bin"
+#define ALBUM_INDEX_TMP_FILE ALBUM_CACHE_DIR "/index.tmp"
+#define ALBUM_INDEX_MAGIC "AIDX"
+#define ALBUM_INDEX_VERSION 1
+// 文件名最大长度，更长的照片不会被索引
+#define ALBUM_NAME_MAX 40
+#define ALBUM_PATH_MAX (sizeof(ALBUM_CACHE_DIR) + ALBUM_NAME_MAX + 4)
+// 重建时读入内存比较的旧条目数上限（每条52字节，超出部分按新照片重新读取）
+#define ALBUM_INDEX_CACHE_MAX 256
+
+// 缩略图最长边（像素）；预览时放大到全屏，约7KB，翻页时从SD卡读取只需几毫秒
+#define ALBUM_THUMB_MAX 60
+// 当前照片前后各预读的缩略图数
+#define ALBUM_THUMB_AHEAD 1
+// 翻页后停留多久才解码完整图像（连续翻页时只显示缩略图）
+#define ALBUM_FULL_DELAY_MS 150
+// 完整图像缓冲数：1张显示中，其余用于按倾斜方向预解码下一张（无PSRAM时内存不足则自动减少）
+#define ALBUM_FULL_BUFS 2
+// Y轴加速度超过该值（原始值，约0.06g，低于翻页手势阈值3000）视为正在向该方向倾斜
+#define ALBUM_LEAN_AY 1000
+
+#define ALBUM_TASK_CORE 0
+#define ALBUM_TASK_PRIORITY 1
+#define ALBUM_TASK_STACK 4096
+
+// AlbumIndexEntry.format
+#define ALBUM_FORMAT_JPEG 0
+#define ALBUM_FORMAT_BIN 1
+#define ALBUM_FORMAT_TILED 2
+
+#pragma pack(push, 1)
+
+/**
+ * 索引文件布局与场景索引相同：[AlbumIndexHeader][AlbumIndexEntry * count]，按目录遍历顺序
+ */
+struct AlbumIndexHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	uint16_t entry_size;
+	uint16_t reserved;
+	uint32_t count;
+};
+
+struct AlbumIndexEntry
+{
+	char name[ALBUM_NAME_MAX];  // 以0结尾
+	uint32_t mtime;             // 修改时间不变时沿用条目与缩略图
+	uint16_t width;
+	uint16_t height;
+	uint8_t format;             // ALBUM_FORMAT_x
+	uint8_t levels;             // 分块大图的金字塔级数，其他格式为0
+	uint8_t reserved[2];
+};
+
+#pragma pack(pop)
+
+/**
+ * 一张完整图像（真彩色，最大为屏幕大小）
+ * state只在持有album_mux时修改：空闲 -> 解码中（后台任务） -> 就绪 -> 显示中（LVGL任务） -> 空闲
+ */
+struct AlbumFrame
+{
+	uint8_t* buf;
+	lv_img_dsc_t dsc;
+	int32_t idx;
+	volatile uint8_t state;
+};
+
+/**
+ * 缩略图槽（只在LVGL任务中访问）
+ */
+struct AlbumThumb
+{
+	uint8_t* buf;
+	lv_img_dsc_t dsc;
+	int32_t idx;
+};
+
+/**
+ * 相册
+ *
+ * 翻页（左右倾斜）先显示缓存的缩略图（放大到全屏），停留ALBUM_FULL_DELAY_MS后由后台任务
+ * 解码完整图像（JPEG按tjpgd缩放到不超过屏幕），完成后替换缩略图；
+ * 空闲时按IMU的倾斜方向（没有倾斜时按上次翻页方向）预解码下一张，
+ * 前后各ALBUM_THUMB_AHEAD张缩略图常驻内存，翻页本身不读取SD卡。
+ *
+ * 进入相册时后台任务增量更新索引（与场景索引相同：修改时间不变的照片沿用旧条目），
+ * 之后为缺少缩略图的照片生成缩略图（JPEG按1/8~1/1缩小解码，.bin按行抽样），
+ * 有翻页请求时优先解码当前照片。
+ *
+ * 完整图像缓冲分配失败时（无PSRAM且片内内存不足），完整图像改由LVGL的S:解码器在刷新时解码
+ *
+ * .htl分块大图（全景图等，见tile_format.h）的缩略图与完整图像取金字塔最后一级（总览）；
+ * 总览时按下进入查看器（TileViewer，从倒数第二级开始，借用显示中的帧缓冲作视口），
+ * 倾斜平移，再按下放大一级，在第0级按下回到总览；查看时左右翻页不起作用
+ * 所有接口必须在LVGL任务中调用
+ */
+class PhotoAlbum
+{
+private:
+	lv_obj_t* scr;
+	lv_obj_t* prev_scr;
+	lv_obj_t* img;
+	lv_obj_t* status;
+	lv_group_t* group;
+	lv_group_t* prev_group;
+	lv_task_t* full_task;
+	lv_task_t* thumb_task;
+	IMU* imu;
+
+	uint32_t count;
+	volatile int32_t cur;       // 当前照片（后台任务只读，用于选择预解码方向）
+	volatile int8_t last_dir;
+	uint8_t frame_count;
+	AlbumFrame frames[ALBUM_FULL_BUFS];
+	AlbumThumb thumbs[2 * ALBUM_THUMB_AHEAD + 1];
+	AlbumFrame* shown;
+	TileViewer viewer;
+	char lv_path[ALBUM_PATH_MAX + 4];
+
+	TaskHandle_t worker;
+	SemaphoreHandle_t done;
+	volatile bool stopping;
+	volatile int32_t want;      // 需要完整图像的照片（-1为无）；解码其他照片时发现变化即中止
+
+	// 后台任务
+	uint32_t total;             // 后台任务的照片数（LVGL任务的count在收到重建通知后才更新）
+	JpegDecoder jpeg;
+	TileImage tiles;
+	File src_file;
+	uint8_t* thumb_buf;
+	uint16_t out_w;
+	uint16_t out_h;
+	uint8_t out_step;
+	AlbumFrame* decode_frame;
+	int32_t decode_idx;
+
+	uint32_t readCount();
+	bool getEntry(uint32_t i, AlbumIndexEntry* e);
+	static int32_t wrap(int32_t i, uint32_t n);
+	void show(int32_t i);
+	void showFull(AlbumFrame* f);
+	void releaseShown();
+	AlbumThumb* findThumb(int32_t i);
+	AlbumThumb* loadThumb(int32_t i);
+	void prefetchThumbs();
+	void setStatus(const char* text);
+	int8_t leanDir();
+	bool enterViewer();
+	void exitViewer();
+
+	void buildIndex();
+	void makeThumbs();
+	bool makeThumb(const AlbumIndexEntry* e);
+	bool decodeFull(AlbumFrame* f, int32_t i);
+	bool decodeJpeg(const char* path, uint8_t scale, jpeg_band_cb_t cb);
+	bool decodeTiled(const char* path, lv_color_t* dst, uint16_t max_w, uint16_t max_h, tile_abort_cb_t abort_cb);
+	bool hasFrame(int32_t i);
+	AlbumFrame* takeFrame();
+	void serve();
+	bool probe(File& f, const char* name, AlbumIndexEntry* e);
+	static void photoPath(char* out, const char* name);
+	static void thumbPath(char* out, const char* name);
+	static uint8_t fitScale(uint16_t w, uint16_t h, uint16_t max_w, uint16_t max_h);
+	static uint32_t jpegRead(void* user, uint8_t* buf, uint32_t len);
+	static bool thumbBand(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px);
+	static bool frameBand(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px);
+	static bool thumbAbort(void* user);
+	static bool frameAbort(void* user);
+	static void workerEntry(void* arg);
+	static void keyCb(lv_obj_t* obj, lv_event_t event);
+	static void fullTaskCb(lv_task_t* t);
+	static void thumbTaskCb(lv_task_t* t);
+	static void onFrameReady(const struct UiMsg* msg);
+	static void onThumbReady(const struct UiMsg* msg);
+	static void onIndexReady(const struct UiMsg* msg);
+
+public:
+	PhotoAlbum();
+	void setImu(IMU* sensor);
+	bool start();
+	void stop();
+	bool isRunning();
+};
+
+extern PhotoAlbum album;
+// 以应用形式运行（apps.open(apps.add(album_app))），离开前台时停止
+extern const App album_app;
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <sdkconfig.h>
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
+#include "backlight.h"
+#include "ambient.h"
+#include "imu.h"
+
+// 动态调频范围：最低频率保持80MHz，APB时钟不变，SPI/I2C/UART的分频无需调整
+#define POWER_CPU_MAX_MHZ 240
+#define POWER_CPU_MIN_MHZ 80
+// 1：空闲时自动浅睡眠（需要sdkconfig开启CONFIG_FREERTOS_USE_TICKLESS_IDLE，否则退回仅调频）
+#define POWER_LIGHT_SLEEP 1
+
+// 无操作多久后调暗背光、多久后关闭背光进入待机
+#define POWER_DIM_MS 60000
+#define POWER_STANDBY_MS 300000
+// 调暗时的背光亮度
+#define POWER_DIM_DUTY 0.03f
+// 状态检查与运动检测周期
+#define POWER_CHECK_MS 200
+// 两次检查之间任一轴加速度变化超过该值视为拿起/移动（原始值，±2g量程下约0.1g）
+#define POWER_MOTION_DELTA 1600
+// 照度相对进入调暗时变化超过该值视为有人开灯/关灯
+#define POWER_LUX_DELTA 50
+
+/**
+ * 电源状态
+ * POWER_ACTIVE:  正常亮度
+ * POWER_DIM:     背光调暗，界面照常刷新
+ * POWER_STANDBY: 背光关闭，界面降到最低刷新频率，允许自动浅睡眠
+ */
+enum PowerState
+{
+	POWER_ACTIVE = 0,
+	POWER_DIM,
+	POWER_STANDBY
+};
+
+/**
+ * 电源管理
+ * esp_pm动态调频：LVGL任务处理期间持有CPU最高频率锁，休眠等待时释放，空闲时降到80MHz；
+ * 背光点亮期间持有禁止浅睡眠锁（LEDC在浅睡眠中停止输出），待机后释放，帧间与采样间隙自动浅睡眠；
+ * 编码器/手势事件、IMU检测到移动、环境光明显变化时调用activity()回到正常状态；
+ * 待机期间IMU停止读取，由片上运动检测唤醒（连接INT引脚时从移动到恢复亮度不超过约30ms）
+ */
+class PowerManager
+{
+private:
+	Backlight* backlight;
+	Ambient* ambient;
+	IMU* imu;
+	esp_timer_handle_t timer;
+	SemaphoreHandle_t mutex;
+#if CONFIG_PM_ENABLE
+	esp_pm_lock_handle_t cpu_lock;
+	esp_pm_lock_handle_t sleep_lock;
+#endif
+	bool pm_enabled;
+
+	volatile PowerState state;
+	volatile uint32_t last_activity;
+	bool saved_auto;
+	float saved_duty;
+	int16_t last_accel[3];
+	unsigned int ref_lux;
+
+	bool configure(bool light_sleep);
+	void enterDim();
+	void enterStandby();
+	void exitIdle();
+	bool checkMotion();
+	bool checkLux();
+	void check();
+	static void timerCb(void* arg);
+	static void onMotion(void* arg);
+
+public:
+	bool begin(Backlight* bl, Ambient* amb, IMU* sensor);
+	void activity();
+	void busyBegin();
+	void busyEnd();
+	PowerState getState();
+};
+
+extern PowerManager power;
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef PREMUL_DECODER_H
+#define PREMUL_DECODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lvgl.h>
+
+// 数据开头的标识（紧跟4字节lv_img_header_t，图像头的cf为LV_IMG_CF_RAW_ALPHA）
+#define PREMUL_MAGIC "PMA8"
+#define PREMUL_MAGIC_SIZE 4
+// 片段头：高2位为类型，低14位为像素数（1~16383）
+#define PREMUL_SPAN_SKIP 0       // 全透明，跳过
+#define PREMUL_SPAN_COPY 1       // 不透明：len个lv_color_t，直接复制
+#define PREMUL_SPAN_BLEND 2      // 半透明：len个预乘lv_color_t + len个alpha（补齐到偶数字节）
+#define PREMUL_SPAN_TYPE(head) ((head) >> 14)
+#define PREMUL_SPAN_LEN(head) ((head) & 0x3FFF)
+
+/**
+ * 预乘alpha图像（RGB565 + A8）：界面叠加层、图标等带透明边缘的素材（编码端见HoloPack --cf premul_alpha）
+ *
+ * 数据布局（lv_img_dsc_t.data，16位对齐）：
+ *   [PREMUL_MAGIC][行偏移 u32 * h（相对data开头）][各行片段...]
+ * 每行由若干片段组成，像素数之和等于图像宽度；片段头为u16，随后是片段的像素（按lv_color_t内存布局，
+ * LV_COLOR_16_SWAP时为面板字节序）。半透明像素的颜色已乘以alpha（各分量为floor(c * a / 255)），
+ * 混合时每像素只需对目标乘一次权重：dst = src + dst * (255 - a) / 256。
+ *
+ * 行偏移与片段起到跳表的作用：全透明的部分整段跳过、不透明的部分整段复制，
+ * 只有抗锯齿边缘等半透明像素参与运算；叠加在逐帧刷新的动画上时，每帧的开销与半透明像素数成正比。
+ *
+ * 绘制：premul_decoder_draw为lv_draw_img.c的钩子（LV_USE_PREMUL_DRAW），无缩放/旋转/重新着色、
+ * 没有其他遮罩时直接从片段混合到绘制缓冲（大图按行拆分到两个核心，见draw_split.h）；
+ * 有遮罩或重新着色时由解码器的read_line还原为LV_IMG_CF_TRUE_COLOR_ALPHA逐行交给LVGL，速度较慢。
+ * 与其他逐行解码的图像相同，LVGL不对其缩放/旋转（需要时使用TRUE_COLOR_ALPHA素材）
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	// 是否为预乘alpha的内存图像（cf为LV_IMG_CF_RAW_ALPHA且数据以PREMUL_MAGIC开头）
+	bool premul_is_image(const lv_img_dsc_t* img);
+
+	/**
+	 * 在clip_area内绘制图像（LVGL绘制时调用）
+	 * @param src 图像源（lv_img_dsc_t*），不是预乘alpha图像时返回false
+	 * @return 已绘制返回true；条件不满足返回false，由LVGL按解码器的输出绘制
+	 */
+	bool premul_decoder_draw(const void* src, const lv_area_t* coords, const lv_area_t* clip_area,
+							 const lv_draw_img_dsc_t* draw_dsc);
+
+	/**
+	 * 注册预乘alpha图像解码器（需在lv_init之后调用）
+	 * 打开时报告为LV_IMG_CF_TRUE_COLOR_ALPHA，read_line把预乘颜色还原后逐行输出
+	 */
+	void premul_decoder_lv_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef PRIM_BENCH_H
+#define PRIM_BENCH_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <esp_partition.h>
+#include "lvgl.h"
+#include "display.h"
+
+// 1：启动后运行一次绘制原语微基准（构建配置env:pico32_primbench），结果输出到串口并追加到SD卡CSV
+#ifndef PRIM_BENCH_ON_BOOT
+#define PRIM_BENCH_ON_BOOT 0
+#endif
+// 构建标识（CSV第一列），比较不同构建时在build_flags中另设，如-DPRIM_BENCH_BUILD_ID=\"iram\"
+#ifndef PRIM_BENCH_BUILD_ID
+#define PRIM_BENCH_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+// 每组参数冷、热缓存各计时的次数，报告最小值与中位数
+#define PRIM_BENCH_ITERS 15
+// 画布（片内内存）：绘制原语的输出目标，代替显示缓冲区（默认只有10行）
+#define PRIM_BENCH_CANVAS_W LV_HOR_RES_MAX
+#define PRIM_BENCH_CANVAS_H 64
+// 测试图像（真彩色，运行时生成）
+#define PRIM_BENCH_IMG_SIZE 64
+// 冷缓存：计时前按缓存行顺序读取的flash映射数据量（ESP32每核32KB缓存，取指与flash/PSRAM数据共用）
+#define PRIM_BENCH_EVICT_BYTES (64U * 1024U)
+#define PRIM_BENCH_CACHE_LINE 32
+
+#define PRIM_BENCH_DIR "/bench"
+#define PRIM_BENCH_CSV_PATH "/bench/prims.csv"
+
+struct PrimCase;
+typedef void (*prim_bench_fn_t)(const PrimCase* c);
+
+/**
+ * 绘制原语的周期级微基准（设备端）
+ *
+ * 单独调用各绘制原语并用CCOUNT（xthal_get_ccount）计周期：
+ *   _lv_blend_fill / _lv_blend_map：尺寸 x 不透明度
+ *   lv_draw_label：字体 x 文字长度
+ *   lv_draw_rect：尺寸 x 圆角 x 阴影宽度
+ *   lv_draw_img：缩放 x 抗锯齿
+ *   flush_cb（Display的刷新回调，含DMA/队列发送完成）：区域尺寸
+ * 每组参数先热缓存（预热一次后连续调用），再冷缓存（每次调用前读取PRIM_BENCH_EVICT_BYTES的flash映射，
+ * 把代码与常量挤出缓存，图像另外使LVGL的图像缓存失效）各计时PRIM_BENCH_ITERS次。
+ *
+ * 输出：
+ *   串口 PRIMBENCH,原语,参数,单位数,cold/warm,最小周期,中位周期,每单位周期
+ *   SD卡 PRIM_BENCH_CSV_PATH（追加，每行带构建标识、LVGL版本与CPU频率，不同构建与库版本的结果可直接对比）
+ *
+ * 注意事项：
+ * - 在LVGL任务中且不在lv_task_handler内调用（如runtime.post的回调），运行期间界面停止响应约数秒
+ * - 计时区间内的中断与任务切换一并计入，比较时以最小值为准，中位数反映实际运行中的波动
+ * - 绘制期间临时把显示缓冲区换成画布，刷新测试直接写屏，结束后整屏重绘
+ */
+class PrimBench
+{
+private:
+	Display* screen;
+	lv_disp_t* disp;
+	lv_disp_buf_t* vdb;
+	lv_color_t* canvas;
+	lv_color_t* img_buf;
+	const uint8_t* evict_src;
+	spi_flash_mmap_handle_t evict_map;
+	File csv;
+	uint16_t rows;
+
+	void beginCanvas(void** saved_buf, lv_area_t* saved_area, lv_disp_t** saved_refr);
+	void endCanvas(void* saved_buf, const lv_area_t* saved_area, lv_disp_t* saved_refr);
+	void evict();
+	void measure(const PrimCase* c, prim_bench_fn_t fn);
+	void emit(const PrimCase* c, const char* cache, uint32_t* cycles);
+	void runBlend();
+	void runLabel();
+	void runRect();
+	void runImg();
+	void runFlush();
+
+public:
+	PrimBench();
+	/**
+	 * 运行全部原语
+	 * @return 画布或测试图像内存不足时返回false（没有SD卡时只输出到串口）
+	 */
+	bool run(Display* display);
+};
+
+extern PrimBench primbench;
+
+#endif
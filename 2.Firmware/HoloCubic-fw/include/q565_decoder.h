@@ -0,0 +1,65 @@
+#ifndef Q565_DECODER_H
+#define Q565_DECODER_H
+
+#include <stdint.h>
+#include <lvgl.h>
+
+// 压缩数据开头的标识（紧跟4字节lv_img_header_t，图像头的cf为LV_IMG_CF_RAW）
+#define Q565_MAGIC "Q565"
+#define Q565_MAGIC_SIZE 4
+// 最近颜色表大小（与编码端一致，不能修改）
+#define Q565_INDEX_SIZE 64
+
+/**
+ * Q565：按RGB565设计的QOI风格逐像素压缩（编码端见HoloPack与ImageToHolo/convertor/holo.py）
+ *
+ * 像素按行优先连续编码，预测基于上一个像素prev（初始为黑色0x0000）与最近颜色表index[64]
+ * （初始全0，键为(r * 3 + g * 5 + b * 7) & 63，r/g/b为565各分量）。每个操作码：
+ *   00iiiiii           INDEX：prev = index[i]
+ *   01rrggbb           DIFF：r/g/b各加(-2~1)（偏置2）
+ *   10gggggg rrrrbbbb  LUMA：g加dg(-32~31，偏置32)，r/b加dg/2（向下取整）再加(-8~7，偏置8)
+ *   11nnnnnn           RUN：重复prev n+1次（n为0~61）
+ *   11111110 lo hi     RGB：prev为随后的16位小端RGB565
+ *   11111111 lo hi     LONGRUN：重复prev (随后的16位小端值 + 1)次
+ * 分量加减按5/6位回绕；INDEX/DIFF/LUMA/RGB之后把prev写入index，RUN不写（prev已在表中）。
+ * LUMA按绿色6位、红蓝5位的比例预测：亮度变化时红蓝的变化约为绿色的一半。
+ *
+ * 全息素材大面积为黑色，整行黑色只需一个LONGRUN；解码每像素只有一次查表与几次移位，
+ * 240x240的帧在ESP32上约几毫秒，远快于从SD卡读取115KB的原始帧
+ */
+struct Q565State
+{
+	const uint8_t* src;
+	const uint8_t* end;
+	uint32_t run;          // 未输出完的重复次数
+	uint16_t prev;         // 本机RGB565（不交换字节）
+	uint16_t index[Q565_INDEX_SIZE];
+};
+
+/**
+ * 是否为Q565压缩的内存图像（图像头cf为LV_IMG_CF_RAW且数据以Q565_MAGIC开头）
+ */
+bool q565_is_image(const lv_img_dsc_t* img);
+
+/**
+ * 从压缩数据开头开始解码
+ * @param data 包括Q565_MAGIC的压缩数据（lv_img_dsc_t.data）
+ * @return 标识不符时返回false
+ */
+bool q565_begin(Q565State* st, const uint8_t* data, uint32_t len);
+
+/**
+ * 顺序解码n个像素，按lv_color_t的内存布局写出（LV_COLOR_16_SWAP时为面板字节序）
+ * 运行在IRAM中，可在条带回调与read_line中直接写入目标缓冲
+ * @return 实际写出的像素数，数据截断时小于n
+ */
+uint32_t q565_decode(Q565State* st, lv_color_t* out, uint32_t n);
+
+/**
+ * 注册Q565图像解码器（需在lv_init之后调用）
+ * 接管Q565压缩的内存图像，read_line按顺序从压缩数据解码到LVGL绘制缓冲；
+ * 行号回退（同一帧重绘上方区域）时从头重新解码
+ */
+void q565_decoder_lv_init();
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef QUALITY_GOV_H
+#define QUALITY_GOV_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+#include "display.h"
+#include "rgb_led.h"
+
+// 1：启动后按帧时间自动调整画质
+#ifndef QUALITY_ON_BOOT
+#define QUALITY_ON_BOOT 0
+#endif
+
+// 评估窗口：每QUALITY_PERIOD_MS取一次渲染计时的累计值，按窗口内的平均帧时间决定升降
+#define QUALITY_PERIOD_MS 500
+// 默认帧预算（刷新任务一次的总耗时，微秒），超出时帧率低于刷新周期决定的帧率
+#define QUALITY_BUDGET_US (LV_DISP_DEF_REFR_PERIOD * 1000)
+// 连续QUALITY_DEGRADE_WINDOWS个窗口超出预算时降一级；
+// 连续QUALITY_RESTORE_WINDOWS个窗口低于预算的QUALITY_RESTORE_PCT%时升一级（两者不同，避免在边界来回切换）
+#define QUALITY_DEGRADE_WINDOWS 2
+#define QUALITY_RESTORE_WINDOWS 6
+#define QUALITY_RESTORE_PCT 60
+// 窗口内帧数少于该值时视为空闲（静止界面，计入余量）
+#define QUALITY_MIN_FRAMES 3
+// 最低一级时LED节拍的分频（100Hz -> 25Hz）
+#define QUALITY_LED_DIV 4
+// 画质变化通知的回调数
+#define QUALITY_LISTENERS 4
+
+/**
+ * 画质级别（逐级累加：每一级包含前面各级的降级）
+ */
+enum QualityLevel
+{
+	QUALITY_FULL = 0,      // 全部效果
+	QUALITY_NO_SHADOW,     // 关闭阴影（lv_draw_rect不画阴影）
+	QUALITY_NO_AA,         // 关闭抗锯齿（显示驱动的antialiasing，圆角、线条、文字边缘不混合）
+	QUALITY_LOW_RES,       // 资源取低一级的缩略图（getMipBias() = 1）
+	QUALITY_LED_SLOW,      // LED刷新率降为1/QUALITY_LED_DIV
+	QUALITY_LEVEL_CNT
+};
+
+// 画质变化回调（LVGL任务中调用），各模块据此替换自己的资源
+typedef void (*quality_cb_t)(QualityLevel level);
+
+/**
+ * 帧预算与画质调节
+ *
+ * 定期读取渲染计时（render_prof）的帧数与FRAME累计耗时，求窗口内的平均帧时间：
+ * - 超出预算时逐级关闭开销大的效果：阴影 -> 抗锯齿 -> 低分辨率资源 -> LED刷新率
+ * - 余量恢复后逐级恢复；级别变化后整屏重绘一次，该窗口不参与评估（避免重绘本身引起再次降级）
+ * 负载变化时帧率保持稳定，代价是画质暂时降低。
+ *
+ * 注意事项：
+ * - 所有接口必须在LVGL任务中调用
+ * - 启用时同时启用渲染计时；LVGL基准测试等关闭渲染计时期间暂停评估
+ * - 低分辨率资源由各模块按getMipBias()选择（SceneIndex::readThumb已按此跳过较大的级）
+ */
+class QualityGovernor
+{
+private:
+	Display* screen;
+	Pixel* led;
+	lv_task_t* task;
+	uint32_t budget_us;
+	uint8_t level;
+	uint8_t max_level;
+	uint8_t over;
+	uint8_t under;
+	bool settle;               // 级别刚变化：下一个窗口不评估
+	uint32_t last_frames;
+	uint32_t last_frame_us;
+	uint32_t avg_us;
+	uint32_t changes;
+	quality_cb_t listeners[QUALITY_LISTENERS];
+	uint8_t listener_count;
+
+	void apply(uint8_t lv);
+	void evaluate();
+	static void taskCb(lv_task_t* t);
+
+public:
+	QualityGovernor();
+	bool begin(Display* display, Pixel* rgb = NULL);
+	// 停止调节并恢复全部效果
+	void end();
+
+	void setBudget(uint32_t us);
+	// 最多降到该级（如不允许关闭抗锯齿时设为QUALITY_NO_SHADOW）
+	void setMaxLevel(QualityLevel lv);
+	// 手动设置级别（自动调节期间会被后续评估改变）
+	void setLevel(QualityLevel lv);
+	QualityLevel getLevel();
+	// 资源应跳过的缩略图级数（0为原始尺寸）
+	uint8_t getMipBias();
+	bool addListener(quality_cb_t cb);
+
+	uint32_t getAvgFrameUs();
+	uint32_t getChanges();
+};
+
+extern QualityGovernor quality;
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef REMOTE_DISPLAY_H
+#define REMOTE_DISPLAY_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "display.h"
+#include "jpeg_decoder.h"
+
+#define REMOTE_DISPLAY_PORT 7000
+// 接收任务（与LVGL任务分处不同核心）
+#define REMOTE_TASK_CORE 0
+#define REMOTE_TASK_PRIORITY 2
+#define REMOTE_TASK_STACK 3072
+// 数据包缓冲池：包长不超过以太网MTU内的单个UDP载荷，按DMA内存分配，分块可直接写屏
+#define REMOTE_PKT_SIZE 1472
+#define REMOTE_PKT_POOL 24
+// 抖动缓冲：最多同时组装的帧数，完整帧至少等待REMOTE_JITTER_MS再显示（有更新的完整帧时立即显示）
+#define REMOTE_JITTER_DEPTH 3
+#define REMOTE_JITTER_MS 20
+// 帧超时：分块帧显示已收到的分块，JPEG帧丢弃
+#define REMOTE_FRAME_TIMEOUT_MS 100
+// 单帧最多包数（须小于缓冲池大小）
+#define REMOTE_FRAME_PKTS 16
+// JPEG帧重组缓冲（首次收到JPEG帧时分配）
+#define REMOTE_JPEG_MAX (REMOTE_FRAME_PKTS * (REMOTE_PKT_SIZE - sizeof(RemotePacketHeader)))
+// 显示任务周期
+#define REMOTE_PRESENT_PERIOD_MS 5
+// RLE分块展开时的行缓冲（像素数）
+#define REMOTE_RLE_BUF_PX (LV_HOR_RES_MAX * 8)
+
+#define REMOTE_MAGIC0 'H'
+#define REMOTE_MAGIC1 'R'
+
+// RemotePacketHeader.type
+#define REMOTE_TILE_RAW 0      // 载荷为w*h个RGB565像素（小端）
+#define REMOTE_TILE_RLE 1      // 载荷为(uint16_t 重复次数, uint16_t RGB565)对，按行优先展开为w*h
+#define REMOTE_JPEG 2          // 载荷为一幅基线JPEG的一个分片，x/y为图像左上角
+
+// RemotePacketHeader.flags
+#define REMOTE_FLAG_END 0x01   // 本帧最后一个包（据此得出本帧包数 = seq + 1）
+
+#pragma pack(push, 1)
+
+/**
+ * UDP包头（小端，16字节，载荷随后，2字节对齐）
+ * 一帧由若干个包组成：分块帧每个包是一个独立的脏矩形，JPEG帧按seq顺序拼接
+ * frame为16位递增帧号（回绕按有符号差比较），比已显示帧旧的包直接丢弃
+ */
+struct RemotePacketHeader
+{
+	uint8_t magic[2];
+	uint8_t type;
+	uint8_t flags;
+	uint16_t frame;
+	uint16_t seq;
+	uint16_t x;
+	uint16_t y;
+	uint16_t w;
+	uint16_t h;
+};
+
+#pragma pack(pop)
+
+/**
+ * 统计信息
+ */
+struct RemoteDisplayStats
+{
+	uint32_t frames;       // 已显示帧数
+	uint32_t dropped;      // 丢弃的帧（超时不完整的JPEG帧、被挤出抖动缓冲的帧）
+	uint32_t late;         // 比已显示帧旧而被丢弃的包
+	uint32_t partial;      // 超时后按已收到分块显示的帧
+};
+
+/**
+ * 远程显示模式
+ * PC端通过UDP推送RGB565分块（原始或RLE）或JPEG帧，接收任务把包放入抖动缓冲，
+ * LVGL任务中按帧号顺序取出，经Display::pushRect直接写屏，不经过LVGL对象绘制。
+ * 只有变化的分块需要发送，静态仪表盘的大部分帧只有几个包。
+ *
+ * 注意事项：
+ * - start()/stop()会切换LVGL屏幕并创建lv_task，需在LVGL任务中调用
+ * - 运行期间载入一个空白屏幕，避免LVGL重绘覆盖远程内容；stop()恢复原屏幕
+ */
+class RemoteDisplay
+{
+private:
+	struct Packet
+	{
+		uint8_t* data;
+		uint16_t len;
+	};
+
+	enum SlotState
+	{
+		SLOT_FREE = 0,
+		SLOT_FILLING,
+		SLOT_PRESENTING
+	};
+
+	struct FrameSlot
+	{
+		SlotState state;
+		uint16_t frame;
+		uint8_t type;
+		uint8_t received;
+		uint8_t expected;      // 0表示尚未收到结束包
+		uint32_t first_ms;     // 收到第一个包的时间
+		int8_t pkts[REMOTE_FRAME_PKTS];
+	};
+
+	Display* display;
+	int sock;
+	volatile bool running;
+	TaskHandle_t rx_task;
+	lv_task_t* present_task;
+	lv_obj_t* screen;
+	lv_obj_t* prev_screen;
+
+	Packet pool[REMOTE_PKT_POOL];
+	int8_t free_list[REMOTE_PKT_POOL];
+	uint8_t free_count;
+	FrameSlot slots[REMOTE_JITTER_DEPTH];
+	bool has_shown;
+	uint16_t last_shown;
+	portMUX_TYPE lock;
+
+	JpegDecoder jpeg;
+	uint8_t* jpeg_buf;
+	uint16_t jpeg_x;
+	uint16_t jpeg_y;
+	uint16_t* rle_buf;
+
+	RemoteDisplayStats stats;
+
+	bool allocPool();
+	void freePool();
+	int8_t takePacket();
+	void releaseSlot(FrameSlot* s);
+	FrameSlot* slotFor(const RemotePacketHeader* hdr);
+	void store(int8_t idx);
+	FrameSlot* nextFrame();
+	void present(FrameSlot* s);
+	void presentTile(const RemotePacketHeader* hdr, const uint8_t* payload, uint16_t len);
+	void presentJpeg(FrameSlot* s);
+
+	static void rxEntry(void* arg);
+	static void presentCb(lv_task_t* task);
+	static bool jpegBandCb(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px);
+
+public:
+	RemoteDisplay();
+
+	bool start(Display* disp, uint16_t port = REMOTE_DISPLAY_PORT);
+	void stop();
+	bool isRunning();
+	void getStats(RemoteDisplayStats* out);
+};
+
+#endif
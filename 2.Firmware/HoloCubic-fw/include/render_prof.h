@@ -0,0 +1,80 @@
+#ifndef RENDER_PROF_H
+#define RENDER_PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 环形缓冲区保存的帧数（启用时才分配，每帧40字节）
+#define RENDER_PROF_RING_LEN 64
+// 屏幕叠加层刷新周期
+#define RENDER_PROF_OVERLAY_MS 500
+// 1：启动后立即开始计时并显示叠加层
+#ifndef RENDER_PROF_ON_BOOT
+#define RENDER_PROF_ON_BOOT 0
+#endif
+
+/**
+ * 计时阶段
+ * FRAME:   一次刷新任务的总耗时（有区域需要重绘时）
+ * JOIN:    lv_refr_join_area，合并失效区域
+ * DRAW:    lv_refr_area_part中的绘制（不含刷新）
+ * FLUSH:   lv_refr_vdb_flush，含等待上一条带发送完成与flush_cb
+ * SPI:     Display的刷新回调内部（DMA模式下为等待上次DMA与排队的时间）
+ * INDEV:   编码器读取回调
+ * IMU:     IMU::update（传感器任务，含I2C读取）
+ * AMBIENT: BH1750一次读取从提交到回调的时间（总线任务，含排队）
+ */
+typedef enum
+{
+	RENDER_PROF_FRAME = 0,
+	RENDER_PROF_JOIN,
+	RENDER_PROF_DRAW,
+	RENDER_PROF_FLUSH,
+	RENDER_PROF_SPI,
+	RENDER_PROF_INDEV,
+	RENDER_PROF_IMU,
+	RENDER_PROF_AMBIENT,
+	RENDER_PROF_PHASE_CNT
+} render_prof_phase_t;
+
+/**
+ * 一帧的记录（单位微秒）
+ * 每个阶段为距上一帧记录以来的累计值，同一帧内多次进入（如逐条带绘制）时相加；
+ * INDEV/IMU/AMBIENT不在刷新路径上，记录的是两帧之间发生的总耗时
+ */
+typedef struct
+{
+	uint32_t time_ms;
+	uint32_t px;
+	uint32_t us[RENDER_PROF_PHASE_CNT];
+} render_prof_frame_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	// 计时开始/结束（未启用时各只有一次判断）；同一阶段只能在一个任务中计时
+	void render_prof_begin(render_prof_phase_t phase);
+	void render_prof_end(render_prof_phase_t phase);
+	// 累加一段已测得的耗时（异步完成的操作）
+	void render_prof_add(render_prof_phase_t phase, uint32_t us);
+	// 刷新任务结束时调用，写入一条帧记录
+	void render_prof_frame_end(uint32_t px);
+
+	int64_t render_prof_now(void);
+	bool render_prof_enable(bool en);
+	bool render_prof_is_enabled(void);
+	// 显示/隐藏叠加层（必须在LVGL任务中调用）
+	void render_prof_overlay(bool show);
+	// 以CSV格式从串口输出缓冲区中的全部帧（旧到新），可在任意任务中调用
+	void render_prof_dump(void);
+	// 取最近第n帧（0为最新），没有时返回false
+	bool render_prof_get(uint16_t n, render_prof_frame_t* out);
+	// 取总帧数与各阶段累计耗时（单调递增，取两次求差），可在任意任务中调用
+	uint32_t render_prof_get_totals(uint32_t us[RENDER_PROF_PHASE_CNT]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
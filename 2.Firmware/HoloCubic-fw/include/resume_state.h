@@ -0,0 +1,102 @@
+#ifndef RESUME_STATE_H
+#define RESUME_STATE_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "scene_player.h"
+
+#define RESUME_MAGIC 0x31535248   // "HRS1"
+#define RESUME_VERSION 1
+#define RESUME_APP_NAME_MAX 16
+// 记录滚动位置的页面数（trackScroll的slot）
+#define RESUME_SCROLL_MAX 4
+// 检查界面状态的周期（LVGL定时任务），有变化时更新快照
+#define RESUME_POLL_MS 500
+// 连续恢复多少次后仍在该时间内重启，视为恢复的状态导致崩溃，放弃快照
+#define RESUME_MAX_RESTORES 3
+#define RESUME_STABLE_MS 30000
+
+// ResumeSnapshot.scene_mode
+#define RESUME_SCENE_NONE 0
+#define RESUME_SCENE_SINGLE 1     // 单个场景，scene为路径，frame为显示到的帧
+#define RESUME_SCENE_PLAYLIST 2   // 播放列表，playlist_item为条目序号
+
+/**
+ * 界面状态快照（RTC慢速内存，软件复位、看门狗复位与深度睡眠后保留，上电时内容随机）
+ * 整个结构以CRC32校验，写入一半时复位（CRC不符）视为没有快照
+ */
+struct ResumeSnapshot
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t size;
+	uint8_t restores;          // 连续恢复次数，运行RESUME_STABLE_MS后清零
+	int8_t screen;             // 屏幕管理器的界面编号，-1为未使用
+	uint8_t scene_mode;        // RESUME_SCENE_x
+	uint8_t fps;
+	int8_t playlist_item;
+	uint8_t reserved;
+	uint16_t frame;
+	char app[RESUME_APP_NAME_MAX];    // 前台应用名称，空为没有
+	char scene[SCENE_PATH_MAX];
+	int16_t scroll[RESUME_SCROLL_MAX][2];
+	uint32_t crc;
+};
+
+/**
+ * 热重启恢复（OTA重启、看门狗或崩溃复位后回到原来的界面）
+ *
+ * 运行中每RESUME_POLL_MS检查一次前台应用、当前界面、页面滚动位置与正在播放的场景（帧号），
+ * 有变化时写入RTC内存中的快照，不写flash，不需要各模块在状态变化时通知。
+ * 启动时按复位原因判断快照是否可用（上电、掉电、外部复位时丢弃），恢复时：
+ *   restoreUi():    打开上次的前台应用，或只创建并显示上次的界面（setup_ui_at），其他界面仍按需创建
+ *   restoreScene(): SD卡挂载后重新打开场景并从上次的帧继续（差分动画从头开始），或从上次的条目继续轮播
+ * 恢复后连续崩溃RESUME_MAX_RESTORES次时放弃快照，按冷启动进入默认界面。
+ * 除begin外的接口都在LVGL任务中调用
+ */
+class ResumeState
+{
+private:
+	ResumeSnapshot restored;   // 启动时的快照（restoreX读取）
+	bool valid;
+	bool stable;
+	uint32_t started_ms;
+	lv_task_t* task;
+	ScenePlayer* players[2];
+	uint8_t player_count;
+	lv_obj_t* pages[RESUME_SCROLL_MAX];
+
+	void capture(ResumeSnapshot* s);
+	static uint32_t checksum(const ResumeSnapshot* s);
+	static void pollCb(lv_task_t* t);
+
+public:
+	ResumeState();
+	// 启动时尽早调用（日志之后）：检查复位原因与快照，不可用时清空
+	bool begin();
+	// 开始记录（恢复完成后调用，此前不覆盖启动时的快照）
+	void start();
+	// 立即记录一次当前状态
+	void save();
+	void clear();
+
+	// 有可用的快照
+	bool available();
+	const ResumeSnapshot* get();
+	// 上次的界面编号，没有时返回def（用于setup_ui_at）
+	int8_t getScreen(int8_t def);
+
+	// 记录其帧号的播放器（播放列表的两个播放器都要登记）
+	void watch(ScenePlayer* player);
+	// 记录页面（lv_page）的滚动位置；页面删除前应以page=NULL取消
+	void trackScroll(uint8_t slot, lv_obj_t* page);
+	// 页面重建后恢复滚动位置，没有快照时返回false
+	bool restoreScroll(uint8_t slot, lv_obj_t* page);
+
+	bool restoreUi();
+	bool restoreScene(lv_obj_t* canvas);
+};
+
+extern ResumeState resume;
+
+#endif
@@ -1,22 +1,120 @@
 #ifndef RGB_H
 #define RGB_H
 
+// WS2812只用一个RMT通道，其余通道留给其他外设
+#define FASTLED_RMT_MAX_CHANNELS 1
 #include <FastLED.h>
+#include <esp_timer.h>
 
 #define RGB_LED_NUM 2
 #define RGB_LED_PIN 27
 
+// 合成节拍：esp_timer每RGB_FRAME_US唤醒刷新任务，每个节拍合成各图层并最多发送一次（100Hz）
+#define RGB_FRAME_US 10000
+#define RGB_TASK_STACK 2048
+#define RGB_TASK_PRIO 1
+#define RGB_TASK_CORE 0
+// 关键帧动画最多帧数
+#define RGB_MAX_KEYFRAMES 8
+// 输出伽马（各图层按线性亮度混合，发送前查表校正）
+#define RGB_GAMMA 2.2f
+// 1：开启FastLED时间抖动，低亮度下颜色过渡更平滑（需每个节拍都发送，图层静止时也不跳过）
+#define RGB_DITHER 1
+// 环境色图层：场景平均色的默认混合比例，以及每个节拍向目标颜色/比例靠近的比例（/256，约0.3秒过渡）
+#define RGB_AMBIENT_AMOUNT 160
+#define RGB_AMBIENT_EASE 16
+// 运动辉光：角速度大小（三轴平方和开方，定点计算）除以RGB_GLOW_DIV为亮度（±250°/s量程下约每秒400°满亮），每个节拍衰减RGB_GLOW_DECAY
+#define RGB_GLOW_DIV 200
+#define RGB_GLOW_DECAY 4
 
+class IMU;
+
+/**
+ * 关键帧：time为相对动画开始的毫秒数（递增），相邻帧之间线性插值
+ */
+struct RgbKeyframe
+{
+	uint16_t time;
+	uint8_t r, g, b;
+};
+
+enum RgbAnimMode
+{
+	RGB_ANIM_NONE = 0,     // 静态颜色（setRGB）
+	RGB_ANIM_KEYFRAMES,    // 关键帧循环（呼吸灯等）
+	RGB_ANIM_RAINBOW       // 色相循环，各LED错开相位
+};
+
+/**
+ * 板载WS2812控制
+ * setRGB/setBrightness只修改缓冲区并标记脏，由刷新任务每帧合并发送一次；
+ * FastLED在ESP32上使用RMT外设发送，发送期间刷新任务挂起等待，不关中断、不阻塞调用方。
+ *
+ * 每个节拍由下到上合成各图层，再经伽马校正后调用一次FastLED.show()：
+ * 1. 基础层：setRGB的静态颜色或动画（呼吸、彩虹、关键帧）
+ * 2. 环境色：setAmbient（如场景平均色），按比例与基础层混合，颜色与比例随节拍渐变
+ * 3. 运动辉光：setGlow指定IMU后，按角速度叠加（加亮）辉光颜色，静止后逐渐熄灭
+ * 4. 通知闪烁：pulse，闪烁期间覆盖下面所有图层
+ * 节拍由esp_timer产生，效果开销固定，与界面循环无关
+ */
 class Pixel
 {
 private:
-	CRGB color_buffers[RGB_LED_NUM];
+	CRGB color_buffers[RGB_LED_NUM];      // 静态颜色（动画结束后恢复）
+	CRGB out_buffers[RGB_LED_NUM];        // 实际发送给FastLED的数据
+	uint8_t brightness;
+	volatile bool dirty;
+	portMUX_TYPE lock;
+	TaskHandle_t task;
+
+	RgbAnimMode mode;
+	RgbKeyframe frames[RGB_MAX_KEYFRAMES];
+	uint8_t frame_count;
+	uint32_t anim_start;
+	uint32_t anim_period;
+
+	// 通知闪烁：叠加在当前模式之上，结束后恢复
+	CRGB pulse_color;
+	uint8_t pulse_left;
+	uint32_t pulse_start;
+
+	// 环境色图层：当前值每个节拍向目标靠近
+	CRGB ambient_target;
+	CRGB ambient_cur;
+	uint8_t ambient_amount;
+	uint8_t ambient_level;
+
+	// 运动辉光图层
+	IMU* glow_imu;
+	CRGB glow_color;
+	uint8_t glow_level;
+
+	esp_timer_handle_t timer;
+	volatile uint8_t rate_div;     // 每rate_div个节拍刷新一次
+	uint8_t tick_count;
+
+	bool render(uint32_t now);
+	CRGB sampleKeyframes(uint32_t t);
+	static void tickCb(void* arg);
+	static void taskEntry(void* arg);
 
 public:
 	void init();
 
 	Pixel& setRGB(int id, int r, int g, int b);
 	Pixel& setBrightness(float duty);
+
+	Pixel& play(const RgbKeyframe* keyframes, uint8_t count);
+	Pixel& breathe(int r, int g, int b, uint16_t period_ms = 2000);
+	Pixel& rainbow(uint16_t period_ms = 3000);
+	Pixel& pulse(int r, int g, int b, uint8_t count = 3);
+	Pixel& stop();
+
+	Pixel& setAmbient(int r, int g, int b, uint8_t amount = RGB_AMBIENT_AMOUNT);
+	Pixel& clearAmbient();
+	Pixel& setGlow(IMU* imu, int r = 255, int g = 255, int b = 255);
+	// 节拍分频（1为RGB_FRAME_US一次），负载高时降低刷新率；动画按时间计算，速度不变
+	Pixel& setRateDivider(uint8_t div);
 };
 
-#endif
\ No newline at end of file
+#endif
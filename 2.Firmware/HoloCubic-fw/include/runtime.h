@@ -0,0 +1,112 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include "display.h"
+#include "imu.h"
+
+// LVGL渲染任务固定在核心1，传感器/网络任务在核心0
+#define UI_TASK_CORE 1
+#define UI_TASK_PRIORITY 3
+#define UI_TASK_STACK 8192
+
+#define SENSOR_TASK_CORE 0
+#define SENSOR_TASK_PRIORITY 2
+#define SENSOR_TASK_STACK 4096
+#define SENSOR_TASK_PERIOD_MS 10
+// FIFO模式下无中断通知时的最长等待（需小于FIFO写满时间：1024/12/100Hz≈850ms）
+#define SENSOR_FIFO_WAIT_MS 50
+// 任务监视（supervisor.h）的停顿阈值：一轮LVGL处理、一次IMU读取超过该时间视为停顿
+// （传感器停顿时清除I2C总线；LVGL没有可以安全执行的恢复动作，只记录，卡死时热重启）
+#define UI_STALL_MS 2000
+#define SENSOR_STALL_MS 500
+
+// UI消息队列深度
+#define UI_QUEUE_LEN 32
+
+// LVGL任务按最近一个定时器到期时间休眠，该值为最长休眠时间（兜底）
+#define UI_IDLE_MAX_MS 1000
+// 界面刷新周期：默认值与场景播放界面（60Hz）
+#define UI_REFR_DEFAULT_MS LV_DISP_DEF_REFR_PERIOD
+#define UI_REFR_SCENE_MS 16
+// 待机（背光关闭）时的最高刷新周期
+#define UI_REFR_STANDBY_MS 1000
+// 可单独设置刷新周期的界面数
+#define UI_REFR_SCREEN_MAX 4
+
+// LVGL任务唤醒原因（任务通知位）
+#define UI_WAKE_MSG   (1 << 0)
+#define UI_WAKE_INPUT (1 << 1)
+
+struct UiMsg;
+typedef void (*ui_msg_cb_t)(const UiMsg* msg);
+
+/**
+ * UI消息
+ * 回调在LVGL任务中执行，可以安全调用lv_obj_*接口
+ * obj/value为调用方自定义参数，消息按值拷贝进队列，不需要动态内存
+ */
+struct UiMsg
+{
+	ui_msg_cb_t cb;
+	void* obj;
+	int32_t value;
+};
+
+/**
+ * 界面刷新周期（毫秒），切换到该界面时生效
+ */
+struct UiRefresh
+{
+	lv_obj_t* scr;
+	uint16_t period;
+};
+
+
+class Runtime
+{
+private:
+	Display* disp;
+	IMU* imu;
+	QueueHandle_t ui_queue;
+	SemaphoreHandle_t ui_mutex;
+	TaskHandle_t ui_task;
+	TaskHandle_t sensor_task;
+	UiRefresh refr[UI_REFR_SCREEN_MAX];
+	uint8_t refr_count;
+	lv_obj_t* refr_scr;
+	volatile bool standby;
+	uint32_t wakeups;
+	int8_t ui_sup;
+	int8_t sensor_sup;
+
+	static void uiTaskEntry(void* arg);
+	static void sensorTaskEntry(void* arg);
+	static void inputWake();
+	void drainQueue();
+	void applyRefresh();
+	void readImu();
+
+public:
+	void begin(Display* display, IMU* sensor);
+
+	bool post(ui_msg_cb_t cb, void* obj = NULL, int32_t value = 0);
+	bool postFromISR(ui_msg_cb_t cb, void* obj = NULL, int32_t value = 0);
+
+	void lock();
+	void unlock();
+
+	void wake(uint32_t reason);
+	bool setScreenRefresh(lv_obj_t* scr, uint16_t period_ms);
+	void setStandby(bool enable);
+
+	TaskHandle_t getUiTask();
+	uint32_t getWakeups();
+};
+
+extern Runtime runtime;
+
+#endif
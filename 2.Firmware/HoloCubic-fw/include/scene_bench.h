@@ -0,0 +1,109 @@
+#ifndef SCENE_BENCH_H
+#define SCENE_BENCH_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+#include "scene_player.h"
+#include "scene_index.h"
+#include "render_prof.h"
+#include "runtime.h"
+
+// 1：启动后播放一次参考动画包并输出场景基准（构建配置env:pico32_scenebench），用于整机出厂验收
+#ifndef SCENE_BENCH_ON_BOOT
+#define SCENE_BENCH_ON_BOOT 0
+#endif
+
+// 参考动画包（所有设备使用同一个包，结果才能相互比较）
+#define SCENE_BENCH_PACK SCENE_ROOT "/bench.holo"
+// 目标帧率：高于设备能达到的帧率，播放速度由流水线决定（LVGL绘制的帧另受LV_DISP_DEF_REFR_PERIOD限制）
+#define SCENE_BENCH_FPS 100
+// 开始计时前的预热（预读扩充环形缓冲、图像缓存与SD卡进入稳定状态）
+#define SCENE_BENCH_WARMUP_MS 2000
+// 默认计时时长（秒）
+#define SCENE_BENCH_SECONDS 10
+// 等待LVGL任务执行打开/关闭的超时
+#define SCENE_BENCH_UI_TIMEOUT_MS 3000
+#define SCENE_BENCH_DIR "/bench"
+#define SCENE_BENCH_CSV_PATH "/bench/scene.csv"
+// start()的后台任务
+#define SCENE_BENCH_TASK_CORE 0
+#define SCENE_BENCH_TASK_PRIORITY 1
+#define SCENE_BENCH_TASK_STACK 4096
+
+/**
+ * 一次取值：播放统计、渲染计时的累计值与时刻
+ */
+struct SceneBenchSnap
+{
+	ScenePlayerStats player;
+	uint32_t refr;             // 刷新次数（render_prof帧数）
+	uint32_t us[RENDER_PROF_PHASE_CNT];
+	uint32_t t_us;
+};
+
+/**
+ * 场景播放的端到端基准
+ *
+ * 在全屏的顶层图像上播放参考动画包，预热后在计时窗口的两端各取一次播放统计（ScenePlayerStats）
+ * 与渲染计时（render_prof）的累计值，求差得到各阶段的每帧耗时与占用率（忙碌时间 / 窗口时长）：
+ *   sd_read    预读任务读取一帧（含CRC校验）
+ *   decode     LVGL任务中的showSlot：差分叠加、JPEG/Q565解码写屏、直接写屏的DMA排队
+ *   lvgl_draw  LVGL绘制（Q565以外的图像在此解码/复制）
+ *   spi        刷新回调（DMA模式下为等待上次DMA与排队）
+ *   lvgl_task  decode加刷新任务的总耗时（LVGL任务的占用）
+ * 预读任务与LVGL任务各自串行，按两者中占用率较高的一个推算可持续帧率：实测帧率 / 最高占用率。
+ *
+ * 输出：
+ *   串口 SCENEBENCH,begin,<包>,<秒>
+ *        SCENEBENCH,stage,<阶段>,<每帧us>,<占用%>
+ *        SCENEBENCH,queue,<平均就绪帧>,<最多就绪帧>,<槽位>
+ *        SCENEBENCH,stall,<预读等待槽位%>,<重复周期>,<丢帧>,<校验失败>
+ *        SCENEBENCH,sd,<读取吞吐>,MB/s,<单帧最长读取us>,max_us
+ *        SCENEBENCH,refr,<刷新次数/秒>,fps
+ *        SCENEBENCH,result,<实测fps>,<可持续fps>,<瓶颈阶段>
+ *        SCENEBENCH,end（无法运行时为SCENEBENCH,skip,<原因>）
+ *   SD卡 SCENE_BENCH_CSV_PATH（追加，每行带设备MAC与CPU频率）
+ *
+ * 注意事项：
+ * - run()阻塞到结束，不能在LVGL任务中调用（打开/关闭通过runtime.post交给LVGL任务）
+ * - 运行期间占用传入的播放器，结束后关闭，不恢复原来的场景；同时启用渲染计时，结束后恢复原状态
+ * - 直接写屏时DMA与下一帧解码重叠，spi阶段只包含等待与排队，实际传输时间体现在decode的等待中
+ */
+class SceneBench
+{
+private:
+	ScenePlayer* player;
+	char path[SCENE_PATH_MAX];
+	lv_obj_t* canvas;
+	volatile bool ui_done;
+	bool opened;
+	bool prof_was;
+	uint16_t seconds;
+	TaskHandle_t task;
+	volatile bool running;
+	float result_fps;
+
+	bool callUi(ui_msg_cb_t cb);
+	void snap(SceneBenchSnap* s);
+	void report(const SceneBenchSnap* a, const SceneBenchSnap* b);
+	static void uiStart(const UiMsg* msg);
+	static void uiStop(const UiMsg* msg);
+	static void taskEntry(void* arg);
+
+public:
+	SceneBench();
+	/**
+	 * 运行一次（阻塞约预热 + seconds秒）
+	 * @return 动画包无法打开或LVGL任务没有响应时返回false
+	 */
+	bool run(ScenePlayer* scene, const char* pack = SCENE_BENCH_PACK, uint16_t secs = SCENE_BENCH_SECONDS);
+	// 在后台任务中运行一次（启动时使用）
+	bool start(ScenePlayer* scene, const char* pack = SCENE_BENCH_PACK, uint16_t secs = SCENE_BENCH_SECONDS);
+	bool isRunning();
+	// 最近一次的可持续帧率，没有结果时为0
+	float getResult();
+};
+
+extern SceneBench scenebench;
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SCENE_INDEX_H
+#define SCENE_INDEX_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "scene_player.h"
+
+// 场景索引文件（二进制，定长条目），重建时先写临时文件再改名
+#define SCENE_INDEX_FILE SCENE_ROOT "/index.bin"
+#define SCENE_INDEX_TMP_FILE SCENE_ROOT "/index.tmp"
+#define SCENE_INDEX_MAGIC "SIDX"
+#define SCENE_INDEX_VERSION 4
+// 场景名（目录名或.holo文件名）最大长度，更长的场景不会被索引
+#define SCENE_INDEX_NAME_MAX 36
+// 重建时读入内存比较的旧条目数上限（每条94字节，超出部分按新场景重新读取）
+#define SCENE_INDEX_CACHE_MAX 128
+// 帧目录没有帧率，时长按此帧率估算（与ScenePlayer::open的默认值一致）
+#define SCENE_INDEX_DEFAULT_FPS 25
+
+// SceneIndexEntry.format
+#define SCENE_FORMAT_FRAMES 0  // 帧目录（frameNNN.bin）
+#define SCENE_FORMAT_HOLO 1    // .holo动画包，flags为HoloHeader.flags
+
+// SceneIndexEntry.verify：动画包的帧校验状态（帧目录与不带校验值的包为NONE）
+#define SCENE_VERIFY_NONE 0
+#define SCENE_VERIFY_PENDING 1 // 带校验值，尚未全部校验过
+#define SCENE_VERIFY_OK 2      // 每一帧都已校验通过（修改时间不变时之后的播放不再校验）
+#define SCENE_VERIFY_BAD 3     // 有帧校验失败（bad_frame为第一个）
+
+#pragma pack(push, 1)
+
+/**
+ * 索引文件布局（小端）：[SceneIndexHeader][SceneIndexEntry * count]，按目录遍历顺序
+ * 第i个场景位于header_size + i * entry_size，浏览界面翻页时直接seek，不必遍历目录
+ * entry_size为单条长度，新版本可在条目末尾追加字段
+ */
+struct SceneIndexHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	uint16_t entry_size;
+	uint16_t reserved;
+	uint32_t count;
+};
+
+struct SceneIndexEntry
+{
+	char name[SCENE_INDEX_NAME_MAX];   // 以0结尾
+	uint32_t mtime;        // 目录/文件的修改时间（FAT目录项），用于增量重建
+	uint32_t frame_count;
+	uint16_t width;
+	uint16_t height;
+	uint8_t format;        // SCENE_FORMAT_x
+	uint8_t flags;         // HOLO_FLAG_x
+	uint8_t cf;            // 帧的LVGL颜色格式
+	uint8_t fps;           // 帧目录为0
+	uint32_t duration_ms;
+	uint32_t thumb_offset; // 缩略图（第一帧，LVGL .bin、JPEG或Q565）：.holo中为文件内偏移，帧目录中为frame000.bin的0
+	uint32_t thumb_size;
+	uint16_t fragments;    // .holo文件的FAT片段数：1为连续存放（可按扇区直接读取），0为帧目录或无法判断
+	// 第一个关键帧的缩略图（HoloMipEntry），下标0~2依次为1/2、1/4、1/8尺寸，size为0表示没有该级
+	uint32_t mip_offset[HOLO_MIP_LEVELS];
+	uint32_t mip_size[HOLO_MIP_LEVELS];
+	// 帧校验结果（SCENE_VERIFY_x）：播放器得出结果后原位写回，重建时随条目沿用，修改时间变化后重新读取为PENDING
+	uint8_t verify;
+	uint8_t reserved;
+	uint16_t bad_frame;
+};
+
+#pragma pack(pop)
+
+/**
+ * 场景索引
+ *
+ * 重建（build）：遍历场景根目录，修改时间与旧索引相同的场景直接沿用旧条目，
+ * 只有新增、修改过的场景才打开读取（帧目录统计帧数、.holo读取文件头与第一帧索引并检查是否连续存放）。
+ * FAT不会在目录内增删文件时更新目录的修改时间，单独上传帧文件后应把该场景名传给build()
+ *
+ * 浏览（open/get）：读取条目为一次seek加一次read，与场景总数无关；动画包的缩略图位置也记录在条目中，
+ * 网格中的预览按格子尺寸用readThumb读出对应的一级，不必读取并缩小整幅首帧；
+ * build()完成后getGeneration()加1，已打开的读取方应重新open()
+ */
+class SceneIndex
+{
+private:
+	File file;
+	uint32_t count;
+	uint16_t header_size;
+	uint16_t entry_size;
+	uint32_t generation;
+	uint16_t sd_gen;           // 打开时SD卡的挂载次数，重新挂载后文件句柄失效
+
+	static bool probe(File& f, const char* name, SceneIndexEntry* e);
+	static bool probeFrames(File& dir, SceneIndexEntry* e);
+	static bool probePack(File& f, SceneIndexEntry* e);
+
+public:
+	SceneIndex();
+	~SceneIndex();
+
+	bool open();
+	void close();
+	uint32_t getCount();
+	bool get(uint32_t i, SceneIndexEntry* out);
+	// 按名称查找（顺序读取），找不到时返回-1
+	int32_t find(const char* name);
+	bool isStale();
+
+	/**
+	 * 读取不超过max_w x max_h的最大一级缩略图（一次seek加一次read，不解码）
+	 * 画质调节降到QUALITY_LOW_RES时取再小一级，显示尺寸以out的图像头为准
+	 * @param buf 调用方提供的缓冲，out引用其中的数据，可直接交给lv_img_set_src
+	 * @return 没有合适的级、缓冲不够或读取失败时返回false（可改用thumb_offset处的首帧）
+	 */
+	static bool readThumb(const SceneIndexEntry* e, uint16_t max_w, uint16_t max_h, uint8_t* buf, uint32_t cap,
+						  lv_img_dsc_t* out);
+
+	// 增量重建；changed为修改过内容的场景名（NULL表示只按修改时间判断），force为true时全部重新读取
+	static bool build(const char* changed = NULL, bool force = false);
+	static uint32_t getGeneration();
+
+	// 场景根目录下的路径（SCENE_ROOT/<名称>）返回名称部分，其他路径返回NULL
+	static const char* sceneName(const char* path);
+	/**
+	 * 读取/写回场景的帧校验状态（按名称顺序查找，供播放器在打开与得出结果时调用）
+	 * mtime须与条目中的修改时间相同（索引尚未按新内容重建时不读取、不写回）
+	 */
+	static uint8_t getVerify(const char* name, uint32_t mtime);
+	static bool setVerify(const char* name, uint32_t mtime, uint8_t state, uint16_t bad_frame = 0);
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef SCENE_MANIFEST_H
+#define SCENE_MANIFEST_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "scene_player.h"
+
+// 文件内容清单（与场景索引同目录，按需计算后缓存），临时文件用于压缩
+#define SCENE_MANIFEST_FILE SCENE_ROOT "/manifest.bin"
+#define SCENE_MANIFEST_TMP_FILE SCENE_ROOT "/manifest.tmp"
+#define SCENE_MANIFEST_MAGIC "SMAN"
+#define SCENE_MANIFEST_VERSION 1
+// 分块大小：差量同步以块为单位比较与上传（.holo帧对齐为4096，块边界与帧边界对齐）
+#define SCENE_MANIFEST_CHUNK 65536
+// 单个文件的块数上限（4GB / 64KB）
+#define SCENE_MANIFEST_CHUNKS_MAX 65535
+// 作废记录多于有效记录且超过该数时压缩清单文件
+#define SCENE_MANIFEST_COMPACT_MIN 32
+// 计算CRC时的读取块大小（堆上分配）
+#define SCENE_MANIFEST_READ_SIZE 4096
+
+#pragma pack(push, 1)
+
+/**
+ * 清单文件布局（小端）：[SceneManifestHeader][记录 ...]，记录为
+ * [SceneManifestRecord][路径（path_len字节，不含0）][uint32_t块CRC * chunk_count]
+ * 同一文件重新计算时追加新记录，旧记录的live置0，压缩时丢弃
+ */
+struct SceneManifestHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	uint32_t chunk_size;   // 与SCENE_MANIFEST_CHUNK不同时整个清单作废
+	uint32_t live;
+	uint32_t dead;
+};
+
+struct SceneManifestRecord
+{
+	uint32_t path_crc;     // 路径的CRC32，查找时先比较
+	uint32_t size;
+	uint32_t mtime;        // FAT目录项修改时间，与size都一致时沿用记录
+	uint32_t crc32;        // 整个文件的CRC32（与zlib相同）
+	uint16_t chunk_count;
+	uint8_t path_len;
+	uint8_t live;
+};
+
+#pragma pack(pop)
+
+/**
+ * 查找结果：文件的大小与CRC，以及块CRC在清单文件中的位置
+ */
+struct SceneManifestEntry
+{
+	uint32_t size;
+	uint32_t crc32;
+	uint16_t chunk_count;
+	uint32_t chunks_pos;
+};
+
+/**
+ * SD卡文件内容清单（差量同步）
+ *
+ * 文件按SCENE_MANIFEST_CHUNK分块，记录每块与整个文件的CRC32。
+ * 查询时只比较文件的大小与修改时间：一致时直接返回缓存的记录，否则读一遍文件重新计算并追加记录，
+ * 因此第一次同步需要读取整个库，之后只有修改过的文件才会被读取。
+ * 主机按块比较后只上传不同的块（PUT /upload的patch模式原地写入），写入完成时作废该文件的记录。
+ *
+ * 由多设备管理服务（SYNC/CHUNKS）与上传服务在各自的任务中调用，内部由互斥锁串行
+ */
+class SceneManifest
+{
+private:
+	static int32_t findRecord(File& f, const SceneManifestHeader* h, const char* path, SceneManifestRecord* rec);
+	static bool append(File& f, const char* path, File& src, SceneManifestRecord* rec);
+	static bool openFile(File& f, SceneManifestHeader* h);
+	static bool compact(File& f, SceneManifestHeader* h);
+	static void kill(File& f, SceneManifestHeader* h, int32_t pos);
+
+public:
+	// 取文件的清单（必要时计算并缓存），文件不存在或读取失败时返回false
+	static bool lookup(const char* path, SceneManifestEntry* out);
+	// 读取lookup结果中第first块起的n块CRC
+	static bool readChunks(const SceneManifestEntry* e, uint16_t first, uint16_t n, uint32_t* out);
+	// 作废文件的记录（文件被改写后调用，下次lookup时重新计算）
+	static void invalidate(const char* path);
+};
+
+#endif
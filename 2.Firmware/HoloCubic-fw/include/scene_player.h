@@ -0,0 +1,275 @@
+#ifndef SCENE_PLAYER_H
+#define SCENE_PLAYER_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <FS.h>
+#include "holo_format.h"
+#include "jpeg_decoder.h"
+#include "q565_decoder.h"
+#include "display.h"
+#include "sd_card.h"
+#include "rgb_led.h"
+
+// 预读环形缓冲区深度（帧数）
+#define SCENE_RING_DEPTH 3
+// SD读取耗时波动大时播放中最多扩充到的槽位数（BUF_BULK分配失败时保持现有深度）
+#define SCENE_RING_MAX 5
+// 播放节奏：每个帧周期轮询SCENE_PACE_POLL_DIV次，帧在预定显示时刻（PTS）上屏
+#define SCENE_PACE_POLL_DIV 4
+// 落后超过此时长（SD卡长时间停顿）时重新对齐时钟，不再追赶
+#define SCENE_PACE_RESYNC_MS 500
+// 对齐外部时间轴（setEpoch，多设备同步见scene_sync.h）：误差在STEP以内时每显示一帧最多调整SLEW，
+// 画面节奏的变化看不出来；超过STEP（刚加入、换了主机）时直接跳到对齐位置
+#define SCENE_SYNC_SLEW_US 1000
+#define SCENE_SYNC_STEP_MS 200
+// 预读任务配置（与LVGL任务分处不同核心）
+#define SCENE_TASK_CORE 0
+#define SCENE_TASK_PRIORITY 1
+#define SCENE_TASK_STACK 4096
+// 一帧SD读取超过该时间视为停顿（见supervisor.h），连续读取失败时重新挂载SD卡
+#define SCENE_STALL_MS 1000
+// SD卡重新挂载期间（见sd_hotplug.h）预读任务的等待间隔
+#define SCENE_SD_WAIT_MS 50
+// 帧文件路径最大长度
+#define SCENE_PATH_MAX 64
+// 场景根目录（场景索引见scene_index.h）
+#define SCENE_ROOT "/Scenes"
+// 1：设置了显示对象（setDisplay）时，真彩色帧从槽位整幅DMA写屏，不经过LVGL绘制，
+// 面板写入当前帧与SD卡读取下一帧分别在VSPI/HSPI上同时进行
+#define SCENE_DIRECT_PRESENT 1
+// 设置了LED（setLeds）时每隔多少帧取一次帧的平均色作为LED环境色：动画包索引带平均色时直接使用，
+// 否则按8x8网格采样（真彩色与索引色帧在显示时采样，MJPEG帧在解码条带时采样）
+#define SCENE_AMBIENT_EVERY 5
+#define SCENE_AMBIENT_GRID 8
+// Q565压缩帧直接写屏时每条带的行数（两个条带缓冲交替：解码一条带时上一条带正在DMA发送）
+#define SCENE_Q565_LINES 16
+// 实时画面（openLive）的显示轮询周期：帧到达后最多等待一个周期上屏
+#define SCENE_LIVE_POLL_MS 5
+
+// 实时画面的帧格式
+enum SceneLiveFormat
+{
+	SCENE_LIVE_RAW = 0,        // 槽位为LVGL真彩色图像（图像头在openLive时写好，来源只写像素）
+	SCENE_LIVE_JPEG            // 槽位为一幅基线JPEG，显示时按条带解码直接写屏（需要setDisplay）
+};
+
+/**
+ * 环形缓冲区中的一帧
+ * data为LVGL .bin文件的完整内容（4字节lv_img_header_t + 像素数据）
+ * dsc直接引用data，交给lv_img_set_src作为内存图像使用
+ */
+struct SceneSlot
+{
+	uint8_t* data;
+	uint32_t len;
+	uint16_t frame_id;
+	uint32_t seq;          // 时间轴序号（play起按帧周期编号），预定显示时刻为pace_origin + seq * period_us
+	lv_img_dsc_t dsc;
+};
+
+/**
+ * 播放统计：open起累计，只增不减（回绕按无符号差计算），供基准测试两次取值求差
+ * 读取相关字段由预读任务写入，其余由LVGL任务写入；getStats的各字段不保证取自同一时刻
+ */
+struct ScenePlayerStats
+{
+	uint32_t reads;            // 预读的帧数（含读取/校验失败的）
+	uint32_t read_us;          // SD读取（含解压调色板、CRC校验）累计耗时
+	uint32_t read_max_us;
+	uint32_t read_bytes;       // 读取成功的帧字节数
+	uint32_t free_wait_us;     // 预读任务等待空闲槽位的累计时间（显示跟不上或环形缓冲已满）
+	uint32_t corrupt;          // 校验失败的帧
+	uint32_t shown;            // 上屏的帧
+	uint32_t dropped;          // 时间轴上跳过的帧（含预读时跳过的）
+	uint32_t repeated;         // 预读未跟上而重复显示的周期数
+	uint32_t present_us;       // showSlot累计耗时：差分叠加、JPEG/Q565解码写屏、设置图像源
+	uint32_t depth_sum;        // 每帧上屏时ready_q中剩余的帧数之和
+	uint8_t depth_max;
+	uint8_t slots;             // 当前已分配的槽位数
+};
+
+
+class ScenePlayer
+{
+private:
+	char dir[SCENE_PATH_MAX];
+	uint16_t frame_count;
+	uint16_t next_read;
+	uint8_t fps;
+	uint8_t pack_fps;
+	uint16_t pack_w;           // 帧尺寸（裁剪过的动画包为裁剪后的尺寸），0表示未知
+	uint16_t pack_h;
+	// 帧中心相对画布中心的偏移（HOLO_FLAG_CROP），画布在控件的父对象中居中
+	int16_t place_dx;
+	int16_t place_dy;
+	bool placed;               // play之后已按帧尺寸摆放控件
+	uint32_t slot_size;
+	bool playing;
+	volatile bool prefetching; // 预读任务运行中（play或preroll之后）
+
+	// .holo动画包：文件保持打开，帧索引常驻内存
+	File pack;
+	HoloFrameEntry* index;
+	uint8_t pack_flags;
+	bool index_ambient;        // 索引条目带平均色（HoloFrameEntry.ambient）
+	// 连续存放的动画包：按扇区直接读取帧，不经过FatFs的簇查找
+	SdExtent extent;
+	bool raw;
+	uint16_t sd_gen;           // 打开动画包时SD卡的挂载次数（tf.generation()）
+	// 预读在任务监视器中的阶段，第一次预读时登记
+	bool supervised;
+	int8_t sup_id;
+	// 帧校验（索引条目带crc时）：每帧一位，第一次读取时校验通过后置位；全部通过后释放，之后不再校验。
+	// 场景索引记录为已校验通过的包打开时为NULL
+	uint8_t* verified;
+	uint16_t verified_cnt;
+	bool verify_bad;
+	bool read_corrupt;         // 最近一次readFrame因校验失败返回（不计为SD读取失败）
+	uint32_t pack_mtime;
+	// 共用调色板（HOLO_FLAG_PALETTE）：读取完整帧时插回图像头之后
+	uint8_t* palette;
+	uint16_t palette_size;
+
+	// 差分动画：常驻帧缓冲（关键帧完整内容），差分帧在其上覆盖变化的分块
+	uint8_t* fb;
+	uint32_t fb_len;
+	lv_img_dsc_t fb_dsc;
+
+	// MJPEG动画：解码条带直接写屏
+	Display* display;
+	JpegDecoder jpeg;
+	// Q565压缩帧直接写屏的条带缓冲（可DMA内存），没有显示对象时为NULL
+	lv_color_t* q565_band[2];
+	// 最近一帧由presentDirect写屏（LVGL的图像源没有跟着更新）
+	bool direct_shown;
+	// LED环境色跟随场景平均色；MJPEG帧解码时累加网格采样点
+	Pixel* leds;
+	uint32_t amb_sum[3];
+	uint16_t amb_n;
+	bool amb_sampling;
+
+	SceneSlot slots[SCENE_RING_MAX];
+	uint8_t slot_count;        // 已分配的槽位，预读任务按读取耗时扩充
+	QueueHandle_t free_q;      // 可填充的槽位
+	QueueHandle_t ready_q;     // 已读取、按顺序等待显示的槽位
+	TaskHandle_t prefetch_task;
+	lv_task_t* present_task;
+	lv_obj_t* canvas;
+	int8_t shown_slot;
+	int32_t last_frame;        // 最近显示的帧号，-1表示尚未显示
+
+	// 播放节奏：时间按micros()回绕计算；显示第一帧时对齐时钟，之后按PTS显示、丢弃或重复
+	uint32_t period_us;
+	volatile uint32_t pace_origin;
+	volatile bool paced;
+	uint16_t seq_base;         // play时的起始帧号，帧号为(seq_base + seq) % frame_count
+	uint32_t next_seq;
+	uint32_t shown_seq;
+	uint32_t shown_us;
+	// SD读取一帧耗时的平滑均值与平均偏差（同TCP的SRTT/RTTVAR），预读任务中更新
+	uint32_t read_avg_us;
+	uint32_t read_dev_us;
+	bool ring_full;
+	// 实时画面：没有预读任务，槽位由外部来源（如live_link.h）填充后提交
+	bool live;
+	// 外部时间轴：帧号0的本地显示时刻（micros），由同步任务写入，显示任务逐帧调整pace_origin
+	volatile uint32_t sync_epoch;
+	volatile bool sync_valid;
+	volatile int32_t sync_err;
+	ScenePlayerStats stats;
+
+	bool allocSlots(uint32_t size);
+	void freeSlots();
+	void framePath(char* out, uint16_t id);
+	bool probeFrames(uint16_t frames, uint32_t* max_size);
+	bool openPack(uint32_t* max_size);
+	bool readFrame(SceneSlot* slot, uint16_t id);
+	void beginVerify();
+	bool verifyFrame(const uint8_t* data, uint32_t len, uint16_t id);
+	bool reopenPack();
+	static bool recoverSd(void* user);
+	bool fillSlot(SceneSlot* slot, uint16_t id);
+	bool isDelta();
+	bool isJpeg();
+	bool isQ565();
+	void allocBands();
+	bool presentQ565(SceneSlot* slot);
+	void presentJpeg(SceneSlot* slot);
+	bool presentDirect(SceneSlot* slot);
+	static bool jpegBandCb(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px);
+	bool allocFrameBuffer();
+	void applyDelta(SceneSlot* slot);
+	uint32_t ptsOf(uint32_t seq);
+	void slewToEpoch();
+	uint32_t readLead();
+	void trackRead(uint32_t us);
+	void growRing();
+	void showSlot(uint8_t idx);
+	void placeCanvas();
+	bool ambientDue(uint16_t frame_id);
+	void updateAmbient(const lv_img_dsc_t* img, uint16_t frame_id);
+	void sampleBand(uint16_t y, uint16_t w, uint16_t h, const uint16_t* px);
+
+	static void prefetchEntry(void* arg);
+	static void presentCb(lv_task_t* task);
+
+public:
+	void setDisplay(Display* disp);
+	void setLeds(Pixel* pixel);
+
+	// scene_dir为帧目录，或以".holo"结尾的动画包（此时frames被忽略，fps为0时取包内帧率）
+	bool open(const char* scene_dir, uint16_t frames = 0, uint8_t target_fps = 25);
+	void play(lv_obj_t* img);
+	bool preroll();
+	void stop();
+	void close();
+
+	/**
+	 * 打开实时画面：帧不来自SD卡，由外部来源直接写入环形缓冲区的槽位，play()后每帧到达即上屏
+	 * @param w/h 画面尺寸（SCENE_LIVE_RAW据此写图像头）
+	 * @param max_size JPEG帧的最大字节数（SCENE_LIVE_RAW时忽略）
+	 */
+	bool openLive(SceneLiveFormat format, uint16_t w, uint16_t h, uint32_t max_size = 0);
+	/**
+	 * 实时画面的来源接口（任意任务，不阻塞）：
+	 * 取得空闲槽位 -> 把数据写入liveBuffer -> liveCommit交给显示（或liveRelease放弃）
+	 * 显示任务只显示最新提交的一帧，积压的旧帧直接归还；来源须在stop()/close()之前停止
+	 * @return 槽位编号，没有空闲槽位（显示跟不上）时返回-1
+	 */
+	int8_t liveAcquire();
+	uint8_t* liveBuffer(int8_t slot);
+	// 槽位容量（SCENE_LIVE_RAW为图像头加w*h像素）
+	uint32_t liveCapacity();
+	void liveCommit(int8_t slot, uint32_t len, uint16_t frame_id);
+	void liveRelease(int8_t slot);
+
+	// 从第frame帧开始播放（open之后、play/preroll之前调用）；差分动画只能从关键帧（第0帧）开始，返回false
+	bool seek(uint16_t frame);
+
+	/**
+	 * 对齐到外部时间轴（任意任务，不阻塞）：帧号0在本地时刻epoch_us（micros()）上屏，
+	 * 其余帧按帧周期排列并按帧数循环；之后每显示一帧向对齐位置调整一次（见SCENE_SYNC_SLEW_US）
+	 */
+	void setEpoch(uint32_t epoch_us);
+	// 取消对齐，时间轴保持当前位置继续
+	void clearEpoch();
+	// 当前时间轴上帧号0的本地显示时刻（播放中且已显示第一帧后有效），实时画面返回false
+	bool getEpoch(uint32_t* epoch_us);
+	// 与外部时间轴的误差（us，正数为本机偏早），未对齐时为0
+	int32_t getSyncError();
+
+	bool isPlaying();
+	// 最近显示的帧号，尚未显示时为-1
+	int32_t getShownFrame();
+	uint16_t getFrameCount();
+	// 打开的场景路径与帧率，未打开时路径为NULL
+	const char* getPath();
+	uint8_t getFps();
+	// 复制播放统计（任意任务）
+	void getStats(ScenePlayerStats* out);
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef SCENE_PLAYLIST_H
+#define SCENE_PLAYLIST_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include "scene_index.h"
+#include "scene_player.h"
+
+// 播放列表文件（文本，每行一个场景，格式见ScenePlaylist::load）
+#define PLAYLIST_FILE SCENE_ROOT "/playlist.txt"
+#define PLAYLIST_MAX 32
+// 当前场景结束前多久开始预载下一场景：打开文件头与帧索引，并把前SCENE_RING_DEPTH帧读入环形缓冲区
+#define PLAYLIST_PRELOAD_MS 3000
+// 未写时长的条目的播放时长
+#define PLAYLIST_DEFAULT_MS 30000
+// 按动画结尾切换时，超过时长后最多再等待多久（帧率很低或帧数很多的场景不会无限延长）
+#define PLAYLIST_LOOP_WAIT_MS 10000
+// 调度周期（LVGL定时任务）
+#define PLAYLIST_TICK_MS 20
+// 预载任务配置（与预读任务同在核心0）
+#define PLAYLIST_TASK_CORE 0
+#define PLAYLIST_TASK_PRIORITY 1
+#define PLAYLIST_TASK_STACK 4096
+
+// PlaylistItem.transition
+#define PLAYLIST_CUT 0         // 到时长立即切换
+#define PLAYLIST_LOOP_END 1    // 到时长后等当前动画播完最后一帧再切换，衔接在循环点上
+
+/**
+ * 播放列表条目
+ */
+struct PlaylistItem
+{
+	char name[SCENE_INDEX_NAME_MAX];   // 场景根目录下的帧目录名或.holo文件名
+	uint32_t duration_ms;
+	uint8_t fps;               // 0为包内帧率（帧目录为25）
+	uint8_t transition;        // PLAYLIST_x
+};
+
+/**
+ * 场景播放列表（展厅轮播）
+ *
+ * 两个场景播放器交替使用：当前场景剩余PLAYLIST_PRELOAD_MS时，后台任务用另一个播放器打开下一场景
+ * 并启动预读（ScenePlayer::preroll），到切换时刻下一场景的前几帧已在内存中，
+ * 停止当前场景后立即开始播放，屏幕上始终保留上一帧，没有空白帧；
+ * 新场景显示了第一帧之后才关闭上一场景，释放其缓冲区。
+ *
+ * 两个场景的环形缓冲区在预载期间同时存在；内存不足以预载时退回为先关闭再打开，
+ * 切换时会停顿一次读取的时间（日志中提示）。
+ * 只有一个条目时循环播放该场景，不重新打开。
+ * 所有接口在LVGL任务中调用。
+ */
+class ScenePlaylist
+{
+private:
+	ScenePlayer* players[2];
+	uint8_t cur;               // 当前播放器下标
+	PlaylistItem items[PLAYLIST_MAX];
+	uint8_t count;
+	uint8_t cur_item;
+	uint8_t next_item;
+	lv_obj_t* canvas;
+	lv_task_t* task;
+	uint32_t started_ms;
+	bool retire;               // 上一场景等待新场景显示第一帧后关闭
+
+	TaskHandle_t preload_task;
+	volatile uint8_t preload_state;
+
+	bool openItem(ScenePlayer* p, uint8_t i);
+	bool switchDue(uint32_t elapsed);
+	void startPreload();
+	void advance();
+	static void preloadEntry(void* arg);
+	static void tickCb(lv_task_t* t);
+
+public:
+	void begin(ScenePlayer* a, ScenePlayer* b);
+	bool load(const char* path = PLAYLIST_FILE);
+	bool add(const PlaylistItem& item);
+	void clear();
+
+	// 从第first个条目开始轮播（不可播放的条目跳过）
+	bool start(lv_obj_t* img, uint8_t first = 0);
+	void stop();
+	bool isRunning();
+	// 当前条目序号，未运行时为-1
+	int current();
+};
+
+extern ScenePlaylist playlist;
+
+#endif
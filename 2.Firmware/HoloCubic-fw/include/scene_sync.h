@@ -0,0 +1,159 @@
+#ifndef SCENE_SYNC_H
+#define SCENE_SYNC_H
+
+#include <Arduino.h>
+#include "scene_player.h"
+
+class Network;
+
+// 同步协议UDP端口（与管理协议FLEET_PORT相邻）
+#define SYNC_PORT 7011
+#define SYNC_MAGIC0 'H'
+#define SYNC_MAGIC1 'S'
+#define SYNC_VERSION 1
+// 每台设备广播ANNOUNCE的周期；超过TIMEOUT没有收到主机的ANNOUNCE时重新选举
+#define SYNC_ANNOUNCE_MS 500
+#define SYNC_LEADER_TIMEOUT_MS 2000
+// 跟随方测量时钟偏差的周期与最小时延滤波窗口（取窗口内往返最短的一次）
+#define SYNC_DELAY_REQ_MS 250
+#define SYNC_FILTER_N 8
+// 往返超过此时长的测量丢弃（省电唤醒、重传）；窗口内至少有LOCK_MIN次有效测量才开始对齐
+#define SYNC_MAX_RTT_US 30000
+#define SYNC_LOCK_MIN 3
+// 同步任务（接收超时兼作定时）
+#define SYNC_TASK_CORE 0
+#define SYNC_TASK_PRIORITY 2
+#define SYNC_TASK_STACK 3072
+#define SYNC_RECV_TIMEOUT_MS 20
+
+// SyncHeader.op
+#define SYNC_OP_ANNOUNCE 0x01  // 广播：SyncAnnounce
+#define SYNC_OP_DELAY_REQ 0x02 // 跟随方 -> 主机：SyncDelay（只填t1）
+#define SYNC_OP_DELAY_RESP 0x03 // 主机 -> 跟随方：SyncDelay（t1原样带回，填t2/t3）
+
+#pragma pack(push, 1)
+
+/**
+ * 包头（小端，12字节）
+ * group相同的设备组成一组，组内MAC最小的设备为主机
+ */
+struct SyncHeader
+{
+	uint8_t magic[2];
+	uint8_t version;
+	uint8_t op;
+	uint8_t group;
+	uint8_t reserved;
+	uint8_t mac[6];
+};
+
+/**
+ * ANNOUNCE载荷：发送时刻的本机时钟与正在播放的场景时间轴
+ * 时间均为esp_timer_get_time()（64位微秒，低32位即micros()）
+ */
+struct SyncAnnounce
+{
+	int64_t time_us;
+	int64_t epoch_us;          // 帧号0的显示时刻（发送方时钟）
+	uint32_t scene_id;         // 场景路径的CRC32，0表示没有在播放
+	uint32_t period_us;
+	uint16_t frame_count;
+	uint16_t reserved;
+};
+
+/**
+ * DELAY_REQ/DELAY_RESP载荷（同NTP的四个时间戳）
+ * t1: 跟随方发送 t2: 主机接收 t3: 主机回复（t4为跟随方接收，不在包中）
+ */
+struct SyncDelay
+{
+	int64_t t1;
+	int64_t t2;
+	int64_t t3;
+};
+
+#pragma pack(pop)
+
+/**
+ * 多设备场景同步
+ *
+ * 成排摆放的立方体播放同一场景时按同一时间轴显示，不需要中心视频服务器：
+ * - 组内每台设备每SYNC_ANNOUNCE_MS广播一次ANNOUNCE，MAC最小的设备为主机（主机离线后自动改选）
+ * - 跟随方以DELAY_REQ/DELAY_RESP测量与主机的时钟偏差（类似PTP的延迟请求：
+ *   偏差 = ((t2 - t1) + (t3 - t4)) / 2，往返 = (t4 - t1) - (t3 - t2)），
+ *   取最近SYNC_FILTER_N次中往返最短的一次，WiFi排队与省电唤醒造成的非对称时延影响最小
+ * - 主机的ANNOUNCE带有场景时间轴（帧号0的显示时刻），跟随方播放同一场景（路径、帧数、帧率相同）时
+ *   换算到本机时钟交给ScenePlayer::setEpoch，播放器逐帧把PTS调向对齐位置，各台的显示时刻相差几毫秒
+ * - 不同场景时只保持时钟同步，不调整播放；各台应播放相同的场景（同一播放列表或由HoloFleet的SCENE切换）
+ *
+ * 注意事项：
+ * - 运行期间保持网络工作窗口（Network::acquire），关闭WiFi省电，收发时延稳定
+ * - 同步包不认证（不改变场景，只调整播放时刻），组号用来隔离同一网段内的不同展位
+ */
+class SceneSync
+{
+private:
+	struct Sample
+	{
+		int64_t offset;        // 主机时钟 - 本机时钟
+		uint32_t rtt;
+	};
+
+	Network* net;
+	ScenePlayer* players[2];
+	uint8_t group;
+	uint8_t mac[6];
+	int sock;
+	TaskHandle_t task;
+	volatile bool running;
+
+	// 当前主机（MAC比本机小且未超时的设备），没有时本机为主机
+	bool has_leader;
+	uint8_t leader_mac[6];
+	uint32_t leader_ip;
+	uint32_t leader_seen;
+	SyncAnnounce leader_state;
+
+	Sample samples[SYNC_FILTER_N];
+	uint8_t sample_count;
+	uint8_t sample_pos;
+	int64_t pending_t1;
+	volatile int64_t offset;
+	volatile uint32_t rtt;
+	volatile bool locked;
+
+	uint32_t announce_due;
+	uint32_t delay_due;
+	bool aligning;         // 已对某个播放器setEpoch，条件不满足时需要clearEpoch
+
+	ScenePlayer* activePlayer(uint32_t* scene_id);
+	void send(uint8_t op, const void* payload, uint16_t len, uint32_t ip);
+	void announce();
+	void onAnnounce(const SyncHeader* h, const SyncAnnounce* a, uint32_t ip);
+	void onDelayReq(const SyncDelay* d, uint32_t ip, int64_t rx);
+	void onDelayResp(const SyncDelay* d, int64_t rx);
+	void follow();
+	void resetFilter();
+	static void taskEntry(void* arg);
+
+public:
+	SceneSync();
+	/**
+	 * 启动同步（联网前后都可调用，断网期间只是收不到包）
+	 * @param a/b 场景播放器（播放列表交替使用两个，b可为NULL），正在播放的一个参与同步
+	 * @param group_id 组号（1~255）
+	 */
+	bool begin(Network* network, ScenePlayer* a, ScenePlayer* b, uint8_t group_id);
+	void end();
+	bool isRunning();
+	bool isLeader();
+	// 已测得与主机的时钟偏差（本机为主机时也返回true）
+	bool isLocked();
+	// 主机时钟 - 本机时钟（us）与最近一次采用的往返时延
+	int32_t getOffset();
+	uint32_t getRtt();
+};
+
+extern SceneSync scenesync;
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * @file screen_manager.h
+ *
+ */
+
+#ifndef SCREEN_MANAGER_H
+#define SCREEN_MANAGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/*********************
+	 *      INCLUDES
+	 *********************/
+#include "lvgl.h"
+#include <stddef.h>
+
+	/*********************
+	 *      DEFINES
+	 *********************/
+
+/* 最多登记的屏幕数 */
+#define SCR_MGR_MAX 8
+/* 除当前屏幕外最多保留几个已建好的屏幕（LRU），再离开的屏幕会被删除 */
+#ifndef SCR_MGR_WARM
+#define SCR_MGR_WARM 1
+#endif
+/* 默认切换动画时长（ms） */
+#define SCR_MGR_ANIM_TIME 300
+/* setup期间样式属性表与本地样式的分配区（字节，见lv_style_arena_open），屏幕删除后整块释放 */
+#define SCR_MGR_STYLE_ARENA 512
+
+	/**********************
+	 *      TYPEDEFS
+	 **********************/
+
+	/**
+	 * 屏幕定义
+	 * setup把屏幕对象写到ctx中root_ofs偏移处（如offsetof(lv_ui, home)）；
+	 * cleanup在屏幕被删除后（下一次lv_task_handler或下一次打开前）调用，
+	 * 用于释放样式、清空子对象指针，可以为NULL；
+	 * keep为true的屏幕建好后不会被回收（如被外部模块长期引用的画布）
+	 * 屏幕根对象的event_cb由管理器使用
+	 */
+	typedef struct
+	{
+		const char* name;
+		size_t root_ofs;
+		void (*setup)(void* ctx);
+		void (*cleanup)(void* ctx);
+		bool keep;
+	} scr_mgr_def_t;
+
+	/**********************
+	 * GLOBAL PROTOTYPES
+	 **********************/
+
+	// 登记屏幕表（defs需长期有效），此时不创建任何屏幕
+	void scr_mgr_init(void* ctx, const scr_mgr_def_t* defs, uint8_t cnt);
+	// 切换到屏幕（首次打开时创建），返回屏幕对象；id无效时返回NULL
+	lv_obj_t* scr_mgr_open(uint8_t id, lv_scr_load_anim_t anim, uint32_t time);
+	// 已建好的屏幕对象，未创建时返回NULL
+	lv_obj_t* scr_mgr_get(uint8_t id);
+	// 当前屏幕编号（切换中时为切换目标），当前显示的不是登记的屏幕时返回-1
+	int scr_mgr_current(void);
+	// 删除除当前屏幕外所有可回收的屏幕（内存紧张时调用）
+	void scr_mgr_trim(void);
+	// 重建屏幕（切换语言等之后）：离开的屏幕删除，下次打开时重新创建；当前屏幕立即重建
+	void scr_mgr_rebuild(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*SCREEN_MANAGER_H*/
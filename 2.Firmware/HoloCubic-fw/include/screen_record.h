@@ -0,0 +1,101 @@
+#ifndef SCREEN_RECORD_H
+#define SCREEN_RECORD_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <freertos/semphr.h>
+#include "runtime.h"
+#include "sd_writer.h"
+
+// 1：启动后开始录屏（保存到REC_DIR下的下一个文件名）
+#ifndef SCREEN_RECORD_ON_BOOT
+#define SCREEN_RECORD_ON_BOOT 0
+#endif
+
+// start未指定路径时保存到该目录（rec_0001.hrec……），用3.Software/HoloRec/holo_rec.py还原为视频
+#define REC_DIR "/rec"
+// 每行按REC_SEG_PX像素分段，每段保存上次记录内容的散列，只记录散列变化的段
+#define REC_SEG_PX 32
+// 支持的最大分辨率（每行的段数不超过16，散列表按此检查）
+#define REC_WIDTH_MAX 320
+#define REC_HEIGHT_MAX 320
+// 单个脏矩形数据包的最大字节数（超出时按行拆分），每个包整次写入SdWriter
+#define REC_PACKET_MAX 2048
+// 文件达到该大小后自动停止
+#define REC_FILE_MAX (64UL * 1024UL * 1024UL)
+
+// 文件格式（小端）：
+//   文件头  "HREC" u8版本 u8标志（bit0：像素高低字节交换） u16宽 u16高 u16分段宽度
+//   'R'    u16 x u16 y u16 w u16 h，之后w*h个像素（LVGL颜色格式RGB565，行优先）
+//   'F'    u32 毫秒时间戳：一次刷新结束，此前的矩形构成一帧（没有变化的刷新不写）
+#define REC_VERSION 1
+#define REC_FILE_HEADER 12
+#define REC_RECT_HEADER 9
+#define REC_FRAME_PACKET 5
+
+/**
+ * 录屏（增量记录刷新区域，用于问题报告）
+ *
+ * 在刷新回调上挂旁路（Display::setFlushTap），每个刷新区域按行分段计算散列，
+ * 与上次记录的散列比较，只把变化的段合并为脏矩形（相邻且变化段相同的行合为一个矩形），
+ * 连同像素写入后台SD写入流（SdWriter），一次刷新结束写一个帧标记。
+ * 不保存上一帧图像，只保存每段一个32位散列（240x240时约7.5KB）。
+ * LVGL任务中只有散列与内存复制，SD卡由写入任务访问，可在现场调试时持续开启。
+ *
+ * 缓冲已满丢弃的矩形对应的散列被清除，这些段下次刷新时重新记录；
+ * 开始时整屏失效，第一帧为完整画面。
+ *
+ * 注意事项：
+ * - 只记录经LVGL刷新的内容（调色之前）；场景、效果等经pushRect/pushFrame直接写面板的画面不记录，
+ *   录屏期间直出回调关闭，图像改由LVGL绘制后经刷新回调发送
+ * - 与截图共用刷新旁路，录屏期间截图失败，截图进行中开始录屏失败
+ * - start/stop可在任意任务中调用（不能在中断中调用）
+ */
+class ScreenRecord
+{
+private:
+	Display* display;
+	SdWriter out;
+	SemaphoreHandle_t lock;
+	SemaphoreHandle_t done;
+	uint32_t* hashes;          // 每行每段一个散列，0表示未知（下次必定记录）
+	uint8_t* packet;
+	volatile bool active;
+	bool dirty;                // 上个帧标记之后写过矩形
+	lv_coord_t width;
+	lv_coord_t height;
+	uint8_t segs;              // 每行的段数
+	uint32_t frames;
+	uint32_t rects;
+	uint32_t lost;             // 丢弃的矩形数
+
+	void emit(const lv_area_t* area, const lv_color_t* color_p, lv_coord_t x1, lv_coord_t x2, lv_coord_t y1, lv_coord_t y2);
+	void release();
+	bool runOnUi(ui_msg_cb_t cb);
+	static void tapCb(const lv_area_t* area, const lv_color_t* color_p, void* user);
+	static void startCb(const UiMsg* msg);
+	static void stopCb(const UiMsg* msg);
+
+public:
+	ScreenRecord();
+	void begin(Display* disp);
+	bool isRecording();
+
+	/**
+	 * 开始录屏
+	 * @param path 为NULL时在REC_DIR下取下一个未使用的文件名
+	 * @return 已在录屏、旁路被占用、内存不足或文件无法创建时返回false
+	 */
+	bool start(const char* path = NULL);
+	// 停止录屏，写入剩余数据并关闭文件
+	void stop();
+
+	uint32_t getFrames();
+	uint32_t getRects();
+	uint32_t getLost();
+	uint32_t getBytes();
+};
+
+extern ScreenRecord screenrec;
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef SCREENSHOT_H
+#define SCREENSHOT_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <freertos/stream_buffer.h>
+#include <freertos/semphr.h>
+#include "runtime.h"
+
+// captureToFile未指定路径时保存到该目录（shot_0001.bmp、shot_0002.qoi……）
+#define SHOT_DIR "/shots"
+// 刷新回调与写出端之间的字节流缓冲（编码后的数据），写出端每次取出SHOT_CHUNK字节
+#define SHOT_STREAM_BYTES 4096
+#define SHOT_CHUNK 512
+// 刷新回调等待写出端腾出空间的最长时间（超时则放弃本次截图，不让LVGL任务卡住）
+#define SHOT_ROW_WAIT_MS 500
+// 整次截图的超时（等待刷新与写出）
+#define SHOT_TIMEOUT_MS 5000
+// 支持的最大水平分辨率（行编码缓冲按此分配）
+#define SHOT_WIDTH_MAX 320
+
+enum ShotFormat
+{
+	SHOT_BMP = 0,      // 16位BMP（RGB565位域，自上而下），与屏幕像素一一对应
+	SHOT_QOI           // QOI（RGB888无损压缩），界面截图通常只有BMP的十分之一左右，适合网络传输
+};
+
+// 写出编码后的数据（在调用capture的任务中执行），失败返回false
+typedef bool (*shot_write_t)(const void* data, size_t len, void* user);
+
+/**
+ * 截图（不需要帧缓冲）
+ *
+ * 在刷新回调上挂一个旁路（Display::setFlushTap），再使当前屏幕整屏失效：
+ * 下一次刷新按条带自上而下经过刷新回调，每条带在发送到面板之前逐行编码为BMP或QOI，
+ * 经字节流缓冲交给调用capture的任务写到SD卡文件或网络连接，一次截图正好是一次整屏刷新。
+ * 内存只有字节流缓冲与一行的编码缓冲，与分辨率无关。
+ *
+ * 注意事项：
+ * - capture阻塞到完成，不能在LVGL任务中调用（如上传服务、串口任务、其他后台任务）
+ * - 截图的是LVGL绘制的内容（调色之前）；场景、效果等经pushRect/pushFrame直接写面板的画面不经过刷新回调
+ * - 写出端较慢时（SD卡、网络）该帧的刷新随之变慢
+ * - 同一时刻只进行一次截图；录屏（screen_record.h）进行中截图失败
+ */
+class Screenshot
+{
+private:
+	enum State
+	{
+		SHOT_IDLE = 0,
+		SHOT_ARMED,        // 已挂上旁路，等待从第0行开始的条带
+		SHOT_RUNNING,
+		SHOT_DONE,
+		SHOT_FAILED
+	};
+
+	Display* display;
+	SemaphoreHandle_t lock;
+	StreamBufferHandle_t stream;
+	uint8_t* row;              // 一行的编码缓冲
+	volatile uint8_t state;
+	ShotFormat format;
+	lv_coord_t width;
+	lv_coord_t height;
+	lv_coord_t next_y;         // 下一个要编码的行
+	// QOI编码状态
+	uint32_t qoi_index[64];
+	uint32_t qoi_prev;
+	uint8_t qoi_run;
+
+	size_t header(uint8_t* out);
+	size_t encodeRow(const lv_color_t* px, uint8_t* out);
+	size_t trailer(uint8_t* out);
+	bool send(const uint8_t* data, size_t len);
+	static void tapCb(const lv_area_t* area, const lv_color_t* color_p, void* user);
+	static void startCb(const UiMsg* msg);
+	static void stopCb(const UiMsg* msg);
+
+public:
+	Screenshot();
+	void begin(Display* disp);
+	// 已设置显示且没有截图在进行
+	bool available();
+
+	/**
+	 * 截取下一次整屏刷新，编码后的数据依次交给write
+	 * @return 超时、编码缓冲分配失败、刷新区域不完整或write失败时返回false（已写出的部分不完整）
+	 */
+	bool capture(shot_write_t write, void* user, ShotFormat fmt = SHOT_BMP);
+	/**
+	 * 截图保存到SD卡
+	 * @param path     为NULL时在SHOT_DIR下取下一个未使用的文件名
+	 * @param out_path 不为NULL时写入实际的路径
+	 */
+	bool captureToFile(const char* path = NULL, ShotFormat fmt = SHOT_BMP, char* out_path = NULL, size_t out_len = 0);
+	static const char* extension(ShotFormat fmt);
+};
+
+extern Screenshot screenshot;
+
+#endif
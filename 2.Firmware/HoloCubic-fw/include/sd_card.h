@@ -2,16 +2,70 @@
 #define SD_CARD_H
 
 #include "FS.h"
-#include "SD.h"
 #include "SPI.h"
+
+/**
+ * 存储后端（编译时选择，如build_flags = -DSD_USE_MMC=1）
+ * 0: SPI模式，HSPI总线（默认板载连线：SCLK14 MISO12 MOSI13 CS15）
+ * 1: SDMMC主机，需按SDMMC固定引脚连线：CLK14 CMD15 D0=2 (D1=4 D2=12 D3=13)
+ *    GPIO2/4与屏幕DC/RST冲突，使用前需改线。1线模式只占用CLK/CMD/D0
+ * 其他模块统一通过SD_FS访问文件，LVGL的S:盘直接走FatFs，两种后端均可用
+ */
+#ifndef SD_USE_MMC
+#define SD_USE_MMC 0
+#endif
+#ifndef SD_MMC_1BIT
+#define SD_MMC_1BIT 1
+#endif
+
+#if SD_USE_MMC
+#include "SD_MMC.h"
+#define SD_FS SD_MMC
+#else
+#include "SD.h"
+#define SD_FS SD
+#endif
+
+// SD卡片选引脚（HSPI）
+#define SD_CS_PIN 15
+// 总线时钟（SPI或SDMMC），挂载失败时自动退回SD_SPI_FREQ_SAFE
+#define SD_SPI_FREQ 40000000
+#define SD_SPI_FREQ_SAFE 4000000
+// 顺序读写的单次传输大小（512的整数倍，便于驱动合并为多扇区传输）
+#define SD_IO_CHUNK 4096
+
+/**
+ * 连续存放的文件在卡上的位置（mapContiguous），readSectors据此绕过FatFs直接按扇区读取
+ * 路径为SD_FS中的路径（如"/Scenes/a.holo"），与LVGL的S:盘相同，直接交给FatFs
+ */
+struct SdExtent
+{
+	void* fs;              // FATFS*（内部使用）
+	uint32_t sector;       // 文件第一个扇区
+	uint32_t size;         // 文件大小
+	uint16_t sector_size;
+	uint8_t pdrv;
+};
  
 class SdCard
 {
 private:
-	char buf[128];
+	bool mount(uint32_t freq);
 
 public:
-	void init();
+	void init(uint32_t freq = SD_SPI_FREQ);
+
+	// 卸载后以init时的时钟重新挂载（读写持续失败时由任务监视器触发），此前打开的文件句柄全部失效
+	bool remount();
+
+	// 挂载次数，remount后加1：持有文件句柄的模块据此判断是否需要重新打开
+	uint16_t generation();
+
+	// 最近一次init/remount是否挂载成功
+	bool isMounted();
+
+	// 读取卷的引导扇区，确认卡仍在位且响应（热插拔检测用，不经过FatFs的扇区窗口缓存）
+	bool probe();
 
 	void listDir(  const char* dirname, uint8_t levels);
 
@@ -21,7 +75,8 @@ public:
 
 	void readFile(  const char* path);
 
-	String readFileLine( const char* path, int num);
+	// 读取第num行（从1开始）到调用方的缓冲区，不分配堆内存
+	bool readFileLine(const char* path, int num, char* out, size_t len);
 
 	void writeFile(  const char* path, const char* message);
 
@@ -35,7 +90,17 @@ public:
 
 	void writeBinToSd(const char* path, uint8_t* buf);
 
-	void fileIO(  const char* path);
+	// 为即将写入的空文件找到一段连续的空闲簇（FF_USE_EXPAND），之后顺序写入的簇依次取自这段空间
+	bool preallocate(const char* path, uint32_t size);
+
+	// 文件的FAT片段数：1为连续存放，0为空文件，无法判断（FF_USE_FASTSEEK为0或打开失败）时为-1
+	int32_t countFragments(const char* path);
+
+	// 连续存放的文件返回其扇区位置，碎片化或无法判断时返回false
+	bool mapContiguous(const char* path, SdExtent* ext);
+
+	// 从连续文件的offset（扇区对齐）起读取len字节，按整扇区传输：buf须能容纳len向上取整到扇区的长度
+	bool readSectors(const SdExtent* ext, uint32_t offset, uint8_t* buf, uint32_t len);
 
 };
 
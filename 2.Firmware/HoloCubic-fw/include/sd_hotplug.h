@@ -0,0 +1,81 @@
+#ifndef SD_HOTPLUG_H
+#define SD_HOTPLUG_H
+
+#include <Arduino.h>
+
+// 卡检测引脚（卡座的CD开关），-1为没有（HoloCubic默认），此时定时读取引导扇区判断卡是否仍可用
+#ifndef SD_DETECT_PIN
+#define SD_DETECT_PIN -1
+#endif
+// 插入卡时CD引脚的电平
+#define SD_DETECT_LEVEL LOW
+// 检查周期：有CD引脚时读取电平（两次一致才算变化），没有时读取一个扇区
+#define SD_HOTPLUG_POLL_MS 200
+#define SD_HOTPLUG_PROBE_MS 2000
+// 重新挂载失败（卡仍未插好）后的重试间隔，每次加倍直到MAX
+#define SD_HOTPLUG_RETRY_MS 1000
+#define SD_HOTPLUG_RETRY_MAX_MS 8000
+// 等待正在进行的读写结束的最长时间（超过后照常卸载，读写方会得到失败）
+#define SD_HOTPLUG_QUIESCE_MS 1000
+#define SD_HOTPLUG_TASK_CORE 0
+#define SD_HOTPLUG_TASK_PRIORITY 1
+// 恢复后在本任务中增量重建场景索引，栈与启动任务相同
+#define SD_HOTPLUG_TASK_STACK 6144
+
+enum SdHotplugState
+{
+	SD_STATE_MOUNTED = 0,
+	SD_STATE_LOST          // 卡已拔出或读取失败，读写暂停，等待重新挂载
+};
+
+/**
+ * SD卡热插拔
+ *
+ * 卡在播放中途被拔插或接触不良后，FatFs与卡的状态不再一致，之后的读写全部失败。
+ * 后台任务检测这种情况（CD引脚，或定时读取引导扇区；读写方也可以用reportError()立即触发检查），然后：
+ *   1. 关闭读写门：beginIo()返回false，等待已在进行的读写结束（最多SD_HOTPLUG_QUIESCE_MS）
+ *   2. 持有LVGL锁（S:盘的读取在LVGL任务中）重新挂载（tf.remount()，挂载次数加1），
+ *      使LVGL的文件句柄缓存失效；卡未插好时按退避间隔重试
+ *   3. 打开读写门，各读取方按tf.generation()发现挂载次数变化后重新打开自己的文件（场景播放器重新打开动画包继续播放）
+ *
+ * 读写在其他任务中进行的模块（场景预读、相册后台任务、SD写入任务）用beginIo()/endIo()包围每一段读写；
+ * 在LVGL任务中的读取由LVGL锁保证不与重新挂载并发
+ */
+class SdHotplug
+{
+private:
+	TaskHandle_t task;
+	SemaphoreHandle_t drained;
+	portMUX_TYPE mux;
+	volatile SdHotplugState state;
+	volatile bool closed;
+	volatile uint16_t io_count;
+	uint16_t lost_count;
+	uint32_t retry_ms;
+
+	bool present();
+	void quiesce();
+	bool recover();
+	static void taskEntry(void* arg);
+
+public:
+	SdHotplug();
+	// 启动检测任务（tf.init之后调用；启动时挂载失败的卡在插入后同样会被挂载）
+	bool begin();
+
+	// 开始一段读写：SD卡不可用（已拔出、正在重新挂载）时返回false，此时不要访问SD卡
+	bool beginIo();
+	void endIo();
+	// 读写失败时调用：立即检查卡是否仍可用（任意任务，不阻塞）
+	void reportError();
+
+	bool isRunning();
+	SdHotplugState getState();
+	bool isAvailable();
+	// 检测到的掉卡次数
+	uint16_t getLostCount();
+};
+
+extern SdHotplug sdhotplug;
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef SD_WRITER_H
+#define SD_WRITER_H
+
+#include <Arduino.h>
+#include "ff.h"
+
+// 缓冲块大小（与SD卡簇大小相同时，每次写入都是对齐的整簇）与块数
+#define SD_WRITER_BUF_SIZE 4096
+#define SD_WRITER_BUFS 3
+// 写入任务每SD_WRITER_SYNC_MS把未满的当前块也写入并f_sync，断电时最多丢失这段时间的数据
+#define SD_WRITER_SYNC_MS 1000
+#define SD_WRITER_TASK_CORE 0
+#define SD_WRITER_TASK_PRIORITY 1
+#define SD_WRITER_TASK_STACK 3072
+// printf()单次格式化的最大长度（超出截断）
+#define SD_WRITER_LINE_MAX 128
+
+/**
+ * SD卡后台写入流（日志、传感器记录等持续追加的文件）
+ *
+ * write()只把数据复制进内存中的缓冲块，写满一块交给写入任务，调用方不等待SD卡；
+ * 写入任务按块大小对齐写入整块，并定期f_sync更新目录项。缓冲块都在等待写入时丢弃整次写入并计数。
+ *
+ * 文件偏移按SD_WRITER_BUF_SIZE对齐划分：追加打开时先读回最后一个不完整的块，
+ * 定期同步时未满的块写到它所在的位置，写满后整块再写一次，每次f_write都从簇边界开始
+ *
+ * write()/printf()可在多个任务中调用（不能在中断中调用），数据按调用顺序整段写入
+ */
+class SdWriter
+{
+private:
+	FIL* fil;
+	uint8_t* buf[SD_WRITER_BUFS];
+	uint8_t cur;               // 正在填充的块
+	uint8_t pending;           // cur之前等待写入的整块数
+	uint16_t fill;
+	uint32_t cur_base;         // cur块对应的文件偏移
+	uint32_t synced_end;       // 已写入SD卡的文件末尾
+	volatile bool open;
+	volatile bool stopping;
+	volatile bool sync_req;
+	uint32_t written;
+	uint32_t dropped;
+	TaskHandle_t writer;
+	SemaphoreHandle_t done;
+
+	void release();
+	void flushPending();
+	void flushPartial();
+	static void writerEntry(void* arg);
+
+public:
+	SdWriter();
+	~SdWriter();
+
+	// 打开文件（路径同SD_FS，如"/log/imu.csv"）；append为false时清空已有内容
+	bool begin(const char* path, bool append = true);
+	// 写入剩余数据、同步并关闭文件（等待写入任务完成）
+	void end();
+	bool isOpen();
+
+	// 追加数据，返回写入的字节数；缓冲已满时返回0（整次丢弃）
+	size_t write(const void* data, size_t len);
+	size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+	// 请写入任务尽快写入全部数据并同步（不等待完成）
+	void sync();
+
+	uint32_t getWritten();
+	uint32_t getDropped();
+};
+
+#endif
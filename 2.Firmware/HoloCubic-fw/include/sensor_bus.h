@@ -0,0 +1,101 @@
+#ifndef SENSOR_BUS_H
+#define SENSOR_BUS_H
+
+#include <Arduino.h>
+
+class Ambient;
+
+// 订阅者上限（所有传感器合计）
+#define SENSOR_BUS_MAX_SUBSCRIBERS 8
+
+/**
+ * 总线上的传感器
+ * SENSOR_IMU:     每个送入手势引擎的样本（轮询/FIFO/DMP三种模式均为100Hz）
+ * SENSOR_AMBIENT: 每次BH1750读数（连续高分辨率模式为125ms一次）
+ */
+enum SensorId
+{
+	SENSOR_IMU = 0,
+	SENSOR_AMBIENT,
+	SENSOR_COUNT
+};
+
+/**
+ * 传感器样本快照，按传感器只使用对应的字段，其余为0
+ */
+struct SensorSample
+{
+	uint32_t count;        // 该传感器的累计样本序号，0表示尚无数据
+	uint32_t time_ms;      // 采样时刻（FIFO样本按采样间隔倒推）
+	int16_t accel[3];      // IMU：加速度XYZ（16384/g，已扣除零偏）
+	int16_t gyro[3];       // IMU：角速度XYZ（原始值）
+	uint16_t lux;          // 环境光：本次读数（lx）
+	uint16_t lux_avg;      // 环境光：最近5次的平均（与Ambient::getLux相同）
+};
+
+/**
+ * 样本回调，在发布样本的任务中执行（IMU为传感器任务，环境光为I2C总线任务），
+ * 应尽快返回，不能直接调用lv_*接口（需runtime.post）
+ */
+typedef void (*sensor_bus_cb_t)(const SensorSample* s, void* user);
+
+/**
+ * 传感器总线
+ *
+ * 所有传感器由运行时的传感器任务按各自的周期读取一次，最新样本以序列锁快照发布：
+ * 每个快照只有一个写方（IMU在传感器任务中，环境光在I2C总线任务的读取回调中），
+ * 读方在任意任务中调用get()，不加锁、不访问总线，读到的一组数值总是同一个样本。
+ * 需要每个样本或固定间隔处理的功能（手势、自动旋转）订阅并指定抽取倍数，回调按订阅顺序执行；
+ * 只需要当前值的功能（电源、背光、相册、LED辉光、遥测）直接读快照。
+ * 无论多少功能使用，每个传感器在一个周期内只读取一次。
+ *
+ * 注意事项：
+ * - 订阅只能增加不能取消，应在初始化时完成；begin()之后订阅同样安全（先写入表项再增加计数）
+ * - IMU处于运动唤醒（suspend）时没有新样本，快照保持最后一个样本
+ */
+class SensorBus
+{
+private:
+	struct Slot
+	{
+		volatile uint32_t seq;     // 奇数表示正在写入
+		SensorSample data;
+	};
+	struct Subscriber
+	{
+		uint8_t sensor;
+		uint16_t every;            // 每every个样本回调一次
+		uint16_t left;             // 距下一次回调还差的样本数
+		sensor_bus_cb_t cb;
+		void* user;
+	};
+
+	Ambient* amb;
+	Slot slots[SENSOR_COUNT];
+	Subscriber subs[SENSOR_BUS_MAX_SUBSCRIBERS];
+	volatile uint8_t sub_count;
+	uint32_t amb_due;
+
+public:
+	SensorBus();
+	// 登记由总线调度读取的环境光传感器（传感器任务启动前调用，IMU由传感器任务直接读取），amb可为NULL
+	void begin(Ambient* amb);
+	/**
+	 * 订阅样本
+	 * @param every 抽取倍数：每every个样本回调一次（1为每个样本），IMU为100Hz
+	 * @return 订阅表满时返回false
+	 */
+	bool subscribe(SensorId sensor, uint16_t every, sensor_bus_cb_t cb, void* user = NULL);
+	// 读取最新快照（任意任务，不阻塞写方）；尚无数据时返回false
+	bool get(SensorId sensor, SensorSample* out);
+	uint32_t getCount(SensorId sensor);
+
+	// 发布一个样本并回调订阅者（只由该传感器的写方调用）
+	void publish(SensorId sensor, SensorSample* s);
+	// 传感器任务每轮调用：提交到期的环境光读取，返回距下一次到期的毫秒数
+	uint32_t poll(uint32_t now);
+};
+
+extern SensorBus sensorbus;
+
+#endif
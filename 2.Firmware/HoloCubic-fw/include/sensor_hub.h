@@ -0,0 +1,104 @@
+#ifndef SENSOR_HUB_H
+#define SENSOR_HUB_H
+
+#include <Arduino.h>
+#include "sensor_window.h"
+#include "imu.h"
+#include "ambient.h"
+#include "mqtt_feed.h"
+#include "fleet.h"
+
+// 上报任务：每个周期从传感器取走统计窗口并合并，到各主题的上报周期时发布一次
+#define SENSOR_HUB_TASK_CORE 0
+#define SENSOR_HUB_TASK_PRIORITY 1
+#define SENSOR_HUB_TASK_STACK 4096
+#define SENSOR_HUB_TICK_MS 1000
+// 动态加速度（mg）超过该值视为有人移动/拿起设备
+#define SENSOR_HUB_MOTION_MG 60
+// Home Assistant自动发现的主题前缀
+#define SENSOR_HUB_DISCOVERY_PREFIX "homeassistant"
+// 状态主题：holocubic/<设备名>/<lux|motion|presence|orientation>
+#define SENSOR_HUB_TOPIC_FMT "holocubic/%s/%s"
+// 发现配置过期时间为上报周期的倍数（设备离线后实体变为不可用）
+#define SENSOR_HUB_EXPIRE_FACTOR 3
+
+/**
+ * 传感器中枢（Home Assistant）
+ *
+ * 把环境光、运动/有人、姿态经MQTT低频上报，数据完全来自已有的采样路径：
+ * - 环境光读数与IMU样本在原有的总线回调/传感器任务中计入统计窗口（sensor_window.h），
+ *   本模块只取走窗口，不产生额外的I2C读取，也不保存样本
+ * - 每个上报周期发布一次最小/最大/平均，周期之间的样本全部合并，不丢失峰值
+ * - 有人/无人在状态变化时立即发布（retain）：最近presence_s秒内动态加速度超过SENSOR_HUB_MOTION_MG为有人
+ * - 姿态（pitch/roll）由周期内的平均加速度计算；DMP模式下附带融合得到的yaw
+ * 每次连上代理后发布一次Home Assistant发现配置（retain），设备自动出现在HA中。
+ *
+ * 配置（config.json）：
+ *   hub.enable     启用（还需配置mqtt.uri）
+ *   hub.lux_s      照度上报周期（秒，0为不上报）
+ *   hub.motion_s   运动强度上报周期
+ *   hub.orient_s   姿态上报周期
+ *   hub.presence_s 无运动多少秒后变为无人
+ *   hub.discovery  发布Home Assistant发现配置
+ *
+ * 注意事项：
+ * - 未连接代理时周期到达的统计直接丢弃，重连后从新的周期开始，不在断线期间积压
+ * - IMU处于运动唤醒（suspend）时没有样本：运动强度与姿态的样本数为0时不发布，
+ *   运动唤醒本身会恢复采样，有人状态不受影响
+ */
+class SensorHub
+{
+private:
+	IMU* imu;
+	Ambient* amb;
+	MqttFeed* mq;
+	char name[FLEET_NAME_MAX];
+	TaskHandle_t task;
+	volatile bool running;
+
+	uint16_t lux_s;
+	uint16_t motion_s;
+	uint16_t orient_s;
+	uint16_t presence_s;
+	bool discovery;
+
+	// 当前上报周期内合并的窗口
+	SensorWindow lux;
+	SensorWindow motion;
+	SensorWindow accel[3];
+	uint32_t lux_ms;
+	uint32_t motion_ms;
+	uint32_t orient_ms;
+
+	uint32_t last_motion_ms;
+	bool present;
+	uint32_t announced;      // 已发布发现配置时的连接次数
+	uint32_t published;
+
+	void tick(uint32_t now);
+	void publishLux();
+	void publishMotion();
+	void publishOrientation();
+	void publishPresence();
+	void publishDiscovery();
+	void discover(const char* component, const char* object, const char* label, const char* state,
+				  const char* extra, uint16_t period_s);
+	bool send(const char* object, const char* payload, bool retain = false);
+	static void taskEntry(void* arg);
+
+public:
+	SensorHub();
+	/**
+	 * 启动上报任务（周期等取自配置），imu/amb为NULL或未连接时不上报对应主题
+	 * @param device 设备名（主题与HA设备标识）
+	 */
+	bool begin(IMU* imu, Ambient* amb, MqttFeed* mq, const char* device);
+	void end();
+	bool isPresent();
+	// 已发布的消息数
+	uint32_t getPublishCount();
+};
+
+extern SensorHub sensorhub;
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef SENSOR_WINDOW_H
+#define SENSOR_WINDOW_H
+
+#include <stdint.h>
+
+/**
+ * 传感器统计窗口：最小/最大/累加和/样本数
+ *
+ * 在已有的采样路径（总线回调、传感器任务）中逐个样本累加，只有整数比较与加法；
+ * 读取方整体取走后清零（由调用方加锁），多个窗口可合并成更长的时间段。
+ * 不保存样本本身，窗口长度不影响RAM占用。
+ */
+struct SensorWindow
+{
+	int32_t min;
+	int32_t max;
+	int64_t sum;
+	uint32_t count;
+};
+
+static inline void sensor_window_reset(SensorWindow* w)
+{
+	w->min = INT32_MAX;
+	w->max = INT32_MIN;
+	w->sum = 0;
+	w->count = 0;
+}
+
+static inline void sensor_window_add(SensorWindow* w, int32_t v)
+{
+	if (v < w->min) w->min = v;
+	if (v > w->max) w->max = v;
+	w->sum += v;
+	w->count++;
+}
+
+// 把src并入dst（src为空时不变）
+static inline void sensor_window_merge(SensorWindow* dst, const SensorWindow* src)
+{
+	if (src->count == 0) return;
+	if (src->min < dst->min) dst->min = src->min;
+	if (src->max > dst->max) dst->max = src->max;
+	dst->sum += src->sum;
+	dst->count += src->count;
+}
+
+// 平均值（四舍五入），空窗口为0
+static inline int32_t sensor_window_mean(const SensorWindow* w)
+{
+	if (w->count == 0) return 0;
+	int64_t half = w->count / 2;
+	return (int32_t)(w->sum >= 0 ? (w->sum + half) / w->count : (w->sum - half) / w->count);
+}
+
+#endif
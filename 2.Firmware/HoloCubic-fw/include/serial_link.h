@@ -0,0 +1,139 @@
+#ifndef SERIAL_LINK_H
+#define SERIAL_LINK_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <esp_pm.h>
+
+// 握手阶段的波特率（与启动日志相同），握手后切换到主机请求的波特率
+#define SERIAL_LINK_BOOT_BAUD 115200
+// 默认传输波特率（CH340C/CP2102N均支持2M，主机可在HELLO中指定其他值）
+#define SERIAL_LINK_BAUD 2000000
+// 串口接收缓冲（须在Serial.begin之前设置）：容纳一个完整的发送窗口，SD卡写入期间不丢数据
+#define SERIAL_LINK_RX_BUF 9216
+// 接收任务
+#define SERIAL_LINK_TASK_CORE 0
+#define SERIAL_LINK_TASK_PRIORITY 1
+#define SERIAL_LINK_TASK_STACK 4096
+// 每帧最多的文件数据（DATA帧载荷为4字节偏移 + 数据）
+#define SERIAL_LINK_DATA_MAX 1024
+#define SERIAL_LINK_PAYLOAD_MAX (SERIAL_LINK_DATA_MAX + 4)
+// 发送窗口：未确认的DATA帧数上限（读文件时设备端使用，写文件时告知主机）
+#define SERIAL_LINK_WINDOW 8
+// 读文件时等待确认的超时，超时后从最后确认的偏移重发
+#define SERIAL_LINK_ACK_MS 300
+// 传输模式下无任何帧的时间超过该值时回到握手波特率（主机异常退出）
+#define SERIAL_LINK_IDLE_MS 5000
+#define SERIAL_LINK_PATH_MAX 96
+
+#define SERIAL_LINK_MAGIC0 0xA5
+#define SERIAL_LINK_MAGIC1 0x5A
+#define SERIAL_LINK_VERSION 1
+
+// 帧类型（主机 -> 设备，DATA与END双向）
+#define LINK_HELLO 0x01   // u32 波特率（0为SERIAL_LINK_BAUD），回复ACK(version, window, data_max)
+#define LINK_PUT   0x02   // u32 文件长度 + 路径：开始写入<路径>.part
+#define LINK_DATA  0x03   // u32 偏移 + 数据
+#define LINK_END   0x04   // u32 文件长度 + u32 CRC32：写入结束（主机）/ 读取结束（设备）
+#define LINK_GET   0x05   // u32 起始偏移 + 路径：设备以DATA帧发送文件，最后发送END
+#define LINK_LIST  0x06   // u16 起始序号 + 目录：回复ACK，附带"名称\t长度\n"文本（目录长度为-1）
+#define LINK_BYE   0x07   // 结束传输，回到握手波特率
+#define LINK_ACK   0x80   // u8 状态 + u32 值 + 附加数据（设备 -> 主机，读文件时主机 -> 设备）
+
+// ACK状态
+#define LINK_OK       0
+#define LINK_E_OFFSET 1   // 值为期望的偏移（主机从该偏移重发）
+#define LINK_E_PATH   2
+#define LINK_E_IO     3
+#define LINK_E_CRC    4
+#define LINK_E_STATE  5   // 没有打开的文件，或帧类型不支持
+
+#pragma pack(push, 1)
+
+/**
+ * 帧格式（小端）：[A5 5A][type u8][seq u8][len u16][载荷len字节][CRC32 u32]
+ * CRC32（与zlib相同）覆盖type到载荷末尾；错误的帧直接丢弃，由窗口重传恢复
+ * 帧头之外的字节（未屏蔽的Serial.printf输出等）在寻找帧头时跳过
+ */
+struct LinkFrameHeader
+{
+	uint8_t magic[2];
+	uint8_t type;
+	uint8_t seq;          // 发送方递增，ACK沿用请求帧的seq
+	uint16_t len;
+};
+
+#pragma pack(pop)
+
+/**
+ * 串口高速传输（代替Windows上的HoloTool.exe）
+ *
+ * 使用烧录固件的同一个USB串口：启动后以115200等待主机的HELLO帧，确认后双方切换到高波特率，
+ * 此间暂停日志的串口输出（LOG_SINK_UART），BYE或空闲超时后恢复。
+ *   写文件：PUT -> DATA ... -> END，主机最多有SERIAL_LINK_WINDOW个未确认的DATA帧；
+ *           每帧ACK带上已接收的偏移，偏移不连续时回复E_OFFSET，主机从期望的偏移重发（go-back-N）
+ *   读文件：GET -> 设备发送DATA ... END，主机按偏移确认，设备超时未收到确认时重发
+ * 数据按UPLOAD_WRITE_SIZE攒满后整段写入.part文件，END校验CRC后改名，
+ * /Scenes/下的文件与无线上传一样更新文件清单与场景索引（UploadServer::finish）
+ *
+ * 主机端：3.Software/HoloLink/holo_link.py（推送素材、拉取日志与基准报告）
+ */
+class SerialLink
+{
+private:
+	struct Frame
+	{
+		LinkFrameHeader h;
+		uint8_t payload[SERIAL_LINK_PAYLOAD_MAX + 4];   // 载荷之后是CRC32
+	};
+
+	TaskHandle_t task;
+	esp_pm_lock_handle_t pm_lock;   // 传输期间禁止自动浅睡眠（UART时钟停止会丢数据）
+	volatile bool active;
+	uint8_t saved_sinks;
+	uint8_t tx_seq;
+	uint32_t last_rx_ms;
+	// 串口读入缓冲与帧解析状态
+	uint8_t in[256];
+	uint16_t in_len;
+	uint16_t in_pos;
+	uint16_t got;
+	Frame rx;
+	Frame tx;
+	// 正在写入的文件
+	File file;
+	char path[SERIAL_LINK_PATH_MAX];
+	uint8_t* wbuf;
+	uint32_t wfill;
+	uint32_t offset;
+	uint32_t size;
+	uint32_t crc;
+	bool nak_sent;
+
+	bool readFrame(uint32_t timeout_ms);
+	void send(uint8_t type, uint8_t seq, const void* payload, uint16_t len);
+	void ack(uint8_t status, uint32_t value, const void* extra = NULL, uint16_t extra_len = 0);
+	void handle();
+	void onHello();
+	void onPut();
+	void onData();
+	void onEnd();
+	void onGet();
+	void onList();
+	void leave();
+	bool flushWrite();
+	void closeFile(bool keep);
+	bool getPath(const uint8_t* p, uint16_t len, char* out);
+	static void taskEntry(void* arg);
+
+public:
+	SerialLink();
+	// 启动接收任务（Serial.begin之后调用）
+	bool begin();
+	// 主机已连接并处于高速传输模式
+	bool isActive();
+};
+
+extern SerialLink seriallink;
+
+#endif
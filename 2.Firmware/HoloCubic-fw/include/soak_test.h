@@ -0,0 +1,87 @@
+#ifndef SOAK_TEST_H
+#define SOAK_TEST_H
+
+#include <Arduino.h>
+#include "sd_writer.h"
+#include "runtime.h"
+#include "scene_player.h"
+
+// 1：启动后进入长时间运行测试（循环切换界面与场景、定时触发网络抓取，每分钟记录内存与帧率）
+#ifndef SOAK_TEST_ON_BOOT
+#define SOAK_TEST_ON_BOOT 0
+#endif
+
+// 记录周期与CSV路径（SD卡，追加写入，重启后继续）
+#define SOAK_LOG_PERIOD_MS 60000
+#define SOAK_LOG_DIR "/soak"
+#define SOAK_LOG_PATH "/soak/soak.csv"
+// 每隔多久执行一步负载：依次为打开下一个场景、回到主界面；每SOAK_FETCH_EVERY步触发一次全部数据源的请求
+#define SOAK_STEP_MS 15000
+#define SOAK_FETCH_EVERY 4
+// 趋势判断：最近SOAK_TREND_WINDOW次记录中至少SOAK_TREND_MIN_STEPS次变化，
+// 其中下降的占比不低于SOAK_TREND_PERCENT且窗口末尾低于开头时标记为持续下降
+#define SOAK_TREND_WINDOW 30
+#define SOAK_TREND_MIN_STEPS 2
+#define SOAK_TREND_PERCENT 80
+// 后台任务（与遥测同在核心0）
+#define SOAK_TASK_CORE 0
+#define SOAK_TASK_PRIORITY 1
+#define SOAK_TASK_STACK 4096
+
+// 跟踪趋势的指标（CSV中对应列）
+enum SoakMetric
+{
+	SOAK_HEAP_FREE = 0,    // 内部RAM空闲
+	SOAK_HEAP_LARGEST,     // 内部RAM最大空闲块（heap_caps_get_largest_free_block）
+	SOAK_LV_FREE,          // LVGL堆空闲
+	SOAK_LV_BIGGEST,       // LVGL堆最大空闲块
+	SOAK_STACK_MIN,        // 所有任务中最小的栈历史余量
+	SOAK_FPS,              // 记录周期内的平均帧率（0.1fps）
+	SOAK_METRIC_CNT
+};
+
+/**
+ * 长时间运行（浸泡）测试
+ *
+ * 后台任务每SOAK_STEP_MS经runtime.post在LVGL任务中执行一步负载（场景索引中的场景轮流打开播放、
+ * 回到主界面、刷新全部数据源），每SOAK_LOG_PERIOD_MS取一次遥测采样写入CSV：
+ *
+ *   uptime_min,heap_free,heap_min,heap_largest,heap_frag,lv_free,lv_biggest,lv_frag,lv_fail,
+ *   stack_min,stack_task,fps,flags
+ *
+ * frag为1 - 最大空闲块/空闲总量（千分比），堆总量不变而碎片增加时最大空闲块先下降；
+ * flags列出窗口内持续下降的指标（如"heap_largest|stack_min"），同时LOG_W输出。
+ * 依赖遥测采样（未启动时自动启动）；记录经SdWriter后台写入，不阻塞负载
+ */
+class SoakTest
+{
+private:
+	TaskHandle_t task;
+	ScenePlayer* player;
+	SdWriter log;
+	volatile bool running;
+	uint32_t step;
+	uint32_t scene_pos;
+	uint32_t mark_frames;
+	uint32_t mark_ms;
+
+	uint32_t history[SOAK_METRIC_CNT][SOAK_TREND_WINDOW];
+	uint8_t hist_len;
+	uint8_t hist_pos;
+
+	void record();
+	uint32_t trends(const uint32_t* values);
+	static void stepCb(const UiMsg* msg);
+	static void taskEntry(void* arg);
+
+public:
+	SoakTest();
+	// player为轮流打开场景使用的播放器（通常为全局scene）
+	bool begin(ScenePlayer* scene_player);
+	void end();
+	bool isRunning();
+};
+
+extern SoakTest soak;
+
+#endif
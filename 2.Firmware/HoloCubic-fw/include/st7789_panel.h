@@ -0,0 +1,100 @@
+#ifndef ST7789_PANEL_H
+#define ST7789_PANEL_H
+
+#include <TFT_eSPI.h>
+
+// 1：Display的刷新路径使用按本机配置特化的St7789Panel（窗口设置与DMA排队内联）；0：经TFT_eSPI通用接口
+#ifndef DISP_PANEL_FAST
+#define DISP_PANEL_FAST 1
+#endif
+
+#if DISP_PANEL_FAST && (!defined(ST7789_DRIVER) || !defined(ESP32_DMA) || defined(TFT_PARALLEL_8_BIT))
+#error "St7789Panel需要TFT_eSPI用户配置为ST7789 + ESP32 SPI（DMA），其他配置请设置DISP_PANEL_FAST为0"
+#endif
+
+// TFT_eSPI_ESP32.c中的DMA设备句柄（initDMA时创建）与所在SPI主机
+extern spi_device_handle_t dmaHAL;
+extern spi_host_device_t spi_host;
+
+/**
+ * 按固定配置特化的ST7789面板（SPI单总线、RAM 240x320）
+ *
+ * 继承TFT_eSPI，初始化、DMA与读回等仍由库完成，只替换每次刷新都要执行的两步：
+ *   window()   CASET/RASET/RAMWR直接写SPI寄存器，RAM偏移已在setOrientFlags时算好，
+ *              没有setAddrWindow的视口、基准点与多驱动分支，也不进出事务
+ *   pushDMA()  等待上一次DMA后设置窗口并排队发送；只按面板尺寸（常量）检查范围，
+ *              不做视口裁剪与复制，字节交换开启时（非常规调用）退回pushImageDMA
+ *
+ * 调用方约定：在startWrite()之后调用，像素已为面板字节序（LV_COLOR_16_SWAP），
+ * 缓冲区为可DMA的片内内存且在dmaWait()之前不被改写；方向只能经setOrientFlags设置
+ */
+template <int16_t W, int16_t H, int16_t RAM_LINES = 320>
+class St7789Panel : public TFT_eSPI
+{
+private:
+	static_assert(W > 0 && H > 0 && W <= 240 && H <= RAM_LINES, "ST7789显存为240x320");
+
+	uint16_t x_off;
+	uint16_t y_off;
+	spi_transaction_t trans;   // 同一时刻只有一次DMA在进行
+
+public:
+	St7789Panel() : TFT_eSPI(W, H), x_off(0), y_off(0)
+	{
+		memset(&trans, 0, sizeof(trans));
+	}
+
+	/**
+	 * 写入MADCTL（MV/MX/MY组合，与setRotation(8 + flags)相同）并记下RAM偏移：
+	 * 行倒序时可见区域为显存的最后H行，行列交换后偏移落在列方向
+	 */
+	void setOrientFlags(uint8_t flags)
+	{
+		setRotation(8 + flags);
+		bool my = (flags & 0x04) != 0;
+		bool mv = (flags & 0x01) != 0;
+		x_off = (my && mv) ? RAM_LINES - H : 0;
+		y_off = (my && !mv) ? RAM_LINES - H : 0;
+	}
+
+	// 当前方向下屏幕坐标到显存坐标的偏移（预编码窗口命令时使用）
+	uint16_t xOffset() { return x_off; }
+	uint16_t yOffset() { return y_off; }
+
+	/**
+	 * 设置写入窗口并进入RAMWR（需已startWrite）
+	 */
+	inline void window(int32_t x, int32_t y, int32_t w, int32_t h) __attribute__((always_inline))
+	{
+		uint32_t x0 = x + x_off;
+		uint32_t y0 = y + y_off;
+		addr_row = 0xFFFF;
+		addr_col = 0xFFFF;
+		DC_C; tft_Write_8(TFT_CASET);
+		DC_D; tft_Write_32C(x0, x0 + w - 1);
+		DC_C; tft_Write_8(TFT_PASET);
+		DC_D; tft_Write_32C(y0, y0 + h - 1);
+		DC_C; tft_Write_8(TFT_RAMWR);
+		DC_D;
+	}
+
+	/**
+	 * DMA发送一块像素，排队后立即返回（需已startWrite；完成前不能改写px）
+	 */
+	inline void pushDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* px) __attribute__((always_inline))
+	{
+		if (_swapBytes || (uint32_t)x + w > (uint32_t)_width || (uint32_t)y + h > (uint32_t)_height || w < 1 || h < 1)
+		{
+			pushImageDMA(x, y, w, h, px);
+			return;
+		}
+		if (spiBusyCheck) dmaWait();
+		window(x, y, w, h);
+		trans.user = (void*)1;
+		trans.tx_buffer = px;
+		trans.length = (uint32_t)w * h * 16;
+		if (spi_device_queue_trans(dmaHAL, &trans, portMAX_DELAY) == ESP_OK) spiBusyCheck++;
+	}
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef STORAGE_BENCH_H
+#define STORAGE_BENCH_H
+
+#include <Arduino.h>
+#include "sd_card.h"
+
+// 开机时运行存储基准测试（出厂验收SD卡批次时打开）
+#ifndef STORAGE_BENCH_ON_BOOT
+#define STORAGE_BENCH_ON_BOOT 0
+#endif
+
+// 测试文件大小与随机读取次数
+#define BENCH_FILE_SIZE (1024 * 1024)
+#define BENCH_RANDOM_READS 64
+// 目录规模测试的文件数（依次递增）
+#define BENCH_DIR_SIZES { 16, 64, 256 }
+// 帧序列测试最多读取的帧数
+#define BENCH_MAX_FRAMES 100
+
+/**
+ * 存储基准测试
+ *
+ * 报告格式（每行一项，便于脚本解析）：
+ *   BENCH,<测试项>,<参数>,<数值>,<单位>
+ * 以"BENCH,begin"开始、"BENCH,end"结束；某项无法运行时数值为skip
+ */
+class StorageBench
+{
+private:
+	const char* work_dir;
+	uint8_t* buf;
+	uint32_t buf_size;
+
+	void report(const char* item, uint32_t param, float value, const char* unit);
+	void skip(const char* item, uint32_t param, const char* reason);
+
+	bool prepareFile(const char* path);
+	void seqRead(const char* path, uint32_t chunk);
+	void randomRead(const char* path, uint32_t chunk);
+	void openLatency();
+	void lvFsRead(const char* path, uint32_t chunk);
+	void frameRate(const char* scene_dir);
+
+public:
+	void run(const char* dir = "/bench", const char* scene_dir = "/Scenes/Holo3D");
+};
+
+#endif
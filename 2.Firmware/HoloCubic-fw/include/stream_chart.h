@@ -0,0 +1,76 @@
+#ifndef STREAM_CHART_H
+#define STREAM_CHART_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+
+// 曲线数上限（如IMU三轴）
+#define SCHART_SERIES_MAX 4
+// 水平网格线数（含上下边界之间的等分线，不含边界）
+#define SCHART_GRID_LINES 3
+// 像素与采样缓冲上限（字节）：200x100的RGB565像素环约40KB
+#define SCHART_MAX_BYTES (48U * 1024U)
+
+/**
+ * 实时曲线图（传感器波形，如环境光、IMU各轴）
+ *
+ * lv_chart的lv_chart_set_next每加一个点都要移动整个数组，并按折线重新绘制整个图表区域。
+ * 这里把图表保存为按列的环形像素缓冲（RGB565，背景与网格预先填好）和每条曲线的环形采样缓冲：
+ * 每个新采样只在环中覆盖最旧的一列（背景、网格与各曲线从上一点到本点的竖线），
+ * 绘制时按当前环起点分两段把像素行复制到显示缓冲（相当于整体左移一列），不重新光栅化已有的曲线。
+ * 每采样一次的开销为一列像素（高度个像素），与宽度和曲线形状无关；
+ * 一帧之间到达多个采样时只重绘一次，50Hz采样、30帧/秒刷新也只占很少的CPU时间。
+ *
+ * 注意事项：
+ * - 所有接口必须在LVGL任务中调用，其他任务的采样可经runtime.post或定时器转交
+ * - setRange修改纵轴范围时按采样缓冲重画全部列（一次性开销）
+ * - 不透明、不处理圆角裁剪等绘制遮罩
+ */
+class StreamChart
+{
+private:
+	lv_obj_t* obj;
+	lv_color_t* strip;         // w * h像素，第c列为环中的第c个采样
+	int16_t* samples;          // series_count * w，与像素环同一位置
+	lv_coord_t w;
+	lv_coord_t h;
+	lv_coord_t head;           // 下一个写入的列（也是最旧的一列）
+	lv_coord_t filled;         // 已有采样的列数，不超过w
+	lv_color_t bg;
+	lv_color_t grid;
+	lv_color_t colors[SCHART_SERIES_MAX];
+	uint8_t series_count;
+	int16_t min_v;
+	int16_t max_v;
+
+	void detach();
+	lv_coord_t toY(int16_t v);
+	void drawColumn(lv_coord_t col, bool connect);
+	void redraw();
+	static StreamChart* of(lv_obj_t* o);
+	static lv_design_res_t designCb(lv_obj_t* o, const lv_area_t* clip, lv_design_mode_t mode);
+	static lv_res_t signalCb(lv_obj_t* o, lv_signal_t sign, void* param);
+
+public:
+	StreamChart();
+	/**
+	 * 创建图表，series为曲线数（颜色取colors的前series个），纵轴范围为[min_v, max_v]
+	 * @return 像素与采样缓冲超过SCHART_MAX_BYTES或内存不足时返回false
+	 */
+	bool create(lv_obj_t* parent, lv_coord_t w, lv_coord_t h, uint8_t series, const lv_color_t* colors,
+				int16_t min_v, int16_t max_v, lv_color_t bg = LV_COLOR_BLACK, lv_color_t grid = LV_COLOR_GRAY);
+	void destroy();
+	lv_obj_t* getObj();
+
+	// 加入一个采样点（每条曲线一个值），超出纵轴范围的值画在边界上
+	void push(const int16_t* values);
+	void push(int16_t value);
+	// 修改纵轴范围并重画
+	void setRange(int16_t min_v, int16_t max_v);
+	// 清空曲线
+	void clear();
+	// 第series条曲线的最新值，没有采样时返回0
+	int16_t getLast(uint8_t series);
+};
+
+#endif
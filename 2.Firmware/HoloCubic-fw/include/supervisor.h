@@ -0,0 +1,109 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <Arduino.h>
+
+// 最多监视的阶段数（每个渲染、传感器、总线、预读任务各占一个）
+#define SUP_MAX_STAGES 8
+#define SUP_NAME_LEN 12
+// 耗时直方图的桶数：桶0为<1ms，桶i为[2^(i-1), 2^i)ms，最后一桶为>=1024ms
+#define SUP_HIST_BUCKETS 12
+// 检查任务：优先级高于传感器与I2C任务，它们忙等时仍能运行
+#define SUP_TASK_CORE 0
+#define SUP_TASK_PRIORITY 5
+#define SUP_TASK_STACK 3072
+#define SUP_PERIOD_MS 100
+// 连续失败多少次视为卡住（如I2C总线被拉死时每个事务都超时返回）
+#define SUP_FAIL_LIMIT 10
+// 两次恢复之间的最短间隔，恢复无效时每次加倍，直到SUP_BACKOFF_MAX_MS
+#define SUP_BACKOFF_MS 1000
+#define SUP_BACKOFF_MAX_MS 30000
+// 一段工作超过该时间仍未结束时热重启（界面状态由resume_state恢复），0为只记录不重启
+#ifndef SUP_REBOOT_MS
+#define SUP_REBOOT_MS 20000
+#endif
+
+// 恢复动作，在该阶段所属的任务中执行（下一次enter时），返回是否成功
+typedef bool (*sup_recover_t)(void* user);
+
+/**
+ * 一个阶段的统计（collect()输出，遥测的"stages"）
+ * max_ms/count/fails/hist为两次collect之间的值，stalls/recoveries为累计值
+ */
+struct SupervisorStats
+{
+	char name[SUP_NAME_LEN];
+	uint32_t max_ms;           // 最长一次耗时（仍在停顿中时计入当前已持续的时间）
+	uint32_t count;
+	uint16_t fails;
+	uint16_t stalls;
+	uint16_t recoveries;
+	bool stalled;              // 采样时仍在停顿中
+	uint16_t hist[SUP_HIST_BUCKETS];
+};
+
+/**
+ * 任务监视与停顿检测
+ *
+ * 各子系统任务把每一段工作（一轮LVGL处理、一次IMU读取、一个I2C事务、一帧SD预读）
+ * 用enter()/leave()包围，监视器记录每段的耗时直方图与最大值，并由后台任务每SUP_PERIOD_MS检查：
+ *   - 一段工作超过该阶段的stall_ms仍未结束：记录一次停顿并输出日志，结束时输出停顿时长
+ *   - 连续SUP_FAIL_LIMIT次leave(id, false)，或发生过停顿：在该任务下一次enter时执行恢复动作
+ *     （重新初始化I2C总线、重新挂载SD卡等），不重启整机；无效时按退避间隔重试
+ *   - 超过SUP_REBOOT_MS仍未结束（任务已死锁，恢复动作没有机会执行）：热重启
+ * 恢复动作在所属任务中执行，不会与该任务正在进行的读写并发。
+ * 任务在两段工作之间休眠（等待中断、队列、下一帧）不计入耗时，也不算停顿
+ */
+class Supervisor
+{
+private:
+	struct Stage
+	{
+		char name[SUP_NAME_LEN];
+		uint32_t stall_ms;
+		sup_recover_t recover;
+		void* user;
+		volatile bool busy;
+		volatile uint32_t start_ms;
+		bool stalled;
+		volatile bool pending;     // 需要执行恢复动作
+		uint8_t fail_run;
+		uint32_t retry_ms;         // 最早的恢复时间
+		uint32_t backoff_ms;
+		// 以下受mux保护（遥测任务读取并清零）
+		uint32_t max_ms;
+		uint32_t count;
+		uint16_t fails;
+		uint16_t stalls;
+		uint16_t recoveries;
+		uint16_t hist[SUP_HIST_BUCKETS];
+	};
+
+	Stage stages[SUP_MAX_STAGES];
+	volatile uint8_t stage_count;
+	TaskHandle_t task;
+
+	void check(Stage* s, uint32_t now);
+	static uint8_t bucket(uint32_t ms);
+	static void taskEntry(void* arg);
+
+public:
+	Supervisor();
+	// 启动检查任务（日志之后尽早调用；add可以在之前或之后）
+	bool begin();
+
+	// 登记一个阶段，返回编号；已满时返回-1（之后以-1调用enter/leave无效果）
+	int8_t add(const char* name, uint32_t stall_ms, sup_recover_t recover = NULL, void* user = NULL);
+	// 开始/结束一段工作（只在所属任务中调用）；ok=false计为失败
+	void enter(int8_t id);
+	void leave(int8_t id, bool ok = true);
+	// 请求在下一次enter时执行恢复动作（如调用方自行发现设备无应答）
+	void requestRecover(int8_t id);
+
+	// 读取各阶段统计并清零区间值，返回阶段数
+	uint8_t collect(SupervisorStats* out, uint8_t max);
+};
+
+extern Supervisor supervisor;
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	// SD卡读写字节计数（lv_port_fatfs.c、scene_player.cpp、upload_server.cpp等在实际读写后调用，任意任务）
+	void telemetry_sd_io(uint32_t read, uint32_t written);
+	// 场景播放节奏（scene_player.cpp）：每显示一帧报告相对PTS的偏差（微秒，晚为正）与此前丢弃/重复的帧数
+	void telemetry_scene_frame(int32_t late_us, uint32_t dropped, uint32_t repeated);
+	// 场景预读（scene_player.cpp）：一帧的SD读取耗时与当前环形缓冲深度
+	void telemetry_scene_read(uint32_t read_us, uint8_t depth);
+
+#ifdef __cplusplus
+}
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "render_prof.h"
+#include "supervisor.h"
+#include "energy.h"
+
+// 1：启动后立即开始采样（GET /telemetry需要上传服务，见network.h的NET_UPLOAD_SERVER）
+#ifndef TELEMETRY_ON_BOOT
+#define TELEMETRY_ON_BOOT 0
+#endif
+// 采样周期（帧率、CPU占用、SD吞吐均为两次采样之间的平均值）
+#define TELEMETRY_PERIOD_MS 1000
+#define TELEMETRY_TASK_CORE 0
+#define TELEMETRY_TASK_PRIORITY 1
+#define TELEMETRY_TASK_STACK 4096
+// 统计的最多任务数（超出的任务只计入总量）
+#define TELEMETRY_MAX_TASKS 24
+// JSON输出缓冲区大小（每个任务约70字节，每个监视阶段约110字节，能耗约200字节）
+#define TELEMETRY_JSON_SIZE 4400
+// 1：启动采样时同时启用渲染计时，以便输出刷新与SPI耗时（约40字节/帧的环形缓冲区）
+#define TELEMETRY_RENDER_PROF 1
+// UDP推送的默认端口（setUdpTarget未指定端口时使用）
+#define TELEMETRY_UDP_PORT 9125
+
+/**
+ * 单个任务的CPU占用
+ * cpu_permille需要FreeRTOS运行时统计（CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS），
+ * 未开启时为-1，只输出栈余量
+ */
+struct TelemetryTask
+{
+	char name[configMAX_TASK_NAME_LEN];
+	int16_t cpu_permille;      // 千分比，相对两个核的总时间
+	uint8_t core;              // 0/1，未绑定核时为2
+	uint8_t priority;
+	uint32_t stack_free;       // 栈历史最小余量（字节）
+};
+
+/**
+ * 一次采样
+ */
+struct TelemetrySample
+{
+	uint32_t time_ms;
+	uint32_t interval_ms;
+
+	// 系统堆（内部RAM）
+	uint32_t heap_free;
+	uint32_t heap_min_free;
+	uint32_t heap_largest;
+	// LVGL分配器（见lv_port_mem.h）
+	uint32_t lv_used;
+	uint32_t lv_max_used;
+	uint32_t lv_free;
+	uint32_t lv_biggest;
+	uint32_t lv_fail;
+
+	// 渲染：帧率（0.1fps）；刷新/SPI为每帧平均微秒，渲染计时未启用时为0
+	uint16_t fps_x10;
+	uint32_t flush_us;
+	uint32_t spi_us;
+
+	// SD卡吞吐（字节/秒）
+	uint32_t sd_read_bps;
+	uint32_t sd_write_bps;
+
+	// 场景播放节奏：显示偏差的平均/最大绝对值（微秒）、丢弃与重复的帧数、
+	// 每帧SD读取的平均/最大耗时与环形缓冲深度；期间没有播放时均为0
+	uint16_t scene_frames;
+	uint32_t scene_jitter_us;
+	uint32_t scene_jitter_max_us;
+	uint16_t scene_dropped;
+	uint16_t scene_repeated;
+	uint32_t scene_read_us;
+	uint32_t scene_read_max_us;
+	uint8_t scene_depth;
+
+	// 传感器总线：IMU实际采样率（样本/秒）与最新照度（lx，没有环境光传感器时为0）
+	uint16_t imu_sps;
+	uint16_t lux;
+
+	// WiFi信号（未连接时为0）
+	int8_t rssi;
+
+	// 按部件估计的平均电流（energy.h）
+	EnergyStats energy;
+
+	uint8_t task_count;
+	TelemetryTask task[TELEMETRY_MAX_TASKS];
+
+	// 任务监视的各阶段：期间的耗时直方图、最大耗时与失败次数，累计停顿与恢复次数
+	uint8_t stage_count;
+	int8_t stage_slowest;      // 期间最大耗时最长的阶段，没有时为-1
+	SupervisorStats stage[SUP_MAX_STAGES];
+};
+
+/**
+ * 运行时遥测
+ *
+ * 后台任务每TELEMETRY_PERIOD_MS采样一次：堆与LVGL内存、各任务CPU占用、帧率与刷新耗时、
+ * SD卡读写吞吐、场景播放节奏、WiFi RSSI、按部件估计的电流（energy.h）、各任务阶段的耗时分布与停顿（supervisor.h），结果通过以下方式获取，不再周期性地打印到串口：
+ *
+ *   GET /telemetry           上传服务（upload_server）返回最近一次采样的JSON
+ *   setUdpTarget(ip, port)   每次采样后把同样的JSON以一个UDP报文推送给监控端
+ *   get(&sample)             在固件内读取
+ *
+ * 采样本身在低优先级任务中进行，LVGL任务只多了每帧一次计数
+ */
+class Telemetry
+{
+private:
+	struct TaskMark
+	{
+		TaskHandle_t handle;
+		uint32_t runtime;
+	};
+
+	TelemetrySample last;
+	TaskMark marks[TELEMETRY_MAX_TASKS];
+	uint8_t mark_count;
+	uint32_t mark_total;
+	uint32_t mark_frames;
+	uint32_t mark_us[RENDER_PROF_PHASE_CNT];
+	uint32_t mark_sd_read;
+	uint32_t mark_sd_write;
+	uint32_t mark_imu;
+	uint32_t mark_ms;
+
+	TaskHandle_t task;
+	SemaphoreHandle_t lock;
+	WiFiUDP udp;
+	IPAddress udp_ip;
+	uint16_t udp_port;
+	char* json;
+
+	void sample(TelemetrySample* s);
+	void sampleTasks(TelemetrySample* s);
+	void sampleScene(TelemetrySample* s);
+	static size_t format(const TelemetrySample* s, char* buf, size_t len);
+	static void taskEntry(void* arg);
+
+public:
+	Telemetry();
+	bool begin();
+	void end();
+	bool isRunning();
+
+	void setUdpTarget(IPAddress ip, uint16_t port = TELEMETRY_UDP_PORT);
+	bool get(TelemetrySample* out);
+	size_t toJson(char* buf, size_t len);
+};
+
+extern Telemetry telemetry;
+
+#endif
+
+#endif
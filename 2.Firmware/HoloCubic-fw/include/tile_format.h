@@ -0,0 +1,66 @@
+#ifndef TILE_FORMAT_H
+#define TILE_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * .htl 分块大图格式（与3.Software/ImageToHolo/convertor/tiles.py保持一致）
+ *
+ * 文件布局（小端）：
+ *   [TileHeader][TileEntry * tile_count][分块数据...]
+ *
+ * - 图像按tile_w x tile_h分块保存，多级金字塔：第0级为原图，第n级为原图的1/2^n（BOX平均），
+ *   最后一级不大于240x240（相册的总览）；第n级的尺寸为(width >> n, height >> n)，至少为1
+ * - 索引按级别、行、列的顺序排列，第n级有ceil(w_n / tile_w) * ceil(h_n / tile_h)块；
+ *   右、下边缘的分块同样是完整的tile_w x tile_h，图像以外的部分为黑色
+ * - 每块单独选择编码（TileEntry.codec），解码后均为tile_w x tile_h的RGB565：
+ *   TILE_CODEC_RAW  小端RGB565原始像素
+ *   TILE_CODEC_Q565 Q565_MAGIC + Q565操作码（见q565_decoder.h），大面积同色时只有几十字节
+ *   TILE_CODEC_JPEG 一幅基线JPEG（照片类全景图）
+ * - max_tile_size为最大一块的字节数，读取端按它分配一个读缓冲即可读任意一块
+ * - entry_size为单条索引长度，新版本可在条目末尾追加字段，读取时按entry_size步进
+ */
+
+#define TILE_MAGIC "HTIL"
+#define TILE_VERSION 1
+
+// 读取端支持的分块与级数上限（分块缓存按TILE_SIZE_MAX分配）
+#define TILE_SIZE_MAX 64
+#define TILE_LEVELS_MAX 8
+#define TILE_ENTRY_SIZE_MIN 9
+
+// TileEntry.codec
+#define TILE_CODEC_RAW 0
+#define TILE_CODEC_Q565 1
+#define TILE_CODEC_JPEG 2
+
+#pragma pack(push, 1)
+
+struct TileHeader
+{
+	char magic[4];
+	uint16_t version;
+	uint16_t header_size;
+	uint16_t width;            // 第0级尺寸
+	uint16_t height;
+	uint16_t tile_w;
+	uint16_t tile_h;
+	uint8_t levels;
+	uint8_t entry_size;        // TILE_ENTRY_SIZE_MIN或更大
+	uint16_t reserved;
+	uint32_t index_offset;
+	uint32_t tile_count;       // 所有级别的分块总数
+	uint32_t max_tile_size;
+};
+
+struct TileEntry
+{
+	uint32_t offset;           // 分块数据在文件中的绝对偏移
+	uint32_t size;
+	uint8_t codec;             // TILE_CODEC_x
+	uint8_t reserved[3];
+};
+
+#pragma pack(pop)
+
+#endif
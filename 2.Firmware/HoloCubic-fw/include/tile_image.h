@@ -0,0 +1,149 @@
+#ifndef TILE_IMAGE_H
+#define TILE_IMAGE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "lvgl.h"
+#include "tile_format.h"
+#include "jpeg_decoder.h"
+
+// 查看器的分块缓存：至少能放下视口一列（或一行）的分块，最多放下一列加一行（斜向平移）
+#define TILE_VIEW_CACHE_MIN 5
+#define TILE_VIEW_CACHE_MAX 10
+// 倾斜平移：定时器周期、死区（加速度原始值，相对进入时的姿态）、每像素对应的倾斜量与单次最大位移
+#define TILE_VIEW_PAN_MS 33
+#define TILE_VIEW_TILT_DEAD 1500
+#define TILE_VIEW_TILT_PER_PX 400
+#define TILE_VIEW_PAN_MAX 24
+
+// 解码过程中检查是否中止（后台任务生成缩略图时用），返回true即中止
+typedef bool (*tile_abort_cb_t)(void* user);
+
+/**
+ * .htl分块大图读取（格式见tile_format.h）
+ * 只读入文件头，分块索引与数据按需读取，占用的内存与图像大小无关：
+ * 一个max_tile_size的读缓冲，JPEG分块另需tjpgd工作区
+ * 每个对象只能在一个任务中使用
+ */
+class TileImage
+{
+private:
+	File file;
+	TileHeader hdr;
+	uint32_t level_base[TILE_LEVELS_MAX];  // 各级第一块在索引中的序号
+	uint8_t* rd_buf;
+	JpegDecoder jpeg;
+	lv_color_t* jpeg_out;
+
+	static bool jpegBand(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px);
+
+public:
+	TileImage();
+	~TileImage();
+	// path为SD卡路径（不带S:）
+	bool open(const char* path);
+	void close();
+	bool isOpen();
+
+	// 读取文件头（相册建立索引时用），只检查格式，返回第0级尺寸与级数
+	static bool probe(File& f, uint16_t* w, uint16_t* h, uint8_t* levels);
+
+	uint8_t getLevels();
+	uint16_t getTileW();
+	uint16_t getTileH();
+	uint16_t getWidth(uint8_t level);
+	uint16_t getHeight(uint8_t level);
+	uint16_t getCols(uint8_t level);
+	uint16_t getRows(uint8_t level);
+
+	/**
+	 * 解码一块到out（tile_w * tile_h像素，行优先，按lv_color_t的内存布局）
+	 * @return 越界、读取失败或数据损坏时返回false
+	 */
+	bool decodeTile(uint8_t level, uint16_t col, uint16_t row, lv_color_t* out);
+
+	/**
+	 * 把一级按step抽样写到dst（dst_w x dst_h，超出该级的部分不写），tile为一块大小的临时缓冲
+	 * 用于相册的总览与缩略图（最后一级）
+	 */
+	bool renderLevel(uint8_t level, lv_color_t* dst, uint16_t dst_w, uint16_t dst_h, uint8_t step,
+					 lv_color_t* tile, tile_abort_cb_t abort_cb = NULL, void* user = NULL);
+};
+
+/**
+ * 分块大图查看器
+ *
+ * 在父对象上建一个视口大小的图像对象（不大于屏幕），视口内容保存在一个屏幕大小的缓冲中：
+ * - 平移时把缓冲中仍可见的部分移到新位置，只为新露出的条带解码分块
+ * - 分块解码结果放在LRU分块缓存（TILE_VIEW_CACHE_MIN~MAX块，按可分配的内存决定），
+ *   缓慢平移时同一列/行的分块在接下来几次平移中直接复制
+ * - 缩放在金字塔各级之间切换（每级2倍），保持视口中心
+ * - 倾斜平移：按传感器总线的IMU快照，相对进入时的姿态向倾斜方向移动，越倾斜越快
+ * 分块在LVGL任务中同步解码（一块SD读取与Q565解码约几毫秒）
+ *
+ * 所有接口必须在LVGL任务中调用
+ */
+class TileViewer
+{
+private:
+	struct Slot
+	{
+		lv_color_t* buf;
+		uint32_t stamp;
+		uint16_t col;
+		uint16_t row;
+		uint8_t level;
+		bool valid;
+	};
+
+	TileImage image;
+	lv_obj_t* img;
+	lv_img_dsc_t dsc;
+	lv_color_t* view;
+	bool own_view;
+	uint16_t vw;               // 视口尺寸（当前级别不大于屏幕时为该级尺寸）
+	uint16_t vh;
+	uint8_t level;
+	int32_t vx;                // 视口左上角在当前级别中的坐标
+	int32_t vy;
+	Slot slots[TILE_VIEW_CACHE_MAX];
+	uint8_t slot_count;
+	uint32_t stamp;
+	uint32_t decoded;
+	uint32_t hits;
+	lv_task_t* task;
+	int16_t base_ax;
+	int16_t base_ay;
+
+	lv_color_t* getTile(uint16_t col, uint16_t row);
+	void render(int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+	void shift(int32_t dx, int32_t dy);
+	void clampOrigin();
+	void layout();
+	static int32_t tiltStep(int32_t over);
+	static void taskCb(lv_task_t* t);
+
+public:
+	TileViewer();
+	/**
+	 * 打开大图并显示第level级（视口居中，超出级数时为最后一级）
+	 * @param buf 视口缓冲（至少屏幕大小），NULL时自行分配
+	 * @return 文件无效或内存不足时返回false
+	 */
+	bool open(const char* path, lv_obj_t* parent, uint8_t level, lv_color_t* buf = NULL, uint32_t buf_size = 0);
+	void close();
+	bool isOpen();
+
+	// 切换到另一级，视口中心对应原图中的同一点
+	bool setLevel(uint8_t new_level);
+	uint8_t getLevel();
+	uint8_t getLevels();
+	// 平移（像素，按当前级别），到达边缘时停止
+	void panBy(int32_t dx, int32_t dy);
+	// 倾斜平移：开启时以当前姿态为中性位置
+	void setTilt(bool on);
+	// 分块解码次数与缓存命中次数
+	void getStats(uint32_t* decodes, uint32_t* cache_hits);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef TIME_SERVICE_H
+#define TIME_SERVICE_H
+
+#include <Arduino.h>
+#include <time.h>
+
+// NTP服务器与时区（固定偏移，不处理夏令时）
+#define TIME_NTP_SERVER "ntp.aliyun.com"
+#define TIME_NTP_PORT 123
+#define TIME_TZ_OFFSET_S (8 * 3600)
+// 早于该时间戳视为时钟尚未同步（2020-09-13）
+#define TIME_VALID_EPOCH 1600000000L
+// 校时周期（在后台抓取的网络窗口中进行）、失败后的重试间隔、单次请求的超时与次数
+#define TIME_SYNC_INTERVAL_S (6 * 3600)
+#define TIME_RETRY_S 300
+#define TIME_NTP_TIMEOUT_MS 1500
+#define TIME_NTP_TRIES 2
+// 两次校时间隔超过TIME_DRIFT_MIN_S才估计频偏（间隔太短时网络抖动占主导）；频偏上限（ppb）
+#define TIME_DRIFT_MIN_S 1800
+#define TIME_DRIFT_MAX_PPB 200000
+// 往返时间超过该值的应答不采用（时间误差最大为往返时间的一半）
+#define TIME_RTT_MAX_MS 800
+// RTC内存中的时间快照的刷新周期（重启后按RTC时钟推算，误差只来自快照之后的这段时间）
+#define TIME_RTC_SAVE_S 60
+
+#define TIME_RTC_MAGIC 0x31535448   // "HTS1"
+#define TIME_RTC_VERSION 1
+
+/**
+ * 时间来源
+ */
+enum TimeSource
+{
+	TIME_SRC_NONE = 0,     // 尚未同步：now()返回0
+	TIME_SRC_RTC,          // 重启前的快照按RTC时钟推算（尚未联网校准）
+	TIME_SRC_NTP           // NTP校时
+};
+
+/**
+ * 按秒缓存的格式化结果（每个格式、每个调用处一个，调用方保证不被同时使用）
+ */
+struct TimeText
+{
+	time_t sec;
+	char text[32];
+};
+
+/**
+ * 时间服务
+ *
+ * - nowMs()/now()只读esp_timer并按上次校时的基准与频偏推算（一次定点乘法，不经newlib的gettimeofday），
+ *   可在任何任务与日志中频繁调用
+ * - 校时由后台抓取任务在网络窗口中调用sync()：直接发一个SNTP请求（UDP，超时TIME_NTP_TIMEOUT_MS），
+ *   按往返时间补偿；两次NTP校时之间的误差用于估计本机晶振的频偏，之后的推算按频偏修正
+ * - 基准定期以RTC时钟（软件复位、看门狗、深度睡眠不清零）为参照写入RTC内存，
+ *   重启后begin()立即恢复时间，不必等待联网
+ * - 校时后同时设置系统时间（settimeofday）与TZ，仍调用time()/localtime_r的代码结果一致
+ * - toLocal()按天缓存日期部分，同一天内只做除法；format()按秒缓存strftime的结果
+ */
+class TimeService
+{
+private:
+	// 推算基准：epoch_us对应的esp_timer时间与频偏（mux保护）
+	int64_t base_epoch_us;
+	int64_t base_timer_us;
+	int32_t drift_ppb;
+	int64_t drift_q32;             // 频偏的Q32定点数（每微秒的修正量），推算时只做乘法与移位
+	portMUX_TYPE mux;
+	volatile TimeSource source;
+	int64_t last_ntp_timer_us;     // 上次NTP校时的esp_timer时间，0为没有
+	uint32_t next_sync_ms;
+	uint32_t saved_ms;
+	int16_t last_error_ms;         // 上次校时时推算值与服务器的差
+	uint16_t last_rtt_ms;
+
+	// 日期缓存（mux保护）
+	time_t day_start;              // 当地时间当天0点的时间戳
+	struct tm day_tm;
+
+	int64_t epochAt(int64_t timer_us);
+	void rebase(int64_t epoch_us, int64_t timer_us, int32_t drift);
+	bool query(int64_t* server_us, int64_t* timer_us, uint16_t* rtt_ms);
+	void saveRtc();
+	bool restoreRtc();
+
+public:
+	TimeService();
+	// 设置TZ并从RTC内存恢复时间（setup中尽早调用）
+	void begin();
+
+	// 自1970年起的毫秒数/秒数，尚未同步时返回0
+	int64_t nowMs();
+	time_t now();
+	bool isValid();
+	TimeSource getSource();
+
+	// 当地时间；t为0或无效时返回false
+	bool toLocal(time_t t, struct tm* out);
+	bool local(struct tm* out);
+	// 按fmt（strftime）格式化当前当地时间，同一秒内直接返回缓存；尚未同步时返回""
+	const char* format(TimeText* cache, const char* fmt);
+
+	// 是否需要校时，以及距下次校时的毫秒数（后台抓取任务据此安排网络窗口）
+	bool syncDue();
+	uint32_t msToSync();
+	// 校时（网络已连接时在后台抓取任务中调用，最多阻塞TIME_NTP_TRIES * TIME_NTP_TIMEOUT_MS）
+	bool sync();
+	// 定期调用（后台抓取任务每次唤醒）：刷新RTC内存中的快照
+	void poll();
+
+	int32_t getDriftPpb();
+	int16_t getLastErrorMs();
+	uint16_t getLastRttMs();
+};
+
+extern TimeService timesvc;
+
+#endif
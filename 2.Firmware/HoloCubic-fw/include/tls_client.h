@@ -0,0 +1,70 @@
+#ifndef TLS_CLIENT_H
+#define TLS_CLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+
+// 握手超时
+#define TLS_HANDSHAKE_TIMEOUT_MS 8000
+// 会话缓存条数（按主机名，一个数据源主机一条）
+#define TLS_SESSION_CACHE 4
+// SD卡上的CA证书包（PEM，可包含多张证书）
+#define TLS_CA_BUNDLE_PATH "/certs/ca.pem"
+
+/**
+ * 支持会话复用的TLS客户端
+ * 继承WiFiClient以便直接交给HTTPClient::begin(client, url)使用：
+ * TCP收发走父类，mbedtls在其上完成TLS。
+ * - CA证书包只解析一次，所有连接共用同一份mbedtls配置
+ * - 握手成功后按主机名保存会话（会话ID或会话票据），下次连接同一主机时恢复，
+ *   服务器接受时省去证书交换与密钥协商，握手从几百毫秒降到一个往返
+ */
+class TlsClient : public WiFiClient
+{
+private:
+	mbedtls_ssl_context ssl;
+	bool active;
+	int peeked;
+	char host[48];
+	bool resumed;
+	uint8_t resume_id[32];
+	size_t resume_len;
+
+	bool handshake();
+	void saveSession();
+	void restoreSession();
+	static int bioSend(void* ctx, const unsigned char* buf, size_t len);
+	static int bioRecv(void* ctx, unsigned char* buf, size_t len);
+
+public:
+	TlsClient();
+	~TlsClient();
+
+	static bool loadCaBundle(const char* pem, size_t len);
+	static bool loadCaFile(const char* path = TLS_CA_BUNDLE_PATH);
+	static bool hasCa();
+
+	int connect(IPAddress ip, uint16_t port) override;
+	int connect(IPAddress ip, uint16_t port, int32_t timeout) override;
+	int connect(const char* host, uint16_t port) override;
+	int connect(const char* host, uint16_t port, int32_t timeout) override;
+
+	size_t write(uint8_t data) override;
+	size_t write(const uint8_t* buf, size_t size) override;
+	int available() override;
+	int read() override;
+	int read(uint8_t* buf, size_t size) override;
+	int peek() override;
+	void flush() override;
+	void stop() override;
+	uint8_t connected() override;
+
+	bool isResumed();
+};
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file ui_builder.h
+ *
+ */
+
+#ifndef UI_BUILDER_H
+#define UI_BUILDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/*********************
+	 *      INCLUDES
+	 *********************/
+#include "lvgl.h"
+#include <stddef.h>
+
+	/*********************
+	 *      DEFINES
+	 *********************/
+
+/* ui_obj_def_t.slot：不写回lv_ui */
+#define UI_NO_SLOT 0xFFFF
+/* ui_obj_def_t.parent：屏幕根对象（表中第0项）没有父对象 */
+#define UI_NO_PARENT 0xFF
+/* 一个屏幕最多的对象数（父对象按表中序号引用） */
+#define UI_BUILD_MAX 32
+/* ui_obj_def_t.align：不对齐，使用x/y作为绝对位置 */
+#define UI_NO_ALIGN 0xFF
+
+/* ui_obj_def_t.flags */
+#define UI_F_HIDDEN   0x01
+#define UI_F_NO_CLICK 0x02
+
+/*
+ * 常量样式表（由scripts/ui_compile.py生成）
+ * LVGL 7的样式属性表是按(uint16_t 属性|状态<<8, 值)顺序排列、以_LV_STYLE_CLOSING_PROP结尾的字节数组，
+ * 值为lv_style_int_t（2字节）、lv_color_t（2字节）或lv_opa_t（1字节），小端。
+ * 表放在flash中，lv_obj_add_style只保存指针；常量样式不能再调用lv_style_set_*或lv_style_reset
+ */
+#define UI_PROP(prop, state) \
+	(uint8_t)(((prop) | ((state) << LV_STYLE_STATE_POS)) & 0xFF), (uint8_t)(((prop) | ((state) << LV_STYLE_STATE_POS)) >> 8)
+#define UI_INT(v) (uint8_t)((uint16_t)(v) & 0xFF), (uint8_t)((uint16_t)(v) >> 8)
+#define UI_OPA(v) (uint8_t)(v)
+/* 0xRRGGBB -> RGB565（按LV_COLOR_16_SWAP的字节序） */
+#define UI_RGB565(hex) \
+	(uint16_t)((((hex) >> 8) & 0xF800) | (((hex) >> 5) & 0x07E0) | (((hex) >> 3) & 0x001F))
+#if LV_COLOR_16_SWAP
+#define UI_COLOR(hex) (uint8_t)(UI_RGB565(hex) >> 8), (uint8_t)(UI_RGB565(hex) & 0xFF)
+#else
+#define UI_COLOR(hex) (uint8_t)(UI_RGB565(hex) & 0xFF), (uint8_t)(UI_RGB565(hex) >> 8)
+#endif
+#define UI_STYLE_END UI_INT(_LV_STYLE_CLOSING_PROP)
+
+#if LV_USE_ASSERT_STYLE
+#define UI_STYLE_INIT(map) { (uint8_t*)(map), LV_DEBUG_STYLE_SENTINEL_VALUE }
+#else
+#define UI_STYLE_INIT(map) { (uint8_t*)(map) }
+#endif
+
+	/**********************
+	 *      TYPEDEFS
+	 **********************/
+
+	typedef enum
+	{
+		UI_OBJ_BASE = 0,
+		UI_OBJ_IMG,
+		UI_OBJ_LABEL,
+		UI_OBJ_CPICKER,
+		UI_OBJ_TYPE_CNT
+	} ui_obj_type_t;
+
+	typedef struct
+	{
+		uint8_t part;
+		const lv_style_t* style;
+	} ui_style_ref_t;
+
+	/**
+	 * 对象定义（按创建顺序排列，父对象总在子对象之前）
+	 * slot为对象指针在lv_ui中的偏移（offsetof(lv_ui, home_cpicker0)），src按类型解释：
+	 * IMG为图像源，LABEL为静态文字（lv_label_set_text_static，不复制），其他类型忽略；
+	 * arg按类型解释：CPICKER为lv_cpicker_type_t
+	 */
+	typedef struct
+	{
+		uint16_t slot;
+		uint8_t parent;
+		uint8_t type;
+		uint8_t align;
+		uint8_t flags;
+		int16_t arg;
+		lv_coord_t x;
+		lv_coord_t y;
+		lv_coord_t w;           // 0：保持控件默认尺寸
+		lv_coord_t h;
+		const void* src;
+		const ui_style_ref_t* styles;
+		uint8_t style_cnt;
+	} ui_obj_def_t;
+
+	typedef struct
+	{
+		const char* name;
+		const ui_obj_def_t* objs;
+		uint8_t obj_cnt;
+	} ui_scr_def_t;
+
+	/**********************
+	 * GLOBAL PROTOTYPES
+	 **********************/
+
+	// 按定义表创建屏幕（LVGL任务），对象指针写入ctx（lv_ui），返回屏幕根对象，失败返回NULL
+	lv_obj_t* ui_build(void* ctx, const ui_scr_def_t* def);
+	// 屏幕删除后清空ctx中子对象的指针（根对象由屏幕管理器处理，常量样式无需释放）
+	void ui_unbuild(void* ctx, const ui_scr_def_t* def);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*UI_BUILDER_H*/
@@ -0,0 +1,21 @@
+/*
+ * 由scripts/ui_compile.py根据ui目录下的屏幕描述生成，请勿手工修改
+ */
+
+#ifndef UI_TABLES_H
+#define UI_TABLES_H
+
+#include "ui_builder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	extern const ui_scr_def_t ui_scr_home;
+	extern const ui_scr_def_t ui_scr_scenes;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef UPLOAD_SERVER_H
+#define UPLOAD_SERVER_H
+
+#include <Arduino.h>
+#include <esp_http_server.h>
+#include <FS.h>
+#include "ota_update.h"
+
+#define UPLOAD_SERVER_PORT 80
+// httpd任务：文件系统操作需要较大的栈
+#define UPLOAD_TASK_CORE 0
+#define UPLOAD_TASK_PRIORITY 2
+#define UPLOAD_TASK_STACK 6144
+// 单次写入SD卡的大小：FatFs对整扇区的f_write直接从用户缓冲区做多扇区传输，
+// 不经过扇区缓存。取FAT簇大小的典型值（SD_IO_CHUNK的2倍）
+#define UPLOAD_WRITE_SIZE 8192
+// 只允许写入该目录（场景根目录）
+#define UPLOAD_ROOT "/Scenes/"
+#define UPLOAD_PATH_MAX 96
+// 接收超时次数上限（每次为httpd的recv_wait_timeout）
+#define UPLOAD_RECV_RETRIES 3
+
+/**
+ * 无线上传服务
+ * 基于esp_http_server，上传内容边接收边写入SD卡，不在内存中缓存整个文件：
+ *
+ *   PUT /upload?path=/Scenes/xxx.holo[&offset=N][&final=0][&size=N]   请求体为文件内容
+ *   PUT /upload?path=/Scenes/xxx.holo&patch=1&offset=N[&final=0]       请求体写入已有文件的offset处
+ *   GET /upload?path=/Scenes/xxx.holo                                 返回已接收的字节数（断点续传）
+ *   GET /scenes                                                       返回场景索引（文本，见scene_index.h）
+ *   GET /telemetry                                                    返回运行时遥测（JSON，见telemetry.h）
+ *   GET /screenshot[?format=qoi]                                      截取下一次整屏刷新（BMP或QOI，见screenshot.h）
+ *   PUT /ota[?sha256=...]                                             请求体为固件镜像（需先setOta）
+ *
+ * - 数据先写入<path>.part，final（默认1）时改名为目标文件并重建场景索引
+ * - 大文件可分多次PUT，offset须等于已接收的字节数，否则返回409及当前长度；
+ *   每段长度取UPLOAD_WRITE_SIZE的整数倍时，每次写入都与簇边界对齐
+ * - 第一段（offset为0）带上size（文件总长）时，先为文件预留一段连续的空闲簇（SdCard::preallocate）
+ * - patch直接改写目标文件（不经.part，保留原有簇链），offset不超过当前长度，不能截短文件；
+ *   用于差量同步只上传变化的块，最后一块带final（默认1）时更新场景索引
+ * - 覆盖正在播放的场景前应先关闭场景播放器
+ */
+class UploadServer
+{
+private:
+	httpd_handle_t server;
+	OtaUpdate* ota;
+
+	static esp_err_t putHandler(httpd_req_t* req);
+	static esp_err_t statusHandler(httpd_req_t* req);
+	static esp_err_t scenesHandler(httpd_req_t* req);
+	static esp_err_t telemetryHandler(httpd_req_t* req);
+	static esp_err_t screenshotHandler(httpd_req_t* req);
+	static esp_err_t otaHandler(httpd_req_t* req);
+	static bool getPath(httpd_req_t* req, char* query, size_t query_len, char* path);
+	static bool receive(httpd_req_t* req, File& f);
+
+public:
+	UploadServer();
+	bool begin(uint16_t port = UPLOAD_SERVER_PORT);
+	void end();
+	bool isRunning();
+	void setOta(OtaUpdate* updater);
+
+	// 创建路径中缺少的上级目录（串口传输也使用）
+	static bool makeParents(const char* path);
+	// 文件写入完成：作废清单记录与LVGL文件句柄，更新所在场景的索引（串口传输也使用）
+	static void finish(const char* path);
+};
+
+#endif
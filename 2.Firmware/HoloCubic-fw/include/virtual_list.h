@@ -0,0 +1,98 @@
+#ifndef VIRTUAL_LIST_H
+#define VIRTUAL_LIST_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+
+// 行对象池上限：可见行数加1（半行露出）加1（滚动时另一端露出），240像素高、20像素行高时为14
+#define VLIST_POOL_MAX 16
+// 每行的主文字与右侧附加文字（长度、帧数等）缓冲，超出部分截断
+#define VLIST_TEXT_MAX 48
+#define VLIST_DETAIL_MAX 16
+// 选中行移出可见区域时滚动动画的时长
+#define VLIST_ANIM_MS 150
+// 拖动超过该距离后松开不算点击
+#define VLIST_DRAG_LIMIT 6
+
+/**
+ * 取一行的数据（在LVGL任务中调用），text/detail为该行的缓冲，返回false时该行显示为空
+ * 例如从SceneIndex::get读取条目并格式化名称与时长
+ */
+typedef bool (*vlist_fetch_t)(uint32_t index, char* text, uint16_t text_len, char* detail, uint16_t detail_len,
+							  void* user);
+// 按下编码器或点击某行
+typedef void (*vlist_select_t)(uint32_t index, void* user);
+
+/**
+ * 虚拟列表（大数据量的文件浏览、日志查看）
+ *
+ * lv_list/lv_table为每一行创建对象（lv_list每行一个按钮加一个标签，约300字节），
+ * 32KB的LVGL内存在几十行时就会耗尽。这里只创建覆盖可见区域所需的行对象（最多VLIST_POOL_MAX行），
+ * 第i项固定由第i % 行数个行对象显示：滚动一行时只有移入的一行重新取数据，其他行只改变位置。
+ * 条目数只是一个整数，内存占用与条目数无关；滚动位置为32位（lv_page的坐标为16位，超过约1600行会溢出）。
+ *
+ * 输入：编码器（左右倾斜）或按键上下移动选中行，确认键调用选中回调；触摸时拖动滚动，点击选中。
+ * 注意事项：
+ * - 所有接口必须在LVGL任务中调用；控件随父对象删除时自动释放
+ * - 数据源变化（条目增删、索引重建）后调用setCount或refresh
+ */
+class VirtualList
+{
+private:
+	struct Row
+	{
+		lv_obj_t* obj;
+		lv_obj_t* text;
+		lv_obj_t* detail;
+		int32_t index;         // 显示的条目，-1为未使用
+		char text_buf[VLIST_TEXT_MAX];
+		char detail_buf[VLIST_DETAIL_MAX];
+	};
+
+	lv_obj_t* obj;
+	Row rows[VLIST_POOL_MAX];
+	uint8_t row_count;
+	lv_coord_t row_h;
+	uint32_t count;
+	int32_t offset;            // 内容顶端到第一个像素的距离
+	int32_t selected;          // -1为没有
+	int32_t anim_from;
+	int32_t anim_to;
+	lv_coord_t drag_sum;
+	vlist_fetch_t fetch;
+	vlist_select_t on_select;
+	void* user;
+
+	void detach();
+	void layout();
+	void bind(Row* r, int32_t index);
+	int32_t maxOffset();
+	void setOffset(int32_t ofs);
+	void scrollToSelected(bool anim);
+	void activate(int32_t index);
+	static VirtualList* of(lv_obj_t* o);
+	static lv_res_t signalCb(lv_obj_t* o, lv_signal_t sign, void* param);
+	static void animCb(void* var, lv_anim_value_t v);
+
+public:
+	VirtualList();
+	// 创建控件，row_h为行高（像素），行对象数按控件高度计算
+	bool create(lv_obj_t* parent, lv_coord_t w, lv_coord_t h, lv_coord_t row_h);
+	void destroy();
+	lv_obj_t* getObj();
+
+	void setSource(vlist_fetch_t fetch, vlist_select_t on_select, void* user);
+	// 设置条目数并重新取可见行的数据，滚动位置与选中行超出范围时修正
+	void setCount(uint32_t n);
+	uint32_t getCount();
+	// 重新取可见行的数据（条目内容变化、条目数不变时）
+	void refresh();
+
+	// 选中一项并滚动到可见，index超出范围时取最近的一项
+	void select(int32_t index, bool anim = true);
+	int32_t getSelected();
+	// 滚动使第index项位于顶端
+	void scrollTo(uint32_t index);
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef WEATHER_H
+#define WEATHER_H
+
+#include <Arduino.h>
+#include "lvgl.h"
+#include "app_manager.h"
+#include "fetch_scheduler.h"
+
+// Open-Meteo预报接口（无需密钥），经纬度取自配置weather.lat/weather.lon
+#define WEATHER_URL "http://api.open-meteo.com/v1/forecast?latitude=%s&longitude=%s" \
+	"&current=temperature_2m,relative_humidity_2m,weather_code" \
+	"&daily=weather_code,temperature_2m_max,temperature_2m_min&forecast_days=3&timezone=auto"
+// 刷新间隔；超过有效期未刷新成功时界面标记为离线
+#define WEATHER_INTERVAL_S 1800
+#define WEATHER_TTL_S (6 * 3600)
+// 预报天数（含今天）
+#define WEATHER_DAYS 3
+// NVS缓存（一条定长记录，内容变化时才写入）
+#define WEATHER_NVS_NAMESPACE "weather"
+#define WEATHER_NVS_KEY "data"
+#define WEATHER_DATA_VERSION 1
+// 图标图集（资源包中的一张图：WEATHER_ICON_COUNT个正方形图标横向排列，边长等于图高）
+#define WEATHER_ATLAS "weather_icons"
+
+// 图集中的图标顺序
+enum WeatherIcon
+{
+	WEATHER_ICON_CLEAR = 0,
+	WEATHER_ICON_PARTLY,
+	WEATHER_ICON_CLOUDY,
+	WEATHER_ICON_FOG,
+	WEATHER_ICON_DRIZZLE,
+	WEATHER_ICON_RAIN,
+	WEATHER_ICON_SNOW,
+	WEATHER_ICON_THUNDER,
+	WEATHER_ICON_COUNT
+};
+
+#pragma pack(push, 1)
+
+struct WeatherDay
+{
+	uint8_t code;     // WMO天气代码
+	int8_t t_max;     // 摄氏度
+	int8_t t_min;
+};
+
+/**
+ * 天气记录（原样保存到NVS，约20字节）
+ */
+struct WeatherData
+{
+	uint8_t version;
+	uint8_t days;
+	int16_t temp_x10; // 当前温度，0.1摄氏度
+	uint8_t humidity; // %
+	uint8_t code;     // 当前WMO天气代码
+	uint32_t updated; // 取得数据的实时时间，0为未知
+	WeatherDay day[WEATHER_DAYS];
+};
+
+#pragma pack(pop)
+
+/**
+ * 天气
+ *
+ * 后台抓取作为FetchScheduler的一个数据源：响应按过滤文档只保留当前温度、湿度、天气代码
+ * 与每日最高/最低温度，解析为WeatherData；内容变化时才写入NVS并通知界面。
+ * 开机时从NVS读出上次的记录，进入界面立即显示，不等待网络与SD卡。
+ * 图标来自资源包中的一张图集（flash映射），每个图标对象只显示图集的一格，不占用堆内存。
+ * start/stop必须在LVGL任务中调用
+ */
+class Weather
+{
+private:
+	WeatherData data;
+	WeatherData pending;        // 网络任务解析结果，值变化通知时提交
+	bool has_data;
+	bool loaded;
+	int source;                 // 数据源编号，未注册为-1
+
+	lv_obj_t* scr;
+	lv_obj_t* prev_scr;
+	lv_obj_t* icon;
+	lv_obj_t* temp;
+	lv_obj_t* unit;
+	lv_obj_t* desc;
+	lv_obj_t* status;
+	lv_obj_t* day_name[WEATHER_DAYS];
+	lv_obj_t* day_icon[WEATHER_DAYS];
+	lv_obj_t* day_temp[WEATHER_DAYS];
+	const lv_img_dsc_t* atlas;
+	char text[2][40];           // 描述与状态标签的文本（lv_label_set_text_static，翻译后的文字可能更长）
+
+	void load();
+	void save(const WeatherData* d);
+	void refresh();
+	lv_obj_t* createIcon(lv_coord_t x, lv_coord_t y);
+	void setIcon(lv_obj_t* img, uint8_t code);
+	static uint8_t iconOf(uint8_t code);
+	static const char* describe(uint8_t code);
+	static uint32_t hash(const WeatherData* d);
+	static bool parse(JsonDocument* doc, char* out, size_t len);
+	static void onChange(uint8_t id, const char* value, void* user);
+	static void onUpdate(const struct UiMsg* msg);
+
+public:
+	Weather();
+	bool begin(const char* lat, const char* lon);
+	bool get(WeatherData* out);
+	bool start();
+	void stop();
+	bool isRunning();
+};
+
+extern Weather weather;
+// 以应用形式运行（apps.open(apps.add(weather_app))），离开前台时关闭界面（后台抓取继续）
+extern const App weather_app;
+
+#endif
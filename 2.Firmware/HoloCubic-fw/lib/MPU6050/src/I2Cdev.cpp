@@ -92,6 +92,46 @@ THE SOFTWARE.
 #define BUFFER_LENGTH 32
 #endif
 
+#if I2CDEV_IMPLEMENTATION == I2CDEV_ESP_IDF
+
+/** Read a register block as one command link: START, addr+W, reg, repeated START, addr+R, data..., STOP.
+ * The driver has no receive buffer limit, so FIFO bursts are never split.
+ * @param timeout Driver timeout in milliseconds (0 to wait forever)
+ * @return ESP_OK or the driver error (ESP_FAIL: no ACK, ESP_ERR_TIMEOUT: bus timeout)
+ */
+static esp_err_t idfRead(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint16_t length, uint16_t timeout) {
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    if (cmd == NULL) return ESP_ERR_NO_MEM;
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_write_byte(cmd, regAddr, true);
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_READ, true);
+    i2c_master_read(cmd, data, length, I2C_MASTER_LAST_NACK);
+    i2c_master_stop(cmd);
+    esp_err_t err = i2c_master_cmd_begin(I2CDEV_ESP_IDF_PORT, cmd, timeout ? pdMS_TO_TICKS(timeout) : portMAX_DELAY);
+    i2c_cmd_link_delete(cmd);
+    return err;
+}
+
+/** Write a register block as one command link: START, addr+W, reg, data..., STOP.
+ * @return ESP_OK or the driver error
+ */
+static esp_err_t idfWrite(uint8_t devAddr, uint8_t regAddr, const uint8_t *data, uint16_t length) {
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    if (cmd == NULL) return ESP_ERR_NO_MEM;
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (devAddr << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_write_byte(cmd, regAddr, true);
+    if (length > 0) i2c_master_write(cmd, (uint8_t *)data, length, true);
+    i2c_master_stop(cmd);
+    esp_err_t err = i2c_master_cmd_begin(I2CDEV_ESP_IDF_PORT, cmd, pdMS_TO_TICKS(I2CDEV_ESP_IDF_WRITE_TIMEOUT));
+    i2c_cmd_link_delete(cmd);
+    return err;
+}
+
+#endif
+
 /** Default constructor.
  */
 I2Cdev::I2Cdev() {
@@ -306,6 +346,12 @@ int8_t I2Cdev::readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8
             count = -1; // error
         }
 
+    #elif (I2CDEV_IMPLEMENTATION == I2CDEV_ESP_IDF)
+
+        // ESP-IDF I2C driver
+        // the whole block in one transaction with a repeated start, no chunking
+        count = idfRead(devAddr, regAddr, data, length, timeout) == ESP_OK ? length : -1;
+
     #endif
 
     // check for timeout
@@ -459,6 +505,19 @@ int8_t I2Cdev::readWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint1
             count = -1; // error
         }
 
+    #elif (I2CDEV_IMPLEMENTATION == I2CDEV_ESP_IDF)
+
+        // ESP-IDF I2C driver
+        uint8_t intermediate[length * 2];
+        if (idfRead(devAddr, regAddr, intermediate, length * 2, timeout) == ESP_OK) {
+            count = length; // success
+            for (uint8_t i = 0; i < length; i++) {
+                data[i] = (intermediate[2*i] << 8) | intermediate[2*i + 1];
+            }
+        } else {
+            count = -1; // error
+        }
+
     #endif
 
     if (timeout > 0 && millis() - t1 >= timeout && count < length) count = -1; // timeout
@@ -629,6 +688,8 @@ bool I2Cdev::writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_
     #elif (I2CDEV_IMPLEMENTATION == I2CDEV_BUILTIN_FASTWIRE)
         Fastwire::stop();
         //status = Fastwire::endTransmission();
+    #elif (I2CDEV_IMPLEMENTATION == I2CDEV_ESP_IDF)
+        status = idfWrite(devAddr, regAddr, data, length) != ESP_OK;
     #endif
     #ifdef I2CDEV_SERIAL_DEBUG
         Serial.println(". Done.");
@@ -691,6 +752,14 @@ bool I2Cdev::writeWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16
     #elif (I2CDEV_IMPLEMENTATION == I2CDEV_BUILTIN_FASTWIRE)
         Fastwire::stop();
         //status = Fastwire::endTransmission();
+    #elif (I2CDEV_IMPLEMENTATION == I2CDEV_ESP_IDF)
+        // words are sent MSB first
+        uint8_t intermediate[length * 2];
+        for (uint8_t i = 0; i < length; i++) {
+            intermediate[2*i] = (uint8_t)(data[i] >> 8);
+            intermediate[2*i + 1] = (uint8_t)data[i];
+        }
+        status = idfWrite(devAddr, regAddr, intermediate, length * 2) != ESP_OK;
     #endif
     #ifdef I2CDEV_SERIAL_DEBUG
         Serial.println(". Done.");
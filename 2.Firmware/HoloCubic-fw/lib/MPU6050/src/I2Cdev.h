@@ -51,7 +51,11 @@ THE SOFTWARE.
 // I2C interface implementation setting
 // -----------------------------------------------------------------------------
 #ifndef I2CDEV_IMPLEMENTATION
+#ifdef ESP_PLATFORM
+#define I2CDEV_IMPLEMENTATION       I2CDEV_ESP_IDF
+#else
 #define I2CDEV_IMPLEMENTATION       I2CDEV_ARDUINO_WIRE
+#endif
 //#define I2CDEV_IMPLEMENTATION       I2CDEV_BUILTIN_SBWIRE
 //#define I2CDEV_IMPLEMENTATION       I2CDEV_BUILTIN_FASTWIRE
 #endif // I2CDEV_IMPLEMENTATION
@@ -69,6 +73,7 @@ THE SOFTWARE.
 #define I2CDEV_BUILTIN_FASTWIRE     3 // FastWire object from Francesco Ferrara's project
 #define I2CDEV_I2CMASTER_LIBRARY    4 // I2C object from DSSCircuits I2C-Master Library at https://github.com/DSSCircuits/I2C-Master-Library
 #define I2CDEV_BUILTIN_SBWIRE	    5 // I2C object from Shuning (Steve) Bian's SBWire Library at https://github.com/freespace/SBWire 
+#define I2CDEV_ESP_IDF              6 // ESP-IDF I2C driver command links (the driver must already be installed, e.g. by Wire.begin())
 
 // -----------------------------------------------------------------------------
 // Arduino-style "Serial.print" debug constant (uncomment to enable)
@@ -92,6 +97,17 @@ THE SOFTWARE.
 	#endif
 #endif
 
+#if I2CDEV_IMPLEMENTATION == I2CDEV_ESP_IDF
+    #include <driver/i2c.h>
+    #ifndef I2CDEV_ESP_IDF_PORT
+    #define I2CDEV_ESP_IDF_PORT         I2C_NUM_0
+    #endif
+    // driver timeout for writes (reads use the timeout argument)
+    #ifndef I2CDEV_ESP_IDF_WRITE_TIMEOUT
+    #define I2CDEV_ESP_IDF_WRITE_TIMEOUT 20
+    #endif
+#endif
+
 #ifdef SPARK
     #include <spark_wiring_i2c.h>
     #define ARDUINO 101
@@ -27,6 +27,49 @@ void TFT_eSPI::loadFont(String fontName, fs::FS &ffs)
   fontFS = ffs;
   loadFont(fontName, false);
 }
+
+/***************************************************************************************
+** Function name:           setFontCache
+** Description:             Set the RAM budget used to preload fonts from a file system
+*************************************************************************************x*/
+void TFT_eSPI::setFontCache(uint32_t bytes)
+{
+  fontCacheBytes = bytes;
+}
+
+/***************************************************************************************
+** Function name:           fontAlloc
+** Description:             Allocate font memory, in PSRAM if available
+*************************************************************************************x*/
+void* TFT_eSPI::fontAlloc(uint32_t bytes)
+{
+#if defined (ESP32) && defined (CONFIG_SPIRAM_SUPPORT)
+  if ( psramFound() ) return ps_malloc(bytes);
+#endif
+  return malloc(bytes);
+}
+
+/***************************************************************************************
+** Function name:           cachedGlyph
+** Description:             Get a glyph bitmap from the preload pool, copying it on first use
+*************************************************************************************x*/
+// Returns nullptr when there is no pool or it is full, the caller then streams rows from the file
+uint8_t* TFT_eSPI::cachedGlyph(uint16_t gNum)
+{
+  if (gCache == nullptr) return nullptr;
+  if (gCache[gNum]) return gCache[gNum];
+
+  uint32_t size = gWidth[gNum] * gHeight[gNum];
+  if (fontPoolUsed + size > fontCacheBytes) return nullptr;
+
+  uint8_t* bitmap = fontPool + fontPoolUsed;
+  fontFile.seek(gBitmap[gNum], fs::SeekSet);
+  if (fontFile.read(bitmap, size) != size) return nullptr;
+
+  fontPoolUsed += size;
+  gCache[gNum] = bitmap;
+  return bitmap;
+}
 #endif
 
 /***************************************************************************************
@@ -116,6 +159,25 @@ void TFT_eSPI::loadFont(String fontName, bool flash)
     if(!fontFile) return;
 
     fontFile.seek(0, fs::SeekSet);
+
+    // Preload: a font that fits the cache budget is read whole and then drawn as an array font
+    uint32_t fileSize = fontFile.size();
+    if (fileSize && fileSize <= fontCacheBytes) fontFileBuf = (uint8_t*)fontAlloc(fileSize);
+    if (fontFileBuf)
+    {
+      if (fontFile.read(fontFileBuf, fileSize) == fileSize)
+      {
+        fontFile.close();
+        fontPtr = fontFileBuf;
+        fs_font = false;
+      }
+      else
+      {
+        free(fontFileBuf);
+        fontFileBuf = nullptr;
+        fontFile.seek(0, fs::SeekSet);
+      }
+    }
   }
 #else
   // Avoid unused varaible warning
@@ -142,6 +204,23 @@ void TFT_eSPI::loadFont(String fontName, bool flash)
 
   // Fetch the metrics for each glyph
   loadMetrics();
+
+#ifdef FONT_FS_AVAILABLE
+  // Font too large to preload: keep a pool for the glyphs actually drawn
+  if (fs_font && fontCacheBytes)
+  {
+    fontPool = (uint8_t*)fontAlloc(fontCacheBytes);
+    gCache = (uint8_t**)calloc(gFont.gCount, sizeof(uint8_t*));
+    if (fontPool == nullptr || gCache == nullptr)
+    {
+      free(fontPool);
+      free(gCache);
+      fontPool = nullptr;
+      gCache = nullptr;
+    }
+    fontPoolUsed = 0;
+  }
+#endif
 }
 
 
@@ -184,10 +263,28 @@ void TFT_eSPI::loadMetrics(void)
 #endif
 
 #ifdef FONT_FS_AVAILABLE
-  if (fs_font) fontFile.seek(headerPtr, fs::SeekSet);
+  // Read the whole metrics table in one go and parse it from RAM rather than 4 byte file reads
+  uint8_t* metrics = nullptr;
+  if (fs_font)
+  {
+    fontFile.seek(headerPtr, fs::SeekSet);
+    metrics = (uint8_t*)malloc(gFont.gCount * 28);
+    if (metrics && fontFile.read(metrics, gFont.gCount * 28) == gFont.gCount * 28)
+    {
+      fontPtr = metrics;
+      fs_font = false;
+    }
+    else if (metrics)
+    {
+      free(metrics);
+      metrics = nullptr;
+      fontFile.seek(headerPtr, fs::SeekSet);
+    }
+  }
 #endif
 
   uint16_t gNum = 0;
+  gSorted = true;
 
   while (gNum < gFont.gCount)
   {
@@ -238,10 +335,21 @@ void TFT_eSPI::loadMetrics(void)
 
     bitmapPtr += gWidth[gNum] * gHeight[gNum];
 
+    if (gNum > 0 && gUnicode[gNum] <= gUnicode[gNum - 1]) gSorted = false;
+
     gNum++;
     yield();
   }
 
+#ifdef FONT_FS_AVAILABLE
+  if (metrics)
+  {
+    free(metrics);
+    fontPtr = nullptr;
+    fs_font = true;
+  }
+#endif
+
   gFont.yAdvance = gFont.maxAscent + gFont.maxDescent;
 
   gFont.spaceWidth = (gFont.ascent + gFont.descent) * 2/7;  // Guess at space width
@@ -300,6 +408,25 @@ void TFT_eSPI::unloadFont( void )
 
 #ifdef FONT_FS_AVAILABLE
   if (fs_font && fontFile) fontFile.close();
+
+  if (fontFileBuf)
+  {
+    free(fontFileBuf);
+    fontFileBuf = nullptr;
+    fontPtr = nullptr;
+  }
+
+  if (gCache)
+  {
+    free(gCache);
+    gCache = nullptr;
+  }
+
+  if (fontPool)
+  {
+    free(fontPool);
+    fontPool = nullptr;
+  }
 #endif
 
   fontLoaded = false;
@@ -340,6 +467,23 @@ uint32_t TFT_eSPI::readInt32(void)
 *************************************************************************************x*/
 bool TFT_eSPI::getUnicodeIndex(uint16_t unicode, uint16_t *index)
 {
+  if (gSorted)
+  {
+    uint16_t lo = 0, hi = gFont.gCount;
+    while (lo < hi)
+    {
+      uint16_t mid = (lo + hi) / 2;
+      if (gUnicode[mid] < unicode) lo = mid + 1;
+      else hi = mid;
+    }
+    if (lo < gFont.gCount && gUnicode[lo] == unicode)
+    {
+      *index = lo;
+      return true;
+    }
+    return false;
+  }
+
   for (uint16_t i = 0; i < gFont.gCount; i++)
   {
     if (gUnicode[i] == unicode)
@@ -393,15 +537,21 @@ void TFT_eSPI::drawGlyph(uint16_t code)
     if (cursor_x == 0) cursor_x -= gdX[gNum];
 
     uint8_t* pbuffer = nullptr;
-    const uint8_t* gPtr = (const uint8_t*) gFont.gArray;
+    const uint8_t* gPtr = nullptr; // Whole glyph bitmap in memory (array font or preload pool)
 
 #ifdef FONT_FS_AVAILABLE
     if (fs_font)
     {
-      fontFile.seek(gBitmap[gNum], fs::SeekSet); // This is taking >30ms for a significant position shift
-      pbuffer =  (uint8_t*)malloc(gWidth[gNum]);
+      gPtr = cachedGlyph(gNum);
+      if (gPtr == nullptr)
+      {
+        fontFile.seek(gBitmap[gNum], fs::SeekSet); // This is taking >30ms for a significant position shift
+        pbuffer =  (uint8_t*)malloc(gWidth[gNum]);
+      }
     }
+    else
 #endif
+    gPtr = (const uint8_t*) gFont.gArray + gBitmap[gNum];
 
     int16_t cy = cursor_y + gFont.maxAscent - gdY[gNum];
     int16_t cx = cursor_x + gdX[gNum];
@@ -417,7 +567,7 @@ void TFT_eSPI::drawGlyph(uint16_t code)
     for (int y = 0; y < gHeight[gNum]; y++)
     {
 #ifdef FONT_FS_AVAILABLE
-      if (fs_font) {
+      if (pbuffer) {
         if (spiffs)
         {
           fontFile.read(pbuffer, gWidth[gNum]);
@@ -435,10 +585,10 @@ void TFT_eSPI::drawGlyph(uint16_t code)
       for (int x = 0; x < gWidth[gNum]; x++)
       {
 #ifdef FONT_FS_AVAILABLE
-        if (fs_font) pixel = pbuffer[x];
+        if (pbuffer) pixel = pbuffer[x];
         else
 #endif
-        pixel = pgm_read_byte(gPtr + gBitmap[gNum] + x + gWidth[gNum] * y);
+        pixel = pgm_read_byte(gPtr + x + gWidth[gNum] * y);
 
         if (pixel)
         {
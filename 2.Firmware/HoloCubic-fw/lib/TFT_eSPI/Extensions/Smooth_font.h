@@ -7,6 +7,11 @@
   void     loadFont(const uint8_t array[]);
 #ifdef FONT_FS_AVAILABLE
   void     loadFont(String fontName, fs::FS &ffs);
+  // Preload mode: RAM (PSRAM if available) budget for fonts subsequently loaded from a file system.
+  // A font file that fits is read into memory whole and the file is closed; a larger font keeps
+  // a pool of this size into which glyph bitmaps are copied the first time they are drawn.
+  // 0 (default) streams every glyph bitmap from the file.
+  void     setFontCache(uint32_t bytes);
 #endif
   void     loadFont(String fontName, bool flash = true);
   void     unloadFont( void );
@@ -41,6 +46,7 @@ fontMetrics gFont = { nullptr, 0, 0, 0, 0, 0, 0, 0 };
   uint32_t* gBitmap = NULL;   //file pointer to greyscale bitmap
 
   bool     fontLoaded = false; // Flags when a anti-aliased font is loaded
+  bool     gSorted = false;    // Unicode values ascending, getUnicodeIndex can binary search
 
 #ifdef FONT_FS_AVAILABLE
   fs::File fontFile;
@@ -48,6 +54,8 @@ fontMetrics gFont = { nullptr, 0, 0, 0, 0, 0, 0, 0 };
   bool     spiffs   = true;
   bool     fs_font = false;    // For ESP32/8266 use smooth font file or FLASH (PROGMEM) array
 
+  uint8_t* cachedGlyph(uint16_t gNum); // Glyph bitmap in the preload pool, nullptr: read it from the file
+
 #else
   bool     fontFile = true;
 #endif
@@ -59,3 +67,13 @@ fontMetrics gFont = { nullptr, 0, 0, 0, 0, 0, 0, 0 };
 
   uint8_t* fontPtr = nullptr;
 
+#ifdef FONT_FS_AVAILABLE
+  void*    fontAlloc(uint32_t bytes);
+
+  uint32_t fontCacheBytes = 0;    // Preload budget set by setFontCache()
+  uint8_t* fontFileBuf = nullptr; // Whole font file read into RAM (used as an array font)
+  uint8_t* fontPool = nullptr;    // Hot glyph bitmap pool
+  uint32_t fontPoolUsed = 0;
+  uint8_t** gCache = nullptr;     // Per glyph pointer into fontPool, nullptr until first drawn
+#endif
+
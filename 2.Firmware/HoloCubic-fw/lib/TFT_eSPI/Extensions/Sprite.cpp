@@ -2425,14 +2425,19 @@ void TFT_eSprite::drawGlyph(uint16_t code)
     }
 
     uint8_t* pbuffer = nullptr;
-    const uint8_t* gPtr = (const uint8_t*) gFont.gArray;
+    const uint8_t* gPtr = nullptr; // Whole glyph bitmap in memory (array font or preload pool)
 
 #ifdef FONT_FS_AVAILABLE
     if (fs_font) {
-      fontFile.seek(gBitmap[gNum], fs::SeekSet); // This is slow for a significant position shift!
-      pbuffer =  (uint8_t*)malloc(gWidth[gNum]);
+      gPtr = cachedGlyph(gNum);
+      if (gPtr == nullptr) {
+        fontFile.seek(gBitmap[gNum], fs::SeekSet); // This is slow for a significant position shift!
+        pbuffer =  (uint8_t*)malloc(gWidth[gNum]);
+      }
     }
+    else
 #endif
+    gPtr = (const uint8_t*) gFont.gArray + gBitmap[gNum];
 
     int16_t  xs = 0;
     uint16_t dl = 0;
@@ -2443,19 +2448,19 @@ void TFT_eSprite::drawGlyph(uint16_t code)
     for (int32_t y = 0; y < gHeight[gNum]; y++)
     {
 #ifdef FONT_FS_AVAILABLE
-      if (fs_font) {
+      if (pbuffer) {
         fontFile.read(pbuffer, gWidth[gNum]);
       }
 #endif
       for (int32_t x = 0; x < gWidth[gNum]; x++)
       {
 #ifdef FONT_FS_AVAILABLE
-        if (fs_font) {
+        if (pbuffer) {
           pixel = pbuffer[x];
         }
         else
 #endif
-        pixel = pgm_read_byte(gPtr + gBitmap[gNum] + x + gWidth[gNum] * y);
+        pixel = pgm_read_byte(gPtr + x + gWidth[gNum] * y);
 
         if (pixel)
         {
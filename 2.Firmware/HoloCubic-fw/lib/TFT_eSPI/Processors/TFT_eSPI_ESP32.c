@@ -708,7 +708,7 @@ bool TFT_eSPI::initDMA(bool ctrl_cs)
     .duty_cycle_pos = 0,
     .cs_ena_pretrans = 0,
     .cs_ena_posttrans = 0,
-    .clock_speed_hz = SPI_FREQUENCY,
+    .clock_speed_hz = (int)_spiFrequency,
     .input_delay_ns = 0,
     .spics_io_num = pin,
     .flags = SPI_DEVICE_NO_DUMMY, //0,
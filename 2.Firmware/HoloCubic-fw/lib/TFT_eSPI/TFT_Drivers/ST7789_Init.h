@@ -54,7 +54,16 @@
   writedata(0x20);
 
   writecommand(ST7789_FRCTR2);
-  writedata(0x0f);
+#ifdef TFT_TE_FRAME_RATE
+  writedata(TFT_TE_FRAME_RATE);
+#else
+  writedata(0x0f);     // 60Hz
+#endif
+
+#ifdef TFT_TE
+  writecommand(ST7789_TEON);     // Tearing effect line on
+  writedata(0x00);     // V-blank only: one pulse per frame, at the start of the vertical blanking
+#endif
 
   writecommand(ST7789_PWCTRL1);
   writedata(0xa4);
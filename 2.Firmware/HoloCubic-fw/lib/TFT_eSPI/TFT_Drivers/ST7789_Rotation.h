@@ -96,4 +96,27 @@ case 4: // Inverter portrait & Mirror Y
 	_width = _init_width;
 	_height = _init_height;
 	break;
+
+default: // 8-15: flags given directly, bit 0: MV (exchange), bit 1: MX, bit 2: MY
+{
+	uint8_t mad = TFT_MAD_COLOR_ORDER;
+	if (m & 1) mad |= TFT_MAD_MV;
+	if (m & 2) mad |= TFT_MAD_MX;
+	if (m & 4) mad |= TFT_MAD_MY;
+#ifdef CGRAM_OFFSET
+	// 240x320 RAM: with reversed row order the visible rows are the last ones
+	colstart = 0;
+	rowstart = 0;
+	if ((m & 4) && _init_width != 135)
+	{
+		if (m & 1) colstart = 320 - _init_height;
+		else rowstart = 320 - _init_height;
+	}
+#endif
+	writedata(mad);
+
+	_width = (m & 1) ? _init_height : _init_width;
+	_height = (m & 1) ? _init_width : _init_height;
+	break;
+}
 }
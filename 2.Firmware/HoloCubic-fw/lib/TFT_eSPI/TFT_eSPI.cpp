@@ -55,7 +55,7 @@ inline void TFT_eSPI::begin_tft_write(void){
 #if defined (SPI_HAS_TRANSACTION) && defined (SUPPORT_TRANSACTIONS) && !defined(TFT_PARALLEL_8_BIT)
   if (locked) {
     locked = false;
-    spi.beginTransaction(SPISettings(SPI_FREQUENCY, MSBFIRST, TFT_SPI_MODE));
+    spi.beginTransaction(SPISettings(_spiFrequency, MSBFIRST, TFT_SPI_MODE));
     CS_L;
     SET_BUS_WRITE_MODE;
   }
@@ -333,7 +333,7 @@ inline void TFT_eSPI::end_tft_read(void){
   }
 #else
   #if !defined(TFT_PARALLEL_8_BIT)
-    spi.setFrequency(SPI_FREQUENCY);
+    spi.setFrequency(_spiFrequency);
   #endif
    if(!inTransaction) {CS_H;}
 #endif
@@ -1033,6 +1033,29 @@ void TFT_eSPI::setCallback(getColorCallback getCol)
 }
 
 
+/***************************************************************************************
+** Function name:           setSPIFrequency
+** Description:             Set the SPI clock used for writes
+***************************************************************************************/
+void TFT_eSPI::setSPIFrequency(uint32_t freq)
+{
+  _spiFrequency = freq;
+#if !(defined (SPI_HAS_TRANSACTION) && defined (SUPPORT_TRANSACTIONS)) && !defined(TFT_PARALLEL_8_BIT)
+  spi.setFrequency(freq);
+#endif
+}
+
+
+/***************************************************************************************
+** Function name:           getSPIFrequency
+** Description:             Return the SPI clock used for writes
+***************************************************************************************/
+uint32_t TFT_eSPI::getSPIFrequency(void)
+{
+  return _spiFrequency;
+}
+
+
 /***************************************************************************************
 ** Function name:           read rectangle (for SPI Interface II i.e. IM [3:0] = "1101")
 ** Description:             Read 565 pixel colours from a defined area
@@ -453,6 +453,11 @@ class TFT_eSPI : public Print { friend class TFT_eSprite; // Sprite class has ac
   void     setSwapBytes(bool swap);
   bool     getSwapBytes(void);
 
+           // Change the SPI write clock at runtime (defaults to SPI_FREQUENCY). Call while no transaction is open,
+           // and before initDMA(): the DMA device clock is set when it is attached to the bus
+  void     setSPIFrequency(uint32_t freq);
+  uint32_t getSPIFrequency(void);
+
            // Draw bitmap
   void     drawBitmap( int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t fgcolor),
            drawBitmap( int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t fgcolor, uint16_t bgcolor),
@@ -763,6 +768,7 @@ class TFT_eSPI : public Print { friend class TFT_eSprite; // Sprite class has ac
   bool     isDigits;   // adjust bounding box for numbers to reduce visual jiggling
   bool     textwrapX, textwrapY;  // If set, 'wrap' text at right and optionally bottom edge of display
   bool     _swapBytes; // Swap the byte order for TFT pushImage()
+  uint32_t _spiFrequency = SPI_FREQUENCY; // SPI write clock
   bool     locked, inTransaction; // SPI transaction and mutex lock flags
 
   bool     _booted;    // init() or begin() has already run once
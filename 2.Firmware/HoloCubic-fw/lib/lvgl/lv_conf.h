@@ -32,8 +32,9 @@
 #define LV_COLOR_DEPTH     16
 
 /* Swap the 2 bytes of RGB565 color.
- * Useful if the display has a 8 bit interface (e.g. SPI)*/
-#define LV_COLOR_16_SWAP   0
+ * Useful if the display has a 8 bit interface (e.g. SPI)
+ * 1: 以ST7789的字节序绘制，刷新时不再逐像素交换；真彩色资源需用rgb565_swap格式生成（get_holo --color）*/
+#define LV_COLOR_16_SWAP   1
 
 /* 1: Enable screen transparency.
  * Useful for OSD or other overlapping GUIs.
@@ -76,8 +77,9 @@ typedef int16_t lv_coord_t;
 /* LittelvGL's internal memory manager's settings.
  * The graphical objects and other related data are stored here. */
 
-/* 1: use custom malloc/free, 0: use the built-in `lv_mem_alloc` and `lv_mem_free` */
-#define LV_MEM_CUSTOM      0
+/* 1: use custom malloc/free, 0: use the built-in `lv_mem_alloc` and `lv_mem_free`
+ * 1时使用lv_port_mem（TLSF堆+小块固定池，见lv_port_mem.h），0时恢复内置32KB静态堆 */
+#define LV_MEM_CUSTOM      1
 #if LV_MEM_CUSTOM == 0
 /* Size of the memory used by `lv_mem_alloc` in bytes (>= 2kB)*/
 #  define LV_MEM_SIZE    (32U * 1024U)
@@ -92,9 +94,10 @@ typedef int16_t lv_coord_t;
 /* Automatically defrag. on free. Defrag. means joining the adjacent free cells. */
 #  define LV_MEM_AUTO_DEFRAG  1
 #else       /*LV_MEM_CUSTOM*/
-#  define LV_MEM_CUSTOM_INCLUDE <stdlib.h>   /*Header for the dynamic memory function*/
-#  define LV_MEM_CUSTOM_ALLOC   malloc       /*Wrapper to malloc*/
-#  define LV_MEM_CUSTOM_FREE    free         /*Wrapper to free*/
+#  define LV_MEM_CUSTOM_INCLUDE "lv_port_mem.h"   /*Header for the dynamic memory function*/
+#  define LV_MEM_CUSTOM_ALLOC   lv_port_mem_alloc       /*Wrapper to malloc*/
+#  define LV_MEM_CUSTOM_FREE    lv_port_mem_free        /*Wrapper to free*/
+#  define LV_MEM_CUSTOM_MONITOR lv_port_mem_monitor     /*Fill `lv_mem_monitor()` (optional)*/
 #endif     /*LV_MEM_CUSTOM*/
 
 /* Use the standard memcpy and memset instead of LVGL's own functions.
@@ -161,7 +164,13 @@ typedef void * lv_anim_user_data_t;
  * LV_SHADOW_CACHE_SIZE is the max. shadow size to buffer,
  * where shadow size is `shadow_width + radius`
  * Caching has LV_SHADOW_CACHE_SIZE^2 RAM cost*/
-#define LV_SHADOW_CACHE_SIZE    0
+#define LV_SHADOW_CACHE_SIZE    40
+
+/* Number of blurred corners to keep (HoloCubic extension, see lv_draw_rect.c).
+ * Different shadows (e.g. of buttons and cards) reuse their own corner in every redraw.
+ * The buffers are allocated from the LVGL heap: at most LV_SHADOW_CACHE_NUM * LV_SHADOW_CACHE_SIZE^2 bytes
+ * 每次绘制（每个绘制缓冲分片）都要重新模糊阴影角，缓存后只需复制*/
+#define LV_SHADOW_CACHE_NUM     6
 #endif
 
 /*1: enable outline drawing on rectangles*/
@@ -190,6 +199,29 @@ typedef void * lv_group_user_data_t;
 
 /* 1: Enable GPU interface*/
 #define LV_USE_GPU              1   /*Only enables `gpu_fill_cb` and `gpu_blend_cb` in the disp. drv- */
+
+/*1: Use the ESP32 specific software kernels (lv_gpu_esp32.c, placed in IRAM) for fills, copies and
+ *   opacity blending of RGB565 pixels (either byte order). Requires LV_COLOR_DEPTH 16.
+ *   With LV_USE_GPU the driver's `gpu_fill_cb`/`gpu_blend_cb` are tried first (see display.cpp).
+ *   只替换blend中最常用的四条路径，LV_ATTRIBUTE_FAST_MEM保持为空以免其他绘制函数占满IRAM
+ *   lv_img的缩放/旋转（TRUE_COLOR格式）也按行走这里的90°/最近邻/双线性专用路径*/
+#define LV_USE_GPU_ESP32        1
+
+/*1: Split the per-pixel work of large image draws (transform, ARGB, chroma key, recolor) and of
+ *   translucent fills/blends by rows between the two cores with the hooks of `LV_DRAW_SPLIT_INCLUDE`.
+ *   The lower half runs on a worker task and writes other lines of the same draw buffer.
+ *   实验性：需调用draw_split_enable(true)，未启用时每次绘制只多一次判断；拆分条件见draw_split.h*/
+#define LV_USE_DRAW_SPLIT       1
+#if LV_USE_DRAW_SPLIT
+#  define LV_DRAW_SPLIT_INCLUDE "draw_split.h"
+#endif
+/*1: Draw premultiplied alpha images (span encoded RGB565 + A8, see `LV_PREMUL_DRAW_INCLUDE`) straight from their
+ *   spans: transparent spans are skipped, opaque ones copied and only the translucent pixels are blended.
+ *   格式与直接绘制的条件见premul_decoder.h，其他情况由其解码器逐行还原为TRUE_COLOR_ALPHA*/
+#define LV_USE_PREMUL_DRAW      1
+#if LV_USE_PREMUL_DRAW
+#  define LV_PREMUL_DRAW_INCLUDE "premul_decoder.h"
+#endif
 #define LV_USE_GPU_STM32_DMA2D  0
 /*If enabling LV_USE_GPU_STM32_DMA2D, LV_GPU_DMA2D_CMSIS_INCLUDE must be defined to include path of CMSIS header of target processor
 e.g. "stm32f769xx.h" or "stm32f429xx.h" */
@@ -221,6 +253,60 @@ typedef void * lv_fs_drv_user_data_t;
 /*1: Show CPU usage and FPS count in the right bottom corner*/
 #define LV_USE_PERF_MONITOR     0
 
+/*1: Time the refresh phases (join, draw, flush) with the hooks of `LV_REFR_PROFILER_INCLUDE`.
+ * 计时结果与叠加层见render_prof.h，未调用render_prof_enable时每个钩子只有一次判断*/
+#define LV_USE_REFR_PROFILER    1
+#if LV_USE_REFR_PROFILER
+#  define LV_REFR_PROFILER_INCLUDE "render_prof.h"
+#endif
+
+/*1: Let the display driver's `direct_cb` send areas which show only a screen level, unscaled, opaque
+ *   true color image (e.g. a scene frame) straight from the image data, skipping the draw buffer.
+ *   直出条件见lv_refr.c的lv_refr_area_direct，驱动实现见display.cpp*/
+#define LV_USE_REFR_DIRECT      1
+
+/*Number of invalid areas saved per display before refreshing (max. 1023).
+ * A new area is joined with the saved ones it is on; when all places are used it is joined with the area which grows
+ * the least, the whole screen is refreshed only if that wouldn't be less pixels. 见lv_refr.c的inv_area_save*/
+#define LV_INV_BUF_SIZE         32
+
+/*Refresh the invalid areas in tiles of this size instead of joining them (0: disable).
+ * Only the invalid part of the dirty tiles is redrawn, neighbouring parts on the same lines are sent together.
+ * 48x48 = 2304像素，正好放进一个绘制缓冲区（240 x DISP_BUF_LINES），见lv_refr.c的lv_refr_tiles*/
+#define LV_REFR_TILE_SIZE       48
+
+/*1: Before drawing an area find the objects fully covered by an opaque object drawn later and skip them
+ *   (e.g. a background under an opaque scene image with translucent overlays). 遮挡判断见lv_refr.c的occlusion_collect_obj*/
+#define LV_USE_REFR_OCCLUSION   1
+
+/*Number of resolved style properties (object, part, state, property) to cache (power of 2, 0: disable).
+ * Any style, state or parent change invalidates the whole cache. 每项16字节，见lv_obj.c的style_cache_find*/
+#define LV_STYLE_CACHE_SIZE     256
+
+/*1: Style property maps and local styles created between `lv_style_arena_open` and `lv_style_arena_close`
+ * (e.g. while a screen is built) are bump-allocated from one block instead of being realloc-ed property by property.
+ * The block is freed at once when the last of them is released (the screen is deleted).
+ * 屏幕与应用界面创建时由screen_manager/app_manager打开，见lv_style.c的style_resize*/
+#define LV_USE_STYLE_ARENA      1
+
+/*Max. number of linked list nodes (objects, tasks, anims...) allocated together in one chunk (1: one by one).
+ * A new node goes to the chunk of its neighbour, chunks grow 2, 4, 8... per list. 见lv_ll.c的node_alloc*/
+#define LV_LL_CHUNK_MAX         4
+
+/*Max. number of objects whose rendered look can be kept in a buffer with `lv_obj_set_layer_cache` (0: disable).
+ * Such an object (e.g. a static panel with shadow and many children) is rendered together with everything
+ * under it once, then only copied while nothing changes inside or under it.
+ * 适合大部分时间不变的复合控件，失效与重建规则见lv_refr.c的_lv_refr_layer_cache_inv*/
+#define LV_LAYER_CACHE_MAX          4
+#if LV_LAYER_CACHE_MAX
+/*Total size of the layer buffers in bytes (a 120x120 object with 10 px shadow needs 39200 bytes)*/
+#  define LV_LAYER_CACHE_BYTES      (48U * 1024U)
+/*Allocator of the layer buffers: PSRAM when present, internal RAM otherwise*/
+#  define LV_LAYER_CACHE_ALLOC_INCLUDE  <esp_heap_caps.h>
+#  define LV_LAYER_CACHE_ALLOC(size)    heap_caps_malloc_prefer(size, 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, MALLOC_CAP_8BIT)
+#  define LV_LAYER_CACHE_FREE(p)        heap_caps_free(p)
+#endif
+
 /*1: Use the functions and types from the older API if possible */
 #define LV_USE_API_EXTENSION_V6  1
 #define LV_USE_API_EXTENSION_V7  1
@@ -241,7 +327,24 @@ typedef void * lv_fs_drv_user_data_t;
  * With complex image decoders (e.g. PNG or JPG) caching can save the continuous open/decode of images.
  * However the opened images might consume additional RAM.
  * Set it to 0 to disable caching */
-#define LV_IMG_CACHE_DEF_SIZE       1
+#define LV_IMG_CACHE_DEF_SIZE       8
+
+/* Cache policy (HoloCubic extension, see lv_img_cache.c).
+ * LV_IMG_CACHE_BYTE_BUDGET > 0: LV_IMG_CACHE_DEF_SIZE is only the maximal number of entries.
+ * Entries are evicted in least-recently-used order (pinned entries never) while the
+ * decoded data held by the cache would exceed the budget.
+ * 0: keep the original count based "life" policy */
+#define LV_IMG_CACHE_BYTE_BUDGET    (32U * 1024U)
+
+/* File images which can only be read line-by-line (.bin from SD, JPEG) are decoded once
+ * into a buffer owned by the cache if not larger than this, so redraws skip the decoder
+ * and no file stays open. 0: disable */
+#define LV_IMG_CACHE_PRELOAD_MAX    (32U * 1024U)
+
+/* Allocator for preloaded data: PSRAM when present, internal RAM otherwise */
+#define LV_IMG_CACHE_ALLOC_INCLUDE  <esp_heap_caps.h>
+#define LV_IMG_CACHE_ALLOC(size)    heap_caps_malloc_prefer(size, 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, MALLOC_CAP_8BIT)
+#define LV_IMG_CACHE_FREE(p)        heap_caps_free(p)
 
 /*Declare the type of the user data of image decoder (can be e.g. `void *`, `int`, `struct`)*/
 typedef void * lv_img_decoder_user_data_t;
@@ -259,8 +362,23 @@ typedef void * lv_img_decoder_user_data_t;
 /* Define a custom attribute to `lv_task_handler` function */
 #define LV_ATTRIBUTE_TASK_HANDLER
 
+/*1: Place the measured hot set of the refresh path in IRAM (build profile `env:pico32_iram`):
+ *   blend dispatchers and normal fill/map, lv_refr area/object/flush functions, lv_disp_flush_ready,
+ *   the display flush callbacks and the image decoders' read_line callbacks (all marked LV_ATTRIBUTE_HOT).
+ *   约占8KB IRAM；选取依据为CACHE_PROF构建中各阶段的取指停顿（见cache_prof.h）。
+ *   LV_ATTRIBUTE_FAST_MEM须保持为空：两者同时为IRAM_ATTR时同一函数会得到两个段属性*/
+#ifndef LV_IRAM_HOT
+#define LV_IRAM_HOT             0
+#endif
+#if LV_IRAM_HOT
+#  include <esp_attr.h>
+#  define LV_ATTRIBUTE_HOT      IRAM_ATTR
+#else
+#  define LV_ATTRIBUTE_HOT
+#endif
+
 /* Define a custom attribute to `lv_disp_flush_ready` function */
-#define LV_ATTRIBUTE_FLUSH_READY
+#define LV_ATTRIBUTE_FLUSH_READY LV_ATTRIBUTE_HOT
 
 /* Required alignment size for buffers */
 #define LV_ATTRIBUTE_MEM_ALIGN_SIZE
@@ -399,7 +517,7 @@ typedef void * lv_indev_drv_user_data_t;            /*Type of user data in the i
 #define LV_FONT_MONTSERRAT_42    0
 #define LV_FONT_MONTSERRAT_44    0
 #define LV_FONT_MONTSERRAT_46    0
-#define LV_FONT_MONTSERRAT_48    0
+#define LV_FONT_MONTSERRAT_48    1
 
 /* Demonstrate special features */
 #define LV_FONT_MONTSERRAT_12_SUBPX      0
@@ -430,6 +548,19 @@ typedef void * lv_indev_drv_user_data_t;            /*Type of user data in the i
  */
 #define LV_USE_FONT_COMPRESSED 1
 
+/* Keep the last decompressed glyphs of compressed fonts (LRU, keyed by font and glyph).
+ * The slots are allocated from the LVGL heap at the first compressed glyph, plain fonts
+ * are drawn from flash directly and never use it. Glyphs larger than a slot are
+ * decompressed on every draw. 0: disable the cache*/
+#define LV_FONT_GLYPH_CACHE_SLOTS     24
+#define LV_FONT_GLYPH_CACHE_SLOT_SIZE 256
+
+/* Page cache of fonts loaded with `lv_font_load_stream()` (e.g. a full GB2312 .bin on the SD card):
+ * only the character maps stay in RAM, glyphs are read through these pages on demand.
+ * RAM per font: LV_FONT_STREAM_PAGES * LV_FONT_STREAM_PAGE_SIZE + index*/
+#define LV_FONT_STREAM_PAGE_SIZE 512
+#define LV_FONT_STREAM_PAGES     8
+
 /* Enable subpixel rendering */
 #define LV_USE_FONT_SUBPX 1
 #if LV_USE_FONT_SUBPX
@@ -608,6 +739,16 @@ typedef void * lv_obj_user_data_t;
 
 /*Color picker (dependencies: -*/
 #define LV_USE_CPICKER   1
+#if LV_USE_CPICKER
+/* Cache the geometry of the LV_CPICKER_TYPE_DISC ring (angle index + coverage, 2 bytes per ring pixel,
+ * about 16 KB for a 200x200 disc with a 10 px ring). Redraws blend the cached pixels instead of
+ * drawing a masked line per step, and a change which keeps the ring colors (e.g. the hue in hue mode)
+ * only refreshes the knob and the center. 0: draw the ring with lines every time */
+#  define LV_CPICKER_RING_CACHE         1
+#  define LV_CPICKER_CACHE_ALLOC_INCLUDE <esp_heap_caps.h>
+#  define LV_CPICKER_CACHE_ALLOC(size)  heap_caps_malloc_prefer(size, 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT, MALLOC_CAP_8BIT)
+#  define LV_CPICKER_CACHE_FREE(p)      heap_caps_free(p)
+#endif
 
 /*Drop down list (dependencies: lv_page, lv_label, lv_symbol_def.h)*/
 #define LV_USE_DROPDOWN    1
@@ -646,6 +787,12 @@ typedef void * lv_obj_user_data_t;
 
 /*Store extra some info in labels (12 bytes) to speed up drawing of very long texts*/
 #  define LV_LABEL_LONG_TXT_HINT          0
+
+/*Keep the line breaks and line widths of every label so redrawing unchanged text skips
+ * UTF-8 decoding and line breaking (6 bytes per line from the LVGL heap, labels with more
+ * lines are laid out on every draw as before). 见lv_draw_label.c的lv_draw_label_layout_update*/
+#  define LV_LABEL_LAYOUT_CACHE           1
+#  define LV_LABEL_LAYOUT_MAX_LINES       64
 #endif
 
 /*LED (dependencies: -)*/
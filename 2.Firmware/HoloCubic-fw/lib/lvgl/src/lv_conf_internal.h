@@ -683,6 +683,15 @@ e.g. "stm32f769xx.h" or "stm32f429xx.h" */
 #  else
 #    define  LV_ATTRIBUTE_LARGE_CONST
 #  endif
+#endif
+
+/* Prefix the measured hot set of the refresh path (see LV_IRAM_HOT in lv_conf.h) */
+#ifndef LV_ATTRIBUTE_HOT
+#  ifdef CONFIG_LV_ATTRIBUTE_HOT
+#    define LV_ATTRIBUTE_HOT CONFIG_LV_ATTRIBUTE_HOT
+#  else
+#    define  LV_ATTRIBUTE_HOT
+#  endif
 #endif
 
   /* Prefix performance critical functions to place them into a faster memory (e.g RAM)
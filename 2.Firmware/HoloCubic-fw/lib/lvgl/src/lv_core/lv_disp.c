@@ -156,6 +156,9 @@ void lv_disp_set_bg_color(lv_disp_t * disp, lv_color_t color)
 
     lv_area_t a;
     lv_area_set(&a, 0, 0, lv_disp_get_hor_res(disp) - 1, lv_disp_get_ver_res(disp) - 1);
+#if LV_LAYER_CACHE_MAX
+    _lv_refr_layer_cache_inv(NULL, &a);
+#endif
     _lv_inv_area(disp, &a);
 
 }
@@ -177,6 +180,9 @@ void lv_disp_set_bg_image(lv_disp_t * disp, const void  * img_src)
 
     lv_area_t a;
     lv_area_set(&a, 0, 0, lv_disp_get_hor_res(disp) - 1, lv_disp_get_ver_res(disp) - 1);
+#if LV_LAYER_CACHE_MAX
+    _lv_refr_layer_cache_inv(NULL, &a);
+#endif
     _lv_inv_area(disp, &a);
 }
 
@@ -198,6 +204,9 @@ void lv_disp_set_bg_opa(lv_disp_t * disp, lv_opa_t opa)
 
     lv_area_t a;
     lv_area_set(&a, 0, 0, lv_disp_get_hor_res(disp) - 1, lv_disp_get_ver_res(disp) - 1);
+#if LV_LAYER_CACHE_MAX
+    _lv_refr_layer_cache_inv(NULL, &a);
+#endif
     _lv_inv_area(disp, &a);
 }
 
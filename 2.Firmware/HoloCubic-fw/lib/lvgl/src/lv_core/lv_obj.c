@@ -52,6 +52,10 @@
 #define LV_OBJ_DEF_WIDTH    (LV_DPX(100))
 #define LV_OBJ_DEF_HEIGHT   (LV_DPX(50))
 
+#ifndef LV_STYLE_CACHE_SIZE
+    #define LV_STYLE_CACHE_SIZE 0
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -109,6 +113,22 @@ typedef struct {
     uint32_t border_post : 1;
 } style_snapshot_t;
 
+#if LV_STYLE_CACHE_SIZE
+/*A resolved style property of an object's part. Valid while the style change ID is the same.*/
+typedef struct {
+    const lv_obj_t * obj;
+    uint32_t change_id;
+    lv_style_property_t prop;   /*The property ORed with the part's state*/
+    uint8_t part;
+    union {
+        lv_style_int_t num;
+        lv_color_t color;
+        lv_opa_t opa;
+        const void * ptr;
+    } value;
+} style_cache_t;
+#endif
+
 typedef enum {
     STYLE_COMPARE_SAME,
     STYLE_COMPARE_VISUAL_DIFF,
@@ -143,6 +163,15 @@ static bool obj_valid_child(const lv_obj_t * parent, const lv_obj_t * obj_to_fin
 static void lv_obj_del_async_cb(void * obj);
 static void obj_del_core(lv_obj_t * obj);
 static void update_style_cache(lv_obj_t * obj, uint8_t part, uint16_t prop);
+static lv_style_int_t get_style_int_core(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop);
+static lv_color_t get_style_color_core(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop);
+static lv_opa_t get_style_opa_core(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop);
+static const void * get_style_ptr_core(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop);
+#if LV_STYLE_CACHE_SIZE
+static style_cache_t * style_cache_find(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop,
+                                        style_cache_t * key);
+static void style_cache_store(const style_cache_t * key);
+#endif
 static void update_style_cache_children(lv_obj_t * obj);
 static void invalidate_style_cache(lv_obj_t * obj, uint8_t part, lv_style_property_t prop);
 static void style_snapshot(lv_obj_t * obj, uint8_t part, style_snapshot_t * shot);
@@ -154,6 +183,9 @@ static style_snapshot_res_t style_snapshot_compare(style_snapshot_t * shot1, sty
 static bool lv_initialized = false;
 static lv_event_temp_data_t * event_temp_data_head;
 static const void * event_act_data;
+#if LV_STYLE_CACHE_SIZE
+static style_cache_t style_cache[LV_STYLE_CACHE_SIZE];
+#endif
 
 /**********************
  *      MACROS
@@ -553,6 +585,11 @@ void lv_obj_invalidate_area(const lv_obj_t * obj, const lv_area_t * area)
 {
     LV_ASSERT_OBJ(obj, LV_OBJX_NAME);
 
+#if LV_LAYER_CACHE_MAX
+    /*Also if not visible now: a layer rendered earlier might show it*/
+    _lv_refr_layer_cache_inv(obj, area);
+#endif
+
     lv_area_t area_tmp;
     lv_area_copy(&area_tmp, area);
     bool visible = lv_obj_area_is_visible(obj, &area_tmp);
@@ -677,6 +714,7 @@ void lv_obj_set_parent(lv_obj_t * obj, lv_obj_t * parent)
     }
 
     lv_obj_invalidate(obj);
+    _lv_style_mark_changed();   /*Inherited properties might come from the new parent*/
 
     lv_obj_t * old_par = obj->parent;
     lv_point_t old_pos;
@@ -1531,6 +1569,32 @@ void lv_obj_set_adv_hittest(lv_obj_t * obj, bool en)
     obj->adv_hittest = en == false ? 0 : 1;
 }
 
+#if LV_LAYER_CACHE_MAX
+/**
+ * Keep the rendered look of an object in a buffer and copy it to the screen instead of drawing it again
+ * @param obj pointer to an object
+ * @param en true: enable the layer cache
+ */
+void lv_obj_set_layer_cache(lv_obj_t * obj, bool en)
+{
+    LV_ASSERT_OBJ(obj, LV_OBJX_NAME);
+
+    if(en == (obj->layer_cache != 0)) return;
+
+    if(en) {
+        if(_lv_refr_layer_cache_add(obj) == false) {
+            LV_LOG_WARN("lv_obj_set_layer_cache: no free slot (LV_LAYER_CACHE_MAX)");
+            return;
+        }
+        obj->layer_cache = 1;
+    }
+    else {
+        _lv_refr_layer_cache_remove(obj);
+        obj->layer_cache = 0;
+    }
+}
+#endif
+
 /**
  * Enable or disable the clicking of an object
  * @param obj pointer to an object
@@ -1741,6 +1805,7 @@ void lv_obj_set_state(lv_obj_t * obj, lv_state_t new_state)
     }
 
     obj->state = new_state;
+    _lv_style_mark_changed();   /*The children might inherit properties from the new state*/
 
     if(cmp_res == STYLE_COMPARE_SAME) {
         return;
@@ -2584,6 +2649,24 @@ lv_style_list_t * lv_obj_get_style_list(const lv_obj_t * obj, uint8_t part)
  * @note for performance reasons it's not checked if the property really has integer type
  */
 lv_style_int_t _lv_obj_get_style_int(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop)
+{
+#if LV_STYLE_CACHE_SIZE
+    style_cache_t key;
+    style_cache_t * c = style_cache_find(obj, part, prop, &key);
+    if(c) return c->value.num;
+
+    key.value.num = get_style_int_core(obj, part, prop);
+    style_cache_store(&key);
+    return key.value.num;
+#else
+    return get_style_int_core(obj, part, prop);
+#endif
+}
+
+/**
+ * Resolve a style property by scanning the style lists of the object (and its parents if inherited)
+ */
+static lv_style_int_t get_style_int_core(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop)
 {
     lv_style_property_t prop_ori = prop;
 
@@ -2715,6 +2798,24 @@ lv_style_int_t _lv_obj_get_style_int(const lv_obj_t * obj, uint8_t part, lv_styl
  * @note for performance reasons it's not checked if the property really has color type
  */
 lv_color_t _lv_obj_get_style_color(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop)
+{
+#if LV_STYLE_CACHE_SIZE
+    style_cache_t key;
+    style_cache_t * c = style_cache_find(obj, part, prop, &key);
+    if(c) return c->value.color;
+
+    key.value.color = get_style_color_core(obj, part, prop);
+    style_cache_store(&key);
+    return key.value.color;
+#else
+    return get_style_color_core(obj, part, prop);
+#endif
+}
+
+/**
+ * Resolve a style property by scanning the style lists of the object (and its parents if inherited)
+ */
+static lv_color_t get_style_color_core(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop)
 {
     lv_style_property_t prop_ori = prop;
 
@@ -2771,6 +2872,24 @@ lv_color_t _lv_obj_get_style_color(const lv_obj_t * obj, uint8_t part, lv_style_
  * @note for performance reasons it's not checked if the property really has opacity type
  */
 lv_opa_t _lv_obj_get_style_opa(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop)
+{
+#if LV_STYLE_CACHE_SIZE
+    style_cache_t key;
+    style_cache_t * c = style_cache_find(obj, part, prop, &key);
+    if(c) return c->value.opa;
+
+    key.value.opa = get_style_opa_core(obj, part, prop);
+    style_cache_store(&key);
+    return key.value.opa;
+#else
+    return get_style_opa_core(obj, part, prop);
+#endif
+}
+
+/**
+ * Resolve a style property by scanning the style lists of the object (and its parents if inherited)
+ */
+static lv_opa_t get_style_opa_core(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop)
 {
     lv_style_property_t prop_ori = prop;
 
@@ -2850,6 +2969,24 @@ lv_opa_t _lv_obj_get_style_opa(const lv_obj_t * obj, uint8_t part, lv_style_prop
  * @note for performance reasons it's not checked if the property really has pointer type
  */
 const void * _lv_obj_get_style_ptr(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop)
+{
+#if LV_STYLE_CACHE_SIZE
+    style_cache_t key;
+    style_cache_t * c = style_cache_find(obj, part, prop, &key);
+    if(c) return c->value.ptr;
+
+    key.value.ptr = get_style_ptr_core(obj, part, prop);
+    style_cache_store(&key);
+    return key.value.ptr;
+#else
+    return get_style_ptr_core(obj, part, prop);
+#endif
+}
+
+/**
+ * Resolve a style property by scanning the style lists of the object (and its parents if inherited)
+ */
+static const void * get_style_ptr_core(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop)
 {
     lv_style_property_t prop_ori = prop;
 
@@ -2957,6 +3094,20 @@ bool lv_obj_get_adv_hittest(const lv_obj_t * obj)
     return obj->adv_hittest == 0 ? false : true;
 }
 
+#if LV_LAYER_CACHE_MAX
+/**
+ * Get whether the layer cache is enabled on an object
+ * @param obj pointer to an object
+ * @return true: the object is drawn from its layer buffer when it's up to date
+ */
+bool lv_obj_get_layer_cache(const lv_obj_t * obj)
+{
+    LV_ASSERT_OBJ(obj, LV_OBJX_NAME);
+
+    return obj->layer_cache == 0 ? false : true;
+}
+#endif
+
 /**
  * Get the click enable attribute of an object
  * @param obj pointer to an object
@@ -3776,6 +3927,9 @@ static void lv_obj_del_async_cb(void * obj)
 
 static void obj_del_core(lv_obj_t * obj)
 {
+    /*A new object might be allocated to the same address*/
+    _lv_style_mark_changed();
+
     /*Let the user free the resources used in `LV_EVENT_DELETE`*/
     lv_event_send(obj, LV_EVENT_DELETE, NULL);
 
@@ -3811,6 +3965,10 @@ static void obj_del_core(lv_obj_t * obj)
 
     lv_event_mark_deleted(obj);
 
+#if LV_LAYER_CACHE_MAX
+    if(obj->layer_cache) _lv_refr_layer_cache_remove(obj);
+#endif
+
     /* Reset all input devices if the object to delete is used*/
     lv_indev_t * indev = lv_indev_get_next(NULL);
     while(indev) {
@@ -3845,7 +4003,7 @@ static void obj_del_core(lv_obj_t * obj)
 
     /*Delete the base objects*/
     if(obj->ext_attr != NULL) lv_mem_free(obj->ext_attr);
-    lv_mem_free(obj); /*Free the object itself*/
+    _lv_ll_free(obj); /*Free the object itself*/
 }
 
 /**
@@ -4445,7 +4603,7 @@ static void trans_del(lv_obj_t * obj, uint8_t part, lv_style_property_t prop, lv
 
             lv_anim_del(tr, NULL);
             _lv_ll_remove(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
-            lv_mem_free(tr);
+            _lv_ll_free(tr);
         }
         tr = tr_prev;
     }
@@ -4539,7 +4697,7 @@ static void trans_anim_ready_cb(lv_anim_t * a)
     }
 
     _lv_ll_remove(&LV_GC_ROOT(_lv_obj_style_trans_ll), tr);
-    lv_mem_free(tr);
+    _lv_ll_free(tr);
 }
 
 static void opa_scale_anim(lv_obj_t * obj, lv_anim_value_t v)
@@ -4627,6 +4785,55 @@ static bool style_prop_is_cacheble(lv_style_property_t prop)
     }
 }
 
+#if LV_STYLE_CACHE_SIZE
+static uint32_t style_cache_index(const style_cache_t * key)
+{
+    uint32_t h = (uint32_t)((uintptr_t)key->obj >> 2);
+    h = h * 31 + key->prop;
+    h = h * 31 + key->part;
+    h ^= h >> 8;
+    return h & (LV_STYLE_CACHE_SIZE - 1);
+}
+
+/**
+ * Look up a resolved property in the style value cache
+ * @param obj pointer to an object
+ * @param part the part of the object
+ * @param prop the property without state
+ * @param key filled with the key of the property (to store the value on a miss)
+ * @return the cache entry or NULL if the value is not cached
+ */
+static style_cache_t * style_cache_find(const lv_obj_t * obj, uint8_t part, lv_style_property_t prop,
+                                        style_cache_t * key)
+{
+    key->obj = obj;
+    key->part = part;
+    key->prop = (uint16_t)prop + ((uint16_t)lv_obj_get_state(obj, part) << LV_STYLE_STATE_POS);
+    key->change_id = _lv_style_get_change_id();
+
+    /*The values are read around a state change or for a transition without the caches: don't save them either*/
+    lv_style_list_t * list = lv_obj_get_style_list(obj, part);
+    if(list == NULL || list->ignore_cache) {
+        key->obj = NULL;
+        return NULL;
+    }
+
+    style_cache_t * c = &style_cache[style_cache_index(key)];
+    if(c->obj == obj && c->prop == key->prop && c->part == part && c->change_id == key->change_id) return c;
+    return NULL;
+}
+
+/**
+ * Save a resolved property in the style value cache
+ * @param key the key from `style_cache_find` with the value set
+ */
+static void style_cache_store(const style_cache_t * key)
+{
+    if(key->obj == NULL) return;
+    _lv_memcpy_small(&style_cache[style_cache_index(key)], key, sizeof(style_cache_t));
+}
+#endif
+
 /**
  * Update the cache of style list
  * @param obj pointer to an object
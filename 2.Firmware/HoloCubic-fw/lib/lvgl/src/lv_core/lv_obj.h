@@ -43,6 +43,10 @@ extern "C" {
 
 #define LV_MAX_ANCESTOR_NUM 8
 
+#ifndef LV_LAYER_CACHE_MAX
+#define LV_LAYER_CACHE_MAX 0
+#endif
+
 #define LV_EXT_CLICK_AREA_OFF   0
 #define LV_EXT_CLICK_AREA_TINY  1
 #define LV_EXT_CLICK_AREA_FULL  2
@@ -227,6 +231,9 @@ typedef struct _lv_obj_t {
     uint8_t adv_hittest     : 1; /**< 1: Use advanced hit-testing (slower) */
     uint8_t gesture_parent  : 1; /**< 1: Parent will be gesture instead*/
     uint8_t focus_parent    : 1; /**< 1: Parent will be focused instead*/
+#if LV_LAYER_CACHE_MAX
+    uint8_t layer_cache     : 1; /**< 1: Drawn from a buffer rendered earlier (see `lv_obj_set_layer_cache`)*/
+#endif
 
     lv_drag_dir_t drag_dir  : 3; /**<  Which directions the object can be dragged in */
     lv_bidi_dir_t base_dir  : 2; /**< Base direction of texts related to this object */
@@ -706,6 +713,18 @@ void lv_obj_set_hidden(lv_obj_t * obj, bool en);
  */
 void lv_obj_set_adv_hittest(lv_obj_t * obj, bool en);
 
+#if LV_LAYER_CACHE_MAX
+/**
+ * Keep the rendered look of an object (with its children, shadow and everything under it) in a buffer
+ * and copy it to the screen instead of drawing the object again.
+ * The buffer is rendered again when the object, a child or something under it is invalidated
+ * and is not used while it would change in every refresh (e.g. during an animation).
+ * @param obj pointer to an object
+ * @param en true: enable the layer cache (fails with a warning if all `LV_LAYER_CACHE_MAX` slots are used)
+ */
+void lv_obj_set_layer_cache(lv_obj_t * obj, bool en);
+#endif
+
 /**
  * Enable or disable the clicking of an object
  * @param obj pointer to an object
@@ -1233,6 +1252,15 @@ bool lv_obj_get_hidden(const lv_obj_t * obj);
  */
 bool lv_obj_get_adv_hittest(const lv_obj_t * obj);
 
+#if LV_LAYER_CACHE_MAX
+/**
+ * Get whether the layer cache is enabled on an object
+ * @param obj pointer to an object
+ * @return true: the object is drawn from its layer buffer when it's up to date
+ */
+bool lv_obj_get_layer_cache(const lv_obj_t * obj);
+#endif
+
 /**
  * Get the click enable attribute of an object
  * @param obj pointer to an object
@@ -27,6 +27,65 @@
     #include LV_GC_INCLUDE
 #endif /* LV_ENABLE_GC */
 
+#ifndef LV_USE_REFR_PROFILER
+    #define LV_USE_REFR_PROFILER 0
+#endif
+
+#if LV_USE_REFR_PROFILER
+    #include LV_REFR_PROFILER_INCLUDE
+    #define REFR_PROF_BEGIN(phase)  render_prof_begin(phase)
+    #define REFR_PROF_END(phase)    render_prof_end(phase)
+    #define REFR_PROF_FRAME_END(px) render_prof_frame_end(px)
+#else
+    #define REFR_PROF_BEGIN(phase)
+    #define REFR_PROF_END(phase)
+    #define REFR_PROF_FRAME_END(px)
+#endif
+
+#ifndef LV_USE_REFR_DIRECT
+    #define LV_USE_REFR_DIRECT 0
+#endif
+
+#if LV_USE_REFR_DIRECT
+    #include <string.h>
+    #include "../lv_widgets/lv_img.h"
+#endif
+
+#ifndef LV_REFR_TILE_SIZE
+    #define LV_REFR_TILE_SIZE 0
+#endif
+
+#if LV_REFR_TILE_SIZE > 0
+    #define LV_REFR_TILE_COLS ((LV_HOR_RES_MAX + LV_REFR_TILE_SIZE - 1) / LV_REFR_TILE_SIZE)
+    #define LV_REFR_TILE_ROWS ((LV_VER_RES_MAX + LV_REFR_TILE_SIZE - 1) / LV_REFR_TILE_SIZE)
+#endif
+
+#ifndef LV_USE_REFR_OCCLUSION
+    #define LV_USE_REFR_OCCLUSION 0
+#endif
+
+#if LV_USE_REFR_OCCLUSION
+    #ifndef LV_REFR_OCCLUDER_MAX
+        #define LV_REFR_OCCLUDER_MAX 8  /*Opaque areas remembered per refreshed area*/
+    #endif
+    #ifndef LV_REFR_OCCLUDED_MAX
+        #define LV_REFR_OCCLUDED_MAX 16 /*Hidden objects remembered per refreshed area*/
+    #endif
+#endif
+
+#if LV_LAYER_CACHE_MAX
+    #ifdef LV_LAYER_CACHE_ALLOC_INCLUDE
+        #include LV_LAYER_CACHE_ALLOC_INCLUDE
+    #endif
+    #ifndef LV_LAYER_CACHE_ALLOC
+        #define LV_LAYER_CACHE_ALLOC(size) lv_mem_alloc(size)
+        #define LV_LAYER_CACHE_FREE(p)     lv_mem_free(p)
+    #endif
+    #ifndef LV_LAYER_CACHE_BYTES
+        #define LV_LAYER_CACHE_BYTES (32U * 1024U)
+    #endif
+#endif
+
 /*********************
  *      DEFINES
  *********************/
@@ -36,24 +95,85 @@
 /**********************
  *      TYPEDEFS
  **********************/
+typedef struct {
+    lv_disp_t * disp;
+    lv_area_t area;
+} lv_inv_batch_t;
+
+#if LV_LAYER_CACHE_MAX
+typedef struct {
+    lv_obj_t * obj;         /*NULL: free slot*/
+    lv_color_t * buf;       /*The rendered `area`*/
+    uint32_t size;          /*Size of `buf` in bytes*/
+    lv_area_t area;         /*Visible part of the object's draw area when it was rendered*/
+    uint16_t dirty_refr;    /*`layer_refr_cnt` when it was invalidated last time*/
+    uint8_t valid : 1;      /*1: `buf` shows the current look*/
+    uint8_t busy  : 1;      /*1: invalidated before the previous refresh too*/
+} lv_layer_cache_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static void lv_refr_join_area(void);
+static void inv_area_save(lv_disp_t * disp, const lv_area_t * area_p);
+static void inv_batch_add(lv_disp_t * disp, lv_area_t * area_p);
 static void lv_refr_areas(void);
+#if LV_REFR_TILE_SIZE > 0
+    static bool lv_refr_tiles(void);
+#endif
 static void lv_refr_area(const lv_area_t * area_p);
 static void lv_refr_area_part(const lv_area_t * area_p);
 static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj);
 static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p);
 static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p);
 static void lv_refr_vdb_flush(void);
+#if LV_LAYER_CACHE_MAX
+    static void layer_cache_update(void);
+    static void layer_cache_render(lv_layer_cache_t * c);
+    static lv_layer_cache_t * layer_cache_get(const lv_obj_t * obj);
+    static bool layer_cache_is_below(const lv_obj_t * obj, const lv_obj_t * layer);
+    static void layer_cache_mark(lv_layer_cache_t * c);
+#endif
+#if LV_USE_REFR_DIRECT
+    static bool lv_refr_area_direct(const lv_area_t * area_p);
+    static bool lv_refr_children_overlap(lv_obj_t * par, const lv_obj_t * until, const lv_area_t * area_p);
+#endif
+#if LV_USE_REFR_OCCLUSION
+    static void lv_refr_occlusion_collect(lv_obj_t * top_act_scr, lv_obj_t * top_prev_scr, const lv_area_t * mask_p);
+    static void occlusion_collect_top(lv_obj_t * top_p, const lv_area_t * mask_p);
+    static void occlusion_collect_level(lv_obj_t * border_p, const lv_area_t * mask_p);
+    static void occlusion_collect_obj(lv_obj_t * obj, const lv_area_t * mask_p);
+    static bool lv_refr_is_occluded(const lv_obj_t * obj);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static uint32_t px_num;
 static lv_disp_t * disp_refr; /*Display being refreshed*/
+static lv_inv_batch_t inv_batch[LV_INV_BUF_SIZE]; /*Areas collected between `_lv_inv_batch_begin/end`*/
+static uint16_t inv_batch_cnt;
+static uint8_t inv_batch_depth;
+static bool inv_refreshing; /*The invalid areas are being refreshed: only append (they are cleared after it)*/
+#if LV_REFR_TILE_SIZE > 0
+    static lv_area_t tile_box[LV_REFR_TILE_COLS * LV_REFR_TILE_ROWS];     /*Invalid part of the tiles*/
+    static uint8_t tile_dirty[LV_REFR_TILE_COLS * LV_REFR_TILE_ROWS];
+#endif
+#if LV_USE_REFR_OCCLUSION
+    static lv_area_t occluders[LV_REFR_OCCLUDER_MAX];       /*Opaque areas of the objects drawn later*/
+    static uint8_t occluder_cnt;
+    static const lv_obj_t * occluded[LV_REFR_OCCLUDED_MAX]; /*Objects fully covered by an occluder: not drawn*/
+    static uint8_t occluded_cnt;
+    static uint8_t occluder_block;                          /*>0: inside an object which masks its children*/
+#endif
+#if LV_LAYER_CACHE_MAX
+    static lv_layer_cache_t layer_cache[LV_LAYER_CACHE_MAX];
+    static uint8_t layer_cache_cnt;
+    static uint16_t layer_refr_cnt;             /*Incremented in every refresh with layer caches*/
+    static const lv_obj_t * layer_stop;         /*Rendering a layer: stop when this object is drawn*/
+    static bool layer_stopped;
+#endif
 #if LV_USE_PERF_MONITOR
     static uint32_t fps_sum_cnt;
     static uint32_t fps_sum_all;
@@ -115,6 +235,11 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
     /*Clear the invalidate buffer if the parameter is NULL*/
     if(area_p == NULL) {
         disp->inv_p = 0;
+        uint16_t i = 0;
+        while(i < inv_batch_cnt) {
+            if(inv_batch[i].disp == disp) inv_batch[i] = inv_batch[--inv_batch_cnt];
+            else i++;
+        }
         return;
     }
 
@@ -133,23 +258,37 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
     if(suc != false) {
         if(disp->driver.rounder_cb) disp->driver.rounder_cb(&disp->driver, &com_area);
 
-        /*Save only if this area is not in one of the saved areas*/
-        uint16_t i;
-        for(i = 0; i < disp->inv_p; i++) {
-            if(_lv_area_is_in(&com_area, &disp->inv_areas[i], 0) != false) return;
-        }
+        if(inv_batch_depth > 0) inv_batch_add(disp, &com_area);
+        else inv_area_save(disp, &com_area);
+    }
+}
 
-        /*Save the area*/
-        if(disp->inv_p < LV_INV_BUF_SIZE) {
-            lv_area_copy(&disp->inv_areas[disp->inv_p], &com_area);
-        }
-        else {   /*If no place for the area add the screen*/
-            disp->inv_p = 0;
-            lv_area_copy(&disp->inv_areas[disp->inv_p], &scr_area);
-        }
-        disp->inv_p++;
-        lv_task_set_prio(disp->refr_task, LV_REFR_TASK_PRIO);
+/**
+ * Start collecting the invalidated areas instead of saving them one by one.
+ * Overlapping areas are joined while collecting (if the union is not larger than the parts)
+ * so many small changes (e.g. one animation step of several objects)
+ * need less place in the invalidate buffer and don't overflow it to a full screen refresh.
+ * Can be nested.
+ */
+void _lv_inv_batch_begin(void)
+{
+    inv_batch_depth++;
+}
+
+/**
+ * Save the areas collected since the outermost `_lv_inv_batch_begin`
+ */
+void _lv_inv_batch_end(void)
+{
+    if(inv_batch_depth == 0) return;
+    inv_batch_depth--;
+    if(inv_batch_depth > 0) return;
+
+    uint16_t i;
+    for(i = 0; i < inv_batch_cnt; i++) {
+        inv_area_save(inv_batch[i].disp, &inv_batch[i].area);
     }
+    inv_batch_cnt = 0;
 }
 
 /**
@@ -172,6 +311,93 @@ void _lv_refr_set_disp_refreshing(lv_disp_t * disp)
     disp_refr = disp;
 }
 
+#if LV_LAYER_CACHE_MAX
+/**
+ * Take a free layer cache slot for an object. Use `lv_obj_set_layer_cache` instead.
+ * @param obj pointer to an object
+ * @return false: all the slots are used
+ */
+bool _lv_refr_layer_cache_add(lv_obj_t * obj)
+{
+    uint8_t i;
+    for(i = 0; i < LV_LAYER_CACHE_MAX; i++) {
+        lv_layer_cache_t * c = &layer_cache[i];
+        if(c->obj) continue;
+
+        _lv_memset_00(c, sizeof(lv_layer_cache_t));
+        c->obj = obj;
+        c->dirty_refr = layer_refr_cnt;
+        layer_cache_cnt++;
+        lv_obj_invalidate(obj);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Free the layer cache slot and buffer of an object (called also when the object is deleted)
+ * @param obj pointer to an object
+ */
+void _lv_refr_layer_cache_remove(lv_obj_t * obj)
+{
+    uint8_t i;
+    for(i = 0; i < LV_LAYER_CACHE_MAX; i++) {
+        lv_layer_cache_t * c = &layer_cache[i];
+        if(c->obj != obj) continue;
+
+        if(c->buf) LV_LAYER_CACHE_FREE(c->buf);
+        _lv_memset_00(c, sizeof(lv_layer_cache_t));
+        layer_cache_cnt--;
+    }
+}
+
+/**
+ * Mark the layers showing an invalidated area as out of date:
+ * - a change of the layer's object or any of its children (even if it's not visible now);
+ * - a change on the layer's area of something drawn under the object: the parents,
+ *   the older siblings of the object and of its parents (and their children) or the display background.
+ * Changes of the objects drawn above the layer (younger siblings, top and system layer) don't matter.
+ * @param obj the object whose area changed (NULL: the display background)
+ * @param area_p the changed area
+ */
+void _lv_refr_layer_cache_inv(const lv_obj_t * obj, const lv_area_t * area_p)
+{
+    if(layer_cache_cnt == 0) return;
+
+    uint8_t i;
+    for(i = 0; i < LV_LAYER_CACHE_MAX; i++) {
+        lv_layer_cache_t * c = &layer_cache[i];
+        if(c->obj == NULL) continue;
+
+        /*Inside the layer?*/
+        const lv_obj_t * par = obj;
+        while(par && par != c->obj) par = par->parent;
+        if(par) {
+            layer_cache_mark(c);
+            continue;
+        }
+
+        /*Under the layer? (Compare with the current place if not rendered yet)*/
+        lv_area_t layer_area;
+        if(c->valid) {
+            lv_area_copy(&layer_area, &c->area);
+        }
+        else {
+            lv_coord_t ext_size = c->obj->ext_draw_pad;
+            lv_area_copy(&layer_area, &c->obj->coords);
+            layer_area.x1 -= ext_size;
+            layer_area.y1 -= ext_size;
+            layer_area.x2 += ext_size;
+            layer_area.y2 += ext_size;
+        }
+        lv_area_t com;
+        if(_lv_area_intersect(&com, area_p, &layer_area) && layer_cache_is_below(obj, c->obj)) {
+            layer_cache_mark(c);
+        }
+    }
+}
+#endif
+
 /**
  * Called periodically to handle the refreshing
  * @param task pointer to the task itself
@@ -198,9 +424,26 @@ void _lv_disp_refr_task(lv_task_t * task)
         return;
     }
 
-    lv_refr_join_area();
+    REFR_PROF_BEGIN(RENDER_PROF_FRAME);
 
-    lv_refr_areas();
+#if LV_LAYER_CACHE_MAX
+    /*Render the out of date layers before drawing the invalid areas from them*/
+    if(layer_cache_cnt && disp_refr->inv_p != 0) layer_cache_update();
+#endif
+
+    inv_refreshing = true;
+#if LV_REFR_TILE_SIZE > 0
+    /*With a screen sized buffer redraw the areas as they are*/
+    if(lv_disp_is_true_double_buf(disp_refr) || lv_refr_tiles() == false)
+#endif
+    {
+        REFR_PROF_BEGIN(RENDER_PROF_JOIN);
+        lv_refr_join_area();
+        REFR_PROF_END(RENDER_PROF_JOIN);
+
+        lv_refr_areas();
+    }
+    inv_refreshing = false;
 
     /*If refresh happened ...*/
     if(disp_refr->inv_p != 0) {
@@ -272,6 +515,7 @@ void _lv_disp_refr_task(lv_task_t * task)
         if(disp_refr->driver.monitor_cb) {
             disp_refr->driver.monitor_cb(&disp_refr->driver, elaps, px_num);
         }
+        REFR_PROF_FRAME_END(px_num);
     }
 
     _lv_mem_buf_free_all();
@@ -336,6 +580,118 @@ uint32_t lv_refr_get_fps_avg(void)
  *   STATIC FUNCTIONS
  **********************/
 
+/**
+ * Save an (already truncated and rounded) area in the invalidate buffer of a display.
+ * The area is joined with the saved areas it is on if their union is not larger than the parts,
+ * saved areas inside it are dropped. If the buffer is full the area is joined with the saved area
+ * whose union grows the least; the whole screen is saved only if that wouldn't be less pixels.
+ */
+static void inv_area_save(lv_disp_t * disp, const lv_area_t * area_p)
+{
+    lv_area_t area;
+    lv_area_copy(&area, area_p);
+
+    uint16_t i = 0;
+    while(i < disp->inv_p) {
+        lv_area_t * saved = &disp->inv_areas[i];
+        /*Save only if this area is not in one of the saved areas*/
+        if(_lv_area_is_in(&area, saved, 0)) return;
+        if(inv_refreshing) {
+            i++;
+            continue;
+        }
+
+        bool take = _lv_area_is_in(saved, &area, 0);
+        if(!take && _lv_area_is_on(&area, saved)) {
+            lv_area_t joined;
+            _lv_area_join(&joined, &area, saved);
+            if(lv_area_get_size(&joined) <= lv_area_get_size(&area) + lv_area_get_size(saved)) {
+                lv_area_copy(&area, &joined);
+                take = true;
+            }
+        }
+
+        if(take) {
+            /*Take out the saved area and check the (grown) area against the others again*/
+            disp->inv_p--;
+            lv_area_copy(saved, &disp->inv_areas[disp->inv_p]);
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+
+    if(disp->inv_p < LV_INV_BUF_SIZE) {
+        lv_area_copy(&disp->inv_areas[disp->inv_p], &area);
+        disp->inv_p++;
+    }
+    else if(!inv_refreshing) {
+        /*No place: join with the saved area which grows the least*/
+        uint32_t total = 0;
+        uint32_t best_grow = UINT32_MAX;
+        uint16_t best = 0;
+        for(i = 0; i < disp->inv_p; i++) {
+            uint32_t size = lv_area_get_size(&disp->inv_areas[i]);
+            total += size;
+            lv_area_t joined;
+            _lv_area_join(&joined, &area, &disp->inv_areas[i]);
+            uint32_t grow = lv_area_get_size(&joined) - size;
+            if(grow < best_grow) {
+                best_grow = grow;
+                best = i;
+            }
+        }
+
+        uint32_t scr_size = (uint32_t)lv_disp_get_hor_res(disp) * lv_disp_get_ver_res(disp);
+        if(total + best_grow < scr_size) {
+            _lv_area_join(&disp->inv_areas[best], &area, &disp->inv_areas[best]);
+        }
+        else {   /*Joining wouldn't save pixels: add the screen*/
+            disp->inv_p = 1;
+            disp->inv_areas[0].x1 = 0;
+            disp->inv_areas[0].y1 = 0;
+            disp->inv_areas[0].x2 = lv_disp_get_hor_res(disp) - 1;
+            disp->inv_areas[0].y2 = lv_disp_get_ver_res(disp) - 1;
+        }
+    }
+    lv_task_set_prio(disp->refr_task, LV_REFR_TASK_PRIO);
+}
+
+/**
+ * Add an area to the batch. Join it with the collected areas it is on
+ * if their union is not larger than the two areas together.
+ * @param area_p the area to add. Modified (might become a union).
+ */
+static void inv_batch_add(lv_disp_t * disp, lv_area_t * area_p)
+{
+    uint16_t i = 0;
+    while(i < inv_batch_cnt) {
+        lv_inv_batch_t * b = &inv_batch[i];
+        if(b->disp == disp && _lv_area_is_on(area_p, &b->area)) {
+            lv_area_t joined;
+            _lv_area_join(&joined, area_p, &b->area);
+            if(lv_area_get_size(&joined) <= lv_area_get_size(area_p) + lv_area_get_size(&b->area)) {
+                /*Take out the joined area and try to join the union with the others too*/
+                lv_area_copy(area_p, &joined);
+                inv_batch[i] = inv_batch[--inv_batch_cnt];
+                i = 0;
+                continue;
+            }
+        }
+        i++;
+    }
+
+    /*The batch is full: save the area directly*/
+    if(inv_batch_cnt >= LV_INV_BUF_SIZE) {
+        inv_area_save(disp, area_p);
+        return;
+    }
+
+    inv_batch[inv_batch_cnt].disp = disp;
+    lv_area_copy(&inv_batch[inv_batch_cnt].area, area_p);
+    inv_batch_cnt++;
+}
+
 /**
  * Join the areas which has got common parts
  */
@@ -408,11 +764,91 @@ static void lv_refr_areas(void)
     }
 }
 
+#if LV_REFR_TILE_SIZE > 0
+/**
+ * Refresh the invalid areas tile by tile instead of joining them.
+ * The screen is divided into `LV_REFR_TILE_SIZE` sized tiles and only the invalid part of the dirty tiles
+ * is redrawn, so small scattered changes don't pull in the whole bounding area of their neighbours.
+ * Dirty parts of neighbouring tiles in a row with the same height are refreshed together
+ * (e.g. a full screen change is still refreshed in full width bands).
+ * @return false if the display is larger than `LV_HOR_RES_MAX` x `LV_VER_RES_MAX` (refresh the areas normally)
+ */
+static bool lv_refr_tiles(void)
+{
+    lv_coord_t hor_res = lv_disp_get_hor_res(disp_refr);
+    lv_coord_t ver_res = lv_disp_get_ver_res(disp_refr);
+    uint16_t cols = (hor_res + LV_REFR_TILE_SIZE - 1) / LV_REFR_TILE_SIZE;
+    uint16_t rows = (ver_res + LV_REFR_TILE_SIZE - 1) / LV_REFR_TILE_SIZE;
+    if(cols > LV_REFR_TILE_COLS || rows > LV_REFR_TILE_ROWS) return false;
+
+    px_num = 0;
+    if(disp_refr->inv_p == 0) return true;
+
+    REFR_PROF_BEGIN(RENDER_PROF_JOIN);
+    _lv_memset_00(tile_dirty, cols * rows);
+
+    /*Add the parts of the invalid areas to the tiles they are on (the areas are already on the screen)*/
+    uint16_t i;
+    for(i = 0; i < disp_refr->inv_p; i++) {
+        const lv_area_t * a = &disp_refr->inv_areas[i];
+        lv_coord_t r;
+        lv_coord_t c;
+        for(r = a->y1 / LV_REFR_TILE_SIZE; r <= a->y2 / LV_REFR_TILE_SIZE; r++) {
+            for(c = a->x1 / LV_REFR_TILE_SIZE; c <= a->x2 / LV_REFR_TILE_SIZE; c++) {
+                lv_area_t tile;
+                lv_area_t part;
+                tile.x1 = c * LV_REFR_TILE_SIZE;
+                tile.y1 = r * LV_REFR_TILE_SIZE;
+                tile.x2 = tile.x1 + LV_REFR_TILE_SIZE - 1;
+                tile.y2 = tile.y1 + LV_REFR_TILE_SIZE - 1;
+                if(_lv_area_intersect(&part, a, &tile) == false) continue;
+
+                uint16_t t = r * cols + c;
+                if(tile_dirty[t]) _lv_area_join(&tile_box[t], &tile_box[t], &part);
+                else lv_area_copy(&tile_box[t], &part);
+                tile_dirty[t] = 1;
+            }
+        }
+    }
+
+    /*Join the dirty parts of the neighbouring tiles of a row if they are on the same lines*/
+    uint16_t t;
+    uint16_t last_t = 0;
+    for(t = 0; t < cols * rows; t++) {
+        if(tile_dirty[t] == 0) continue;
+        last_t = t;
+        if(t % cols == 0 || tile_dirty[t - 1] == 0) continue;
+
+        lv_area_t * prev = &tile_box[t - 1];
+        if(prev->x2 + 1 == tile_box[t].x1 && prev->y1 == tile_box[t].y1 && prev->y2 == tile_box[t].y2) {
+            tile_box[t].x1 = prev->x1;
+            tile_dirty[t - 1] = 0;
+        }
+    }
+    REFR_PROF_END(RENDER_PROF_JOIN);
+
+    disp_refr->driver.buffer->last_area = 0;
+    disp_refr->driver.buffer->last_part = 0;
+
+    for(t = 0; t <= last_t; t++) {
+        if(tile_dirty[t] == 0) continue;
+
+        if(t == last_t) disp_refr->driver.buffer->last_area = 1;
+        disp_refr->driver.buffer->last_part = 0;
+        lv_refr_area(&tile_box[t]);
+
+        px_num += lv_area_get_size(&tile_box[t]);
+    }
+
+    return true;
+}
+#endif
+
 /**
  * Refresh an area if there is Virtual Display Buffer
  * @param area_p  pointer to an area to refresh
  */
-static void lv_refr_area(const lv_area_t * area_p)
+LV_ATTRIBUTE_HOT static void lv_refr_area(const lv_area_t * area_p)
 {
     /*True double buffering: there are two screen sized buffers. Just redraw directly into a
      * buffer*/
@@ -427,6 +863,10 @@ static void lv_refr_area(const lv_area_t * area_p)
     }
     /*The buffer is smaller: refresh the area in parts*/
     else {
+#if LV_USE_REFR_DIRECT
+        /*Only an opaque image is visible here: let the driver send it without drawing*/
+        if(lv_refr_area_direct(area_p)) return;
+#endif
         lv_disp_buf_t * vdb = lv_disp_get_buf(disp_refr);
         /*Calculate the max row num*/
         lv_coord_t w = lv_area_get_width(area_p);
@@ -500,7 +940,7 @@ static void lv_refr_area(const lv_area_t * area_p)
  * Refresh a part of an area which is on the actual Virtual Display Buffer
  * @param area_p pointer to an area to refresh
  */
-static void lv_refr_area_part(const lv_area_t * area_p)
+LV_ATTRIBUTE_HOT static void lv_refr_area_part(const lv_area_t * area_p)
 {
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp_refr);
 
@@ -512,6 +952,8 @@ static void lv_refr_area_part(const lv_area_t * area_p)
         }
     }
 
+    REFR_PROF_BEGIN(RENDER_PROF_DRAW);
+
     lv_obj_t * top_act_scr = NULL;
     lv_obj_t * top_prev_scr = NULL;
 
@@ -553,21 +995,26 @@ static void lv_refr_area_part(const lv_area_t * area_p)
 
         }
     }
+    /*Get the most top object which is not covered by others*/
+    if(disp_refr->prev_scr && top_prev_scr == NULL) {
+        top_prev_scr = disp_refr->prev_scr;
+    }
+    if(top_act_scr == NULL) {
+        top_act_scr = disp_refr->act_scr;
+    }
+
+#if LV_USE_REFR_OCCLUSION
+    /*Find the objects covered by opaque objects drawn later*/
+    lv_refr_occlusion_collect(top_act_scr, top_prev_scr, &start_mask);
+#endif
+
     /*Refresh the previous screen if any*/
     if(disp_refr->prev_scr) {
-        /*Get the most top object which is not covered by others*/
-        if(top_prev_scr == NULL) {
-            top_prev_scr = disp_refr->prev_scr;
-        }
         /*Do the refreshing from the top object*/
         lv_refr_obj_and_children(top_prev_scr, &start_mask);
 
     }
 
-
-    if(top_act_scr == NULL) {
-        top_act_scr = disp_refr->act_scr;
-    }
     /*Do the refreshing from the top object*/
     lv_refr_obj_and_children(top_act_scr, &start_mask);
 
@@ -575,6 +1022,8 @@ static void lv_refr_area_part(const lv_area_t * area_p)
     lv_refr_obj_and_children(lv_disp_get_layer_top(disp_refr), &start_mask);
     lv_refr_obj_and_children(lv_disp_get_layer_sys(disp_refr), &start_mask);
 
+    REFR_PROF_END(RENDER_PROF_DRAW);
+
     /* In true double buffered mode flush only once when all areas were rendered.
      * In normal mode flush after every area */
     if(lv_disp_is_true_double_buf(disp_refr) == false) {
@@ -588,12 +1037,16 @@ static void lv_refr_area_part(const lv_area_t * area_p)
  * @param obj the first object to start the searching (typically a screen)
  * @return
  */
-static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj)
+LV_ATTRIBUTE_HOT static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj)
 {
     lv_obj_t * found_p = NULL;
 
     /*If this object is fully cover the draw area check the children too */
     if(_lv_area_is_in(area_p, &obj->coords, 0) && obj->hidden == 0) {
+#if LV_LAYER_CACHE_MAX
+        /*An up to date layer has everything under the object too*/
+        if(obj->layer_cache && layer_cache_get(obj)) return obj;
+#endif
         lv_design_res_t design_res = obj->design_cb(obj, area_p, LV_DESIGN_COVER_CHK);
         if(design_res == LV_DESIGN_RES_MASKED) return NULL;
 
@@ -629,7 +1082,7 @@ static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj)
  * @param top_p pointer to an objects. Start the drawing from it.
  * @param mask_p pointer to an area, the objects will be drawn only here
  */
-static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p)
+LV_ATTRIBUTE_HOT static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p)
 {
     /* Normally always will be a top_obj (at least the screen)
      * but in special cases (e.g. if the screen has alpha) it won't.
@@ -673,11 +1126,21 @@ static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p)
  * @param obj pointer to an object to refresh
  * @param mask_ori_p pointer to an area, the objects will be drawn only here
  */
-static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
+LV_ATTRIBUTE_HOT static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
 {
     /*Do not refresh hidden objects*/
     if(obj->hidden != 0) return;
 
+#if LV_LAYER_CACHE_MAX
+    /*Rendering a layer: the objects above it are not part of it*/
+    if(layer_stopped) return;
+#endif
+
+#if LV_USE_REFR_OCCLUSION
+    /*Do not refresh objects covered by others*/
+    if(lv_refr_is_occluded(obj)) return;
+#endif
+
     bool union_ok; /* Store the return value of area_union */
     /* Truncate the original mask to the coordinates of the parent
      * because the parent and its children are visible only here */
@@ -695,6 +1158,18 @@ static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
     /*Draw the parent and its children only if they ore on 'mask_parent'*/
     if(union_ok != false) {
 
+#if LV_LAYER_CACHE_MAX
+        /*Copy the object, its children and everything under it from the layer*/
+        if(obj->layer_cache) {
+            lv_layer_cache_t * c = layer_cache_get(obj);
+            if(c && _lv_area_is_in(&obj_ext_mask, &c->area, 0)) {
+                _lv_blend_map(&obj_ext_mask, &c->area, c->buf, NULL, LV_DRAW_MASK_RES_FULL_COVER, LV_OPA_COVER,
+                              LV_BLEND_MODE_NORMAL);
+                return;
+            }
+        }
+#endif
+
         /* Redraw the object */
         if(obj->design_cb) obj->design_cb(obj, &obj_ext_mask, LV_DESIGN_DRAW_MAIN);
 
@@ -741,16 +1216,287 @@ static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
             }
         }
 
+#if LV_LAYER_CACHE_MAX
+        /*Rendering a layer: the parents' post draw is above it*/
+        if(layer_stopped) return;
+#endif
+
         /* If all the children are redrawn make 'post draw' design */
         if(obj->design_cb) obj->design_cb(obj, &obj_ext_mask, LV_DESIGN_DRAW_POST);
+
+#if LV_LAYER_CACHE_MAX
+        if(obj == layer_stop) layer_stopped = true;
+#endif
+    }
+}
+
+#if LV_LAYER_CACHE_MAX
+/**
+ * Render the out of date layers of the objects visible on the display being refreshed.
+ * A layer invalidated in two refreshes in a row is changing (e.g. animated):
+ * it's not rendered (the object is drawn normally) until a refresh without change.
+ */
+static void layer_cache_update(void)
+{
+    /*The layers store only the active screen, what the drawing functions write into the buffer*/
+    if(disp_refr->prev_scr == NULL && disp_refr->driver.set_px_cb == NULL) {
+        uint8_t i;
+        for(i = 0; i < LV_LAYER_CACHE_MAX; i++) {
+            lv_layer_cache_t * c = &layer_cache[i];
+            if(c->obj == NULL || c->valid) continue;
+            if(c->busy && c->dirty_refr == layer_refr_cnt) continue;
+            if(lv_obj_get_disp(c->obj) != disp_refr) continue;
+
+            REFR_PROF_BEGIN(RENDER_PROF_DRAW);
+            layer_cache_render(c);
+            REFR_PROF_END(RENDER_PROF_DRAW);
+        }
     }
+
+    layer_refr_cnt++;
 }
 
+/**
+ * Render a layer: draw the screen into the layer's buffer on the visible part of the object
+ * and stop when the object and its children are drawn
+ * @param c pointer to a layer cache entry
+ */
+static void layer_cache_render(lv_layer_cache_t * c)
+{
+    lv_area_t area;
+    lv_coord_t ext_size = c->obj->ext_draw_pad;
+    lv_area_copy(&area, &c->obj->coords);
+    area.x1 -= ext_size;
+    area.y1 -= ext_size;
+    area.x2 += ext_size;
+    area.y2 += ext_size;
+    if(lv_obj_area_is_visible(c->obj, &area) == false) return;
+
+    /*`lv_obj_area_is_visible` accepts the objects of the not loaded screens too*/
+    lv_obj_t * scr = lv_obj_get_screen(c->obj);
+    if(scr != disp_refr->act_scr && scr != disp_refr->top_layer && scr != disp_refr->sys_layer) return;
+
+    lv_area_t scr_area;
+    lv_area_set(&scr_area, 0, 0, lv_disp_get_hor_res(disp_refr) - 1, lv_disp_get_ver_res(disp_refr) - 1);
+    if(_lv_area_intersect(&area, &area, &scr_area) == false) return;
+
+    /*(Re)allocate the buffer if the size changed, keeping all the layers in the budget*/
+    uint32_t size = lv_area_get_size(&area) * sizeof(lv_color_t);
+    if(size != c->size) {
+        if(c->buf) LV_LAYER_CACHE_FREE(c->buf);
+        c->buf = NULL;
+        c->size = 0;
+
+        uint32_t used = 0;
+        uint8_t i;
+        for(i = 0; i < LV_LAYER_CACHE_MAX; i++) used += layer_cache[i].size;
+        if(used + size > LV_LAYER_CACHE_BYTES) return;
+
+        c->buf = LV_LAYER_CACHE_ALLOC(size);
+        if(c->buf == NULL) return;
+        c->size = size;
+    }
+
+    /*Let the drawing functions write into the layer buffer*/
+    lv_disp_buf_t * vdb = lv_disp_get_buf(disp_refr);
+    lv_area_t vdb_area_ori;
+    lv_area_copy(&vdb_area_ori, &vdb->area);
+    lv_color_t * buf_act_ori = vdb->buf_act;
+    lv_area_copy(&vdb->area, &area);
+    vdb->buf_act = c->buf;
+
+#if LV_USE_REFR_OCCLUSION
+    occluded_cnt = 0;
+    occluder_block = 0;
+#endif
+
+    layer_stop = c->obj;
+    layer_stopped = false;
+    lv_refr_obj_and_children(disp_refr->act_scr, &area);
+    if(layer_stopped == false) lv_refr_obj_and_children(disp_refr->top_layer, &area);
+    if(layer_stopped == false) lv_refr_obj_and_children(disp_refr->sys_layer, &area);
+
+    /*The post draw of the parents was skipped: remove the masks they added*/
+    int16_t id;
+    for(id = 0; id < _LV_MASK_MAX_NUM; id++) lv_draw_mask_remove_id(id);
+
+    c->valid = layer_stopped ? 1 : 0;
+    lv_area_copy(&c->area, &area);
+    layer_stop = NULL;
+    layer_stopped = false;
+
+    lv_area_copy(&vdb->area, &vdb_area_ori);
+    vdb->buf_act = buf_act_ori;
+}
+
+/**
+ * Get the up to date layer of an object
+ * @param obj pointer to an object
+ * @return pointer to the layer cache entry or NULL if there is no usable layer
+ */
+static lv_layer_cache_t * layer_cache_get(const lv_obj_t * obj)
+{
+    /*Draw every object normally while rendering a layer or during a screen load animation*/
+    if(layer_stop || disp_refr->prev_scr) return NULL;
+
+    uint8_t i;
+    for(i = 0; i < LV_LAYER_CACHE_MAX; i++) {
+        if(layer_cache[i].obj == obj) return layer_cache[i].valid ? &layer_cache[i] : NULL;
+    }
+    return NULL;
+}
+
+/**
+ * Tell whether an object is drawn before (under) the layer of an other one (not inside it)
+ * @param obj pointer to an object (NULL: the display background)
+ * @param layer pointer to the object with a layer cache
+ * @return true: `obj` is under the layer
+ */
+static bool layer_cache_is_below(const lv_obj_t * obj, const lv_obj_t * layer)
+{
+    if(obj == NULL) return true;
+
+    /*Go up to the same level in the object tree*/
+    uint16_t obj_depth = 0;
+    uint16_t layer_depth = 0;
+    const lv_obj_t * i;
+    for(i = obj->parent; i; i = i->parent) obj_depth++;
+    for(i = layer->parent; i; i = i->parent) layer_depth++;
+    while(obj_depth > layer_depth) {
+        obj = obj->parent;
+        obj_depth--;
+    }
+    while(layer_depth > obj_depth) {
+        layer = layer->parent;
+        layer_depth--;
+    }
+
+    /*`obj` is a parent of the layer*/
+    if(obj == layer) return true;
+
+    /*Go up to the children of the common parent*/
+    while(obj->parent != layer->parent) {
+        obj = obj->parent;
+        layer = layer->parent;
+    }
+
+    /*On different screens: only the top and system layer are above the screens*/
+    if(obj->parent == NULL) {
+        lv_disp_t * disp = lv_obj_get_disp(layer);
+        if(obj == disp->sys_layer) return false;
+        if(obj == disp->top_layer) return layer == disp->sys_layer;
+        return true;
+    }
+
+    /*The children are drawn from the end of the list, the head is drawn last*/
+    _LV_LL_READ(obj->parent->child_ll, i) {
+        if(i == obj) return false;
+        if(i == layer) return true;
+    }
+    return true;
+}
+
+/**
+ * Mark a layer as out of date and remember whether it changes continuously
+ * @param c pointer to a layer cache entry
+ */
+static void layer_cache_mark(lv_layer_cache_t * c)
+{
+    if(c->dirty_refr != layer_refr_cnt) {
+        c->busy = c->dirty_refr == (uint16_t)(layer_refr_cnt - 1) ? 1 : 0;
+        c->dirty_refr = layer_refr_cnt;
+    }
+    c->valid = 0;
+}
+#endif
+
+#if LV_USE_REFR_DIRECT
+/**
+ * Send an area with the driver's `direct_cb` if it shows only a plain true color image:
+ * in-memory source, no zoom, rotation, offset, tiling, recolor or anything drawn over it.
+ * @param area_p pointer to an area to refresh
+ * @return true: the area was sent; false: it has to be drawn normally
+ */
+static bool lv_refr_area_direct(const lv_area_t * area_p)
+{
+    if(disp_refr->driver.direct_cb == NULL || disp_refr->prev_scr) return false;
+    if(lv_draw_mask_get_cnt() != 0) return false;
+
+    lv_obj_t * img = lv_refr_get_top_obj(area_p, disp_refr->act_scr);
+    if(img == NULL) return false;
+
+    /*Objects drawn after the ancestors (e.g. scrollbars) are not checked so allow only screen level images*/
+    lv_obj_t * par = lv_obj_get_parent(img);
+    if(par != NULL && par != disp_refr->act_scr) return false;
+
+    lv_obj_type_t type;
+    lv_obj_get_type(img, &type);
+    if(strcmp(type.type[0], "lv_img") != 0) return false;
+
+    /*The cover check has already tested clip corner, opacity, the final angle and the blend modes*/
+    lv_img_ext_t * ext = lv_obj_get_ext_attr(img);
+    if(ext->src_type != LV_IMG_SRC_VARIABLE || ext->cf != LV_IMG_CF_TRUE_COLOR) return false;
+    if(ext->zoom != LV_IMG_ZOOM_NONE) return false;
+    if(lv_obj_get_style_transform_zoom(img, LV_IMG_PART_MAIN) != LV_IMG_ZOOM_NONE) return false;
+    if(ext->offset.x != 0 || ext->offset.y != 0) return false;
+    if(ext->w != lv_obj_get_width(img) || ext->h != lv_obj_get_height(img)) return false;
+    if(lv_obj_get_style_image_recolor_opa(img, LV_IMG_PART_MAIN) != LV_OPA_TRANSP) return false;
+    if(lv_obj_get_style_border_post(img, LV_IMG_PART_MAIN) &&
+       lv_obj_get_style_border_width(img, LV_IMG_PART_MAIN) != 0) return false;
+
+    /*Nothing else can be on the area: children, younger siblings, top and sys layer*/
+    if(lv_refr_children_overlap(img, NULL, area_p)) return false;
+    if(par && lv_refr_children_overlap(par, img, area_p)) return false;
+    if(lv_refr_children_overlap(lv_disp_get_layer_top(disp_refr), NULL, area_p)) return false;
+    if(lv_refr_children_overlap(lv_disp_get_layer_sys(disp_refr), NULL, area_p)) return false;
+
+    const lv_img_dsc_t * dsc = ext->src;
+    const lv_color_t * src = (const lv_color_t *)dsc->data;
+    src += (int32_t)(area_p->y1 - img->coords.y1) * ext->w + (area_p->x1 - img->coords.x1);
+
+    /*The driver may use the draw buffers as bounce buffers so wait for the last flush*/
+    lv_disp_buf_t * vdb = lv_disp_get_buf(disp_refr);
+    while(vdb->flushing) {
+        if(disp_refr->driver.wait_cb) disp_refr->driver.wait_cb(&disp_refr->driver);
+    }
+
+    return disp_refr->driver.direct_cb(&disp_refr->driver, area_p, src, ext->w);
+}
+
+/**
+ * Tell whether a visible child of `par` overlaps an area
+ * @param par pointer to a parent object
+ * @param until check only the children younger than this (drawn above it). NULL to check all.
+ * @param area_p pointer to an area
+ * @return true: a child (including its extended draw area) is on the area
+ */
+static bool lv_refr_children_overlap(lv_obj_t * par, const lv_obj_t * until, const lv_area_t * area_p)
+{
+    lv_obj_t * i;
+    _LV_LL_READ(par->child_ll, i) {
+        if(i == until) break;
+        if(i->hidden) continue;
+
+        lv_area_t a;
+        lv_area_copy(&a, &i->coords);
+        a.x1 -= i->ext_draw_pad;
+        a.y1 -= i->ext_draw_pad;
+        a.x2 += i->ext_draw_pad;
+        a.y2 += i->ext_draw_pad;
+        if(_lv_area_is_on(&a, area_p)) return true;
+    }
+
+    return false;
+}
+#endif
+
 /**
  * Flush the content of the VDB
  */
-static void lv_refr_vdb_flush(void)
+LV_ATTRIBUTE_HOT static void lv_refr_vdb_flush(void)
 {
+    REFR_PROF_BEGIN(RENDER_PROF_FLUSH);
+
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp_refr);
 
     /*In double buffered mode wait until the other buffer is flushed before flushing the current
@@ -778,4 +1524,134 @@ static void lv_refr_vdb_flush(void)
         else
             vdb->buf_act = vdb->buf1;
     }
+
+    REFR_PROF_END(RENDER_PROF_FLUSH);
+}
+
+#if LV_USE_REFR_OCCLUSION
+
+/**
+ * Before drawing an area find the objects which are fully covered by an opaque object drawn later.
+ * The objects are visited in reverse drawing order (from the top), so when an object is checked
+ * all the opaque areas above it are known.
+ * @param top_act_scr the top object of the active screen where the drawing starts
+ * @param top_prev_scr the top object of the previous screen or NULL
+ * @param mask_p the area to refresh
+ */
+static void lv_refr_occlusion_collect(lv_obj_t * top_act_scr, lv_obj_t * top_prev_scr, const lv_area_t * mask_p)
+{
+    occluder_cnt = 0;
+    occluded_cnt = 0;
+    occluder_block = 0;
+
+    occlusion_collect_top(lv_disp_get_layer_sys(disp_refr), mask_p);
+    occlusion_collect_top(lv_disp_get_layer_top(disp_refr), mask_p);
+    occlusion_collect_top(top_act_scr, mask_p);
+    if(top_prev_scr) occlusion_collect_top(top_prev_scr, mask_p);
+}
+
+/**
+ * Reverse of `lv_refr_obj_and_children`: first the younger siblings of the parents, then the top object
+ */
+static void occlusion_collect_top(lv_obj_t * top_p, const lv_area_t * mask_p)
+{
+    if(top_p == NULL) top_p = lv_disp_get_scr_act(disp_refr);
+    if(top_p == NULL) return;
+
+    occlusion_collect_level(top_p, mask_p);
+    occlusion_collect_obj(top_p, mask_p);
+}
+
+/**
+ * Visit the younger siblings of `border_p` and of its parents. The outer levels are drawn later so visit them first.
+ */
+static void occlusion_collect_level(lv_obj_t * border_p, const lv_area_t * mask_p)
+{
+    lv_obj_t * par = lv_obj_get_parent(border_p);
+    if(par == NULL) return;
+
+    occlusion_collect_level(par, mask_p);
+
+    /*From the youngest child down to the one just above `border_p`*/
+    lv_obj_t * i = _lv_ll_get_head(&par->child_ll);
+    while(i != NULL && i != border_p) {
+        occlusion_collect_obj(i, mask_p);
+        i = _lv_ll_get_next(&par->child_ll, i);
+    }
+}
+
+/**
+ * Reverse of `lv_refr_obj`: check whether the object is covered,
+ * visit its children (they are drawn later) and finally save its own opaque area.
+ * @param obj pointer to an object
+ * @param mask_p the area where the object can be visible (as in `lv_refr_obj`)
+ */
+static void occlusion_collect_obj(lv_obj_t * obj, const lv_area_t * mask_p)
+{
+    if(obj->hidden != 0) return;
+
+    lv_area_t obj_area;
+    lv_area_t obj_ext_mask;
+    lv_coord_t ext_size = obj->ext_draw_pad;
+    lv_obj_get_coords(obj, &obj_area);
+    obj_area.x1 -= ext_size;
+    obj_area.y1 -= ext_size;
+    obj_area.x2 += ext_size;
+    obj_area.y2 += ext_size;
+    if(_lv_area_intersect(&obj_ext_mask, mask_p, &obj_area) == false) return;
+
+    /*If an object drawn later covers everything this object (and its children) would draw, skip it*/
+    uint8_t i;
+    for(i = 0; i < occluder_cnt; i++) {
+        if(_lv_area_is_in(&obj_ext_mask, &occluders[i], 0)) {
+            if(occluded_cnt < LV_REFR_OCCLUDED_MAX) {
+                occluded[occluded_cnt] = obj;
+                occluded_cnt++;
+                return;
+            }
+            break;  /*No more place: draw it normally*/
+        }
+    }
+
+    /*The children are visible only on the object*/
+    lv_area_t obj_mask;
+    lv_obj_get_coords(obj, &obj_area);
+    if(_lv_area_intersect(&obj_mask, mask_p, &obj_area) == false) return;
+
+    lv_design_res_t design_res = LV_DESIGN_RES_NOT_COVER;
+    if(obj->design_cb) design_res = obj->design_cb(obj, &obj_mask, LV_DESIGN_COVER_CHK);
+#if LV_USE_OPA_SCALE
+    if(design_res == LV_DESIGN_RES_COVER && lv_obj_get_style_opa_scale(obj, LV_OBJ_PART_MAIN) != LV_OPA_COVER) {
+        design_res = LV_DESIGN_RES_NOT_COVER;
+    }
+#endif
+
+    /*The children of a masking object (e.g. clipped corners) are not drawn fully: they can't cover others*/
+    if(design_res == LV_DESIGN_RES_MASKED) occluder_block++;
+
+    lv_obj_t * child_p;
+    _LV_LL_READ(obj->child_ll, child_p) {
+        occlusion_collect_obj(child_p, &obj_mask);
+    }
+
+    if(design_res == LV_DESIGN_RES_MASKED) occluder_block--;
+
+    if(design_res == LV_DESIGN_RES_COVER && occluder_block == 0 && occluder_cnt < LV_REFR_OCCLUDER_MAX) {
+        lv_area_copy(&occluders[occluder_cnt], &obj_mask);
+        occluder_cnt++;
+    }
 }
+
+/**
+ * Check whether an object was found to be covered in `lv_refr_occlusion_collect`
+ */
+static bool lv_refr_is_occluded(const lv_obj_t * obj)
+{
+    uint8_t i;
+    for(i = 0; i < occluded_cnt; i++) {
+        if(occluded[i] == obj) return true;
+    }
+    return false;
+}
+
+#endif /*LV_USE_REFR_OCCLUSION*/
@@ -64,6 +64,17 @@ void lv_refr_now(lv_disp_t * disp);
  */
 void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p);
 
+/**
+ * Start collecting the invalidated areas. Overlapping areas are joined
+ * and saved together by `_lv_inv_batch_end`. Can be nested.
+ */
+void _lv_inv_batch_begin(void);
+
+/**
+ * Save the areas collected since the outermost `_lv_inv_batch_begin`
+ */
+void _lv_inv_batch_end(void);
+
 /**
  * Get the display which is being refreshed
  * @return the display being refreshed
@@ -78,6 +89,28 @@ lv_disp_t * _lv_refr_get_disp_refreshing(void);
  */
 void _lv_refr_set_disp_refreshing(lv_disp_t * disp);
 
+#if LV_LAYER_CACHE_MAX
+/**
+ * Take a free layer cache slot for an object. Use `lv_obj_set_layer_cache` instead.
+ * @param obj pointer to an object
+ * @return false: all the slots are used
+ */
+bool _lv_refr_layer_cache_add(lv_obj_t * obj);
+
+/**
+ * Free the layer cache slot and buffer of an object (called also when the object is deleted)
+ * @param obj pointer to an object
+ */
+void _lv_refr_layer_cache_remove(lv_obj_t * obj);
+
+/**
+ * Mark the layers showing an invalidated area as out of date
+ * @param obj the object whose area changed (NULL: the display background)
+ * @param area_p the changed area
+ */
+void _lv_refr_layer_cache_inv(const lv_obj_t * obj, const lv_area_t * area_p);
+#endif
+
 #if LV_USE_PERF_MONITOR
 /**
  * Get the average FPS since start up
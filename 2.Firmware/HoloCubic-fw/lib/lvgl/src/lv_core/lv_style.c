@@ -31,12 +31,31 @@
  *      TYPEDEFS
  **********************/
 
+#if LV_USE_STYLE_ARENA
+struct _lv_style_arena_t {
+    struct _lv_style_arena_t * next;        /*In `arena_list`*/
+    struct _lv_style_arena_t * prev_open;   /*The arena which was open before this one*/
+    uint8_t * top;                          /*Next free byte*/
+    uint8_t * end;
+    uint8_t * last;                         /*The last allocation (can grow in place)*/
+    uint32_t live;                          /*Allocations not released yet*/
+    uint8_t open;
+    /*The buffer follows the header*/
+};
+#endif
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 LV_ATTRIBUTE_FAST_MEM static inline int32_t get_property_index(const lv_style_t * style, lv_style_property_t prop);
 static lv_style_t * get_alloc_local_style(lv_style_list_t * list);
 static inline void style_resize(lv_style_t * style, size_t sz);
+static void * style_mem_alloc(size_t size);
+static void style_mem_free(void * p);
+#if LV_USE_STYLE_ARENA
+static lv_style_arena_t * arena_find(const void * p);
+static void arena_release(lv_style_arena_t * arena);
+#endif
 static inline lv_style_property_t get_style_prop(const lv_style_t * style, size_t idx);
 static inline uint8_t get_style_prop_id(const lv_style_t * style, size_t idx);
 static inline uint8_t get_style_prop_attr(const lv_style_t * style, size_t idx);
@@ -50,6 +69,12 @@ static inline size_t get_next_prop_index(uint8_t prop_id, size_t id);
 /**********************
  *  STATIC VARIABLES
  **********************/
+static uint32_t style_change_id; /*Incremented on every change which might affect a resolved property*/
+#if LV_USE_STYLE_ARENA
+static lv_style_arena_t * arena_list;   /*Arenas which are open or have live allocations*/
+static lv_style_arena_t * arena_act;    /*The last opened arena, new allocations come from here*/
+static lv_style_arena_stats_t arena_stats;
+#endif
 
 /**********************
  *      MACROS
@@ -78,6 +103,7 @@ void lv_style_init(lv_style_t * style)
  */
 void lv_style_copy(lv_style_t * style_dest, const lv_style_t * style_src)
 {
+    _lv_style_mark_changed();
     if(style_src == NULL) return;
 
     LV_ASSERT_STYLE(style_dest);
@@ -86,7 +112,7 @@ void lv_style_copy(lv_style_t * style_dest, const lv_style_t * style_src)
     if(style_src->map == NULL) return;
 
     uint16_t size = _lv_style_get_mem_size(style_src);
-    style_dest->map = lv_mem_alloc(size);
+    style_dest->map = style_mem_alloc(size);
     _lv_memcpy(style_dest->map, style_src->map, size);
 }
 
@@ -99,6 +125,7 @@ void lv_style_copy(lv_style_t * style_dest, const lv_style_t * style_src)
  */
 bool lv_style_remove_prop(lv_style_t * style, lv_style_property_t prop)
 {
+    _lv_style_mark_changed();
     if(style == NULL) return false;
     LV_ASSERT_STYLE(style);
 
@@ -149,6 +176,7 @@ void lv_style_list_init(lv_style_list_t * list)
  */
 void lv_style_list_copy(lv_style_list_t * list_dest, const lv_style_list_t * list_src)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE_LIST(list_dest);
     LV_ASSERT_STYLE_LIST(list_src);
 
@@ -195,6 +223,7 @@ void lv_style_list_copy(lv_style_list_t * list_dest, const lv_style_list_t * lis
  */
 void _lv_style_list_add_style(lv_style_list_t * list, lv_style_t * style)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE_LIST(list);
     LV_ASSERT_STYLE(style);
 
@@ -233,6 +262,7 @@ void _lv_style_list_add_style(lv_style_list_t * list, lv_style_t * style)
  */
 void _lv_style_list_remove_style(lv_style_list_t * list, lv_style_t * style)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE_LIST(list);
     LV_ASSERT_STYLE(style);
 
@@ -284,6 +314,7 @@ void _lv_style_list_remove_style(lv_style_list_t * list, lv_style_t * style)
  */
 void _lv_style_list_reset(lv_style_list_t * list)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE_LIST(list);
 
     if(list == NULL) return;
@@ -292,7 +323,7 @@ void _lv_style_list_reset(lv_style_list_t * list)
         lv_style_t * local = lv_style_list_get_local_style(list);
         if(local) {
             lv_style_reset(local);
-            lv_mem_free(local);
+            style_mem_free(local);
         }
     }
 
@@ -321,9 +352,10 @@ void _lv_style_list_reset(lv_style_list_t * list)
  */
 void lv_style_reset(lv_style_t * style)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE(style);
 
-    lv_mem_free(style->map);
+    style_mem_free(style->map);
     style->map = NULL;
 }
 
@@ -359,6 +391,7 @@ uint16_t _lv_style_get_mem_size(const lv_style_t * style)
  */
 void _lv_style_set_int(lv_style_t * style, lv_style_property_t prop, lv_style_int_t value)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE(style);
 
     int32_t id = get_property_index(style, prop);
@@ -405,6 +438,7 @@ void _lv_style_set_int(lv_style_t * style, lv_style_property_t prop, lv_style_in
  */
 void _lv_style_set_color(lv_style_t * style, lv_style_property_t prop, lv_color_t color)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE(style);
 
     int32_t id = get_property_index(style, prop);
@@ -452,6 +486,7 @@ void _lv_style_set_color(lv_style_t * style, lv_style_property_t prop, lv_color_
  */
 void _lv_style_set_opa(lv_style_t * style, lv_style_property_t prop, lv_opa_t opa)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE(style);
 
     int32_t id = get_property_index(style, prop);
@@ -499,6 +534,7 @@ void _lv_style_set_opa(lv_style_t * style, lv_style_property_t prop, lv_opa_t op
  */
 void _lv_style_set_ptr(lv_style_t * style, lv_style_property_t prop, const void * p)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE(style);
 
     int32_t id = get_property_index(style, prop);
@@ -708,6 +744,7 @@ lv_style_t * _lv_style_list_get_transition_style(lv_style_list_t * list)
  */
 lv_style_t * _lv_style_list_add_trans_style(lv_style_list_t * list)
 {
+    _lv_style_mark_changed();
     LV_ASSERT_STYLE_LIST(list);
     if(list->has_trans) return _lv_style_list_get_transition_style(list);
 
@@ -1003,6 +1040,96 @@ lv_res_t _lv_style_list_get_ptr(lv_style_list_t * list, lv_style_property_t prop
     else return LV_RES_INV;
 }
 
+#if LV_USE_STYLE_ARENA
+/**
+ * Open a style arena. Until it's closed new style property maps and local styles are bump-allocated from it.
+ * @param size bytes for the maps and local styles (full arenas fall back to `lv_mem_alloc`)
+ * @return the new arena or NULL if there is no memory (styles then use `lv_mem` as usual)
+ */
+lv_style_arena_t * lv_style_arena_open(uint32_t size)
+{
+    size = (size + 3) & ~(uint32_t)3;
+    lv_style_arena_t * arena = lv_mem_alloc(sizeof(lv_style_arena_t) + size);
+    if(arena == NULL) {
+        LV_LOG_WARN("lv_style_arena_open: no memory");
+        return NULL;
+    }
+
+    arena->top = (uint8_t *)(arena + 1);
+    arena->end = arena->top + size;
+    arena->last = NULL;
+    arena->live = 0;
+    arena->open = 1;
+    arena->prev_open = arena_act;
+    arena_act = arena;
+    arena->next = arena_list;
+    arena_list = arena;
+
+    arena_stats.arena_cnt++;
+    arena_stats.reserved += size;
+    return arena;
+}
+
+/**
+ * Stop allocating from an arena. It's freed when the last allocation is released (or now if there is none).
+ * @param arena pointer to an arena returned by `lv_style_arena_open` (NULL is ignored)
+ */
+void lv_style_arena_close(lv_style_arena_t * arena)
+{
+    if(arena == NULL || arena->open == 0) return;
+
+    /*Usually the last opened one, but unlink it from anywhere in the open chain*/
+    lv_style_arena_t ** pp;
+    for(pp = &arena_act; *pp; pp = &(*pp)->prev_open) {
+        if(*pp == arena) {
+            *pp = arena->prev_open;
+            break;
+        }
+    }
+    arena->open = 0;
+    arena->live++;
+    arena_release(arena);
+}
+
+/**
+ * Get the number of bytes used in an open arena
+ * @param arena pointer to an open arena
+ * @return used bytes
+ */
+uint32_t lv_style_arena_get_used(const lv_style_arena_t * arena)
+{
+    return arena->top - (const uint8_t *)(arena + 1);
+}
+
+/**
+ * Get the statistics of all arenas
+ * @param stats store the result here
+ */
+void lv_style_arena_get_stats(lv_style_arena_stats_t * stats)
+{
+    *stats = arena_stats;
+}
+#endif
+
+/**
+ * Note that a style, a style list or an object's state has changed,
+ * so the property values resolved earlier might be different now.
+ */
+void _lv_style_mark_changed(void)
+{
+    style_change_id++;
+}
+
+/**
+ * Get a number which changes whenever `_lv_style_mark_changed` is called.
+ * Property values resolved with the same change ID are still valid.
+ * @return the current change ID
+ */
+uint32_t _lv_style_get_change_id(void)
+{
+    return style_change_id;
+}
+
 /**
  * Check whether a style is valid (initialized correctly)
  * @param style pointer to a style
@@ -1107,7 +1234,7 @@ static lv_style_t * get_alloc_local_style(lv_style_list_t * list)
 
     if(list->has_local) return lv_style_list_get_style(list, list->has_trans ? 1 : 0);
 
-    lv_style_t * local_style = lv_mem_alloc(sizeof(lv_style_t));
+    lv_style_t * local_style = style_mem_alloc(sizeof(lv_style_t));
     LV_ASSERT_MEM(local_style);
     if(local_style == NULL) {
         LV_LOG_WARN("get_local_style: couldn't create local style");
@@ -1129,9 +1256,121 @@ static lv_style_t * get_alloc_local_style(lv_style_list_t * list)
  */
 static inline void style_resize(lv_style_t * style, size_t sz)
 {
+#if LV_USE_STYLE_ARENA
+    if(style->map == NULL) {
+        if(sz) style->map = style_mem_alloc(sz);
+        return;
+    }
+
+    lv_style_arena_t * arena = arena_find(style->map);
+    if(arena == NULL) {
+        style->map = lv_mem_realloc(style->map, sz);
+        return;
+    }
+    if(sz == 0) {
+        arena_release(arena);
+        style->map = NULL;
+        return;
+    }
+
+    /*Adding properties one by one to the same style: grow the last allocation in place*/
+    size_t aligned = (sz + 3) & ~(size_t)3;
+    if(arena->open && style->map == arena->last && (size_t)(arena->end - style->map) >= aligned) {
+        arena->top = style->map + aligned;
+        return;
+    }
+
+    /*Move to the open arena or to `lv_mem`. The old copy stays in its arena until the arena is freed.*/
+    uint16_t old_size = _lv_style_get_mem_size(style);
+    uint8_t * map = style_mem_alloc(sz);
+    if(map) _lv_memcpy(map, style->map, LV_MATH_MIN(old_size, sz));
+    arena_release(arena);
+    style->map = map;
+#else
     style->map = lv_mem_realloc(style->map, sz);
+#endif
 }
 
+/**
+ * Allocate a style property map or a local style: from the open arena if there is one and it has space.
+ * @param size bytes
+ * @return pointer to the memory or NULL if there is no memory
+ */
+static void * style_mem_alloc(size_t size)
+{
+#if LV_USE_STYLE_ARENA
+    lv_style_arena_t * arena = arena_act;
+    if(arena) {
+        /*4 byte aligned: local styles contain a pointer*/
+        size_t aligned = (size + 3) & ~(size_t)3;
+        if((size_t)(arena->end - arena->top) >= aligned) {
+            void * p = arena->top;
+            arena->last = arena->top;
+            arena->top += aligned;
+            arena->live++;
+            return p;
+        }
+        arena_stats.fallback_cnt++;
+    }
+#endif
+    return lv_mem_alloc(size);
+}
+
+/**
+ * Free a style property map or a local style allocated with `style_mem_alloc`
+ * @param p pointer to the memory (NULL is ignored)
+ */
+static void style_mem_free(void * p)
+{
+    if(p == NULL) return;
+#if LV_USE_STYLE_ARENA
+    lv_style_arena_t * arena = arena_find(p);
+    if(arena) {
+        arena_release(arena);
+        return;
+    }
+#endif
+    lv_mem_free(p);
+}
+
+#if LV_USE_STYLE_ARENA
+/**
+ * Find the arena containing a memory address
+ * @param p pointer to check
+ * @return the arena or NULL if `p` is not in an arena
+ */
+static lv_style_arena_t * arena_find(const void * p)
+{
+    const uint8_t * u = p;
+    lv_style_arena_t * arena;
+    for(arena = arena_list; arena; arena = arena->next) {
+        if(u >= (const uint8_t *)(arena + 1) && u < arena->end) return arena;
+    }
+    return NULL;
+}
+
+/**
+ * Release an allocation of an arena and free the arena if it's closed and nothing lives in it
+ * @param arena pointer to an arena
+ */
+static void arena_release(lv_style_arena_t * arena)
+{
+    if(arena->live) arena->live--;
+    if(arena->live || arena->open) return;
+
+    lv_style_arena_t ** pp;
+    for(pp = &arena_list; *pp; pp = &(*pp)->next) {
+        if(*pp == arena) {
+            *pp = arena->next;
+            break;
+        }
+    }
+    arena_stats.arena_cnt--;
+    arena_stats.reserved -= arena->end - (uint8_t *)(arena + 1);
+    lv_mem_free(arena);
+}
+#endif
+
 /**
  * Get style property in index.
  * @param style pointer to style.
@@ -45,6 +45,10 @@ LV_EXPORT_CONST_INT(LV_RADIUS_CIRCLE);
 
 #define LV_STYLE_PROP_ALL 0xFF
 
+#ifndef LV_USE_STYLE_ARENA
+#define LV_USE_STYLE_ARENA 0
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -255,6 +259,17 @@ typedef struct {
     uint32_t text_font_normal : 1;
 } lv_style_list_t;
 
+#if LV_USE_STYLE_ARENA
+/*Bump allocator of style property maps and local styles (opaque, see `lv_style_arena_open`)*/
+typedef struct _lv_style_arena_t lv_style_arena_t;
+
+typedef struct {
+    uint16_t arena_cnt;     /*Arenas which are open or still have live allocations*/
+    uint32_t reserved;      /*Bytes reserved by these arenas*/
+    uint32_t fallback_cnt;  /*Allocations which didn't fit into the open arena and went to `lv_mem_alloc`*/
+} lv_style_arena_stats_t;
+#endif
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -566,6 +581,52 @@ lv_res_t _lv_style_list_get_opa(lv_style_list_t * list, lv_style_property_t prop
  */
 lv_res_t _lv_style_list_get_ptr(lv_style_list_t * list, lv_style_property_t prop, const void ** res);
 
+#if LV_USE_STYLE_ARENA
+/**
+ * Open a style arena. Until it's closed new style property maps and local styles are bump-allocated from it
+ * (a map which is the last allocation also grows in place), and they are not freed one by one:
+ * the whole arena is freed when it's closed and the last of its allocations is released
+ * (e.g. every object of the screen built while it was open is deleted).
+ * A style resized after closing moves to `lv_mem`. Arenas can be nested; the last opened one is used.
+ * @param size bytes for the maps and local styles (full arenas fall back to `lv_mem_alloc`)
+ * @return the new arena or NULL if there is no memory (styles then use `lv_mem` as usual)
+ */
+lv_style_arena_t * lv_style_arena_open(uint32_t size);
+
+/**
+ * Stop allocating from an arena. It's freed immediately if nothing was allocated from it
+ * or everything was already released, otherwise when the last allocation is released.
+ * @param arena pointer to an arena returned by `lv_style_arena_open` (NULL is ignored)
+ */
+void lv_style_arena_close(lv_style_arena_t * arena);
+
+/**
+ * Get the number of bytes used in an open arena (to tune its size)
+ * @param arena pointer to an open arena
+ * @return used bytes
+ */
+uint32_t lv_style_arena_get_used(const lv_style_arena_t * arena);
+
+/**
+ * Get the statistics of all arenas
+ * @param stats store the result here
+ */
+void lv_style_arena_get_stats(lv_style_arena_stats_t * stats);
+#endif
+
+/**
+ * Note that a style, a style list or an object's state has changed,
+ * so the property values resolved earlier might be different now.
+ */
+void _lv_style_mark_changed(void);
+
+/**
+ * Get a number which changes whenever `_lv_style_mark_changed` is called.
+ * Property values resolved with the same change ID are still valid.
+ * @return the current change ID
+ */
+uint32_t _lv_style_get_change_id(void);
+
 /**
  * Check whether a style is valid (initialized correctly)
  * @param style pointer to a style
@@ -20,6 +20,22 @@
     #include "../lv_gpu/lv_gpu_stm32_dma2d.h"
 #endif
 
+#ifndef LV_USE_GPU_ESP32
+    #define LV_USE_GPU_ESP32 0
+#endif
+
+#if LV_USE_GPU_ESP32
+    #include "../lv_gpu/lv_gpu_esp32.h"
+#endif
+
+#ifndef LV_USE_DRAW_SPLIT
+    #define LV_USE_DRAW_SPLIT 0
+#endif
+
+#if LV_USE_DRAW_SPLIT
+    #include LV_DRAW_SPLIT_INCLUDE
+#endif
+
 /*********************
  *      DEFINES
  *********************/
@@ -28,6 +44,20 @@
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_USE_DRAW_SPLIT
+/*A fill (`map_buf == NULL`) or map blend whose lines are shared between the cores*/
+typedef struct {
+    const lv_area_t * disp_area;
+    lv_color_t * disp_buf;
+    lv_area_t draw_area;
+    const lv_area_t * map_area;
+    const lv_color_t * map_buf;
+    lv_color_t color;
+    lv_opa_t opa;
+    const lv_opa_t * mask;
+    lv_draw_mask_res_t mask_res;
+} blend_split_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
@@ -57,6 +87,12 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
                                              const lv_area_t * map_area, const lv_color_t * map_buf, lv_opa_t opa,
                                              const lv_opa_t * mask, lv_draw_mask_res_t mask_res);
 
+#if LV_USE_DRAW_SPLIT
+static bool blend_split(const lv_area_t * disp_area, lv_color_t * disp_buf, const lv_area_t * draw_area,
+                        const lv_area_t * map_area, const lv_color_t * map_buf, lv_color_t color, lv_opa_t opa,
+                        const lv_opa_t * mask, lv_draw_mask_res_t mask_res);
+#endif
+
 #if LV_USE_BLEND_MODES
 static void map_blended(const lv_area_t * disp_area, lv_color_t * disp_buf,  const lv_area_t * draw_area,
                         const lv_area_t * map_area, const lv_color_t * map_buf, lv_opa_t opa,
@@ -131,7 +167,7 @@ static inline lv_color_t color_blend_true_color_subtractive(lv_color_t fg, lv_co
  * @param opa overall opacity in 0x00..0xff range
  * @param mode blend mode from `lv_blend_mode_t`
  */
-LV_ATTRIBUTE_FAST_MEM void _lv_blend_fill(const lv_area_t * clip_area, const lv_area_t * fill_area,
+LV_ATTRIBUTE_FAST_MEM LV_ATTRIBUTE_HOT void _lv_blend_fill(const lv_area_t * clip_area, const lv_area_t * fill_area,
                                           lv_color_t color, lv_opa_t * mask, lv_draw_mask_res_t mask_res, lv_opa_t opa,
                                           lv_blend_mode_t mode)
 {
@@ -176,6 +212,9 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_fill(const lv_area_t * clip_area, const lv_
         fill_set_px(disp_area, disp_buf, &draw_area, color, opa, mask, mask_res);
     }
     else if(mode == LV_BLEND_MODE_NORMAL) {
+#if LV_USE_DRAW_SPLIT
+        if(blend_split(disp_area, disp_buf, &draw_area, NULL, NULL, color, opa, mask, mask_res)) return;
+#endif
         fill_normal(disp_area, disp_buf, &draw_area, color, opa, mask, mask_res);
     }
 #if LV_USE_BLEND_MODES
@@ -198,7 +237,7 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_fill(const lv_area_t * clip_area, const lv_
  * @param opa  overall opacity in 0x00..0xff range
  * @param mode blend mode from `lv_blend_mode_t`
  */
-LV_ATTRIBUTE_FAST_MEM void _lv_blend_map(const lv_area_t * clip_area, const lv_area_t * map_area,
+LV_ATTRIBUTE_FAST_MEM LV_ATTRIBUTE_HOT void _lv_blend_map(const lv_area_t * clip_area, const lv_area_t * map_area,
                                          const lv_color_t * map_buf,
                                          lv_opa_t * mask, lv_draw_mask_res_t mask_res,
                                          lv_opa_t opa, lv_blend_mode_t mode)
@@ -243,6 +282,9 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_map(const lv_area_t * clip_area, const lv_a
         map_set_px(disp_area, disp_buf, &draw_area, map_area, map_buf, opa, mask, mask_res);
     }
     else if(mode == LV_BLEND_MODE_NORMAL) {
+#if LV_USE_DRAW_SPLIT
+        if(blend_split(disp_area, disp_buf, &draw_area, map_area, map_buf, LV_COLOR_BLACK, opa, mask, mask_res)) return;
+#endif
         map_normal(disp_area, disp_buf, &draw_area, map_area, map_buf, opa, mask, mask_res);
     }
 #if LV_USE_BLEND_MODES
@@ -257,6 +299,47 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_map(const lv_area_t * clip_area, const lv_a
  *   STATIC FUNCTIONS
  **********************/
 
+#if LV_USE_DRAW_SPLIT
+static void blend_split_cb(void * ctx, int32_t y1, int32_t y2)
+{
+    const blend_split_t * s = ctx;
+    lv_area_t part = s->draw_area;
+    part.y1 = s->draw_area.y1 + y1;
+    part.y2 = s->draw_area.y1 + y2;
+
+    /*The mask continues line by line with the width of the draw area*/
+    const lv_opa_t * mask = s->mask ? s->mask + y1 * lv_area_get_width(&s->draw_area) : NULL;
+    if(s->map_buf) map_normal(s->disp_area, s->disp_buf, &part, s->map_area, s->map_buf, s->opa, mask, s->mask_res);
+    else fill_normal(s->disp_area, s->disp_buf, &part, s->color, s->opa, mask, s->mask_res);
+}
+
+/**
+ * Share the lines of a normal fill or map blend between the cores if every pixel has to be mixed
+ * (opaque copies and fills are limited by the memory and stay on one core)
+ * @return true: the area is drawn; false: draw it as usual
+ */
+static bool blend_split(const lv_area_t * disp_area, lv_color_t * disp_buf, const lv_area_t * draw_area,
+                        const lv_area_t * map_area, const lv_color_t * map_buf, lv_color_t color, lv_opa_t opa,
+                        const lv_opa_t * mask, lv_draw_mask_res_t mask_res)
+{
+    if(opa > LV_OPA_MAX && mask_res == LV_DRAW_MASK_RES_FULL_COVER) return false;
+    if(lv_area_get_height(draw_area) < 2 || draw_split_ready(lv_area_get_size(draw_area)) == false) return false;
+
+    blend_split_t s;
+    s.disp_area = disp_area;
+    s.disp_buf = disp_buf;
+    s.draw_area = *draw_area;
+    s.map_area = map_area;
+    s.map_buf = map_buf;
+    s.color = color;
+    s.opa = opa;
+    s.mask = mask_res == LV_DRAW_MASK_RES_FULL_COVER ? NULL : mask;
+    s.mask_res = mask_res;
+    draw_split_run(blend_split_cb, &s, lv_area_get_height(draw_area));
+    return true;
+}
+#endif
+
 static void fill_set_px(const lv_area_t * disp_area, lv_color_t * disp_buf,  const lv_area_t * draw_area,
                         lv_color_t color, lv_opa_t opa,
                         const lv_opa_t * mask, lv_draw_mask_res_t mask_res)
@@ -311,7 +394,7 @@ static void fill_set_px(const lv_area_t * disp_area, lv_color_t * disp_buf,  con
  *                 LV_MASK_RES_TRANSP: the mask has only 0x00 values (full transparent),
  *                 LV_MASK_RES_CHANGED: the mask has mixed values
  */
-LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_color_t * disp_buf,
+LV_ATTRIBUTE_FAST_MEM LV_ATTRIBUTE_HOT static void fill_normal(const lv_area_t * disp_area, lv_color_t * disp_buf,
                                               const lv_area_t * draw_area,
                                               lv_color_t color, lv_opa_t opa,
                                               const lv_opa_t * mask, lv_draw_mask_res_t mask_res)
@@ -358,6 +441,10 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
                 lv_gpu_stm32_dma2d_fill(disp_buf_first, disp_w, color, draw_area_w, draw_area_h);
                 return;
             }
+#endif
+#if LV_USE_GPU_ESP32
+            lv_gpu_esp32_fill(disp_buf_first, disp_w, color, draw_area_w, draw_area_h);
+            return;
 #endif
             /*Software rendering*/
             for(y = 0; y < draw_area_h; y++) {
@@ -380,7 +467,8 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
                 }
                 /* Fall down to SW render in case of error */
             }
-#elif LV_USE_GPU
+#elif LV_USE_GPU && LV_USE_GPU_ESP32 == 0
+            /*The ESP32 kernel below mixes a constant color directly, without a line buffer*/
             if(disp->driver.gpu_blend_cb && lv_area_get_size(draw_area) > GPU_SIZE_LIMIT) {
                 for(x = 0; x < draw_area_w ; x++) blend_buf[x].full = color.full;
 
@@ -410,6 +498,9 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
 
                 return;
             }
+#elif LV_USE_GPU_ESP32
+            lv_gpu_esp32_fill_opa(disp_buf_first, disp_w, color, opa, draw_area_w, draw_area_h);
+            return;
 #endif
             lv_color_t last_dest_color = LV_COLOR_BLACK;
             lv_color_t last_res_color = lv_color_mix(color, last_dest_color, opa);
@@ -713,7 +804,7 @@ static void map_set_px(const lv_area_t * disp_area, lv_color_t * disp_buf,  cons
  *                 LV_MASK_RES_TRANSP: the mask has only 0x00 values (full transparent),
  *                 LV_MASK_RES_CHANGED: the mask has mixed values
  */
-LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_color_t * disp_buf,
+LV_ATTRIBUTE_FAST_MEM LV_ATTRIBUTE_HOT static void map_normal(const lv_area_t * disp_area, lv_color_t * disp_buf,
                                              const lv_area_t * draw_area,
                                              const lv_area_t * map_area, const lv_color_t * map_buf, lv_opa_t opa,
                                              const lv_opa_t * mask, lv_draw_mask_res_t mask_res)
@@ -797,6 +888,9 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
                 lv_gpu_stm32_dma2d_copy(disp_buf_first, disp_w, map_buf_first, map_w, draw_area_w, draw_area_h);
                 return;
             }
+#elif LV_USE_GPU_ESP32
+            lv_gpu_esp32_copy(disp_buf_first, disp_w, map_buf_first, map_w, draw_area_w, draw_area_h);
+            return;
 #endif
 
             /*Software rendering*/
@@ -848,6 +942,9 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
                 lv_gpu_stm32_dma2d_blend(disp_buf_first, disp_w, map_buf_first, opa, map_w, draw_area_w, draw_area_h);
                 return;
             }
+#elif LV_USE_GPU_ESP32
+            lv_gpu_esp32_blend(disp_buf_first, disp_w, map_buf_first, map_w, opa, draw_area_w, draw_area_h);
+            return;
 #endif
 
             /*Software rendering*/
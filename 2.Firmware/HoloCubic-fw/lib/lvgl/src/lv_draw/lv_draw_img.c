@@ -19,6 +19,30 @@
     #include "../lv_gpu/lv_gpu_nxp_pxp.h"
 #endif
 
+#ifndef LV_USE_GPU_ESP32
+    #define LV_USE_GPU_ESP32 0
+#endif
+
+#if LV_USE_GPU_ESP32
+    #include "../lv_gpu/lv_gpu_esp32.h"
+#endif
+
+#ifndef LV_USE_DRAW_SPLIT
+    #define LV_USE_DRAW_SPLIT 0
+#endif
+
+#if LV_USE_DRAW_SPLIT
+    #include LV_DRAW_SPLIT_INCLUDE
+#endif
+
+#ifndef LV_USE_PREMUL_DRAW
+    #define LV_USE_PREMUL_DRAW 0
+#endif
+
+#if LV_USE_PREMUL_DRAW
+    #include LV_PREMUL_DRAW_INCLUDE
+#endif
+
 /*********************
  *      DEFINES
  *********************/
@@ -39,6 +63,17 @@ LV_ATTRIBUTE_FAST_MEM static void lv_draw_map(const lv_area_t * map_area, const
                                               const lv_draw_img_dsc_t * draw_dsc,
                                               bool chroma_key, bool alpha_byte);
 
+LV_ATTRIBUTE_FAST_MEM static void draw_map_part(const lv_area_t * map_area, const lv_area_t * clip_area,
+                                                const uint8_t * map_p,
+                                                const lv_draw_img_dsc_t * draw_dsc,
+                                                bool chroma_key, bool alpha_byte,
+                                                lv_color_t * map2_buf, lv_opa_t * opa_buf);
+
+#if LV_USE_DRAW_SPLIT
+static bool draw_map_split(const lv_area_t * map_area, const lv_area_t * clip_area, const uint8_t * map_p,
+                           const lv_draw_img_dsc_t * draw_dsc, bool chroma_key, bool alpha_byte);
+#endif
+
 static void show_error(const lv_area_t * coords, const lv_area_t * clip_area, const char * msg);
 static void draw_cleanup(lv_img_cache_entry_t * cache);
 
@@ -248,6 +283,11 @@ LV_ATTRIBUTE_FAST_MEM static lv_res_t lv_img_draw_core(const lv_area_t * coords,
 
         show_error(coords, clip_area, cdsc->dec_dsc.error_msg);
     }
+#if LV_USE_PREMUL_DRAW
+    /* Premultiplied alpha images are blended straight from their spans if no per pixel work is needed*/
+    else if(premul_decoder_draw(cdsc->dec_dsc.src, coords, clip_area, draw_dsc)) {
+    }
+#endif
     /* The decoder could open the image and gave the entire uncompressed image.
      * Just draw it!*/
     else if(cdsc->dec_dsc.img_data) {
@@ -339,6 +379,81 @@ LV_ATTRIBUTE_FAST_MEM static void lv_draw_map(const lv_area_t * map_area, const
                                               const uint8_t * map_p,
                                               const lv_draw_img_dsc_t * draw_dsc,
                                               bool chroma_key, bool alpha_byte)
+{
+#if LV_USE_DRAW_SPLIT
+    if(draw_map_split(map_area, clip_area, map_p, draw_dsc, chroma_key, alpha_byte)) return;
+#endif
+    draw_map_part(map_area, clip_area, map_p, draw_dsc, chroma_key, alpha_byte, NULL, NULL);
+}
+
+#if LV_USE_DRAW_SPLIT
+/*The lines of `clip_area` shared between the cores*/
+typedef struct {
+    const lv_area_t * map_area;
+    lv_area_t clip_area;
+    const uint8_t * map_p;
+    const lv_draw_img_dsc_t * draw_dsc;
+    bool chroma_key;
+    bool alpha_byte;
+    lv_color_t * map2_buf;       /*Line buffers of the lower half (allocated in advance)*/
+    lv_opa_t * opa_buf;
+} draw_map_split_t;
+
+static void draw_map_split_cb(void * ctx, int32_t y1, int32_t y2)
+{
+    const draw_map_split_t * s = ctx;
+    lv_area_t part = s->clip_area;
+    part.y1 = s->clip_area.y1 + y1;
+    part.y2 = s->clip_area.y1 + y2;
+
+    /*The upper half runs in the LVGL task and can get its buffers as usual*/
+    if(y1 == 0) draw_map_part(s->map_area, &part, s->map_p, s->draw_dsc, s->chroma_key, s->alpha_byte, NULL, NULL);
+    else draw_map_part(s->map_area, &part, s->map_p, s->draw_dsc, s->chroma_key, s->alpha_byte, s->map2_buf, s->opa_buf);
+}
+
+/**
+ * Share the lines of an image which is built pixel by pixel (transform, alpha, chroma key, recolor) between the cores.
+ * Not with other masks because the radius mask caches its last line.
+ * @return true: the image is drawn; false: draw it as usual
+ */
+static bool draw_map_split(const lv_area_t * map_area, const lv_area_t * clip_area, const uint8_t * map_p,
+                           const lv_draw_img_dsc_t * draw_dsc, bool chroma_key, bool alpha_byte)
+{
+    if(lv_draw_mask_get_cnt() != 0) return false;
+    if(draw_dsc->angle == 0 && draw_dsc->zoom == LV_IMG_ZOOM_NONE && chroma_key == false && alpha_byte == false &&
+       draw_dsc->recolor_opa == LV_OPA_TRANSP) return false;
+    if(lv_area_get_height(clip_area) < 2 || draw_split_ready(lv_area_get_size(clip_area)) == false) return false;
+
+    uint32_t hor_res = (uint32_t) lv_disp_get_hor_res(_lv_refr_get_disp_refreshing());
+    draw_map_split_t s;
+    s.map_area = map_area;
+    s.clip_area = *clip_area;
+    s.map_p = map_p;
+    s.draw_dsc = draw_dsc;
+    s.chroma_key = chroma_key;
+    s.alpha_byte = alpha_byte;
+    s.map2_buf = _lv_mem_buf_get(hor_res * sizeof(lv_color_t));
+    s.opa_buf = _lv_mem_buf_get(hor_res);
+    if(s.map2_buf && s.opa_buf) draw_split_run(draw_map_split_cb, &s, lv_area_get_height(clip_area));
+    else draw_map_part(map_area, clip_area, map_p, draw_dsc, chroma_key, alpha_byte, NULL, NULL);
+
+    if(s.opa_buf) _lv_mem_buf_release(s.opa_buf);
+    if(s.map2_buf) _lv_mem_buf_release(s.map2_buf);
+    return true;
+}
+#endif
+
+/**
+ * Draw a part of a color map
+ * @param map2_buf, opa_buf line buffers of `LV_HOR_RES` pixels for the colors and opacities of the map
+ *                          or NULL to get them with `_lv_mem_buf_get`
+ * @see lv_draw_map for the other parameters
+ */
+LV_ATTRIBUTE_FAST_MEM static void draw_map_part(const lv_area_t * map_area, const lv_area_t * clip_area,
+                                                const uint8_t * map_p,
+                                                const lv_draw_img_dsc_t * draw_dsc,
+                                                bool chroma_key, bool alpha_byte,
+                                                lv_color_t * map2_buf, lv_opa_t * opa_buf)
 {
     /* Use the clip area as draw area*/
     lv_area_t draw_area;
@@ -426,8 +541,8 @@ LV_ATTRIBUTE_FAST_MEM static void lv_draw_map(const lv_area_t * map_area, const
 #endif
             uint32_t hor_res = (uint32_t) lv_disp_get_hor_res(disp);
             uint32_t mask_buf_size = lv_area_get_size(&draw_area) > (uint32_t) hor_res ? hor_res : lv_area_get_size(&draw_area);
-            lv_color_t * map2 = _lv_mem_buf_get(mask_buf_size * sizeof(lv_color_t));
-            lv_opa_t * mask_buf = _lv_mem_buf_get(mask_buf_size);
+            lv_color_t * map2 = map2_buf ? map2_buf : _lv_mem_buf_get(mask_buf_size * sizeof(lv_color_t));
+            lv_opa_t * mask_buf = opa_buf ? opa_buf : _lv_mem_buf_get(mask_buf_size);
 
             int32_t x;
             int32_t y;
@@ -469,16 +584,16 @@ LV_ATTRIBUTE_FAST_MEM static void lv_draw_map(const lv_area_t * map_area, const
                 _lv_blend_map(clip_area, &blend_area, map2, mask_buf, LV_DRAW_MASK_RES_CHANGED, draw_dsc->opa, draw_dsc->blend_mode);
             }
 
-            _lv_mem_buf_release(mask_buf);
-            _lv_mem_buf_release(map2);
+            if(opa_buf == NULL) _lv_mem_buf_release(mask_buf);
+            if(map2_buf == NULL) _lv_mem_buf_release(map2);
         }
         /*Most complicated case: transform or other mask or chroma keyed*/
         else {
             /*Build the image and a mask line-by-line*/
             uint32_t hor_res = (uint32_t) lv_disp_get_hor_res(disp);
             uint32_t mask_buf_size = lv_area_get_size(&draw_area) > hor_res ? hor_res : lv_area_get_size(&draw_area);
-            lv_color_t * map2 = _lv_mem_buf_get(mask_buf_size * sizeof(lv_color_t));
-            lv_opa_t * mask_buf = _lv_mem_buf_get(mask_buf_size);
+            lv_color_t * map2 = map2_buf ? map2_buf : _lv_mem_buf_get(mask_buf_size * sizeof(lv_color_t));
+            lv_opa_t * mask_buf = opa_buf ? opa_buf : _lv_mem_buf_get(mask_buf_size);
 
 #if LV_USE_IMG_TRANSFORM
             lv_img_transform_dsc_t trans_dsc;
@@ -529,6 +644,19 @@ LV_ATTRIBUTE_FAST_MEM static void lv_draw_map(const lv_area_t * map_area, const
 
 #if LV_USE_IMG_TRANSFORM
                 int32_t rot_x = disp_area->x1 + draw_area.x1 - map_area->x1;
+#endif
+#if LV_USE_IMG_TRANSFORM && LV_USE_GPU_ESP32
+                /*RGB565 without alpha: transform the whole row with the specialized kernels*/
+                if(transform && lv_gpu_esp32_transform_row(&trans_dsc, rot_x, rot_y + y, draw_area_w,
+                                                           &map2[px_i], &mask_buf[px_i])) {
+                    if(draw_dsc->recolor_opa != 0) {
+                        for(x = 0; x < draw_area_w; x++) {
+                            map2[px_i + x] = lv_color_mix_premult(recolor_premult, map2[px_i + x], recolor_opa_inv);
+                        }
+                    }
+                    px_i += draw_area_w;
+                }
+                else
 #endif
                 for(x = 0; x < draw_area_w; x++, map_px += px_size_byte, px_i++) {
 
@@ -636,8 +764,8 @@ LV_ATTRIBUTE_FAST_MEM static void lv_draw_map(const lv_area_t * map_area, const
                 _lv_blend_map(clip_area, &blend_area, map2, mask_buf, mask_res, draw_dsc->opa, draw_dsc->blend_mode);
             }
 
-            _lv_mem_buf_release(mask_buf);
-            _lv_mem_buf_release(map2);
+            if(opa_buf == NULL) _lv_mem_buf_release(mask_buf);
+            if(map2_buf == NULL) _lv_mem_buf_release(map2);
         }
     }
 }
@@ -12,6 +12,7 @@
 #include "../lv_core/lv_refr.h"
 #include "../lv_misc/lv_bidi.h"
 #include "../lv_misc/lv_debug.h"
+#include "../lv_misc/lv_mem.h"
 
 /*********************
  *      DEFINES
@@ -43,6 +44,12 @@ static void draw_letter_subpx(lv_coord_t pos_x, lv_coord_t pos_y, lv_font_glyph_
 
 
 static uint8_t hex_char_to_num(char hex);
+static bool layout_match(const lv_draw_label_layout_t * layout, const char * txt, const lv_draw_label_dsc_t * dsc,
+                         lv_coord_t max_w);
+static uint32_t get_line_end(const lv_draw_label_layout_t * layout, uint32_t line_idx, const char * txt,
+                             uint32_t line_start, const lv_draw_label_dsc_t * dsc, lv_coord_t w);
+static lv_coord_t get_line_width(const lv_draw_label_layout_t * layout, uint32_t line_idx, const char * txt,
+                                 uint32_t line_start, uint32_t line_end, const lv_draw_label_dsc_t * dsc);
 
 /**********************
  *  STATIC VARIABLES
@@ -130,10 +137,19 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
     if(!clip_ok) return;
 
 
+    /*Use the cached line breaks if they were made for this text with the same parameters*/
+    const lv_draw_label_layout_t * layout = dsc->layout;
+    if(layout && !layout_match(layout, txt, dsc, (dsc->flag & LV_TXT_FLAG_EXPAND) ? LV_COORD_MAX : lv_area_get_width(coords))) {
+        layout = NULL;
+    }
+
     if((dsc->flag & LV_TXT_FLAG_EXPAND) == 0) {
         /*Normally use the label's width as width*/
         w = lv_area_get_width(coords);
     }
+    else if(layout) {
+        w = layout->w_max;
+    }
     else {
         /*If EXAPND is enabled then not limit the text's width to the object's width*/
         lv_point_t p;
@@ -159,6 +175,10 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
 
     uint32_t line_start     = 0;
     int32_t last_line_start = -1;
+    uint32_t line_idx       = 0;    /*Index of the line in `layout`*/
+
+    /*All line starts are known from the layout, the hint is not required*/
+    if(layout) hint = NULL;
 
     /*Check the hint to use the cached info*/
     if(hint && y_ofs == 0 && coords->y1 < 0) {
@@ -175,13 +195,14 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
         pos.y += hint->y;
     }
 
-    uint32_t line_end = line_start + _lv_txt_get_next_line(&txt[line_start], font, dsc->letter_space, w, dsc->flag);
+    uint32_t line_end = get_line_end(layout, line_idx, txt, line_start, dsc, w);
 
     /*Go the first visible line*/
     while(pos.y + line_height_font < mask->y1) {
         /*Go to next line*/
         line_start = line_end;
-        line_end += _lv_txt_get_next_line(&txt[line_start], font, dsc->letter_space, w, dsc->flag);
+        line_idx++;
+        line_end = get_line_end(layout, line_idx, txt, line_start, dsc, w);
         pos.y += line_height;
 
         /*Save at the threshold coordinate*/
@@ -196,14 +217,14 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
 
     /*Align to middle*/
     if(dsc->flag & LV_TXT_FLAG_CENTER) {
-        line_width = _lv_txt_get_width(&txt[line_start], line_end - line_start, font, dsc->letter_space, dsc->flag);
+        line_width = get_line_width(layout, line_idx, txt, line_start, line_end, dsc);
 
         pos.x += (lv_area_get_width(coords) - line_width) / 2;
 
     }
     /*Align to the right*/
     else if(dsc->flag & LV_TXT_FLAG_RIGHT) {
-        line_width = _lv_txt_get_width(&txt[line_start], line_end - line_start, font, dsc->letter_space, dsc->flag);
+        line_width = get_line_width(layout, line_idx, txt, line_start, line_end, dsc);
         pos.x += lv_area_get_width(coords) - line_width;
     }
 
@@ -358,21 +379,20 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
 #endif
         /*Go to next line*/
         line_start = line_end;
-        line_end += _lv_txt_get_next_line(&txt[line_start], font, dsc->letter_space, w, dsc->flag);
+        line_idx++;
+        line_end = get_line_end(layout, line_idx, txt, line_start, dsc, w);
 
         pos.x = coords->x1;
         /*Align to middle*/
         if(dsc->flag & LV_TXT_FLAG_CENTER) {
-            line_width =
-                _lv_txt_get_width(&txt[line_start], line_end - line_start, font, dsc->letter_space, dsc->flag);
+            line_width = get_line_width(layout, line_idx, txt, line_start, line_end, dsc);
 
             pos.x += (lv_area_get_width(coords) - line_width) / 2;
 
         }
         /*Align to the right*/
         else if(dsc->flag & LV_TXT_FLAG_RIGHT) {
-            line_width =
-                _lv_txt_get_width(&txt[line_start], line_end - line_start, font, dsc->letter_space, dsc->flag);
+            line_width = get_line_width(layout, line_idx, txt, line_start, line_end, dsc);
             pos.x += lv_area_get_width(coords) - line_width;
         }
 
@@ -385,10 +405,126 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
     LV_ASSERT_MEM_INTEGRITY();
 }
 
+void lv_draw_label_layout_init(lv_draw_label_layout_t * layout)
+{
+    _lv_memset_00(layout, sizeof(lv_draw_label_layout_t));
+}
+
+bool lv_draw_label_layout_update(lv_draw_label_layout_t * layout, lv_point_t * size_res, const char * txt,
+                                 const lv_font_t * font, lv_coord_t letter_space, lv_coord_t line_space,
+                                 lv_coord_t max_w, lv_txt_flag_t flag)
+{
+    layout->line_cnt = 0;
+    if(txt == NULL || font == NULL) return false;
+
+    if(flag & LV_TXT_FLAG_EXPAND) max_w = LV_COORD_MAX;
+
+    uint32_t line_start = 0;
+    uint16_t line_cnt = 0;
+    lv_coord_t w_max = 0;
+    int32_t h = 0;
+    int32_t letter_height = lv_font_get_line_height(font);
+
+    while(txt[line_start] != '\0') {
+        if(line_cnt >= LV_LABEL_LAYOUT_MAX_LINES) return false;
+
+        /*Grow the buffers in steps of 8 lines*/
+        if(line_cnt + 1 >= layout->line_cap) {
+            uint16_t cap = (line_cnt + 1 + 8) & ~7;
+            uint32_t * starts = lv_mem_realloc(layout->line_start, cap * sizeof(uint32_t));
+            if(starts == NULL) return false;
+            layout->line_start = starts;
+            lv_coord_t * widths = lv_mem_realloc(layout->line_w, cap * sizeof(lv_coord_t));
+            if(widths == NULL) return false;
+            layout->line_w = widths;
+            layout->line_cap = cap;
+        }
+
+        uint32_t line_end = line_start + _lv_txt_get_next_line(&txt[line_start], font, letter_space, max_w, flag);
+        lv_coord_t line_w = _lv_txt_get_width(&txt[line_start], line_end - line_start, font, letter_space, flag);
+
+        layout->line_start[line_cnt] = line_start;
+        layout->line_w[line_cnt] = line_w;
+        line_cnt++;
+
+        /*Same overflow limit as _lv_txt_get_size*/
+        if(h + letter_height + line_space > LV_MAX_OF(lv_coord_t)) return false;
+        h += letter_height + line_space;
+
+        w_max = LV_MATH_MAX(w_max, line_w);
+        line_start = line_end;
+    }
+
+    /*Make the text one line taller if the last character is '\n' or '\r'*/
+    if((line_start != 0) && (txt[line_start - 1] == '\n' || txt[line_start - 1] == '\r')) {
+        h += letter_height + line_space;
+    }
+
+    /*Nothing to cache for an empty text (it's not drawn at all)*/
+    if(line_cnt == 0) return false;
+
+    layout->line_start[line_cnt] = line_start;
+    layout->txt = txt;
+    layout->txt_len = line_start;
+    layout->font = font;
+    layout->max_w = max_w;
+    layout->letter_space = letter_space;
+    layout->flag = flag & LV_DRAW_LABEL_LAYOUT_FLAGS;
+    layout->w_max = w_max;
+    layout->line_cnt = line_cnt;
+
+    size_res->x = w_max;
+    size_res->y = h - line_space;
+    return true;
+}
+
+void lv_draw_label_layout_invalidate(lv_draw_label_layout_t * layout)
+{
+    layout->line_cnt = 0;
+}
+
+void lv_draw_label_layout_free(lv_draw_label_layout_t * layout)
+{
+    if(layout->line_start) lv_mem_free(layout->line_start);
+    if(layout->line_w) lv_mem_free(layout->line_w);
+    lv_draw_label_layout_init(layout);
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
 
+/**
+ * Check whether a layout was made for a text with the parameters of a draw descriptor.
+ * The text length is compared too so a text modified without rebuilding the layout
+ * can't make the drawing read past its end.
+ */
+static bool layout_match(const lv_draw_label_layout_t * layout, const char * txt, const lv_draw_label_dsc_t * dsc,
+                         lv_coord_t max_w)
+{
+    if(layout->line_cnt == 0) return false;
+    if(layout->txt != txt || layout->font != dsc->font || layout->letter_space != dsc->letter_space) return false;
+    if(layout->max_w != max_w || layout->flag != (dsc->flag & LV_DRAW_LABEL_LAYOUT_FLAGS)) return false;
+    return strlen(txt) == layout->txt_len;
+}
+
+/**
+ * Get the end of a line: from the layout or by breaking the text from `line_start`
+ */
+static uint32_t get_line_end(const lv_draw_label_layout_t * layout, uint32_t line_idx, const char * txt,
+                             uint32_t line_start, const lv_draw_label_dsc_t * dsc, lv_coord_t w)
+{
+    if(layout) return line_idx < layout->line_cnt ? layout->line_start[line_idx + 1] : line_start;
+    return line_start + _lv_txt_get_next_line(&txt[line_start], dsc->font, dsc->letter_space, w, dsc->flag);
+}
+
+static lv_coord_t get_line_width(const lv_draw_label_layout_t * layout, uint32_t line_idx, const char * txt,
+                                 uint32_t line_start, uint32_t line_end, const lv_draw_label_dsc_t * dsc)
+{
+    if(layout) return line_idx < layout->line_cnt ? layout->line_w[line_idx] : 0;
+    return _lv_txt_get_width(&txt[line_start], line_end - line_start, dsc->font, dsc->letter_space, dsc->flag);
+}
+
 
 /**
  * Draw a letter in the Virtual Display Buffer
@@ -22,10 +22,38 @@ extern "C" {
  *********************/
 #define LV_DRAW_LABEL_NO_TXT_SEL (0xFFFF)
 
+#ifndef LV_LABEL_LAYOUT_CACHE
+#define LV_LABEL_LAYOUT_CACHE 0
+#endif
+#ifndef LV_LABEL_LAYOUT_MAX_LINES
+#define LV_LABEL_LAYOUT_MAX_LINES 64
+#endif
+
+/*Flags which change where the lines break (the rest only change alignment)*/
+#define LV_DRAW_LABEL_LAYOUT_FLAGS (LV_TXT_FLAG_RECOLOR | LV_TXT_FLAG_EXPAND | LV_TXT_FLAG_FIT)
+
 /**********************
  *      TYPEDEFS
  **********************/
 
+/** Line breaks of a text, kept by the text's owner (e.g. a label) and reused on every draw
+ * while the text, font, letter space, width and breaking flags are unchanged.
+ * The owner has to rebuild it with `lv_draw_label_layout_update` whenever the text changes,
+ * `lv_draw_label` only checks the key and the text length and lays out the lines itself on mismatch.*/
+typedef struct {
+    const char * txt;
+    const lv_font_t * font;
+    lv_coord_t max_w;           /*Width used for breaking (LV_COORD_MAX with LV_TXT_FLAG_EXPAND)*/
+    lv_coord_t letter_space;
+    lv_txt_flag_t flag;         /*Only the LV_DRAW_LABEL_LAYOUT_FLAGS bits*/
+    uint32_t txt_len;
+    uint16_t line_cnt;          /*0: invalid*/
+    uint16_t line_cap;
+    uint32_t * line_start;      /*`line_cnt + 1` byte indexes, the last is `txt_len`*/
+    lv_coord_t * line_w;        /*Width of each line*/
+    lv_coord_t w_max;           /*Width of the longest line*/
+} lv_draw_label_layout_t;
+
 typedef struct {
     lv_color_t color;
     lv_color_t sel_color;
@@ -42,6 +70,7 @@ typedef struct {
     lv_txt_flag_t flag;
     lv_text_decor_t decor;
     lv_blend_mode_t blend_mode;
+    const lv_draw_label_layout_t * layout; /*Cached line breaks of `txt` or NULL*/
 } lv_draw_label_dsc_t;
 
 /** Store some info to speed up drawing of very large texts
@@ -82,6 +111,36 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
                                          const lv_draw_label_dsc_t * dsc,
                                          const char * txt, lv_draw_label_hint_t * hint);
 
+/**
+ * Prepare an empty layout (no memory is allocated until the first update)
+ * @param layout pointer to a layout
+ */
+void lv_draw_label_layout_init(lv_draw_label_layout_t * layout);
+
+/**
+ * Break a text into lines and save the line starts and widths in a layout.
+ * The size of the text is calculated on the way exactly as `_lv_txt_get_size` does.
+ * @param layout pointer to a layout
+ * @param size_res the size of the text is stored here
+ * @return true: the layout is valid; false: out of memory or too many lines,
+ *         the layout is invalidated and `size_res` is not set
+ */
+bool lv_draw_label_layout_update(lv_draw_label_layout_t * layout, lv_point_t * size_res, const char * txt,
+                                 const lv_font_t * font, lv_coord_t letter_space, lv_coord_t line_space,
+                                 lv_coord_t max_w, lv_txt_flag_t flag);
+
+/**
+ * Mark a layout invalid (e.g. when its text is modified in place) but keep its buffers
+ * @param layout pointer to a layout
+ */
+void lv_draw_label_layout_invalidate(lv_draw_label_layout_t * layout);
+
+/**
+ * Free the buffers of a layout
+ * @param layout pointer to a layout
+ */
+void lv_draw_label_layout_free(lv_draw_label_layout_t * layout);
+
 //! @endcond
 /***********************
  * GLOBAL VARIABLES
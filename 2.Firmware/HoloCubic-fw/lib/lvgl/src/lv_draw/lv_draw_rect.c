@@ -21,9 +21,24 @@
 #define SHADOW_ENHANCE          1
 #define SPLIT_LIMIT             50
 
+#if LV_USE_SHADOW && LV_SHADOW_CACHE_SIZE && !defined(LV_SHADOW_CACHE_NUM)
+    #define LV_SHADOW_CACHE_NUM 1
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_USE_SHADOW && LV_SHADOW_CACHE_SIZE
+/*A blurred corner: `(sw + r)^2` opacity values as `shadow_draw_corner_buf` returns them*/
+typedef struct {
+    lv_opa_t * buf;     /*NULL: unused entry*/
+    uint32_t life;      /*`sh_cache_life` when it was used last time*/
+    lv_coord_t sw;
+    lv_coord_t r;
+    lv_coord_t w;       /*Shadow size limited to `2 * (sw + r)`*/
+    lv_coord_t h;
+} sh_cache_t;
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
@@ -55,13 +70,20 @@ static void draw_full_border(const lv_area_t * area_inner, const lv_area_t * are
                              lv_coord_t radius, bool radius_is_in, lv_color_t color, lv_opa_t opa, lv_blend_mode_t blend_mode);
 LV_ATTRIBUTE_FAST_MEM static inline lv_color_t grad_get(const lv_draw_rect_dsc_t * dsc, lv_coord_t s, lv_coord_t i);
 
+#if LV_USE_SHADOW && LV_SHADOW_CACHE_SIZE
+    static lv_opa_t * sh_cache_get(lv_coord_t sw, lv_coord_t r, lv_coord_t w, lv_coord_t h);
+    static void sh_cache_store(lv_coord_t sw, lv_coord_t r, lv_coord_t w, lv_coord_t h, const lv_opa_t * sh_buf);
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
+#if LV_USE_SHADOW
+    static bool shadow_enabled = true;
+#endif
 #if LV_USE_SHADOW && LV_SHADOW_CACHE_SIZE
-    static uint8_t sh_cache[LV_SHADOW_CACHE_SIZE * LV_SHADOW_CACHE_SIZE];
-    static int32_t sh_cache_size = -1;
-    static int32_t sh_cache_r = -1;
+    static sh_cache_t sh_cache[LV_SHADOW_CACHE_NUM];
+    static uint32_t sh_cache_life;  /*Incremented in every lookup, the entry used longest ago is replaced*/
 #endif
 
 /**********************
@@ -104,7 +126,7 @@ void lv_draw_rect(const lv_area_t * coords, const lv_area_t * clip, const lv_dra
 {
     if(lv_area_get_height(coords) < 1 || lv_area_get_width(coords) < 1) return;
 #if LV_USE_SHADOW
-    draw_shadow(coords, clip, dsc);
+    if(shadow_enabled) draw_shadow(coords, clip, dsc);
 #endif
 
     draw_bg(coords, clip, dsc);
@@ -160,6 +182,18 @@ void lv_draw_px(const lv_point_t * point, const lv_area_t * clip_area, const lv_
     //    }
 }
 
+#if LV_USE_SHADOW
+void lv_draw_rect_set_shadow_enabled(bool en)
+{
+    shadow_enabled = en;
+}
+
+bool lv_draw_rect_get_shadow_enabled(void)
+{
+    return shadow_enabled;
+}
+#endif
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
@@ -595,10 +629,14 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(const lv_area_t * coords, const lv
     lv_opa_t * sh_buf;
 
 #if LV_SHADOW_CACHE_SIZE
-    if(sh_cache_size == corner_size && sh_cache_r == r_sh) {
-        /*Use the cache if available*/
+    /*The size of the shadow matters only if it's small: a larger one doesn't reach into the corner*/
+    lv_coord_t sh_w = LV_MATH_MIN(lv_area_get_width(&sh_rect_area), 2 * corner_size);
+    lv_coord_t sh_h = LV_MATH_MIN(lv_area_get_height(&sh_rect_area), 2 * corner_size);
+    lv_opa_t * sh_cached = sh_cache_get(sw, r_sh, sh_w, sh_h);
+    if(sh_cached) {
+        /*Use the cache if available (copy it because the corner is mirrored in place)*/
         sh_buf = _lv_mem_buf_get(corner_size * corner_size);
-        _lv_memcpy(sh_buf, sh_cache, corner_size * corner_size);
+        _lv_memcpy(sh_buf, sh_cached, corner_size * corner_size);
     }
     else {
         /*A larger buffer is required for calculation */
@@ -606,11 +644,7 @@ LV_ATTRIBUTE_FAST_MEM static void draw_shadow(const lv_area_t * coords, const lv
         shadow_draw_corner_buf(&sh_rect_area, (uint16_t *)sh_buf, dsc->shadow_width, r_sh);
 
         /*Cache the corner if it fits into the cache size*/
-        if(corner_size * corner_size < sizeof(sh_cache)) {
-            _lv_memcpy(sh_cache, sh_buf, corner_size * corner_size);
-            sh_cache_size = corner_size;
-            sh_cache_r = r_sh;
-        }
+        if(corner_size <= LV_SHADOW_CACHE_SIZE) sh_cache_store(sw, r_sh, sh_w, sh_h, sh_buf);
     }
 #else
     sh_buf = _lv_mem_buf_get(corner_size * corner_size * sizeof(uint16_t));
@@ -1079,6 +1113,71 @@ LV_ATTRIBUTE_FAST_MEM static void shadow_draw_corner_buf(const lv_area_t * coord
 
 }
 
+#if LV_SHADOW_CACHE_SIZE
+/**
+ * Find a blurred corner in the cache
+ * @param sw shadow width
+ * @param r radius of the shadow
+ * @param w width of the shadow (limited to `2 * (sw + r)`)
+ * @param h height of the shadow (limited to `2 * (sw + r)`)
+ * @return the cached corner or NULL if not found
+ */
+static lv_opa_t * sh_cache_get(lv_coord_t sw, lv_coord_t r, lv_coord_t w, lv_coord_t h)
+{
+    sh_cache_life++;
+
+    uint32_t i;
+    for(i = 0; i < LV_SHADOW_CACHE_NUM; i++) {
+        sh_cache_t * c = &sh_cache[i];
+        if(c->buf && c->sw == sw && c->r == r && c->w == w && c->h == h) {
+            c->life = sh_cache_life;
+            return c->buf;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Save a blurred corner in a free entry or in place of the least recently used one
+ * @param sw shadow width
+ * @param r radius of the shadow
+ * @param w width of the shadow (limited to `2 * (sw + r)`)
+ * @param h height of the shadow (limited to `2 * (sw + r)`)
+ * @param sh_buf the corner to save (`(sw + r)^2` bytes)
+ */
+static void sh_cache_store(lv_coord_t sw, lv_coord_t r, lv_coord_t w, lv_coord_t h, const lv_opa_t * sh_buf)
+{
+    uint32_t size = (sw + r) * (sw + r);
+
+    sh_cache_t * c = &sh_cache[0];
+    uint32_t i;
+    for(i = 0; i < LV_SHADOW_CACHE_NUM; i++) {
+        if(sh_cache[i].buf == NULL) {
+            c = &sh_cache[i];
+            break;
+        }
+        if(sh_cache[i].life < c->life) c = &sh_cache[i];
+    }
+
+    /*Reuse the buffer if it has the same size*/
+    if(c->buf && (c->sw + c->r) != (sw + r)) {
+        lv_mem_free(c->buf);
+        c->buf = NULL;
+    }
+    if(c->buf == NULL) {
+        c->buf = lv_mem_alloc(size);
+        if(c->buf == NULL) return;
+    }
+
+    _lv_memcpy(c->buf, sh_buf, size);
+    c->sw = sw;
+    c->r = r;
+    c->w = w;
+    c->h = h;
+    c->life = sh_cache_life;
+}
+#endif
+
 LV_ATTRIBUTE_FAST_MEM static void shadow_blur_corner(lv_coord_t size, lv_coord_t sw, uint16_t * sh_ups_buf)
 {
     int32_t s_left = sw >> 1;
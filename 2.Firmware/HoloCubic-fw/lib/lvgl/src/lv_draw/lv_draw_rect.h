@@ -105,6 +105,16 @@ void lv_draw_rect(const lv_area_t * coords, const lv_area_t * mask, const lv_dra
  */
 void lv_draw_px(const lv_point_t * point, const lv_area_t * clip_area, const lv_style_t * style);
 
+#if LV_USE_SHADOW
+/**
+ * Enable or disable drawing shadows at run time (e.g. to keep the frame time under load).
+ * Only the drawing is skipped, the styles and the objects' extended draw area are unchanged.
+ * @param en true: draw shadows (default); false: skip them
+ */
+void lv_draw_rect_set_shadow_enabled(bool en);
+bool lv_draw_rect_get_shadow_enabled(void);
+#endif
+
 /**********************
  *      MACROS
  **********************/
@@ -16,6 +16,26 @@
 #if defined(LV_GC_INCLUDE)
     #include LV_GC_INCLUDE
 #endif /* LV_ENABLE_GC */
+
+#ifndef LV_IMG_CACHE_BYTE_BUDGET
+    #define LV_IMG_CACHE_BYTE_BUDGET 0
+#endif
+#ifndef LV_IMG_CACHE_PRELOAD_MAX
+    #define LV_IMG_CACHE_PRELOAD_MAX 0
+#endif
+#if LV_IMG_CACHE_DEF_SIZE == 0
+    #undef LV_IMG_CACHE_BYTE_BUDGET
+    #define LV_IMG_CACHE_BYTE_BUDGET 0
+#endif
+#if LV_IMG_CACHE_BYTE_BUDGET
+    #ifdef LV_IMG_CACHE_ALLOC_INCLUDE
+        #include LV_IMG_CACHE_ALLOC_INCLUDE
+    #endif
+    #ifndef LV_IMG_CACHE_ALLOC
+        #define LV_IMG_CACHE_ALLOC(size) lv_mem_alloc(size)
+        #define LV_IMG_CACHE_FREE(p)     lv_mem_free(p)
+    #endif
+#endif
 /*********************
  *      DEFINES
  *********************/
@@ -39,6 +59,13 @@
 #if LV_IMG_CACHE_DEF_SIZE == 0
     static lv_img_cache_entry_t cache_temp;
 #endif
+#if LV_IMG_CACHE_BYTE_BUDGET
+    static lv_img_cache_entry_t * cache_find(const void * src, lv_color_t color, bool match_color);
+    static lv_img_cache_entry_t * cache_make_room(uint32_t size);
+    static void cache_close_entry(lv_img_cache_entry_t * entry);
+    static bool cache_preload(lv_img_cache_entry_t * entry, uint32_t size);
+    static uint32_t cache_decoded_size(const lv_img_decoder_dsc_t * dsc);
+#endif
 
 /**********************
  *  STATIC VARIABLES
@@ -46,6 +73,14 @@
 #if LV_IMG_CACHE_DEF_SIZE
     static uint16_t entry_cnt;
 #endif
+#if LV_IMG_CACHE_BYTE_BUDGET
+    /*Holds an image which doesn't fit into the budget until the next miss*/
+    static lv_img_cache_entry_t cache_overflow;
+    static uint32_t use_stamp;
+    static uint32_t byte_budget = LV_IMG_CACHE_BYTE_BUDGET;
+    static uint32_t preload_max = LV_IMG_CACHE_PRELOAD_MAX;
+#endif
+static lv_img_cache_stats_t cache_stats;
 
 /**********************
  *      MACROS
@@ -63,6 +98,77 @@
  * @param color color The color of the image with `LV_IMG_CF_ALPHA_...`
  * @return pointer to the cache entry or NULL if can open the image
  */
+#if LV_IMG_CACHE_BYTE_BUDGET
+lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color)
+{
+    if(entry_cnt == 0) {
+        LV_LOG_WARN("lv_img_cache_open: the cache size is 0");
+        return NULL;
+    }
+
+    use_stamp++;
+    lv_img_cache_entry_t * cached_src = cache_find(src, color, true);
+    if(cached_src) {
+        cached_src->last_used = use_stamp;
+        cache_stats.hits++;
+        LV_LOG_TRACE("image draw: image found in the cache");
+        return cached_src;
+    }
+    cache_stats.misses++;
+
+    /*Open into a temporary descriptor first: the decoded size decides what has to be evicted*/
+    lv_img_decoder_dsc_t dsc;
+    _lv_memset_00(&dsc, sizeof(dsc));
+    uint32_t t_start = lv_tick_get();
+    if(lv_img_decoder_open(&dsc, src, color) == LV_RES_INV) {
+        LV_LOG_WARN("Image draw cannot open the image resource");
+        lv_img_decoder_close(&dsc);
+        return NULL;
+    }
+    if(dsc.time_to_open == 0) dsc.time_to_open = lv_tick_elaps(t_start);
+    if(dsc.time_to_open == 0) dsc.time_to_open = 1;
+
+    uint32_t size = cache_decoded_size(&dsc);
+    bool preload = false;
+#if LV_IMG_CACHE_PRELOAD_MAX
+    /*Only files: variable sources may be modified in place by the application (e.g. frame buffers)*/
+    if(dsc.img_data == NULL && dsc.error_msg == NULL && dsc.src_type == LV_IMG_SRC_FILE) {
+        uint32_t px_size = lv_img_cf_has_alpha(dsc.header.cf) ? LV_IMG_PX_SIZE_ALPHA_BYTE : LV_COLOR_SIZE / 8;
+        uint32_t pre_size = (uint32_t)dsc.header.w * dsc.header.h * px_size;
+        if(pre_size > 0 && pre_size <= preload_max && pre_size <= byte_budget) {
+            size = pre_size;
+            preload = true;
+        }
+    }
+#endif
+
+    cached_src = cache_make_room(size);
+    if(cached_src == NULL) {
+        /*Too large for the budget or everything is pinned*/
+        if(cache_overflow.dec_dsc.src) cache_close_entry(&cache_overflow);
+        cached_src = &cache_overflow;
+        preload = false;
+        size = 0;
+        LV_LOG_INFO("image draw: cache miss, image doesn't fit into the budget");
+    }
+
+    cached_src->dec_dsc = dsc;
+    cached_src->life = 0;
+    cached_src->size = 0;
+    cached_src->last_used = use_stamp;
+    cached_src->pinned = 0;
+    cached_src->preloaded = 0;
+
+    if(!preload) size = cache_decoded_size(&dsc);
+    else if(!cache_preload(cached_src, size)) size = 0;
+
+    if(cached_src != &cache_overflow) {
+        cached_src->size = size;
+        cache_stats.bytes_used += size;
+    }
+    return cached_src;
+}
+#else
 lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color)
 {
     /*Is the image cached?*/
@@ -154,6 +260,7 @@ lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color)
 
     return cached_src;
 }
+#endif
 
 /**
  * Set the number of images to be cached.
@@ -181,6 +288,7 @@ void lv_img_cache_set_size(uint16_t new_entry_cnt)
         return;
     }
     entry_cnt = new_entry_cnt;
+    cache_stats.bytes_used = 0;
 
     /*Clean the cache*/
     uint16_t i;
@@ -191,6 +299,25 @@ void lv_img_cache_set_size(uint16_t new_entry_cnt)
 #endif
 }
 
+/**
+ * Change the byte budget at run time (e.g. a larger one when PSRAM is present).
+ * Entries already cached stay until they are evicted.
+ * Only has effect with `LV_IMG_CACHE_BYTE_BUDGET > 0`.
+ * @param bytes decoded data the cache may hold
+ * @param preload max. size of a file image decoded into a cache owned buffer
+ *                (0: never; only with `LV_IMG_CACHE_PRELOAD_MAX > 0`)
+ */
+void lv_img_cache_set_budget(uint32_t bytes, uint32_t preload)
+{
+#if LV_IMG_CACHE_BYTE_BUDGET
+    byte_budget = bytes;
+    preload_max = preload;
+#else
+    LV_UNUSED(bytes);
+    LV_UNUSED(preload);
+#endif
+}
+
 /**
  * Invalidate an image source in the cache.
  * Useful if the image source is updated therefore it needs to be cached again.
@@ -198,7 +325,21 @@ void lv_img_cache_set_size(uint16_t new_entry_cnt)
  */
 void lv_img_cache_invalidate_src(const void * src)
 {
-#if LV_IMG_CACHE_DEF_SIZE
+#if LV_IMG_CACHE_BYTE_BUDGET
+    lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
+
+    /*File sources are copied by the decoder, compare them by content*/
+    lv_img_src_t src_type = src ? lv_img_src_get_type(src) : LV_IMG_SRC_UNKNOWN;
+    uint16_t i;
+    for(i = 0; i <= entry_cnt; i++) {
+        lv_img_cache_entry_t * e = i < entry_cnt ? &cache[i] : &cache_overflow;
+        if(e->dec_dsc.src == NULL) continue;
+        if(src == NULL || e->dec_dsc.src == src ||
+           (src_type == LV_IMG_SRC_FILE && e->dec_dsc.src_type == LV_IMG_SRC_FILE && strcmp(e->dec_dsc.src, src) == 0)) {
+            cache_close_entry(e);
+        }
+    }
+#elif LV_IMG_CACHE_DEF_SIZE
     lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
 
     uint16_t i;
@@ -215,6 +356,160 @@ void lv_img_cache_invalidate_src(const void * src)
 #endif
 }
 
+/**
+ * Pin an image in the cache so it's never evicted (e.g. UI icons which must always draw instantly).
+ * Pinning opens and caches the image if it isn't cached yet.
+ * Only has effect with `LV_IMG_CACHE_BYTE_BUDGET > 0`.
+ * @param src an image source path to a file or pointer to an `lv_img_dsc_t` variable.
+ * @param pin true: pin, false: release (the entry becomes evictable again)
+ */
+void lv_img_cache_pin(const void * src, bool pin)
+{
+#if LV_IMG_CACHE_BYTE_BUDGET
+    lv_img_cache_entry_t * entry = cache_find(src, LV_COLOR_BLACK, false);
+    if(entry == NULL && pin) entry = _lv_img_cache_open(src, LV_COLOR_BLACK);
+    if(entry && entry != &cache_overflow) entry->pinned = pin ? 1 : 0;
+#else
+    LV_UNUSED(src);
+    LV_UNUSED(pin);
+#endif
+}
+
+/**
+ * Get the cache counters
+ * @param stats pointer to store the counters
+ */
+void lv_img_cache_get_stats(lv_img_cache_stats_t * stats)
+{
+    *stats = cache_stats;
+    stats->entries = 0;
+    stats->entries_max = 0;
+    stats->bytes_budget = 0;
+#if LV_IMG_CACHE_BYTE_BUDGET
+    stats->bytes_budget = byte_budget;
+#endif
+#if LV_IMG_CACHE_DEF_SIZE
+    stats->entries_max = entry_cnt;
+    lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
+    uint16_t i;
+    for(i = 0; i < entry_cnt; i++) {
+        if(cache[i].dec_dsc.src) stats->entries++;
+    }
+#endif
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
+
+#if LV_IMG_CACHE_BYTE_BUDGET
+/**
+ * Find a cached image (the overflow entry included)
+ * @param match_color also compare the color (it's used by `LV_IMG_CF_ALPHA_...` images)
+ */
+static lv_img_cache_entry_t * cache_find(const void * src, lv_color_t color, bool match_color)
+{
+    lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
+    lv_img_src_t src_type = lv_img_src_get_type(src);
+
+    uint16_t i;
+    for(i = 0; i <= entry_cnt; i++) {
+        lv_img_cache_entry_t * e = i < entry_cnt ? &cache[i] : &cache_overflow;
+        if(e->dec_dsc.src == NULL) continue;
+        if(match_color && e->dec_dsc.color.full != color.full) continue;
+
+        if(src_type == LV_IMG_SRC_VARIABLE) {
+            if(e->dec_dsc.src == src) return e;
+        }
+        else if(src_type == LV_IMG_SRC_FILE && e->dec_dsc.src_type == LV_IMG_SRC_FILE) {
+            if(strcmp(e->dec_dsc.src, src) == 0) return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Evict least recently used, not pinned entries until there is a free entry and `size` bytes fit
+ * @return a free entry or NULL if `size` can't fit
+ */
+static lv_img_cache_entry_t * cache_make_room(uint32_t size)
+{
+    if(size > byte_budget) return NULL;
+
+    lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
+    while(1) {
+        lv_img_cache_entry_t * free_entry = NULL;
+        lv_img_cache_entry_t * lru = NULL;
+        uint16_t i;
+        for(i = 0; i < entry_cnt; i++) {
+            if(cache[i].dec_dsc.src == NULL) {
+                if(free_entry == NULL) free_entry = &cache[i];
+            }
+            else if(!cache[i].pinned && (lru == NULL || (int32_t)(cache[i].last_used - lru->last_used) < 0)) {
+                lru = &cache[i];
+            }
+        }
+
+        if(free_entry && cache_stats.bytes_used + size <= byte_budget) return free_entry;
+        if(lru == NULL) return NULL;
+
+        LV_LOG_INFO("image draw: cache miss, evict the least recently used entry");
+        cache_close_entry(lru);
+        cache_stats.evictions++;
+    }
+}
+
+/**
+ * Close the decoder (or free the preloaded data) of an entry and make it free
+ */
+static void cache_close_entry(lv_img_cache_entry_t * entry)
+{
+    if(entry->preloaded) {
+        LV_IMG_CACHE_FREE((void *)entry->dec_dsc.img_data);
+        if(entry->dec_dsc.src_type == LV_IMG_SRC_FILE) lv_mem_free(entry->dec_dsc.src);
+    }
+    else if(entry->dec_dsc.src) {
+        lv_img_decoder_close(&entry->dec_dsc);
+    }
+
+    if(entry != &cache_overflow) cache_stats.bytes_used -= entry->size;
+    _lv_memset_00(entry, sizeof(lv_img_cache_entry_t));
+}
+
+/**
+ * Decode a line-by-line image into a buffer owned by the cache and close its decoder.
+ * The buffer has the format `lv_draw_map` expects: true color (+ alpha byte if the format has alpha)
+ */
+static bool cache_preload(lv_img_cache_entry_t * entry, uint32_t size)
+{
+    lv_img_decoder_dsc_t * dsc = &entry->dec_dsc;
+    uint8_t * buf = LV_IMG_CACHE_ALLOC(size);
+    if(buf == NULL) return false;
+
+    uint32_t stride = size / dsc->header.h;
+    lv_coord_t y;
+    for(y = 0; y < (lv_coord_t)dsc->header.h; y++) {
+        if(lv_img_decoder_read_line(dsc, 0, y, dsc->header.w, buf + y * stride) != LV_RES_OK) {
+            LV_IMG_CACHE_FREE(buf);
+            return false;
+        }
+    }
+
+    /*The decoder isn't needed anymore: release its file handle and buffers but keep `src` for matching*/
+    if(dsc->decoder->close_cb) dsc->decoder->close_cb(dsc->decoder, dsc);
+    dsc->user_data = NULL;
+    dsc->img_data = buf;
+    entry->preloaded = 1;
+    return true;
+}
+
+/**
+ * Bytes of decoded data an opened image holds. Variable sources are drawn from their own data
+ * and decoders reading line-by-line keep only small buffers, so they count as 0.
+ */
+static uint32_t cache_decoded_size(const lv_img_decoder_dsc_t * dsc)
+{
+    if(dsc->img_data == NULL || dsc->src_type == LV_IMG_SRC_VARIABLE) return 0;
+    return lv_img_buf_get_img_size(dsc->header.w, dsc->header.h, dsc->header.cf);
+}
+#endif
@@ -35,8 +35,33 @@ typedef struct {
      * Decrement all lifes by one every in every ::lv_img_cache_open.
      * If life == 0 the entry can be reused */
     int32_t life;
+
+    /** Bytes of decoded data held by the entry (counted against `LV_IMG_CACHE_BYTE_BUDGET`)*/
+    uint32_t size;
+
+    /** Stamp of the last use, the smallest is evicted first*/
+    uint32_t last_used;
+
+    /** Never evicted (see `lv_img_cache_pin`)*/
+    uint8_t pinned : 1;
+
+    /** `img_data` was decoded and allocated by the cache, the decoder is already closed*/
+    uint8_t preloaded : 1;
 } lv_img_cache_entry_t;
 
+/**
+ * Cache counters for tuning `LV_IMG_CACHE_DEF_SIZE` and `LV_IMG_CACHE_BYTE_BUDGET`
+ */
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t bytes_used;
+    uint32_t bytes_budget;  /**< Current byte budget (0: no budget, `LV_IMG_CACHE_BYTE_BUDGET == 0`)*/
+    uint16_t entries;
+    uint16_t entries_max;   /**< Number of cache entries*/
+} lv_img_cache_stats_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -59,6 +84,16 @@ lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color);
  */
 void lv_img_cache_set_size(uint16_t new_slot_num);
 
+/**
+ * Change the byte budget at run time (e.g. a larger one when PSRAM is present).
+ * Entries already cached stay until they are evicted.
+ * Only has effect with `LV_IMG_CACHE_BYTE_BUDGET > 0`.
+ * @param bytes decoded data the cache may hold
+ * @param preload max. size of a file image decoded into a cache owned buffer
+ *                (0: never; only with `LV_IMG_CACHE_PRELOAD_MAX > 0`)
+ */
+void lv_img_cache_set_budget(uint32_t bytes, uint32_t preload);
+
 /**
  * Invalidate an image source in the cache.
  * Useful if the image source is updated therefore it needs to be cached again.
@@ -66,6 +101,21 @@ void lv_img_cache_set_size(uint16_t new_slot_num);
  */
 void lv_img_cache_invalidate_src(const void * src);
 
+/**
+ * Pin an image in the cache so it's never evicted (e.g. UI icons which must always draw instantly).
+ * Pinning opens and caches the image if it isn't cached yet.
+ * Only has effect with `LV_IMG_CACHE_BYTE_BUDGET > 0`.
+ * @param src an image source path to a file or pointer to an `lv_img_dsc_t` variable.
+ * @param pin true: pin, false: release (the entry becomes evictable again)
+ */
+void lv_img_cache_pin(const void * src, bool pin);
+
+/**
+ * Get the cache counters
+ * @param stats pointer to store the counters
+ */
+void lv_img_cache_get_stats(lv_img_cache_stats_t * stats);
+
 /**********************
  *      MACROS
  **********************/
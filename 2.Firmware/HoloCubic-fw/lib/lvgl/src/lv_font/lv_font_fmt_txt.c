@@ -23,6 +23,17 @@
 /*********************
  *      DEFINES
  *********************/
+/*Number of decompressed glyphs kept in the cache (0: decompress on every draw)*/
+#ifndef LV_FONT_GLYPH_CACHE_SLOTS
+    #define LV_FONT_GLYPH_CACHE_SLOTS 0
+#endif
+
+/*Size of one cache slot in bytes. Larger glyphs are decompressed on every draw*/
+#ifndef LV_FONT_GLYPH_CACHE_SLOT_SIZE
+    #define LV_FONT_GLYPH_CACHE_SLOT_SIZE 256
+#endif
+
+#define GLYPH_CACHE_EN (LV_USE_FONT_COMPRESSED && LV_FONT_GLYPH_CACHE_SLOTS > 0)
 
 /**********************
  *      TYPEDEFS
@@ -33,6 +44,14 @@ typedef enum {
     RLE_STATE_COUNTER,
 } rle_state_t;
 
+#if GLYPH_CACHE_EN
+typedef struct {
+    const lv_font_t * font;
+    uint32_t gid;
+    uint32_t last_use;  /*Value of `glyph_cache_tick` at the last hit, the smallest is replaced first*/
+} glyph_cache_entry_t;
+#endif
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -63,6 +82,12 @@ static int32_t kern_pair_16_compare(const void * ref, const void * element);
     static rle_state_t rle_state;
 #endif /* LV_USE_FONT_COMPRESSED */
 
+#if GLYPH_CACHE_EN
+    static glyph_cache_entry_t glyph_cache[LV_FONT_GLYPH_CACHE_SLOTS];
+    static uint8_t * glyph_cache_buf;   /*Allocated at the first compressed glyph, plain fonts cost nothing*/
+    static uint32_t glyph_cache_tick;
+#endif
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -117,13 +142,42 @@ const uint8_t * lv_font_get_bitmap_fmt_txt(const lv_font_t * font, uint32_t unic
                 break;
         }
 
+        bool prefilter = fdsc->bitmap_format == LV_FONT_FMT_TXT_COMPRESSED ? true : false;
+
+#if GLYPH_CACHE_EN
+        /*Look up the decompressed glyph and keep it if it fits into a slot.
+         *The returned bitmap stays valid until the next call, the same as with the shared buffer*/
+        if(glyph_cache_buf == NULL && buf_size <= LV_FONT_GLYPH_CACHE_SLOT_SIZE) {
+            glyph_cache_buf = lv_mem_alloc(LV_FONT_GLYPH_CACHE_SLOTS * LV_FONT_GLYPH_CACHE_SLOT_SIZE);
+        }
+        if(glyph_cache_buf && buf_size <= LV_FONT_GLYPH_CACHE_SLOT_SIZE) {
+            uint32_t i;
+            uint32_t oldest = 0;
+            glyph_cache_tick++;
+            for(i = 0; i < LV_FONT_GLYPH_CACHE_SLOTS; i++) {
+                if(glyph_cache[i].font == font && glyph_cache[i].gid == gid) {
+                    glyph_cache[i].last_use = glyph_cache_tick;
+                    return &glyph_cache_buf[i * LV_FONT_GLYPH_CACHE_SLOT_SIZE];
+                }
+                if(glyph_cache[i].last_use < glyph_cache[oldest].last_use) oldest = i;
+            }
+
+            uint8_t * slot = &glyph_cache_buf[oldest * LV_FONT_GLYPH_CACHE_SLOT_SIZE];
+            decompress(&fdsc->glyph_bitmap[gdsc->bitmap_index], slot, gdsc->box_w, gdsc->box_h,
+                       (uint8_t)fdsc->bpp, prefilter);
+            glyph_cache[oldest].font = font;
+            glyph_cache[oldest].gid = gid;
+            glyph_cache[oldest].last_use = glyph_cache_tick;
+            return slot;
+        }
+#endif
+
         if(_lv_mem_get_size(LV_GC_ROOT(_lv_font_decompr_buf)) < buf_size) {
             LV_GC_ROOT(_lv_font_decompr_buf) = lv_mem_realloc(LV_GC_ROOT(_lv_font_decompr_buf), buf_size);
             LV_ASSERT_MEM(LV_GC_ROOT(_lv_font_decompr_buf));
             if(LV_GC_ROOT(_lv_font_decompr_buf) == NULL) return NULL;
         }
 
-        bool prefilter = fdsc->bitmap_format == LV_FONT_FMT_TXT_COMPRESSED ? true : false;
         decompress(&fdsc->glyph_bitmap[gdsc->bitmap_index], LV_GC_ROOT(_lv_font_decompr_buf), gdsc->box_w, gdsc->box_h,
                    (uint8_t)fdsc->bpp,
                    prefilter);
@@ -197,8 +251,53 @@ void _lv_font_clean_up_fmt_txt(void)
         lv_mem_free(LV_GC_ROOT(_lv_font_decompr_buf));
         LV_GC_ROOT(_lv_font_decompr_buf) = NULL;
     }
+    lv_font_fmt_txt_cache_clear(NULL);
+#if GLYPH_CACHE_EN
+    if(glyph_cache_buf) {
+        lv_mem_free(glyph_cache_buf);
+        glyph_cache_buf = NULL;
+    }
+#endif
 }
 
+/**
+ * Drop the cached decompressed glyphs of a font.
+ * Must be called before a font loaded at run time is freed.
+ * @param font pointer to font or NULL to drop every glyph
+ */
+void lv_font_fmt_txt_cache_clear(const lv_font_t * font)
+{
+#if GLYPH_CACHE_EN
+    uint32_t i;
+    for(i = 0; i < LV_FONT_GLYPH_CACHE_SLOTS; i++) {
+        if(font == NULL || glyph_cache[i].font == font) {
+            glyph_cache[i].font = NULL;
+            glyph_cache[i].last_use = 0;
+        }
+    }
+#else
+    (void)font;
+#endif
+}
+
+
+uint32_t _lv_font_fmt_txt_get_glyph_id(const lv_font_t * font, uint32_t letter)
+{
+    return get_glyph_dsc_id(font, letter);
+}
+
+int8_t _lv_font_fmt_txt_get_kern_value(const lv_font_t * font, uint32_t gid_left, uint32_t gid_right)
+{
+    return get_kern_value(font, gid_left, gid_right);
+}
+
+#if LV_USE_FONT_COMPRESSED
+void _lv_font_fmt_txt_decompress(const uint8_t * in, uint8_t * out, lv_coord_t w, lv_coord_t h, uint8_t bpp,
+                                 bool prefilter)
+{
+    decompress(in, out, w, h, bpp, prefilter);
+}
+#endif
 
 /**********************
  *   STATIC FUNCTIONS
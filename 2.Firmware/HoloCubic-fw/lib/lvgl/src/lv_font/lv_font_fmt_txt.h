@@ -224,6 +224,40 @@ bool lv_font_get_glyph_dsc_fmt_txt(const lv_font_t * font, lv_font_glyph_dsc_t *
  */
 void _lv_font_clean_up_fmt_txt(void);
 
+/**
+ * Drop the cached decompressed glyphs of a font.
+ * Must be called before a font loaded at run time is freed.
+ * @param font pointer to font or NULL to drop every glyph
+ */
+void lv_font_fmt_txt_cache_clear(const lv_font_t * font);
+
+/**
+ * Get the glyph id of a letter. Used by font backends which keep only the
+ * cmaps of a font in RAM (e.g. fonts streamed by `lv_font_load_stream`).
+ * @param font pointer to font, `font->dsc` has to be a `lv_font_fmt_txt_dsc_t`
+ * @param letter an UNICODE letter code
+ * @return the glyph id or 0 if the letter is not in the font
+ */
+uint32_t _lv_font_fmt_txt_get_glyph_id(const lv_font_t * font, uint32_t letter);
+
+/**
+ * Get the kerning value of a glyph pair from the kerning table of the font
+ * @param font pointer to font, `font->dsc` has to be a `lv_font_fmt_txt_dsc_t`
+ * @return the unscaled kerning value
+ */
+int8_t _lv_font_fmt_txt_get_kern_value(const lv_font_t * font, uint32_t gid_left, uint32_t gid_right);
+
+#if LV_USE_FONT_COMPRESSED
+/**
+ * Decompress a glyph bitmap stored in LV_FONT_FMT_TXT_COMPRESSED(_NO_PREFILTER) format
+ * @param in the compressed bitmap
+ * @param out buffer for the decompressed bitmap (`w * h * bpp` bits, rounded up)
+ * @param prefilter true for LV_FONT_FMT_TXT_COMPRESSED
+ */
+void _lv_font_fmt_txt_decompress(const uint8_t * in, uint8_t * out, lv_coord_t w, lv_coord_t h, uint8_t bpp,
+                                 bool prefilter);
+#endif
+
 /**********************
  *      MACROS
  **********************/
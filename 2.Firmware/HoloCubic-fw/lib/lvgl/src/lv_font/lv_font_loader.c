@@ -16,6 +16,17 @@
 
 #if LV_USE_FILESYSTEM
 
+/*********************
+ *      DEFINES
+ *********************/
+/*Page cache of fonts loaded with `lv_font_load_stream`: page size in bytes and number of pages per font*/
+#ifndef LV_FONT_STREAM_PAGE_SIZE
+    #define LV_FONT_STREAM_PAGE_SIZE 512
+#endif
+
+#ifndef LV_FONT_STREAM_PAGES
+    #define LV_FONT_STREAM_PAGES 8
+#endif
 
 /**********************
  *      TYPEDEFS
@@ -61,12 +72,54 @@ typedef struct cmap_table_bin {
     uint8_t padding;
 } cmap_table_bin_t;
 
+typedef struct {
+    uint32_t no;                /*Page index in the file, UINT32_MAX if unused*/
+    uint32_t last_use;
+    uint32_t len;               /*Valid bytes (the last page of the file may be shorter)*/
+    uint8_t data[LV_FONT_STREAM_PAGE_SIZE];
+} font_page_t;
+
+/*A font whose glyph headers and bitmaps stay in the file*/
+typedef struct {
+    lv_font_fmt_txt_dsc_t fmt;  /*Must be the first: cmaps and kerning are used through `font->dsc`*/
+    lv_fs_file_t file;
+    uint32_t loca_start;        /*Offset of the first `loca` entry*/
+    uint32_t loca_count;
+    uint32_t glyph_start;       /*Offset of the `glyf` table*/
+    uint32_t glyph_length;
+    uint8_t index_to_loc_format;
+    uint8_t advance_width_format;
+    uint8_t advance_width_bits;
+    uint8_t xy_bits;
+    uint8_t wh_bits;
+    uint16_t default_advance_width;
+
+    /*The last looked up glyph: `get_glyph_dsc` is followed by `get_glyph_bitmap` for the same letter*/
+    uint32_t gid;
+    lv_font_fmt_txt_glyph_dsc_t gdsc;
+    uint32_t bmp_pos;           /*File offset of the byte holding the first bitmap bit*/
+    uint8_t bmp_shift;          /*Bit offset of the bitmap in that byte*/
+    uint32_t bmp_size;
+
+    uint8_t * bitmap;
+    uint32_t bitmap_size;
+#if LV_USE_FONT_COMPRESSED
+    uint8_t * raw;
+    uint32_t raw_size;
+#endif
+    uint32_t tick;
+    font_page_t pages[LV_FONT_STREAM_PAGES];
+} font_stream_t;
+
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static bit_iterator_t init_bit_iterator(lv_fs_file_t * fp);
-static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font);
+static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font, font_stream_t * stream);
+static bool stream_get_glyph_dsc(const lv_font_t * font, lv_font_glyph_dsc_t * dsc_out, uint32_t unicode_letter,
+                                 uint32_t unicode_letter_next);
+static const uint8_t * stream_get_bitmap(const lv_font_t * font, uint32_t unicode_letter);
 int32_t load_kern(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc, uint8_t format, uint32_t start);
 
 static int read_bits_signed(bit_iterator_t * it, int n_bits, lv_fs_res_t * res);
@@ -97,7 +150,7 @@ lv_font_t * lv_font_load(const char * font_name)
     lv_fs_res_t res = lv_fs_open(&file, font_name, LV_FS_MODE_RD);
 
     if(res == LV_FS_RES_OK) {
-        success = lvgl_load_font(&file, font);
+        success = lvgl_load_font(&file, font, NULL);
     }
 
     if(!success) {
@@ -117,6 +170,48 @@ lv_font_t * lv_font_load(const char * font_name)
 }
 
 
+/**
+ * Loads a `lv_font_t` object from a binary font file but keeps only the character maps
+ * and the kerning tables in RAM. The file stays open and the glyph headers and bitmaps
+ * are read on demand through a small page cache, so large fonts (e.g. full GB2312 CJK)
+ * cost only `LV_FONT_STREAM_PAGES` pages and the index.
+ * @param font_name filename where the font file is located
+ * @return a pointer to the font or NULL in case of error
+ */
+lv_font_t * lv_font_load_stream(const char * font_name)
+{
+    lv_font_t * font = lv_mem_alloc(sizeof(lv_font_t));
+    if(font == NULL) return NULL;
+    memset(font, 0, sizeof(lv_font_t));
+
+    font_stream_t * stream = lv_mem_alloc(sizeof(font_stream_t));
+    if(stream == NULL) {
+        lv_mem_free(font);
+        return NULL;
+    }
+    memset(stream, 0, sizeof(font_stream_t));
+    for(int i = 0; i < LV_FONT_STREAM_PAGES; i++) stream->pages[i].no = UINT32_MAX;
+    stream->gid = UINT32_MAX;
+    font->dsc = stream;
+    /*Set first, `lv_font_free` tells streamed fonts apart by it*/
+    font->get_glyph_dsc = stream_get_glyph_dsc;
+    font->get_glyph_bitmap = stream_get_bitmap;
+
+    bool success = false;
+    if(lv_fs_open(&stream->file, font_name, LV_FS_MODE_RD) == LV_FS_RES_OK) {
+        success = lvgl_load_font(&stream->file, font, stream);
+    }
+
+    if(!success) {
+        LV_LOG_WARN("Error loading font file: %s\n", font_name);
+        lv_font_free(font);
+        font = NULL;
+    }
+
+    return font;
+}
+
+
 /**
  * Frees the memory allocated by the `lv_font_load()` function
  * @param font lv_font_t object created by the lv_font_load function
@@ -124,8 +219,19 @@ lv_font_t * lv_font_load(const char * font_name)
 void lv_font_free(lv_font_t * font)
 {
     if(NULL != font) {
+        lv_font_fmt_txt_cache_clear(font);
         lv_font_fmt_txt_dsc_t * dsc = (lv_font_fmt_txt_dsc_t *) font->dsc;
 
+        /*Streamed font: `fmt` is embedded at the start of the stream descriptor*/
+        if(NULL != dsc && font->get_glyph_bitmap == stream_get_bitmap) {
+            font_stream_t * stream = (font_stream_t *) dsc;
+            if(stream->file.file_d) lv_fs_close(&stream->file);
+            if(stream->bitmap) lv_mem_free(stream->bitmap);
+#if LV_USE_FONT_COMPRESSED
+            if(stream->raw) lv_mem_free(stream->raw);
+#endif
+        }
+
         if(NULL != dsc) {
 
             if(dsc->kern_classes == 0) {
@@ -488,14 +594,18 @@ static int32_t load_glyph(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc,
  * `lv_font_free` will assume that all non-null pointers are allocated and
  * should be freed.
  */
-static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font)
+static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font, font_stream_t * stream)
 {
-    lv_font_fmt_txt_dsc_t * font_dsc = (lv_font_fmt_txt_dsc_t *)
-                                       lv_mem_alloc(sizeof(lv_font_fmt_txt_dsc_t));
-
-    memset(font_dsc, 0, sizeof(lv_font_fmt_txt_dsc_t));
-
-    font->dsc = font_dsc;
+    lv_font_fmt_txt_dsc_t * font_dsc;
+    if(stream) {
+        /*Already zeroed and set as `font->dsc` by the caller*/
+        font_dsc = &stream->fmt;
+    }
+    else {
+        font_dsc = (lv_font_fmt_txt_dsc_t *) lv_mem_alloc(sizeof(lv_font_fmt_txt_dsc_t));
+        memset(font_dsc, 0, sizeof(lv_font_fmt_txt_dsc_t));
+        font->dsc = font_dsc;
+    }
 
     /* header */
     int32_t header_length = read_label(fp, 0, "head");
@@ -510,8 +620,10 @@ static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font)
 
     font->base_line = -font_header.descent;
     font->line_height = font_header.ascent - font_header.descent;
-    font->get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt;
-    font->get_glyph_bitmap = lv_font_get_bitmap_fmt_txt;
+    if(!stream) {
+        font->get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt;
+        font->get_glyph_bitmap = lv_font_get_bitmap_fmt_txt;
+    }
     font->subpx = font_header.subpixels_mode;
 
     font_dsc->bpp = font_header.bits_per_pixel;
@@ -537,6 +649,38 @@ static bool lvgl_load_font(lv_fs_file_t * fp, lv_font_t * font)
         return false;
     }
 
+    /*Streamed: only remember where the glyphs are, they are read when drawn*/
+    if(stream) {
+        if(font_header.index_to_loc_format > 1 || loca_count == 0) {
+            LV_LOG_WARN("Unknown index_to_loc_format: %d.", font_header.index_to_loc_format);
+            return false;
+        }
+        stream->loca_start = loca_start + 12;   /*Length, label and count*/
+        stream->loca_count = loca_count;
+        stream->index_to_loc_format = font_header.index_to_loc_format;
+        stream->advance_width_format = font_header.advance_width_format;
+        stream->advance_width_bits = font_header.advance_width_bits;
+        stream->xy_bits = font_header.xy_bits;
+        stream->wh_bits = font_header.wh_bits;
+        stream->default_advance_width = font_header.default_advance_width;
+
+        uint32_t glyph_start = loca_start + loca_length;
+        int32_t glyph_length = read_label(fp, glyph_start, "glyf");
+        if(glyph_length < 0) {
+            return false;
+        }
+        stream->glyph_start = glyph_start;
+        stream->glyph_length = glyph_length;
+
+        if(font_header.tables_count < 4) {
+            font_dsc->kern_dsc = NULL;
+            font_dsc->kern_classes = 0;
+            font_dsc->kern_scale = 0;
+            return true;
+        }
+        return load_kern(fp, font_dsc, font_header.glyph_id_format, glyph_start + glyph_length) >= 0;
+    }
+
     bool failed = false;
     uint32_t * glyph_offset = lv_mem_alloc(sizeof(uint32_t) * (loca_count + 1));
 
@@ -690,5 +834,217 @@ int32_t load_kern(lv_fs_file_t * fp, lv_font_fmt_txt_dsc_t * font_dsc, uint8_t f
     return kern_length;
 }
 
+/**
+ * Read bytes of a streamed font through its page cache
+ * @return number of bytes read (less than `len` only at the end of the file)
+ */
+static uint32_t stream_read(font_stream_t * stream, uint32_t pos, uint8_t * buf, uint32_t len)
+{
+    uint32_t done = 0;
+    while(done < len) {
+        uint32_t no = pos / LV_FONT_STREAM_PAGE_SIZE;
+        font_page_t * page = NULL;
+        font_page_t * oldest = &stream->pages[0];
+
+        stream->tick++;
+        for(int i = 0; i < LV_FONT_STREAM_PAGES; i++) {
+            if(stream->pages[i].no == no) {
+                page = &stream->pages[i];
+                break;
+            }
+            if(stream->pages[i].last_use < oldest->last_use) oldest = &stream->pages[i];
+        }
+
+        if(page == NULL) {
+            page = oldest;
+            page->no = UINT32_MAX;
+            uint32_t br = 0;
+            if(lv_fs_seek(&stream->file, no * LV_FONT_STREAM_PAGE_SIZE) != LV_FS_RES_OK ||
+               lv_fs_read(&stream->file, page->data, LV_FONT_STREAM_PAGE_SIZE, &br) != LV_FS_RES_OK) {
+                return done;
+            }
+            page->no = no;
+            page->len = br;
+        }
+        page->last_use = stream->tick;
+
+        uint32_t ofs = pos - no * LV_FONT_STREAM_PAGE_SIZE;
+        if(ofs >= page->len) return done;
+        uint32_t n = LV_MATH_MIN(page->len - ofs, len - done);
+        memcpy(buf + done, page->data + ofs, n);
+        done += n;
+        pos += n;
+    }
+    return done;
+}
+
+static uint32_t stream_read_loca(font_stream_t * stream, uint32_t gid, bool * ok)
+{
+    if(stream->index_to_loc_format == 0) {
+        uint16_t v = 0;
+        *ok = *ok && stream_read(stream, stream->loca_start + gid * 2, (uint8_t *)&v, 2) == 2;
+        return v;
+    }
+    else {
+        uint32_t v = 0;
+        *ok = *ok && stream_read(stream, stream->loca_start + gid * 4, (uint8_t *)&v, 4) == 4;
+        return v;
+    }
+}
+
+static int stream_bits(const uint8_t * in, uint32_t * bit_pos, int n_bits)
+{
+    int value = 0;
+    while(n_bits--) {
+        value = (value << 1) | ((in[*bit_pos >> 3] >> (7 - (*bit_pos & 7))) & 1);
+        (*bit_pos)++;
+    }
+    return value;
+}
+
+static int stream_bits_signed(const uint8_t * in, uint32_t * bit_pos, int n_bits)
+{
+    int value = stream_bits(in, bit_pos, n_bits);
+    if(n_bits && (value & (1 << (n_bits - 1)))) value -= 1 << n_bits;
+    return value;
+}
+
+/**
+ * Load the header of a glyph (the same fields and rules as `load_glyph`)
+ */
+static bool stream_load_glyph(font_stream_t * stream, uint32_t gid)
+{
+    if(stream->gid == gid) return true;
+    if(gid >= stream->loca_count) return false;
+
+    lv_font_fmt_txt_glyph_dsc_t * gdsc = &stream->gdsc;
+    memset(gdsc, 0, sizeof(lv_font_fmt_txt_glyph_dsc_t));
+    stream->bmp_size = 0;
+
+    /*Glyph 0 is the "not found" glyph*/
+    if(gid == 0) {
+        stream->gid = gid;
+        return true;
+    }
+
+    bool ok = true;
+    uint32_t ofs = stream_read_loca(stream, gid, &ok);
+    uint32_t next = gid < stream->loca_count - 1 ? stream_read_loca(stream, gid + 1, &ok) : stream->glyph_length - 1;
+    if(!ok) return false;
+
+    /*At most 16 + 2 * 8 + 2 * 8 header bits*/
+    uint8_t head[8] = {0};
+    int nbits = stream->advance_width_bits + 2 * stream->xy_bits + 2 * stream->wh_bits;
+    if(nbits > (int)sizeof(head) * 8) return false;
+    stream_read(stream, stream->glyph_start + ofs, head, (nbits + 7) / 8);
+
+    uint32_t bit = 0;
+    if(stream->advance_width_bits == 0) gdsc->adv_w = stream->default_advance_width;
+    else gdsc->adv_w = stream_bits(head, &bit, stream->advance_width_bits);
+    if(stream->advance_width_format == 0) gdsc->adv_w *= 16;
+    gdsc->ofs_x = stream_bits_signed(head, &bit, stream->xy_bits);
+    gdsc->ofs_y = stream_bits_signed(head, &bit, stream->xy_bits);
+    gdsc->box_w = stream_bits(head, &bit, stream->wh_bits);
+    gdsc->box_h = stream_bits(head, &bit, stream->wh_bits);
+
+    stream->bmp_pos = stream->glyph_start + ofs + nbits / 8;
+    stream->bmp_shift = nbits % 8;
+    stream->bmp_size = (gdsc->box_w * gdsc->box_h != 0) ? next - ofs - nbits / 8 : 0;
+    stream->gid = gid;
+    return true;
+}
+
+static bool stream_get_glyph_dsc(const lv_font_t * font, lv_font_glyph_dsc_t * dsc_out, uint32_t unicode_letter,
+                                 uint32_t unicode_letter_next)
+{
+    bool is_tab = false;
+    if(unicode_letter == '\t') {
+        unicode_letter = ' ';
+        is_tab = true;
+    }
+    font_stream_t * stream = (font_stream_t *) font->dsc;
+    uint32_t gid = _lv_font_fmt_txt_get_glyph_id(font, unicode_letter);
+    if(!gid) return false;
+
+    int8_t kvalue = 0;
+    if(stream->fmt.kern_dsc) {
+        uint32_t gid_next = _lv_font_fmt_txt_get_glyph_id(font, unicode_letter_next);
+        if(gid_next) kvalue = _lv_font_fmt_txt_get_kern_value(font, gid, gid_next);
+    }
+
+    if(!stream_load_glyph(stream, gid)) return false;
+    const lv_font_fmt_txt_glyph_dsc_t * gdsc = &stream->gdsc;
+
+    int32_t kv = ((int32_t)((int32_t)kvalue * stream->fmt.kern_scale) >> 4);
+
+    uint32_t adv_w = gdsc->adv_w;
+    if(is_tab) adv_w *= 2;
+
+    adv_w += kv;
+    adv_w  = (adv_w + (1 << 3)) >> 4;
+
+    dsc_out->adv_w = adv_w;
+    dsc_out->box_h = gdsc->box_h;
+    dsc_out->box_w = gdsc->box_w;
+    dsc_out->ofs_x = gdsc->ofs_x;
+    dsc_out->ofs_y = gdsc->ofs_y;
+    dsc_out->bpp   = (uint8_t)stream->fmt.bpp;
+
+    if(is_tab) dsc_out->box_w = dsc_out->box_w * 2;
+
+    return true;
+}
+
+/**
+ * Make sure a buffer of a streamed font is at least `size` bytes
+ */
+static uint8_t * stream_buf(uint8_t ** buf, uint32_t * buf_size, uint32_t size)
+{
+    if(*buf_size < size) {
+        uint8_t * p = lv_mem_realloc(*buf, size);
+        if(p == NULL) return NULL;
+        *buf = p;
+        *buf_size = size;
+    }
+    return *buf;
+}
+
+static const uint8_t * stream_get_bitmap(const lv_font_t * font, uint32_t unicode_letter)
+{
+    if(unicode_letter == '\t') unicode_letter = ' ';
+
+    font_stream_t * stream = (font_stream_t *) font->dsc;
+    uint32_t gid = _lv_font_fmt_txt_get_glyph_id(font, unicode_letter);
+    if(!gid || !stream_load_glyph(stream, gid) || stream->bmp_size == 0) return NULL;
+
+    /*The bitmap follows the bit packed header without padding: read one more byte and shift*/
+    uint32_t size = stream->bmp_size;
+    uint8_t * out = stream_buf(&stream->bitmap, &stream->bitmap_size, size + 1);
+    if(out == NULL) return NULL;
+    uint32_t br = stream_read(stream, stream->bmp_pos, out, size + (stream->bmp_shift ? 1 : 0));
+    if(br < size) memset(out + br, 0, size + 1 - br);
+    if(stream->bmp_shift) {
+        uint8_t sh = stream->bmp_shift;
+        for(uint32_t i = 0; i < size; i++) out[i] = (uint8_t)((out[i] << sh) | (out[i + 1] >> (8 - sh)));
+    }
+
+    if(stream->fmt.bitmap_format == LV_FONT_FMT_TXT_PLAIN) return out;
+
+#if LV_USE_FONT_COMPRESSED
+    /*Decompress into the second buffer, `out` holds the compressed stream*/
+    const lv_font_fmt_txt_glyph_dsc_t * gdsc = &stream->gdsc;
+    uint32_t px = gdsc->box_w * gdsc->box_h;
+    uint32_t dsize = (px * stream->fmt.bpp + 7) >> 3;
+    if(stream->fmt.bpp == 3) dsize = (px + 1) >> 1;    /*3 bpp is decompressed to 4 bpp*/
+    uint8_t * dec = stream_buf(&stream->raw, &stream->raw_size, dsize);
+    if(dec == NULL) return NULL;
+    _lv_font_fmt_txt_decompress(out, dec, gdsc->box_w, gdsc->box_h, (uint8_t)stream->fmt.bpp,
+                                stream->fmt.bitmap_format == LV_FONT_FMT_TXT_COMPRESSED);
+    return dec;
+#else
+    return NULL;
+#endif
+}
+
 #endif /*LV_USE_FILESYSTEM*/
 
@@ -0,0 +1,629 @@
+/**
+ * @file lv_gpu_esp32.c
+ * Software blend kernels tuned for the ESP32 (Xtensa LX6): RGB565 pixels are processed in pairs
+ * packed into 32 bit words and the code is placed in IRAM so it doesn't depend on the flash cache.
+ * Both byte orders (LV_COLOR_16_SWAP) are supported.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_gpu_esp32.h"
+#include <string.h>
+
+#ifndef LV_USE_GPU_ESP32
+    #define LV_USE_GPU_ESP32 0
+#endif
+
+#if LV_USE_GPU_ESP32
+
+#if LV_COLOR_DEPTH != 16 || LV_COLOR_SCREEN_TRANSP != 0
+    #error "LV_USE_GPU_ESP32 requires LV_COLOR_DEPTH 16 and LV_COLOR_SCREEN_TRANSP 0"
+#endif
+
+#if defined(ESP_PLATFORM)
+    #include <esp_attr.h>
+    #define LV_GPU_ESP32_ATTR IRAM_ATTR
+#else
+    #define LV_GPU_ESP32_ATTR
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+/*The 5 bit red/blue and 6 bit green channels of two pixels, one pixel in each 16 bit lane*/
+#define LANE_5BIT   0x001F001FU
+#define LANE_6BIT   0x003F003FU
+#define LANE_8BIT   0x00FF00FFU
+#define LANE_ONE    0x00010001U
+#define LANE_ROUND  ((uint32_t)LV_COLOR_MIX_ROUND_OFS * LANE_ONE)
+
+/*RGB565 spread over 32 bits (green in the upper half) so that the channels can be interpolated
+ *with one multiplication and 5 bit weights*/
+#define SPREAD_MASK 0x07E0F81FU
+
+/*With LV_COLOR_16_SWAP the pixels are stored in the display's byte order.
+ *Fills and copies don't care but the channels have to be swapped back to be mixed.*/
+#if LV_COLOR_16_SWAP
+    #define PX_ORDER_X2(x) swap16_x2(x)
+#else
+    #define PX_ORDER_X2(x) (x)
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Swap the two bytes of a pixel
+ */
+static inline uint16_t swap16(uint16_t x)
+{
+    return (uint16_t)((x << 8) | (x >> 8));
+}
+
+/**
+ * Swap the two bytes in both 16 bit lanes
+ */
+static inline uint32_t swap16_x2(uint32_t x)
+{
+    return ((x & LANE_8BIT) << 8) | ((x >> 8) & LANE_8BIT);
+}
+
+/**
+ * Divide both 16 bit lanes by 255. Exact (same as `LV_MATH_UDIV255`) for lane values below 0xFF00.
+ */
+static inline uint32_t div255_x2(uint32_t x)
+{
+    return ((x + LANE_ONE + ((x >> 8) & LANE_8BIT)) >> 8) & LANE_8BIT;
+}
+
+/**
+ * Mix two pixel pairs: `fg * opa + bg * (255 - opa)` per channel and lane, rounded like `lv_color_mix`
+ */
+static inline uint32_t mix_x2(uint32_t fg, uint32_t bg, uint32_t opa, uint32_t opa_inv)
+{
+    fg = PX_ORDER_X2(fg);
+    bg = PX_ORDER_X2(bg);
+    uint32_t r = ((fg >> 11) & LANE_5BIT) * opa + ((bg >> 11) & LANE_5BIT) * opa_inv + LANE_ROUND;
+    uint32_t g = ((fg >> 5) & LANE_6BIT) * opa + ((bg >> 5) & LANE_6BIT) * opa_inv + LANE_ROUND;
+    uint32_t b = (fg & LANE_5BIT) * opa + (bg & LANE_5BIT) * opa_inv + LANE_ROUND;
+
+    return PX_ORDER_X2((div255_x2(r) << 11) | (div255_x2(g) << 5) | div255_x2(b));
+}
+
+/**
+ * Mix a pixel pair with a constant color which is already multiplied with `opa` (see `lv_gpu_esp32_fill_opa`)
+ */
+static inline uint32_t mix_premult_x2(const uint32_t * premult, uint32_t bg, uint32_t opa_inv)
+{
+    bg = PX_ORDER_X2(bg);
+    uint32_t r = ((bg >> 11) & LANE_5BIT) * opa_inv + premult[0];
+    uint32_t g = ((bg >> 5) & LANE_6BIT) * opa_inv + premult[1];
+    uint32_t b = (bg & LANE_5BIT) * opa_inv + premult[2];
+
+    return PX_ORDER_X2((div255_x2(r) << 11) | (div255_x2(g) << 5) | div255_x2(b));
+}
+
+#if LV_USE_IMG_TRANSFORM
+/**
+ * Source coordinate [1/256 px] of a target pixel relative to the pivot.
+ * The same arithmetic as `_lv_img_buf_transform` so the kernels sample the same points.
+ */
+static inline void transform_src(const lv_img_transform_dsc_t * dsc, int32_t xt, int32_t yt, int32_t * xs, int32_t * ys)
+{
+    if(dsc->cfg.zoom == LV_IMG_ZOOM_NONE) {
+        *xs = ((dsc->tmp.cosma * xt - dsc->tmp.sinma * yt) >> (_LV_TRANSFORM_TRIGO_SHIFT - 8)) + dsc->tmp.pivot_x_256;
+        *ys = ((dsc->tmp.sinma * xt + dsc->tmp.cosma * yt) >> (_LV_TRANSFORM_TRIGO_SHIFT - 8)) + dsc->tmp.pivot_y_256;
+        return;
+    }
+
+    xt = (int32_t)(xt * dsc->tmp.zoom_inv) >> _LV_ZOOM_INV_UPSCALE;
+    yt = (int32_t)(yt * dsc->tmp.zoom_inv) >> _LV_ZOOM_INV_UPSCALE;
+    if(dsc->cfg.angle == 0) {
+        *xs = xt + dsc->tmp.pivot_x_256;
+        *ys = yt + dsc->tmp.pivot_y_256;
+    }
+    else {
+        *xs = ((dsc->tmp.cosma * xt - dsc->tmp.sinma * yt) >> _LV_TRANSFORM_TRIGO_SHIFT) + dsc->tmp.pivot_x_256;
+        *ys = ((dsc->tmp.sinma * xt + dsc->tmp.cosma * yt) >> _LV_TRANSFORM_TRIGO_SHIFT) + dsc->tmp.pivot_y_256;
+    }
+}
+
+/**
+ * Read a source pixel in the native channel order
+ */
+static inline uint32_t px_565(const uint16_t * src, int32_t i)
+{
+#if LV_COLOR_16_SWAP
+    return swap16(src[i]);
+#else
+    return src[i];
+#endif
+}
+
+/**
+ * Interpolate two RGB565 pixels (native order): `a * (32 - f) + b * f`, `f` = 0..32
+ */
+static inline uint32_t lerp_565(uint32_t a, uint32_t b, uint32_t f)
+{
+    a = (a | (a << 16)) & SPREAD_MASK;
+    b = (b | (b << 16)) & SPREAD_MASK;
+    uint32_t r = ((a * (32 - f) + b * f) >> 5) & SPREAD_MASK;
+    return (r | (r >> 16)) & 0xFFFF;
+}
+
+/**
+ * 90, 180 or 270 degree rotation without zoom: every target pixel is exactly one source pixel
+ */
+LV_GPU_ESP32_ATTR static void transform_rot90(const lv_img_transform_dsc_t * dsc, int32_t xt, int32_t yt, lv_coord_t len,
+                                              uint16_t * color_buf, lv_opa_t * opa_buf)
+{
+    const uint16_t * src = dsc->cfg.src;
+    int32_t w = dsc->cfg.src_w;
+    int32_t h = dsc->cfg.src_h;
+    int32_t sx;
+    int32_t sy;
+    int32_t dsx = 0;    /*Source pixel change per target pixel*/
+    int32_t dsy = 0;
+
+    switch(dsc->cfg.angle) {
+        case 900:
+            sx = dsc->cfg.pivot_x + yt;
+            sy = dsc->cfg.pivot_y - xt;
+            dsy = -1;
+            break;
+        case 1800:
+            sx = dsc->cfg.pivot_x - xt;
+            sy = dsc->cfg.pivot_y - yt;
+            dsx = -1;
+            break;
+        default:
+            sx = dsc->cfg.pivot_x - yt;
+            sy = dsc->cfg.pivot_y + xt;
+            dsy = 1;
+            break;
+    }
+
+    lv_coord_t i;
+    for(i = 0; i < len; i++, sx += dsx, sy += dsy) {
+        if(sx >= 0 && sx < w && sy >= 0 && sy < h) {
+            color_buf[i] = src[sy * w + sx];
+            opa_buf[i] = LV_OPA_COVER;
+        }
+        else {
+            opa_buf[i] = LV_OPA_TRANSP;
+        }
+    }
+}
+
+/**
+ * Nearest neighbor: the pixel the original transformation picks without anti-aliasing
+ */
+LV_GPU_ESP32_ATTR static void transform_nearest(const lv_img_transform_dsc_t * dsc, int32_t xt, int32_t yt, lv_coord_t len,
+                                                uint16_t * color_buf, lv_opa_t * opa_buf)
+{
+    const uint16_t * src = dsc->cfg.src;
+    int32_t w = dsc->cfg.src_w;
+    int32_t h = dsc->cfg.src_h;
+
+    if(dsc->cfg.angle == 0) {
+        /*Pure zoom: one source row, the column only depends on x*/
+        int32_t xs;
+        int32_t ys;
+        transform_src(dsc, xt, yt, &xs, &ys);
+        int32_t sy = ys >> 8;
+        if(sy < 0 || sy >= h) {
+            _lv_memset_00(opa_buf, len);
+            return;
+        }
+        const uint16_t * row = &src[sy * w];
+        lv_coord_t i;
+        for(i = 0; i < len; i++) {
+            int32_t sx = (((int32_t)((xt + i) * dsc->tmp.zoom_inv) >> _LV_ZOOM_INV_UPSCALE) + dsc->tmp.pivot_x_256) >> 8;
+            if(sx >= 0 && sx < w) {
+                color_buf[i] = row[sx];
+                opa_buf[i] = LV_OPA_COVER;
+            }
+            else {
+                opa_buf[i] = LV_OPA_TRANSP;
+            }
+        }
+        return;
+    }
+
+    lv_coord_t i;
+    for(i = 0; i < len; i++) {
+        int32_t xs;
+        int32_t ys;
+        transform_src(dsc, xt + i, yt, &xs, &ys);
+        int32_t sx = xs >> 8;
+        int32_t sy = ys >> 8;
+        if(sx >= 0 && sx < w && sy >= 0 && sy < h) {
+            color_buf[i] = src[sy * w + sx];
+            opa_buf[i] = LV_OPA_COVER;
+        }
+        else {
+            opa_buf[i] = LV_OPA_TRANSP;
+        }
+    }
+}
+
+/**
+ * Bilinear interpolation between the 4 nearest pixel centers.
+ * Neighbors outside of the image are replaced with the nearest inside pixel and only reduce the opacity,
+ * so the edges are anti-aliased without darkening.
+ */
+LV_GPU_ESP32_ATTR static void transform_bilinear(const lv_img_transform_dsc_t * dsc, int32_t xt, int32_t yt, lv_coord_t len,
+                                                 uint16_t * color_buf, lv_opa_t * opa_buf)
+{
+    const uint16_t * src = dsc->cfg.src;
+    int32_t w = dsc->cfg.src_w;
+    int32_t h = dsc->cfg.src_h;
+
+    lv_coord_t i;
+    for(i = 0; i < len; i++) {
+        int32_t xs;
+        int32_t ys;
+        transform_src(dsc, xt + i, yt, &xs, &ys);
+        if((xs >> 8) < 0 || (xs >> 8) >= w || (ys >> 8) < 0 || (ys >> 8) >= h) {
+            opa_buf[i] = LV_OPA_TRANSP;
+            continue;
+        }
+
+        /*Relative to the pixel centers*/
+        xs -= 128;
+        ys -= 128;
+        int32_t x0 = xs >> 8;
+        int32_t y0 = ys >> 8;
+        uint32_t fx = (xs & 0xFF) >> 3;
+        uint32_t fy = (ys & 0xFF) >> 3;
+
+        uint32_t cov_x = 32;
+        uint32_t cov_y = 32;
+        int32_t x1 = x0 + 1;
+        int32_t y1 = y0 + 1;
+        if(x0 < 0) {
+            x0 = 0;
+            cov_x = fx;
+        }
+        else if(x1 >= w) {
+            x1 = w - 1;
+            cov_x = 32 - fx;
+        }
+        if(y0 < 0) {
+            y0 = 0;
+            cov_y = fy;
+        }
+        else if(y1 >= h) {
+            y1 = h - 1;
+            cov_y = 32 - fy;
+        }
+
+        const uint16_t * r0 = &src[y0 * w];
+        const uint16_t * r1 = &src[y1 * w];
+        uint32_t top = lerp_565(px_565(r0, x0), px_565(r0, x1), fx);
+        uint32_t bottom = lerp_565(px_565(r1, x0), px_565(r1, x1), fx);
+        uint32_t c = lerp_565(top, bottom, fy);
+#if LV_COLOR_16_SWAP
+        c = swap16(c);
+#endif
+        color_buf[i] = c;
+        opa_buf[i] = (cov_x * cov_y * 255) >> 10;
+    }
+}
+#endif /*LV_USE_IMG_TRANSFORM*/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+LV_GPU_ESP32_ATTR void lv_gpu_esp32_fill(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, lv_coord_t fill_w,
+                                         lv_coord_t fill_h)
+{
+    uint32_t c32 = color.full | ((uint32_t)color.full << 16);
+    lv_coord_t y;
+
+    for(y = 0; y < fill_h; y++) {
+        uint16_t * d16 = &buf->full;
+        int32_t n = fill_w;
+
+        if(((lv_uintptr_t)d16 & 0x2) && n > 0) {
+            *d16++ = color.full;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d16;
+        while(n >= 16) {
+            d32[0] = c32;
+            d32[1] = c32;
+            d32[2] = c32;
+            d32[3] = c32;
+            d32[4] = c32;
+            d32[5] = c32;
+            d32[6] = c32;
+            d32[7] = c32;
+            d32 += 8;
+            n -= 16;
+        }
+        while(n >= 2) {
+            *d32++ = c32;
+            n -= 2;
+        }
+        if(n) *(uint16_t *)d32 = color.full;
+
+        buf += buf_w;
+    }
+}
+
+LV_GPU_ESP32_ATTR void lv_gpu_esp32_fill_opa(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, lv_opa_t opa,
+                                             lv_coord_t fill_w, lv_coord_t fill_h)
+{
+    uint32_t opa_inv = 255 - opa;
+    uint32_t c32 = PX_ORDER_X2(color.full | ((uint32_t)color.full << 16));
+    uint32_t premult[3];
+    premult[0] = ((c32 >> 11) & LANE_5BIT) * opa + LANE_ROUND;
+    premult[1] = ((c32 >> 5) & LANE_6BIT) * opa + LANE_ROUND;
+    premult[2] = (c32 & LANE_5BIT) * opa + LANE_ROUND;
+
+    /*Backgrounds are mostly uniform: cache the last destination pair and its result*/
+    uint32_t last_dest = 0;
+    uint32_t last_res = mix_premult_x2(premult, 0, opa_inv);
+    lv_coord_t y;
+
+    for(y = 0; y < fill_h; y++) {
+        uint16_t * d16 = &buf->full;
+        int32_t n = fill_w;
+
+        if(((lv_uintptr_t)d16 & 0x2) && n > 0) {
+            *d16 = (uint16_t)mix_premult_x2(premult, *d16, opa_inv);
+            d16++;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d16;
+        while(n >= 2) {
+            uint32_t dest = *d32;
+            if(dest != last_dest) {
+                last_dest = dest;
+                last_res = mix_premult_x2(premult, dest, opa_inv);
+            }
+            *d32++ = last_res;
+            n -= 2;
+        }
+        if(n) {
+            d16 = (uint16_t *)d32;
+            *d16 = (uint16_t)mix_premult_x2(premult, *d16, opa_inv);
+        }
+
+        buf += buf_w;
+    }
+}
+
+LV_GPU_ESP32_ATTR void lv_gpu_esp32_copy(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                                         lv_coord_t copy_w, lv_coord_t copy_h)
+{
+    lv_coord_t y;
+
+    for(y = 0; y < copy_h; y++) {
+        /*Word copies need the same alignment on both sides. Otherwise fall back to `memcpy`*/
+        if(((lv_uintptr_t)buf ^ (lv_uintptr_t)map) & 0x2) {
+            memcpy(buf, map, copy_w * sizeof(lv_color_t));
+            buf += buf_w;
+            map += map_w;
+            continue;
+        }
+
+        uint16_t * d16 = &buf->full;
+        const uint16_t * s16 = &map->full;
+        int32_t n = copy_w;
+
+        if(((lv_uintptr_t)d16 & 0x2) && n > 0) {
+            *d16++ = *s16++;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d16;
+        const uint32_t * s32 = (const uint32_t *)s16;
+        while(n >= 8) {
+            uint32_t a = s32[0];
+            uint32_t b = s32[1];
+            uint32_t c = s32[2];
+            uint32_t d = s32[3];
+            d32[0] = a;
+            d32[1] = b;
+            d32[2] = c;
+            d32[3] = d;
+            d32 += 4;
+            s32 += 4;
+            n -= 8;
+        }
+        while(n >= 2) {
+            *d32++ = *s32++;
+            n -= 2;
+        }
+        if(n) *(uint16_t *)d32 = *(const uint16_t *)s32;
+
+        buf += buf_w;
+        map += map_w;
+    }
+}
+
+LV_GPU_ESP32_ATTR void lv_gpu_esp32_copy_swap(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map,
+                                              lv_coord_t map_w, lv_coord_t copy_w, lv_coord_t copy_h)
+{
+    lv_coord_t y;
+
+    for(y = 0; y < copy_h; y++) {
+        uint16_t * d16 = &buf->full;
+        const uint16_t * s16 = &map->full;
+        int32_t n = copy_w;
+
+        if(((lv_uintptr_t)d16 & 0x2) && n > 0) {
+            *d16++ = swap16(*s16++);
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d16;
+        if(((lv_uintptr_t)s16 & 0x2) == 0) {
+            const uint32_t * s32 = (const uint32_t *)s16;
+            while(n >= 4) {
+                uint32_t a = s32[0];
+                uint32_t b = s32[1];
+                d32[0] = swap16_x2(a);
+                d32[1] = swap16_x2(b);
+                d32 += 2;
+                s32 += 2;
+                n -= 4;
+            }
+            while(n >= 2) {
+                *d32++ = swap16_x2(*s32++);
+                n -= 2;
+            }
+            s16 = (const uint16_t *)s32;
+        }
+        else {
+            while(n >= 2) {
+                *d32++ = swap16_x2(s16[0] | ((uint32_t)s16[1] << 16));
+                s16 += 2;
+                n -= 2;
+            }
+        }
+        if(n) *(uint16_t *)d32 = swap16(*s16);
+
+        buf += buf_w;
+        map += map_w;
+    }
+}
+
+LV_GPU_ESP32_ATTR void lv_gpu_esp32_copy_lut(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map,
+                                             lv_coord_t map_w, lv_coord_t copy_w, lv_coord_t copy_h, const uint16_t * lut)
+{
+    const uint16_t * lut_g = lut + 32;
+    const uint16_t * lut_b = lut + 96;
+    lv_coord_t y;
+
+    for(y = 0; y < copy_h; y++) {
+        uint16_t * d16 = &buf->full;
+        const uint16_t * s16 = &map->full;
+        int32_t n = copy_w;
+
+        /*Two pixels per iteration: the loads of the second pixel hide the latency of the first one's*/
+        while(n >= 2) {
+            uint32_t a = s16[0];
+            uint32_t b = s16[1];
+#if LV_COLOR_16_SWAP
+            a = swap16(a);
+            b = swap16(b);
+#endif
+            uint16_t oa = lut[a >> 11] | lut_g[(a >> 5) & 0x3F] | lut_b[a & 0x1F];
+            uint16_t ob = lut[b >> 11] | lut_g[(b >> 5) & 0x3F] | lut_b[b & 0x1F];
+            d16[0] = oa;
+            d16[1] = ob;
+            d16 += 2;
+            s16 += 2;
+            n -= 2;
+        }
+        if(n) {
+            uint32_t a = s16[0];
+#if LV_COLOR_16_SWAP
+            a = swap16(a);
+#endif
+            d16[0] = lut[a >> 11] | lut_g[(a >> 5) & 0x3F] | lut_b[a & 0x1F];
+        }
+
+        buf += buf_w;
+        map += map_w;
+    }
+}
+
+LV_GPU_ESP32_ATTR void lv_gpu_esp32_blend(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                                          lv_opa_t opa, lv_coord_t copy_w, lv_coord_t copy_h)
+{
+    uint32_t opa_inv = 255 - opa;
+    lv_coord_t y;
+
+    for(y = 0; y < copy_h; y++) {
+        uint16_t * d16 = &buf->full;
+        const uint16_t * s16 = &map->full;
+        int32_t n = copy_w;
+
+        if(((lv_uintptr_t)d16 & 0x2) && n > 0) {
+            *d16 = (uint16_t)mix_x2(*s16, *d16, opa, opa_inv);
+            d16++;
+            s16++;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d16;
+        if(((lv_uintptr_t)s16 & 0x2) == 0) {
+            const uint32_t * s32 = (const uint32_t *)s16;
+            while(n >= 2) {
+                *d32 = mix_x2(*s32, *d32, opa, opa_inv);
+                d32++;
+                s32++;
+                n -= 2;
+            }
+            s16 = (const uint16_t *)s32;
+        }
+        else {
+            /*The map is not word aligned here: pack the pairs with two halfword loads*/
+            while(n >= 2) {
+                uint32_t fg = s16[0] | ((uint32_t)s16[1] << 16);
+                *d32 = mix_x2(fg, *d32, opa, opa_inv);
+                d32++;
+                s16 += 2;
+                n -= 2;
+            }
+        }
+        if(n) {
+            d16 = (uint16_t *)d32;
+            *d16 = (uint16_t)mix_x2(*s16, *d16, opa, opa_inv);
+        }
+
+        buf += buf_w;
+        map += map_w;
+    }
+}
+
+#if LV_USE_IMG_TRANSFORM
+LV_GPU_ESP32_ATTR bool lv_gpu_esp32_transform_row(const lv_img_transform_dsc_t * dsc, lv_coord_t x, lv_coord_t y,
+                                                  lv_coord_t len, lv_color_t * color_buf, lv_opa_t * opa_buf)
+{
+    if(dsc->cfg.cf != LV_IMG_CF_TRUE_COLOR) return false;
+
+    int32_t xt = x - dsc->cfg.pivot_x;
+    int32_t yt = y - dsc->cfg.pivot_y;
+    uint16_t * c16 = &color_buf->full;
+
+    if(dsc->cfg.zoom == LV_IMG_ZOOM_NONE &&
+       (dsc->cfg.angle == 900 || dsc->cfg.angle == 1800 || dsc->cfg.angle == 2700)) {
+        transform_rot90(dsc, xt, yt, len, c16, opa_buf);
+    }
+    else if(!dsc->cfg.antialias || (dsc->cfg.angle == 0 && (dsc->cfg.zoom & 0xFF) == 0)) {
+        transform_nearest(dsc, xt, yt, len, c16, opa_buf);
+    }
+    else {
+        transform_bilinear(dsc, xt, yt, len, c16, opa_buf);
+    }
+    return true;
+}
+#endif
+
+#endif /*LV_USE_GPU_ESP32*/
@@ -0,0 +1,139 @@
+/**
+ * @file lv_gpu_esp32.h
+ *
+ */
+
+#ifndef LV_GPU_ESP32_H
+#define LV_GPU_ESP32_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../lv_misc/lv_area.h"
+#include "../lv_misc/lv_color.h"
+#include "../lv_draw/lv_img_buf.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/*Entries of the table of `lv_gpu_esp32_copy_lut`: 32 red, 64 green and 32 blue levels*/
+#define LV_GPU_ESP32_LUT_SIZE 128
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Fill an area in the buffer with a color, two pixels per 32 bit store
+ * @param buf a buffer which should be filled
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ * @note `buf_w - fill_w` is offset to the next line after fill
+ */
+void lv_gpu_esp32_fill(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, lv_coord_t fill_w,
+                       lv_coord_t fill_h);
+
+/**
+ * Mix a color into an area of the buffer with the given opacity
+ * @param buf a buffer to blend into
+ * @param buf_w width of the buffer in pixels
+ * @param color fill color
+ * @param opa opacity of `color` (0..255)
+ * @param fill_w width to fill in pixels (<= buf_w)
+ * @param fill_h height to fill in pixels
+ * @note the result is the same as `lv_color_mix(color, buf[i], opa)` for every pixel
+ */
+void lv_gpu_esp32_fill_opa(lv_color_t * buf, lv_coord_t buf_w, lv_color_t color, lv_opa_t opa,
+                           lv_coord_t fill_w, lv_coord_t fill_h);
+
+/**
+ * Copy a map (typically RGB image) to a buffer
+ * @param buf a buffer where map should be copied
+ * @param buf_w width of the buffer in pixels
+ * @param map an "image" to copy
+ * @param map_w width of the map in pixels
+ * @param copy_w width of the area to copy in pixels (<= buf_w)
+ * @param copy_h height of the area to copy in pixels
+ */
+void lv_gpu_esp32_copy(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                       lv_coord_t copy_w, lv_coord_t copy_h);
+
+/**
+ * Copy a map to a buffer and swap the bytes of every pixel (to the big endian order of SPI displays)
+ * @param buf a buffer where map should be copied
+ * @param buf_w width of the buffer in pixels
+ * @param map an "image" to copy
+ * @param map_w width of the map in pixels
+ * @param copy_w width of the area to copy in pixels (<= buf_w)
+ * @param copy_h height of the area to copy in pixels
+ */
+void lv_gpu_esp32_copy_swap(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                            lv_coord_t copy_w, lv_coord_t copy_h);
+
+/**
+ * Copy a map to a buffer and remap every channel through a lookup table (color grading fused with the
+ * byte order conversion of the flush path). `buf` and `map` may be the same buffer.
+ * @param buf a buffer where map should be copied
+ * @param buf_w width of the buffer in pixels
+ * @param map an "image" to copy
+ * @param map_w width of the map in pixels
+ * @param copy_w width of the area to copy in pixels (<= buf_w)
+ * @param copy_h height of the area to copy in pixels
+ * @param lut `LV_GPU_ESP32_LUT_SIZE` entries: 32 for red, 64 for green and 32 for blue. The output pixel is
+ *            `lut[r] | lut[32 + g] | lut[96 + b]` so the entries already hold the channel at its final
+ *            position and in the output byte order.
+ */
+void lv_gpu_esp32_copy_lut(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                           lv_coord_t copy_w, lv_coord_t copy_h, const uint16_t * lut);
+
+/**
+ * Blend a map (e.g. ARGB image or RGB image with opacity) to a buffer
+ * @param buf a buffer where `map` should be copied
+ * @param buf_w width of the buffer in pixels
+ * @param map an "image" to copy
+ * @param map_w width of the map in pixels
+ * @param opa opacity of `map` (0..255)
+ * @param copy_w width of the area to copy in pixels (<= buf_w)
+ * @param copy_h height of the area to copy in pixels
+ * @note the result is the same as `lv_color_mix(map[i], buf[i], opa)` for every pixel
+ */
+void lv_gpu_esp32_blend(lv_color_t * buf, lv_coord_t buf_w, const lv_color_t * map, lv_coord_t map_w,
+                        lv_opa_t opa, lv_coord_t copy_w, lv_coord_t copy_h);
+
+#if LV_USE_IMG_TRANSFORM
+/**
+ * Transform one row of an RGB565 image without alpha (LV_IMG_CF_TRUE_COLOR)
+ * - 90/180/270 degrees without zoom: exact pixel copy
+ * - no anti-aliasing or integer zoom without rotation: nearest neighbor
+ * - otherwise: fixed-point bilinear interpolation
+ * @param dsc a descriptor initialized by `_lv_img_buf_transform_init`
+ * @param x first target pixel relative to the image's original position
+ * @param y row relative to the image's original position
+ * @param len number of pixels
+ * @param color_buf store the colors here
+ * @param opa_buf store the opacity of the pixels here (0: outside of the image)
+ * @return false: the color format is not supported, use `_lv_img_buf_transform`
+ */
+bool lv_gpu_esp32_transform_row(const lv_img_transform_dsc_t * dsc, lv_coord_t x, lv_coord_t y,
+                                lv_coord_t len, lv_color_t * color_buf, lv_opa_t * opa_buf);
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_GPU_ESP32_H*/
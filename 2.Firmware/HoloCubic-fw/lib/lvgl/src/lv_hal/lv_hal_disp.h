@@ -128,6 +128,15 @@ typedef struct _disp_drv_t {
                         const lv_area_t * fill_area, lv_color_t color);
 #endif
 
+#if defined(LV_USE_REFR_DIRECT) && LV_USE_REFR_DIRECT
+    /** OPTIONAL: Send an area of an opaque true color image to the display without rendering it to the buffer.
+     * Called only if the area shows nothing but that image (see `LV_USE_REFR_DIRECT` in lv_conf.h).
+     * `src` points to the first pixel of the area and `src_stride` is the width of the image in pixels.
+     * Return `true` if the area was sent or `false` to render it normally.*/
+    bool (*direct_cb)(struct _disp_drv_t * disp_drv, const lv_area_t * area, const lv_color_t * src,
+                      lv_coord_t src_stride);
+#endif
+
     /** On CHROMA_KEYED images this color will be transparent.
      * `LV_COLOR_TRANSP` by default. (lv_conf.h)*/
     lv_color_t color_chroma_key;
@@ -16,6 +16,7 @@
 #include "lv_task.h"
 #include "lv_math.h"
 #include "lv_gc.h"
+#include "../lv_core/lv_refr.h"
 
 #if defined(LV_GC_INCLUDE)
     #include LV_GC_INCLUDE
@@ -44,6 +45,7 @@ static bool anim_ready_handler(lv_anim_t * a);
  **********************/
 static uint32_t last_task_run;
 static bool anim_list_changed;
+static uint8_t anim_round; /*Toggled in every `anim_task`; an animation has run in this round if `has_run == anim_round`*/
 static lv_task_t * _lv_anim_task;
 const lv_anim_path_t lv_anim_path_def = {.cb = lv_anim_path_linear};
 
@@ -108,6 +110,7 @@ void lv_anim_start(lv_anim_t * a)
     /*Initialize the animation descriptor*/
     a->time_orig = a->time;
     _lv_memcpy(new_anim, a, sizeof(lv_anim_t));
+    new_anim->has_run = anim_round; /*Don't step it with the time elapsed before it was created*/
 
     /*Set the start value*/
     if(new_anim->early_apply) {
@@ -140,7 +143,7 @@ bool lv_anim_del(void * var, lv_anim_exec_xcb_t exec_cb)
 
         if(a->var == var && (a->exec_cb == exec_cb || exec_cb == NULL)) {
             _lv_ll_remove(&LV_GC_ROOT(_lv_anim_ll), a);
-            lv_mem_free(a);
+            _lv_ll_free(a);
             anim_mark_list_change(); /*Read by `anim_task`. It need to know if a delete occurred in
                                          the linked list*/
             del = true;
@@ -444,13 +447,16 @@ static void anim_task(lv_task_t * param)
 {
     (void)param;
 
-    lv_anim_t * a;
-    _LV_LL_READ(LV_GC_ROOT(_lv_anim_ll), a) {
-        a->has_run = 0;
-    }
+    /*Instead of clearing `has_run` of every animation start a new round*/
+    anim_round = anim_round ? 0 : 1;
 
     uint32_t elaps = lv_tick_elaps(last_task_run);
 
+    /*The `exec_cb`s typically move/resize objects: join their invalidated areas*/
+    _lv_inv_batch_begin();
+
+    lv_anim_t * a;
+
     a = _lv_ll_get_head(&LV_GC_ROOT(_lv_anim_ll));
 
     while(a != NULL) {
@@ -460,8 +466,8 @@ static void anim_task(lv_task_t * param)
          */
         anim_list_changed = false;
 
-        if(!a->has_run) {
-            a->has_run = 1; /*The list readying might be reseted so need to know which anim has run already*/
+        if(a->has_run != anim_round) {
+            a->has_run = anim_round; /*The list readying might be reseted so need to know which anim has run already*/
 
             /*The animation will run now for the first time. Call `start_cb`*/
             int32_t new_act_time = a->act_time + elaps;
@@ -472,9 +478,10 @@ static void anim_task(lv_task_t * param)
             if(a->act_time >= 0) {
                 if(a->act_time > a->time) a->act_time = a->time;
 
+                /*Call the default path directly, it can be inlined*/
                 int32_t new_value;
-                if(a->path.cb) new_value = a->path.cb(&a->path, a);
-                else new_value = lv_anim_path_linear(&a->path, a);
+                if(a->path.cb == NULL || a->path.cb == lv_anim_path_linear) new_value = lv_anim_path_linear(&a->path, a);
+                else new_value = a->path.cb(&a->path, a);
 
                 if(new_value != a->current) {
                     a->current = new_value;
@@ -497,6 +504,8 @@ static void anim_task(lv_task_t * param)
             a = _lv_ll_get_next(&LV_GC_ROOT(_lv_anim_ll), a);
     }
 
+    _lv_inv_batch_end();
+
     last_task_run = lv_tick_get();
 }
 
@@ -523,7 +532,7 @@ static bool anim_ready_handler(lv_anim_t * a)
         lv_anim_t a_tmp;
         _lv_memcpy(&a_tmp, a, sizeof(lv_anim_t));
         _lv_ll_remove(&LV_GC_ROOT(_lv_anim_ll), a);
-        lv_mem_free(a);
+        _lv_ll_free(a);
         /*Flag that the list has changed */
         anim_mark_list_change();
 
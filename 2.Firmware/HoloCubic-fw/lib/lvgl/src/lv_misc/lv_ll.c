@@ -2,6 +2,7 @@
  * @file lv_ll.c
  * Handle linked lists.
  * The nodes are dynamically allocated by the 'lv_mem' module,
+ * a few nodes of the same list at once in a chunk if `LV_LL_CHUNK_MAX > 1`.
  */
 
 /*********************
@@ -20,15 +21,33 @@
 #define LL_PREV_P_OFFSET(ll_p) (ll_p->n_size)
 #define LL_NEXT_P_OFFSET(ll_p) (ll_p->n_size + sizeof(lv_ll_node_t *))
 
+/*Every node is preceded by a pointer to its chunk (NULL: allocated alone)*/
+#define LL_CHUNK_P_SIZE sizeof(lv_ll_chunk_t *)
+#define LL_NODE_CHUNK(n) (((lv_ll_chunk_t **)(n))[-1])
+
 /**********************
  *      TYPEDEFS
  **********************/
 
+/**
+ * A block of `cap` nodes of the same size followed by the node slots.
+ * A new node is taken from the chunk of its neighbour in the list, so list traversal (children, tasks, anims)
+ * stays within a few cache lines and the heap sees one alloc per chunk. Freed when its last node is freed.
+ * 见_lv_ll_free：节点可以移到其他链表（_lv_ll_chg_list），块只按使用计数释放
+ */
+typedef struct {
+    uint32_t free;      /*Bit i: slot i is free*/
+    uint16_t stride;    /*Size of a slot: chunk pointer + node + meta*/
+    uint8_t cap;
+    uint8_t used;
+} lv_ll_chunk_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static void node_set_prev(lv_ll_t * ll_p, lv_ll_node_t * act, lv_ll_node_t * prev);
 static void node_set_next(lv_ll_t * ll_p, lv_ll_node_t * act, lv_ll_node_t * next);
+static lv_ll_node_t * node_alloc(lv_ll_t * ll_p, lv_ll_node_t * near);
 
 /**********************
  *  STATIC VARIABLES
@@ -71,7 +90,7 @@ void * _lv_ll_ins_head(lv_ll_t * ll_p)
 {
     lv_ll_node_t * n_new;
 
-    n_new = lv_mem_alloc(ll_p->n_size + LL_NODE_META_SIZE);
+    n_new = node_alloc(ll_p, ll_p->head);
 
     if(n_new != NULL) {
         node_set_prev(ll_p, n_new, NULL);       /*No prev. before the new head*/
@@ -107,7 +126,7 @@ void * _lv_ll_ins_prev(lv_ll_t * ll_p, void * n_act)
         if(n_new == NULL) return NULL;
     }
     else {
-        n_new = lv_mem_alloc(ll_p->n_size + LL_NODE_META_SIZE);
+        n_new = node_alloc(ll_p, n_act);
         if(n_new == NULL) return NULL;
 
         lv_ll_node_t * n_prev;
@@ -130,7 +149,7 @@ void * _lv_ll_ins_tail(lv_ll_t * ll_p)
 {
     lv_ll_node_t * n_new;
 
-    n_new = lv_mem_alloc(ll_p->n_size + LL_NODE_META_SIZE);
+    n_new = node_alloc(ll_p, ll_p->tail);
 
     if(n_new != NULL) {
         node_set_next(ll_p, n_new, NULL);       /*No next after the new tail*/
@@ -201,12 +220,33 @@ void _lv_ll_clear(lv_ll_t * ll_p)
         i_next = _lv_ll_get_next(ll_p, i);
 
         _lv_ll_remove(ll_p, i);
-        lv_mem_free(i);
+        _lv_ll_free(i);
 
         i = i_next;
     }
 }
 
+/**
+ * Free a node already removed from its linked list (don't use `lv_mem_free` on nodes)
+ * @param node_p pointer to a node returned by `_lv_ll_ins_head/prev/tail`
+ */
+void _lv_ll_free(void * node_p)
+{
+    if(node_p == NULL) return;
+
+    lv_ll_chunk_t * chunk = LL_NODE_CHUNK(node_p);
+    uint8_t * slot = (uint8_t *)node_p - LL_CHUNK_P_SIZE;
+    if(chunk == NULL) {
+        lv_mem_free(slot);
+        return;
+    }
+
+    uint32_t i = (uint32_t)(slot - (uint8_t *)(chunk + 1)) / chunk->stride;
+    chunk->free |= (uint32_t)1 << i;
+    chunk->used--;
+    if(chunk->used == 0) lv_mem_free(chunk);
+}
+
 /**
  * Move a node to a new linked list
  * @param ll_ori_p pointer to the original (old) linked list
@@ -384,6 +424,62 @@ bool _lv_ll_is_empty(lv_ll_t * ll_p)
  *   STATIC FUNCTIONS
  **********************/
 
+/**
+ * Allocate a node for `ll_p`, from the chunk of `near` (its neighbour after insertion) if it has a free slot.
+ * Otherwise a new chunk twice as large as the neighbour's is allocated (up to `LV_LL_CHUNK_MAX` nodes),
+ * so short lists cost one allocation per node and long ones get contiguous runs of nodes.
+ * The first node of a list is allocated alone.
+ * @param ll_p pointer to linked list
+ * @param near pointer to the node next to the new one or NULL if the list is empty
+ * @return pointer to the new node or NULL if out of memory
+ */
+static lv_ll_node_t * node_alloc(lv_ll_t * ll_p, lv_ll_node_t * near)
+{
+    uint32_t stride = LL_CHUNK_P_SIZE + ll_p->n_size + LL_NODE_META_SIZE;
+    lv_ll_chunk_t * chunk = near ? LL_NODE_CHUNK(near) : NULL;
+    uint8_t * slot;
+
+    if(chunk != NULL && chunk->free != 0 && chunk->stride == stride) {
+        uint32_t i = 0;
+        while((chunk->free & ((uint32_t)1 << i)) == 0) i++;
+        chunk->free &= ~((uint32_t)1 << i);
+        chunk->used++;
+        slot = (uint8_t *)(chunk + 1) + i * stride;
+    }
+    else {
+        uint32_t cap = 1;
+        if(near != NULL) cap = chunk ? chunk->cap * 2 : 2;
+        if(cap > LV_LL_CHUNK_MAX) cap = LV_LL_CHUNK_MAX;
+        if(cap > 32) cap = 32;
+        if(stride > UINT16_MAX) cap = 1;
+
+        if(cap <= 1) {
+            slot = lv_mem_alloc(stride);
+            if(slot == NULL) return NULL;
+            chunk = NULL;
+        }
+        else {
+            chunk = lv_mem_alloc(sizeof(lv_ll_chunk_t) + cap * stride);
+            if(chunk == NULL) {
+                /*Not enough memory for a chunk: try a single node*/
+                slot = lv_mem_alloc(stride);
+                if(slot == NULL) return NULL;
+            }
+            else {
+                chunk->cap = cap;
+                chunk->stride = stride;
+                chunk->used = 1;
+                chunk->free = (cap == 32 ? 0xFFFFFFFF : (((uint32_t)1 << cap) - 1)) & ~(uint32_t)1;
+                slot = (uint8_t *)(chunk + 1);
+            }
+        }
+    }
+
+    lv_ll_node_t * node = slot + LL_CHUNK_P_SIZE;
+    LL_NODE_CHUNK(node) = chunk;
+    return node;
+}
+
 /**
  * Set the previous node pointer of a node
  * @param ll_p pointer to linked list
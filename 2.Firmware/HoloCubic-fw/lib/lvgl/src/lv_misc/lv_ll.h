@@ -22,6 +22,11 @@ extern "C" {
  *      DEFINES
  *********************/
 
+/*Max. number of nodes allocated together in one chunk (1: every node is allocated alone)*/
+#ifndef LV_LL_CHUNK_MAX
+#define LV_LL_CHUNK_MAX 1
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -77,6 +82,12 @@ void * _lv_ll_ins_tail(lv_ll_t * ll_p);
  */
 void _lv_ll_remove(lv_ll_t * ll_p, void * node_p);
 
+/**
+ * Free a node already removed from its linked list (don't use `lv_mem_free` on nodes)
+ * @param node_p pointer to a node returned by `_lv_ll_ins_head/prev/tail`
+ */
+void _lv_ll_free(void * node_p);
+
 /**
  * Remove and free all elements from a linked list. The list remain valid but become empty.
  * @param ll_p pointer to linked list
@@ -449,6 +449,8 @@ void lv_mem_monitor(lv_mem_monitor_t * mon_p)
     else {
         mon_p->frag_pct   = 0; /*no fragmentation if all the RAM is used*/
     }
+#elif defined(LV_MEM_CUSTOM_MONITOR)
+    LV_MEM_CUSTOM_MONITOR(mon_p);
 #endif
 }
 
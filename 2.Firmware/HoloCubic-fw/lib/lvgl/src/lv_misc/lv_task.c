@@ -2,6 +2,11 @@
  * @file lv_task.c
  * An 'lv_task'  is a void (*fp) (void* param) type function which will be called periodically.
  * A priority (5 levels + disable) can be assigned to lv_tasks.
+ *
+ * The tasks waiting for their period are kept in a min-heap ordered by deadline
+ * (`last_run + period`), so `lv_task_handler` only looks at the tasks which are due.
+ * Due tasks are moved to a second heap ordered by priority and run from the highest priority.
+ * Deadlines are compared with wrap-around arithmetic, so periods must be less than 2^31 ms.
  */
 
 /*********************
@@ -23,16 +28,31 @@
 #define IDLE_MEAS_PERIOD 500 /*[ms]*/
 #define DEF_PRIO LV_TASK_PRIO_MID
 #define DEF_PERIOD 500
+#define HEAP_INIT_SIZE 8 /*Initial capacity of the task heaps*/
 
 /**********************
  *      TYPEDEFS
  **********************/
+typedef bool (*lv_task_before_t)(const lv_task_t * a, const lv_task_t * b);
+
+typedef struct {
+    lv_task_t ** items;
+    uint32_t cnt;
+    lv_task_before_t before; /*true if `a` has to be closer to the root than `b`*/
+    uint8_t id;              /*_LV_TASK_HEAP_...*/
+} lv_task_heap_t;
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
-static bool lv_task_exec(lv_task_t * task);
+static void lv_task_exec(lv_task_t * task);
 static uint32_t lv_task_time_remaining(lv_task_t * task);
+static bool wait_before(const lv_task_t * a, const lv_task_t * b);
+static bool ready_before(const lv_task_t * a, const lv_task_t * b);
+static void heap_push(lv_task_heap_t * h, lv_task_t * task);
+static void heap_remove(lv_task_heap_t * h, lv_task_t * task);
+static void task_schedule(lv_task_t * task);
+static void task_unlink(lv_task_t * task);
 
 /**********************
  *  STATIC VARIABLES
@@ -40,8 +60,10 @@ static uint32_t lv_task_time_remaining(lv_task_t * task);
 static bool lv_task_run  = false;
 static uint8_t idle_last = 0;
 static bool task_deleted;
-static bool task_list_changed;
-static bool task_created;
+static lv_task_heap_t wait_heap;
+static lv_task_heap_t ready_heap;
+static uint32_t heap_size; /*Capacity of both heaps*/
+static uint32_t task_cnt;
 
 /**********************
  *      MACROS
@@ -58,7 +80,17 @@ void _lv_task_core_init(void)
 {
     _lv_ll_init(&LV_GC_ROOT(_lv_task_ll), sizeof(lv_task_t));
 
-    task_list_changed = false;
+    wait_heap.items = NULL;
+    wait_heap.cnt = 0;
+    wait_heap.before = wait_before;
+    wait_heap.id = _LV_TASK_HEAP_WAIT;
+    ready_heap.items = NULL;
+    ready_heap.cnt = 0;
+    ready_heap.before = ready_before;
+    ready_heap.id = _LV_TASK_HEAP_READY;
+    heap_size = 0;
+    task_cnt = 0;
+
     /*Initially enable the lv_task handling*/
     lv_task_enable(true);
 }
@@ -90,80 +122,25 @@ LV_ATTRIBUTE_TASK_HANDLER uint32_t lv_task_handler(void)
 
     handler_start = lv_tick_get();
 
-    /* Run all task from the highest to the lowest priority
-     * If a lower priority task is executed check task again from the highest priority
-     * but on the priority of executed tasks don't run tasks before the executed*/
-    lv_task_t * task_interrupter = NULL;
-    lv_task_t * next;
-    bool end_flag;
-    do {
-        end_flag                 = true;
-        task_deleted             = false;
-        task_created             = false;
-        LV_GC_ROOT(_lv_task_act) = _lv_ll_get_head(&LV_GC_ROOT(_lv_task_ll));
-        while(LV_GC_ROOT(_lv_task_act)) {
-            /* The task might be deleted if it runs only once ('once = 1')
-             * So get next element until the current is surely valid*/
-            next = _lv_ll_get_next(&LV_GC_ROOT(_lv_task_ll), LV_GC_ROOT(_lv_task_act));
-
-            /*We reach priority of the turned off task. There is nothing more to do.*/
-            if(((lv_task_t *)LV_GC_ROOT(_lv_task_act))->prio == LV_TASK_PRIO_OFF) {
-                break;
-            }
-
-            /*Here is the interrupter task. Don't execute it again.*/
-            if(LV_GC_ROOT(_lv_task_act) == task_interrupter) {
-                task_interrupter = NULL; /*From this point only task after the interrupter comes, so
-                                            the interrupter is not interesting anymore*/
-                LV_GC_ROOT(_lv_task_act) = next;
-                continue; /*Load the next task*/
-            }
-
-            /*Just try to run the tasks with highest priority.*/
-            if(((lv_task_t *)LV_GC_ROOT(_lv_task_act))->prio == LV_TASK_PRIO_HIGHEST) {
-                lv_task_exec(LV_GC_ROOT(_lv_task_act));
-            }
-            /*Tasks with higher priority than the interrupted shall be run in every case*/
-            else if(task_interrupter) {
-                if(((lv_task_t *)LV_GC_ROOT(_lv_task_act))->prio > task_interrupter->prio) {
-                    if(lv_task_exec(LV_GC_ROOT(_lv_task_act))) {
-                        if(!task_created && !task_deleted) {
-                            /*Check all tasks again from the highest priority */
-                            task_interrupter = LV_GC_ROOT(_lv_task_act);
-                            end_flag = false;
-                            break;
-                        }
-                    }
-                }
-            }
-            /* It is no interrupter task or we already reached it earlier.
-             * Just run the remaining tasks*/
-            else {
-                if(lv_task_exec(LV_GC_ROOT(_lv_task_act))) {
-                    if(!task_created && !task_deleted) {
-                        task_interrupter = LV_GC_ROOT(_lv_task_act); /*Check all tasks again from the highest priority */
-                        end_flag         = false;
-                        break;
-                    }
-                }
-            }
-
-            /*If a task was created or deleted then this or the next item might be corrupted*/
-            if(task_created || task_deleted) {
-                task_interrupter = NULL;
-                break;
-            }
-
-            if(task_list_changed) {
-                task_interrupter = NULL;
-                end_flag = false;
-                task_list_changed = false;
-                break;
-            }
-
-            LV_GC_ROOT(_lv_task_act) = next; /*Load the next task*/
+    /* Move the due tasks to the ready heap and run the one with the highest priority.
+     * Check the deadlines again after every task because running a task takes time
+     * and a higher priority task might become due meanwhile.
+     * Run at most as many tasks as existed at start to return even if
+     * a task with 0 period is always ready.*/
+    uint32_t budget = task_cnt;
+    while(budget > 0) {
+        while(wait_heap.cnt > 0 && lv_task_time_remaining(wait_heap.items[0]) == 0) {
+            lv_task_t * due = wait_heap.items[0];
+            heap_remove(&wait_heap, due);
+            heap_push(&ready_heap, due);
         }
-    } while(!end_flag);
+        if(ready_heap.cnt == 0) break;
+
+        lv_task_t * task = ready_heap.items[0];
+        heap_remove(&ready_heap, task);
+        lv_task_exec(task);
+        budget--;
+    }
 
     busy_time += lv_tick_elaps(handler_start);
     uint32_t idle_period_time = lv_tick_elaps(idle_period_start);
@@ -175,17 +152,7 @@ LV_ATTRIBUTE_TASK_HANDLER uint32_t lv_task_handler(void)
         idle_period_start = lv_tick_get();
     }
 
-    time_till_next = LV_NO_TASK_READY;
-    next = _lv_ll_get_head(&LV_GC_ROOT(_lv_task_ll));
-    while(next) {
-        if(next->prio != LV_TASK_PRIO_OFF) {
-            uint32_t delay = lv_task_time_remaining(next);
-            if(delay < time_till_next)
-                time_till_next = delay;
-        }
-
-        next = _lv_ll_get_next(&LV_GC_ROOT(_lv_task_ll), next); /*Find the next task*/
-    }
+    time_till_next = lv_task_get_time_till_next();
 
     already_running = false; /*Release the mutex*/
 
@@ -202,6 +169,21 @@ lv_task_t * lv_task_create_basic(void)
     lv_task_t * new_task = NULL;
     lv_task_t * tmp;
 
+    /*Reserve place in both heaps now so scheduling never needs to allocate*/
+    if(task_cnt >= heap_size) {
+        uint32_t new_size = heap_size ? heap_size * 2 : HEAP_INIT_SIZE;
+        if(new_size > UINT16_MAX) return NULL;
+        lv_task_t ** items = lv_mem_realloc(wait_heap.items, new_size * sizeof(lv_task_t *));
+        LV_ASSERT_MEM(items);
+        if(items == NULL) return NULL;
+        wait_heap.items = items;
+        items = lv_mem_realloc(ready_heap.items, new_size * sizeof(lv_task_t *));
+        LV_ASSERT_MEM(items);
+        if(items == NULL) return NULL;
+        ready_heap.items = items;
+        heap_size = new_size;
+    }
+
     /*Create task lists in order of priority from high to low*/
     tmp = _lv_ll_get_head(&LV_GC_ROOT(_lv_task_ll));
 
@@ -230,8 +212,6 @@ lv_task_t * lv_task_create_basic(void)
             if(new_task == NULL) return NULL;
         }
     }
-    task_list_changed = true;
-
     new_task->period  = DEF_PERIOD;
     new_task->task_cb = NULL;
     new_task->prio    = DEF_PRIO;
@@ -241,7 +221,9 @@ lv_task_t * lv_task_create_basic(void)
 
     new_task->user_data = NULL;
 
-    task_created = true;
+    new_task->heap = _LV_TASK_HEAP_NONE;
+    task_cnt++;
+    task_schedule(new_task);
 
     return new_task;
 }
@@ -286,10 +268,11 @@ void lv_task_set_cb(lv_task_t * task, lv_task_cb_t task_cb)
  */
 void lv_task_del(lv_task_t * task)
 {
+    task_unlink(task);
     _lv_ll_remove(&LV_GC_ROOT(_lv_task_ll), task);
-    task_list_changed = true;
+    task_cnt--;
 
-    lv_mem_free(task);
+    _lv_ll_free(task);
 
     if(LV_GC_ROOT(_lv_task_act) == task) task_deleted = true; /*The active task was deleted*/
 }
@@ -316,9 +299,9 @@ void lv_task_set_prio(lv_task_t * task, lv_task_prio_t prio)
     if(i == NULL) {
         _lv_ll_move_before(&LV_GC_ROOT(_lv_task_ll), task, NULL);
     }
-    task_list_changed = true;
 
     task->prio = prio;
+    task_schedule(task);
 }
 
 /**
@@ -328,7 +311,9 @@ void lv_task_set_prio(lv_task_t * task, lv_task_prio_t prio)
  */
 void lv_task_set_period(lv_task_t * task, uint32_t period)
 {
+    if(task->period == period) return;
     task->period = period;
+    task_schedule(task);
 }
 
 /**
@@ -338,6 +323,7 @@ void lv_task_set_period(lv_task_t * task, uint32_t period)
 void lv_task_ready(lv_task_t * task)
 {
     task->last_run = lv_tick_get() - task->period - 1;
+    task_schedule(task);
 }
 
 /**
@@ -358,6 +344,7 @@ void lv_task_set_repeat_count(lv_task_t * task, int32_t repeat_count)
 void lv_task_reset(lv_task_t * task)
 {
     task->last_run = lv_tick_get();
+    task_schedule(task);
 }
 
 /**
@@ -378,6 +365,17 @@ uint8_t lv_task_get_idle(void)
     return idle_last;
 }
 
+/**
+ * Get the time until the next task has to run.
+ * @return the time in ms, 0 if a task is ready or LV_NO_TASK_READY if every task is turned off
+ */
+uint32_t lv_task_get_time_till_next(void)
+{
+    if(ready_heap.cnt > 0) return 0;
+    if(wait_heap.cnt == 0) return LV_NO_TASK_READY;
+    return lv_task_time_remaining(wait_heap.items[0]);
+}
+
 /**
  * Iterate through the tasks
  * @param task NULL to start iteration or the previous return value to get the next task
@@ -394,33 +392,32 @@ lv_task_t * lv_task_get_next(lv_task_t * task)
  **********************/
 
 /**
- * Execute task if its the priority is appropriate
+ * Execute a task taken from the ready heap and put it back to the wait heap
  * @param task pointer to lv_task
- * @return true: execute, false: not executed
  */
-static bool lv_task_exec(lv_task_t * task)
+static void lv_task_exec(lv_task_t * task)
 {
-    bool exec = false;
-
-    if(lv_task_time_remaining(task) == 0) {
-        task->last_run = lv_tick_get();
-        task_deleted   = false;
-        task_created   = false;
-        if(task->task_cb) task->task_cb(task);
-
-        /*Delete if it was a one shot lv_task*/
-        if(task_deleted == false) { /*The task might be deleted by itself as well*/
-            if(task->repeat_count > 0) {
-                task->repeat_count--;
-            }
-            if(task->repeat_count == 0) {
-                lv_task_del(task);
-            }
+    LV_GC_ROOT(_lv_task_act) = task;
+    task->heap     = _LV_TASK_HEAP_RUN;
+    task->last_run = lv_tick_get();
+    task_deleted   = false;
+    if(task->task_cb) task->task_cb(task);
+
+    /*Delete if it was a one shot lv_task*/
+    if(task_deleted == false) { /*The task might be deleted by itself as well*/
+        if(task->repeat_count > 0) {
+            task->repeat_count--;
+        }
+        if(task->repeat_count == 0) {
+            lv_task_del(task);
+        }
+        else {
+            /*The callback might have changed the period or the priority: schedule with the current values*/
+            task->heap = _LV_TASK_HEAP_NONE;
+            task_schedule(task);
         }
-        exec = true;
     }
-
-    return exec;
+    LV_GC_ROOT(_lv_task_act) = NULL;
 }
 
 /**
@@ -436,3 +433,102 @@ static uint32_t lv_task_time_remaining(lv_task_t * task)
         return 0;
     return task->period - elp;
 }
+
+/**
+ * Ordering of the wait heap: earlier deadline first, higher priority on equal deadlines
+ */
+static bool wait_before(const lv_task_t * a, const lv_task_t * b)
+{
+    int32_t d = (int32_t)((a->last_run + a->period) - (b->last_run + b->period));
+    if(d != 0) return d < 0;
+    return a->prio > b->prio;
+}
+
+/**
+ * Ordering of the ready heap: higher priority first, earlier deadline on equal priorities
+ */
+static bool ready_before(const lv_task_t * a, const lv_task_t * b)
+{
+    if(a->prio != b->prio) return a->prio > b->prio;
+    return (int32_t)((a->last_run + a->period) - (b->last_run + b->period)) < 0;
+}
+
+static void heap_place(lv_task_heap_t * h, uint32_t i, lv_task_t * task)
+{
+    h->items[i]    = task;
+    task->heap_pos = i;
+}
+
+static void heap_sift_up(lv_task_heap_t * h, uint32_t i)
+{
+    lv_task_t * task = h->items[i];
+    while(i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if(!h->before(task, h->items[parent])) break;
+        heap_place(h, i, h->items[parent]);
+        i = parent;
+    }
+    heap_place(h, i, task);
+}
+
+static void heap_sift_down(lv_task_heap_t * h, uint32_t i)
+{
+    lv_task_t * task = h->items[i];
+    while(1) {
+        uint32_t child = 2 * i + 1;
+        if(child >= h->cnt) break;
+        if(child + 1 < h->cnt && h->before(h->items[child + 1], h->items[child])) child++;
+        if(!h->before(h->items[child], task)) break;
+        heap_place(h, i, h->items[child]);
+        i = child;
+    }
+    heap_place(h, i, task);
+}
+
+/**
+ * Add a task to a heap. The place is reserved in `lv_task_create_basic`.
+ */
+static void heap_push(lv_task_heap_t * h, lv_task_t * task)
+{
+    task->heap = h->id;
+    heap_place(h, h->cnt, task);
+    h->cnt++;
+    heap_sift_up(h, h->cnt - 1);
+}
+
+/**
+ * Remove a task from any position of its heap
+ */
+static void heap_remove(lv_task_heap_t * h, lv_task_t * task)
+{
+    uint32_t i = task->heap_pos;
+    task->heap = _LV_TASK_HEAP_NONE;
+    h->cnt--;
+    if(i == h->cnt) return;
+
+    /*Move the last item to the hole and restore the heap order around it*/
+    lv_task_t * last = h->items[h->cnt];
+    heap_place(h, i, last);
+    heap_sift_up(h, i);
+    if(last->heap_pos == i) heap_sift_down(h, i);
+}
+
+/**
+ * Remove a task from the heap holding it (if any)
+ */
+static void task_unlink(lv_task_t * task)
+{
+    if(task->heap == _LV_TASK_HEAP_WAIT) heap_remove(&wait_heap, task);
+    else if(task->heap == _LV_TASK_HEAP_READY) heap_remove(&ready_heap, task);
+}
+
+/**
+ * Put a task to the wait heap according to its current period, last run and priority.
+ * A running task is scheduled by `lv_task_exec` when its callback returns.
+ */
+static void task_schedule(lv_task_t * task)
+{
+    if(task->heap == _LV_TASK_HEAP_RUN) return;
+    task_unlink(task);
+    if(task->prio != LV_TASK_PRIO_OFF) heap_push(&wait_heap, task);
+}
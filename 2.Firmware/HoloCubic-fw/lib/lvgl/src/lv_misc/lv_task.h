@@ -54,6 +54,16 @@ enum {
 };
 typedef uint8_t lv_task_prio_t;
 
+/**
+ * Which scheduler heap holds a task (internal)
+ */
+enum {
+    _LV_TASK_HEAP_NONE = 0, /**< Turned off (LV_TASK_PRIO_OFF) */
+    _LV_TASK_HEAP_WAIT,     /**< Waiting for its period, ordered by deadline */
+    _LV_TASK_HEAP_READY,    /**< Period elapsed, ordered by priority */
+    _LV_TASK_HEAP_RUN,      /**< Its callback is running right now */
+};
+
 /**
  * Descriptor of a lv_task
  */
@@ -66,6 +76,8 @@ typedef struct _lv_task_t {
 
     int32_t repeat_count; /**< 1: Task times;  -1 : infinity;  0 : stop ;  n>0: residual times */
     uint8_t prio : 3; /**< Task priority */
+    uint8_t heap : 2; /**< Scheduler heap holding the task (internal) */
+    uint16_t heap_pos; /**< Index in that heap (internal) */
 } lv_task_t;
 
 /**********************
@@ -165,6 +177,14 @@ void lv_task_enable(bool en);
  */
 uint8_t lv_task_get_idle(void);
 
+/**
+ * Get the time until the next task has to run.
+ * Kept up to date by every task function, so it is valid also after tasks were
+ * created or reset outside of `lv_task_handler`.
+ * @return the time in ms, 0 if a task is ready or LV_NO_TASK_READY if every task is turned off
+ */
+uint32_t lv_task_get_time_till_next(void);
+
 /**
  * Iterate through the tasks
  * @param task NULL to start iteration or the previous return value to get the next task
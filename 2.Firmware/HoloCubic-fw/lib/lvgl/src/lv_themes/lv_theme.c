@@ -43,6 +43,7 @@ static lv_theme_t * act_theme;
 void lv_theme_set_act(lv_theme_t * th)
 {
     act_theme = th;
+    _lv_style_mark_changed();   /*The default fonts might be different*/
 }
 
 /**
@@ -189,7 +189,7 @@ lv_chart_series_t * lv_chart_add_series(lv_obj_t * chart, lv_color_t color)
     LV_ASSERT_MEM(ser->points);
     if(ser->points == NULL) {
         _lv_ll_remove(&ext->series_ll, ser);
-        lv_mem_free(ser);
+        _lv_ll_free(ser);
         return NULL;
     }
 
@@ -223,7 +223,7 @@ void lv_chart_remove_series(lv_obj_t * chart, lv_chart_series_t * series)
     if(!series->ext_buf_assigned && series->points) lv_mem_free(series->points);
 
     _lv_ll_remove(&ext->series_ll, series);
-    lv_mem_free(series);
+    _lv_ll_free(series);
 
     return;
 }
@@ -1004,7 +1004,7 @@ static lv_res_t lv_chart_signal(lv_obj_t * chart, lv_signal_t sign, void * param
             if(!ser->ext_buf_assigned) lv_mem_free(ser->points);
 
             _lv_ll_remove(&ext->series_ll, ser);
-            lv_mem_free(ser);
+            _lv_ll_free(ser);
         }
         _lv_ll_clear(&ext->series_ll);
 
@@ -1861,7 +1861,7 @@ static void invalidate_columns(lv_obj_t * chart, uint16_t i)
     col_a.x1 = x_act;
     col_a.x2 = col_a.x1 + col_w;
 
-    _lv_inv_area(lv_obj_get_disp(chart), &col_a);
+    lv_obj_invalidate_area(chart, &col_a);
 }
 
 #endif
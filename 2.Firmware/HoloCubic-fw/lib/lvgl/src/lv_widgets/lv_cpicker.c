@@ -16,6 +16,7 @@
 #include "../lv_core/lv_indev.h"
 #include "../lv_core/lv_refr.h"
 #include "../lv_misc/lv_math.h"
+#include "../lv_draw/lv_draw_blend.h"
 
 /*********************
  *      DEFINES
@@ -55,10 +56,43 @@
  */
 #define OUTER_MASK_WIDTH 3
 
+#if LV_CPICKER_RING_CACHE
+    #ifdef LV_CPICKER_CACHE_ALLOC_INCLUDE
+        #include LV_CPICKER_CACHE_ALLOC_INCLUDE
+    #endif
+    #ifndef LV_CPICKER_CACHE_ALLOC
+        #define LV_CPICKER_CACHE_ALLOC(size) lv_mem_alloc(size)
+        #define LV_CPICKER_CACHE_FREE(p)     lv_mem_free(p)
+    #endif
+    /*One palette entry for each line the uncached ring would draw*/
+    #define RING_STEPS (360 / LV_CPICKER_DEF_QF + 1)
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
 
+#if LV_CPICKER_RING_CACHE
+/*The ring pixels of a row: a left span and its horizontal mirror, or one span where the ring has no hole*/
+typedef struct {
+    uint32_t ofs;       /*Index of the row's first pixel in `px`*/
+    lv_coord_t x;       /*First pixel of the left span, relative to the object*/
+    lv_coord_t len;     /*Length of the left span (the right span has the same length)*/
+    uint8_t single;     /*1: the row is one span of `len` pixels*/
+} ring_row_t;
+
+typedef struct {
+    lv_coord_t size;                    /*Geometry the pixels were computed for*/
+    lv_coord_t scale_w;
+    lv_color_hsv_t hsv;                 /*Colors the palette was computed for*/
+    uint8_t color_mode;
+    uint8_t palette_valid;
+    lv_color_t palette[RING_STEPS];
+    ring_row_t * rows;
+    uint8_t * px;                       /*2 bytes per ring pixel: palette index, coverage*/
+} ring_cache_t;
+#endif
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -78,6 +112,13 @@ static lv_res_t double_click_reset(lv_obj_t * cpicker);
 static void refr_knob_pos(lv_obj_t * cpicker);
 static lv_color_t angle_to_mode_color(lv_obj_t * cpicker, uint16_t angle);
 static uint16_t get_angle(lv_obj_t * cpicker);
+#if LV_CPICKER_RING_CACHE
+    static bool draw_ring_cached(lv_obj_t * cpicker, const lv_area_t * mask, const lv_draw_line_dsc_t * line_dsc);
+    static ring_cache_t * ring_cache_get(lv_obj_t * cpicker);
+    static void ring_cache_free(lv_obj_t * cpicker);
+    static bool ring_colors_changed(lv_cpicker_color_mode_t mode, const lv_color_hsv_t * old, const lv_color_hsv_t * hsv);
+    static void invalidate_center(lv_obj_t * cpicker);
+#endif
 
 /**********************
  *  STATIC VARIABLES
@@ -126,6 +167,9 @@ lv_obj_t * lv_cpicker_create(lv_obj_t * par, const lv_obj_t * copy)
     ext->color_mode_fixed = 0;
     ext->last_click_time = 0;
     ext->last_change_time = 0;
+#if LV_CPICKER_RING_CACHE
+    ext->ring_cache = NULL;
+#endif
 
     lv_style_list_init(&ext->knob.style_list);
 
@@ -177,6 +221,9 @@ void lv_cpicker_set_type(lv_obj_t * cpicker, lv_cpicker_type_t type)
     if(ext->type == type) return;
 
     ext->type = type;
+#if LV_CPICKER_RING_CACHE
+    ring_cache_free(cpicker);
+#endif
     lv_obj_refresh_ext_draw_pad(cpicker);
     refr_knob_pos(cpicker);
 
@@ -240,10 +287,21 @@ bool lv_cpicker_set_hsv(lv_obj_t * cpicker, lv_color_hsv_t hsv)
 
     if(ext->hsv.h == hsv.h && ext->hsv.s == hsv.s && ext->hsv.v == hsv.v) return false;
 
+#if LV_CPICKER_RING_CACHE
+    lv_color_hsv_t old = ext->hsv;
+#endif
     ext->hsv = hsv;
 
     refr_knob_pos(cpicker);
 
+#if LV_CPICKER_RING_CACHE
+    /*The ring looks the same: only the knob (invalidated above) and the center change*/
+    if(ext->type == LV_CPICKER_TYPE_DISC && !ring_colors_changed(ext->color_mode, &old, &hsv)) {
+        invalidate_center(cpicker);
+        return true;
+    }
+#endif
+
     lv_obj_invalidate(cpicker);
 
     return true;
@@ -488,34 +546,41 @@ static void draw_disc_grad(lv_obj_t * cpicker, const lv_area_t * mask)
     uint16_t i;
     lv_coord_t cir_w = lv_obj_get_style_scale_width(cpicker, LV_CPICKER_PART_MAIN);
 
-    /* Mask outer ring of widget to tidy up ragged edges of lines while drawing outer ring */
-    lv_area_t mask_area_out;
-    lv_area_copy(&mask_area_out, &cpicker->coords);
-    mask_area_out.x1 += OUTER_MASK_WIDTH;
-    mask_area_out.x2 -= OUTER_MASK_WIDTH;
-    mask_area_out.y1 += OUTER_MASK_WIDTH;
-    mask_area_out.y2 -= OUTER_MASK_WIDTH;
-    lv_draw_mask_radius_param_t mask_out_param;
-    lv_draw_mask_radius_init(&mask_out_param, &mask_area_out, LV_RADIUS_CIRCLE, false);
-    int16_t mask_out_id = lv_draw_mask_add(&mask_out_param, 0);
-
-    /* The inner line ends will be masked out.
-     * So make lines a little bit longer because the masking makes a more even result */
-    lv_coord_t cir_w_extra = cir_w + line_dsc.width;
-
-    for(i = 0; i <= 360; i += LV_CPICKER_DEF_QF) {
-        line_dsc.color = angle_to_mode_color(cpicker, i);
-
-        lv_point_t p[2];
-        p[0].x = cx + (r * _lv_trigo_sin(i) >> LV_TRIGO_SHIFT);
-        p[0].y = cy + (r * _lv_trigo_sin(i + 90) >> LV_TRIGO_SHIFT);
-        p[1].x = cx + ((r - cir_w_extra) * _lv_trigo_sin(i) >> LV_TRIGO_SHIFT);
-        p[1].y = cy + ((r - cir_w_extra) * _lv_trigo_sin(i + 90) >> LV_TRIGO_SHIFT);
-
-        lv_draw_line(&p[0], &p[1], mask, &line_dsc);
+#if LV_CPICKER_RING_CACHE
+    bool cached = draw_ring_cached(cpicker, mask, &line_dsc);
+#else
+    bool cached = false;
+#endif
+    if(!cached) {
+        /* Mask outer ring of widget to tidy up ragged edges of lines while drawing outer ring */
+        lv_area_t mask_area_out;
+        lv_area_copy(&mask_area_out, &cpicker->coords);
+        mask_area_out.x1 += OUTER_MASK_WIDTH;
+        mask_area_out.x2 -= OUTER_MASK_WIDTH;
+        mask_area_out.y1 += OUTER_MASK_WIDTH;
+        mask_area_out.y2 -= OUTER_MASK_WIDTH;
+        lv_draw_mask_radius_param_t mask_out_param;
+        lv_draw_mask_radius_init(&mask_out_param, &mask_area_out, LV_RADIUS_CIRCLE, false);
+        int16_t mask_out_id = lv_draw_mask_add(&mask_out_param, 0);
+
+        /* The inner line ends will be masked out.
+         * So make lines a little bit longer because the masking makes a more even result */
+        lv_coord_t cir_w_extra = cir_w + line_dsc.width;
+
+        for(i = 0; i <= 360; i += LV_CPICKER_DEF_QF) {
+            line_dsc.color = angle_to_mode_color(cpicker, i);
+
+            lv_point_t p[2];
+            p[0].x = cx + (r * _lv_trigo_sin(i) >> LV_TRIGO_SHIFT);
+            p[0].y = cy + (r * _lv_trigo_sin(i + 90) >> LV_TRIGO_SHIFT);
+            p[1].x = cx + ((r - cir_w_extra) * _lv_trigo_sin(i) >> LV_TRIGO_SHIFT);
+            p[1].y = cy + ((r - cir_w_extra) * _lv_trigo_sin(i + 90) >> LV_TRIGO_SHIFT);
+
+            lv_draw_line(&p[0], &p[1], mask, &line_dsc);
+        }
+        /* Now remove mask to continue with inner part */
+        lv_draw_mask_remove_id(mask_out_id);
     }
-    /* Now remove mask to continue with inner part */
-    lv_draw_mask_remove_id(mask_out_id);
 
     /*Mask out the inner area*/
     lv_draw_rect_dsc_t bg_dsc;
@@ -685,6 +750,9 @@ static lv_res_t lv_cpicker_signal(lv_obj_t * cpicker, lv_signal_t sign, void * p
 
     if(sign == LV_SIGNAL_CLEANUP) {
         lv_obj_clean_style_list(cpicker, LV_CPICKER_PART_KNOB);
+#if LV_CPICKER_RING_CACHE
+        ring_cache_free(cpicker);
+#endif
     }
     else if(sign == LV_SIGNAL_REFR_EXT_DRAW_PAD) {
         lv_style_int_t left = lv_obj_get_style_pad_left(cpicker, LV_CPICKER_PART_KNOB);
@@ -1036,4 +1104,210 @@ static uint16_t get_angle(lv_obj_t * cpicker)
     return angle;
 }
 
+#if LV_CPICKER_RING_CACHE
+
+/**
+ * Coverage of a ring pixel (0: not on the ring)
+ * The outer edge follows the mask of the uncached drawing, the inner edge is 2 px under
+ * the center circle so that its anti-aliased edge is drawn on the ring.
+ */
+static lv_opa_t ring_px_opa(lv_coord_t size, lv_coord_t x, lv_coord_t y, int32_t r_out, int32_t r_in)
+{
+    int32_t dx = 2 * x - (size - 1);
+    int32_t dy = 2 * y - (size - 1);
+    lv_sqrt_res_t q;
+    _lv_sqrt(dx * dx + dy * dy, &q, 0x8000);
+    int32_t d = ((q.i << 8) + q.f) / 2; /*Distance from the center [1/256 px]*/
+
+    int32_t cov = LV_MATH_MIN(r_out + 128 - d, d - r_in + 128);
+    if(cov <= 0) return 0;
+    return cov >= 255 ? LV_OPA_COVER : cov;
+}
+
+static uint8_t ring_px_index(lv_coord_t size, lv_coord_t x, lv_coord_t y)
+{
+    int32_t dx = 2 * x - (size - 1);
+    int32_t dy = 2 * y - (size - 1);
+    if(dx == 0 && dy == 0) return 0;
+    uint16_t idx = (_lv_atan2(dx, dy) + LV_CPICKER_DEF_QF / 2) / LV_CPICKER_DEF_QF;
+    return LV_MATH_MIN(idx, RING_STEPS - 1);
+}
+
+/**
+ * Get the ring cache, (re)building it if the size or the ring width changed
+ * @return NULL if the object is not square or out of memory (draw with lines then)
+ */
+static ring_cache_t * ring_cache_get(lv_obj_t * cpicker)
+{
+    lv_cpicker_ext_t * ext = lv_obj_get_ext_attr(cpicker);
+    lv_coord_t size = lv_obj_get_width(cpicker);
+    lv_coord_t scale_w = lv_obj_get_style_scale_width(cpicker, LV_CPICKER_PART_MAIN);
+
+    ring_cache_t * c = ext->ring_cache;
+    if(c && c->size == size && c->scale_w == scale_w) return c;
+    ring_cache_free(cpicker);
+    if(size != lv_obj_get_height(cpicker) || size <= 2 * OUTER_MASK_WIDTH) return NULL;
+
+    int32_t r_out = (int32_t)(size - 2 * OUTER_MASK_WIDTH) * 128;
+    int32_t r_in = LV_MATH_MAX((int32_t)(size - 2 * scale_w - 4) * 128, 0);
+
+    /*First pass: the spans of every row (left half only, the ring is symmetric)*/
+    ring_row_t * rows = lv_mem_alloc(size * sizeof(ring_row_t));
+    LV_ASSERT_MEM(rows);
+    if(rows == NULL) return NULL;
+
+    lv_coord_t half = (size + 1) / 2;
+    uint32_t px_cnt = 0;
+    lv_coord_t x, y;
+    for(y = 0; y < size; y++) {
+        ring_row_t * row = &rows[y];
+        for(x = 0; x < half && ring_px_opa(size, x, y, r_out, r_in) == 0; x++);
+        row->x = x;
+        for(; x < half && ring_px_opa(size, x, y, r_out, r_in) != 0; x++);
+        row->ofs = px_cnt;
+        row->single = x >= half && row->x < half;
+        row->len = row->single ? size - 2 * row->x : x - row->x;
+        px_cnt += row->single ? row->len : 2 * row->len;
+    }
+
+    c = LV_CPICKER_CACHE_ALLOC(sizeof(ring_cache_t) + size * sizeof(ring_row_t) + px_cnt * 2);
+    if(c == NULL) {
+        LV_LOG_WARN("lv_cpicker: no memory for the ring cache, drawing with lines");
+        lv_mem_free(rows);
+        return NULL;
+    }
+    c->size = size;
+    c->scale_w = scale_w;
+    c->palette_valid = 0;
+    c->rows = (ring_row_t *)(c + 1);
+    c->px = (uint8_t *)(c->rows + size);
+    _lv_memcpy(c->rows, rows, size * sizeof(ring_row_t));
+    lv_mem_free(rows);
+
+    /*Second pass: palette index and coverage of the ring pixels*/
+    for(y = 0; y < size; y++) {
+        const ring_row_t * row = &c->rows[y];
+        uint8_t * p = &c->px[row->ofs * 2];
+        lv_coord_t span_x[2] = {row->x, size - row->x - row->len};
+        uint8_t span;
+        for(span = 0; span < (row->single ? 1 : 2); span++) {
+            for(x = span_x[span]; x < span_x[span] + row->len; x++) {
+                *p++ = ring_px_index(size, x, y);
+                *p++ = ring_px_opa(size, x, y, r_out, r_in);
+            }
+        }
+    }
+
+    ext->ring_cache = c;
+    return c;
+}
+
+static void ring_cache_free(lv_obj_t * cpicker)
+{
+    lv_cpicker_ext_t * ext = lv_obj_get_ext_attr(cpicker);
+    if(ext->ring_cache == NULL) return;
+    LV_CPICKER_CACHE_FREE(ext->ring_cache);
+    ext->ring_cache = NULL;
+}
+
+/**
+ * Draw the ring of the disc type from the cache
+ * @return false if there is no cache (the caller draws the ring with lines)
+ */
+static bool draw_ring_cached(lv_obj_t * cpicker, const lv_area_t * mask, const lv_draw_line_dsc_t * line_dsc)
+{
+    ring_cache_t * c = ring_cache_get(cpicker);
+    if(c == NULL) return false;
+    if(line_dsc->opa <= LV_OPA_MIN) return true;
+
+    lv_cpicker_ext_t * ext = lv_obj_get_ext_attr(cpicker);
+    if(!c->palette_valid || c->color_mode != ext->color_mode ||
+       c->hsv.h != ext->hsv.h || c->hsv.s != ext->hsv.s || c->hsv.v != ext->hsv.v) {
+        uint16_t i;
+        for(i = 0; i < RING_STEPS; i++) c->palette[i] = angle_to_mode_color(cpicker, i * LV_CPICKER_DEF_QF);
+        c->hsv = ext->hsv;
+        c->color_mode = ext->color_mode;
+        c->palette_valid = 1;
+    }
+
+    lv_area_t clip;
+    if(!_lv_area_intersect(&clip, mask, &cpicker->coords)) return true;
+
+    lv_coord_t buf_len = lv_area_get_width(&clip);
+    lv_color_t * color_buf = _lv_mem_buf_get(buf_len * sizeof(lv_color_t));
+    lv_opa_t * opa_buf = _lv_mem_buf_get(buf_len);
+    bool masked = lv_draw_mask_get_cnt() > 0;
+
+    lv_coord_t y;
+    for(y = clip.y1; y <= clip.y2; y++) {
+        const ring_row_t * row = &c->rows[y - cpicker->coords.y1];
+        if(row->len == 0) continue;
+
+        lv_coord_t span_x[2] = {row->x, c->size - row->x - row->len};
+        uint8_t span;
+        for(span = 0; span < (row->single ? 1 : 2); span++) {
+            lv_area_t area;
+            area.x1 = LV_MATH_MAX(cpicker->coords.x1 + span_x[span], clip.x1);
+            area.x2 = LV_MATH_MIN(cpicker->coords.x1 + span_x[span] + row->len - 1, clip.x2);
+            area.y1 = y;
+            area.y2 = y;
+            if(area.x1 > area.x2) continue;
+
+            lv_coord_t len = lv_area_get_width(&area);
+            uint32_t first = row->ofs + span * row->len + (area.x1 - cpicker->coords.x1 - span_x[span]);
+            const uint8_t * p = &c->px[first * 2];
+            lv_coord_t i;
+            for(i = 0; i < len; i++) {
+                color_buf[i] = c->palette[p[0]];
+                opa_buf[i] = p[1];
+                p += 2;
+            }
+
+            if(masked && lv_draw_mask_apply(opa_buf, area.x1, y, len) == LV_DRAW_MASK_RES_TRANSP) continue;
+            _lv_blend_map(&clip, &area, color_buf, opa_buf, LV_DRAW_MASK_RES_CHANGED, line_dsc->opa, line_dsc->blend_mode);
+        }
+    }
+
+    _lv_mem_buf_release(opa_buf);
+    _lv_mem_buf_release(color_buf);
+    return true;
+}
+
+/**
+ * Tell whether the ring's colors depend on a changed component
+ * (the ring shows the color mode's component with the other two fixed)
+ */
+static bool ring_colors_changed(lv_cpicker_color_mode_t mode, const lv_color_hsv_t * old, const lv_color_hsv_t * hsv)
+{
+    switch(mode) {
+        case LV_CPICKER_COLOR_MODE_HUE:
+            return old->s != hsv->s || old->v != hsv->v;
+        case LV_CPICKER_COLOR_MODE_SATURATION:
+            return old->h != hsv->h || old->v != hsv->v;
+        case LV_CPICKER_COLOR_MODE_VALUE:
+        default:
+            return old->h != hsv->h || old->s != hsv->s;
+    }
+}
+
+/**
+ * Invalidate the center circle of the disc which shows the current color
+ */
+static void invalidate_center(lv_obj_t * cpicker)
+{
+    lv_coord_t cir_w = lv_obj_get_style_scale_width(cpicker, LV_CPICKER_PART_MAIN);
+    lv_style_int_t inner = lv_obj_get_style_pad_inner(cpicker, LV_CPICKER_PART_MAIN);
+
+    lv_area_t area;
+    lv_area_copy(&area, &cpicker->coords);
+    area.x1 += cir_w + inner;
+    area.y1 += cir_w + inner;
+    area.x2 -= cir_w + inner;
+    area.y2 -= cir_w + inner;
+    if(area.x1 > area.x2 || area.y1 > area.y2) return;
+    lv_obj_invalidate_area(cpicker, &area);
+}
+
+#endif /*LV_CPICKER_RING_CACHE*/
+
 #endif /* LV_USE_CPICKER != 0 */
@@ -23,6 +23,10 @@ extern "C" {
  *      DEFINES
  *********************/
 
+#ifndef LV_CPICKER_RING_CACHE
+    #define LV_CPICKER_RING_CACHE 0
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -57,6 +61,9 @@ typedef struct {
     lv_cpicker_color_mode_t color_mode  : 2;
     uint8_t color_mode_fixed            : 1;
     lv_cpicker_type_t type              : 1;
+#if LV_CPICKER_RING_CACHE
+    void * ring_cache;      /*Pre-computed ring of the disc type, built on the first draw*/
+#endif
 } lv_cpicker_ext_t;
 
 /*Parts*/
@@ -112,6 +112,10 @@ lv_obj_t * lv_label_create(lv_obj_t * par, const lv_obj_t * copy)
     ext->hint.y          = 0;
 #endif
 
+#if LV_LABEL_LAYOUT_CACHE
+    lv_draw_label_layout_init(&ext->layout);
+#endif
+
 #if LV_LABEL_TEXT_SEL
     ext->sel_start = LV_DRAW_LABEL_NO_TXT_SEL;
     ext->sel_end   = LV_DRAW_LABEL_NO_TXT_SEL;
@@ -1014,7 +1018,11 @@ void lv_label_refr_text(lv_obj_t * label)
     if(ext->recolor != 0) flag |= LV_TXT_FLAG_RECOLOR;
     if(ext->expand != 0) flag |= LV_TXT_FLAG_EXPAND;
     if(ext->long_mode == LV_LABEL_LONG_EXPAND) flag |= LV_TXT_FLAG_FIT;
-    _lv_txt_get_size(&size, ext->text, font, letter_space, line_space, max_w, flag);
+#if LV_LABEL_LAYOUT_CACHE
+    /*Keep the line breaks for drawing; the size comes out of the same pass*/
+    if(!lv_draw_label_layout_update(&ext->layout, &size, ext->text, font, letter_space, line_space, max_w, flag))
+#endif
+        _lv_txt_get_size(&size, ext->text, font, letter_space, line_space, max_w, flag);
 
     /*Set the full size in expand mode*/
     if(ext->long_mode == LV_LABEL_LONG_EXPAND) {
@@ -1207,6 +1215,11 @@ void lv_label_refr_text(lv_obj_t * label)
                 }
                 ext->text[byte_id_ori + LV_LABEL_DOT_NUM] = '\0';
                 ext->dot_end                              = letter_id + LV_LABEL_DOT_NUM;
+#if LV_LABEL_LAYOUT_CACHE
+                /*The text is shorter now, break it again*/
+                lv_point_t dot_size;
+                lv_draw_label_layout_update(&ext->layout, &dot_size, ext->text, font, letter_space, line_space, max_w, flag);
+#endif
             }
         }
     }
@@ -1285,6 +1298,9 @@ static lv_design_res_t lv_label_design(lv_obj_t * label, const lv_area_t * clip_
         label_draw_dsc.ofs_y = ext->offset.y;
         label_draw_dsc.flag = flag;
         lv_obj_init_draw_label_dsc(label, LV_LABEL_PART_MAIN, &label_draw_dsc);
+#if LV_LABEL_LAYOUT_CACHE
+        label_draw_dsc.layout = &ext->layout;
+#endif
 
         /* In SROLL and SROLL_CIRC mode the CENTER and RIGHT are pointless so remove them.
          * (In addition they will result misalignment is this case)*/
@@ -1367,6 +1383,9 @@ static lv_res_t lv_label_signal(lv_obj_t * label, lv_signal_t sign, void * param
             ext->text = NULL;
         }
         lv_label_dot_tmp_free(label);
+#if LV_LABEL_LAYOUT_CACHE
+        lv_draw_label_layout_free(&ext->layout);
+#endif
     }
     else if(sign == LV_SIGNAL_STYLE_CHG) {
         /*Revert dots for proper refresh*/
@@ -1416,6 +1435,9 @@ static void lv_label_revert_dots(lv_obj_t * label)
     lv_label_dot_tmp_free(label);
 
     ext->dot_end = LV_LABEL_DOT_END_INV;
+#if LV_LABEL_LAYOUT_CACHE
+    lv_draw_label_layout_invalidate(&ext->layout);
+#endif
 }
 
 #if LV_USE_ANIMATION
@@ -84,6 +84,10 @@ typedef struct {
     lv_draw_label_hint_t hint; /*Used to buffer info about large text*/
 #endif
 
+#if LV_LABEL_LAYOUT_CACHE
+    lv_draw_label_layout_t layout; /*Line breaks of `text`, rebuilt by `lv_label_refr_text`*/
+#endif
+
 #if LV_LABEL_TEXT_SEL
     uint32_t sel_start;
     uint32_t sel_end;
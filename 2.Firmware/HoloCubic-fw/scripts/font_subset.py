@@ -0,0 +1,399 @@
+"""
+字体子集化（PlatformIO构建前脚本）
+
+扫描界面源码（setup_scr_*.c、ui_tables.c、lv_cubic_gui.c）中的字符串常量与LV_SYMBOL_*符号，
+加上 scripts/font_strings.txt 中列出的字符，从lv_font_conv生成的LVGL C字体中
+裁出只含这些字形的新字体文件，写到构建目录并在编译时替换原字体源文件。
+原字体文件保持不变，关闭子集化即恢复完整字库。
+
+platformio.ini 中启用：
+    extra_scripts = pre:scripts/font_subset.py
+    custom_font_subset = lv_font_montserrat_14.c lv_font_simsun_12.c lv_font_montserrat_48.c=0123456789:-
+
+字体名后接"=字符"时该字体只保留列出的字符（如时钟只用到数字的大号字体），不扫描界面源码
+
+也可以单独运行查看裁剪结果：
+    python scripts/font_subset.py -o out lib/lvgl/src/lv_font/lv_font_montserrat_14.c
+"""
+
+import glob, os, re, sys
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+# 被扫描字符串的界面源码
+GUI_SOURCES = ["src/setup_scr_*.c", "src/ui_tables.c", "src/lv_cubic_gui.c"]
+# 用户补充的字符列表（运行时拼出的文字、数字等）
+STRINGS_FILE = "scripts/font_strings.txt"
+SYMBOL_DEF = "lib/lvgl/src/lv_font/lv_symbol_def.h"
+# 至少连续这么多个码位才单独使用FORMAT0_TINY映射，否则放进稀疏列表
+RUN_MIN = 4
+
+
+def c_unescape(body):
+    """C字符串常量内容 -> bytes"""
+    out = bytearray()
+    i = 0
+    simple = {"n": 10, "t": 9, "r": 13, "0": 0, "\\": 92, "\"": 34, "'": 39, "a": 7, "b": 8, "f": 12, "v": 11}
+    while i < len(body):
+        c = body[i]
+        if c != "\\":
+            out += c.encode("utf-8")
+            i += 1
+            continue
+        n = body[i + 1] if i + 1 < len(body) else ""
+        if n == "x":
+            m = re.match(r"[0-9a-fA-F]{1,2}", body[i + 2:])
+            out.append(int(m.group(0), 16) if m else 0)
+            i += 2 + (len(m.group(0)) if m else 0)
+        elif n in "01234567" and n:
+            m = re.match(r"[0-7]{1,3}", body[i + 1:])
+            out.append(int(m.group(0), 8) & 0xFF)
+            i += 1 + len(m.group(0))
+        else:
+            out.append(simple.get(n, ord(n) if n else 92))
+            i += 2
+    return bytes(out)
+
+
+def strip_comments(text):
+    """去掉注释（保留字符串常量），避免把中文注释里的字符也算进去"""
+    return re.sub(r"//[^\n]*|/\*.*?\*/|(\"(?:\\.|[^\"\\\n])*\")",
+                  lambda m: m.group(1) or " ", text, flags=re.S)
+
+
+def load_symbols(path):
+    """LV_SYMBOL_XXX -> 字符"""
+    symbols = {}
+    with open(path, encoding="utf-8") as f:
+        for m in re.finditer(r"#define\s+(LV_SYMBOL_\w+)\s+\"((?:\\.|[^\"\\])*)\"", f.read()):
+            symbols[m.group(1)] = c_unescape(m.group(2)).decode("utf-8", "ignore")
+    return symbols
+
+
+def scan_source(path, symbols):
+    """源码中字符串常量与LV_SYMBOL_*用到的字符"""
+    with open(path, encoding="utf-8", errors="ignore") as f:
+        text = strip_comments(f.read())
+    text = re.sub(r"^\s*#\s*include[^\n]*", "", text, flags=re.M)
+    chars = set()
+    for m in re.finditer(r"\"((?:\\.|[^\"\\\n])*)\"", text):
+        chars |= set(c_unescape(m.group(1)).decode("utf-8", "ignore"))
+    for m in re.finditer(r"\bLV_SYMBOL_\w+", text):
+        chars |= set(symbols.get(m.group(0), ""))
+    return chars
+
+
+def load_strings(path, symbols):
+    """
+    字符列表文件：每行一段文字，#开头为注释
+    U+XXXX 或 U+XXXX-U+YYYY 表示码位/码位范围，LV_SYMBOL_XXX 表示图标
+    """
+    chars = set()
+    if not os.path.isfile(path):
+        return chars
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.rstrip("\r\n")
+            if not line or line.startswith("#"):
+                continue
+            m = re.fullmatch(r"\s*U\+([0-9a-fA-F]+)(?:\s*-\s*U\+([0-9a-fA-F]+))?\s*", line)
+            if m:
+                lo = int(m.group(1), 16)
+                hi = int(m.group(2), 16) if m.group(2) else lo
+                chars |= set(chr(c) for c in range(lo, hi + 1))
+            elif re.fullmatch(r"\s*LV_SYMBOL_\w+\s*", line):
+                chars |= set(symbols.get(line.strip(), ""))
+            else:
+                chars |= set(line)
+    return chars
+
+
+def collect_chars(project_dir=PROJECT_DIR):
+    symbols = load_symbols(os.path.join(project_dir, SYMBOL_DEF))
+    chars = load_strings(os.path.join(project_dir, STRINGS_FILE), symbols)
+    for pattern in GUI_SOURCES:
+        for path in sorted(glob.glob(os.path.join(project_dir, pattern))):
+            chars |= scan_source(path, symbols)
+    return set(ord(c) for c in chars if ord(c) >= 0x20)
+
+
+def parse_array(text, name):
+    m = re.search(r"\b" + name + r"\[\]\s*=\s*\{(.*?)\};", text, re.S)
+    if not m:
+        return None
+    body = re.sub(r"/\*.*?\*/", " ", m.group(1), flags=re.S)
+    return [int(v, 0) for v in re.findall(r"-?(?:0x[0-9a-fA-F]+|\d+)", body)]
+
+
+def parse_font(text):
+    """解析lv_font_conv输出的C字体（--format lvgl）"""
+    font = {}
+    font["bitmap"] = parse_array(text, "gylph_bitmap")
+    font["glyphs"] = [tuple(int(v) for v in g) for g in re.findall(
+        r"\{\.bitmap_index = (\d+), \.adv_w = (\d+), \.box_w = (\d+), \.box_h = (\d+),"
+        r" \.ofs_x = (-?\d+), \.ofs_y = (-?\d+)\}", text)]
+
+    # 码位 -> 原glyph id
+    cmap = {}
+    body = re.search(r"cmaps\[\]\s*=\s*\{(.*?)\n\};", text, re.S).group(1)
+    for m in re.finditer(r"\{(.*?)\}", body, re.S):
+        f = dict(re.findall(r"\.(\w+) = (\w+)", m.group(1)))
+        start, length, gid = int(f["range_start"]), int(f["range_length"]), int(f["glyph_id_start"])
+        ulist = parse_array(text, f["unicode_list"]) if f["unicode_list"] != "NULL" else None
+        olist = parse_array(text, f["glyph_id_ofs_list"]) if f["glyph_id_ofs_list"] != "NULL" else None
+        kind = f["type"]
+        if kind.endswith("FORMAT0_TINY"):
+            for i in range(length):
+                cmap.setdefault(start + i, gid + i)
+        elif kind.endswith("FORMAT0_FULL"):
+            for i in range(length):
+                if olist[i] or i == 0:
+                    cmap.setdefault(start + i, gid + olist[i])
+        elif kind.endswith("SPARSE_TINY"):
+            for i, ofs in enumerate(ulist):
+                cmap.setdefault(start + ofs, gid + i)
+        else:
+            for i, ofs in enumerate(ulist):
+                cmap.setdefault(start + ofs, gid + olist[i])
+    font["cmap"] = cmap
+
+    m = re.search(r"static lv_font_fmt_txt_dsc_t font_dsc = \{(.*?)\};", text, re.S)
+    font["dsc"] = dict(re.findall(r"\.(\w+) = ([^,\n]+)", m.group(1)))
+    if font["dsc"].get("kern_classes") == "1":
+        font["kern_left"] = parse_array(text, "kern_left_class_mapping")
+        font["kern_right"] = parse_array(text, "kern_right_class_mapping")
+        font["kern_values"] = parse_array(text, "kern_class_values")
+        k = re.search(r"kern_classes =\s*\{(.*?)\};", text, re.S).group(1)
+        font["kern_cnt"] = {n: int(v) for n, v in re.findall(r"\.(left_class_cnt|right_class_cnt)\s*=\s*(\d+)", k)}
+    elif font["dsc"].get("kern_dsc", "NULL") != "NULL":
+        ids = parse_array(text, "kern_pair_glyph_ids")
+        values = parse_array(text, "kern_pair_values")
+        font["kern_pairs"] = [(ids[2 * i], ids[2 * i + 1], values[i]) for i in range(len(values))]
+
+    # 原文件的文件头（版权、宏开关）与公共字体描述，原样保留
+    font["head"] = text[:text.index("/*-----------------\n *    BITMAPS")]
+    font["tail"] = text[text.index("/*-----------------\n *  PUBLIC FONT"):]
+    return font
+
+
+def glyph_bytes(font, gid):
+    idx, _, w, h = font["glyphs"][gid][:4]
+    if w * h == 0:
+        return []
+    ends = [g[0] for g in font["glyphs"] if g[0] > idx]
+    return font["bitmap"][idx:min(ends) if ends else len(font["bitmap"])]
+
+
+def fmt_list(values, indent="    ", per_line=8):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append(indent + ", ".join(values[i:i + per_line]))
+    return ",\n".join(lines)
+
+
+def char_comment(cp):
+    c = chr(cp)
+    if c in "\\\"":
+        c = "\\" + c
+    return "/* U+{:X} \"{}\" */".format(cp, c if cp >= 0x20 else "")
+
+
+def build_cmaps(cps):
+    """按码位连续段生成映射：长连续段用FORMAT0_TINY，零散码位合并成SPARSE_TINY"""
+    runs = []
+    for cp in cps:
+        if runs and cp == runs[-1][-1] + 1:
+            runs[-1].append(cp)
+        else:
+            runs.append([cp])
+    cmaps, sparse, gid = [], [], 1
+
+    def flush():
+        nonlocal gid
+        if sparse:
+            cmaps.append(("SPARSE_TINY", sparse[0], sparse[-1] - sparse[0] + 1, gid, [c - sparse[0] for c in sparse]))
+            gid += len(sparse)
+            sparse.clear()
+
+    for run in runs:
+        if len(run) >= RUN_MIN:
+            flush()
+            cmaps.append(("FORMAT0_TINY", run[0], len(run), gid, None))
+            gid += len(run)
+            continue
+        for cp in run:
+            if sparse and cp - sparse[0] > 0xFFFF:
+                flush()
+            sparse.append(cp)
+    flush()
+    return cmaps
+
+
+def subset_font(text, wanted):
+    """
+    生成子集字体C源码
+    @return (源码, 保留字形数, 原字形数, 字体中缺失的字符集合)
+    """
+    font = parse_font(text)
+    cps = sorted(cp for cp in wanted if cp in font["cmap"])
+    missing = set(wanted) - set(font["cmap"])
+    cmaps = build_cmaps(cps)
+    old_gids = [0] + [font["cmap"][cp] for cp in cps]
+    new_gid = {old: new for new, old in enumerate(old_gids) if new}
+
+    out = [font["head"]]
+    out.append("/*-----------------\n *    BITMAPS\n *----------------*/\n\n")
+    out.append("/*Store the image of the glyphs*/\n")
+    out.append("static LV_ATTRIBUTE_LARGE_CONST const uint8_t gylph_bitmap[] = {\n")
+    blocks, dscs, pos = [], [], 0
+    for cp, old in zip(cps, old_gids[1:]):
+        data = glyph_bytes(font, old)
+        block = "    " + char_comment(cp) + "\n"
+        if data:
+            block += fmt_list(["0x{:x}".format(v) for v in data]) + ","
+        blocks.append(block)
+        g = font["glyphs"][old]
+        dscs.append((pos,) + g[1:])
+        pos += len(data)
+    out.append("\n\n".join(b.rstrip() for b in blocks).rstrip(",") + "\n};\n\n\n")
+
+    out.append("/*---------------------\n *  GLYPH DESCRIPTION\n *--------------------*/\n\n")
+    out.append("static const lv_font_fmt_txt_glyph_dsc_t glyph_dsc[] = {\n")
+    rows = ["    {.bitmap_index = 0, .adv_w = 0, .box_w = 0, .box_h = 0, .ofs_x = 0, .ofs_y = 0} /* id = 0 reserved */"]
+    rows += ["    {{.bitmap_index = {}, .adv_w = {}, .box_w = {}, .box_h = {}, .ofs_x = {}, .ofs_y = {}}}".format(*d)
+             for d in dscs]
+    out.append(",\n".join(rows) + "\n};\n\n")
+
+    out.append("/*---------------------\n *  CHARACTER MAPPING\n *--------------------*/\n\n")
+    for i, c in enumerate(cmaps):
+        if c[4] is not None:
+            out.append("static const uint16_t unicode_list_{}[] = {{\n{}\n}};\n\n".format(
+                i, fmt_list(["0x{:x}".format(v) for v in c[4]])))
+    out.append("/*Collect the unicode lists and glyph_id offsets*/\nstatic const lv_font_fmt_txt_cmap_t cmaps[] =\n{\n")
+    rows = []
+    for i, (kind, start, length, gid, ulist) in enumerate(cmaps):
+        rows.append("    {{\n        .range_start = {}, .range_length = {}, .glyph_id_start = {},\n"
+                    "        .unicode_list = {}, .glyph_id_ofs_list = NULL, .list_length = {}, "
+                    ".type = LV_FONT_FMT_TXT_CMAP_{}\n    }}".format(
+                        start, length, gid, "unicode_list_{}".format(i) if ulist else "NULL",
+                        len(ulist) if ulist else 0, kind))
+    out.append(",\n".join(rows) + "\n};\n\n")
+
+    dsc = dict(font["dsc"])
+    dsc["cmap_num"] = str(len(cmaps))
+    if "kern_left" in font:
+        out.append("/*-----------------\n *    KERNING\n *----------------*/\n\n")
+        for name, table in (("left", font["kern_left"]), ("right", font["kern_right"])):
+            mapped = [table[g] if g < len(table) else 0 for g in old_gids]
+            out.append("/*Map glyph_ids to kern {} classes*/\nstatic const uint8_t kern_{}_class_mapping[] =\n{{\n{}\n}};\n\n"
+                       .format(name, name, fmt_list([str(v) for v in mapped])))
+        out.append("/*Kern values between classes*/\nstatic const int8_t kern_class_values[] =\n{{\n{}\n}};\n\n\n"
+                   .format(fmt_list([str(v) for v in font["kern_values"]])))
+        out.append("/*Collect the kern class' data in one place*/\n"
+                   "static const lv_font_fmt_txt_kern_classes_t kern_classes =\n{{\n"
+                   "    .class_pair_values   = kern_class_values,\n"
+                   "    .left_class_mapping  = kern_left_class_mapping,\n"
+                   "    .right_class_mapping = kern_right_class_mapping,\n"
+                   "    .left_class_cnt      = {},\n"
+                   "    .right_class_cnt     = {},\n}};\n\n".format(
+                       font["kern_cnt"]["left_class_cnt"], font["kern_cnt"]["right_class_cnt"]))
+    elif "kern_pairs" in font:
+        pairs = sorted((new_gid[l], new_gid[r], v) for l, r, v in font["kern_pairs"] if l in new_gid and r in new_gid)
+        if pairs:
+            wide = max(max(p[0], p[1]) for p in pairs) > 255
+            out.append("/*-----------------\n *    KERNING\n *----------------*/\n\n")
+            out.append("/*Pair left and right glyphs for kerning*/\nstatic const {} kern_pair_glyph_ids[] =\n{{\n{}\n}};\n\n"
+                       .format("uint16_t" if wide else "uint8_t",
+                               fmt_list([str(v) for p in pairs for v in p[:2]])))
+            out.append("/* Kerning between the respective left and right glyphs\n * 4.4 format which needs to scaled with `kern_scale`*/\n"
+                       "static const int8_t kern_pair_values[] =\n{{\n{}\n}};\n\n".format(
+                           fmt_list([str(p[2]) for p in pairs])))
+            out.append("/*Collect the kern pair's data in one place*/\n"
+                       "static const lv_font_fmt_txt_kern_pair_t kern_pairs =\n{{\n"
+                       "    .glyph_ids = kern_pair_glyph_ids,\n    .values = kern_pair_values,\n"
+                       "    .pair_cnt = {},\n    .glyph_ids_size = {}\n}};\n\n".format(len(pairs), 1 if wide else 0))
+        else:
+            dsc["kern_dsc"] = "NULL"
+            dsc["kern_scale"] = "0"
+
+    out.append("/*--------------------\n *  ALL CUSTOM DATA\n *--------------------*/\n\n")
+    out.append("/*Store all the custom data of the font*/\nstatic lv_font_fmt_txt_dsc_t font_dsc = {\n")
+    out.append(",\n".join("    .{} = {}".format(k, v.strip()) for k, v in dsc.items()) + "\n};\n\n\n")
+    out.append(font["tail"])
+    return "".join(out), len(cps), len(font["glyphs"]) - 1, missing
+
+
+def write_subset(src, dst, wanted):
+    """生成子集文件，内容未变化时不改写（避免每次构建都重新编译）"""
+    with open(src, encoding="utf-8") as f:
+        code, kept, total, missing = subset_font(f.read(), wanted)
+    code = "/* 由scripts/font_subset.py从{}生成，请勿手动修改 */\n".format(os.path.basename(src)) + code
+    old = None
+    if os.path.isfile(dst):
+        with open(dst, encoding="utf-8") as f:
+            old = f.read()
+    if old != code:
+        with open(dst, "w", encoding="utf-8") as f:
+            f.write(code)
+    return kept, total, missing
+
+
+def find_font(project_dir, name):
+    for pattern in ("src/" + name, "lib/*/src/lv_font/" + name, "lib/**/" + name):
+        found = glob.glob(os.path.join(project_dir, pattern), recursive=True)
+        if found:
+            return found[0]
+    return None
+
+
+def split_spec(spec, wanted):
+    """"name=字符" -> (name, 只含这些字符的集合)；没有"="时使用界面扫描出的字符集"""
+    name, sep, chars = spec.partition("=")
+    return name, (set(ord(c) for c in chars) if sep else wanted)
+
+
+def pio_setup(env):
+    fonts = env.GetProjectOption("custom_font_subset", "").split()
+    if not fonts:
+        return
+    out_dir = os.path.join(env.subst("$BUILD_DIR"), "font_subset")
+    os.makedirs(out_dir, exist_ok=True)
+    wanted = collect_chars(env.subst("$PROJECT_DIR"))
+    subsets = {}
+    for spec in fonts:
+        name, chars = split_spec(spec, wanted)
+        src = find_font(env.subst("$PROJECT_DIR"), name)
+        if src is None:
+            print("font_subset: 找不到字体文件 {}".format(name))
+            continue
+        dst = os.path.join(out_dir, name)
+        kept, total, missing = write_subset(src, dst, chars)
+        print("font_subset: {} 保留{}/{}个字形".format(name, kept, total))
+        subsets[name] = (src, dst)
+
+    def replace_font(env, node):
+        src, dst = subsets[os.path.basename(node.srcnode().get_path())]
+        # 原文件的相对#include（如"../../lvgl.h"）按原目录解析
+        return env.Object(target=os.path.join(out_dir, os.path.splitext(os.path.basename(dst))[0]), source=dst,
+                          CPPPATH=[os.path.dirname(src)] + env.get("CPPPATH", []))
+
+    for name in subsets:
+        env.AddBuildMiddleware(replace_font, "*/" + name)
+
+
+if __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser(description="按界面用到的字符裁剪LVGL C字体")
+    parser.add_argument("fonts", nargs="+", help="lv_font_conv生成的 .c 字体文件（可接\"=字符\"）")
+    parser.add_argument("-o", "--out", default=".", help="输出目录")
+    args = parser.parse_args()
+    wanted = collect_chars()
+    os.makedirs(args.out, exist_ok=True)
+    for spec in args.fonts:
+        path, chars = split_spec(spec, wanted)
+        kept, total, missing = write_subset(path, os.path.join(args.out, os.path.basename(path)), chars)
+        print("{}: 保留{}/{}个字形".format(os.path.basename(path), kept, total))
+        if missing:
+            print("  字体中没有: " + "".join(sorted(chr(c) for c in missing)))
+else:
+    Import("env")
+    pio_setup(env)
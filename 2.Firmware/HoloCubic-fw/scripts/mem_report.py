@@ -0,0 +1,348 @@
+"""
+内存占用报告（PlatformIO构建后脚本）
+
+链接时生成map文件，构建完成后解析其中每个输入段的大小，按模块汇总IRAM/DRAM/Flash占用，
+并与上一次构建的结果比较，输出变化量。报告写到构建目录：
+    mem_report.txt   按模块的占用表、变化最大的模块、各区域最大的对象
+    mem_report.json  供下次构建比较（也可以保存下来作为减少内存工作的目标）
+
+区域按链接脚本的输出段划分（ESP32）：
+    IRAM   .iram0.*（中断向量、IRAM_ATTR代码与数据）
+    DRAM   .dram0.data、.dram0.bss、.noinit（静态变量，启动后即从可用堆中扣除）
+    Flash  .flash.text、.flash.rodata、.flash.appdesc（经cache映射的代码与常量，如images.h、字体表）
+    RTC    .rtc.*（只计入总量）
+.dram0.data与.iram0.*的初值同样存放在固件镜像中，Flash一列只统计映射执行/读取的部分。
+
+模块的划分：
+    src下的文件      以文件名为模块（sd_card、display、images等）
+    lib下的库        库名/源码子目录（lvgl/lv_core、lvgl/lv_widgets等）
+    字体             font/字体文件名（所在位置不限，子集化后的字体也归到这里）
+    框架与SDK        sdk/库名（arduino、freertos、lwip、libc等）
+
+platformio.ini 中启用：
+    extra_scripts = post:scripts/mem_report.py
+    ; 可选：超出预算时给出警告（字节）
+    custom_mem_budget = iram=100000 dram=90000 flash=1500000
+
+也可以单独解析一个map文件：
+    python scripts/mem_report.py .pio/build/pico32/firmware.map --prev old.json
+"""
+
+import glob, json, os, re, shutil, subprocess, sys
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+REGIONS = ("iram", "dram", "flash")
+# 输出段名称前缀 -> 区域
+SECTION_REGIONS = [
+    (".iram0.", "iram"),
+    (".dram0.heap_start", None),
+    (".dram0.", "dram"),
+    (".noinit", "dram"),
+    (".flash_rodata_dummy", None),
+    (".flash.", "flash"),
+    (".rtc", "rtc"),
+]
+# 报告中列出的模块数与每个区域最大的对象数
+TOP_MODULES = 40
+TOP_OBJECTS = 12
+FONT_RE = re.compile(r"^lv_font_[a-z]+(?:_[a-z]+)*_\d+$")
+
+OUTPUT_RE = re.compile(r"^(\.\S+)(?:\s+0x[0-9a-fA-F]+\s+0x[0-9a-fA-F]+)?\s*$")
+INPUT_RE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+INPUT_NAME_RE = re.compile(r"^ (\S+)\s*$")
+CONT_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+FILL_RE = re.compile(r"^ \*fill\*\s+0x[0-9a-fA-F]+\s+0x([0-9a-fA-F]+)")
+ARCHIVE_RE = re.compile(r"^(.*?)([^/\\]+)\.a\((.+)\)$")
+
+
+def region_of(section):
+    for prefix, region in SECTION_REGIONS:
+        if section.startswith(prefix):
+            return region
+    return None
+
+
+def parse_map(path):
+    """
+    map文件 -> [(区域, 输出段, 输入段, 大小, 对象)]
+    只解析"Linker script and memory map"之后的部分；调试段等不在SECTION_REGIONS中的输出段跳过
+    """
+    entries = []
+    with open(path, encoding="utf-8", errors="ignore") as f:
+        lines = f.read().splitlines()
+    try:
+        start = next(i for i, l in enumerate(lines) if l.startswith("Linker script and memory map"))
+    except StopIteration:
+        start = 0
+    region = out_sec = None
+    pending = None
+    for line in lines[start + 1:]:
+        if pending is not None:
+            m = CONT_RE.match(line)
+            if m and region:
+                entries.append((region, out_sec, pending, int(m.group(2), 16), m.group(3).strip()))
+            pending = None
+            if m:
+                continue
+        if line.startswith("."):
+            m = OUTPUT_RE.match(line)
+            if m:
+                out_sec = m.group(1)
+                region = region_of(out_sec)
+            continue
+        if region is None:
+            continue
+        m = FILL_RE.match(line)
+        if m:
+            entries.append((region, out_sec, "*fill*", int(m.group(1), 16), ""))
+            continue
+        m = INPUT_RE.match(line)
+        if m:
+            entries.append((region, out_sec, m.group(1), int(m.group(3), 16), m.group(4).strip()))
+            continue
+        m = INPUT_NAME_RE.match(line)
+        if m and not line.startswith(" *"):
+            # 输入段名过长时地址与大小在下一行
+            pending = m.group(1)
+    return [e for e in entries if e[3] > 0]
+
+
+def source_index(project_dir):
+    """lib下的源文件名 -> 库名/子目录（用于把库归档中的对象归到子系统）"""
+    index = {}
+    lib_dir = os.path.join(project_dir, "lib")
+    for path in glob.glob(os.path.join(lib_dir, "*", "**", "*.c*"), recursive=True):
+        rel = os.path.relpath(path, lib_dir).replace("\\", "/").split("/")
+        if "examples" in rel or "tests" in rel:
+            continue
+        # lvgl/src/lv_core/lv_obj.c -> lvgl/lv_core
+        sub = [p for p in rel[1:-1] if p != "src"]
+        index.setdefault(rel[-1], "/".join([rel[0]] + sub[:1]))
+    return index
+
+
+def module_of(obj, index, build_dir):
+    """对象路径 -> 模块名"""
+    if not obj:
+        return "(fill)"
+    obj = obj.replace("\\", "/")
+    m = ARCHIVE_RE.match(obj)
+    member = m.group(3) if m else os.path.basename(obj)
+    source = re.sub(r"\.o(bj)?$", "", member)
+    stem = os.path.splitext(source)[0]
+    if FONT_RE.match(stem):
+        return "font/" + stem
+    in_project = (build_dir and obj.startswith(build_dir.replace("\\", "/"))) or ".pio/build/" in obj
+    if m:
+        lib = re.sub(r"^lib", "", m.group(2))
+        if in_project and lib not in ("FrameworkArduino",):
+            return index.get(source, lib)
+        return "sdk/" + ("arduino" if lib == "FrameworkArduino" else m.group(2))
+    if in_project and "/src/" in obj:
+        return stem
+    if in_project:
+        return index.get(source, stem)
+    return "sdk/" + stem
+
+
+def object_name(section):
+    """输入段名 -> 对象名（-ffunction-sections/-fdata-sections时段名后缀即符号）"""
+    for prefix in (".literal.", ".text.", ".rodata.str", ".rodata.", ".data.", ".bss.", ".sbss.", ".sdata.",
+                   ".iram1.", ".dram1.", ".noinit."):
+        if section.startswith(prefix) and not section[len(prefix):].isdigit():
+            return section[len(prefix):]
+    return section
+
+
+def demangle(names, tool):
+    """用c++filt还原C++符号名，找不到工具时原样返回"""
+    names = list(names)
+    if not tool or not names:
+        return dict((n, n) for n in names)
+    try:
+        out = subprocess.run([tool], input="\n".join(names), stdout=subprocess.PIPE,
+                             universal_newlines=True, timeout=20).stdout.splitlines()
+    except (OSError, subprocess.SubprocessError):
+        return dict((n, n) for n in names)
+    if len(out) != len(names):
+        return dict((n, n) for n in names)
+    return dict(zip(names, out))
+
+
+def summarize(entries, project_dir=PROJECT_DIR, build_dir=None):
+    index = source_index(project_dir)
+    modules = {}
+    totals = {}
+    objects = dict((r, {}) for r in REGIONS)
+    for region, out_sec, in_sec, size, obj in entries:
+        totals[region] = totals.get(region, 0) + size
+        if region not in REGIONS:
+            continue
+        mod = module_of(obj, index, build_dir)
+        row = modules.setdefault(mod, dict((r, 0) for r in REGIONS))
+        row[region] += size
+        if in_sec != "*fill*":
+            key = (object_name(in_sec), mod)
+            objects[region][key] = objects[region].get(key, 0) + size
+    top = {}
+    for region in REGIONS:
+        items = sorted(objects[region].items(), key=lambda kv: -kv[1])[:TOP_OBJECTS]
+        top[region] = [{"name": k[0], "module": k[1], "size": v} for k, v in items]
+    return {"totals": totals, "modules": modules, "top": top}
+
+
+def fmt_delta(v):
+    return "" if v == 0 else "{:+d}".format(v)
+
+
+def render(report, prev=None, budget=None):
+    """报告 -> 文本；prev为上一次构建的报告"""
+    lines = []
+    totals = report["totals"]
+    mods = report["modules"]
+    pmods = prev["modules"] if prev else {}
+    ptotals = prev["totals"] if prev else {}
+
+    lines.append("区域总量（字节）")
+    for region in REGIONS + ("rtc",):
+        v = totals.get(region, 0)
+        d = v - ptotals.get(region, 0) if prev else 0
+        limit = budget.get(region) if budget else None
+        extra = ""
+        if limit:
+            extra = "  预算{} 剩余{}".format(limit, limit - v)
+        lines.append("  {:<6}{:>10}  {:>8}{}".format(region.upper(), v, fmt_delta(d), extra))
+    lines.append("")
+
+    head = "  {:<34}{:>9}{:>8}{:>9}{:>8}{:>10}{:>9}".format("模块", "IRAM", "", "DRAM", "", "Flash", "")
+    lines.append("按模块（括号外为本次，其后为与上次构建的差）")
+    lines.append(head)
+    rows = sorted(mods.items(), key=lambda kv: -(kv[1]["iram"] + kv[1]["dram"] + kv[1]["flash"]))
+    for name, row in rows[:TOP_MODULES]:
+        p = pmods.get(name, {})
+        cells = []
+        for region in REGIONS:
+            cells.append("{:>9}".format(row[region]))
+            cells.append("{:>8}".format(fmt_delta(row[region] - p.get(region, 0)) if prev else ""))
+        lines.append("  {:<34}{}{}{}{}{}{}".format(name[:34], *cells))
+    if len(rows) > TOP_MODULES:
+        rest = dict((r, sum(row[r] for _, row in rows[TOP_MODULES:])) for r in REGIONS)
+        lines.append("  {:<34}{:>9}{:>8}{:>9}{:>8}{:>10}".format(
+            "（其余{}个）".format(len(rows) - TOP_MODULES), rest["iram"], "", rest["dram"], "", rest["flash"]))
+    lines.append("")
+
+    if prev:
+        changes = []
+        for name in set(mods) | set(pmods):
+            row, p = mods.get(name, {}), pmods.get(name, {})
+            d = dict((r, row.get(r, 0) - p.get(r, 0)) for r in REGIONS)
+            if any(d.values()):
+                changes.append((name, d))
+        changes.sort(key=lambda c: -sum(abs(v) for v in c[1].values()))
+        lines.append("与上次构建相比变化的模块")
+        if not changes:
+            lines.append("  （无）")
+        for name, d in changes[:TOP_MODULES]:
+            lines.append("  {:<34}".format(name[:34]) + "".join(
+                "{:>6} {:<9}".format(r.upper(), fmt_delta(d[r]) or "0") for r in REGIONS))
+        lines.append("")
+
+    for region in REGIONS:
+        lines.append("{}中最大的对象".format(region.upper()))
+        for item in report["top"][region]:
+            lines.append("  {:>8}  {:<28}{}".format(item["size"], item["module"][:28], item["name"]))
+        lines.append("")
+    return "\n".join(lines)
+
+
+def parse_budget(text):
+    """"iram=100000 dram=90000" -> {"iram": 100000, ...}"""
+    budget = {}
+    for part in text.split():
+        key, sep, value = part.partition("=")
+        if sep and key.lower() in REGIONS + ("rtc",):
+            budget[key.lower()] = int(value, 0)
+    return budget
+
+
+def load_report(path):
+    if not path or not os.path.isfile(path):
+        return None
+    try:
+        with open(path, encoding="utf-8") as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return None
+
+
+def write_report(map_path, out_dir, project_dir=PROJECT_DIR, build_dir=None, budget=None, cxxfilt=None, prev=None):
+    """解析map并写出报告，返回文本；prev为None时与out_dir中上一次的mem_report.json比较"""
+    json_path = os.path.join(out_dir, "mem_report.json")
+    if prev is None:
+        prev = load_report(json_path)
+    report = summarize(parse_map(map_path), project_dir, build_dir)
+    names = set(i["name"] for region in REGIONS for i in report["top"][region])
+    names = demangle(names, cxxfilt)
+    for region in REGIONS:
+        for item in report["top"][region]:
+            item["name"] = names.get(item["name"], item["name"])
+    text = render(report, prev, budget)
+    with open(os.path.join(out_dir, "mem_report.txt"), "w", encoding="utf-8") as f:
+        f.write(text + "\n")
+    with open(json_path, "w", encoding="utf-8") as f:
+        json.dump(report, f, ensure_ascii=False, indent=1, sort_keys=True)
+    warnings = []
+    for region, limit in (budget or {}).items():
+        used = report["totals"].get(region, 0)
+        if used > limit:
+            warnings.append("mem_report: {} 超出预算 {} 字节（{}/{}）".format(region.upper(), used - limit, used, limit))
+    return text, warnings
+
+
+def pio_setup(env):
+    build_dir = env.subst("$BUILD_DIR")
+    map_path = None
+    for flag in env.get("LINKFLAGS", []):
+        m = re.match(r"-Wl,-Map[=,](.+)", str(flag))
+        if m:
+            map_path = env.subst(m.group(1).strip("\""))
+    if map_path is None:
+        map_path = os.path.join(build_dir, env.subst("${PROGNAME}.map"))
+        env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+    budget = parse_budget(env.GetProjectOption("custom_mem_budget", ""))
+    cxx = env.subst("$CXX")
+    cxxfilt = shutil.which(re.sub(r"g\+\+$", "c++filt", cxx), path=env["ENV"].get("PATH")) if cxx else None
+
+    def report(source, target, env):
+        if not os.path.isfile(map_path):
+            print("mem_report: 找不到map文件 {}".format(map_path))
+            return
+        text, warnings = write_report(map_path, build_dir, env.subst("$PROJECT_DIR"), build_dir, budget, cxxfilt)
+        print(text)
+        print("mem_report: 报告已写入 {}".format(os.path.join(build_dir, "mem_report.txt")))
+        for w in warnings:
+            print(w)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report)
+
+
+if __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser(description="按模块统计ESP32固件的IRAM/DRAM/Flash占用")
+    parser.add_argument("map", help="链接生成的 .map 文件")
+    parser.add_argument("-o", "--out", default=None, help="报告输出目录（默认为map文件所在目录）")
+    parser.add_argument("--prev", default=None, help="比较用的mem_report.json（默认为输出目录中上一次的报告）")
+    parser.add_argument("--budget", default="", help="预算，如 \"iram=100000 dram=90000\"")
+    parser.add_argument("--cxxfilt", default=shutil.which("xtensa-esp32-elf-c++filt") or shutil.which("c++filt"))
+    args = parser.parse_args()
+    out = args.out or os.path.dirname(os.path.abspath(args.map))
+    os.makedirs(out, exist_ok=True)
+    text, warnings = write_report(args.map, out, PROJECT_DIR, None, parse_budget(args.budget), args.cxxfilt,
+                                  load_report(args.prev) if args.prev else None)
+    print(text)
+    for w in warnings:
+        print(w)
+    sys.exit(1 if warnings else 0)
+else:
+    Import("env")
+    pio_setup(env)
@@ -0,0 +1,223 @@
+"""
+界面描述编译（PlatformIO构建前脚本）
+
+把 ui/*.json 中的屏幕描述编译成 src/ui_tables.c 与 include/ui_tables.h 中的常量表：
+样式编译为flash中的LVGL属性表（运行时不再调用lv_style_set_*，不占LVGL堆），
+对象编译为按创建顺序排列的ui_obj_def_t，由src/ui_builder.c在打开屏幕时实例化。
+内容没有变化时不改写输出文件，不触发重新编译。
+
+platformio.ini 中启用（需排在字体子集化之前，字体子集化会扫描生成的文字）：
+    extra_scripts = pre:scripts/ui_compile.py
+
+也可以单独运行（修改界面描述后重新生成）：
+    python scripts/ui_compile.py
+
+描述格式（一个文件一个屏幕）：
+{
+    "screen": "home",                        屏幕名，生成 ui_scr_home
+    "styles": {                              样式名 -> 状态 -> 属性
+        "home_cpicker0_main": {
+            "default": { "pad_inner": 10, "bg_color": "#000000", "bg_opa": "LV_OPA_50" }
+        }
+    },
+    "objects": [                             第0项为屏幕根对象，父对象排在子对象之前
+        { "id": "home", "type": "obj" },
+        { "id": "home_cpicker0", "type": "cpicker", "parent": "home",
+          "pos": [15, 16], "size": [200, 200], "align": "center",
+          "styles": { "main": "home_cpicker0_main" }, "cpicker_type": "disc" }
+    ]
+}
+id为lv_ui中的成员名（对象指针写回该成员，省略则不写回）；type为obj/img/label/cpicker；
+img的"src"为图像文件路径，label的"text"为静态文字；"hidden"/"click"为可选的布尔值。
+属性名为LV_STYLE_*去掉前缀的小写形式：*_color取"#RRGGBB"，*_opa与opa_scale取0~255或LV_OPA_*，
+其余为整数或C常量；指针类属性（字体、图片、文字、过渡）不能放入常量表，仍在源码中设置。
+"""
+
+import glob, json, os, re, sys
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+UI_SOURCES = "ui/*.json"
+OUT_C = "src/ui_tables.c"
+OUT_H = "include/ui_tables.h"
+
+TYPES = {"obj": ("UI_OBJ_BASE", "LV_OBJ"), "img": ("UI_OBJ_IMG", "LV_IMG"),
+         "label": ("UI_OBJ_LABEL", "LV_LABEL"), "cpicker": ("UI_OBJ_CPICKER", "LV_CPICKER")}
+STATES = ("default", "checked", "focused", "edited", "hovered", "pressed", "disabled")
+POINTER_PROPS = ("text_font", "value_font", "value_str", "pattern_image", "transition_path")
+
+
+class UiError(Exception):
+    pass
+
+
+def c_str(s):
+    return "\"" + s.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n") + "\""
+
+
+def c_ident(name, what):
+    if not re.fullmatch(r"[A-Za-z_]\w*", name):
+        raise UiError("{}名不是合法的C标识符: {}".format(what, name))
+    return name
+
+
+def prop_value(prop, value):
+    """属性值 -> UI_INT/UI_COLOR/UI_OPA"""
+    if prop.endswith("_color"):
+        m = re.fullmatch(r"(?:#|0x)([0-9a-fA-F]{6})", str(value))
+        if not m:
+            raise UiError("{}需要#RRGGBB: {}".format(prop, value))
+        return "UI_COLOR(0x{})".format(m.group(1).upper())
+    if isinstance(value, bool) or not isinstance(value, (int, str)):
+        raise UiError("{}的值无效: {}".format(prop, value))
+    if isinstance(value, str) and not re.fullmatch(r"[A-Z_][A-Z0-9_]*", value):
+        raise UiError("{}的值应为整数或C常量: {}".format(prop, value))
+    if prop.endswith("_opa") or prop == "opa_scale":
+        if isinstance(value, int) and not 0 <= value <= 255:
+            raise UiError("{}超出0~255: {}".format(prop, value))
+        return "UI_OPA({})".format(value)
+    if isinstance(value, int) and not -32768 <= value <= 32767:
+        raise UiError("{}超出lv_style_int_t: {}".format(prop, value))
+    return "UI_INT({})".format(value)
+
+
+def compile_style(name, states):
+    lines = []
+    for state, props in states.items():
+        if state not in STATES:
+            raise UiError("样式{}的状态无效: {}".format(name, state))
+        for prop, value in props.items():
+            if prop in POINTER_PROPS:
+                raise UiError("样式{}: 指针属性{}不能放入常量表".format(name, prop))
+            c_ident(prop, "属性")
+            lines.append("\tUI_PROP(LV_STYLE_{}, LV_STATE_{}), {},".format(
+                prop.upper(), state.upper(), prop_value(prop, value)))
+    out = ["static const uint8_t {}_map[] = {{".format(name)]
+    out += lines
+    out.append("\tUI_STYLE_END")
+    out.append("};")
+    out.append("static const lv_style_t {} = UI_STYLE_INIT({}_map);".format(name, name))
+    return "\n".join(out)
+
+
+def compile_screen(desc, path):
+    scr = c_ident(desc.get("screen", ""), "屏幕")
+    styles = desc.get("styles", {})
+    objects = desc.get("objects", [])
+    if not objects:
+        raise UiError("{}: 没有对象".format(path))
+
+    parts = [compile_style(c_ident(n, "样式"), s) for n, s in styles.items()]
+    index = {}
+    refs = []
+    defs = []
+    for i, o in enumerate(objects):
+        kind = o.get("type", "obj")
+        if kind not in TYPES:
+            raise UiError("{}: 对象类型无效: {}".format(path, kind))
+        ui_type, prefix = TYPES[kind]
+        oid = o.get("id")
+        if oid:
+            index[c_ident(oid, "对象")] = i
+        label = oid or "{}_{}".format(scr, i)
+
+        if i == 0:
+            if "parent" in o:
+                raise UiError("{}: 第0项为屏幕根对象，不能有父对象".format(path))
+            parent = "UI_NO_PARENT"
+        else:
+            p = o.get("parent", 0)
+            p = index.get(p) if isinstance(p, str) else p
+            if p is None or not 0 <= p < i:
+                raise UiError("{}: {}的父对象必须排在前面".format(path, label))
+            parent = str(p)
+
+        style_refs = o.get("styles", {})
+        srefs = "NULL"
+        if style_refs:
+            items = []
+            for part, sname in style_refs.items():
+                if sname not in styles:
+                    raise UiError("{}: {}引用了不存在的样式{}".format(path, label, sname))
+                part_c = part if part.startswith("LV_") else "{}_PART_{}".format(prefix, part.upper())
+                items.append("\t{{ {}, &{} }},".format(part_c, sname))
+            srefs = "{}_styles".format(label)
+            refs.append("static const ui_style_ref_t {}[] = {{\n{}\n}};".format(srefs, "\n".join(items)))
+
+        src = "NULL"
+        if kind == "img" and "src" in o:
+            src = c_str(o["src"])
+        elif kind == "label" and "text" in o:
+            src = c_str(o["text"])
+        arg = "0"
+        if kind == "cpicker":
+            arg = "LV_CPICKER_TYPE_" + o.get("cpicker_type", "disc").upper()
+
+        align = o.get("align")
+        align = "UI_NO_ALIGN" if align is None else "LV_ALIGN_" + align.upper()
+        flags = []
+        if o.get("hidden"):
+            flags.append("UI_F_HIDDEN")
+        if o.get("click") is False:
+            flags.append("UI_F_NO_CLICK")
+        x, y = o.get("pos", [0, 0])
+        w, h = o.get("size", [0, 0])
+        slot = "offsetof(lv_ui, {})".format(oid) if oid else "UI_NO_SLOT"
+        defs.append("\t{{ {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {} }},".format(
+            slot, parent, ui_type, align, " | ".join(flags) or "0", arg, x, y, w, h, src, srefs,
+            len(style_refs)))
+
+    parts += refs
+    parts.append("static const ui_obj_def_t {}_objs[] = {{\n{}\n}};".format(scr, "\n".join(defs)))
+    parts.append("const ui_scr_def_t ui_scr_{} = {{ {}, {}_objs, {} }};".format(scr, c_str(scr), scr, len(objects)))
+    return scr, "/* {} */\n\n".format(os.path.basename(path)) + "\n\n".join(parts)
+
+
+def generate(project_dir=PROJECT_DIR):
+    screens = []
+    bodies = []
+    for path in sorted(glob.glob(os.path.join(project_dir, UI_SOURCES))):
+        with open(path, encoding="utf-8") as f:
+            desc = json.load(f)
+        scr, body = compile_screen(desc, path)
+        screens.append(scr)
+        bodies.append(body)
+
+    banner = "/*\n * 由scripts/ui_compile.py根据ui目录下的屏幕描述生成，请勿手工修改\n */\n\n"
+    c = banner + "#include \"ui_tables.h\"\n#include \"gui_guider.h\"\n#include <stddef.h>\n\n" + \
+        "\n\n".join(bodies) + "\n"
+    h = banner + "#ifndef UI_TABLES_H\n#define UI_TABLES_H\n\n#include \"ui_builder.h\"\n\n" + \
+        "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n" + \
+        "".join("\textern const ui_scr_def_t ui_scr_{};\n".format(s) for s in screens) + \
+        "\n#ifdef __cplusplus\n}\n#endif\n\n#endif\n"
+    return c, h, screens
+
+
+def write_if_changed(path, text):
+    if os.path.isfile(path):
+        with open(path, encoding="utf-8", newline="") as f:
+            if f.read() == text:
+                return False
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write(text)
+    return True
+
+
+def run(project_dir=PROJECT_DIR):
+    c, h, screens = generate(project_dir)
+    changed = write_if_changed(os.path.join(project_dir, OUT_C), c)
+    changed |= write_if_changed(os.path.join(project_dir, OUT_H), h)
+    print("ui_compile: {}个屏幕（{}）{}".format(len(screens), " ".join(screens), "，已更新" if changed else ""))
+
+
+if __name__ == "__main__":
+    try:
+        run()
+    except (UiError, ValueError) as e:
+        sys.exit("ui_compile: {}".format(e))
+else:
+    Import("env")
+    try:
+        run(env.subst("$PROJECT_DIR"))
+    except (UiError, ValueError) as e:
+        sys.stderr.write("ui_compile: {}\n".format(e))
+        env.Exit(1)
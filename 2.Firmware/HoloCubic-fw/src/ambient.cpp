@@ -1,55 +1,131 @@
 #include "ambient.h"
+#include "sensor_bus.h"
+#include "render_prof.h"
 
+// 统计窗口在总线任务中累加、在读取方任务中取走
+static portMUX_TYPE window_mux = portMUX_INITIALIZER_UNLOCKED;
 
+/**
+ * 初始化BH1750
+ *
+ * @param mode 测量模式，单次模式会换成对应的连续模式（单次模式每次读取后都要重新写模式字节）
+ */
 void Ambient::init(int mode)
 {
+	// 单次模式0x2X与连续模式0x1X的分辨率与测量时间一一对应
+	if ((mode & 0xF0) == 0x20) mode -= 0x10;
 	mMode = mode;
 	switch (mode)
 	{
-	case ONE_TIME_H_RESOLUTION_MODE:
+	case CONTINUOUS_H_RESOLUTION_MODE:
 		sample_time = 125;
 		break;
-	case ONE_TIME_H_RESOLUTION_MODE2:
+	case CONTINUOUS_H_RESOLUTION_MODE2:
 		sample_time = 125;
 		break;
-	case ONE_TIME_L_RESOLUTION_MODE:
+	case CONTINUOUS_L_RESOLUTION_MODE:
 		sample_time = 20;
 		break;
 	}
 
-	Wire.begin(AMB_I2C_SDA, AMB_I2C_SCL);
+	busy = false;
+	valid = false;
+	published = 0;
+	sensor_window_reset(&window);
 
-	delay(50);
+	// 与IMU共用总线，已初始化时直接返回；失败时mMode清零，sample()不再提交读取
+	cmd = mMode;
+	mMode = 0;
+	if (!i2c_bus.begin(AMB_I2C_SDA, AMB_I2C_SCL)) return;
 
-	Wire.beginTransmission(ADDRESS_BH1750FVI); //"notify" the matching device
-	Wire.write(mMode);     //set operation mode
-	Wire.endTransmission();
+	// 写一次模式字节即开始连续测量（异步，不等待上电延时）
+	I2cTransaction t = { ADDRESS_BH1750FVI, &cmd, 1, NULL, 0, NULL, NULL };
+	if (i2c_bus.submit(t)) mMode = cmd;
 }
 
-unsigned int Ambient::getLux()
+/**
+ * 提交一次读取（传感器任务中由总线按测量周期调用，上次还未完成时跳过）
+ * 总线在init之后一个周期才第一次调用，此时第一次测量已完成
+ */
+void Ambient::sample()
+{
+	if (busy || mMode == 0) return;
+
+	I2cTransaction t = { ADDRESS_BH1750FVI, NULL, 0, raw, 2, onRead, this };
+	submit_us = render_prof_now();
+	busy = i2c_bus.submit(t);
+}
+
+uint16_t Ambient::getPeriod()
+{
+	return (uint16_t)sample_time;
+}
+
+/**
+ * 读取回调（在总线任务中执行），更新滑动平均并发布
+ */
+void Ambient::onRead(esp_err_t err, void* user)
 {
-	if (millis() - last_time > sample_time)
+	Ambient* self = (Ambient*)user;
+	render_prof_add(RENDER_PROF_AMBIENT, (uint32_t)(render_prof_now() - self->submit_us));
+	if (err == ESP_OK)
 	{
-		last_time = millis();
-		Wire.requestFrom(ADDRESS_BH1750FVI, 2); //ask Arduino to read back 2 bytes from the sensor
-		highByte = Wire.read();  // get the high byte
-		lowByte = Wire.read(); // get the low byte
+		self->highByte = self->raw[0];
+		self->lowByte = self->raw[1];
+		self->sensorOut = (self->highByte << 8) | self->lowByte;
+		// 读数 / 1.2为照度（lx），总线回调中用整数计算
+		self->illuminance = self->sensorOut * 5 / 6;
 
-		sensorOut = (highByte << 8) | lowByte;
-		illuminance = sensorOut / 1.2;
+		// 第一次读数填满整个窗口，避免开机后平均值从0爬升
+		if (!self->valid)
+			for (int i = 4; i > 0; i--) self->lux[i] = self->illuminance;
+		for (int i = 4; i > 0; i--) self->lux[i] = self->lux[i - 1];
+		self->lux[0] = self->illuminance;
 
-		for (int i = 4; i > 0; i--) lux[i] = lux[i - 1];
-		lux[0] = illuminance;
+		unsigned int avg = 0;
+		for (int i = 4; i >= 0; i--) avg += self->lux[i];
+		self->published = avg / 5;
+		self->valid = true;
 
-		Wire.beginTransmission(ADDRESS_BH1750FVI); //"notify" the matching device
-		Wire.write(mMode);     //set operation mode
-		Wire.endTransmission();
+		portENTER_CRITICAL(&window_mux);
+		sensor_window_add(&self->window, self->illuminance);
+		portEXIT_CRITICAL(&window_mux);
+
+		SensorSample s = {};
+		s.time_ms = millis();
+		s.lux = (uint16_t)self->illuminance;
+		s.lux_avg = (uint16_t)self->published;
+		self->busy = false;
+		sensorbus.publish(SENSOR_AMBIENT, &s);
+		return;
 	}
+	self->busy = false;
+}
 
-	unsigned int avg = 0;
-	for (int i = 4; i >= 0; i--) avg += lux[i];
-	avg /= 5;
+/**
+ * 获取环境光照度（最近5次的平均值）
+ * 只读取已发布的结果，任意任务中调用均为O(1)且不访问总线
+ */
+unsigned int Ambient::getLux()
+{
+	return published;
+}
 
-	return avg;
+/**
+ * 传感器是否存在并已有测量结果（未焊接BH1750时一直为false）
+ */
+bool Ambient::available()
+{
+	return valid;
 }
 
+/**
+ * 取走上次调用以来的照度统计（最小/最大/平均按单次读数计算），窗口随即清零
+ */
+void Ambient::takeWindow(SensorWindow* out)
+{
+	portENTER_CRITICAL(&window_mux);
+	*out = window;
+	sensor_window_reset(&window);
+	portEXIT_CRITICAL(&window_mux);
+}
@@ -0,0 +1,353 @@
+/*
+ * HoloCubic 应用框架
+ *
+ * 功能说明：
+ * 1. 应用以App结构登记生命周期回调：on_enter / on_loop / on_background / on_exit
+ * 2. 同一时间只有一个前台应用，切换时原前台应用转入后台（或停止），
+ *    后台应用以较低频率回调，多个应用的轮询开销不再全部落在每一帧上
+ * 3. 每次回调统计耗时与堆变化：超出CPU预算时限速，持续超预算的后台应用与超出内存预算的应用被停止
+ * 4. on_enter期间打开样式分配区，界面的样式属性表与本地样式整块分配、界面删除后整块释放
+ * 5. 所有回调由一个LVGL定时器驱动，定时器周期设为最近一个应用的到期时间，
+ *    没有应用运行时暂停，LVGL任务照常按最近定时器休眠
+ *
+ * 输出格式：
+ * APP,名称,状态,内存字节,平均耗时us,最大耗时us,限速倍数
+ */
+
+#include "app_manager.h"
+#include "lv_port_mem.h"
+#include "logger.h"
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+
+AppManager apps;
+
+static const char* state_name[] = { "stopped", "foreground", "background" };
+
+/**
+ * 创建调度定时器（LVGL初始化之后调用）
+ */
+void AppManager::begin()
+{
+	fg = -1;
+	task = lv_task_create(taskCb, APP_FG_PERIOD_MS, LV_TASK_PRIO_OFF, this);
+}
+
+/**
+ * 登记应用
+ * @return 应用编号，表已满时返回-1
+ */
+int AppManager::add(const App& app)
+{
+	if (count >= APP_MAX)
+	{
+		LOG_E("app", "应用表已满，%s未登记", app.name);
+		return -1;
+	}
+
+	Entry* e = &entries[count];
+	memset(e, 0, sizeof(Entry));
+	e->app = app;
+	if (e->app.fg_period_ms == 0) e->app.fg_period_ms = APP_FG_PERIOD_MS;
+	e->state = APP_STOPPED;
+	e->throttle = 1;
+	return count++;
+}
+
+/**
+ * 切换到前台（未运行时先检查内存预算并启动）
+ * @return 内存不足或on_enter中超出预算时返回false
+ */
+bool AppManager::open(uint8_t id)
+{
+	if (id >= count) return false;
+	Entry* e = &entries[id];
+	if (fg == id) return true;
+
+	if (e->state == APP_STOPPED)
+	{
+		lv_port_mem_stats_t mem;
+		lv_port_mem_get_stats(&mem);
+		uint32_t avail = heap_caps_get_free_size(MALLOC_CAP_8BIT) + mem.heap_free;
+		if (e->app.ram_budget && avail < e->app.ram_budget)
+		{
+			LOG_W("app", "应用%s需要%u字节，剩余%u字节，未启动", e->app.name, e->app.ram_budget, avail);
+			return false;
+		}
+		e->ram_used = 0;
+		e->cpu_avg_us = 0;
+		e->cpu_max_us = 0;
+		e->throttle = 1;
+		e->strikes = 0;
+		e->good_runs = 0;
+	}
+
+	if (fg >= 0) enterBackground(fg);
+
+	fg = id;
+	e->state = APP_FOREGROUND;
+	e->due = millis();
+	if (!enter(id))
+	{
+		stop(id);
+		return false;
+	}
+	schedule();
+	return true;
+}
+
+/**
+ * 轮播切换：没有前台应用时从第一个开始；打开失败的应用跳过，转完一圈仍失败时返回false
+ */
+bool AppManager::openNext(int8_t dir)
+{
+	if (count == 0) return false;
+	// 打开失败时原前台应用已转入后台，按起点继续找
+	int start = fg;
+	int id = start;
+	for (uint8_t n = 0; n < count; n++)
+	{
+		if (id < 0) id = dir > 0 ? 0 : count - 1;
+		else id = (id + (dir > 0 ? 1 : count - 1)) % count;
+		if (id == start) return false;
+		if (open(id)) return true;
+	}
+	return false;
+}
+
+/**
+ * 停止应用（调用on_exit）
+ */
+void AppManager::stop(uint8_t id)
+{
+	if (id >= count) return;
+	Entry* e = &entries[id];
+	if (e->state == APP_STOPPED) return;
+
+	// 先改状态，on_exit中的超预算不再触发停止
+	e->state = APP_STOPPED;
+	if (fg == id) fg = -1;
+	call(id, e->app.on_exit);
+	if (e->ram_used > APP_LEAK_WARN)
+		LOG_W("app", "应用%s停止后仍有%d字节未释放", e->app.name, e->ram_used);
+	schedule();
+}
+
+/**
+ * 重新进入前台应用：依次调用on_background与on_enter，按当前的文字与字体重建界面（如切换语言之后）
+ * 应用保持运行，不经过后台调度
+ */
+void AppManager::reload()
+{
+	if (fg < 0 || fg >= count) return;
+	uint8_t id = fg;
+	Entry* e = &entries[id];
+	if (!call(id, e->app.on_background) || !enter(id)) stop(id);
+}
+
+/**
+ * 当前前台应用编号，没有时返回-1
+ */
+int AppManager::foreground()
+{
+	return fg;
+}
+
+uint8_t AppManager::getCount()
+{
+	return count;
+}
+
+const App* AppManager::getApp(uint8_t id)
+{
+	return id < count ? &entries[id].app : NULL;
+}
+
+bool AppManager::isForeground(uint8_t id)
+{
+	return fg == id;
+}
+
+int AppManager::find(const char* name)
+{
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (strcmp(entries[i].app.name, name) == 0) return i;
+	}
+	return -1;
+}
+
+const char* AppManager::getName(uint8_t id)
+{
+	return id < count ? entries[id].app.name : NULL;
+}
+
+AppState AppManager::getState(uint8_t id)
+{
+	return id < count ? entries[id].state : APP_STOPPED;
+}
+
+/**
+ * 输出各应用的资源统计（APP,开头的行为CSV）
+ */
+void AppManager::report()
+{
+	for (uint8_t i = 0; i < count; i++)
+	{
+		const Entry* e = &entries[i];
+		Serial.printf("APP,%s,%s,%d,%u,%u,%u\n", e->app.name, state_name[e->state], e->ram_used,
+					  e->cpu_avg_us, e->cpu_max_us, e->throttle);
+	}
+}
+
+/**
+ * LVGL堆已分配字节减去系统堆剩余字节，只用于计算回调前后的差值
+ */
+/**
+ * 调用on_enter：期间新建的样式从分配区顺序分配
+ * 分配区本身也记到应用名下，界面对象全部删除时释放的是同一块内存
+ */
+bool AppManager::enter(uint8_t id)
+{
+	Entry* e = &entries[id];
+#if LV_USE_STYLE_ARENA
+	int32_t mem0 = heapUsed();
+	lv_style_arena_t* arena = lv_style_arena_open(APP_STYLE_ARENA);
+	e->ram_used += heapUsed() - mem0;
+	bool ok = call(id, e->app.on_enter);
+	mem0 = heapUsed();
+	lv_style_arena_close(arena);
+	e->ram_used += heapUsed() - mem0;
+	return ok;
+#else
+	return call(id, e->app.on_enter);
+#endif
+}
+
+int32_t AppManager::heapUsed()
+{
+	lv_port_mem_stats_t mem;
+	lv_port_mem_get_stats(&mem);
+	return (int32_t)mem.used_size - (int32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+/**
+ * 执行一个回调并记账
+ * @return 超出内存预算，或后台应用持续超出CPU预算时返回false（由调用方停止应用）
+ */
+bool AppManager::call(uint8_t id, app_hook_t hook)
+{
+	if (hook == NULL) return true;
+	Entry* e = &entries[id];
+
+	int32_t mem0 = heapUsed();
+	int64_t t0 = esp_timer_get_time();
+	hook(e->app.user);
+	uint32_t dt = (uint32_t)(esp_timer_get_time() - t0);
+	e->ram_used += heapUsed() - mem0;
+
+	e->cpu_avg_us = e->cpu_avg_us ? (e->cpu_avg_us * 7 + dt) / 8 : dt;
+	if (dt > e->cpu_max_us) e->cpu_max_us = dt;
+
+	uint32_t budget = e->app.cpu_budget_us;
+	if (budget && dt > budget)
+	{
+		e->good_runs = 0;
+		if (e->throttle < APP_THROTTLE_MAX)
+		{
+			e->throttle *= 2;
+			LOG_W("app", "应用%s耗时%uus超出预算%uus，周期放慢到%u倍", e->app.name, dt, budget, e->throttle);
+		}
+		else if (e->strikes < 255)
+		{
+			e->strikes++;
+		}
+	}
+	else if (budget && dt < budget / 2)
+	{
+		e->strikes = 0;
+		if (e->throttle > 1 && ++e->good_runs >= APP_RECOVER_RUNS)
+		{
+			e->throttle /= 2;
+			e->good_runs = 0;
+		}
+	}
+
+	if (e->state == APP_STOPPED) return true;
+	if (e->app.ram_budget && e->ram_used > (int32_t)e->app.ram_budget)
+	{
+		LOG_W("app", "应用%s占用%d字节超出预算%u字节，已停止", e->app.name, e->ram_used, e->app.ram_budget);
+		return false;
+	}
+	if (e->state == APP_BACKGROUND && e->strikes >= APP_CPU_STRIKES)
+	{
+		LOG_W("app", "后台应用%s持续超出CPU预算，已停止", e->app.name);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 原前台应用离开前台：调用on_background，不在后台运行的应用随后停止
+ */
+void AppManager::enterBackground(uint8_t id)
+{
+	Entry* e = &entries[id];
+	fg = -1;
+	e->state = APP_BACKGROUND;
+	if (!call(id, e->app.on_background) || e->app.bg_period_ms == 0)
+	{
+		stop(id);
+		return;
+	}
+	e->due = millis() + e->app.bg_period_ms * e->throttle;
+}
+
+/**
+ * 按最近一个到期的应用设置定时器周期，没有应用运行时暂停定时器
+ */
+void AppManager::schedule()
+{
+	if (task == NULL) return;
+
+	uint32_t now = millis();
+	uint32_t next = UINT32_MAX;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		const Entry* e = &entries[i];
+		if (e->state == APP_STOPPED || e->app.on_loop == NULL) continue;
+		int32_t left = (int32_t)(e->due - now);
+		if (left < 1) left = 1;
+		if ((uint32_t)left < next) next = left;
+	}
+
+	if (next == UINT32_MAX)
+	{
+		lv_task_set_prio(task, LV_TASK_PRIO_OFF);
+		return;
+	}
+	lv_task_set_prio(task, LV_TASK_PRIO_MID);
+	lv_task_set_period(task, next);
+	lv_task_reset(task);
+}
+
+/**
+ * 调度定时器：回调所有到期的应用
+ */
+void AppManager::taskCb(lv_task_t* t)
+{
+	AppManager* self = (AppManager*)t->user_data;
+	uint32_t now = millis();
+
+	for (uint8_t i = 0; i < self->count; i++)
+	{
+		Entry* e = &self->entries[i];
+		if (e->state == APP_STOPPED || e->app.on_loop == NULL) continue;
+		if ((int32_t)(now - e->due) < 0) continue;
+
+		uint16_t period = e->state == APP_FOREGROUND ? e->app.fg_period_ms : e->app.bg_period_ms;
+		e->due = now + period * e->throttle;
+		if (!self->call(i, e->app.on_loop)) self->stop(i);
+	}
+	self->schedule();
+}
@@ -0,0 +1,663 @@
+/*
+ * HoloCubic 应用模块
+ *
+ * 功能说明：
+ * 1. addApps()查找SD卡AMOD_DIR下的.ham文件与资源包中名称以mod_开头的数据，校验文件头后按其中的名称、周期与预算登记为应用
+ * 2. 进入前台时载入代码（资源包中的模块直接指向flash映射），建立模块屏幕，执行enter回调
+ * 3. on_loop按模块周期执行loop回调；停止时执行exit回调，删除屏幕并释放代码与解释器状态
+ *
+ * 沙箱：
+ *   指令预算（每次回调） + 栈/调用栈/全局变量/代码地址检查 + 对象表（只能操作自己创建的对象）
+ *   + 字符串只取常量数据（显示前检查结尾） + 内存/CPU预算（AppManager记账）
+ *
+ * 注意事项：
+ * - 没有采用原生ELF：ESP32不能从PSRAM取指，位置无关代码需重定位到IRAM且无法隔离出错的模块；
+ *   也没有引入wasm3（解释器本身约60KB flash），界面与传感器接口很窄时字节码解释器已足够
+ * - 模块出错（越界、超出预算）后不再执行，屏幕上显示出错原因，离开前台后正常停止
+ */
+
+#include "app_module.h"
+#include "buf_manager.h"
+#include "sd_card.h"
+#include "sensor_bus.h"
+#include "asset_bundle.h"
+#include "i18n.h"
+#include "time_service.h"
+#include "logger.h"
+#include <esp_system.h>
+
+AppModules modules;
+
+enum
+{
+	OBJ_NONE = 0,
+	OBJ_LABEL,
+	OBJ_BAR
+};
+
+static lv_color_t rgb_color(int32_t rgb)
+{
+	return lv_color_make((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+}
+
+static inline uint16_t rd16(const uint8_t* p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline int32_t rd32(const uint8_t* p)
+{
+	return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+/**** 解释器 ****/
+
+ModuleVm::ModuleVm()
+{
+	code = NULL;
+	data = NULL;
+	globals = NULL;
+	stack = NULL;
+	scr = NULL;
+	code_size = 0;
+	data_size = 0;
+	global_count = 0;
+	stack_size = 0;
+	sp = 0;
+	depth = 0;
+	obj_count = 0;
+	step_budget = AMOD_STEPS_DEFAULT;
+	steps = 0;
+	fault = AMOD_OK;
+	fault_pc = 0;
+}
+
+bool ModuleVm::init(const AppModuleHeader* h, const uint8_t* image, lv_obj_t* s)
+{
+	release();
+	code = image;
+	code_size = h->code_size;
+	data = image + h->code_size;
+	data_size = h->data_size;
+	global_count = h->globals;
+	stack_size = h->stack;
+	step_budget = h->step_budget ? h->step_budget : AMOD_STEPS_DEFAULT;
+	scr = s;
+	// 全局变量与栈频繁随机访问，放片内内存
+	globals = (int32_t*)buf_calloc(BUF_FAST, global_count + stack_size, sizeof(int32_t));
+	if (globals == NULL) return false;
+	stack = globals + global_count;
+	fault = AMOD_OK;
+	return true;
+}
+
+void ModuleVm::release()
+{
+	if (globals) buf_free(globals);
+	globals = NULL;
+	stack = NULL;
+	// 对象随模块屏幕一起删除
+	obj_count = 0;
+	scr = NULL;
+}
+
+bool ModuleVm::trap(AmodFault f, uint32_t pc)
+{
+	fault = f;
+	fault_pc = pc;
+	return false;
+}
+
+AmodFault ModuleVm::getFault()
+{
+	return fault;
+}
+
+uint32_t ModuleVm::getFaultPc()
+{
+	return fault_pc;
+}
+
+uint32_t ModuleVm::getSteps()
+{
+	return steps;
+}
+
+const char* ModuleVm::faultName(AmodFault f)
+{
+	static const char* const names[] = {
+		"ok", "budget", "stack", "opcode", "address", "div0", "syscall", "object", "string"
+	};
+	return (unsigned)f < sizeof(names) / sizeof(names[0]) ? names[f] : "?";
+}
+
+/**
+ * 常量数据中的字符串：偏移越界或到数据末尾仍没有'\0'时返回NULL
+ */
+const char* ModuleVm::str(int32_t off)
+{
+	if (off < 0 || (uint32_t)off >= data_size) return NULL;
+	if (memchr(data + off, 0, data_size - off) == NULL) return NULL;
+	return (const char*)data + off;
+}
+
+/**
+ * 按编号取本模块创建的对象，编号无效或类型不符时返回NULL
+ */
+lv_obj_t* ModuleVm::obj(int32_t h, uint8_t type)
+{
+	if (h < 1 || h > obj_count) return NULL;
+	if (type != OBJ_NONE && obj_types[h - 1] != type) return NULL;
+	return objs[h - 1];
+}
+
+int32_t ModuleVm::newObj(lv_obj_t* o, uint8_t type)
+{
+	objs[obj_count] = o;
+	obj_types[obj_count] = type;
+	return ++obj_count;
+}
+
+// 系统调用的参数个数与是否有返回值
+static const uint8_t sys_args[AMOD_SYS_COUNT] = { 0, 2, 2, 3, 2, 3, 4, 2, 2, 1, 1, 1, 0, 0, 1, 1 };
+static const uint8_t sys_ret[AMOD_SYS_COUNT] = { 1, 1, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 1, 1, 0 };
+
+/**
+ * 执行系统调用：参数从栈上取出（a[0]为第一个参数），返回值压栈
+ */
+bool ModuleVm::sys(uint8_t id, uint32_t pc)
+{
+	if (id >= AMOD_SYS_COUNT) return trap(AMOD_FAULT_SYSCALL, pc);
+	uint8_t n = sys_args[id];
+	if (sp < n) return trap(AMOD_FAULT_STACK, pc);
+	if (sys_ret[id] && sp - n >= stack_size) return trap(AMOD_FAULT_STACK, pc);
+	sp -= n;
+	const int32_t* a = stack + sp;
+	int32_t ret = 0;
+	lv_obj_t* o;
+	const char* s;
+	SensorSample ss;
+
+	switch (id)
+	{
+	case AMOD_SYS_MILLIS:
+		ret = (int32_t)millis();
+		break;
+	case AMOD_SYS_LABEL:
+		if (obj_count >= AMOD_OBJ_MAX) return trap(AMOD_FAULT_OBJECT, pc);
+		o = lv_label_create(scr, NULL);
+		lv_obj_set_style_local_text_color(o, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_WHITE);
+		lv_obj_set_style_local_text_font(o, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, i18n.getFont());
+		lv_label_set_text_static(o, "");
+		lv_obj_set_pos(o, a[0], a[1]);
+		ret = newObj(o, OBJ_LABEL);
+		break;
+	case AMOD_SYS_TEXT:
+		if ((o = obj(a[0], OBJ_LABEL)) == NULL) return trap(AMOD_FAULT_OBJECT, pc);
+		if ((s = str(a[1])) == NULL) return trap(AMOD_FAULT_STRING, pc);
+		lv_label_set_text(o, s);
+		break;
+	case AMOD_SYS_NUM:
+	{
+		if ((o = obj(a[0], OBJ_LABEL)) == NULL) return trap(AMOD_FAULT_OBJECT, pc);
+		if ((s = str(a[1])) == NULL) return trap(AMOD_FAULT_STRING, pc);
+		// 模块的字符串不作为printf格式，只替换第一个"%d"
+		char text[AMOD_TEXT_MAX];
+		const char* d = strstr(s, "%d");
+		if (d) snprintf(text, sizeof(text), "%.*s%d%s", (int)(d - s), s, a[2], d + 2);
+		else snprintf(text, sizeof(text), "%s", s);
+		lv_label_set_text(o, text);
+		break;
+	}
+	case AMOD_SYS_COLOR:
+		if ((o = obj(a[0], OBJ_NONE)) == NULL) return trap(AMOD_FAULT_OBJECT, pc);
+		if (obj_types[a[0] - 1] == OBJ_LABEL)
+			lv_obj_set_style_local_text_color(o, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, rgb_color(a[1]));
+		else
+			lv_obj_set_style_local_bg_color(o, LV_BAR_PART_INDIC, LV_STATE_DEFAULT, rgb_color(a[1]));
+		break;
+	case AMOD_SYS_POS:
+		if ((o = obj(a[0], OBJ_NONE)) == NULL) return trap(AMOD_FAULT_OBJECT, pc);
+		lv_obj_set_pos(o, a[1], a[2]);
+		break;
+	case AMOD_SYS_BAR:
+		if (obj_count >= AMOD_OBJ_MAX) return trap(AMOD_FAULT_OBJECT, pc);
+		o = lv_bar_create(scr, NULL);
+		lv_obj_set_pos(o, a[0], a[1]);
+		lv_obj_set_size(o, LV_MATH_MAX(a[2], 1), LV_MATH_MAX(a[3], 1));
+		lv_bar_set_range(o, 0, 100);
+		ret = newObj(o, OBJ_BAR);
+		break;
+	case AMOD_SYS_BAR_SET:
+		if ((o = obj(a[0], OBJ_BAR)) == NULL) return trap(AMOD_FAULT_OBJECT, pc);
+		lv_bar_set_value(o, constrain(a[1], 0, 100), LV_ANIM_OFF);
+		break;
+	case AMOD_SYS_HIDE:
+		if ((o = obj(a[0], OBJ_NONE)) == NULL) return trap(AMOD_FAULT_OBJECT, pc);
+		lv_obj_set_hidden(o, a[1] != 0);
+		break;
+	case AMOD_SYS_BG:
+		lv_obj_set_style_local_bg_color(scr, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, rgb_color(a[0]));
+		break;
+	case AMOD_SYS_ACCEL:
+		if (a[0] >= 0 && a[0] < 3 && sensorbus.get(SENSOR_IMU, &ss)) ret = (int32_t)ss.accel[a[0]] * 1000 / 16384;
+		break;
+	case AMOD_SYS_GYRO:
+		// ±250dps：131 LSB/(°/s)
+		if (a[0] >= 0 && a[0] < 3 && sensorbus.get(SENSOR_IMU, &ss)) ret = (int32_t)ss.gyro[a[0]] * 100 / 131;
+		break;
+	case AMOD_SYS_LUX:
+		ret = sensorbus.get(SENSOR_AMBIENT, &ss) ? ss.lux_avg : -1;
+		break;
+	case AMOD_SYS_TIME:
+		ret = (int32_t)timesvc.now();
+		break;
+	case AMOD_SYS_RAND:
+		ret = a[0] > 0 ? (int32_t)(esp_random() % (uint32_t)a[0]) : 0;
+		break;
+	case AMOD_SYS_LOG:
+		if ((s = str(a[0])) == NULL) return trap(AMOD_FAULT_STRING, pc);
+		LOG_I("module", "%s", s);
+		break;
+	}
+	if (sys_ret[id]) stack[sp++] = ret;
+	return true;
+}
+
+// 栈检查：need为需要的操作数个数，push为执行后净增加的个数
+#define NEED(n) do { if (sp < (n)) return trap(AMOD_FAULT_STACK, op_pc); } while (0)
+#define ROOM(n) do { if (sp + (n) > stack_size) return trap(AMOD_FAULT_STACK, op_pc); } while (0)
+#define IMM(n) do { if (pc + (n) > code_size) return trap(AMOD_FAULT_ADDRESS, op_pc); } while (0)
+#define BINOP(expr) do { NEED(2); int32_t b = stack[--sp]; int32_t a = stack[sp - 1]; stack[sp - 1] = (expr); } while (0)
+
+/**
+ * 执行一个回调直到HALT或最外层的RET
+ * 算术按32位补码回绕（无符号运算后转换，避免有符号溢出）
+ */
+bool ModuleVm::run(uint16_t entry)
+{
+	if (fault != AMOD_OK) return false;
+	if (entry == AMOD_NO_ENTRY) return true;
+	uint32_t pc = entry;
+	sp = 0;
+	depth = 0;
+	steps = 0;
+
+	for (;;)
+	{
+		uint32_t op_pc = pc;
+		if (++steps > step_budget) return trap(AMOD_FAULT_BUDGET, op_pc);
+		if (pc >= code_size) return trap(AMOD_FAULT_ADDRESS, op_pc);
+		uint8_t op = code[pc++];
+
+		switch (op)
+		{
+		case AMOD_NOP:
+			break;
+		case AMOD_PUSH:
+			IMM(4);
+			ROOM(1);
+			stack[sp++] = rd32(code + pc);
+			pc += 4;
+			break;
+		case AMOD_PUSH8:
+			IMM(1);
+			ROOM(1);
+			stack[sp++] = (int8_t)code[pc++];
+			break;
+		case AMOD_DUP:
+			NEED(1);
+			ROOM(1);
+			stack[sp] = stack[sp - 1];
+			sp++;
+			break;
+		case AMOD_DROP:
+			NEED(1);
+			sp--;
+			break;
+		case AMOD_SWAP:
+		{
+			NEED(2);
+			int32_t t = stack[sp - 1];
+			stack[sp - 1] = stack[sp - 2];
+			stack[sp - 2] = t;
+			break;
+		}
+		case AMOD_OVER:
+			NEED(2);
+			ROOM(1);
+			stack[sp] = stack[sp - 2];
+			sp++;
+			break;
+		case AMOD_LOAD:
+		{
+			IMM(2);
+			uint16_t g = rd16(code + pc);
+			pc += 2;
+			if (g >= global_count) return trap(AMOD_FAULT_ADDRESS, op_pc);
+			ROOM(1);
+			stack[sp++] = globals[g];
+			break;
+		}
+		case AMOD_STORE:
+		{
+			IMM(2);
+			uint16_t g = rd16(code + pc);
+			pc += 2;
+			if (g >= global_count) return trap(AMOD_FAULT_ADDRESS, op_pc);
+			NEED(1);
+			globals[g] = stack[--sp];
+			break;
+		}
+		case AMOD_LOADI:
+		{
+			NEED(1);
+			int32_t g = stack[sp - 1];
+			if (g < 0 || g >= global_count) return trap(AMOD_FAULT_ADDRESS, op_pc);
+			stack[sp - 1] = globals[g];
+			break;
+		}
+		case AMOD_STOREI:
+		{
+			NEED(2);
+			int32_t v = stack[--sp];
+			int32_t g = stack[--sp];
+			if (g < 0 || g >= global_count) return trap(AMOD_FAULT_ADDRESS, op_pc);
+			globals[g] = v;
+			break;
+		}
+
+		case AMOD_ADD: BINOP((int32_t)((uint32_t)a + (uint32_t)b)); break;
+		case AMOD_SUB: BINOP((int32_t)((uint32_t)a - (uint32_t)b)); break;
+		case AMOD_MUL: BINOP((int32_t)((uint32_t)a * (uint32_t)b)); break;
+		case AMOD_DIV:
+		case AMOD_MOD:
+		{
+			NEED(2);
+			int32_t b = stack[sp - 1];
+			int32_t a = stack[sp - 2];
+			if (b == 0) return trap(AMOD_FAULT_DIV0, op_pc);
+			sp--;
+			// INT32_MIN / -1溢出：按回绕结果
+			if (b == -1) stack[sp - 1] = op == AMOD_DIV ? (int32_t)(0U - (uint32_t)a) : 0;
+			else stack[sp - 1] = op == AMOD_DIV ? a / b : a % b;
+			break;
+		}
+		case AMOD_NEG:
+			NEED(1);
+			stack[sp - 1] = (int32_t)(0U - (uint32_t)stack[sp - 1]);
+			break;
+		case AMOD_AND: BINOP(a & b); break;
+		case AMOD_OR: BINOP(a | b); break;
+		case AMOD_XOR: BINOP(a ^ b); break;
+		case AMOD_SHL: BINOP((int32_t)((uint32_t)a << (b & 31))); break;
+		case AMOD_SHR: BINOP(a >> (b & 31)); break;
+		case AMOD_NOT:
+			NEED(1);
+			stack[sp - 1] = stack[sp - 1] == 0;
+			break;
+
+		case AMOD_EQ: BINOP(a == b); break;
+		case AMOD_NE: BINOP(a != b); break;
+		case AMOD_LT: BINOP(a < b); break;
+		case AMOD_LE: BINOP(a <= b); break;
+		case AMOD_GT: BINOP(a > b); break;
+		case AMOD_GE: BINOP(a >= b); break;
+
+		case AMOD_JMP:
+		case AMOD_JZ:
+		case AMOD_JNZ:
+		case AMOD_CALL:
+		{
+			IMM(2);
+			uint16_t target = rd16(code + pc);
+			pc += 2;
+			bool take = true;
+			if (op == AMOD_JZ || op == AMOD_JNZ)
+			{
+				NEED(1);
+				int32_t v = stack[--sp];
+				take = op == AMOD_JZ ? v == 0 : v != 0;
+			}
+			if (op == AMOD_CALL)
+			{
+				if (depth >= AMOD_CALL_DEPTH) return trap(AMOD_FAULT_STACK, op_pc);
+				calls[depth++] = pc;
+			}
+			if (take) pc = target;
+			break;
+		}
+		case AMOD_RET:
+			if (depth == 0) return true;
+			pc = calls[--depth];
+			break;
+		case AMOD_SYS:
+			IMM(1);
+			if (!sys(code[pc++], op_pc)) return false;
+			break;
+		case AMOD_HALT:
+			return true;
+		default:
+			return trap(AMOD_FAULT_OPCODE, op_pc);
+		}
+	}
+}
+
+#undef NEED
+#undef ROOM
+#undef IMM
+#undef BINOP
+
+/**** 模块管理 ****/
+
+AppModules::AppModules()
+{
+	count = 0;
+}
+
+/**
+ * 校验模块头：格式、版本、各段大小与入口地址（size为文件或资源的总字节数）
+ */
+bool AppModules::check(AppModuleHeader* h, uint32_t size)
+{
+	if (memcmp(h->magic, AMOD_MAGIC, 4) != 0 || h->version > AMOD_VERSION || h->header_size < sizeof(AppModuleHeader))
+		return false;
+	if (h->api_version > AMOD_API_VERSION) return false;
+	if (h->code_size == 0 || h->code_size > AMOD_CODE_MAX || h->data_size > AMOD_DATA_MAX) return false;
+	if ((uint64_t)h->header_size + h->code_size + h->data_size > size) return false;
+	if (h->globals > AMOD_GLOBALS_MAX || h->stack == 0 || h->stack > AMOD_STACK_MAX) return false;
+	uint16_t entries[3] = { h->entry_enter, h->entry_loop, h->entry_exit };
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		if (entries[i] != AMOD_NO_ENTRY && entries[i] >= h->code_size) return false;
+	}
+	h->name[AMOD_NAME_LEN - 1] = '\0';
+	return h->name[0] != '\0';
+}
+
+AppModules::Slot* AppModules::addSlot(const AppModuleHeader* h, const char* path, bool flash)
+{
+	if (count >= AMOD_MAX_MODULES) return NULL;
+	Slot* s = &slots[count];
+	memcpy(&s->h, h, sizeof(AppModuleHeader));
+	strlcpy(s->path, path, sizeof(s->path));
+	s->flash = flash;
+	s->image = NULL;
+	s->loaded = NULL;
+	s->scr = NULL;
+	s->prev_scr = NULL;
+
+	App& a = s->app;
+	memset(&a, 0, sizeof(a));
+	a.name = s->h.name;
+	a.on_enter = enterCb;
+	a.on_loop = loopCb;
+	a.on_exit = exitCb;
+	a.ram_budget = h->ram_budget ? h->ram_budget : AMOD_RAM_DEFAULT;
+	a.cpu_budget_us = h->cpu_budget_us;
+	a.fg_period_ms = h->fg_period_ms;
+	a.user = s;
+	if (apps.add(a) < 0) return NULL;
+	count++;
+	return s;
+}
+
+/**
+ * SD卡AMOD_DIR下的*.ham：只读取文件头
+ */
+uint8_t AppModules::scanSd()
+{
+	uint8_t n = 0;
+	File dir = SD_FS.open(AMOD_DIR);
+	if (!dir) return 0;
+	File f;
+	while ((f = dir.openNextFile()))
+	{
+		const char* name = strrchr(f.name(), '/');
+		name = name ? name + 1 : f.name();
+		size_t len = strlen(name);
+		AppModuleHeader h;
+		char path[AMOD_PATH_MAX];
+		snprintf(path, sizeof(path), AMOD_DIR "/%s", name);
+		bool ok = len > 4 && strcmp(name + len - 4, ".ham") == 0 && strlen(path) < sizeof(path) - 1 &&
+				  f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && check(&h, f.size());
+		uint32_t size = f.size();
+		f.close();
+		if (!ok)
+		{
+			if (len > 4 && strcmp(name + len - 4, ".ham") == 0) LOG_W("app", "应用模块无效: %s（%u字节）", path, size);
+			continue;
+		}
+		if (addSlot(&h, path, false) == NULL) break;
+		n++;
+	}
+	dir.close();
+	return n;
+}
+
+/**
+ * 资源包中名称以AMOD_ASSET_PREFIX开头的数据（直接在flash映射上执行）
+ */
+uint8_t AppModules::scanAssets()
+{
+	uint8_t n = 0;
+	for (uint16_t i = 0; i < assets.getCount(); i++)
+	{
+		const char* name = assets.getName(i);
+		if (strncmp(name, AMOD_ASSET_PREFIX, sizeof(AMOD_ASSET_PREFIX) - 1) != 0) continue;
+		uint32_t size = 0;
+		const uint8_t* p = assets.getData(name, &size);
+		AppModuleHeader h;
+		if (p == NULL || size < sizeof(h)) continue;
+		memcpy(&h, p, sizeof(h));
+		if (!check(&h, size))
+		{
+			LOG_W("app", "应用模块无效: %s（资源包）", name);
+			continue;
+		}
+		Slot* s = addSlot(&h, name, true);
+		if (s == NULL) break;
+		s->image = p + h.header_size;
+		n++;
+	}
+	return n;
+}
+
+uint8_t AppModules::addApps()
+{
+	uint8_t n = scanAssets();
+	n += scanSd();
+	if (n) LOG_I("app", "登记应用模块%u个", n);
+	return n;
+}
+
+uint8_t AppModules::getCount()
+{
+	return count;
+}
+
+const char* AppModules::getName(uint8_t i)
+{
+	return i < count ? slots[i].h.name : NULL;
+}
+
+/**
+ * 载入代码与常量数据（SD卡上的模块，BUF_BULK：有PSRAM时在PSRAM中）
+ */
+bool AppModules::load(Slot* s)
+{
+	if (s->flash) return true;
+	uint32_t len = s->h.code_size + s->h.data_size;
+	s->loaded = (uint8_t*)buf_alloc(BUF_BULK, len);
+	if (s->loaded == NULL) return false;
+	File f = SD_FS.open(s->path);
+	bool ok = f && f.seek(s->h.header_size) && f.read(s->loaded, len) == len;
+	if (f) f.close();
+	if (!ok)
+	{
+		buf_free(s->loaded);
+		s->loaded = NULL;
+		return false;
+	}
+	s->image = s->loaded;
+	return true;
+}
+
+/**
+ * 出错后在模块屏幕上显示原因与位置
+ */
+void AppModules::showFault(Slot* s)
+{
+	AmodFault f = s->vm.getFault();
+	LOG_E("app", "应用模块%s出错: %s（pc=%u，%u条指令）", s->h.name, ModuleVm::faultName(f), s->vm.getFaultPc(),
+		  s->vm.getSteps());
+	if (s->scr == NULL) return;
+	lv_obj_t* label = lv_label_create(s->scr, NULL);
+	lv_obj_set_style_local_text_color(label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_RED);
+	lv_label_set_text_fmt(label, "%s: %s @%u", s->h.name, ModuleVm::faultName(f), s->vm.getFaultPc());
+	lv_obj_align(label, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, -8);
+}
+
+void AppModules::enterCb(void* user)
+{
+	Slot* s = (Slot*)user;
+	if (!modules.load(s))
+	{
+		LOG_W("app", "无法载入应用模块: %s", s->path);
+		return;
+	}
+	s->prev_scr = lv_scr_act();
+	s->scr = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(s->scr, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	if (!s->vm.init(&s->h, s->image, s->scr))
+	{
+		lv_obj_del(s->scr);
+		s->scr = NULL;
+		return;
+	}
+	lv_scr_load(s->scr);
+	if (!s->vm.run(s->h.entry_enter)) modules.showFault(s);
+}
+
+void AppModules::loopCb(void* user)
+{
+	Slot* s = (Slot*)user;
+	if (s->scr == NULL || s->vm.getFault() != AMOD_OK) return;
+	if (!s->vm.run(s->h.entry_loop)) modules.showFault(s);
+}
+
+void AppModules::exitCb(void* user)
+{
+	Slot* s = (Slot*)user;
+	if (s->scr)
+	{
+		s->vm.run(s->h.entry_exit);
+		if (s->prev_scr) lv_scr_load(s->prev_scr);
+		lv_obj_del(s->scr);
+		s->scr = NULL;
+	}
+	s->vm.release();
+	if (s->loaded) buf_free(s->loaded);
+	s->loaded = NULL;
+	if (!s->flash) s->image = NULL;
+}
@@ -0,0 +1,222 @@
+/*
+ * HoloCubic 应用预热
+ *
+ * 功能说明：
+ * 1. 低优先级LVGL定时器发现前台应用变化时记录一次切换（from -> to），并按导航图选出接下来最可能进入的应用
+ * 2. 等切换动画结束、LVGL任务空闲时，每个周期预热候选应用的一项资源（App::assets）
+ * 3. 图像只放进图像缓存的剩余空间，不淘汰已缓存的图像；字体与文件不占用额外内存
+ *
+ * 候选顺序：
+ *   得分 = 切换次数 * 2 + （轮播中相邻 ? 1 : 0），取得分最高的APP_PREFETCH_DEPTH个
+ *   没有切换记录时即轮播的前后两个应用；用户的习惯（如时钟 -> 天气）建立后排在前面
+ *
+ * 注意事项：
+ * - 单项预热在LVGL任务中同步执行（解码整幅文件图像可能需要几十毫秒），只在空闲率足够且没有动画时进行
+ * - 资源包图像与内置图像多为不需要解码的真彩色数据，预热对它们只是一次缓存命中
+ */
+
+#include "app_prefetch.h"
+#include "asset_bundle.h"
+#include "buf_manager.h"
+#include "i18n.h"
+#include "logger.h"
+
+AppPrefetch prefetcher;
+
+AppPrefetch::AppPrefetch()
+{
+	task = NULL;
+	reset();
+}
+
+void AppPrefetch::begin()
+{
+	if (task) return;
+	task = lv_task_create(taskCb, APP_PREFETCH_PERIOD_MS, LV_TASK_PRIO_LOWEST, this);
+}
+
+void AppPrefetch::reset()
+{
+	last_fg = -1;
+	start_at = 0;
+	memset(counts, 0, sizeof(counts));
+	plan_count = 0;
+	plan_pos = 0;
+	asset_pos = 0;
+	spent = 0;
+	warmed = 0;
+	skipped = 0;
+}
+
+void AppPrefetch::report()
+{
+	Serial.printf("PREFETCH,%u,%u,%u\n", warmed, skipped, spent);
+}
+
+/**
+ * 记录一次切换，计数饱和时该行减半
+ */
+void AppPrefetch::record(int from, int to)
+{
+	if (from < 0 || from >= APP_MAX || to < 0 || to >= APP_MAX || from == to) return;
+	uint8_t* row = counts[from];
+	if (row[to] >= APP_PREFETCH_COUNT_MAX)
+	{
+		for (uint8_t i = 0; i < APP_MAX; i++) row[i] /= 2;
+	}
+	row[to]++;
+}
+
+/**
+ * 按得分选出候选应用（只考虑登记了资源的应用）
+ */
+void AppPrefetch::buildPlan(int fg)
+{
+	uint8_t n = apps.getCount();
+	uint16_t score[APP_MAX];
+	for (uint8_t i = 0; i < n; i++)
+	{
+		const App* app = apps.getApp(i);
+		score[i] = 0;
+		if (i == fg || app->assets == NULL || app->asset_count == 0) continue;
+		score[i] = counts[fg][i] * 2;
+		if (i == (fg + 1) % n || i == (fg + n - 1) % n) score[i]++;
+	}
+
+	plan_count = 0;
+	while (plan_count < APP_PREFETCH_DEPTH)
+	{
+		int best = -1;
+		for (uint8_t i = 0; i < n; i++)
+		{
+			if (score[i] && (best < 0 || score[i] > score[best])) best = i;
+		}
+		if (best < 0) break;
+		plan[plan_count++] = best;
+		score[best] = 0;
+	}
+	plan_pos = 0;
+	asset_pos = 0;
+}
+
+/**
+ * 预热一项资源
+ * @return 已预热（或已在缓存中）时返回true，不满足预算或资源不存在时返回false
+ */
+bool AppPrefetch::warm(const AppAsset* a)
+{
+	switch (a->type)
+	{
+	case APP_ASSET_IMAGE:
+		return a->src && warmImage(a->src);
+	case APP_ASSET_BUNDLE:
+	{
+		const lv_img_dsc_t* img = a->src ? assets.getImage((const char*)a->src) : NULL;
+		return img && warmImage(img);
+	}
+	case APP_ASSET_FONT:
+		if (a->text == NULL) return false;
+		warmFont(a->src ? (const lv_font_t*)a->src : i18n.getFont(), a->text);
+		return true;
+	case APP_ASSET_FILE:
+		if (a->src == NULL) return false;
+		warmFile((const char*)a->src);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * 把图像解码进缓存
+ * 按图像头估算解码后的大小，只在缓存有空闲表项与剩余字节、且本轮未超出预算时打开，
+ * 打开后按缓存实际增加的字节记账（已缓存的图像不增加）
+ */
+bool AppPrefetch::warmImage(const void* src)
+{
+	lv_img_header_t header;
+	if (lv_img_decoder_get_info((const char*)src, &header) != LV_RES_OK) return false;
+	uint32_t px = lv_img_cf_has_alpha(header.cf) ? LV_IMG_PX_SIZE_ALPHA_BYTE : LV_COLOR_SIZE / 8;
+	uint32_t size = (uint32_t)header.w * header.h * px;
+
+	lv_img_cache_stats_t st;
+	lv_img_cache_get_stats(&st);
+	if (st.entries >= st.entries_max) return false;
+	if (st.bytes_budget && st.bytes_used + size > st.bytes_budget) return false;
+	if (spent + size > APP_PREFETCH_BUDGET || buf_largest(BUF_BULK) < size) return false;
+
+	uint32_t used0 = st.bytes_used;
+	if (_lv_img_cache_open(src, LV_COLOR_BLACK) == NULL) return false;
+	lv_img_cache_get_stats(&st);
+	spent += st.bytes_used > used0 ? st.bytes_used - used0 : 0;
+	return true;
+}
+
+/**
+ * 查找文字中每个字符的字形并读取位图
+ * 内置字体与语言包的字形表、位图都在flash中，按cache行读一遍即进入flash cache
+ */
+void AppPrefetch::warmFont(const lv_font_t* font, const char* text)
+{
+	uint32_t i = 0;
+	volatile uint8_t sink = 0;
+	while (text[i])
+	{
+		uint32_t letter = _lv_txt_encoded_next(text, &i);
+		lv_font_glyph_dsc_t g;
+		if (!lv_font_get_glyph_dsc(font, &g, letter, 0)) continue;
+		const uint8_t* bmp = lv_font_get_glyph_bitmap(font, letter);
+		if (bmp == NULL) continue;
+		uint32_t len = ((uint32_t)g.box_w * g.box_h * g.bpp + 7) / 8;
+		for (uint32_t k = 0; k < len; k += 32) sink += bmp[k];
+	}
+	(void)sink;
+}
+
+/**
+ * 打开后关闭：只读句柄留在lv_fs的句柄缓存中
+ */
+void AppPrefetch::warmFile(const char* path)
+{
+	lv_fs_file_t f;
+	if (lv_fs_open(&f, path, LV_FS_MODE_RD) == LV_FS_RES_OK) lv_fs_close(&f);
+}
+
+/**
+ * 预热定时器：前台变化时重新规划，空闲时预热一项
+ */
+void AppPrefetch::taskCb(lv_task_t* t)
+{
+	AppPrefetch* self = (AppPrefetch*)t->user_data;
+	int fg = apps.foreground();
+	if (fg != self->last_fg)
+	{
+		if (fg >= 0)
+		{
+			self->record(self->last_fg, fg);
+			self->buildPlan(fg);
+		}
+		else
+		{
+			self->plan_count = 0;
+		}
+		self->last_fg = fg;
+		self->start_at = millis() + APP_PREFETCH_DELAY_MS;
+		self->spent = 0;
+		return;
+	}
+
+	if (self->plan_pos >= self->plan_count) return;
+	if ((int32_t)(millis() - self->start_at) < 0) return;
+	if (lv_anim_count_running() || lv_task_get_idle() < APP_PREFETCH_IDLE_MIN) return;
+
+	const App* app = apps.getApp(self->plan[self->plan_pos]);
+	if (app == NULL || self->asset_pos >= app->asset_count)
+	{
+		self->plan_pos++;
+		self->asset_pos = 0;
+		return;
+	}
+	if (self->warm(&app->assets[self->asset_pos++])) self->warmed++;
+	else self->skipped++;
+}
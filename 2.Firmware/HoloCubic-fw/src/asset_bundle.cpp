@@ -0,0 +1,140 @@
+/*
+ * HoloCubic 资源包模块
+ *
+ * 功能说明：
+ * 1. 在flash专用分区中存放常用界面图像（Logo、图标等），不再编译进固件
+ * 2. 分区映射到数据地址空间，图像按需经flash cache读取，零拷贝
+ * 3. 界面按名称取lv_img_dsc_t，加载时不需要访问SD卡
+ *
+ * 资源包生成与烧录：
+ *   python get_holo.py --assets assets.bin logo.png icon_wifi.png ...
+ *   esptool.py write_flash 0x290000 assets.bin
+ */
+
+#include "asset_bundle.h"
+#include <Arduino.h>
+
+AssetBundle assets;
+
+AssetBundle::AssetBundle()
+{
+	map = 0;
+	base = NULL;
+	entries = NULL;
+	count = 0;
+	dscs = NULL;
+}
+
+/**
+ * 映射资源包分区并建立图像描述符
+ * 分区不存在或未烧录资源包时返回false，界面应退回内置资源
+ */
+bool AssetBundle::begin()
+{
+	if (base) return true;
+
+	const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+		(esp_partition_subtype_t)ASSET_PARTITION_SUBTYPE, ASSET_PARTITION_LABEL);
+	if (part == NULL)
+	{
+		Serial.println("未找到资源包分区");
+		return false;
+	}
+
+	AssetHeader hdr;
+	if (esp_partition_read(part, 0, &hdr, sizeof(hdr)) != ESP_OK ||
+		memcmp(hdr.magic, ASSET_MAGIC, 4) != 0 || hdr.version > ASSET_VERSION ||
+		hdr.size > part->size || hdr.size < sizeof(hdr) + hdr.count * sizeof(AssetEntry))
+	{
+		Serial.println("资源包分区为空或格式错误");
+		return false;
+	}
+
+	const void* ptr;
+	if (esp_partition_mmap(part, 0, hdr.size, ESP_PARTITION_MMAP_DATA, &ptr, &map) != ESP_OK)
+	{
+		Serial.println("资源包映射失败");
+		return false;
+	}
+	base = (const uint8_t*)ptr;
+	entries = (const AssetEntry*)(base + sizeof(AssetHeader));
+
+	dscs = (lv_img_dsc_t*)calloc(hdr.count, sizeof(lv_img_dsc_t));
+	if (dscs == NULL)
+	{
+		end();
+		return false;
+	}
+	count = hdr.count;
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		const AssetEntry& e = entries[i];
+		if (e.offset + e.size > hdr.size || e.size < sizeof(lv_img_header_t)) continue;
+		memcpy(&dscs[i].header, base + e.offset, sizeof(lv_img_header_t));
+		dscs[i].data = base + e.offset + sizeof(lv_img_header_t);
+		dscs[i].data_size = e.size - sizeof(lv_img_header_t);
+	}
+
+	Serial.printf("资源包已映射: %u个资源, %u字节\n", count, hdr.size);
+	return true;
+}
+
+/**
+ * 取消映射（之后不能再使用已返回的描述符）
+ */
+void AssetBundle::end()
+{
+	if (base) spi_flash_munmap(map);
+	base = NULL;
+	entries = NULL;
+	if (dscs) free(dscs);
+	dscs = NULL;
+	count = 0;
+}
+
+/**
+ * 按名称查找图像（资源数量少，线性查找）
+ *
+ * @return 图像描述符，data指向flash；未找到返回NULL
+ */
+const lv_img_dsc_t* AssetBundle::getImage(const char* name)
+{
+	for (uint16_t i = 0; i < count; i++)
+	{
+		if (strncmp(entries[i].name, name, ASSET_NAME_LEN) == 0)
+			return dscs[i].data ? &dscs[i] : NULL;
+	}
+	return NULL;
+}
+
+/**
+ * 按名称取原始数据（含4字节图像头），用于非图像资源
+ */
+const uint8_t* AssetBundle::getData(const char* name, uint32_t* size)
+{
+	for (uint16_t i = 0; i < count; i++)
+	{
+		if (strncmp(entries[i].name, name, ASSET_NAME_LEN) == 0)
+		{
+			if (size) *size = entries[i].size;
+			return base + entries[i].offset;
+		}
+	}
+	return NULL;
+}
+
+uint16_t AssetBundle::getCount()
+{
+	return count;
+}
+
+const char* AssetBundle::getName(uint16_t i)
+{
+	return i < count ? entries[i].name : NULL;
+}
+
+const lv_img_dsc_t* asset_image(const char* name)
+{
+	return assets.getImage(name);
+}
@@ -0,0 +1,490 @@
+/*
+ * HoloCubic 异步图像加载
+ *
+ * 功能说明：
+ * 1. set()把lv_img对象绑定到缓存槽：已解码的直接显示，否则先显示占位图并唤醒后台任务
+ * 2. 后台任务每次取最近请求的一个槽解码（JPEG经tjpgd缩放，真彩色.bin按行读取），
+ *    像素直接写入槽的缓冲，完成后通过runtime.post通知LVGL任务
+ * 3. LVGL任务把绑定到该槽的对象换成解码结果；缓存槽按最近使用淘汰，只淘汰没有对象引用的槽
+ *
+ * 线程说明：
+ * - LVGL任务：绑定、显示、淘汰与释放（READY/FAILED的槽只由LVGL任务处理）
+ * - 后台任务（IMGLOAD_TASK_CORE）：QUEUED -> DECODING -> READY/FAILED；
+ *   解码期间引用归零时在下一个条带中止，释放缓冲后槽回到EMPTY（中止前又被请求时重新排队）
+ * - 槽状态只在imgload_mux内修改，缓冲的分配与释放都在锁外
+ *
+ * 数据流：
+ *   set --> QUEUED --> workerEntry：serve --> decode --> runtime.post --> onReady --> lv_img_set_src
+ */
+
+#include "async_image.h"
+#include "buf_manager.h"
+#include "sd_card.h"
+#include "sd_hotplug.h"
+#include "logger.h"
+#include "telemetry.h"
+#include <src/lv_gpu/lv_gpu_esp32.h>  // 面板字节序时的交换复制
+
+#define SLOT_EMPTY 0
+#define SLOT_QUEUED 1
+#define SLOT_DECODING 2
+#define SLOT_READY 3
+#define SLOT_FAILED 4
+
+AsyncImage imgloader;
+
+static portMUX_TYPE imgload_mux = portMUX_INITIALIZER_UNLOCKED;
+static lv_signal_cb_t ancestor_signal = NULL;
+
+AsyncImage::AsyncImage()
+{
+	memset(slots, 0, sizeof(slots));
+	memset(binds, 0, sizeof(binds));
+	use_seq = 0;
+	worker = NULL;
+	decoding = NULL;
+	aborted = false;
+	out_w = out_h = 0;
+	decoded = 0;
+	failed = 0;
+}
+
+bool AsyncImage::begin()
+{
+	if (worker) return true;
+	if (xTaskCreatePinnedToCore(workerEntry, "imgload", IMGLOAD_TASK_STACK, this,
+								IMGLOAD_TASK_PRIORITY, &worker, IMGLOAD_TASK_CORE) != pdPASS)
+	{
+		worker = NULL;
+		LOG_E("imgload", "后台任务创建失败");
+		return false;
+	}
+	return true;
+}
+
+/**** 缓存槽与绑定（LVGL任务） ****/
+
+int8_t AsyncImage::findSlot(const char* path, uint16_t max_w, uint16_t max_h)
+{
+	for (uint8_t i = 0; i < IMGLOAD_SLOTS; i++)
+	{
+		ImgSlot* s = &slots[i];
+		if (s->state == SLOT_EMPTY) continue;
+		if (s->max_w == max_w && s->max_h == max_h && strcmp(s->path, path) == 0) return i;
+	}
+	return -1;
+}
+
+/**
+ * 取一个空槽：没有时淘汰没有引用、最久未用的已完成槽
+ */
+int8_t AsyncImage::freeSlot()
+{
+	int8_t victim = -1;
+	for (uint8_t i = 0; i < IMGLOAD_SLOTS; i++)
+	{
+		ImgSlot* s = &slots[i];
+		if (s->state == SLOT_EMPTY) return i;
+		if (s->refs || (s->state != SLOT_READY && s->state != SLOT_FAILED)) continue;
+		if (victim < 0 || s->used < slots[victim].used) victim = i;
+	}
+	if (victim < 0) return -1;
+
+	ImgSlot* s = &slots[victim];
+	// 缓存按描述符地址查找，同一地址之后对应新的内容
+	lv_img_cache_invalidate_src(&s->dsc);
+	buf_free(s->buf);
+	s->buf = NULL;
+	portENTER_CRITICAL(&imgload_mux);
+	s->state = SLOT_EMPTY;
+	portEXIT_CRITICAL(&imgload_mux);
+	return victim;
+}
+
+ImgBinding* AsyncImage::findBinding(lv_obj_t* img)
+{
+	for (uint8_t i = 0; i < IMGLOAD_BINDINGS; i++)
+	{
+		if (binds[i].img == img) return &binds[i];
+	}
+	return NULL;
+}
+
+/**
+ * 槽的引用减一：归零时尚未开始的解码直接取消，正在进行的通知后台任务中止；已完成的留在缓存中
+ */
+void AsyncImage::release(int8_t slot)
+{
+	ImgSlot* s = &slots[slot];
+	if (s->refs == 0 || --s->refs) return;
+	portENTER_CRITICAL(&imgload_mux);
+	if (s->state == SLOT_QUEUED) s->state = SLOT_EMPTY;
+	else if (s->state == SLOT_DECODING) s->cancel = true;
+	portEXIT_CRITICAL(&imgload_mux);
+}
+
+/**
+ * 显示槽的结果；缓冲分配失败时退回LVGL的S:解码器（绘制时同步解码，总比不显示好），其他失败保留占位图
+ */
+void AsyncImage::apply(lv_obj_t* img, ImgSlot* s)
+{
+	if (s->state == SLOT_READY)
+	{
+		lv_img_set_src(img, &s->dsc);
+	}
+	else if (s->state == SLOT_FAILED && s->nomem)
+	{
+		char p[IMGLOAD_PATH_MAX + 2];
+		snprintf(p, sizeof(p), "S:%s", s->path);
+		lv_img_set_src(img, p);
+	}
+}
+
+bool AsyncImage::set(lv_obj_t* img, const char* path, const void* placeholder, uint16_t max_w, uint16_t max_h)
+{
+	if (img == NULL || path == NULL || strlen(path) >= IMGLOAD_PATH_MAX) return false;
+
+	int8_t i = findSlot(path, max_w, max_h);
+	ImgBinding* b = findBinding(img);
+	if (b && b->slot == i)
+	{
+		slots[i].used = ++use_seq;
+		return true;
+	}
+	if (b)
+	{
+		cancel(img);
+	}
+	else if (lv_obj_get_signal_cb(img) != signalCb)
+	{
+		// 对象删除时解除绑定
+		if (ancestor_signal == NULL) ancestor_signal = lv_obj_get_signal_cb(img);
+		lv_obj_set_signal_cb(img, signalCb);
+	}
+	b = findBinding(NULL);
+	if (i < 0 && b) i = freeSlot();
+	if (b == NULL || i < 0)
+	{
+		if (placeholder) lv_img_set_src(img, placeholder);
+		LOG_W("imgload", "%s: %s已满", path, b ? "缓存槽" : "绑定");
+		return false;
+	}
+
+	ImgSlot* s = &slots[i];
+	if (s->state == SLOT_EMPTY)
+	{
+		strcpy(s->path, path);
+		s->max_w = max_w;
+		s->max_h = max_h;
+		s->nomem = false;
+		s->refs = 0;
+		s->buf = NULL;
+		portENTER_CRITICAL(&imgload_mux);
+		s->cancel = false;
+		s->state = SLOT_QUEUED;
+		portEXIT_CRITICAL(&imgload_mux);
+		if (worker) xTaskNotifyGive(worker);
+	}
+	else
+	{
+		// 解码中的槽刚被取消又被请求：继续解码
+		portENTER_CRITICAL(&imgload_mux);
+		s->cancel = false;
+		portEXIT_CRITICAL(&imgload_mux);
+	}
+	s->refs++;
+	s->used = ++use_seq;
+	b->img = img;
+	b->slot = i;
+
+	if (s->state == SLOT_READY || s->state == SLOT_FAILED) apply(img, s);
+	else if (placeholder) lv_img_set_src(img, placeholder);
+	return true;
+}
+
+void AsyncImage::cancel(lv_obj_t* img)
+{
+	ImgBinding* b = findBinding(img);
+	if (b == NULL || img == NULL) return;
+	// 不再引用槽的缓冲：之后槽可能被淘汰
+	if (lv_img_get_src(img) == &slots[b->slot].dsc) lv_img_set_src(img, NULL);
+	release(b->slot);
+	b->img = NULL;
+}
+
+void AsyncImage::flush()
+{
+	for (uint8_t i = 0; i < IMGLOAD_SLOTS; i++)
+	{
+		ImgSlot* s = &slots[i];
+		if (s->refs || (s->state != SLOT_READY && s->state != SLOT_FAILED)) continue;
+		lv_img_cache_invalidate_src(&s->dsc);
+		buf_free(s->buf);
+		s->buf = NULL;
+		portENTER_CRITICAL(&imgload_mux);
+		s->state = SLOT_EMPTY;
+		portEXIT_CRITICAL(&imgload_mux);
+	}
+}
+
+/**
+ * 解码完成：绑定到该槽的对象换成解码结果
+ */
+void AsyncImage::onReady(const UiMsg* msg)
+{
+	AsyncImage* self = (AsyncImage*)msg->obj;
+	ImgSlot* s = &self->slots[msg->value];
+	if (s->state != SLOT_READY && s->state != SLOT_FAILED) return;
+	for (uint8_t i = 0; i < IMGLOAD_BINDINGS; i++)
+	{
+		if (self->binds[i].img && self->binds[i].slot == msg->value) self->apply(self->binds[i].img, s);
+	}
+}
+
+lv_res_t AsyncImage::signalCb(lv_obj_t* obj, lv_signal_t sign, void* param)
+{
+	if (sign == LV_SIGNAL_CLEANUP)
+	{
+		ImgBinding* b = imgloader.findBinding(obj);
+		if (b)
+		{
+			imgloader.release(b->slot);
+			b->img = NULL;
+		}
+	}
+	return ancestor_signal(obj, sign, param);
+}
+
+/**** 后台任务 ****/
+
+void AsyncImage::workerEntry(void* arg)
+{
+	AsyncImage* self = (AsyncImage*)arg;
+	for (;;)
+	{
+		// SD卡正在重新挂载时定期重试，否则等待新的请求
+		bool idle = self->serve();
+		ulTaskNotifyTake(pdTRUE, idle ? portMAX_DELAY : pdMS_TO_TICKS(IMGLOAD_RETRY_MS));
+	}
+}
+
+/**
+ * 依次解码排队的槽（最近请求的优先）
+ * @return 队列已空时返回true，SD卡不可用时返回false
+ */
+bool AsyncImage::serve()
+{
+	for (;;)
+	{
+		ImgSlot* s = NULL;
+		int8_t idx = -1;
+		portENTER_CRITICAL(&imgload_mux);
+		for (uint8_t i = 0; i < IMGLOAD_SLOTS; i++)
+		{
+			if (slots[i].state != SLOT_QUEUED) continue;
+			if (s == NULL || slots[i].used > s->used)
+			{
+				s = &slots[i];
+				idx = i;
+			}
+		}
+		if (s) s->state = SLOT_DECODING;
+		portEXIT_CRITICAL(&imgload_mux);
+		if (s == NULL) return true;
+
+		if (!sdhotplug.beginIo())
+		{
+			portENTER_CRITICAL(&imgload_mux);
+			s->state = s->cancel ? SLOT_EMPTY : SLOT_QUEUED;
+			portEXIT_CRITICAL(&imgload_mux);
+			return false;
+		}
+		uint32_t t0 = millis();
+		bool ok = decode(s);
+		sdhotplug.endIo();
+		if (!ok)
+		{
+			// 解码中的槽LVGL任务不会访问，缓冲在锁外释放
+			buf_free(s->buf);
+			s->buf = NULL;
+		}
+
+		// 解码完成时引用已归零的结果同样留在缓存中
+		portENTER_CRITICAL(&imgload_mux);
+		if (ok) s->state = SLOT_READY;
+		else if (s->cancel) s->state = SLOT_EMPTY;
+		// 中止后又被请求（cancel已清除）：重新排队
+		else if (aborted) s->state = SLOT_QUEUED;
+		else s->state = SLOT_FAILED;
+		bool post = s->state == SLOT_READY || s->state == SLOT_FAILED;
+		portEXIT_CRITICAL(&imgload_mux);
+		decoding = NULL;
+
+		if (ok)
+		{
+			decoded++;
+			LOG_I("imgload", "%s: %ux%u %lums", s->path, s->dsc.header.w, s->dsc.header.h,
+				  (unsigned long)(millis() - t0));
+		}
+		else if (post)
+		{
+			failed++;
+			LOG_W("imgload", "%s: %s", s->path, s->nomem ? "内存不足" : "无法解码");
+		}
+		if (post) runtime.post(onReady, this, idx);
+	}
+}
+
+/**
+ * 按扩展名选择解码方式
+ * @return 失败或被中止（aborted）时返回false
+ */
+bool AsyncImage::decode(ImgSlot* s)
+{
+	decoding = s;
+	aborted = false;
+	const char* ext = strrchr(s->path, '.');
+	if (ext && (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0)) return decodeJpeg(s);
+	if (ext && strcasecmp(ext, ".bin") == 0) return decodeBin(s);
+	return false;
+}
+
+/**
+ * 分配槽的缓冲并填写描述符（真彩色，面板字节序）
+ */
+static bool slot_alloc(ImgSlot* s, uint16_t w, uint16_t h)
+{
+	uint32_t size = (uint32_t)w * h * sizeof(lv_color_t);
+	s->buf = (uint8_t*)buf_alloc(BUF_BULK, size);
+	if (s->buf == NULL)
+	{
+		s->nomem = true;
+		return false;
+	}
+	memset(&s->dsc, 0, sizeof(s->dsc));
+	s->dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+	s->dsc.header.w = w;
+	s->dsc.header.h = h;
+	s->dsc.data_size = size;
+	s->dsc.data = s->buf;
+	return true;
+}
+
+/**
+ * JPEG：IDCT阶段按1/2^scale缩小到不超过max_w x max_h（1/8仍然更大时裁去右下部分）
+ */
+bool AsyncImage::decodeJpeg(ImgSlot* s)
+{
+	src_file = SD_FS.open(s->path);
+	if (!src_file) return false;
+	bool ok = jpeg.open(jpegRead, this);
+	if (ok)
+	{
+		uint16_t w = jpeg.getWidth();
+		uint16_t h = jpeg.getHeight();
+		uint8_t scale = 0;
+		while (scale < 3 && (JpegDecoder::scaledSize(w, scale) > s->max_w ||
+							 JpegDecoder::scaledSize(h, scale) > s->max_h))
+		{
+			scale++;
+		}
+		out_w = LV_MATH_MIN(JpegDecoder::scaledSize(w, scale), s->max_w);
+		out_h = LV_MATH_MIN(JpegDecoder::scaledSize(h, scale), s->max_h);
+		ok = slot_alloc(s, out_w, out_h) && jpeg.decode(jpegBand, this, scale);
+	}
+	if (ok) telemetry_sd_io(src_file.size(), 0);
+	src_file.close();
+	return ok;
+}
+
+/**
+ * 真彩色.bin：不缩放，大于max_w x max_h时只读取左上部分
+ */
+bool AsyncImage::decodeBin(ImgSlot* s)
+{
+	File file = SD_FS.open(s->path);
+	if (!file) return false;
+	lv_img_header_t header;
+	bool ok = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+			  header.cf == LV_IMG_CF_TRUE_COLOR && header.w && header.h;
+	if (ok)
+	{
+		out_w = LV_MATH_MIN(header.w, s->max_w);
+		out_h = LV_MATH_MIN(header.h, s->max_h);
+		ok = slot_alloc(s, out_w, out_h);
+	}
+	uint32_t row_bytes = (uint32_t)header.w * sizeof(lv_color_t);
+	uint32_t out_bytes = (uint32_t)out_w * sizeof(lv_color_t);
+	if (ok && out_bytes == row_bytes)
+	{
+		ok = file.read(s->buf, out_bytes * out_h) == out_bytes * out_h;
+	}
+	else
+	{
+		for (uint16_t y = 0; ok && y < out_h; y++)
+		{
+			if (s->cancel)
+			{
+				aborted = true;
+				ok = false;
+				break;
+			}
+			ok = file.seek(sizeof(lv_img_header_t) + y * row_bytes) &&
+				 file.read(s->buf + y * out_bytes, out_bytes) == out_bytes;
+		}
+	}
+	file.close();
+	if (ok) telemetry_sd_io(out_bytes * out_h, 0);
+	return ok;
+}
+
+uint32_t AsyncImage::jpegRead(void* user, uint8_t* buf, uint32_t len)
+{
+	File& f = ((AsyncImage*)user)->src_file;
+	if (buf == NULL)
+	{
+		uint32_t pos = f.position();
+		uint32_t left = f.size() - pos;
+		if (len > left) len = left;
+		return f.seek(pos + len) ? len : 0;
+	}
+	int n = f.read(buf, len);
+	return n > 0 ? n : 0;
+}
+
+/**
+ * 条带写入槽的缓冲（转换为面板字节序）；引用归零时中止
+ */
+bool AsyncImage::jpegBand(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px)
+{
+	AsyncImage* self = (AsyncImage*)user;
+	ImgSlot* s = self->decoding;
+	if (s->cancel)
+	{
+		self->aborted = true;
+		return false;
+	}
+	if (y >= self->out_h) return true;
+
+	uint16_t rows = LV_MATH_MIN(h, self->out_h - y);
+	lv_color_t* dst = (lv_color_t*)s->buf + (uint32_t)y * self->out_w;
+#if LV_COLOR_16_SWAP
+	lv_gpu_esp32_copy_swap(dst, self->out_w, (const lv_color_t*)px, w, self->out_w, rows);
+#else
+	for (uint16_t r = 0; r < rows; r++)
+	{
+		memcpy(dst + (uint32_t)r * self->out_w, px + (uint32_t)r * w, self->out_w * sizeof(uint16_t));
+	}
+#endif
+	return true;
+}
+
+uint32_t AsyncImage::getDecoded()
+{
+	return decoded;
+}
+
+uint32_t AsyncImage::getFailed()
+{
+	return failed;
+}
@@ -0,0 +1,354 @@
+/*
+ * HoloCubic I2S麦克风与频谱分析模块
+ *
+ * 功能说明：
+ * 1. I2S外设DMA连续采集数字麦克风，音频任务每256个样本（16ms）分析一次最近512个样本
+ * 2. 定点实数FFT：512个实数样本打包为256点复数FFT（Q15旋转因子，每级右移1位），再拆分出实数频谱
+ * 3. 16个对数间隔频带，log2功率经自动增益归一化为0~255，带下落平滑
+ *
+ * 数据流：
+ *   I2S DMA --> raw（32位） --> 去直流 --> frame（最近512个样本） --> Hann窗 --> FFT --> 频带 --> result
+ */
+
+#include "audio_input.h"
+#include <esp_idf_version.h>
+#include <math.h>
+
+AudioInput audio;
+
+static portMUX_TYPE audio_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Q15查找表（begin时用浮点运算生成一次）
+static int16_t hann[AUDIO_FFT_N];
+static int16_t tw_cos[AUDIO_FFT_N / 2];   // cos(2πk/N)
+static int16_t tw_sin[AUDIO_FFT_N / 2];   // sin(2πk/N)
+static bool tables_ready = false;
+
+static inline int32_t clampInt(int32_t v, int32_t lo, int32_t hi)
+{
+	return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static void buildTables()
+{
+	if (tables_ready) return;
+	for (int32_t n = 0; n < AUDIO_FFT_N; n++)
+	{
+		hann[n] = (int16_t)(16383.5f - 16383.5f * cosf(2.0f * (float)M_PI * n / AUDIO_FFT_N));
+	}
+	for (int32_t k = 0; k < AUDIO_FFT_N / 2; k++)
+	{
+		tw_cos[k] = (int16_t)lroundf(32767.0f * cosf(2.0f * (float)M_PI * k / AUDIO_FFT_N));
+		tw_sin[k] = (int16_t)lroundf(32767.0f * sinf(2.0f * (float)M_PI * k / AUDIO_FFT_N));
+	}
+	tables_ready = true;
+}
+
+AudioInput::AudioInput()
+{
+	task = NULL;
+	running = false;
+	done = NULL;
+	listener = NULL;
+	listener_user = NULL;
+	raw = NULL;
+	frame = NULL;
+	fft = NULL;
+	memset(&result, 0, sizeof(result));
+}
+
+/**
+ * 安装I2S驱动并启动音频任务
+ * 没有接麦克风时同样成功（读到的全是0，频谱为空）
+ */
+bool AudioInput::begin()
+{
+	if (running) return true;
+
+	raw = (int32_t*)malloc(AUDIO_HOP * sizeof(int32_t) + 2 * AUDIO_FFT_N * sizeof(int16_t));
+	if (raw == NULL)
+	{
+		Serial.println("音频缓冲分配失败");
+		return false;
+	}
+	frame = (int16_t*)(raw + AUDIO_HOP);
+	fft = frame + AUDIO_FFT_N;
+	memset(frame, 0, AUDIO_FFT_N * sizeof(int16_t));
+	buildTables();
+
+	i2s_config_t cfg;
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX);
+	cfg.sample_rate = AUDIO_SAMPLE_RATE;
+	cfg.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;
+	cfg.channel_format = AUDIO_CHANNEL_FMT;
+	cfg.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+	cfg.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+	cfg.dma_buf_count = AUDIO_DMA_BUFS;
+	cfg.dma_buf_len = AUDIO_HOP;
+
+	i2s_pin_config_t pins;
+	memset(&pins, 0, sizeof(pins));
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 4, 0)
+	pins.mck_io_num = I2S_PIN_NO_CHANGE;
+#endif
+	pins.bck_io_num = AUDIO_PIN_BCLK;
+	pins.ws_io_num = AUDIO_PIN_WS;
+	pins.data_out_num = I2S_PIN_NO_CHANGE;
+	pins.data_in_num = AUDIO_PIN_DIN;
+
+	if (i2s_driver_install(AUDIO_I2S_PORT, &cfg, 0, NULL) != ESP_OK)
+	{
+		Serial.println("I2S驱动安装失败");
+		free(raw);
+		raw = NULL;
+		return false;
+	}
+	if (i2s_set_pin(AUDIO_I2S_PORT, &pins) != ESP_OK)
+	{
+		Serial.println("I2S引脚配置失败");
+		i2s_driver_uninstall(AUDIO_I2S_PORT);
+		free(raw);
+		raw = NULL;
+		return false;
+	}
+
+	if (done == NULL) done = xSemaphoreCreateBinary();
+	fill = 0;
+	dc = 0;
+	ceiling = AUDIO_CEIL_MIN_Q4;
+	portENTER_CRITICAL(&audio_mux);
+	memset(&result, 0, sizeof(result));
+	portEXIT_CRITICAL(&audio_mux);
+
+	// 频带边界：AUDIO_BAND_MIN_HZ到奈奎斯特频率按对数等分，每个频带至少一个频点
+	float bin_hz = (float)AUDIO_SAMPLE_RATE / AUDIO_FFT_N;
+	float ratio = (AUDIO_SAMPLE_RATE / 2.0f) / AUDIO_BAND_MIN_HZ;
+	band_edge[0] = (uint16_t)clampInt(lroundf(AUDIO_BAND_MIN_HZ / bin_hz), 1, AUDIO_FFT_N / 2 - AUDIO_BANDS);
+	for (uint8_t i = 1; i <= AUDIO_BANDS; i++)
+	{
+		int32_t e = lroundf(AUDIO_BAND_MIN_HZ * powf(ratio, (float)i / AUDIO_BANDS) / bin_hz);
+		band_edge[i] = (uint16_t)clampInt(e, band_edge[i - 1] + 1, AUDIO_FFT_N / 2);
+	}
+
+	running = true;
+	if (xTaskCreatePinnedToCore(taskEntry, "audio", AUDIO_TASK_STACK, this,
+								AUDIO_TASK_PRIORITY, &task, AUDIO_TASK_CORE) != pdPASS)
+	{
+		running = false;
+		task = NULL;
+		i2s_driver_uninstall(AUDIO_I2S_PORT);
+		free(raw);
+		raw = NULL;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 停止音频任务并卸载I2S驱动（等待任务退出，最长约一次读取超时）
+ */
+void AudioInput::end()
+{
+	if (task == NULL) return;
+
+	running = false;
+	xSemaphoreTake(done, portMAX_DELAY);
+	task = NULL;
+
+	i2s_driver_uninstall(AUDIO_I2S_PORT);
+	free(raw);
+	raw = NULL;
+	frame = fft = NULL;
+}
+
+bool AudioInput::isRunning()
+{
+	return running;
+}
+
+/**
+ * 读取最近一次分析结果
+ * @return 还没有完成过分析时返回false
+ */
+bool AudioInput::get(AudioSpectrum* out)
+{
+	portENTER_CRITICAL(&audio_mux);
+	*out = result;
+	portEXIT_CRITICAL(&audio_mux);
+	return out->seq != 0;
+}
+
+/**
+ * 设置分析完成回调（在音频任务中执行，应尽快返回）
+ */
+void AudioInput::setListener(audio_spectrum_cb_t cb, void* user)
+{
+	portENTER_CRITICAL(&audio_mux);
+	listener = cb;
+	listener_user = user;
+	portEXIT_CRITICAL(&audio_mux);
+}
+
+/**
+ * 原位基2时间抽取FFT（复数交织存放：re, im, re, im...）
+ * 每级右移1位，输出为DFT / 2^bits；输入各点模值不超过32767时不会溢出
+ *
+ * @param bits 点数 = 2^bits，不超过AUDIO_FFT_BITS - 1（旋转因子表按AUDIO_FFT_N点生成）
+ */
+void AudioInput::fftRadix2(int16_t* data, uint8_t bits)
+{
+	uint16_t n = 1 << bits;
+
+	for (uint16_t i = 1, j = 0; i < n; i++)
+	{
+		uint16_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) j ^= bit;
+		j |= bit;
+		if (i < j)
+		{
+			int16_t tr = data[2 * i], ti = data[2 * i + 1];
+			data[2 * i] = data[2 * j];
+			data[2 * i + 1] = data[2 * j + 1];
+			data[2 * j] = tr;
+			data[2 * j + 1] = ti;
+		}
+	}
+
+	for (uint16_t len = 2; len <= n; len <<= 1)
+	{
+		uint16_t half = len >> 1;
+		uint16_t step = AUDIO_FFT_N / len;
+		for (uint16_t i = 0; i < n; i += len)
+		{
+			int16_t* a = data + 2 * i;
+			int16_t* b = a + 2 * half;
+			for (uint16_t j = 0, k = 0; j < half; j++, k += step)
+			{
+				// t = b * exp(-j2πk/N)
+				int32_t c = tw_cos[k], s = tw_sin[k];
+				int32_t br = b[2 * j], bi = b[2 * j + 1];
+				int32_t tr = (br * c + bi * s) >> 15;
+				int32_t ti = (bi * c - br * s) >> 15;
+				int32_t ar = a[2 * j], ai = a[2 * j + 1];
+				a[2 * j] = (int16_t)((ar + tr) >> 1);
+				a[2 * j + 1] = (int16_t)((ai + ti) >> 1);
+				b[2 * j] = (int16_t)((ar - tr) >> 1);
+				b[2 * j + 1] = (int16_t)((ai - ti) >> 1);
+			}
+		}
+	}
+}
+
+/**
+ * log2(v)，Q4定点（整数部分取最高位位置，小数部分取其后4位）
+ */
+uint16_t AudioInput::log2Q4(uint64_t v)
+{
+	if (v == 0) return 0;
+	uint8_t n = 63 - __builtin_clzll(v);
+	uint8_t frac = n >= 4 ? (uint8_t)(v >> (n - 4)) & 15 : (uint8_t)(v << (4 - n)) & 15;
+	return n * 16 + frac;
+}
+
+/**
+ * 分析最近AUDIO_FFT_N个样本，更新result
+ */
+void AudioInput::analyze()
+{
+	const uint16_t m = AUDIO_FFT_N / 2;
+
+	// 加窗并打包：z[n] = x[2n] + j*x[2n+1]；多右移1位使复数模值不超过32767
+	for (uint16_t i = 0; i < AUDIO_FFT_N; i++) fft[i] = (int16_t)(((int32_t)frame[i] * hann[i]) >> 16);
+	fftRadix2(fft, AUDIO_FFT_BITS - 1);
+
+	// 拆分实数频谱：A = Z[k]，B = conj(Z[m-k])
+	// X[k] = (A + B) / 2 + W^k * (A - B) / 2j，W = exp(-j2π/N)
+	uint64_t power[AUDIO_BANDS];
+	uint64_t total = 0;
+	for (uint8_t b = 0; b < AUDIO_BANDS; b++)
+	{
+		uint64_t sum = 0;
+		for (uint16_t k = band_edge[b]; k < band_edge[b + 1]; k++)
+		{
+			int32_t ar = fft[2 * k], ai = fft[2 * k + 1];
+			int32_t br = fft[2 * (m - k)], bi = -fft[2 * (m - k) + 1];
+			int32_t er = (ar + br) >> 1, ei = (ai + bi) >> 1;
+			int32_t orr = (ai - bi) >> 1, oi = (br - ar) >> 1;
+			int32_t c = tw_cos[k], s = tw_sin[k];
+			int32_t xr = er + ((c * orr + s * oi) >> 15);
+			int32_t xi = ei + ((c * oi - s * orr) >> 15);
+			sum += (uint64_t)((int64_t)xr * xr + (int64_t)xi * xi);
+		}
+		power[b] = sum;
+		total += sum;
+	}
+
+	// 自动增益：满格参考跟随最响的频带，之后缓慢回落
+	uint16_t level[AUDIO_BANDS];
+	int16_t peak = 0;
+	for (uint8_t b = 0; b < AUDIO_BANDS; b++)
+	{
+		level[b] = log2Q4(power[b]);
+		if (level[b] > peak) peak = level[b];
+	}
+	if (peak > ceiling) ceiling = peak;
+	else if (ceiling > AUDIO_CEIL_MIN_Q4) ceiling -= AUDIO_AGC_DECAY_Q4;
+	int16_t floor_q4 = ceiling - AUDIO_RANGE_Q4;
+
+	AudioSpectrum next;
+	portENTER_CRITICAL(&audio_mux);
+	next = result;
+	portEXIT_CRITICAL(&audio_mux);
+
+	for (uint8_t b = 0; b < AUDIO_BANDS; b++)
+	{
+		int32_t v = clampInt(((int32_t)level[b] - floor_q4) * 255 / AUDIO_RANGE_Q4, 0, 255);
+		// 上升立即跟随，下降每次最多AUDIO_FALL
+		int32_t fall = (int32_t)next.bands[b] - AUDIO_FALL;
+		next.bands[b] = (uint8_t)(v > fall ? v : fall);
+	}
+	next.level = (uint8_t)clampInt(((int32_t)log2Q4(total) - floor_q4) * 255 / AUDIO_RANGE_Q4, 0, 255);
+	next.seq++;
+
+	portENTER_CRITICAL(&audio_mux);
+	result = next;
+	audio_spectrum_cb_t cb = listener;
+	void* user = listener_user;
+	portEXIT_CRITICAL(&audio_mux);
+
+	if (cb) cb(&next, user);
+}
+
+/**
+ * 音频任务：读满一个帧移后去直流、移入frame并分析
+ */
+void AudioInput::taskEntry(void* arg)
+{
+	AudioInput* self = (AudioInput*)arg;
+
+	while (self->running)
+	{
+		size_t got = 0;
+		i2s_read(AUDIO_I2S_PORT, self->raw + self->fill, (AUDIO_HOP - self->fill) * sizeof(int32_t),
+				 &got, pdMS_TO_TICKS(100));
+		self->fill += got / sizeof(int32_t);
+		if (self->fill < AUDIO_HOP) continue;
+		self->fill = 0;
+
+		int16_t* in = self->frame + AUDIO_FFT_N - AUDIO_HOP;
+		memmove(self->frame, self->frame + AUDIO_HOP, (AUDIO_FFT_N - AUDIO_HOP) * sizeof(int16_t));
+		for (uint16_t i = 0; i < AUDIO_HOP; i++)
+		{
+			// 一阶高通（时间常数64个样本，约40Hz），dc为Q8
+			int32_t x = self->raw[i] >> AUDIO_SAMPLE_SHIFT;
+			self->dc += ((x << 8) - self->dc) >> 6;
+			x -= self->dc >> 8;
+			in[i] = (int16_t)clampInt(x, -32768, 32767);
+		}
+		self->analyze();
+	}
+
+	xSemaphoreGive(self->done);
+	vTaskDelete(NULL);
+}
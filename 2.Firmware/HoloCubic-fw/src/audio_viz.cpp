@@ -0,0 +1,197 @@
+/*
+ * HoloCubic 音频频谱可视化模块
+ *
+ * 功能说明：
+ * 1. 16根频谱条，按帧只写高度变化的部分（升高取渐变列，降低写黑色块）
+ * 2. 板载WS2812随音乐变色：色相为频谱重心，亮度为整体响度
+ *
+ * 数据流：
+ *   音频任务：analyze --> onSpectrum --> Pixel::setRGB
+ *   LVGL任务：frameCb --> audio.get --> pushStrip（只含变化部分） --> endStrips
+ */
+
+#include "audio_viz.h"
+#include <FastLED.h>
+#include <esp_heap_caps.h>
+
+AudioViz audioviz;
+
+const App audio_viz_app = {
+	"audioviz",
+	[](void* u) { audioviz.start(); },
+	NULL,
+	NULL,
+	[](void* u) { audioviz.stop(); },
+	12 * 1024, 0, 0, 0, NULL
+};
+
+/**
+ * FastLED颜色转为面板字节序RGB565
+ */
+static inline uint16_t panel565(const CRGB& c)
+{
+	uint16_t v = ((c.r & 0xF8) << 8) | ((c.g & 0xFC) << 3) | (c.b >> 3);
+	return (v >> 8) | (v << 8);
+}
+
+AudioViz::AudioViz()
+{
+	display = NULL;
+	leds = NULL;
+	running = false;
+	bar_px = blank_px = NULL;
+	frame_task = NULL;
+	screen = prev_screen = NULL;
+}
+
+void AudioViz::setDisplay(Display* disp)
+{
+	display = disp;
+}
+
+void AudioViz::setLeds(Pixel* pixel)
+{
+	leds = pixel;
+}
+
+/**
+ * 开始采集并显示频谱（在LVGL任务中调用）
+ */
+bool AudioViz::start()
+{
+	if (running) return true;
+	if (display == NULL) return false;
+
+	uint32_t bar_n = AUDIO_VIZ_BAR_W * AUDIO_VIZ_MAX_H;
+	uint32_t blank_n = AUDIO_VIZ_BAR_W * AUDIO_VIZ_BLANK_LINES;
+	bar_px = (uint16_t*)heap_caps_malloc((bar_n + blank_n) * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	if (bar_px == NULL)
+	{
+		Serial.println("频谱条缓冲分配失败");
+		return false;
+	}
+	blank_px = bar_px + bar_n;
+	memset(blank_px, 0, blank_n * sizeof(uint16_t));
+	// 由顶部的红色渐变到底部的绿色
+	for (int32_t r = 0; r < AUDIO_VIZ_MAX_H; r++)
+	{
+		uint16_t c = panel565(CHSV(96 * r / (AUDIO_VIZ_MAX_H - 1), 255, 255));
+		for (int32_t x = 0; x < AUDIO_VIZ_BAR_W; x++) bar_px[r * AUDIO_VIZ_BAR_W + x] = c;
+	}
+
+	if (leds)
+	{
+		leds->stop();
+		audio.setListener(onSpectrum, this);
+	}
+	if (!audio.begin())
+	{
+		audio.setListener(NULL, NULL);
+		heap_caps_free(bar_px);
+		bar_px = blank_px = NULL;
+		return false;
+	}
+
+	prev_screen = lv_scr_act();
+	screen = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(screen, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	lv_scr_load(screen);
+	lv_refr_now(NULL);
+
+	memset(heights, 0, sizeof(heights));
+	seq = 0;
+	running = true;
+	frame_task = lv_task_create(frameCb, 1000 / AUDIO_VIZ_FPS, LV_TASK_PRIO_HIGH, this);
+	return true;
+}
+
+/**
+ * 停止采集，熄灭LED并恢复原来的LVGL屏幕（在LVGL任务中调用）
+ */
+void AudioViz::stop()
+{
+	if (!running) return;
+
+	running = false;
+	if (frame_task)
+	{
+		lv_task_del(frame_task);
+		frame_task = NULL;
+	}
+	audio.end();
+	audio.setListener(NULL, NULL);
+	if (leds) leds->setRGB(0, 0, 0, 0).setRGB(1, 0, 0, 0);
+
+	if (prev_screen) lv_scr_load(prev_screen);
+	if (screen) lv_obj_del(screen);
+	screen = prev_screen = NULL;
+
+	heap_caps_free(bar_px);
+	bar_px = blank_px = NULL;
+}
+
+bool AudioViz::isRunning()
+{
+	return running;
+}
+
+/**
+ * 帧定时任务：有新的分析结果时，逐根写入变化的部分
+ * 渐变列与黑色块在运行期间只读，同一缓冲可以连续交给pushStrip
+ */
+void AudioViz::frameCb(lv_task_t* task)
+{
+	AudioViz* self = (AudioViz*)task->user_data;
+	AudioSpectrum s;
+	if (!audio.get(&s) || s.seq == self->seq) return;
+	self->seq = s.seq;
+
+	bool begun = false;
+	for (uint8_t i = 0; i < AUDIO_BANDS; i++)
+	{
+		int32_t h = s.bands[i] * AUDIO_VIZ_MAX_H / 255;
+		int32_t old = self->heights[i];
+		if (h == old) continue;
+		if (!begun)
+		{
+			self->display->beginStrips();
+			begun = true;
+		}
+
+		int32_t x = i * (AUDIO_VIZ_BAR_W + AUDIO_VIZ_GAP) + AUDIO_VIZ_GAP / 2;
+		if (h > old)
+		{
+			// 新增的行 [MAX_H - h, MAX_H - old) 对应渐变列的同一段
+			uint16_t* px = self->bar_px + (AUDIO_VIZ_MAX_H - h) * AUDIO_VIZ_BAR_W;
+			self->display->pushStrip(x, LV_VER_RES_MAX - h, AUDIO_VIZ_BAR_W, h - old, px);
+		}
+		else
+		{
+			for (int32_t y = LV_VER_RES_MAX - old; y < LV_VER_RES_MAX - h; y += AUDIO_VIZ_BLANK_LINES)
+			{
+				int32_t lines = LV_MATH_MIN(AUDIO_VIZ_BLANK_LINES, LV_VER_RES_MAX - h - y);
+				self->display->pushStrip(x, y, AUDIO_VIZ_BAR_W, lines, self->blank_px);
+			}
+		}
+		self->heights[i] = (uint8_t)h;
+	}
+	if (begun) self->display->endStrips();
+}
+
+/**
+ * 分析完成回调（音频任务）：按频谱重心与响度设置LED
+ * Pixel::setRGB只修改缓冲区，由LED刷新任务发送
+ */
+void AudioViz::onSpectrum(const AudioSpectrum* s, void* user)
+{
+	AudioViz* self = (AudioViz*)user;
+	uint32_t sum = 0, moment = 0;
+	for (uint8_t i = 0; i < AUDIO_BANDS; i++)
+	{
+		sum += s->bands[i];
+		moment += s->bands[i] * i;
+	}
+	uint8_t hue = sum ? moment * AUDIO_VIZ_HUE_MAX / (sum * (AUDIO_BANDS - 1)) : 0;
+	CRGB c = CHSV(hue, 255, s->level);
+	self->leds->setRGB(0, c.r, c.g, c.b).setRGB(1, c.r, c.g, c.b);
+}
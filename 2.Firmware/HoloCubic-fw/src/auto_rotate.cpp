@@ -0,0 +1,168 @@
+/*
+ * HoloCubic 自动旋转模块
+ *
+ * 功能说明：
+ * 1. 订阅传感器总线的IMU样本，每AUTO_ROTATE_CHECK_MS取一个加速度样本（传感器任务中），低通滤波
+ * 2. 屏幕平面内的重力方向按90°量化为DISP_ROTATE_x，带滞回与去抖
+ * 3. 方向确定变化后向LVGL任务发送一条消息：切换MADCTL、整屏失效一次、通知订阅者
+ *
+ * 方向判断只用整数：四个方向的重力投影为(右, 下)分量的正负，取投影最大的方向；
+ * 当前方向的投影乘AUTO_ROTATE_HYST_X10/10仍小于新方向时才开始去抖
+ */
+
+#include "auto_rotate.h"
+#include "logger.h"
+
+/**
+ * 启动自动旋转（不启用，setEnabled(true)后才开始检查）
+ *
+ * @param display 跟随重力旋转的显示，begin时的镜像位保持不变
+ * @param sensor  IMU，样本取自传感器总线
+ * @return 总线订阅表已满时返回false
+ */
+bool AutoRotate::begin(Display* display, IMU* sensor)
+{
+	disp = display;
+	imu = sensor;
+	enabled = false;
+	mirror = disp->getOrientation() & (DISP_MIRROR_H | DISP_MIRROR_V);
+	lpf_init = false;
+	rotation = disp->getOrientation() & 0x03;
+	candidate = -1;
+	changes = 0;
+	sub_count = 0;
+
+	return sensorbus.subscribe(SENSOR_IMU, AUTO_ROTATE_EVERY, onSample, this);
+}
+
+/**
+ * 启用/停用（停用后保持当前方向）
+ */
+void AutoRotate::setEnabled(bool en)
+{
+	if (en && !enabled)
+	{
+		lpf_init = false;
+		candidate = -1;
+	}
+	enabled = en;
+}
+
+bool AutoRotate::isEnabled()
+{
+	return enabled;
+}
+
+/**
+ * 订阅方向变化（在LVGL任务中回调），应在setEnabled(true)之前调用
+ */
+bool AutoRotate::subscribe(auto_rotate_cb_t cb, void* user)
+{
+	if (sub_count >= AUTO_ROTATE_MAX_SUBSCRIBERS) return false;
+	subs[sub_count] = cb;
+	subs_user[sub_count] = user;
+	sub_count++;
+	return true;
+}
+
+uint8_t AutoRotate::getRotation()
+{
+	return rotation;
+}
+
+uint32_t AutoRotate::getChangeCount()
+{
+	return changes;
+}
+
+/**
+ * 当前重力方向对应的显示方向
+ * @return DISP_ROTATE_x；平放、晃动或未超过滞回时返回当前方向，没有有效数据时返回-1
+ */
+int8_t AutoRotate::detect(const SensorSample* s)
+{
+	int32_t a[3] = { s->accel[0], s->accel[1], s->accel[2] };
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		if (!lpf_init) lpf[i] = a[i];
+		else lpf[i] += (a[i] - lpf[i]) >> AUTO_ROTATE_LPF_SHIFT;
+	}
+	lpf_init = true;
+
+	// 总加速度偏离1g（16384）太多说明正在移动，重力方向不可靠
+	int32_t norm2 = ((lpf[0] * lpf[0]) >> 8) + ((lpf[1] * lpf[1]) >> 8) + ((lpf[2] * lpf[2]) >> 8);
+	int32_t lo = (16384 - AUTO_ROTATE_MAX_SHAKE) * (16384 - AUTO_ROTATE_MAX_SHAKE) >> 8;
+	int32_t hi = (16384 + AUTO_ROTATE_MAX_SHAKE) * (16384 + AUTO_ROTATE_MAX_SHAKE) >> 8;
+	if (norm2 < lo || norm2 > hi) return -1;
+
+	int32_t right = lpf[AUTO_ROTATE_AXIS_RIGHT] * AUTO_ROTATE_SIGN_RIGHT;
+	int32_t down = lpf[AUTO_ROTATE_AXIS_DOWN] * AUTO_ROTATE_SIGN_DOWN;
+	if (((right * right) >> 8) + ((down * down) >> 8) < (AUTO_ROTATE_MIN_PLANE * AUTO_ROTATE_MIN_PLANE >> 8)) return -1;
+
+	// 各方向正放时重力指向：0为屏幕下方，90°（顺时针）为屏幕左方，180°为上方，270°为右方
+	int32_t proj[4] = { down, -right, -down, right };
+	// 奇数个镜像时观看者看到的旋转方向相反
+	bool flip = mirror == DISP_MIRROR_H || mirror == DISP_MIRROR_V;
+	if (flip)
+	{
+		int32_t t = proj[1];
+		proj[1] = proj[3];
+		proj[3] = t;
+	}
+
+	uint8_t best = 0;
+	for (uint8_t r = 1; r < 4; r++)
+	{
+		if (proj[r] > proj[best]) best = r;
+	}
+	if (best == rotation) return rotation;
+	if (proj[best] * 10 <= proj[rotation] * AUTO_ROTATE_HYST_X10) return rotation;
+	return best;
+}
+
+void AutoRotate::onSample(const SensorSample* s, void* user)
+{
+	((AutoRotate*)user)->check(s);
+}
+
+/**
+ * 周期检查（传感器任务中执行）：新方向保持AUTO_ROTATE_DEBOUNCE_MS后发送给LVGL任务
+ */
+void AutoRotate::check(const SensorSample* s)
+{
+	if (!enabled || imu == NULL || !imu->isConnected()) return;
+
+	int8_t r = detect(s);
+	if (r < 0 || r == rotation)
+	{
+		candidate = -1;
+		return;
+	}
+
+	uint32_t now = s->time_ms;
+	if (r != candidate)
+	{
+		candidate = r;
+		candidate_since = now;
+		return;
+	}
+	if (now - candidate_since < AUTO_ROTATE_DEBOUNCE_MS) return;
+
+	// 队列满时保持候选，下一次检查重试
+	if (!runtime.post(applyMsg, this, r)) return;
+	rotation = r;
+	candidate = -1;
+}
+
+/**
+ * 应用新方向（LVGL任务中执行）：写入MADCTL并整屏失效一次，然后通知订阅者
+ */
+void AutoRotate::applyMsg(const UiMsg* msg)
+{
+	AutoRotate* self = (AutoRotate*)msg->obj;
+	uint8_t r = (uint8_t)msg->value;
+	self->disp->setOrientation(self->mirror | r);
+	self->changes++;
+	LOG_I("auto_rotate", "方向: %d°", r * 90);
+	for (uint8_t i = 0; i < self->sub_count; i++) self->subs[i](r, self->subs_user[i]);
+}
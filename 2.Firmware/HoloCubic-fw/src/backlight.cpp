@@ -0,0 +1,225 @@
+/*
+ * HoloCubic 自动背光模块
+ *
+ * 功能说明：
+ * 1. 定时读取BH1750照度，按当前档案的曲线映射为背光占空比
+ * 2. 映射结果做指数平滑，再以固定步长渐变写入LEDC，亮度变化不可察觉
+ * 3. 支持白天/夜间/省电档案与手动亮度
+ * 4. 亮度稳定后停止渐变周期：自动模式只保留低频照度采样，手动模式不再唤醒CPU
+ *
+ * 背光是整机最大的耗电项，暗室中把亮度降到曲线下限可明显降低USB供电功耗
+ */
+
+#include "backlight.h"
+
+// 空闲标志与定时器周期的切换在定时器回调与设置接口之间互斥
+static portMUX_TYPE idle_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const BacklightCurve curves[BACKLIGHT_PROFILE_COUNT] = {
+	// 白天
+	{ { 0, 10, 50, 200, 800 }, { 0.15f, 0.25f, 0.40f, 0.65f, 1.00f } },
+	// 夜间
+	{ { 0, 10, 50, 200, 800 }, { 0.03f, 0.08f, 0.15f, 0.30f, 0.50f } },
+	// 省电
+	{ { 0, 10, 50, 200, 800 }, { 0.08f, 0.15f, 0.25f, 0.40f, 0.60f } },
+};
+
+/**
+ * 启动自动背光
+ *
+ * @param disp    显示对象（提供setBackLight）
+ * @param amb     环境光传感器，NULL或无数据时保持手动亮度
+ * @param initial 启动时的亮度
+ * @return 定时器创建失败返回false（此时亮度固定为initial）
+ */
+bool Backlight::begin(Display* disp, Ambient* amb, float initial)
+{
+	display = disp;
+	ambient = amb;
+	profile = BACKLIGHT_DAY;
+	auto_mode = amb != NULL;
+	target = initial;
+	smooth = initial;
+	duty = initial;
+	ticks = 0;
+	idle = false;
+	suspended = false;
+	display->setBackLight(duty);
+
+	esp_timer_create_args_t args = {};
+	args.callback = timerCb;
+	args.arg = this;
+	args.name = "backlight";
+	if (esp_timer_create(&args, &timer) != ESP_OK) return false;
+	return esp_timer_start_periodic(timer, BACKLIGHT_TICK_MS * 1000) == ESP_OK;
+}
+
+void Backlight::timerCb(void* arg)
+{
+	((Backlight*)arg)->tick();
+}
+
+/**
+ * 定时器回调（esp_timer任务中执行）
+ */
+void Backlight::tick()
+{
+	if (auto_mode && ambient != NULL && (idle || ++ticks >= BACKLIGHT_LUX_TICKS))
+	{
+		ticks = 0;
+		if (ambient->available()) target = curve(ambient->getLux());
+	}
+	if (idle)
+	{
+		// 空闲采样：照度对应的亮度有变化时恢复渐变周期
+		if (fabsf(target - duty) >= 1.0f / 255) wake();
+		return;
+	}
+
+	// 一阶指数平滑：alpha = 周期 / 时间常数
+	smooth += (target - smooth) * ((float)BACKLIGHT_TICK_MS / BACKLIGHT_SMOOTH_MS);
+
+	float diff = smooth - duty;
+	if (fabsf(diff) >= 1.0f / 255)
+	{
+		duty += constrain(diff, -BACKLIGHT_RAMP_STEP, BACKLIGHT_RAMP_STEP);
+		display->setBackLight(duty);
+		return;
+	}
+	if (fabsf(target - smooth) < 1.0f / 255) enterIdle();
+}
+
+/**
+ * 已到达目标：停止渐变周期，自动模式改为低频采样照度（定时器回调中执行）
+ */
+void Backlight::enterIdle()
+{
+	portENTER_CRITICAL(&idle_mux);
+	if (!idle && !suspended)
+	{
+		esp_timer_stop(timer);
+		if (auto_mode) esp_timer_start_periodic(timer, BACKLIGHT_IDLE_MS * 1000);
+		idle = true;
+	}
+	portEXIT_CRITICAL(&idle_mux);
+}
+
+/**
+ * 目标可能变化：恢复渐变周期（任意任务）
+ */
+void Backlight::wake()
+{
+	portENTER_CRITICAL(&idle_mux);
+	if (idle && !suspended)
+	{
+		esp_timer_stop(timer);
+		esp_timer_start_periodic(timer, BACKLIGHT_TICK_MS * 1000);
+		idle = false;
+	}
+	portEXIT_CRITICAL(&idle_mux);
+}
+
+/**
+ * 按当前档案把照度映射为占空比（分段线性插值）
+ */
+float Backlight::curve(unsigned int lux)
+{
+	const BacklightCurve& c = curves[profile];
+	if (lux <= c.lux[0]) return c.duty[0];
+
+	for (uint8_t i = 1; i < BACKLIGHT_CURVE_POINTS; i++)
+	{
+		if (lux < c.lux[i])
+		{
+			float t = (float)(lux - c.lux[i - 1]) / (c.lux[i] - c.lux[i - 1]);
+			return c.duty[i - 1] + t * (c.duty[i] - c.duty[i - 1]);
+		}
+	}
+	return c.duty[BACKLIGHT_CURVE_POINTS - 1];
+}
+
+/**
+ * 切换档案，下一次照度采样时生效
+ */
+void Backlight::setProfile(BacklightProfile p)
+{
+	if (p < BACKLIGHT_PROFILE_COUNT) profile = p;
+	ticks = BACKLIGHT_LUX_TICKS;
+	wake();
+}
+
+BacklightProfile Backlight::getProfile()
+{
+	return profile;
+}
+
+/**
+ * 开关自动模式（没有环境光传感器时无法开启）
+ */
+void Backlight::setAuto(bool enable)
+{
+	auto_mode = enable && ambient != NULL;
+	ticks = BACKLIGHT_LUX_TICKS;
+	wake();
+}
+
+/**
+ * 手动设定亮度（同时关闭自动模式），亮度以渐变方式到达
+ */
+void Backlight::setManual(float value)
+{
+	auto_mode = false;
+	target = constrain(value, 0, 1);
+	wake();
+}
+
+bool Backlight::isAuto()
+{
+	return auto_mode;
+}
+
+/**
+ * 手动模式下设定的目标亮度（自动模式下为最近一次曲线映射结果）
+ */
+float Backlight::getTarget()
+{
+	return target;
+}
+
+/**
+ * 当前实际输出的占空比
+ */
+float Backlight::getDuty()
+{
+	return duty;
+}
+
+/**
+ * 关闭背光并停止定时器（待机时使用）
+ * LEDC使用APB时钟，自动浅睡眠期间PWM输出会中断，关闭后引脚电平恒定，不再闪烁；
+ * 停止20ms周期定时器后esp_timer不再频繁唤醒CPU
+ */
+void Backlight::suspend()
+{
+	portENTER_CRITICAL(&idle_mux);
+	esp_timer_stop(timer);
+	suspended = true;
+	idle = false;
+	portEXIT_CRITICAL(&idle_mux);
+	duty = 0;
+	smooth = 0;
+	display->setBackLight(0);
+}
+
+/**
+ * 恢复定时器，亮度从0渐变到当前目标
+ */
+void Backlight::resume()
+{
+	ticks = BACKLIGHT_LUX_TICKS;
+	portENTER_CRITICAL(&idle_mux);
+	suspended = false;
+	idle = false;
+	esp_timer_start_periodic(timer, BACKLIGHT_TICK_MS * 1000);
+	portEXIT_CRITICAL(&idle_mux);
+}
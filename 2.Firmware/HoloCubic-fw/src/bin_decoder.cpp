@@ -0,0 +1,155 @@
+/*
+ * HoloCubic 文件图像流式解码模块
+ *
+ * 功能说明：
+ * 1. 内置解码器读取文件图像时每行一次lv_fs_seek与lv_fs_read（240行的图像每帧240次）
+ * 2. 这里在打开图像时分配一个整行对齐的条带缓冲区：
+ *    从第0行开始或紧接上一行读取时，一次读入缓冲区能容纳的全部后续行；之后的行直接从缓冲区复制
+ * 3. 不按顺序的读取（如只重绘图像中间的一小块后跳到别处）只读一行，不浪费带宽
+ *
+ * 注意事项：
+ * - 只处理真彩色格式（文件内容即像素），索引色、alpha格式仍交给内置解码器
+ * - 图像缓存（LV_IMG_CACHE_DEF_SIZE）保持解码器打开，缓冲区在各显示条带之间延续；
+ *   文件在打开期间被改写时须先lv_img_cache_invalidate_src
+ */
+
+#include "bin_decoder.h"
+#include <esp_heap_caps.h>
+
+struct BinStreamCtx
+{
+	lv_fs_file_t file;
+	uint8_t* buf;
+	uint32_t stride;       // 每行字节数
+	uint16_t px_bytes;
+	uint16_t cap_rows;     // 缓冲区可容纳的行数
+	int32_t buf_y;         // 缓冲区第一行，-1表示无效
+	uint16_t buf_rows;     // 缓冲区内有效行数
+	int32_t last_y;        // 上一次读取的行
+	uint16_t h;
+};
+
+static bool is_true_color(lv_img_cf_t cf)
+{
+	return cf == LV_IMG_CF_TRUE_COLOR || cf == LV_IMG_CF_TRUE_COLOR_ALPHA || cf == LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED;
+}
+
+static bool is_bin_file(const void* src)
+{
+	return lv_img_src_get_type(src) == LV_IMG_SRC_FILE && strcmp(lv_fs_get_ext((const char*)src), "bin") == 0;
+}
+
+static lv_res_t bin_lv_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+	if (!is_bin_file(src)) return LV_RES_INV;
+
+	lv_fs_file_t f;
+	if (lv_fs_open(&f, (const char*)src, LV_FS_MODE_RD) != LV_FS_RES_OK) return LV_RES_INV;
+	uint32_t br = 0;
+	lv_fs_res_t res = lv_fs_read(&f, header, sizeof(lv_img_header_t), &br);
+	lv_fs_close(&f);
+	if (res != LV_FS_RES_OK || br != sizeof(lv_img_header_t)) return LV_RES_INV;
+
+	return is_true_color((lv_img_cf_t)header->cf) ? LV_RES_OK : LV_RES_INV;
+}
+
+static lv_res_t bin_lv_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	if (dsc->src_type != LV_IMG_SRC_FILE || !is_bin_file(dsc->src) || !is_true_color(dsc->header.cf)) return LV_RES_INV;
+	if (dsc->header.w == 0 || dsc->header.h == 0) return LV_RES_INV;
+
+	BinStreamCtx* ctx = new BinStreamCtx();
+	if (lv_fs_open(&ctx->file, (const char*)dsc->src, LV_FS_MODE_RD) != LV_FS_RES_OK)
+	{
+		delete ctx;
+		return LV_RES_INV;
+	}
+
+	ctx->px_bytes = lv_img_cf_get_px_size(dsc->header.cf) >> 3;
+	ctx->stride = (uint32_t)dsc->header.w * ctx->px_bytes;
+	ctx->h = dsc->header.h;
+	uint32_t rows = BIN_DECODER_BUF_SIZE / ctx->stride;
+	if (rows == 0) rows = 1;
+	if (rows > ctx->h) rows = ctx->h;
+	ctx->cap_rows = rows;
+	// 可DMA内存：FatFs整扇区读取时SD驱动直接写入
+	ctx->buf = (uint8_t*)heap_caps_malloc(rows * ctx->stride, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	if (ctx->buf == NULL)
+	{
+		// 内存不足时交给内置解码器逐行读取
+		lv_fs_close(&ctx->file);
+		delete ctx;
+		return LV_RES_INV;
+	}
+	ctx->buf_y = -1;
+	ctx->buf_rows = 0;
+	ctx->last_y = -2;
+
+	dsc->img_data = NULL;       // 不提供整帧数据，LVGL逐行调用read_line
+	dsc->user_data = ctx;
+	return LV_RES_OK;
+}
+
+/**
+ * 把从第y行开始的若干行读入缓冲区
+ * 顺序读取（第0行或紧接上一行）时读满缓冲区，否则只读一行
+ */
+static bool bin_fill(BinStreamCtx* ctx, int32_t y)
+{
+	bool sequential = (y == 0 || y == ctx->last_y + 1);
+	uint32_t rows = sequential ? ctx->cap_rows : 1;
+	if (y + rows > ctx->h) rows = ctx->h - y;
+
+	ctx->buf_y = -1;
+	if (lv_fs_seek(&ctx->file, sizeof(lv_img_header_t) + (uint32_t)y * ctx->stride) != LV_FS_RES_OK) return false;
+	uint32_t br = 0;
+	if (lv_fs_read(&ctx->file, ctx->buf, rows * ctx->stride, &br) != LV_FS_RES_OK || br < ctx->stride) return false;
+
+	ctx->buf_y = y;
+	ctx->buf_rows = br / ctx->stride;
+	return true;
+}
+
+static lv_res_t LV_ATTRIBUTE_HOT bin_lv_read_line(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc,
+								 lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t* buf)
+{
+	BinStreamCtx* ctx = (BinStreamCtx*)dsc->user_data;
+	if (y < 0 || y >= ctx->h || x < 0 || len <= 0 || (uint32_t)(x + len) * ctx->px_bytes > ctx->stride) return LV_RES_INV;
+
+	if (ctx->buf_y < 0 || y < ctx->buf_y || y >= ctx->buf_y + ctx->buf_rows)
+	{
+		if (!bin_fill(ctx, y))
+		{
+			LV_LOG_WARN("bin decoder read failed");
+			return LV_RES_INV;
+		}
+	}
+	ctx->last_y = y;
+
+	memcpy(buf, ctx->buf + (uint32_t)(y - ctx->buf_y) * ctx->stride + (uint32_t)x * ctx->px_bytes,
+		   (uint32_t)len * ctx->px_bytes);
+	return LV_RES_OK;
+}
+
+static void bin_lv_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	BinStreamCtx* ctx = (BinStreamCtx*)dsc->user_data;
+	if (ctx == NULL) return;
+	lv_fs_close(&ctx->file);
+	heap_caps_free(ctx->buf);
+	delete ctx;
+	dsc->user_data = NULL;
+}
+
+/**
+ * 注册文件图像流式解码器
+ * 新解码器插入列表头部，优先于内置.bin解码器尝试
+ */
+void bin_decoder_lv_init()
+{
+	lv_img_decoder_t* dec = lv_img_decoder_create();
+	lv_img_decoder_set_info_cb(dec, bin_lv_info);
+	lv_img_decoder_set_open_cb(dec, bin_lv_open);
+	lv_img_decoder_set_read_line_cb(dec, bin_lv_read_line);
+	lv_img_decoder_set_close_cb(dec, bin_lv_close);
+}
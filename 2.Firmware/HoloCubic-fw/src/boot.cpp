@@ -0,0 +1,151 @@
+/*
+ * HoloCubic 启动计时与并行初始化
+ *
+ * 功能说明：
+ * 1. 记录每个初始化阶段的开始/结束时间与所在核心
+ * 2. 互不依赖的外设（SD卡挂载、IMU探测与校准、环境光、WiFi）放到核心0的临时任务中执行，
+ *    setup()在核心1上继续初始化LVGL并先画出启动画面，首帧不再等待最慢的外设
+ * 3. 启动完成后输出时间线，便于找出拖慢启动的阶段
+ *
+ * 输出格式：
+ * BOOT,阶段名,核心,同步/异步,开始ms,结束ms,耗时ms
+ */
+
+#include "boot.h"
+#include <esp_timer.h>
+
+/**
+ * 开始计时（setup()最开始调用）
+ */
+void Boot::begin()
+{
+	t0 = esp_timer_get_time();
+	count = 0;
+	mutex = xSemaphoreCreateMutex();
+	done = xEventGroupCreate();
+}
+
+/**
+ * 新增一条阶段记录
+ * @return 阶段编号，记录已满时返回-1（阶段照常执行，只是不计时）
+ */
+int Boot::add(const char* name, bool async)
+{
+	int id = -1;
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	if (count < BOOT_MAX_STAGES)
+	{
+		id = count++;
+		BootStage* s = &stages[id];
+		s->name = name;
+		s->start = esp_timer_get_time() - t0;
+		s->end = 0;
+		s->core = xPortGetCoreID();
+		s->async = async;
+		s->job = NULL;
+		s->arg = NULL;
+	}
+	xSemaphoreGive(mutex);
+	return id;
+}
+
+void Boot::finish(int id)
+{
+	if (id < 0) return;
+	stages[id].end = esp_timer_get_time() - t0;
+	xEventGroupSetBits(done, 1 << id);
+}
+
+/**
+ * 在当前任务中执行一个阶段
+ */
+bool Boot::run(const char* name, boot_job_t job, void* arg)
+{
+	int id = add(name, false);
+	job(arg);
+	finish(id);
+	return id >= 0;
+}
+
+void Boot::taskEntry(void* arg)
+{
+	BootStage* s = (BootStage*)arg;
+	s->start = esp_timer_get_time() - boot.t0;
+	s->job(s->arg);
+	boot.finish(s - boot.stages);
+	vTaskDelete(NULL);
+}
+
+/**
+ * 在核心0的临时任务中执行一个阶段
+ * @return 阶段编号（传给wait()）；记录已满或任务创建失败时在当前任务中直接执行，返回-1
+ */
+int Boot::async(const char* name, boot_job_t job, void* arg)
+{
+	int id = add(name, true);
+	if (id >= 0)
+	{
+		stages[id].job = job;
+		stages[id].arg = arg;
+		stages[id].core = BOOT_TASK_CORE;
+		if (xTaskCreatePinnedToCore(taskEntry, name, BOOT_TASK_STACK, &stages[id],
+									BOOT_TASK_PRIORITY, NULL, BOOT_TASK_CORE) == pdPASS)
+			return id;
+		Serial.printf("启动阶段%s创建任务失败，改为同步执行\n", name);
+		stages[id].async = false;
+		stages[id].core = xPortGetCoreID();
+	}
+	job(arg);
+	finish(id);
+	return -1;
+}
+
+/**
+ * 等待异步阶段完成
+ * @return 超时返回false，阶段仍在后台执行
+ */
+bool Boot::wait(int id, uint32_t timeout_ms)
+{
+	if (id < 0) return true;
+	EventBits_t bits = xEventGroupWaitBits(done, 1 << id, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+	if (bits & (1 << id)) return true;
+	Serial.printf("启动阶段%s等待超时（%ums），继续启动\n", stages[id].name, timeout_ms);
+	return false;
+}
+
+/**
+ * 记录一个时间点（如首帧显示）
+ */
+void Boot::mark(const char* name)
+{
+	int id = add(name, false);
+	if (id >= 0) stages[id].end = stages[id].start;
+}
+
+/**
+ * 输出启动时间线，按开始时间排序；未完成的异步阶段结束时间显示为-1
+ */
+void Boot::report()
+{
+	uint8_t n = count;
+	uint8_t order[BOOT_MAX_STAGES];
+	for (uint8_t i = 0; i < n; i++) order[i] = i;
+	for (uint8_t i = 1; i < n; i++)
+	{
+		uint8_t k = order[i];
+		int8_t j = i - 1;
+		for (; j >= 0 && stages[order[j]].start > stages[k].start; j--) order[j + 1] = order[j];
+		order[j + 1] = k;
+	}
+
+	Serial.printf("启动时间线（总计%.1fms）：\n", (esp_timer_get_time() - t0) / 1000.0f);
+	for (uint8_t i = 0; i < n; i++)
+	{
+		const BootStage* s = &stages[order[i]];
+		float start = s->start / 1000.0f;
+		float end = s->end ? s->end / 1000.0f : -1;
+		float dur = s->end ? end - start : -1;
+		Serial.printf("BOOT,%s,%u,%s,%.1f,%.1f,%.1f\n", s->name, s->core, s->async ? "async" : "sync",
+					  start, end, dur);
+	}
+}
@@ -0,0 +1,111 @@
+/*
+ * HoloCubic 缓冲区管理
+ *
+ * 功能说明：
+ * 1. 按用途分类分配缓冲区：传输缓冲放片内可DMA内存，大块缓存有PSRAM时放PSRAM
+ * 2. 没有PSRAM（pico32）时大块缓存退回片内，并保留一块最大空闲块给WiFi/TLS/LVGL，
+ *    分配失败由调用方缩小配置，而不是把系统堆耗尽
+ * 3. 有PSRAM时放大LVGL图像缓存的字节预算，整幅界面图片也能预解码常驻
+ *
+ * 注意事项：
+ * - PSRAM不能被SPI DMA直接读取，BUF_BULK的缓冲需要DMA时调用方先用buf_is_dma()判断
+ *   （如场景播放器在PSRAM中的帧改由LVGL绘制）
+ * - 启用PSRAM需使用带PSRAM的模组与platformio.ini中的对应环境（见env:wrover）
+ */
+
+#include "buf_manager.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>  // esp_ptr_dma_capable
+#include <lvgl.h>
+#include "logger.h"
+
+static bool psram = false;
+static bool psram_checked = false;
+
+static inline bool has_psram()
+{
+	if (!psram_checked)
+	{
+		psram = psramFound() && heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+		psram_checked = true;
+	}
+	return psram;
+}
+
+void buf_manager_init(void)
+{
+	bool p = has_psram();
+#if LV_IMG_CACHE_BYTE_BUDGET
+	if (p) lv_img_cache_set_budget(BUF_IMG_CACHE_PSRAM_BUDGET, BUF_IMG_CACHE_PSRAM_PRELOAD);
+#endif
+	LOG_I("mem", "片内空闲%u字节（最大块%u，可DMA%u），PSRAM %u字节", heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+		heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL), heap_caps_get_free_size(MALLOC_CAP_DMA),
+		p ? heap_caps_get_free_size(MALLOC_CAP_SPIRAM) : 0);
+}
+
+bool buf_has_psram(void)
+{
+	return has_psram();
+}
+
+void* buf_alloc(buf_class_t cls, size_t size)
+{
+	switch (cls)
+	{
+	case BUF_DMA:
+		return heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	case BUF_FAST:
+		return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	case BUF_BULK:
+		if (has_psram())
+		{
+			void* p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+			if (p) return p;
+		}
+		// 片内：分配后最大空闲块仍不小于保留量（最大块可能就是被分走的那块，按保守估计）
+		if (heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL) < size + BUF_INTERNAL_RESERVE)
+		{
+			LOG_W("mem", "片内内存不足，%u字节的缓存未分配", size);
+			return NULL;
+		}
+		return heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	}
+	return NULL;
+}
+
+void* buf_calloc(buf_class_t cls, size_t n, size_t size)
+{
+	if (size && n > SIZE_MAX / size) return NULL;
+	void* p = buf_alloc(cls, n * size);
+	if (p) memset(p, 0, n * size);
+	return p;
+}
+
+void buf_free(void* p)
+{
+	if (p) heap_caps_free(p);
+}
+
+size_t buf_largest(buf_class_t cls)
+{
+	switch (cls)
+	{
+	case BUF_DMA:
+		return heap_caps_get_largest_free_block(MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	case BUF_FAST:
+		return heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	case BUF_BULK:
+	{
+		if (has_psram()) return heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+		size_t n = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+		return n > BUF_INTERNAL_RESERVE ? n - BUF_INTERNAL_RESERVE : 0;
+	}
+	}
+	return 0;
+}
+
+bool buf_is_dma(const void* p)
+{
+	return p != NULL && esp_ptr_dma_capable(p);
+}
@@ -0,0 +1,123 @@
+/*
+ * HoloCubic 取指停顿（Flash缓存未命中）统计
+ *
+ * 功能说明：
+ * 1. 用Xtensa性能计数器（perfmon组件）统计完成的指令数与取指停顿周期，CCOUNT统计周期数
+ * 2. 计数区间与渲染计时的阶段相同（render_prof_begin/end中调用），每个阶段单独累计
+ * 3. 每CACHE_PROF_LOG_MS输出一次各阶段的CPI与停顿占比，据此决定哪些函数放入IRAM（LV_IRAM_HOT）
+ *
+ * 使用方法：
+ *   pio run -e pico32_cacheprof（CACHE_PROF=1），对比加上LV_IRAM_HOT=1前后的日志
+ *
+ * 注意事项：
+ * - 计数器每个核一组，阶段在哪个核上计时就读取哪个核的计数器；区间内发生的中断与任务切换一并计入
+ * - ESP32每核只有两个性能计数器，因此只统计指令与取指停顿
+ */
+
+#include "cache_prof.h"
+
+#if CACHE_PROF
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <xtensa/hal.h>
+#include <xtensa_perfmon_access.h>
+#include <xtensa_perfmon_masks.h>
+#include "logger.h"
+
+static const char* const phase_names[RENDER_PROF_PHASE_CNT] = {
+	"frame", "join", "draw", "flush", "spi", "indev", "imu", "ambient"
+};
+
+static bool core_ready[portNUM_PROCESSORS];
+static uint32_t start[RENDER_PROF_PHASE_CNT][CACHE_PROF_CNT];
+static uint64_t totals[RENDER_PROF_PHASE_CNT][CACHE_PROF_CNT];
+static lv_task_t* log_task = NULL;
+
+/**
+ * 在当前核上配置并启动计数器（所有中断级别都计数）
+ */
+static void core_init()
+{
+	int core = xPortGetCoreID();
+	if (core_ready[core]) return;
+	xtensa_perfmon_stop();
+	xtensa_perfmon_init(0, XTPERF_CNT_INSN, XTPERF_MASK_INSN_ALL, 0, -1);
+	xtensa_perfmon_init(1, XTPERF_CNT_I_STALL, XTPERF_MASK_I_STALL_ALL, 0, -1);
+	xtensa_perfmon_reset(0);
+	xtensa_perfmon_reset(1);
+	xtensa_perfmon_start();
+	core_ready[core] = true;
+}
+
+static void read_counters(uint32_t v[CACHE_PROF_CNT])
+{
+	v[CACHE_PROF_CYCLES] = xthal_get_ccount();
+	v[CACHE_PROF_INSN] = xtensa_perfmon_value(0);
+	v[CACHE_PROF_I_STALL] = xtensa_perfmon_value(1);
+}
+
+void cache_prof_begin(render_prof_phase_t phase)
+{
+	core_init();
+	read_counters(start[phase]);
+}
+
+void cache_prof_end(render_prof_phase_t phase)
+{
+	uint32_t v[CACHE_PROF_CNT];
+	read_counters(v);
+	// 32位计数器差值在回绕后仍正确（240MHz下区间不超过17秒）
+	for (uint8_t i = 0; i < CACHE_PROF_CNT; i++) totals[phase][i] += v[i] - start[phase][i];
+}
+
+void cache_prof_get(render_prof_phase_t phase, uint64_t out[CACHE_PROF_CNT])
+{
+	for (uint8_t i = 0; i < CACHE_PROF_CNT; i++) out[i] = totals[phase][i];
+}
+
+void cache_prof_reset()
+{
+	memset(totals, 0, sizeof(totals));
+}
+
+/**
+ * 输出一次：每个有计数的阶段一行，CPI与停顿占比为千分比换算的小数
+ */
+void cache_prof_log()
+{
+	for (uint8_t p = 0; p < RENDER_PROF_PHASE_CNT; p++)
+	{
+		uint64_t v[CACHE_PROF_CNT];
+		cache_prof_get((render_prof_phase_t)p, v);
+		if (v[CACHE_PROF_INSN] == 0 || v[CACHE_PROF_CYCLES] == 0) continue;
+		uint32_t cpi = (uint32_t)(v[CACHE_PROF_CYCLES] * 1000 / v[CACHE_PROF_INSN]);
+		uint32_t stall = (uint32_t)(v[CACHE_PROF_I_STALL] * 1000 / v[CACHE_PROF_CYCLES]);
+		LOG_I("cache", "%s: %llu周期 %llu指令 CPI %u.%03u 取指停顿%llu周期(%u.%u%%)", phase_names[p],
+			v[CACHE_PROF_CYCLES], v[CACHE_PROF_INSN], cpi / 1000, cpi % 1000,
+			v[CACHE_PROF_I_STALL], stall / 10, stall % 10);
+	}
+	cache_prof_reset();
+}
+
+static void log_update(lv_task_t* task)
+{
+	cache_prof_log();
+}
+
+bool cache_prof_enable(bool en)
+{
+	if (!en)
+	{
+		if (log_task) lv_task_del(log_task);
+		log_task = NULL;
+		return true;
+	}
+	if (log_task) return true;
+	if (!render_prof_enable(true)) return false;
+	cache_prof_reset();
+	log_task = lv_task_create(log_update, CACHE_PROF_LOG_MS, LV_TASK_PRIO_LOW, NULL);
+	return log_task != NULL;
+}
+
+#endif
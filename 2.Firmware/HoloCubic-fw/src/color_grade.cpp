@@ -0,0 +1,144 @@
+/*
+ * HoloCubic 环境光调色
+ *
+ * 功能说明：
+ * 1. 定时读取照度，指数平滑后映射为调色强度（COLOR_GRADE_LUX_LOW以下为0，COLOR_GRADE_LUX_HIGH以上为1）
+ * 2. 强度量化为级别，级别变化时按高光压缩曲线生成三个通道的表，交给Display在刷新时查表
+ *
+ * 数据流：
+ *   Ambient::getLux --> 平滑 --> 级别 --> curve（32/64/32项） --> Display::setColorCurve --> 刷新时查表
+ */
+
+#include "color_grade.h"
+#include "logger.h"
+
+ColorGrade colorgrade;
+
+ColorGrade::ColorGrade()
+{
+	display = NULL;
+	ambient = NULL;
+	task = NULL;
+	auto_mode = true;
+	smooth = 0;
+	level = -1;
+	last_ms = 0;
+}
+
+bool ColorGrade::begin(Display* disp, Ambient* amb)
+{
+	if (task) return true;
+	display = disp;
+	ambient = amb;
+	last_ms = millis();
+	task = lv_task_create(taskCb, COLOR_GRADE_PERIOD_MS, LV_TASK_PRIO_LOW, this);
+	if (task == NULL) return false;
+	lv_task_ready(task);
+	return true;
+}
+
+/**
+ * 停止并恢复为不调色
+ */
+void ColorGrade::end()
+{
+	if (task)
+	{
+		lv_task_del(task);
+		task = NULL;
+	}
+	if (display) display->setColorCurve(NULL, NULL, NULL);
+	level = -1;
+}
+
+void ColorGrade::setAuto(bool enable)
+{
+	auto_mode = enable;
+	if (task) lv_task_ready(task);
+}
+
+bool ColorGrade::isAuto()
+{
+	return auto_mode;
+}
+
+void ColorGrade::setStrength(float strength)
+{
+	smooth = constrain(strength, 0.0f, 1.0f);
+	if (!auto_mode && display) apply((uint8_t)(smooth * (COLOR_GRADE_LEVELS - 1) + 0.5f));
+}
+
+float ColorGrade::getStrength()
+{
+	return level > 0 ? (float)level / (COLOR_GRADE_LEVELS - 1) : 0;
+}
+
+/**
+ * 高光压缩：x <= knee不变，以上为y = x - c * (x - knee)^2，c使白色降低drop * strength；
+ * 导数在knee处为1、在白色处不小于0，曲线单调
+ *
+ * @param in   通道值（bits位）
+ * @return 同样位数的输出
+ */
+uint8_t ColorGrade::curve(uint8_t in, uint8_t bits, float strength)
+{
+	uint8_t max = (1 << bits) - 1;
+	float x = (float)in * 255 / max;
+	float knee = COLOR_GRADE_KNEE;
+	if (x > knee)
+	{
+		float c = strength * COLOR_GRADE_MAX_DROP / ((255 - knee) * (255 - knee));
+		x -= c * (x - knee) * (x - knee);
+	}
+	return (uint8_t)(x * max / 255 + 0.5f);
+}
+
+/**
+ * 按级别生成三个通道的曲线（级别0为恒等映射，Display随即关闭查表）
+ */
+void ColorGrade::apply(uint8_t lvl)
+{
+	if (lvl >= COLOR_GRADE_LEVELS) lvl = COLOR_GRADE_LEVELS - 1;
+	if (lvl == level) return;
+
+	uint8_t red[32], green[64], blue[32];
+	float strength = (float)lvl / (COLOR_GRADE_LEVELS - 1);
+	for (uint8_t i = 0; i < 32; i++) red[i] = blue[i] = curve(i, 5, strength);
+	for (uint8_t i = 0; i < 64; i++) green[i] = curve(i, 6, strength);
+	if (!display->setColorCurve(red, green, blue))
+	{
+		LOG_W("grade", "调色表分配失败");
+		return;
+	}
+	LOG_D("grade", "调色强度%u/%u", lvl, COLOR_GRADE_LEVELS - 1);
+	level = lvl;
+}
+
+/**
+ * 定时任务：照度映射为强度并平滑，量化后级别变化时重建曲线
+ */
+void ColorGrade::taskCb(lv_task_t* t)
+{
+	ColorGrade* self = (ColorGrade*)t->user_data;
+	uint32_t now = millis();
+	uint32_t dt = now - self->last_ms;
+	self->last_ms = now;
+	if (!self->auto_mode || self->display == NULL) return;
+
+	float target = 0;
+	if (self->ambient && self->ambient->available())
+	{
+		unsigned int lux = self->ambient->getLux();
+		if (lux >= COLOR_GRADE_LUX_HIGH) target = 1;
+		else if (lux > COLOR_GRADE_LUX_LOW)
+			target = (float)(lux - COLOR_GRADE_LUX_LOW) / (COLOR_GRADE_LUX_HIGH - COLOR_GRADE_LUX_LOW);
+	}
+	// 首次直接到达目标，之后按时间常数平滑
+	if (self->level < 0) self->smooth = target;
+	else self->smooth += (target - self->smooth) * LV_MATH_MIN(1.0f, (float)dt / COLOR_GRADE_SMOOTH_MS);
+
+	// 在两级之间来回时保持当前级别（半级回差）
+	float pos = self->smooth * (COLOR_GRADE_LEVELS - 1);
+	if (self->level >= 0 && fabsf(pos - self->level) < 0.75f) return;
+	self->apply((uint8_t)(pos + 0.5f));
+}
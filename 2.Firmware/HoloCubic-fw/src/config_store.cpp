@@ -0,0 +1,437 @@
+/*
+ * HoloCubic 配置系统
+ *
+ * 功能说明：
+ * 1. 配置值按schema表以类型化的键保存在NVS，启动时一次读入内存，没有SD卡也能启动联网
+ * 2. SD卡上的/config.json只在大小或修改时间变化时解析（ArduinoJson），逐项校验后写入NVS
+ * 3. 没有config.json时导入一次旧的/wifi.txt（第1行SSID、第2行密码）
+ * 4. 其他模块按编号读取内存中的值，不再访问SD卡
+ *
+ * 配置文件示例：
+ *   {
+ *     "wifi": { "ssid": "MyAP", "password": "12345678" },
+ *     "bili": { "uid": "20259914" },
+ *     "log":  { "sinks": 1 },
+ *     "device": { "name": "cube-01" },
+ *     "fleet":  { "key": "多设备管理的共享密钥" },
+ *     "mqtt":   { "uri": "mqtt://192.168.1.10", "user": "", "password": "" },
+ *     "ui":     { "lang": "zh" },
+ *     "sync":   { "group": 1 }
+ *   }
+ *
+ * 注意事项：
+ * - 文件标记取FAT目录项中的修改时间，PC端编辑保存后即会变化；大小与时间都不变的修改不会被发现，
+ *   此时删除NVS中的标记（或修改文件大小）即可强制重新导入
+ * - 密码类配置项（CFG_FLAG_SECRET）保存在单独的NVS分区：固件启用NVS加密（CONFIG_NVS_ENCRYPTION，
+ *   需同时启用Flash加密保护nvs_keys分区）时加密保存，否则只是与其他配置分开，仍为明文
+ * - 旧版本保存在默认分区中的密码在第一次启动时移到该分区
+ */
+
+#include "config_store.h"
+#include "sd_card.h"
+#include "logger.h"
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <nvs_flash.h>
+#include <esp_partition.h>
+
+Config config;
+
+static const ConfigSchema schema_table[CFG_KEY_COUNT] = {
+	{ "wifi.ssid",     "wifi_ssid", CFG_TYPE_STR, 0, 32, "",         0 },
+	{ "wifi.password", "wifi_pass", CFG_TYPE_STR, 0, 64, "",         0, CFG_FLAG_SECRET },
+	{ "bili.uid",      "bili_uid",  CFG_TYPE_STR, 0, 15, "20259914", 0 },
+	{ "weather.lat",   "wx_lat",    CFG_TYPE_STR, 0, 12, "39.90",    0 },
+	{ "weather.lon",   "wx_lon",    CFG_TYPE_STR, 0, 12, "116.40",   0 },
+	{ "log.sinks",     "log_sinks", CFG_TYPE_INT, 0,  7, NULL,       1 },
+	{ "device.name",   "dev_name",  CFG_TYPE_STR, 0, 23, "",         0 },
+	{ "fleet.key",     "fleet_key", CFG_TYPE_STR, 0, 32, "",         0, CFG_FLAG_SECRET },
+	{ "mqtt.uri",      "mqtt_uri",  CFG_TYPE_STR, 0, 96, "",         0 },
+	{ "mqtt.user",     "mqtt_user", CFG_TYPE_STR, 0, 32, "",         0 },
+	{ "mqtt.password", "mqtt_pass", CFG_TYPE_STR, 0, 64, "",         0, CFG_FLAG_SECRET },
+	{ "ui.lang",       "ui_lang",   CFG_TYPE_STR, 0,  7, "",         0 },
+	{ "hub.enable",    "hub_en",    CFG_TYPE_BOOL, 0, 1, NULL,       0 },
+	{ "hub.lux_s",     "hub_lux",   CFG_TYPE_INT, 0, 3600, NULL,     60 },
+	{ "hub.motion_s",  "hub_motion", CFG_TYPE_INT, 0, 3600, NULL,    10 },
+	{ "hub.orient_s",  "hub_orient", CFG_TYPE_INT, 0, 3600, NULL,    60 },
+	{ "hub.presence_s", "hub_pres", CFG_TYPE_INT, 1, 3600, NULL,     300 },
+	{ "hub.discovery", "hub_disc",  CFG_TYPE_BOOL, 0, 1, NULL,       1 },
+	{ "sync.group",    "sync_group", CFG_TYPE_INT, 0, 255, NULL,     0 },
+};
+
+static bool secure_ready = false;
+
+Config::Config()
+{
+	str_pool = NULL;
+	loaded = false;
+}
+
+/**
+ * 初始化密码分区（加密时第一次启动生成并保存密钥）
+ * @return 分区可用时返回true
+ */
+bool Config::secureBegin()
+{
+	const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS,
+		CONFIG_SECURE_PARTITION);
+	if (part == NULL) return false;
+
+	esp_err_t err;
+#if CONFIG_NVS_ENCRYPTION
+	const esp_partition_t* keys = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_NVS_KEYS, NULL);
+	nvs_sec_cfg_t cfg;
+	err = keys ? nvs_flash_read_security_cfg(keys, &cfg) : ESP_ERR_NOT_FOUND;
+	if (err == ESP_ERR_NVS_KEYS_NOT_INITIALIZED) err = nvs_flash_generate_keys(keys, &cfg);
+	if (err == ESP_OK) err = nvs_flash_secure_init_partition(CONFIG_SECURE_PARTITION, &cfg);
+	if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND)
+	{
+		nvs_flash_erase_partition(CONFIG_SECURE_PARTITION);
+		err = nvs_flash_secure_init_partition(CONFIG_SECURE_PARTITION, &cfg);
+	}
+#else
+	err = nvs_flash_init_partition(CONFIG_SECURE_PARTITION);
+	if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND)
+	{
+		nvs_flash_erase_partition(CONFIG_SECURE_PARTITION);
+		err = nvs_flash_init_partition(CONFIG_SECURE_PARTITION);
+	}
+#endif
+	if (err != ESP_OK) Serial.printf("密码分区初始化失败: %d\n", err);
+	return err == ESP_OK;
+}
+
+/**
+ * 配置项所在的NVS分区（NULL为默认分区）
+ */
+const char* Config::partition(const ConfigSchema* s)
+{
+	return (s->flags & CFG_FLAG_SECRET) && secure_ready ? CONFIG_SECURE_PARTITION : NULL;
+}
+
+/**
+ * 把旧版本保存在默认分区的密码移到密码分区（内存中的值已在begin中读入）
+ */
+void Config::migrateSecrets()
+{
+	Preferences plain;
+	if (!plain.begin(CONFIG_NAMESPACE, false)) return;
+	for (uint8_t i = 0; i < CFG_KEY_COUNT; i++)
+	{
+		const ConfigSchema* s = &schema_table[i];
+		if (!(s->flags & CFG_FLAG_SECRET) || !plain.isKey(s->nvs)) continue;
+
+		char* dst = str_pool + str_offset[i];
+		if (dst[0] == '\0') plain.getString(s->nvs, dst, s->max + 1);
+		Preferences sec;
+		if (sec.begin(CONFIG_NAMESPACE, false, CONFIG_SECURE_PARTITION) &&
+			(sec.putString(s->nvs, dst) == strlen(dst) || dst[0] == '\0'))
+		{
+			plain.remove(s->nvs);
+			Serial.printf("配置项%s已移到密码分区\n", s->path);
+		}
+		sec.end();
+	}
+	plain.end();
+}
+
+/**
+ * 从NVS读入全部配置（不访问SD卡，可在setup开头调用）
+ * NVS中没有的项取默认值
+ */
+bool Config::begin()
+{
+	if (loaded) return true;
+
+	// 字符串统一放在一块内存中
+	uint16_t total = 0;
+	for (uint8_t i = 0; i < CFG_KEY_COUNT; i++)
+	{
+		str_offset[i] = total;
+		if (schema_table[i].type == CFG_TYPE_STR) total += schema_table[i].max + 1;
+	}
+	str_pool = (char*)calloc(1, total ? total : 1);
+	if (str_pool == NULL)
+	{
+		Serial.println("配置缓冲区分配失败");
+		return false;
+	}
+
+	secure_ready = secureBegin();
+
+	Preferences prefs;
+	Preferences sec;
+	bool nvs = prefs.begin(CONFIG_NAMESPACE, true);
+	bool nvs_sec = secure_ready && sec.begin(CONFIG_NAMESPACE, true, CONFIG_SECURE_PARTITION);
+	for (uint8_t i = 0; i < CFG_KEY_COUNT; i++)
+	{
+		const ConfigSchema* s = &schema_table[i];
+		bool secret = partition(s) != NULL;
+		Preferences& p = secret ? sec : prefs;
+		bool open = secret ? nvs_sec : nvs;
+		if (s->type == CFG_TYPE_STR)
+		{
+			char* dst = str_pool + str_offset[i];
+			if (!open || p.getString(s->nvs, dst, s->max + 1) == 0)
+				strlcpy(dst, s->def_str ? s->def_str : "", s->max + 1);
+		}
+		else
+		{
+			int_value[i] = open && p.isKey(s->nvs) ? p.getInt(s->nvs, s->def_int) : s->def_int;
+		}
+	}
+	if (nvs) prefs.end();
+	if (nvs_sec) sec.end();
+
+	if (secure_ready) migrateSecrets();
+	loaded = true;
+	return true;
+}
+
+/**
+ * SD卡挂载后调用：配置文件有变化时导入
+ * @return 导入了新的配置时返回true
+ */
+bool Config::sync()
+{
+	if (!loaded && !begin()) return false;
+	if (SD_FS.cardType() == CARD_NONE) return false;
+
+	uint32_t size, mtime;
+	if (fileChanged(CONFIG_FILE, "_json", &size, &mtime))
+	{
+		if (!importJson(CONFIG_FILE)) return false;
+		saveStamp("_json", size, mtime);
+		return true;
+	}
+	if (!SD_FS.exists(CONFIG_FILE) && fileChanged(CONFIG_LEGACY_WIFI_FILE, "_wifi", &size, &mtime))
+	{
+		if (!importLegacy(CONFIG_LEGACY_WIFI_FILE)) return false;
+		saveStamp("_wifi", size, mtime);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * 比较文件的大小与修改时间和NVS中保存的标记
+ * @return 文件存在且与标记不同时返回true
+ */
+bool Config::fileChanged(const char* path, const char* stamp_key, uint32_t* size, uint32_t* mtime)
+{
+	File f = SD_FS.open(path);
+	if (!f) return false;
+	*size = f.size();
+	*mtime = (uint32_t)f.getLastWrite();
+	f.close();
+
+	uint32_t stamp[2] = { 0, 0 };
+	Preferences prefs;
+	if (prefs.begin(CONFIG_NAMESPACE, true))
+	{
+		prefs.getBytes(stamp_key, stamp, sizeof(stamp));
+		prefs.end();
+	}
+	return stamp[0] != *size || stamp[1] != *mtime;
+}
+
+void Config::saveStamp(const char* stamp_key, uint32_t size, uint32_t mtime)
+{
+	uint32_t stamp[2] = { size, mtime };
+	Preferences prefs;
+	if (!prefs.begin(CONFIG_NAMESPACE, false)) return;
+	prefs.putBytes(stamp_key, stamp, sizeof(stamp));
+	prefs.end();
+}
+
+/**
+ * 解析config.json，逐项校验后写入NVS与内存
+ * 格式错误时整个文件不导入，单项不合法时只跳过该项
+ */
+bool Config::importJson(const char* path)
+{
+	File f = SD_FS.open(path);
+	if (!f) return false;
+	if (f.size() > CONFIG_FILE_MAX)
+	{
+		LOG_W("config", "%s超过%u字节，未导入", path, CONFIG_FILE_MAX);
+		f.close();
+		return false;
+	}
+
+	JsonDocument doc;
+	DeserializationError err = deserializeJson(doc, f);
+	f.close();
+	if (err)
+	{
+		LOG_W("config", "%s解析失败: %s", path, err.c_str());
+		return false;
+	}
+
+	uint8_t count = 0;
+	for (uint8_t i = 0; i < CFG_KEY_COUNT; i++)
+	{
+		const ConfigSchema* s = &schema_table[i];
+
+		// 按路径逐级查找
+		char part[32];
+		const char* p = s->path;
+		JsonVariantConst v = doc.as<JsonVariantConst>();
+		while (*p && !v.isNull())
+		{
+			const char* dot = strchr(p, '.');
+			size_t n = dot ? (size_t)(dot - p) : strlen(p);
+			if (n >= sizeof(part)) n = sizeof(part) - 1;
+			memcpy(part, p, n);
+			part[n] = '\0';
+			v = v[part];
+			p = dot ? dot + 1 : p + n;
+		}
+		if (v.isNull()) continue;
+
+		bool ok = false;
+		switch (s->type)
+		{
+		case CFG_TYPE_STR:
+			ok = v.is<const char*>() && strlen(v.as<const char*>()) <= (size_t)s->max && store((ConfigKey)i, v.as<const char*>(), 0);
+			break;
+		case CFG_TYPE_INT:
+			ok = v.is<int32_t>() && v.as<int32_t>() >= s->min && v.as<int32_t>() <= s->max && store((ConfigKey)i, NULL, v.as<int32_t>());
+			break;
+		case CFG_TYPE_BOOL:
+			ok = v.is<bool>() && store((ConfigKey)i, NULL, v.as<bool>() ? 1 : 0);
+			break;
+		}
+		if (ok) count++;
+		else LOG_W("config", "配置项%s不合法，保留原值", s->path);
+	}
+
+	LOG_I("config", "已从%s导入%u项配置", path, count);
+	return true;
+}
+
+/**
+ * 导入旧的wifi.txt：一次读取，取前两行
+ */
+bool Config::importLegacy(const char* path)
+{
+	File f = SD_FS.open(path);
+	if (!f) return false;
+
+	char line[2][65];
+	uint8_t row = 0;
+	size_t len = 0;
+	line[0][0] = line[1][0] = '\0';
+	while (row < 2 && f.available())
+	{
+		char c = f.read();
+		if (c == '\n')
+		{
+			line[row][len] = '\0';
+			row++;
+			len = 0;
+		}
+		else if (c != '\r' && len < sizeof(line[0]) - 1)
+		{
+			line[row][len++] = c;
+			line[row][len] = '\0';
+		}
+	}
+	f.close();
+
+	// 去掉首尾空白
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		char* s = line[i];
+		size_t n = strlen(s);
+		while (n && isspace((unsigned char)s[n - 1])) s[--n] = '\0';
+		size_t lead = 0;
+		while (s[lead] && isspace((unsigned char)s[lead])) lead++;
+		if (lead) memmove(s, s + lead, n - lead + 1);
+	}
+
+	if (line[0][0] == '\0') return false;
+	store(CFG_WIFI_SSID, line[0], 0);
+	store(CFG_WIFI_PASSWORD, line[1], 0);
+	LOG_I("config", "已从%s导入WiFi配置", path);
+	return true;
+}
+
+/**
+ * 写入NVS与内存；值未变化时不写NVS（减少flash擦写）
+ */
+bool Config::store(ConfigKey key, const char* s, int32_t v)
+{
+	const ConfigSchema* sc = &schema_table[key];
+	if (sc->type == CFG_TYPE_STR)
+	{
+		char* dst = str_pool + str_offset[key];
+		if (strcmp(dst, s) == 0) return true;
+		Preferences prefs;
+		if (!prefs.begin(CONFIG_NAMESPACE, false, partition(sc))) return false;
+		bool ok = prefs.putString(sc->nvs, s) == strlen(s) || s[0] == '\0';
+		prefs.end();
+		if (ok) strlcpy(dst, s, sc->max + 1);
+		return ok;
+	}
+
+	if (int_value[key] == v) return true;
+	Preferences prefs;
+	if (!prefs.begin(CONFIG_NAMESPACE, false, partition(sc))) return false;
+	bool ok = prefs.putInt(sc->nvs, v) == sizeof(int32_t);
+	prefs.end();
+	if (ok) int_value[key] = v;
+	return ok;
+}
+
+const char* Config::getStr(ConfigKey key)
+{
+	if (!loaded || key >= CFG_KEY_COUNT || schema_table[key].type != CFG_TYPE_STR) return "";
+	return str_pool + str_offset[key];
+}
+
+int32_t Config::getInt(ConfigKey key)
+{
+	if (key >= CFG_KEY_COUNT) return 0;
+	if (!loaded) return schema_table[key].def_int;
+	return int_value[key];
+}
+
+bool Config::getBool(ConfigKey key)
+{
+	return getInt(key) != 0;
+}
+
+/**
+ * 修改配置（写入NVS，持久保存；config.json下次变化时仍会覆盖）
+ * @return 类型不符、超出范围或NVS写入失败时返回false
+ */
+bool Config::set(ConfigKey key, const char* value)
+{
+	if (!loaded || key >= CFG_KEY_COUNT || schema_table[key].type != CFG_TYPE_STR || value == NULL) return false;
+	if (strlen(value) > (size_t)schema_table[key].max) return false;
+	return store(key, value, 0);
+}
+
+bool Config::set(ConfigKey key, int32_t value)
+{
+	if (!loaded || key >= CFG_KEY_COUNT || schema_table[key].type == CFG_TYPE_STR) return false;
+	const ConfigSchema* s = &schema_table[key];
+	if (s->type == CFG_TYPE_BOOL) value = value ? 1 : 0;
+	else if (value < s->min || value > s->max) return false;
+	return store(key, NULL, value);
+}
+
+ConfigKey Config::find(const char* path)
+{
+	for (uint8_t i = 0; i < CFG_KEY_COUNT; i++)
+	{
+		if (strcmp(schema_table[i].path, path) == 0) return (ConfigKey)i;
+	}
+	return CFG_KEY_COUNT;
+}
+
+const ConfigSchema* Config::schema(ConfigKey key)
+{
+	return key < CFG_KEY_COUNT ? &schema_table[key] : NULL;
+}
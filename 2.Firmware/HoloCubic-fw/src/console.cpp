@@ -0,0 +1,374 @@
+/*
+ * HoloCubic 串口诊断命令
+ *
+ * 功能说明：
+ * 1. 串口任务（serial_link）把帧以外的字节放入环形缓冲，命令任务按行取出，不读串口、不阻塞串口任务
+ * 2. 一行按空白切分为最多CONSOLE_ARGS_MAX个参数，查命令表（第一个词，必要时加第二个词）执行
+ * 3. 回复经异步日志输出；需要LVGL的命令通过runtime.post交给LVGL任务
+ *
+ * 示例（终端，115200，回车结束）：
+ *   stats
+ *   log level w
+ *   scene play Holo3D 30
+ *
+ * 数据流：
+ *   Serial --> SerialLink::readFrame（非帧字节）--> feed --> rx环形缓冲 --> readLine --> exec --> 命令表
+ */
+
+#include "console.h"
+#include "logger.h"
+#include "telemetry.h"
+#include "quality_gov.h"
+#include "async_image.h"
+#include "cache_prof.h"
+#include "lv_port_mem.h"
+#include "storage_bench.h"
+#include "prim_bench.h"
+#include "scene_bench.h"
+#include "sd_hotplug.h"
+#include "gui_guider.h"
+#include <esp_heap_caps.h>
+
+#define CONSOLE_RX_MASK (CONSOLE_RX_BUF - 1)
+
+Console console;
+
+const ConsoleCmd Console::commands[] = {
+	{ "help",  NULL,    Console::cmdHelp,      "列出命令" },
+	{ "stats", NULL,    Console::cmdStats,     "帧率/刷新/SD/场景/画质" },
+	{ "heap",  NULL,    Console::cmdHeap,      "系统堆/PSRAM/LVGL内存" },
+	{ "cache", "stats", Console::cmdCache,     "图像缓存与取指停顿" },
+	{ "log",   "level", Console::cmdLogLevel,  "[e|w|i|d] 日志级别" },
+	{ "bench", "sd",    Console::cmdBenchSd,   "存储基准" },
+	{ "bench", "draw",  Console::cmdBenchDraw, "绘制原语微基准" },
+	{ "bench", "scene", Console::cmdBenchScene, "[名称] [秒] 场景播放基准" },
+	{ "scene", "play",  Console::cmdScenePlay, "<名称> [fps] 播放场景" },
+	{ "scene", "stop",  Console::cmdSceneStop, "停止播放" },
+};
+
+#define CONSOLE_CMD_CNT (sizeof(commands) / sizeof(commands[0]))
+
+Console::Console()
+{
+	task = NULL;
+	screen = NULL;
+	player = NULL;
+	rx_head = 0;
+	rx_tail = 0;
+	overrun = 0;
+	line_len = 0;
+	line_drop = false;
+	ui_busy = false;
+	ui_arg[0] = '\0';
+	ui_fps = 0;
+}
+
+bool Console::begin(Display* display, ScenePlayer* scene)
+{
+	if (task) return true;
+	screen = display;
+	player = scene;
+	if (xTaskCreatePinnedToCore(taskEntry, "console", CONSOLE_TASK_STACK, this,
+								CONSOLE_TASK_PRIORITY, &task, CONSOLE_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 放入一个字节（串口任务）：只写rx_head，满时丢弃并计数；行结束时唤醒命令任务
+ */
+void Console::feed(uint8_t c)
+{
+	if (!task) return;
+	uint16_t head = rx_head;
+	if ((uint16_t)(head - rx_tail) >= CONSOLE_RX_BUF)
+	{
+		overrun++;
+		return;
+	}
+	rx[head & CONSOLE_RX_MASK] = c;
+	__atomic_store_n(&rx_head, (uint16_t)(head + 1), __ATOMIC_RELEASE);
+	if (c == '\n' || c == '\r') xTaskNotifyGive(task);
+}
+
+uint32_t Console::getOverrun()
+{
+	return overrun;
+}
+
+/**
+ * 从环形缓冲取出字节拼成一行（命令任务）；取到行结束符且行不为空时返回true
+ * 超长的行标记为丢弃，直到行结束符为止
+ */
+bool Console::readLine()
+{
+	uint16_t head = __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE);
+	while (rx_tail != head)
+	{
+		char c = (char)rx[rx_tail & CONSOLE_RX_MASK];
+		rx_tail = rx_tail + 1;
+
+		if (c == '\r' || c == '\n')
+		{
+			bool ok = line_len > 0 && !line_drop;
+			if (line_drop) LOG_W("con", "命令过长（最多%u字符）", CONSOLE_LINE_MAX - 1);
+			line[line_len] = '\0';
+			line_len = 0;
+			line_drop = false;
+			if (ok) return true;
+			continue;
+		}
+		if (c == 0x08 || c == 0x7f)
+		{
+			if (line_len) line_len--;
+			continue;
+		}
+		if ((uint8_t)c < 0x20) continue;
+		if (line_len >= CONSOLE_LINE_MAX - 1)
+		{
+			line_drop = true;
+			continue;
+		}
+		line[line_len++] = c;
+	}
+	return false;
+}
+
+/**
+ * 切分参数并查命令表
+ */
+void Console::exec(char* text)
+{
+	char* argv[CONSOLE_ARGS_MAX];
+	int argc = 0;
+	char* p = text;
+	while (*p && argc < CONSOLE_ARGS_MAX)
+	{
+		while (*p == ' ' || *p == '\t') *p++ = '\0';
+		if (!*p) break;
+		argv[argc++] = p;
+		while (*p && *p != ' ' && *p != '\t') p++;
+	}
+	if (argc == 0) return;
+
+	bool name_found = false;
+	for (uint8_t i = 0; i < CONSOLE_CMD_CNT; i++)
+	{
+		const ConsoleCmd* c = &commands[i];
+		if (strcmp(argv[0], c->name) != 0) continue;
+		name_found = true;
+		if (c->sub && (argc < 2 || strcmp(argv[1], c->sub) != 0)) continue;
+		c->fn(this, argc, argv);
+		return;
+	}
+	if (name_found)
+		LOG_W("con", "%s: 缺少或未知的子命令（help查看）", argv[0]);
+	else
+		LOG_W("con", "未知命令：%s（help查看）", argv[0]);
+}
+
+/**
+ * 把命令交给LVGL任务：上一条尚未执行时拒绝（ui_arg只有一份）
+ */
+bool Console::postUi(ui_msg_cb_t cb)
+{
+	if (ui_busy)
+	{
+		LOG_W("con", "上一条命令尚未执行");
+		return false;
+	}
+	ui_busy = true;
+	if (!runtime.post(cb, this))
+	{
+		ui_busy = false;
+		LOG_W("con", "UI消息队列已满");
+		return false;
+	}
+	return true;
+}
+
+void Console::taskEntry(void* arg)
+{
+	Console* self = (Console*)arg;
+	for (;;)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONSOLE_POLL_MS));
+		while (self->readLine()) self->exec(self->line);
+	}
+}
+
+/**** 命令 ****/
+
+void Console::cmdHelp(Console* con, int argc, char** argv)
+{
+	for (uint8_t i = 0; i < CONSOLE_CMD_CNT; i++)
+	{
+		const ConsoleCmd* c = &commands[i];
+		LOG_I("con", "%s%s%s  %s", c->name, c->sub ? " " : "", c->sub ? c->sub : "", c->help);
+	}
+}
+
+void Console::cmdStats(Console* con, int argc, char** argv)
+{
+	TelemetrySample s;
+	if (telemetry.isRunning() && telemetry.get(&s))
+	{
+		LOG_I("con", "fps %u.%u flush %luus spi %luus", s.fps_x10 / 10, s.fps_x10 % 10,
+			  (unsigned long)s.flush_us, (unsigned long)s.spi_us);
+		LOG_I("con", "sd 读%luB/s 写%luB/s imu %usps", (unsigned long)s.sd_read_bps,
+			  (unsigned long)s.sd_write_bps, s.imu_sps);
+		LOG_I("con", "scene %u帧 偏差%lu/%luus 丢%u 重复%u 读%lu/%luus 深度%u", s.scene_frames,
+			  (unsigned long)s.scene_jitter_us, (unsigned long)s.scene_jitter_max_us, s.scene_dropped,
+			  s.scene_repeated, (unsigned long)s.scene_read_us, (unsigned long)s.scene_read_max_us, s.scene_depth);
+	}
+	else
+	{
+		LOG_I("con", "遥测未启动（TELEMETRY_ON_BOOT或telemetry.begin()），只输出画质与日志");
+	}
+	LOG_I("con", "quality %u 平均帧%luus 切换%lu次", quality.getLevel(),
+		  (unsigned long)quality.getAvgFrameUs(), (unsigned long)quality.getChanges());
+	LOG_I("con", "log 丢弃%lu 限速%lu console溢出%lu", (unsigned long)logger.getDropped(),
+		  (unsigned long)logger.getLimited(), (unsigned long)con->overrun);
+}
+
+void Console::cmdHeap(Console* con, int argc, char** argv)
+{
+	LOG_I("con", "internal 空闲%u 最低%u 最大块%u", heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+		  heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+	if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0)
+		LOG_I("con", "psram 空闲%u 最大块%u", heap_caps_get_free_size(MALLOC_CAP_SPIRAM),
+			  heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+
+	// LVGL分配器只在LVGL任务中修改，读取时持有LVGL锁
+	lv_port_mem_stats_t mem;
+	runtime.lock();
+	lv_port_mem_get_stats(&mem);
+	runtime.unlock();
+	LOG_I("con", "lvgl 已用%lu 峰值%lu 空闲%lu 最大块%lu 失败%lu", (unsigned long)mem.used_size,
+		  (unsigned long)mem.max_used, (unsigned long)mem.heap_free, (unsigned long)mem.heap_biggest,
+		  (unsigned long)mem.fail_cnt);
+}
+
+void Console::cmdCache(Console* con, int argc, char** argv)
+{
+	LOG_I("con", "imgloader 解码%lu 失败%lu", (unsigned long)imgloader.getDecoded(),
+		  (unsigned long)imgloader.getFailed());
+#if CACHE_PROF
+	con->postUi([](const UiMsg* msg) {
+		cache_prof_log();
+		((Console*)msg->obj)->ui_busy = false;
+	});
+#endif
+}
+
+void Console::cmdLogLevel(Console* con, int argc, char** argv)
+{
+	static const char level_chars[] = "-ewid";
+	if (argc >= 3)
+	{
+		const char* p = strchr(level_chars + 1, argv[2][0] | 0x20);
+		if (!p || argv[2][1] != '\0')
+		{
+			LOG_W("con", "级别为e/w/i/d之一");
+			return;
+		}
+		logger.setLevel(p - level_chars);
+	}
+	// 级别为e时WARN也被丢弃，这一行改以ERROR输出
+	uint8_t lv = logger.getLevel();
+	log_write(lv >= LOG_LEVEL_WARN ? LOG_LEVEL_WARN : LOG_LEVEL_ERROR, "con", "日志级别 %c（编译时最高%c）",
+			  level_chars[lv], level_chars[LOG_LEVEL]);
+}
+
+void Console::cmdBenchSd(Console* con, int argc, char** argv)
+{
+	if (!sdhotplug.beginIo())
+	{
+		LOG_W("con", "SD卡未挂载");
+		return;
+	}
+	LOG_I("con", "存储基准开始，结果见BENCH,...");
+	logger.flush();
+	StorageBench bench;
+	bench.run();
+	sdhotplug.endIo();
+}
+
+void Console::cmdBenchDraw(Console* con, int argc, char** argv)
+{
+	if (!con->screen)
+	{
+		LOG_W("con", "没有显示对象");
+		return;
+	}
+	con->postUi([](const UiMsg* msg) {
+		Console* self = (Console*)msg->obj;
+		if (!primbench.run(self->screen)) LOG_W("con", "绘制基准内存不足");
+		self->ui_busy = false;
+	});
+}
+
+void Console::cmdBenchScene(Console* con, int argc, char** argv)
+{
+	if (!con->player) return;
+	char pack[SCENE_PATH_MAX];
+	if (argc >= 3)
+		snprintf(pack, sizeof(pack), SCENE_ROOT "/%s", argv[2]);
+	else
+		strcpy(pack, SCENE_BENCH_PACK);
+	uint16_t secs = argc >= 4 ? (uint16_t)constrain(atoi(argv[3]), 1, 600) : SCENE_BENCH_SECONDS;
+	LOG_I("con", "场景基准%s（%us），结果见SCENEBENCH,...", pack, secs);
+	logger.flush();
+	if (!scenebench.run(con->player, pack, secs)) LOG_W("con", "场景基准未运行");
+}
+
+void Console::cmdScenePlay(Console* con, int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		LOG_W("con", "用法：scene play <名称> [fps]");
+		return;
+	}
+	if (!con->player) return;
+	if (con->ui_busy)
+	{
+		LOG_W("con", "上一条命令尚未执行");
+		return;
+	}
+	if (strlen(argv[2]) >= sizeof(con->ui_arg))
+	{
+		LOG_W("con", "场景名过长");
+		return;
+	}
+	strcpy(con->ui_arg, argv[2]);
+	con->ui_fps = argc >= 4 ? (uint8_t)constrain(atoi(argv[3]), 1, 60) : SCENE_INDEX_DEFAULT_FPS;
+	con->postUi([](const UiMsg* msg) {
+		Console* self = (Console*)msg->obj;
+		char dir[SCENE_INDEX_NAME_MAX + sizeof(SCENE_ROOT) + 1];
+		snprintf(dir, sizeof(dir), SCENE_ROOT "/%s", self->ui_arg);
+		self->player->close();
+		if (self->player->open(dir, 0, self->ui_fps))
+		{
+			self->player->play(guider_ui.scenes_canvas);
+			LOG_I("con", "播放%s（%ufps）", dir, self->ui_fps);
+		}
+		else
+		{
+			LOG_W("con", "无法打开%s", dir);
+		}
+		self->ui_busy = false;
+	});
+}
+
+void Console::cmdSceneStop(Console* con, int argc, char** argv)
+{
+	if (!con->player) return;
+	con->postUi([](const UiMsg* msg) {
+		Console* self = (Console*)msg->obj;
+		self->player->close();
+		self->ui_busy = false;
+	});
+}
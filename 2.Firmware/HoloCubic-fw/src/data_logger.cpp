@@ -0,0 +1,457 @@
+/*
+ * HoloCubic 传感器数据记录
+ *
+ * 功能说明：
+ * 1. IMU样本（原始样本流200Hz，或传感器总线100Hz）在传感器任务中组成块，每块一次写入后台SD写入流
+ * 2. 环境光的每次读数（I2C总线任务）只更新最新值，写块时记入块头
+ * 3. 记录任务每DATALOG_CHECK_MS检查轮换条件（时长、大小、SD卡重新挂载），打开新文件后在块边界切换
+ * 4. 加速度按DATALOG_CHART_HZ抽取进环形缓冲，界面在LVGL任务中取出画到实时曲线
+ *
+ * 数据流：
+ *   传感器任务 --> pushSample（组块） --> SdWriter（内存缓冲） --> 写入任务 --> SD卡
+ *                             \--> 曲线环形缓冲 --> updateUi（LVGL任务） --> StreamChart
+ *
+ * 文件轮换：
+ *   记录任务：打开writers[新]并写文件头 --> next = 新 --> 等待传感器任务在块边界把cur换成新 --> 关闭writers[旧]
+ */
+
+#include "data_logger.h"
+#include "sd_card.h"
+#include "sd_hotplug.h"
+#include "sensor_bus.h"
+#include "i18n.h"
+#include "time_service.h"
+#include "logger.h"
+
+DataLogger datalogger;
+
+DataLogger::DataLogger()
+{
+	imu = NULL;
+	cur = -1;
+	next = -1;
+	seq = 0;
+	file_ms = 0;
+	sd_gen = 0;
+	scan_gen = -1;
+	rate_hz = 0;
+	subscribed = false;
+	raw = false;
+	active = false;
+	stop_req = false;
+	rotate_req = false;
+	task = NULL;
+	mux = portMUX_INITIALIZER_UNLOCKED;
+	block_count = 0;
+	block_file = -1;
+	last_us = 0;
+	lux = DATALOG_LUX_NONE;
+	lux_new = false;
+	ring_head = 0;
+	ring_count = 0;
+	chart_every = 1;
+	chart_phase = 0;
+	samples = 0;
+	bytes_done = 0;
+	lost_done = 0;
+	scr = NULL;
+	prev_scr = NULL;
+	info = NULL;
+	info_due = 0;
+}
+
+void DataLogger::begin(IMU* i)
+{
+	imu = i;
+	if (subscribed) return;
+	sensorbus.subscribe(SENSOR_IMU, 1, onBusImu, this);
+	sensorbus.subscribe(SENSOR_AMBIENT, 1, onBusLux, this);
+	subscribed = true;
+}
+
+bool DataLogger::start()
+{
+	if (task) return false;
+	stop_req = false;
+	rotate_req = false;
+	samples = 0;
+	bytes_done = 0;
+	lost_done = 0;
+	if (xTaskCreatePinnedToCore(taskEntry, "datalog", DATALOG_TASK_STACK, this,
+								DATALOG_TASK_PRIORITY, &task, DATALOG_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		return false;
+	}
+	return true;
+}
+
+void DataLogger::stop()
+{
+	if (task == NULL) return;
+	stop_req = true;
+	xTaskNotifyGive(task);
+}
+
+bool DataLogger::isRunning()
+{
+	return task != NULL;
+}
+
+void DataLogger::rotate()
+{
+	if (task == NULL) return;
+	rotate_req = true;
+	xTaskNotifyGive(task);
+}
+
+uint16_t DataLogger::getRate()
+{
+	return rate_hz;
+}
+
+uint16_t DataLogger::getSeq()
+{
+	return seq;
+}
+
+uint32_t DataLogger::getSamples()
+{
+	return samples;
+}
+
+uint32_t DataLogger::getBytes()
+{
+	int8_t f = cur;
+	return bytes_done + (f >= 0 ? writers[f].getWritten() : 0);
+}
+
+uint32_t DataLogger::getLost()
+{
+	int8_t f = cur;
+	return lost_done + (f >= 0 ? writers[f].getDropped() : 0);
+}
+
+/**** 传感器任务 ****/
+
+void DataLogger::onRaw(const int16_t* accel, const int16_t* gyro, uint32_t t_us, void* user)
+{
+	((DataLogger*)user)->pushSample(accel, gyro, t_us);
+}
+
+void DataLogger::onBusImu(const SensorSample* s, void* user)
+{
+	DataLogger* self = (DataLogger*)user;
+	// 毫秒时间换算为微秒：millis() * 1000与micros()模2^32一致
+	if (!self->raw) self->pushSample(s->accel, s->gyro, s->time_ms * 1000);
+}
+
+void DataLogger::onBusLux(const SensorSample* s, void* user)
+{
+	DataLogger* self = (DataLogger*)user;
+	self->lux = s->lux < DATALOG_LUX_NONE ? s->lux : DATALOG_LUX_NONE - 1;
+	self->lux_new = true;
+}
+
+/**
+ * 加入一个样本：块的第一个样本时在块边界切换到轮换后的文件，块满或间隔超出dt_us范围时写出
+ * 停止请求到达后写出不满的最后一块并不再接收
+ */
+void DataLogger::pushSample(const int16_t* accel, const int16_t* gyro, uint32_t t_us)
+{
+	if (!active) return;
+	if (stop_req)
+	{
+		if (block_count) flushBlock();
+		active = false;
+		return;
+	}
+
+	// FIFO复位等造成的长间隔：另起一块，块头带绝对时间
+	if (block_count && t_us - last_us > 0xFFFF) flushBlock();
+	DataLogBlock* h = (DataLogBlock*)block;
+	if (block_count == 0)
+	{
+		portENTER_CRITICAL(&mux);
+		if (next >= 0)
+		{
+			cur = next;
+			next = -1;
+		}
+		block_file = cur;
+		portEXIT_CRITICAL(&mux);
+		if (block_file < 0) return;
+		h->t_us = t_us - start_us[block_file];
+		last_us = t_us;
+	}
+
+	DataLogImu* r = (DataLogImu*)(block + sizeof(DataLogBlock)) + block_count;
+	r->dt_us = t_us - last_us;
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		r->v[i] = accel[i];
+		r->v[3 + i] = gyro[i];
+	}
+	last_us = t_us;
+	samples++;
+	if (++block_count >= DATALOG_BLOCK_SAMPLES) flushBlock();
+
+	if (++chart_phase >= chart_every)
+	{
+		chart_phase = 0;
+		portENTER_CRITICAL(&mux);
+		memcpy(ring[ring_head], accel, sizeof(ring[0]));
+		ring_head = (ring_head + 1) % DATALOG_CHART_RING;
+		if (ring_count < DATALOG_CHART_RING) ring_count++;
+		portEXIT_CRITICAL(&mux);
+	}
+}
+
+/**
+ * 写出当前块（只复制进SdWriter的缓冲），块头的环境光取块期间最新的读数
+ */
+void DataLogger::flushBlock()
+{
+	DataLogBlock* h = (DataLogBlock*)block;
+	h->tag = DATALOG_BLOCK_TAG;
+	h->count = block_count;
+	h->lux = lux_new ? lux : DATALOG_LUX_NONE;
+	lux_new = false;
+	writers[block_file].write(block, sizeof(DataLogBlock) + block_count * sizeof(DataLogImu));
+	block_count = 0;
+}
+
+/**** 记录任务 ****/
+
+/**
+ * 目录中已有文件的最大序号（没有时为0）
+ */
+uint16_t DataLogger::lastSeq()
+{
+	uint16_t last = 0;
+	File dir = SD_FS.open(DATALOG_DIR);
+	if (!dir) return 0;
+	File f;
+	while ((f = dir.openNextFile()))
+	{
+		const char* n = strrchr(f.name(), '/');
+		n = n ? n + 1 : f.name();
+		unsigned v;
+		if (sscanf(n, "log_%5u.hdl", &v) == 1 && v > last && v <= 0xFFFF) last = v;
+		f.close();
+	}
+	dir.close();
+	return last;
+}
+
+/**
+ * 打开下一个文件并写入文件头，交给传感器任务在块边界切换，然后关闭旧文件
+ * @return SD卡不可用或无法打开文件时返回false（继续写入旧文件，下一次检查时重试）
+ */
+bool DataLogger::rotateFile()
+{
+	if (!sdhotplug.beginIo()) return false;
+	// 第一次打开或重新挂载后（可能换了一张卡）重新查找已有文件的最大序号
+	if (scan_gen != tf.generation())
+	{
+		SD_FS.mkdir("/log");
+		SD_FS.mkdir(DATALOG_DIR);
+		seq = lastSeq();
+		scan_gen = tf.generation();
+	}
+	int8_t old = cur;
+	int8_t f = old == 0 ? 1 : 0;
+	uint16_t n = seq + 1;
+	char path[sizeof(DATALOG_DIR) + 16];
+	if (n > DATALOG_KEEP_FILES)
+	{
+		snprintf(path, sizeof(path), DATALOG_DIR "/log_%05u.hdl", n - DATALOG_KEEP_FILES);
+		SD_FS.remove(path);
+	}
+	snprintf(path, sizeof(path), DATALOG_DIR "/log_%05u.hdl", n);
+	bool ok = writers[f].begin(path, false);
+	if (ok)
+	{
+		DataLogHeader h = {};
+		memcpy(h.magic, DATALOG_MAGIC, 4);
+		h.version = DATALOG_VERSION;
+		h.header_size = sizeof(h);
+		h.imu_rate_hz = rate_hz;
+		h.seq = n;
+		h.start_ms = millis();
+		h.start_epoch = (uint32_t)timesvc.now();
+		h.block_size = sizeof(DataLogBlock);
+		h.sample_size = sizeof(DataLogImu);
+		start_us[f] = micros();
+		writers[f].write(&h, sizeof(h));
+	}
+	sdhotplug.endIo();
+	if (!ok) return false;
+
+	portENTER_CRITICAL(&mux);
+	if (old < 0) cur = f;
+	else next = f;
+	portEXIT_CRITICAL(&mux);
+
+	if (old >= 0)
+	{
+		// 传感器任务在下一个块边界切换；没有样本（IMU停止）时直接切换
+		uint32_t t0 = millis();
+		while (next >= 0 && millis() - t0 < DATALOG_SWITCH_MS) vTaskDelay(pdMS_TO_TICKS(10));
+		portENTER_CRITICAL(&mux);
+		if (next >= 0)
+		{
+			cur = next;
+			next = -1;
+		}
+		portEXIT_CRITICAL(&mux);
+		closeFile(old);
+	}
+	seq = n;
+	file_ms = millis();
+	sd_gen = tf.generation();
+	LOG_I("datalog", "记录文件: %s（%uHz）", path, rate_hz);
+	return true;
+}
+
+/**
+ * 关闭文件并计入累计统计（等待SdWriter写入剩余数据）
+ */
+void DataLogger::closeFile(int8_t f)
+{
+	writers[f].end();
+	bytes_done += writers[f].getWritten();
+	lost_done += writers[f].getDropped();
+}
+
+void DataLogger::run()
+{
+	scan_gen = -1;
+	raw = imu && imu->setRawStream(onRaw, this, DATALOG_IMU_RATE_HZ);
+	// 传感器总线上的IMU样本在三种模式下均为100Hz
+	rate_hz = raw ? DATALOG_IMU_RATE_HZ : IMU_FIFO_RATE_HZ;
+	chart_every = rate_hz / DATALOG_CHART_HZ ? rate_hz / DATALOG_CHART_HZ : 1;
+	chart_phase = 0;
+	block_count = 0;
+	cur = -1;
+	next = -1;
+	active = true;
+	if (!raw) LOG_W("datalog", "IMU不支持原始样本流（DMP/轮询模式），按%uHz记录", rate_hz);
+
+	while (!stop_req)
+	{
+		uint32_t age = millis() - file_ms;
+		if (cur < 0 || rotate_req || sd_gen != tf.generation() || age >= DATALOG_ROTATE_MIN * 60000UL ||
+			writers[cur].getWritten() >= DATALOG_ROTATE_BYTES)
+		{
+			rotate_req = false;
+			rotateFile();
+		}
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DATALOG_CHECK_MS));
+	}
+
+	// 传感器任务写出最后一块后停止接收（IMU没有样本时超时）
+	uint32_t t0 = millis();
+	while (active && millis() - t0 < DATALOG_SWITCH_MS) vTaskDelay(pdMS_TO_TICKS(10));
+	active = false;
+	if (raw) imu->setRawStream(NULL, NULL, 0);
+	raw = false;
+	if (next >= 0) closeFile(next);
+	if (cur >= 0) closeFile(cur);
+	cur = -1;
+	next = -1;
+	LOG_I("datalog", "记录结束: %u个样本，%u字节，丢弃%u字节", samples, bytes_done, lost_done);
+}
+
+void DataLogger::taskEntry(void* arg)
+{
+	DataLogger* self = (DataLogger*)arg;
+	self->run();
+	self->task = NULL;
+	vTaskDelete(NULL);
+}
+
+/**** 界面 ****/
+
+bool DataLogger::showUi()
+{
+	if (scr) return true;
+	static const lv_color_t colors[3] = { LV_COLOR_RED, LV_COLOR_LIME, LV_COLOR_CYAN };
+
+	prev_scr = lv_scr_act();
+	scr = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(scr, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	// 纵轴±2g（加速度16384/g）
+	if (!chart.create(scr, DATALOG_CHART_W, DATALOG_CHART_H, 3, colors, -32768, 32767))
+	{
+		lv_obj_del(scr);
+		scr = NULL;
+		return false;
+	}
+	lv_obj_align(chart.getObj(), NULL, LV_ALIGN_IN_TOP_MID, 0, 40);
+
+	info = lv_label_create(scr, NULL);
+	lv_label_set_long_mode(info, LV_LABEL_LONG_CROP);
+	lv_label_set_align(info, LV_LABEL_ALIGN_CENTER);
+	lv_obj_set_width(info, LV_HOR_RES_MAX);
+	lv_obj_set_pos(info, 0, 40 + DATALOG_CHART_H + 16);
+	lv_obj_set_style_local_text_color(info, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_GRAY);
+	lv_obj_set_style_local_text_font(info, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, i18n.getFont());
+	lv_label_set_text_static(info, "");
+	info_due = 0;
+
+	portENTER_CRITICAL(&mux);
+	ring_count = 0;
+	portEXIT_CRITICAL(&mux);
+	lv_scr_load(scr);
+	updateUi();
+	return true;
+}
+
+void DataLogger::hideUi()
+{
+	if (scr == NULL) return;
+	if (prev_scr) lv_scr_load(prev_scr);
+	chart.destroy();
+	lv_obj_del(scr);
+	scr = NULL;
+	info = NULL;
+}
+
+/**
+ * 取出环形缓冲中的加速度画到曲线（每个采样一列），每DATALOG_INFO_MS更新一次状态文字
+ */
+void DataLogger::updateUi()
+{
+	int16_t v[DATALOG_CHART_RING][3];
+	uint8_t n;
+	portENTER_CRITICAL(&mux);
+	n = ring_count;
+	for (uint8_t i = 0; i < n; i++)
+		memcpy(v[i], ring[(ring_head + DATALOG_CHART_RING - n + i) % DATALOG_CHART_RING], sizeof(v[0]));
+	ring_count = 0;
+	portEXIT_CRITICAL(&mux);
+	if (scr == NULL) return;
+	for (uint8_t i = 0; i < n; i++) chart.push(v[i]);
+
+	uint32_t now = millis();
+	if ((int32_t)(now - info_due) < 0) return;
+	info_due = now + DATALOG_INFO_MS;
+	uint32_t kb = getBytes() / 1024;
+	if (task == NULL) lv_label_set_text_static(info, "--");
+	else
+		lv_label_set_text_fmt(info, "log_%05u  %uHz\n%u.%u MB  lost %u B\nlux %u", seq, rate_hz, kb / 1024,
+							  kb % 1024 * 10 / 1024, getLost(), lux == DATALOG_LUX_NONE ? 0 : lux);
+}
+
+/**** 应用入口 ****/
+
+const App datalog_app = {
+	"datalog",
+	[](void* u) { datalogger.start(); datalogger.showUi(); },
+	[](void* u) { datalogger.updateUi(); },
+	[](void* u) { datalogger.hideUi(); },
+	[](void* u) { datalogger.hideUi(); datalogger.stop(); },
+	64 * 1024, 0, 0, APP_BG_PERIOD_MS, NULL,
+	NULL, 0
+};
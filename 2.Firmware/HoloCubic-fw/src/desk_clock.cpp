@@ -0,0 +1,263 @@
+/*
+ * HoloCubic 桌面时钟
+ *
+ * 功能说明：
+ * 1. 进入时用画布把"0"~"9"和":"渲染为真彩色字形图像（字体montserrat 48，底色预先填好），
+ *    之后绘制数字只是图像复制，不再逐像素混合字形
+ * 2. 每秒的定时器对齐到整秒：只替换变化的那一位数字图像，冒号闪烁只重绘冒号区域，
+ *    分钟不变时每秒重绘的面积只有冒号大小
+ * 3. 界面刷新周期设为CLOCK_REFR_MS，有变化时由定时器立即触发一次刷新，
+ *    两次之间LVGL任务没有到期的定时器，按runtime的最长休眠时间休眠
+ * 4. 时间取自时间服务（timesvc），同步完成前只显示冒号与状态文字
+ *
+ * 布局（240x240）：
+ *        HH:MM        数字按最宽数字等宽排列，时间变化时不左右跳动
+ *     2026-10-14 Wed  日期（montserrat 14），每天更新一次
+ *
+ * 注意事项：
+ * - 字形图像共约22KB（10 x 32 x 34 x 2字节加冒号），有PSRAM时放PSRAM
+ * - 时区与NTP服务器见time_service.h（TIME_TZ_OFFSET_S、TIME_NTP_SERVER）
+ */
+
+#include "desk_clock.h"
+#include "runtime.h"
+#include "buf_manager.h"
+#include "time_service.h"
+#include "i18n.h"
+#include "logger.h"
+
+DeskClock deskclock;
+
+DeskClock::DeskClock()
+{
+	scr = NULL;
+	prev_scr = NULL;
+	task = NULL;
+	net = NULL;
+	memset(glyph, 0, sizeof(glyph));
+}
+
+void DeskClock::setNetwork(Network* n)
+{
+	net = n;
+}
+
+/**
+ * 渲染11个字形图像（需要scr已创建，画布临时建在scr上）
+ */
+bool DeskClock::renderGlyphs()
+{
+	const lv_font_t* font = &CLOCK_FONT;
+	// 格宽取最宽的数字；高度裁到数字的上下边界（行高上下的空白约占三分之一）
+	lv_coord_t dw = 0;
+	lv_coord_t top = LV_COORD_MAX;
+	lv_coord_t bottom = LV_COORD_MIN;
+	for (char c = '0'; c <= '9'; c++)
+	{
+		lv_font_glyph_dsc_t g;
+		if (!lv_font_get_glyph_dsc(font, &g, c, 0)) continue;
+		dw = LV_MATH_MAX(dw, g.adv_w);
+		top = LV_MATH_MIN(top, font->line_height - font->base_line - g.box_h - g.ofs_y);
+		bottom = LV_MATH_MAX(bottom, font->line_height - font->base_line - g.ofs_y);
+	}
+	if (dw == 0) return false;
+	lv_coord_t h = bottom - top;
+	lv_coord_t cw = lv_font_get_glyph_width(font, ':', 0);
+
+	lv_draw_label_dsc_t dsc;
+	lv_draw_label_dsc_init(&dsc);
+	dsc.font = font;
+	dsc.color = CLOCK_FG_COLOR;
+
+	lv_obj_t* canvas = lv_canvas_create(scr, NULL);
+	lv_obj_set_hidden(canvas, true);
+	bool ok = true;
+	for (uint8_t i = 0; i < 11; i++)
+	{
+		lv_coord_t w = i < 10 ? dw : cw;
+		uint32_t size = LV_CANVAS_BUF_SIZE_TRUE_COLOR(w, h);
+		uint8_t* buf = (uint8_t*)buf_alloc(BUF_BULK, size);
+		if (buf == NULL)
+		{
+			ok = false;
+			break;
+		}
+		char txt[2] = { i < 10 ? (char)('0' + i) : ':', '\0' };
+		lv_canvas_set_buffer(canvas, buf, w, h, LV_IMG_CF_TRUE_COLOR);
+		lv_canvas_fill_bg(canvas, CLOCK_BG_COLOR, LV_OPA_COVER);
+		lv_canvas_draw_text(canvas, 0, -top, w, &dsc, txt, LV_LABEL_ALIGN_CENTER);
+		glyph[i] = *lv_canvas_get_img(canvas);
+		glyph[i].data_size = size;
+	}
+	lv_obj_del(canvas);
+
+	if (!ok)
+	{
+		LOG_E("clock", "字形图像分配失败: 11 x %u字节", LV_CANVAS_BUF_SIZE_TRUE_COLOR(dw, h));
+		freeGlyphs();
+	}
+	return ok;
+}
+
+void DeskClock::freeGlyphs()
+{
+	for (uint8_t i = 0; i < 11; i++)
+	{
+		if (glyph[i].data == NULL) continue;
+		// 缓存按描述符地址查找，下次进入时同一地址对应新的缓冲区
+		lv_img_cache_invalidate_src(&glyph[i]);
+		buf_free((void*)glyph[i].data);
+	}
+	memset(glyph, 0, sizeof(glyph));
+}
+
+/**
+ * 进入时钟界面
+ * @return 已在运行或内存不足时返回false
+ */
+bool DeskClock::start()
+{
+	if (task) return false;
+
+	prev_scr = lv_scr_act();
+	scr = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(scr, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, CLOCK_BG_COLOR);
+	if (!renderGlyphs())
+	{
+		lv_obj_del(scr);
+		scr = NULL;
+		return false;
+	}
+
+	lv_coord_t dw = glyph[0].header.w;
+	lv_coord_t cw = glyph[10].header.w;
+	lv_coord_t h = glyph[0].header.h;
+	lv_coord_t x = (LV_HOR_RES_MAX - 4 * dw - cw) / 2;
+	lv_coord_t y = (LV_VER_RES_MAX - h) / 2 - h / 3;
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		digit[i] = lv_img_create(scr, NULL);
+		lv_img_set_src(digit[i], &glyph[0]);
+		lv_obj_set_pos(digit[i], x + i * dw + (i >= 2 ? cw : 0), y);
+		lv_obj_set_hidden(digit[i], true);
+		shown[i] = -1;
+	}
+	colon = lv_img_create(scr, NULL);
+	lv_img_set_src(colon, &glyph[10]);
+	lv_obj_set_pos(colon, x + 2 * dw, y);
+
+	date = lv_label_create(scr, NULL);
+	lv_label_set_long_mode(date, LV_LABEL_LONG_CROP);
+	lv_label_set_align(date, LV_LABEL_ALIGN_CENTER);
+	lv_obj_set_width(date, LV_HOR_RES_MAX);
+	lv_obj_set_pos(date, 0, y + h + 16);
+	lv_obj_set_style_local_text_color(date, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_GRAY);
+	lv_obj_set_style_local_text_font(date, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, i18n.getFont());
+	lv_label_set_text_static(date, "");
+	shown_yday = -1;
+
+	lv_scr_load(scr);
+	runtime.setScreenRefresh(scr, CLOCK_REFR_MS);
+	task = lv_task_create(taskCb, 1000, LV_TASK_PRIO_MID, this);
+	tick();
+	return true;
+}
+
+/**
+ * 离开时钟界面，恢复原界面
+ */
+void DeskClock::stop()
+{
+	if (task == NULL) return;
+
+	lv_task_del(task);
+	task = NULL;
+	runtime.setScreenRefresh(scr, 0);
+	if (prev_scr) lv_scr_load(prev_scr);
+	lv_obj_del(scr);
+	scr = NULL;
+	freeGlyphs();
+}
+
+bool DeskClock::isRunning()
+{
+	return task != NULL;
+}
+
+/**
+ * 每秒一次：更新变化的数字、冒号与日期，有变化时立即刷新
+ */
+void DeskClock::tick()
+{
+	// 尚未同步时按运行时间对齐（只影响冒号闪烁的相位）
+	int64_t ms = timesvc.nowMs();
+	if (ms == 0) ms = millis();
+	lv_task_set_period(task, 1000 - ms % 1000 + CLOCK_TICK_SLACK_MS);
+
+	bool online = net != NULL && net->isConnected();
+	struct tm t = {};
+	bool valid = timesvc.local(&t);
+	int8_t d[4] = { (int8_t)(t.tm_hour / 10), (int8_t)(t.tm_hour % 10), (int8_t)(t.tm_min / 10), (int8_t)(t.tm_min % 10) };
+
+	bool changed = false;
+	for (uint8_t i = 0; i < 4; i++)
+	{
+		int8_t v = valid ? d[i] : -1;
+		if (v == shown[i]) continue;
+		if (v >= 0) lv_img_set_src(digit[i], &glyph[v]);
+		lv_obj_set_hidden(digit[i], v < 0);
+		shown[i] = v;
+		changed = true;
+	}
+
+#if CLOCK_BLINK
+	bool hide = ((ms / 1000) & 1) != 0;
+	if (lv_obj_get_hidden(colon) != hide)
+	{
+		lv_obj_set_hidden(colon, hide);
+		changed = true;
+	}
+#endif
+
+	// 同步之前显示状态：-2等待联网，-3正在同步
+	int16_t yday = valid ? t.tm_yday : (online ? -3 : -2);
+	if (yday != shown_yday)
+	{
+		if (valid)
+		{
+			char buf[48];
+			size_t n = strftime(buf, sizeof(buf), i18n.str(STR_CLOCK_DATE), &t);
+			snprintf(buf + n, sizeof(buf) - n, " %s", i18n.str((i18n_id_t)(STR_WEEKDAY_SUN + t.tm_wday)));
+			lv_label_set_text(date, buf);
+		}
+		else lv_label_set_text_static(date, i18n.str(online ? STR_CLOCK_SYNCING : STR_CLOCK_NO_WIFI));
+		shown_yday = yday;
+		changed = true;
+	}
+
+	lv_disp_t* disp = lv_disp_get_default();
+	if (changed && disp) lv_task_ready(disp->refr_task);
+}
+
+void DeskClock::taskCb(lv_task_t* t)
+{
+	((DeskClock*)t->user_data)->tick();
+}
+
+/**** 应用入口 ****/
+
+// 进入时渲染字形图像用到的数字与冒号
+static const AppAsset clock_assets[] = {
+	{ APP_ASSET_FONT, &CLOCK_FONT, "0123456789:" },
+	{ APP_ASSET_FONT, NULL, "-0123456789" },
+};
+
+const App clock_app = {
+	"clock",
+	[](void* u) { deskclock.start(); },
+	NULL,
+	NULL,
+	[](void* u) { deskclock.stop(); },
+	48 * 1024, 0, 0, 0, NULL,
+	clock_assets, sizeof(clock_assets) / sizeof(clock_assets[0])
+};
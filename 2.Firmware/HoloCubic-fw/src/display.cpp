@@ -15,29 +15,270 @@
  * 
  * 技术特点：
  * - 双缓冲机制提高显示流畅度
- * - DMA加速SPI传输
+ * - DMA加速SPI传输（LVGL绘制第N+1条带时第N条带正在DMA发送）
+ * - 只显示一张不透明图像的区域跳过LVGL绘制，由图像数据直接发送
+ * - 小区域刷新合并：时钟数字等零散小区域暂存后一次写出，省去逐个区域的DMA排队与等待
+ * - 开机自检SPI写时钟：能读回显存的面板逐档提高时钟，最高稳定频率保存在NVS
+ * - 可选垂直同步：每帧第一条带在ST7789的TE脉冲（垂直消隐开始）后发送，避免撕裂
+ * - 旋转与镜像由面板的MADCTL完成（可按屏幕切换），LVGL与刷新路径不做坐标变换
+ * - 刷新路径使用按ST7789 240x240特化的St7789Panel（st7789_panel.h）：窗口设置与DMA排队内联，不经TFT_eSPI的视口裁剪
+ * - 可选队列刷新：每条带的窗口命令与像素预编码为一组SPI事务排队，DC由事务回调切换，完成时在中断中通知LVGL
+ * - 同一SPI总线上可接多块面板：各自注册LVGL显示（独立缓冲区与刷新周期）或镜像另一块面板的内容
  * - 支持LVGL动画和特效
  */
 
 #include "display.h"
 #include <TFT_eSPI.h>    // ESP32优化的TFT显示库
+#include "st7789_panel.h"   // 按本机配置特化的刷新路径
 #include <lvgl.h>        // 轻量级图形库
+#include <esp_heap_caps.h>  // 按能力分配内存（DMA/PSRAM）
+#include "render_prof.h"    // 渲染分阶段计时
+#include <src/lv_gpu/lv_gpu_esp32.h>  // RGB565填充/复制/混合内核（IRAM）
+#include <soc/soc_caps.h>
+#include <soc/soc_memory_layout.h>  // esp_ptr_dma_capable
+#include <esp_timer.h>
+#include <esp_rom_crc.h>       // 自检图案CRC
+#include <Preferences.h>       // 保存自检得到的SPI时钟
+#include "asset_bundle.h"      // 启动画面图像
+#include "logger.h"            // 异步日志
+#include "energy.h"            // 背光占空比计入能耗估计
+
+// LV_COLOR_16_SWAP为1时LVGL直接以面板字节序（大端）绘制，发送时不再交换
+#define DISP_SWAP_BYTES (LV_COLOR_16_SWAP == 0)
+
+// ESP32-S2的CP_DMA与S3/C3的GDMA可做内存到内存传输；ESP32没有可用的内存DMA
+#if SOC_CP_DMA_SUPPORTED || SOC_GDMA_SUPPORTED
+#include <esp_async_memcpy.h>
+#define DISP_GPU_ASYNC 1
+#else
+#define DISP_GPU_ASYNC 0
+#endif
+
+#if DISP_SPLASH && ASSET_BUILTIN_LOGO
+extern "C" const lv_img_dsc_t logo;  // images.h中的内置Logo（定义在lv_cubic_gui.c）
+#endif
 
 /*
 TFT引脚配置应在以下路径设置：
 path/to/Arduino/libraries/TFT_eSPI/User_Setups/Setup24_ST7789.h
 */
-// TFT显示驱动实例
+// TFT显示驱动实例（所有面板共用总线与DMA，按各Display的cs_pin切换片选）
+// 刷新路径上的窗口设置、DMA发送与方向切换经PANEL_x，DISP_PANEL_FAST为1时由St7789Panel内联完成
+#if DISP_PANEL_FAST
+St7789Panel<TFT_WIDTH, TFT_HEIGHT> tft;
+#define PANEL_WINDOW(x, y, w, h) tft.window(x, y, w, h)
+#define PANEL_PUSH_DMA(x, y, w, h, px) tft.pushDMA(x, y, w, h, px)
+#define PANEL_ORIENT(flags) tft.setOrientFlags(flags)
+#else
 TFT_eSPI tft = TFT_eSPI();
+#define PANEL_WINDOW(x, y, w, h) tft.setAddrWindow(x, y, w, h)
+#define PANEL_PUSH_DMA(x, y, w, h, px) tft.pushImageDMA(x, y, w, h, px)
+#define PANEL_ORIENT(flags) tft.setRotation(8 + (flags))
+#endif
+
+// 已初始化的面板（第一块为主面板：TE同步、SPI自检、LVGL默认显示）
+static Display* displays[DISP_MAX];
+static uint8_t display_cnt = 0;
+// 当前片选有效的面板
+static Display* panel_active = NULL;
+static bool dma_ready = false;
+
+// TE引脚由TFT_eSPI用户配置给出（同时在初始化序列中开启TEON）
+#ifdef TFT_TE
+#define DISP_TE_PIN TFT_TE
+#else
+#define DISP_TE_PIN -1
+#endif
+
+/*
+垂直同步：
+面板从TE脉冲开始由上到下扫描，每帧从第0行开始、紧跟TE发送时，
+发送比扫描慢（40MHz SPI整屏约23ms，扫描16.7ms）则第一遍扫描始终在写入位置之前，显示完整的旧帧；
+第二遍扫描追上写入位置前发送已经结束（只要整帧在两个扫描周期内发完），显示完整的新帧
+*/
+static SemaphoreHandle_t te_sem = NULL;
+static volatile int64_t te_time = 0;
+static bool te_sync = false;
+
+/*
+刷新合并：
+小区域的像素很少，逐个区域发送时DMA排队、中断与等待结果的开销远大于像素本身；
+暂存后在一次startWrite/endWrite中依次写窗口（CASET/RASET/RAMWR）与像素，全部走寄存器轮询发送
+*/
+
+/*
+显示方向：
+ST7789按MADCTL的MV（行列交换）、MX（列倒序）、MY（行倒序）把写入的像素放到显存中，
+旋转90°/270°与镜像只改变写入顺序，每帧的发送量不变；240x240面板的显存为240x320，
+行倒序时可见区域为最后240行（偏移由TFT_eSPI的setRotation处理）
+*/
+#define ORIENT_MV 0x01  // 与ST7789_Rotation.h中setRotation(8 + flags)的位一致
+#define ORIENT_MX 0x02
+#define ORIENT_MY 0x04
+
+/*
+队列刷新（DISP_FLUSH_QUEUED）：
+DMA模式下每条带先用寄存器轮询写CASET/RASET/RAMWR（5次写入，每次都等待总线空闲），再排队像素DMA；
+这里在同一SPI主机上另挂一个spi_master设备，每条带的6个事务（3条命令、2组坐标、像素）
+预先填好命令字节与标志，刷新时只写入坐标与像素地址后一次排队，由SPI驱动在中断中依次发送：
+- pre_cb按事务的user标志切换DC（命令为低，数据为高），不需要CPU在命令之间等待
+- 像素事务的post_cb在发送完成时清除LVGL的flushing标志（即lv_disp_flush_ready，该函数不在IRAM中）
+- 描述符DISP_QUEUE_BANDS组循环使用，排队前回收已完成的一组
+其他路径（合并写出、直出、方向、推帧）仍直接操作寄存器或dmaHAL，开始前先等待队列发完（panel_wait/panel_begin）
+*/
+#define QUEUE_TRANS 6          // 每条带的事务数
+#define QUEUE_USER_DATA 0x1    // user低位：DC为高（数据）
+#define QUEUE_USER_LAST 0x2    // user低位：本条带的像素事务，完成时通知LVGL
+
+struct QueueBand
+{
+	spi_transaction_t t[QUEUE_TRANS];
+	lv_disp_buf_t* vdb;
+};
+
+#if DISP_PANEL_FAST
+static spi_device_handle_t queue_dev = NULL;
+static QueueBand queue_bands[DISP_QUEUE_BANDS];   // 4字节对齐，地址低两位用作user标志
+static uint8_t queue_next = 0;
+static uint8_t queue_pending = 0;   // 已排队未回收的事务数
+
+static void IRAM_ATTR queue_pre_cb(spi_transaction_t* t)
+{
+	if ((uintptr_t)t->user & QUEUE_USER_DATA) { DC_D; }
+	else { DC_C; }
+}
+
+static void IRAM_ATTR queue_post_cb(spi_transaction_t* t)
+{
+	uintptr_t user = (uintptr_t)t->user;
+	if (!(user & QUEUE_USER_LAST)) return;
+	QueueBand* b = (QueueBand*)(user & ~(uintptr_t)0x3);
+	b->vdb->flushing = 0;
+	b->vdb->flushing_last = 0;
+}
+
+/**
+ * 挂载队列设备并预填描述符（需DMA已初始化，总线时钟已确定）
+ */
+static bool queue_init()
+{
+	if (queue_dev) return true;
+	spi_device_interface_config_t devcfg;
+	memset(&devcfg, 0, sizeof(devcfg));
+	devcfg.mode = TFT_SPI_MODE;
+	devcfg.clock_speed_hz = (int)tft.getSPIFrequency();
+	devcfg.spics_io_num = -1;
+	devcfg.flags = SPI_DEVICE_NO_DUMMY;
+	devcfg.queue_size = QUEUE_TRANS * DISP_QUEUE_BANDS;
+	devcfg.pre_cb = queue_pre_cb;
+	devcfg.post_cb = queue_post_cb;
+	if (spi_bus_add_device(spi_host, &devcfg, &queue_dev) != ESP_OK)
+	{
+		queue_dev = NULL;
+		return false;
+	}
+
+	static const uint8_t cmds[3] = { TFT_CASET, TFT_PASET, TFT_RAMWR };
+	memset(queue_bands, 0, sizeof(queue_bands));
+	for (uint8_t i = 0; i < DISP_QUEUE_BANDS; i++)
+	{
+		spi_transaction_t* t = queue_bands[i].t;
+		for (uint8_t c = 0; c < 3; c++)
+		{
+			t[c * 2].flags = SPI_TRANS_USE_TXDATA;
+			t[c * 2].length = 8;
+			t[c * 2].tx_data[0] = cmds[c];
+			t[c * 2].user = (void*)0;
+		}
+		t[1].flags = t[3].flags = SPI_TRANS_USE_TXDATA;
+		t[1].length = t[3].length = 32;
+		t[1].user = t[3].user = (void*)QUEUE_USER_DATA;
+		t[5].user = (void*)((uintptr_t)&queue_bands[i] | QUEUE_USER_DATA | QUEUE_USER_LAST);
+	}
+	return true;
+}
+
+/**
+ * 回收已完成的事务，直到未回收的不超过keep个
+ */
+static void queue_collect(uint8_t keep)
+{
+	spi_transaction_t* r;
+	while (queue_pending > keep)
+	{
+		if (spi_device_get_trans_result(queue_dev, &r, portMAX_DELAY) != ESP_OK) break;
+		queue_pending--;
+	}
+}
+
+static void queue_wait()
+{
+	if (queue_pending) queue_collect(0);
+}
+
+static void queue_coord(spi_transaction_t* t, uint32_t a, uint32_t b)
+{
+	t->tx_data[0] = a >> 8;
+	t->tx_data[1] = a;
+	t->tx_data[2] = b >> 8;
+	t->tx_data[3] = b;
+}
+
+/**
+ * 排队一条带（窗口命令与像素），像素发送完成时清除drv的flushing标志
+ * @return 排队失败时返回false（已排队的部分照常发送）
+ */
+static bool queue_push(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* px, lv_disp_drv_t* drv)
+{
+	// 保证本组描述符已回收（LVGL等待flushing清零后才会刷新下一条带，通常不阻塞）
+	queue_collect(QUEUE_TRANS * (DISP_QUEUE_BANDS - 1));
+
+	QueueBand* b = &queue_bands[queue_next];
+	queue_next = (queue_next + 1) % DISP_QUEUE_BANDS;
+	uint32_t x0 = x + tft.xOffset();
+	uint32_t y0 = y + tft.yOffset();
+	queue_coord(&b->t[1], x0, x0 + w - 1);
+	queue_coord(&b->t[3], y0, y0 + h - 1);
+	b->t[5].tx_buffer = px;
+	b->t[5].length = (uint32_t)w * h * 16;
+	b->vdb = drv->buffer;
+
+	for (uint8_t i = 0; i < QUEUE_TRANS; i++)
+	{
+		if (spi_device_queue_trans(queue_dev, &b->t[i], portMAX_DELAY) != ESP_OK) return false;
+		queue_pending++;
+	}
+	return true;
+}
+#else
+// 预编码窗口命令需要St7789Panel的显存偏移，通用接口下队列刷新退回DMA模式
+static bool queue_init() { return false; }
+static void queue_wait() {}
+static bool queue_push(int32_t, int32_t, int32_t, int32_t, uint16_t*, lv_disp_drv_t*) { return false; }
+#endif
+
+/**
+ * 直接操作面板前等待所有发送完成：队列中的条带与dmaHAL上的DMA
+ */
+static void panel_wait()
+{
+	queue_wait();
+	tft.dmaWait();
+}
 
-// LVGL显示缓冲区配置
-static lv_disp_buf_t disp_buf;                    // 显示缓冲区描述符
-static lv_color_t buf[LV_HOR_RES_MAX * 10];       // 显示缓冲区数组（10行像素）
+/**
+ * 开始寄存器写入（等待队列发完后进入SPI事务，已处于事务中时不会重复加锁）
+ */
+static void panel_begin()
+{
+	queue_wait();
+	tft.startWrite();
+}
 
 
 /**
  * LVGL日志打印回调函数
- * 用于调试LVGL内部状态和错误信息
+ * 用于调试LVGL内部状态和错误信息，写入异步日志（不在渲染任务中等待串口）
  * 
  * @param level 日志级别
  * @param file  源文件名
@@ -47,85 +288,1148 @@ static lv_color_t buf[LV_HOR_RES_MAX * 10];       // 显示缓冲区数组（10
  */
 void my_print(lv_log_level_t level, const char* file, uint32_t line, const char* fun, const char* dsc)
 {
-	Serial.printf("%s@%d %s->%s\r\n", file, line, fun, dsc);
-	Serial.flush();
+	static const uint8_t levels[] = { LOG_LEVEL_DEBUG, LOG_LEVEL_INFO, LOG_LEVEL_WARN, LOG_LEVEL_ERROR, LOG_LEVEL_INFO };
+	// 只保留文件名（Windows下构建的路径分隔符为'\\'）
+	const char* base = file;
+	for (const char* p = file; *p; p++)
+	{
+		if (*p == '/' || *p == '\\') base = p + 1;
+	}
+	log_write(levels[level < 5 ? level : 4], "lvgl", "%s@%u %s->%s", base, line, fun, dsc);
+}
+
+
+/**
+ * TE上升沿中断：记录时间并唤醒等待的刷新
+ */
+static void IRAM_ATTR te_isr()
+{
+	te_time = esp_timer_get_time();
+	BaseType_t woken = pdFALSE;
+	xSemaphoreGiveFromISR(te_sem, &woken);
+	if (woken) portYIELD_FROM_ISR();
+}
+
+/**
+ * 等待面板开始新一轮扫描
+ * 距上一个TE不到DISP_TE_WINDOW_US（扫描仍在顶部）时直接返回；
+ * 超时（TE未连接或面板未开启TEON）后不再等待
+ */
+static void te_wait()
+{
+	if (!te_sync) return;
+	if (esp_timer_get_time() - te_time < DISP_TE_WINDOW_US) return;
+	xSemaphoreTake(te_sem, 0);
+	xSemaphoreTake(te_sem, pdMS_TO_TICKS(DISP_TE_TIMEOUT_MS));
+}
+
+/**
+ * 使本面板的片选有效（cs_pin为-1时由TFT_eSPI控制，不需要切换）
+ * 切换前等待上一块面板正在进行的DMA，两块面板的发送不会交错
+ */
+void LV_ATTRIBUTE_HOT Display::select()
+{
+	if (panel_active == this) return;
+	panel_wait();
+	if (panel_active && panel_active->config.cs_pin >= 0) digitalWrite(panel_active->config.cs_pin, HIGH);
+	if (config.cs_pin >= 0) digitalWrite(config.cs_pin, LOW);
+	panel_active = this;
+}
+
+/**
+ * 一帧的第一个区域发送前对齐到TE（TE只连接主面板）
+ */
+void LV_ATTRIBUTE_HOT Display::frameBegin()
+{
+	if (!te_frame_start) return;
+	te_frame_start = false;
+	if (this == displays[0]) te_wait();
+}
+
+/**
+ * 方向换算为MADCTL标志
+ * 旋转90°/270°时行列已交换，屏幕的左右对应显存的行方向
+ */
+static uint8_t orient_flags(uint8_t orient)
+{
+	static const uint8_t rotate[4] = { 0, ORIENT_MX | ORIENT_MV, ORIENT_MX | ORIENT_MY, ORIENT_MV | ORIENT_MY };
+	uint8_t f = rotate[orient & 0x03];
+	bool mv = (f & ORIENT_MV) != 0;
+	if (orient & DISP_MIRROR_H) f ^= mv ? ORIENT_MY : ORIENT_MX;
+	if (orient & DISP_MIRROR_V) f ^= mv ? ORIENT_MX : ORIENT_MY;
+	return f;
+}
+
+/**
+ * 写入MADCTL；DMA模式下先等待正在发送的条带（事务保持打开，setRotation不会结束事务）
+ */
+void Display::orientApply(uint8_t orient)
+{
+	select();
+	panel_wait();
+	PANEL_ORIENT(orient_flags(orient));
+	orient_cur = orient;
+}
+
+/**
+ * 活动屏幕对应的方向
+ */
+uint8_t Display::orientOf(lv_obj_t* scr)
+{
+	for (uint8_t i = 0; i < DISP_ORIENT_SCREENS; i++)
+	{
+		if (orient_scr[i] == scr) return orient_val[i];
+	}
+	return orient_base;
+}
+
+/**
+ * 活动屏幕变化时在两帧之间切换方向（切换动画期间按新屏幕的方向显示）
+ */
+void Display::orientUpdate()
+{
+	if (disp == NULL) return;
+	lv_obj_t* scr = lv_disp_get_scr_act(disp);
+	if (scr == orient_last_scr) return;
+	orient_last_scr = scr;
+	uint8_t orient = orientOf(scr);
+	if (orient != orient_cur)
+	{
+		orientApply(orient);
+		lv_obj_invalidate(scr);
+	}
+}
+
+/**
+ * 复制像素并转换为面板格式：有调色表时查表（表项已是面板字节序，调色与字节交换是同一遍），
+ * 否则按需交换字节；dst可以与src相同（原地转换）
+ */
+static inline void panel_copy(const uint16_t* lut, lv_color_t* dst, lv_coord_t dst_w, const lv_color_t* src,
+							  lv_coord_t src_w, lv_coord_t w, lv_coord_t h)
+{
+	if (lut) lv_gpu_esp32_copy_lut(dst, dst_w, src, src_w, w, h, lut);
+#if DISP_SWAP_BYTES
+	else lv_gpu_esp32_copy_swap(dst, dst_w, src, src_w, w, h);
+#else
+	else if (dst != src) lv_gpu_esp32_copy(dst, dst_w, src, src_w, w, h);
+#endif
+}
+
+/**
+ * 写出暂存的全部小区域（镜像面板随后写出同样的区域）
+ * DMA模式下先等待正在进行的DMA，寄存器写入不能与DMA交错
+ */
+void Display::coalFlush()
+{
+	if (coal_count == 0) return;
+
+	frameBegin();
+	render_prof_begin(RENDER_PROF_SPI);
+	for (Display* d = this; d; d = d->mirror)
+	{
+		d->select();
+		panel_wait();
+		tft.startWrite();
+		for (uint8_t i = 0; i < coal_count; i++)
+		{
+			const lv_area_t* a = &coal_areas[i].area;
+			uint32_t w = lv_area_get_width(a);
+			uint32_t h = lv_area_get_height(a);
+			PANEL_WINDOW(a->x1, a->y1, w, h);
+			// 像素已在暂存时转换为面板字节序
+			tft.pushColors(&coal_buf[coal_areas[i].offset].full, w * h, false);
+		}
+		// DMA模式下事务保持打开，与flushDmaCb一致
+		if (config.flush_mode == DISP_FLUSH_BLOCKING) tft.endWrite();
+	}
+	render_prof_end(RENDER_PROF_SPI);
+
+	coal_count = 0;
+	coal_used = 0;
+}
+
+/**
+ * 尝试把区域暂存到合并缓冲区
+ * @return 区域太大或合并未启用时返回false，由调用方直接发送
+ */
+bool Display::coalAdd(const lv_area_t* area, const lv_color_t* color_p)
+{
+	uint32_t px = lv_area_get_size(area);
+	if (coal_buf == NULL || px > DISP_COALESCE_MAX_PX) return false;
+
+	if (coal_used + px > DISP_COALESCE_BUF_PX || coal_count == DISP_COALESCE_AREAS) coalFlush();
+
+	lv_coord_t w = lv_area_get_width(area);
+	lv_coord_t h = lv_area_get_height(area);
+	panel_copy(lut, coal_buf + coal_used, w, color_p, w, w, h);
+	lv_area_copy(&coal_areas[coal_count].area, area);
+	coal_areas[coal_count].offset = coal_used;
+	coal_count++;
+	coal_used += px;
+	return true;
+}
+
+/**
+ * 把一块像素发送到本面板
+ * 阻塞模式：pushColors发送完成后返回；
+ * DMA模式：pushImageDMA内部先等待上一条带的DMA完成，再设置窗口并排队本条带，排队后立即返回
+ *
+ * @param swap 是否转换为面板字节序（DMA模式下原地交换，之后像素已是面板字节序）
+ */
+void LV_ATTRIBUTE_HOT Display::sendArea(const lv_area_t* area, lv_color_t* color_p, bool swap)
+{
+	uint32_t w = lv_area_get_width(area);
+	uint32_t h = lv_area_get_height(area);
+
+	select();
+	// 已处于事务中时startWrite不会重复加锁
+	panel_begin();
+	if (config.flush_mode != DISP_FLUSH_BLOCKING)
+	{
+		tft.setSwapBytes(swap);
+		PANEL_PUSH_DMA(area->x1, area->y1, w, h, &color_p->full);
+		tft.setSwapBytes(DISP_SWAP_BYTES);
+		return;
+	}
+	// 设置显示窗口地址
+	PANEL_WINDOW(area->x1, area->y1, w, h);
+	// 推送像素数据到显示屏
+	tft.pushColors(&color_p->full, w * h, swap);
+	// 结束SPI传输事务
+	tft.endWrite();
 }
 
+/**
+ * 由LVGL显示驱动找到所属的Display
+ */
+Display* LV_ATTRIBUTE_HOT Display::of(lv_disp_drv_t* drv)
+{
+	for (uint8_t i = 0; i < display_cnt; i++)
+	{
+		if (displays[i]->disp && &displays[i]->disp->driver == drv) return displays[i];
+	}
+	return NULL;
+}
 
 /**
  * LVGL显示刷新回调函数
  * 将LVGL渲染的图像数据传输到TFT显示屏
  * 
- * @param disp    显示驱动指针
+ * @param drv     显示驱动指针
  * @param area    需要刷新的区域坐标
  * @param color_p 像素颜色数据指针
  */
-void my_disp_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
+void LV_ATTRIBUTE_HOT Display::flushCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
 {
-	// 计算刷新区域的宽度和高度
-	uint32_t w = (area->x2 - area->x1 + 1);
-	uint32_t h = (area->y2 - area->y1 + 1);
+	Display* self = of(drv);
+	bool last = lv_disp_flush_is_last(drv);
+	if (self->tap) self->tap(area, color_p, self->tap_user);
 
-	// 开始SPI传输事务
-	tft.startWrite();
-	// 设置显示窗口地址
-	tft.setAddrWindow(area->x1, area->y1, w, h);
-	// 推送像素数据到显示屏（使用DMA加速）
-	tft.pushColors(&color_p->full, w * h, true);
-	// 结束SPI传输事务
-	tft.endWrite();
+	// 小区域暂存，一帧的最后一个区域到达时统一写出
+	if (self->coalAdd(area, color_p))
+	{
+		if (last)
+		{
+			self->coalFlush();
+			self->te_frame_start = true;
+		}
+		lv_disp_flush_ready(drv);
+		return;
+	}
+	self->coalFlush();
+
+	self->frameBegin();
+	render_prof_begin(RENDER_PROF_SPI);
+	if (self->lut)
+	{
+		// 调色时原地查表（同时转换为面板字节序），各面板直接发送
+		lv_coord_t w = lv_area_get_width(area);
+		panel_copy(self->lut, color_p, w, color_p, w, w, lv_area_get_height(area));
+		for (Display* d = self; d; d = d->mirror) d->sendArea(area, color_p, false);
+	}
+	// 本机字节序时逐像素交换（不改写缓冲区，镜像面板可以再次发送）
+	else for (Display* d = self; d; d = d->mirror) d->sendArea(area, color_p, DISP_SWAP_BYTES);
+	render_prof_end(RENDER_PROF_SPI);
 
+	// flush_ready会清除最后一条带标志，因此在开始时读取
+	if (last) self->te_frame_start = true;
 	// 通知LVGL刷新完成
-	lv_disp_flush_ready(disp);
+	lv_disp_flush_ready(drv);
+}
+
+/**
+ * LVGL显示刷新回调函数（DMA模式）
+ *
+ * 工作原理：
+ * 1. pushImageDMA内部先等待上一条带的DMA完成，再设置窗口并排队本条带
+ * 2. 排队后立即通知LVGL刷新完成，LVGL随即在另一个缓冲区中绘制下一条带
+ * 3. 下一次刷新时会先等待本次DMA完成，因此正在发送的缓冲区不会被改写
+ * 4. 有镜像面板时切换片选前等待本面板的DMA，镜像面板的DMA同样在下一次刷新前完成
+ *
+ * 注意：DMA模式下SPI事务保持打开（不调用endWrite），
+ *      其他代码直接操作tft前需先调用panel_wait()
+ *
+ * @param drv     显示驱动指针
+ * @param area    需要刷新的区域坐标
+ * @param color_p 像素颜色数据指针
+ */
+void LV_ATTRIBUTE_HOT Display::flushDmaCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+	Display* self = of(drv);
+	bool last = lv_disp_flush_is_last(drv);
+	if (self->tap) self->tap(area, color_p, self->tap_user);
+
+	if (self->coalAdd(area, color_p))
+	{
+		if (last)
+		{
+			self->coalFlush();
+			self->te_frame_start = true;
+		}
+		lv_disp_flush_ready(drv);
+		return;
+	}
+	self->coalFlush();
+
+	self->frameBegin();
+	render_prof_begin(RENDER_PROF_SPI);
+	// 本机字节序时字节交换在第一次DMA发送前原地完成，镜像面板直接发送交换后的像素
+	// 调色时由查表代替这一次交换，不增加遍数
+	bool swap = DISP_SWAP_BYTES;
+	if (self->lut)
+	{
+		lv_coord_t w = lv_area_get_width(area);
+		panel_copy(self->lut, color_p, w, color_p, w, w, lv_area_get_height(area));
+		swap = false;
+	}
+	self->sendArea(area, color_p, swap);
+	for (Display* d = self->mirror; d; d = d->mirror) d->sendArea(area, color_p, false);
+	render_prof_end(RENDER_PROF_SPI);
+
+	if (last) self->te_frame_start = true;
+	lv_disp_flush_ready(drv);
+}
+
+/**
+ * LVGL显示刷新回调函数（队列模式）
+ *
+ * 与DMA模式相同地暂存小区域、对齐TE，大区域的窗口命令与像素作为一组事务排队后立即返回，
+ * 不调用lv_disp_flush_ready：像素发送完成时由SPI中断（queue_post_cb）清除flushing，
+ * LVGL在此之前已经开始在另一个缓冲区中绘制下一条带
+ * 有镜像面板时等待队列发完后按DMA模式发送（两块面板要依次切换片选）
+ */
+void LV_ATTRIBUTE_HOT Display::flushQueuedCb(lv_disp_drv_t* drv, const lv_area_t* area, lv_color_t* color_p)
+{
+	Display* self = of(drv);
+	if (self->mirror)
+	{
+		queue_wait();
+		flushDmaCb(drv, area, color_p);
+		return;
+	}
+	bool last = lv_disp_flush_is_last(drv);
+	if (self->tap) self->tap(area, color_p, self->tap_user);
+
+	if (self->coalAdd(area, color_p))
+	{
+		if (last)
+		{
+			self->coalFlush();
+			self->te_frame_start = true;
+		}
+		lv_disp_flush_ready(drv);
+		return;
+	}
+	self->coalFlush();
+
+	self->frameBegin();
+	render_prof_begin(RENDER_PROF_SPI);
+	self->select();
+	// 合并写出与直出使用的dmaHAL与队列设备共用总线，排队前等待其完成
+	tft.dmaWait();
+	panel_copy(self->lut, color_p, lv_area_get_width(area), color_p, lv_area_get_width(area), lv_area_get_width(area),
+			   lv_area_get_height(area));
+	bool queued = queue_push(area->x1, area->y1, lv_area_get_width(area), lv_area_get_height(area), &color_p->full, drv);
+	render_prof_end(RENDER_PROF_SPI);
+
+	if (last) self->te_frame_start = true;
+	if (!queued)
+	{
+		// 排队失败：等待已排队的部分，本条带经DMA重新发送（像素已是面板字节序）
+		queue_wait();
+		self->sendArea(area, color_p, false);
+		lv_disp_flush_ready(drv);
+	}
+}
+
+
+#if LV_USE_REFR_DIRECT
+/**
+ * LVGL直出回调：区域内只有一张不透明、未缩放的真彩色图像（如场景帧）时调用，跳过LVGL的绘制与缓冲区
+ *
+ * 阻塞模式：pushColors直接从图像数据读取（本机字节序时发送中交换），不做复制
+ * DMA模式：面板字节序的图像位于可DMA内存且整行连续时直接从图像发送；
+ *          否则（Flash中的图像DMA无法读取，本机字节序需要交换）按段用IRAM内核复制（交换）
+ *          到两个显示缓冲区并交替发送
+ * 有镜像面板时返回false，由LVGL照常绘制后经刷新回调同时发送到两块面板
+ *
+ * @param src        区域左上角的像素
+ * @param src_stride 图像宽度（像素）
+ */
+bool Display::directCb(lv_disp_drv_t* drv, const lv_area_t* area, const lv_color_t* src, lv_coord_t src_stride)
+{
+	Display* self = of(drv);
+	if (self->mirror) return false;
+	// 阻塞模式直接从图像发送，没有查表的机会：调色时由LVGL照常绘制
+	if (self->lut && self->config.flush_mode == DISP_FLUSH_BLOCKING) return false;
+	// 截图期间由LVGL照常绘制，像素经刷新回调交给旁路
+	if (self->tap) return false;
+
+	lv_coord_t w = lv_area_get_width(area);
+	lv_coord_t h = lv_area_get_height(area);
+
+	self->coalFlush();
+	self->frameBegin();
+	// 直出的区域不再分条带，本帧的最后一个区域即为帧结束
+	if (drv->buffer->last_area) self->te_frame_start = true;
+
+	render_prof_begin(RENDER_PROF_SPI);
+	self->select();
+	panel_begin();
+	if (self->config.flush_mode == DISP_FLUSH_BLOCKING)
+	{
+		PANEL_WINDOW(area->x1, area->y1, w, h);
+		if (w == src_stride)
+		{
+			tft.pushColors((uint16_t*)&src->full, (uint32_t)w * h, DISP_SWAP_BYTES);
+		}
+		else
+		{
+			for (lv_coord_t y = 0; y < h; y++)
+			{
+				tft.pushColors((uint16_t*)&src[(int32_t)y * src_stride].full, w, DISP_SWAP_BYTES);
+			}
+		}
+		tft.endWrite();
+		render_prof_end(RENDER_PROF_SPI);
+		return true;
+	}
+
+#if !DISP_SWAP_BYTES
+	if (self->lut == NULL && w == src_stride && ((uintptr_t)src & 3) == 0 && esp_ptr_dma_capable(src))
+	{
+		PANEL_PUSH_DMA(area->x1, area->y1, w, h, (uint16_t*)&src->full);
+		// 图像随后可能被改写（如场景帧槽），等待发送完成
+		tft.dmaWait();
+		render_prof_end(RENDER_PROF_SPI);
+		return true;
+	}
+#endif
+
+	lv_disp_buf_t* vdb = drv->buffer;
+	lv_coord_t rows = vdb->size / w;
+	lv_color_t* bounce = (lv_color_t*)vdb->buf_act;
+
+#if DISP_SWAP_BYTES
+	// 像素已在复制时交换，发送前不能再原地交换
+	tft.setSwapBytes(false);
+#endif
+	for (lv_coord_t y = 0; y < h; y += rows)
+	{
+		lv_coord_t n = rows < h - y ? rows : h - y;
+		// 单缓冲时等待上一段发送完成后才能改写；双缓冲时pushImageDMA排队前已等待过倒数第二段
+		if (vdb->buf2 == NULL) tft.dmaWait();
+		panel_copy(self->lut, bounce, w, src + (int32_t)y * src_stride, src_stride, w, n);
+		PANEL_PUSH_DMA(area->x1, area->y1 + y, w, n, &bounce->full);
+		if (vdb->buf2) bounce = (lv_color_t*)((bounce == vdb->buf1) ? vdb->buf2 : vdb->buf1);
+	}
+#if DISP_SWAP_BYTES
+	tft.setSwapBytes(true);
+#endif
+
+	// 最后一段仍在发送：让LVGL接着在另一个缓冲区中绘制
+	if (vdb->buf2) vdb->buf_act = bounce;
+	else tft.dmaWait();
+	render_prof_end(RENDER_PROF_SPI);
+	return true;
 }
+#endif
 
+#if DISP_GPU_ASYNC
+static async_memcpy_t gpu_dma = NULL;
+static SemaphoreHandle_t gpu_done = NULL;
+
+static IRAM_ATTR bool gpu_dma_done(async_memcpy_t hdl, async_memcpy_event_t* event, void* arg)
+{
+	BaseType_t woken = pdFALSE;
+	xSemaphoreGiveFromISR(gpu_done, &woken);
+	return woken == pdTRUE;
+}
+
+/**
+ * 内存DMA复制，等待完成期间让出CPU
+ */
+static bool gpu_dma_copy(void* dst, const void* src, size_t n)
+{
+	if (esp_async_memcpy(gpu_dma, dst, (void*)src, n, gpu_dma_done, NULL) != ESP_OK) return false;
+	xSemaphoreTake(gpu_done, portMAX_DELAY);
+	return true;
+}
+#endif
+
+/**
+ * LVGL GPU填充回调（不透明、无遮罩、面积大于240像素时调用）
+ *
+ * 整行宽度的填充在内存中连续：CPU只填第一行，之后按1、2、4...行倍增交给内存DMA复制；
+ * 其余情况（包括ESP32上）由IRAM中的32位填充内核完成
+ */
+static void my_gpu_fill(lv_disp_drv_t* disp, lv_color_t* dest_buf, lv_coord_t dest_width,
+						const lv_area_t* fill_area, lv_color_t color)
+{
+	lv_coord_t w = lv_area_get_width(fill_area);
+	lv_coord_t h = lv_area_get_height(fill_area);
+	lv_color_t* first = dest_buf + dest_width * fill_area->y1 + fill_area->x1;
+
+#if DISP_GPU_ASYNC
+	uint32_t total = (uint32_t)w * h;
+	if (gpu_dma && w == dest_width && total >= DISP_GPU_DMA_MIN_PX && (w & 1) == 0 &&
+		((uintptr_t)first & 3) == 0 && esp_ptr_dma_capable(first))
+	{
+		lv_gpu_esp32_fill(first, dest_width, color, w, 1);
+		uint32_t done = w;
+		bool ok = true;
+		while (ok && done < total)
+		{
+			uint32_t n = done < total - done ? done : total - done;
+			ok = gpu_dma_copy(first + done, first, n * sizeof(lv_color_t));
+			done += n;
+		}
+		if (ok) return;
+	}
+#endif
+
+	lv_gpu_esp32_fill(first, dest_width, color, w, h);
+}
+
+/**
+ * LVGL GPU混合回调（图像复制/混合，每次一行）
+ * 单行太短，DMA的启动开销大于收益，直接使用IRAM内核
+ */
+static void my_gpu_blend(lv_disp_drv_t* disp, lv_color_t* dest, const lv_color_t* src, uint32_t length, lv_opa_t opa)
+{
+	if (opa > LV_OPA_MAX) lv_gpu_esp32_copy(dest, length, src, length, length, 1);
+	else lv_gpu_esp32_blend(dest, length, src, length, opa, length, 1);
+}
+
+Display::Display()
+{
+	config = DISPLAY_CONFIG_DEFAULT;
+	buf_bytes = 0;
+	disp = NULL;
+	mirror = NULL;
+	te_frame_start = true;
+	strip_swap = false;
+	coal_buf = NULL;
+	coal_count = 0;
+	coal_used = 0;
+	orient_cur = DISP_ORIENT_DEFAULT;
+	orient_base = DISP_ORIENT_DEFAULT;
+	memset(orient_scr, 0, sizeof(orient_scr));
+	orient_last_scr = NULL;
+	lut = NULL;
+	tap = NULL;
+	tap_user = NULL;
+}
+
+/**
+ * 显示系统初始化函数（仅指定刷新模式，其余使用默认配置）
+ */
+void Display::init(DispFlushMode mode)
+{
+	DisplayConfig cfg = DISPLAY_CONFIG_DEFAULT;
+	cfg.flush_mode = mode;
+	init(cfg);
+}
 
 /**
  * 显示系统初始化函数
  * 配置TFT显示屏、LVGL图形库和背光控制
+ * 第一次调用初始化总线、DMA与LVGL；之后的调用只向本面板（cs_pin）发送初始化序列
+ *
+ * @param cfg       显示配置：刷新模式、缓冲行数、单/双缓冲、内存位置、片选、背光与刷新周期
+ *                  内存不足时缓冲行数会逐次减半，最终配置可通过getConfig()查询
+ * @param mirror_of 非NULL时本面板镜像该显示（不注册LVGL显示，不分配缓冲区，刷新模式与之相同）
  */
-void Display::init()
+void Display::init(const DisplayConfig& cfg, Display* mirror_of)
 {
+	if (display_cnt >= DISP_MAX)
+	{
+		Serial.printf("面板超过%d块，未初始化\n", DISP_MAX);
+		return;
+	}
+	bool first = display_cnt == 0;
+	displays[display_cnt++] = this;
+
+	config = cfg;
+	config.buf_lines = constrain(config.buf_lines, 1, LV_VER_RES_MAX);
+	if (mirror_of) config.flush_mode = mirror_of->config.flush_mode;
+
+	// PSRAM不可被SPI DMA直接访问，DMA刷新需要片内缓冲区
+	if (config.placement == DISP_BUF_PSRAM && config.flush_mode != DISP_FLUSH_BLOCKING)
+	{
+		Serial.println("显示缓冲区位于PSRAM，刷新模式退回阻塞模式");
+		config.flush_mode = DISP_FLUSH_BLOCKING;
+	}
+	// 阻塞模式下双缓冲没有收益
+	if (config.flush_mode == DISP_FLUSH_BLOCKING)
+	{
+		config.double_buf = false;
+	}
+
 	// 配置背光PWM控制
 	// 频率5kHz，8位分辨率（0-255）
-	ledcSetup(LCD_BL_PWM_CHANNEL, 5000, 8);
-	ledcAttachPin(LCD_BL_PIN, LCD_BL_PWM_CHANNEL);
+	if (config.bl_pin >= 0)
+	{
+		ledcSetup(config.bl_channel, 5000, 8);
+		ledcAttachPin(config.bl_pin, config.bl_channel);
+	}
+	// 启动画面写屏之前保持背光关闭，不显示面板上电时的随机内容
+	setBackLight(0);
+
+	if (config.cs_pin >= 0)
+	{
+		pinMode(config.cs_pin, OUTPUT);
+		digitalWrite(config.cs_pin, HIGH);
+	}
+	select();
+	if (first)
+	{
+		// 初始化TFT显示屏
+		tft.begin();
+	}
+	else
+	{
+		// 总线已初始化，只向本面板发送初始化序列
+		panel_wait();
+		tft.init();
+	}
+	// 设置屏幕方向（默认镜像显示）
+	orientApply(orient_cur);
+
+	if (first)
+	{
+#if DISP_SPI_TUNE
+		// 须在initDMA之前：DMA设备的时钟在挂到总线时确定
+		tuneSpi();
+#endif
+
+#if DISP_TE_PIN >= 0
+		te_sem = xSemaphoreCreateBinary();
+		if (te_sem)
+		{
+			pinMode(DISP_TE_PIN, INPUT);
+			attachInterrupt(DISP_TE_PIN, te_isr, RISING);
+			te_sync = true;
+			Serial.printf("垂直同步: TE引脚%d\n", DISP_TE_PIN);
+		}
+#endif
+	}
+
+	// DMA通道由所有面板共用，只初始化一次
+	if (config.flush_mode != DISP_FLUSH_BLOCKING && !dma_ready) dma_ready = tft.initDMA();
+	if (config.flush_mode != DISP_FLUSH_BLOCKING && !dma_ready)
+	{
+		config.flush_mode = DISP_FLUSH_BLOCKING;
+		config.double_buf = false;
+	}
+	// 队列设备挂在DMA所在的总线上，时钟沿用自检后的频率
+	if (config.flush_mode == DISP_FLUSH_QUEUED && !queue_init())
+	{
+		Serial.println("SPI队列设备不可用，刷新模式退回DMA模式");
+		config.flush_mode = DISP_FLUSH_DMA;
+	}
+	if (config.flush_mode != DISP_FLUSH_BLOCKING)
+	{
+		// 本机字节序时pushImageDMA按TFT字节序原地交换像素
+		tft.setSwapBytes(DISP_SWAP_BYTES);
+	}
 
-	// 初始化LVGL图形库
-	lv_init();
+#if DISP_SPLASH
+	// 面板可用后立即显示启动画面，LVGL与界面随后初始化
+	splash();
+#endif
 
-	// 注册LVGL调试日志打印函数
-	lv_log_register_print_cb(my_print);
+	if (mirror_of)
+	{
+		// 接在镜像链的末尾，源显示刷新的区域依次发送到链上每块面板
+		Display* d = mirror_of;
+		while (d->mirror) d = d->mirror;
+		d->mirror = this;
+		Serial.println("镜像面板已初始化");
+		return;
+	}
 
-	// 初始化TFT显示屏
-	tft.begin();
-	// 设置屏幕旋转方向（镜像显示）
-	tft.setRotation(4);
+	if (first)
+	{
+		// 初始化LVGL图形库
+		lv_init();
+
+		// 注册LVGL调试日志打印函数
+		lv_log_register_print_cb(my_print);
+	}
 
 	// 初始化LVGL显示缓冲区
-	// 使用单缓冲模式，缓冲区大小为10行像素
-	lv_disp_buf_init(&disp_buf, buf, NULL, LV_HOR_RES_MAX * 10);
+	lv_color_t* b1 = NULL;
+	lv_color_t* b2 = NULL;
+	if (!allocBuffers(&b1, &b2))
+	{
+		Serial.println("显示缓冲区分配失败！");
+		return;
+	}
+	lv_disp_buf_init(&disp_buf, b1, b2, LV_HOR_RES_MAX * config.buf_lines);
+	// 合并暂存区分配失败时小区域照常逐个发送
+	coal_buf = (lv_color_t*)heap_caps_malloc(DISP_COALESCE_BUF_PX * sizeof(lv_color_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+	Serial.printf("显示缓冲区: %d行 x %d, %s, %s, 共%u字节\n",
+				  config.buf_lines, config.double_buf ? 2 : 1,
+				  config.placement == DISP_BUF_PSRAM ? "PSRAM" : "片内RAM",
+				  config.flush_mode == DISP_FLUSH_QUEUED ? "队列" : config.flush_mode == DISP_FLUSH_DMA ? "DMA" : "阻塞",
+				  buf_bytes);
 
 	// 配置LVGL显示驱动
 	lv_disp_drv_t disp_drv;
 	lv_disp_drv_init(&disp_drv);              // 初始化驱动结构体
 	disp_drv.hor_res = 240;                   // 水平分辨率240像素
 	disp_drv.ver_res = 240;                   // 垂直分辨率240像素
-	disp_drv.flush_cb = my_disp_flush;        // 设置刷新回调函数
+	// 设置刷新回调函数
+	disp_drv.flush_cb = config.flush_mode == DISP_FLUSH_QUEUED ? flushQueuedCb :
+						config.flush_mode == DISP_FLUSH_DMA ? flushDmaCb : flushCb;
 	disp_drv.buffer = &disp_buf;              // 绑定显示缓冲区
-	lv_disp_drv_register(&disp_drv);          // 注册显示驱动到LVGL
+	disp_drv.gpu_fill_cb = my_gpu_fill;       // 大面积填充
+	disp_drv.gpu_blend_cb = my_gpu_blend;     // 图像复制与混合
+#if LV_USE_REFR_DIRECT
+	disp_drv.direct_cb = directCb;            // 全屏图像直出
+#endif
+#if DISP_GPU_ASYNC
+	if (first)
+	{
+		async_memcpy_config_t dma_cfg = ASYNC_MEMCPY_DEFAULT_CONFIG();
+		gpu_done = xSemaphoreCreateBinary();
+		if (gpu_done == NULL || esp_async_memcpy_install(&dma_cfg, &gpu_dma) != ESP_OK)
+		{
+			Serial.println("内存DMA不可用，填充使用CPU");
+			gpu_dma = NULL;
+		}
+	}
+#endif
+	disp = lv_disp_drv_register(&disp_drv);   // 注册显示驱动到LVGL
+	// 新注册的显示会成为默认显示，lv_scr_act()始终对应主面板
+	if (!first) lv_disp_set_default(displays[0]->disp);
+	setRefreshPeriod(config.refr_ms);
+}
+
+/**
+ * 按配置分配显示缓冲区
+ * 分配失败时将行数减半重试，直到1行仍失败才返回false
+ *
+ * @param b1 输出：缓冲区1
+ * @param b2 输出：缓冲区2（单缓冲时为NULL）
+ */
+bool Display::allocBuffers(lv_color_t** b1, lv_color_t** b2)
+{
+	uint32_t caps = (config.placement == DISP_BUF_PSRAM) ?
+		(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+
+	if (config.placement == DISP_BUF_PSRAM && !psramFound())
+	{
+		Serial.println("未检测到PSRAM，显示缓冲区改用片内RAM");
+		config.placement = DISP_BUF_INTERNAL;
+		caps = MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL;
+	}
+
+	while (config.buf_lines > 0)
+	{
+		uint32_t bytes = LV_HOR_RES_MAX * config.buf_lines * sizeof(lv_color_t);
+		*b1 = (lv_color_t*)heap_caps_malloc(bytes, caps);
+		*b2 = (config.double_buf && *b1) ? (lv_color_t*)heap_caps_malloc(bytes, caps) : NULL;
+
+		if (*b1 && (!config.double_buf || *b2))
+		{
+			buf_bytes = bytes * (config.double_buf ? 2 : 1);
+			return true;
+		}
+
+		if (*b1) heap_caps_free(*b1);
+		Serial.printf("显示缓冲区%d行分配失败，尝试减半\n", config.buf_lines);
+		config.buf_lines /= 2;
+	}
+
+	*b1 = *b2 = NULL;
+	buf_bytes = 0;
+	return false;
 }
 
 /**
  * 显示系统例程函数
  * 需要在主循环中定期调用，处理LVGL任务调度
  * 包括动画更新、事件处理、显示刷新等
+ *
+ * @return 距下一个LVGL定时器到期的毫秒数（没有待运行的定时器时为LV_NO_TASK_READY）
  */
-void Display::routine()
+uint32_t Display::routine()
 {
+	// 各显示的活动屏幕变化时切换方向
+	for (uint8_t i = 0; i < display_cnt; i++) displays[i]->orientUpdate();
+
 	// 处理LVGL任务队列
-	// 包括动画、定时器、事件处理等
-	lv_task_handler();
+	// 包括动画、定时器、事件处理等（所有显示共用一个LVGL实例，主循环中调用任意一个实例即可）
+	return lv_task_handler();
+}
+
+/**
+ * 绕过LVGL直接向屏幕写入一块RGB565（本机字节序）像素，镜像面板同时写入
+ * 用于JPEG等解码器按条带直出，必须在LVGL任务中调用，避免与刷新回调交错
+ *
+ * @param px 像素数据，DMA模式下会被原地字节交换
+ */
+void Display::pushRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* px)
+{
+	bool dma = config.flush_mode != DISP_FLUSH_BLOCKING;
+	bool swap = true;
+	for (Display* d = this; d; d = d->mirror)
+	{
+		d->select();
+		panel_begin();
+		tft.setSwapBytes(swap);
+		if (dma)
+		{
+			tft.pushImageDMA(x, y, w, h, px);
+			// 调用方会立即复用px，等待本次发送完成
+			panel_wait();
+			// 发送前已原地交换为面板字节序
+			swap = false;
+			continue;
+		}
+		tft.pushImage(x, y, w, h, px);
+		tft.endWrite();
+	}
+	tft.setSwapBytes(dma ? DISP_SWAP_BYTES : false);
+}
+
+/**
+ * 按条带流式写屏（面板字节序像素）开始：关闭字节交换并打开SPI事务
+ * 之后连续调用pushStrip，最后调用endStrips，期间不得穿插pushRect，必须在LVGL任务中调用
+ */
+void Display::beginStrips()
+{
+	strip_swap = tft.getSwapBytes();
+	tft.setSwapBytes(false);
+	select();
+	panel_begin();
+}
+
+/**
+ * 写出一条带（有镜像面板时随后写入镜像面板）
+ * DMA模式下排队后立即返回（pushImageDMA先等待上一条带发送完成），
+ * 调用方应交替使用两个缓冲区：px在下一次pushStrip返回之前仍在发送，不得改写
+ *
+ * @param px 面板字节序（大端）RGB565像素
+ */
+void Display::pushStrip(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* px)
+{
+	for (Display* d = this; d; d = d->mirror)
+	{
+		d->select();
+		if (config.flush_mode != DISP_FLUSH_BLOCKING) PANEL_PUSH_DMA(x, y, w, h, px);
+		else tft.pushImage(x, y, w, h, px);
+	}
+}
+
+/**
+ * 等待最后一条带发送完成，恢复字节交换设置
+ */
+void Display::endStrips()
+{
+	if (config.flush_mode != DISP_FLUSH_BLOCKING) panel_wait();
+	else tft.endWrite();
+	tft.setSwapBytes(strip_swap);
+}
+
+/**
+ * 整幅图像（面板字节序、整行连续）排队DMA发送后立即返回，必须在LVGL任务中调用
+ * 面板写入在VSPI上进行时调用方可以继续其他工作（如场景播放器在HSPI上读取下一帧），
+ * 下一次pushFrame（pushImageDMA先等待上一次发送完成）或frameWait()返回之前px不得改写或释放
+ *
+ * @return 非DMA模式、像素不在可DMA内存或未4字节对齐、本机字节序需要交换、有镜像面板时返回false，
+ *         由调用方改用LVGL绘制
+ */
+bool Display::pushFrame(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t* px)
+{
+#if DISP_SWAP_BYTES
+	// 发送前原地交换会改写调用方的数据
+	return false;
+#else
+	if (config.flush_mode == DISP_FLUSH_BLOCKING || mirror || ((uintptr_t)px & 3) != 0 || !esp_ptr_dma_capable(px)) return false;
+	if (x < 0 || y < 0 || x + w > tft.width() || y + h > tft.height()) return false;
+	select();
+	panel_begin();
+	PANEL_PUSH_DMA(x, y, w, h, (uint16_t*)px);
+	return true;
+#endif
+}
+
+/**
+ * 等待pushFrame排队的发送完成
+ */
+void Display::frameWait()
+{
+	if (config.flush_mode != DISP_FLUSH_BLOCKING) panel_wait();
+}
+
+/**
+ * 开启/关闭垂直同步（TE引脚未配置时始终关闭）
+ * 关闭后刷新不再等待TE，帧率不受面板刷新率限制，但可能出现撕裂
+ */
+void Display::setVsync(bool enable)
+{
+	te_sync = enable && te_sem != NULL;
+}
+
+bool Display::getVsync()
+{
+	return te_sync;
+}
+
+/**
+ * 等待面板开始新一轮扫描（垂直同步关闭时立即返回）
+ * 供绕过LVGL按条带写屏的调用方（如JPEG解码）在一帧的第一条带前调用，必须在LVGL任务中调用
+ */
+void Display::waitVsync()
+{
+	te_wait();
+}
+
+/**
+ * 设置显示方向（DISP_ROTATE_x与DISP_MIRROR_x组合），没有单独设置方向的屏幕都使用该方向
+ * 立即写入面板并重绘整屏，必须在LVGL任务中调用；镜像面板只改变本面板的方向
+ * 注意：上下颠倒（行倒序）时写入方向与面板扫描方向相反，垂直同步不能完全避免撕裂
+ */
+void Display::setOrientation(uint8_t orient)
+{
+	orient_base = orient & 0x0F;
+	if (disp == NULL)
+	{
+		// 镜像面板：下一次源显示刷新时生效，请同时让源显示重绘
+		if (orient_base != orient_cur) orientApply(orient_base);
+		return;
+	}
+	lv_obj_t* scr = lv_disp_get_scr_act(disp);
+	uint8_t o = orientOf(scr);
+	if (o == orient_cur) return;
+	orientApply(o);
+	lv_obj_invalidate(scr);
+}
+
+uint8_t Display::getOrientation()
+{
+	return orient_cur;
+}
+
+/**
+ * 为某个屏幕单独设置方向，该屏幕成为活动屏幕时自动切换（如需要镜像的场景）
+ * @param orient DISP_ROTATE_x与DISP_MIRROR_x组合，-1表示取消（删除屏幕前应取消，避免新屏幕复用地址）
+ */
+void Display::setScreenOrientation(lv_obj_t* scr, int16_t orient)
+{
+	int8_t slot = -1;
+	for (uint8_t i = 0; i < DISP_ORIENT_SCREENS; i++)
+	{
+		if (orient_scr[i] == scr) slot = i;
+		else if (slot < 0 && orient_scr[i] == NULL && orient >= 0) slot = i;
+	}
+	if (slot < 0)
+	{
+		if (orient >= 0) LOG_W("display", "单独设置方向的屏幕超过%d个", DISP_ORIENT_SCREENS);
+		return;
+	}
+	if (orient < 0) orient_scr[slot] = NULL;
+	else
+	{
+		orient_scr[slot] = scr;
+		orient_val[slot] = orient & 0x0F;
+	}
+	// 活动屏幕在下一次routine()时应用
+	if (disp && scr == lv_disp_get_scr_act(disp)) orient_last_scr = NULL;
+}
+
+/**
+ * 启动画面：绕过LVGL直接写屏（在lv_init之前调用），画完后点亮背光
+ * 图像按条带解码为面板字节序，DMA模式下解码下一条带时上一条带正在发送
+ *
+ * @param img 图像，NULL时依次查找资源包中的DISP_SPLASH_ASSET、"logo"，最后使用内置Logo
+ *            不大于屏幕时居中显示，周围填充黑色
+ * @return 没有可用图像、颜色格式不支持或内存不足时返回false（背光保持不变）
+ */
+bool Display::splash(const lv_img_dsc_t* img)
+{
+	if (img == NULL && assets.begin())
+	{
+		img = assets.getImage(DISP_SPLASH_ASSET);
+		if (img == NULL) img = assets.getImage("logo");
+	}
+#if ASSET_BUILTIN_LOGO
+	if (img == NULL) img = &logo;
+#endif
+	if (img == NULL) return false;
+
+	uint8_t bpp;
+	switch (img->header.cf)
+	{
+	case LV_IMG_CF_INDEXED_1BIT: bpp = 1; break;
+	case LV_IMG_CF_INDEXED_2BIT: bpp = 2; break;
+	case LV_IMG_CF_INDEXED_4BIT: bpp = 4; break;
+	case LV_IMG_CF_INDEXED_8BIT: bpp = 8; break;
+	case LV_IMG_CF_TRUE_COLOR: bpp = LV_COLOR_DEPTH == 16 ? 16 : 0; break;
+	default: bpp = 0; break;
+	}
+	int32_t w = img->header.w, h = img->header.h;
+	if (bpp == 0 || w > LV_HOR_RES_MAX || h > LV_VER_RES_MAX) return false;
+
+	// 调色板转换为面板字节序的RGB565
+	uint16_t palette[256];
+	const uint8_t* px = img->data;
+	if (bpp <= 8)
+	{
+		const lv_color32_t* c = (const lv_color32_t*)px;
+		for (uint16_t i = 0; i < (1 << bpp); i++)
+		{
+			uint16_t v = ((c[i].ch.red & 0xF8) << 8) | ((c[i].ch.green & 0xFC) << 3) | (c[i].ch.blue >> 3);
+			palette[i] = (v >> 8) | (v << 8);
+		}
+		px += (1 << bpp) * sizeof(lv_color32_t);
+	}
+
+	uint32_t band_px = LV_HOR_RES_MAX * DISP_SPLASH_LINES;
+	uint16_t* bufs[2];
+	bufs[0] = (uint16_t*)heap_caps_malloc(band_px * 2 * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	if (bufs[0] == NULL) return false;
+	bufs[1] = bufs[0] + band_px;
+
+	int32_t x0 = (LV_HOR_RES_MAX - w) / 2, y0 = (LV_VER_RES_MAX - h) / 2;
+	uint32_t stride = bpp == 16 ? w * 2 : (w * bpp + 7) / 8;
+	uint8_t mask = (1 << (bpp & 7)) - 1;
+	bool dma = config.flush_mode != DISP_FLUSH_BLOCKING;
+	bool swap = tft.getSwapBytes();
+	tft.setSwapBytes(false);
+	select();
+	panel_begin();
+
+	for (int32_t y = 0, k = 0; y < LV_VER_RES_MAX; y += DISP_SPLASH_LINES, k ^= 1)
+	{
+		int32_t lines = min((int32_t)DISP_SPLASH_LINES, (int32_t)(LV_VER_RES_MAX - y));
+		uint16_t* out = bufs[k];
+		memset(out, 0, LV_HOR_RES_MAX * lines * sizeof(uint16_t));
+		for (int32_t r = 0; r < lines; r++)
+		{
+			int32_t sy = y + r - y0;
+			if (sy < 0 || sy >= h) continue;
+			const uint8_t* row = px + sy * stride;
+			uint16_t* dst = out + r * LV_HOR_RES_MAX + x0;
+			if (bpp == 16)
+			{
+				for (int32_t i = 0; i < w; i++)
+				{
+#if LV_COLOR_16_SWAP
+					dst[i] = row[2 * i] | (row[2 * i + 1] << 8);
+#else
+					dst[i] = row[2 * i + 1] | (row[2 * i] << 8);
+#endif
+				}
+				continue;
+			}
+			for (int32_t i = 0; i < w; i++)
+			{
+				uint32_t bit = i * bpp;
+				uint8_t idx = bpp == 8 ? row[i] : (row[bit >> 3] >> (8 - bpp - (bit & 7))) & mask;
+				dst[i] = palette[idx];
+			}
+		}
+		// pushImageDMA先等待上一条带发送完成，因此另一个缓冲区可以继续解码
+		if (dma) tft.pushImageDMA(0, y, LV_HOR_RES_MAX, lines, out);
+		else tft.pushImage(0, y, LV_HOR_RES_MAX, lines, out);
+	}
+
+	if (dma) panel_wait();
+	else tft.endWrite();
+	tft.setSwapBytes(swap);
+	heap_caps_free(bufs[0]);
+
+	setBackLight(DISP_SPLASH_BACKLIGHT);
+	return true;
+}
+
+/**
+ * 设置调色曲线（每通道一张表，刷新时查表，与字节交换在同一遍中完成，不增加绘制）
+ * 只作用于经LVGL刷新与直出的内容，pushRect/pushFrame等直接写面板的像素不调色
+ *
+ * @param red   32项，输入红色5位值，输出0~31
+ * @param green 64项，输入绿色6位值，输出0~63
+ * @param blue  32项，输入蓝色5位值，输出0~31
+ *              red为NULL或三条曲线都是恒等映射时关闭调色
+ * @return 调色表分配失败时返回false（保持不调色）
+ */
+bool Display::setColorCurve(const uint8_t* red, const uint8_t* green, const uint8_t* blue)
+{
+	bool identity = true;
+	for (uint8_t i = 0; red && i < 64 && identity; i++)
+	{
+		identity = green[i] == i && (i >= 32 || (red[i] == i && blue[i] == i));
+	}
+	if (identity)
+	{
+		if (lut == NULL) return true;
+		heap_caps_free(lut);
+		lut = NULL;
+	}
+	else
+	{
+		if (lut == NULL)
+		{
+			lut = (uint16_t*)heap_caps_malloc(LV_GPU_ESP32_LUT_SIZE * sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+			if (lut == NULL) return false;
+		}
+		// 表项为移到通道位置后的面板字节序（大端）
+		for (uint8_t i = 0; i < 32; i++)
+		{
+			lut[i] = __builtin_bswap16((uint16_t)(LV_MATH_MIN(red[i], 31) << 11));
+			lut[96 + i] = __builtin_bswap16((uint16_t)LV_MATH_MIN(blue[i], 31));
+		}
+		for (uint8_t i = 0; i < 64; i++) lut[32 + i] = __builtin_bswap16((uint16_t)(LV_MATH_MIN(green[i], 63) << 5));
+	}
+	// 屏幕上未变化的区域不会重新发送，整屏重绘一次
+	if (disp) lv_obj_invalidate(lv_disp_get_scr_act(disp));
+	return true;
+}
+
+bool Display::hasColorCurve()
+{
+	return lut != NULL;
+}
+
+/**
+ * 设置刷新旁路（截图等）
+ * 只能看到经LVGL刷新的区域：pushRect/pushFrame等直接写面板的内容不经过旁路，
+ * 设置期间直出回调返回false，图像改由LVGL绘制后经刷新回调发送
+ */
+void Display::setFlushTap(disp_tap_cb_t cb, void* user)
+{
+	tap_user = user;
+	tap = cb;
+}
+
+disp_tap_cb_t Display::getFlushTap()
+{
+	return tap;
 }
 
 /**
@@ -137,10 +1441,171 @@ void Display::routine()
  */
 void Display::setBackLight(float duty)
 {
+	// 没有背光引脚（如与主面板共用背光）
+	if (config.bl_pin < 0) return;
 	// 限制占空比范围在0-1之间
 	duty = constrain(duty, 0, 1);
+	energy.setBacklight(duty);
 	// 反转占空比（硬件可能是低电平有效）
 	duty = 1 - duty;
 	// 写入PWM值（0-255对应8位分辨率）
-	ledcWrite(LCD_BL_PWM_CHANNEL, (int)(duty * 255));
+	ledcWrite(config.bl_channel, (int)(duty * 255));
+}
+
+/**
+ * 获取当前刷新模式
+ * DMA初始化失败时会自动回退为阻塞模式
+ */
+DispFlushMode Display::getFlushMode()
+{
+	return config.flush_mode;
+}
+
+/**
+ * 获取实际生效的显示配置
+ */
+const DisplayConfig& Display::getConfig()
+{
+	return config;
+}
+
+/**
+ * 获取本显示注册的LVGL显示（镜像面板为NULL）
+ * 第二块独立面板的屏幕：lv_disp_get_scr_act(getDisp())，或lv_disp_set_default后创建
+ */
+lv_disp_t* Display::getDisp()
+{
+	return disp;
+}
+
+/**
+ * 设置本显示的LVGL刷新周期（毫秒），如副屏只显示慢变化的内容时降低刷新频率
+ */
+void Display::setRefreshPeriod(uint16_t ms)
+{
+	config.refr_ms = ms;
+	if (disp && disp->refr_task) lv_task_set_period(disp->refr_task, ms);
+}
+
+/**
+ * 获取显示缓冲区占用的RAM字节数
+ */
+uint32_t Display::getBufBytes()
+{
+	return buf_bytes;
+}
+
+/**
+ * 当前SPI写时钟（Hz）
+ */
+uint32_t Display::getSpiFrequency()
+{
+	return tft.getSPIFrequency();
+}
+
+/**
+ * 清除保存的SPI时钟，下次启动重新自检（如更换排线后）
+ */
+void Display::clearSpiTuning()
+{
+	Preferences prefs;
+	if (!prefs.begin(DISP_SPI_NAMESPACE, false)) return;
+	prefs.clear();
+	prefs.end();
+}
+
+/**
+ * 以指定时钟写入伪随机图案，再以SPI_READ_FREQUENCY读回比较
+ * 读回使用低速时钟，出错只可能来自写入；每轮使用不同的种子，避免读到上一轮残留的显存
+ *
+ * @return 所有轮次的CRC一致返回true
+ */
+bool Display::spiSelfTest(uint32_t freq)
+{
+	static uint32_t seed = 0x9E3779B9;
+	uint16_t line[LV_HOR_RES_MAX];
+
+	tft.setSPIFrequency(freq);
+	for (uint8_t round = 0; round < DISP_SPI_TUNE_ROUNDS; round++)
+	{
+		uint32_t x = seed += 0x6D2B79F5;
+		uint32_t crc_w = 0;
+		uint32_t crc_r = 0;
+
+		panel_begin();
+		tft.setAddrWindow(0, 0, LV_HOR_RES_MAX, DISP_SPI_TUNE_ROWS);
+		for (uint16_t y = 0; y < DISP_SPI_TUNE_ROWS; y++)
+		{
+			for (uint16_t i = 0; i < LV_HOR_RES_MAX; i++)
+			{
+				// xorshift32
+				x ^= x << 13;
+				x ^= x >> 17;
+				x ^= x << 5;
+				line[i] = (uint16_t)x;
+			}
+			crc_w = esp_rom_crc32_le(crc_w, (const uint8_t*)line, sizeof(line));
+			tft.pushColors(line, LV_HOR_RES_MAX, true);
+		}
+		tft.endWrite();
+
+		for (uint16_t y = 0; y < DISP_SPI_TUNE_ROWS; y++)
+		{
+			// readRect返回面板字节序（与pushRect配合），转换回本机字节序
+			tft.readRect(0, y, LV_HOR_RES_MAX, 1, line);
+			for (uint16_t i = 0; i < LV_HOR_RES_MAX; i++) line[i] = (line[i] << 8) | (line[i] >> 8);
+			crc_r = esp_rom_crc32_le(crc_r, (const uint8_t*)line, sizeof(line));
+		}
+		if (crc_r != crc_w) return false;
+	}
+	return true;
+}
+
+/**
+ * SPI写时钟自检
+ * 1. NVS中有保存值时只复验一次该频率，通过即直接使用
+ * 2. 先以默认时钟验证读回通路：失败说明MISO未连接或面板不支持读，保持SPI_FREQUENCY
+ * 3. 从低到高逐档测试，遇到第一档失败即停止，使用并保存最后一档通过的频率
+ */
+void Display::tuneSpi()
+{
+	static const uint32_t freqs[] = DISP_SPI_TUNE_FREQS;
+	Preferences prefs;
+	uint32_t saved = 0;
+	if (prefs.begin(DISP_SPI_NAMESPACE, true))
+	{
+		saved = prefs.getUInt("hz", 0);
+		prefs.end();
+	}
+
+	uint32_t best = 0;
+	if (saved && spiSelfTest(saved))
+	{
+		best = saved;
+	}
+	else if (!spiSelfTest(SPI_FREQUENCY))
+	{
+		Serial.println("SPI自检: 无法读回显存，保持默认时钟");
+		best = SPI_FREQUENCY;
+	}
+	else
+	{
+		best = SPI_FREQUENCY;
+		for (uint8_t i = 0; i < sizeof(freqs) / sizeof(freqs[0]); i++)
+		{
+			if (freqs[i] <= SPI_FREQUENCY) continue;
+			if (!spiSelfTest(freqs[i])) break;
+			best = freqs[i];
+		}
+		if (best != saved && prefs.begin(DISP_SPI_NAMESPACE, false))
+		{
+			prefs.putUInt("hz", best);
+			prefs.end();
+		}
+	}
+
+	tft.setSPIFrequency(best);
+	// 清除自检图案
+	tft.fillRect(0, 0, LV_HOR_RES_MAX, DISP_SPI_TUNE_ROWS, TFT_BLACK);
+	Serial.printf("SPI写时钟: %uMHz%s\n", best / 1000000, best == saved ? "（已保存）" : "");
 }
@@ -0,0 +1,119 @@
+/*
+ * HoloCubic 双核绘制模块
+ *
+ * 功能说明：
+ * 1. 工作任务固定在核心0，平时阻塞在任务通知上
+ * 2. draw_split_run发布后半部分后立即开始做前半部分，做完后用原子比较交换认领后半部分：
+ *    - 认领成功：工作任务还没开始，LVGL任务自己做完（stolen计数）
+ *    - 认领失败：工作任务正在做，等待它的完成信号量
+ * 3. 工作任务被唤醒时同样先认领，认领失败说明该工作已被LVGL任务做完，直接返回等待
+ *
+ * 两个核心访问同一片内部RAM（没有数据缓存一致性问题），任务通知与信号量保证内存可见性
+ */
+
+#include "draw_split.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "logger.h"
+
+enum
+{
+	JOB_IDLE = 0,
+	JOB_POSTED,     // 已发布，等待认领
+	JOB_CLAIMED,    // 已被某一方认领
+};
+
+static TaskHandle_t worker = NULL;
+static SemaphoreHandle_t done = NULL;
+static volatile bool enabled = false;
+static volatile uint32_t state = JOB_IDLE;
+
+static draw_split_cb_t job_cb;
+static void* job_ctx;
+static int32_t job_y1;
+static int32_t job_y2;
+
+static draw_split_stats_t stats;
+
+static bool claim()
+{
+	uint32_t expect = JOB_POSTED;
+	return __atomic_compare_exchange_n(&state, &expect, JOB_CLAIMED, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static void workerEntry(void* arg)
+{
+	while (true)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if (!claim()) continue;
+
+		int64_t t0 = esp_timer_get_time();
+		job_cb(job_ctx, job_y1, job_y2);
+		stats.worker_us += (uint32_t)(esp_timer_get_time() - t0);
+		xSemaphoreGive(done);
+	}
+}
+
+bool draw_split_enable(bool en)
+{
+	if (en && worker == NULL)
+	{
+		if (done == NULL) done = xSemaphoreCreateBinary();
+		if (done == NULL || xTaskCreatePinnedToCore(workerEntry, "draw_split", DRAW_SPLIT_TASK_STACK, NULL,
+													DRAW_SPLIT_TASK_PRIORITY, &worker, DRAW_SPLIT_TASK_CORE) != pdPASS)
+		{
+			LOG_E("draw_split", "工作任务创建失败");
+			worker = NULL;
+			return false;
+		}
+	}
+	enabled = en;
+	return true;
+}
+
+bool draw_split_is_enabled()
+{
+	return enabled;
+}
+
+bool draw_split_ready(uint32_t px)
+{
+	return enabled && px >= DRAW_SPLIT_MIN_PX && state == JOB_IDLE && xTaskGetCurrentTaskHandle() != worker;
+}
+
+void draw_split_run(draw_split_cb_t cb, void* ctx, int32_t rows)
+{
+	if (rows < 2 || !draw_split_ready(DRAW_SPLIT_MIN_PX))
+	{
+		cb(ctx, 0, rows - 1);
+		return;
+	}
+
+	int32_t half = rows / 2;
+	job_cb = cb;
+	job_ctx = ctx;
+	job_y1 = half;
+	job_y2 = rows - 1;
+	__atomic_store_n(&state, JOB_POSTED, __ATOMIC_RELEASE);
+	xTaskNotifyGive(worker);
+
+	cb(ctx, 0, half - 1);
+
+	if (claim())
+	{
+		cb(ctx, half, rows - 1);
+		stats.stolen++;
+	}
+	else
+	{
+		xSemaphoreTake(done, portMAX_DELAY);
+	}
+	stats.jobs++;
+	__atomic_store_n(&state, JOB_IDLE, __ATOMIC_RELEASE);
+}
+
+void draw_split_get_stats(draw_split_stats_t* out)
+{
+	*out = stats;
+}
@@ -0,0 +1,334 @@
+/*
+ * HoloCubic 程序化效果模块
+ *
+ * 功能说明：
+ * 1. 等离子、星空、火焰、熔岩噪声四种待机效果，可按间隔自动轮换
+ * 2. 逐条带计算：两个8行条带缓冲交替，DMA发送上一条带时计算下一条带，总共约7.5KB
+ * 3. 全部使用lib8tion定点运算：sin8/cos8/inoise8/qadd8/qsub8，颜色经256色调色板查表
+ *
+ * 数据流：
+ *   每帧：beginFrame更新查找表/星星位置 --> 逐条带render --> pushStrip（DMA） --> endStrips
+ */
+
+#include "effects.h"
+#include <FastLED.h>
+#include <esp_heap_caps.h>
+
+static const char* effect_names[EFFECT_COUNT] = { "plasma", "starfield", "fire", "noise" };
+
+/**
+ * FastLED颜色转为面板字节序RGB565
+ */
+static inline uint16_t panel565(const CRGB& c)
+{
+	uint16_t v = ((c.r & 0xF8) << 8) | ((c.g & 0xFC) << 3) | (c.b >> 3);
+	return (v >> 8) | (v << 8);
+}
+
+/**
+ * 16色渐变调色板展开为256色查找表
+ */
+static void buildPalette(uint16_t* out, const TProgmemRGBPalette16& pal)
+{
+	for (uint16_t i = 0; i < 256; i++) out[i] = panel565(ColorFromPalette(pal, i, 255, LINEARBLEND));
+}
+
+EffectEngine::EffectEngine()
+{
+	display = NULL;
+	type = EFFECT_PLASMA;
+	running = false;
+	strips[0] = strips[1] = NULL;
+	cycle_s = EFFECT_CYCLE_S;
+	frame_task = NULL;
+	screen = prev_screen = NULL;
+}
+
+void EffectEngine::setDisplay(Display* disp)
+{
+	display = disp;
+}
+
+/**
+ * 开始播放效果（在LVGL任务中调用）
+ *
+ * @param first 第一个效果，之后按setCycle的间隔轮换
+ */
+bool EffectEngine::start(EffectType first)
+{
+	if (running) return true;
+	if (display == NULL) return false;
+
+	uint32_t strip_px = LV_HOR_RES_MAX * EFFECT_STRIP_LINES;
+	strips[0] = (uint16_t*)heap_caps_malloc(strip_px * 2 * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	if (strips[0] == NULL)
+	{
+		Serial.println("效果条带缓冲分配失败");
+		return false;
+	}
+	strips[1] = strips[0] + strip_px;
+
+	// 空白屏幕：LVGL不再有需要重绘的对象，先画完这一次，之后不会覆盖效果画面
+	prev_screen = lv_scr_act();
+	screen = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(screen, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	lv_scr_load(screen);
+	lv_refr_now(NULL);
+
+	random16_add_entropy(micros());
+	memset(&stats, 0, sizeof(stats));
+	t = 0;
+	last_ms = millis();
+	select(first < EFFECT_COUNT ? first : EFFECT_PLASMA);
+
+	running = true;
+	frame_task = lv_task_create(frameCb, 1000 / EFFECT_FPS, LV_TASK_PRIO_HIGH, this);
+	return true;
+}
+
+/**
+ * 停止效果，恢复原来的LVGL屏幕（在LVGL任务中调用）
+ */
+void EffectEngine::stop()
+{
+	if (!running) return;
+
+	running = false;
+	if (frame_task)
+	{
+		lv_task_del(frame_task);
+		frame_task = NULL;
+	}
+	if (prev_screen) lv_scr_load(prev_screen);
+	if (screen) lv_obj_del(screen);
+	screen = prev_screen = NULL;
+
+	heap_caps_free(strips[0]);
+	strips[0] = strips[1] = NULL;
+}
+
+/**
+ * 切换到下一个效果
+ */
+void EffectEngine::next()
+{
+	select((EffectType)((type + 1) % EFFECT_COUNT));
+}
+
+/**
+ * 设置自动轮换间隔（秒），0表示不轮换
+ */
+void EffectEngine::setCycle(uint16_t seconds)
+{
+	cycle_s = seconds;
+}
+
+bool EffectEngine::isRunning()
+{
+	return running;
+}
+
+EffectType EffectEngine::getType()
+{
+	return type;
+}
+
+const char* EffectEngine::getName()
+{
+	return effect_names[type];
+}
+
+void EffectEngine::getStats(EffectStats* out)
+{
+	*out = stats;
+}
+
+/**
+ * 切换效果：准备调色板与星星初始位置
+ */
+void EffectEngine::select(EffectType next)
+{
+	type = next;
+	switch_ms = millis();
+	switch (type)
+	{
+	case EFFECT_PLASMA: buildPalette(palette, RainbowColors_p); break;
+	case EFFECT_FIRE: buildPalette(palette, HeatColors_p); break;
+	case EFFECT_NOISE: buildPalette(palette, LavaColors_p); break;
+	case EFFECT_STARFIELD:
+		for (uint8_t i = 0; i < EFFECT_STARS; i++) resetStar(&stars[i], false);
+		break;
+	default: break;
+	}
+}
+
+/**
+ * 重新放置一颗星星
+ * @param far 放到最远处（飞出屏幕后），否则随机深度（刚开始时铺满画面）
+ */
+void EffectEngine::resetStar(Star* s, bool far)
+{
+	s->x = (int16_t)(random16(2048) - 1024);
+	s->y = (int16_t)(random16(2048) - 1024);
+	s->z = far ? 1023 : 64 + random16(960);
+}
+
+/**
+ * 每帧开始：推进效果时间，更新本帧的查找表或星星投影
+ * @param dt 距上一帧的毫秒数
+ */
+void EffectEngine::beginFrame(uint32_t dt)
+{
+	if (dt > 100) dt = 100;
+	t += dt;
+
+	if (type == EFFECT_PLASMA)
+	{
+		uint8_t tc = t >> 3, td = t >> 4;
+		for (int32_t x = 0; x < LV_HOR_RES_MAX; x++) cols[x] = sin8(x * 3 + tc);
+		for (int32_t i = 0; i < LV_HOR_RES_MAX + LV_VER_RES_MAX; i++) diag[i] = cos8(i * 2 - td);
+		return;
+	}
+
+	if (type != EFFECT_STARFIELD) return;
+	// 每毫秒靠近0.5个深度单位，从最远处飞到镜头约2秒
+	uint16_t dz = (dt + 1) >> 1;
+	for (uint8_t i = 0; i < EFFECT_STARS; i++)
+	{
+		Star* s = &stars[i];
+		if (s->z <= 64 + dz) resetStar(s, true);
+		else s->z -= dz;
+
+		int32_t sx = LV_HOR_RES_MAX / 2 + (int32_t)s->x * 128 / s->z;
+		int32_t sy = LV_VER_RES_MAX / 2 + (int32_t)s->y * 128 / s->z;
+		if (sx < 0 || sx >= LV_HOR_RES_MAX || sy < 0 || sy >= LV_VER_RES_MAX)
+		{
+			// 飞出屏幕，下一帧从远处重新出现
+			resetStar(s, true);
+			s->sx = -1;
+			continue;
+		}
+		uint8_t b = 255 - (s->z >> 2);
+		s->sx = sx;
+		s->sy = sy;
+		s->size = s->z < 300 ? 2 : 1;
+		s->color = panel565(CRGB(b, b, qadd8(b, 48)));
+	}
+}
+
+void EffectEngine::render(uint16_t* out, int32_t y0, int32_t lines)
+{
+	switch (type)
+	{
+	case EFFECT_PLASMA: renderPlasma(out, y0, lines); break;
+	case EFFECT_STARFIELD: renderStars(out, y0, lines); break;
+	default: renderNoise(out, y0, lines); break;
+	}
+}
+
+/**
+ * 等离子：列、行、对角三个正弦项相加，按和查调色板（彩虹调色板首尾相接，和回绕后仍连续）
+ */
+void EffectEngine::renderPlasma(uint16_t* out, int32_t y0, int32_t lines)
+{
+	uint8_t tr = t >> 2;
+	for (int32_t y = y0; y < y0 + lines; y++)
+	{
+		uint8_t row = sin8(y * 2 + tr);
+		const uint8_t* d = &diag[y];
+		for (int32_t x = 0; x < LV_HOR_RES_MAX; x++)
+		{
+			*out++ = palette[(uint8_t)(cols[x] + row + d[x])];
+		}
+	}
+}
+
+/**
+ * 星空：清黑后只画投影落在本条带内的星星
+ */
+void EffectEngine::renderStars(uint16_t* out, int32_t y0, int32_t lines)
+{
+	memset(out, 0, LV_HOR_RES_MAX * lines * sizeof(uint16_t));
+	for (uint8_t i = 0; i < EFFECT_STARS; i++)
+	{
+		const Star* s = &stars[i];
+		if (s->sx < 0) continue;
+		for (uint8_t dy = 0; dy < s->size; dy++)
+		{
+			int32_t r = s->sy + dy - y0;
+			if (r < 0 || r >= lines) continue;
+			for (uint8_t dx = 0; dx < s->size && s->sx + dx < LV_HOR_RES_MAX; dx++)
+			{
+				out[r * LV_HOR_RES_MAX + s->sx + dx] = s->color;
+			}
+		}
+	}
+}
+
+/**
+ * 火焰与熔岩：按EFFECT_NOISE_BLOCK像素块计算inoise8，块内像素取同一颜色
+ * 火焰：噪声随时间向上滚动，越往上减去越多热量，经热度调色板着色
+ * 熔岩：三维噪声（z为时间）缓慢翻涌，调色板随时间轮转
+ */
+void EffectEngine::renderNoise(uint16_t* out, int32_t y0, int32_t lines)
+{
+	const int32_t B = EFFECT_NOISE_BLOCK;
+	const int32_t bw = LV_HOR_RES_MAX / B;
+	for (int32_t by = y0; by < y0 + lines; by += B)
+	{
+		if (type == EFFECT_FIRE)
+		{
+			uint16_t ny = by * 12 + ((t * 3) >> 2);
+			int32_t fade = (LV_VER_RES_MAX - 1 - by) * 320 / LV_VER_RES_MAX;
+			uint8_t f = fade > 255 ? 255 : fade;
+			for (int32_t bx = 0; bx < bw; bx++)
+			{
+				uint8_t n = inoise8(bx * B * 20, ny, t >> 2);
+				cols[bx] = qsub8(qadd8(n, 64), f);
+			}
+		}
+		else
+		{
+			uint8_t shift = t >> 6;
+			for (int32_t bx = 0; bx < bw; bx++) cols[bx] = inoise8(bx * B * 12, by * 12, t >> 2) + shift;
+		}
+
+		// 块的第一行查表展开，其余行直接复制
+		uint16_t* row = out + (by - y0) * LV_HOR_RES_MAX;
+		for (int32_t x = 0; x < LV_HOR_RES_MAX; x++) row[x] = palette[cols[x / B]];
+		for (int32_t r = 1; r < B && by + r < y0 + lines; r++)
+		{
+			memcpy(row + r * LV_HOR_RES_MAX, row, LV_HOR_RES_MAX * sizeof(uint16_t));
+		}
+	}
+}
+
+/**
+ * 帧定时任务：到间隔时轮换效果，逐条带计算并写屏
+ */
+void EffectEngine::frameCb(lv_task_t* task)
+{
+	EffectEngine* self = (EffectEngine*)task->user_data;
+	uint32_t now = millis();
+	uint32_t t0 = micros();
+
+	if (self->cycle_s && now - self->switch_ms >= (uint32_t)self->cycle_s * 1000) self->next();
+	self->beginFrame(now - self->last_ms);
+	self->last_ms = now;
+
+	self->display->waitVsync();
+	self->display->beginStrips();
+	for (int32_t y = 0, k = 0; y < LV_VER_RES_MAX; y += EFFECT_STRIP_LINES, k ^= 1)
+	{
+		int32_t lines = LV_MATH_MIN(EFFECT_STRIP_LINES, LV_VER_RES_MAX - y);
+		self->render(self->strips[k], y, lines);
+		// pushStrip先等待上一条带发送完成，因此另一个缓冲区可以继续计算
+		self->display->pushStrip(0, y, LV_HOR_RES_MAX, lines, self->strips[k]);
+	}
+	self->display->endStrips();
+
+	uint32_t dt = micros() - t0;
+	self->stats.frames++;
+	self->stats.frame_us = dt;
+	if (dt > self->stats.max_us) self->stats.max_us = dt;
+}
@@ -0,0 +1,187 @@
+/*
+ * HoloCubic 能耗估计
+ *
+ * 功能说明：
+ * 1. 背光、LED、WiFi在负载变化时报告，每个通道累计"负载值 * 持续微秒"，采样时除以时长即为平均负载
+ * 2. CPU与SD卡由遥测采样提供（各核空闲任务占用、期间读写字节数）
+ * 3. 平均负载乘以energy.h中的电流模型，得到各部件的平均电流与累计耗电
+ *
+ * 估计方法：
+ *   背光 = ENERGY_UA_BACKLIGHT * 平均占空比
+ *   LED  = LED数 * ENERGY_UA_LED_IDLE + ENERGY_UA_LED_CHANNEL * 平均通道值之和 / 255
+ *   WiFi = 各状态电流按时间加权（关闭0 / 最大省电 / 常开）
+ *   CPU  = ENERGY_UA_CPU_IDLE + ENERGY_UA_CPU_CORE * 各核负载之和
+ *   SD   = ENERGY_UA_SD_IDLE + ENERGY_UA_SD_ACTIVE * (读字节 / 读吞吐 + 写字节 / 写吞吐) / 时长
+ *
+ * 注意事项：
+ * - 通道的积分在自旋锁内进行，报告方可以是任意任务（背光渐变、LED刷新任务、WiFi事件任务）
+ */
+
+#include "energy.h"
+#include "telemetry.h"
+#include "lvgl.h"
+
+// LVGL（Arduino的loop）所在的核，没有运行时统计时用LVGL空闲率估计其负载
+#ifdef CONFIG_ARDUINO_RUNNING_CORE
+#define ENERGY_LV_CORE CONFIG_ARDUINO_RUNNING_CORE
+#else
+#define ENERGY_LV_CORE 1
+#endif
+
+EnergyMeter energy;
+
+EnergyMeter::EnergyMeter()
+{
+	lock = portMUX_INITIALIZER_UNLOCKED;
+	memset(ch, 0, sizeof(ch));
+	led_count = 0;
+	mark_us = 0;
+	total_acc = 0;
+}
+
+/**
+ * 积分到当前时刻后换上新的负载值
+ */
+void EnergyMeter::set(uint8_t id, uint32_t value)
+{
+	portENTER_CRITICAL(&lock);
+	int64_t now = esp_timer_get_time();
+	Channel* c = &ch[id];
+	c->acc += (uint64_t)c->value * (uint64_t)(now - c->mark_us);
+	c->mark_us = now;
+	c->value = value;
+	portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * 取出通道在span_us内的平均值并清零累计（持锁调用）
+ */
+uint32_t EnergyMeter::take(uint8_t id, int64_t now, uint32_t span_us)
+{
+	Channel* c = &ch[id];
+	c->acc += (uint64_t)c->value * (uint64_t)(now - c->mark_us);
+	c->mark_us = now;
+	uint32_t avg = (uint32_t)(c->acc / span_us);
+	c->acc = 0;
+	return avg;
+}
+
+void EnergyMeter::setBacklight(float duty)
+{
+	set(CH_BACKLIGHT, (uint32_t)(constrain(duty, 0, 1) * 1000));
+}
+
+void EnergyMeter::setLed(uint32_t level, uint8_t count)
+{
+	led_count = count;
+	set(CH_LED, level);
+}
+
+void EnergyMeter::setWifi(EnergyWifi state)
+{
+	uint32_t ua = state == ENERGY_WIFI_ON ? ENERGY_UA_WIFI_ON : (state == ENERGY_WIFI_SLEEP ? ENERGY_UA_WIFI_SLEEP : 0);
+	set(CH_RADIO, state == ENERGY_WIFI_ON ? 1000 : 0);
+	set(CH_WIFI_UA, ua);
+}
+
+/**
+ * 丢弃此前的累计，下一次采样从现在开始
+ */
+void EnergyMeter::reset()
+{
+	portENTER_CRITICAL(&lock);
+	int64_t now = esp_timer_get_time();
+	for (uint8_t i = 0; i < CH_COUNT; i++)
+	{
+		ch[i].acc = 0;
+		ch[i].mark_us = now;
+	}
+	mark_us = now;
+	total_acc = 0;
+	portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * 各核负载：空闲任务（IDLE0/IDLE1）的占用为相对两个核总时间的千分比，
+ * 该核空闲比例 = 2 * 占用；没有运行时统计时只能按LVGL空闲率估计LVGL所在的核
+ */
+static void cpuLoad(const TelemetryTask* tasks, uint8_t n, int16_t load[2])
+{
+	int32_t idle[2] = {-1, -1};
+	for (uint8_t i = 0; i < n; i++)
+	{
+		const TelemetryTask* t = &tasks[i];
+		if (t->core > 1 || t->cpu_permille < 0 || strncmp(t->name, "IDLE", 4) != 0) continue;
+		idle[t->core] = (idle[t->core] < 0 ? 0 : idle[t->core]) + t->cpu_permille * 2;
+	}
+	for (uint8_t c = 0; c < 2; c++)
+	{
+		load[c] = idle[c] < 0 ? -1 : (int16_t)constrain(1000 - idle[c], 0, 1000);
+	}
+	if (load[ENERGY_LV_CORE] < 0) load[ENERGY_LV_CORE] = (int16_t)(100 - lv_task_get_idle()) * 10;
+}
+
+void EnergyMeter::sample(EnergyStats* out, uint32_t sd_read, uint32_t sd_write, const TelemetryTask* tasks,
+						 uint8_t task_count)
+{
+	portENTER_CRITICAL(&lock);
+	int64_t now = esp_timer_get_time();
+	uint32_t span = (uint32_t)(now - mark_us);
+	if (span == 0) span = 1;
+	mark_us = now;
+	uint32_t bl = take(CH_BACKLIGHT, now, span);
+	uint32_t led = take(CH_LED, now, span);
+	uint32_t radio = take(CH_RADIO, now, span);
+	uint32_t wifi_ua = take(CH_WIFI_UA, now, span);
+	uint8_t leds = led_count;
+	portEXIT_CRITICAL(&lock);
+
+	cpuLoad(tasks, task_count, out->cpu_load);
+	uint32_t cpu_ua = ENERGY_UA_CPU_IDLE;
+	for (uint8_t c = 0; c < 2; c++)
+	{
+		if (out->cpu_load[c] > 0) cpu_ua += (uint32_t)ENERGY_UA_CPU_CORE * out->cpu_load[c] / 1000;
+	}
+
+	// 读写时间（微秒）= 字节 / 吞吐
+	uint64_t sd_busy = (uint64_t)sd_read * 1000000 / ENERGY_SD_READ_BPS +
+					   (uint64_t)sd_write * 1000000 / ENERGY_SD_WRITE_BPS;
+	uint32_t sd_permille = (uint32_t)LV_MATH_MIN(sd_busy * 1000 / span, 1000);
+	uint32_t sd_ua = ENERGY_UA_SD_IDLE + (uint32_t)ENERGY_UA_SD_ACTIVE * sd_permille / 1000;
+
+	uint32_t bl_ua = (uint32_t)ENERGY_UA_BACKLIGHT * bl / 1000;
+	uint32_t led_ua = (uint32_t)leds * ENERGY_UA_LED_IDLE + (uint32_t)((uint64_t)ENERGY_UA_LED_CHANNEL * led / 255);
+	uint32_t total = ENERGY_UA_BOARD + cpu_ua + bl_ua + wifi_ua + sd_ua + led_ua;
+	total_acc += (uint64_t)total * span;
+
+	out->total_ma_x10 = total / 100;
+	out->board_ma_x10 = ENERGY_UA_BOARD / 100;
+	out->cpu_ma_x10 = cpu_ua / 100;
+	out->backlight_ma_x10 = bl_ua / 100;
+	out->wifi_ma_x10 = wifi_ua / 100;
+	out->sd_ma_x10 = sd_ua / 100;
+	out->led_ma_x10 = led_ua / 100;
+	out->backlight_permille = bl;
+	out->radio_permille = radio;
+	out->sd_permille = sd_permille;
+	out->led_permille = leds ? led * 1000 / (leds * 3U * 255U) : 0;
+	// 微安 * 微秒 -> 微安时
+	out->total_uah = (uint32_t)(total_acc / 3600000000ULL);
+}
+
+/**
+ * 输出JSON的"power"对象（不含外层逗号），电流单位mA
+ * @return 写入的字节数，缓冲区不足时返回负数
+ */
+int EnergyMeter::format(const EnergyStats* s, char* buf, size_t len)
+{
+	int n = snprintf(buf, len,
+		"\"power\":{\"ma\":%u.%u,\"board\":%u.%u,\"cpu\":%u.%u,\"bl\":%u.%u,\"wifi\":%u.%u,\"sd\":%u.%u,\"led\":%u.%u,"
+		"\"uah\":%u,\"load\":[%d,%d],\"bl_duty\":%u,\"radio\":%u,\"sd_busy\":%u,\"led_lvl\":%u}",
+		s->total_ma_x10 / 10, s->total_ma_x10 % 10, s->board_ma_x10 / 10, s->board_ma_x10 % 10,
+		s->cpu_ma_x10 / 10, s->cpu_ma_x10 % 10, s->backlight_ma_x10 / 10, s->backlight_ma_x10 % 10,
+		s->wifi_ma_x10 / 10, s->wifi_ma_x10 % 10, s->sd_ma_x10 / 10, s->sd_ma_x10 % 10,
+		s->led_ma_x10 / 10, s->led_ma_x10 % 10, s->total_uah, s->cpu_load[0], s->cpu_load[1],
+		s->backlight_permille, s->radio_permille, s->sd_permille, s->led_permille);
+	return n < 0 || (size_t)n >= len ? -1 : n;
+}
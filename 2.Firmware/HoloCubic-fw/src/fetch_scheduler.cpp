@@ -0,0 +1,238 @@
+/*
+ * HoloCubic 后台数据抓取模块
+ *
+ * 功能说明：
+ * 1. 数据源注册URL、刷新间隔、解析函数与缓存有效期
+ * 2. 抓取任务在WiFi连接时集中请求到期的数据源，断网时不发请求
+ * 3. 结果缓存在内存和SD卡（/cache/<name>.txt），开机后未过期的缓存可直接显示
+ * 4. 只有值发生变化时才回调通知界面
+ * 5. 到期时间相近的请求合并为一个网络窗口，窗口之外不唤醒抓取任务、射频保持省电
+ * 6. 请求与解析交给Network的网络任务（与其他请求共用一个HTTP客户端），本任务只负责调度与缓存
+ */
+
+#include "fetch_scheduler.h"
+#include "sd_card.h"
+#include "time_service.h"
+
+FetchScheduler fetcher;
+
+/**
+ * 启动抓取任务
+ * 数据源可以在begin之前或之后注册
+ */
+bool FetchScheduler::begin(Network* network)
+{
+	net = network;
+	if (mutex == NULL) mutex = xSemaphoreCreateMutex();
+	if (mutex == NULL) return false;
+
+	SD_FS.mkdir(FETCH_CACHE_DIR);
+	return xTaskCreatePinnedToCore(taskEntry, "fetch", FETCH_TASK_STACK, this,
+		FETCH_TASK_PRIORITY, &task, FETCH_TASK_CORE) == pdPASS;
+}
+
+/**
+ * 注册数据源，立即读取SD卡缓存，下一个调度周期发起首次请求
+ *
+ * @return 数据源编号，已满或URL为空返回-1
+ */
+int FetchScheduler::add(const FetchSource& src)
+{
+	if (mutex == NULL) mutex = xSemaphoreCreateMutex();
+	if (count >= FETCH_MAX_SOURCES || src.parse == NULL) return -1;
+	if (src.url[0] == 0) return -1;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	uint8_t id = count;
+	Entry& e = entries[id];
+	e.src = src;
+	e.value[0] = 0;
+	e.fetched_at = 0;
+	e.has_value = false;
+	e.due = millis();
+	count++;
+	xSemaphoreGive(mutex);
+
+	loadCache(id);
+	return id;
+}
+
+/**
+ * 读取缓存值（任意任务中调用，不访问网络）
+ *
+ * @return 没有值或已超过有效期返回false
+ */
+bool FetchScheduler::get(uint8_t id, char* out, size_t len)
+{
+	if (id >= count) return false;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	const Entry& e = entries[id];
+	bool ok = e.has_value && fresh(e);
+	if (ok) strlcpy(out, e.value, len);
+	xSemaphoreGive(mutex);
+	return ok;
+}
+
+/**
+ * 要求尽快刷新（下一个调度周期请求）
+ */
+void FetchScheduler::refresh(uint8_t id)
+{
+	if (id >= count) return;
+	entries[id].due = millis();
+	if (task) xTaskNotifyGive(task);
+}
+
+/**
+ * 是否并入本次窗口：已到期，或在提前量之内即将到期
+ */
+bool FetchScheduler::inWindow(const Entry& e, uint32_t now)
+{
+	int32_t left = (int32_t)(e.due - now);
+	if (left <= 0) return true;
+	uint32_t ahead = e.src.interval_s / FETCH_BATCH_AHEAD_DIV;
+	if (ahead > FETCH_BATCH_AHEAD_S) ahead = FETCH_BATCH_AHEAD_S;
+	return (uint32_t)left <= ahead * 1000;
+}
+
+/**
+ * 距最近一个数据源到期的毫秒数（不超过FETCH_IDLE_MAX_MS）
+ */
+uint32_t FetchScheduler::nextDue(uint32_t now)
+{
+	uint32_t wait = FETCH_IDLE_MAX_MS;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		int32_t left = (int32_t)(entries[i].due - now);
+		if (left <= 0) return 0;
+		if ((uint32_t)left < wait) wait = left;
+	}
+	return wait;
+}
+
+/**
+ * 缓存是否仍在有效期内（时间未同步时无法判断，视为有效）
+ */
+bool FetchScheduler::fresh(const Entry& e)
+{
+	if (e.src.ttl_s == 0 || e.fetched_at == 0) return true;
+	time_t now = timesvc.now();
+	if (now == 0) return true;
+	return now - e.fetched_at <= (time_t)e.src.ttl_s;
+}
+
+/**
+ * 请求一个数据源（抓取任务中执行，等待网络任务完成请求与解析）
+ */
+void FetchScheduler::fetch(uint8_t id)
+{
+	Entry& e = entries[id];
+	char value[FETCH_VALUE_LEN];
+
+	strlcpy(req.url, e.src.url, sizeof(req.url));
+	req.filter = e.src.filter;
+	req.parse = e.src.parse;
+	req.done = NULL;
+	req.notify = xTaskGetCurrentTaskHandle();
+	bool ok = net->request(&req);
+	// 期间收到的refresh()通知一并消耗：到期时间已更新，窗口结束后重新计算
+	while (ok && req.busy) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FETCH_TICK_MS));
+	if (ok && req.ok) strlcpy(value, req.result, sizeof(value));
+	if (!ok || !req.ok)
+	{
+		e.due = millis() + min(e.src.interval_s, (uint32_t)FETCH_RETRY_S) * 1000;
+		return;
+	}
+	e.due = millis() + e.src.interval_s * 1000;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	bool changed = !e.has_value || strcmp(e.value, value) != 0;
+	strlcpy(e.value, value, sizeof(e.value));
+	e.has_value = true;
+	e.fetched_at = timesvc.now();
+	xSemaphoreGive(mutex);
+
+	// 值不变时只刷新时间戳，不写SD卡、不通知界面
+	if (!changed) return;
+	saveCache(id);
+	if (e.src.on_change) e.src.on_change(id, e.value, e.src.user);
+}
+
+/**
+ * 读取SD卡缓存（格式：第1行时间戳，第2行值）
+ */
+void FetchScheduler::loadCache(uint8_t id)
+{
+	Entry& e = entries[id];
+	char path[48];
+	snprintf(path, sizeof(path), FETCH_CACHE_DIR "/%s.txt", e.src.name);
+
+	File f = SD_FS.open(path);
+	if (!f) return;
+	char line[24];
+	char value[FETCH_VALUE_LEN];
+	size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+	line[n] = 0;
+	time_t ts = atol(line);
+	n = f.readBytesUntil('\n', value, sizeof(value) - 1);
+	f.close();
+	while (n > 0 && value[n - 1] == '\r') n--;
+	value[n] = 0;
+	if (n == 0) return;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	strlcpy(e.value, value, sizeof(e.value));
+	e.fetched_at = ts;
+	e.has_value = true;
+	xSemaphoreGive(mutex);
+}
+
+void FetchScheduler::saveCache(uint8_t id)
+{
+	const Entry& e = entries[id];
+	char path[48];
+	snprintf(path, sizeof(path), FETCH_CACHE_DIR "/%s.txt", e.src.name);
+
+	File f = SD_FS.open(path, FILE_WRITE);
+	if (!f) return;
+	f.printf("%ld\n%s\n", (long)e.fetched_at, e.value);
+	f.close();
+}
+
+/**
+ * 抓取任务：休眠到最近的到期时间，WiFi连接时把窗口内的数据源集中请求完
+ * 断网时按FETCH_TICK_MS检查，联网后到期的请求立即进行
+ */
+void FetchScheduler::taskEntry(void* arg)
+{
+	FetchScheduler* self = (FetchScheduler*)arg;
+	uint32_t wait = FETCH_TICK_MS;
+
+	for (;;)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+		timesvc.poll();
+		if (!self->net->isConnected())
+		{
+			wait = FETCH_TICK_MS;
+			continue;
+		}
+
+		uint32_t now = millis();
+		wait = min(self->nextDue(now), timesvc.msToSync());
+		if (wait > 0) continue;
+
+		self->net->acquire();
+		// 校时到期（首次联网时立即）时先校时，之后的缓存时间戳即为准确时间
+		if (timesvc.syncDue()) timesvc.sync();
+		for (uint8_t i = 0; i < self->count; i++)
+		{
+			if (!self->inWindow(self->entries[i], now)) continue;
+			self->fetch(i);
+			if (!self->net->isConnected()) break;
+		}
+		self->net->release();
+		wait = min(self->nextDue(millis()), timesvc.msToSync());
+	}
+}
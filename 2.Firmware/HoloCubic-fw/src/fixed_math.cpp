@@ -0,0 +1,90 @@
+/*
+ * HoloCubic 定点数学工具
+ *
+ * 功能说明：
+ * 1. fx_atan2：按八分圆折叠到[0, 45度]，比值查33项atan表后线性插值
+ * 2. fx_isqrt：逐位求整数平方根（16次迭代，只用移位与比较）
+ * 3. fx_rsqrt：把x按偶数位左移规格化到[2^30, 2^32)，求平方根后用一次32位除法取倒数，再按移位量还原
+ *
+ * 函数放在IRAM、查找表放在DRAM，闪存缓存关闭时（中断、Flash写入期间）也可调用
+ */
+
+#include "fixed_math.h"
+#include <esp_attr.h>
+
+// atan(i / 32)，二进制角度（65536为一整圈），i = 0..32
+static DRAM_ATTR const uint16_t atan_lut[33] = {
+	0, 326, 651, 975, 1297, 1617, 1933, 2246, 2555, 2860, 3159, 3453, 3742, 4025, 4302, 4572, 4836,
+	5094, 5344, 5589, 5826, 6058, 6282, 6500, 6712, 6917, 7117, 7310, 7498, 7679, 7856, 8026, 8192
+};
+
+/**
+ * [0, 1]内比值（Q15，0~32768）的反正切
+ */
+static IRAM_ATTR uint16_t atanUnit(uint32_t t)
+{
+	uint32_t i = t >> 10;
+	if (i >= 32) return atan_lut[32];
+	uint32_t f = t & 1023;
+	return atan_lut[i] + (((atan_lut[i + 1] - atan_lut[i]) * f + 512) >> 10);
+}
+
+fx_angle_t IRAM_ATTR fx_atan2(int32_t y, int32_t x)
+{
+	uint32_t ax = x < 0 ? -(uint32_t)x : (uint32_t)x;
+	uint32_t ay = y < 0 ? -(uint32_t)y : (uint32_t)y;
+	if (ax == 0 && ay == 0) return 0;
+
+	// 比值只需16位精度，较大的分量缩到16位以内，(min << 15)不会溢出
+	while ((ax | ay) >= 0x10000)
+	{
+		ax >>= 1;
+		ay >>= 1;
+	}
+	uint32_t a;
+	if (ax >= ay) a = atanUnit((ay << 15) / ax);
+	else a = FX_ANGLE_90 - atanUnit((ax << 15) / ay);
+
+	if (x < 0) a = FX_ANGLE_180 - a;
+	if (y < 0) a = 65536 - a;
+	return (fx_angle_t)a;
+}
+
+uint16_t IRAM_ATTR fx_isqrt(uint32_t x)
+{
+	uint32_t res = 0;
+	uint32_t bit = 1UL << 30;
+	while (bit > x) bit >>= 2;
+	while (bit)
+	{
+		if (x >= res + bit)
+		{
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+		{
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t)res;
+}
+
+uint16_t IRAM_ATTR fx_hypot(int16_t x, int16_t y)
+{
+	return fx_isqrt((uint32_t)((int32_t)x * x) + (uint32_t)((int32_t)y * y));
+}
+
+q16_t IRAM_ATTR fx_rsqrt(q16_t x)
+{
+	if (x <= 0) return INT32_MAX;
+
+	// x' = x * 4^k ∈ [2^30, 2^32)，sqrt(x') = sqrt(x) * 2^k，取16位精度的平方根
+	uint32_t k = __builtin_clz((uint32_t)x) >> 1;
+	uint32_t s = fx_isqrt((uint32_t)x << (2 * k));
+
+	// 1/sqrt(x / 2^16)的Q16表示为2^24 / sqrt(x) = (2^32 / s) * 2^(k - 8)
+	uint32_t r = 0xFFFFFFFFUL / s;
+	return (q16_t)(k >= 8 ? r << (k - 8) : (r + (1UL << (7 - k))) >> (8 - k));
+}
@@ -0,0 +1,448 @@
+/*
+ * HoloCubic 多设备管理模块
+ *
+ * 功能说明：
+ * 1. mDNS：主机名为设备名（<name>.local），发布_holocubic._udp与_http._tcp服务，TXT中带MAC与固件版本
+ * 2. UDP管理协议（包格式见fleet.h）：状态查询、写入配置、切换场景、批量文件比较、块CRC查询、重启
+ * 3. 写操作用共享密钥的HMAC-SHA256认证，会话号与递增序号防止重放
+ *
+ * 批量同步流程（主机工具3.Software/HoloFleet/holo_fleet.py）：
+ *   主机计算本地文件的大小与CRC32 --SYNC--> 设备按文件内容清单比较，回复需要上传的条目
+ *   --> 设备上没有的文件经PUT /upload（可续传）整个推送；已有的文件先取CHUNKS，
+ *       只用PUT /upload?patch=1上传变化的块，多台设备并发进行
+ *
+ * 注意事项：
+ * - 请求在接收任务（核心0）中处理；切换场景经runtime.post在LVGL任务中执行
+ * - CONFIG写入NVS，与config.json导入的项相同；WiFi等启动时读取的配置在RESTART后生效
+ * - 回复不认证，STATUS可被同一网段内的任何主机查询
+ */
+
+#include "fleet.h"
+#include "upload_server.h"
+#include "config_store.h"
+#include "render_prof.h"
+#include "sd_card.h"
+#include "scene_manifest.h"
+#include "logger.h"
+#include <WiFi.h>
+#include <ESPmDNS.h>
+#include <lwip/sockets.h>
+#include <mbedtls/md.h>
+#include <esp_ota_ops.h>
+
+FleetServer::FleetServer()
+{
+	sock = -1;
+	task = NULL;
+	running = false;
+	session = 0;
+	last_seq = 0;
+	seq_valid = false;
+	name[0] = '\0';
+	key[0] = '\0';
+	http_port = 0;
+	scene_cb = NULL;
+	scene_user = NULL;
+	scene_lock = portMUX_INITIALIZER_UNLOCKED;
+	scene_name[0] = '\0';
+	scene_fps = 0;
+}
+
+/**
+ * 设置设备名与共享密钥（begin之前调用）
+ * 设备名只保留字母、数字与'-'（mDNS主机名），为空时按MAC生成
+ */
+void FleetServer::setIdentity(const char* device_name, const char* fleet_key)
+{
+	uint8_t n = 0;
+	for (const char* p = device_name; p && *p && n < sizeof(name) - 1; p++)
+	{
+		if (isalnum((unsigned char)*p) || *p == '-') name[n++] = *p;
+	}
+	name[n] = '\0';
+	if (n == 0)
+	{
+		uint8_t mac[6];
+		WiFi.macAddress(mac);
+		snprintf(name, sizeof(name), FLEET_NAME_PREFIX "%02x%02x%02x", mac[3], mac[4], mac[5]);
+	}
+	strlcpy(key, fleet_key ? fleet_key : "", sizeof(key));
+}
+
+/**
+ * 场景触发回调（在LVGL任务中执行，通常打开并播放场景）
+ */
+void FleetServer::setSceneCallback(fleet_scene_cb_t cb, void* user)
+{
+	scene_cb = cb;
+	scene_user = user;
+}
+
+/**
+ * 上传服务端口（STATUS中给出，0表示未运行）
+ */
+void FleetServer::setHttpPort(uint16_t port)
+{
+	http_port = port;
+}
+
+/**
+ * 启动mDNS与接收任务（联网后调用；重复调用直接返回）
+ */
+bool FleetServer::begin(uint16_t port)
+{
+	if (running) return true;
+	if (name[0] == '\0') setIdentity(NULL, key);
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (sock < 0 || bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		LOG_W("fleet", "管理端口%u绑定失败", port);
+		if (sock >= 0) closesocket(sock);
+		sock = -1;
+		return false;
+	}
+	// 接收超时用于检查退出标志
+	timeval tv = { 0, 500000 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	session = esp_random();
+	seq_valid = false;
+
+	if (MDNS.begin(name))
+	{
+		const esp_app_desc_t* app = esp_ota_get_app_description();
+		MDNS.addService(FLEET_MDNS_SERVICE, "udp", port);
+		MDNS.addServiceTxt(FLEET_MDNS_SERVICE, "udp", "mac", WiFi.macAddress().c_str());
+		MDNS.addServiceTxt(FLEET_MDNS_SERVICE, "udp", "fw", app->version);
+		if (http_port) MDNS.addService("http", "tcp", http_port);
+	}
+	else
+	{
+		// 没有mDNS时主机仍可广播STATUS发现设备
+		LOG_W("fleet", "mDNS启动失败");
+	}
+
+	running = true;
+	if (xTaskCreatePinnedToCore(taskEntry, "fleet", FLEET_TASK_STACK, this,
+								FLEET_TASK_PRIORITY, &task, FLEET_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		running = false;
+		closesocket(sock);
+		sock = -1;
+		MDNS.end();
+		return false;
+	}
+	LOG_I("fleet", "管理服务已启动: %s.local UDP %u%s", name, port, key[0] ? "" : "（未配置密钥，只读）");
+	return true;
+}
+
+void FleetServer::end()
+{
+	if (!running) return;
+	running = false;
+	while (task != NULL) vTaskDelay(pdMS_TO_TICKS(10));
+	closesocket(sock);
+	sock = -1;
+	MDNS.end();
+}
+
+bool FleetServer::isRunning()
+{
+	return running;
+}
+
+const char* FleetServer::getName()
+{
+	return name;
+}
+
+/**
+ * 检查写操作：密钥已配置、会话号一致、序号递增、认证标签正确
+ * 标签位于载荷之后（接收时已确认长度足够）
+ */
+bool FleetServer::authorize(const FleetHeader* h, const uint8_t* payload)
+{
+	if (key[0] == '\0' || h->session != session) return false;
+	if (seq_valid && (int32_t)(h->seq - last_seq) <= 0) return false;
+
+	uint8_t mac[32];
+	const mbedtls_md_info_t* md = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+	if (mbedtls_md_hmac(md, (const uint8_t*)key, strlen(key), (const uint8_t*)h,
+						sizeof(FleetHeader) + h->len, mac) != 0) return false;
+	// 逐字节累积差异，比较时间与标签内容无关
+	const uint8_t* tag = payload + h->len;
+	uint8_t diff = 0;
+	for (uint8_t i = 0; i < FLEET_TAG_LEN; i++) diff |= mac[i] ^ tag[i];
+	if (diff) return false;
+
+	last_seq = h->seq;
+	seq_valid = true;
+	return true;
+}
+
+/**
+ * 填写状态
+ */
+uint16_t FleetServer::opStatus(uint8_t* out)
+{
+	FleetStatus* s = (FleetStatus*)out;
+	memset(s, 0, sizeof(*s));
+	WiFi.macAddress(s->mac);
+	s->rssi = WiFi.RSSI();
+	s->flags = (key[0] ? FLEET_STATUS_WRITABLE : 0) | (http_port ? FLEET_STATUS_UPLOAD : 0);
+	s->uptime_s = millis() / 1000;
+	s->heap_free = ESP.getFreeHeap();
+	s->heap_min = ESP.getMinFreeHeap();
+	s->frames = render_prof_get_totals(NULL);
+	SceneIndex index;
+	s->scene_count = index.open() ? index.getCount() : 0;
+	s->http_port = http_port;
+	strlcpy(s->name, name, sizeof(s->name));
+	strlcpy(s->firmware, esp_ota_get_app_description()->version, sizeof(s->firmware));
+	portENTER_CRITICAL(&scene_lock);
+	memcpy(s->scene, scene_name, sizeof(s->scene));
+	portEXIT_CRITICAL(&scene_lock);
+	return sizeof(*s);
+}
+
+/**
+ * 写入配置：每项为"路径\0值\0"，整数与布尔值为十进制文本（布尔也可为true/false）
+ */
+uint16_t FleetServer::opConfig(const uint8_t* payload, uint16_t len, uint8_t* out, uint8_t* status)
+{
+	FleetConfigResult* r = (FleetConfigResult*)out;
+	r->applied = 0;
+	r->rejected = 0;
+
+	const char* p = (const char*)payload;
+	const char* end = p + len;
+	while (p < end)
+	{
+		const char* path = p;
+		const char* value = (const char*)memchr(path, '\0', end - path);
+		if (value == NULL || ++value >= end || memchr(value, '\0', end - value) == NULL)
+		{
+			*status = FLEET_ERR_FORMAT;
+			break;
+		}
+		p = value + strlen(value) + 1;
+
+		ConfigKey k = Config::find(path);
+		const ConfigSchema* sc = Config::schema(k);
+		bool ok = false;
+		if (sc && sc->type == CFG_TYPE_STR)
+		{
+			ok = config.set(k, value);
+		}
+		else if (sc)
+		{
+			char* tail;
+			long v = strtol(value, &tail, 10);
+			if (sc->type == CFG_TYPE_BOOL && (strcmp(value, "true") == 0 || strcmp(value, "false") == 0))
+			{
+				v = value[0] == 't';
+				tail = (char*)value + strlen(value);
+			}
+			ok = *value && *tail == '\0' && config.set(k, (int32_t)v);
+		}
+		if (ok) r->applied++;
+		else r->rejected++;
+		LOG_I("fleet", "配置%s: %s", path, ok ? "已写入" : "拒绝");
+	}
+	return sizeof(*r);
+}
+
+/**
+ * 切换场景：记下场景名后交给LVGL任务
+ */
+uint8_t FleetServer::opScene(const uint8_t* payload, uint16_t len)
+{
+	if (len < 2 || payload[len - 1] != '\0' || len - 1 > SCENE_INDEX_NAME_MAX) return FLEET_ERR_FORMAT;
+	const char* scene = (const char*)payload + 1;
+	if (strchr(scene, '/') || strstr(scene, "..")) return FLEET_ERR_FORMAT;
+	if (scene_cb == NULL) return FLEET_ERR_BUSY;
+
+	portENTER_CRITICAL(&scene_lock);
+	strlcpy(scene_name, scene, sizeof(scene_name));
+	scene_fps = payload[0];
+	portEXIT_CRITICAL(&scene_lock);
+	return runtime.post(sceneMsg, this) ? FLEET_OK : FLEET_ERR_BUSY;
+}
+
+void FleetServer::sceneMsg(const UiMsg* msg)
+{
+	FleetServer* self = (FleetServer*)msg->obj;
+	char scene[SCENE_INDEX_NAME_MAX];
+	portENTER_CRITICAL(&self->scene_lock);
+	memcpy(scene, self->scene_name, sizeof(scene));
+	uint8_t fps = self->scene_fps;
+	portEXIT_CRITICAL(&self->scene_lock);
+	LOG_I("fleet", "切换场景: %s", scene[0] ? scene : "（停止）");
+	self->scene_cb(scene, fps, self->scene_user);
+}
+
+/**
+ * 与上传服务相同的路径限制
+ */
+bool FleetServer::validPath(const char* path)
+{
+	return strncmp(path, UPLOAD_ROOT, strlen(UPLOAD_ROOT)) == 0 && strstr(path, "..") == NULL &&
+		path[strlen(path) - 1] != '/';
+}
+
+/**
+ * 比较一批文件：回复uint8_t条数 + 位图，第i条需要上传时第i位为1
+ * 大小不同时不查清单；大小相同时按清单的整文件CRC比较（只有修改过的文件才会被读取）
+ */
+uint16_t FleetServer::opSync(const uint8_t* payload, uint16_t len, uint8_t* out, uint8_t* status)
+{
+	uint8_t count = 0;
+	uint8_t* bits = out + 1;
+	memset(bits, 0, (FLEET_SYNC_MAX + 7) / 8);
+	const uint8_t* p = payload;
+	const uint8_t* end = payload + len;
+	while (p < end)
+	{
+		FleetSyncEntry e;
+		const char* path = (const char*)p + sizeof(e);
+		if (count >= FLEET_SYNC_MAX || end - p <= (int)sizeof(e) ||
+			memchr(path, '\0', end - (const uint8_t*)path) == NULL)
+		{
+			*status = FLEET_ERR_FORMAT;
+			break;
+		}
+		memcpy(&e, p, sizeof(e));
+		p = (const uint8_t*)path + strlen(path) + 1;
+
+		bool same = false;
+		if (validPath(path))
+		{
+			File f = SD_FS.open(path);
+			bool size_ok = f && !f.isDirectory() && f.size() == e.size;
+			if (f) f.close();
+			SceneManifestEntry m;
+			same = size_ok && SceneManifest::lookup(path, &m) && m.crc32 == e.crc32;
+		}
+		if (!same) bits[count / 8] |= 1 << (count % 8);
+		count++;
+	}
+	out[0] = count;
+	return 1 + (count + 7) / 8;
+}
+
+/**
+ * 取文件的块CRC：回复FleetChunks + 从first开始的最多FLEET_CHUNKS_MAX块
+ */
+uint16_t FleetServer::opChunks(const uint8_t* payload, uint16_t len, uint8_t* out, uint8_t* status)
+{
+	uint16_t first;
+	const char* path = (const char*)payload + sizeof(first);
+	SceneManifestEntry m;
+	if (len <= sizeof(first) || payload[len - 1] != '\0' || !validPath(path) || !SceneManifest::lookup(path, &m))
+	{
+		*status = FLEET_ERR_FORMAT;
+		return 0;
+	}
+	memcpy(&first, payload, sizeof(first));
+
+	FleetChunks* c = (FleetChunks*)out;
+	memset(c, 0, sizeof(*c));
+	c->size = m.size;
+	c->crc32 = m.crc32;
+	c->chunk_size = SCENE_MANIFEST_CHUNK;
+	c->chunk_count = m.chunk_count;
+	c->first = first;
+	if (first < m.chunk_count)
+	{
+		c->n = m.chunk_count - first < FLEET_CHUNKS_MAX ? m.chunk_count - first : FLEET_CHUNKS_MAX;
+		if (!SceneManifest::readChunks(&m, first, c->n, (uint32_t*)(out + sizeof(*c))))
+		{
+			*status = FLEET_ERR_BUSY;
+			return 0;
+		}
+	}
+	return sizeof(*c) + c->n * 4;
+}
+
+/**
+ * 处理一个请求，返回回复载荷长度
+ */
+uint16_t FleetServer::handle(const FleetHeader* h, const uint8_t* payload, uint8_t* out, uint8_t* status)
+{
+	*status = FLEET_OK;
+	switch (h->op)
+	{
+	case FLEET_OP_STATUS:
+		return opStatus(out);
+	case FLEET_OP_CONFIG:
+		return opConfig(payload, h->len, out, status);
+	case FLEET_OP_SCENE:
+		*status = opScene(payload, h->len);
+		return 0;
+	case FLEET_OP_SYNC:
+		return opSync(payload, h->len, out, status);
+	case FLEET_OP_CHUNKS:
+		return opChunks(payload, h->len, out, status);
+	case FLEET_OP_RESTART:
+		return 0;
+	default:
+		*status = FLEET_ERR_OP;
+		return 0;
+	}
+}
+
+/**
+ * 接收任务：一个请求一个回复，回复发往请求的来源地址
+ */
+void FleetServer::taskEntry(void* arg)
+{
+	FleetServer* self = (FleetServer*)arg;
+	static uint8_t rx[FLEET_PKT_MAX];
+	static uint8_t tx[FLEET_PKT_MAX];
+
+	while (self->running)
+	{
+		sockaddr_in from;
+		socklen_t from_len = sizeof(from);
+		int n = recvfrom(self->sock, rx, sizeof(rx), 0, (sockaddr*)&from, &from_len);
+		if (n < (int)sizeof(FleetHeader)) continue;
+
+		const FleetHeader* h = (const FleetHeader*)rx;
+		if (h->magic[0] != FLEET_MAGIC0 || h->magic[1] != FLEET_MAGIC1 || h->version != FLEET_VERSION ||
+			(h->op & FLEET_REPLY)) continue;
+		bool write = h->op != FLEET_OP_STATUS;
+		if ((int)(sizeof(FleetHeader) + h->len + (write ? FLEET_TAG_LEN : 0)) > n) continue;
+
+		const uint8_t* payload = rx + sizeof(FleetHeader);
+		FleetHeader* r = (FleetHeader*)tx;
+		*r = *h;
+		r->op = h->op | FLEET_REPLY;
+		r->session = self->session;
+		r->len = 0;
+		if (write && !self->authorize(h, payload))
+		{
+			r->status = FLEET_ERR_AUTH;
+		}
+		else
+		{
+			r->len = self->handle(h, payload, tx + sizeof(FleetHeader), &r->status);
+		}
+		sendto(self->sock, tx, sizeof(FleetHeader) + r->len, 0, (sockaddr*)&from, from_len);
+
+		if (h->op == FLEET_OP_RESTART && r->status == FLEET_OK)
+		{
+			LOG_W("fleet", "收到重启请求");
+			vTaskDelay(pdMS_TO_TICKS(200));
+			ESP.restart();
+		}
+	}
+
+	self->task = NULL;
+	vTaskDelete(NULL);
+}
@@ -0,0 +1,343 @@
+/*
+ * HoloCubic 编码器焦点导航
+ *
+ * 功能说明：
+ * 1. 每个屏幕一个LVGL分组，分组中只有0尺寸的代理对象（编辑模式），编码器的左右都作为LV_KEY_LEFT/RIGHT交给代理
+ * 2. 代理的事件回调在本屏幕的对象数组中移动下标，按下、长按等原样转发给当前对象
+ * 3. 焦点框为屏幕上几条细长的纯色矩形，焦点变化时只移动焦点框（可带动画），被聚焦对象不重绘
+ *
+ * 数据流：
+ *   倾斜 --> lv_port_indev --> 分组（编辑模式） --> proxyCb：LV_EVENT_KEY --> step --> select --> moveTo --> animCb --> place
+ */
+
+#include "focus_nav.h"
+#include "lv_port_indev.h"
+
+/**
+ * 代理对象的扩展数据：指回所属的FocusScope
+ */
+struct FocusExt
+{
+	FocusScope* owner;
+};
+
+FocusScope::FocusScope()
+{
+	scr = NULL;
+	proxy = NULL;
+	group = NULL;
+	prev_group = NULL;
+	attached = false;
+	edge_count = 0;
+	for (uint8_t i = 0; i < 4; i++) edges[i] = NULL;
+	count = 0;
+	index = -1;
+}
+
+bool FocusScope::create(lv_obj_t* s, lv_color_t color, FocusStyle style)
+{
+	if (proxy) return false;
+	scr = s;
+
+	proxy = lv_obj_create(scr, NULL);
+	if (proxy == NULL) return false;
+	FocusExt* ext = (FocusExt*)lv_obj_allocate_ext_attr(proxy, sizeof(FocusExt));
+	if (ext == NULL)
+	{
+		lv_obj_del(proxy);
+		proxy = NULL;
+		return false;
+	}
+	ext->owner = this;
+	// 0尺寸、不可点击：获得LV_STATE_FOCUSED时的样式变化没有可重绘的面积
+	lv_obj_set_size(proxy, 0, 0);
+	lv_obj_set_click(proxy, false);
+	lv_obj_set_event_cb(proxy, proxyCb);
+
+	group = lv_group_create();
+	lv_group_add_obj(group, proxy);
+	lv_group_set_editing(group, true);
+
+	// 焦点框：无边框、无圆角、无阴影的纯色矩形，失效区域就是矩形本身
+	edge_count = style == FOCUS_UNDERLINE ? 1 : 4;
+	for (uint8_t i = 0; i < edge_count; i++)
+	{
+		lv_obj_t* e = lv_obj_create(scr, NULL);
+		lv_obj_set_click(e, false);
+		lv_obj_set_style_local_radius(e, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 0);
+		lv_obj_set_style_local_border_width(e, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 0);
+		lv_obj_set_style_local_shadow_width(e, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 0);
+		lv_obj_set_style_local_outline_width(e, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 0);
+		lv_obj_set_style_local_bg_opa(e, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_COVER);
+		lv_obj_set_style_local_bg_color(e, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, color);
+		lv_obj_set_hidden(e, true);
+		edges[i] = e;
+	}
+	count = 0;
+	index = -1;
+	return true;
+}
+
+void FocusScope::destroy()
+{
+	lv_anim_del(this, animCb);
+	for (uint8_t i = 0; i < edge_count; i++)
+	{
+		if (edges[i]) lv_obj_del(edges[i]);
+		edges[i] = NULL;
+	}
+	edge_count = 0;
+	// 删除代理时proxyCb释放分组并恢复编码器
+	if (proxy) lv_obj_del(proxy);
+	count = 0;
+	index = -1;
+	scr = NULL;
+}
+
+bool FocusScope::add(lv_obj_t* obj)
+{
+	if (proxy == NULL || count >= FOCUS_MAX_ITEMS) return false;
+	items[count++] = obj;
+	return true;
+}
+
+void FocusScope::remove(lv_obj_t* obj)
+{
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (items[i] != obj) continue;
+		memmove(&items[i], &items[i + 1], (count - i - 1) * sizeof(items[0]));
+		count--;
+		if (index == i)
+		{
+			// 焦点移到原来的下一个对象（删除的是最后一个时移到新的最后一个）
+			index = -1;
+			if (count) select(i < count ? i : count - 1, false);
+			else moveTo(false);
+		}
+		else if (index > i)
+		{
+			index--;
+		}
+		return;
+	}
+}
+
+void FocusScope::attach()
+{
+	if (proxy == NULL || indev_encoder == NULL) return;
+	if (!attached)
+	{
+		prev_group = indev_encoder->group;
+		attached = true;
+	}
+	lv_indev_set_group(indev_encoder, group);
+	// 焦点框画在本屏幕所有对象之上
+	for (uint8_t i = 0; i < edge_count; i++) lv_obj_move_foreground(edges[i]);
+	if (index < 0 && count) step(1);
+}
+
+void FocusScope::detach()
+{
+	if (!attached) return;
+	if (indev_encoder && indev_encoder->group == group) lv_indev_set_group(indev_encoder, prev_group);
+	attached = false;
+	prev_group = NULL;
+}
+
+/**
+ * 对象i的焦点框位置（屏幕坐标，向外扩FOCUS_PAD与线宽）；对象隐藏时返回false
+ */
+bool FocusScope::target(uint8_t i, lv_area_t* area)
+{
+	if (lv_obj_get_hidden(items[i])) return false;
+	lv_area_t s;
+	lv_obj_get_coords(scr, &s);
+	lv_obj_get_coords(items[i], area);
+	lv_coord_t pad = FOCUS_PAD + FOCUS_EDGE_W;
+	area->x1 -= s.x1 + pad;
+	area->x2 -= s.x1 - pad;
+	area->y1 -= s.y1 + pad;
+	area->y2 -= s.y1 - pad;
+	return true;
+}
+
+/**
+ * 把焦点框放到area：位置、尺寸没有变化的边不失效
+ */
+void FocusScope::place(const lv_area_t* a)
+{
+	shown = *a;
+	lv_coord_t w = lv_area_get_width(a);
+	lv_coord_t h = lv_area_get_height(a);
+	lv_coord_t e = FOCUS_EDGE_W;
+	// 下、上、左、右（FOCUS_UNDERLINE只有第一条）
+	const lv_coord_t rect[4][4] = {
+		{ a->x1, (lv_coord_t)(a->y2 - e + 1), w, e },
+		{ a->x1, a->y1, w, e },
+		{ a->x1, (lv_coord_t)(a->y1 + e), e, (lv_coord_t)(h - 2 * e) },
+		{ (lv_coord_t)(a->x2 - e + 1), (lv_coord_t)(a->y1 + e), e, (lv_coord_t)(h - 2 * e) },
+	};
+	for (uint8_t i = 0; i < edge_count; i++)
+	{
+		lv_obj_set_pos(edges[i], rect[i][0], rect[i][1]);
+		lv_obj_set_size(edges[i], rect[i][2], LV_MATH_MAX(rect[i][3], 0));
+		if (lv_obj_get_hidden(edges[i])) lv_obj_set_hidden(edges[i], false);
+	}
+}
+
+/**
+ * 焦点框移到当前对象：焦点框原来隐藏或不需要动画时直接放置
+ */
+void FocusScope::moveTo(bool animate)
+{
+	lv_anim_del(this, animCb);
+	if (edge_count == 0) return;
+	if (index < 0 || !target(index, &to))
+	{
+		for (uint8_t i = 0; i < edge_count; i++) lv_obj_set_hidden(edges[i], true);
+		return;
+	}
+	if (!animate || FOCUS_ANIM_MS == 0 || lv_obj_get_hidden(edges[0]))
+	{
+		place(&to);
+		return;
+	}
+	from = shown;
+	lv_anim_t a;
+	lv_anim_init(&a);
+	lv_anim_set_var(&a, this);
+	lv_anim_set_exec_cb(&a, animCb);
+	lv_anim_set_values(&a, 0, 256);
+	lv_anim_set_time(&a, FOCUS_ANIM_MS);
+	lv_anim_path_t path;
+	lv_anim_path_init(&path);
+	lv_anim_path_set_cb(&path, lv_anim_path_ease_out);
+	lv_anim_set_path(&a, &path);
+	lv_anim_start(&a);
+}
+
+void FocusScope::animCb(void* var, lv_anim_value_t v)
+{
+	FocusScope* f = (FocusScope*)var;
+	lv_area_t a;
+	a.x1 = f->from.x1 + (f->to.x1 - f->from.x1) * v / 256;
+	a.y1 = f->from.y1 + (f->to.y1 - f->from.y1) * v / 256;
+	a.x2 = f->from.x2 + (f->to.x2 - f->from.x2) * v / 256;
+	a.y2 = f->from.y2 + (f->to.y2 - f->from.y2) * v / 256;
+	f->place(&a);
+}
+
+/**
+ * 焦点改为对象i：通知新旧对象（只发事件，不改变对象状态），移动焦点框
+ */
+void FocusScope::select(int8_t i, bool animate)
+{
+	int8_t old = index;
+	index = i;
+	if (old >= 0 && old != i) lv_event_send(items[old], LV_EVENT_DEFOCUSED, NULL);
+	moveTo(animate);
+	if (i >= 0 && old != i) lv_event_send(items[i], LV_EVENT_FOCUSED, NULL);
+}
+
+/**
+ * 上一个/下一个：下标加减1，只有遇到隐藏对象时才继续查找
+ */
+void FocusScope::step(int8_t dir)
+{
+	int16_t i = index < 0 && dir < 0 ? count : index;
+	for (uint8_t n = 0; n < count; n++)
+	{
+		i += dir;
+		if (i < 0 || i >= count)
+		{
+			if (!FOCUS_WRAP && index >= 0) return;
+			i = i < 0 ? count - 1 : 0;
+		}
+		if (!lv_obj_get_hidden(items[i]))
+		{
+			select(i, index >= 0);
+			return;
+		}
+	}
+}
+
+void FocusScope::next()
+{
+	step(1);
+}
+
+void FocusScope::prev()
+{
+	step(-1);
+}
+
+bool FocusScope::focus(lv_obj_t* obj, bool animate)
+{
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (items[i] != obj) continue;
+		select(i, animate);
+		return true;
+	}
+	return false;
+}
+
+lv_obj_t* FocusScope::getFocused()
+{
+	return index >= 0 ? items[index] : NULL;
+}
+
+int8_t FocusScope::getIndex()
+{
+	return index;
+}
+
+void FocusScope::refresh()
+{
+	moveTo(false);
+}
+
+/**
+ * 代理对象的事件：左右移动焦点，其余转发给当前对象
+ */
+void FocusScope::proxyCb(lv_obj_t* obj, lv_event_t event)
+{
+	FocusExt* ext = (FocusExt*)lv_obj_get_ext_attr(obj);
+	FocusScope* f = ext->owner;
+
+	switch (event)
+	{
+	case LV_EVENT_KEY:
+	{
+		uint32_t key = *(const uint32_t*)lv_event_get_data();
+		if (key == LV_KEY_RIGHT || key == LV_KEY_DOWN) f->next();
+		else if (key == LV_KEY_LEFT || key == LV_KEY_UP) f->prev();
+		else if (f->index >= 0) lv_event_send(f->items[f->index], LV_EVENT_KEY, &key);
+		break;
+	}
+	case LV_EVENT_PRESSED:
+	case LV_EVENT_SHORT_CLICKED:
+	case LV_EVENT_CLICKED:
+	case LV_EVENT_LONG_PRESSED:
+	case LV_EVENT_LONG_PRESSED_REPEAT:
+	case LV_EVENT_RELEASED:
+	case LV_EVENT_CANCEL:
+		if (f->index >= 0) lv_event_send(f->items[f->index], event, NULL);
+		break;
+	case LV_EVENT_DELETE:
+		// 屏幕删除（或destroy）：焦点框随屏幕删除，这里停止动画、恢复编码器并释放分组
+		lv_anim_del(f, animCb);
+		f->detach();
+		if (f->group) lv_group_del(f->group);
+		f->group = NULL;
+		f->proxy = NULL;
+		for (uint8_t i = 0; i < 4; i++) f->edges[i] = NULL;
+		f->edge_count = 0;
+		f->count = 0;
+		f->index = -1;
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,363 @@
+/*
+ * HoloCubic 手势识别引擎
+ *
+ * 功能说明：
+ * 1. 对加速度/角速度做逐轴滤波，得到倾斜、冲击、晃动三类信号
+ * 2. 按规则表运行状态机，识别左/右/前/后倾斜、晃动和双击
+ * 3. 滞回阈值与不应期避免抖动误触发，识别结果排队送入LVGL编码器
+ * 4. 左右倾斜滚动：速率随倾斜角度与保持时间增加，回正后惯性滑行，多步合并为一个编码器事件
+ *
+ * 状态机（每条规则独立）：
+ *   空闲 --信号>=enter--> 预备 --持续hold_ms--> 触发（产生开始事件）
+ *   预备/触发 --信号<exit--> 空闲（触发过的产生结束事件并进入不应期）
+ */
+
+#include "gesture.h"
+
+/**
+ * 默认规则表
+ * 倾斜阈值沿用原有手势（Y轴3000、X轴10000，约0.18g/0.6g），退出阈值取一半左右做滞回
+ */
+static const GestureRule default_rules[] = {
+	// 类型                  信号                  进入    退出   保持  重复  不应期
+	{ GESTURE_TILT_LEFT,    GESTURE_SIG_AY,        3000,  1500,  60,  400,  150 },
+	{ GESTURE_TILT_RIGHT,   GESTURE_SIG_AY,       -3000, -1500,  60,  400,  150 },
+	{ GESTURE_TILT_FORWARD, GESTURE_SIG_AX,       10000,  7000,  80,    0,  300 },
+	{ GESTURE_TILT_BACK,    GESTURE_SIG_AX,      -10000, -7000,  80,    0,  300 },
+	{ GESTURE_SHAKE,        GESTURE_SIG_ROTATION, 20000,  8000, 150,    0, 1000 },
+	{ GESTURE_TAP,          GESTURE_SIG_JERK,      9000,  4000,   0,    0,   80 },
+};
+
+static const char* const type_names[GESTURE_TYPE_COUNT] = {
+	"none", "tilt_left", "tilt_right", "tilt_forward", "tilt_back", "shake", "tap", "double_tap"
+};
+
+const char* gesture_name(GestureType type)
+{
+	return type < GESTURE_TYPE_COUNT ? type_names[type] : "unknown";
+}
+
+GestureType gesture_from_name(const char* name)
+{
+	for (uint8_t i = 1; i < GESTURE_TYPE_COUNT; i++)
+	{
+		if (strcmp(name, type_names[i]) == 0) return (GestureType)i;
+	}
+	return GESTURE_NONE;
+}
+
+GestureEngine::GestureEngine()
+{
+	cb = NULL;
+	cb_user = NULL;
+	// 不随init()复位：替换规则表后敲击仍由IMU送入
+	external_tap = false;
+	init();
+}
+
+/**
+ * 初始化引擎
+ *
+ * @param table 规则表，NULL时使用默认规则
+ * @param count 规则条数（超过GESTURE_MAX_RULES的部分忽略）
+ */
+void GestureEngine::init(const GestureRule* table, uint8_t count)
+{
+	if (table == NULL)
+	{
+		table = default_rules;
+		count = sizeof(default_rules) / sizeof(default_rules[0]);
+	}
+	rules = table;
+	rule_count = count > GESTURE_MAX_RULES ? GESTURE_MAX_RULES : count;
+
+	for (uint8_t i = 0; i < GESTURE_MAX_RULES; i++)
+	{
+		state[i] = RULE_IDLE;
+		since[i] = 0;
+		blocked[i] = 0;
+	}
+	primed = false;
+	last_tap = 0;
+	to_encoder = true;
+	enc_state = LV_INDEV_STATE_REL;
+
+	scroll_accel = true;
+	scroll_dir = 0;
+	scroll_vel = 0;
+	scroll_frac = 0;
+	scroll_pending = 0;
+	scroll_since = 0;
+	scroll_last = 0;
+	scroll_pushed = 0;
+}
+
+/**
+ * 输入一个样本（在传感器任务中调用）
+ *
+ * @param now 样本时间（毫秒），批量读出时由调用方按采样间隔推算
+ */
+void GestureEngine::feed(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz, uint32_t now)
+{
+	filter(ax, ay, az, gx, gy, gz);
+	for (uint8_t i = 0; i < rule_count; i++)
+	{
+		if (external_tap && rules[i].type == GESTURE_TAP) continue;
+		step(i, now);
+	}
+	if (to_encoder && scroll_accel) scroll(now);
+}
+
+/**
+ * 逐轴滤波
+ * 低通分量用于倾斜判断；原始值减去低通分量即高通分量，用于敲击冲击判断
+ */
+void GestureEngine::filter(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz)
+{
+	int32_t rot = abs(gx) + abs(gy) + abs(gz);
+
+	// 第一个样本直接作为初值，避免上电时从0爬升引起误触发
+	if (!primed)
+	{
+		lpf_ax = ax;
+		lpf_ay = ay;
+		lpf_az = az;
+		lpf_rot = rot;
+		primed = true;
+	}
+
+	int32_t hx = ax - lpf_ax;
+	int32_t hy = ay - lpf_ay;
+	int32_t hz = az - lpf_az;
+
+	lpf_ax += (ax - lpf_ax) >> GESTURE_LPF_SHIFT;
+	lpf_ay += (ay - lpf_ay) >> GESTURE_LPF_SHIFT;
+	lpf_az += (az - lpf_az) >> GESTURE_LPF_SHIFT;
+	lpf_rot += (rot - lpf_rot) >> GESTURE_LPF_SHIFT;
+
+	signals[GESTURE_SIG_AX] = lpf_ax;
+	signals[GESTURE_SIG_AY] = lpf_ay;
+	signals[GESTURE_SIG_JERK] = abs(hx) + abs(hy) + abs(hz);
+	signals[GESTURE_SIG_ROTATION] = lpf_rot;
+}
+
+/**
+ * 运行第i条规则的状态机
+ */
+void GestureEngine::step(uint8_t i, uint32_t now)
+{
+	const GestureRule& r = rules[i];
+
+	// 负阈值的规则把信号取反，统一按"大于"比较
+	int32_t v = signals[r.signal];
+	int32_t enter = r.enter;
+	int32_t exit = r.exit;
+	if (r.enter < 0)
+	{
+		v = -v;
+		enter = -enter;
+		exit = -exit;
+	}
+
+	switch (state[i])
+	{
+	case RULE_IDLE:
+		if (v < enter || (int32_t)(now - blocked[i]) < 0) break;
+		state[i] = RULE_ARMED;
+		since[i] = now;
+		// hold_ms为0时同一样本内立即触发
+		// fall through
+	case RULE_ARMED:
+		if (v < exit)
+		{
+			state[i] = RULE_IDLE;
+		}
+		else if (now - since[i] >= r.hold_ms)
+		{
+			state[i] = RULE_ACTIVE;
+			since[i] = now;
+			emit(r.type, true, now);
+		}
+		break;
+
+	case RULE_ACTIVE:
+		if (v < exit)
+		{
+			state[i] = RULE_IDLE;
+			blocked[i] = now + r.refractory_ms;
+			emit(r.type, false, now);
+		}
+		else if (r.repeat_ms && now - since[i] >= r.repeat_ms)
+		{
+			since[i] = now;
+			emit(r.type, true, now);
+		}
+		break;
+	}
+}
+
+/**
+ * 分发事件；单击在这里组合为双击
+ */
+void GestureEngine::emit(GestureType type, bool active, uint32_t now)
+{
+	GestureEvent ev = { type, active, now };
+
+	if (to_encoder) toEncoder(&ev);
+	if (cb) cb(&ev, cb_user);
+
+	if (type == GESTURE_TAP && active)
+	{
+		if (last_tap != 0 && now - last_tap <= GESTURE_DOUBLE_TAP_MS)
+		{
+			last_tap = 0;
+			emit(GESTURE_DOUBLE_TAP, true, now);
+		}
+		else
+		{
+			last_tap = now;
+		}
+	}
+}
+
+/**
+ * 手势到编码器事件的映射
+ * 左右倾斜→旋转一格（保持时加速滚动，或按规则周期重复），前倾保持→按下/回正→释放（支持长按），双击→一次点击
+ */
+void GestureEngine::toEncoder(const GestureEvent* ev)
+{
+	switch (ev->type)
+	{
+	case GESTURE_TILT_LEFT:
+	case GESTURE_TILT_RIGHT:
+	{
+		int8_t dir = ev->type == GESTURE_TILT_RIGHT ? 1 : -1;
+		if (!scroll_accel)
+		{
+			if (ev->active) lv_port_indev_push(dir, enc_state, ev->time);
+			break;
+		}
+		if (!ev->active)
+		{
+			if (scroll_dir == dir) scroll_dir = 0;
+			break;
+		}
+		// 保持期间的重复事件由scroll()按速率代替
+		if (scroll_dir == dir) break;
+		// 开始倾斜：立即走一格；反向倾斜时先停止滑行
+		if (scroll_vel * dir < 0) scroll_vel = 0;
+		scroll_dir = dir;
+		scroll_since = ev->time;
+		scroll_frac = 0;
+		lv_port_indev_push(dir, enc_state, ev->time);
+		break;
+	}
+	case GESTURE_TILT_FORWARD:
+		// 按下时停止滑行，还没写入的步数先交付
+		if (ev->active)
+		{
+			if (scroll_pending) lv_port_indev_push(scroll_pending, enc_state, ev->time);
+			scroll_pending = 0;
+			scroll_vel = 0;
+			scroll_frac = 0;
+		}
+		enc_state = ev->active ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+		lv_port_indev_push(0, enc_state, ev->time);
+		break;
+	case GESTURE_DOUBLE_TAP:
+		if (enc_state == LV_INDEV_STATE_PR) break;
+		lv_port_indev_push(0, LV_INDEV_STATE_PR, ev->time);
+		lv_port_indev_push(0, LV_INDEV_STATE_REL, ev->time);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * 倾斜滚动（每个样本调用一次）
+ * 目标速率由当前倾斜量与保持时间决定，速度按一阶惯性跟随目标：回正后目标为0，速度按摩擦时间常数衰减。
+ * 速度对时间积分得到步数，每GESTURE_SCROLL_PERIOD_MS最多写入一个多步编码器事件
+ */
+void GestureEngine::scroll(uint32_t now)
+{
+	uint32_t dt = now - scroll_last;
+	scroll_last = now;
+	if (scroll_dir == 0 && scroll_vel == 0 && scroll_pending == 0) return;
+	// 样本中断（挂起、批量读取）后不按整段间隔积分
+	if (dt > 100) dt = 100;
+
+	int32_t target = 0;
+	if (scroll_dir)
+	{
+		// 右倾时Y轴加速度为负
+		int32_t over = -signals[GESTURE_SIG_AY] * scroll_dir - GESTURE_SCROLL_TILT_MIN;
+		if (over < 0) over = 0;
+		int32_t rate = GESTURE_SCROLL_MIN_RATE + over * GESTURE_SCROLL_TILT_RATE / GESTURE_SCROLL_TILT_SPAN;
+		uint32_t held = now - scroll_since;
+		if (held > (GESTURE_SCROLL_ACCEL_MAX - 1) * GESTURE_SCROLL_ACCEL_MS) held = (GESTURE_SCROLL_ACCEL_MAX - 1) * GESTURE_SCROLL_ACCEL_MS;
+		rate = rate * (int32_t)(GESTURE_SCROLL_ACCEL_MS + held) / GESTURE_SCROLL_ACCEL_MS;
+		if (rate > GESTURE_SCROLL_MAX_RATE) rate = GESTURE_SCROLL_MAX_RATE;
+		target = (rate * scroll_dir) << 8;
+	}
+
+	int32_t tau = scroll_dir && abs(target) >= abs(scroll_vel) ? GESTURE_SCROLL_RISE_MS : GESTURE_SCROLL_FRICTION_MS;
+	scroll_vel += (target - scroll_vel) * (int32_t)dt / tau;
+	if (scroll_dir == 0 && abs(scroll_vel) < (GESTURE_SCROLL_STOP_RATE << 8))
+	{
+		scroll_vel = 0;
+		scroll_frac = 0;
+	}
+
+	// 一格为10（0.1格/秒）* 1000ms
+	scroll_frac += (scroll_vel >> 8) * (int32_t)dt;
+	int32_t steps = scroll_frac / 10000;
+	scroll_frac -= steps * 10000;
+	scroll_pending += steps;
+
+	if (scroll_pending && now - scroll_pushed >= GESTURE_SCROLL_PERIOD_MS)
+	{
+		// 缓冲区满时保留步数，下个周期再写
+		if (lv_port_indev_push(scroll_pending, enc_state, now)) scroll_pending = 0;
+		scroll_pushed = now;
+	}
+}
+
+/**
+ * 外部检测到的敲击（IMU的1kHz采集窗口分类结果），两次在GESTURE_DOUBLE_TAP_MS内时组合为双击
+ */
+void GestureEngine::tap(uint32_t now)
+{
+	emit(GESTURE_TAP, true, now);
+}
+
+void GestureEngine::setExternalTap(bool enable)
+{
+	external_tap = enable;
+}
+
+/**
+ * 注册手势监听者（回调在传感器任务中执行，操作界面需通过runtime.post）
+ */
+void GestureEngine::setCallback(gesture_cb_t callback, void* user)
+{
+	cb = callback;
+	cb_user = user;
+}
+
+/**
+ * 是否把手势转换为LVGL编码器事件（应用自行处理手势时可关闭）
+ */
+void GestureEngine::setEncoderOutput(bool enable)
+{
+	to_encoder = enable;
+}
+
+void GestureEngine::setScrollAccel(bool enable)
+{
+	scroll_accel = enable;
+	scroll_dir = 0;
+	scroll_vel = 0;
+	scroll_frac = 0;
+	scroll_pending = 0;
+}
@@ -0,0 +1,152 @@
+/*
+ * HoloCubic 手势回放评估
+ *
+ * 功能说明：
+ * 1. 按.imt记录的时间间隔重建样本时间，逐条送入手势引擎
+ * 2. 标注记录（IMU_TRACE_LABEL）保存为“期望在窗口内识别到某手势”
+ * 3. 结束时把识别结果与标注逐一匹配，统计延迟、漏检与误触发
+ *
+ * 固件（imu_trace.cpp从SD卡读取）与主机端LvglBench（--gesture）共用，
+ * 调整规则表后可以用同一批轨迹离线、可重复地比较
+ */
+
+#include "gesture_replay.h"
+
+/**
+ * 开始一次回放
+ *
+ * @param start_ms 轨迹头中的start_ms
+ * @param rules    规则表，NULL时使用默认规则
+ */
+void GestureReplay::begin(uint32_t start_ms, const GestureRule* rules, uint8_t count)
+{
+	engine.init(rules, count);
+	engine.setEncoderOutput(false);
+	engine.setCallback(onEvent, this);
+
+	label_count = 0;
+	event_count = 0;
+	dropped = 0;
+	memset(active, 0, sizeof(active));
+	now = start_ms;
+	start = start_ms;
+	samples = 0;
+}
+
+/**
+ * 送入一条记录（样本或标注）
+ */
+void GestureReplay::feed(const ImuTraceRecord* r)
+{
+	if (r->dt_ms == IMU_TRACE_LABEL)
+	{
+		if (r->v[0] <= GESTURE_NONE || r->v[0] >= GESTURE_TYPE_COUNT) return;
+		if (label_count >= GESTURE_REPLAY_MAX_LABELS)
+		{
+			dropped++;
+			return;
+		}
+		Label* l = &labels[label_count++];
+		l->time = now;
+		l->window = (uint16_t)r->v[1];
+		l->type = (uint8_t)r->v[0];
+		l->hit = false;
+		return;
+	}
+
+	now += r->dt_ms;
+	samples++;
+	engine.feed(r->v[0], r->v[1], r->v[2], r->v[3], r->v[4], r->v[5], now);
+}
+
+/**
+ * 手势引擎回调：只记录每次激活的开始
+ * 持续型手势在结束事件之前的重复事件忽略；双击没有结束事件，每次都算一次激活
+ */
+void GestureReplay::onEvent(const GestureEvent* ev, void* user)
+{
+	GestureReplay* self = (GestureReplay*)user;
+	if (!ev->active)
+	{
+		self->active[ev->type] = false;
+		return;
+	}
+	if (self->active[ev->type]) return;
+	if (ev->type != GESTURE_DOUBLE_TAP) self->active[ev->type] = true;
+
+	if (self->event_count >= GESTURE_REPLAY_MAX_EVENTS)
+	{
+		self->dropped++;
+		return;
+	}
+	self->events[self->event_count++] = *ev;
+}
+
+/**
+ * t是否落在某个type类标注的窗口内
+ * @param label 输出第一个包含t的标注序号（优先尚未命中的）
+ */
+bool GestureReplay::inWindow(GestureType type, uint32_t t, int* label)
+{
+	int found = -1;
+	for (uint16_t i = 0; i < label_count; i++)
+	{
+		const Label* l = &labels[i];
+		if (l->type != type || (int32_t)(t - l->time) < 0 || t - l->time > l->window) continue;
+		if (!l->hit)
+		{
+			found = i;
+			break;
+		}
+		if (found < 0) found = i;
+	}
+	if (label) *label = found;
+	return found >= 0;
+}
+
+/**
+ * 匹配识别结果与标注，输出统计
+ */
+void GestureReplay::finish(GestureReplayReport* out)
+{
+	memset(out, 0, sizeof(*out));
+	out->samples = samples;
+	out->duration_ms = now - start;
+	out->labels = label_count;
+	out->events = event_count;
+	out->dropped = dropped;
+
+	for (uint16_t i = 0; i < label_count; i++) out->type[labels[i].type].labels++;
+
+	for (uint16_t i = 0; i < event_count; i++)
+	{
+		const GestureEvent* e = &events[i];
+		GestureReplayStats* s = &out->type[e->type];
+		int idx;
+		if (inWindow(e->type, e->time, &idx) && !labels[idx].hit)
+		{
+			uint32_t latency = e->time - labels[idx].time;
+			labels[idx].hit = true;
+			s->hits++;
+			s->latency_sum_ms += latency;
+			if (latency > s->latency_max_ms) s->latency_max_ms = latency;
+		}
+		else if (!(e->type == GESTURE_TAP && inWindow(GESTURE_DOUBLE_TAP, e->time, NULL)))
+		{
+			s->false_pos++;
+		}
+	}
+
+	for (uint16_t i = 0; i < label_count; i++)
+	{
+		if (!labels[i].hit) out->type[labels[i].type].misses++;
+	}
+}
+
+/**
+ * 最近一条样本的时间（毫秒）
+ */
+uint32_t GestureReplay::time()
+{
+	return now;
+}
@@ -0,0 +1,685 @@
+/*
+ * HoloCubic GIF动画控件
+ *
+ * 功能说明：
+ * 1. 文件通过LVGL文件系统顺序读取（GIF_READ_BUF字节的读缓冲），每帧从上一帧结束处继续，读到结尾块后回到第一帧
+ * 2. 图像数据边读子块边做LZW解码：字典为前缀码/末尾字节两张表（4096项，共12KB），
+ *    码值逆序展开到栈后按行（隔行扫描的GIF按四遍）写入画布，透明色索引不写
+ * 3. 下一帧开始前先处置上一帧的子矩形：2填充背景色，3恢复解码前保存的内容
+ * 4. 只让处置与新写入的子矩形失效；绘制回调用_lv_blend_map把画布复制到显示缓冲
+ *
+ * 数据流：
+ *   lv_task（周期为帧延时） --> nextFrame：扩展块 --> dispose --> decodeImage --> invalidate子矩形 --> designCb
+ */
+
+#include "gif_player.h"
+#include "buf_manager.h"
+#include "logger.h"
+
+static lv_signal_cb_t ancestor_signal = NULL;
+
+/**
+ * 控件的扩展数据：指回所属的GifPlayer
+ */
+struct GifPlayerExt
+{
+	GifPlayer* owner;
+};
+
+GifPlayer::GifPlayer()
+{
+	obj = NULL;
+	task = NULL;
+	file_open = false;
+	rbuf_pos = 0;
+	rpos = rlen = 0;
+	first_frame = 0;
+	w = h = 0;
+	canvas = NULL;
+	bg = LV_COLOR_BLACK;
+	has_gct = false;
+	prefix = NULL;
+	suffix = NULL;
+	stack = NULL;
+	next_disposal = 0;
+	next_transparent = -1;
+	next_delay = 0;
+	disposal = 0;
+	rect = { 0, 0, -1, -1 };
+	backup = NULL;
+	delay_ms = GIF_DEFAULT_DELAY_MS;
+	frames = 0;
+}
+
+/**
+ * 创建控件（大小在open时设为GIF的逻辑屏幕大小）
+ */
+bool GifPlayer::create(lv_obj_t* parent)
+{
+	if (obj) return false;
+
+	obj = lv_obj_create(parent, NULL);
+	if (obj == NULL) return false;
+	GifPlayerExt* ext = (GifPlayerExt*)lv_obj_allocate_ext_attr(obj, sizeof(GifPlayerExt));
+	if (ext == NULL)
+	{
+		lv_obj_del(obj);
+		obj = NULL;
+		return false;
+	}
+	ext->owner = this;
+
+	if (ancestor_signal == NULL) ancestor_signal = lv_obj_get_signal_cb(obj);
+	lv_obj_set_design_cb(obj, designCb);
+	lv_obj_set_signal_cb(obj, signalCb);
+	lv_obj_set_click(obj, false);
+	lv_obj_set_size(obj, 0, 0);
+	return true;
+}
+
+/**
+ * 删除控件，关闭文件并释放缓冲
+ */
+void GifPlayer::destroy()
+{
+	// 删除时的CLEANUP信号调用detach
+	if (obj) lv_obj_del(obj);
+}
+
+lv_obj_t* GifPlayer::getObj()
+{
+	return obj;
+}
+
+/**
+ * 打开GIF文件并显示第一帧（不开始播放）
+ * @param path LVGL路径，如"S:/anim/cat.gif"
+ * @return 控件未创建、文件无法打开、格式不支持、画布超过GIF_MAX_CANVAS_BYTES或内存不足时返回false
+ */
+bool GifPlayer::open(const char* path)
+{
+	if (obj == NULL) return false;
+
+	close();
+	if (lv_fs_open(&file, path, LV_FS_MODE_RD) != LV_FS_RES_OK)
+	{
+		LOG_W("gif", "无法打开: %s", path);
+		return false;
+	}
+	file_open = true;
+	rbuf_pos = 0;
+	rpos = rlen = 0;
+
+	if (!readHeader())
+	{
+		LOG_W("gif", "格式不支持: %s", path);
+		release();
+		return false;
+	}
+
+	uint32_t size = (uint32_t)w * h * sizeof(lv_color_t);
+	if (size > GIF_MAX_CANVAS_BYTES || (canvas = (lv_color_t*)buf_alloc(BUF_BULK, size)) == NULL ||
+		(prefix = (uint16_t*)buf_alloc(BUF_FAST, GIF_LZW_CODES * (sizeof(uint16_t) + 2))) == NULL)
+	{
+		LOG_W("gif", "缓冲分配失败: %d x %d", w, h);
+		release();
+		return false;
+	}
+	suffix = (uint8_t*)(prefix + GIF_LZW_CODES);
+	stack = suffix + GIF_LZW_CODES;
+	for (uint32_t i = 0; i < (uint32_t)w * h; i++) canvas[i] = bg;
+
+	lv_obj_set_size(obj, w, h);
+	lv_obj_invalidate(obj);
+	if (!nextFrame())
+	{
+		LOG_W("gif", "没有可解码的帧: %s", path);
+		release();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 停止播放、关闭文件并释放画布（控件保留，显示为空）
+ */
+void GifPlayer::close()
+{
+	stop();
+	release();
+	if (obj) lv_obj_invalidate(obj);
+}
+
+/**
+ * 按帧延时循环播放
+ */
+bool GifPlayer::play()
+{
+	if (canvas == NULL) return false;
+	if (task == NULL) task = lv_task_create(taskCb, delay_ms, LV_TASK_PRIO_MID, this);
+	return task != NULL;
+}
+
+/**
+ * 暂停在当前帧
+ */
+void GifPlayer::stop()
+{
+	if (task)
+	{
+		lv_task_del(task);
+		task = NULL;
+	}
+}
+
+/**
+ * 设置背景色：open时填充画布，以及处置方式2（恢复背景）使用的颜色
+ */
+void GifPlayer::setBackground(lv_color_t color)
+{
+	bg = color;
+}
+
+bool GifPlayer::isPlaying()
+{
+	return task != NULL;
+}
+
+/**
+ * 已解码的帧数（open时从1开始，循环播放时继续累加）
+ */
+uint32_t GifPlayer::getFrameCount()
+{
+	return frames;
+}
+
+uint16_t GifPlayer::getWidth()
+{
+	return w;
+}
+
+uint16_t GifPlayer::getHeight()
+{
+	return h;
+}
+
+void GifPlayer::release()
+{
+	if (file_open)
+	{
+		lv_fs_close(&file);
+		file_open = false;
+	}
+	if (canvas)
+	{
+		buf_free(canvas);
+		canvas = NULL;
+	}
+	if (backup)
+	{
+		buf_free(backup);
+		backup = NULL;
+	}
+	if (prefix)
+	{
+		buf_free(prefix);
+		prefix = NULL;
+		suffix = NULL;
+		stack = NULL;
+	}
+	w = h = 0;
+	frames = 0;
+	disposal = 0;
+	rect = { 0, 0, -1, -1 };
+}
+
+/**
+ * 控件已删除：停止播放并释放缓冲
+ */
+void GifPlayer::detach()
+{
+	stop();
+	release();
+	obj = NULL;
+}
+
+uint32_t GifPlayer::tell()
+{
+	return rbuf_pos + rpos;
+}
+
+/**
+ * 定位到文件偏移：目标在读缓冲内时只移动读指针
+ */
+bool GifPlayer::seek(uint32_t pos)
+{
+	if (pos >= rbuf_pos && pos < rbuf_pos + rlen)
+	{
+		rpos = pos - rbuf_pos;
+		return true;
+	}
+	rbuf_pos = pos;
+	rpos = rlen = 0;
+	return lv_fs_seek(&file, pos) == LV_FS_RES_OK;
+}
+
+bool GifPlayer::readByte(uint8_t* out)
+{
+	if (rpos >= rlen)
+	{
+		uint32_t br = 0;
+		rbuf_pos += rlen;
+		rpos = rlen = 0;
+		if (lv_fs_read(&file, rbuf, GIF_READ_BUF, &br) != LV_FS_RES_OK || br == 0) return false;
+		rlen = br;
+	}
+	*out = rbuf[rpos++];
+	return true;
+}
+
+bool GifPlayer::readBytes(void* out, uint32_t n)
+{
+	uint8_t* p = (uint8_t*)out;
+	while (n--)
+	{
+		if (!readByte(p++)) return false;
+	}
+	return true;
+}
+
+uint16_t GifPlayer::readWord(bool* ok)
+{
+	uint8_t b[2];
+	if (!readBytes(b, 2)) *ok = false;
+	return b[0] | (b[1] << 8);
+}
+
+/**
+ * 跳过一串数据子块（长度字节 + 数据，0长度结束）
+ */
+bool GifPlayer::skipSubBlocks()
+{
+	uint8_t len;
+	while (readByte(&len))
+	{
+		if (len == 0) return true;
+		if (!seek(tell() + len)) return false;
+	}
+	return false;
+}
+
+bool GifPlayer::readPalette(lv_color_t* pal, uint16_t n)
+{
+	uint8_t rgb[3];
+	for (uint16_t i = 0; i < n; i++)
+	{
+		if (!readBytes(rgb, 3)) return false;
+		pal[i] = lv_color_make(rgb[0], rgb[1], rgb[2]);
+	}
+	return true;
+}
+
+/**
+ * 文件头与逻辑屏幕描述符（宽、高、全局调色板），背景色索引与像素宽高比不使用
+ */
+bool GifPlayer::readHeader()
+{
+	uint8_t sig[6];
+	if (!readBytes(sig, 6) || memcmp(sig, "GIF", 3) != 0) return false;
+
+	bool ok = true;
+	w = readWord(&ok);
+	h = readWord(&ok);
+	uint8_t lsd[3];
+	if (!ok || !readBytes(lsd, 3) || w == 0 || h == 0) return false;
+
+	has_gct = lsd[0] & 0x80;
+	if (has_gct && !readPalette(gct, 2 << (lsd[0] & 7))) return false;
+	first_frame = tell();
+	next_disposal = 0;
+	next_transparent = -1;
+	next_delay = 0;
+	return true;
+}
+
+/**
+ * 读到下一幅图像并写入画布
+ * 结尾块（或文件在帧之间截断）时回到第一帧继续；从第一帧读到结尾都没有图像时返回false
+ */
+bool GifPlayer::nextFrame()
+{
+	bool rewound = false;
+	uint8_t b;
+	while (true)
+	{
+		if (!readByte(&b)) b = 0x3B;
+
+		if (b == 0x21)
+		{
+			uint8_t label, len;
+			if (!readByte(&label)) return false;
+			if (label == 0xF9)
+			{
+				// 图形控制扩展：处置方式、延时、透明色索引
+				uint8_t gce[4];
+				if (!readByte(&len) || len < 4 || !readBytes(gce, 4)) return false;
+				if (!seek(tell() + len - 4) || !skipSubBlocks()) return false;
+				next_disposal = (gce[0] >> 2) & 7;
+				next_transparent = (gce[0] & 1) ? gce[3] : -1;
+				next_delay = gce[1] | (gce[2] << 8);
+			}
+			else if (!skipSubBlocks())
+			{
+				return false;
+			}
+		}
+		else if (b == 0x2C)
+		{
+			bool ok = true;
+			uint16_t ix = readWord(&ok);
+			uint16_t iy = readWord(&ok);
+			uint16_t iw = readWord(&ok);
+			uint16_t ih = readWord(&ok);
+			uint8_t packed;
+			// 坐标需在lv_coord_t范围内
+			if (!ok || !readByte(&packed) || ix + iw > LV_COORD_MAX || iy + ih > LV_COORD_MAX) return false;
+			lv_area_t r = { (lv_coord_t)ix, (lv_coord_t)iy, (lv_coord_t)(ix + iw - 1), (lv_coord_t)(iy + ih - 1) };
+
+			const lv_color_t* pal = gct;
+			if (packed & 0x80)
+			{
+				if (!readPalette(lct, 2 << (packed & 7))) return false;
+				pal = lct;
+			}
+			else if (!has_gct)
+			{
+				return false;
+			}
+
+			// 上一帧的处置，然后按本帧的处置方式保存将被覆盖的内容
+			dispose();
+			lv_area_t full = { 0, 0, (lv_coord_t)(w - 1), (lv_coord_t)(h - 1) };
+			bool visible = iw && ih && _lv_area_intersect(&rect, &r, &full);
+			disposal = visible ? next_disposal : 0;
+			if (disposal == 3)
+			{
+				lv_coord_t rw = lv_area_get_width(&rect);
+				backup = (lv_color_t*)buf_alloc(BUF_BULK, lv_area_get_size(&rect) * sizeof(lv_color_t));
+				if (backup)
+				{
+					for (lv_coord_t y = rect.y1; y <= rect.y2; y++)
+					{
+						memcpy(backup + (y - rect.y1) * rw, canvas + (uint32_t)y * w + rect.x1, rw * sizeof(lv_color_t));
+					}
+				}
+				else
+				{
+					LOG_W("gif", "恢复缓冲分配失败，按不处置继续");
+					disposal = 1;
+				}
+			}
+
+			if (!decodeImage(&r, packed & 0x40, pal, next_transparent)) return false;
+			if (visible) invalidate(&rect);
+
+			delay_ms = next_delay < 2 ? GIF_DEFAULT_DELAY_MS : LV_MATH_MAX(next_delay * 10, GIF_MIN_DELAY_MS);
+			next_disposal = 0;
+			next_transparent = -1;
+			next_delay = 0;
+			frames++;
+			return true;
+		}
+		else if (b == 0x3B && !rewound)
+		{
+			rewound = true;
+			if (!seek(first_frame)) return false;
+			next_disposal = 0;
+			next_transparent = -1;
+			next_delay = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+}
+
+/**
+ * LZW解码一幅图像，像素按行（或隔行扫描的四遍）写入画布中的r，超出画布的部分与透明色不写
+ * 读完结束码后跳过本图像剩余的子块
+ */
+bool GifPlayer::decodeImage(const lv_area_t* r, bool interlace, const lv_color_t* pal, int16_t transparent)
+{
+	static const uint8_t pass_start[4] = { 0, 4, 2, 1 };
+	static const uint8_t pass_step[4] = { 8, 8, 4, 2 };
+
+	uint8_t min_size;
+	if (!readByte(&min_size) || min_size < 1 || min_size > 11) return false;
+
+	const uint16_t clear = 1 << min_size;
+	const uint16_t eoi = clear + 1;
+	for (uint16_t i = 0; i < clear; i++) suffix[i] = (uint8_t)i;
+
+	uint8_t code_size = min_size + 1;
+	uint16_t next = clear + 2;
+	int32_t old = -1;
+	uint8_t first = 0;
+
+	uint32_t bits = 0;
+	uint8_t nbits = 0;
+	uint8_t block_left = 0;
+	bool ended = false;
+
+	// 输出位置（图像内坐标）与对应的画布行（超出画布时为NULL）
+	lv_coord_t iw = lv_area_get_width(r);
+	lv_coord_t ih = lv_area_get_height(r);
+	lv_coord_t px = 0;
+	lv_coord_t py = 0;
+	uint8_t pass = 0;
+	bool done = iw <= 0 || ih <= 0;
+	lv_color_t* line = NULL;
+	auto setLine = [&]() {
+		lv_coord_t cy = r->y1 + py;
+		line = cy < h ? canvas + (uint32_t)cy * w : NULL;
+	};
+	setLine();
+
+	while (!done)
+	{
+		// 跨子块拼接下一个码
+		while (nbits < code_size)
+		{
+			if (block_left == 0)
+			{
+				if (!readByte(&block_left)) return false;
+				if (block_left == 0)
+				{
+					ended = true;
+					break;
+				}
+			}
+			uint8_t byte;
+			if (!readByte(&byte)) return false;
+			block_left--;
+			bits |= (uint32_t)byte << nbits;
+			nbits += 8;
+		}
+		if (ended) break;
+		uint16_t code = bits & ((1 << code_size) - 1);
+		bits >>= code_size;
+		nbits -= code_size;
+
+		if (code == clear)
+		{
+			code_size = min_size + 1;
+			next = clear + 2;
+			old = -1;
+			continue;
+		}
+		if (code == eoi) break;
+
+		uint16_t sp = 0;
+		uint16_t in = code;
+		if (old < 0)
+		{
+			if (code >= clear) break;
+			first = code;
+			stack[sp++] = first;
+		}
+		else
+		{
+			if (code > next) break;
+			if (code == next)
+			{
+				// KwKwK：码尚未入字典，等于上一个串加其首字节
+				stack[sp++] = first;
+				code = old;
+			}
+			while (code >= clear && sp < GIF_LZW_CODES - 1)
+			{
+				stack[sp++] = suffix[code];
+				code = prefix[code];
+			}
+			first = suffix[code];
+			stack[sp++] = first;
+
+			if (next < GIF_LZW_CODES)
+			{
+				prefix[next] = old;
+				suffix[next] = first;
+				next++;
+				if (next == (1 << code_size) && code_size < 12) code_size++;
+			}
+		}
+		old = in;
+
+		while (sp && !done)
+		{
+			uint8_t index = stack[--sp];
+			lv_coord_t cx = r->x1 + px;
+			if (line && cx < w && index != transparent) line[cx] = pal[index];
+			if (++px < iw) continue;
+
+			px = 0;
+			if (!interlace)
+			{
+				py++;
+			}
+			else
+			{
+				py += pass_step[pass];
+				while (py >= ih && pass < 3)
+				{
+					pass++;
+					py = pass_start[pass];
+				}
+			}
+			if (py >= ih) done = true;
+			else setLine();
+		}
+	}
+
+	if (ended) return true;
+	return seek(tell() + block_left) && skipSubBlocks();
+}
+
+/**
+ * 处置上一帧的子矩形
+ */
+void GifPlayer::dispose()
+{
+	if (disposal == 2)
+	{
+		for (lv_coord_t y = rect.y1; y <= rect.y2; y++)
+		{
+			lv_color_t* p = canvas + (uint32_t)y * w;
+			for (lv_coord_t x = rect.x1; x <= rect.x2; x++) p[x] = bg;
+		}
+		invalidate(&rect);
+	}
+	else if (disposal == 3 && backup)
+	{
+		lv_coord_t rw = lv_area_get_width(&rect);
+		for (lv_coord_t y = rect.y1; y <= rect.y2; y++)
+		{
+			memcpy(canvas + (uint32_t)y * w + rect.x1, backup + (y - rect.y1) * rw, rw * sizeof(lv_color_t));
+		}
+		invalidate(&rect);
+	}
+	if (backup)
+	{
+		buf_free(backup);
+		backup = NULL;
+	}
+	disposal = 0;
+}
+
+/**
+ * 使画布坐标中的区域失效
+ */
+void GifPlayer::invalidate(const lv_area_t* r)
+{
+	lv_area_t a = { (lv_coord_t)(r->x1 + obj->coords.x1), (lv_coord_t)(r->y1 + obj->coords.y1),
+					(lv_coord_t)(r->x2 + obj->coords.x1), (lv_coord_t)(r->y2 + obj->coords.y1) };
+	lv_obj_invalidate_area(obj, &a);
+}
+
+GifPlayer* GifPlayer::of(lv_obj_t* o)
+{
+	GifPlayerExt* ext = (GifPlayerExt*)lv_obj_get_ext_attr(o);
+	return ext ? ext->owner : NULL;
+}
+
+/**
+ * 绘制回调：把画布与裁剪区域的交集复制到显示缓冲
+ */
+lv_design_res_t GifPlayer::designCb(lv_obj_t* o, const lv_area_t* clip, lv_design_mode_t mode)
+{
+	GifPlayer* g = of(o);
+	if (mode == LV_DESIGN_COVER_CHK)
+	{
+		// 画布不透明（透明像素显示的是之前的帧或背景色）
+		if (g && g->canvas && lv_obj_get_style_opa_scale(o, LV_OBJ_PART_MAIN) == LV_OPA_COVER &&
+			_lv_area_is_in(clip, &o->coords, 0))
+		{
+			return LV_DESIGN_RES_COVER;
+		}
+		return LV_DESIGN_RES_NOT_COVER;
+	}
+	if (mode != LV_DESIGN_DRAW_MAIN || g == NULL || g->canvas == NULL) return LV_DESIGN_RES_OK;
+
+	lv_area_t map = { o->coords.x1, o->coords.y1, (lv_coord_t)(o->coords.x1 + g->w - 1),
+					  (lv_coord_t)(o->coords.y1 + g->h - 1) };
+	lv_area_t area;
+	if (!_lv_area_intersect(&area, clip, &map)) return LV_DESIGN_RES_OK;
+	lv_opa_t opa = lv_obj_get_style_opa_scale(o, LV_OBJ_PART_MAIN);
+	if (opa < LV_OPA_MIN) return LV_DESIGN_RES_OK;
+
+	_lv_blend_map(&area, &map, g->canvas, NULL, LV_DRAW_MASK_RES_FULL_COVER, opa, LV_BLEND_MODE_NORMAL);
+	return LV_DESIGN_RES_OK;
+}
+
+lv_res_t GifPlayer::signalCb(lv_obj_t* o, lv_signal_t sign, void* param)
+{
+	if (sign == LV_SIGNAL_CLEANUP)
+	{
+		GifPlayer* g = of(o);
+		if (g) g->detach();
+	}
+	return ancestor_signal(o, sign, param);
+}
+
+/**
+ * 帧定时器：解码下一帧，周期设为该帧的延时
+ */
+void GifPlayer::taskCb(lv_task_t* t)
+{
+	GifPlayer* self = (GifPlayer*)t->user_data;
+	if (!self->nextFrame())
+	{
+		LOG_W("gif", "解码失败，停止播放");
+		self->stop();
+		return;
+	}
+	lv_task_set_period(t, self->delay_ms);
+}
@@ -32,7 +32,23 @@
 
 #include "lvgl.h"        // LVGL图形库核心头文件
 #include <stdio.h>       // 标准输入输出库
+#include <stddef.h>      // offsetof
 #include "gui_guider.h"  // GUI向导头文件
+#include "screen_manager.h"  // 按需创建/回收屏幕
+
+static void home_setup(void* ctx) { setup_scr_home((lv_ui*)ctx); }
+static void home_cleanup(void* ctx) { cleanup_scr_home((lv_ui*)ctx); }
+static void scenes_setup(void* ctx) { setup_scr_scenes((lv_ui*)ctx); }
+static void scenes_cleanup(void* ctx) { cleanup_scr_scenes((lv_ui*)ctx); }
+
+/**
+ * 屏幕登记表（顺序与gui_scr_t一致）
+ * 场景界面的画布由ScenePlayer长期引用，建好后不回收
+ */
+static const scr_mgr_def_t gui_screens[GUI_SCR_CNT] = {
+	{ "home", offsetof(lv_ui, home), home_setup, home_cleanup, false },
+	{ "scenes", offsetof(lv_ui, scenes), scenes_setup, scenes_cleanup, true },
+};
 
 /**
  * GUI用户界面初始化函数
@@ -40,16 +56,8 @@
  * @param ui GUI界面结构体指针，包含所有界面对象
  * 
  * 功能说明：
- * 1. 初始化所有GUI界面屏幕
- * 2. 设置界面的默认显示状态
- * 3. 建立界面间的导航关系
- * 4. 配置界面的显示优先级
- * 
- * 初始化流程：
- * 1. 创建主界面（颜色选择器）
- * 2. 加载并显示主界面
- * 3. 创建场景界面（动画播放）
- * 4. 切换到场景界面作为默认显示
+ * 1. 向屏幕管理器登记所有界面，此时不创建任何界面
+ * 2. 创建并显示默认界面（场景界面）
  * 
  * 界面说明：
  * - Home界面：提供RGB颜色选择功能，用于控制LED灯效
@@ -57,19 +65,33 @@
  * 
  * 注意事项：
  * - 必须在LVGL和显示系统初始化后调用
- * - 界面切换会自动处理资源释放
- * - 最后加载的界面将成为当前显示界面
+ * - 其他界面在首次gui_load()时才创建，离开后按LRU保留SCR_MGR_WARM个，
+ *   超出的删除并释放样式；回收后ui中对应的指针被置为NULL
  */
 void setup_ui(lv_ui* ui)
 {
-	/* 初始化主界面（RGB颜色选择器） */
-	setup_scr_home(ui);     // 创建主界面UI元素
-	lv_scr_load(ui->home);  // 加载主界面到显示系统
+	/* 场景界面作为系统启动后的默认显示界面 */
+	/* 用户可以通过IMU手势在不同界面间切换（gui_load） */
+	setup_ui_at(ui, GUI_SCR_SCENES);
+}
+
+/**
+ * 同setup_ui，首先显示的界面由调用方指定（热重启后恢复上次的界面，只创建该界面）
+ */
+void setup_ui_at(lv_ui* ui, gui_scr_t first)
+{
+	scr_mgr_init(ui, gui_screens, GUI_SCR_CNT);
+	gui_load(first < GUI_SCR_CNT ? first : GUI_SCR_SCENES, LV_SCR_LOAD_ANIM_NONE);
+}
 
-	/* 初始化场景界面（3D全息动画播放） */
-	setup_scr_scenes(ui);     // 创建场景界面UI元素
-	lv_scr_load(ui->scenes);  // 切换到场景界面（默认显示）
-	
-	/* 场景界面将作为系统启动后的默认显示界面 */
-	/* 用户可以通过IMU手势在不同界面间切换 */
+/**
+ * 切换界面（首次切换时创建）
+ *
+ * @param id   界面编号
+ * @param anim 切换动画，如LV_SCR_LOAD_ANIM_MOVE_LEFT，时长SCR_MGR_ANIM_TIME
+ * @return 界面屏幕对象，创建失败时返回NULL
+ */
+lv_obj_t* gui_load(gui_scr_t id, lv_scr_load_anim_t anim)
+{
+	return scr_mgr_open(id, anim, SCR_MGR_ANIM_TIME);
 }
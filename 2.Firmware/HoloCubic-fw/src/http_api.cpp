@@ -0,0 +1,279 @@
+/*
+ * HoloCubic HTTP接口模块
+ *
+ * 功能说明：
+ * 1. 多个数据源共用一个HTTPClient，同一主机的请求复用连接
+ * 2. ArduinoJson按过滤文档流式解析响应，忽略不需要的字段
+ * 3. 解析结果放在固定内存池中，每次请求复用同一块内存
+ * 4. 支持chunked传输编码（keep-alive时服务器常用）
+ * 5. https请求使用TlsClient，CA证书包首次使用时从SD卡加载
+ * 6. 解析按HTTP_API_SLICE_BYTES分片让出CPU
+ */
+
+#include "http_api.h"
+
+/**
+ * chunked传输编码解码流
+ * 包装原始连接，只向JSON解析器输出数据部分
+ */
+class ChunkedStream : public Stream
+{
+private:
+	Stream& src;
+	uint32_t left;     // 当前块剩余字节
+	bool done;
+
+	// 读一个块头（十六进制长度行），长度为0表示结束
+	void nextChunk()
+	{
+		char line[12];
+		size_t n = src.readBytesUntil('\n', line, sizeof(line) - 1);
+		line[n] = 0;
+		left = strtoul(line, NULL, 16);
+		if (left == 0) done = true;
+	}
+
+public:
+	ChunkedStream(Stream& s) : src(s), left(0), done(false) {}
+
+	int available() override
+	{
+		return done ? 0 : src.available();
+	}
+
+	int read() override
+	{
+		if (done) return -1;
+		if (left == 0)
+		{
+			nextChunk();
+			if (done) return -1;
+		}
+		int c = src.read();
+		if (c < 0) return -1;
+		// 块数据之后紧跟\r\n
+		if (--left == 0)
+		{
+			src.read();
+			src.read();
+		}
+		return c;
+	}
+
+	int peek() override
+	{
+		if (done) return -1;
+		if (left == 0)
+		{
+			nextChunk();
+			if (done) return -1;
+		}
+		return src.peek();
+	}
+
+	size_t readBytes(char* buffer, size_t length) override
+	{
+		size_t n = 0;
+		while (n < length)
+		{
+			int c = read();
+			if (c < 0) break;
+			buffer[n++] = c;
+		}
+		return n;
+	}
+
+	size_t write(uint8_t) override
+	{
+		return 0;
+	}
+};
+
+/**
+ * 分片流
+ * 包装响应流，每读HTTP_API_SLICE_BYTES字节让出一个tick，按片限定连续占用CPU的时间
+ */
+class SliceStream : public Stream
+{
+private:
+	Stream& src;
+	uint32_t count;
+
+	void account(size_t n)
+	{
+		uint32_t before = count / HTTP_API_SLICE_BYTES;
+		count += n;
+		if (count / HTTP_API_SLICE_BYTES != before) vTaskDelay(1);
+	}
+
+public:
+	SliceStream(Stream& s) : src(s), count(0) {}
+
+	int available() override
+	{
+		return src.available();
+	}
+
+	int read() override
+	{
+		int c = src.read();
+		if (c >= 0) account(1);
+		return c;
+	}
+
+	int peek() override
+	{
+		return src.peek();
+	}
+
+	size_t readBytes(char* buffer, size_t length) override
+	{
+		size_t n = src.readBytes(buffer, length);
+		account(n);
+		return n;
+	}
+
+	size_t write(uint8_t) override
+	{
+		return 0;
+	}
+};
+
+JsonPoolAllocator::JsonPoolAllocator(uint8_t* buf, size_t len) : pool(buf), size(len), used(0)
+{
+}
+
+void JsonPoolAllocator::reset()
+{
+	used = 0;
+}
+
+/**
+ * 每块前放一个长度头，reallocate需要知道原长度
+ */
+void* JsonPoolAllocator::allocate(size_t n)
+{
+	size_t need = (n + sizeof(size_t) + 3) & ~(size_t)3;
+	if (used + need > size) return NULL;
+
+	size_t* hdr = (size_t*)(pool + used);
+	*hdr = n;
+	used += need;
+	return hdr + 1;
+}
+
+void JsonPoolAllocator::deallocate(void* ptr)
+{
+	// 最后一块可以回收，其余在reset时整体回收
+	if (ptr == NULL) return;
+	size_t* hdr = (size_t*)ptr - 1;
+	size_t blk = (*hdr + sizeof(size_t) + 3) & ~(size_t)3;
+	if ((uint8_t*)hdr + blk == pool + used) used -= blk;
+}
+
+void* JsonPoolAllocator::reallocate(void* ptr, size_t n)
+{
+	if (ptr == NULL) return allocate(n);
+
+	size_t* hdr = (size_t*)ptr - 1;
+	size_t old = *hdr;
+	size_t old_blk = (old + sizeof(size_t) + 3) & ~(size_t)3;
+	size_t new_blk = (n + sizeof(size_t) + 3) & ~(size_t)3;
+
+	// 缩小（shrinkToFit）或最后一块原地扩展
+	if (n <= old || (uint8_t*)hdr + old_blk == pool + used)
+	{
+		if ((uint8_t*)hdr + old_blk == pool + used)
+		{
+			if ((uint8_t*)hdr - pool + new_blk > size) return NULL;
+			used = (uint8_t*)hdr - pool + new_blk;
+		}
+		*hdr = n;
+		return ptr;
+	}
+
+	void* p = allocate(n);
+	if (p) memcpy(p, ptr, old);
+	return p;
+}
+
+HttpApi::HttpApi() : pool(pool_buf, sizeof(pool_buf)), doc(&pool)
+{
+	current = NULL;
+	http.setReuse(true);
+	http.setTimeout(HTTP_API_TIMEOUT_MS);
+	http.setConnectTimeout(HTTP_API_TIMEOUT_MS);
+}
+
+/**
+ * GET请求并流式解析JSON
+ *
+ * @param url    完整URL（主机相同的连续请求复用连接），调用方可在栈上拼接
+ *               （HTTPClient::begin内部仍会转为String解析主机与路径，请求结束即释放）
+ * @param filter 过滤文档，值为true的字段才会保留
+ * @return 解析结果（下次请求前有效），失败返回NULL
+ */
+JsonDocument* HttpApi::getJson(const char* url, const JsonDocument& filter)
+{
+	static const char* headers[] = { "Transfer-Encoding" };
+
+	if (!WiFi.isConnected()) return NULL;
+
+	// http与https分别使用不同的客户端，切换时先断开上一个连接
+	WiFiClient* c = strncmp(url, "https://", 8) == 0 ? &tls : &client;
+	if (c != current) close();
+	current = c;
+	if (c == &tls && !TlsClient::hasCa()) TlsClient::loadCaFile();
+	if (!http.begin(*c, url)) return NULL;
+	http.collectHeaders(headers, 1);
+
+	int code = http.GET();
+	if (code != HTTP_CODE_OK)
+	{
+		if (code < 0) Serial.printf("[HTTP] %s 失败: %s\n", url, http.errorToString(code).c_str());
+		else Serial.printf("[HTTP] %s 失败: %d\n", url, code);
+		// 出错后连接状态不确定，不再复用
+		close();
+		return NULL;
+	}
+
+	doc.clear();
+	pool.reset();
+
+	DeserializationError err;
+	Stream& body = http.getStream();
+	if (http.header("Transfer-Encoding").equalsIgnoreCase("chunked"))
+	{
+		ChunkedStream chunked(body);
+		SliceStream sliced(chunked);
+		err = deserializeJson(doc, sliced, DeserializationOption::Filter(filter));
+		// 读完剩余数据（含结束块），否则残留字节会破坏下一次复用的响应
+		while (chunked.read() >= 0);
+	}
+	else
+	{
+		SliceStream sliced(body);
+		err = deserializeJson(doc, sliced, DeserializationOption::Filter(filter));
+	}
+
+	// end()在服务器允许keep-alive时保留连接
+	http.end();
+
+	if (err)
+	{
+		Serial.printf("[HTTP] JSON解析失败: %s\n", err.c_str());
+		close();
+		return NULL;
+	}
+	return &doc;
+}
+
+/**
+ * 主动断开连接
+ */
+void HttpApi::close()
+{
+	http.end();
+	client.stop();
+	tls.stop();
+}
@@ -0,0 +1,212 @@
+/*
+ * HoloCubic 多语言文字
+ *
+ * 功能说明：
+ * 1. 界面文字按编号（i18n_strings.h）取得，内置英文编译在固件中
+ * 2. 其他语言的语言包放在资源包分区（名称lang_<代码>），文字表按编号排列，直接引用映射后的flash
+ * 3. 语言包自带该语言用到的字形，作为LVGL字体按码位二分查找，没有的字符交给I18N_FALLBACK_FONT
+ * 4. 切换语言后删除已建好的屏幕（下次打开时重建）、重建当前屏幕并重新进入前台应用
+ *
+ * 语言包生成（翻译文件每行"编号 = 文字"，见3.Software/ImageToHolo/lang/）：
+ *   python get_holo.py --assets assets.bin --lang-font simsun.ttc --lang-size 14 logo.png lang/zh.lang ...
+ */
+
+#include "i18n.h"
+#include "asset_bundle.h"
+#include "config_store.h"
+#include "app_manager.h"
+#include "screen_manager.h"
+#include "logger.h"
+
+I18n i18n;
+
+static const char* const builtin[STR_COUNT] = {
+#define I18N_STRING(id, text) text,
+#include "i18n_strings.h"
+#undef I18N_STRING
+};
+
+I18n::I18n()
+{
+	pack = NULL;
+	offsets = NULL;
+	font_base = NULL;
+	font_hdr = NULL;
+	codes = NULL;
+	glyphs = NULL;
+	memset(&font, 0, sizeof(font));
+}
+
+void I18n::begin()
+{
+	const char* code = config.getStr(CFG_UI_LANG);
+	if (code[0] && !setLanguage(code, false)) LOG_W("i18n", "没有语言包: %s，使用内置文字", code);
+}
+
+/**
+ * 检查语言包的各部分都在资源范围内并记下指针
+ */
+bool I18n::check(const uint8_t* data, uint32_t size)
+{
+	const I18nHeader* hdr = (const I18nHeader*)data;
+	if (size < sizeof(I18nHeader) || memcmp(hdr->magic, I18N_MAGIC, 4) != 0 || hdr->version > I18N_VERSION ||
+		hdr->size > size || sizeof(I18nHeader) + hdr->count * 4U > hdr->size ||
+		hdr->code[I18N_CODE_LEN - 1] != '\0' || hdr->name[sizeof(hdr->name) - 1] != '\0')
+		return false;
+
+	// 文字区在偏移表之后、字体之前，以'\0'结束（其余各项的结尾由下一项的起始保证）
+	const uint32_t* offs = (const uint32_t*)(data + sizeof(I18nHeader));
+	uint32_t start = sizeof(I18nHeader) + hdr->count * 4U;
+	uint32_t end = hdr->font ? hdr->font : hdr->size;
+	if (end <= start || end > hdr->size || data[end - 1] != '\0') return false;
+	for (uint16_t i = 0; i < hdr->count; i++)
+	{
+		if (offs[i] && (offs[i] < start || offs[i] >= end)) return false;
+	}
+
+	const uint8_t* fbase = NULL;
+	const I18nFontHeader* fh = NULL;
+	if (hdr->font)
+	{
+		fbase = data + hdr->font;
+		fh = (const I18nFontHeader*)fbase;
+		uint32_t need = sizeof(I18nFontHeader) + fh->glyph_count * (4U + sizeof(I18nGlyph));
+		if ((hdr->font & 3) || hdr->font + need > hdr->size || fh->glyph_count == 0 ||
+			(fh->bpp != 1 && fh->bpp != 2 && fh->bpp != 4 && fh->bpp != 8))
+			return false;
+		const I18nGlyph* g = (const I18nGlyph*)(fbase + sizeof(I18nFontHeader) + fh->glyph_count * 4U);
+		uint32_t limit = hdr->size - hdr->font;
+		for (uint16_t i = 0; i < fh->glyph_count; i++)
+		{
+			if (g[i].bitmap + ((uint32_t)g[i].box_w * g[i].box_h * fh->bpp + 7) / 8 > limit) return false;
+		}
+	}
+
+	pack = hdr;
+	offsets = offs;
+	font_base = fbase;
+	font_hdr = fh;
+	codes = fh ? (const uint32_t*)(fbase + sizeof(I18nFontHeader)) : NULL;
+	glyphs = fh ? (const I18nGlyph*)(codes + fh->glyph_count) : NULL;
+	return true;
+}
+
+bool I18n::setLanguage(const char* code, bool save)
+{
+	if (code == NULL) code = "";
+	if (code[0] == '\0')
+	{
+		pack = NULL;
+		offsets = NULL;
+		font_base = NULL;
+		font_hdr = NULL;
+		codes = NULL;
+		glyphs = NULL;
+	}
+	else
+	{
+		char name[ASSET_NAME_LEN];
+		snprintf(name, sizeof(name), I18N_ASSET_PREFIX "%s", code);
+		uint32_t size = 0;
+		const uint8_t* data = assets.getData(name, &size);
+		if (data == NULL || !check(data, size)) return false;
+	}
+
+	if (font_hdr)
+	{
+		font.get_glyph_dsc = glyphDscCb;
+		font.get_glyph_bitmap = glyphBitmapCb;
+		font.line_height = font_hdr->line_height;
+		font.base_line = font_hdr->base_line;
+		font.subpx = LV_FONT_SUBPX_NONE;
+		font.underline_position = font_hdr->underline_position;
+		font.underline_thickness = font_hdr->underline_thickness;
+		font.dsc = this;
+	}
+	LOG_I("i18n", "界面语言: %s", getName());
+	if (save) config.set(CFG_UI_LANG, code);
+
+	// 按新语言重建界面（开机时begin在界面创建之前调用，此时没有需要重建的对象）
+	scr_mgr_rebuild();
+	apps.reload();
+	return true;
+}
+
+const char* I18n::getLanguage()
+{
+	return pack ? pack->code : "";
+}
+
+const char* I18n::getName()
+{
+	return pack ? pack->name : "English";
+}
+
+const char* I18n::str(i18n_id_t id)
+{
+	if ((unsigned)id >= STR_COUNT) return "";
+	if (pack && id < pack->count && offsets[id]) return (const char*)pack + offsets[id];
+	return builtin[id];
+}
+
+const lv_font_t* I18n::getFont()
+{
+	return font_hdr ? &font : I18N_FALLBACK_FONT;
+}
+
+/**
+ * 按码位二分查找字形
+ */
+const I18nGlyph* I18n::findGlyph(uint32_t letter) const
+{
+	if (font_hdr == NULL) return NULL;
+	uint16_t lo = 0;
+	uint16_t hi = font_hdr->glyph_count;
+	while (lo < hi)
+	{
+		uint16_t mid = (lo + hi) / 2;
+		if (codes[mid] < letter) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo < font_hdr->glyph_count && codes[lo] == letter ? &glyphs[lo] : NULL;
+}
+
+bool I18n::glyphDscCb(const lv_font_t* font, lv_font_glyph_dsc_t* dsc, uint32_t letter, uint32_t letter_next)
+{
+	const I18n* self = (const I18n*)font->dsc;
+	const I18nGlyph* g = self->findGlyph(letter);
+	if (g == NULL)
+	{
+		const lv_font_t* fb = I18N_FALLBACK_FONT;
+		return fb->get_glyph_dsc(fb, dsc, letter, letter_next);
+	}
+	dsc->adv_w = (g->adv_w + (1 << 3)) >> 4;
+	dsc->box_w = g->box_w;
+	dsc->box_h = g->box_h;
+	dsc->ofs_x = g->ofs_x;
+	dsc->ofs_y = g->ofs_y;
+	dsc->bpp = self->font_hdr->bpp;
+	return true;
+}
+
+const uint8_t* I18n::glyphBitmapCb(const lv_font_t* font, uint32_t letter)
+{
+	const I18n* self = (const I18n*)font->dsc;
+	const I18nGlyph* g = self->findGlyph(letter);
+	if (g == NULL)
+	{
+		const lv_font_t* fb = I18N_FALLBACK_FONT;
+		return fb->get_glyph_bitmap(fb, letter);
+	}
+	return self->font_base + g->bitmap;
+}
+
+const char* i18n_str(i18n_id_t id)
+{
+	return i18n.str(id);
+}
+
+const lv_font_t* i18n_font(void)
+{
+	return i18n.getFont();
+}
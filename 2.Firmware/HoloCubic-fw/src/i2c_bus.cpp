@@ -0,0 +1,230 @@
+/*
+ * HoloCubic I2C总线管理模块
+ *
+ * 功能说明：
+ * 1. 统一初始化I2C总线，IMU与环境光传感器不再各自调用Wire.begin
+ * 2. 事务排队，在专用任务中通过IDF命令链执行，完成后回调
+ * 3. 提供阻塞式transfer()：调用任务挂起等待完成，不占用CPU
+ * 4. 总线被从机拉死时输出时钟释放SDA，由任务监视器触发（supervisor.h）
+ */
+
+#include "i2c_bus.h"
+#include "supervisor.h"
+#include "logger.h"
+#include <rom/gpio.h>
+
+I2cBus i2c_bus(I2C_NUM_0, Wire);
+
+// transfer()的完成上下文，位于调用方栈上
+struct I2cWaiter
+{
+	SemaphoreHandle_t done;
+	esp_err_t err;
+};
+
+static void waiterDone(esp_err_t err, void* user)
+{
+	I2cWaiter* w = (I2cWaiter*)user;
+	w->err = err;
+	xSemaphoreGive(w->done);
+}
+
+I2cBus::I2cBus(i2c_port_t p, TwoWire& w) : port(p), wire(w)
+{
+	queue = NULL;
+	task = NULL;
+	started = false;
+	pin_sda = -1;
+	pin_scl = -1;
+	mutex = NULL;
+	sup_id = -1;
+}
+
+/**
+ * 初始化总线并启动总线任务（重复调用时直接返回）
+ *
+ * @return 驱动安装或任务创建失败返回false
+ */
+bool I2cBus::begin(int sda, int scl, uint32_t freq)
+{
+	if (started)
+	{
+		if (sda != pin_sda || scl != pin_scl)
+			Serial.printf("I2C%d已在GPIO%d/%d上初始化，忽略GPIO%d/%d\n", port, pin_sda, pin_scl, sda, scl);
+		return true;
+	}
+
+	// Wire负责安装IDF驱动；I2Cdev（I2CDEV_ESP_IDF）直接在同一驱动上执行命令链
+	if (!wire.begin(sda, scl, freq))
+	{
+		Serial.printf("I2C%d初始化失败\n", port);
+		return false;
+	}
+
+	queue = xQueueCreate(I2C_BUS_QUEUE_LEN, sizeof(I2cTransaction));
+	mutex = xSemaphoreCreateMutex();
+	if (queue == NULL || mutex == NULL) return false;
+	pin_sda = sda;
+	pin_scl = scl;
+	sup_id = supervisor.add("i2c", I2C_BUS_STALL_MS, recoverCb, this);
+	if (xTaskCreatePinnedToCore(taskEntry, "i2c", I2C_BUS_TASK_STACK, this,
+		I2C_BUS_TASK_PRIO, &task, I2C_BUS_TASK_CORE) != pdPASS)
+	{
+		vQueueDelete(queue);
+		queue = NULL;
+		return false;
+	}
+
+	started = true;
+	return true;
+}
+
+/**
+ * 提交异步事务（不等待），完成后在总线任务中调用t.cb
+ *
+ * @return 总线未初始化或队列已满返回false，此时不会回调
+ */
+bool I2cBus::submit(const I2cTransaction& t)
+{
+	if (!started) return false;
+	return xQueueSend(queue, &t, 0) == pdTRUE;
+}
+
+/**
+ * 提交事务并挂起等待完成（不能在总线任务的回调中调用）
+ *
+ * @return ESP_OK或驱动返回的错误（ESP_FAIL: 无应答，ESP_ERR_TIMEOUT: 总线超时）
+ */
+esp_err_t I2cBus::transfer(uint8_t addr, const uint8_t* tx, uint8_t tx_len, uint8_t* rx, uint16_t rx_len)
+{
+	StaticSemaphore_t sem_buf;
+	I2cWaiter w;
+	w.done = xSemaphoreCreateBinaryStatic(&sem_buf);
+	w.err = ESP_FAIL;
+
+	I2cTransaction t = { addr, tx, tx_len, rx, rx_len, waiterDone, &w };
+	if (!started || xQueueSend(queue, &t, portMAX_DELAY) != pdTRUE)
+	{
+		vSemaphoreDelete(w.done);
+		return ESP_ERR_INVALID_STATE;
+	}
+
+	// 每个事务都有驱动超时，回调一定会发生，w在此之前不会离开作用域
+	xSemaphoreTake(w.done, portMAX_DELAY);
+	vSemaphoreDelete(w.done);
+	return w.err;
+}
+
+esp_err_t I2cBus::writeReg(uint8_t addr, uint8_t reg, uint8_t value)
+{
+	uint8_t buf[2] = { reg, value };
+	return transfer(addr, buf, 2, NULL, 0);
+}
+
+esp_err_t I2cBus::readRegs(uint8_t addr, uint8_t reg, uint8_t* data, uint16_t len)
+{
+	return transfer(addr, &reg, 1, data, len);
+}
+
+/**
+ * 用命令链执行一个事务
+ */
+esp_err_t I2cBus::execute(const I2cTransaction& t)
+{
+	i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+	if (cmd == NULL) return ESP_ERR_NO_MEM;
+
+	if (t.tx_len > 0)
+	{
+		i2c_master_start(cmd);
+		i2c_master_write_byte(cmd, (t.addr << 1) | I2C_MASTER_WRITE, true);
+		i2c_master_write(cmd, t.tx, t.tx_len, true);
+	}
+	if (t.rx_len > 0)
+	{
+		// 有写阶段时这里是重复起始
+		i2c_master_start(cmd);
+		i2c_master_write_byte(cmd, (t.addr << 1) | I2C_MASTER_READ, true);
+		i2c_master_read(cmd, t.rx, t.rx_len, I2C_MASTER_LAST_NACK);
+	}
+	i2c_master_stop(cmd);
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	esp_err_t err = i2c_master_cmd_begin(port, cmd, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS));
+	xSemaphoreGive(mutex);
+	i2c_cmd_link_delete(cmd);
+	return err;
+}
+
+/**
+ * 清除总线：从机在传输中途被打断（复位、干扰）时会一直拉低SDA，控制器此后的事务全部超时。
+ * SCL临时切换为GPIO，输出时钟直到从机送完剩余的位并释放SDA，再发出STOP，
+ * 然后把引脚交还I2C控制器并清空其FIFO。
+ * I2Cdev在调用方任务中直接执行的命令链不经过mutex，恢复期间会以错误返回一次
+ */
+bool I2cBus::recover()
+{
+	if (!started) return false;
+	gpio_num_t sda = (gpio_num_t)pin_sda;
+	gpio_num_t scl = (gpio_num_t)pin_scl;
+
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	gpio_set_level(scl, 1);
+	gpio_set_level(sda, 1);
+	gpio_set_direction(scl, GPIO_MODE_INPUT_OUTPUT_OD);
+	gpio_set_direction(sda, GPIO_MODE_INPUT_OUTPUT_OD);
+	gpio_matrix_out(scl, SIG_GPIO_OUT_IDX, false, false);
+	gpio_matrix_out(sda, SIG_GPIO_OUT_IDX, false, false);
+
+	uint8_t clocks = 0;
+	while (gpio_get_level(sda) == 0 && clocks < I2C_BUS_CLEAR_CLOCKS)
+	{
+		gpio_set_level(scl, 0);
+		ets_delay_us(5);
+		gpio_set_level(scl, 1);
+		ets_delay_us(5);
+		clocks++;
+	}
+	// STOP：SCL高时SDA由低变高
+	gpio_set_level(sda, 0);
+	ets_delay_us(5);
+	gpio_set_level(scl, 1);
+	ets_delay_us(5);
+	gpio_set_level(sda, 1);
+	ets_delay_us(5);
+	bool released = gpio_get_level(sda) == 1;
+
+	i2c_set_pin(port, pin_sda, pin_scl, GPIO_PULLUP_ENABLE, GPIO_PULLUP_ENABLE, I2C_MODE_MASTER);
+	i2c_reset_tx_fifo(port);
+	i2c_reset_rx_fifo(port);
+	xSemaphoreGive(mutex);
+
+	if (released) LOG_W("i2c", "I2C%d总线已清除（%u个时钟）", port, clocks);
+	else LOG_E("i2c", "I2C%d的SDA仍被拉低，检查从机供电与接线", port);
+	return released;
+}
+
+bool I2cBus::recoverCb(void* user)
+{
+	return ((I2cBus*)user)->recover();
+}
+
+/**
+ * 总线任务：逐个执行排队的事务并回调
+ */
+void I2cBus::taskEntry(void* arg)
+{
+	I2cBus* self = (I2cBus*)arg;
+	I2cTransaction t;
+
+	for (;;)
+	{
+		if (xQueueReceive(self->queue, &t, portMAX_DELAY) != pdTRUE) continue;
+
+		supervisor.enter(self->sup_id);
+		esp_err_t err = self->execute(t);
+		// 从机无应答（ESP_FAIL）不是总线故障，只有超时计为失败
+		supervisor.leave(self->sup_id, err != ESP_ERR_TIMEOUT);
+		if (t.cb) t.cb(err, t.user);
+	}
+}
@@ -14,113 +14,559 @@
  * - 工作电压：3.3V
  * - 采样频率：可配置，默认1kHz
  * 
- * 手势识别逻辑：
- * - Y轴加速度变化 → 旋转方向检测
- * - X轴加速度阈值 → 按压状态检测
- * - 数据滤波和防抖处理
+ * 工作模式：
+ * - 轮询模式：每次update()读取一次（14字节I2C事务，由总线任务执行）
+ * - FIFO模式：传感器以IMU_FIFO_RATE_HZ写入片上FIFO，数据就绪中断累计
+ *   IMU_FIFO_BURST个样本后唤醒传感器任务一次性读出，采样间隔由硬件保证
+ * - DMP模式：片上DMP完成姿态融合（orientation），手势使用数据包内的加速度
+ * - 融合模式：DMP初始化失败时FIFO改为ORIENT_SW_RATE_HZ，每个样本送入软件融合（orientation），
+ *   手势与总线仍按IMU_FIFO_RATE_HZ抽取，其余功能不受影响
+ * - 敲击检测：FIFO/融合模式下片上运动检测触发时，FIFO临时改为1kHz采集IMU_TAP_CAPTURE_MS，
+ *   按冲击段的峰值与能量分类，识别为敲击时向手势引擎送入一个GESTURE_TAP（双击由手势引擎组合）
+ * - 运动唤醒：suspend()后停止读取数据，加速度计低功耗周期采样，片上运动检测到移动时回调（见power.cpp）
+ * 
+ * 手势识别：
+ * - 每个样本发布到传感器总线（sensor_bus.h），手势引擎（gesture.cpp）作为第一个订阅者逐个样本接收，
+ *   由规则表识别倾斜、晃动和双击；其他功能读取总线快照或按抽取倍数订阅，不再读取ax~gz
+ * - 识别结果以带时间戳的事件送入LVGL编码器（lv_port_indev_push）
+ * - startTrace()录制送入手势引擎的样本（imu_trace.cpp），可在设备上或主机端离线回放调参
  */
 
 #include "imu.h"
 #include <MPU6050.h>        // MPU6050传感器库
-#include <Wire.h>           // I2C通信库
+#include "i2c_bus.h"        // I2C总线管理（与环境光传感器共用）
+#include "render_prof.h"    // 渲染分阶段计时
+#include "runtime.h"        // 传感器任务周期（轮询模式下轨迹的标称采样率）
+#include "fixed_math.h"     // 动态加速度的整数开方
+#include "sensor_bus.h"     // 样本快照与订阅
+
+// 统计窗口在传感器任务中累加、在读取方任务中取走
+static portMUX_TYPE window_mux = portMUX_INITIALIZER_UNLOCKED;
 
 // MPU6050传感器对象实例
 // 注意：对象在IMU类中定义，这里不需要重复定义
 //MPU6050 imu(Wire);
 
-/**** LVGL编码器输入设备全局变量 ****/
-// 这些变量在lv_port_indev.c中已经定义，这里使用extern声明
-// 编码器旋转差值，用于LVGL滚动事件
-// 正值表示顺时针旋转，负值表示逆时针旋转
-// int16_t encoder_diff = 0;
-// extern int encoder_diff;
-
-// 编码器按键状态，用于LVGL按键事件
-// LV_INDEV_STATE_PRESSED: 按下状态
-// LV_INDEV_STATE_REL: 释放状态
-// lv_indev_state_t encoder_state = LV_INDEV_STATE_REL;
-
 /**
  * IMU传感器初始化函数
  * 
  * 功能：
- * 1. 初始化I2C总线，配置SDA和SCL引脚
- * 2. 设置I2C时钟频率为400kHz（快速模式）
- * 3. 检测MPU6050连接状态，确保通信正常
- * 4. 初始化MPU6050寄存器配置
+ * 1. 通过总线管理初始化I2C总线（SDA/SCL，400kHz快速模式），已初始化时共用
+ * 2. 周期性的数据读取经总线任务执行，配置类读写仍由MPU6050库同步完成
+ * 3. 在IMU_PROBE_TIMEOUT_MS内探测MPU6050，总线异常时不会卡住开机
+ * 4. 初始化MPU6050寄存器配置，写入NVS中保存的零偏（首次开机自动校准）
+ * 5. FIFO模式下配置采样率、低通滤波、FIFO与数据就绪中断
+ *
+ * @param m 工作模式，默认轮询
+ * @return 未检测到传感器时返回false，此后update()不做任何事
  */
-void IMU::init()
+bool IMU::init(ImuMode m)
 {
-	// 初始化I2C总线，指定SDA和SCL引脚
-	Wire.begin(IMU_I2C_SDA, IMU_I2C_SCL);
-	
-	// 设置I2C时钟频率为400kHz，提高数据传输速度
-	Wire.setClock(400000);
+	mode = m;
+	fifo_rate = IMU_FIFO_RATE_HZ;
+	gesture.init();
+	for (int i = 0; i < IMU_WINDOW_COUNT; i++) sensor_window_reset(&windows[i]);
+	want_suspend = false;
+	suspended = false;
+	int_attached = false;
+	tap_enabled = false;
+	tap_int = false;
+	tap_capturing = false;
+	raw_cb = NULL;
+	raw_user = NULL;
+	raw_rate = 0;
+
+	// 初始化I2C总线，指定SDA和SCL引脚，时钟400kHz
+	if (!i2c_bus.begin(IMU_I2C_SDA, IMU_I2C_SCL, 400000))
+	{
+		connected = false;
+		return false;
+	}
 	
-	// 等待MPU6050连接成功，确保硬件通信正常
-	while (!imu.testConnection());
+	// 探测MPU6050，超时则放弃（手势输入不可用，其余功能照常启动）
+	connected = probe();
+	if (!connected)
+	{
+		Serial.println("未检测到MPU6050，跳过IMU初始化");
+		return false;
+	}
+	sensorbus.subscribe(SENSOR_IMU, 1, onSample, this);
 	
 	// 初始化MPU6050传感器，配置默认参数
 	imu.initialize();
+
+	// 读取保存的零偏；没有时在静止状态下校准一次并保存
+	calibrated = calib.load(&offsets);
+	if (calibrated) calib.apply(imu, offsets);
+	else if (IMU_CALIB_ON_FIRST_BOOT) calibrate();
+
+	if (mode == IMU_MODE_DMP)
+	{
+		if (orientation.begin())
+		{
+			// DMP初始化复位了传感器，偏移寄存器需要重新写入
+			if (calibrated) calib.apply(imu, offsets);
+			attachInt();
+			orientation.subscribe(onOrientation, this);
+		}
+		else
+		{
+			// DMP初始化已复位传感器，恢复默认配置（陀螺仪±250dps）与偏移寄存器
+			Serial.println("DMP不可用，改用软件姿态融合");
+			imu.reset();
+			delay(30);
+			imu.initialize();
+			if (calibrated) calib.apply(imu, offsets);
+			mode = IMU_MODE_FUSION;
+			fifo_rate = ORIENT_SW_RATE_HZ;
+			orientation.beginSoftware();
+		}
+	}
+	if (mode == IMU_MODE_FIFO || mode == IMU_MODE_FUSION) initFifo();
+	return true;
 }
 
 /**
- * IMU数据更新和手势识别函数
- * 
- * 参数：
- * @param interval 更新间隔时间（毫秒）
- * 
- * 功能：
- * 1. 读取MPU6050的六轴数据（3轴加速度 + 3轴角速度）
- * 2. 基于Y轴加速度变化检测旋转手势
- * 3. 基于X轴加速度阈值检测按压手势
- * 4. 转换为LVGL编码器事件格式
+ * 在超时时间内反复检测WHO_AM_I
+ */
+bool IMU::probe()
+{
+	uint32_t start = millis();
+	do
+	{
+		if (imu.testConnection()) return true;
+		delay(10);
+	} while (millis() - start < IMU_PROBE_TIMEOUT_MS);
+	return false;
+}
+
+/**
+ * 重新校准零偏并保存（设备需静止放置）
+ * 启动后调用时需在传感器任务中执行（与update()共用I2C总线）
+ *
+ * @return 校准成功并已保存返回true
  */
-void IMU::update(int interval)
+bool IMU::calibrate()
 {
-	// 读取MPU6050六轴数据：加速度计(ax,ay,az) + 陀螺仪(gx,gy,gz)
-	imu.getMotion6(&ax, &ay, &az, &gx, &gy, &gz);
+	if (!connected) return false;
 
-	// 调试输出陀螺仪数据（已注释）
-	//Serial.print(gx);
-	//Serial.print(" ");
-	//Serial.print(gy);
-	//Serial.print(" ");
-	//Serial.print(gz);
-	//Serial.println(" ");
+	ImuOffsets result;
+	if (!calib.run(imu, &result)) return false;
 
-	// 按设定间隔更新手势识别，避免过于频繁的状态变化
-	if (millis() - last_update_time > interval)
+	offsets = result;
+	calibrated = true;
+	if (!calib.save(offsets))
 	{
-		// Y轴加速度手势识别：检测上下倾斜动作
-		if (ay > 3000 && flag)  // Y轴正向倾斜超过阈值
+		Serial.println("IMU零偏保存失败");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 开机时是否检测到传感器
+ */
+bool IMU::isConnected()
+{
+	return connected;
+}
+
+/**
+ * 配置FIFO采样
+ * 采样率 = 1kHz / (1 + 分频)，FIFO中只放加速度与陀螺仪（每样本12字节）
+ */
+void IMU::initFifo()
+{
+	base_rate = fifo_rate;
+	init_rate = fifo_rate;
+	raw_rate = fifo_rate;
+	fifo_phase = 0;
+	tap_enabled = IMU_TAP_ENABLE;
+	tap_int = tap_enabled && IMU_INT_PIN >= 0;
+	tap_capturing = false;
+
+	imu.setDLPFMode(IMU_FIFO_DLPF);
+	imu.setRate(1000 / fifo_rate - 1);
+
+	imu.setAccelFIFOEnabled(true);
+	imu.setXGyroFIFOEnabled(true);
+	imu.setYGyroFIFOEnabled(true);
+	imu.setZGyroFIFOEnabled(true);
+	imu.setFIFOEnabled(true);
+	imu.resetFIFO();
+
+	// 启用敲击检测时INT只用于运动中断，FIFO按超时批量读取
+	if (IMU_INT_PIN >= 0 && !tap_int) imu.setIntDataReadyEnabled(true);
+	if (tap_enabled)
+	{
+		initTap();
+		gesture.setExternalTap(true);
+	}
+	attachInt();
+	Serial.printf("IMU FIFO模式: %dHz, 中断引脚%d%s\n", fifo_rate, IMU_INT_PIN, tap_enabled ? ", 敲击检测" : "");
+}
+
+/**
+ * 切换FIFO采样率与数字低通（敲击采集开始与结束时，FIFO中的样本已读出）
+ * 低通260Hz（DLPF关闭）时陀螺仪输出率为8kHz，分频按8kHz计算
+ */
+void IMU::setFifoRate(uint16_t rate, uint8_t dlpf)
+{
+	imu.setFIFOEnabled(false);
+	imu.setDLPFMode(dlpf);
+	imu.setRate((dlpf == MPU6050_DLPF_BW_256 ? 8000 : 1000) / rate - 1);
+	imu.resetFIFO();
+	imu.setFIFOEnabled(true);
+	fifo_rate = rate;
+	fifo_phase = 0;
+}
+
+/**
+ * 片上运动检测作为敲击触发（FIFO初始化与退出运动唤醒时配置）
+ * 数字高通只作用于运动检测，数据寄存器与FIFO中的加速度不受影响
+ */
+void IMU::initTap()
+{
+	imu.setDHPFMode(MPU6050_DHPF_5);
+	imu.setMotionDetectionThreshold(IMU_TAP_MOT_THRESHOLD);
+	imu.setMotionDetectionDuration(1);
+	imu.setIntMotionEnabled(true);
+}
+
+/**
+ * 检测到运动后开始采集（传感器任务中执行）
+ */
+void IMU::beginTap()
+{
+	tap_capturing = true;
+	tap_len = 0;
+	tap_start = millis();
+	setFifoRate(IMU_TAP_RATE_HZ, MPU6050_DLPF_BW_256);
+}
+
+/**
+ * 采集窗口读满：恢复平时的采样率，分类结果送入手势引擎
+ */
+void IMU::endTap()
+{
+	tap_capturing = false;
+	setFifoRate(base_rate, IMU_FIFO_DLPF);
+
+	uint8_t n = classifyTap();
+	if (n == 0) tap_rejects++;
+	tap_count += n;
+	for (uint8_t i = 0; i < n; i++) gesture.tap(tap_start);
+}
+
+/**
+ * 采集窗口分类，触发本身计为一次敲击
+ * 偏差超过IMU_TAP_SEG_LSB的一段为冲击段（之后连续安静IMU_TAP_QUIET_MS结束），逐段计算峰值与能量：
+ * - 等效宽度 能量 / 峰值² 超过IMU_TAP_WIDTH_MS：持续的运动（搬动、晃动），整个窗口不算敲击
+ * - 窗口结束时仍未安静：运动在继续，同样不算
+ * - 不是紧接触发的段（前面有安静）且峰值达到IMU_TAP_PEAK_LSB：窗口内的又一次敲击
+ *
+ * @return 敲击次数（1或2），0表示不是敲击
+ */
+uint8_t IMU::classifyTap()
+{
+	uint8_t taps = 1;
+	bool first = true;
+	uint8_t i = 0;
+	while (i < tap_len)
+	{
+		if (tap_buf[i] < IMU_TAP_SEG_LSB)
 		{
-			encoder_diff--;  // 编码器计数减1（向上滚动）
-			flag = 0;        // 设置防抖标志
+			i++;
+			continue;
 		}
-		else if (ay < -3000 && flag)  // Y轴负向倾斜超过阈值
+
+		uint8_t start = i;
+		uint32_t peak = 0;
+		uint64_t energy = 0;
+		uint8_t quiet = 0;
+		for (; i < tap_len && quiet < IMU_TAP_QUIET_MS; i++)
 		{
-			encoder_diff++;  // 编码器计数加1（向下滚动）
-			flag = 0;        // 设置防抖标志
+			uint32_t v = tap_buf[i];
+			energy += v * v;
+			if (v > peak) peak = v;
+			quiet = v < IMU_TAP_SEG_LSB ? quiet + 1 : 0;
 		}
-		else
+		if (quiet < IMU_TAP_QUIET_MS) return 0;
+		if (energy > (uint64_t)peak * peak * IMU_TAP_WIDTH_MS) return 0;
+
+		bool tail = first && start < IMU_TAP_QUIET_MS;
+		if (!tail && peak >= IMU_TAP_PEAK_LSB && taps < 2) taps++;
+		first = false;
+	}
+	return taps;
+}
+
+/**
+ * 配置INT引脚并挂接中断（未连接时不做任何事）
+ * 中断源由调用方设置：FIFO模式为数据就绪，DMP模式由dmpInitialize配置
+ */
+void IMU::attachInt()
+{
+	if (IMU_INT_PIN < 0) return;
+
+	// 高电平有效、推挽输出、50us脉冲，任意读操作清除中断
+	imu.setInterruptMode(false);
+	imu.setInterruptDrive(false);
+	imu.setInterruptLatch(false);
+	imu.setInterruptLatchClear(true);
+
+	pinMode(IMU_INT_PIN, INPUT);
+	attachInterruptArg(digitalPinToInterrupt(IMU_INT_PIN), intISR, this, RISING);
+	int_attached = true;
+}
+
+/**
+ * 数据就绪中断：累计IMU_FIFO_BURST个样本后通知读取任务（融合模式按采样率等比增加，唤醒间隔不变）
+ */
+void IRAM_ATTR IMU::intISR(void* arg)
+{
+	IMU* self = (IMU*)arg;
+	// 运动唤醒期间与敲击检测时的中断为运动检测，立即通知
+	if (!self->suspended && !self->tap_int && ++self->pending < IMU_FIFO_BURST * self->fifo_rate / IMU_FIFO_RATE_HZ) return;
+	if (self->notify_task == NULL) return;
+
+	self->pending = 0;
+	BaseType_t woken = pdFALSE;
+	vTaskNotifyGiveFromISR(self->notify_task, &woken);
+	if (woken) portYIELD_FROM_ISR();
+}
+
+/**
+ * 一次读出FIFO中的全部完整样本，保留最新一组作为当前值
+ * FIFO溢出（1024字节）时数据错位，直接复位重新开始
+ * 样本按采样率抽取：每fifo_rate / IMU_FIFO_RATE_HZ个送入手势引擎一次，
+ * 融合模式下每fifo_rate / ORIENT_SW_RATE_HZ个送入姿态融合一次（平时为每个样本），
+ * 有原始样本流时每fifo_rate / base_rate个回调一次（平时为每个样本）
+ * 敲击检测：采集期间记录每个样本相对基线的偏差，平时更新基线；读完后结束采集或响应运动标志
+ */
+void IMU::drainFifo()
+{
+	// 读INT_STATUS同时清除中断标志
+	uint8_t status = 0;
+	uint8_t cnt[2];
+	if (i2c_bus.readRegs(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_INT_STATUS, &status, 1) != ESP_OK) return;
+	if (status & (1 << MPU6050_INTERRUPT_FIFO_OFLOW_BIT))
+	{
+		imu.resetFIFO();
+		overflow_count++;
+		if (tap_capturing)
 		{
-			flag = 1;  // 重置防抖标志，允许下次检测
+			tap_capturing = false;
+			setFifoRate(base_rate, IMU_FIFO_DLPF);
 		}
+		return;
+	}
+	// 采集期间的运动标志属于本窗口，不再触发新的采集
+	bool motion = tap_enabled && !tap_capturing && (status & (1 << MPU6050_INTERRUPT_MOT_BIT));
+	if (i2c_bus.readRegs(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_FIFO_COUNTH, cnt, 2) != ESP_OK) return;
+
+	uint16_t count = ((cnt[0] << 8) | cnt[1]) / IMU_FIFO_PACKET;
+	// 每次I2C事务最多读8个样本（96字节，控制栈上缓冲区大小）
+	uint8_t burst[IMU_FIFO_PACKET * 8];
+	// 样本时间按采样间隔从当前时间倒推，最后一个样本对应当前时间
+	uint32_t back = count > 0 ? count - 1 : 0;
+	uint32_t t = millis() - back * (1000 / fifo_rate);
+	uint32_t t_us = micros() - back * (1000000 / fifo_rate);
+	uint16_t decim = fifo_rate / IMU_FIFO_RATE_HZ;
+	uint16_t orient_decim = fifo_rate / ORIENT_SW_RATE_HZ;
+	uint16_t raw_decim = fifo_rate / base_rate;
+	imu_raw_cb_t raw = raw_cb;
+	while (count > 0)
+	{
+		uint8_t n = count > 8 ? 8 : count;
+		if (i2c_bus.readRegs(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_FIFO_R_W, burst, n * IMU_FIFO_PACKET) != ESP_OK) return;
+		count -= n;
 
-		// X轴加速度按压检测：检测前后倾斜或震动
-		if (ax > 10000)  // X轴加速度超过按压阈值
+		for (uint8_t i = 0; i < n; i++)
 		{
-			encoder_state = LV_INDEV_STATE_PR;   // 设置为按下状态
+			const uint8_t* p = burst + i * IMU_FIFO_PACKET;
+			ax = (p[0] << 8) | p[1];
+			ay = (p[2] << 8) | p[3];
+			az = (p[4] << 8) | p[5];
+			gx = (p[6] << 8) | p[7];
+			gy = (p[8] << 8) | p[9];
+			gz = (p[10] << 8) | p[11];
+			if (tap_capturing)
+			{
+				if (tap_len < IMU_TAP_CAPTURE_MS)
+				{
+					int32_t d = abs(ax - (tap_base[0] >> 3)) + abs(ay - (tap_base[1] >> 3)) + abs(az - (tap_base[2] >> 3));
+					tap_buf[tap_len++] = d > 0xFFFF ? 0xFFFF : d;
+				}
+			}
+			else if (tap_enabled)
+			{
+				tap_base[0] += ax - (tap_base[0] >> 3);
+				tap_base[1] += ay - (tap_base[1] >> 3);
+				tap_base[2] += az - (tap_base[2] >> 3);
+			}
+			if (mode == IMU_MODE_FUSION && fifo_phase % orient_decim == 0)
+			{
+				int16_t a[3] = {ax, ay, az};
+				int16_t g[3] = {gx, gy, gz};
+				orientation.feed(a, g, t_us);
+			}
+			if (raw && fifo_phase % raw_decim == 0)
+			{
+				int16_t a[3] = {ax, ay, az};
+				int16_t g[3] = {gx, gy, gz};
+				raw(a, g, t_us, raw_user);
+			}
+			if (fifo_phase % decim == 0) feed(t);
+			if (++fifo_phase >= fifo_rate) fifo_phase = 0;
+			sample_count++;
+			t += 1000 / fifo_rate;
+			t_us += 1000000 / fifo_rate;
 		}
-		else
+	}
+
+	if (tap_capturing && tap_len >= IMU_TAP_CAPTURE_MS) endTap();
+	else if (motion) beginTap();
+}
+
+/**
+ * IMU数据更新函数（在传感器任务中调用）
+ * 
+ * 功能：
+ * 1. 读取MPU6050的六轴数据（3轴加速度 + 3轴角速度），FIFO模式下批量读出
+ * 2. 每个样本送入手势引擎，由引擎产生编码器事件
+ * 3. DMP模式下样本在orientation回调中送入手势引擎，融合模式下FIFO样本同时送入软件融合
+ * 4. 运动唤醒期间只检查运动标志（见suspend()）
+ */
+void IMU::update()
+{
+	if (!connected) return;
+	if (want_suspend || suspended)
+	{
+		checkMotionWake();
+		if (suspended) return;
+	}
+
+	render_prof_begin(RENDER_PROF_IMU);
+	if (mode == IMU_MODE_FIFO || mode == IMU_MODE_FUSION)
+	{
+		drainFifo();
+		// 原始样本流要求的采样率（FIFO中的样本已读出，敲击采集结束后再切换）
+		if (raw_rate != base_rate && !tap_capturing)
+		{
+			base_rate = raw_rate;
+			setFifoRate(base_rate, IMU_FIFO_DLPF);
+		}
+	}
+	else if (mode == IMU_MODE_DMP) readDmp();
+	else
+	{
+		// 加速度XYZ、温度、陀螺仪XYZ连续14字节
+		uint8_t raw[14];
+		if (i2c_bus.readRegs(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_ACCEL_XOUT_H, raw, 14) != ESP_OK)
 		{
-			encoder_state = LV_INDEV_STATE_REL;  // 设置为释放状态
+			render_prof_end(RENDER_PROF_IMU);
+			return;
 		}
+		ax = (raw[0] << 8) | raw[1];
+		ay = (raw[2] << 8) | raw[3];
+		az = (raw[4] << 8) | raw[5];
+		gx = (raw[8] << 8) | raw[9];
+		gy = (raw[10] << 8) | raw[11];
+		gz = (raw[12] << 8) | raw[13];
+		feed(millis());
+	}
+	render_prof_end(RENDER_PROF_IMU);
+}
+
+/**
+ * 当前样本（ax~gz）发布到传感器总线（手势引擎在订阅回调中接收），录制轨迹时同时写入
+ */
+void IMU::feed(uint32_t now)
+{
+	trace.push(ax, ay, az, gx, gy, gz, now);
+	accumulate(ax, ay, az);
+
+	SensorSample s = {};
+	s.time_ms = now;
+	s.accel[0] = ax;
+	s.accel[1] = ay;
+	s.accel[2] = az;
+	s.gyro[0] = gx;
+	s.gyro[1] = gy;
+	s.gyro[2] = gz;
+	sensorbus.publish(SENSOR_IMU, &s);
+}
+
+/**
+ * 总线样本回调（传感器任务中执行）：每个样本都送入手势引擎
+ */
+void IMU::onSample(const SensorSample* s, void* user)
+{
+	IMU* self = (IMU*)user;
+	self->gesture.feed(s->accel[0], s->accel[1], s->accel[2], s->gyro[0], s->gyro[1], s->gyro[2], s->time_ms);
+}
+
+/**
+ * 样本计入统计窗口（传感器任务/DMP回调中执行，只有整数运算）
+ */
+void IMU::accumulate(int16_t x, int16_t y, int16_t z)
+{
+	// 3 * 32768^2 < 2^32，平方和不会溢出
+	uint32_t sq = (uint32_t)((int32_t)x * x) + (uint32_t)((int32_t)y * y) + (uint32_t)((int32_t)z * z);
+	int32_t dyn = (int32_t)fx_isqrt(sq) - 16384;
+	if (dyn < 0) dyn = -dyn;
+
+	portENTER_CRITICAL(&window_mux);
+	sensor_window_add(&windows[IMU_WINDOW_AX], x);
+	sensor_window_add(&windows[IMU_WINDOW_AY], y);
+	sensor_window_add(&windows[IMU_WINDOW_AZ], z);
+	sensor_window_add(&windows[IMU_WINDOW_MOTION], dyn * 1000 >> 14);
+	portEXIT_CRITICAL(&window_mux);
+}
 
-		// 更新时间戳
-		last_update_time = millis();
+/**
+ * 取走上次调用以来的统计窗口，随即清零
+ */
+void IMU::takeWindows(SensorWindow* out)
+{
+	portENTER_CRITICAL(&window_mux);
+	for (int i = 0; i < IMU_WINDOW_COUNT; i++)
+	{
+		out[i] = windows[i];
+		sensor_window_reset(&windows[i]);
 	}
+	portEXIT_CRITICAL(&window_mux);
+}
+
+/**
+ * 获取手势引擎（注册监听者、替换规则表）
+ */
+GestureEngine* IMU::getGesture()
+{
+	return &gesture;
+}
+
+/**
+ * 开始录制手势引擎的输入样本（.imt，格式见imu_trace_format.h）
+ * 可在任意任务中调用；用getTrace()->mark()插入手势标注，用ImuTrace::replay()回放评估
+ */
+bool IMU::startTrace(const char* path)
+{
+	if (!connected) return false;
+	uint16_t rate = mode == IMU_MODE_FIFO || mode == IMU_MODE_FUSION ? IMU_FIFO_RATE_HZ
+		: mode == IMU_MODE_POLL ? 1000 / SENSOR_TASK_PERIOD_MS : 0;
+	return trace.start(path, rate, mode);
+}
+
+void IMU::stopTrace()
+{
+	trace.stop();
+}
+
+ImuTrace* IMU::getTrace()
+{
+	return &trace;
 }
 
 /**
@@ -176,3 +622,233 @@ int16_t IMU::getGyroZ()
 {
 	return gz;
 }
+
+/**
+ * DMP模式：读出姿态数据包，原始加速度/角速度取最新一包
+ */
+void IMU::readDmp()
+{
+	sample_count += orientation.poll();
+
+	OrientationData d;
+	if (!orientation.get(&d)) return;
+	// DMP数据包中加速度为8192/g，换算到与getMotion6相同的16384/g
+	ax = d.accel.x * 2;
+	ay = d.accel.y * 2;
+	az = d.accel.z * 2;
+	gx = d.gyro.x;
+	gy = d.gyro.y;
+	gz = d.gyro.z;
+}
+
+/**
+ * DMP数据包回调：每个数据包都作为一个样本发布（加速度同样换算到16384/g）
+ */
+void IMU::onOrientation(const OrientationData* d, void* user)
+{
+	IMU* self = (IMU*)user;
+	self->ax = d->accel.x * 2;
+	self->ay = d->accel.y * 2;
+	self->az = d->accel.z * 2;
+	self->gx = d->gyro.x;
+	self->gy = d->gyro.y;
+	self->gz = d->gyro.z;
+	self->feed(d->timestamp / 1000);
+}
+
+/**
+ * 获取当前工作模式
+ */
+ImuMode IMU::getMode()
+{
+	return mode;
+}
+
+/**
+ * 指定接收数据就绪通知的任务（FIFO/DMP模式下的传感器任务）
+ */
+void IMU::attachTask(TaskHandle_t task)
+{
+	notify_task = task;
+}
+
+/**
+ * 等待FIFO中累计足够样本（未连接中断引脚时即为定时等待）
+ */
+void IMU::waitData(TickType_t timeout)
+{
+	// 敲击采集期间在窗口读满时醒来（FIFO中只有约一个窗口的样本）
+	if (tap_capturing)
+	{
+		uint32_t elapsed = millis() - tap_start;
+		TickType_t left = pdMS_TO_TICKS((elapsed < IMU_TAP_CAPTURE_MS ? IMU_TAP_CAPTURE_MS - elapsed : 0) + 1);
+		if (left < timeout) timeout = left;
+	}
+	ulTaskNotifyTake(pdTRUE, timeout);
+}
+
+/**
+ * 停止读取数据，进入运动唤醒（可在任意任务中调用，由传感器任务在下一次update()中配置传感器）
+ * 检测到移动时在传感器任务中调用setMotionCallback设置的回调，回调中应调用resume()
+ * 有原始样本流（数据记录）时不进入
+ */
+void IMU::suspend()
+{
+	if (!connected || want_suspend || raw_cb) return;
+	want_suspend = true;
+	if (notify_task) xTaskNotifyGive(notify_task);
+}
+
+/**
+ * 恢复正常读取（可在任意任务中调用）
+ */
+void IMU::resume()
+{
+	if (!want_suspend) return;
+	want_suspend = false;
+	if (notify_task) xTaskNotifyGive(notify_task);
+}
+
+/**
+ * 是否处于运动唤醒（传感器任务据此延长等待时间）
+ */
+bool IMU::isSuspended()
+{
+	return suspended;
+}
+
+/**
+ * 运动唤醒期间检测到移动时的回调（在传感器任务中执行）
+ */
+void IMU::setMotionCallback(void (*cb)(void* user), void* user)
+{
+	motion_user = user;
+	motion_cb = cb;
+}
+
+bool IMU::setRawStream(imu_raw_cb_t cb, void* user, uint16_t rate_hz)
+{
+	if (!connected || (mode != IMU_MODE_FIFO && mode != IMU_MODE_FUSION)) return false;
+	if (cb && (rate_hz < init_rate || rate_hz > IMU_RAW_RATE_MAX || rate_hz % init_rate || 1000 % rate_hz))
+		return false;
+	// 先停止回调再更换参数，传感器任务每批样本只读取一次回调指针
+	raw_cb = NULL;
+	raw_user = user;
+	raw_cb = cb;
+	raw_rate = cb ? rate_hz : init_rate;
+	// 运动唤醒期间没有样本
+	if (cb) resume();
+	if (notify_task) xTaskNotifyGive(notify_task);
+	return true;
+}
+
+/**
+ * 传感器任务中切换运动唤醒状态并检查运动标志
+ * 读INT_STATUS同时清除标志（锁存的INT引脚随之复位）
+ */
+void IMU::checkMotionWake()
+{
+	if (want_suspend && !suspended)
+	{
+		enterMotionWake();
+		return;
+	}
+
+	uint8_t status = 0;
+	if (i2c_bus.readRegs(MPU6050_DEFAULT_ADDRESS, MPU6050_RA_INT_STATUS, &status, 1) == ESP_OK &&
+		(status & (1 << MPU6050_INTERRUPT_MOT_BIT)) && motion_cb)
+	{
+		motion_cb(motion_user);
+	}
+	if (!want_suspend) exitMotionWake();
+}
+
+/**
+ * 配置低功耗运动检测：停止FIFO/DMP，陀螺仪与温度传感器待机，加速度计周期唤醒采样
+ * INT引脚改为锁存，保证浅睡眠中按电平唤醒时不会错过50us脉冲
+ */
+void IMU::enterMotionWake()
+{
+	saved_int = imu.getIntEnabled();
+	if (tap_capturing)
+	{
+		tap_capturing = false;
+		setFifoRate(base_rate, IMU_FIFO_DLPF);
+	}
+	if (mode == IMU_MODE_DMP) imu.setDMPEnabled(false);
+	if (mode == IMU_MODE_FIFO || mode == IMU_MODE_FUSION) imu.setFIFOEnabled(false);
+
+	imu.setDHPFMode(MPU6050_DHPF_5);
+	imu.setMotionDetectionThreshold(IMU_MOTION_THRESHOLD);
+	imu.setMotionDetectionDuration(IMU_MOTION_DURATION);
+	// 轮询模式平时不使用INT引脚，第一次进入时挂接中断
+	if (mode == IMU_MODE_POLL && !int_attached) attachInt();
+	imu.setInterruptLatch(true);
+	imu.setIntEnabled(1 << MPU6050_INTERRUPT_MOT_BIT);
+
+	imu.setStandbyXGyroEnabled(true);
+	imu.setStandbyYGyroEnabled(true);
+	imu.setStandbyZGyroEnabled(true);
+	imu.setTempSensorEnabled(false);
+	imu.setWakeFrequency(IMU_MOTION_WAKE_FREQ);
+	imu.setWakeCycleEnabled(true);
+
+	imu.getIntStatus();
+	suspended = true;
+	Serial.println("IMU进入运动唤醒");
+}
+
+/**
+ * 恢复连续采样与原来的中断配置，FIFO中的旧数据丢弃
+ * 陀螺仪从待机恢复约需30ms，最初几个样本的角速度可能偏小
+ */
+void IMU::exitMotionWake()
+{
+	imu.setWakeCycleEnabled(false);
+	imu.setTempSensorEnabled(true);
+	imu.setStandbyXGyroEnabled(false);
+	imu.setStandbyYGyroEnabled(false);
+	imu.setStandbyZGyroEnabled(false);
+
+	// 敲击检测继续使用运动检测，恢复其阈值
+	if (tap_enabled) initTap();
+	else imu.setDHPFMode(MPU6050_DHPF_RESET);
+	imu.setIntEnabled(saved_int);
+	imu.setInterruptLatch(false);
+
+	if (mode == IMU_MODE_FIFO || mode == IMU_MODE_FUSION)
+	{
+		imu.setFIFOEnabled(true);
+		imu.resetFIFO();
+	}
+	if (mode == IMU_MODE_DMP)
+	{
+		imu.resetFIFO();
+		imu.setDMPEnabled(true);
+	}
+	pending = 0;
+	suspended = false;
+}
+
+/**
+ * FIFO模式下累计读取的样本数与溢出次数（用于确认采样无丢失）
+ */
+uint32_t IMU::getSampleCount()
+{
+	return sample_count;
+}
+
+uint32_t IMU::getOverflowCount()
+{
+	return overflow_count;
+}
+
+uint32_t IMU::getTapCount()
+{
+	return tap_count;
+}
+
+uint32_t IMU::getTapRejects()
+{
+	return tap_rejects;
+}
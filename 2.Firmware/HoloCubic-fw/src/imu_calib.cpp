@@ -0,0 +1,173 @@
+/*
+ * HoloCubic IMU校准存储模块
+ *
+ * 功能说明：
+ * 1. 在静止状态下迭代搜索MPU6050加速度计与陀螺仪零偏
+ * 2. 零偏保存在NVS（Preferences），不依赖SD卡，开机时在IMU初始化阶段即可读取
+ * 3. 开机时写入偏移寄存器，各台设备的手势阈值因此一致
+ *
+ * 偏移寄存器与读数的比例（±2g/±250dps量程下）：
+ * - 加速度偏移1LSB约等于读数8LSB
+ * - 陀螺仪偏移1LSB约等于读数4LSB
+ */
+
+#include "imu_calib.h"
+#include <Preferences.h>
+
+/**
+ * 从NVS读取已保存的零偏
+ *
+ * @return 没有数据或版本不匹配时返回false
+ */
+bool ImuCalibration::load(ImuOffsets* out)
+{
+	Preferences prefs;
+	if (!prefs.begin(IMU_CALIB_NAMESPACE, true)) return false;
+
+	bool ok = prefs.getUChar("ver", 0) == IMU_CALIB_VERSION &&
+		prefs.getBytes("offsets", out, sizeof(ImuOffsets)) == sizeof(ImuOffsets);
+	prefs.end();
+	return ok;
+}
+
+/**
+ * 保存零偏到NVS
+ */
+bool ImuCalibration::save(const ImuOffsets& offsets)
+{
+	Preferences prefs;
+	if (!prefs.begin(IMU_CALIB_NAMESPACE, false)) return false;
+
+	bool ok = prefs.putBytes("offsets", &offsets, sizeof(ImuOffsets)) == sizeof(ImuOffsets) &&
+		prefs.putUChar("ver", IMU_CALIB_VERSION) == 1;
+	prefs.end();
+	return ok;
+}
+
+/**
+ * 清除已保存的零偏（下次开机重新校准）
+ */
+void ImuCalibration::erase()
+{
+	Preferences prefs;
+	if (!prefs.begin(IMU_CALIB_NAMESPACE, false)) return;
+	prefs.clear();
+	prefs.end();
+}
+
+/**
+ * 写入偏移寄存器
+ * 注意：DMP初始化会复位传感器，偏移需在orientation.begin()之后重新写入
+ */
+void ImuCalibration::apply(MPU6050& dev, const ImuOffsets& offsets)
+{
+	dev.setXAccelOffset(offsets.accel[0]);
+	dev.setYAccelOffset(offsets.accel[1]);
+	dev.setZAccelOffset(offsets.accel[2]);
+	dev.setXGyroOffset(offsets.gyro[0]);
+	dev.setYGyroOffset(offsets.gyro[1]);
+	dev.setZGyroOffset(offsets.gyro[2]);
+}
+
+/**
+ * 采集一轮样本求平均
+ *
+ * @param mean 输出ax,ay,az,gx,gy,gz的平均值
+ * @return 设备在移动时返回false
+ */
+bool ImuCalibration::measure(MPU6050& dev, int32_t mean[6])
+{
+	int32_t sum[6] = { 0 };
+	int16_t gmin = INT16_MAX;
+	int16_t gmax = INT16_MIN;
+
+	for (uint16_t i = 0; i < IMU_CALIB_SAMPLES; i++)
+	{
+		int16_t v[6];
+		dev.getMotion6(&v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+		for (uint8_t k = 0; k < 6; k++) sum[k] += v[k];
+		for (uint8_t k = 3; k < 6; k++)
+		{
+			if (v[k] < gmin) gmin = v[k];
+			if (v[k] > gmax) gmax = v[k];
+		}
+		// 默认采样率1kHz，间隔2ms读取避免连续读到同一组数据
+		delay(2);
+	}
+
+	for (uint8_t k = 0; k < 6; k++) mean[k] = sum[k] / IMU_CALIB_SAMPLES;
+	return gmax - gmin <= IMU_CALIB_MOTION_LIMIT;
+}
+
+/**
+ * 搜索零偏（设备需静止放置）
+ * 重力轴取平均读数绝对值最大的加速度轴，目标为±16384，其余五个通道目标为0
+ *
+ * @param out 输出零偏（已写入传感器）
+ * @return 未收敛或检测到移动时返回false，传感器恢复为原有偏移
+ */
+bool ImuCalibration::run(MPU6050& dev, ImuOffsets* out)
+{
+	ImuOffsets prev;
+	prev.accel[0] = dev.getXAccelOffset();
+	prev.accel[1] = dev.getYAccelOffset();
+	prev.accel[2] = dev.getZAccelOffset();
+	prev.gyro[0] = dev.getXGyroOffset();
+	prev.gyro[1] = dev.getYGyroOffset();
+	prev.gyro[2] = dev.getZGyroOffset();
+
+	ImuOffsets cur = prev;
+	int32_t mean[6];
+	if (!measure(dev, mean))
+	{
+		Serial.println("IMU校准失败：设备未静止");
+		return false;
+	}
+
+	// 确定重力轴及方向
+	uint8_t g_axis = 0;
+	for (uint8_t k = 1; k < 3; k++)
+	{
+		if (abs(mean[k]) > abs(mean[g_axis])) g_axis = k;
+	}
+	int32_t g_target = mean[g_axis] > 0 ? 16384 : -16384;
+
+	for (uint8_t round = 0; round < IMU_CALIB_MAX_ROUNDS; round++)
+	{
+		bool done = true;
+		for (uint8_t k = 0; k < 3; k++)
+		{
+			int32_t err = mean[k] - (k == g_axis ? g_target : 0);
+			if (abs(err) > IMU_CALIB_ACCEL_TOL)
+			{
+				done = false;
+				cur.accel[k] -= err / 8;
+			}
+			err = mean[k + 3];
+			if (abs(err) > IMU_CALIB_GYRO_TOL)
+			{
+				done = false;
+				// 余量小于比例时至少修正1，避免停在死区外
+				cur.gyro[k] -= err / 4 ? err / 4 : (err > 0 ? 1 : -1);
+			}
+		}
+		if (done)
+		{
+			*out = cur;
+			Serial.printf("IMU校准完成（%d轮）: A %d %d %d G %d %d %d\n", round,
+				cur.accel[0], cur.accel[1], cur.accel[2], cur.gyro[0], cur.gyro[1], cur.gyro[2]);
+			return true;
+		}
+
+		apply(dev, cur);
+		if (!measure(dev, mean))
+		{
+			Serial.println("IMU校准失败：设备未静止");
+			break;
+		}
+	}
+
+	apply(dev, prev);
+	Serial.println("IMU校准未收敛");
+	return false;
+}
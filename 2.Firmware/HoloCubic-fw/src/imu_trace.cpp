@@ -0,0 +1,308 @@
+/*
+ * HoloCubic IMU轨迹录制与回放
+ *
+ * 功能说明：
+ * 1. 录制送入手势引擎的原始六轴样本（.imt格式见imu_trace_format.h），
+ *    两块缓冲交替：传感器任务写一块，写入任务把写满的另一块保存到SD卡
+ * 2. 可在录制中插入标注（mark），记录“此刻开始做某个手势”
+ * 3. 回放时把轨迹送入独立的手势引擎（gesture_replay.cpp），输出每类手势的
+ *    识别延迟、漏检与误触发，调整GestureRule阈值时不必再反复摆动设备
+ *
+ * 报告格式（串口）：
+ * GESTURE,trace,路径,样本数,时长ms,标注数,识别次数,丢弃数
+ * GESTURE,手势,标注数,命中,漏检,误触发,平均延迟ms,最大延迟ms
+ *
+ * 注意事项：
+ * - 写入任务来不及时（SD卡写入停顿超过一块缓冲的时长，100Hz时约1.3秒）丢弃样本并计数
+ * - 录制期间不要拔出SD卡，停止前断电时已写入的完整缓冲块仍可回放
+ */
+
+#include "imu_trace.h"
+#include <new>
+
+// 缓冲块切换与标注可能来自不同任务（传感器任务/应用），由自旋锁保护
+static portMUX_TYPE trace_mux = portMUX_INITIALIZER_UNLOCKED;
+
+ImuTrace::ImuTrace()
+{
+	buf[0] = buf[1] = NULL;
+	full = -1;
+	recording = false;
+	stopping = false;
+	writer = NULL;
+	done = NULL;
+}
+
+/**
+ * 开始录制
+ *
+ * @param path    SD卡上的文件路径（已存在时覆盖）
+ * @param rate_hz 标称采样率，写入文件头
+ * @param mode    当前ImuMode，写入文件头
+ * @return 已在录制、内存不足或无法创建文件时返回false
+ */
+bool ImuTrace::start(const char* path, uint16_t rate_hz, uint8_t mode)
+{
+	if (recording || writer) return false;
+
+	buf[0] = (ImuTraceRecord*)malloc(sizeof(ImuTraceRecord) * IMU_TRACE_CHUNK);
+	buf[1] = (ImuTraceRecord*)malloc(sizeof(ImuTraceRecord) * IMU_TRACE_CHUNK);
+	if (buf[0] == NULL || buf[1] == NULL)
+	{
+		Serial.println("IMU轨迹缓冲区分配失败");
+		free(buf[0]);
+		free(buf[1]);
+		buf[0] = buf[1] = NULL;
+		return false;
+	}
+
+	file = SD_FS.open(path, FILE_WRITE);
+	if (!file)
+	{
+		Serial.printf("无法创建IMU轨迹文件%s\n", path);
+		free(buf[0]);
+		free(buf[1]);
+		buf[0] = buf[1] = NULL;
+		return false;
+	}
+
+	ImuTraceHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, IMU_TRACE_MAGIC, 4);
+	h.version = IMU_TRACE_VERSION;
+	h.header_size = sizeof(ImuTraceHeader);
+	h.rate_hz = rate_hz;
+	h.mode = mode;
+	h.start_ms = millis();
+	file.write((const uint8_t*)&h, sizeof(h));
+
+	if (done == NULL) done = xSemaphoreCreateBinary();
+	fill = 0;
+	cur = 0;
+	full = -1;
+	count = 0;
+	dropped = 0;
+	last_ms = h.start_ms;
+	stopping = false;
+
+	if (xTaskCreatePinnedToCore(writerEntry, "imu_trace", IMU_TRACE_TASK_STACK, this,
+								IMU_TRACE_TASK_PRIORITY, &writer, IMU_TRACE_TASK_CORE) != pdPASS)
+	{
+		writer = NULL;
+		file.close();
+		free(buf[0]);
+		free(buf[1]);
+		buf[0] = buf[1] = NULL;
+		return false;
+	}
+
+	portENTER_CRITICAL(&trace_mux);
+	recording = true;
+	portEXIT_CRITICAL(&trace_mux);
+	Serial.printf("开始录制IMU轨迹：%s\n", path);
+	return true;
+}
+
+/**
+ * 停止录制：写入剩余记录并关闭文件（等待写入任务完成）
+ */
+void ImuTrace::stop()
+{
+	if (writer == NULL) return;
+
+	portENTER_CRITICAL(&trace_mux);
+	recording = false;
+	portEXIT_CRITICAL(&trace_mux);
+
+	stopping = true;
+	xTaskNotifyGive(writer);
+	xSemaphoreTake(done, portMAX_DELAY);
+	writer = NULL;
+
+	free(buf[0]);
+	free(buf[1]);
+	buf[0] = buf[1] = NULL;
+	Serial.printf("IMU轨迹已保存：%u条记录，丢弃%u条\n", count, dropped);
+}
+
+bool ImuTrace::isRecording()
+{
+	return recording;
+}
+
+/**
+ * 追加一条记录；当前块写满且另一块仍在写入时丢弃
+ * @return 未在录制或被丢弃时返回false
+ */
+bool ImuTrace::append(const ImuTraceRecord* r)
+{
+	bool notify = false;
+
+	portENTER_CRITICAL(&trace_mux);
+	if (!recording)
+	{
+		portEXIT_CRITICAL(&trace_mux);
+		return false;
+	}
+	if (fill == IMU_TRACE_CHUNK)
+	{
+		if (full >= 0)
+		{
+			dropped++;
+			portEXIT_CRITICAL(&trace_mux);
+			return false;
+		}
+		full = cur;
+		cur ^= 1;
+		fill = 0;
+		notify = true;
+	}
+	buf[cur][fill++] = *r;
+	count++;
+	if (fill == IMU_TRACE_CHUNK && full < 0)
+	{
+		full = cur;
+		cur ^= 1;
+		fill = 0;
+		notify = true;
+	}
+	portEXIT_CRITICAL(&trace_mux);
+
+	if (notify) xTaskNotifyGive(writer);
+	return true;
+}
+
+/**
+ * 记录一个样本（传感器任务中，与送入手势引擎的值和时间相同）
+ * 批量读出的样本时间是倒推的，可能早于上一条，此时间隔记为0
+ */
+void ImuTrace::push(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz, uint32_t now)
+{
+	if (!recording) return;
+
+	int32_t dt = (int32_t)(now - last_ms);
+	if (dt < 0) dt = 0;
+	if (dt > IMU_TRACE_LABEL - 1) dt = IMU_TRACE_LABEL - 1;
+
+	ImuTraceRecord r = { (uint16_t)dt, { ax, ay, az, gx, gy, gz } };
+	// 丢弃的样本不推进时间，下一条样本的间隔包含这段空缺
+	if (append(&r)) last_ms += dt;
+}
+
+/**
+ * 插入标注：此刻开始做type手势，期望在window_ms内识别（可在任意任务中调用）
+ */
+void ImuTrace::mark(GestureType type, uint16_t window_ms)
+{
+	if (!recording) return;
+	ImuTraceRecord r = { IMU_TRACE_LABEL, { (int16_t)type, (int16_t)window_ms, 0, 0, 0, 0 } };
+	append(&r);
+}
+
+uint32_t ImuTrace::getCount()
+{
+	return count;
+}
+
+uint32_t ImuTrace::getDropped()
+{
+	return dropped;
+}
+
+/**
+ * 写入任务：保存写满的缓冲块；停止时写入剩余部分后关闭文件并退出
+ */
+void ImuTrace::writerEntry(void* arg)
+{
+	ImuTrace* self = (ImuTrace*)arg;
+
+	while (true)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		int8_t b = self->full;
+		if (b >= 0)
+		{
+			self->file.write((const uint8_t*)self->buf[b], sizeof(ImuTraceRecord) * IMU_TRACE_CHUNK);
+			portENTER_CRITICAL(&trace_mux);
+			self->full = -1;
+			portEXIT_CRITICAL(&trace_mux);
+		}
+
+		if (self->stopping)
+		{
+			// recording已清除，不会再有追加
+			if (self->fill) self->file.write((const uint8_t*)self->buf[self->cur], sizeof(ImuTraceRecord) * self->fill);
+			self->file.close();
+			xSemaphoreGive(self->done);
+			vTaskDelete(NULL);
+		}
+	}
+}
+
+/**
+ * 回放轨迹并统计（在调用任务中运行，不影响当前的手势引擎与界面）
+ *
+ * @param rules 要评估的规则表，NULL时使用默认规则
+ * @return 文件不存在、格式不符或内存不足时返回false
+ */
+bool ImuTrace::replay(const char* path, GestureReplayReport* out, const GestureRule* rules, uint8_t count)
+{
+	File f = SD_FS.open(path);
+	if (!f)
+	{
+		Serial.printf("无法打开IMU轨迹%s\n", path);
+		return false;
+	}
+
+	ImuTraceHeader h;
+	if (f.read((uint8_t*)&h, sizeof(h)) != sizeof(h) || memcmp(h.magic, IMU_TRACE_MAGIC, 4) != 0 ||
+		h.version > IMU_TRACE_VERSION || h.header_size < sizeof(h))
+	{
+		Serial.printf("%s不是IMU轨迹文件\n", path);
+		f.close();
+		return false;
+	}
+	f.seek(h.header_size);
+
+	GestureReplay* rp = new (std::nothrow) GestureReplay();
+	ImuTraceRecord* recs = (ImuTraceRecord*)malloc(sizeof(ImuTraceRecord) * IMU_TRACE_READ_RECORDS);
+	if (rp == NULL || recs == NULL)
+	{
+		Serial.println("IMU轨迹回放内存不足");
+		delete rp;
+		free(recs);
+		f.close();
+		return false;
+	}
+
+	rp->begin(h.start_ms, rules, count);
+	int n;
+	while ((n = f.read((uint8_t*)recs, sizeof(ImuTraceRecord) * IMU_TRACE_READ_RECORDS)) > 0)
+	{
+		// 末尾不完整的记录（录制中断电）忽略
+		for (int i = 0; i < n / (int)sizeof(ImuTraceRecord); i++) rp->feed(&recs[i]);
+	}
+	rp->finish(out);
+
+	delete rp;
+	free(recs);
+	f.close();
+	return true;
+}
+
+/**
+ * 串口输出回放报告（只列出有标注或有识别结果的手势）
+ */
+void ImuTrace::printReport(const char* path, const GestureReplayReport* r)
+{
+	Serial.printf("GESTURE,trace,%s,%u,%u,%u,%u,%u\n", path, r->samples, r->duration_ms,
+		r->labels, r->events, r->dropped);
+	for (uint8_t i = 1; i < GESTURE_TYPE_COUNT; i++)
+	{
+		const GestureReplayStats* s = &r->type[i];
+		if (s->labels == 0 && s->hits == 0 && s->false_pos == 0) continue;
+		Serial.printf("GESTURE,%s,%u,%u,%u,%u,%u,%u\n", gesture_name((GestureType)i), s->labels, s->hits,
+			s->misses, s->false_pos, s->hits ? s->latency_sum_ms / s->hits : 0, s->latency_max_ms);
+	}
+}
@@ -0,0 +1,380 @@
+/*
+ * HoloCubic JPEG解码模块
+ *
+ * 功能说明：
+ * 1. 封装ESP32 ROM中的tjpgd，解码基线JPEG（不支持渐进式）
+ * 2. 解码结果按MCU行拼成条带输出，只需一行MCU大小的缓冲区（240x16x2=7.5KB）
+ * 3. 注册为LVGL图像解码器，相册等场景可直接lv_img_set_src("S:/xxx.jpg")
+ *
+ * 性能说明：
+ * - JPEG体积通常只有.bin的1/5~1/10，以CPU解码换取SD与SPI带宽
+ * - LVGL按行读取时，若请求的行早于当前条带，需要从头重新解码；
+ *   LVGL自上而下刷新，显示缓冲行数越大，重解码次数越少
+ */
+
+#include "jpeg_decoder.h"
+#include <esp_heap_caps.h>
+#include "logger.h"
+#include "buf_manager.h"
+#include <src/lv_gpu/lv_gpu_esp32.h>  // 面板字节序时的交换复制
+
+JpegDecoder::JpegDecoder()
+	: work(NULL), src(NULL), src_len(0), src_pos(0), reader(NULL), reader_user(NULL), scale(0),
+	  band(NULL), band_w(0), out_w(0), band_y(0), band_h(0), band_cb(NULL), band_user(NULL)
+{
+}
+
+JpegDecoder::~JpegDecoder()
+{
+	release();
+}
+
+/**
+ * 准备解码一幅内存中的JPEG
+ * 数据需在decode()结束前保持有效
+ *
+ * @return 文件头解析成功返回true
+ */
+bool JpegDecoder::open(const uint8_t* data, uint32_t len)
+{
+	src = data;
+	src_len = len;
+	src_pos = 0;
+	reader = NULL;
+	return prepare();
+}
+
+/**
+ * 准备解码一幅流式输入的JPEG（只能顺序读取：每次decode()之前需重新open()并从头提供数据）
+ */
+bool JpegDecoder::open(jpeg_read_cb_t read, void* user)
+{
+	src = NULL;
+	reader = read;
+	reader_user = user;
+	return prepare();
+}
+
+bool JpegDecoder::prepare()
+{
+	if (work == NULL) work = (uint8_t*)heap_caps_malloc(JPEG_WORK_SIZE, MALLOC_CAP_8BIT);
+	if (work == NULL) return false;
+
+	JRESULT res = jd_prepare(&jdec, inputFunc, work, JPEG_WORK_SIZE, this);
+	if (res != JDR_OK)
+	{
+		LOG_W("jpeg", "JPEG头解析失败: %d", res);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 解码整幅图像，每完成一行MCU回调一次
+ *
+ * @return 完整解码返回true；回调中止、条带缓冲区分配失败或数据错误返回false
+ */
+bool JpegDecoder::decode(jpeg_band_cb_t cb, void* user, uint8_t scale)
+{
+	band_cb = cb;
+	band_user = user;
+	band_y = 0;
+	band_h = 0;
+	this->scale = scale > 3 ? 3 : scale;
+	out_w = scaledSize(jdec.width, this->scale);
+
+	// 条带缓冲区按输出宽度分配（大图缩小解码时只需缩小后的宽度），尺寸不变时复用
+	if (band == NULL || band_w != out_w)
+	{
+		if (band) heap_caps_free(band);
+		band = (uint16_t*)heap_caps_malloc((uint32_t)out_w * JPEG_MCU_MAX_H * sizeof(uint16_t),
+										   MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+		band_w = band ? out_w : 0;
+	}
+	if (band == NULL) return false;
+
+	JRESULT res = jd_decomp(&jdec, outputFunc, this->scale);
+	return res == JDR_OK;
+}
+
+/**
+ * 释放工作区与条带缓冲区
+ */
+void JpegDecoder::release()
+{
+	if (work) heap_caps_free(work);
+	if (band) heap_caps_free(band);
+	work = NULL;
+	band = NULL;
+	band_w = 0;
+}
+
+uint16_t JpegDecoder::getWidth()
+{
+	return jdec.width;
+}
+
+uint16_t JpegDecoder::getHeight()
+{
+	return jdec.height;
+}
+
+/**
+ * MCU高度：4:2:0为16行，4:4:4/4:2:2为8行
+ */
+uint16_t JpegDecoder::getMcuHeight()
+{
+	return jdec.msy * 8;
+}
+
+/**
+ * 按scale缩小后的宽度或高度（tjpgd逐MCU向下取整，右、下边缘不足一个输出像素的部分被舍去）
+ */
+uint16_t JpegDecoder::scaledSize(uint16_t size, uint8_t scale)
+{
+	return size >> scale;
+}
+
+/**
+ * tjpgd输入回调，buf为NULL时跳过数据
+ */
+UINT JpegDecoder::inputFunc(JDEC* jd, BYTE* buf, UINT len)
+{
+	JpegDecoder* self = (JpegDecoder*)jd->device;
+	if (self->reader) return self->reader(self->reader_user, buf, len);
+	uint32_t left = self->src_len - self->src_pos;
+	if (len > left) len = left;
+	if (buf) memcpy(buf, self->src + self->src_pos, len);
+	self->src_pos += len;
+	return len;
+}
+
+/**
+ * tjpgd输出回调
+ * 把RGB888的MCU块转换为RGB565写入条带，条带最右一块写完后输出整条带
+ */
+UINT JpegDecoder::outputFunc(JDEC* jd, void* bitmap, JRECT* rect)
+{
+	JpegDecoder* self = (JpegDecoder*)jd->device;
+	const uint8_t* rgb = (const uint8_t*)bitmap;
+	uint16_t w = rect->right - rect->left + 1;
+	uint16_t h = rect->bottom - rect->top + 1;
+
+	self->band_y = rect->top - rect->top % ((jd->msy * 8) >> self->scale);
+	uint16_t row0 = rect->top - self->band_y;
+	if (row0 + h > JPEG_MCU_MAX_H) return 0;
+
+	for (uint16_t y = 0; y < h; y++)
+	{
+		uint16_t* dst = self->band + (uint32_t)(row0 + y) * self->out_w + rect->left;
+		for (uint16_t x = 0; x < w; x++, rgb += 3)
+		{
+			dst[x] = ((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3);
+		}
+	}
+	if (row0 + h > self->band_h) self->band_h = row0 + h;
+
+	// 最右一列MCU：按原图坐标判断（MCU起点是8的倍数，缩小再放大不变），
+	// 缩小时右侧不足一个输出像素的MCU不会输出，它前面的一列就是最后一列
+	uint32_t next = ((uint32_t)rect->left << self->scale) + jd->msx * 8;
+	if (next >= jd->width || ((jd->width - next) >> self->scale) == 0)
+	{
+		bool go = self->band_cb(self->band_user, self->band_y, self->out_w, self->band_h, self->band);
+		self->band_h = 0;
+		return go ? 1 : 0;
+	}
+	return 1;
+}
+
+
+/*
+ * LVGL图像解码器
+ * 打开时只把压缩数据读入内存，按行读取时解码到所在条带并缓存该条带
+ */
+
+struct JpegLvCtx
+{
+	JpegDecoder dec;
+	uint8_t* file_data;       // 文件源时读入的压缩数据（内存源为NULL）
+	const uint8_t* data;
+	uint32_t len;
+	int32_t cached_y;         // 已缓存条带的起始行，-1表示无
+	uint16_t cached_h;
+	uint16_t want_y;          // 目标行
+	uint16_t* lines;          // 条带副本（解码回调返回后band会被覆盖）
+};
+
+static bool is_jpeg_path(const char* path)
+{
+	const char* ext = strrchr(path, '.');
+	return ext && (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0);
+}
+
+static bool is_jpeg_var(const lv_img_dsc_t* dsc)
+{
+	return dsc->header.cf == LV_IMG_CF_RAW && dsc->data_size > 2 &&
+		   dsc->data[0] == 0xFF && dsc->data[1] == 0xD8;
+}
+
+/**
+ * 读取文件源的压缩数据（通过lv_fs，可使用S:盘符）
+ *
+ * @param max 最多读取的字节数，0表示整个文件
+ */
+static uint8_t* jpeg_read_file(const char* path, uint32_t* len, uint32_t max = 0)
+{
+	lv_fs_file_t f;
+	if (lv_fs_open(&f, path, LV_FS_MODE_RD) != LV_FS_RES_OK) return NULL;
+
+	uint32_t size = 0;
+	uint8_t* buf = NULL;
+	if (lv_fs_size(&f, &size) == LV_FS_RES_OK && size > 0)
+	{
+		if (max && size > max) size = max;
+		buf = (uint8_t*)buf_alloc(BUF_BULK, size);
+		uint32_t br = 0;
+		if (buf && (lv_fs_read(&f, buf, size, &br) != LV_FS_RES_OK || br != size))
+		{
+			heap_caps_free(buf);
+			buf = NULL;
+		}
+	}
+	lv_fs_close(&f);
+	*len = size;
+	return buf;
+}
+
+static lv_res_t jpeg_lv_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+	lv_img_src_t type = lv_img_src_get_type(src);
+	JpegDecoder dec;
+	uint8_t* data = NULL;
+	uint32_t len = 0;
+	bool ok = false;
+
+	if (type == LV_IMG_SRC_FILE && is_jpeg_path((const char*)src))
+	{
+		// 只需文件头部即可解析出尺寸
+		data = jpeg_read_file((const char*)src, &len, JPEG_INFO_READ_MAX);
+		ok = data && dec.open(data, len);
+	}
+	else if (type == LV_IMG_SRC_VARIABLE && is_jpeg_var((const lv_img_dsc_t*)src))
+	{
+		const lv_img_dsc_t* dsc = (const lv_img_dsc_t*)src;
+		ok = dec.open(dsc->data, dsc->data_size);
+	}
+
+	if (ok)
+	{
+		header->always_zero = 0;
+		header->cf = LV_IMG_CF_TRUE_COLOR;
+		header->w = dec.getWidth();
+		header->h = dec.getHeight();
+	}
+	buf_free(data);
+	return ok ? LV_RES_OK : LV_RES_INV;
+}
+
+static lv_res_t jpeg_lv_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	JpegLvCtx* ctx = new JpegLvCtx();
+	ctx->file_data = NULL;
+	ctx->lines = NULL;
+	ctx->cached_y = -1;
+
+	if (dsc->src_type == LV_IMG_SRC_FILE)
+	{
+		if (!is_jpeg_path((const char*)dsc->src)) goto fail;
+		ctx->file_data = jpeg_read_file((const char*)dsc->src, &ctx->len);
+		ctx->data = ctx->file_data;
+	}
+	else if (dsc->src_type == LV_IMG_SRC_VARIABLE && is_jpeg_var((const lv_img_dsc_t*)dsc->src))
+	{
+		ctx->data = ((const lv_img_dsc_t*)dsc->src)->data;
+		ctx->len = ((const lv_img_dsc_t*)dsc->src)->data_size;
+	}
+	else goto fail;
+
+	if (ctx->data == NULL || !ctx->dec.open(ctx->data, ctx->len)) goto fail;
+
+	ctx->lines = (uint16_t*)heap_caps_malloc((uint32_t)ctx->dec.getWidth() * JPEG_MCU_MAX_H * sizeof(uint16_t),
+											 MALLOC_CAP_8BIT);
+	if (ctx->lines == NULL) goto fail;
+
+	dsc->header.cf = LV_IMG_CF_TRUE_COLOR;
+	dsc->header.w = ctx->dec.getWidth();
+	dsc->header.h = ctx->dec.getHeight();
+	dsc->img_data = NULL;       // 不提供整帧数据，LVGL逐行调用read_line
+	dsc->user_data = ctx;
+	return LV_RES_OK;
+
+fail:
+	buf_free(ctx->file_data);
+	if (ctx->lines) heap_caps_free(ctx->lines);
+	delete ctx;
+	return LV_RES_INV;
+}
+
+/**
+ * 条带回调：找到目标行所在条带后保存并中止解码
+ */
+static bool jpeg_lv_band(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px)
+{
+	JpegLvCtx* ctx = (JpegLvCtx*)user;
+	if (ctx->want_y >= y + h) return true;
+
+#if LV_COLOR_16_SWAP
+	// 解码输出为本机字节序，LVGL按面板字节序绘制
+	lv_gpu_esp32_copy_swap((lv_color_t*)ctx->lines, w, (const lv_color_t*)px, w, w, h);
+#else
+	memcpy(ctx->lines, px, (uint32_t)w * h * sizeof(uint16_t));
+#endif
+	ctx->cached_y = y;
+	ctx->cached_h = h;
+	return false;
+}
+
+static lv_res_t LV_ATTRIBUTE_HOT jpeg_lv_read_line(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc,
+								  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t* buf)
+{
+	JpegLvCtx* ctx = (JpegLvCtx*)dsc->user_data;
+	uint16_t w = ctx->dec.getWidth();
+
+	if (ctx->cached_y < 0 || y < ctx->cached_y || y >= ctx->cached_y + ctx->cached_h)
+	{
+		// tjpgd只能顺序解码，从头解到目标条带
+		ctx->want_y = y;
+		ctx->cached_y = -1;
+		if (!ctx->dec.open(ctx->data, ctx->len)) return LV_RES_INV;
+		ctx->dec.decode(jpeg_lv_band, ctx);
+		if (ctx->cached_y < 0) return LV_RES_INV;
+	}
+
+	const uint16_t* row = ctx->lines + (uint32_t)(y - ctx->cached_y) * w + x;
+	memcpy(buf, row, len * sizeof(uint16_t));
+	return LV_RES_OK;
+}
+
+static void jpeg_lv_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	JpegLvCtx* ctx = (JpegLvCtx*)dsc->user_data;
+	if (ctx == NULL) return;
+
+	buf_free(ctx->file_data);
+	if (ctx->lines) heap_caps_free(ctx->lines);
+	delete ctx;
+	dsc->user_data = NULL;
+}
+
+/**
+ * 注册JPEG解码器（需在lv_init之后调用）
+ * 新解码器插入列表头部，优先于内置.bin解码器尝试
+ */
+void jpeg_decoder_lv_init()
+{
+	lv_img_decoder_t* dec = lv_img_decoder_create();
+	lv_img_decoder_set_info_cb(dec, jpeg_lv_info);
+	lv_img_decoder_set_open_cb(dec, jpeg_lv_open);
+	lv_img_decoder_set_read_line_cb(dec, jpeg_lv_read_line);
+	lv_img_decoder_set_close_cb(dec, jpeg_lv_close);
+}
@@ -0,0 +1,251 @@
+/*
+ * HoloCubic ESP-NOW实时画面模块
+ *
+ * 功能说明：
+ * 1. 接收伴侣板经ESP-NOW发送的JPEG或RLE分片（包头见live_link.h），不需要连接AP
+ * 2. 分片按帧内位置直接写入场景播放器的槽位（ScenePlayer::liveAcquire），收齐后提交显示
+ * 3. 新帧的分片到达时放弃未收齐的旧帧；没有空闲槽位时跳过整帧，显示始终追最新的画面
+ *
+ * 数据流：
+ *   射频 --> WiFi任务 recvCb 写入槽位 --> ready_q --> LVGL任务解码/写屏 --> 槽位归还free_q
+ */
+
+#include "live_link.h"
+#include "logger.h"
+#include <esp_wifi.h>
+
+LiveLink livelink;
+
+LiveLink::LiveLink()
+{
+	player = NULL;
+	net = NULL;
+	has_peer = false;
+	running = false;
+	in_cb = false;
+	cur = -1;
+	memset(&stats, 0, sizeof(stats));
+}
+
+/**
+ * 打开播放器的实时画面并注册ESP-NOW接收回调（LVGL任务）
+ */
+bool LiveLink::start(ScenePlayer* scene, lv_obj_t* img, Network* network, SceneLiveFormat fmt, uint16_t w, uint16_t h,
+					 const uint8_t* peer_mac)
+{
+	if (running) return true;
+	if (scene == NULL || img == NULL) return false;
+
+	uint32_t max_size = fmt == SCENE_LIVE_JPEG ? LIVE_JPEG_MAX : 0;
+	if (!scene->openLive(fmt, w, h, max_size)) return false;
+
+	player = scene;
+	net = network;
+	format = fmt;
+	type = fmt == SCENE_LIVE_JPEG ? LIVE_TYPE_JPEG : LIVE_TYPE_RLE;
+	width = w;
+	height = h;
+	has_peer = peer_mac != NULL;
+	if (has_peer) memcpy(peer, peer_mac, sizeof(peer));
+	cur = -1;
+	skipping = false;
+	has_last = false;
+	memset(&stats, 0, sizeof(stats));
+
+	// ESP-NOW需要WiFi驱动已启动；未连接AP时固定在LIVE_CHANNEL上接收
+	if (WiFi.getMode() == WIFI_OFF) WiFi.mode(WIFI_STA);
+	if (!WiFi.isConnected()) esp_wifi_set_channel(LIVE_CHANNEL, WIFI_SECOND_CHAN_NONE);
+	if (esp_now_init() != ESP_OK || esp_now_register_recv_cb(recvCb) != ESP_OK)
+	{
+		LOG_E("live", "ESP-NOW初始化失败");
+		esp_now_deinit();
+		player->close();
+		player = NULL;
+		return false;
+	}
+	if (net) net->acquire();
+
+	running = true;
+	player->play(img);
+	uint8_t ch = 0;
+	wifi_second_chan_t second;
+	esp_wifi_get_channel(&ch, &second);
+	LOG_I("live", "ESP-NOW实时画面: %s %ux%u，信道%u，本机MAC %s", fmt == SCENE_LIVE_JPEG ? "JPEG" : "RLE", w, h, ch,
+		  WiFi.macAddress().c_str());
+	return true;
+}
+
+/**
+ * 停止接收：先等接收回调退出，再放弃未收齐的帧并关闭播放器（LVGL任务）
+ */
+void LiveLink::stop()
+{
+	if (!running) return;
+	running = false;
+	esp_now_unregister_recv_cb();
+	while (in_cb) vTaskDelay(1);
+	esp_now_deinit();
+	if (net) net->release();
+
+	if (cur >= 0) player->liveRelease(cur);
+	cur = -1;
+	player->close();
+	player = NULL;
+	LOG_I("live", "实时画面已停止: %u帧，放弃%u，过期包%u，无槽位%u", stats.frames, stats.dropped, stats.late, stats.busy);
+}
+
+bool LiveLink::isRunning()
+{
+	return running;
+}
+
+void LiveLink::getStats(LiveLinkStats* out)
+{
+	*out = stats;
+}
+
+void LiveLink::recvCb(const uint8_t* mac, const uint8_t* data, int len)
+{
+	livelink.onPacket(mac, data, len);
+}
+
+/**
+ * 放弃正在接收的帧，槽位归还
+ */
+void LiveLink::abandon()
+{
+	player->liveRelease(cur);
+	cur = -1;
+	stats.dropped++;
+}
+
+/**
+ * 一个分片（WiFi任务中执行，只有一次复制或RLE展开，不阻塞）
+ */
+void LiveLink::onPacket(const uint8_t* mac, const uint8_t* data, int len)
+{
+	// 先置标志再检查running：stop()清除running后等待标志清零，之后不会再访问播放器
+	in_cb = true;
+	if (!running || (has_peer && memcmp(mac, peer, sizeof(peer)) != 0) || len < (int)sizeof(LivePacketHeader))
+	{
+		in_cb = false;
+		return;
+	}
+
+	LivePacketHeader hdr;
+	memcpy(&hdr, data, sizeof(hdr));
+	if (hdr.magic[0] != LIVE_MAGIC0 || hdr.magic[1] != LIVE_MAGIC1 || hdr.type != type || hdr.chunk >= LIVE_CHUNKS_MAX)
+	{
+		in_cb = false;
+		return;
+	}
+
+	uint32_t now = millis();
+	if (cur >= 0 && hdr.frame != cur_frame)
+	{
+		if ((int16_t)(hdr.frame - cur_frame) < 0)
+		{
+			stats.late++;
+			in_cb = false;
+			return;
+		}
+		// 新帧开始：旧帧有分片丢失
+		abandon();
+	}
+	else if (cur >= 0 && now - first_ms > LIVE_FRAME_TIMEOUT_MS)
+	{
+		// 超时：此前的分片已丢失，该帧的其余分片不再接收
+		skip_frame = cur_frame;
+		abandon();
+		skipping = true;
+	}
+
+	if (cur < 0)
+	{
+		if ((has_last && (int16_t)(hdr.frame - last_frame) <= 0) || (skipping && hdr.frame == skip_frame))
+		{
+			if (!skipping || hdr.frame != skip_frame) stats.late++;
+			in_cb = false;
+			return;
+		}
+		cur = player->liveAcquire();
+		if (cur < 0)
+		{
+			skipping = true;
+			skip_frame = hdr.frame;
+			stats.busy++;
+			in_cb = false;
+			return;
+		}
+		skipping = false;
+		cur_frame = hdr.frame;
+		first_ms = now;
+		memset(chunks, 0, sizeof(chunks));
+		received = 0;
+		expected = 0;
+		jpeg_len = 0;
+	}
+
+	uint32_t bit = 1u << (hdr.chunk & 31);
+	if (chunks[hdr.chunk >> 5] & bit)
+	{
+		in_cb = false;
+		return;
+	}
+	if (!writeChunk(&hdr, data + sizeof(hdr), len - sizeof(hdr)))
+	{
+		LOG_W("live", "帧%u分片%u越界，放弃该帧", hdr.frame, hdr.chunk);
+		abandon();
+		in_cb = false;
+		return;
+	}
+	chunks[hdr.chunk >> 5] |= bit;
+	received++;
+	if (hdr.flags & LIVE_FLAG_END) expected = hdr.chunk + 1;
+
+	if (expected && received >= expected)
+	{
+		uint32_t frame_len = format == SCENE_LIVE_JPEG ? jpeg_len : player->liveCapacity();
+		player->liveCommit(cur, frame_len, cur_frame);
+		cur = -1;
+		has_last = true;
+		last_frame = cur_frame;
+		stats.frames++;
+	}
+	in_cb = false;
+}
+
+/**
+ * 把分片写入槽位：JPEG按字节偏移复制，RLE按像素偏移直接展开为槽位中的像素
+ */
+bool LiveLink::writeChunk(const LivePacketHeader* hdr, const uint8_t* payload, uint16_t len)
+{
+	uint8_t* dst = player->liveBuffer(cur);
+
+	if (format == SCENE_LIVE_JPEG)
+	{
+		uint32_t cap = player->liveCapacity();
+		if (hdr->offset > cap || len > cap - hdr->offset) return false;
+		memcpy(dst + hdr->offset, payload, len);
+		if (hdr->offset + len > jpeg_len) jpeg_len = hdr->offset + len;
+		return true;
+	}
+
+	// 槽位中图像头之后为w*h个lv_color_t（openLive时已写好图像头）
+	uint16_t* px = (uint16_t*)(dst + sizeof(lv_img_header_t));
+	uint32_t total = (uint32_t)width * height;
+	uint32_t pos = hdr->offset;
+	if (pos > total) return false;
+	for (uint16_t i = 0; i + 4 <= len; i += 4)
+	{
+		// 载荷在回调缓冲中不一定2字节对齐，逐字节组合
+		uint16_t n = payload[i] | (payload[i + 1] << 8);
+		uint16_t c = payload[i + 2] | (payload[i + 3] << 8);
+#if LV_COLOR_16_SWAP
+		c = (uint16_t)((c >> 8) | (c << 8));
+#endif
+		if (n > total - pos) return false;
+		for (uint16_t k = 0; k < n; k++) px[pos++] = c;
+	}
+	return true;
+}
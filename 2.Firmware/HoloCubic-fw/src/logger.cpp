@@ -0,0 +1,337 @@
+/*
+ * HoloCubic 异步日志模块
+ *
+ * 功能说明：
+ * 1. 编译时按LOG_LEVEL去掉低级别日志（LOG_x宏展开为空，参数不求值）
+ * 2. 生产者把日志格式化进固定槽位的环形缓冲区，O(1)占用槽位，不加锁、不等待输出
+ * 3. 低优先级输出任务按顺序写到串口、SD卡（LOG_SD_PATH）与UDP，不占用渲染任务的时间
+ * 4. 令牌桶限速：日志风暴时丢弃超出部分并计数，恢复后报告丢弃条数（ERROR不限速）
+ *
+ * 环形缓冲区（多生产者、单消费者）：
+ * 每个槽位有一个序号，生产者以CAS推进head占用序号等于head的槽位，写完后把序号加1发布；
+ * 输出任务读取序号等于tail+1的槽位，取出后把序号推进一圈归还。
+ * 序号按“减去槽位下标”保存，全零即为初始状态，全局构造之前也可写入
+ *
+ * 输出格式：
+ *   秒.毫秒 级别 标签: 内容
+ *   12.345 W scene: 帧索引异常: 17
+ *
+ * 注意事项：
+ * - 标签须为字符串常量（只保存指针）
+ * - 不能在中断中调用（vsnprintf）；单条超过LOG_LINE_MAX的内容被截断
+ * - 输出任务未启动时缓冲区满即丢弃
+ */
+
+#include "logger.h"
+#include <WiFi.h>
+
+#define LOG_RING_MASK (LOG_RING_SLOTS - 1)
+
+struct LogSlot
+{
+	uint32_t seq;          // 实际序号 - 槽位下标
+	uint32_t time_ms;
+	const char* tag;
+	uint8_t level;
+	char text[LOG_LINE_MAX];
+};
+
+// 放在.bss中，不依赖构造顺序
+static LogSlot ring[LOG_RING_SLOTS];
+static uint32_t head = 0;
+static uint32_t tail = 0;
+static uint32_t dropped = 0;
+static uint32_t limited = 0;
+static int32_t tokens = LOG_RATE_BURST;
+static volatile bool limit_on = false;
+static volatile uint8_t run_level = LOG_LEVEL;
+static SemaphoreHandle_t drain_lock = NULL;
+
+static const char level_chars[] = "-EWID";
+
+Logger logger;
+
+static inline uint32_t slot_seq(uint32_t idx)
+{
+	return __atomic_load_n(&ring[idx].seq, __ATOMIC_ACQUIRE) + idx;
+}
+
+static inline void slot_set_seq(uint32_t idx, uint32_t seq)
+{
+	__atomic_store_n(&ring[idx].seq, seq - idx, __ATOMIC_RELEASE);
+}
+
+/**
+ * 取一个令牌；桶空时返回false
+ */
+static bool take_token()
+{
+	int32_t t = __atomic_load_n(&tokens, __ATOMIC_RELAXED);
+	while (t > 0)
+	{
+		if (__atomic_compare_exchange_n(&tokens, &t, t - 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) return true;
+	}
+	return false;
+}
+
+void log_vwrite(uint8_t level, const char* tag, const char* fmt, va_list ap)
+{
+	if (level > LOG_LEVEL || level > run_level || level == LOG_LEVEL_NONE) return;
+
+	if (level != LOG_LEVEL_ERROR && limit_on && !take_token())
+	{
+		__atomic_fetch_add(&limited, 1, __ATOMIC_RELAXED);
+		return;
+	}
+
+	// 占用槽位：序号等于pos时可用，小于pos说明输出任务还没取走（缓冲区满）
+	uint32_t pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+	uint32_t idx;
+	while (true)
+	{
+		idx = pos & LOG_RING_MASK;
+		int32_t d = (int32_t)(slot_seq(idx) - pos);
+		if (d == 0)
+		{
+			if (__atomic_compare_exchange_n(&head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+		}
+		else if (d < 0)
+		{
+			__atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+		else
+		{
+			pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+		}
+	}
+
+	LogSlot* s = &ring[idx];
+	s->time_ms = millis();
+	s->tag = tag;
+	s->level = level;
+	vsnprintf(s->text, sizeof(s->text), fmt, ap);
+	slot_set_seq(idx, pos + 1);
+
+	// 缓冲区过半时提前唤醒输出任务
+	if (pos - __atomic_load_n(&tail, __ATOMIC_RELAXED) >= LOG_RING_SLOTS / 2) logger.kick();
+}
+
+void log_write(uint8_t level, const char* tag, const char* fmt, ...)
+{
+	va_list ap;
+	va_start(ap, fmt);
+	log_vwrite(level, tag, fmt, ap);
+	va_end(ap);
+}
+
+Logger::Logger()
+{
+	task = NULL;
+	sinks = LOG_SINK_UART;
+	file_size = 0;
+	last_flush = 0;
+	udp_port = 0;
+	reported_drops = 0;
+	reported_limited = 0;
+}
+
+/**
+ * 启动输出任务（Serial.begin之后调用），之前缓存的日志随即输出
+ */
+bool Logger::begin(uint8_t sink_mask)
+{
+	if (task) return true;
+
+	if (drain_lock == NULL) drain_lock = xSemaphoreCreateMutex();
+	if (drain_lock == NULL) return false;
+	setSinks(sink_mask);
+
+	if (xTaskCreatePinnedToCore(taskEntry, "logger", LOG_TASK_STACK, this,
+								LOG_TASK_PRIORITY, &task, LOG_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		Serial.println("日志任务创建失败");
+		return false;
+	}
+	limit_on = true;
+	return true;
+}
+
+/**
+ * 选择输出目标（LOG_SINK_x组合）；启用SD卡时打开日志文件
+ */
+void Logger::setSinks(uint8_t sink_mask)
+{
+	if (drain_lock) xSemaphoreTake(drain_lock, portMAX_DELAY);
+	sinks = sink_mask;
+	if ((sinks & LOG_SINK_SD) && !file) openFile();
+	if (!(sinks & LOG_SINK_SD) && file) file.close();
+	if (drain_lock) xSemaphoreGive(drain_lock);
+}
+
+uint8_t Logger::getSinks()
+{
+	return sinks;
+}
+
+/**
+ * 运行时级别：低于该级别的日志在格式化前丢弃；不能高于编译时的LOG_LEVEL（已被去掉的调用无法恢复）
+ */
+void Logger::setLevel(uint8_t level)
+{
+	run_level = level > LOG_LEVEL ? LOG_LEVEL : level;
+}
+
+uint8_t Logger::getLevel()
+{
+	return run_level;
+}
+
+/**
+ * 设置UDP输出目标（需同时启用LOG_SINK_UDP）
+ */
+void Logger::setUdpTarget(IPAddress ip, uint16_t port)
+{
+	if (drain_lock) xSemaphoreTake(drain_lock, portMAX_DELAY);
+	udp_ip = ip;
+	udp_port = port;
+	if (drain_lock) xSemaphoreGive(drain_lock);
+}
+
+uint32_t Logger::getDropped()
+{
+	return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+uint32_t Logger::getLimited()
+{
+	return __atomic_load_n(&limited, __ATOMIC_RELAXED);
+}
+
+void Logger::kick()
+{
+	if (task) xTaskNotifyGive(task);
+}
+
+/**
+ * 打开（追加）日志文件，超过LOG_SD_MAX_SIZE时先改名为.old
+ */
+void Logger::openFile()
+{
+	if (!SD_FS.exists("/log")) SD_FS.mkdir("/log");
+	file = SD_FS.open(LOG_SD_PATH, FILE_APPEND);
+	if (!file) return;
+	file_size = file.size();
+	if (file_size >= LOG_SD_MAX_SIZE)
+	{
+		file.close();
+		SD_FS.remove(LOG_SD_PATH ".old");
+		SD_FS.rename(LOG_SD_PATH, LOG_SD_PATH ".old");
+		file = SD_FS.open(LOG_SD_PATH, FILE_APPEND);
+		file_size = 0;
+	}
+}
+
+/**
+ * 把一行写到各个目标（持有drain_lock）
+ */
+void Logger::emit(const char* line, size_t len)
+{
+	if (sinks & LOG_SINK_UART) Serial.write((const uint8_t*)line, len);
+
+	if ((sinks & LOG_SINK_SD) && file)
+	{
+		file.write((const uint8_t*)line, len);
+		file_size += len;
+		if (file_size >= LOG_SD_MAX_SIZE)
+		{
+			file.close();
+			openFile();
+		}
+	}
+
+	if ((sinks & LOG_SINK_UDP) && udp_port && WiFi.isConnected())
+	{
+		if (udp.beginPacket(udp_ip, udp_port))
+		{
+			udp.write((const uint8_t*)line, len);
+			udp.endPacket();
+		}
+	}
+}
+
+/**
+ * 取出并输出缓冲区中的全部日志
+ */
+void Logger::flush()
+{
+	if (drain_lock) xSemaphoreTake(drain_lock, portMAX_DELAY);
+
+	char line[LOG_LINE_MAX + 32];
+	while (true)
+	{
+		uint32_t idx = tail & LOG_RING_MASK;
+		if (slot_seq(idx) != tail + 1) break;
+
+		LogSlot* s = &ring[idx];
+		int n = snprintf(line, sizeof(line), "%u.%03u %c %s: %s\r\n", s->time_ms / 1000, s->time_ms % 1000,
+			level_chars[s->level], s->tag ? s->tag : "-", s->text);
+		// 槽位内容已复制，先归还再输出
+		slot_set_seq(idx, tail + LOG_RING_SLOTS);
+		__atomic_store_n(&tail, tail + 1, __ATOMIC_RELAXED);
+		if (n > (int)sizeof(line) - 1) n = sizeof(line) - 1;
+		if (n > 0) emit(line, n);
+	}
+
+	uint32_t d = getDropped();
+	uint32_t l = getLimited();
+	if (d != reported_drops || l != reported_limited)
+	{
+		int n = snprintf(line, sizeof(line), "%u.%03u W log: 缓冲区满丢弃%u条，限速丢弃%u条\r\n",
+			millis() / 1000, millis() % 1000, d - reported_drops, l - reported_limited);
+		reported_drops = d;
+		reported_limited = l;
+		emit(line, n);
+	}
+
+	if (file && millis() - last_flush >= 1000)
+	{
+		file.flush();
+		last_flush = millis();
+	}
+
+	if (drain_lock) xSemaphoreGive(drain_lock);
+}
+
+/**
+ * 输出任务：每LOG_DRAIN_MS（或被唤醒时）输出一次，并按经过的时间补充令牌
+ */
+void Logger::taskEntry(void* arg)
+{
+	Logger* self = (Logger*)arg;
+	uint32_t last = millis();
+	uint32_t frac = 0;
+
+	while (true)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_DRAIN_MS));
+
+		uint32_t now = millis();
+		frac += (now - last) * LOG_RATE_PER_S;
+		last = now;
+		int32_t add = frac / 1000;
+		frac %= 1000;
+		if (add > 0)
+		{
+			int32_t t = __atomic_load_n(&tokens, __ATOMIC_RELAXED);
+			int32_t n;
+			do
+			{
+				n = t + add > LOG_RATE_BURST ? LOG_RATE_BURST : t + add;
+			} while (!__atomic_compare_exchange_n(&tokens, &t, n, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+		}
+
+		self->flush();
+	}
+}
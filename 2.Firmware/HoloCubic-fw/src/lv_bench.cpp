@@ -0,0 +1,747 @@
+/*
+ * HoloCubic 设备端LVGL基准测试模块
+ *
+ * 功能说明：
+ * 1. 移植lv_demo_benchmark的场景表：每个场景创建若干上下往返移动的对象，
+ *    持续产生局部重绘，先以不透明、再以半透明模式各运行LV_BENCH_SCENE_MS
+ * 2. 计时取自render_prof：绘制（DRAW）、送屏（FLUSH）、flush_cb内部（SPI）分开累计，
+ *    直接反映ST7789条带DMA与传感器任务并行运行时的真实开销
+ * 3. 测试图像（齿轮，100x100）在运行时按需生成，每个图像场景只分配当前格式的一张，
+ *    不占用flash，也不需要PSRAM
+ * 4. 结束后输出串口摘要并写入JSON报告，恢复原界面与计时器状态
+ *
+ * 串口输出格式：
+ * LVBENCH,场景,opa,fps,平均绘制us,平均送屏us,平均SPIus
+ * fps与lv_demo_benchmark相同，按刷新任务耗时计算（不受刷新周期限制）
+ *
+ * 注意事项：
+ * - 测试期间独占屏幕，场景中的对象只在测试屏幕上创建
+ * - lv_demo_benchmark的大号与压缩字体场景未移植（固件只启用了montserrat 14），
+ *   "Text small"使用界面中的宋体12
+ */
+
+#include "lv_bench.h"
+#include "render_prof.h"
+#include "guider_fonts.h"
+#include "power.h"
+#include "sd_card.h"
+#include <esp_heap_caps.h>
+
+#define OBJ_SIZE_MIN        (LV_MATH_MAX(LV_DPI / 20, 5))
+#define OBJ_SIZE_MAX        (LV_HOR_RES_MAX / 2)
+#define ANIM_TIME_MIN       ((2 * LV_BENCH_SCENE_MS) / 10)
+#define ANIM_TIME_MAX       (LV_BENCH_SCENE_MS)
+#define RADIUS              LV_MATH_MAX(LV_DPI / 15, 2)
+#define BORDER_WIDTH        LV_MATH_MAX(LV_DPI / 40, 1)
+#define SHADOW_WIDTH_SMALL  LV_MATH_MAX(LV_DPI / 15, 5)
+#define SHADOW_OFS_SMALL    LV_MATH_MAX(LV_DPI / 20, 2)
+#define SHADOW_SPREAD_SMALL LV_MATH_MAX(LV_DPI / 30, 2)
+#define SHADOW_WIDTH_LARGE  LV_MATH_MAX(LV_DPI / 5, 10)
+#define SHADOW_OFS_LARGE    LV_MATH_MAX(LV_DPI / 10, 5)
+#define SHADOW_SPREAD_LARGE LV_MATH_MAX(LV_DPI / 30, 2)
+#define IMG_NUM             LV_MATH_MAX((LV_HOR_RES_MAX * LV_VER_RES_MAX) / 5 / LV_BENCH_IMG_SIZE / LV_BENCH_IMG_SIZE, 1)
+#define IMG_ZOOM_MIN        128
+#define IMG_ZOOM_MAX        (256 + 64)
+#define LINE_WIDTH          LV_MATH_MAX(LV_DPI / 50, 2)
+#define LINE_POINT_NUM      16
+#define LINE_POINT_DIFF_MIN (LV_DPI / 10)
+#define LINE_POINT_DIFF_MAX LV_MATH_MAX(LV_HOR_RES_MAX / (LINE_POINT_NUM + 2), LINE_POINT_DIFF_MIN * 2)
+#define ARC_WIDTH_THIN      LV_MATH_MAX(LV_DPI / 50, 2)
+#define ARC_WIDTH_THICK     LV_MATH_MAX(LV_DPI / 10, 5)
+#define TXT "hello world\nit is a multi line text to test\nthe performance of text rendering"
+
+LvBench lvbench;
+
+struct BenchScene
+{
+	const char* name;
+	uint8_t weight;
+	void (*create_cb)();
+};
+
+// 场景回调共用的状态（同一时间只运行一个测试）
+static lv_style_t style_common;
+static lv_obj_t* scene_bg = NULL;
+static bool opa_mode = false;
+static bool scene_skipped = false;
+static uint32_t rnd_state;
+static lv_point_t line_points[LV_BENCH_OBJ_NUM][LINE_POINT_NUM];
+
+// 当前场景的测试图像
+static lv_img_dsc_t img_dsc;
+static uint8_t* img_buf = NULL;
+
+static void rnd_reset()
+{
+	rnd_state = 0x2545F491;
+}
+
+/**
+ * 固定种子的xorshift，每个场景重新开始，两种模式下对象的位置与颜色相同
+ */
+static int32_t rnd_next(int32_t min, int32_t max)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 17;
+	rnd_state ^= rnd_state << 5;
+	if (max <= min) return min;
+	return min + (int32_t)(rnd_state % (uint32_t)(max - min));
+}
+
+/**
+ * 齿轮图案：返回覆盖率（0~255，边缘1像素抗锯齿），shade为由内到外的亮度
+ */
+static uint8_t gear_coverage(int x, int y, uint8_t* shade)
+{
+	const float c = (LV_BENCH_IMG_SIZE - 1) / 2.0f;
+	float dx = x - c, dy = y - c;
+	float r = sqrtf(dx * dx + dy * dy);
+	float outer = c * 0.8f + (cosf(atan2f(dy, dx) * 10) > 0 ? c * 0.18f : 0);
+	float hole = c * 0.3f;
+
+	float cov = outer - r;
+	if (r - hole < cov) cov = r - hole;
+	*shade = r >= c ? 0 : (uint8_t)(255 - r * 160 / c);
+	if (cov <= 0) return 0;
+	if (cov >= 1) return 255;
+	return (uint8_t)(cov * 255);
+}
+
+static lv_color_t gear_color(uint8_t shade)
+{
+	return lv_color_make(shade / 3, shade * 2 / 3, shade);
+}
+
+/**
+ * 生成指定格式的测试图像（释放上一张）
+ * 支持TRUE_COLOR、TRUE_COLOR_ALPHA、TRUE_COLOR_CHROMA_KEYED、INDEXED_4BIT、ALPHA_4BIT
+ * @return 内存不足时返回NULL
+ */
+static const lv_img_dsc_t* bench_img(lv_img_cf_t cf)
+{
+	const uint16_t n = LV_BENCH_IMG_SIZE;
+	uint32_t size;
+	switch (cf)
+	{
+	case LV_IMG_CF_TRUE_COLOR_ALPHA: size = n * n * LV_IMG_PX_SIZE_ALPHA_BYTE; break;
+	case LV_IMG_CF_INDEXED_4BIT: size = 16 * sizeof(lv_color32_t) + (n + 1) / 2 * n; break;
+	case LV_IMG_CF_ALPHA_4BIT: size = (n + 1) / 2 * n; break;
+	default: size = n * n * sizeof(lv_color_t); break;
+	}
+
+	uint8_t* buf = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+	if (buf == NULL)
+	{
+		Serial.printf("LVGL基准测试图像分配失败（%u字节）\n", size);
+		return NULL;
+	}
+
+	uint8_t* p = buf;
+	if (cf == LV_IMG_CF_INDEXED_4BIT)
+	{
+		// 0号为透明，1~15由暗到亮
+		lv_color32_t* pal = (lv_color32_t*)buf;
+		for (uint8_t i = 0; i < 16; i++)
+		{
+			uint8_t s = i * 17;
+			pal[i].ch.red = s / 3;
+			pal[i].ch.green = s * 2 / 3;
+			pal[i].ch.blue = s;
+			pal[i].ch.alpha = i ? LV_OPA_COVER : LV_OPA_TRANSP;
+		}
+		p += 16 * sizeof(lv_color32_t);
+		memset(p, 0, (n + 1) / 2 * n);
+	}
+	else if (cf == LV_IMG_CF_ALPHA_4BIT)
+	{
+		memset(p, 0, size);
+	}
+
+	for (uint16_t y = 0; y < n; y++)
+	{
+		for (uint16_t x = 0; x < n; x++)
+		{
+			uint8_t shade;
+			uint8_t a = gear_coverage(x, y, &shade);
+			lv_color_t c = gear_color(shade);
+			switch (cf)
+			{
+			case LV_IMG_CF_TRUE_COLOR_ALPHA:
+				memcpy(p, &c, sizeof(lv_color_t));
+				p[sizeof(lv_color_t)] = a;
+				p += LV_IMG_PX_SIZE_ALPHA_BYTE;
+				break;
+			case LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED:
+				if (a < LV_OPA_50) c = LV_COLOR_TRANSP;
+				memcpy(p, &c, sizeof(lv_color_t));
+				p += sizeof(lv_color_t);
+				break;
+			case LV_IMG_CF_INDEXED_4BIT:
+			{
+				uint8_t idx = a < LV_OPA_50 ? 0 : LV_MATH_MAX(shade / 17, 1);
+				p[y * ((n + 1) / 2) + x / 2] |= (x & 1) ? idx : idx << 4;
+				break;
+			}
+			case LV_IMG_CF_ALPHA_4BIT:
+				p[y * ((n + 1) / 2) + x / 2] |= (x & 1) ? a >> 4 : a & 0xF0;
+				break;
+			default:
+				// 不透明图像：齿轮外为黑色
+				if (a < LV_OPA_COVER) c = lv_color_mix(c, LV_COLOR_BLACK, a);
+				memcpy(p, &c, sizeof(lv_color_t));
+				p += sizeof(lv_color_t);
+				break;
+			}
+		}
+	}
+
+	if (img_buf)
+	{
+		lv_img_cache_invalidate_src(&img_dsc);
+		heap_caps_free(img_buf);
+	}
+	img_buf = buf;
+	memset(&img_dsc, 0, sizeof(img_dsc));
+	img_dsc.header.always_zero = 0;
+	img_dsc.header.w = n;
+	img_dsc.header.h = n;
+	img_dsc.header.cf = cf;
+	img_dsc.data_size = size;
+	img_dsc.data = buf;
+	return &img_dsc;
+}
+
+static void bench_img_free()
+{
+	if (img_buf == NULL) return;
+	lv_img_cache_invalidate_src(&img_dsc);
+	heap_caps_free(img_buf);
+	img_buf = NULL;
+}
+
+/**
+ * 对象在场景内上下往返移动，从中间位置开始
+ */
+static void fall_anim(lv_obj_t* obj)
+{
+	lv_obj_set_x(obj, rnd_next(0, lv_obj_get_width(scene_bg) - lv_obj_get_width(obj)));
+
+	uint32_t t = rnd_next(ANIM_TIME_MIN, ANIM_TIME_MAX);
+
+	lv_anim_t a;
+	lv_anim_init(&a);
+	lv_anim_set_var(&a, obj);
+	lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_obj_set_y);
+	lv_anim_set_values(&a, 0, lv_obj_get_height(scene_bg) - lv_obj_get_height(obj));
+	lv_anim_set_time(&a, t);
+	lv_anim_set_playback_time(&a, t);
+	lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
+	a.act_time = a.time / 2;
+	lv_anim_start(&a);
+}
+
+static lv_color_t rnd_color()
+{
+	return lv_color_hex(rnd_next(0, 0xFFFFF0));
+}
+
+static void rect_create(lv_style_t* style)
+{
+	for (uint8_t i = 0; i < LV_BENCH_OBJ_NUM; i++)
+	{
+		lv_obj_t* obj = lv_obj_create(scene_bg, NULL);
+		lv_obj_reset_style_list(obj, LV_OBJ_PART_MAIN);
+		lv_obj_add_style(obj, LV_OBJ_PART_MAIN, style);
+		lv_obj_set_style_local_bg_color(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, rnd_color());
+		lv_obj_set_style_local_border_color(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, rnd_color());
+		lv_obj_set_style_local_shadow_color(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, rnd_color());
+		lv_obj_set_size(obj, rnd_next(OBJ_SIZE_MIN, OBJ_SIZE_MAX), rnd_next(OBJ_SIZE_MIN, OBJ_SIZE_MAX));
+		fall_anim(obj);
+	}
+}
+
+static void img_create(lv_style_t* style, lv_img_cf_t cf, bool rotate, bool zoom, bool aa)
+{
+	const lv_img_dsc_t* src = bench_img(cf);
+	if (src == NULL)
+	{
+		scene_skipped = true;
+		return;
+	}
+
+	for (uint8_t i = 0; i < IMG_NUM; i++)
+	{
+		lv_obj_t* obj = lv_img_create(scene_bg, NULL);
+		lv_obj_reset_style_list(obj, LV_OBJ_PART_MAIN);
+		lv_obj_add_style(obj, LV_OBJ_PART_MAIN, style);
+		lv_img_set_src(obj, src);
+		lv_obj_set_style_local_image_recolor(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, rnd_color());
+		if (rotate) lv_img_set_angle(obj, rnd_next(0, 3599));
+		if (zoom) lv_img_set_zoom(obj, rnd_next(IMG_ZOOM_MIN, IMG_ZOOM_MAX));
+		lv_img_set_antialias(obj, aa);
+		fall_anim(obj);
+	}
+}
+
+static void txt_create(lv_style_t* style)
+{
+	for (uint8_t i = 0; i < LV_BENCH_OBJ_NUM; i++)
+	{
+		lv_obj_t* obj = lv_label_create(scene_bg, NULL);
+		lv_obj_reset_style_list(obj, LV_OBJ_PART_MAIN);
+		lv_obj_add_style(obj, LV_OBJ_PART_MAIN, style);
+		lv_obj_set_style_local_text_color(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, rnd_color());
+		lv_label_set_text_static(obj, TXT);
+		fall_anim(obj);
+	}
+}
+
+static void line_create(lv_style_t* style)
+{
+	for (uint8_t i = 0; i < LV_BENCH_OBJ_NUM; i++)
+	{
+		line_points[i][0].x = 0;
+		line_points[i][0].y = 0;
+		for (uint8_t j = 1; j < LINE_POINT_NUM; j++)
+		{
+			line_points[i][j].x = line_points[i][j - 1].x + rnd_next(LINE_POINT_DIFF_MIN, LINE_POINT_DIFF_MAX);
+			line_points[i][j].y = rnd_next(LINE_POINT_DIFF_MIN, LINE_POINT_DIFF_MAX);
+		}
+
+		lv_obj_t* obj = lv_line_create(scene_bg, NULL);
+		lv_obj_reset_style_list(obj, LV_OBJ_PART_MAIN);
+		lv_obj_add_style(obj, LV_OBJ_PART_MAIN, style);
+		lv_obj_set_style_local_line_color(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, rnd_color());
+		lv_line_set_points(obj, line_points[i], LINE_POINT_NUM);
+		lv_line_set_auto_size(obj, true);
+		fall_anim(obj);
+	}
+}
+
+static void arc_create(lv_style_t* style)
+{
+	for (uint8_t i = 0; i < LV_BENCH_OBJ_NUM; i++)
+	{
+		lv_obj_t* obj = lv_arc_create(scene_bg, NULL);
+		lv_obj_reset_style_list(obj, LV_ARC_PART_BG);
+		lv_obj_reset_style_list(obj, LV_ARC_PART_INDIC);
+		lv_obj_set_size(obj, rnd_next(OBJ_SIZE_MIN, OBJ_SIZE_MAX), rnd_next(OBJ_SIZE_MIN, OBJ_SIZE_MAX));
+		lv_obj_add_style(obj, LV_ARC_PART_INDIC, style);
+		lv_obj_set_style_local_line_color(obj, LV_ARC_PART_INDIC, LV_STATE_DEFAULT, rnd_color());
+		lv_arc_set_start_angle(obj, 0);
+
+		uint32_t t = rnd_next(ANIM_TIME_MIN / 4, ANIM_TIME_MAX / 4);
+		lv_anim_t a;
+		lv_anim_init(&a);
+		lv_anim_set_var(&a, obj);
+		lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_arc_set_end_angle);
+		lv_anim_set_values(&a, 0, 359);
+		lv_anim_set_time(&a, t);
+		lv_anim_set_playback_time(&a, t);
+		lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
+		lv_anim_start(&a);
+
+		fall_anim(obj);
+	}
+}
+
+/**** 场景 ****/
+
+static lv_opa_t mode_opa(lv_opa_t opa)
+{
+	return opa_mode ? opa : LV_OPA_COVER;
+}
+
+static void rect_style(lv_style_int_t radius)
+{
+	lv_style_set_radius(&style_common, LV_STATE_DEFAULT, radius);
+	lv_style_set_bg_opa(&style_common, LV_STATE_DEFAULT, mode_opa(LV_OPA_50));
+}
+
+static void border_style(lv_style_int_t radius, lv_border_side_t side)
+{
+	lv_style_set_radius(&style_common, LV_STATE_DEFAULT, radius);
+	lv_style_set_border_width(&style_common, LV_STATE_DEFAULT, BORDER_WIDTH);
+	lv_style_set_border_opa(&style_common, LV_STATE_DEFAULT, mode_opa(LV_OPA_50));
+	lv_style_set_border_side(&style_common, LV_STATE_DEFAULT, side);
+}
+
+static void shadow_style(lv_style_int_t width, lv_style_int_t ofs, lv_style_int_t spread)
+{
+	lv_style_set_radius(&style_common, LV_STATE_DEFAULT, RADIUS);
+	lv_style_set_bg_opa(&style_common, LV_STATE_DEFAULT, LV_OPA_COVER);
+	lv_style_set_shadow_opa(&style_common, LV_STATE_DEFAULT, mode_opa(LV_OPA_80));
+	lv_style_set_shadow_width(&style_common, LV_STATE_DEFAULT, width);
+	lv_style_set_shadow_ofs_x(&style_common, LV_STATE_DEFAULT, ofs);
+	lv_style_set_shadow_ofs_y(&style_common, LV_STATE_DEFAULT, ofs);
+	lv_style_set_shadow_spread(&style_common, LV_STATE_DEFAULT, spread);
+}
+
+static void img_style(bool recolor)
+{
+	lv_style_set_image_opa(&style_common, LV_STATE_DEFAULT, mode_opa(LV_OPA_50));
+	if (recolor) lv_style_set_image_recolor_opa(&style_common, LV_STATE_DEFAULT, LV_OPA_50);
+}
+
+static void txt_style(const lv_font_t* font)
+{
+	lv_style_set_text_font(&style_common, LV_STATE_DEFAULT, font);
+	lv_style_set_text_opa(&style_common, LV_STATE_DEFAULT, mode_opa(LV_OPA_50));
+}
+
+static void line_style(lv_style_int_t width)
+{
+	lv_style_set_line_width(&style_common, LV_STATE_DEFAULT, width);
+	lv_style_set_line_opa(&style_common, LV_STATE_DEFAULT, mode_opa(LV_OPA_50));
+}
+
+static void rectangle_cb() { rect_style(0); rect_create(&style_common); }
+static void rectangle_rounded_cb() { rect_style(RADIUS); rect_create(&style_common); }
+static void rectangle_circle_cb() { rect_style(LV_RADIUS_CIRCLE); rect_create(&style_common); }
+static void border_cb() { border_style(0, LV_BORDER_SIDE_FULL); rect_create(&style_common); }
+static void border_rounded_cb() { border_style(RADIUS, LV_BORDER_SIDE_FULL); rect_create(&style_common); }
+static void border_circle_cb() { border_style(LV_RADIUS_CIRCLE, LV_BORDER_SIDE_FULL); rect_create(&style_common); }
+static void border_top_cb() { border_style(RADIUS, LV_BORDER_SIDE_TOP); rect_create(&style_common); }
+static void border_left_cb() { border_style(RADIUS, LV_BORDER_SIDE_LEFT); rect_create(&style_common); }
+static void border_top_left_cb() { border_style(RADIUS, LV_BORDER_SIDE_TOP | LV_BORDER_SIDE_LEFT); rect_create(&style_common); }
+static void border_left_right_cb() { border_style(RADIUS, LV_BORDER_SIDE_LEFT | LV_BORDER_SIDE_RIGHT); rect_create(&style_common); }
+static void border_top_bottom_cb() { border_style(RADIUS, LV_BORDER_SIDE_TOP | LV_BORDER_SIDE_BOTTOM); rect_create(&style_common); }
+
+static void shadow_small_cb() { shadow_style(SHADOW_WIDTH_SMALL, 0, 0); rect_create(&style_common); }
+static void shadow_small_ofs_cb() { shadow_style(SHADOW_WIDTH_SMALL, SHADOW_OFS_SMALL, SHADOW_SPREAD_SMALL); rect_create(&style_common); }
+static void shadow_large_cb() { shadow_style(SHADOW_WIDTH_LARGE, 0, 0); rect_create(&style_common); }
+static void shadow_large_ofs_cb() { shadow_style(SHADOW_WIDTH_LARGE, SHADOW_OFS_LARGE, SHADOW_SPREAD_LARGE); rect_create(&style_common); }
+
+static void img_rgb_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR, false, false, false); }
+static void img_argb_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR_ALPHA, false, false, false); }
+static void img_ckey_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED, false, false, false); }
+static void img_index_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_INDEXED_4BIT, false, false, false); }
+static void img_alpha_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_ALPHA_4BIT, false, false, false); }
+static void img_rgb_recolor_cb() { img_style(true); img_create(&style_common, LV_IMG_CF_TRUE_COLOR, false, false, false); }
+static void img_argb_recolor_cb() { img_style(true); img_create(&style_common, LV_IMG_CF_TRUE_COLOR_ALPHA, false, false, false); }
+static void img_ckey_recolor_cb() { img_style(true); img_create(&style_common, LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED, false, false, false); }
+static void img_index_recolor_cb() { img_style(true); img_create(&style_common, LV_IMG_CF_INDEXED_4BIT, false, false, false); }
+static void img_rgb_rot_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR, true, false, false); }
+static void img_rgb_rot_aa_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR, true, false, true); }
+static void img_argb_rot_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR_ALPHA, true, false, false); }
+static void img_argb_rot_aa_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR_ALPHA, true, false, true); }
+static void img_rgb_zoom_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR, false, true, false); }
+static void img_rgb_zoom_aa_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR, false, true, true); }
+static void img_argb_zoom_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR_ALPHA, false, true, false); }
+static void img_argb_zoom_aa_cb() { img_style(false); img_create(&style_common, LV_IMG_CF_TRUE_COLOR_ALPHA, false, true, true); }
+
+static void txt_small_cb() { txt_style(&lv_font_simsun_12); txt_create(&style_common); }
+static void txt_medium_cb() { txt_style(&lv_font_montserrat_14); txt_create(&style_common); }
+
+static void line_cb() { line_style(LINE_WIDTH); line_create(&style_common); }
+static void arc_thin_cb() { line_style(ARC_WIDTH_THIN); arc_create(&style_common); }
+static void arc_thick_cb() { line_style(ARC_WIDTH_THICK); arc_create(&style_common); }
+
+static void sub_rectangle_cb()
+{
+	rect_style(RADIUS);
+	lv_style_set_bg_blend_mode(&style_common, LV_STATE_DEFAULT, LV_BLEND_MODE_SUBTRACTIVE);
+	rect_create(&style_common);
+}
+
+static void sub_border_cb()
+{
+	border_style(RADIUS, LV_BORDER_SIDE_FULL);
+	lv_style_set_border_blend_mode(&style_common, LV_STATE_DEFAULT, LV_BLEND_MODE_SUBTRACTIVE);
+	rect_create(&style_common);
+}
+
+static void sub_shadow_cb()
+{
+	shadow_style(SHADOW_WIDTH_SMALL, 0, SHADOW_WIDTH_SMALL);
+	lv_style_set_shadow_blend_mode(&style_common, LV_STATE_DEFAULT, LV_BLEND_MODE_SUBTRACTIVE);
+	rect_create(&style_common);
+}
+
+static void sub_img_cb()
+{
+	img_style(false);
+	lv_style_set_image_blend_mode(&style_common, LV_STATE_DEFAULT, LV_BLEND_MODE_SUBTRACTIVE);
+	img_create(&style_common, LV_IMG_CF_TRUE_COLOR_ALPHA, false, false, false);
+}
+
+static void sub_line_cb()
+{
+	line_style(LINE_WIDTH);
+	lv_style_set_line_blend_mode(&style_common, LV_STATE_DEFAULT, LV_BLEND_MODE_SUBTRACTIVE);
+	line_create(&style_common);
+}
+
+static void sub_arc_cb()
+{
+	line_style(ARC_WIDTH_THICK);
+	lv_style_set_line_blend_mode(&style_common, LV_STATE_DEFAULT, LV_BLEND_MODE_SUBTRACTIVE);
+	arc_create(&style_common);
+}
+
+static void sub_text_cb()
+{
+	txt_style(&lv_font_montserrat_14);
+	lv_style_set_text_blend_mode(&style_common, LV_STATE_DEFAULT, LV_BLEND_MODE_SUBTRACTIVE);
+	txt_create(&style_common);
+}
+
+// 名称与权重与lv_demo_benchmark一致，报告可以直接和模拟器结果对比
+static const BenchScene scenes[] = {
+	{ "Rectangle", 30, rectangle_cb },
+	{ "Rectangle rounded", 20, rectangle_rounded_cb },
+	{ "Circle", 10, rectangle_circle_cb },
+	{ "Border", 20, border_cb },
+	{ "Border rounded", 30, border_rounded_cb },
+	{ "Circle border", 10, border_circle_cb },
+	{ "Border top", 3, border_top_cb },
+	{ "Border left", 3, border_left_cb },
+	{ "Border top + left", 3, border_top_left_cb },
+	{ "Border left + right", 3, border_left_right_cb },
+	{ "Border top + bottom", 3, border_top_bottom_cb },
+
+	{ "Shadow small", 3, shadow_small_cb },
+	{ "Shadow small offset", 5, shadow_small_ofs_cb },
+	{ "Shadow large", 5, shadow_large_cb },
+	{ "Shadow large offset", 3, shadow_large_ofs_cb },
+
+	{ "Image RGB", 20, img_rgb_cb },
+	{ "Image ARGB", 20, img_argb_cb },
+	{ "Image chorma keyed", 5, img_ckey_cb },
+	{ "Image indexed", 5, img_index_cb },
+	{ "Image alpha only", 5, img_alpha_cb },
+
+	{ "Image RGB recolor", 5, img_rgb_recolor_cb },
+	{ "Image ARGB recolor", 20, img_argb_recolor_cb },
+	{ "Image chorma keyed recolor", 3, img_ckey_recolor_cb },
+	{ "Image indexed recolor", 3, img_index_recolor_cb },
+
+	{ "Image RGB rotate", 3, img_rgb_rot_cb },
+	{ "Image RGB rotate anti aliased", 3, img_rgb_rot_aa_cb },
+	{ "Image ARGB rotate", 5, img_argb_rot_cb },
+	{ "Image ARGB rotate anti aliased", 5, img_argb_rot_aa_cb },
+	{ "Image RGB zoom", 3, img_rgb_zoom_cb },
+	{ "Image RGB zoom anti aliased", 3, img_rgb_zoom_aa_cb },
+	{ "Image ARGB zoom", 5, img_argb_zoom_cb },
+	{ "Image ARGB zoom anti aliased", 5, img_argb_zoom_aa_cb },
+
+	{ "Text small", 20, txt_small_cb },
+	{ "Text medium", 30, txt_medium_cb },
+
+	{ "Line", 10, line_cb },
+
+	{ "Arc think", 10, arc_thin_cb },
+	{ "Arc thick", 10, arc_thick_cb },
+
+	{ "Substr. rectangle", 10, sub_rectangle_cb },
+	{ "Substr. border", 10, sub_border_cb },
+	{ "Substr. shadow", 10, sub_shadow_cb },
+	{ "Substr. image", 10, sub_img_cb },
+	{ "Substr. line", 10, sub_line_cb },
+	{ "Substr. arc", 10, sub_arc_cb },
+	{ "Substr. text", 10, sub_text_cb },
+};
+#define SCENE_CNT (sizeof(scenes) / sizeof(scenes[0]))
+
+/**
+ * 开始测试：切换到测试屏幕，启用分阶段计时
+ * @return 已在运行、内存不足或计时缓冲区分配失败时返回false
+ */
+bool LvBench::start()
+{
+	if (task) return false;
+
+	prof_was_enabled = render_prof_is_enabled();
+	if (!render_prof_enable(true)) return false;
+
+	results = (LvBenchResult*)calloc(SCENE_CNT * 2, sizeof(LvBenchResult));
+	if (results == NULL)
+	{
+		Serial.println("LVGL基准测试结果缓冲区分配失败");
+		if (!prof_was_enabled) render_prof_enable(false);
+		return false;
+	}
+
+	prev_scr = lv_scr_act();
+	scr = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(scr, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	scene_bg = lv_obj_create(scr, NULL);
+	lv_obj_reset_style_list(scene_bg, LV_OBJ_PART_MAIN);
+	lv_obj_set_size(scene_bg, LV_HOR_RES_MAX, LV_VER_RES_MAX);
+	lv_obj_set_click(scene_bg, false);
+	lv_style_init(&style_common);
+	lv_scr_load(scr);
+
+	Serial.printf("LVBENCH,begin,%u,%u\n", (unsigned)(SCENE_CNT * 2), LV_BENCH_SCENE_MS);
+	scene = 0;
+	opa_mode = false;
+	startScene();
+	task = lv_task_create(taskCb, LV_BENCH_SCENE_MS, LV_TASK_PRIO_HIGHEST, this);
+	return true;
+}
+
+/**
+ * 中止测试（不写报告），恢复原界面
+ */
+void LvBench::stop()
+{
+	if (task == NULL) return;
+
+	lv_task_del(task);
+	task = NULL;
+	if (prev_scr) lv_scr_load(prev_scr);
+	lv_obj_del(scr);          // 连同对象上的动画一起删除
+	scr = NULL;
+	scene_bg = NULL;
+	bench_img_free();
+	lv_style_reset(&style_common);
+	free(results);
+	results = NULL;
+	if (!prof_was_enabled) render_prof_enable(false);
+}
+
+bool LvBench::isRunning()
+{
+	return task != NULL;
+}
+
+/**
+ * 清空场景并创建当前场景的对象
+ */
+void LvBench::startScene()
+{
+	lv_obj_clean(scene_bg);   // 先删除对象，再重置它们引用的样式
+	lv_style_reset(&style_common);
+	scene_skipped = false;
+	rnd_reset();
+	scenes[scene].create_cb();
+	results[scene * 2 + opa_mode].skipped = scene_skipped;
+	scene_start = millis();
+	power.activity();         // 测试期间不进入调暗/待机（待机降低刷新频率）
+}
+
+/**
+ * 累计场景开始LV_BENCH_WARMUP_MS之后的帧记录（环形缓冲区由新到旧）
+ */
+void LvBench::collect(LvBenchResult* r)
+{
+	uint32_t from = scene_start + LV_BENCH_WARMUP_MS;
+	render_prof_frame_t f;
+	for (uint16_t n = 0; render_prof_get(n, &f); n++)
+	{
+		if ((int32_t)(f.time_ms - from) < 0) break;
+		r->frames++;
+		r->px += f.px;
+		r->frame_us += f.us[RENDER_PROF_FRAME];
+		r->render_us += f.us[RENDER_PROF_DRAW];
+		r->flush_us += f.us[RENDER_PROF_FLUSH];
+		r->spi_us += f.us[RENDER_PROF_SPI];
+		r->imu_us += f.us[RENDER_PROF_IMU];
+		if (f.us[RENDER_PROF_FRAME] > r->max_frame_us) r->max_frame_us = f.us[RENDER_PROF_FRAME];
+	}
+	r->elapsed_ms = millis() - from;
+}
+
+/**
+ * 场景定时器：记录当前场景，切换到下一场景（普通 -> 半透明 -> 下一个）
+ */
+void LvBench::taskCb(lv_task_t* t)
+{
+	LvBench* self = (LvBench*)t->user_data;
+	LvBenchResult* r = &self->results[self->scene * 2 + self->opa_mode];
+	if (!r->skipped) self->collect(r);
+
+	uint32_t fps = r->frame_us ? (uint64_t)r->frames * 1000000 / r->frame_us : 0;
+	Serial.printf("LVBENCH,%s,%u,%u,%u,%u,%u\n", scenes[self->scene].name, self->opa_mode, fps,
+		r->frames ? r->render_us / r->frames : 0, r->frames ? r->flush_us / r->frames : 0,
+		r->frames ? r->spi_us / r->frames : 0);
+
+	if (self->opa_mode)
+	{
+		self->opa_mode = false;
+		self->scene++;
+	}
+	else
+	{
+		self->opa_mode = true;
+	}
+
+	if (self->scene >= SCENE_CNT)
+	{
+		self->finish();
+		return;
+	}
+	self->startScene();
+}
+
+/**
+ * 全部场景结束：计算加权帧率（半透明模式权重减半，同lv_demo_benchmark），写报告并恢复界面
+ */
+void LvBench::finish()
+{
+	uint32_t fps_sum = 0, weight_sum = 0;
+	for (uint8_t i = 0; i < SCENE_CNT * 2; i++)
+	{
+		const LvBenchResult* r = &results[i];
+		if (r->skipped || r->frame_us == 0) continue;
+		uint32_t w = (i & 1) ? LV_MATH_MAX(scenes[i / 2].weight / 2, 1) : scenes[i / 2].weight;
+		fps_sum += (uint64_t)r->frames * 1000000 / r->frame_us * w;
+		weight_sum += w;
+	}
+	Serial.printf("LVBENCH,end,weighted_fps,%u\n", weight_sum ? fps_sum / weight_sum : 0);
+
+	if (writeReport(LV_BENCH_REPORT_PATH)) Serial.printf("LVGL基准测试报告已写入%s\n", LV_BENCH_REPORT_PATH);
+	stop();
+}
+
+/**
+ * JSON报告（逐项写入，不在内存中拼接整篇）
+ * 每个场景记录帧数与各阶段合计/平均耗时，render为绘制、flush为送屏（含SPI）
+ */
+bool LvBench::writeReport(const char* path)
+{
+	SD_FS.mkdir(LV_BENCH_REPORT_DIR);
+	File f = SD_FS.open(path, FILE_WRITE);
+	if (!f)
+	{
+		Serial.printf("无法写入%s\n", path);
+		return false;
+	}
+
+	f.printf("{\n  \"lvgl\": \"%d.%d.%d\",\n  \"hor_res\": %d,\n  \"ver_res\": %d,\n",
+		LVGL_VERSION_MAJOR, LVGL_VERSION_MINOR, LVGL_VERSION_PATCH, LV_HOR_RES_MAX, LV_VER_RES_MAX);
+	f.printf("  \"cpu_mhz\": %u,\n  \"scene_ms\": %u,\n  \"warmup_ms\": %u,\n  \"scenes\": [\n",
+		getCpuFrequencyMhz(), LV_BENCH_SCENE_MS, LV_BENCH_WARMUP_MS);
+
+	for (uint8_t i = 0; i < SCENE_CNT * 2; i++)
+	{
+		const LvBenchResult* r = &results[i];
+		uint16_t n = r->frames ? r->frames : 1;
+		f.printf("    {\"name\": \"%s\", \"opa\": %s, \"weight\": %u, \"skipped\": %s, \"frames\": %u, "
+			"\"elapsed_ms\": %u, \"px\": %u, \"fps\": %u, \"refr_fps\": %u, "
+			"\"frame_us\": %u, \"render_us\": %u, \"flush_us\": %u, \"spi_us\": %u, \"imu_us\": %u, "
+			"\"avg_render_us\": %u, \"avg_flush_us\": %u, \"max_frame_us\": %u}%s\n",
+			scenes[i / 2].name, (i & 1) ? "true" : "false",
+			(i & 1) ? LV_MATH_MAX(scenes[i / 2].weight / 2, 1) : scenes[i / 2].weight,
+			r->skipped ? "true" : "false", r->frames, r->elapsed_ms, r->px,
+			r->frame_us ? (uint32_t)((uint64_t)r->frames * 1000000 / r->frame_us) : 0,
+			r->elapsed_ms ? r->frames * 1000 / r->elapsed_ms : 0,
+			r->frame_us, r->render_us, r->flush_us, r->spi_us, r->imu_us,
+			r->render_us / n, r->flush_us / n, r->max_frame_us,
+			i < SCENE_CNT * 2 - 1 ? "," : "");
+	}
+	f.print("  ]\n}\n");
+	f.close();
+	return true;
+}
+
+/**** 应用入口 ****/
+
+const App lv_bench_app = {
+	"lv_bench",
+	[](void* u) { lvbench.start(); },
+	NULL,
+	NULL,
+	[](void* u) { lvbench.stop(); },
+	40 * 1024, 0, 0, 0, NULL
+};
@@ -40,7 +40,10 @@
  *      INCLUDES
  *********************/
 #include "lv_cubic_gui.h"  // HoloCubic GUI头文件
-#include "images.h"        // 图像资源头文件
+#include "asset_bundle.h"  // flash资源包
+#if ASSET_BUILTIN_LOGO
+#include "images.h"        // 图像资源头文件（内置Logo）
+#endif
 
 /**
  * 全局屏幕对象指针
@@ -75,7 +78,7 @@ lv_obj_t* scr;
  * 
  * 注意事项：
  * - 必须在LVGL和显示系统初始化后调用
- * - Logo图像资源需要在images.h中定义
+ * - Logo优先取flash资源包中的"logo"，没有时使用images.h中的内置Logo
  * - 样式设置会影响整个屏幕的视觉效果
  */
 void lv_holo_cubic_gui(void)
@@ -106,8 +109,17 @@ void lv_holo_cubic_gui(void)
 	lv_obj_t* img = lv_img_create(lv_scr_act(), NULL);
 	
 	/* 设置Logo图像源 */
-	/* 使用内嵌的Logo图像资源，确保快速加载和显示 */
-	lv_img_set_src(img, &logo);
+	/* 优先使用flash资源包（直接从flash映射读取），否则使用内嵌的Logo图像资源 */
+	const lv_img_dsc_t* logo_src = asset_image("logo");
+#if ASSET_BUILTIN_LOGO
+	if (logo_src == NULL) logo_src = &logo;
+#endif
+	if (logo_src)
+	{
+		lv_img_set_src(img, logo_src);
+		/* 固定在图像缓存中，切换场景后返回主界面时不会被挤出 */
+		lv_img_cache_pin(logo_src, true);
+	}
 	/* 可选：从SD卡加载外部图像文件 */
 	// lv_img_set_src(img, "S:/pic.bin");
 	
@@ -12,6 +12,7 @@
  * 2. 目录管理：支持目录遍历、创建、删除操作
  * 3. 存储管理：提供磁盘空间查询和文件大小获取
  * 4. 路径操作：支持文件重命名、删除、截断等操作
+ * 5. 句柄缓存：只读文件关闭后保持打开（LRU），图像重绘、场景循环再次打开时不再查找目录
  * 
  * 技术实现：
  * - 基于FatFs文件系统库的底层实现
@@ -42,6 +43,8 @@
   *      INCLUDES
   *********************/
 #include "lv_port_fatfs.h"  // LVGL FatFs端口头文件
+#include <esp_heap_caps.h>  // 分配可DMA的预读缓冲区
+#include "telemetry.h"      // SD卡吞吐计数
 
 
   /*********************
@@ -55,9 +58,38 @@
 	*      TYPEDEFS
 	**********************/
 
-/* 文件操作类型定义 */
-/* 基于FatFs库的FIL结构，用于存储文件操作所需的状态信息 */
-typedef  FIL file_t;
+/* 已打开的文件：FatFs的FIL结构加上一个按簇对齐的预读缓冲区 */
+/* LVGL按行读取图像（每次几百字节），经预读后合并为整簇的多扇区读取（CMD18） */
+/* 只读句柄可被多个LVGL文件共用（各自保存读写位置），关闭后留在缓存中 */
+typedef struct
+{
+	FIL fil;
+	uint8_t* ra_buf;     /* 预读缓冲区，只读句柄第一次读取时分配，大小LV_FS_RA_SIZE */
+	uint32_t ra_start;   /* 缓冲区对应的文件偏移（LV_FS_RA_SIZE对齐） */
+	uint32_t ra_len;     /* 缓冲区内有效字节数，0表示无效 */
+#if FF_USE_FASTSEEK
+	DWORD clmt[LV_FS_CLMT_SIZE];  /* 簇链表，打开时建立一次 */
+#endif
+	char path[LV_FS_CACHE_PATH_MAX];  /* 缓存的句柄为打开路径，否则为空 */
+	uint32_t gen;        /* 打开时的缓存代数，与cache_gen不同时已失效 */
+	uint32_t last_use;   /* 最近一次打开的序号（LRU） */
+	uint8_t refs;        /* 共用该句柄的LVGL文件数 */
+	bool readonly;
+} handle_t;
+
+/* LVGL的文件：指向句柄，读写位置各自保存 */
+typedef struct
+{
+	handle_t* h;
+	uint32_t pos;        /* LVGL视角的读写位置 */
+} file_t;
+
+/* FF_FS_LOCK限制同时打开的文件数：缓存最多占用其中的一部分，留出2个给写入与其他模块 */
+#if FF_FS_LOCK && LV_FS_HANDLE_CACHE > FF_FS_LOCK - 2
+#define CACHE_SLOTS (FF_FS_LOCK > 2 ? FF_FS_LOCK - 2 : 0)
+#else
+#define CACHE_SLOTS LV_FS_HANDLE_CACHE
+#endif
 
 /* 目录操作类型定义 */
 /* 基于FatFs库的FF_DIR结构，用于目录遍历和管理操作 */
@@ -70,6 +102,10 @@ typedef  FF_DIR dir_t;
 static void fs_init(void);
 
 /* 文件操作相关函数声明 */
+static handle_t* handle_open(const char* path, uint8_t flags, bool readonly);                    // 打开句柄
+static void handle_free(handle_t* h);                                                            // 关闭句柄
+static handle_t* cache_open(const char* path, bool* failed);                                     // 从缓存取出只读句柄
+static void cache_drop(handle_t* h);                                                             // 移除失效句柄
 static lv_fs_res_t fs_open(lv_fs_drv_t* drv, void* file_p, const char* path, lv_fs_mode_t mode);  // 打开文件
 static lv_fs_res_t fs_close(lv_fs_drv_t* drv, void* file_p);                                    // 关闭文件
 static lv_fs_res_t fs_read(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t btr, uint32_t* br);  // 读取文件
@@ -92,6 +128,11 @@ static lv_fs_res_t fs_dir_close(lv_fs_drv_t* drv, void* dir_p);
 /**********************
  *  STATIC VARIABLES
  **********************/
+#if CACHE_SLOTS > 0
+static handle_t* cache[CACHE_SLOTS];
+static uint32_t use_clock = 0;
+#endif
+static volatile uint32_t cache_gen = 0;
 
  /**********************
   *      MACROS
@@ -150,7 +191,7 @@ void lv_fs_if_init(void)
 	 * 第三步：配置文件系统驱动参数
 	 * ==================================================== */
 	/* 基本配置 */
-	fs_drv.file_size = sizeof(file_t);          /* 文件句柄大小（FIL结构体） */
+	fs_drv.file_size = sizeof(file_t);          /* 文件大小（句柄指针与读写位置） */
 	fs_drv.letter = DRIVE_LETTER;               /* 驱动器标识符 'S' */
 	
 	/* 文件操作回调函数配置 */
@@ -203,6 +244,128 @@ static void fs_init(void)
 	//}
 }
 
+/**
+ * 打开一个句柄
+ * 只读句柄建立快速定位的簇链表（FF_USE_FASTSEEK时），预读缓冲区在第一次读取时分配
+ */
+static handle_t* handle_open(const char* path, uint8_t flags, bool readonly)
+{
+	handle_t* h = (handle_t*)heap_caps_calloc(1, sizeof(handle_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	if (h == NULL) return NULL;
+
+	if (f_open(&h->fil, path, flags) != FR_OK)
+	{
+		heap_caps_free(h);
+		return NULL;
+	}
+	f_lseek(&h->fil, 0);
+	h->readonly = readonly;
+
+#if FF_USE_FASTSEEK
+	/* 不超过一个预读块的文件不需要定位 */
+	if (readonly && f_size(&h->fil) > LV_FS_RA_SIZE)
+	{
+		h->clmt[0] = LV_FS_CLMT_SIZE;
+		h->fil.cltbl = h->clmt;
+		/* 片段太多时表放不下，按普通方式沿FAT链定位 */
+		if (f_lseek(&h->fil, CREATE_LINKMAP) != FR_OK) h->fil.cltbl = NULL;
+	}
+#endif
+	return h;
+}
+
+static void handle_free(handle_t* h)
+{
+	f_close(&h->fil);
+	if (h->ra_buf) heap_caps_free(h->ra_buf);
+	heap_caps_free(h);
+}
+
+/**
+ * 从缓存中取出（或打开并放入）一个只读句柄
+ * @param failed 输出：文件打开失败时为true；返回NULL且failed为false表示不缓存，由调用方直接打开
+ */
+static handle_t* cache_open(const char* path, bool* failed)
+{
+#if CACHE_SLOTS > 0
+	if (strlen(path) >= LV_FS_CACHE_PATH_MAX) return NULL;
+	uint32_t gen = cache_gen;
+
+	/* 命中 */
+	int8_t slot = -1;
+	for (uint8_t i = 0; i < CACHE_SLOTS; i++)
+	{
+		handle_t* h = cache[i];
+		if (h && h->gen == gen && strcmp(h->path, path) == 0)
+		{
+			h->refs++;
+			h->last_use = ++use_clock;
+			return h;
+		}
+	}
+
+	/* 选择空位、已失效的空闲句柄或最久未用的空闲句柄 */
+	for (uint8_t i = 0; i < CACHE_SLOTS; i++)
+	{
+		handle_t* h = cache[i];
+		if (h == NULL || (h->refs == 0 && h->gen != gen))
+		{
+			slot = i;
+			break;
+		}
+		if (h->refs == 0 && (slot < 0 || h->last_use < cache[slot]->last_use)) slot = i;
+	}
+	/* 全部正在使用：本次不缓存 */
+	if (slot < 0) return NULL;
+
+	if (cache[slot])
+	{
+		handle_free(cache[slot]);
+		cache[slot] = NULL;
+	}
+
+	handle_t* h = handle_open(path, FA_READ, true);
+	if (h == NULL)
+	{
+		*failed = true;
+		return NULL;
+	}
+	strcpy(h->path, path);
+	h->gen = gen;
+	h->refs = 1;
+	h->last_use = ++use_clock;
+	cache[slot] = h;
+	return h;
+#else
+	(void)path;
+	(void)failed;
+	return NULL;
+#endif
+}
+
+/**
+ * 从缓存中移除并关闭一个句柄（没有使用者时）
+ */
+static void cache_drop(handle_t* h)
+{
+#if CACHE_SLOTS > 0
+	for (uint8_t i = 0; i < CACHE_SLOTS; i++)
+	{
+		if (cache[i] == h) cache[i] = NULL;
+	}
+#endif
+	handle_free(h);
+}
+
+/**
+ * 使缓存的句柄全部失效（文件被改写后，FIL中的簇链可能已被释放）
+ * 只推进代数，关闭在LVGL任务中进行，因此可在上传等其他任务中调用
+ */
+void lv_fs_if_invalidate(void)
+{
+	__atomic_fetch_add(&cache_gen, 1, __ATOMIC_RELEASE);
+}
+
 /**
  * Open a file
  * @param drv pointer to a driver where this function belongs
@@ -219,17 +382,23 @@ static lv_fs_res_t fs_open(lv_fs_drv_t* drv, void* file_p, const char* path, lv_
 	else if (mode == LV_FS_MODE_RD) flags = FA_READ;
 	else if (mode == (LV_FS_MODE_WR | LV_FS_MODE_RD)) flags = FA_READ | FA_WRITE | FA_OPEN_ALWAYS;
 
-	FRESULT res = f_open((file_t*)file_p, path, flags);
+	file_t* fp = (file_t*)file_p;
+	fp->pos = 0;
 
-	if (res == FR_OK)
-	{
-		f_lseek((file_t*)file_p, 0);
-		return LV_FS_RES_OK;
-	}
-	else
+	/* 只读打开先查缓存：命中时不访问SD卡 */
+	if (mode == LV_FS_MODE_RD)
 	{
-		return LV_FS_RES_UNKNOWN;
+		bool failed = false;
+		fp->h = cache_open(path, &failed);
+		if (fp->h) return LV_FS_RES_OK;
+		if (failed) return LV_FS_RES_UNKNOWN;
 	}
+
+	fp->h = handle_open(path, flags, mode == LV_FS_MODE_RD);
+	if (fp->h == NULL) return LV_FS_RES_UNKNOWN;
+	/* 写入后缓存中同一文件的句柄不再可信 */
+	if (mode & LV_FS_MODE_WR) lv_fs_if_invalidate();
+	return LV_FS_RES_OK;
 }
 
 
@@ -242,7 +411,30 @@ static lv_fs_res_t fs_open(lv_fs_drv_t* drv, void* file_p, const char* path, lv_
  */
 static lv_fs_res_t fs_close(lv_fs_drv_t* drv, void* file_p)
 {
-	f_close((file_t*)file_p);
+	file_t* fp = (file_t*)file_p;
+	handle_t* h = fp->h;
+	fp->h = NULL;
+	if (h == NULL) return LV_FS_RES_OK;
+
+	if (h->path[0] == '\0')
+	{
+		handle_free(h);
+		return LV_FS_RES_OK;
+	}
+
+	/* 缓存的句柄保持打开；已失效的在最后一个使用者关闭时释放 */
+	if (h->refs > 0) h->refs--;
+	if (h->refs == 0)
+	{
+		if (h->gen != cache_gen) cache_drop(h);
+		/* 空闲句柄只保留能装下整个文件的预读缓冲区（小图标再次显示时不读SD卡） */
+		else if (h->ra_buf && !(h->ra_start == 0 && h->ra_len == f_size(&h->fil)))
+		{
+			heap_caps_free(h->ra_buf);
+			h->ra_buf = NULL;
+			h->ra_len = 0;
+		}
+	}
 	return LV_FS_RES_OK;
 }
 
@@ -258,9 +450,51 @@ static lv_fs_res_t fs_close(lv_fs_drv_t* drv, void* file_p)
  */
 static lv_fs_res_t fs_read(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t btr, uint32_t* br)
 {
-	FRESULT res = f_read((file_t*)file_p, buf, btr, (UINT*)br);
-	if (res == FR_OK) return LV_FS_RES_OK;
-	else return LV_FS_RES_UNKNOWN;
+	file_t* fp = (file_t*)file_p;
+	handle_t* h = fp->h;
+	uint8_t* dst = (uint8_t*)buf;
+	UINT n = 0;
+	*br = 0;
+
+	/* 只读句柄才使用预读，分配失败时退化为直接读取 */
+	if (h->ra_buf == NULL && h->readonly && btr < LV_FS_RA_SIZE)
+		h->ra_buf = (uint8_t*)heap_caps_malloc(LV_FS_RA_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+
+	/* 无预读缓冲区或请求量不小于一簇：直接读取，FatFs对整扇区部分使用多扇区传输 */
+	if (h->ra_buf == NULL || btr >= LV_FS_RA_SIZE)
+	{
+		if (f_tell(&h->fil) != fp->pos) f_lseek(&h->fil, fp->pos);
+		FRESULT res = f_read(&h->fil, dst, btr, &n);
+		telemetry_sd_io(n, 0);
+		fp->pos += n;
+		*br = n;
+		return res == FR_OK ? LV_FS_RES_OK : LV_FS_RES_UNKNOWN;
+	}
+
+	while (btr > 0)
+	{
+		/* 当前位置不在缓冲区内时，按簇对齐重新填充 */
+		if (h->ra_len == 0 || fp->pos < h->ra_start || fp->pos >= h->ra_start + h->ra_len)
+		{
+			h->ra_start = fp->pos & ~(LV_FS_RA_SIZE - 1);
+			h->ra_len = 0;
+			if (f_lseek(&h->fil, h->ra_start) != FR_OK) return LV_FS_RES_UNKNOWN;
+			if (f_read(&h->fil, h->ra_buf, LV_FS_RA_SIZE, &n) != FR_OK) return LV_FS_RES_UNKNOWN;
+			telemetry_sd_io(n, 0);
+			h->ra_len = n;
+			if (fp->pos >= h->ra_start + h->ra_len) break;   /* 已到文件末尾 */
+		}
+
+		uint32_t off = fp->pos - h->ra_start;
+		uint32_t chunk = h->ra_len - off;
+		if (chunk > btr) chunk = btr;
+		memcpy(dst, h->ra_buf + off, chunk);
+		dst += chunk;
+		btr -= chunk;
+		fp->pos += chunk;
+		*br += chunk;
+	}
+	return LV_FS_RES_OK;
 }
 
 /**
@@ -274,7 +508,15 @@ static lv_fs_res_t fs_read(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t b
  */
 static lv_fs_res_t fs_write(lv_fs_drv_t* drv, void* file_p, const void* buf, uint32_t btw, uint32_t* bw)
 {
-	FRESULT res = f_write((file_t*)file_p, buf, btw, (UINT*)bw);
+	file_t* fp = (file_t*)file_p;
+	handle_t* h = fp->h;
+	UINT n = 0;
+	if (f_tell(&h->fil) != fp->pos) f_lseek(&h->fil, fp->pos);
+	FRESULT res = f_write(&h->fil, buf, btw, &n);
+	telemetry_sd_io(0, n);
+	fp->pos += n;
+	h->ra_len = 0;
+	if (bw) *bw = n;
 	if (res == FR_OK) return LV_FS_RES_OK;
 	else return LV_FS_RES_UNKNOWN;
 }
@@ -289,7 +531,8 @@ static lv_fs_res_t fs_write(lv_fs_drv_t* drv, void* file_p, const void* buf, uin
  */
 static lv_fs_res_t fs_seek(lv_fs_drv_t* drv, void* file_p, uint32_t pos)
 {
-	f_lseek((file_t*)file_p, pos);
+	/* 只记录位置，落在预读缓冲区内的定位不产生SD访问 */
+	((file_t*)file_p)->pos = pos;
 	return LV_FS_RES_OK;
 }
 
@@ -302,7 +545,7 @@ static lv_fs_res_t fs_seek(lv_fs_drv_t* drv, void* file_p, uint32_t pos)
  */
 static lv_fs_res_t fs_size(lv_fs_drv_t* drv, void* file_p, uint32_t* size_p)
 {
-	(*size_p) = f_size(((file_t*)file_p));
+	(*size_p) = f_size(&((file_t*)file_p)->h->fil);
 	return LV_FS_RES_OK;
 }
 
@@ -316,7 +559,7 @@ static lv_fs_res_t fs_size(lv_fs_drv_t* drv, void* file_p, uint32_t* size_p)
  */
 static lv_fs_res_t fs_tell(lv_fs_drv_t* drv, void* file_p, uint32_t* pos_p)
 {
-	*pos_p = f_tell(((file_t*)file_p));
+	*pos_p = ((file_t*)file_p)->pos;
 	return LV_FS_RES_OK;
 }
 
@@ -344,8 +587,12 @@ static lv_fs_res_t fs_remove(lv_fs_drv_t* drv, const char* path)
  */
 static lv_fs_res_t fs_trunc(lv_fs_drv_t* drv, void* file_p)
 {
-	f_sync((file_t*)file_p);           /*If not syncronized fclose can write the truncated part*/
-	f_truncate((file_t*)file_p);
+	file_t* fp = (file_t*)file_p;
+	handle_t* h = fp->h;
+	f_lseek(&h->fil, fp->pos);
+	f_sync(&h->fil);            /*If not syncronized fclose can write the truncated part*/
+	f_truncate(&h->fil);
+	h->ra_len = 0;
 	return LV_FS_RES_OK;
 }
 
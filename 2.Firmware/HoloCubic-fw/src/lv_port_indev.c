@@ -37,15 +37,30 @@
  *      INCLUDES
  *********************/
 #include "lv_port_indev.h"
+#include "render_prof.h"
+#include <esp32-hal.h>
 
 /*********************
  *      DEFINES
  *********************/
 
+/* 事件环形缓冲区长度（必须是2的幂），一个LVGL读取周期内的连续手势都能缓存 */
+#define ENCODER_RING_LEN 16
+/* 超过该时长仍未被读取的事件直接丢弃，避免界面卡顿后补发一串过期操作 */
+#define ENCODER_EVENT_MAX_AGE_MS 500
+
 /**********************
  *      TYPEDEFS
  **********************/
 
+/* 编码器事件：一次旋转或一次按键状态变化 */
+typedef struct
+{
+	int16_t diff;
+	lv_indev_state_t state;
+	uint32_t time;          // 产生时间（millis）
+} encoder_event_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -53,7 +68,6 @@
 // 编码器相关函数声明
 static void encoder_init(void);        // 编码器初始化
 static bool encoder_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data);  // 编码器数据读取
-static void encoder_handler(void);     // 编码器事件处理
 
 /**********************
  *  STATIC VARIABLES
@@ -66,11 +80,20 @@ static void encoder_handler(void);     // 编码器事件处理
 lv_indev_t* indev_encoder;     // 编码器输入设备对象
 
 /**
- * 编码器状态变量
- * 这些变量由IMU模块更新，用于模拟编码器的旋转和按压状态
+ * 编码器事件环形缓冲区（单写单读）
+ * 只有传感器任务写入head、只有LVGL读取回调写入tail，两端各自只修改自己的下标，不需要加锁
  */
-int32_t encoder_diff;           // 编码器旋转差值（正值：顺时针，负值：逆时针）
-lv_indev_state_t encoder_state; // 编码器按键状态（LV_INDEV_STATE_PRESSED/LV_INDEV_STATE_REL）
+static encoder_event_t encoder_ring[ENCODER_RING_LEN];
+static volatile uint32_t encoder_head;
+static volatile uint32_t encoder_tail;
+static lv_indev_state_t encoder_state;  // 最近一次的按键状态，缓冲区为空时保持
+
+/* 统计：缓冲区满丢弃、过期丢弃的事件数，以及事件从产生到被读取的最大延迟 */
+static lv_port_indev_stats_t encoder_stats;
+
+/* 空闲（无事件且已释放）时暂停LVGL读取任务，写入事件后经唤醒回调通知LVGL任务恢复 */
+static volatile bool encoder_paused;
+static void (*encoder_wake_cb)(void);
 
 
 /**********************
@@ -167,16 +190,17 @@ void lv_port_indev_init(void)
  * 注意事项：
  * - IMU传感器的初始化在imu.cpp中完成
  * - 此函数主要用于编码器状态变量的初始化
- * - 实际的手势识别逻辑在IMU模块中实现
+ * - 实际的手势识别逻辑在手势引擎（gesture.cpp）中实现
  */
 static void encoder_init(void)
 {
-    /* 初始化编码器状态变量 */
-    encoder_diff = 0;                           // 旋转差值清零
-    encoder_state = LV_INDEV_STATE_REL;    // 按键状态设为释放
-    
+    /* 清空事件缓冲区，按键状态设为释放 */
+    encoder_head = 0;
+    encoder_tail = 0;
+    encoder_state = LV_INDEV_STATE_REL;
+
     /* IMU传感器的具体初始化在imu.cpp的IMU::init()中完成 */
-    /* 这里主要是编码器逻辑层的初始化 */
+    /* 手势识别在gesture.cpp中完成，识别结果通过lv_port_indev_push入队 */
 }
 
 /**
@@ -184,69 +208,127 @@ static void encoder_init(void)
  * 
  * @param indev_drv 输入设备驱动指针
  * @param data 输入数据结构指针，用于返回编码器状态
- * @return false 表示没有缓冲数据，无需继续读取
+ * @return true 表示缓冲区中还有事件，LVGL会在同一周期内立即再次读取
  * 
  * 功能说明：
  * 1. 被LVGL库定期调用以获取编码器状态
- * 2. 读取全局变量中的编码器数据
+ * 2. 从事件队列中取出编码器事件
  * 3. 将数据填充到LVGL的输入数据结构中
  * 4. 支持旋转方向和按键状态的检测
  * 
  * 数据来源：
- * - encoder_diff：由IMU模块根据手势识别结果更新
- * - encoder_state：由IMU模块根据敲击检测结果更新
- * 
- * 工作原理：
- * - 正值encoder_diff表示顺时针旋转
- * - 负值encoder_diff表示逆时针旋转
- * - encoder_state表示编码器按键的按压/释放状态
+ * - encoder_ring：由手势引擎（gesture.cpp）在传感器任务中写入
+ * - 每次读取取出一个事件，缓冲区为空时旋转差值为0、按键保持上次状态
+ * - 过期事件丢弃；按键事件即使过期也要更新状态，避免按下后丢失释放
  */
 static bool encoder_read(lv_indev_drv_t * indev_drv, lv_indev_data_t * data)
  {
-     /* 读取编码器旋转差值（由IMU手势识别更新） */
-     data->enc_diff = encoder_diff;
-     
-     /* 读取编码器按键状态（由IMU敲击检测更新） */
+     uint32_t now = millis();
+     data->enc_diff = 0;
+     render_prof_begin(RENDER_PROF_INDEV);
+
+     while (encoder_tail != encoder_head)
+     {
+         encoder_event_t ev = encoder_ring[encoder_tail & (ENCODER_RING_LEN - 1)];
+         __sync_synchronize();
+         encoder_tail++;
+
+         uint32_t age = now - ev.time;
+         if (age > ENCODER_EVENT_MAX_AGE_MS && ev.state == encoder_state)
+         {
+             encoder_stats.expired++;
+             continue;
+         }
+         if (age > encoder_stats.max_latency_ms) encoder_stats.max_latency_ms = age;
+         encoder_stats.delivered++;
+
+         /* 每次只交付一个事件，旋转与按键不会在同一次读取中合并 */
+         data->enc_diff = ev.diff;
+         encoder_state = ev.state;
+         /* 刷新任务立即就绪：LVGL处理完本次输入（在读取任务中）后，同一次lv_task_handler内接着重绘，
+          * 不再等待刷新周期到期 */
+         lv_task_t* refr = _lv_disp_get_refr_task(indev_drv->disp);
+         if (refr) lv_task_ready(refr);
+         break;
+     }
      data->state = encoder_state;
+     render_prof_end(RENDER_PROF_INDEV);
 
-     /* 清零旋转差值，避免重复触发 */
-     /* 这是编码器正常工作的关键步骤 */
-     encoder_diff = 0;
+     /* 没有待处理事件且按键已释放：暂停周期读取，不再限制LVGL任务的休眠时长
+      * 之后写入的事件一定会触发唤醒回调，LVGL任务醒来后调用lv_port_indev_resume */
+     bool more = encoder_tail != encoder_head;
+     if (!more && encoder_state == LV_INDEV_STATE_REL && data->enc_diff == 0 && encoder_wake_cb)
+     {
+         encoder_paused = true;
+         lv_task_set_prio(indev_drv->read_task, LV_TASK_PRIO_OFF);
+     }
 
-     /* 返回false表示没有缓冲数据，无需继续读取 */
-     /* HoloCubic采用实时读取模式，不使用输入缓冲 */
-     return false;
+     /* 还有事件时返回true，LVGL在本周期内继续读取，连续手势逐个交付且不会等待下一个周期 */
+     return more;
  }
 
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
 /**
- * 编码器中断处理函数
- * 
- * 功能说明：
- * 1. 在中断服务程序中调用此函数处理编码器事件
- * 2. 更新编码器的旋转差值和按键状态
- * 3. 为LVGL提供实时的输入事件数据
- * 
- * 使用方式：
- * - 在硬件中断或定时器中断中调用
- * - 根据实际硬件信号更新encoder_diff和encoder_state
- * - HoloCubic中由IMU模块的手势识别算法更新这些值
- * 
- * 注意事项：
- * - 此函数应该尽可能快速执行
- * - 避免在中断中进行复杂的计算
- * - 实际的手势识别在IMU::update()中完成
+ * 向编码器事件缓冲区写入一个事件（只能在传感器任务中调用，单写者）
+ *
+ * @param diff  旋转步数（正值：顺时针，负值：逆时针）
+ * @param state 该事件之后的按键状态
+ * @param time  事件产生时间（millis）
+ * @return 缓冲区已满时丢弃事件并返回false
  */
-static void encoder_handler(void)
+bool lv_port_indev_push(int16_t diff, lv_indev_state_t state, uint32_t time)
 {
-    /* 示例代码：根据实际硬件更新编码器状态 */
-    /* 在HoloCubic中，这些值由IMU模块的手势识别算法更新 */
-    
-    /* 旋转差值更新（示例，实际由IMU手势识别更新） */
-    encoder_diff += 0;  // 实际值由imu.cpp中的手势识别算法设置
-    
-    /* 按键状态更新（示例，实际由IMU敲击检测更新） */
-    encoder_state = LV_INDEV_STATE_REL;  // 实际值由imu.cpp中的敲击检测设置
+    uint32_t head = encoder_head;
+    if (head - encoder_tail >= ENCODER_RING_LEN)
+    {
+        encoder_stats.overflow++;
+        return false;
+    }
+
+    encoder_event_t* ev = &encoder_ring[head & (ENCODER_RING_LEN - 1)];
+    ev->diff = diff;
+    ev->state = state;
+    ev->time = time;
+    /* 先写完事件再发布下标，另一核心上的读取方看到新下标时数据一定完整 */
+    __sync_synchronize();
+    encoder_head = head + 1;
+    if (encoder_wake_cb) encoder_wake_cb();
+    return true;
 }
 
-#endif  // 结束条件编译
+/**
+ * 设置事件写入后的唤醒回调（在传感器任务中调用，应只发送通知）
+ * 设置后编码器空闲时LVGL读取任务会被暂停，必须在LVGL任务中响应唤醒并调用lv_port_indev_resume
+ */
+void lv_port_indev_set_wake_cb(void (*cb)(void))
+{
+    encoder_wake_cb = cb;
+}
+
+/**
+ * 收到输入唤醒后立即读取一次（只能在LVGL任务中调用）：恢复被暂停的读取任务；
+ * 未暂停时也置为就绪，事件不必等到下一个读取周期（LV_INDEV_DEF_READ_PERIOD）
+ */
+void lv_port_indev_resume(void)
+{
+    if (indev_encoder == NULL) return;
+    if (encoder_paused)
+    {
+        encoder_paused = false;
+        lv_task_set_prio(indev_encoder->driver.read_task, LV_TASK_PRIO_HIGH);
+    }
+    lv_task_ready(indev_encoder->driver.read_task);
+}
 
+/**
+ * 读取事件统计（用于调试输入延迟与丢失）
+ */
+void lv_port_indev_get_stats(lv_port_indev_stats_t* stats)
+{
+    *stats = encoder_stats;
+}
+
+#endif  // 结束条件编译
@@ -0,0 +1,569 @@
+/**
+ * @file lv_port_mem.c
+ * @brief LVGL内存分配端口
+ *
+ * 功能概述：
+ * 替代LVGL内置的32KB静态堆（lv_mem.c）。内置堆分配时线性查找空闲块，
+ * 并在释放时做碎片整理（LV_MEM_AUTO_DEFRAG），切换界面时大量释放会造成卡顿，
+ * 且堆大小固定，控件增多后容易分配失败。
+ *
+ * 实现：
+ * 1. TLSF（Two-Level Segregated Fit）堆：两级位图定位空闲链表，
+ *    分配与释放都是O(1)，释放时立即与相邻空闲块合并，不需要整理
+ * 2. 堆由内部RAM区域组成，不足时向系统堆追加区域；有PSRAM时再加一个PSRAM堆，
+ *    内部RAM用尽后才使用
+ * 3. 16/32/64字节三档固定块池，承接样式属性、链表节点、动画等小对象，
+ *    不进入TLSF，避免小碎片
+ *
+ * 仅在LVGL任务中调用（与LVGL本身相同），不加锁
+ */
+
+#if 1
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_port_mem.h"
+#include <stddef.h>
+#include <string.h>
+#include <esp_heap_caps.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* TLSF参数：二级划分16档，4字节对齐，最大块16MB */
+#define SL_INDEX_COUNT_LOG2 4
+#define ALIGN_SIZE_LOG2 2
+#define ALIGN_SIZE (1U << ALIGN_SIZE_LOG2)
+#define FL_INDEX_MAX 24
+#define SL_INDEX_COUNT (1U << SL_INDEX_COUNT_LOG2)
+#define FL_INDEX_SHIFT (SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT (FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE (1U << FL_INDEX_SHIFT)
+
+/* size低两位：本块空闲、物理上前一块空闲 */
+#define BLOCK_FREE_BIT 1U
+#define BLOCK_PREV_FREE_BIT 2U
+
+/* 已用块只保留size字段作为开销；prev_phys位于前一块数据区末尾，仅前一块空闲时有效 */
+#define BLOCK_OVERHEAD sizeof(size_t)
+#define BLOCK_START_OFFSET (offsetof(tlsf_block_t, size) + sizeof(size_t))
+#define BLOCK_SIZE_MIN (sizeof(tlsf_block_t) - sizeof(tlsf_block_t*))
+#define BLOCK_SIZE_MAX ((size_t)1 << FL_INDEX_MAX)
+
+#define HEAP_INTERNAL 0
+#define HEAP_PSRAM 1
+#define HEAP_CNT 2
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct tlsf_block
+{
+	struct tlsf_block* prev_phys;
+	size_t size;
+	struct tlsf_block* next_free;
+	struct tlsf_block* prev_free;
+} tlsf_block_t;
+
+typedef struct
+{
+	tlsf_block_t block_null;
+	uint32_t fl_bitmap;
+	uint32_t sl_bitmap[FL_INDEX_COUNT];
+	tlsf_block_t* blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+	uint32_t total;
+	uint32_t free_size;
+	uint16_t free_cnt;
+} tlsf_heap_t;
+
+/* 固定块池：空闲块以单链表串起，块首存放下一个空闲块地址 */
+typedef struct
+{
+	uint16_t size;
+	uint16_t count;
+	uint8_t* start;
+	uint8_t* end;
+	void* free_list;
+	uint32_t used;
+	uint32_t max_used;
+} mem_pool_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static void heap_init(tlsf_heap_t* heap);
+static bool heap_add_region(tlsf_heap_t* heap, void* mem, size_t bytes);
+static void* heap_alloc(tlsf_heap_t* heap, size_t size);
+static void heap_free(tlsf_heap_t* heap, void* ptr);
+static size_t heap_biggest(tlsf_heap_t* heap);
+static bool heap_grow(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static tlsf_heap_t heaps[HEAP_CNT];
+static uint8_t* psram_start;
+static uint8_t* psram_end;
+static uint16_t grow_cnt;
+static bool inited;
+
+static mem_pool_t pools[LV_PORT_MEM_POOL_CNT];
+
+static uint32_t used_cnt;
+static uint32_t used_size;
+static uint32_t max_used;
+static uint32_t pool_fallback;
+static uint32_t fail_cnt;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_port_mem_init(void)
+{
+	if (inited) return;
+	inited = true;
+
+	for (uint8_t i = 0; i < HEAP_CNT; i++) heap_init(&heaps[i]);
+
+	void* mem = heap_caps_malloc(LV_PORT_MEM_INTERNAL_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	if (mem) heap_add_region(&heaps[HEAP_INTERNAL], mem, LV_PORT_MEM_INTERNAL_SIZE);
+
+	/* 无PSRAM时heap_caps_malloc直接返回NULL */
+	mem = heap_caps_malloc(LV_PORT_MEM_PSRAM_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+	if (mem && heap_add_region(&heaps[HEAP_PSRAM], mem, LV_PORT_MEM_PSRAM_SIZE))
+	{
+		psram_start = (uint8_t*)mem;
+		psram_end = psram_start + LV_PORT_MEM_PSRAM_SIZE;
+	}
+
+	/* 固定块池一次性从内部堆切出 */
+	static const uint16_t sizes[LV_PORT_MEM_POOL_CNT] = LV_PORT_MEM_POOL_SIZES;
+	static const uint16_t counts[LV_PORT_MEM_POOL_CNT] = LV_PORT_MEM_POOL_BLOCKS;
+	for (uint8_t i = 0; i < LV_PORT_MEM_POOL_CNT; i++)
+	{
+		mem_pool_t* pool = &pools[i];
+		pool->size = sizes[i];
+		pool->start = (uint8_t*)heap_alloc(&heaps[HEAP_INTERNAL], (size_t)sizes[i] * counts[i]);
+		if (pool->start == NULL) continue;
+		pool->count = counts[i];
+		pool->end = pool->start + (size_t)sizes[i] * counts[i];
+		for (uint16_t j = counts[i]; j > 0; j--)
+		{
+			void** blk = (void**)(pool->start + (size_t)sizes[i] * (j - 1));
+			*blk = pool->free_list;
+			pool->free_list = blk;
+		}
+	}
+}
+
+void* lv_port_mem_alloc(size_t size)
+{
+	if (!inited) lv_port_mem_init();
+
+	void* p = NULL;
+	for (uint8_t i = 0; i < LV_PORT_MEM_POOL_CNT; i++)
+	{
+		mem_pool_t* pool = &pools[i];
+		if (size > pool->size) continue;
+		if (pool->free_list)
+		{
+			p = pool->free_list;
+			pool->free_list = *(void**)p;
+			if (++pool->used > pool->max_used) pool->max_used = pool->used;
+			size = pool->size;
+		}
+		else
+		{
+			pool_fallback++;
+		}
+		break;
+	}
+
+	if (p == NULL)
+	{
+		p = heap_alloc(&heaps[HEAP_INTERNAL], size);
+		if (p == NULL) p = heap_alloc(&heaps[HEAP_PSRAM], size);
+		if (p == NULL && heap_grow()) p = heap_alloc(&heaps[HEAP_INTERNAL], size);
+		if (p == NULL)
+		{
+			fail_cnt++;
+			return NULL;
+		}
+		size = ((tlsf_block_t*)((uint8_t*)p - BLOCK_START_OFFSET))->size & ~(size_t)3;
+	}
+
+	used_cnt++;
+	used_size += size;
+	if (used_size > max_used) max_used = used_size;
+	return p;
+}
+
+void lv_port_mem_free(void* ptr)
+{
+	if (ptr == NULL) return;
+
+	for (uint8_t i = 0; i < LV_PORT_MEM_POOL_CNT; i++)
+	{
+		mem_pool_t* pool = &pools[i];
+		if ((uint8_t*)ptr < pool->start || (uint8_t*)ptr >= pool->end) continue;
+		*(void**)ptr = pool->free_list;
+		pool->free_list = ptr;
+		pool->used--;
+		used_cnt--;
+		used_size -= pool->size;
+		return;
+	}
+
+	used_cnt--;
+	used_size -= ((tlsf_block_t*)((uint8_t*)ptr - BLOCK_START_OFFSET))->size & ~(size_t)3;
+	bool psram = (uint8_t*)ptr >= psram_start && (uint8_t*)ptr < psram_end;
+	heap_free(&heaps[psram ? HEAP_PSRAM : HEAP_INTERNAL], ptr);
+}
+
+/**
+ * 填充lv_mem_monitor的结果（由lv_mem.c在LV_MEM_CUSTOM时调用）
+ * 固定池从内部堆切出，已含在total_size中；池中空闲块计入free_size，但不参与碎片率计算
+ */
+void lv_port_mem_monitor(lv_mem_monitor_t* mon)
+{
+	lv_port_mem_stats_t st;
+	lv_port_mem_get_stats(&st);
+
+	uint32_t pool_free = 0;
+	for (uint8_t i = 0; i < LV_PORT_MEM_POOL_CNT; i++)
+	{
+		pool_free += (uint32_t)pools[i].size * (pools[i].count - pools[i].used);
+	}
+
+	mon->total_size = st.internal_size + st.psram_size;
+	mon->free_cnt = st.heap_free_cnt;
+	mon->free_size = st.heap_free + pool_free;
+	mon->free_biggest_size = st.heap_biggest;
+	mon->used_cnt = st.used_cnt;
+	mon->max_used = st.max_used;
+	mon->used_pct = mon->total_size ? 100 - (uint64_t)100 * mon->free_size / mon->total_size : 0;
+	mon->frag_pct = st.heap_free ? 100 - (uint64_t)100 * st.heap_biggest / st.heap_free : 0;
+}
+
+void lv_port_mem_get_stats(lv_port_mem_stats_t* stats)
+{
+	memset(stats, 0, sizeof(lv_port_mem_stats_t));
+	stats->internal_size = heaps[HEAP_INTERNAL].total;
+	stats->psram_size = heaps[HEAP_PSRAM].total;
+	for (uint8_t i = 0; i < HEAP_CNT; i++)
+	{
+		stats->heap_free += heaps[i].free_size;
+		stats->heap_free_cnt += heaps[i].free_cnt;
+		size_t big = heap_biggest(&heaps[i]);
+		if (big > stats->heap_biggest) stats->heap_biggest = big;
+	}
+	stats->grow_cnt = grow_cnt;
+	for (uint8_t i = 0; i < LV_PORT_MEM_POOL_CNT; i++)
+	{
+		stats->pool_used[i] = pools[i].used;
+		stats->pool_max_used[i] = pools[i].max_used;
+	}
+	stats->pool_fallback = pool_fallback;
+	stats->used_cnt = used_cnt;
+	stats->used_size = used_size;
+	stats->max_used = max_used;
+	stats->fail_cnt = fail_cnt;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static inline int tlsf_fls(size_t x)
+{
+	return x ? 31 - __builtin_clz(x) : -1;
+}
+
+static inline int tlsf_ffs(uint32_t x)
+{
+	return __builtin_ffs(x) - 1;
+}
+
+static inline size_t block_size(const tlsf_block_t* b)
+{
+	return b->size & ~(size_t)(BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT);
+}
+
+static inline void block_set_size(tlsf_block_t* b, size_t size)
+{
+	b->size = size | (b->size & (BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT));
+}
+
+static inline bool block_is_free(const tlsf_block_t* b)
+{
+	return b->size & BLOCK_FREE_BIT;
+}
+
+static inline bool block_is_prev_free(const tlsf_block_t* b)
+{
+	return b->size & BLOCK_PREV_FREE_BIT;
+}
+
+static inline void* block_to_ptr(const tlsf_block_t* b)
+{
+	return (uint8_t*)b + BLOCK_START_OFFSET;
+}
+
+static inline tlsf_block_t* block_from_ptr(const void* p)
+{
+	return (tlsf_block_t*)((uint8_t*)p - BLOCK_START_OFFSET);
+}
+
+static inline tlsf_block_t* offset_to_block(const void* p, ptrdiff_t offset)
+{
+	return (tlsf_block_t*)((uint8_t*)p + offset);
+}
+
+static inline tlsf_block_t* block_next(const tlsf_block_t* b)
+{
+	return offset_to_block(block_to_ptr(b), block_size(b) - BLOCK_OVERHEAD);
+}
+
+static inline tlsf_block_t* block_link_next(tlsf_block_t* b)
+{
+	tlsf_block_t* next = block_next(b);
+	next->prev_phys = b;
+	return next;
+}
+
+static inline void block_mark_free(tlsf_block_t* b)
+{
+	tlsf_block_t* next = block_link_next(b);
+	next->size |= BLOCK_PREV_FREE_BIT;
+	b->size |= BLOCK_FREE_BIT;
+}
+
+static inline void block_mark_used(tlsf_block_t* b)
+{
+	tlsf_block_t* next = block_next(b);
+	next->size &= ~(size_t)BLOCK_PREV_FREE_BIT;
+	b->size &= ~(size_t)BLOCK_FREE_BIT;
+}
+
+/* 由块大小求所在的一级/二级索引 */
+static inline void mapping_insert(size_t size, int* fl, int* sl)
+{
+	if (size < SMALL_BLOCK_SIZE)
+	{
+		*fl = 0;
+		*sl = (int)size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+	}
+	else
+	{
+		int f = tlsf_fls(size);
+		*sl = (int)(size >> (f - SL_INDEX_COUNT_LOG2)) ^ (1 << SL_INDEX_COUNT_LOG2);
+		*fl = f - (FL_INDEX_SHIFT - 1);
+	}
+}
+
+/* 分配时向上取整到下一档，保证该档链表中任一块都能满足请求 */
+static inline void mapping_search(size_t size, int* fl, int* sl)
+{
+	if (size >= SMALL_BLOCK_SIZE)
+		size += ((size_t)1 << (tlsf_fls(size) - SL_INDEX_COUNT_LOG2)) - 1;
+	mapping_insert(size, fl, sl);
+}
+
+static tlsf_block_t* search_suitable_block(tlsf_heap_t* heap, int* fl, int* sl)
+{
+	uint32_t sl_map = heap->sl_bitmap[*fl] & (~0U << *sl);
+	if (!sl_map)
+	{
+		uint32_t fl_map = *fl + 1 < 32 ? heap->fl_bitmap & (~0U << (*fl + 1)) : 0;
+		if (!fl_map) return NULL;
+		*fl = tlsf_ffs(fl_map);
+		sl_map = heap->sl_bitmap[*fl];
+	}
+	*sl = tlsf_ffs(sl_map);
+	return heap->blocks[*fl][*sl];
+}
+
+static void remove_free_block(tlsf_heap_t* heap, tlsf_block_t* b, int fl, int sl)
+{
+	tlsf_block_t* prev = b->prev_free;
+	tlsf_block_t* next = b->next_free;
+	next->prev_free = prev;
+	prev->next_free = next;
+
+	if (heap->blocks[fl][sl] == b)
+	{
+		heap->blocks[fl][sl] = next;
+		if (next == &heap->block_null)
+		{
+			heap->sl_bitmap[fl] &= ~(1U << sl);
+			if (!heap->sl_bitmap[fl]) heap->fl_bitmap &= ~(1U << fl);
+		}
+	}
+	heap->free_size -= block_size(b);
+	heap->free_cnt--;
+}
+
+static void insert_free_block(tlsf_heap_t* heap, tlsf_block_t* b, int fl, int sl)
+{
+	tlsf_block_t* current = heap->blocks[fl][sl];
+	b->next_free = current;
+	b->prev_free = &heap->block_null;
+	current->prev_free = b;
+	heap->blocks[fl][sl] = b;
+	heap->fl_bitmap |= 1U << fl;
+	heap->sl_bitmap[fl] |= 1U << sl;
+	heap->free_size += block_size(b);
+	heap->free_cnt++;
+}
+
+static void block_remove(tlsf_heap_t* heap, tlsf_block_t* b)
+{
+	int fl, sl;
+	mapping_insert(block_size(b), &fl, &sl);
+	remove_free_block(heap, b, fl, sl);
+}
+
+static void block_insert(tlsf_heap_t* heap, tlsf_block_t* b)
+{
+	int fl, sl;
+	mapping_insert(block_size(b), &fl, &sl);
+	insert_free_block(heap, b, fl, sl);
+}
+
+static tlsf_block_t* block_absorb(tlsf_block_t* prev, tlsf_block_t* b)
+{
+	prev->size += block_size(b) + BLOCK_OVERHEAD;
+	block_link_next(prev);
+	return prev;
+}
+
+/* 多余部分拆成新的空闲块放回链表 */
+static void block_trim_free(tlsf_heap_t* heap, tlsf_block_t* b, size_t size)
+{
+	if (block_size(b) < sizeof(tlsf_block_t) + size) return;
+
+	tlsf_block_t* rest = offset_to_block(block_to_ptr(b), size - BLOCK_OVERHEAD);
+	size_t rest_size = block_size(b) - (size + BLOCK_OVERHEAD);
+	block_set_size(rest, rest_size);
+	block_set_size(b, size);
+	block_mark_free(rest);
+	block_link_next(b);
+	rest->size |= BLOCK_PREV_FREE_BIT;
+	block_insert(heap, rest);
+}
+
+static void heap_init(tlsf_heap_t* heap)
+{
+	memset(heap, 0, sizeof(tlsf_heap_t));
+	heap->block_null.next_free = &heap->block_null;
+	heap->block_null.prev_free = &heap->block_null;
+	for (int i = 0; i < FL_INDEX_COUNT; i++)
+	{
+		for (int j = 0; j < (int)SL_INDEX_COUNT; j++) heap->blocks[i][j] = &heap->block_null;
+	}
+}
+
+/**
+ * 把一段内存加入堆：整段作为一个空闲块，末尾放一个大小为0的哨兵块
+ */
+static bool heap_add_region(tlsf_heap_t* heap, void* mem, size_t bytes)
+{
+	if (((uintptr_t)mem & (ALIGN_SIZE - 1)) || bytes < 2 * BLOCK_OVERHEAD + BLOCK_SIZE_MIN) return false;
+
+	size_t region = (bytes - 2 * BLOCK_OVERHEAD) & ~(size_t)(ALIGN_SIZE - 1);
+	if (region >= BLOCK_SIZE_MAX) region = BLOCK_SIZE_MAX - ALIGN_SIZE;
+
+	/* 块头的prev_phys字段落在区域之前，首块的前一块永远视为已用，不会访问它 */
+	tlsf_block_t* b = offset_to_block(mem, -(ptrdiff_t)BLOCK_OVERHEAD);
+	b->size = region | BLOCK_FREE_BIT;
+	block_insert(heap, b);
+
+	tlsf_block_t* sentinel = block_link_next(b);
+	sentinel->size = 0 | BLOCK_PREV_FREE_BIT;
+
+	heap->total += bytes;
+	return true;
+}
+
+static void* heap_alloc(tlsf_heap_t* heap, size_t size)
+{
+	if (size == 0 || size >= BLOCK_SIZE_MAX) return NULL;
+	size = (size + ALIGN_SIZE - 1) & ~(size_t)(ALIGN_SIZE - 1);
+	if (size < BLOCK_SIZE_MIN) size = BLOCK_SIZE_MIN;
+
+	int fl, sl;
+	mapping_search(size, &fl, &sl);
+	if (fl >= FL_INDEX_COUNT) return NULL;
+
+	tlsf_block_t* b = search_suitable_block(heap, &fl, &sl);
+	if (b == NULL || b == &heap->block_null) return NULL;
+	remove_free_block(heap, b, fl, sl);
+	block_trim_free(heap, b, size);
+	block_mark_used(b);
+	return block_to_ptr(b);
+}
+
+static void heap_free(tlsf_heap_t* heap, void* ptr)
+{
+	tlsf_block_t* b = block_from_ptr(ptr);
+	block_mark_free(b);
+
+	if (block_is_prev_free(b))
+	{
+		tlsf_block_t* prev = b->prev_phys;
+		block_remove(heap, prev);
+		b = block_absorb(prev, b);
+	}
+	tlsf_block_t* next = block_next(b);
+	if (block_is_free(next))
+	{
+		block_remove(heap, next);
+		b = block_absorb(b, next);
+	}
+	block_insert(heap, b);
+}
+
+/**
+ * 最大空闲块：位图中最高的非空档，遍历该档链表（仅统计时调用）
+ */
+static size_t heap_biggest(tlsf_heap_t* heap)
+{
+	if (!heap->fl_bitmap) return 0;
+	int fl = tlsf_fls(heap->fl_bitmap);
+	int sl = tlsf_fls(heap->sl_bitmap[fl]);
+	size_t big = 0;
+	for (tlsf_block_t* b = heap->blocks[fl][sl]; b != &heap->block_null; b = b->next_free)
+	{
+		if (block_size(b) > big) big = block_size(b);
+	}
+	return big;
+}
+
+/**
+ * 内部堆与PSRAM堆都不足时，向系统堆追加一块内部RAM区域
+ */
+static bool heap_grow(void)
+{
+	if (grow_cnt >= LV_PORT_MEM_GROW_MAX) return false;
+	void* mem = heap_caps_malloc(LV_PORT_MEM_GROW_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	if (mem == NULL) return false;
+	if (!heap_add_region(&heaps[HEAP_INTERNAL], mem, LV_PORT_MEM_GROW_SIZE))
+	{
+		heap_caps_free(mem);
+		return false;
+	}
+	grow_cnt++;
+	return true;
+}
+
+#else /* Enable this file at the top */
+
+/* This dummy typedef exists purely to silence -Wpedantic. */
+typedef int keep_pedantic_happy;
+#endif
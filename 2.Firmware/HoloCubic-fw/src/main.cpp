@@ -5,7 +5,7 @@
  * 1. 初始化所有硬件模块（显示屏、IMU、RGB LED、SD卡等）
  * 2. 配置LVGL图形库和输入设备
  * 3. 建立WiFi连接并支持网络应用
- * 4. 运行主循环，处理显示刷新和传感器数据
+ * 4. 启动运行时任务：LVGL渲染任务（核心1）与传感器任务（核心0）
  * 
  * 硬件平台：ESP32-PICO-D4
  * 开发框架：Arduino + PlatformIO
@@ -26,13 +26,87 @@
 #include "lv_port_fatfs.h"  // LVGL文件系统端口
 #include "lv_cubic_gui.h"   // HoloCubic自定义GUI
 #include "gui_guider.h"     // GUI向导和界面管理
+#include "runtime.h"        // FreeRTOS运行时任务与UI消息队列
+#include "scene_player.h"   // SD卡帧序列场景播放器
+#include "jpeg_decoder.h"   // JPEG图像解码器
+#include "palette_decoder.h" // 索引色图像解码器
+#include "bin_decoder.h"    // 文件图像流式解码器
+#include "q565_decoder.h"   // Q565压缩图像解码器
+#include "premul_decoder.h" // 预乘alpha图像（叠加层素材）
+#include "storage_bench.h"  // 存储基准测试
+#include "backlight.h"      // 自动背光
+#include "fetch_scheduler.h" // 后台数据抓取
+#include "time_service.h"   // 时间服务（NTP校时、频偏修正、重启后从RTC内存恢复）
+#include "remote_display.h" // 远程显示（UDP推流）
+#include "ota_update.h"     // OTA固件升级
+#include "asset_bundle.h"   // flash资源包
+#include "i18n.h"           // 多语言文字（资源包中的语言包）
+#include "render_prof.h"    // 渲染分阶段计时
+#include "cache_prof.h"     // 取指停顿统计（CACHE_PROF构建）
+#include "draw_split.h"     // 双核绘制（实验性）
+#include "power.h"          // 动态调频、自动浅睡眠与待机
+#include "auto_rotate.h"    // 按重力方向自动旋转显示
+#include "boot.h"           // 启动计时与并行初始化
+#include "app_manager.h"    // 应用框架（生命周期与资源预算）
+#include "app_prefetch.h"   // 应用预热（按导航图提前加载资源）
+#include "parallax.h"       // IMU视差场景
+#include "effects.h"        // 程序化待机效果
+#include "mesh_scene.h"     // 实时三维网格场景
+#include "lv_bench.h"       // 设备端LVGL基准测试
+#include "telemetry.h"      // 运行时遥测（HTTP/UDP）
+#include "soak_test.h"      // 长时间运行测试（内存碎片趋势）
+#include "logger.h"         // 异步日志（串口/SD卡/UDP）
+#include "config_store.h"   // 配置（NVS缓存，SD卡config.json变化时导入）
+#include "scene_index.h"    // 场景索引（增量重建）
+#include "scene_playlist.h" // 场景播放列表（预载下一场景）
+#include "buf_manager.h"    // 缓冲区分配（片内/PSRAM）
+#include "desk_clock.h"     // 桌面时钟应用
+#include "photo_album.h"    // 相册应用
+#include "weather.h"        // 天气应用
+#include "mqtt_feed.h"      // MQTT实时数据
+#include "sensor_bus.h"     // 传感器总线（各传感器每周期读取一次，快照与抽取订阅）
+#include "sensor_hub.h"     // 传感器中枢（照度/有人/姿态经MQTT上报Home Assistant）
+#include "audio_viz.h"      // 音频频谱可视化（I2S麦克风）
+#include "serial_link.h"    // 串口高速传输（代替HoloTool.exe）
+#include "resume_state.h"   // 热重启恢复（界面状态快照到RTC内存）
+#include "supervisor.h"     // 任务监视（停顿检测、I2C/SD恢复）
+#include "sd_hotplug.h"     // SD卡热插拔（暂停读写、后台重新挂载）
+#include "data_logger.h"    // 传感器数据记录（IMU/环境光，文件轮换）
+#include "app_module.h"     // 应用模块（SD卡/资源包中的字节码应用，沙箱执行）
+#include "focus_nav.h"      // 编码器焦点导航（焦点框代替对象的聚焦样式）
+#include "async_image.h"    // 异步图像加载（后台解码，解码完成前显示占位图）
+#include "virtual_list.h"   // 虚拟列表（固定行对象池）
+#include "stream_chart.h"   // 实时曲线图（环形像素缓冲）
+#include "color_grade.h"    // 按环境光调色（刷新时查表）
+#include "perf_check.h"     // 性能回归检查（与SD卡上的基线比较）
+#include "prim_bench.h"     // 绘制原语微基准（CCOUNT计周期，冷/热缓存）
+#include "scene_bench.h"    // 场景播放基准（SD读取/解码/绘制/SPI各阶段占用与可持续帧率）
+#include "quality_gov.h"    // 帧预算与画质调节（超出预算时逐级关闭阴影、抗锯齿等）
+#include "screenshot.h"     // 截图（刷新时逐条带编码为BMP/QOI）
+#include "screen_record.h"  // 录屏（刷新区域增量记录到SD卡，HoloRec还原为视频）
+#include "live_link.h"      // ESP-NOW实时画面（伴侣板摄像头）
+#include "scene_sync.h"     // 多设备场景同步（UDP时钟同步）
+#include "console.h"        // 串口诊断命令（stats/heap/bench/scene等，回复经日志输出）
 
 /**** 硬件组件对象实例化 ****/
 Display screen;     // 显示屏对象 - 管理ST7789 TFT显示屏
 IMU mpu;           // IMU传感器对象 - 管理MPU6050六轴传感器
+Ambient amb;       // 环境光传感器对象 - 管理BH1750（与IMU共用I2C总线）
+Backlight backlight; // 背光对象 - 按环境光自动调节屏幕亮度
 Pixel rgb;         // RGB LED对象 - 管理板载WS2812 LED
 SdCard tf;         // SD卡对象 - 管理文件系统和数据存储
 Network wifi;      // WiFi网络对象 - 管理无线连接和网络应用
+Runtime runtime;   // 运行时对象 - 管理LVGL渲染任务、传感器任务和UI消息队列
+ScenePlayer scene; // 场景播放器对象 - 预读并播放SD卡中的全息动画
+ScenePlayer scene_next; // 第二个场景播放器 - 播放列表切换前用它预载下一场景
+ScenePlaylist playlist; // 播放列表对象 - 按列表轮播场景，切换时无空白帧
+RemoteDisplay remote; // 远程显示对象 - 接收PC推送的画面直接写屏
+PowerManager power; // 电源管理对象 - 动态调频，无操作时调暗背光并进入待机
+Boot boot;         // 启动计时对象 - 记录各初始化阶段耗时，外设在核心0并行初始化
+ParallaxScene parallax; // 视差场景对象 - 按姿态平移多层图像，只重绘移动图层的区域
+EffectEngine effects; // 效果对象 - 等离子/星空/火焰/噪声待机画面，逐条带计算写屏
+MeshScene mesh;       // 三维网格场景 - 随姿态旋转的实时渲染模型，逐条带光栅化写屏
+AutoRotate autorotate; // 自动旋转对象 - 立方体侧放时按重力方向切换面板MADCTL
 
 // LVGL GUI管理对象
 lv_ui guider_ui;   // GUI向导界面结构体
@@ -43,95 +117,336 @@ lv_ui guider_ui;   // GUI向导界面结构体
  * 执行顺序：
  * 1. 串口通信初始化
  * 2. 显示系统初始化（TFT屏幕 + LVGL）
- * 3. 输入设备初始化（IMU传感器作为编码器）
- * 4. 状态指示初始化（RGB LED）
- * 5. 存储系统初始化（SD卡 + FAT文件系统）
- * 6. 用户界面初始化
- * 7. 网络功能初始化（可选）
+ * 3. 核心0并行初始化外设：IMU与环境光（共用I2C总线，依次执行）、SD卡挂载
+ * 4. 核心1继续：输入设备、RGB LED、LVGL文件系统与解码器、用户界面，立即刷新出首帧
+ * 5. 等待SD卡：配置文件有变化时导入，网络功能初始化（可选）
+ * 6. 等待IMU：启动运行时任务（传感器任务需要IMU已初始化）
+ * 7. 输出启动时间线
  */
 void setup()
 {
-    // 初始化串口通信，波特率115200
-    Serial.begin(115200);
+    boot.begin();
+
+    // 初始化串口通信，波特率115200（接收缓冲须在begin之前设置，容纳串口传输的一个窗口）
+    Serial.setRxBufferSize(SERIAL_LINK_RX_BUF);
+    Serial.begin(SERIAL_LINK_BOOT_BAUD);
     Serial.println("HoloCubic System Starting...");
+    logger.begin();             // 日志输出任务：LOG_x写入缓冲区，由低优先级任务输出到串口
+    seriallink.begin();         // 等待主机握手（3.Software/HoloLink），握手后切换到2M波特率传输文件
+#if CONSOLE_ON_BOOT
+    console.begin(&screen, &scene); // 串口诊断命令（help列出），回复经日志输出
+#endif
+    resume.begin();             // OTA/看门狗/崩溃复位后保留上次的界面状态，上电时清空
+    timesvc.begin();            // 时区；软件复位后从RTC内存恢复时间（联网后在后台抓取窗口中NTP校时）
+    supervisor.begin();         // 各任务登记的阶段卡住时记录停顿并恢复I2C总线/SD卡，耗时分布见遥测
+    OtaUpdate::checkBoot();     // OTA新固件启动计数，多次启动失败时回滚
+    config.begin();             // 从NVS读入配置，不需要SD卡
 
     /**** 显示系统初始化 ****/
-    screen.init();              // 初始化ST7789 TFT显示屏和LVGL
-    screen.setBackLight(0.2);   // 设置背光亮度为20%（PWM控制）
+    boot.run("display", [](void* arg) {
+        screen.init();              // 初始化ST7789 TFT显示屏和LVGL
+        buf_manager_init();         // 检测PSRAM，有PSRAM时放大LVGL图像缓存
+        screen.setBackLight(0.2);   // 设置背光亮度为20%（PWM控制），自动背光启动后接管
+    });
+
+    /**** 外设并行初始化（核心0，不访问LVGL）****/
+    int sensors = boot.async("imu+ambient", [](void* arg) {
+        mpu.init(IMU_MODE_DMP);     // 初始化MPU6050 IMU传感器（I2C接口，DMP姿态融合，失败时改用软件融合）
+        amb.init(CONTINUOUS_H_RESOLUTION_MODE); // 初始化BH1750环境光传感器（连续测量）
+        backlight.begin(&screen, &amb, 0.2);    // 从20%亮度开始，按环境光自动调节
+    });
+    int storage = boot.async("sd", [](void* arg) {
+        tf.init();                  // 初始化SD卡（HSPI接口）
+    });
 
     /**** 输入设备初始化 ****/
-    lv_port_indev_init();       // 初始化LVGL输入设备端口
-    mpu.init();                 // 初始化MPU6050 IMU传感器（I2C接口）
+    boot.run("indev", [](void* arg) { lv_port_indev_init(); }); // 初始化LVGL输入设备端口
 
     /**** RGB状态指示灯初始化 ****/
-    rgb.init();                 // 初始化WS2812 RGB LED
-    // 设置两颗LED为蓝色，亮度10%，表示系统启动状态
-    rgb.setBrightness(0.1).setRGB(0, 0, 122, 204).setRGB(1, 0, 122, 204);
-
-    /**** 存储系统初始化 ****/
-    tf.init();                  // 初始化SD卡（HSPI接口）
-    lv_fs_if_init();           // 初始化LVGL文件系统接口
+    boot.run("rgb", [](void* arg) {
+        rgb.init();                 // 初始化WS2812 RGB LED
+        // 设置两颗LED为蓝色，亮度10%，表示系统启动状态
+        rgb.setBrightness(0.1).setRGB(0, 0, 122, 204).setRGB(1, 0, 122, 204);
+    });
 
-    // 从SD卡读取WiFi配置信息
-    String ssid = tf.readFileLine("/wifi.txt", 1);        // 第1行：WiFi SSID
-    String password = tf.readFileLine("/wifi.txt", 2);    // 第2行：WiFi密码
+    /**** LVGL文件系统与解码器（只注册驱动，打开文件时才访问SD卡）****/
+    boot.run("lv_fs", [](void* arg) {
+        lv_fs_if_init();           // 初始化LVGL文件系统接口
+        jpeg_decoder_lv_init();    // 注册JPEG解码器，lv_img可直接显示S:/xxx.jpg
+        palette_decoder_lv_init(); // 内存中的索引色图像按查找表展开为真彩色
+        bin_decoder_lv_init();     // S:/xxx.bin真彩色图像按条带顺序读取
+        q565_decoder_lv_init();    // Q565压缩帧（.holo）在绘制时逐行解码
+        premul_decoder_lv_init();  // 预乘alpha图像按片段直接混合，其他情况逐行还原
+        scene.setDisplay(&screen); // MJPEG动画包按条带直接写屏
+        scene.setLeds(&rgb);       // LED环境色跟随场景平均色
+        scene_next.setDisplay(&screen);
+        scene_next.setLeds(&rgb);
+        playlist.begin(&scene, &scene_next); // 两个播放器交替播放列表中的场景
+        resume.watch(&scene);      // 热重启后从上次显示的帧继续
+        resume.watch(&scene_next);
+        parallax.setDisplay(&screen); // 视差场景合成后直接写屏
+        effects.setDisplay(&screen);  // 待机效果逐条带直接写屏
+        mesh.setDisplay(&screen);     // 三维网格逐条带光栅化后直接写屏
+        audioviz.setDisplay(&screen); // 频谱条只写变化部分
+        audioviz.setLeds(&rgb);       // LED随频谱变色
+        screenshot.begin(&screen);    // 截图：GET /screenshot或screenshot.captureToFile()（不能在LVGL任务中调用）
+        screenrec.begin(&screen);     // 录屏：screenrec.start()/stop()，保存到SD卡/rec/
+    });
 
     /**** 用户界面初始化 ****/
-    lv_holo_cubic_gui();        // 加载HoloCubic自定义GUI界面
-    // setup_ui(&guider_ui);    // 可选：使用GUI向导生成的界面
+    boot.run("gui", [](void* arg) {
+        assets.begin();             // 映射flash资源包（未烧录时界面使用内置资源）
+        i18n.begin();               // 按配置ui.lang选择语言包（没有时使用内置英文）
+        lv_holo_cubic_gui();        // 加载HoloCubic自定义GUI界面
+        apps.begin();               // 应用调度定时器（没有应用运行时不占用LVGL任务）
+        prefetcher.begin();         // 空闲时预热接下来可能进入的应用的图像、字形与文件（apps.openNext轮播）
+        deskclock.setNetwork(&wifi); // 时钟按联网状态显示等待联网/正在同步
+        album.setImu(&mpu);         // 相册按倾斜方向预解码下一张
+        // 示例：场景播放作为应用，离开前台后停止播放
+        // static const App scene_app = { "scene",
+        //     [](void* u) { gui_load(GUI_SCR_SCENES, LV_SCR_LOAD_ANIM_MOVE_LEFT);
+        //                   if (scene.open("/Scenes/Holo3D", 0, 25)) scene.play(guider_ui.scenes_canvas); },
+        //     NULL, NULL, [](void* u) { scene.close(); }, 16 * 1024, 0, 0, 0, NULL };
+        // apps.open(apps.add(scene_app));
+        // setup_ui(&guider_ui);    // 可选：使用GUI向导生成的界面
+        // 热重启时只创建上次的界面：setup_ui_at(&guider_ui, (gui_scr_t)resume.getScreen(GUI_SCR_SCENES));
+        // 使用GUI向导界面时，可在场景界面播放SD卡动画（frame000.bin ~ frame137.bin）
+        // if (scene.open("/Scenes/Holo3D", 0, 25)) scene.play(guider_ui.scenes_canvas);
+        // 或按/Scenes/playlist.txt轮播（需在SD卡挂载之后）：if (playlist.load()) playlist.start(guider_ui.scenes_canvas);
+        lv_refr_now(NULL);          // 立即画出启动画面，不等待外设与渲染任务
+    });
+    boot.mark("first frame");
+
+    /**** 存储相关（等待SD卡挂载）****/
+    boot.wait(storage);
+    config.sync();              // config.json（或旧的wifi.txt）有变化时导入，否则只比较文件标记
+    // 日志输出目标（log.sinks，现场调试时设为3同时写入SD卡/log/holo.log，超过256KB轮换为.old）
+    logger.setSinks(config.getInt(CFG_LOG_SINKS));
+    // 场景索引在后台增量更新（只读取修改过的场景），不等待完成
+    boot.async("scene index", [](void* arg) { SceneIndex::build(); });
+#if STORAGE_BENCH_ON_BOOT
+    StorageBench bench;
+    bench.run();               // 输出存储基准报告（BENCH,...）
+#endif
 
     /**** 网络功能初始化（当前已禁用）****/
 #if 0
-    wifi.init(ssid, password);  // 连接WiFi网络
+    // 设备名（device.name，mDNS为<name>.local）与多设备管理密钥（fleet.key），见3.Software/HoloFleet
+    wifi.setIdentity(config.getStr(CFG_DEVICE_NAME), config.getStr(CFG_FLEET_KEY));
+    // 管理工具切换场景时按名称打开场景目录并播放（空名称为停止）
+    wifi.getFleet()->setSceneCallback([](const char* name, uint8_t fps, void* user) {
+        char dir[SCENE_INDEX_NAME_MAX + sizeof(SCENE_ROOT) + 1];
+        scene.close();
+        if (name[0] == '\0') return;
+        snprintf(dir, sizeof(dir), SCENE_ROOT "/%s", name);
+        if (scene.open(dir, 0, fps ? fps : 25)) scene.play(guider_ui.scenes_canvas);
+    });
+    // 没有配置SSID时进入ESP-Touch配网，收到的凭据写入配置（密码保存在密码分区），下次启动直接快速连接
+    wifi.setCredentialsCallback([](const char* ssid, const char* password, void* user) {
+        config.set(CFG_WIFI_SSID, ssid);
+        config.set(CFG_WIFI_PASSWORD, password);
+    });
+    wifi.init(config.getStr(CFG_WIFI_SSID), config.getStr(CFG_WIFI_PASSWORD)); // 异步连接WiFi网络，立即返回
+    fetcher.begin(&wifi);       // 启动后台数据抓取任务（联网后自动请求）
+
+    // 示例：每10分钟刷新B站粉丝数（UID取自配置bili.uid），值变化时打印
+    static JsonDocument fans_filter;
+    fans_filter["data"]["follower"] = true;
+    FetchSource fans = {
+        "bili_fans", "", 600, 3600, &fans_filter,
+        [](JsonDocument* doc, char* out, size_t len) {
+            if (!(*doc)["data"]["follower"].is<unsigned int>()) return false;
+            snprintf(out, len, "%u", (*doc)["data"]["follower"].as<unsigned int>());
+            return true;
+        },
+        [](uint8_t id, const char* value, void* user) { Serial.printf("B站粉丝数: %s\n", value); },
+        NULL
+    };
+    snprintf(fans.url, sizeof(fans.url), NET_BILI_FANS_URL, config.getStr(CFG_BILI_UID));
+    fetcher.add(fans);
+    // 天气：每30分钟刷新（经纬度取自配置weather.lat/lon），记录缓存在NVS，开机即可显示
+    weather.begin(config.getStr(CFG_WEATHER_LAT), config.getStr(CFG_WEATHER_LON));
+    // MQTT推送（mqtt.uri未配置时不连接）：主题绑定到控件，每个控件每周期最多刷新一次
+    // 示例：发布端以retain发布holocubic/<设备名>/fans，值变化时打印（绑定标签时obj填标签、apply填NULL）
+    static char fans_topic[MQTT_TOPIC_LEN];
+    snprintf(fans_topic, sizeof(fans_topic), "holocubic/%s/fans", wifi.getFleet()->getName());
+    mqtt.bind({ fans_topic, 1, 1000, NULL, NULL,
+        [](lv_obj_t* obj, const char* value, void* user) { Serial.printf("MQTT粉丝数: %s\n", value); }, NULL });
+    mqtt.begin(config.getStr(CFG_MQTT_URI), config.getStr(CFG_MQTT_USER), config.getStr(CFG_MQTT_PASSWORD),
+               wifi.getFleet()->getName());
+    // 传感器中枢（hub.enable）：统计窗口取自已有的采样路径，不增加I2C读取
+    if (config.getBool(CFG_HUB_ENABLE)) sensorhub.begin(&mpu, &amb, &mqtt, wifi.getFleet()->getName());
+    // 多设备场景同步（sync.group非0）：同组的立方体播放同一场景时逐帧对齐到主机（MAC最小的一台）的时间轴
+    if (config.getInt(CFG_SYNC_GROUP)) scenesync.begin(&wifi, &scene, &scene_next, config.getInt(CFG_SYNC_GROUP));
 
-    // 示例：获取B站粉丝数（需要修改为你的UID）
-    Serial.println(wifi.getBilibiliFans("20259914"));
+    // 遥测UDP推送：每秒向监控端发送一个JSON报文（需TELEMETRY_ON_BOOT或telemetry.begin()）
+    // telemetry.setUdpTarget(IPAddress(192, 168, 1, 100));
+    // 日志UDP输出：nc -ul 9126
+    // logger.setUdpTarget(IPAddress(192, 168, 1, 100));
+    // logger.setSinks(LOG_SINK_UART | LOG_SINK_UDP);
+
+    // 远程显示模式：PC端向UDP 7000端口推送分块/JPEG画面（start需在LVGL任务中执行）
+    // runtime.post([](const UiMsg* msg) { remote.start(&screen); });
+    // ESP-NOW实时画面：伴侣板（摄像头）推送JPEG分片，直接写入场景播放器的槽位（start需在LVGL任务中执行）
+    // runtime.post([](const UiMsg* msg) { livelink.start(&scene, guider_ui.scenes_canvas, &wifi, SCENE_LIVE_JPEG, 240, 240); });
 #endif
 
+    /**** 启动运行时任务（等待IMU初始化完成）****/
+    // 此后LVGL只在渲染任务中运行，其他模块通过runtime.post()更新界面
+    boot.wait(sensors);
+    boot.run("runtime", [](void* arg) {
+        sensorbus.begin(&amb);      // 环境光由传感器任务按测量周期读取，IMU样本经总线发布
+        runtime.begin(&screen, &mpu);
+        sdhotplug.begin();          // 掉卡或拔插后暂停SD读写并在后台重新挂载（重新挂载时持有LVGL锁）
+        imgloader.begin();          // 图像解码在另一个核的后台任务中进行，lv_task_handler不因大图停顿
+        // rgb.setGlow(&mpu, 255, 160, 60); // 转动时LED叠加暖色辉光
+        power.begin(&backlight, &amb, &mpu); // 空闲降频；无操作时调暗、待机，移动或光线变化时唤醒
+        autorotate.begin(&screen, &mpu);     // 侧放时自动旋转（setEnabled(true)后生效）
+        autorotate.setEnabled(AUTO_ROTATE_ON_BOOT);
+    });
+    // 视差场景：图层取自flash资源包，场景描述文件格式见parallax.cpp（start需在LVGL任务中执行）
+    // if (parallax.load("/Scenes/parallax.txt")) runtime.post([](const UiMsg* msg) { parallax.start(); });
+    // 待机效果：每EFFECT_CYCLE_S秒轮换一种（start需在LVGL任务中执行）
+    // runtime.post([](const UiMsg* msg) { effects.start(EFFECT_PLASMA); });
+    // 三维网格：512个三角形的环面随立方体姿态旋转（start需在LVGL任务中执行）
+    // runtime.post([](const UiMsg* msg) { mesh.makeTorus(70, 32, 16, 16); mesh.start(); });
+    // 桌面时钟：只重绘变化的数字，两秒之间LVGL任务休眠（start需在LVGL任务中执行）
+    // runtime.post([](const UiMsg* msg) { apps.open(apps.add(clock_app)); });
+    // 相册：/Photos下的JPEG与.bin，翻页先显示缩略图，停留后解码完整图像（start需在LVGL任务中执行）
+    // runtime.post([](const UiMsg* msg) { apps.open(apps.add(album_app)); });
+    // 天气：图标取自资源包中的"weather_icons"图集（8个正方形图标横向排列）
+    // runtime.post([](const UiMsg* msg) { apps.open(apps.add(weather_app)); });
+    // 音频可视化：需外接I2S麦克风（引脚见audio_input.h，BCLK 26 / WS 25 / DIN 35）
+    // runtime.post([](const UiMsg* msg) { apps.open(apps.add(audio_viz_app)); });
+    // 数据记录：IMU与环境光写入SD卡/log/data（每小时换一个文件），界面为加速度实时曲线；200Hz需mpu.init(IMU_MODE_FIFO)
+    // datalogger.begin(&mpu);
+    // runtime.post([](const UiMsg* msg) { apps.open(apps.add(datalog_app)); });
+    // 应用模块：SD卡/apps下的.ham（3.Software/HoloApp汇编生成）与资源包中的mod_*登记为应用，只读取文件头
+    // runtime.post([](const UiMsg* msg) { modules.addApps(); });
+    // 焦点导航：倾斜只移动屏幕上的焦点框，被聚焦的按钮不重绘（按下转发为LV_EVENT_CLICKED）
+    // static FocusScope home_focus;
+    // runtime.post([](const UiMsg* msg) {
+    //     home_focus.create(lv_scr_act(), LV_COLOR_WHITE, FOCUS_FRAME);
+    //     home_focus.add(btn_a); home_focus.add(btn_b); home_focus.add(btn_c);
+    //     home_focus.attach();
+    // });
+    // 异步图像：先显示占位图，JPEG在后台缩放解码到不超过120x120，完成后替换（set需在LVGL任务中调用）
+    // runtime.post([](const UiMsg* msg) {
+    //     lv_obj_t* img = lv_img_create(lv_scr_act(), NULL);
+    //     imgloader.set(img, "/Photos/cover.jpg", LV_SYMBOL_IMAGE, 120, 120);
+    // });
+    // 实时曲线：加速度三轴以50Hz采样，每个采样只画一列（start需在LVGL任务中执行）
+    // static StreamChart accel_chart;
+    // runtime.post([](const UiMsg* msg) {
+    //     static const lv_color_t colors[3] = { LV_COLOR_RED, LV_COLOR_LIME, LV_COLOR_CYAN };
+    //     accel_chart.create(lv_scr_act(), 200, 100, 3, colors, -16384, 16384);
+    //     lv_obj_align(accel_chart.getObj(), NULL, LV_ALIGN_CENTER, 0, 0);
+    //     lv_task_create([](lv_task_t* t) {
+    //         int16_t v[3] = { mpu.getAccelX(), mpu.getAccelY(), mpu.getAccelZ() };
+    //         accel_chart.push(v);
+    //     }, 20, LV_TASK_PRIO_MID, NULL);
+    // });
+    // 场景列表：虚拟列表按需读取场景索引的条目（行对象数固定，与场景数无关），确认键播放选中的场景
+    // static SceneIndex list_index;
+    // static VirtualList scene_list;
+    // runtime.post([](const UiMsg* msg) {
+    //     list_index.open();
+    //     scene_list.create(lv_scr_act(), LV_HOR_RES_MAX, LV_VER_RES_MAX, 24);
+    //     scene_list.setSource([](uint32_t i, char* text, uint16_t text_len, char* detail, uint16_t detail_len, void* user) {
+    //         SceneIndexEntry e;
+    //         if (!list_index.get(i, &e)) return false;
+    //         strlcpy(text, e.name, text_len);
+    //         snprintf(detail, detail_len, "%us", e.duration_ms / 1000);
+    //         return true;
+    //     }, [](uint32_t i, void* user) {
+    //         SceneIndexEntry e;
+    //         char dir[SCENE_INDEX_NAME_MAX + sizeof(SCENE_ROOT) + 1];
+    //         if (!list_index.get(i, &e)) return;
+    //         snprintf(dir, sizeof(dir), SCENE_ROOT "/%s", e.name);
+    //         if (scene.open(dir, 0, e.fps ? e.fps : SCENE_INDEX_DEFAULT_FPS)) scene.play(guider_ui.scenes_canvas);
+    //     }, NULL);
+    //     scene_list.setCount(list_index.getCount());
+    //     lv_group_t* g = lv_group_create();
+    //     lv_group_add_obj(g, scene_list.getObj());
+    //     lv_group_set_editing(g, true);
+    //     lv_indev_set_group(indev_encoder, g);
+    // });
+#if COLOR_GRADE_ON_BOOT
+    // 强光下压缩高光，调色表在刷新时与字节交换一起查表
+    runtime.post([](const UiMsg* msg) { colorgrade.begin(&screen, &amb); });
+#endif
+#if SCREEN_RECORD_ON_BOOT
+    // 录屏：只记录变化的刷新区域，现场调试时可持续开启
+    screenrec.start();
+#endif
+#if QUALITY_ON_BOOT
+    // 画质调节：平均帧时间连续超出刷新周期时逐级关闭阴影、抗锯齿，改用低一级缩略图，降低LED刷新率；余量恢复后逐级恢复
+    runtime.post([](const UiMsg* msg) { quality.begin(&screen, &rgb); });
+#endif
+#if PERF_CHECK_ON_BOOT
+    // 性能回归检查：约数秒，结果写入SD卡/bench/perf.json，首次运行时建立基线/bench/perf_base.json
+    runtime.post([](const UiMsg* msg) { perfcheck.run(); });
+#endif
+#if PRIM_BENCH_ON_BOOT
+    // 绘制原语微基准：约数秒，每组参数冷/热缓存各计时，结果追加到SD卡/bench/prims.csv
+    runtime.post([](const UiMsg* msg) { primbench.run(&screen); });
+#endif
+#if SCENE_BENCH_ON_BOOT
+    // 场景播放基准：预热后约10秒，播放/Scenes/bench.holo，各阶段占用与可持续帧率追加到SD卡/bench/scene.csv
+    scenebench.start(&scene);
+#endif
+#if LV_BENCH_ON_BOOT
+    // LVGL基准测试：约90秒，结果写入SD卡/bench/lvgl.json，结束后回到原界面
+    runtime.post([](const UiMsg* msg) { apps.open(apps.add(lv_bench_app)); });
+#endif
+#if TELEMETRY_ON_BOOT
+    telemetry.begin();         // 每秒采样，结果见GET /telemetry，不输出到串口
+#endif
+#if DATALOG_ON_BOOT
+    // 数据记录：不打开界面，持续写入SD卡/log/data，用HoloLog/holo_log.py转换为CSV
+    datalogger.begin(&mpu);
+    datalogger.start();
+#endif
+#if SOAK_TEST_ON_BOOT
+    // 长时间运行测试：循环切换界面与场景，每分钟把内存与帧率写入SD卡/soak/soak.csv
+    soak.begin(&scene);
+#endif
+#if RENDER_PROF_ON_BOOT
+    // 叠加层需在LVGL任务中创建；串口CSV可随时调用render_prof_dump()输出
+    runtime.post([](const UiMsg* msg) { render_prof_overlay(true); });
+#endif
+#if CACHE_PROF
+    // 取指停顿统计：每CACHE_PROF_LOG_MS输出各渲染阶段的CPI与停顿占比
+    runtime.post([](const UiMsg* msg) { cache_prof_enable(true); });
+#endif
+#if DRAW_SPLIT_ON_BOOT
+    // 双核绘制：在LVGL任务中启用，避免拆分进行中切换
+    runtime.post([](const UiMsg* msg) { draw_split_enable(true); });
+#endif
+
+    // 热重启恢复：应用登记（以上runtime.post）之后打开上次的前台应用并继续播放场景，之后开始记录状态
+    runtime.post([](const UiMsg* msg) {
+        resume.restoreUi();
+        resume.restoreScene(guider_ui.scenes_canvas);
+        resume.start();
+    });
+
     Serial.println("System initialization completed!");
+    boot.report();              // 输出启动时间线（BOOT,...）
 }
 
-// 动画帧计数器（用于播放SD卡中的动画序列）
-int frame_id = 0;
-char buf[100];  // 文件路径缓冲区
-
 /**
  * 主循环函数
  * 
  * 功能说明：
- * 1. 处理LVGL图形库任务（显示刷新、动画更新等）
- * 2. 更新IMU传感器数据并转换为输入事件
- * 3. 处理动画播放（从SD卡加载帧图像）
- * 4. 处理网络任务和其他后台任务
+ * 显示刷新与传感器读取已移至运行时任务（见runtime.cpp）：
+ * 1. LVGL渲染任务（核心1）：处理UI消息队列和lv_task_handler，空闲时休眠到下一个定时器到期
+ * 2. 传感器任务（核心0）：以固定周期读取IMU并转换为输入事件
  * 
- * 执行频率：尽可能高频率运行，确保界面流畅
+ * Arduino主循环不再承担实时工作，仅保持空闲
  */
 void loop()
 {
-    /**** 显示系统任务处理 ****/
-    // LVGL任务处理器 - 处理界面刷新、动画、事件等
-    // 这个函数需要尽可能频繁调用以保证界面流畅
-    screen.routine();
-
-    /**** 输入设备数据更新 ****/
-    // 每200ms更新一次IMU数据，避免过于频繁的传感器读取
-    // IMU数据会被转换为LVGL编码器事件用于界面导航
-    mpu.update(200);
-
-    // 调试输出（可以移除）
-    Serial.println("System running...");
-
-    /**** 动画播放功能（当前已注释）****/
-    // 以下代码演示如何从SD卡播放动画序列
-    // 动画文件命名格式：S:/Scenes/Holo3D/frame000.bin ~ frame137.bin
-//    int len = sprintf(buf, "S:/Scenes/Holo3D/frame%03d.bin", frame_id++);
-//    buf[len] = 0;
-//    lv_img_set_src(guider_ui.scenes_canvas, buf);  // 设置图像源
-//    Serial.println(buf);
-//
-//    if (frame_id == 138) frame_id = 0;  // 循环播放动画
-
-    /**** 可选延时 ****/
-    // 如果需要降低CPU使用率，可以添加小延时
-    // delay(10);
-}
\ No newline at end of file
+    // 所有工作都在各自的任务中，删除Arduino的loop任务，tickless空闲时不再被它周期唤醒
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,325 @@
+/*
+ * HoloCubic 跑马灯控件
+ *
+ * 功能说明：
+ * 1. setText时按字体位图直接把整段文字光栅化到条带缓冲（A8覆盖率或预混合背景色的RGB565）
+ * 2. 控件使用自己的绘制回调：每行最多两段（条带末尾折回开头），A8段调用_lv_blend_fill（条带行作为遮罩），
+ *    RGB565段调用_lv_blend_map（直接复制）
+ * 3. 定时器按时间推进位置，整像素位置变化时才使控件失效
+ *
+ * 数据流：
+ *   setText --> measure --> render（一次） --> taskCb：pos更新 --> lv_obj_invalidate --> designCb：按行复制可见窗口
+ */
+
+#include "marquee.h"
+#include "buf_manager.h"
+#include "logger.h"
+
+static lv_signal_cb_t ancestor_signal = NULL;
+
+/**
+ * 控件的扩展数据：指回所属的Marquee
+ */
+struct MarqueeExt
+{
+	Marquee* owner;
+};
+
+Marquee::Marquee()
+{
+	obj = NULL;
+	task = NULL;
+	strip = NULL;
+	format = MARQUEE_A8;
+	font = NULL;
+	strip_w = strip_h = 0;
+	scrolling = false;
+	speed = MARQUEE_SPEED;
+	pos_q8 = 0;
+	shown = 0;
+	last_ms = 0;
+	loops = 0;
+}
+
+/**
+ * 创建控件（高度为字体行高）
+ *
+ * @param w  控件宽度，文字更宽时循环滚动
+ * @param bg 背景色，只用于RGB565格式（A8格式透明，显示下层内容）
+ */
+bool Marquee::create(lv_obj_t* parent, lv_coord_t w, const lv_font_t* f, lv_color_t fg_color, lv_color_t bg_color,
+					 MarqueeFormat fmt)
+{
+	if (obj) return false;
+
+	obj = lv_obj_create(parent, NULL);
+	if (obj == NULL) return false;
+	MarqueeExt* ext = (MarqueeExt*)lv_obj_allocate_ext_attr(obj, sizeof(MarqueeExt));
+	if (ext == NULL)
+	{
+		lv_obj_del(obj);
+		obj = NULL;
+		return false;
+	}
+	ext->owner = this;
+
+	if (ancestor_signal == NULL) ancestor_signal = lv_obj_get_signal_cb(obj);
+	lv_obj_set_design_cb(obj, designCb);
+	lv_obj_set_signal_cb(obj, signalCb);
+	lv_obj_set_click(obj, false);
+
+	font = f;
+	fg = fg_color;
+	bg = bg_color;
+	format = fmt;
+	strip_h = lv_font_get_line_height(font);
+	lv_obj_set_size(obj, w, strip_h);
+	return true;
+}
+
+/**
+ * 删除控件，释放条带与定时器
+ */
+void Marquee::destroy()
+{
+	// 删除时的CLEANUP信号调用detach
+	if (obj) lv_obj_del(obj);
+}
+
+lv_obj_t* Marquee::getObj()
+{
+	return obj;
+}
+
+/**
+ * 设置文字：整段渲染一次到条带缓冲，滚动位置回到开头
+ * @return 控件未创建或条带超过MARQUEE_MAX_BYTES/内存不足时返回false（控件显示为空）
+ */
+bool Marquee::setText(const char* txt)
+{
+	if (obj == NULL) return false;
+
+	release();
+	lv_obj_invalidate(obj);
+	lv_coord_t text_w = txt ? measure(font, txt) : 0;
+	if (text_w <= 0) return true;
+
+	scrolling = text_w > lv_obj_get_width(obj);
+	strip_w = scrolling ? text_w + MARQUEE_GAP : text_w;
+	uint32_t px = (uint32_t)strip_w * strip_h;
+	uint32_t size = format == MARQUEE_A8 ? px : px * sizeof(lv_color_t);
+	if (size > MARQUEE_MAX_BYTES || (strip = (uint8_t*)buf_alloc(BUF_BULK, size)) == NULL)
+	{
+		LOG_W("marquee", "条带缓冲分配失败: %d x %d, %u字节", strip_w, strip_h, size);
+		strip_w = 0;
+		return false;
+	}
+	render(txt, text_w);
+
+	pos_q8 = 0;
+	shown = 0;
+	loops = 0;
+	last_ms = millis();
+	if (scrolling) task = lv_task_create(taskCb, MARQUEE_PERIOD_MS, LV_TASK_PRIO_MID, this);
+	return true;
+}
+
+/**
+ * 设置滚动速度（像素/秒），0为暂停
+ */
+void Marquee::setSpeed(uint16_t px_per_s)
+{
+	speed = px_per_s;
+	last_ms = millis();
+}
+
+/**
+ * 已完整滚动的遍数（setText后从0开始），可用于通知显示若干遍后关闭
+ */
+uint16_t Marquee::getLoops()
+{
+	return loops;
+}
+
+void Marquee::release()
+{
+	if (task)
+	{
+		lv_task_del(task);
+		task = NULL;
+	}
+	if (strip)
+	{
+		buf_free(strip);
+		strip = NULL;
+	}
+	strip_w = 0;
+	scrolling = false;
+}
+
+/**
+ * 控件已删除：停止定时器并释放条带
+ */
+void Marquee::detach()
+{
+	release();
+	obj = NULL;
+}
+
+/**
+ * 文字宽度（含字距调整）
+ */
+lv_coord_t Marquee::measure(const lv_font_t* f, const char* txt)
+{
+	uint32_t i = 0;
+	int32_t w = 0;
+	uint32_t letter = _lv_txt_encoded_next(txt, &i);
+	while (letter)
+	{
+		uint32_t next = _lv_txt_encoded_next(txt, &i);
+		w += lv_font_get_glyph_width(f, letter, next);
+		letter = next;
+	}
+	return (lv_coord_t)LV_MATH_MIN(w, LV_COORD_MAX);
+}
+
+/**
+ * 把文字光栅化到条带（字形位图按bpp连续存放，不按行对齐）
+ * A8：覆盖率取各字形的较大值；RGB565：先填背景色，再逐像素按覆盖率混合前景色
+ */
+void Marquee::render(const char* txt, lv_coord_t text_w)
+{
+	uint32_t px = (uint32_t)strip_w * strip_h;
+	lv_color_t* cbuf = (lv_color_t*)strip;
+	if (format == MARQUEE_A8) memset(strip, 0, px);
+	else for (uint32_t i = 0; i < px; i++) cbuf[i] = bg;
+
+	uint32_t i = 0;
+	int32_t x = 0;
+	uint32_t letter = _lv_txt_encoded_next(txt, &i);
+	while (letter && x < text_w)
+	{
+		uint32_t next = _lv_txt_encoded_next(txt, &i);
+		lv_font_glyph_dsc_t g;
+		if (lv_font_get_glyph_dsc(font, &g, letter, next))
+		{
+			const uint8_t* bm = g.box_w ? lv_font_get_glyph_bitmap(font, letter) : NULL;
+			uint8_t bpp = g.bpp == 3 ? 4 : g.bpp;
+			if (bm && (bpp == 1 || bpp == 2 || bpp == 4 || bpp == 8))
+			{
+				uint8_t mask = (1 << bpp) - 1;
+				uint8_t scale = 255 / mask;
+				int32_t gx = x + g.ofs_x;
+				int32_t gy = font->line_height - font->base_line - g.box_h - g.ofs_y;
+				uint32_t bit = 0;
+				for (int32_t r = 0; r < g.box_h; r++)
+				{
+					int32_t y = gy + r;
+					for (int32_t c = 0; c < g.box_w; c++, bit += bpp)
+					{
+						int32_t sx = gx + c;
+						if (y < 0 || y >= strip_h || sx < 0 || sx >= text_w) continue;
+						uint8_t a = ((bm[bit >> 3] >> (8 - bpp - (bit & 7))) & mask) * scale;
+						if (a == 0) continue;
+						uint32_t o = (uint32_t)y * strip_w + sx;
+						if (format == MARQUEE_A8) strip[o] = LV_MATH_MAX(strip[o], a);
+						else cbuf[o] = lv_color_mix(fg, cbuf[o], a);
+					}
+				}
+			}
+			x += g.adv_w;
+		}
+		letter = next;
+	}
+}
+
+Marquee* Marquee::of(lv_obj_t* o)
+{
+	MarqueeExt* ext = (MarqueeExt*)lv_obj_get_ext_attr(o);
+	return ext ? ext->owner : NULL;
+}
+
+/**
+ * 绘制回调：按行绘制条带的可见窗口
+ */
+lv_design_res_t Marquee::designCb(lv_obj_t* o, const lv_area_t* clip, lv_design_mode_t mode)
+{
+	Marquee* m = of(o);
+	if (mode == LV_DESIGN_COVER_CHK)
+	{
+		// RGB565条带不透明：滚动时铺满整个控件，下层对象不必绘制
+		if (m && m->strip && m->format == MARQUEE_RGB565 && m->scrolling && _lv_area_is_in(clip, &o->coords, 0))
+		{
+			return LV_DESIGN_RES_COVER;
+		}
+		return LV_DESIGN_RES_NOT_COVER;
+	}
+	if (mode != LV_DESIGN_DRAW_MAIN || m == NULL || m->strip == NULL) return LV_DESIGN_RES_OK;
+
+	lv_area_t area;
+	if (!_lv_area_intersect(&area, clip, &o->coords)) return LV_DESIGN_RES_OK;
+	lv_opa_t opa = lv_obj_get_style_opa_scale(o, LV_OBJ_PART_MAIN);
+	if (opa < LV_OPA_MIN) return LV_DESIGN_RES_OK;
+
+	area.y2 = LV_MATH_MIN(area.y2, o->coords.y1 + m->strip_h - 1);
+	for (lv_coord_t y = area.y1; y <= area.y2; y++)
+	{
+		uint32_t row = (uint32_t)(y - o->coords.y1) * m->strip_w;
+		lv_coord_t x = area.x1;
+		while (x <= area.x2)
+		{
+			// 滚动时按条带宽度折回；不滚动时文字右侧不绘制
+			lv_coord_t col = x - o->coords.x1;
+			if (m->scrolling) col = (col + m->shown) % m->strip_w;
+			else if (col >= m->strip_w) break;
+			lv_coord_t n = LV_MATH_MIN(m->strip_w - col, area.x2 - x + 1);
+
+			lv_area_t seg = { x, y, (lv_coord_t)(x + n - 1), y };
+			if (m->format == MARQUEE_A8)
+			{
+				_lv_blend_fill(&seg, &seg, m->fg, m->strip + row + col, LV_DRAW_MASK_RES_CHANGED, opa, LV_BLEND_MODE_NORMAL);
+			}
+			else
+			{
+				_lv_blend_map(&seg, &seg, (lv_color_t*)m->strip + row + col, NULL, LV_DRAW_MASK_RES_FULL_COVER, opa,
+							  LV_BLEND_MODE_NORMAL);
+			}
+			x += n;
+		}
+	}
+	return LV_DESIGN_RES_OK;
+}
+
+lv_res_t Marquee::signalCb(lv_obj_t* o, lv_signal_t sign, void* param)
+{
+	if (sign == LV_SIGNAL_CLEANUP)
+	{
+		Marquee* m = of(o);
+		if (m) m->detach();
+	}
+	return ancestor_signal(o, sign, param);
+}
+
+/**
+ * 滚动定时器：按经过的时间推进，整像素位置变化时重绘
+ */
+void Marquee::taskCb(lv_task_t* t)
+{
+	Marquee* self = (Marquee*)t->user_data;
+	uint32_t now = millis();
+	uint32_t dt = LV_MATH_MIN(now - self->last_ms, 200U);
+	self->last_ms = now;
+	if (!self->scrolling || self->speed == 0) return;
+
+	uint32_t limit = (uint32_t)self->strip_w << 8;
+	self->pos_q8 += self->speed * dt * 256 / 1000;
+	while (self->pos_q8 >= limit)
+	{
+		self->pos_q8 -= limit;
+		self->loops++;
+	}
+	lv_coord_t pos = self->pos_q8 >> 8;
+	if (pos == self->shown) return;
+	self->shown = pos;
+	lv_obj_invalidate(self->obj);
+}
@@ -0,0 +1,764 @@
+/*
+ * HoloCubic 三维网格场景模块
+ *
+ * 功能说明：
+ * 1. 参数化生成环面、球面、立方体网格，或使用外部提供的顶点与三角形
+ * 2. DMP姿态（相对初始姿态）叠加自转换算为Q14旋转矩阵，顶点经透视投影得到1/16像素的屏幕坐标
+ * 3. 屏幕空间绕向剔除背面，面法线与光线方向的点积决定亮度（平面着色）
+ * 4. 三角形按深度由远到近排序后逐条带扫描线填充（画家算法），两个条带缓冲交替DMA写屏
+ *
+ * 数据流：
+ *   orientation.get() --> updateRotation --> transform（投影、剔除、着色、排序）
+ *     --> 逐条带render（fillTri/drawEdge） --> pushStrip（DMA） --> endStrips
+ *
+ * 光栅化规则：像素中心落在三角形内（上边与左边包含，下边与右边不包含）才填充，相邻三角形不重叠不留缝
+ */
+
+#include "mesh_scene.h"
+#include "orientation.h"
+#include <esp_heap_caps.h>
+
+// 光线方向（观察空间，指向左上前方的光源），Q15单位向量
+static const int16_t light_dir[3] = { FX_Q15(-0.36f), FX_Q15(0.48f), FX_Q15(0.80f) };
+
+/**
+ * lv_color_t转为面板字节序RGB565
+ */
+static inline uint16_t panel565(lv_color_t c)
+{
+#if LV_COLOR_16_SWAP
+	return c.full;
+#else
+	return (c.full >> 8) | (c.full << 8);
+#endif
+}
+
+static inline int16_t clamp16(int32_t v)
+{
+	return (int16_t)LV_MATH_MAX(-32767, LV_MATH_MIN(v, 32767));
+}
+
+/**
+ * Q14矩阵乘法 out = a * b（3x3，行优先）
+ */
+static void matMul(const int16_t* a, const int16_t* b, int16_t* out)
+{
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		for (uint8_t j = 0; j < 3; j++)
+		{
+			int32_t s = (int32_t)a[i * 3] * b[j] + (int32_t)a[i * 3 + 1] * b[3 + j] + (int32_t)a[i * 3 + 2] * b[6 + j];
+			out[i * 3 + j] = (int16_t)((s + (1 << 13)) >> 14);
+		}
+	}
+}
+
+/**
+ * 单位四元数转为Q14旋转矩阵
+ */
+static void quatToMatrix(float w, float x, float y, float z, int16_t* m)
+{
+	const float s = 16384.0f;
+	m[0] = lroundf((1 - 2 * (y * y + z * z)) * s);
+	m[1] = lroundf(2 * (x * y - w * z) * s);
+	m[2] = lroundf(2 * (x * z + w * y) * s);
+	m[3] = lroundf(2 * (x * y + w * z) * s);
+	m[4] = lroundf((1 - 2 * (x * x + z * z)) * s);
+	m[5] = lroundf(2 * (y * z - w * x) * s);
+	m[6] = lroundf(2 * (x * z - w * y) * s);
+	m[7] = lroundf(2 * (y * z + w * x) * s);
+	m[8] = lroundf((1 - 2 * (x * x + y * y)) * s);
+}
+
+/**
+ * 绕Y轴（spin）与绕X轴（tilt）的Q14旋转矩阵
+ */
+static void rotY(fx_angle_t a, int16_t* m)
+{
+	int16_t c = fx_cos(a) >> 1, s = fx_sin(a) >> 1;
+	m[0] = c;  m[1] = 0;     m[2] = s;
+	m[3] = 0;  m[4] = 16384; m[5] = 0;
+	m[6] = -s; m[7] = 0;     m[8] = c;
+}
+
+static void rotX(fx_angle_t a, int16_t* m)
+{
+	int16_t c = fx_cos(a) >> 1, s = fx_sin(a) >> 1;
+	m[0] = 16384; m[1] = 0; m[2] = 0;
+	m[3] = 0;     m[4] = c; m[5] = -s;
+	m[6] = 0;     m[7] = s; m[8] = c;
+}
+
+/**
+ * 生成的网格统一调整三角形绕向：法线应背离参考点（球面、立方体为原点，环面为管道中心线上最近的点）
+ */
+static void orientFaces(const MeshVertex* v, MeshFace* f, uint16_t nf, float major)
+{
+	for (uint16_t i = 0; i < nf; i++)
+	{
+		const MeshVertex &a = v[f[i].a], &b = v[f[i].b], &c = v[f[i].c];
+		float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+		float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+		float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+
+		float cx = (a.x + b.x + c.x) / 3.0f, cy = (a.y + b.y + c.y) / 3.0f, cz = (a.z + b.z + c.z) / 3.0f;
+		if (major > 0)
+		{
+			float r = sqrtf(cx * cx + cz * cz);
+			if (r > 0)
+			{
+				cx -= cx * major / r;
+				cz -= cz * major / r;
+			}
+		}
+		if (nx * cx + ny * cy + nz * cz < 0)
+		{
+			uint16_t t = f[i].b;
+			f[i].b = f[i].c;
+			f[i].c = t;
+		}
+	}
+}
+
+/**
+ * 四边形(a, b, c, d)拆为两个三角形
+ */
+static void addQuad(MeshFace* f, uint16_t* n, uint16_t a, uint16_t b, uint16_t c, uint16_t d)
+{
+	f[(*n)++] = { a, b, c };
+	f[(*n)++] = { a, c, d };
+}
+
+MeshScene::MeshScene()
+{
+	display = NULL;
+	running = false;
+	verts = NULL;
+	faces = NULL;
+	normals = NULL;
+	vert_count = face_count = 0;
+	owned = false;
+	proj = NULL;
+	tris = NULL;
+	tri_count = 0;
+	strips[0] = strips[1] = NULL;
+	mode = MESH_SOLID;
+	color = LV_COLOR_CYAN;
+	bg = 0;
+	edge = panel565(LV_COLOR_WHITE);
+	spin = 0;
+	spin_dps = MESH_SPIN_DPS;
+	frame_task = NULL;
+	screen = prev_screen = NULL;
+	view.x1 = 0;
+	view.y1 = 0;
+	view.x2 = LV_HOR_RES_MAX - 1;
+	view.y2 = LV_VER_RES_MAX - 1;
+}
+
+void MeshScene::setDisplay(Display* disp)
+{
+	display = disp;
+}
+
+/**
+ * 设置网格
+ *
+ * @param v  顶点（模型坐标，到原点的距离不超过MESH_MAX_RADIUS），数据在场景期间须保持有效
+ * @param f  三角形，从外侧看为逆时针，数据在场景期间须保持有效
+ * @return 超过MESH_MAX_VERTS/MESH_MAX_FACES、顶点序号越界、模型过大或内存不足时返回false
+ */
+bool MeshScene::setMesh(const MeshVertex* v, uint16_t nv, const MeshFace* f, uint16_t nf)
+{
+	close();
+	if (v == NULL || f == NULL || nv == 0 || nf == 0 || nv > MESH_MAX_VERTS || nf > MESH_MAX_FACES) return false;
+	for (uint16_t i = 0; i < nv; i++)
+	{
+		int32_t r2 = (int32_t)v[i].x * v[i].x + (int32_t)v[i].y * v[i].y + (int32_t)v[i].z * v[i].z;
+		if (r2 > (int32_t)MESH_MAX_RADIUS * MESH_MAX_RADIUS)
+		{
+			Serial.printf("网格顶点%u超出半径%d\n", i, MESH_MAX_RADIUS);
+			return false;
+		}
+	}
+	for (uint16_t i = 0; i < nf; i++)
+	{
+		if (f[i].a >= nv || f[i].b >= nv || f[i].c >= nv)
+		{
+			Serial.printf("网格三角形%u的顶点序号越界\n", i);
+			return false;
+		}
+	}
+
+	verts = (MeshVertex*)v;
+	faces = (MeshFace*)f;
+	vert_count = nv;
+	face_count = nf;
+	if (!alloc(nv, nf))
+	{
+		Serial.println("网格工作缓冲分配失败");
+		release();
+		return false;
+	}
+	computeNormals();
+	return true;
+}
+
+/**
+ * 生成环面（甜甜圈）：管道中心线半径major、管道半径minor，seg_u x seg_v个四边形
+ * 16 x 16为512个三角形
+ */
+bool MeshScene::makeTorus(int16_t major, int16_t minor, uint8_t seg_u, uint8_t seg_v)
+{
+	if (seg_u < 3 || seg_v < 3) return false;
+	uint32_t nv = (uint32_t)seg_u * seg_v, nf = nv * 2;
+	if (nv > MESH_MAX_VERTS || nf > MESH_MAX_FACES) return false;
+
+	MeshVertex* v = (MeshVertex*)malloc(nv * sizeof(MeshVertex));
+	MeshFace* f = (MeshFace*)malloc(nf * sizeof(MeshFace));
+	if (v == NULL || f == NULL)
+	{
+		free(v);
+		free(f);
+		return false;
+	}
+	for (uint16_t i = 0; i < seg_u; i++)
+	{
+		float u = 2 * PI * i / seg_u;
+		for (uint16_t j = 0; j < seg_v; j++)
+		{
+			float t = 2 * PI * j / seg_v;
+			float r = major + minor * cosf(t);
+			v[i * seg_v + j] = { (int16_t)lroundf(r * cosf(u)), (int16_t)lroundf(minor * sinf(t)),
+								 (int16_t)lroundf(r * sinf(u)) };
+		}
+	}
+	uint16_t n = 0;
+	for (uint16_t i = 0; i < seg_u; i++)
+	{
+		uint16_t i2 = (i + 1) % seg_u;
+		for (uint16_t j = 0; j < seg_v; j++)
+		{
+			uint16_t j2 = (j + 1) % seg_v;
+			addQuad(f, &n, i * seg_v + j, i2 * seg_v + j, i2 * seg_v + j2, i * seg_v + j2);
+		}
+	}
+	orientFaces(v, f, n, major);
+
+	if (!setMesh(v, nv, f, n))
+	{
+		free(v);
+		free(f);
+		return false;
+	}
+	owned = true;
+	return true;
+}
+
+/**
+ * 生成经纬球面：seg_u条经线、seg_v个纬度分段（两极为三角扇），16 x 16为480个三角形
+ */
+bool MeshScene::makeSphere(int16_t radius, uint8_t seg_u, uint8_t seg_v)
+{
+	if (seg_u < 3 || seg_v < 2) return false;
+	uint16_t rings = seg_v - 1;
+	uint32_t nv = rings * seg_u + 2, nf = (uint32_t)seg_u * 2 * rings;
+	if (nv > MESH_MAX_VERTS || nf > MESH_MAX_FACES) return false;
+
+	MeshVertex* v = (MeshVertex*)malloc(nv * sizeof(MeshVertex));
+	MeshFace* f = (MeshFace*)malloc(nf * sizeof(MeshFace));
+	if (v == NULL || f == NULL)
+	{
+		free(v);
+		free(f);
+		return false;
+	}
+	for (uint16_t r = 0; r < rings; r++)
+	{
+		float phi = PI * (r + 1) / seg_v;
+		for (uint16_t i = 0; i < seg_u; i++)
+		{
+			float u = 2 * PI * i / seg_u;
+			v[r * seg_u + i] = { (int16_t)lroundf(radius * sinf(phi) * cosf(u)), (int16_t)lroundf(radius * cosf(phi)),
+								 (int16_t)lroundf(radius * sinf(phi) * sinf(u)) };
+		}
+	}
+	uint16_t top = rings * seg_u, bottom = top + 1;
+	v[top] = { 0, radius, 0 };
+	v[bottom] = { 0, (int16_t)-radius, 0 };
+
+	uint16_t n = 0;
+	for (uint16_t i = 0; i < seg_u; i++)
+	{
+		uint16_t i2 = (i + 1) % seg_u;
+		f[n++] = { top, i, i2 };
+		for (uint16_t r = 0; r + 1 < rings; r++)
+		{
+			addQuad(f, &n, r * seg_u + i, (r + 1) * seg_u + i, (r + 1) * seg_u + i2, r * seg_u + i2);
+		}
+		f[n++] = { bottom, (uint16_t)((rings - 1) * seg_u + i2), (uint16_t)((rings - 1) * seg_u + i) };
+	}
+	orientFaces(v, f, n, 0);
+
+	if (!setMesh(v, nv, f, n))
+	{
+		free(v);
+		free(f);
+		return false;
+	}
+	owned = true;
+	return true;
+}
+
+/**
+ * 生成立方体（边长2 * half，12个三角形）
+ */
+bool MeshScene::makeCube(int16_t half)
+{
+	MeshVertex* v = (MeshVertex*)malloc(8 * sizeof(MeshVertex));
+	MeshFace* f = (MeshFace*)malloc(12 * sizeof(MeshFace));
+	if (v == NULL || f == NULL)
+	{
+		free(v);
+		free(f);
+		return false;
+	}
+	for (uint8_t i = 0; i < 8; i++)
+	{
+		v[i] = { (int16_t)(i & 1 ? half : -half), (int16_t)(i & 2 ? half : -half), (int16_t)(i & 4 ? half : -half) };
+	}
+	uint16_t n = 0;
+	addQuad(f, &n, 0, 1, 3, 2);    // z-
+	addQuad(f, &n, 4, 5, 7, 6);    // z+
+	addQuad(f, &n, 0, 1, 5, 4);    // y-
+	addQuad(f, &n, 2, 3, 7, 6);    // y+
+	addQuad(f, &n, 0, 2, 6, 4);    // x-
+	addQuad(f, &n, 1, 3, 7, 5);    // x+
+	orientFaces(v, f, n, 0);
+
+	if (!setMesh(v, 8, f, n))
+	{
+		free(v);
+		free(f);
+		return false;
+	}
+	owned = true;
+	return true;
+}
+
+/**
+ * 设置颜色与绘制方式（运行中调用时下一帧整屏重绘）
+ *
+ * @param fg 模型颜色，朝向光源的面最亮
+ */
+void MeshScene::setStyle(lv_color_t fg, lv_color_t bg_color, MeshMode m)
+{
+	color = fg;
+	bg = panel565(bg_color);
+	mode = m;
+	edge = panel565(m == MESH_WIRE ? fg : lv_color_mix(LV_COLOR_WHITE, fg, LV_OPA_50));
+	full = true;
+}
+
+/**
+ * 设置绕模型Y轴的自转速度（度/秒），0为不自转（只跟随姿态）
+ */
+void MeshScene::setSpin(uint16_t deg_per_s)
+{
+	spin_dps = deg_per_s;
+}
+
+/**
+ * 进入网格场景（在LVGL任务中调用）
+ */
+bool MeshScene::start()
+{
+	if (running) return true;
+	if (display == NULL || face_count == 0) return false;
+
+	uint32_t strip_px = LV_HOR_RES_MAX * MESH_STRIP_LINES;
+	strips[0] = (uint16_t*)heap_caps_malloc(strip_px * 2 * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	if (strips[0] == NULL)
+	{
+		Serial.println("网格场景条带缓冲分配失败");
+		return false;
+	}
+	strips[1] = strips[0] + strip_px;
+
+	// 空白屏幕：LVGL不再有需要重绘的对象，先画完这一次，之后不会覆盖画面
+	prev_screen = lv_scr_act();
+	screen = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(screen, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	lv_scr_load(screen);
+	lv_refr_now(NULL);
+
+	memset(&stats, 0, sizeof(stats));
+	memset(m, 0, sizeof(m));
+	spin = 0;
+	has_zero = false;
+	shown_valid = false;
+	full = true;
+	last_ms = millis();
+
+	running = true;
+	frame_task = lv_task_create(frameCb, 1000 / MESH_FPS, LV_TASK_PRIO_HIGH, this);
+	return true;
+}
+
+/**
+ * 退出网格场景，恢复原来的LVGL屏幕（在LVGL任务中调用），网格保留
+ */
+void MeshScene::stop()
+{
+	if (!running) return;
+
+	running = false;
+	if (frame_task)
+	{
+		lv_task_del(frame_task);
+		frame_task = NULL;
+	}
+	if (prev_screen) lv_scr_load(prev_screen);
+	if (screen) lv_obj_del(screen);
+	screen = prev_screen = NULL;
+
+	heap_caps_free(strips[0]);
+	strips[0] = strips[1] = NULL;
+}
+
+void MeshScene::close()
+{
+	stop();
+	release();
+}
+
+/**
+ * 以当前姿态作为初始姿态
+ */
+void MeshScene::recenter()
+{
+	has_zero = false;
+}
+
+bool MeshScene::isRunning()
+{
+	return running;
+}
+
+void MeshScene::getStats(MeshStats* out)
+{
+	*out = stats;
+}
+
+bool MeshScene::alloc(uint16_t nv, uint16_t nf)
+{
+	normals = (int16_t*)malloc(nf * 3 * sizeof(int16_t));
+	proj = (Proj*)malloc(nv * sizeof(Proj));
+	tris = (Tri*)malloc(nf * sizeof(Tri));
+	return normals && proj && tris;
+}
+
+void MeshScene::release()
+{
+	if (owned)
+	{
+		free(verts);
+		free(faces);
+	}
+	verts = NULL;
+	faces = NULL;
+	owned = false;
+	free(normals);
+	free(proj);
+	free(tris);
+	normals = NULL;
+	proj = NULL;
+	tris = NULL;
+	vert_count = face_count = tri_count = 0;
+}
+
+/**
+ * 面法线（只在设置网格时计算一次）
+ */
+void MeshScene::computeNormals()
+{
+	for (uint16_t i = 0; i < face_count; i++)
+	{
+		const MeshVertex &a = verts[faces[i].a], &b = verts[faces[i].b], &c = verts[faces[i].c];
+		float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+		float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+		float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+		float len = sqrtf(nx * nx + ny * ny + nz * nz);
+		float k = len > 0 ? 32767.0f / len : 0;
+		normals[i * 3] = lroundf(nx * k);
+		normals[i * 3 + 1] = lroundf(ny * k);
+		normals[i * 3 + 2] = lroundf(nz * k);
+	}
+}
+
+/**
+ * 计算本帧旋转矩阵：DMP姿态相对初始姿态的旋转（不可用时为固定倾角）乘以自转
+ * @return 矩阵有变化
+ */
+bool MeshScene::updateRotation(uint32_t dt)
+{
+	spin += (fx_angle_t)((uint32_t)spin_dps * LV_MATH_MIN(dt, 200U) * 65536 / 360000);
+
+	int16_t dev[9], rs[9], out[9];
+	OrientationData d;
+	if (orientation.isReady() && orientation.get(&d))
+	{
+		if (!has_zero)
+		{
+			zero[0] = d.q.w;
+			zero[1] = d.q.x;
+			zero[2] = d.q.y;
+			zero[3] = d.q.z;
+			has_zero = true;
+		}
+		Quaternion rel = Quaternion(zero[0], -zero[1], -zero[2], -zero[3]).getProduct(d.q);
+#if MESH_WORLD_FIXED
+		rel = rel.getConjugate();
+#endif
+		quatToMatrix(rel.w, rel.x, rel.y, rel.z, dev);
+	}
+	else
+	{
+		rotX(fx_deg_to_angle(MESH_IDLE_TILT), dev);
+	}
+	rotY(spin, rs);
+	matMul(dev, rs, out);
+
+	if (memcmp(out, m, sizeof(m)) == 0) return false;
+	memcpy(m, out, sizeof(m));
+	return true;
+}
+
+/**
+ * 顶点投影，三角形剔除、着色、排序，得到本帧包围盒
+ */
+void MeshScene::transform()
+{
+	const int32_t cx = LV_HOR_RES_MAX * 8, cy = LV_VER_RES_MAX * 8;
+	for (uint16_t i = 0; i < vert_count; i++)
+	{
+		const MeshVertex& v = verts[i];
+		int32_t rx = ((int32_t)m[0] * v.x + (int32_t)m[1] * v.y + (int32_t)m[2] * v.z) >> 14;
+		int32_t ry = ((int32_t)m[3] * v.x + (int32_t)m[4] * v.y + (int32_t)m[5] * v.z) >> 14;
+		int32_t rz = ((int32_t)m[6] * v.x + (int32_t)m[7] * v.y + (int32_t)m[8] * v.z) >> 14;
+		// 顶点半径不超过MESH_MAX_RADIUS，w始终为正
+		int32_t w = MESH_CAMERA_Z - rz;
+		proj[i].x = clamp16(cx + rx * (MESH_FOCAL * 16) / w);
+		proj[i].y = clamp16(cy - ry * (MESH_FOCAL * 16) / w);
+		proj[i].z = (int16_t)rz;
+	}
+
+	area.x1 = area.y1 = LV_COORD_MAX;
+	area.x2 = area.y2 = LV_COORD_MIN;
+	tri_count = 0;
+	for (uint16_t i = 0; i < face_count; i++)
+	{
+		const Proj &a = proj[faces[i].a], &b = proj[faces[i].b], &c = proj[faces[i].c];
+		// 模型中逆时针的三角形投影到y向下的屏幕后为顺时针
+		int32_t cross = (int32_t)(b.x - a.x) * (c.y - a.y) - (int32_t)(b.y - a.y) * (c.x - a.x);
+		if (cross >= 0) continue;
+
+		lv_coord_t x1 = LV_MATH_MIN(a.x, LV_MATH_MIN(b.x, c.x)) >> 4;
+		lv_coord_t x2 = LV_MATH_MAX(a.x, LV_MATH_MAX(b.x, c.x)) >> 4;
+		lv_coord_t y1 = LV_MATH_MIN(a.y, LV_MATH_MIN(b.y, c.y)) >> 4;
+		lv_coord_t y2 = LV_MATH_MAX(a.y, LV_MATH_MAX(b.y, c.y)) >> 4;
+		if (x2 < view.x1 || x1 > view.x2 || y2 < view.y1 || y1 > view.y2) continue;
+
+		const int16_t* n = normals + i * 3;
+		int32_t nx = ((int32_t)m[0] * n[0] + (int32_t)m[1] * n[1] + (int32_t)m[2] * n[2]) >> 14;
+		int32_t ny = ((int32_t)m[3] * n[0] + (int32_t)m[4] * n[1] + (int32_t)m[5] * n[2]) >> 14;
+		int32_t nz = ((int32_t)m[6] * n[0] + (int32_t)m[7] * n[1] + (int32_t)m[8] * n[2]) >> 14;
+		int32_t dot = (nx * light_dir[0] + ny * light_dir[1] + nz * light_dir[2]) >> 15;
+		uint8_t level = MESH_AMBIENT + (((255 - MESH_AMBIENT) * LV_MATH_MAX(dot, 0)) >> 15);
+
+		Tri* t = &tris[tri_count++];
+		t->face = i;
+		t->y1 = y1;
+		t->y2 = y2;
+		t->depth = (int32_t)a.z + b.z + c.z;
+		t->color = panel565(lv_color_mix(color, LV_COLOR_BLACK, level));
+
+		area.x1 = LV_MATH_MIN(area.x1, x1);
+		area.x2 = LV_MATH_MAX(area.x2, x2);
+		area.y1 = LV_MATH_MIN(area.y1, y1);
+		area.y2 = LV_MATH_MAX(area.y2, y2);
+	}
+
+	// 深度排序（插入排序：相邻帧顺序变化很小，接近有序时为线性时间）
+	for (uint16_t i = 1; i < tri_count; i++)
+	{
+		Tri t = tris[i];
+		int32_t j = i - 1;
+		while (j >= 0 && tris[j].depth > t.depth)
+		{
+			tris[j + 1] = tris[j];
+			j--;
+		}
+		tris[j + 1] = t;
+	}
+}
+
+/**
+ * 扫描线填充一个三角形落在条带a中的部分
+ */
+void MeshScene::fillTri(uint16_t* out, const lv_area_t* a, const Tri* t)
+{
+	const Proj* p[3] = { &proj[faces[t->face].a], &proj[faces[t->face].b], &proj[faces[t->face].c] };
+	// 按y排序：p0最上，p2最下
+	auto order = [&p](uint8_t i, uint8_t j) {
+		if (p[i]->y <= p[j]->y) return;
+		const Proj* tmp = p[i];
+		p[i] = p[j];
+		p[j] = tmp;
+	};
+	order(0, 1);
+	order(1, 2);
+	order(0, 1);
+	int32_t y0 = p[0]->y, y1 = p[1]->y, y2 = p[2]->y;
+	if (y2 == y0) return;
+
+	int32_t w = lv_area_get_width(a);
+	// 像素行r的中心为r * 16 + 8，包含y0、不包含y2
+	int32_t r1 = LV_MATH_MAX((y0 + 7) >> 4, a->y1);
+	int32_t r2 = LV_MATH_MIN(((y2 + 7) >> 4) - 1, a->y2);
+	for (int32_t r = r1; r <= r2; r++)
+	{
+		int32_t yc = r * 16 + 8;
+		int32_t xa = p[0]->x + (p[2]->x - p[0]->x) * (yc - y0) / (y2 - y0);
+		int32_t xb = yc < y1 ? p[0]->x + (p[1]->x - p[0]->x) * (yc - y0) / (y1 - y0)
+							 : p[1]->x + (p[2]->x - p[1]->x) * (yc - y1) / (y2 - y1);
+		if (xa > xb)
+		{
+			int32_t tmp = xa;
+			xa = xb;
+			xb = tmp;
+		}
+		int32_t s = LV_MATH_MAX((xa + 7) >> 4, a->x1);
+		int32_t e = LV_MATH_MIN(((xb + 7) >> 4) - 1, a->x2);
+		uint16_t* row = out + (r - a->y1) * w - a->x1;
+		for (int32_t x = s; x <= e; x++) row[x] = t->color;
+	}
+}
+
+/**
+ * 画一条边落在条带a中的部分：每个像素行画出边在该行内经过的横向范围，至少1像素宽
+ */
+void MeshScene::drawEdge(uint16_t* out, const lv_area_t* a, const Proj* p, const Proj* q)
+{
+	if (p->y > q->y)
+	{
+		const Proj* tmp = p;
+		p = q;
+		q = tmp;
+	}
+	int32_t w = lv_area_get_width(a);
+	int32_t dy = q->y - p->y;
+	int32_t r1 = LV_MATH_MAX(p->y >> 4, a->y1);
+	int32_t r2 = LV_MATH_MIN(q->y >> 4, a->y2);
+	for (int32_t r = r1; r <= r2; r++)
+	{
+		int32_t xs = p->x, xe = q->x;
+		if (dy)
+		{
+			int32_t top = LV_MATH_MAX(r * 16, p->y) - p->y;
+			int32_t bot = LV_MATH_MIN(r * 16 + 15, q->y) - p->y;
+			xs = p->x + (q->x - p->x) * top / dy;
+			xe = p->x + (q->x - p->x) * bot / dy;
+		}
+		if (xs > xe)
+		{
+			int32_t tmp = xs;
+			xs = xe;
+			xe = tmp;
+		}
+		int32_t s = LV_MATH_MAX(xs >> 4, a->x1);
+		int32_t e = LV_MATH_MIN(xe >> 4, a->x2);
+		uint16_t* row = out + (r - a->y1) * w - a->x1;
+		for (int32_t x = s; x <= e; x++) row[x] = edge;
+	}
+}
+
+/**
+ * 绘制一个条带：底色后按由远到近的顺序绘制覆盖该条带的三角形
+ */
+void MeshScene::render(uint16_t* out, const lv_area_t* a)
+{
+	uint32_t n = lv_area_get_size(a);
+	for (uint32_t i = 0; i < n; i++) out[i] = bg;
+
+	for (uint16_t i = 0; i < tri_count; i++)
+	{
+		const Tri* t = &tris[i];
+		if (t->y2 < a->y1 || t->y1 > a->y2) continue;
+		if (mode != MESH_WIRE) fillTri(out, a, t);
+		if (mode != MESH_SOLID)
+		{
+			const MeshFace& f = faces[t->face];
+			drawEdge(out, a, &proj[f.a], &proj[f.b]);
+			drawEdge(out, a, &proj[f.b], &proj[f.c]);
+			drawEdge(out, a, &proj[f.c], &proj[f.a]);
+		}
+	}
+}
+
+/**
+ * 帧定时任务：更新旋转，变换网格，重绘本帧与上一帧包围盒的并集
+ */
+void MeshScene::frameCb(lv_task_t* task)
+{
+	MeshScene* self = (MeshScene*)task->user_data;
+	uint32_t now = millis();
+	uint32_t t0 = micros();
+
+	bool changed = self->updateRotation(now - self->last_ms);
+	self->last_ms = now;
+	if (!changed && !self->full)
+	{
+		self->stats.idle++;
+		return;
+	}
+	self->transform();
+
+	// 旧画面所在区域也要重绘为底色
+	bool has_area = self->area.x1 <= self->area.x2;
+	lv_area_t r = self->area;
+	if (self->full) r = self->view;
+	else if (self->shown_valid && has_area) _lv_area_join(&r, &self->area, &self->shown);
+	else if (self->shown_valid) r = self->shown;
+	else if (!has_area)
+	{
+		self->stats.idle++;
+		return;
+	}
+	if (!_lv_area_intersect(&r, &r, &self->view)) return;
+	self->shown = self->area;
+	self->shown_valid = has_area;
+	self->full = false;
+
+	int32_t w = lv_area_get_width(&r);
+	int32_t lines = LV_HOR_RES_MAX * MESH_STRIP_LINES / w;
+	lv_area_t b = r;
+	self->display->waitVsync();
+	self->display->beginStrips();
+	for (int32_t y = r.y1, k = 0; y <= r.y2; y += lines, k ^= 1)
+	{
+		b.y1 = y;
+		b.y2 = LV_MATH_MIN(y + lines - 1, r.y2);
+		self->render(self->strips[k], &b);
+		// pushStrip先等待上一条带发送完成，因此另一个缓冲区可以继续绘制
+		self->display->pushStrip(b.x1, b.y1, w, lv_area_get_height(&b), self->strips[k]);
+	}
+	self->display->endStrips();
+
+	uint32_t dt = micros() - t0;
+	self->stats.frames++;
+	self->stats.visible = self->tri_count;
+	self->stats.pixels = lv_area_get_size(&r);
+	self->stats.frame_us = dt;
+	if (dt > self->stats.max_us) self->stats.max_us = dt;
+}
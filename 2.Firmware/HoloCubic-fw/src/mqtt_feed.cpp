@@ -0,0 +1,289 @@
+/*
+ * HoloCubic MQTT实时数据模块
+ *
+ * 功能说明：
+ * 1. esp-mqtt常驻连接，断线自动重连，连接后订阅绑定表中的全部主题（QoS0/1）
+ * 2. 消息按主题找到绑定，解析后写入缓存（MQTT任务中执行，不接触LVGL）
+ * 3. 界面更新合并：每个控件每个刷新周期最多更新一次，经runtime.post在LVGL任务中执行
+ * 4. publish()把消息放入esp-mqtt的发送队列（传感器中枢等上报用），不阻塞调用方
+ *
+ * 与HTTP轮询（FetchScheduler）相比：
+ * - 值变化后立即推送，不必等到下一次轮询
+ * - 空闲时只有保活（MQTT_KEEPALIVE_S），射频可在两次保活之间休眠，不再周期性建立HTTP连接
+ *
+ * 注意事项：
+ * - 绑定按完整主题匹配；分片的大消息（超过esp-mqtt缓冲区）只取第一片
+ * - 发布端应使用retain，重连后立即收到最近的值
+ */
+
+#include "mqtt_feed.h"
+#include "logger.h"
+
+MqttFeed mqtt;
+
+MqttFeed::MqttFeed()
+{
+	client = NULL;
+	flush_timer = NULL;
+	timer_armed = false;
+	connected = false;
+	connect_count = 0;
+	lock = portMUX_INITIALIZER_UNLOCKED;
+	count = 0;
+	received = 0;
+	updates = 0;
+}
+
+/**
+ * 添加绑定（主题复制到条目内）
+ */
+int MqttFeed::bind(const MqttBinding& b)
+{
+	if (count >= MQTT_MAX_BINDINGS || b.topic == NULL || strlen(b.topic) >= MQTT_TOPIC_LEN) return -1;
+
+	Entry* e = &entries[count];
+	memset(e, 0, sizeof(*e));
+	e->b = b;
+	strlcpy(e->topic, b.topic, sizeof(e->topic));
+	e->b.topic = e->topic;
+	if (e->b.period_ms == 0) e->b.period_ms = MQTT_DEFAULT_PERIOD_MS;
+	if (e->b.qos > 1) e->b.qos = 1;
+
+	portENTER_CRITICAL(&lock);
+	int id = count++;
+	portEXIT_CRITICAL(&lock);
+
+	if (connected) esp_mqtt_client_subscribe(client, e->topic, e->b.qos);
+	return id;
+}
+
+/**
+ * 连接代理（立即返回，连接与重连在esp-mqtt任务中进行）
+ */
+bool MqttFeed::begin(const char* uri, const char* user, const char* password, const char* client_id)
+{
+	if (client) return true;
+	if (uri == NULL || uri[0] == '\0') return false;
+
+	if (flush_timer == NULL)
+	{
+		esp_timer_create_args_t args = {};
+		args.callback = flushCb;
+		args.arg = this;
+		args.name = "mqtt_flush";
+		if (esp_timer_create(&args, &flush_timer) != ESP_OK) return false;
+	}
+
+	esp_mqtt_client_config_t cfg = {};
+	cfg.uri = uri;
+	cfg.username = user && user[0] ? user : NULL;
+	cfg.password = password && password[0] ? password : NULL;
+	cfg.client_id = client_id && client_id[0] ? client_id : NULL;
+	cfg.keepalive = MQTT_KEEPALIVE_S;
+	cfg.reconnect_timeout_ms = MQTT_RECONNECT_MS;
+	cfg.task_prio = MQTT_TASK_PRIORITY;
+	cfg.task_stack = MQTT_TASK_STACK;
+
+	client = esp_mqtt_client_init(&cfg);
+	if (client == NULL) return false;
+	esp_mqtt_client_register_event(client, (esp_mqtt_event_id_t)ESP_EVENT_ANY_ID, eventHandler, this);
+	if (esp_mqtt_client_start(client) != ESP_OK)
+	{
+		esp_mqtt_client_destroy(client);
+		client = NULL;
+		return false;
+	}
+	LOG_I("mqtt", "连接代理: %s，%u个绑定", uri, count);
+	return true;
+}
+
+void MqttFeed::end()
+{
+	if (client == NULL) return;
+	esp_mqtt_client_stop(client);
+	esp_mqtt_client_destroy(client);
+	client = NULL;
+	connected = false;
+	esp_timer_stop(flush_timer);
+	timer_armed = false;
+}
+
+bool MqttFeed::isConnected()
+{
+	return connected;
+}
+
+uint32_t MqttFeed::getConnectCount()
+{
+	return connect_count;
+}
+
+/**
+ * 发布消息：esp_mqtt_client_enqueue只写入发送队列，由MQTT任务发出，调用方不等待网络
+ */
+bool MqttFeed::publish(const char* topic, const char* data, int len, int qos, bool retain)
+{
+	if (client == NULL || !connected || topic == NULL || data == NULL) return false;
+	if (len <= 0) len = strlen(data);
+	return esp_mqtt_client_enqueue(client, topic, data, len, qos, retain ? 1 : 0, true) >= 0;
+}
+
+void MqttFeed::getStats(uint32_t* rx, uint32_t* ui)
+{
+	if (rx) *rx = received;
+	if (ui) *ui = updates;
+}
+
+void MqttFeed::subscribeAll()
+{
+	for (uint8_t i = 0; i < count; i++) esp_mqtt_client_subscribe(client, entries[i].topic, entries[i].b.qos);
+}
+
+/**
+ * esp-mqtt事件（在MQTT任务中执行）
+ */
+void MqttFeed::eventHandler(void* arg, esp_event_base_t base, int32_t id, void* data)
+{
+	MqttFeed* self = (MqttFeed*)arg;
+	esp_mqtt_event_handle_t ev = (esp_mqtt_event_handle_t)data;
+
+	switch ((esp_mqtt_event_id_t)id)
+	{
+	case MQTT_EVENT_CONNECTED:
+		self->connected = true;
+		self->connect_count++;
+		// 会话不保留订阅（clean session），每次连接后重新订阅
+		self->subscribeAll();
+		LOG_I("mqtt", "已连接");
+		break;
+	case MQTT_EVENT_DISCONNECTED:
+		if (self->connected) LOG_W("mqtt", "连接断开，%u秒后重连", MQTT_RECONNECT_MS / 1000);
+		self->connected = false;
+		break;
+	case MQTT_EVENT_DATA:
+		// 分片消息的后续片段没有主题
+		if (ev->current_data_offset == 0) self->onMessage(ev->topic, ev->topic_len, ev->data, ev->data_len);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * 收到消息：解析后写入缓存，不在周期内时立即提交一次界面更新，否则等定时器补发
+ */
+void MqttFeed::onMessage(const char* topic, int topic_len, const char* data, int len)
+{
+	for (uint8_t i = 0; i < count; i++)
+	{
+		Entry* e = &entries[i];
+		if ((int)strlen(e->topic) != topic_len || memcmp(e->topic, topic, topic_len) != 0) continue;
+
+		char value[MQTT_VALUE_LEN];
+		if (e->b.parse)
+		{
+			if (!e->b.parse(data, len, value, sizeof(value))) return;
+		}
+		else
+		{
+			int n = len < (int)sizeof(value) - 1 ? len : (int)sizeof(value) - 1;
+			memcpy(value, data, n);
+			value[n] = '\0';
+		}
+
+		portENTER_CRITICAL(&lock);
+		received++;
+		// 值未变化时不更新界面
+		bool changed = strcmp(value, e->value) != 0;
+		if (changed)
+		{
+			memcpy(e->value, value, sizeof(value));
+			e->dirty = true;
+		}
+		portEXIT_CRITICAL(&lock);
+		if (changed) schedule();
+		return;
+	}
+}
+
+/**
+ * 提交到期的更新，并为周期内的更新按最早的到期时间设置定时器
+ * 在MQTT任务与定时器任务中调用
+ */
+void MqttFeed::schedule()
+{
+	uint8_t due[MQTT_MAX_BINDINGS];
+	uint8_t n = 0;
+	uint32_t wait = UINT32_MAX;
+	uint32_t now = millis();
+
+	portENTER_CRITICAL(&lock);
+	for (uint8_t i = 0; i < count; i++)
+	{
+		Entry* e = &entries[i];
+		if (!e->dirty || e->posted) continue;
+		uint32_t since = now - e->applied_ms;
+		if (since >= e->b.period_ms)
+		{
+			e->posted = true;
+			due[n++] = i;
+		}
+		else if (e->b.period_ms - since < wait)
+		{
+			wait = e->b.period_ms - since;
+		}
+	}
+	bool arm = wait != UINT32_MAX && !timer_armed;
+	if (arm) timer_armed = true;
+	portEXIT_CRITICAL(&lock);
+
+	for (uint8_t k = 0; k < n; k++)
+	{
+		if (runtime.post(applyMsg, this, due[k])) continue;
+		// 界面队列已满：下个周期再试
+		portENTER_CRITICAL(&lock);
+		entries[due[k]].posted = false;
+		entries[due[k]].applied_ms = now;
+		if (!timer_armed)
+		{
+			timer_armed = true;
+			arm = true;
+		}
+		portEXIT_CRITICAL(&lock);
+		if (entries[due[k]].b.period_ms < wait) wait = entries[due[k]].b.period_ms;
+	}
+	if (arm) esp_timer_start_once(flush_timer, (uint64_t)wait * 1000);
+}
+
+/**
+ * 周期结束（在esp_timer任务中执行）
+ */
+void MqttFeed::flushCb(void* arg)
+{
+	MqttFeed* self = (MqttFeed*)arg;
+	portENTER_CRITICAL(&self->lock);
+	self->timer_armed = false;
+	portEXIT_CRITICAL(&self->lock);
+	self->schedule();
+}
+
+/**
+ * 更新控件（在LVGL任务中执行）：取出缓存中最新的值
+ */
+void MqttFeed::applyMsg(const UiMsg* msg)
+{
+	MqttFeed* self = (MqttFeed*)msg->obj;
+	Entry* e = &self->entries[msg->value];
+	char value[MQTT_VALUE_LEN];
+
+	portENTER_CRITICAL(&self->lock);
+	memcpy(value, e->value, sizeof(value));
+	e->dirty = false;
+	e->posted = false;
+	e->applied_ms = millis();
+	self->updates++;
+	portEXIT_CRITICAL(&self->lock);
+
+	if (e->b.apply) e->b.apply(e->b.obj, value, e->b.user);
+	else if (e->b.obj) lv_label_set_text(e->b.obj, value);
+}
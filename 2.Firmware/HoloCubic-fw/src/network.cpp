@@ -10,8 +10,15 @@
  * 
  * 网络特性：
  * - 支持2.4GHz WiFi（802.11 b/g/n）
- * - 自动重连机制
+ * - 事件驱动的异步连接，开机不等待网络
+ * - 网络任务（核心0）：HTTP/TLS、JSON解析与NVS写入都不在界面所在的核心执行，界面只收到定长结果
+ * - 缓存BSSID/信道快速重连（开机不做全信道扫描），失败时指数退避
+ * - 没有WiFi配置时用ESP-Touch（SmartConfig）配网，凭据由回调写入配置（密码分区）
+ * - 按网络工作窗口切换省电：窗口之间最大省电（Modem-sleep + 监听间隔），窗口内全速
  * - HTTP/HTTPS客户端
+ * - 无线上传场景文件到SD卡
+ * - OTA固件升级（HTTP下载或PUT /ota推送）
+ * - mDNS发现与多设备管理（状态、配置、场景、批量同步）
  * - JSON数据处理
  * - 网络状态监控
  * 
@@ -24,148 +31,505 @@
 
 #include "network.h"
 #include <WiFi.h>        // ESP32 WiFi库
-#include <HTTPClient.h>  // HTTP客户端库
 #include <ArduinoJson.h> // JSON解析库
+#include <Preferences.h>
+#include <esp_wifi.h>
+#include "energy.h"
 
 
 /**
- * WiFi网络初始化函数
+ * WiFi网络初始化函数（立即返回）
  * 
  * 功能描述：
- * 1. 扫描周围可用的WiFi网络
- * 2. 显示网络列表（SSID、信号强度、加密状态）
- * 3. 连接到指定的WiFi网络
- * 4. 等待连接成功并显示IP地址
+ * 1. 启动网络任务，注册WiFi事件回调，连接结果与断开均在事件中处理
+ * 2. 有缓存时直接按上次的BSSID/信道连接，跳过全信道扫描
+ * 3. 断开后按指数退避自动重连
  * 
  * @param ssid WiFi网络名称
- * @param password WiFi密码
+ * @param password WiFi密码（不会输出到串口）
  */
-void Network::init(String ssid, String password)
+void Network::init(const char* ssid, const char* password)
 {
-	// 开始扫描周围的WiFi网络
-	Serial.println("开始扫描WiFi网络...");
-	int n = WiFi.scanNetworks();
-	Serial.println("WiFi扫描完成");
-	
-	// 检查扫描结果
-	if (n == 0)
+	strlcpy(this->ssid, ssid, sizeof(this->ssid));
+	strlcpy(this->password, password, sizeof(this->password));
+	backoff_ms = NET_BACKOFF_MIN_MS;
+	cache_fails = 0;
+	ps_lock = portMUX_INITIALIZER_UNLOCKED;
+	active = 0;
+
+	if (queue == NULL) queue = xQueueCreate(NET_QUEUE_LEN, sizeof(Job));
+	if (queue && task == NULL)
+		xTaskCreatePinnedToCore(taskEntry, "net", NET_TASK_STACK, this, NET_TASK_PRIORITY, &task, NET_TASK_CORE);
+
+	esp_timer_create_args_t args = {};
+	args.callback = retryCb;
+	args.arg = this;
+	args.name = "wifi_retry";
+	esp_timer_create(&args, &retry_timer);
+	args.callback = provTimeoutCb;
+	args.name = "wifi_prov";
+	esp_timer_create(&args, &prov_timer);
+	upload.setOta(&ota);
+
+	WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) { onEvent(event, info); });
+	WiFi.mode(WIFI_STA);
+	// 重连由本模块按退避策略控制
+	WiFi.setAutoReconnect(false);
+
+	if (this->ssid[0] == '\0')
 	{
-		Serial.println("未发现任何WiFi网络");
+		startProvisioning();
+		return;
 	}
-	else
+
+	loadCache();
+	Serial.printf("正在连接WiFi: %s%s\n", this->ssid, cache_valid ? "（使用缓存信道）" : "");
+
+	setState(NET_CONNECTING);
+	// 先写入配置再连接：监听间隔只在关联时告知AP
+	if (cache_valid) WiFi.begin(this->ssid, this->password, cache_channel, cache_bssid, false);
+	else WiFi.begin(this->ssid, this->password, 0, NULL, false);
+#if NET_POWER_SAVE
+	wifi_config_t conf;
+	if (esp_wifi_get_config(WIFI_IF_STA, &conf) == ESP_OK)
 	{
-		// 显示发现的网络数量
-		Serial.print("发现 ");
-		Serial.print(n);
-		Serial.println(" 个WiFi网络:");
-		
-		// 遍历并显示每个网络的详细信息
-		for (int i = 0; i < n; ++i)
-		{
-			Serial.print(i + 1);
-			Serial.print(": ");
-			Serial.print(WiFi.SSID(i));        // 网络名称
-			Serial.print(" (");
-			Serial.print(WiFi.RSSI(i));        // 信号强度(dBm)
-			Serial.print("dBm)");
-			// 显示加密状态：开放网络显示空格，加密网络显示*
-			Serial.println((WiFi.encryptionType(i) == WIFI_AUTH_OPEN) ? " [开放]" : " [加密]*");
-			delay(10);  // 短暂延时，避免输出过快
-		}
+		conf.sta.listen_interval = NET_LISTEN_INTERVAL;
+		esp_wifi_set_config(WIFI_IF_STA, &conf);
 	}
-	
-	Serial.println("");
-	Serial.print("正在连接WiFi: ");
-	Serial.print(ssid.c_str());
-	Serial.print(" 密码: ");
-	Serial.println(password.c_str());
-
-	// 开始连接WiFi
-	WiFi.begin(ssid.c_str(), password.c_str());
-	
-	// 等待连接成功，每500ms检查一次状态
-	while (WiFi.status() != WL_CONNECTED)
+#endif
+	esp_wifi_connect();
+}
+
+/**
+ * 开始ESP-Touch配网：手机连接目标AP后用EspTouch App发送SSID与密码
+ * 收到后Arduino库直接按新配置连接，这里保存凭据并交给回调
+ */
+bool Network::startProvisioning()
+{
+	if (state == NET_PROVISIONING) return true;
+	esp_timer_stop(retry_timer);
+	WiFi.disconnect();
+	if (!WiFi.beginSmartConfig()) return false;
+	setState(NET_PROVISIONING);
+	esp_timer_start_once(prov_timer, (uint64_t)NET_PROVISION_TIMEOUT_S * 1000000);
+	Serial.println("等待ESP-Touch配网");
+	return true;
+}
+
+void Network::stopProvisioning()
+{
+	esp_timer_stop(prov_timer);
+	if (state != NET_PROVISIONING) return;
+	WiFi.stopSmartConfig();
+	setState(NET_IDLE);
+}
+
+void Network::provTimeoutCb(void* arg)
+{
+	Network* self = (Network*)arg;
+	if (self->state != NET_PROVISIONING) return;
+	Serial.println("配网超时");
+	self->stopProvisioning();
+	// 原来有配置时恢复连接
+	if (self->ssid[0]) self->connect();
+}
+
+/**
+ * 注册配网凭据回调
+ */
+void Network::setCredentialsCallback(net_creds_cb_t cb, void* user)
+{
+	creds_cb = cb;
+	creds_user = user;
+}
+
+/**
+ * 进入网络工作窗口（例如一批HTTP请求）：关闭省电，下行数据不必等待监听间隔
+ */
+void Network::acquire()
+{
+	portENTER_CRITICAL(&ps_lock);
+	bool first = active++ == 0;
+	portEXIT_CRITICAL(&ps_lock);
+	if (first) applyPowerSave();
+}
+
+/**
+ * 离开窗口：最后一个窗口结束后恢复最大省电
+ */
+void Network::release()
+{
+	portENTER_CRITICAL(&ps_lock);
+	bool last = active > 0 && --active == 0;
+	portEXIT_CRITICAL(&ps_lock);
+	if (last) applyPowerSave();
+}
+
+/**
+ * 按当前是否在窗口内设置省电模式（每次连接后调用，覆盖WiFi.mode()设置的WIFI_PS_MIN_MODEM）
+ */
+void Network::applyPowerSave()
+{
+#if NET_POWER_SAVE
+	esp_wifi_set_ps(active ? WIFI_PS_NONE : WIFI_PS_MAX_MODEM);
+#endif
+	reportEnergy();
+}
+
+/**
+ * 向能耗估计报告射频状态：未启动时关闭，已连接且在最大省电时为省电，其余（连接、重连、配网、数据窗口）为常开
+ */
+void Network::reportEnergy()
+{
+	EnergyWifi e = ENERGY_WIFI_ON;
+	if (state == NET_IDLE) e = ENERGY_WIFI_OFF;
+#if NET_POWER_SAVE
+	else if (state == NET_CONNECTED && active == 0) e = ENERGY_WIFI_SLEEP;
+#endif
+	energy.setWifi(e);
+}
+
+/**
+ * 设置设备名与多设备管理密钥
+ * 设备名同时作为DHCP主机名，须在WiFi启动前设置
+ */
+void Network::setIdentity(const char* device_name, const char* fleet_key)
+{
+	fleet.setIdentity(device_name, fleet_key);
+	WiFi.setHostname(fleet.getName());
+}
+
+/**
+ * WiFi事件处理（在Arduino事件任务中执行，该任务与LVGL同在核心1）
+ * 这里只更新状态与重连计时，写NVS、启动服务等交给网络任务
+ */
+void Network::onEvent(arduino_event_id_t event, arduino_event_info_t info)
+{
+	switch (event)
 	{
-		delay(500);
-		Serial.print(".");  // 显示连接进度
+	case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+		backoff_ms = NET_BACKOFF_MIN_MS;
+		cache_fails = 0;
+		if (!post(NET_JOB_ONLINE)) onOnline();
+		break;
+
+	case ARDUINO_EVENT_SC_GOT_SSID_PSWD:
+		esp_timer_stop(prov_timer);
+		strlcpy(ssid, (const char*)info.sc_got_ssid_pswd.ssid, sizeof(ssid));
+		strlcpy(password, (const char*)info.sc_got_ssid_pswd.password, sizeof(password));
+		// Arduino库已按新配置发起连接：旧的BSSID/信道缓存不再使用，联网后按新AP覆盖；
+		// 监听间隔在下次启动的连接中生效
+		cache_valid = false;
+		cache_fails = 0;
+		backoff_ms = NET_BACKOFF_MIN_MS;
+		Serial.printf("配网完成: %s\n", ssid);
+		setState(NET_CONNECTING);
+		if (creds_cb && !post(NET_JOB_CREDS)) creds_cb(ssid, password, creds_user);
+		break;
+
+	case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+		// 配网期间信道在切换，不重连
+		if (state == NET_PROVISIONING) break;
+		Serial.printf("WiFi断开，原因: %d\n", info.wifi_sta_disconnected.reason);
+		// 缓存的AP多次连不上时（换了信道或AP），放弃缓存改为扫描
+		if (cache_valid && ++cache_fails >= NET_CACHE_RETRIES) dropCache();
+		setState(state == NET_CONNECTED ? NET_DISCONNECTED : NET_CONNECTING);
+		scheduleRetry();
+		break;
+
+	default:
+		break;
 	}
-	
-	// 连接成功，显示网络信息
-	Serial.println("");
-	Serial.println("WiFi连接成功!");
-	Serial.print("设备IP地址: ");
+}
+
+/**
+ * 已获取IP（网络任务）：更新重连缓存、启动上传与多设备管理服务
+ * 处理前连接又断开时不再切换为已连接
+ */
+void Network::onOnline()
+{
+	if (!WiFi.isConnected()) return;
+	uint8_t* bssid = WiFi.BSSID();
+	uint8_t channel = WiFi.channel();
+	if (bssid && (!cache_valid || channel != cache_channel || memcmp(bssid, cache_bssid, 6) != 0))
+		saveCache(bssid, channel);
+
+	Serial.print("WiFi连接成功，设备IP地址: ");
 	Serial.println(WiFi.localIP());
+	applyPowerSave();
+#if NET_UPLOAD_SERVER
+	upload.begin();
+#endif
+#if NET_FLEET
+	fleet.setHttpPort(upload.isRunning() ? UPLOAD_SERVER_PORT : 0);
+	fleet.begin();
+#endif
+	setState(NET_CONNECTED);
 }
 
 /**
- * 获取B站用户粉丝数
- * 
- * 功能描述：
- * 1. 通过B站开放API获取指定用户的粉丝数据
- * 2. 解析JSON响应数据提取粉丝数量
- * 3. 处理网络请求异常和数据解析错误
- * 
- * API接口：http://api.bilibili.com/x/relation/stat?vmid={uid}
- * 返回格式：JSON格式，包含粉丝数、关注数等统计信息
- * 
- * @param uid B站用户UID（用户唯一标识符）
- * @return 粉丝数量，获取失败返回0
+ * 交给网络任务（队列满时等待，事件不丢失）
+ * @return 网络任务未启动时返回false，由调用方就地处理
  */
-unsigned int Network::getBilibiliFans(String uid)
+bool Network::post(JobType type, NetRequest* req)
 {
-	String fansCount = "";  // 存储解析出的粉丝数字符串
-	HTTPClient http;        // HTTP客户端对象
-	
-	// 构建B站API请求URL
-	String apiUrl = "http://api.bilibili.com/x/relation/stat?vmid=" + uid;
-	http.begin(apiUrl);
-	Serial.println("正在请求B站API: " + apiUrl);
+	if (queue == NULL || task == NULL) return false;
+	Job job = { type, req };
+	return xQueueSend(queue, &job, portMAX_DELAY) == pdTRUE;
+}
 
-	// 发送HTTP GET请求
-	int httpCode = http.GET();
-	Serial.printf("HTTP响应码: %d\n", httpCode);
+/**
+ * 网络任务：依次处理请求与事件的后续工作
+ */
+void Network::taskEntry(void* arg)
+{
+	Network* self = (Network*)arg;
+	Job job;
 
-	// 检查HTTP响应状态
-	if (httpCode > 0)
+	for (;;)
 	{
-		// 请求成功，检查响应码
-		if (httpCode == HTTP_CODE_OK)
+		if (xQueueReceive(self->queue, &job, portMAX_DELAY) != pdTRUE) continue;
+		switch (job.type)
 		{
-			// 获取响应数据
-			String payload = http.getString();
-			Serial.println("API响应数据: " + payload);
-			
-			// 简单的字符串解析方式查找粉丝数
-			// 在JSON中查找"follower"字段
-			int pos = payload.indexOf("follower");
-			if (pos != -1)
-			{
-				// 提取粉丝数数值（简化解析，实际应使用JSON库）
-				fansCount = payload.substring(pos + 10, payload.length() - 2);
-				Serial.println("解析到的粉丝数: " + fansCount);
-			}
-			else
+		case NET_JOB_REQUEST:
+			self->runRequest(job.req);
+			break;
+		case NET_JOB_ONLINE:
+			self->onOnline();
+			break;
+		case NET_JOB_CREDS:
+			if (self->creds_cb) self->creds_cb(self->ssid, self->password, self->creds_user);
+			break;
+		case NET_JOB_DROP_CACHE:
+		{
+			Preferences prefs;
+			if (prefs.begin("wifi", false))
 			{
-				Serial.println("未找到follower字段");
+				prefs.clear();
+				prefs.end();
 			}
+			break;
 		}
-		else
-		{
-			Serial.printf("HTTP请求失败，响应码: %d\n", httpCode);
 		}
 	}
-	else
+}
+
+/**
+ * 执行一个异步请求（网络任务）：请求、解析，然后把结果交给界面或等待的任务
+ */
+void Network::runRequest(NetRequest* req)
+{
+	req->ok = false;
+	req->result[0] = '\0';
+	if (isConnected())
 	{
-		// HTTP请求出错
-		Serial.printf("[HTTP] GET请求失败，错误: %s\n", http.errorToString(httpCode).c_str());
+		acquire();
+		JsonDocument* doc = api.getJson(req->url, *req->filter);
+		req->ok = doc != NULL && req->parse(doc, req->result, sizeof(req->result));
+		release();
 	}
-	
-	// 关闭HTTP连接，释放资源
-	http.end();
 
-	// 将字符串转换为数字并返回
-	unsigned int result = atol(fansCount.c_str());
-	Serial.printf("最终粉丝数: %u\n", result);
-	return result;
+	// busy清除后调用方即可重新提交，先取出通知方式
+	ui_msg_cb_t done = req->done;
+	TaskHandle_t notify = req->notify;
+	req->busy = false;
+	if (notify) xTaskNotifyGive(notify);
+	else if (done) runtime.post(done, req);
 }
 
+/**
+ * 提交异步请求
+ */
+bool Network::request(NetRequest* req)
+{
+	if (req == NULL || req->filter == NULL || req->parse == NULL || req->busy) return false;
+	if (queue == NULL || task == NULL) return false;
+	req->busy = true;
+	Job job = { NET_JOB_REQUEST, req };
+	if (xQueueSend(queue, &job, 0) != pdTRUE)
+	{
+		req->busy = false;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 安排一次重连：刚断开时很快重试（AP重启后通常一秒内恢复），之后逐次翻倍
+ */
+void Network::scheduleRetry()
+{
+	esp_timer_stop(retry_timer);
+	esp_timer_start_once(retry_timer, (uint64_t)backoff_ms * 1000);
+	backoff_ms = backoff_ms * 2 > NET_BACKOFF_MAX_MS ? NET_BACKOFF_MAX_MS : backoff_ms * 2;
+}
+
+void Network::retryCb(void* arg)
+{
+	((Network*)arg)->connect();
+}
+
+/**
+ * 发起连接（不等待结果）
+ * 驱动中保存的配置已包含SSID、密码和缓存的BSSID/信道，直接esp_wifi_connect即可
+ */
+void Network::connect()
+{
+	setState(NET_CONNECTING);
+	esp_wifi_connect();
+}
+
+/**
+ * 读取快速重连缓存（SSID不一致时作废）
+ */
+void Network::loadCache()
+{
+	Preferences prefs;
+	cache_valid = false;
+	if (!prefs.begin("wifi", true)) return;
+
+	char cached[NET_SSID_MAX] = "";
+	prefs.getString("ssid", cached, sizeof(cached));
+	cache_valid = strcmp(cached, ssid) == 0 &&
+		prefs.getBytes("bssid", cache_bssid, 6) == 6;
+	cache_channel = prefs.getUChar("ch", 0);
+	if (cache_channel == 0) cache_valid = false;
+	prefs.end();
+}
+
+void Network::saveCache(const uint8_t* bssid, uint8_t channel)
+{
+	memcpy(cache_bssid, bssid, 6);
+	cache_channel = channel;
+	cache_valid = true;
+
+	Preferences prefs;
+	if (!prefs.begin("wifi", false)) return;
+	prefs.putString("ssid", ssid);
+	prefs.putBytes("bssid", cache_bssid, 6);
+	prefs.putUChar("ch", cache_channel);
+	prefs.end();
+}
+
+/**
+ * 作废缓存：清除驱动配置中的BSSID/信道限制，下次连接全信道扫描
+ * （NVS中的缓存由网络任务清除）
+ */
+void Network::dropCache()
+{
+	cache_valid = false;
+	cache_fails = 0;
+
+	wifi_config_t conf;
+	if (esp_wifi_get_config(WIFI_IF_STA, &conf) == ESP_OK)
+	{
+		conf.sta.bssid_set = false;
+		conf.sta.channel = 0;
+		esp_wifi_set_config(WIFI_IF_STA, &conf);
+	}
+
+	if (post(NET_JOB_DROP_CACHE)) return;
+	Preferences prefs;
+	if (!prefs.begin("wifi", false)) return;
+	prefs.clear();
+	prefs.end();
+}
+
+void Network::setState(NetState s)
+{
+	if (state == s) return;
+	state = s;
+	reportEnergy();
+	if (state_cb) state_cb(s, state_user);
+}
+
+/**
+ * 注册状态回调（在WiFi事件任务、定时器任务或网络任务中执行）
+ */
+void Network::setStateCallback(net_state_cb_t cb, void* user)
+{
+	state_cb = cb;
+	state_user = user;
+}
+
+NetState Network::getState()
+{
+	return state;
+}
+
+bool Network::isConnected()
+{
+	return state == NET_CONNECTED;
+}
+
+/**
+ * 异步获取B站用户粉丝数
+ * 
+ * 功能描述：
+ * 1. 通过B站开放API获取指定用户的粉丝数据
+ * 2. 在网络任务中流式解析JSON响应，只保留data.follower字段
+ * 3. 完成后在LVGL任务中调用done，成功时req->ok为true，req->result为粉丝数
+ * 
+ * API接口：http://api.bilibili.com/x/relation/stat?vmid={uid}
+ * 返回格式：{"code":0,"data":{"mid":...,"following":...,"follower":...}}
+ * 
+ * @param req 调用方持有的请求（完成前不要修改）
+ * @param uid B站用户UID（用户唯一标识符）
+ * @return 请求仍在进行、URL过长或队列已满时返回false
+ */
+bool Network::requestBilibiliFans(NetRequest* req, const char* uid, ui_msg_cb_t done, void* user)
+{
+	static JsonDocument filter;
+	if (filter.isNull()) filter["data"]["follower"] = true;
+	if (req->busy) return false;
+
+	// URL直接写入请求，不产生String临时对象
+	if (snprintf(req->url, sizeof(req->url), NET_BILI_FANS_URL, uid) >= (int)sizeof(req->url)) return false;
+	req->filter = &filter;
+	req->parse = [](JsonDocument* doc, char* out, size_t len) {
+		if (!(*doc)["data"]["follower"].is<unsigned int>()) return false;
+		snprintf(out, len, "%u", (*doc)["data"]["follower"].as<unsigned int>());
+		return true;
+	};
+	req->done = done;
+	req->notify = NULL;
+	req->user = user;
+	return request(req);
+}
+
+/**
+ * 共用HTTP客户端（只能在网络任务中使用，例如在请求的parse中；其他任务经request提交）
+ */
+HttpApi* Network::getApi()
+{
+	return &api;
+}
+
+TaskHandle_t Network::getTask()
+{
+	return task;
+}
+
+/**
+ * 无线上传服务（NET_UPLOAD_SERVER为1时首次联网自动启动）
+ */
+UploadServer* Network::getUploadServer()
+{
+	return &upload;
+}
+
+/**
+ * OTA升级（可startFromUrl下载，或经上传服务PUT /ota推送）
+ */
+OtaUpdate* Network::getOta()
+{
+	return &ota;
+}
+
+/**
+ * 多设备管理服务（NET_FLEET为1时首次联网自动启动）
+ */
+FleetServer* Network::getFleet()
+{
+	return &fleet;
+}
@@ -0,0 +1,313 @@
+/*
+ * HoloCubic DMP姿态服务模块
+ *
+ * 功能说明：
+ * 1. 加载MPU6050 DMP固件（MotionApps 2.0），由传感器片上完成六轴融合
+ * 2. 从FIFO读出数据包，解析四元数、重力向量与yaw/pitch/roll
+ * 3. 以序列锁快照发布结果，并在传感器任务中回调订阅者
+ * 4. DMP不可用时由IMU送入FIFO原始样本，软件Mahony滤波融合后按同样的快照发布
+ *
+ * 软件融合（定点Mahony）：
+ * - 四元数为Q30整数，每步：陀螺仪角速度换算为半角增量；加速度模长接近1g时，
+ *   以测得重力方向与四元数估计方向的叉积为误差，按比例+积分项修正角速度；q += q ⊗ (0, 增量)，
+ *   再用一次牛顿迭代归一化（每步偏离很小，一次即收敛）
+ * - 选择Mahony而不是Madgwick：误差项只需一次叉积，没有梯度的雅可比运算，
+ *   积分项还能吸收校准后残余的陀螺仪零偏
+ * - 换算系数由ORIENT_SW_*在编译期算出；第一个样本用加速度的俯仰/横滚初始化（yaw为0，只在此处用浮点）
+ * - 发布时才转换为浮点并用DMP相同的公式计算gravity/ypr（100Hz，在传感器任务中）
+ *
+ * 注意事项：
+ * - DMP占用传感器FIFO，与IMU的FIFO原始采样模式互斥（由IMU_MODE_DMP统一管理）
+ * - MPU6050_6Axis_MotionApps20.h中包含函数定义，整个工程只能在本文件中包含
+ */
+
+#include "orientation.h"
+#include <MPU6050_6Axis_MotionApps20.h>
+#include "fixed_math.h"
+
+Orientation orientation;
+
+// DMP版本的设备对象（类布局含DMP字段，不能与imu.cpp中的对象混用）
+static MPU6050 dmp_dev;
+
+#define SW_Q30 ((int64_t)1 << 30)
+// 陀螺仪原始值 -> 每步半角增量（Q30），系数再放大1024倍保留精度
+static const int32_t SW_GYRO_K = (int32_t)(M_PI / 180.0 / ORIENT_SW_GYRO_LSB * 0.5 / ORIENT_SW_RATE_HZ
+	* (double)SW_Q30 * 1024.0 + 0.5);
+// 误差（Q30） -> 比例项半角增量：Kp * dt / 2，Q32
+static const int32_t SW_KP_K = (int32_t)(ORIENT_SW_KP * 0.5 / ORIENT_SW_RATE_HZ * 4294967296.0 + 0.5);
+// 误差（Q30） -> 积分项每步累加量：Ki * dt * dt / 2，Q32（积分值为Q62）
+static const int32_t SW_KI_K = (int32_t)(ORIENT_SW_KI * 0.5 / ORIENT_SW_RATE_HZ / ORIENT_SW_RATE_HZ
+	* 4294967296.0 + 0.5);
+// 积分项上限：相当于5°/s的零偏，避免长时间晃动后积分饱和
+static const int64_t SW_INTEG_MAX = (int64_t)(5.0 * M_PI / 180.0 * 0.5 / ORIENT_SW_RATE_HZ
+	* (double)SW_Q30) << 32;
+
+/**
+ * 初始化DMP
+ * 需在I2C总线与MPU6050初始化之后调用
+ *
+ * @return DMP固件加载成功返回true
+ */
+bool Orientation::begin()
+{
+	uint8_t status = dmp_dev.dmpInitialize();
+	if (status != 0)
+	{
+		// 1: 固件加载失败 2: DMP配置更新失败
+		Serial.printf("DMP初始化失败: %d\n", status);
+		return false;
+	}
+
+	dmp_dev.setDMPEnabled(true);
+	dmp_dev.resetFIFO();
+	packet_size = dmp_dev.dmpGetFIFOPacketSize();
+	if (packet_size == 0 || packet_size > ORIENT_PACKET_MAX)
+	{
+		Serial.printf("DMP数据包长度异常: %d\n", packet_size);
+		dmp_dev.setDMPEnabled(false);
+		return false;
+	}
+
+	ready = true;
+	Serial.printf("DMP已启动，数据包%d字节\n", packet_size);
+	return true;
+}
+
+/**
+ * 读出FIFO中全部完整数据包并发布（在传感器任务中调用）
+ *
+ * @return 本次读出的数据包数
+ */
+uint16_t Orientation::poll()
+{
+	if (!ready || software) return 0;
+
+	// FIFO溢出后数据包边界错位，只能复位
+	if (dmp_dev.getIntFIFOBufferOverflowStatus())
+	{
+		dmp_dev.resetFIFO();
+		return 0;
+	}
+
+	uint16_t n = dmp_dev.getFIFOCount() / packet_size;
+	for (uint16_t i = 0; i < n; i++)
+	{
+		dmp_dev.getFIFOBytes(packet, packet_size);
+
+		OrientationData d;
+		dmp_dev.dmpGetQuaternion(&d.q, packet);
+		dmp_dev.dmpGetGravity(&d.gravity, &d.q);
+		dmp_dev.dmpGetYawPitchRoll(d.ypr, &d.q, &d.gravity);
+		dmp_dev.dmpGetAccel(&d.accel, packet);
+		dmp_dev.dmpGetGyro(&d.gyro, packet);
+		d.timestamp = micros();
+		d.count = data.count + 1;
+		publish(d);
+	}
+	return n;
+}
+
+/**
+ * 启用软件融合（DMP初始化失败时由IMU调用）
+ * 传感器配置由IMU完成，这里只复位滤波状态，第一个样本到达时初始化姿态
+ *
+ * @return 总是返回true
+ */
+bool Orientation::beginSoftware()
+{
+	software = true;
+	sw_init = false;
+	memset(integ, 0, sizeof(integ));
+	memset(&stats, 0, sizeof(stats));
+	cost_total = 0;
+	decim = 0;
+	ready = true;
+	Serial.printf("姿态改用软件融合: %dHz输入，%dHz输出\n", ORIENT_SW_RATE_HZ, ORIENT_SW_RATE_HZ / ORIENT_SW_DECIM);
+	return true;
+}
+
+/**
+ * 送入一个FIFO样本（传感器任务中执行）
+ * 每步融合计时并计入统计，每ORIENT_SW_DECIM步发布一次快照
+ */
+void Orientation::feed(const int16_t accel[3], const int16_t gyro[3], uint32_t t_us)
+{
+	if (!software) return;
+
+	uint32_t start = micros();
+	if (sw_init) step(accel, gyro);
+	else
+	{
+		initFromAccel(accel);
+		sw_init = true;
+	}
+	uint32_t cost = micros() - start;
+	stats.steps++;
+	cost_total += cost;
+	if (cost > stats.max_us) stats.max_us = cost > 0xFFFF ? 0xFFFF : cost;
+	if (cost > ORIENT_SW_BUDGET_US) stats.over_budget++;
+
+	if (++decim < ORIENT_SW_DECIM) return;
+	decim = 0;
+
+	const float k = 1.0f / (float)SW_Q30;
+	OrientationData d;
+	d.q = Quaternion(sq[0] * k, sq[1] * k, sq[2] * k, sq[3] * k);
+	dmp_dev.dmpGetGravity(&d.gravity, &d.q);
+	dmp_dev.dmpGetYawPitchRoll(d.ypr, &d.q, &d.gravity);
+	// 与DMP数据包相同的8192/g
+	d.accel = VectorInt16(accel[0] / 2, accel[1] / 2, accel[2] / 2);
+	d.gyro = VectorInt16(gyro[0], gyro[1], gyro[2]);
+	d.timestamp = t_us;
+	d.count = data.count + 1;
+	publish(d);
+}
+
+/**
+ * 由加速度的俯仰/横滚得到初始姿态（yaw为0）；加速度无效时为单位四元数
+ */
+void Orientation::initFromAccel(const int16_t accel[3])
+{
+	float x = accel[0], y = accel[1], z = accel[2];
+	float roll = 0, pitch = 0;
+	if (x != 0 || y != 0 || z != 0)
+	{
+		roll = atan2f(y, z);
+		pitch = atan2f(-x, sqrtf(y * y + z * z));
+	}
+	float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+	float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+	sq[0] = (int32_t)(cr * cp * SW_Q30);
+	sq[1] = (int32_t)(sr * cp * SW_Q30);
+	sq[2] = (int32_t)(cr * sp * SW_Q30);
+	sq[3] = (int32_t)(-sr * sp * SW_Q30);
+}
+
+/**
+ * 一步Mahony融合（只有整数运算，乘积在64位中计算）
+ */
+void Orientation::step(const int16_t accel[3], const int16_t gyro[3])
+{
+	int32_t w = sq[0], x = sq[1], y = sq[2], z = sq[3];
+
+	// 半角增量（Q30）
+	int32_t h[3];
+	for (int i = 0; i < 3; i++) h[i] = (int32_t)(((int64_t)gyro[i] * SW_GYRO_K) >> 10);
+
+	// 3 * 32768^2 < 2^32，平方和不会溢出
+	uint32_t a2 = (uint32_t)((int32_t)accel[0] * accel[0]) + (uint32_t)((int32_t)accel[1] * accel[1])
+		+ (uint32_t)((int32_t)accel[2] * accel[2]);
+	uint16_t n = fx_isqrt(a2);
+	if (n >= ORIENT_SW_ACC_MIN && n <= ORIENT_SW_ACC_MAX)
+	{
+		// 单位化的测得重力方向（Q30），一次除法得到模长倒数（Q44/n）
+		int64_t inv = ((int64_t)1 << 44) / n;
+		int32_t ax = (int32_t)((accel[0] * inv) >> 14);
+		int32_t ay = (int32_t)((accel[1] * inv) >> 14);
+		int32_t az = (int32_t)((accel[2] * inv) >> 14);
+
+		// 当前姿态估计的重力方向（与dmpGetGravity相同）
+		int32_t vx = (int32_t)(((int64_t)x * z - (int64_t)w * y) >> 29);
+		int32_t vy = (int32_t)(((int64_t)w * x + (int64_t)y * z) >> 29);
+		int32_t vz = (int32_t)(((int64_t)w * w - (int64_t)x * x - (int64_t)y * y + (int64_t)z * z) >> 30);
+
+		int32_t e[3];
+		e[0] = (int32_t)(((int64_t)ay * vz - (int64_t)az * vy) >> 30);
+		e[1] = (int32_t)(((int64_t)az * vx - (int64_t)ax * vz) >> 30);
+		e[2] = (int32_t)(((int64_t)ax * vy - (int64_t)ay * vx) >> 30);
+
+		for (int i = 0; i < 3; i++)
+		{
+			integ[i] += (int64_t)e[i] * SW_KI_K;
+			if (integ[i] > SW_INTEG_MAX) integ[i] = SW_INTEG_MAX;
+			if (integ[i] < -SW_INTEG_MAX) integ[i] = -SW_INTEG_MAX;
+			h[i] += (int32_t)(((int64_t)e[i] * SW_KP_K) >> 32);
+		}
+	}
+	// 积分项（零偏补偿）在晃动期间也保持作用
+	for (int i = 0; i < 3; i++) h[i] += (int32_t)(integ[i] >> 32);
+
+	// q += q ⊗ (0, h)
+	int32_t nw = w + (int32_t)((-(int64_t)x * h[0] - (int64_t)y * h[1] - (int64_t)z * h[2]) >> 30);
+	int32_t nx = x + (int32_t)(((int64_t)w * h[0] + (int64_t)y * h[2] - (int64_t)z * h[1]) >> 30);
+	int32_t ny = y + (int32_t)(((int64_t)w * h[1] - (int64_t)x * h[2] + (int64_t)z * h[0]) >> 30);
+	int32_t nz = z + (int32_t)(((int64_t)w * h[2] + (int64_t)x * h[1] - (int64_t)y * h[0]) >> 30);
+
+	// 归一化：|q|²接近1时 1/sqrt(s) ≈ (3 - s) / 2
+	int64_t s = ((int64_t)nw * nw + (int64_t)nx * nx + (int64_t)ny * ny + (int64_t)nz * nz) >> 30;
+	int32_t k = (int32_t)((3 * SW_Q30 - s) >> 1);
+	sq[0] = (int32_t)(((int64_t)nw * k) >> 30);
+	sq[1] = (int32_t)(((int64_t)nx * k) >> 30);
+	sq[2] = (int32_t)(((int64_t)ny * k) >> 30);
+	sq[3] = (int32_t)(((int64_t)nz * k) >> 30);
+}
+
+/**
+ * 更新快照并回调订阅者
+ * 序列号写前加一（变为奇数）、写后再加一，读方据此判断是否读到完整数据
+ */
+void Orientation::publish(const OrientationData& d)
+{
+	seq++;
+	__sync_synchronize();
+	data = d;
+	__sync_synchronize();
+	seq++;
+
+	for (uint8_t i = 0; i < sub_count; i++) subs[i](&d, subs_user[i]);
+}
+
+/**
+ * 读取最新姿态快照（任意任务可调用，不阻塞写方）
+ *
+ * @return 尚无数据时返回false
+ */
+bool Orientation::get(OrientationData* out)
+{
+	uint32_t s;
+	do
+	{
+		s = seq;
+		__sync_synchronize();
+		*out = data;
+		__sync_synchronize();
+	} while ((s & 1) || s != seq);
+
+	return out->count > 0;
+}
+
+/**
+ * 订阅姿态更新，回调在传感器任务中执行，不能直接调用lv_*接口（需runtime.post）
+ */
+bool Orientation::subscribe(orientation_cb_t cb, void* user)
+{
+	if (cb == NULL || sub_count >= ORIENT_MAX_SUBSCRIBERS) return false;
+
+	subs[sub_count] = cb;
+	subs_user[sub_count] = user;
+	sub_count++;
+	return true;
+}
+
+bool Orientation::isReady()
+{
+	return ready;
+}
+
+/**
+ * 是否为软件融合（否则为DMP）
+ */
+bool Orientation::isSoftware()
+{
+	return software;
+}
+
+/**
+ * 软件融合的耗时统计（任意任务，数值可能相差一步）
+ */
+void Orientation::getStats(OrientationStats* out)
+{
+	*out = stats;
+	out->avg_us = stats.steps ? (uint16_t)(cost_total / stats.steps) : 0;
+}
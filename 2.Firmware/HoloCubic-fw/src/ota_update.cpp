@@ -0,0 +1,347 @@
+/*
+ * HoloCubic OTA升级模块
+ *
+ * 功能说明：
+ * 1. 把新固件分段写入非运行的OTA分区（默认分区表含app0/app1两个OTA分区）
+ * 2. 写入与下载在核心0的低优先级任务中进行，LVGL任务照常刷新
+ * 3. 写完校验镜像（及可选SHA-256），设置下次从新分区启动
+ * 4. 新固件启动后需确认有效，否则连续启动失败时回滚
+ *
+ * 回滚说明：Arduino预编译的bootloader未开启CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE，
+ * 因此由本模块在NVS中记录待确认状态与启动次数，在应用层完成回滚
+ */
+
+#include "ota_update.h"
+#include "tls_client.h"
+#include <HTTPClient.h>
+#include <Preferences.h>
+#include <esp_timer.h>
+#include <mbedtls/version.h>
+
+#if MBEDTLS_VERSION_NUMBER < 0x03000000
+#define sha256_starts(ctx) mbedtls_sha256_starts_ret(ctx, 0)
+#define sha256_update(ctx, d, n) mbedtls_sha256_update_ret(ctx, d, n)
+#define sha256_finish(ctx, out) mbedtls_sha256_finish_ret(ctx, out)
+#else
+#define sha256_starts(ctx) mbedtls_sha256_starts(ctx, 0)
+#define sha256_update(ctx, d, n) mbedtls_sha256_update(ctx, d, n)
+#define sha256_finish(ctx, out) mbedtls_sha256_finish(ctx, out)
+#endif
+
+OtaUpdate::OtaUpdate()
+{
+	handle = 0;
+	target = NULL;
+	state = OTA_IDLE;
+	total = written = 0;
+	check_sha = false;
+	task = NULL;
+}
+
+/**
+ * 开始写入
+ *
+ * @param size       镜像大小（用于进度显示，0表示未知）
+ * @param sha256_hex 期望的SHA-256（64位十六进制），NULL表示只做镜像自身校验
+ */
+bool OtaUpdate::begin(uint32_t size, const char* sha256_hex)
+{
+	if (state == OTA_RUNNING) return false;
+
+	target = esp_ota_get_next_update_partition(NULL);
+	if (target == NULL)
+	{
+		Serial.println("OTA: 没有可用的OTA分区");
+		state = OTA_FAILED;
+		return false;
+	}
+	if (size > target->size)
+	{
+		Serial.printf("OTA: 镜像过大 %u > %u\n", size, target->size);
+		state = OTA_FAILED;
+		return false;
+	}
+
+	check_sha = sha256_hex != NULL && strlen(sha256_hex) == 64;
+	for (uint8_t i = 0; check_sha && i < 32; i++)
+	{
+		char hex[3] = { sha256_hex[i * 2], sha256_hex[i * 2 + 1], 0 };
+		expect_sha[i] = strtoul(hex, NULL, 16);
+	}
+	if (check_sha)
+	{
+		mbedtls_sha256_init(&sha);
+		sha256_starts(&sha);
+	}
+
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+	// 随写入逐扇区擦除，而不是begin时擦除整个分区
+	esp_err_t err = esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+#else
+	esp_err_t err = esp_ota_begin(target, size ? size : OTA_SIZE_UNKNOWN, &handle);
+#endif
+	if (err != ESP_OK)
+	{
+		Serial.printf("OTA: 开始失败 %s\n", esp_err_to_name(err));
+		state = OTA_FAILED;
+		return false;
+	}
+
+	total = size;
+	written = 0;
+	state = OTA_RUNNING;
+	Serial.printf("OTA: 写入分区%s (0x%x)\n", target->label, target->address);
+	return true;
+}
+
+/**
+ * 写入一段镜像数据（任意长度，esp_ota_write内部按扇区擦除）
+ */
+bool OtaUpdate::write(const uint8_t* data, size_t len)
+{
+	if (state != OTA_RUNNING) return false;
+
+	esp_err_t err = esp_ota_write(handle, data, len);
+	if (err != ESP_OK)
+	{
+		Serial.printf("OTA: 写入失败 %s\n", esp_err_to_name(err));
+		abort();
+		return false;
+	}
+	if (check_sha) sha256_update(&sha, data, len);
+	written += len;
+	return true;
+}
+
+/**
+ * 完成写入：校验镜像并设置启动分区，重启后生效
+ */
+bool OtaUpdate::end()
+{
+	if (state != OTA_RUNNING) return false;
+
+	if (check_sha)
+	{
+		uint8_t digest[32];
+		sha256_finish(&sha, digest);
+		mbedtls_sha256_free(&sha);
+		check_sha = false;
+		if (memcmp(digest, expect_sha, 32) != 0)
+		{
+			Serial.println("OTA: SHA-256不匹配");
+			abort();
+			return false;
+		}
+	}
+
+	esp_err_t err = esp_ota_end(handle);
+	if (err == ESP_OK) err = esp_ota_set_boot_partition(target);
+	if (err != ESP_OK)
+	{
+		Serial.printf("OTA: 校验失败 %s\n", esp_err_to_name(err));
+		state = OTA_FAILED;
+		return false;
+	}
+
+	// 标记新固件待确认，启动后由checkBoot()计数
+	Preferences prefs;
+	if (prefs.begin("ota", false))
+	{
+		prefs.putUChar("pending", 1);
+		prefs.putUChar("tries", 0);
+		prefs.end();
+	}
+
+	state = OTA_DONE;
+	Serial.printf("OTA: 完成，共%u字节，重启后生效\n", written);
+	return true;
+}
+
+void OtaUpdate::abort()
+{
+	if (state != OTA_RUNNING) return;
+	esp_ota_abort(handle);
+	if (check_sha) mbedtls_sha256_free(&sha);
+	check_sha = false;
+	state = OTA_FAILED;
+}
+
+/**
+ * 后台下载并写入固件（立即返回，通过getState/getProgress查询）
+ */
+bool OtaUpdate::startFromUrl(const char* url, const char* sha256_hex)
+{
+	if (state == OTA_RUNNING || task != NULL) return false;
+	strlcpy(this->url, url, sizeof(this->url));
+
+	// begin在调用方任务中完成，SHA参数不必跨任务保存
+	if (!begin(0, sha256_hex)) return false;
+	if (xTaskCreatePinnedToCore(taskEntry, "ota", OTA_TASK_STACK, this,
+		OTA_TASK_PRIORITY, &task, OTA_TASK_CORE) != pdPASS)
+	{
+		abort();
+		return false;
+	}
+	return true;
+}
+
+void OtaUpdate::taskEntry(void* arg)
+{
+	OtaUpdate* self = (OtaUpdate*)arg;
+	self->download();
+	self->task = NULL;
+	vTaskDelete(NULL);
+}
+
+/**
+ * 下载任务：每读满一个扇区写一次，写完让出CPU
+ */
+void OtaUpdate::download()
+{
+	WiFiClient plain;
+	TlsClient tls;
+	bool https = strncmp(url, "https://", 8) == 0;
+	if (https && !TlsClient::hasCa()) TlsClient::loadCaFile();
+
+	HTTPClient http;
+	http.setTimeout(10000);
+	if (!http.begin(https ? (WiFiClient&)tls : plain, url))
+	{
+		abort();
+		return;
+	}
+	int code = http.GET();
+	if (code != HTTP_CODE_OK)
+	{
+		Serial.printf("OTA: 下载失败 %d\n", code);
+		http.end();
+		abort();
+		return;
+	}
+
+	int len = http.getSize();
+	if (len > 0) total = len;
+	WiFiClient* stream = http.getStreamPtr();
+
+	uint8_t* buf = (uint8_t*)malloc(OTA_CHUNK_SIZE);
+	if (buf == NULL)
+	{
+		http.end();
+		abort();
+		return;
+	}
+
+	size_t fill = 0;
+	uint32_t last = millis();
+	while (http.connected() && (len < 0 || written + fill < (uint32_t)len))
+	{
+		int n = stream->read(buf + fill, OTA_CHUNK_SIZE - fill);
+		if (n > 0)
+		{
+			fill += n;
+			last = millis();
+		}
+		else if (millis() - last > 10000)
+		{
+			Serial.println("OTA: 下载超时");
+			break;
+		}
+		else
+		{
+			vTaskDelay(1);
+			continue;
+		}
+
+		if (fill == OTA_CHUNK_SIZE || (len > 0 && written + fill == (uint32_t)len))
+		{
+			if (!write(buf, fill)) break;
+			fill = 0;
+			vTaskDelay(1);
+		}
+	}
+	if (fill && state == OTA_RUNNING) write(buf, fill);
+	free(buf);
+	http.end();
+
+	if (state != OTA_RUNNING) return;
+	if (len > 0 && written != (uint32_t)len)
+	{
+		Serial.printf("OTA: 下载不完整 %u/%d\n", written, len);
+		abort();
+		return;
+	}
+	end();
+}
+
+OtaState OtaUpdate::getState()
+{
+	return state;
+}
+
+/**
+ * 进度百分比（大小未知时返回0）
+ */
+uint8_t OtaUpdate::getProgress()
+{
+	if (state == OTA_DONE) return 100;
+	return total ? (uint64_t)written * 100 / total : 0;
+}
+
+/**
+ * 启动检查（setup开头调用）
+ * 新固件待确认时累计启动次数，超过OTA_BOOT_TRIES则切回上一个分区并重启；
+ * 否则OTA_VALID_AFTER_MS后自动确认
+ */
+void OtaUpdate::checkBoot()
+{
+	Preferences prefs;
+	if (!prefs.begin("ota", false)) return;
+	if (prefs.getUChar("pending", 0) == 0)
+	{
+		prefs.end();
+		return;
+	}
+
+	uint8_t tries = prefs.getUChar("tries", 0) + 1;
+	if (tries > OTA_BOOT_TRIES)
+	{
+		prefs.putUChar("pending", 0);
+		prefs.end();
+		// 两个OTA分区时，“下一个”即为升级前运行的分区
+		const esp_partition_t* prev = esp_ota_get_next_update_partition(NULL);
+		Serial.println("OTA: 新固件多次启动失败，回滚");
+		if (prev && esp_ota_set_boot_partition(prev) == ESP_OK) esp_restart();
+		return;
+	}
+	prefs.putUChar("tries", tries);
+	prefs.end();
+
+	Serial.printf("OTA: 新固件第%u次启动，%u秒后确认\n", tries, OTA_VALID_AFTER_MS / 1000);
+	esp_timer_create_args_t args = {};
+	args.callback = validCb;
+	args.name = "ota_valid";
+	esp_timer_handle_t timer;
+	if (esp_timer_create(&args, &timer) == ESP_OK)
+		esp_timer_start_once(timer, (uint64_t)OTA_VALID_AFTER_MS * 1000);
+}
+
+void OtaUpdate::validCb(void* arg)
+{
+	markValid();
+}
+
+/**
+ * 确认当前固件有效（也可由应用在自检通过后提前调用）
+ */
+void OtaUpdate::markValid()
+{
+	Preferences prefs;
+	if (prefs.begin("ota", false))
+	{
+		if (prefs.getUChar("pending", 0)) Serial.println("OTA: 新固件已确认");
+		prefs.putUChar("pending", 0);
+		prefs.end();
+	}
+	// bootloader开启回滚时同时取消其回滚
+	esp_ota_mark_app_valid_cancel_rollback();
+}
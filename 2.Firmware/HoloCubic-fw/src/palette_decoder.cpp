@@ -0,0 +1,197 @@
+/*
+ * HoloCubic 索引色图像解码模块
+ *
+ * 功能说明：
+ * 1. 内置解码器把索引色图像逐像素换算调色板（lv_color32_t -> lv_color_t），
+ *    并按“颜色+alpha”3字节输出，之后以带alpha的图像逐像素混合
+ * 2. 这里在打开图像时一次性建好lv_color_t查找表（256色为512字节），read_line只做查表，
+ *    输出2字节TRUE_COLOR像素，LVGL按不透明图像直接拷贝到绘制缓冲
+ * 3. 共用调色板的.holo动画（HOLO_FLAG_PALETTE）每帧只需一次查表展开
+ * 4. 着色（主界面颜色选择器）在建查找表时混合进调色板，代替逐像素混合的image_recolor
+ *
+ * 注意事项：
+ * - 调色板含透明色的图像、文件源（S:/xxx.bin）仍交给内置解码器
+ * - info_cb返回图像原本的颜色格式：LVGL只对TRUE_COLOR的内存图像走直接拷贝路径，
+ *   索引色图像因此总会经过本解码器
+ * - 启动画面（Display::splash）直接按调色板写屏，不经过解码器，不着色
+ */
+
+#include "palette_decoder.h"
+
+struct PaletteLvCtx
+{
+	lv_color_t lut[256];
+	const void* src;
+	const uint8_t* px;     // 索引数据（紧跟调色板）
+	uint32_t stride;       // 每行字节数
+	uint8_t bpp;
+};
+
+static lv_color_t tint_color;
+static lv_opa_t tint_opa = LV_OPA_TRANSP;
+// 已打开（在图像缓存中）的图像源，着色变化时逐个失效；溢出时整个缓存失效
+static const void* opened[PALETTE_TINT_TRACK];
+static uint8_t opened_cnt = 0;
+static bool opened_overflow = false;
+
+static void track_open(const void* src)
+{
+	if (opened_cnt < PALETTE_TINT_TRACK)
+		opened[opened_cnt++] = src;
+	else
+		opened_overflow = true;
+}
+
+static void track_close(const void* src)
+{
+	for (uint8_t i = 0; i < opened_cnt; i++)
+	{
+		if (opened[i] != src) continue;
+		opened[i] = opened[--opened_cnt];
+		return;
+	}
+}
+
+/**
+ * 是否为本解码器处理的图像：内存中的索引色图像，调色板全部不透明
+ * 调色板按字节访问（B、G、R、A），数据地址不必4字节对齐
+ */
+static bool is_opaque_indexed(const lv_img_dsc_t* img)
+{
+	lv_img_cf_t cf = img->header.cf;
+	if (cf < LV_IMG_CF_INDEXED_1BIT || cf > LV_IMG_CF_INDEXED_8BIT || img->data == NULL) return false;
+
+	uint16_t colors = 1 << lv_img_cf_get_px_size(cf);
+	if (img->data_size < (uint32_t)colors * sizeof(lv_color32_t)) return false;
+	for (uint16_t i = 0; i < colors; i++)
+	{
+		if (img->data[i * sizeof(lv_color32_t) + 3] != LV_OPA_COVER) return false;
+	}
+	return true;
+}
+
+static lv_res_t palette_lv_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+	if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+
+	const lv_img_dsc_t* img = (const lv_img_dsc_t*)src;
+	if (!is_opaque_indexed(img)) return LV_RES_INV;
+
+	*header = img->header;
+	return LV_RES_OK;
+}
+
+static lv_res_t palette_lv_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	if (dsc->src_type != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+
+	const lv_img_dsc_t* img = (const lv_img_dsc_t*)dsc->src;
+	if (!is_opaque_indexed(img)) return LV_RES_INV;
+
+	PaletteLvCtx* ctx = new PaletteLvCtx();
+	uint8_t bpp = lv_img_cf_get_px_size(img->header.cf);
+	uint16_t colors = 1 << bpp;
+	const uint8_t* pal = img->data;
+	for (uint16_t i = 0; i < colors; i++, pal += sizeof(lv_color32_t))
+	{
+		ctx->lut[i] = lv_color_make(pal[2], pal[1], pal[0]);
+		if (tint_opa != LV_OPA_TRANSP) ctx->lut[i] = lv_color_mix(tint_color, ctx->lut[i], tint_opa);
+	}
+	ctx->src = dsc->src;
+	track_open(ctx->src);
+	ctx->px = pal;
+	ctx->stride = ((uint32_t)img->header.w * bpp + 7) >> 3;
+	ctx->bpp = bpp;
+
+	dsc->header.cf = LV_IMG_CF_TRUE_COLOR;
+	dsc->img_data = NULL;       // 不提供整帧数据，LVGL逐行调用read_line
+	dsc->user_data = ctx;
+	return LV_RES_OK;
+}
+
+/**
+ * 读取一行中[x, x+len)的像素：按索引查表写成lv_color_t
+ * 1/2/4位索引高位在前，行尾不足一字节补0（与lv_img_conv及ImageToHolo一致）
+ */
+static lv_res_t LV_ATTRIBUTE_HOT palette_lv_read_line(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc,
+									 lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t* buf)
+{
+	PaletteLvCtx* ctx = (PaletteLvCtx*)dsc->user_data;
+	const uint8_t* row = ctx->px + (uint32_t)y * ctx->stride;
+	lv_color_t* out = (lv_color_t*)buf;
+
+	if (ctx->bpp == 8)
+	{
+		row += x;
+		for (lv_coord_t i = 0; i < len; i++) out[i] = ctx->lut[row[i]];
+		return LV_RES_OK;
+	}
+
+	uint8_t bpp = ctx->bpp;
+	uint8_t mask = (1 << bpp) - 1;
+	uint8_t ppb = 8 / bpp;
+	const uint8_t* p = row + x / ppb;
+	int8_t shift = 8 - bpp - (x % ppb) * bpp;
+	for (lv_coord_t i = 0; i < len; i++)
+	{
+		out[i] = ctx->lut[(*p >> shift) & mask];
+		shift -= bpp;
+		if (shift < 0)
+		{
+			shift = 8 - bpp;
+			p++;
+		}
+	}
+	return LV_RES_OK;
+}
+
+static void palette_lv_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	PaletteLvCtx* ctx = (PaletteLvCtx*)dsc->user_data;
+	track_close(ctx->src);
+	delete ctx;
+	dsc->user_data = NULL;
+}
+
+/**
+ * 注册索引色解码器
+ * 新解码器插入列表头部，优先于内置.bin解码器尝试
+ */
+void palette_decoder_lv_init()
+{
+	lv_img_decoder_t* dec = lv_img_decoder_create();
+	lv_img_decoder_set_info_cb(dec, palette_lv_info);
+	lv_img_decoder_set_open_cb(dec, palette_lv_open);
+	lv_img_decoder_set_read_line_cb(dec, palette_lv_read_line);
+	lv_img_decoder_set_close_cb(dec, palette_lv_close);
+}
+
+/**
+ * 设置着色：已打开的索引色图像在缓存中失效（关闭回调随即移出记录），整屏重绘时按新的调色板重新打开
+ */
+void palette_decoder_set_tint(lv_color_t color, lv_opa_t opa)
+{
+	if (opa == tint_opa && (opa == LV_OPA_TRANSP || color.full == tint_color.full)) return;
+	tint_color = color;
+	tint_opa = opa;
+
+	if (opened_overflow)
+	{
+		lv_img_cache_invalidate_src(NULL);
+		opened_overflow = false;
+	}
+	else
+	{
+		const void* srcs[PALETTE_TINT_TRACK];
+		uint8_t n = opened_cnt;
+		memcpy(srcs, opened, n * sizeof(srcs[0]));
+		for (uint8_t i = 0; i < n; i++) lv_img_cache_invalidate_src(srcs[i]);
+	}
+	lv_obj_invalidate(lv_scr_act());
+}
+
+lv_opa_t palette_decoder_get_tint(lv_color_t* color)
+{
+	if (color) *color = tint_color;
+	return tint_opa;
+}
@@ -0,0 +1,453 @@
+/*
+ * HoloCubic 视差场景模块
+ *
+ * 功能说明：
+ * 1. 场景由2~4个预合成的RGB565（可带alpha）图层组成，由远到近叠放
+ * 2. DMP姿态的横滚/俯仰经低通滤波与滞回后换算为各图层的位移
+ * 3. 只重绘移动图层的新旧区域：脏矩形按条带在内存中合成，经pushRect直接写屏
+ *
+ * 数据流：
+ *   orientation.get() --> 各图层位移 --> 脏矩形（合并） --> 条带合成（由下到上） --> pushRect
+ *
+ * 场景描述文件（SD卡文本文件，图层由远到近，图像取自flash资源包）：
+ *   # 注释
+ *   bg 101820              底色（RRGGBB，可省略，默认黑色）
+ *   sky -12 -12 6          资源名 x y depth
+ *   hills 0 120 12
+ *   cubic 70 60 28
+ */
+
+#include "parallax.h"
+#include "orientation.h"
+#include "asset_bundle.h"
+#include "sd_card.h"
+#include <esp_heap_caps.h>
+
+// RGB565展开为0000 0GGG GGG0 0000 RRRR R000 00BB BBBB，三个分量可以同时乘以5位alpha
+#define SPREAD_MASK 0x07E0F81FU
+
+/**
+ * 图像中的像素值（lv_color_t）转为本机字节序RGB565
+ */
+static inline uint16_t native565(uint16_t c)
+{
+#if LV_COLOR_16_SWAP
+	return (c >> 8) | (c << 8);
+#else
+	return c;
+#endif
+}
+
+/**
+ * 角度差折算到[-π, π]，姿态越过±180°时位移不跳变
+ */
+static float wrapAngle(float a)
+{
+	while (a > PI) a -= 2 * PI;
+	while (a < -PI) a += 2 * PI;
+	return a;
+}
+
+static void copyRow(uint16_t* dst, const uint16_t* src, int32_t len)
+{
+	for (int32_t i = 0; i < len; i++) dst[i] = native565(src[i]);
+}
+
+/**
+ * 按像素alpha（LV_IMG_CF_TRUE_COLOR_ALPHA：颜色低字节、高字节、alpha）混合到条带上
+ * 预合成图层的大部分像素为全透明或不透明，这两种不做乘法
+ */
+static void blendRow(uint16_t* dst, const uint8_t* src, int32_t len)
+{
+	for (int32_t i = 0; i < len; i++, src += LV_IMG_PX_SIZE_ALPHA_BYTE)
+	{
+		uint8_t a = src[2];
+		if (a < 4) continue;
+		uint16_t c = native565(src[0] | (src[1] << 8));
+		if (a > 251)
+		{
+			dst[i] = c;
+			continue;
+		}
+		uint32_t fg = (c | ((uint32_t)c << 16)) & SPREAD_MASK;
+		uint32_t bgp = (dst[i] | ((uint32_t)dst[i] << 16)) & SPREAD_MASK;
+		uint32_t r = ((((fg - bgp) * ((a + 4) >> 3)) >> 5) + bgp) & SPREAD_MASK;
+		dst[i] = (uint16_t)(r | (r >> 16));
+	}
+}
+
+ParallaxScene::ParallaxScene()
+{
+	display = NULL;
+	layer_count = 0;
+	band = NULL;
+	running = false;
+	frame_task = NULL;
+	screen = prev_screen = NULL;
+	bg = 0;
+	view.x1 = 0;
+	view.y1 = 0;
+	view.x2 = LV_HOR_RES_MAX - 1;
+	view.y2 = LV_VER_RES_MAX - 1;
+}
+
+void ParallaxScene::setDisplay(Display* disp)
+{
+	display = disp;
+}
+
+/**
+ * 设置场景图层（由远到近）
+ *
+ * @param defs     图层定义，内容会被复制
+ * @param count    图层数，超过PARALLAX_MAX_LAYERS的部分忽略
+ * @param bg_color 没有图层覆盖处的底色
+ * @return 有图像格式不支持时返回false
+ */
+bool ParallaxScene::open(const ParallaxLayer* defs, uint8_t count, lv_color_t bg_color)
+{
+	close();
+	bg = native565(bg_color.full);
+	if (count > PARALLAX_MAX_LAYERS) count = PARALLAX_MAX_LAYERS;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (!addLayer(defs[i]))
+		{
+			layer_count = 0;
+			return false;
+		}
+	}
+	return layer_count > 0;
+}
+
+/**
+ * 从SD卡读取场景描述文件（格式见文件头），图像按名称取自flash资源包
+ */
+bool ParallaxScene::load(const char* path)
+{
+	File f = SD_FS.open(path);
+	if (!f)
+	{
+		Serial.printf("视差场景%s无法打开\n", path);
+		return false;
+	}
+
+	ParallaxLayer defs[PARALLAX_MAX_LAYERS];
+	uint8_t count = 0;
+	uint32_t rgb = 0;
+	char name[PARALLAX_NAME_MAX];
+	while (f.available())
+	{
+		String line = f.readStringUntil('\n');
+		line.trim();
+		if (line.length() == 0 || line[0] == '#') continue;
+
+		int x, y, depth;
+		if (sscanf(line.c_str(), "bg %6x", &rgb) == 1) continue;
+		if (sscanf(line.c_str(), "%23s %d %d %d", name, &x, &y, &depth) != 4) continue;
+		if (count >= PARALLAX_MAX_LAYERS)
+		{
+			Serial.printf("视差场景最多%d个图层，%s被忽略\n", PARALLAX_MAX_LAYERS, name);
+			continue;
+		}
+		const lv_img_dsc_t* img = assets.getImage(name);
+		if (img == NULL)
+		{
+			Serial.printf("资源包中没有图层%s\n", name);
+			f.close();
+			return false;
+		}
+		defs[count].img = img;
+		defs[count].x = x;
+		defs[count].y = y;
+		defs[count].depth = depth;
+		count++;
+	}
+	f.close();
+
+	return open(defs, count, lv_color_hex(rgb));
+}
+
+/**
+ * 进入视差场景（在LVGL任务中调用）
+ */
+bool ParallaxScene::start()
+{
+	if (running) return true;
+	if (display == NULL || layer_count == 0) return false;
+
+	band = (uint16_t*)heap_caps_malloc(PARALLAX_BAND_PX * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+	if (band == NULL)
+	{
+		Serial.println("视差场景条带缓冲分配失败");
+		return false;
+	}
+
+	// 空白屏幕：LVGL不再有需要重绘的对象，先画完这一次，之后不会覆盖合成画面
+	prev_screen = lv_scr_act();
+	screen = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(screen, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	lv_scr_load(screen);
+	lv_refr_now(NULL);
+
+	memset(&stats, 0, sizeof(stats));
+	tilt_x = tilt_y = 0;
+	has_zero = false;
+	for (uint8_t i = 0; i < layer_count; i++)
+	{
+		layers[i].ox = layers[i].oy = 0;
+		move(&layers[i]);
+	}
+	dirty_count = 0;
+	full = true;
+
+	running = true;
+	frame_task = lv_task_create(frameCb, 1000 / PARALLAX_FPS, LV_TASK_PRIO_HIGH, this);
+	return true;
+}
+
+/**
+ * 退出视差场景，恢复原来的LVGL屏幕（在LVGL任务中调用），图层设置保留
+ */
+void ParallaxScene::stop()
+{
+	if (!running) return;
+
+	running = false;
+	if (frame_task)
+	{
+		lv_task_del(frame_task);
+		frame_task = NULL;
+	}
+	if (prev_screen) lv_scr_load(prev_screen);
+	if (screen) lv_obj_del(screen);
+	screen = prev_screen = NULL;
+
+	heap_caps_free(band);
+	band = NULL;
+}
+
+void ParallaxScene::close()
+{
+	stop();
+	layer_count = 0;
+}
+
+/**
+ * 以当前姿态作为初始姿态（各图层回到定义的位置）
+ */
+void ParallaxScene::recenter()
+{
+	has_zero = false;
+}
+
+bool ParallaxScene::isRunning()
+{
+	return running;
+}
+
+void ParallaxScene::getStats(ParallaxStats* out)
+{
+	*out = stats;
+}
+
+bool ParallaxScene::addLayer(const ParallaxLayer& def)
+{
+	const lv_img_dsc_t* img = def.img;
+	if (img == NULL || (img->header.cf != LV_IMG_CF_TRUE_COLOR && img->header.cf != LV_IMG_CF_TRUE_COLOR_ALPHA))
+	{
+		Serial.printf("视差图层%u格式不支持（需要TRUE_COLOR或TRUE_COLOR_ALPHA）\n", layer_count);
+		return false;
+	}
+
+	Layer* l = &layers[layer_count++];
+	l->def = def;
+	l->alpha = img->header.cf == LV_IMG_CF_TRUE_COLOR_ALPHA;
+	l->ox = l->oy = 0;
+	return true;
+}
+
+/**
+ * 读取最新姿态并低通滤波
+ * 第一次读到姿态（或recenter之后）时记为初始姿态
+ */
+void ParallaxScene::updateTilt()
+{
+	OrientationData d;
+	if (!orientation.get(&d)) return;
+
+	if (!has_zero)
+	{
+		zero_pitch = d.ypr[1];
+		zero_roll = d.ypr[2];
+		has_zero = true;
+	}
+	float rx = constrain(wrapAngle(d.ypr[2] - zero_roll), -PARALLAX_MAX_TILT, PARALLAX_MAX_TILT);
+	float ry = constrain(wrapAngle(d.ypr[1] - zero_pitch), -PARALLAX_MAX_TILT, PARALLAX_MAX_TILT);
+	tilt_x += (rx - tilt_x) * PARALLAX_SMOOTH;
+	tilt_y += (ry - tilt_y) * PARALLAX_SMOOTH;
+}
+
+/**
+ * 按当前倾角更新图层位移与区域
+ * @return 图层位置有变化
+ */
+bool ParallaxScene::move(Layer* l)
+{
+	float fx = l->def.depth * tilt_x / PARALLAX_MAX_TILT;
+	float fy = l->def.depth * tilt_y / PARALLAX_MAX_TILT;
+	bool moved = false;
+	if (fabsf(fx - l->ox) > PARALLAX_HYSTERESIS)
+	{
+		l->ox = lroundf(fx);
+		moved = true;
+	}
+	if (fabsf(fy - l->oy) > PARALLAX_HYSTERESIS)
+	{
+		l->oy = lroundf(fy);
+		moved = true;
+	}
+
+	l->area.x1 = l->def.x + l->ox;
+	l->area.y1 = l->def.y + l->oy;
+	l->area.x2 = l->area.x1 + l->def.img->header.w - 1;
+	l->area.y2 = l->area.y1 + l->def.img->header.h - 1;
+	return moved;
+}
+
+/**
+ * 登记脏矩形（裁剪到屏幕）
+ * 与已有矩形合并后总面积不增加时合并（与lv_refr的合并规则相同），合并结果可能又能与其他矩形合并
+ */
+void ParallaxScene::markDirty(const lv_area_t* a)
+{
+	lv_area_t r;
+	if (!_lv_area_intersect(&r, a, &view)) return;
+
+	uint8_t i = 0;
+	while (i < dirty_count)
+	{
+		lv_area_t j;
+		_lv_area_join(&j, &r, &dirty[i]);
+		if (lv_area_get_size(&j) <= lv_area_get_size(&r) + lv_area_get_size(&dirty[i]))
+		{
+			r = j;
+			dirty[i] = dirty[--dirty_count];
+			i = 0;
+			continue;
+		}
+		i++;
+	}
+
+	if (dirty_count == PARALLAX_DIRTY_MAX)
+	{
+		_lv_area_join(&dirty[dirty_count - 1], &dirty[dirty_count - 1], &r);
+		return;
+	}
+	dirty[dirty_count++] = r;
+}
+
+/**
+ * 合成并写出一个脏矩形：按条带缓冲可容纳的行数分段
+ */
+void ParallaxScene::compose(const lv_area_t* a)
+{
+	int32_t w = lv_area_get_width(a);
+	int32_t lines = PARALLAX_BAND_PX / w;
+	lv_area_t b = *a;
+	for (int32_t y = a->y1; y <= a->y2; y += lines)
+	{
+		b.y1 = y;
+		b.y2 = LV_MATH_MIN(y + lines - 1, a->y2);
+		composeBand(&b);
+		display->pushRect(b.x1, b.y1, w, lv_area_get_height(&b), band);
+	}
+}
+
+/**
+ * 在条带缓冲中由下到上合成一个区域
+ * 从完全覆盖该区域的最上层不透明图层开始，其下的图层与底色不必绘制
+ */
+void ParallaxScene::composeBand(const lv_area_t* a)
+{
+	int32_t w = lv_area_get_width(a);
+	int8_t first = -1;
+	for (int8_t i = layer_count - 1; i >= 0; i--)
+	{
+		if (!layers[i].alpha && _lv_area_is_in(a, &layers[i].area, 0))
+		{
+			first = i;
+			break;
+		}
+	}
+	if (first < 0)
+	{
+		uint32_t n = w * lv_area_get_height(a);
+		for (uint32_t i = 0; i < n; i++) band[i] = bg;
+		first = 0;
+	}
+
+	for (uint8_t i = first; i < layer_count; i++)
+	{
+		const Layer* l = &layers[i];
+		lv_area_t c;
+		if (!_lv_area_intersect(&c, a, &l->area)) continue;
+
+		const lv_img_dsc_t* img = l->def.img;
+		uint8_t px_size = l->alpha ? LV_IMG_PX_SIZE_ALPHA_BYTE : sizeof(lv_color_t);
+		uint32_t stride = img->header.w * px_size;
+		int32_t cw = lv_area_get_width(&c);
+		const uint8_t* src = img->data + (c.y1 - l->area.y1) * stride + (c.x1 - l->area.x1) * px_size;
+		uint16_t* dst = band + (c.y1 - a->y1) * w + (c.x1 - a->x1);
+		for (int32_t y = c.y1; y <= c.y2; y++, src += stride, dst += w)
+		{
+			if (l->alpha) blendRow(dst, src, cw);
+			else copyRow(dst, (const uint16_t*)src, cw);
+		}
+	}
+}
+
+/**
+ * 帧定时任务：更新姿态，登记移动图层的新旧区域，合成并写屏
+ */
+void ParallaxScene::frameCb(lv_task_t* task)
+{
+	ParallaxScene* self = (ParallaxScene*)task->user_data;
+	uint32_t t0 = micros();
+
+	self->updateTilt();
+	for (uint8_t i = 0; i < self->layer_count; i++)
+	{
+		Layer* l = &self->layers[i];
+		lv_area_t old = l->area;
+		if (!self->move(l)) continue;
+		self->markDirty(&old);
+		self->markDirty(&l->area);
+	}
+	if (self->full)
+	{
+		self->dirty_count = 0;
+		self->markDirty(&self->view);
+		self->full = false;
+	}
+	if (self->dirty_count == 0)
+	{
+		self->stats.idle++;
+		return;
+	}
+
+	self->display->waitVsync();
+	uint32_t pixels = 0;
+	for (uint8_t i = 0; i < self->dirty_count; i++)
+	{
+		self->compose(&self->dirty[i]);
+		pixels += lv_area_get_size(&self->dirty[i]);
+	}
+	self->dirty_count = 0;
+
+	uint32_t dt = micros() - t0;
+	self->stats.frames++;
+	self->stats.pixels = pixels;
+	self->stats.frame_us = dt;
+	if (dt > self->stats.max_us) self->stats.max_us = dt;
+}
@@ -0,0 +1,427 @@
+/*
+ * HoloCubic 性能回归检查
+ *
+ * 功能说明：
+ * 1. 逐项计时：混合内核、解码器read_line、SD顺序读取、整屏刷新、手势回放、lv_task调度
+ * 2. 与SD卡上的基线（上一次确认过的结果）比较，每项按各自的方向与容差判断是否回归
+ * 3. 输出串口摘要（PERF,<项>,<值>,<单位>,<基线>,<结果>）并写入JSON报告
+ *
+ * 数据流：
+ *   run --> benchX --> add(结果) --> compare(基线) --> writeReport（首次或update时同时写基线）
+ */
+
+#include "perf_check.h"
+#include "sd_card.h"
+#include "buf_manager.h"
+#include "imu_trace.h"
+#include "logger.h"
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+#include <src/lv_gpu/lv_gpu_esp32.h>
+
+#define PERF_STRIP_W 240
+#define PERF_STRIP_H 10
+#define PERF_KERNEL_LOOPS 100
+#define PERF_IMG_SIZE 100
+#define PERF_DECODE_LOOPS 10
+#define PERF_FLUSH_FRAMES 20
+#define PERF_SCHED_TASKS 16
+#define PERF_SCHED_BATCHES 200
+#define PERF_SCHED_BATCH 10
+
+/**
+ * 各项的方向与容差；表中没有的项按越小越好、PERF_TOLERANCE_PCT处理
+ * 计数类（漏检、误触发）容差为0：比基线多一次即为回归
+ */
+struct PerfRule
+{
+	const char* name;
+	bool higher_better;
+	uint8_t tolerance_pct;
+};
+
+static const PerfRule rules[] = {
+	{ "sd_read_kbs", true, 15 },
+	{ "flush_fps", true, 5 },
+	{ "gesture_misses", false, 0 },
+	{ "gesture_false_pos", false, 0 },
+	{ "task_handler_us", false, 20 },
+};
+
+#define PERF_MAX_ITEMS 12
+
+static const char* status_name[] = { "pass", "regress", "new", "skip" };
+
+PerfCheck perfcheck;
+
+PerfCheck::PerfCheck()
+{
+	results = NULL;
+	count = 0;
+}
+
+static const PerfRule* rule_of(const char* name)
+{
+	static const PerfRule def = { NULL, false, PERF_TOLERANCE_PCT };
+	for (uint8_t i = 0; i < sizeof(rules) / sizeof(rules[0]); i++)
+	{
+		if (strcmp(rules[i].name, name) == 0) return &rules[i];
+	}
+	return &def;
+}
+
+void PerfCheck::add(const char* name, const char* unit, float value)
+{
+	if (count >= PERF_MAX_ITEMS) return;
+	PerfResult* r = &results[count++];
+	r->name = name;
+	r->unit = unit;
+	r->value = value;
+	r->baseline = 0;
+	r->status = PERF_NEW;
+}
+
+void PerfCheck::skip(const char* name, const char* unit, const char* reason)
+{
+	if (count >= PERF_MAX_ITEMS) return;
+	LOG_W("perf", "跳过%s: %s", name, reason);
+	add(name, unit, 0);
+	results[count - 1].status = PERF_SKIP;
+}
+
+/**
+ * 混合内核：一条240x10条带的填充、复制交换与半透明混合（每次调用的微秒数）
+ */
+void PerfCheck::benchKernels()
+{
+	const uint32_t px = PERF_STRIP_W * PERF_STRIP_H;
+	lv_color_t* buf = (lv_color_t*)buf_alloc(BUF_FAST, px * 2 * sizeof(lv_color_t));
+	if (buf == NULL)
+	{
+		skip("fill_us", "us", "内存不足");
+		skip("copy_swap_us", "us", "内存不足");
+		skip("blend_us", "us", "内存不足");
+		return;
+	}
+	lv_color_t* map = buf + px;
+	for (uint32_t i = 0; i < px; i++) map[i].full = (uint16_t)(i * 2654435761U >> 16);
+
+	int64_t best[3] = { INT64_MAX, INT64_MAX, INT64_MAX };
+	for (uint8_t round = 0; round < PERF_ROUNDS; round++)
+	{
+		int64_t t0 = esp_timer_get_time();
+		for (uint16_t i = 0; i < PERF_KERNEL_LOOPS; i++)
+			lv_gpu_esp32_fill(buf, PERF_STRIP_W, LV_COLOR_MAKE(i, 0x80, 0x40), PERF_STRIP_W, PERF_STRIP_H);
+		int64_t t1 = esp_timer_get_time();
+		for (uint16_t i = 0; i < PERF_KERNEL_LOOPS; i++)
+			lv_gpu_esp32_copy_swap(buf, PERF_STRIP_W, map, PERF_STRIP_W, PERF_STRIP_W, PERF_STRIP_H);
+		int64_t t2 = esp_timer_get_time();
+		for (uint16_t i = 0; i < PERF_KERNEL_LOOPS; i++)
+			lv_gpu_esp32_blend(buf, PERF_STRIP_W, map, PERF_STRIP_W, LV_OPA_50, PERF_STRIP_W, PERF_STRIP_H);
+		int64_t t3 = esp_timer_get_time();
+		best[0] = LV_MATH_MIN(best[0], t1 - t0);
+		best[1] = LV_MATH_MIN(best[1], t2 - t1);
+		best[2] = LV_MATH_MIN(best[2], t3 - t2);
+	}
+	buf_free(buf);
+
+	add("fill_us", "us", (float)best[0] / PERF_KERNEL_LOOPS);
+	add("copy_swap_us", "us", (float)best[1] / PERF_KERNEL_LOOPS);
+	add("blend_us", "us", (float)best[2] / PERF_KERNEL_LOOPS);
+}
+
+/**
+ * 解码器：100x100的4位索引色图像经内置解码器逐行read_line（每幅的微秒数）
+ */
+void PerfCheck::benchDecoder()
+{
+	const uint32_t palette = 16 * sizeof(lv_color32_t);
+	const uint32_t size = palette + PERF_IMG_SIZE / 2 * PERF_IMG_SIZE;
+	uint8_t* data = (uint8_t*)buf_alloc(BUF_FAST, size + PERF_IMG_SIZE * LV_IMG_PX_SIZE_ALPHA_BYTE);
+	if (data == NULL)
+	{
+		skip("read_line_us", "us", "内存不足");
+		return;
+	}
+	lv_color32_t* pal = (lv_color32_t*)data;
+	for (uint8_t i = 0; i < 16; i++) pal[i].full = 0xFF000000U | (i * 0x00111111U);
+	for (uint32_t i = palette; i < size; i++) data[i] = (uint8_t)(i * 37);
+	uint8_t* line = data + size;
+
+	lv_img_dsc_t img;
+	memset(&img, 0, sizeof(img));
+	img.header.cf = LV_IMG_CF_INDEXED_4BIT;
+	img.header.w = PERF_IMG_SIZE;
+	img.header.h = PERF_IMG_SIZE;
+	img.data_size = size;
+	img.data = data;
+
+	lv_img_decoder_dsc_t dsc;
+	memset(&dsc, 0, sizeof(dsc));
+	if (lv_img_decoder_open(&dsc, &img, LV_COLOR_BLACK) != LV_RES_OK || dsc.img_data != NULL)
+	{
+		// img_data不为NULL时解码器整幅输出，不经过read_line
+		if (dsc.decoder) lv_img_decoder_close(&dsc);
+		buf_free(data);
+		skip("read_line_us", "us", "解码器不支持逐行读取");
+		return;
+	}
+
+	int64_t best = INT64_MAX;
+	for (uint8_t round = 0; round < PERF_ROUNDS; round++)
+	{
+		int64_t t0 = esp_timer_get_time();
+		for (uint8_t n = 0; n < PERF_DECODE_LOOPS; n++)
+		{
+			for (lv_coord_t y = 0; y < PERF_IMG_SIZE; y++) lv_img_decoder_read_line(&dsc, 0, y, PERF_IMG_SIZE, line);
+		}
+		best = LV_MATH_MIN(best, esp_timer_get_time() - t0);
+	}
+	lv_img_decoder_close(&dsc);
+	buf_free(data);
+
+	add("read_line_us", "us", (float)best / PERF_DECODE_LOOPS);
+}
+
+/**
+ * SD卡：顺序读取PERF_SD_FILE_SIZE（KB/s），测试文件不存在或长度不符时先写入
+ */
+void PerfCheck::benchSd()
+{
+	uint8_t* buf = (uint8_t*)buf_alloc(BUF_DMA, PERF_SD_CHUNK);
+	if (buf == NULL)
+	{
+		skip("sd_read_kbs", "KB/s", "内存不足");
+		return;
+	}
+
+	File f = SD_FS.open(PERF_SD_FILE);
+	bool ready = f && f.size() == PERF_SD_FILE_SIZE;
+	if (f) f.close();
+	if (!ready)
+	{
+		SD_FS.mkdir(PERF_DIR);
+		f = SD_FS.open(PERF_SD_FILE, FILE_WRITE);
+		for (uint32_t i = 0; i < PERF_SD_CHUNK; i++) buf[i] = (uint8_t)i;
+		for (uint32_t done = 0; f && done < PERF_SD_FILE_SIZE; done += PERF_SD_CHUNK)
+		{
+			if (f.write(buf, PERF_SD_CHUNK) != PERF_SD_CHUNK) break;
+		}
+		ready = f && f.size() == PERF_SD_FILE_SIZE;
+		if (f) f.close();
+	}
+	if (!ready)
+	{
+		buf_free(buf);
+		skip("sd_read_kbs", "KB/s", "无法写入测试文件（没有SD卡？）");
+		return;
+	}
+
+	int64_t best = INT64_MAX;
+	for (uint8_t round = 0; round < PERF_ROUNDS; round++)
+	{
+		f = SD_FS.open(PERF_SD_FILE);
+		if (!f) break;
+		uint32_t total = 0;
+		int64_t t0 = esp_timer_get_time();
+		int n;
+		while ((n = f.read(buf, PERF_SD_CHUNK)) > 0) total += n;
+		int64_t us = esp_timer_get_time() - t0;
+		f.close();
+		if (total == PERF_SD_FILE_SIZE) best = LV_MATH_MIN(best, us);
+	}
+	buf_free(buf);
+
+	if (best == INT64_MAX) skip("sd_read_kbs", "KB/s", "读取失败");
+	else add("sd_read_kbs", "KB/s", (float)PERF_SD_FILE_SIZE * 1000000 / 1024 / best);
+}
+
+/**
+ * 整屏刷新：当前屏幕整屏失效后立即刷新（绘制与送屏，帧/秒）
+ */
+void PerfCheck::benchFlush()
+{
+	lv_disp_t* disp = lv_disp_get_default();
+	if (disp == NULL)
+	{
+		skip("flush_fps", "fps", "没有显示");
+		return;
+	}
+
+	int64_t best = INT64_MAX;
+	for (uint8_t round = 0; round < PERF_ROUNDS; round++)
+	{
+		int64_t t0 = esp_timer_get_time();
+		for (uint8_t i = 0; i < PERF_FLUSH_FRAMES; i++)
+		{
+			lv_obj_invalidate(lv_disp_get_scr_act(disp));
+			lv_refr_now(disp);
+		}
+		best = LV_MATH_MIN(best, esp_timer_get_time() - t0);
+	}
+	add("flush_fps", "fps", (float)PERF_FLUSH_FRAMES * 1000000 / best);
+}
+
+/**
+ * 手势：回放带标注的轨迹（默认规则），平均识别延迟、漏检与误触发（与CPU速度无关，纯算法指标）
+ */
+void PerfCheck::benchGesture()
+{
+	GestureReplayReport r;
+	if (!SD_FS.exists(PERF_GESTURE_TRACE) || !ImuTrace::replay(PERF_GESTURE_TRACE, &r))
+	{
+		skip("gesture_latency_ms", "ms", "没有手势轨迹");
+		return;
+	}
+
+	uint32_t hits = 0, latency = 0, misses = 0, false_pos = 0;
+	for (uint8_t i = 1; i < GESTURE_TYPE_COUNT; i++)
+	{
+		hits += r.type[i].hits;
+		latency += r.type[i].latency_sum_ms;
+		misses += r.type[i].misses;
+		false_pos += r.type[i].false_pos;
+	}
+	add("gesture_latency_ms", "ms", hits ? (float)latency / hits : 0);
+	add("gesture_misses", "", misses);
+	add("gesture_false_pos", "", false_pos);
+}
+
+static void idle_task_cb(lv_task_t* t)
+{
+}
+
+/**
+ * 调度开销：额外登记PERF_SCHED_TASKS个不会就绪的任务，取最快的一批lv_task_handler（每次调用的微秒数）
+ * 取最快的一批以排除期间恰好就绪的刷新、输入等任务
+ */
+void PerfCheck::benchScheduler()
+{
+	lv_task_t* tasks[PERF_SCHED_TASKS];
+	uint8_t n = 0;
+	for (; n < PERF_SCHED_TASKS; n++)
+	{
+		tasks[n] = lv_task_create(idle_task_cb, UINT32_MAX / 2, LV_TASK_PRIO_LOWEST, NULL);
+		if (tasks[n] == NULL) break;
+	}
+
+	int64_t best = INT64_MAX;
+	for (uint16_t b = 0; b < PERF_SCHED_BATCHES; b++)
+	{
+		int64_t t0 = esp_timer_get_time();
+		for (uint8_t i = 0; i < PERF_SCHED_BATCH; i++) lv_task_handler();
+		best = LV_MATH_MIN(best, esp_timer_get_time() - t0);
+	}
+	for (uint8_t i = 0; i < n; i++) lv_task_del(tasks[i]);
+
+	if (n < PERF_SCHED_TASKS) skip("task_handler_us", "us", "内存不足");
+	else add("task_handler_us", "us", (float)best / PERF_SCHED_BATCH);
+}
+
+/**
+ * 与基线比较：越小越好的项超过基线*(1+容差)、越大越好的项低于基线*(1-容差)为回归
+ * @return 基线文件不存在或无法解析时返回false（各项保持PERF_NEW）
+ */
+bool PerfCheck::compare(const char* path)
+{
+	File f = SD_FS.open(path);
+	if (!f) return false;
+	JsonDocument doc;
+	DeserializationError err = deserializeJson(doc, f);
+	f.close();
+	if (err)
+	{
+		LOG_W("perf", "基线%s无法解析: %s", path, err.c_str());
+		return false;
+	}
+
+	JsonObject items = doc["items"];
+	for (uint8_t i = 0; i < count; i++)
+	{
+		PerfResult* r = &results[i];
+		if (r->status == PERF_SKIP || !items[r->name].is<float>()) continue;
+		const PerfRule* rule = rule_of(r->name);
+		r->baseline = items[r->name].as<float>();
+		float tol = r->baseline * rule->tolerance_pct / 100;
+		bool worse = rule->higher_better ? r->value < r->baseline - tol : r->value > r->baseline + tol;
+		r->status = worse ? PERF_REGRESS : PERF_PASS;
+	}
+	return true;
+}
+
+/**
+ * JSON报告；baseline为true时只写items（基线文件）
+ */
+bool PerfCheck::writeReport(const char* path, bool baseline)
+{
+	SD_FS.mkdir(PERF_DIR);
+	File f = SD_FS.open(path, FILE_WRITE);
+	if (!f)
+	{
+		LOG_W("perf", "无法写入%s", path);
+		return false;
+	}
+
+	f.printf("{\n  \"cpu_mhz\": %u,\n  \"rounds\": %u,\n  \"items\": {", getCpuFrequencyMhz(), PERF_ROUNDS);
+	bool first = true;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (results[i].status == PERF_SKIP) continue;
+		f.printf("%s\n    \"%s\": %.2f", first ? "" : ",", results[i].name, results[i].value);
+		first = false;
+	}
+	f.print("\n  }");
+	if (!baseline)
+	{
+		f.print(",\n  \"results\": [");
+		for (uint8_t i = 0; i < count; i++)
+		{
+			const PerfResult* r = &results[i];
+			const PerfRule* rule = rule_of(r->name);
+			f.printf("%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"value\": %.2f, \"baseline\": %.2f, "
+				"\"higher_better\": %s, \"tolerance_pct\": %u, \"status\": \"%s\"}",
+				i ? "," : "", r->name, r->unit, r->value, r->baseline, rule->higher_better ? "true" : "false",
+				rule->tolerance_pct, status_name[r->status]);
+		}
+		f.print("\n  ]");
+	}
+	f.print("\n}\n");
+	f.close();
+	return true;
+}
+
+bool PerfCheck::run(bool update)
+{
+	if (results == NULL) results = (PerfResult*)calloc(PERF_MAX_ITEMS, sizeof(PerfResult));
+	if (results == NULL) return false;
+	count = 0;
+
+	uint32_t start = millis();
+	benchKernels();
+	benchDecoder();
+	benchSd();
+	benchFlush();
+	benchGesture();
+	benchScheduler();
+
+	bool has_base = !update && compare(PERF_BASELINE_PATH);
+	uint8_t regress = 0;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		const PerfResult* r = &results[i];
+		if (r->status == PERF_REGRESS) regress++;
+		Serial.printf("PERF,%s,%.2f,%s,%.2f,%s\n", r->name, r->value, r->unit, r->baseline, status_name[r->status]);
+	}
+	writeReport(PERF_REPORT_PATH, false);
+	if (!has_base && writeReport(PERF_BASELINE_PATH, true)) LOG_I("perf", "已建立基线%s", PERF_BASELINE_PATH);
+
+	if (regress) LOG_W("perf", "性能回归%u项（%u毫秒），详见%s", regress, millis() - start, PERF_REPORT_PATH);
+	else LOG_I("perf", "性能检查通过（%u毫秒）", millis() - start);
+	return regress == 0;
+}
+
+uint8_t PerfCheck::getResults(const PerfResult** out)
+{
+	*out = results;
+	return count;
+}
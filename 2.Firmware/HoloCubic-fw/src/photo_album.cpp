@@ -0,0 +1,1135 @@
+/*
+ * HoloCubic 相册
+ *
+ * 功能说明：
+ * 1. 翻页时先显示缩略图（最长边ALBUM_THUMB_MAX，放大到全屏），连续翻页时每张只是一次图像切换
+ * 2. 停留ALBUM_FULL_DELAY_MS后，后台任务把完整图像解码到帧缓冲（JPEG用tjpgd缩放到不超过屏幕，
+ *    大图按1/2~1/8在IDCT阶段缩小，解码量随之减少），完成后替换缩略图
+ * 3. 空闲时按IMU的倾斜方向预解码下一张，翻到已解码的照片直接显示完整图像
+ * 4. 进入相册时后台任务增量更新索引，再为缺少缩略图的照片生成缩略图（有翻页请求时让出）
+ * 5. .htl分块大图平时显示金字塔的最后一级，按下后由TileViewer平移、逐级放大浏览原图
+ *
+ * 线程说明：
+ * - LVGL任务：界面、缩略图槽的读取与切换、帧的显示与释放
+ * - 后台任务（ALBUM_TASK_CORE）：索引、缩略图生成、完整图像解码，完成后通过runtime.post通知
+ * - 帧状态只在album_mux内修改；索引文件的读取与替换由index_lock串行（两边各自打开文件）
+ * - 后台任务的SD读写由sdhotplug.beginIo()/endIo()包围，掉卡期间不解码，恢复后由定期唤醒继续
+ *
+ * 注意事项：
+ * - 缩略图为LVGL真彩色.bin（按面板字节序），保存在ALBUM_CACHE_DIR/<照片名>.bin
+ * - 照片修改时间变化时删除旧缩略图，之后重新生成
+ * - 渐进式JPEG不受tjpgd支持，不会被索引
+ */
+
+#include "photo_album.h"
+#include "runtime.h"
+#include "buf_manager.h"
+#include "sd_card.h"
+#include "sd_hotplug.h"
+#include "logger.h"
+#include "telemetry.h"
+#include "lv_port_indev.h"
+#include <src/lv_gpu/lv_gpu_esp32.h>  // 面板字节序时的交换复制
+
+#define FRAME_FREE 0
+#define FRAME_DECODING 1
+#define FRAME_READY 2
+#define FRAME_SHOWN 3
+
+PhotoAlbum album;
+
+static portMUX_TYPE album_mux = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t index_lock = xSemaphoreCreateMutex();
+
+PhotoAlbum::PhotoAlbum()
+{
+	scr = NULL;
+	prev_scr = NULL;
+	img = NULL;
+	status = NULL;
+	group = NULL;
+	prev_group = NULL;
+	full_task = NULL;
+	thumb_task = NULL;
+	imu = NULL;
+	count = 0;
+	cur = 0;
+	last_dir = 1;
+	frame_count = 0;
+	memset(frames, 0, sizeof(frames));
+	memset(thumbs, 0, sizeof(thumbs));
+	shown = NULL;
+	worker = NULL;
+	done = NULL;
+	stopping = false;
+	want = -1;
+	thumb_buf = NULL;
+	decode_frame = NULL;
+	decode_idx = -1;
+}
+
+void PhotoAlbum::setImu(IMU* sensor)
+{
+	imu = sensor;
+}
+
+/**
+ * 进入相册
+ * @return 已在运行或内存不足时返回false
+ */
+bool PhotoAlbum::start()
+{
+	if (scr) return false;
+
+	uint32_t thumb_size = sizeof(lv_img_header_t) + ALBUM_THUMB_MAX * ALBUM_THUMB_MAX * sizeof(lv_color_t);
+	thumb_buf = (uint8_t*)buf_alloc(BUF_BULK, thumb_size);
+	done = xSemaphoreCreateBinary();
+	bool ok = thumb_buf != NULL && done != NULL;
+	for (uint8_t i = 0; ok && i < 2 * ALBUM_THUMB_AHEAD + 1; i++)
+	{
+		thumbs[i].buf = (uint8_t*)buf_alloc(BUF_BULK, thumb_size);
+		thumbs[i].idx = -1;
+		ok = thumbs[i].buf != NULL;
+	}
+	if (!ok)
+	{
+		LOG_E("album", "缩略图缓冲分配失败");
+		stop();
+		return false;
+	}
+
+	// 完整图像缓冲分配不到时减少预解码数量，一个也没有时由LVGL的S:解码器显示
+	uint32_t frame_size = (uint32_t)LV_HOR_RES_MAX * LV_VER_RES_MAX * sizeof(lv_color_t);
+	frame_count = 0;
+	for (uint8_t i = 0; i < ALBUM_FULL_BUFS; i++)
+	{
+		frames[i].buf = (uint8_t*)buf_alloc(BUF_BULK, frame_size);
+		frames[i].idx = -1;
+		frames[i].state = FRAME_FREE;
+		if (frames[i].buf == NULL) break;
+		frame_count++;
+	}
+	if (frame_count < ALBUM_FULL_BUFS) LOG_W("album", "完整图像缓冲: %u/%u", frame_count, ALBUM_FULL_BUFS);
+
+	prev_scr = lv_scr_act();
+	scr = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(scr, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	img = lv_img_create(scr, NULL);
+	lv_img_set_antialias(img, false);
+	lv_obj_set_hidden(img, true);
+	lv_obj_set_event_cb(img, keyCb);
+	status = lv_label_create(scr, NULL);
+	lv_obj_set_style_local_text_color(status, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_GRAY);
+	lv_label_set_text_static(status, "");
+
+	// 左右倾斜为编码器旋转，编辑模式下作为LV_KEY_LEFT/RIGHT送到图像对象
+	group = lv_group_create();
+	lv_group_add_obj(group, img);
+	lv_group_set_editing(group, true);
+	prev_group = indev_encoder ? indev_encoder->group : NULL;
+	if (indev_encoder) lv_indev_set_group(indev_encoder, group);
+
+	full_task = lv_task_create(fullTaskCb, ALBUM_FULL_DELAY_MS, LV_TASK_PRIO_OFF, this);
+	thumb_task = lv_task_create(thumbTaskCb, ALBUM_FULL_DELAY_MS / 4, LV_TASK_PRIO_OFF, this);
+
+	SD_FS.mkdir(ALBUM_CACHE_DIR);
+	cur = 0;
+	last_dir = 1;
+	shown = NULL;
+	want = -1;
+	stopping = false;
+	// 沿用上次的索引立即显示，后台重建完成后再刷新
+	count = readCount();
+	total = count;
+	if (count) show(0);
+	else setStatus("Indexing...");
+	lv_scr_load(scr);
+
+	if (xTaskCreatePinnedToCore(workerEntry, "album", ALBUM_TASK_STACK, this,
+								ALBUM_TASK_PRIORITY, &worker, ALBUM_TASK_CORE) != pdPASS)
+	{
+		worker = NULL;
+		stop();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 离开相册：等待后台任务结束（正在进行的解码会在下一个条带中止），释放所有缓冲
+ */
+void PhotoAlbum::stop()
+{
+	if (worker)
+	{
+		stopping = true;
+		want = -1;
+		xTaskNotifyGive(worker);
+		xSemaphoreTake(done, portMAX_DELAY);
+		worker = NULL;
+	}
+	if (full_task) lv_task_del(full_task);
+	if (thumb_task) lv_task_del(thumb_task);
+	full_task = NULL;
+	thumb_task = NULL;
+
+	viewer.close();
+	if (group)
+	{
+		if (indev_encoder) lv_indev_set_group(indev_encoder, prev_group);
+		lv_group_del(group);
+		group = NULL;
+	}
+	if (scr)
+	{
+		if (prev_scr) lv_scr_load(prev_scr);
+		lv_obj_del(scr);
+		scr = NULL;
+	}
+
+	// 缓存按描述符地址查找，下次进入时同一地址对应新的内容
+	for (uint8_t i = 0; i < ALBUM_FULL_BUFS; i++)
+	{
+		lv_img_cache_invalidate_src(&frames[i].dsc);
+		buf_free(frames[i].buf);
+		frames[i].buf = NULL;
+		frames[i].state = FRAME_FREE;
+	}
+	for (uint8_t i = 0; i < 2 * ALBUM_THUMB_AHEAD + 1; i++)
+	{
+		lv_img_cache_invalidate_src(&thumbs[i].dsc);
+		buf_free(thumbs[i].buf);
+		thumbs[i].buf = NULL;
+	}
+	buf_free(thumb_buf);
+	thumb_buf = NULL;
+	if (done) vSemaphoreDelete(done);
+	done = NULL;
+	jpeg.release();
+	frame_count = 0;
+	shown = NULL;
+	count = 0;
+}
+
+bool PhotoAlbum::isRunning()
+{
+	return scr != NULL;
+}
+
+/**** 索引 ****/
+
+/**
+ * 读取索引头中的照片数
+ * @return 索引不存在或格式不符时返回0
+ */
+uint32_t PhotoAlbum::readCount()
+{
+	xSemaphoreTake(index_lock, portMAX_DELAY);
+	File f = SD_FS.open(ALBUM_INDEX_FILE);
+	AlbumIndexHeader h;
+	bool ok = f && f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && memcmp(h.magic, ALBUM_INDEX_MAGIC, 4) == 0 &&
+			  h.version <= ALBUM_INDEX_VERSION && h.header_size >= sizeof(h) && h.entry_size >= sizeof(AlbumIndexEntry);
+	if (f) f.close();
+	xSemaphoreGive(index_lock);
+
+	return ok ? h.count : 0;
+}
+
+/**
+ * 读取第i张照片的条目（每次单独打开索引文件，LVGL任务与后台任务都可调用）
+ */
+bool PhotoAlbum::getEntry(uint32_t i, AlbumIndexEntry* e)
+{
+	xSemaphoreTake(index_lock, portMAX_DELAY);
+	File f = SD_FS.open(ALBUM_INDEX_FILE);
+	AlbumIndexHeader h;
+	bool ok = f && f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && memcmp(h.magic, ALBUM_INDEX_MAGIC, 4) == 0 &&
+			  h.entry_size >= sizeof(AlbumIndexEntry) && i < h.count &&
+			  f.seek(h.header_size + i * h.entry_size) &&
+			  f.read((uint8_t*)e, sizeof(AlbumIndexEntry)) == sizeof(AlbumIndexEntry);
+	if (f) f.close();
+	xSemaphoreGive(index_lock);
+
+	e->name[ALBUM_NAME_MAX - 1] = '\0';
+	if (ok) telemetry_sd_io(sizeof(AlbumIndexEntry), 0);
+	return ok;
+}
+
+void PhotoAlbum::photoPath(char* out, const char* name)
+{
+	snprintf(out, ALBUM_PATH_MAX, "%s/%s", ALBUM_ROOT, name);
+}
+
+void PhotoAlbum::thumbPath(char* out, const char* name)
+{
+	snprintf(out, ALBUM_PATH_MAX, "%s/%s.bin", ALBUM_CACHE_DIR, name);
+}
+
+/**
+ * 读取一张照片的尺寸（JPEG解析文件头，.bin读取图像头，只支持真彩色；.htl读取分块文件头）
+ * @return 不是照片（目录、隐藏文件、其他格式、名称过长）时返回false
+ */
+bool PhotoAlbum::probe(File& f, const char* name, AlbumIndexEntry* e)
+{
+	size_t len = strlen(name);
+	if (f.isDirectory() || name[0] == '.' || len >= ALBUM_NAME_MAX) return false;
+	const char* ext = strrchr(name, '.');
+	if (ext == NULL) return false;
+
+	memset(e, 0, sizeof(AlbumIndexEntry));
+	memcpy(e->name, name, len);
+	e->mtime = (uint32_t)f.getLastWrite();
+
+	if (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0)
+	{
+		src_file = f;
+		bool ok = jpeg.open(jpegRead, this);
+		src_file = File();
+		if (!ok) return false;
+		e->format = ALBUM_FORMAT_JPEG;
+		e->width = jpeg.getWidth();
+		e->height = jpeg.getHeight();
+		return true;
+	}
+	if (strcasecmp(ext, ".htl") == 0)
+	{
+		if (!TileImage::probe(f, &e->width, &e->height, &e->levels)) return false;
+		e->format = ALBUM_FORMAT_TILED;
+		return true;
+	}
+	if (strcasecmp(ext, ".bin") == 0)
+	{
+		lv_img_header_t h;
+		if (f.read((uint8_t*)&h, sizeof(h)) != sizeof(h) || h.cf != LV_IMG_CF_TRUE_COLOR || h.w == 0 || h.h == 0)
+			return false;
+		e->format = ALBUM_FORMAT_BIN;
+		e->width = h.w;
+		e->height = h.h;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * 增量重建索引（后台任务）：修改时间不变的照片沿用旧条目，其余重新读取并删除旧缩略图
+ */
+void PhotoAlbum::buildIndex()
+{
+	uint32_t start = millis();
+
+	AlbumIndexEntry* old = NULL;
+	uint32_t prev_count = readCount();
+	uint32_t old_count = prev_count;
+	if (old_count)
+	{
+		old_count = old_count < ALBUM_INDEX_CACHE_MAX ? old_count : ALBUM_INDEX_CACHE_MAX;
+		old = (AlbumIndexEntry*)buf_alloc(BUF_BULK, sizeof(AlbumIndexEntry) * old_count);
+		if (old == NULL) old_count = 0;
+		for (uint32_t i = 0; i < old_count; i++)
+		{
+			if (!getEntry(i, &old[i])) old[i].name[0] = '\0';
+		}
+	}
+
+	File root = SD_FS.open(ALBUM_ROOT);
+	File out = root && root.isDirectory() ? SD_FS.open(ALBUM_INDEX_TMP_FILE, FILE_WRITE) : File();
+	if (!out)
+	{
+		buf_free(old);
+		if (root) root.close();
+		return;
+	}
+
+	AlbumIndexHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, ALBUM_INDEX_MAGIC, 4);
+	h.version = ALBUM_INDEX_VERSION;
+	h.header_size = sizeof(AlbumIndexHeader);
+	h.entry_size = sizeof(AlbumIndexEntry);
+	out.write((const uint8_t*)&h, sizeof(h));
+
+	uint32_t reused = 0;
+	uint32_t probed = 0;
+	File f;
+	while (!stopping && (f = root.openNextFile()))
+	{
+		const char* name = strrchr(f.name(), '/');
+		name = name ? name + 1 : f.name();
+
+		AlbumIndexEntry e;
+		bool ok = false;
+		uint32_t mtime = (uint32_t)f.getLastWrite();
+		for (uint32_t i = 0; i < old_count; i++)
+		{
+			if (old[i].mtime == mtime && strcmp(old[i].name, name) == 0)
+			{
+				e = old[i];
+				ok = true;
+				reused++;
+				break;
+			}
+		}
+		if (!ok && probe(f, name, &e))
+		{
+			char path[ALBUM_PATH_MAX];
+			thumbPath(path, name);
+			SD_FS.remove(path);
+			ok = true;
+			probed++;
+		}
+		f.close();
+
+		if (ok)
+		{
+			out.write((const uint8_t*)&e, sizeof(e));
+			h.count++;
+		}
+	}
+	root.close();
+	buf_free(old);
+
+	out.seek(0);
+	out.write((const uint8_t*)&h, sizeof(h));
+	out.close();
+	// 中途离开时保留旧索引
+	if (stopping) return;
+
+	xSemaphoreTake(index_lock, portMAX_DELAY);
+	SD_FS.remove(ALBUM_INDEX_FILE);
+	SD_FS.rename(ALBUM_INDEX_TMP_FILE, ALBUM_INDEX_FILE);
+	xSemaphoreGive(index_lock);
+
+	LOG_I("album", "相册索引已更新: %u张（沿用%u，读取%u），%u ms", h.count, reused, probed, millis() - start);
+	// 没有新增或修改的照片、总数也不变时条目与旧索引相同
+	total = h.count;
+	runtime.post(onIndexReady, this, probed > 0 || h.count != prev_count);
+}
+
+/**** 后台任务 ****/
+
+void PhotoAlbum::workerEntry(void* arg)
+{
+	PhotoAlbum* self = (PhotoAlbum*)arg;
+	// 进入相册时SD卡正在重新挂载：等待恢复后再建立索引
+	while (!self->stopping && !sdhotplug.beginIo()) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ALBUM_FULL_DELAY_MS));
+	if (!self->stopping)
+	{
+		self->buildIndex();
+		sdhotplug.endIo();
+	}
+	self->serve();
+	self->makeThumbs();
+	while (!self->stopping)
+	{
+		// 定期醒来按最新的倾斜方向重新选择预解码的照片
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ALBUM_FULL_DELAY_MS));
+		self->serve();
+	}
+	self->jpeg.release();
+	xSemaphoreGive(self->done);
+	vTaskDelete(NULL);
+}
+
+int32_t PhotoAlbum::wrap(int32_t i, uint32_t n)
+{
+	return n > 0 ? ((i % (int32_t)n) + (int32_t)n) % (int32_t)n : 0;
+}
+
+/**
+ * 倾斜方向：向左倾（AY为正）为上一张，向右倾为下一张，没有倾斜时按上次翻页方向
+ */
+int8_t PhotoAlbum::leanDir()
+{
+	SensorSample s;
+	if (imu && sensorbus.get(SENSOR_IMU, &s))
+	{
+		if (s.accel[1] > ALBUM_LEAN_AY) return -1;
+		if (s.accel[1] < -ALBUM_LEAN_AY) return 1;
+	}
+	return last_dir;
+}
+
+/**
+ * 第i张照片是否已有（或正在解码）完整图像
+ */
+bool PhotoAlbum::hasFrame(int32_t i)
+{
+	bool found = false;
+	portENTER_CRITICAL(&album_mux);
+	for (uint8_t k = 0; k < frame_count; k++)
+	{
+		if (frames[k].state != FRAME_FREE && frames[k].idx == i) found = true;
+	}
+	portEXIT_CRITICAL(&album_mux);
+	return found;
+}
+
+/**
+ * 取一个可写的帧：优先空闲帧，其次不是want的预解码结果
+ */
+AlbumFrame* PhotoAlbum::takeFrame()
+{
+	AlbumFrame* f = NULL;
+	portENTER_CRITICAL(&album_mux);
+	for (uint8_t k = 0; k < frame_count && f == NULL; k++)
+	{
+		if (frames[k].state == FRAME_FREE) f = &frames[k];
+	}
+	for (uint8_t k = 0; k < frame_count && f == NULL; k++)
+	{
+		if (frames[k].state == FRAME_READY && frames[k].idx != want) f = &frames[k];
+	}
+	if (f) f->state = FRAME_DECODING;
+	portEXIT_CRITICAL(&album_mux);
+	return f;
+}
+
+/**
+ * 解码完整图像：先满足want，再按倾斜方向预解码相邻一张，都已就绪时返回
+ */
+void PhotoAlbum::serve()
+{
+	while (!stopping && total > 0)
+	{
+		int32_t w = want;
+		if (w < 0) return;  // 仍在翻页，不预解码
+
+		int32_t target = w;
+		if (hasFrame(w))
+		{
+			target = wrap(cur + leanDir(), total);
+			if (target == w || hasFrame(target)) return;
+		}
+
+		if (!sdhotplug.beginIo()) return;
+		AlbumFrame* f = takeFrame();
+		if (f == NULL)
+		{
+			sdhotplug.endIo();
+			return;
+		}
+		bool ok = decodeFull(f, target);
+		sdhotplug.endIo();
+
+		portENTER_CRITICAL(&album_mux);
+		f->idx = ok ? target : -1;
+		f->state = ok ? FRAME_READY : FRAME_FREE;
+		portEXIT_CRITICAL(&album_mux);
+
+		if (ok) runtime.post(onFrameReady, f, target);
+		else if (!stopping && want == target)
+		{
+			// 无法解码的照片只显示缩略图，不再重试
+			if (target == w) want = -1;
+			return;
+		}
+	}
+}
+
+/**
+ * 为缺少缩略图的照片生成缩略图，从当前照片附近开始；每张之间先处理完整图像请求
+ */
+void PhotoAlbum::makeThumbs()
+{
+	uint32_t made = 0;
+	uint32_t start = millis();
+	int32_t first = wrap(cur - ALBUM_THUMB_AHEAD, total);
+	for (uint32_t n = 0; n < total && !stopping; n++)
+	{
+		// 掉卡：其余的缩略图下次进入相册时再生成
+		if (!sdhotplug.beginIo()) break;
+		int32_t i = wrap(first + n, total);
+		AlbumIndexEntry e;
+		char path[ALBUM_PATH_MAX];
+		bool need = getEntry(i, &e);
+		if (need)
+		{
+			thumbPath(path, e.name);
+			need = !SD_FS.exists(path);
+		}
+
+		// 被完整图像请求打断时处理完请求后重试同一张
+		bool ok = false;
+		while (need && !(ok = makeThumb(&e)) && !stopping && want >= 0 && !hasFrame(want) && sdhotplug.isAvailable())
+			serve();
+		sdhotplug.endIo();
+		if (!need) continue;
+		serve();
+		if (!ok) continue;
+		made++;
+		runtime.post(onThumbReady, this, i);
+	}
+	if (made) LOG_I("album", "生成缩略图%u张，%u ms", made, millis() - start);
+}
+
+/**
+ * 选择缩放：最小的scale使宽高不超过max_w x max_h（最多1/8）
+ */
+uint8_t PhotoAlbum::fitScale(uint16_t w, uint16_t h, uint16_t max_w, uint16_t max_h)
+{
+	uint8_t s = 0;
+	while (s < 3 && (JpegDecoder::scaledSize(w, s) > max_w || JpegDecoder::scaledSize(h, s) > max_h)) s++;
+	return s;
+}
+
+/**
+ * 生成一张缩略图：JPEG先按scale缩小解码，仍大于ALBUM_THUMB_MAX时再隔out_step取一个像素；
+ * .bin按行抽样读取，.htl由最后一级逐块抽样。先写临时文件再改名，LVGL任务不会读到写了一半的缩略图
+ *
+ * @return 解码失败或被打断时返回false
+ */
+bool PhotoAlbum::makeThumb(const AlbumIndexEntry* e)
+{
+	char path[ALBUM_PATH_MAX];
+	photoPath(path, e->name);
+	lv_img_header_t* hdr = (lv_img_header_t*)thumb_buf;
+	uint16_t* px = (uint16_t*)(thumb_buf + sizeof(lv_img_header_t));
+	bool ok = false;
+
+	if (e->format == ALBUM_FORMAT_JPEG)
+	{
+		uint8_t s = fitScale(e->width, e->height, ALBUM_THUMB_MAX, ALBUM_THUMB_MAX);
+		uint16_t sw = JpegDecoder::scaledSize(e->width, s);
+		uint16_t sh = JpegDecoder::scaledSize(e->height, s);
+		uint16_t m = LV_MATH_MAX(sw, sh);
+		out_step = (m + ALBUM_THUMB_MAX - 1) / ALBUM_THUMB_MAX;
+		out_w = LV_MATH_MAX(sw / out_step, 1);
+		out_h = LV_MATH_MAX(sh / out_step, 1);
+		ok = decodeJpeg(path, s, thumbBand);
+	}
+	else if (e->format == ALBUM_FORMAT_TILED)
+	{
+		ok = decodeTiled(path, (lv_color_t*)px, ALBUM_THUMB_MAX, ALBUM_THUMB_MAX, thumbAbort);
+	}
+	else
+	{
+		uint16_t m = LV_MATH_MAX(e->width, e->height);
+		out_step = (m + ALBUM_THUMB_MAX - 1) / ALBUM_THUMB_MAX;
+		out_w = LV_MATH_MAX(e->width / out_step, 1);
+		out_h = LV_MATH_MAX(e->height / out_step, 1);
+		uint32_t row_bytes = (uint32_t)e->width * sizeof(lv_color_t);
+		uint16_t* row = (uint16_t*)buf_alloc(BUF_FAST, row_bytes);
+		File f = row ? SD_FS.open(path) : File();
+		ok = f;
+		for (uint16_t y = 0; ok && y < out_h; y++)
+		{
+			ok = f.seek(sizeof(lv_img_header_t) + (uint32_t)y * out_step * row_bytes) &&
+				 f.read((uint8_t*)row, row_bytes) == row_bytes;
+			// .bin已是面板字节序，直接抽样
+			for (uint16_t x = 0; ok && x < out_w; x++) px[(uint32_t)y * out_w + x] = row[x * out_step];
+		}
+		if (f) f.close();
+		buf_free(row);
+		if (ok) telemetry_sd_io((uint32_t)out_h * row_bytes, 0);
+	}
+	if (!ok) return false;
+
+	memset(hdr, 0, sizeof(lv_img_header_t));
+	hdr->cf = LV_IMG_CF_TRUE_COLOR;
+	hdr->w = out_w;
+	hdr->h = out_h;
+	uint32_t size = sizeof(lv_img_header_t) + (uint32_t)out_w * out_h * sizeof(lv_color_t);
+
+	char tmp[ALBUM_PATH_MAX];
+	snprintf(tmp, sizeof(tmp), "%s/thumb.tmp", ALBUM_CACHE_DIR);
+	File out = SD_FS.open(tmp, FILE_WRITE);
+	if (!out) return false;
+	ok = out.write(thumb_buf, size) == size;
+	out.close();
+	thumbPath(path, e->name);
+	ok = ok && SD_FS.rename(tmp, path);
+	if (ok) telemetry_sd_io(0, size);
+	return ok;
+}
+
+/**
+ * 解码第i张照片的完整图像到帧f（不超过屏幕大小，更大的部分裁掉右、下边缘；分块大图为总览）
+ * @return 解码失败或被新的请求打断时返回false
+ */
+bool PhotoAlbum::decodeFull(AlbumFrame* f, int32_t i)
+{
+	AlbumIndexEntry e;
+	if (!getEntry(i, &e)) return false;
+	char path[ALBUM_PATH_MAX];
+	photoPath(path, e.name);
+	uint32_t start = millis();
+
+	lv_img_cache_invalidate_src(&f->dsc);
+	bool ok = false;
+	if (e.format == ALBUM_FORMAT_JPEG)
+	{
+		uint8_t s = fitScale(e.width, e.height, LV_HOR_RES_MAX, LV_VER_RES_MAX);
+		out_w = LV_MATH_MIN(JpegDecoder::scaledSize(e.width, s), LV_HOR_RES_MAX);
+		out_h = LV_MATH_MIN(JpegDecoder::scaledSize(e.height, s), LV_VER_RES_MAX);
+		decode_frame = f;
+		decode_idx = i;
+		ok = decodeJpeg(path, s, frameBand);
+	}
+	else if (e.format == ALBUM_FORMAT_TILED)
+	{
+		decode_idx = i;
+		ok = decodeTiled(path, (lv_color_t*)f->buf, LV_HOR_RES_MAX, LV_VER_RES_MAX, frameAbort);
+	}
+	else
+	{
+		out_w = LV_MATH_MIN(e.width, LV_HOR_RES_MAX);
+		out_h = LV_MATH_MIN(e.height, LV_VER_RES_MAX);
+		uint32_t row_bytes = (uint32_t)e.width * sizeof(lv_color_t);
+		uint32_t out_bytes = (uint32_t)out_w * sizeof(lv_color_t);
+		File file = SD_FS.open(path);
+		ok = file && file.seek(sizeof(lv_img_header_t));
+		if (ok && out_bytes == row_bytes)
+		{
+			ok = file.read(f->buf, out_bytes * out_h) == out_bytes * out_h;
+		}
+		else
+		{
+			for (uint16_t y = 0; ok && y < out_h; y++)
+			{
+				ok = file.seek(sizeof(lv_img_header_t) + y * row_bytes) &&
+					 file.read(f->buf + y * out_bytes, out_bytes) == out_bytes;
+			}
+		}
+		if (file) file.close();
+		if (ok) telemetry_sd_io(out_bytes * out_h, 0);
+	}
+	decode_frame = NULL;
+	decode_idx = -1;
+	if (!ok) return false;
+
+	memset(&f->dsc, 0, sizeof(f->dsc));
+	f->dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+	f->dsc.header.w = out_w;
+	f->dsc.header.h = out_h;
+	f->dsc.data_size = (uint32_t)out_w * out_h * sizeof(lv_color_t);
+	f->dsc.data = f->buf;
+	LOG_D("album", "解码 %s: %ux%u，%u ms", e.name, out_w, out_h, millis() - start);
+	return true;
+}
+
+bool PhotoAlbum::decodeJpeg(const char* path, uint8_t scale, jpeg_band_cb_t cb)
+{
+	src_file = SD_FS.open(path);
+	if (!src_file) return false;
+	bool ok = jpeg.open(jpegRead, this) && jpeg.decode(cb, this, scale);
+	if (ok) telemetry_sd_io(src_file.size(), 0);
+	src_file.close();
+	return ok;
+}
+
+/**
+ * 分块大图：最后一级按步长抽样到不超过max_w x max_h（out_w/out_h/out_step随之设置）
+ * 分块之间调用abort_cb检查是否被打断
+ */
+bool PhotoAlbum::decodeTiled(const char* path, lv_color_t* dst, uint16_t max_w, uint16_t max_h,
+							 tile_abort_cb_t abort_cb)
+{
+	if (!tiles.open(path)) return false;
+	uint8_t l = tiles.getLevels() - 1;
+	uint16_t lw = tiles.getWidth(l);
+	uint16_t lh = tiles.getHeight(l);
+	out_step = LV_MATH_MAX((lw + max_w - 1) / max_w, (lh + max_h - 1) / max_h);
+	out_w = LV_MATH_MAX(lw / out_step, 1);
+	out_h = LV_MATH_MAX(lh / out_step, 1);
+	uint32_t tile_size = (uint32_t)tiles.getTileW() * tiles.getTileH() * sizeof(lv_color_t);
+	lv_color_t* tile = (lv_color_t*)buf_alloc(BUF_FAST, tile_size);
+	bool ok = tile && tiles.renderLevel(l, dst, out_w, out_h, out_step, tile, abort_cb, this);
+	buf_free(tile);
+	tiles.close();
+	return ok;
+}
+
+uint32_t PhotoAlbum::jpegRead(void* user, uint8_t* buf, uint32_t len)
+{
+	File& f = ((PhotoAlbum*)user)->src_file;
+	if (buf == NULL)
+	{
+		uint32_t pos = f.position();
+		uint32_t left = f.size() - pos;
+		if (len > left) len = left;
+		return f.seek(pos + len) ? len : 0;
+	}
+	int n = f.read(buf, len);
+	return n > 0 ? n : 0;
+}
+
+/**
+ * 缩略图条带：每out_step行、out_step列取一个像素（转换为面板字节序）
+ * 有未满足的完整图像请求时中止，处理完请求后重新生成
+ */
+bool PhotoAlbum::thumbBand(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px)
+{
+	PhotoAlbum* self = (PhotoAlbum*)user;
+	uint16_t* dst = (uint16_t*)(self->thumb_buf + sizeof(lv_img_header_t));
+	for (uint16_t r = 0; r < h; r++)
+	{
+		uint32_t sy = y + r;
+		if (sy % self->out_step || sy / self->out_step >= self->out_h) continue;
+		uint16_t* out = dst + sy / self->out_step * self->out_w;
+		const uint16_t* in = px + (uint32_t)r * w;
+		for (uint16_t x = 0; x < self->out_w; x++)
+		{
+			uint16_t v = in[x * self->out_step];
+#if LV_COLOR_16_SWAP
+			v = (v >> 8) | (v << 8);
+#endif
+			out[x] = v;
+		}
+	}
+	return !thumbAbort(self);
+}
+
+/**
+ * 缩略图生成的中止条件：有未满足的完整图像请求
+ */
+bool PhotoAlbum::thumbAbort(void* user)
+{
+	PhotoAlbum* self = (PhotoAlbum*)user;
+	int32_t wanted = self->want;
+	return self->stopping || (wanted >= 0 && !self->hasFrame(wanted));
+}
+
+/**
+ * 完整图像解码的中止条件：请求已换成另一张
+ */
+bool PhotoAlbum::frameAbort(void* user)
+{
+	PhotoAlbum* self = (PhotoAlbum*)user;
+	int32_t wanted = self->want;
+	return self->stopping || (wanted >= 0 && wanted != self->decode_idx);
+}
+
+/**
+ * 完整图像条带：复制到帧缓冲（裁到out_w x out_h），want变为其他照片时中止
+ */
+bool PhotoAlbum::frameBand(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px)
+{
+	PhotoAlbum* self = (PhotoAlbum*)user;
+	if (frameAbort(self)) return false;
+	if (y >= self->out_h) return true;
+
+	uint16_t rows = LV_MATH_MIN(h, self->out_h - y);
+	lv_color_t* dst = (lv_color_t*)self->decode_frame->buf + (uint32_t)y * self->out_w;
+#if LV_COLOR_16_SWAP
+	lv_gpu_esp32_copy_swap(dst, self->out_w, (const lv_color_t*)px, w, self->out_w, rows);
+#else
+	for (uint16_t r = 0; r < rows; r++)
+	{
+		memcpy(dst + (uint32_t)r * self->out_w, px + (uint32_t)r * w, self->out_w * sizeof(uint16_t));
+	}
+#endif
+	return true;
+}
+
+/**** 界面（LVGL任务） ****/
+
+void PhotoAlbum::setStatus(const char* text)
+{
+	lv_label_set_text_static(status, text);
+	lv_obj_align(status, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, -8);
+}
+
+AlbumThumb* PhotoAlbum::findThumb(int32_t i)
+{
+	for (uint8_t k = 0; k < 2 * ALBUM_THUMB_AHEAD + 1; k++)
+	{
+		if (thumbs[k].idx == i) return &thumbs[k];
+	}
+	return NULL;
+}
+
+/**
+ * 读取第i张的缩略图到缩略图槽（已在槽中时直接返回），替换离当前照片最远的槽
+ * @return 缩略图尚未生成时返回NULL
+ */
+AlbumThumb* PhotoAlbum::loadThumb(int32_t i)
+{
+	AlbumThumb* t = findThumb(i);
+	if (t) return t;
+
+	uint32_t far = 0;
+	for (uint8_t k = 0; k < 2 * ALBUM_THUMB_AHEAD + 1; k++)
+	{
+		AlbumThumb* s = &thumbs[k];
+		uint32_t d = count;
+		if (s->idx >= 0 && (uint32_t)s->idx < count)
+		{
+			d = abs(s->idx - cur);
+			d = LV_MATH_MIN(d, count - d);
+		}
+		if (t == NULL || d > far)
+		{
+			t = s;
+			far = d;
+		}
+	}
+
+	AlbumIndexEntry e;
+	char path[ALBUM_PATH_MAX];
+	if (!getEntry(i, &e)) return NULL;
+	thumbPath(path, e.name);
+	File f = SD_FS.open(path);
+	if (!f) return NULL;
+
+	lv_img_cache_invalidate_src(&t->dsc);
+	t->idx = -1;
+	lv_img_header_t h;
+	uint32_t size = 0;
+	bool ok = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && h.cf == LV_IMG_CF_TRUE_COLOR &&
+			  h.w <= ALBUM_THUMB_MAX && h.h <= ALBUM_THUMB_MAX;
+	if (ok)
+	{
+		size = (uint32_t)h.w * h.h * sizeof(lv_color_t);
+		ok = f.read(t->buf, size) == size;
+	}
+	f.close();
+	if (!ok) return NULL;
+
+	telemetry_sd_io(sizeof(h) + size, 0);
+	memset(&t->dsc, 0, sizeof(t->dsc));
+	t->dsc.header = h;
+	t->dsc.data_size = size;
+	t->dsc.data = t->buf;
+	t->idx = i;
+	return t;
+}
+
+/**
+ * 读取当前照片前后的缩略图（翻页后由thumb_task调用，倾斜方向的一侧先读）
+ */
+void PhotoAlbum::prefetchThumbs()
+{
+	int8_t dir = leanDir();
+	for (int32_t d = 1; d <= ALBUM_THUMB_AHEAD; d++)
+	{
+		loadThumb(wrap(cur + dir * d, count));
+		loadThumb(wrap(cur - dir * d, count));
+	}
+}
+
+/**
+ * 停止显示完整图像，帧交还后台任务复用
+ */
+void PhotoAlbum::releaseShown()
+{
+	if (shown == NULL) return;
+	lv_img_cache_invalidate_src(&shown->dsc);
+	portENTER_CRITICAL(&album_mux);
+	shown->state = FRAME_FREE;
+	shown->idx = -1;
+	portEXIT_CRITICAL(&album_mux);
+	shown = NULL;
+}
+
+void PhotoAlbum::showFull(AlbumFrame* f)
+{
+	portENTER_CRITICAL(&album_mux);
+	bool ready = f->state == FRAME_READY && f->idx == cur;
+	if (ready) f->state = FRAME_SHOWN;
+	portEXIT_CRITICAL(&album_mux);
+	if (!ready) return;
+
+	lv_img_set_src(img, &f->dsc);
+	lv_img_set_zoom(img, LV_IMG_ZOOM_NONE);
+	lv_obj_align(img, NULL, LV_ALIGN_CENTER, 0, 0);
+	lv_obj_set_hidden(img, false);
+	releaseShown();
+	shown = f;
+	// 当前照片已就绪，后台任务开始预解码相邻一张
+	xTaskNotifyGive(worker);
+}
+
+/**
+ * 切换到第i张：有已解码的完整图像时直接显示，否则显示缩略图并推迟解码完整图像
+ */
+void PhotoAlbum::show(int32_t i)
+{
+	if (count == 0) return;
+	cur = wrap(i, count);
+	setStatus("");
+
+	for (uint8_t k = 0; k < frame_count; k++)
+	{
+		if (frames[k].state == FRAME_READY && frames[k].idx == cur)
+		{
+			want = cur;
+			showFull(&frames[k]);
+			lv_task_set_prio(full_task, LV_TASK_PRIO_OFF);
+			lv_task_reset(thumb_task);
+			lv_task_set_prio(thumb_task, LV_TASK_PRIO_LOW);
+			return;
+		}
+	}
+
+	// 停止预解码，正在解码的照片（多半就是这一张）继续进行
+	want = -1;
+	AlbumThumb* t = loadThumb(cur);
+	if (t)
+	{
+		// 放大到长边等于屏幕（LVGL缩放以256为1倍）
+		uint16_t m = LV_MATH_MAX(t->dsc.header.w, t->dsc.header.h);
+		lv_img_set_src(img, &t->dsc);
+		lv_img_set_zoom(img, LV_IMG_ZOOM_NONE * LV_HOR_RES_MAX / m);
+		lv_obj_align(img, NULL, LV_ALIGN_CENTER, 0, 0);
+		lv_obj_set_hidden(img, false);
+	}
+	else lv_obj_set_hidden(img, true);
+	releaseShown();
+
+	lv_task_reset(full_task);
+	lv_task_set_prio(full_task, LV_TASK_PRIO_MID);
+	lv_task_reset(thumb_task);
+	lv_task_set_prio(thumb_task, LV_TASK_PRIO_LOW);
+}
+
+void PhotoAlbum::keyCb(lv_obj_t* obj, lv_event_t event)
+{
+	if (event != LV_EVENT_KEY) return;
+	uint32_t key = *(const uint32_t*)lv_event_get_data();
+	if (album.viewer.isOpen())
+	{
+		// 查看时左右倾斜用于平移，按下放大一级，第0级时回到总览
+		if (key != LV_KEY_ENTER) return;
+		uint8_t l = album.viewer.getLevel();
+		if (l == 0) album.exitViewer();
+		else album.viewer.setLevel(l - 1);
+		return;
+	}
+	if (key == LV_KEY_ENTER)
+	{
+		album.enterViewer();
+		return;
+	}
+	int8_t dir = key == LV_KEY_RIGHT ? 1 : (key == LV_KEY_LEFT ? -1 : 0);
+	if (dir == 0 || album.count == 0) return;
+	album.last_dir = dir;
+	album.show(album.cur + dir);
+}
+
+/**
+ * 当前照片为分块大图时进入查看器（从倒数第二级开始）
+ * 显示中的帧缓冲借作视口，退出时作废；没有时由查看器自行分配
+ */
+bool PhotoAlbum::enterViewer()
+{
+	AlbumIndexEntry e;
+	if (count == 0 || !getEntry(cur, &e) || e.format != ALBUM_FORMAT_TILED || e.levels < 2) return false;
+	char path[ALBUM_PATH_MAX];
+	photoPath(path, e.name);
+	uint32_t frame_size = (uint32_t)LV_HOR_RES_MAX * LV_VER_RES_MAX * sizeof(lv_color_t);
+	lv_color_t* buf = shown ? (lv_color_t*)shown->buf : NULL;
+	if (!viewer.open(path, scr, e.levels - 2, buf, buf ? frame_size : 0))
+	{
+		setStatus("Not enough memory");
+		return false;
+	}
+	lv_obj_set_hidden(img, true);
+	setStatus("");
+	viewer.setTilt(true);
+	return true;
+}
+
+void PhotoAlbum::exitViewer()
+{
+	uint32_t decodes, hits;
+	viewer.getStats(&decodes, &hits);
+	LOG_D("album", "查看器: 解码%u块，缓存命中%u次", decodes, hits);
+	viewer.close();
+	// 帧缓冲已被视口覆盖
+	releaseShown();
+	show(cur);
+}
+
+/**
+ * 翻页后停留ALBUM_FULL_DELAY_MS：请求解码完整图像（一次性）
+ */
+void PhotoAlbum::fullTaskCb(lv_task_t* t)
+{
+	PhotoAlbum* self = (PhotoAlbum*)t->user_data;
+	lv_task_set_prio(t, LV_TASK_PRIO_OFF);
+	if (self->count == 0 || self->viewer.isOpen()) return;
+
+	if (self->frame_count == 0)
+	{
+		// 没有帧缓冲：交给LVGL的S:解码器（刷新时解码，大于屏幕的部分被裁掉；分块大图只显示缩略图）
+		AlbumIndexEntry e;
+		if (!self->getEntry(self->cur, &e) || e.format == ALBUM_FORMAT_TILED) return;
+		snprintf(self->lv_path, sizeof(self->lv_path), "S:%s/%s", ALBUM_ROOT, e.name);
+		lv_img_set_src(self->img, self->lv_path);
+		lv_img_set_zoom(self->img, LV_IMG_ZOOM_NONE);
+		lv_obj_align(self->img, NULL, LV_ALIGN_CENTER, 0, 0);
+		lv_obj_set_hidden(self->img, false);
+		return;
+	}
+	self->want = self->cur;
+	xTaskNotifyGive(self->worker);
+}
+
+void PhotoAlbum::thumbTaskCb(lv_task_t* t)
+{
+	PhotoAlbum* self = (PhotoAlbum*)t->user_data;
+	lv_task_set_prio(t, LV_TASK_PRIO_OFF);
+	self->prefetchThumbs();
+}
+
+void PhotoAlbum::onFrameReady(const UiMsg* msg)
+{
+	if (!album.isRunning() || album.viewer.isOpen()) return;
+	AlbumFrame* f = (AlbumFrame*)msg->obj;
+	if (msg->value == album.cur && album.shown != f) album.showFull(f);
+}
+
+/**
+ * 新生成的缩略图：当前照片还没有显示任何图像时显示它
+ */
+void PhotoAlbum::onThumbReady(const UiMsg* msg)
+{
+	if (!album.isRunning() || album.viewer.isOpen() || msg->value != album.cur) return;
+	if (album.shown == NULL && lv_obj_get_hidden(album.img)) album.show(album.cur);
+}
+
+/**
+ * 索引重建完成：有照片增删或修改时重新显示（总数变化时回到第一张）
+ */
+void PhotoAlbum::onIndexReady(const UiMsg* msg)
+{
+	if (!album.isRunning()) return;
+	if (album.viewer.isOpen())
+	{
+		album.viewer.close();
+		album.releaseShown();
+	}
+	uint32_t prev = album.count;
+	album.count = album.readCount();
+	if (album.count == 0)
+	{
+		lv_obj_set_hidden(album.img, true);
+		album.releaseShown();
+		album.setStatus("No photos in " ALBUM_ROOT);
+		return;
+	}
+	if (!msg->value && album.count == prev) return;
+
+	// 条目顺序可能已变化，缩略图槽与预解码结果全部作废
+	for (uint8_t k = 0; k < 2 * ALBUM_THUMB_AHEAD + 1; k++) album.thumbs[k].idx = -1;
+	portENTER_CRITICAL(&album_mux);
+	for (uint8_t k = 0; k < album.frame_count; k++)
+	{
+		if (album.frames[k].state != FRAME_READY) continue;
+		album.frames[k].state = FRAME_FREE;
+		album.frames[k].idx = -1;
+	}
+	portEXIT_CRITICAL(&album_mux);
+	album.show(album.count == prev ? album.cur : 0);
+}
+
+/**** 应用入口 ****/
+
+const App album_app = {
+	"album",
+	[](void* u) { album.start(); },
+	NULL,
+	NULL,
+	[](void* u) { album.stop(); },
+	48 * 1024, 0, 0, 0, NULL
+};
@@ -0,0 +1,259 @@
+/*
+ * HoloCubic 电源管理模块
+ *
+ * 功能说明：
+ * 1. 通过esp_pm启用动态调频（80~240MHz），LVGL任务处理一帧时升到最高频率，休眠等待期间降频
+ * 2. 待机时允许自动浅睡眠，CPU在帧间与传感器采样间隙进入浅睡眠，由esp_timer/任务超时唤醒
+ * 3. 无操作一段时间后先调暗背光，再关闭背光并把界面刷新降到最低频率
+ * 4. 编码器/手势事件、IMU检测到移动、环境光明显变化时恢复正常亮度
+ * 5. 待机时IMU停止读取，改为片上运动检测（IMU::suspend），检测到移动后在传感器任务中立即唤醒
+ *
+ * 注意事项：
+ * - Arduino预编译的sdkconfig未开启tickless idle时esp_pm_configure拒绝浅睡眠，
+ *   此时退回仅动态调频；未开启CONFIG_PM_ENABLE时退回待机降频（setCpuFrequencyMhz）
+ * - 要真正浅睡眠需以arduino-esp32作为IDF组件编译，sdkconfig中开启CONFIG_PM_ENABLE、
+ *   CONFIG_FREERTOS_USE_TICKLESS_IDLE（CONFIG_FREERTOS_IDLE_TIME_BEFORE_SLEEP保持默认3个tick）
+ * - 空闲时没有周期唤醒：LVGL任务阻塞到下一个lv_task截止时间，loop任务已删除，
+ *   背光稳定后停止渐变定时器，传感器任务等待中断或采样超时
+ * - 最低频率保持80MHz：APB时钟固定为80MHz，TFT_eSPI直接写寄存器的SPI、I2C与串口波特率不受影响
+ */
+
+#include "power.h"
+#include "runtime.h"
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+
+/**
+ * 启动电源管理
+ *
+ * @param bl     背光（调暗/关闭/恢复）
+ * @param amb    环境光传感器，NULL时不检测照度变化
+ * @param sensor IMU，NULL时不检测移动
+ * @return 定时器创建失败返回false（此时只有调频生效，不会进入待机）
+ */
+bool PowerManager::begin(Backlight* bl, Ambient* amb, IMU* sensor)
+{
+	backlight = bl;
+	ambient = amb;
+	imu = sensor;
+	state = POWER_ACTIVE;
+	last_activity = millis();
+	memset(last_accel, 0, sizeof(last_accel));
+	ref_lux = 0;
+	mutex = xSemaphoreCreateMutex();
+
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+	bool light = POWER_LIGHT_SLEEP;
+#else
+	// 未编译tickless idle时esp_pm_configure必定拒绝浅睡眠，直接只开调频
+	bool light = false;
+	Serial.println("sdkconfig未开启CONFIG_FREERTOS_USE_TICKLESS_IDLE，空闲时不进入浅睡眠");
+#endif
+	pm_enabled = configure(light);
+	if (!pm_enabled && light) pm_enabled = configure(false);
+	if (!pm_enabled)
+	{
+		setCpuFrequencyMhz(POWER_CPU_MAX_MHZ);
+		Serial.println("esp_pm不可用，仅在待机时降频");
+	}
+
+#if CONFIG_PM_ENABLE
+	if (pm_enabled)
+	{
+		esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "ui", &cpu_lock);
+		esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "backlight", &sleep_lock);
+		esp_pm_lock_acquire(sleep_lock);
+	}
+#endif
+
+	// 待机期间的运动中断直接唤醒（不等待下一次检查）
+	if (imu) imu->setMotionCallback(onMotion, this);
+
+	// INT引脚连接时，数据就绪/DMP/运动中断可以把CPU从浅睡眠中唤醒
+	if (IMU_INT_PIN >= 0)
+	{
+		gpio_wakeup_enable((gpio_num_t)IMU_INT_PIN, GPIO_INTR_HIGH_LEVEL);
+		esp_sleep_enable_gpio_wakeup();
+	}
+
+	esp_timer_create_args_t args = {};
+	args.callback = timerCb;
+	args.arg = this;
+	args.name = "power";
+	if (esp_timer_create(&args, &timer) != ESP_OK) return false;
+	return esp_timer_start_periodic(timer, POWER_CHECK_MS * 1000) == ESP_OK;
+}
+
+/**
+ * 配置esp_pm
+ * @return 当前固件不支持（未开启CONFIG_PM_ENABLE或tickless idle）时返回false
+ */
+bool PowerManager::configure(bool light_sleep)
+{
+#if CONFIG_PM_ENABLE
+	esp_pm_config_esp32_t cfg = {};
+	cfg.max_freq_mhz = POWER_CPU_MAX_MHZ;
+	cfg.min_freq_mhz = POWER_CPU_MIN_MHZ;
+	cfg.light_sleep_enable = light_sleep;
+	esp_err_t err = esp_pm_configure(&cfg);
+	if (err == ESP_OK)
+	{
+		Serial.printf("动态调频: %d~%dMHz, 自动浅睡眠%s\n", POWER_CPU_MIN_MHZ, POWER_CPU_MAX_MHZ,
+					  light_sleep ? "开启" : "关闭");
+		return true;
+	}
+	Serial.printf("esp_pm_configure失败: %s\n", esp_err_to_name(err));
+#endif
+	return false;
+}
+
+/**
+ * 用户活动（编码器/手势事件、移动、照度变化），可在任意任务中调用
+ * 调暗或待机状态下立即恢复
+ */
+void PowerManager::activity()
+{
+	last_activity = millis();
+	if (state != POWER_ACTIVE && mutex)
+	{
+		xSemaphoreTake(mutex, portMAX_DELAY);
+		if (state != POWER_ACTIVE) exitIdle();
+		xSemaphoreGive(mutex);
+	}
+}
+
+/**
+ * LVGL任务开始处理时调用：升到最高频率
+ */
+void PowerManager::busyBegin()
+{
+#if CONFIG_PM_ENABLE
+	if (pm_enabled) esp_pm_lock_acquire(cpu_lock);
+#endif
+}
+
+/**
+ * LVGL任务进入休眠等待前调用：允许降频
+ */
+void PowerManager::busyEnd()
+{
+#if CONFIG_PM_ENABLE
+	if (pm_enabled) esp_pm_lock_release(cpu_lock);
+#endif
+}
+
+PowerState PowerManager::getState()
+{
+	return state;
+}
+
+/**
+ * 调暗背光，保存当前亮度设定以便恢复
+ */
+void PowerManager::enterDim()
+{
+	saved_auto = backlight->isAuto();
+	saved_duty = backlight->getTarget();
+	backlight->setManual(min(POWER_DIM_DUTY, backlight->getDuty()));
+	ref_lux = ambient != NULL ? ambient->getLux() : 0;
+	state = POWER_DIM;
+}
+
+/**
+ * 关闭背光、降低界面刷新频率，释放浅睡眠锁
+ */
+void PowerManager::enterStandby()
+{
+	backlight->suspend();
+	runtime.setStandby(true);
+	if (imu) imu->suspend();
+#if CONFIG_PM_ENABLE
+	if (pm_enabled) esp_pm_lock_release(sleep_lock);
+#endif
+	if (!pm_enabled) setCpuFrequencyMhz(POWER_CPU_MIN_MHZ);
+	state = POWER_STANDBY;
+	Serial.println("进入待机");
+}
+
+/**
+ * 从调暗/待机恢复到保存的亮度设定
+ */
+void PowerManager::exitIdle()
+{
+	if (state == POWER_STANDBY)
+	{
+		if (!pm_enabled) setCpuFrequencyMhz(POWER_CPU_MAX_MHZ);
+#if CONFIG_PM_ENABLE
+		if (pm_enabled) esp_pm_lock_acquire(sleep_lock);
+#endif
+		if (imu) imu->resume();
+		runtime.setStandby(false);
+		backlight->resume();
+	}
+	if (saved_auto) backlight->setAuto(true);
+	else backlight->setManual(saved_duty);
+	state = POWER_ACTIVE;
+}
+
+/**
+ * 任一轴加速度相对上次检查的变化超过阈值
+ * 只读取传感器总线的快照（三轴来自同一样本），不访问I2C总线
+ */
+bool PowerManager::checkMotion()
+{
+	SensorSample s;
+	if (imu == NULL || !sensorbus.get(SENSOR_IMU, &s)) return false;
+
+	bool moved = false;
+	for (uint8_t i = 0; i < 3; i++)
+	{
+		if (abs(s.accel[i] - last_accel[i]) > POWER_MOTION_DELTA) moved = true;
+		last_accel[i] = s.accel[i];
+	}
+	return moved;
+}
+
+/**
+ * 照度相对进入调暗时的变化超过阈值
+ */
+bool PowerManager::checkLux()
+{
+	if (ambient == NULL || !ambient->available()) return false;
+
+	unsigned int lux = ambient->getLux();
+	unsigned int diff = lux > ref_lux ? lux - ref_lux : ref_lux - lux;
+	return diff > POWER_LUX_DELTA;
+}
+
+/**
+ * 待机期间IMU检测到移动（传感器任务中执行）
+ */
+void PowerManager::onMotion(void* arg)
+{
+	((PowerManager*)arg)->activity();
+}
+
+void PowerManager::timerCb(void* arg)
+{
+	((PowerManager*)arg)->check();
+}
+
+/**
+ * 周期检查（esp_timer任务中执行）
+ * 移动检测在所有状态下进行，正常状态下移动同样推迟调暗
+ */
+void PowerManager::check()
+{
+	bool moved = checkMotion();
+	if (moved || (state != POWER_ACTIVE && checkLux()))
+	{
+		activity();
+		return;
+	}
+
+	uint32_t idle = millis() - last_activity;
+	xSemaphoreTake(mutex, portMAX_DELAY);
+	if (state == POWER_ACTIVE && idle >= POWER_DIM_MS) enterDim();
+	if (state == POWER_DIM && idle >= POWER_STANDBY_MS) enterStandby();
+	xSemaphoreGive(mutex);
+}
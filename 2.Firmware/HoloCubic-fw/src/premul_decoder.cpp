@@ -0,0 +1,279 @@
+/*
+ * HoloCubic 预乘alpha图像模块
+ *
+ * 功能说明：
+ * 1. premul_decoder_draw：lv_draw_img.c的钩子，按行偏移找到每行的片段，
+ *    全透明片段跳过、不透明片段复制、半透明片段用预乘混合核（IRAM）写入绘制缓冲
+ * 2. 整体不透明度（draw_dsc->opa）小于LV_OPA_MAX时源颜色与alpha同时乘以opa，仍按片段处理
+ * 3. LVGL解码器：不满足直接绘制条件时按行还原为LV_IMG_CF_TRUE_COLOR_ALPHA（颜色除以alpha）
+ *
+ * 混合核：红蓝两个分量拆开放在一个32位数中（000R RRRR 0000 0000 0000 0000 000B BBBB）与绿色各乘一次8位权重。
+ * 目标乘以(255 - a) / 256（向下取整），预乘颜色为floor(c * a / 255)，
+ * 两者之和不会超过分量最大值，相加时没有进位，不需要逐分量饱和。
+ */
+
+#include "premul_decoder.h"
+#include <esp_attr.h>
+#include <string.h>
+#if LV_USE_DRAW_SPLIT
+#include "draw_split.h"
+#endif
+
+/**
+ * 一次绘制：clip为图像与绘制区域的交集（绝对坐标），buf按绘制缓冲的区域寻址
+ */
+struct PremulDraw
+{
+	const uint8_t* data;
+	lv_area_t coords;
+	lv_area_t clip;
+	lv_color_t* buf;
+	const lv_area_t* buf_area;
+	lv_coord_t buf_w;
+	bool cover;                // 整体不透明度不小于LV_OPA_MAX
+	uint32_t opa;              // 整体不透明度
+};
+
+/**
+ * 图像中的像素值（lv_color_t）与本机字节序RGB565互换
+ */
+static inline uint16_t native565(uint16_t c)
+{
+#if LV_COLOR_16_SWAP
+	return (c >> 8) | (c << 8);
+#else
+	return c;
+#endif
+}
+
+/**
+ * c * w / 256（各分量向下取整），w为0~256
+ */
+static inline uint16_t scale565(uint16_t c, uint32_t w)
+{
+	uint32_t rb = ((((uint32_t)c & 0xF800) << 5) | (c & 0x1F)) * w;
+	uint32_t g = ((uint32_t)c & 0x07E0) * w;
+	return (uint16_t)(((rb >> 13) & 0xF800) | ((g >> 8) & 0x07E0) | ((rb >> 8) & 0x1F));
+}
+
+/**
+ * 半透明片段（整体不透明度为COVER）：dst = src + dst * (255 - a) / 256
+ */
+static void IRAM_ATTR blendSpan(lv_color_t* dst, const lv_color_t* src, const uint8_t* alpha, int32_t n)
+{
+	for (int32_t i = 0; i < n; i++)
+	{
+		uint16_t d = scale565(native565(dst[i].full), 255 - alpha[i]);
+		dst[i].full = native565(native565(src[i].full) + d);
+	}
+}
+
+/**
+ * 整体不透明度opa：src乘以opa / 256，dst乘以1 - a * opa / 255（向上取整到1/256，保证不进位）
+ * alpha为NULL时为不透明片段（a = 255）
+ */
+static void IRAM_ATTR blendSpanOpa(lv_color_t* dst, const lv_color_t* src, const uint8_t* alpha, int32_t n, uint32_t opa)
+{
+	for (int32_t i = 0; i < n; i++)
+	{
+		uint32_t k = alpha ? ((alpha[i] + 1) * opa + 255) >> 8 : opa;
+		uint16_t s = scale565(native565(src[i].full), opa);
+		uint16_t d = scale565(native565(dst[i].full), 256 - k);
+		dst[i].full = native565(s + d);
+	}
+}
+
+static const uint8_t* rowData(const uint8_t* data, lv_coord_t y)
+{
+	uint32_t off;
+	memcpy(&off, data + PREMUL_MAGIC_SIZE + y * sizeof(uint32_t), sizeof(off));
+	return data + off;
+}
+
+/**
+ * 片段的字节数（不含片段头）
+ */
+static inline uint32_t spanBytes(uint16_t head)
+{
+	uint32_t n = PREMUL_SPAN_LEN(head);
+	if (PREMUL_SPAN_TYPE(head) == PREMUL_SPAN_COPY) return n * sizeof(lv_color_t);
+	if (PREMUL_SPAN_TYPE(head) == PREMUL_SPAN_BLEND) return n * sizeof(lv_color_t) + ((n + 1) & ~1U);
+	return 0;
+}
+
+/**
+ * 绘制clip中的第y1行到第y2行（相对于clip.y1），可在draw_split的工作任务中执行
+ */
+static void IRAM_ATTR drawRows(void* ctx, int32_t y1, int32_t y2)
+{
+	const PremulDraw* d = (const PremulDraw*)ctx;
+	for (int32_t y = d->clip.y1 + y1; y <= d->clip.y1 + y2; y++)
+	{
+		const uint8_t* p = rowData(d->data, y - d->coords.y1);
+		// 按绝对x坐标寻址的一行绘制缓冲
+		lv_color_t* row = d->buf + (y - d->buf_area->y1) * d->buf_w - d->buf_area->x1;
+		lv_coord_t x = d->coords.x1;
+		while (x <= d->clip.x2)
+		{
+			uint16_t head = *(const uint16_t*)p;
+			uint16_t n = PREMUL_SPAN_LEN(head);
+			if (n == 0) break;
+			const lv_color_t* src = (const lv_color_t*)(p + sizeof(uint16_t));
+			p += sizeof(uint16_t) + spanBytes(head);
+
+			lv_coord_t a1 = LV_MATH_MAX(x, d->clip.x1);
+			lv_coord_t a2 = LV_MATH_MIN(x + n - 1, d->clip.x2);
+			uint8_t type = PREMUL_SPAN_TYPE(head);
+			if (a1 <= a2 && type != PREMUL_SPAN_SKIP)
+			{
+				int32_t skip = a1 - x;
+				int32_t len = a2 - a1 + 1;
+				const uint8_t* alpha = type == PREMUL_SPAN_BLEND ? (const uint8_t*)(src + n) + skip : NULL;
+				if (d->cover)
+				{
+					if (alpha) blendSpan(row + a1, src + skip, alpha, len);
+					else memcpy(row + a1, src + skip, len * sizeof(lv_color_t));
+				}
+				else
+				{
+					blendSpanOpa(row + a1, src + skip, alpha, len, d->opa);
+				}
+			}
+			x += n;
+		}
+	}
+}
+
+bool premul_is_image(const lv_img_dsc_t* img)
+{
+	return LV_COLOR_DEPTH == 16 && img->header.cf == LV_IMG_CF_RAW_ALPHA && img->data != NULL &&
+		   img->data_size >= PREMUL_MAGIC_SIZE + img->header.h * sizeof(uint32_t) &&
+		   memcmp(img->data, PREMUL_MAGIC, PREMUL_MAGIC_SIZE) == 0;
+}
+
+/**
+ * 直接从片段混合到绘制缓冲
+ * 有缩放/旋转、重新着色、其他遮罩、非普通混合模式或显示驱动逐点写入（set_px_cb）时返回false
+ */
+bool premul_decoder_draw(const void* src, const lv_area_t* coords, const lv_area_t* clip_area,
+						 const lv_draw_img_dsc_t* draw_dsc)
+{
+	if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) return false;
+	const lv_img_dsc_t* img = (const lv_img_dsc_t*)src;
+	if (!premul_is_image(img)) return false;
+	if (draw_dsc->angle != 0 || draw_dsc->zoom != LV_IMG_ZOOM_NONE || draw_dsc->recolor_opa != LV_OPA_TRANSP ||
+		draw_dsc->blend_mode != LV_BLEND_MODE_NORMAL || lv_draw_mask_get_cnt() != 0)
+	{
+		return false;
+	}
+	if (lv_area_get_width(coords) != img->header.w || lv_area_get_height(coords) != img->header.h) return false;
+
+	lv_disp_t* disp = _lv_refr_get_disp_refreshing();
+	if (disp->driver.set_px_cb) return false;
+
+	PremulDraw d;
+	if (!_lv_area_intersect(&d.clip, clip_area, coords)) return true;
+	lv_disp_buf_t* vdb = lv_disp_get_buf(disp);
+	d.data = img->data;
+	d.coords = *coords;
+	d.buf = (lv_color_t*)vdb->buf_act;
+	d.buf_area = &vdb->area;
+	d.buf_w = lv_area_get_width(&vdb->area);
+	d.cover = draw_dsc->opa >= LV_OPA_MAX;
+	d.opa = draw_dsc->opa;
+
+	int32_t rows = lv_area_get_height(&d.clip);
+#if LV_USE_DRAW_SPLIT
+	if (rows >= 2 && draw_split_ready(lv_area_get_size(&d.clip)))
+	{
+		draw_split_run(drawRows, &d, rows);
+		return true;
+	}
+#endif
+	drawRows(&d, 0, rows - 1);
+	return true;
+}
+
+static lv_res_t premul_lv_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+	if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+
+	const lv_img_dsc_t* img = (const lv_img_dsc_t*)src;
+	if (!premul_is_image(img)) return LV_RES_INV;
+
+	// 保留LV_IMG_CF_RAW_ALPHA：lv_img按带透明处理，不会被当作可直接拷贝的真彩色数据
+	*header = img->header;
+	return LV_RES_OK;
+}
+
+static lv_res_t premul_lv_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	if (dsc->src_type != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+	if (!premul_is_image((const lv_img_dsc_t*)dsc->src)) return LV_RES_INV;
+
+	dsc->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+	dsc->img_data = NULL;       // 直接绘制时不经过解码器；需要LVGL逐像素处理时调用read_line
+	dsc->user_data = NULL;
+	return LV_RES_OK;
+}
+
+/**
+ * 读取一行中[x, x+len)的像素，按LV_IMG_CF_TRUE_COLOR_ALPHA输出（颜色低字节、高字节、alpha）
+ * 片段可以从任意行开始解析，不需要保存状态
+ */
+static lv_res_t LV_ATTRIBUTE_HOT premul_lv_read_line(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc,
+									lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t* buf)
+{
+	const lv_img_dsc_t* img = (const lv_img_dsc_t*)dsc->src;
+	if (y < 0 || y >= img->header.h || x < 0 || len <= 0 || x + len > img->header.w) return LV_RES_INV;
+
+	const uint8_t* p = rowData(img->data, y);
+	lv_coord_t end = x + len;
+	for (lv_coord_t sx = 0; sx < end;)
+	{
+		uint16_t head = *(const uint16_t*)p;
+		uint16_t n = PREMUL_SPAN_LEN(head);
+		if (n == 0) return LV_RES_INV;
+		const lv_color_t* src = (const lv_color_t*)(p + sizeof(uint16_t));
+		const uint8_t* alpha = (const uint8_t*)(src + n);
+		p += sizeof(uint16_t) + spanBytes(head);
+
+		for (lv_coord_t i = LV_MATH_MAX(sx, x); i < sx + n && i < end; i++)
+		{
+			uint8_t* out = buf + (i - x) * LV_IMG_PX_SIZE_ALPHA_BYTE;
+			uint16_t c = 0;
+			uint8_t a = 0;
+			if (PREMUL_SPAN_TYPE(head) == PREMUL_SPAN_COPY)
+			{
+				c = src[i - sx].full;
+				a = LV_OPA_COVER;
+			}
+			else if (PREMUL_SPAN_TYPE(head) == PREMUL_SPAN_BLEND && alpha[i - sx] != 0)
+			{
+				a = alpha[i - sx];
+				uint16_t v = native565(src[i - sx].full);
+				uint32_t r = LV_MATH_MIN(((v >> 11) * 255 + a / 2) / a, 0x1F);
+				uint32_t g = LV_MATH_MIN((((v >> 5) & 0x3F) * 255 + a / 2) / a, 0x3F);
+				uint32_t b = LV_MATH_MIN(((v & 0x1F) * 255 + a / 2) / a, 0x1F);
+				c = native565((uint16_t)((r << 11) | (g << 5) | b));
+			}
+			out[0] = c & 0xFF;
+			out[1] = c >> 8;
+			out[2] = a;
+		}
+		sx += n;
+	}
+	return LV_RES_OK;
+}
+
+/**
+ * 注册预乘alpha图像解码器
+ * 新解码器插入列表头部，优先于内置解码器尝试
+ */
+void premul_decoder_lv_init(void)
+{
+	lv_img_decoder_t* dec = lv_img_decoder_create();
+	lv_img_decoder_set_info_cb(dec, premul_lv_info);
+	lv_img_decoder_set_open_cb(dec, premul_lv_open);
+	lv_img_decoder_set_read_line_cb(dec, premul_lv_read_line);
+}
@@ -0,0 +1,461 @@
+/*
+ * HoloCubic 绘制原语微基准
+ *
+ * 功能说明：
+ * 1. 每个原语按参数表逐组调用，CCOUNT计周期（240MHz下每周期约4.2纳秒），不经过对象、样式与刷新调度
+ * 2. 绘制原语写入片内画布：临时把显示缓冲区的buf_act/area换成画布，并把画布所在的显示设为正在刷新的显示，
+ *    _lv_blend_*按正常路径取得目标缓冲区
+ * 3. 刷新回调直接用显示缓冲区调用flush_cb，等待flushing清零与DMA/队列发送完成
+ * 4. 冷缓存：每次调用前顺序读取运行中的应用分区的一段映射（按缓存行步进），代码、字模与常量随之被挤出
+ *
+ * 数据流：
+ *   run --> runBlend/runLabel/runRect/runImg（画布） --> runFlush（显示缓冲区） --> measure：warm/cold --> emit：串口 + CSV
+ *
+ * 注意事项：
+ * - 阴影的角部缓存（LV_SHADOW_CACHE_NUM）在冷缓存时不清除，阴影宽度大于缓存尺寸的组每次重新计算
+ * - 小于合并阈值的刷新区域在flush_cb中暂存，因为flushing_last为1而立即写出，计时包含合并的开销
+ */
+
+#include "prim_bench.h"
+#include "buf_manager.h"
+#include "guider_fonts.h"
+#include "sd_card.h"
+#include "logger.h"
+#include <esp_ota_ops.h>
+#include <xtensa/hal.h>
+
+#define TXT_LONG "hello world\nit is a multi line text to test\nthe performance of text rendering"
+
+/**
+ * 一组参数
+ */
+struct PrimCase
+{
+	const char* prim;
+	char params[48];
+	uint32_t units;            // 处理的像素数（label为字符数），用于每单位周期数
+	const char* unit;
+	lv_area_t clip;
+	lv_area_t area;
+	lv_opa_t opa;
+	const void* src;           // blend_map的像素 / 图像源
+	lv_draw_label_dsc_t label;
+	lv_draw_rect_dsc_t rect;
+	lv_draw_img_dsc_t img;
+	const char* text;
+	lv_disp_drv_t* drv;        // 刷新
+	lv_disp_buf_t* vdb;
+	lv_color_t* px;
+	Display* screen;
+};
+
+PrimBench primbench;
+
+static lv_img_dsc_t img_dsc;
+static volatile uint32_t evict_sink;
+
+PrimBench::PrimBench()
+{
+	screen = NULL;
+	disp = NULL;
+	vdb = NULL;
+	canvas = NULL;
+	img_buf = NULL;
+	evict_src = NULL;
+	evict_map = 0;
+	rows = 0;
+}
+
+/**** 原语 ****/
+
+static void fill_fn(const PrimCase* c)
+{
+	_lv_blend_fill(&c->clip, &c->area, LV_COLOR_MAKE(0x20, 0x80, 0xE0), NULL, LV_DRAW_MASK_RES_FULL_COVER, c->opa,
+				   LV_BLEND_MODE_NORMAL);
+}
+
+static void map_fn(const PrimCase* c)
+{
+	_lv_blend_map(&c->clip, &c->area, (const lv_color_t*)c->src, NULL, LV_DRAW_MASK_RES_FULL_COVER, c->opa,
+				  LV_BLEND_MODE_NORMAL);
+}
+
+static void label_fn(const PrimCase* c)
+{
+	lv_draw_label(&c->area, &c->clip, &c->label, c->text, NULL);
+}
+
+static void rect_fn(const PrimCase* c)
+{
+	lv_draw_rect(&c->area, &c->clip, &c->rect);
+}
+
+static void img_fn(const PrimCase* c)
+{
+	lv_draw_img(&c->area, &c->clip, c->src, &c->img);
+}
+
+static void flush_fn(const PrimCase* c)
+{
+	// 与lv_refr_vdb_flush相同：置flushing后调用，等待刷新回调（或SPI中断）清零
+	c->vdb->flushing = 1;
+	c->vdb->flushing_last = 1;
+	c->drv->flush_cb(c->drv, &c->area, c->px);
+	while (c->vdb->flushing) {}
+	c->screen->frameWait();
+}
+
+/**** 计时 ****/
+
+/**
+ * 读取PRIM_BENCH_EVICT_BYTES的flash映射，每个缓存行读一个字节
+ */
+void PrimBench::evict()
+{
+	uint32_t sum = 0;
+	for (uint32_t i = 0; i < PRIM_BENCH_EVICT_BYTES; i += PRIM_BENCH_CACHE_LINE) sum += evict_src[i];
+	evict_sink = sum;
+	lv_img_cache_invalidate_src(&img_dsc);
+}
+
+void PrimBench::measure(const PrimCase* c, prim_bench_fn_t fn)
+{
+	uint32_t cycles[PRIM_BENCH_ITERS];
+
+	fn(c);
+	for (uint8_t i = 0; i < PRIM_BENCH_ITERS; i++)
+	{
+		uint32_t t0 = xthal_get_ccount();
+		fn(c);
+		cycles[i] = xthal_get_ccount() - t0;
+	}
+	emit(c, "warm", cycles);
+
+	if (evict_src)
+	{
+		for (uint8_t i = 0; i < PRIM_BENCH_ITERS; i++)
+		{
+			evict();
+			uint32_t t0 = xthal_get_ccount();
+			fn(c);
+			cycles[i] = xthal_get_ccount() - t0;
+		}
+		emit(c, "cold", cycles);
+	}
+	// 让出CPU（空闲任务喂看门狗）
+	vTaskDelay(1);
+}
+
+void PrimBench::emit(const PrimCase* c, const char* cache, uint32_t* cycles)
+{
+	for (uint8_t i = 1; i < PRIM_BENCH_ITERS; i++)
+	{
+		uint32_t v = cycles[i];
+		int8_t j = i - 1;
+		while (j >= 0 && cycles[j] > v)
+		{
+			cycles[j + 1] = cycles[j];
+			j--;
+		}
+		cycles[j + 1] = v;
+	}
+	uint32_t min = cycles[0];
+	uint32_t med = cycles[PRIM_BENCH_ITERS / 2];
+	float per = c->units ? (float)min / c->units : 0;
+
+	Serial.printf("PRIMBENCH,%s,%s,%u,%s,%u,%u,%.2f\n", c->prim, c->params, c->units, cache, min, med, per);
+	if (csv)
+	{
+		csv.printf("%s,%d.%d.%d,%u,%s,%s,%u,%s,%s,%u,%u,%u,%.2f\n", PRIM_BENCH_BUILD_ID, LVGL_VERSION_MAJOR,
+				   LVGL_VERSION_MINOR, LVGL_VERSION_PATCH, getCpuFrequencyMhz(), c->prim, c->params, c->units, c->unit,
+				   cache, PRIM_BENCH_ITERS, min, med, per);
+		rows++;
+	}
+}
+
+/**
+ * 显示缓冲区换成画布（画布所在的显示设为正在刷新的显示）
+ */
+void PrimBench::beginCanvas(void** saved_buf, lv_area_t* saved_area, lv_disp_t** saved_refr)
+{
+	while (vdb->flushing) {}
+	screen->frameWait();
+	*saved_buf = vdb->buf_act;
+	*saved_area = vdb->area;
+	*saved_refr = _lv_refr_get_disp_refreshing();
+	vdb->buf_act = canvas;
+	lv_area_set(&vdb->area, 0, 0, PRIM_BENCH_CANVAS_W - 1, PRIM_BENCH_CANVAS_H - 1);
+	_lv_refr_set_disp_refreshing(disp);
+}
+
+void PrimBench::endCanvas(void* saved_buf, const lv_area_t* saved_area, lv_disp_t* saved_refr)
+{
+	vdb->buf_act = saved_buf;
+	vdb->area = *saved_area;
+	_lv_refr_set_disp_refreshing(saved_refr);
+}
+
+/**
+ * 以画布为裁剪区域、area居中的一组参数
+ */
+static void case_init(PrimCase* c, const char* prim, lv_coord_t w, lv_coord_t h)
+{
+	memset(c, 0, sizeof(*c));
+	c->prim = prim;
+	c->unit = "px";
+	c->units = (uint32_t)w * h;
+	lv_area_set(&c->clip, 0, 0, PRIM_BENCH_CANVAS_W - 1, PRIM_BENCH_CANVAS_H - 1);
+	lv_coord_t x = (PRIM_BENCH_CANVAS_W - w) / 2;
+	lv_coord_t y = (PRIM_BENCH_CANVAS_H - h) / 2;
+	lv_area_set(&c->area, x, y, x + w - 1, y + h - 1);
+}
+
+/**
+ * _lv_blend_fill / _lv_blend_map：尺寸 x 不透明度（map的源为测试图像，最大PRIM_BENCH_IMG_SIZE见方）
+ */
+void PrimBench::runBlend()
+{
+	static const lv_coord_t sizes[][2] = {
+		{ 8, 8 }, { 32, 32 }, { 64, 64 }, { PRIM_BENCH_CANVAS_W, 1 }, { PRIM_BENCH_CANVAS_W, PRIM_BENCH_CANVAS_H }
+	};
+	static const lv_opa_t opas[] = { LV_OPA_COVER, LV_OPA_50 };
+	PrimCase c;
+
+	for (uint8_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		for (uint8_t o = 0; o < sizeof(opas) / sizeof(opas[0]); o++)
+		{
+			case_init(&c, "blend_fill", sizes[s][0], sizes[s][1]);
+			c.opa = opas[o];
+			snprintf(c.params, sizeof(c.params), "w=%d h=%d opa=%u", sizes[s][0], sizes[s][1], opas[o]);
+			measure(&c, fill_fn);
+
+			if ((uint32_t)sizes[s][0] * sizes[s][1] > PRIM_BENCH_IMG_SIZE * PRIM_BENCH_IMG_SIZE) continue;
+			case_init(&c, "blend_map", sizes[s][0], sizes[s][1]);
+			c.opa = opas[o];
+			c.src = img_buf;
+			snprintf(c.params, sizeof(c.params), "w=%d h=%d opa=%u", sizes[s][0], sizes[s][1], opas[o]);
+			measure(&c, map_fn);
+		}
+	}
+}
+
+/**
+ * lv_draw_label：字体 x 文字（单位为不含换行的字符数）
+ */
+void PrimBench::runLabel()
+{
+	struct LabelCase
+	{
+		const lv_font_t* font;
+		const char* font_name;
+		const char* text;
+		const char* text_name;
+	};
+	static const LabelCase cases[] = {
+		{ &lv_font_montserrat_14, "montserrat14", "12:34", "short" },
+		{ &lv_font_montserrat_14, "montserrat14", "hello world", "line" },
+		{ &lv_font_montserrat_14, "montserrat14", TXT_LONG, "multi" },
+		{ &lv_font_simsun_12, "simsun12", "hello world", "line" },
+		{ &lv_font_simsun_12, "simsun12", TXT_LONG, "multi" },
+		{ &lv_font_montserrat_48, "montserrat48", "12:34", "short" },
+	};
+	PrimCase c;
+
+	for (uint8_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+	{
+		case_init(&c, "draw_label", PRIM_BENCH_CANVAS_W, PRIM_BENCH_CANVAS_H);
+		lv_draw_label_dsc_init(&c.label);
+		c.label.font = cases[i].font;
+		c.label.color = LV_COLOR_WHITE;
+		c.text = cases[i].text;
+		c.unit = "glyph";
+		c.units = 0;
+		for (const char* p = c.text; *p; p++)
+		{
+			if (*p != '\n') c.units++;
+		}
+		snprintf(c.params, sizeof(c.params), "font=%s text=%s", cases[i].font_name, cases[i].text_name);
+		measure(&c, label_fn);
+	}
+}
+
+/**
+ * lv_draw_rect：尺寸 x 圆角 x 阴影（阴影超出画布的部分被裁剪，单位为矩形本身的像素数）
+ */
+void PrimBench::runRect()
+{
+	static const lv_coord_t sizes[] = { 16, 48 };
+	static const lv_coord_t radii[] = { 0, 8, LV_RADIUS_CIRCLE };
+	static const lv_coord_t shadows[] = { 0, 8, 24 };
+	PrimCase c;
+
+	for (uint8_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		for (uint8_t r = 0; r < sizeof(radii) / sizeof(radii[0]); r++)
+		{
+			for (uint8_t d = 0; d < sizeof(shadows) / sizeof(shadows[0]); d++)
+			{
+				case_init(&c, "draw_rect", sizes[s], sizes[s]);
+				lv_draw_rect_dsc_init(&c.rect);
+				c.rect.radius = radii[r];
+				c.rect.bg_color = LV_COLOR_MAKE(0x40, 0x90, 0xF0);
+				c.rect.shadow_width = shadows[d];
+				c.rect.shadow_color = LV_COLOR_BLACK;
+				c.rect.shadow_opa = shadows[d] ? LV_OPA_COVER : LV_OPA_TRANSP;
+				snprintf(c.params, sizeof(c.params), "size=%d radius=%d shadow=%d", sizes[s],
+						 radii[r] == LV_RADIUS_CIRCLE ? -1 : radii[r], shadows[d]);
+				measure(&c, rect_fn);
+			}
+		}
+	}
+}
+
+/**
+ * lv_draw_img：缩放 x 抗锯齿（64x64真彩色，内存图像经内置解码器直接读取；单位为缩放后的像素数）
+ */
+void PrimBench::runImg()
+{
+	static const uint16_t zooms[] = { LV_IMG_ZOOM_NONE, 128, 192, 320 };
+	PrimCase c;
+
+	for (uint8_t z = 0; z < sizeof(zooms) / sizeof(zooms[0]); z++)
+	{
+		for (uint8_t aa = 0; aa < 2; aa++)
+		{
+			if (zooms[z] == LV_IMG_ZOOM_NONE && aa) continue;
+			case_init(&c, "draw_img", PRIM_BENCH_IMG_SIZE, PRIM_BENCH_IMG_SIZE);
+			lv_draw_img_dsc_init(&c.img);
+			c.img.zoom = zooms[z];
+			c.img.antialias = aa;
+			c.img.pivot.x = PRIM_BENCH_IMG_SIZE / 2;
+			c.img.pivot.y = PRIM_BENCH_IMG_SIZE / 2;
+			c.src = &img_dsc;
+			// 放大后超出画布高度的部分被裁剪
+			uint32_t side = (uint32_t)PRIM_BENCH_IMG_SIZE * zooms[z] / LV_IMG_ZOOM_NONE;
+			c.units = side * LV_MATH_MIN(side, PRIM_BENCH_CANVAS_H);
+			snprintf(c.params, sizeof(c.params), "zoom=%u aa=%u", zooms[z], aa);
+			measure(&c, img_fn);
+		}
+	}
+}
+
+/**
+ * 刷新回调：区域尺寸（像素取自显示缓冲区，写在屏幕左上角，结束后整屏重绘）
+ */
+void PrimBench::runFlush()
+{
+	static const lv_coord_t sizes[][2] = {
+		{ 32, 32 }, { LV_HOR_RES_MAX / 2, 10 }, { LV_HOR_RES_MAX, 1 }, { LV_HOR_RES_MAX, 10 }, { LV_HOR_RES_MAX, 40 }
+	};
+	lv_disp_drv_t* drv = &disp->driver;
+	bool vsync = screen->getVsync();
+	screen->setVsync(false);
+	while (vdb->flushing) {}
+	screen->frameWait();
+
+	PrimCase c;
+	for (uint8_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		lv_coord_t w = sizes[s][0];
+		// 高度受显示缓冲区行数限制，截断后重复的组跳过
+		lv_coord_t h = LV_MATH_MIN(sizes[s][1], (lv_coord_t)(vdb->size / w));
+		if (s && c.units == (uint32_t)w * h && c.area.x2 == w - 1) continue;
+		memset(&c, 0, sizeof(c));
+		c.prim = "flush";
+		c.unit = "px";
+		c.units = (uint32_t)w * h;
+		lv_area_set(&c.area, 0, 0, w - 1, h - 1);
+		c.drv = drv;
+		c.vdb = vdb;
+		c.px = (lv_color_t*)vdb->buf_act;
+		c.screen = screen;
+		snprintf(c.params, sizeof(c.params), "w=%d h=%d mode=%u", w, h, screen->getFlushMode());
+		for (uint32_t i = 0; i < c.units; i++) c.px[i].full = (uint16_t)(i * 2654435761U >> 16);
+		measure(&c, flush_fn);
+	}
+	screen->setVsync(vsync);
+}
+
+bool PrimBench::run(Display* display)
+{
+	screen = display;
+	disp = screen->getDisp();
+	vdb = lv_disp_get_buf(disp);
+	canvas = (lv_color_t*)buf_alloc(BUF_FAST, (uint32_t)PRIM_BENCH_CANVAS_W * PRIM_BENCH_CANVAS_H * sizeof(lv_color_t));
+	img_buf = (lv_color_t*)buf_alloc(BUF_FAST, PRIM_BENCH_IMG_SIZE * PRIM_BENCH_IMG_SIZE * sizeof(lv_color_t));
+	if (canvas == NULL || img_buf == NULL)
+	{
+		LOG_E("primbench", "画布内存不足");
+		buf_free(canvas);
+		buf_free(img_buf);
+		canvas = NULL;
+		img_buf = NULL;
+		return false;
+	}
+	// 测试图像：对角渐变
+	for (uint16_t y = 0; y < PRIM_BENCH_IMG_SIZE; y++)
+	{
+		for (uint16_t x = 0; x < PRIM_BENCH_IMG_SIZE; x++)
+		{
+			img_buf[y * PRIM_BENCH_IMG_SIZE + x] = LV_COLOR_MAKE(x * 4, y * 4, (x + y) * 2);
+		}
+	}
+	memset(&img_dsc, 0, sizeof(img_dsc));
+	img_dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+	img_dsc.header.w = PRIM_BENCH_IMG_SIZE;
+	img_dsc.header.h = PRIM_BENCH_IMG_SIZE;
+	img_dsc.data_size = PRIM_BENCH_IMG_SIZE * PRIM_BENCH_IMG_SIZE * sizeof(lv_color_t);
+	img_dsc.data = (const uint8_t*)img_buf;
+
+	// 冷缓存用的映射：运行中的应用分区开头（映射不到时只测热缓存）
+	const esp_partition_t* app = esp_ota_get_running_partition();
+	const void* ptr = NULL;
+	if (app && app->size >= PRIM_BENCH_EVICT_BYTES &&
+		esp_partition_mmap(app, 0, PRIM_BENCH_EVICT_BYTES, ESP_PARTITION_MMAP_DATA, &ptr, &evict_map) == ESP_OK)
+	{
+		evict_src = (const uint8_t*)ptr;
+	}
+	else
+	{
+		LOG_W("primbench", "无法映射应用分区，跳过冷缓存");
+	}
+
+	SD_FS.mkdir(PRIM_BENCH_DIR);
+	bool header = !SD_FS.exists(PRIM_BENCH_CSV_PATH);
+	csv = SD_FS.open(PRIM_BENCH_CSV_PATH, FILE_APPEND);
+	if (csv && header)
+	{
+		csv.print("build,lvgl,cpu_mhz,prim,params,units,unit,cache,iters,min_cycles,median_cycles,cycles_per_unit\n");
+	}
+	rows = 0;
+	uint32_t start = millis();
+	Serial.printf("PRIMBENCH,prim,params,units,cache,min_cycles,median_cycles,cycles_per_unit\n");
+
+	void* saved_buf;
+	lv_area_t saved_area;
+	lv_disp_t* saved_refr;
+	beginCanvas(&saved_buf, &saved_area, &saved_refr);
+	runBlend();
+	runLabel();
+	runRect();
+	runImg();
+	endCanvas(saved_buf, &saved_area, saved_refr);
+	runFlush();
+
+	if (csv)
+	{
+		csv.close();
+		LOG_I("primbench", "%u行已追加到%s（%lu毫秒）", rows, PRIM_BENCH_CSV_PATH, (unsigned long)(millis() - start));
+	}
+	if (evict_src) spi_flash_munmap(evict_map);
+	evict_src = NULL;
+	lv_img_cache_invalidate_src(&img_dsc);
+	buf_free(canvas);
+	buf_free(img_buf);
+	canvas = NULL;
+	img_buf = NULL;
+	// 刷新测试改写了屏幕
+	lv_obj_invalidate(lv_scr_act());
+	return true;
+}
@@ -0,0 +1,246 @@
+/*
+ * HoloCubic Q565压缩图像解码模块
+ *
+ * 功能说明：
+ * 1. q565_decode：操作码格式见q565_decoder.h，连续的RUN直接批量填充，放在IRAM中
+ * 2. LVGL解码器：Q565压缩的内存图像（.holo压缩帧）按行解码到read_line给出的绘制缓冲，
+ *    不展开整帧，槽位中只保存压缩数据
+ * 3. 场景播放器直接写屏时按条带解码后DMA发送（见scene_player.cpp）
+ *
+ * 注意事项：
+ * - 只支持16位颜色（LV_COLOR_DEPTH 16），其他颜色深度下不接管图像
+ * - 压缩数据只能顺序解码：read_line的行号回退时从头开始，跳过的行解码后丢弃；
+ *   图像缓存保持解码器打开，同一帧各显示条带按行递增读取，没有额外开销
+ */
+
+#include "q565_decoder.h"
+#include <esp_attr.h>
+#include <string.h>
+#include <stdlib.h>
+
+struct Q565LvCtx
+{
+	Q565State st;
+	const uint8_t* data;
+	uint32_t len;
+	uint16_t w;
+	uint16_t h;
+	int32_t next_y;        // 下一个要解码的行
+	int32_t line_y;        // line中保存的行，-1表示无效
+	lv_color_t* line;
+};
+
+static inline uint8_t q565_hash(uint16_t p)
+{
+	return ((p >> 11) * 3 + ((p >> 5) & 0x3F) * 5 + (p & 0x1F) * 7) & (Q565_INDEX_SIZE - 1);
+}
+
+#if LV_COLOR_16_SWAP
+#define Q565_OUT(p) ((uint16_t)(((p) >> 8) | ((p) << 8)))
+#else
+#define Q565_OUT(p) (p)
+#endif
+
+bool q565_is_image(const lv_img_dsc_t* img)
+{
+	return LV_COLOR_DEPTH == 16 && img->header.cf == LV_IMG_CF_RAW && img->data != NULL &&
+		   img->data_size >= Q565_MAGIC_SIZE && memcmp(img->data, Q565_MAGIC, Q565_MAGIC_SIZE) == 0;
+}
+
+bool q565_begin(Q565State* st, const uint8_t* data, uint32_t len)
+{
+	if (len < Q565_MAGIC_SIZE || memcmp(data, Q565_MAGIC, Q565_MAGIC_SIZE) != 0) return false;
+	st->src = data + Q565_MAGIC_SIZE;
+	st->end = data + len;
+	st->run = 0;
+	st->prev = 0;
+	memset(st->index, 0, sizeof(st->index));
+	return true;
+}
+
+uint32_t IRAM_ATTR q565_decode(Q565State* st, lv_color_t* out, uint32_t n)
+{
+	const uint8_t* s = st->src;
+	const uint8_t* end = st->end;
+	uint16_t* index = st->index;
+	uint16_t prev = st->prev;
+	uint32_t run = st->run;
+	uint32_t i = 0;
+
+	while (i < n)
+	{
+		if (run)
+		{
+			uint32_t k = run < n - i ? run : n - i;
+			uint16_t v = Q565_OUT(prev);
+			for (uint32_t j = 0; j < k; j++) out[i + j].full = v;
+			i += k;
+			run -= k;
+			continue;
+		}
+		if (s >= end) break;
+
+		uint8_t op = *s++;
+		uint8_t tag = op >> 6;
+		if (tag == 0)
+		{
+			// 表中的颜色已在对应位置，不必回写
+			prev = index[op];
+			out[i++].full = Q565_OUT(prev);
+			continue;
+		}
+
+		int32_t r = prev >> 11, g = (prev >> 5) & 0x3F, b = prev & 0x1F;
+		if (tag == 1)
+		{
+			r += ((op >> 4) & 3) - 2;
+			g += ((op >> 2) & 3) - 2;
+			b += (op & 3) - 2;
+			prev = ((r & 0x1F) << 11) | ((g & 0x3F) << 5) | (b & 0x1F);
+		}
+		else if (tag == 2)
+		{
+			if (s >= end)
+			{
+				s--;
+				break;
+			}
+			int32_t dg = (op & 0x3F) - 32;
+			uint8_t rb = *s++;
+			r += (dg >> 1) + (rb >> 4) - 8;
+			g += dg;
+			b += (dg >> 1) + (rb & 0x0F) - 8;
+			prev = ((r & 0x1F) << 11) | ((g & 0x3F) << 5) | (b & 0x1F);
+		}
+		else if (op < 0xFE)
+		{
+			run = (op & 0x3F) + 1;
+			continue;
+		}
+		else
+		{
+			if (end - s < 2)
+			{
+				s--;
+				break;
+			}
+			uint16_t v = s[0] | (s[1] << 8);
+			s += 2;
+			if (op == 0xFF)
+			{
+				run = (uint32_t)v + 1;
+				continue;
+			}
+			prev = v;
+		}
+		index[q565_hash(prev)] = prev;
+		out[i++].full = Q565_OUT(prev);
+	}
+
+	st->src = s;
+	st->prev = prev;
+	st->run = run;
+	return i;
+}
+
+static lv_res_t q565_lv_info(lv_img_decoder_t* decoder, const void* src, lv_img_header_t* header)
+{
+	if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+
+	const lv_img_dsc_t* img = (const lv_img_dsc_t*)src;
+	if (!q565_is_image(img)) return LV_RES_INV;
+
+	// 保留LV_IMG_CF_RAW：lv_img按不透明处理，且不会被当作可直接拷贝的真彩色数据
+	*header = img->header;
+	return LV_RES_OK;
+}
+
+static lv_res_t q565_lv_open(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	if (dsc->src_type != LV_IMG_SRC_VARIABLE) return LV_RES_INV;
+
+	const lv_img_dsc_t* img = (const lv_img_dsc_t*)dsc->src;
+	if (!q565_is_image(img) || img->header.w == 0 || img->header.h == 0) return LV_RES_INV;
+
+	Q565LvCtx* ctx = new Q565LvCtx();
+	ctx->line = (lv_color_t*)malloc(img->header.w * sizeof(lv_color_t));
+	if (ctx->line == NULL)
+	{
+		delete ctx;
+		return LV_RES_INV;
+	}
+	ctx->data = img->data;
+	ctx->len = img->data_size;
+	ctx->w = img->header.w;
+	ctx->h = img->header.h;
+	ctx->next_y = 0;
+	ctx->line_y = -1;
+	q565_begin(&ctx->st, ctx->data, ctx->len);
+
+	dsc->header.cf = LV_IMG_CF_TRUE_COLOR;
+	dsc->img_data = NULL;       // 不提供整帧数据，LVGL逐行调用read_line
+	dsc->user_data = ctx;
+	return LV_RES_OK;
+}
+
+/**
+ * 读取一行中[x, x+len)的像素
+ * 整行读取下一行时直接解码到buf；只读一部分时先解码到行缓冲，供同一行的其他部分复用
+ */
+static lv_res_t LV_ATTRIBUTE_HOT q565_lv_read_line(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc,
+								  lv_coord_t x, lv_coord_t y, lv_coord_t len, uint8_t* buf)
+{
+	Q565LvCtx* ctx = (Q565LvCtx*)dsc->user_data;
+	if (y < 0 || y >= ctx->h || x < 0 || len <= 0 || x + len > ctx->w) return LV_RES_INV;
+
+	if (y == ctx->line_y)
+	{
+		memcpy(buf, ctx->line + x, len * sizeof(lv_color_t));
+		return LV_RES_OK;
+	}
+	if (y < ctx->next_y)
+	{
+		q565_begin(&ctx->st, ctx->data, ctx->len);
+		ctx->next_y = 0;
+	}
+	ctx->line_y = -1;
+	while (ctx->next_y < y)
+	{
+		if (q565_decode(&ctx->st, ctx->line, ctx->w) != ctx->w) return LV_RES_INV;
+		ctx->next_y++;
+	}
+
+	if (x == 0 && len == ctx->w)
+	{
+		if (q565_decode(&ctx->st, (lv_color_t*)buf, ctx->w) != ctx->w) return LV_RES_INV;
+		ctx->next_y++;
+		return LV_RES_OK;
+	}
+	if (q565_decode(&ctx->st, ctx->line, ctx->w) != ctx->w) return LV_RES_INV;
+	ctx->next_y++;
+	ctx->line_y = y;
+	memcpy(buf, ctx->line + x, len * sizeof(lv_color_t));
+	return LV_RES_OK;
+}
+
+static void q565_lv_close(lv_img_decoder_t* decoder, lv_img_decoder_dsc_t* dsc)
+{
+	Q565LvCtx* ctx = (Q565LvCtx*)dsc->user_data;
+	if (ctx == NULL) return;
+	free(ctx->line);
+	delete ctx;
+	dsc->user_data = NULL;
+}
+
+/**
+ * 注册Q565解码器
+ * 新解码器插入列表头部，优先于内置解码器尝试
+ */
+void q565_decoder_lv_init()
+{
+	lv_img_decoder_t* dec = lv_img_decoder_create();
+	lv_img_decoder_set_info_cb(dec, q565_lv_info);
+	lv_img_decoder_set_open_cb(dec, q565_lv_open);
+	lv_img_decoder_set_read_line_cb(dec, q565_lv_read_line);
+	lv_img_decoder_set_close_cb(dec, q565_lv_close);
+}
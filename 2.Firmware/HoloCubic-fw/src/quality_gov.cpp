@@ -0,0 +1,173 @@
+/*
+ * HoloCubic 帧预算与画质调节
+ *
+ * 功能说明：
+ * 1. lv_task每QUALITY_PERIOD_MS取一次渲染计时的累计值，与上次求差得到窗口内的帧数与平均帧时间
+ * 2. 超出预算、低于恢复阈值分别计数，连续达到次数后降/升一级，中间状态清零两个计数
+ * 3. 每一级对应一项运行时开关：lv_draw_rect的阴影、显示驱动的antialiasing、缩略图级偏移、LED节拍分频
+ *
+ * 数据流：
+ *   render_prof_get_totals --> evaluate：平均帧时间 vs 预算 --> apply --> 各开关 + lv_obj_invalidate + 回调
+ */
+
+#include "quality_gov.h"
+#include "render_prof.h"
+#include "logger.h"
+
+QualityGovernor quality;
+
+static const char* const level_names[QUALITY_LEVEL_CNT] = {
+	"full", "no_shadow", "no_aa", "low_res", "led_slow"
+};
+
+QualityGovernor::QualityGovernor()
+{
+	screen = NULL;
+	led = NULL;
+	task = NULL;
+	budget_us = QUALITY_BUDGET_US;
+	level = QUALITY_FULL;
+	max_level = QUALITY_LEVEL_CNT - 1;
+	over = under = 0;
+	settle = false;
+	last_frames = 0;
+	last_frame_us = 0;
+	avg_us = 0;
+	changes = 0;
+	listener_count = 0;
+}
+
+bool QualityGovernor::begin(Display* display, Pixel* rgb)
+{
+	if (task) return true;
+	screen = display;
+	led = rgb;
+	if (!render_prof_enable(true)) return false;
+
+	uint32_t us[RENDER_PROF_PHASE_CNT];
+	last_frames = render_prof_get_totals(us);
+	last_frame_us = us[RENDER_PROF_FRAME];
+	over = under = 0;
+	settle = false;
+	task = lv_task_create(taskCb, QUALITY_PERIOD_MS, LV_TASK_PRIO_LOW, this);
+	return task != NULL;
+}
+
+void QualityGovernor::end()
+{
+	if (task) lv_task_del(task);
+	task = NULL;
+	apply(QUALITY_FULL);
+}
+
+/**
+ * 切换到级别lv：各开关按级别设置（不依赖之前的状态），有变化时整屏重绘并通知
+ */
+void QualityGovernor::apply(uint8_t lv)
+{
+	if (lv == level) return;
+	uint8_t old = level;
+	level = lv;
+	changes++;
+
+	lv_draw_rect_set_shadow_enabled(level < QUALITY_NO_SHADOW);
+	lv_disp_t* disp = screen ? screen->getDisp() : lv_disp_get_default();
+	if (disp) disp->driver.antialiasing = level < QUALITY_NO_AA;
+	if (led) led->setRateDivider(level >= QUALITY_LED_SLOW ? QUALITY_LED_DIV : 1);
+
+	// 阴影与抗锯齿只影响之后的绘制，整屏重绘一次使画面一致
+	if (disp) lv_obj_invalidate(lv_disp_get_scr_act(disp));
+	settle = true;
+	over = under = 0;
+	LOG_I("quality", "%s -> %s（平均帧%luus，预算%luus）", level_names[old], level_names[level],
+		  (unsigned long)avg_us, (unsigned long)budget_us);
+	for (uint8_t i = 0; i < listener_count; i++) listeners[i]((QualityLevel)level);
+}
+
+void QualityGovernor::evaluate()
+{
+	// 渲染计时被关闭（基准测试等）期间不评估，恢复后重新取基准
+	if (!render_prof_is_enabled())
+	{
+		last_frames = 0;
+		return;
+	}
+	uint32_t us[RENDER_PROF_PHASE_CNT];
+	uint32_t frames = render_prof_get_totals(us);
+	uint32_t n = frames - last_frames;
+	uint32_t t = us[RENDER_PROF_FRAME] - last_frame_us;
+	bool valid = last_frames != 0;
+	last_frames = frames;
+	last_frame_us = us[RENDER_PROF_FRAME];
+	if (!valid) return;
+	if (settle)
+	{
+		settle = false;
+		return;
+	}
+
+	avg_us = n ? t / n : 0;
+	if (n >= QUALITY_MIN_FRAMES && avg_us > budget_us)
+	{
+		under = 0;
+		if (++over >= QUALITY_DEGRADE_WINDOWS && level < max_level) apply(level + 1);
+	}
+	else if (n < QUALITY_MIN_FRAMES || avg_us < budget_us * QUALITY_RESTORE_PCT / 100)
+	{
+		over = 0;
+		if (++under >= QUALITY_RESTORE_WINDOWS && level > QUALITY_FULL) apply(level - 1);
+	}
+	else
+	{
+		over = under = 0;
+	}
+}
+
+void QualityGovernor::taskCb(lv_task_t* t)
+{
+	((QualityGovernor*)t->user_data)->evaluate();
+}
+
+void QualityGovernor::setBudget(uint32_t us)
+{
+	budget_us = us;
+	over = under = 0;
+}
+
+void QualityGovernor::setMaxLevel(QualityLevel lv)
+{
+	max_level = lv;
+	if (level > max_level) apply(max_level);
+}
+
+void QualityGovernor::setLevel(QualityLevel lv)
+{
+	apply(LV_MATH_MIN((uint8_t)lv, max_level));
+}
+
+QualityLevel QualityGovernor::getLevel()
+{
+	return (QualityLevel)level;
+}
+
+uint8_t QualityGovernor::getMipBias()
+{
+	return level >= QUALITY_LOW_RES ? 1 : 0;
+}
+
+bool QualityGovernor::addListener(quality_cb_t cb)
+{
+	if (listener_count >= QUALITY_LISTENERS) return false;
+	listeners[listener_count++] = cb;
+	return true;
+}
+
+uint32_t QualityGovernor::getAvgFrameUs()
+{
+	return avg_us;
+}
+
+uint32_t QualityGovernor::getChanges()
+{
+	return changes;
+}
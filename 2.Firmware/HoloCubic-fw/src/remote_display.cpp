@@ -0,0 +1,470 @@
+/*
+ * HoloCubic 远程显示模块
+ *
+ * 功能说明：
+ * 1. UDP接收PC端推送的画面：RGB565分块（原始/RLE）或整帧JPEG
+ * 2. 抖动缓冲按帧号组装、排序，吸收WiFi的到达时间抖动与乱序
+ * 3. LVGL任务中按帧直接写屏，只刷新收到的脏分块
+ *
+ * 数据流：
+ *   缓冲池 --> 接收任务(核心0) recv --> 抖动缓冲（按帧号分组） --> LVGL定时任务写屏 --> 归还缓冲池
+ *
+ * 接收的包直接recv进DMA缓冲区，原始分块不经拷贝交给pushRect
+ */
+
+#include "remote_display.h"
+#include <lwip/sockets.h>
+#include <esp_heap_caps.h>
+#include "buf_manager.h"
+
+RemoteDisplay::RemoteDisplay()
+{
+	display = NULL;
+	sock = -1;
+	running = false;
+	rx_task = NULL;
+	present_task = NULL;
+	screen = prev_screen = NULL;
+	jpeg_buf = NULL;
+	rle_buf = NULL;
+	free_count = 0;
+	lock = portMUX_INITIALIZER_UNLOCKED;
+	for (uint8_t i = 0; i < REMOTE_PKT_POOL; i++) pool[i].data = NULL;
+}
+
+/**
+ * 进入远程显示模式（在LVGL任务中调用）
+ *
+ * @param disp 显示对象，画面经pushRect直接写屏
+ * @param port UDP监听端口
+ */
+bool RemoteDisplay::start(Display* disp, uint16_t port)
+{
+	if (running) return true;
+	display = disp;
+	if (display == NULL || !allocPool()) return false;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (sock < 0 || bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		Serial.printf("远程显示端口%u绑定失败\n", port);
+		if (sock >= 0) closesocket(sock);
+		sock = -1;
+		freePool();
+		return false;
+	}
+	// 接收超时用于检查退出标志
+	timeval tv = { 0, 200000 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	memset(&stats, 0, sizeof(stats));
+	for (uint8_t i = 0; i < REMOTE_JITTER_DEPTH; i++) slots[i].state = SLOT_FREE;
+	has_shown = false;
+
+	// 空白屏幕：LVGL不再有需要重绘的对象，不会覆盖远程画面
+	prev_screen = lv_scr_act();
+	screen = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(screen, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	lv_scr_load(screen);
+
+	running = true;
+	xTaskCreatePinnedToCore(rxEntry, "remote", REMOTE_TASK_STACK, this,
+							REMOTE_TASK_PRIORITY, &rx_task, REMOTE_TASK_CORE);
+	present_task = lv_task_create(presentCb, REMOTE_PRESENT_PERIOD_MS, LV_TASK_PRIO_HIGH, this);
+
+	Serial.printf("远程显示已启动，UDP端口%u\n", port);
+	return true;
+}
+
+/**
+ * 退出远程显示模式，恢复原来的LVGL屏幕（在LVGL任务中调用）
+ */
+void RemoteDisplay::stop()
+{
+	if (!running) return;
+
+	running = false;
+	if (present_task)
+	{
+		lv_task_del(present_task);
+		present_task = NULL;
+	}
+	// 接收任务最多在一次recv超时后退出
+	while (rx_task != NULL) vTaskDelay(1);
+	closesocket(sock);
+	sock = -1;
+
+	if (prev_screen) lv_scr_load(prev_screen);
+	if (screen) lv_obj_del(screen);
+	screen = prev_screen = NULL;
+
+	jpeg.release();
+	freePool();
+}
+
+bool RemoteDisplay::isRunning()
+{
+	return running;
+}
+
+void RemoteDisplay::getStats(RemoteDisplayStats* out)
+{
+	portENTER_CRITICAL(&lock);
+	*out = stats;
+	portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * 分配包缓冲池与RLE行缓冲（均为DMA内存，可直接交给pushImageDMA）
+ */
+bool RemoteDisplay::allocPool()
+{
+	free_count = 0;
+	for (uint8_t i = 0; i < REMOTE_PKT_POOL; i++)
+	{
+		pool[i].data = (uint8_t*)heap_caps_malloc(REMOTE_PKT_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+		if (pool[i].data == NULL) break;
+		free_list[free_count++] = i;
+	}
+	rle_buf = (uint16_t*)heap_caps_malloc(REMOTE_RLE_BUF_PX * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+
+	if (free_count < REMOTE_PKT_POOL || rle_buf == NULL)
+	{
+		Serial.println("远程显示缓冲分配失败");
+		freePool();
+		return false;
+	}
+	return true;
+}
+
+void RemoteDisplay::freePool()
+{
+	for (uint8_t i = 0; i < REMOTE_PKT_POOL; i++)
+	{
+		if (pool[i].data) heap_caps_free(pool[i].data);
+		pool[i].data = NULL;
+	}
+	free_count = 0;
+	if (rle_buf) heap_caps_free(rle_buf);
+	rle_buf = NULL;
+	buf_free(jpeg_buf);
+	jpeg_buf = NULL;
+}
+
+/**
+ * 归还一帧占用的全部包（需持有锁）
+ */
+void RemoteDisplay::releaseSlot(FrameSlot* s)
+{
+	for (uint8_t i = 0; i < REMOTE_FRAME_PKTS; i++)
+	{
+		if (s->pkts[i] >= 0) free_list[free_count++] = s->pkts[i];
+		s->pkts[i] = -1;
+	}
+	s->state = SLOT_FREE;
+}
+
+/**
+ * 从缓冲池取一个包（接收任务中调用）
+ * 缓冲池用尽说明有帧迟迟无法完成（丢包），挤出最旧的组装中帧
+ */
+int8_t RemoteDisplay::takePacket()
+{
+	portENTER_CRITICAL(&lock);
+	if (free_count == 0)
+	{
+		FrameSlot* old = NULL;
+		for (uint8_t i = 0; i < REMOTE_JITTER_DEPTH; i++)
+		{
+			FrameSlot* s = &slots[i];
+			if (s->state == SLOT_FILLING && (old == NULL || (int16_t)(s->frame - old->frame) < 0)) old = s;
+		}
+		if (old)
+		{
+			releaseSlot(old);
+			stats.dropped++;
+		}
+	}
+	int8_t idx = free_count ? free_list[--free_count] : -1;
+	portEXIT_CRITICAL(&lock);
+	return idx;
+}
+
+/**
+ * 查找或分配包所属的帧（需持有锁）
+ * 抖动缓冲已满时挤出最旧的帧；比已显示帧旧的包返回NULL
+ */
+RemoteDisplay::FrameSlot* RemoteDisplay::slotFor(const RemotePacketHeader* hdr)
+{
+	if (has_shown && (int16_t)(hdr->frame - last_shown) <= 0)
+	{
+		stats.late++;
+		return NULL;
+	}
+
+	FrameSlot* free_slot = NULL;
+	FrameSlot* old = NULL;
+	for (uint8_t i = 0; i < REMOTE_JITTER_DEPTH; i++)
+	{
+		FrameSlot* s = &slots[i];
+		if (s->state == SLOT_FILLING && s->frame == hdr->frame) return s;
+		if (s->state == SLOT_FREE && free_slot == NULL) free_slot = s;
+		if (s->state == SLOT_FILLING && (old == NULL || (int16_t)(s->frame - old->frame) < 0)) old = s;
+	}
+
+	if (free_slot == NULL)
+	{
+		// 新帧比缓冲中所有帧都旧时丢弃新帧
+		if (old == NULL || (int16_t)(hdr->frame - old->frame) < 0) return NULL;
+		releaseSlot(old);
+		stats.dropped++;
+		free_slot = old;
+	}
+
+	free_slot->state = SLOT_FILLING;
+	free_slot->frame = hdr->frame;
+	free_slot->type = hdr->type;
+	free_slot->received = 0;
+	free_slot->expected = 0;
+	free_slot->first_ms = millis();
+	memset(free_slot->pkts, -1, sizeof(free_slot->pkts));
+	return free_slot;
+}
+
+/**
+ * 把收到的包放入抖动缓冲（接收任务中调用），无效的包直接归还
+ */
+void RemoteDisplay::store(int8_t idx)
+{
+	const RemotePacketHeader* hdr = (const RemotePacketHeader*)pool[idx].data;
+	bool valid = hdr->magic[0] == REMOTE_MAGIC0 && hdr->magic[1] == REMOTE_MAGIC1 &&
+		hdr->type <= REMOTE_JPEG && hdr->seq < REMOTE_FRAME_PKTS;
+
+	portENTER_CRITICAL(&lock);
+	FrameSlot* s = valid ? slotFor(hdr) : NULL;
+	if (s && s->type == hdr->type && s->pkts[hdr->seq] < 0)
+	{
+		s->pkts[hdr->seq] = idx;
+		s->received++;
+		if (hdr->flags & REMOTE_FLAG_END) s->expected = hdr->seq + 1;
+	}
+	else
+	{
+		free_list[free_count++] = idx;
+	}
+	portEXIT_CRITICAL(&lock);
+}
+
+/**
+ * 接收任务：每个UDP包直接收进缓冲池中的一个DMA缓冲区
+ */
+void RemoteDisplay::rxEntry(void* arg)
+{
+	RemoteDisplay* self = (RemoteDisplay*)arg;
+	int8_t idx = -1;
+
+	while (self->running)
+	{
+		if (idx < 0) idx = self->takePacket();
+		if (idx < 0)
+		{
+			vTaskDelay(1);
+			continue;
+		}
+
+		int n = recv(self->sock, self->pool[idx].data, REMOTE_PKT_SIZE, 0);
+		// 超时或过短的包：缓冲区留到下一次接收
+		if (n < (int)sizeof(RemotePacketHeader)) continue;
+
+		self->pool[idx].len = n;
+		self->store(idx);
+		idx = -1;
+	}
+
+	if (idx >= 0)
+	{
+		portENTER_CRITICAL(&self->lock);
+		self->free_list[self->free_count++] = idx;
+		portEXIT_CRITICAL(&self->lock);
+	}
+	self->rx_task = NULL;
+	vTaskDelete(NULL);
+}
+
+/**
+ * 选出下一帧（需持有锁）
+ * 只看帧号最旧的组装中帧，保证按顺序显示：
+ * - 完整且已在缓冲中停留REMOTE_JITTER_MS，或后面已有新帧到达：显示
+ * - 超时或后面已有完整的新帧（本帧丢包）：分块帧显示已收到部分，JPEG帧丢弃
+ */
+RemoteDisplay::FrameSlot* RemoteDisplay::nextFrame()
+{
+	FrameSlot* o = NULL;
+	FrameSlot* newer_complete = NULL;
+	uint8_t filling = 0;
+	for (uint8_t i = 0; i < REMOTE_JITTER_DEPTH; i++)
+	{
+		FrameSlot* s = &slots[i];
+		if (s->state != SLOT_FILLING) continue;
+		filling++;
+		if (o == NULL || (int16_t)(s->frame - o->frame) < 0) o = s;
+	}
+	if (o == NULL) return NULL;
+	for (uint8_t i = 0; i < REMOTE_JITTER_DEPTH; i++)
+	{
+		FrameSlot* s = &slots[i];
+		if (s != o && s->state == SLOT_FILLING && s->expected && s->received == s->expected) newer_complete = s;
+	}
+
+	uint32_t age = millis() - o->first_ms;
+	bool complete = o->expected && o->received == o->expected;
+	if (complete)
+	{
+		if (age < REMOTE_JITTER_MS && filling == 1) return NULL;
+	}
+	else
+	{
+		if (age < REMOTE_FRAME_TIMEOUT_MS && newer_complete == NULL) return NULL;
+		if (o->type == REMOTE_JPEG)
+		{
+			releaseSlot(o);
+			stats.dropped++;
+			last_shown = o->frame;
+			has_shown = true;
+			return NULL;
+		}
+		stats.partial++;
+	}
+
+	o->state = SLOT_PRESENTING;
+	// 之后到达的本帧包按过期处理，不会重新建帧
+	last_shown = o->frame;
+	has_shown = true;
+	return o;
+}
+
+/**
+ * 显示定时任务（LVGL任务中执行）：一次处理完所有可显示的帧
+ */
+void RemoteDisplay::presentCb(lv_task_t* task)
+{
+	RemoteDisplay* self = (RemoteDisplay*)task->user_data;
+
+	for (;;)
+	{
+		portENTER_CRITICAL(&self->lock);
+		FrameSlot* s = self->nextFrame();
+		portEXIT_CRITICAL(&self->lock);
+		if (s == NULL) break;
+
+		self->present(s);
+
+		portENTER_CRITICAL(&self->lock);
+		self->releaseSlot(s);
+		self->stats.frames++;
+		portEXIT_CRITICAL(&self->lock);
+	}
+}
+
+/**
+ * 显示一帧（此时帧处于PRESENTING状态，接收任务不会访问它的包）
+ */
+void RemoteDisplay::present(FrameSlot* s)
+{
+	if (s->type == REMOTE_JPEG)
+	{
+		presentJpeg(s);
+		return;
+	}
+
+	for (uint8_t i = 0; i < REMOTE_FRAME_PKTS; i++)
+	{
+		if (s->pkts[i] < 0) continue;
+		Packet* p = &pool[s->pkts[i]];
+		presentTile((const RemotePacketHeader*)p->data, p->data + sizeof(RemotePacketHeader),
+					p->len - sizeof(RemotePacketHeader));
+	}
+}
+
+/**
+ * 写一个分块：原始分块直接交给pushRect，RLE分块按行缓冲展开后分批写
+ */
+void RemoteDisplay::presentTile(const RemotePacketHeader* hdr, const uint8_t* payload, uint16_t len)
+{
+	uint16_t x = hdr->x, y = hdr->y, w = hdr->w, h = hdr->h;
+	if (w == 0 || h == 0 || x + w > LV_HOR_RES_MAX || y + h > LV_VER_RES_MAX) return;
+
+	if (hdr->type == REMOTE_TILE_RAW)
+	{
+		if (len < (uint32_t)w * h * 2) return;
+		display->pushRect(x, y, w, h, (uint16_t*)payload);
+		return;
+	}
+
+	uint32_t total = (uint32_t)w * h;
+	uint32_t band_px = (REMOTE_RLE_BUF_PX / w) * w;
+	uint32_t pos = 0;
+	uint32_t fill = 0;
+	uint16_t row = 0;
+	const uint16_t* p = (const uint16_t*)payload;
+
+	for (uint16_t i = 0; i + 1 < len / 2 && pos < total; i += 2)
+	{
+		uint16_t n = p[i];
+		uint16_t c = p[i + 1];
+		while (n-- && pos < total)
+		{
+			rle_buf[fill++] = c;
+			pos++;
+			if (fill == band_px || pos == total)
+			{
+				display->pushRect(x, y + row, w, fill / w, rle_buf);
+				row += fill / w;
+				fill = 0;
+			}
+		}
+	}
+	// 数据不足时只写完整的行
+	if (fill >= w) display->pushRect(x, y + row, w, fill / w, rle_buf);
+}
+
+/**
+ * JPEG帧：按seq拼接分片后逐MCU行解码写屏
+ */
+void RemoteDisplay::presentJpeg(FrameSlot* s)
+{
+	if (jpeg_buf == NULL) jpeg_buf = (uint8_t*)buf_alloc(BUF_BULK, REMOTE_JPEG_MAX);
+	if (jpeg_buf == NULL) return;
+
+	uint32_t len = 0;
+	for (uint8_t i = 0; i < s->expected; i++)
+	{
+		Packet* p = &pool[s->pkts[i]];
+		uint16_t n = p->len - sizeof(RemotePacketHeader);
+		if (i == 0)
+		{
+			const RemotePacketHeader* hdr = (const RemotePacketHeader*)p->data;
+			jpeg_x = hdr->x;
+			jpeg_y = hdr->y;
+		}
+		memcpy(jpeg_buf + len, p->data + sizeof(RemotePacketHeader), n);
+		len += n;
+	}
+
+	if (!jpeg.open(jpeg_buf, len)) return;
+	if (jpeg_x + jpeg.getWidth() > LV_HOR_RES_MAX || jpeg_y + jpeg.getHeight() > LV_VER_RES_MAX) return;
+	jpeg.decode(jpegBandCb, this);
+}
+
+bool RemoteDisplay::jpegBandCb(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px)
+{
+	RemoteDisplay* self = (RemoteDisplay*)user;
+	// 每帧第一条带对齐到面板扫描起点（未开启垂直同步时不等待）
+	if (y == 0) self->display->waitVsync();
+	self->display->pushRect(self->jpeg_x, self->jpeg_y + y, w, h, (uint16_t*)px);
+	return self->running;
+}
@@ -0,0 +1,253 @@
+/*
+ * HoloCubic 渲染分阶段计时模块
+ *
+ * 功能说明：
+ * 1. 以微秒时间戳记录每帧各阶段耗时：区域合并、绘制、刷新、SPI发送、输入读取、I2C传感器
+ * 2. 帧记录写入环形缓冲区，可通过串口以CSV导出
+ * 3. 可在系统层显示一个叠加层，每RENDER_PROF_OVERLAY_MS刷新一次各阶段的平均值
+ *
+ * 计时点：
+ * - lv_refr.c中的钩子由lv_conf.h的LV_USE_REFR_PROFILER打开
+ * - display.cpp、lv_port_indev.c、imu.cpp、ambient.cpp中直接调用
+ * - CACHE_PROF构建中同一区间还统计指令数与取指停顿（cache_prof.cpp）
+ *
+ * 各阶段只累加单调递增的总量，帧结束时与上一帧的快照求差，
+ * 其他任务（传感器、I2C总线）写入的阶段因此不需要加锁
+ */
+
+#include "render_prof.h"
+#include "cache_prof.h"
+#include <Arduino.h>
+#include <lvgl.h>
+#include <esp_timer.h>
+
+static const char* const phase_names[RENDER_PROF_PHASE_CNT] = {
+	"frame", "join", "draw", "flush", "spi", "indev", "imu", "ambient"
+};
+
+static volatile bool enabled = false;
+static int64_t start_us[RENDER_PROF_PHASE_CNT];
+static volatile uint32_t total_us[RENDER_PROF_PHASE_CNT];
+static uint32_t mark_us[RENDER_PROF_PHASE_CNT];
+static volatile uint32_t frame_total = 0;    // 不论是否启用都计数，供遥测计算帧率
+
+static render_prof_frame_t* ring = NULL;
+static uint32_t ring_count = 0;     // 写入的总帧数，最新一帧在(ring_count-1)%LEN
+static portMUX_TYPE ring_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// 叠加层：两次刷新之间的累计
+static lv_obj_t* overlay_label = NULL;
+static lv_task_t* overlay_task = NULL;
+static uint32_t overlay_frames = 0;
+static uint32_t overlay_sum[RENDER_PROF_PHASE_CNT];
+
+int64_t render_prof_now()
+{
+	return esp_timer_get_time();
+}
+
+void render_prof_begin(render_prof_phase_t phase)
+{
+	if (!enabled) return;
+	cache_prof_begin(phase);
+	start_us[phase] = esp_timer_get_time();
+}
+
+void render_prof_end(render_prof_phase_t phase)
+{
+	if (!enabled || start_us[phase] == 0) return;
+	total_us[phase] += (uint32_t)(esp_timer_get_time() - start_us[phase]);
+	start_us[phase] = 0;
+	cache_prof_end(phase);
+}
+
+void render_prof_add(render_prof_phase_t phase, uint32_t us)
+{
+	if (!enabled) return;
+	total_us[phase] += us;
+}
+
+/**
+ * 写入一条帧记录（LVGL任务中，刷新任务结束时调用）
+ */
+void render_prof_frame_end(uint32_t px)
+{
+	frame_total++;
+	if (!enabled) return;
+	render_prof_end(RENDER_PROF_FRAME);
+
+	render_prof_frame_t f;
+	f.time_ms = millis();
+	f.px = px;
+	for (uint8_t i = 0; i < RENDER_PROF_PHASE_CNT; i++)
+	{
+		uint32_t t = total_us[i];
+		f.us[i] = t - mark_us[i];
+		mark_us[i] = t;
+		overlay_sum[i] += f.us[i];
+	}
+	overlay_frames++;
+
+	portENTER_CRITICAL(&ring_mux);
+	if (ring)
+	{
+		ring[ring_count % RENDER_PROF_RING_LEN] = f;
+		ring_count++;
+	}
+	portEXIT_CRITICAL(&ring_mux);
+}
+
+/**
+ * 启用/停用计时
+ * 启用时分配环形缓冲区并清空之前的记录
+ */
+bool render_prof_enable(bool en)
+{
+	if (en == enabled) return true;
+
+	if (!en)
+	{
+		enabled = false;
+		return true;
+	}
+
+	if (ring == NULL)
+	{
+		render_prof_frame_t* buf = (render_prof_frame_t*)malloc(sizeof(render_prof_frame_t) * RENDER_PROF_RING_LEN);
+		if (buf == NULL)
+		{
+			Serial.println("渲染计时缓冲区分配失败");
+			return false;
+		}
+		portENTER_CRITICAL(&ring_mux);
+		ring = buf;
+		portEXIT_CRITICAL(&ring_mux);
+	}
+
+	portENTER_CRITICAL(&ring_mux);
+	ring_count = 0;
+	portEXIT_CRITICAL(&ring_mux);
+	for (uint8_t i = 0; i < RENDER_PROF_PHASE_CNT; i++)
+	{
+		start_us[i] = 0;
+		mark_us[i] = total_us[i];
+		overlay_sum[i] = 0;
+	}
+	overlay_frames = 0;
+	enabled = true;
+	return true;
+}
+
+bool render_prof_is_enabled()
+{
+	return enabled;
+}
+
+/**
+ * 取累计值：返回开机以来的总帧数，us（可为NULL）为各阶段累计耗时（只在启用期间增长）
+ * 调用方两次取值求差，不占用环形缓冲区
+ */
+uint32_t render_prof_get_totals(uint32_t us[RENDER_PROF_PHASE_CNT])
+{
+	if (us)
+	{
+		for (uint8_t i = 0; i < RENDER_PROF_PHASE_CNT; i++) us[i] = total_us[i];
+	}
+	return frame_total;
+}
+
+/**
+ * 叠加层刷新任务：显示平均帧率与各阶段平均耗时（毫秒）
+ * 叠加层本身的重绘也会计入，约为一小块标签的绘制时间
+ */
+static void overlay_update(lv_task_t* task)
+{
+	uint32_t n = overlay_frames;
+	if (n == 0)
+	{
+		lv_label_set_text(overlay_label, "no frames");
+		return;
+	}
+
+	uint32_t avg[RENDER_PROF_PHASE_CNT];
+	for (uint8_t i = 0; i < RENDER_PROF_PHASE_CNT; i++)
+	{
+		avg[i] = overlay_sum[i] / n;
+		overlay_sum[i] = 0;
+	}
+	overlay_frames = 0;
+
+	lv_label_set_text_fmt(overlay_label,
+		"%u fps %u.%ums\ndraw %u.%u flush %u.%u\nspi %u.%u join %u.%u\nin %u.%u imu %u.%u",
+		n * 1000 / RENDER_PROF_OVERLAY_MS, avg[0] / 1000, avg[0] % 1000 / 100,
+		avg[2] / 1000, avg[2] % 1000 / 100, avg[3] / 1000, avg[3] % 1000 / 100,
+		avg[4] / 1000, avg[4] % 1000 / 100, avg[1] / 1000, avg[1] % 1000 / 100,
+		avg[5] / 1000, avg[5] % 1000 / 100, avg[6] / 1000, avg[6] % 1000 / 100);
+}
+
+void render_prof_overlay(bool show)
+{
+	if (!show)
+	{
+		if (overlay_task) lv_task_del(overlay_task);
+		if (overlay_label) lv_obj_del(overlay_label);
+		overlay_task = NULL;
+		overlay_label = NULL;
+		return;
+	}
+	if (overlay_label) return;
+	if (!enabled && !render_prof_enable(true)) return;
+
+	overlay_label = lv_label_create(lv_layer_sys(), NULL);
+	lv_obj_set_style_local_bg_opa(overlay_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_70);
+	lv_obj_set_style_local_bg_color(overlay_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+	lv_obj_set_style_local_text_color(overlay_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_LIME);
+	lv_obj_set_style_local_pad_left(overlay_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, 2);
+	lv_obj_set_style_local_pad_right(overlay_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, 2);
+	lv_label_set_text(overlay_label, "...");
+	lv_obj_align(overlay_label, NULL, LV_ALIGN_IN_TOP_LEFT, 0, 0);
+
+	overlay_frames = 0;
+	for (uint8_t i = 0; i < RENDER_PROF_PHASE_CNT; i++) overlay_sum[i] = 0;
+	overlay_task = lv_task_create(overlay_update, RENDER_PROF_OVERLAY_MS, LV_TASK_PRIO_LOW, NULL);
+}
+
+/**
+ * 取最近第n帧
+ */
+bool render_prof_get(uint16_t n, render_prof_frame_t* out)
+{
+	bool ok = false;
+	portENTER_CRITICAL(&ring_mux);
+	if (ring && n < ring_count && n < RENDER_PROF_RING_LEN)
+	{
+		*out = ring[(ring_count - 1 - n) % RENDER_PROF_RING_LEN];
+		ok = true;
+	}
+	portEXIT_CRITICAL(&ring_mux);
+	return ok;
+}
+
+/**
+ * 串口输出CSV：PROF,time_ms,px,frame,join,draw,flush,spi,indev,imu,ambient（微秒）
+ */
+void render_prof_dump()
+{
+	Serial.print("PROF,time_ms,px");
+	for (uint8_t i = 0; i < RENDER_PROF_PHASE_CNT; i++)
+	{
+		Serial.print(',');
+		Serial.print(phase_names[i]);
+	}
+	Serial.println();
+
+	uint16_t n = ring_count < RENDER_PROF_RING_LEN ? ring_count : RENDER_PROF_RING_LEN;
+	render_prof_frame_t f;
+	for (int i = n - 1; i >= 0; i--)
+	{
+		if (!render_prof_get(i, &f)) continue;
+		Serial.printf("PROF,%u,%u", f.time_ms, f.px);
+		for (uint8_t j = 0; j < RENDER_PROF_PHASE_CNT; j++) Serial.printf(",%u", f.us[j]);
+		Serial.println();
+	}
+}
@@ -0,0 +1,230 @@
+/*
+ * HoloCubic 热重启恢复
+ *
+ * 功能说明：
+ * 1. 界面状态（前台应用、界面、滚动位置、场景与帧号）定期快照到RTC内存
+ * 2. 软件复位（OTA、远程重启）、看门狗与崩溃复位后按快照恢复，跳过默认界面
+ * 3. 恢复后反复崩溃时放弃快照，避免启动循环
+ *
+ * 注意事项：
+ * - RTC_NOINIT内存在上电时为随机内容，以魔数、版本、长度与CRC判断有效性
+ * - OTA后新固件的结构布局可能不同，版本或长度不符时同样丢弃
+ */
+
+#include "resume_state.h"
+#include "app_manager.h"
+#include "scene_playlist.h"
+#include "screen_manager.h"
+#include "gui_guider.h"
+#include "logger.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_rom_crc.h>
+
+static RTC_NOINIT_ATTR ResumeSnapshot rtc_snapshot;
+
+ResumeState resume;
+
+ResumeState::ResumeState()
+{
+	memset(&restored, 0, sizeof(restored));
+	valid = false;
+	stable = false;
+	started_ms = 0;
+	task = NULL;
+	player_count = 0;
+	for (uint8_t i = 0; i < RESUME_SCROLL_MAX; i++) pages[i] = NULL;
+}
+
+uint32_t ResumeState::checksum(const ResumeSnapshot* s)
+{
+	return esp_rom_crc32_le(0, (const uint8_t*)s, offsetof(ResumeSnapshot, crc));
+}
+
+/**
+ * 检查快照：只有软件复位、看门狗、崩溃与深度睡眠唤醒保留RTC内存中的状态
+ */
+bool ResumeState::begin()
+{
+	esp_reset_reason_t reason = esp_reset_reason();
+	bool warm = reason == ESP_RST_SW || reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+		reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT || reason == ESP_RST_DEEPSLEEP;
+
+	valid = warm && rtc_snapshot.magic == RESUME_MAGIC && rtc_snapshot.version == RESUME_VERSION &&
+		rtc_snapshot.size == sizeof(ResumeSnapshot) && rtc_snapshot.crc == checksum(&rtc_snapshot);
+
+	if (valid && rtc_snapshot.restores >= RESUME_MAX_RESTORES)
+	{
+		LOG_W("resume", "恢复后连续%u次重启，放弃上次的状态", rtc_snapshot.restores);
+		valid = false;
+	}
+	if (!valid)
+	{
+		clear();
+		return false;
+	}
+
+	// 恢复计数先写回，恢复过程中崩溃也会被计入
+	rtc_snapshot.restores++;
+	rtc_snapshot.crc = checksum(&rtc_snapshot);
+	restored = rtc_snapshot;
+	LOG_I("resume", "热重启（原因%d）：应用\"%s\" 界面%d 场景%s@%u", reason, restored.app, restored.screen,
+		  restored.scene_mode == RESUME_SCENE_PLAYLIST ? "（播放列表）" : restored.scene, restored.frame);
+	return true;
+}
+
+void ResumeState::clear()
+{
+	memset(&rtc_snapshot, 0, sizeof(rtc_snapshot));
+	rtc_snapshot.magic = RESUME_MAGIC;
+	rtc_snapshot.version = RESUME_VERSION;
+	rtc_snapshot.size = sizeof(ResumeSnapshot);
+	rtc_snapshot.screen = -1;
+	rtc_snapshot.playlist_item = -1;
+	rtc_snapshot.crc = checksum(&rtc_snapshot);
+}
+
+bool ResumeState::available()
+{
+	return valid;
+}
+
+const ResumeSnapshot* ResumeState::get()
+{
+	return valid ? &restored : NULL;
+}
+
+int8_t ResumeState::getScreen(int8_t def)
+{
+	return valid && restored.screen >= 0 ? restored.screen : def;
+}
+
+void ResumeState::watch(ScenePlayer* player)
+{
+	if (player_count < 2) players[player_count++] = player;
+}
+
+void ResumeState::trackScroll(uint8_t slot, lv_obj_t* page)
+{
+	if (slot < RESUME_SCROLL_MAX) pages[slot] = page;
+}
+
+/**
+ * 恢复页面滚动位置（页面内容已创建之后调用，超出范围时由lv_page修正）
+ */
+bool ResumeState::restoreScroll(uint8_t slot, lv_obj_t* page)
+{
+	if (!valid || slot >= RESUME_SCROLL_MAX || page == NULL) return false;
+	lv_obj_t* scrl = lv_page_get_scrollable(page);
+	lv_obj_set_pos(scrl, restored.scroll[slot][0], restored.scroll[slot][1]);
+	return true;
+}
+
+/**
+ * 开始定期记录（恢复完成后调用）
+ */
+void ResumeState::start()
+{
+	if (task) return;
+	started_ms = millis();
+	stable = false;
+	task = lv_task_create(pollCb, RESUME_POLL_MS, LV_TASK_PRIO_LOWEST, this);
+	save();
+}
+
+/**
+ * 读取当前界面状态
+ */
+void ResumeState::capture(ResumeSnapshot* s)
+{
+	*s = rtc_snapshot;
+
+	int fg = apps.foreground();
+	const char* name = fg >= 0 ? apps.getName(fg) : NULL;
+	strlcpy(s->app, name ? name : "", sizeof(s->app));
+	s->screen = scr_mgr_current();
+
+	s->scene_mode = RESUME_SCENE_NONE;
+	s->playlist_item = -1;
+	for (uint8_t i = 0; i < player_count; i++)
+	{
+		ScenePlayer* p = players[i];
+		if (!p->isPlaying() || p->getPath() == NULL) continue;
+		int32_t frame = p->getShownFrame();
+		s->frame = frame > 0 ? frame : 0;
+		s->fps = p->getFps();
+		strlcpy(s->scene, p->getPath(), sizeof(s->scene));
+		s->scene_mode = RESUME_SCENE_SINGLE;
+		break;
+	}
+	if (playlist.isRunning())
+	{
+		s->scene_mode = RESUME_SCENE_PLAYLIST;
+		s->playlist_item = playlist.current();
+	}
+
+	for (uint8_t i = 0; i < RESUME_SCROLL_MAX; i++)
+	{
+		if (pages[i] == NULL) continue;
+		lv_obj_t* scrl = lv_page_get_scrollable(pages[i]);
+		s->scroll[i][0] = lv_obj_get_x(scrl);
+		s->scroll[i][1] = lv_obj_get_y(scrl);
+	}
+
+	// 稳定运行一段时间后不再计为恢复失败
+	if (!stable && millis() - started_ms >= RESUME_STABLE_MS)
+	{
+		stable = true;
+		s->restores = 0;
+	}
+}
+
+/**
+ * 有变化时写入RTC快照（只是内存写入，可以频繁调用）
+ */
+void ResumeState::save()
+{
+	ResumeSnapshot s;
+	capture(&s);
+	s.crc = checksum(&s);
+	if (s.crc != rtc_snapshot.crc) rtc_snapshot = s;
+}
+
+void ResumeState::pollCb(lv_task_t* t)
+{
+	((ResumeState*)t->user_data)->save();
+}
+
+/**
+ * 恢复前台应用（应用登记之后调用）；界面由setup_ui_at(getScreen())恢复
+ */
+bool ResumeState::restoreUi()
+{
+	if (!valid) return false;
+	if (restored.app[0])
+	{
+		int id = apps.find(restored.app);
+		if (id >= 0 && apps.open(id)) return true;
+	}
+	if (restored.screen >= 0 && scr_mgr_current() != restored.screen)
+		return gui_load((gui_scr_t)restored.screen, LV_SCR_LOAD_ANIM_NONE) != NULL;
+	return restored.screen >= 0;
+}
+
+/**
+ * 继续播放上次的场景（SD卡挂载之后调用）
+ */
+bool ResumeState::restoreScene(lv_obj_t* canvas)
+{
+	if (!valid || canvas == NULL) return false;
+
+	if (restored.scene_mode == RESUME_SCENE_PLAYLIST)
+		return playlist.load() && playlist.start(canvas, restored.playlist_item > 0 ? restored.playlist_item : 0);
+
+	if (restored.scene_mode != RESUME_SCENE_SINGLE || player_count == 0) return false;
+	ScenePlayer* p = players[0];
+	if (!p->open(restored.scene, 0, restored.fps)) return false;
+	if (!p->seek(restored.frame)) LOG_D("resume", "%s从第0帧开始", restored.scene);
+	p->play(canvas);
+	return true;
+}
@@ -20,15 +20,31 @@
  * - 时序要求：严格的高低电平时序
  * - 级联控制：支持多LED串联
  * - 刷新频率：可达400Hz
+ *
+ * 刷新方式：
+ * - 颜色与亮度修改只写缓冲区，esp_timer每RGB_FRAME_US唤醒刷新任务，合成各图层后发送一次
+ * - FastLED的RMT驱动异步产生波形，发送期间不关中断，不干扰SPI屏幕与SD卡
  */
 
 #include "rgb_led.h"
 #include <FastLED.h>     // 高性能LED控制库
+#include "imu.h"         // 运动辉光读取角速度
+#include "fixed_math.h"
+#include "energy.h"      // 发送的亮度计入能耗估计
 
-// RGB LED颜色缓冲区数组
-// 每个元素对应一颗LED的RGB颜色值
-// CRGB结构体包含红、绿、蓝三个8位颜色分量
-CRGB color_buffers[RGB_LED_NUM];
+// 伽马校正表（线性亮度 -> 发送值），init时生成
+static uint8_t gamma_lut[256];
+
+/**
+ * 向目标靠近RGB_AMBIENT_EASE/256，至少移动1，保证最终到达
+ */
+static inline uint8_t ease8(uint8_t cur, uint8_t target)
+{
+	if (cur == target) return cur;
+	uint8_t step = scale8(cur > target ? cur - target : target - cur, RGB_AMBIENT_EASE);
+	if (step == 0) step = 1;
+	return cur > target ? cur - step : cur + step;
+}
 
 
 /**
@@ -40,13 +56,39 @@ CRGB color_buffers[RGB_LED_NUM];
  * - 颜色顺序：GRB（WS2812的标准格式）
  * - LED数量：RGB_LED_NUM（定义的LED总数）
  * - 默认亮度：200/255（约78%亮度）
+ *
+ * 同时启动刷新任务，此后所有发送都在该任务中完成
  */
 void Pixel::init()
 {
-	// 添加WS2812 LED灯带，指定引脚和颜色缓冲区
-	FastLED.addLeds<WS2812, RGB_LED_PIN, GRB>(color_buffers, RGB_LED_NUM);
+	lock = portMUX_INITIALIZER_UNLOCKED;
+	mode = RGB_ANIM_NONE;
+	pulse_left = 0;
+	brightness = 200;
+	dirty = true;
+	ambient_amount = ambient_level = 0;
+	ambient_target = ambient_cur = CRGB::Black;
+	glow_imu = NULL;
+	glow_level = 0;
+	rate_div = 1;
+	tick_count = 0;
+
+	for (uint16_t i = 0; i < 256; i++) gamma_lut[i] = (uint8_t)(powf(i / 255.0f, RGB_GAMMA) * 255.0f + 0.5f);
+
+	// 添加WS2812 LED灯带，指定引脚和发送缓冲区
+	FastLED.addLeds<WS2812, RGB_LED_PIN, GRB>(out_buffers, RGB_LED_NUM);
 	// 设置全局亮度，避免过亮影响视觉体验
-	FastLED.setBrightness(200);
+	FastLED.setBrightness(brightness);
+	FastLED.setDither(RGB_DITHER ? BINARY_DITHER : DISABLE_DITHER);
+
+	xTaskCreatePinnedToCore(taskEntry, "rgb", RGB_TASK_STACK, this, RGB_TASK_PRIO, &task, RGB_TASK_CORE);
+
+	// 节拍只唤醒刷新任务，RMT发送需要在任务中等待完成
+	esp_timer_create_args_t args = {};
+	args.callback = tickCb;
+	args.arg = this;
+	args.name = "rgb";
+	if (esp_timer_create(&args, &timer) == ESP_OK) esp_timer_start_periodic(timer, RGB_FRAME_US);
 }
 
 /**
@@ -58,14 +100,16 @@ void Pixel::init()
  * @param b 蓝色分量（0-255）
  * @return Pixel& 返回自身引用，支持链式调用
  * 
- * 注意：调用后立即刷新显示，适合单次颜色设置
+ * 注意：只写缓冲区，下一帧统一发送；链式调用多次也只发送一次
  */
 Pixel& Pixel::setRGB(int id, int r, int g, int b)
 {
-	// 将RGB值写入指定LED的颜色缓冲区
+	if (id < 0 || id >= RGB_LED_NUM) return *this;
+
+	portENTER_CRITICAL(&lock);
 	color_buffers[id] = CRGB(r, g, b);
-	// 立即将缓冲区数据发送到LED硬件显示
-	FastLED.show();
+	dirty = true;
+	portEXIT_CRITICAL(&lock);
 
 	return *this;
 }
@@ -85,10 +129,280 @@ Pixel& Pixel::setBrightness(float duty)
 {
 	// 限制亮度值在有效范围内（0-1）
 	duty = constrain(duty, 0, 1);
-	// 将浮点亮度转换为8位整数（0-255）
-	FastLED.setBrightness((uint8_t)(255 * duty));
-	// 应用新的亮度设置到所有LED
-	FastLED.show();
+	// 将浮点亮度转换为8位整数（0-255），下一帧生效
+	brightness = (uint8_t)(255 * duty);
+	dirty = true;
+
+	return *this;
+}
+
+/**
+ * 播放关键帧动画（循环），最后一帧到第一帧之间同样插值
+ *
+ * @param keyframes 关键帧数组，time递增，最后一帧的time即循环周期
+ * @param count     帧数（超过RGB_MAX_KEYFRAMES的部分忽略）
+ */
+Pixel& Pixel::play(const RgbKeyframe* keyframes, uint8_t count)
+{
+	if (count == 0) return stop();
+	if (count > RGB_MAX_KEYFRAMES) count = RGB_MAX_KEYFRAMES;
+
+	portENTER_CRITICAL(&lock);
+	memcpy(frames, keyframes, count * sizeof(RgbKeyframe));
+	frame_count = count;
+	anim_period = keyframes[count - 1].time ? keyframes[count - 1].time : 1;
+	anim_start = millis();
+	mode = RGB_ANIM_KEYFRAMES;
+	dirty = true;
+	portEXIT_CRITICAL(&lock);
+
+	return *this;
+}
+
+/**
+ * 呼吸灯：亮度在10%~100%之间往复
+ */
+Pixel& Pixel::breathe(int r, int g, int b, uint16_t period_ms)
+{
+	RgbKeyframe k[3] = {
+		{ 0, (uint8_t)(r / 10), (uint8_t)(g / 10), (uint8_t)(b / 10) },
+		{ (uint16_t)(period_ms / 2), (uint8_t)r, (uint8_t)g, (uint8_t)b },
+		{ period_ms, (uint8_t)(r / 10), (uint8_t)(g / 10), (uint8_t)(b / 10) },
+	};
+	return play(k, 3);
+}
+
+/**
+ * 彩虹：色相循环，两颗LED相位错开半周
+ */
+Pixel& Pixel::rainbow(uint16_t period_ms)
+{
+	portENTER_CRITICAL(&lock);
+	anim_period = period_ms ? period_ms : 1;
+	anim_start = millis();
+	mode = RGB_ANIM_RAINBOW;
+	dirty = true;
+	portEXIT_CRITICAL(&lock);
+
+	return *this;
+}
+
+/**
+ * 通知闪烁：叠加在当前效果之上闪烁count次（每次亮150ms、灭150ms），结束后自动恢复
+ */
+Pixel& Pixel::pulse(int r, int g, int b, uint8_t count)
+{
+	portENTER_CRITICAL(&lock);
+	pulse_color = CRGB(r, g, b);
+	pulse_left = count;
+	pulse_start = millis();
+	dirty = true;
+	portEXIT_CRITICAL(&lock);
+
+	return *this;
+}
+
+/**
+ * 停止动画，恢复setRGB设置的静态颜色
+ */
+Pixel& Pixel::stop()
+{
+	portENTER_CRITICAL(&lock);
+	mode = RGB_ANIM_NONE;
+	pulse_left = 0;
+	dirty = true;
+	portEXIT_CRITICAL(&lock);
+
+	return *this;
+}
+
+/**
+ * 环境色图层：与基础层按amount/255混合（如当前场景的平均色），颜色变化时渐变过渡
+ */
+Pixel& Pixel::setAmbient(int r, int g, int b, uint8_t amount)
+{
+	portENTER_CRITICAL(&lock);
+	// 从无到有时直接从目标颜色开始，只渐变比例
+	if (ambient_level == 0) ambient_cur = CRGB(r, g, b);
+	ambient_target = CRGB(r, g, b);
+	ambient_amount = amount;
+	dirty = true;
+	portEXIT_CRITICAL(&lock);
 
 	return *this;
 }
+
+/**
+ * 关闭环境色图层（渐隐）
+ */
+Pixel& Pixel::clearAmbient()
+{
+	portENTER_CRITICAL(&lock);
+	ambient_amount = 0;
+	dirty = true;
+	portEXIT_CRITICAL(&lock);
+
+	return *this;
+}
+
+/**
+ * 运动辉光：按imu的角速度叠加颜色，imu为NULL时关闭
+ * 角速度在刷新任务中读取（传感器任务更新），不需要调用方逐帧设置
+ */
+Pixel& Pixel::setGlow(IMU* imu, int r, int g, int b)
+{
+	portENTER_CRITICAL(&lock);
+	glow_imu = imu;
+	glow_color = CRGB(r, g, b);
+	if (imu == NULL) glow_level = 0;
+	dirty = true;
+	portEXIT_CRITICAL(&lock);
+
+	return *this;
+}
+
+/**
+ * 关键帧插值
+ */
+CRGB Pixel::sampleKeyframes(uint32_t t)
+{
+	if (t <= frames[0].time || frame_count == 1)
+		return CRGB(frames[0].r, frames[0].g, frames[0].b);
+
+	for (uint8_t i = 1; i < frame_count; i++)
+	{
+		if (t < frames[i].time)
+		{
+			const RgbKeyframe& a = frames[i - 1];
+			const RgbKeyframe& b = frames[i];
+			fract8 f = (t - a.time) * 255 / (b.time - a.time);
+			return CRGB(lerp8by8(a.r, b.r, f), lerp8by8(a.g, b.g, f), lerp8by8(a.b, b.b, f));
+		}
+	}
+	const RgbKeyframe& last = frames[frame_count - 1];
+	return CRGB(last.r, last.g, last.b);
+}
+
+/**
+ * 合成当前节拍要发送的颜色（持锁调用）
+ * @return 下一个节拍仍需要重新合成（动画、渐变或辉光进行中）
+ */
+bool Pixel::render(uint32_t now)
+{
+	bool busy = mode != RGB_ANIM_NONE;
+	uint32_t t = mode != RGB_ANIM_NONE ? (now - anim_start) % anim_period : 0;
+
+	for (uint8_t i = 0; i < RGB_LED_NUM; i++)
+	{
+		if (mode == RGB_ANIM_KEYFRAMES) out_buffers[i] = sampleKeyframes(t);
+		else if (mode == RGB_ANIM_RAINBOW)
+			out_buffers[i] = CHSV((t * 255 / anim_period) + i * 128 / RGB_LED_NUM, 255, 255);
+		else out_buffers[i] = color_buffers[i];
+	}
+
+	// 环境色：颜色与比例渐变到目标
+	if (ambient_level != ambient_amount || ambient_cur != ambient_target)
+	{
+		ambient_level = ease8(ambient_level, ambient_amount);
+		ambient_cur = CRGB(ease8(ambient_cur.r, ambient_target.r), ease8(ambient_cur.g, ambient_target.g),
+						   ease8(ambient_cur.b, ambient_target.b));
+		busy = true;
+	}
+	if (ambient_level > 0)
+	{
+		for (uint8_t i = 0; i < RGB_LED_NUM; i++) out_buffers[i] = blend(out_buffers[i], ambient_cur, ambient_level);
+	}
+
+	// 辉光：角速度越大越亮（立即跟随），静止后逐渐衰减
+	SensorSample s;
+	if (glow_imu && sensorbus.get(SENSOR_IMU, &s))
+	{
+		int32_t gx = s.gyro[0], gy = s.gyro[1], gz = s.gyro[2];
+		uint32_t w = fx_isqrt((uint32_t)(gx * gx) + (uint32_t)(gy * gy) + (uint32_t)(gz * gz));
+		uint8_t target = (uint8_t)min(w / RGB_GLOW_DIV, (uint32_t)255);
+		glow_level = max(target, (uint8_t)qsub8(glow_level, RGB_GLOW_DECAY));
+		if (glow_level > 0)
+		{
+			CRGB add = glow_color;
+			add.nscale8_video(glow_level);
+			for (uint8_t i = 0; i < RGB_LED_NUM; i++) out_buffers[i] += add;
+		}
+		busy = true;
+	}
+
+	if (pulse_left > 0)
+	{
+		uint32_t dt = now - pulse_start;
+		if (dt >= 300)
+		{
+			pulse_left--;
+			pulse_start += 300;
+			dt -= 300;
+		}
+		if (pulse_left > 0 && dt < 150)
+			for (uint8_t i = 0; i < RGB_LED_NUM; i++) out_buffers[i] = pulse_color;
+		// 闪烁结束后需要再发送一帧恢复原颜色
+		busy = true;
+	}
+
+	for (uint8_t i = 0; i < RGB_LED_NUM; i++)
+	{
+		out_buffers[i] = CRGB(gamma_lut[out_buffers[i].r], gamma_lut[out_buffers[i].g], gamma_lut[out_buffers[i].b]);
+	}
+	return busy;
+}
+
+Pixel& Pixel::setRateDivider(uint8_t div)
+{
+	rate_div = div ? div : 1;
+	return *this;
+}
+
+/**
+ * 节拍回调（esp_timer任务）：每rate_div个节拍唤醒一次刷新任务
+ */
+void Pixel::tickCb(void* arg)
+{
+	Pixel* self = (Pixel*)arg;
+	if (++self->tick_count < self->rate_div) return;
+	self->tick_count = 0;
+	xTaskNotifyGive(self->task);
+}
+
+/**
+ * 刷新任务：每个节拍合成一次，有变化（或开启了抖动）时发送
+ */
+void Pixel::taskEntry(void* arg)
+{
+	Pixel* self = (Pixel*)arg;
+	bool busy = true;
+
+	for (;;)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		bool send, changed;
+		portENTER_CRITICAL(&self->lock);
+		send = RGB_DITHER || self->dirty || busy;
+		changed = self->dirty || busy;
+		if (changed)
+		{
+			self->dirty = false;
+			busy = self->render(millis());
+		}
+		portEXIT_CRITICAL(&self->lock);
+
+		if (changed)
+		{
+			// 能耗估计：各通道实际发送的值之和（out_buffers只在本任务中修改）
+			uint32_t level = 0;
+			for (uint8_t i = 0; i < RGB_LED_NUM; i++)
+				level += self->out_buffers[i].r + self->out_buffers[i].g + self->out_buffers[i].b;
+			energy.setLed(level * self->brightness / 255, RGB_LED_NUM);
+		}
+		if (!send) continue;
+		// RMT发送期间本任务在信号量上挂起，其他任务照常运行
+		FastLED.setBrightness(self->brightness);
+		FastLED.show();
+	}
+}
@@ -0,0 +1,299 @@
+/*
+ * HoloCubic 运行时任务模块
+ *
+ * 功能说明：
+ * 1. 创建LVGL渲染任务并固定在核心1，独占lv_task_handler调用
+ * 2. 创建传感器任务并固定在核心0，I2C读取不再占用帧时间；IMU与环境光都由该任务按各自的周期读取，
+ *    样本经传感器总线（sensor_bus.h）发布给各功能
+ * 3. 提供线程安全的UI消息队列，其他模块通过post()投递界面更新
+ * 4. 提供递归互斥锁，供初始化等少量需要直接访问LVGL的场景使用
+ * 5. 自适应调度：LVGL任务按最近一个定时器（动画、刷新、读取）的到期时间休眠，
+ *    UI消息与编码器事件通过任务通知提前唤醒；没有变化时不重绘，空闲时不再空转
+ * 6. 按界面设置刷新周期（如场景60Hz、时钟1Hz），切换界面时生效
+ * 7. 与电源管理配合：处理期间持有CPU最高频率锁，休眠等待时释放；待机时刷新降到1Hz
+ * 8. 两个任务的每轮处理登记在任务监视器（supervisor.h），停顿时长进入遥测
+ *
+ * 使用约定：
+ * - begin()之后，除LVGL任务外的任何任务都不应直接调用lv_*接口
+ * - 需要更新界面时调用runtime.post(cb, obj, value)，cb在LVGL任务中执行
+ * - ISR中使用postFromISR()
+ */
+
+#include "runtime.h"
+#include "lv_port_indev.h"
+#include "power.h"
+#include "i2c_bus.h"
+#include "supervisor.h"
+#include "logger.h"
+#include "sensor_bus.h"
+
+// 传感器任务停顿或连续失败时的恢复动作（在传感器任务中执行，不与其I2C读写并发）
+static bool recoverSensorBus(void* user)
+{
+	return i2c_bus.recover();
+}
+
+/**
+ * 启动运行时任务
+ * 必须在LVGL、显示屏与GUI初始化完成后调用
+ *
+ * @param display 显示对象（LVGL任务中调用其routine）
+ * @param sensor  IMU对象（传感器任务中调用其update）
+ */
+void Runtime::begin(Display* display, IMU* sensor)
+{
+	disp = display;
+	imu = sensor;
+	refr_scr = NULL;
+	standby = false;
+	wakeups = 0;
+
+	ui_queue = xQueueCreate(UI_QUEUE_LEN, sizeof(UiMsg));
+	ui_mutex = xSemaphoreCreateRecursiveMutex();
+	ui_sup = supervisor.add("lvgl", UI_STALL_MS);
+	sensor_sup = supervisor.add("sensor", SENSOR_STALL_MS, recoverSensorBus);
+
+	xTaskCreatePinnedToCore(uiTaskEntry, "lvgl", UI_TASK_STACK, this,
+							UI_TASK_PRIORITY, &ui_task, UI_TASK_CORE);
+	// 编码器空闲时暂停LVGL的周期读取，手势事件到达时唤醒
+	lv_port_indev_set_wake_cb(inputWake);
+	xTaskCreatePinnedToCore(sensorTaskEntry, "sensor", SENSOR_TASK_STACK, this,
+							SENSOR_TASK_PRIORITY, &sensor_task, SENSOR_TASK_CORE);
+}
+
+/**
+ * 投递UI消息（任务上下文）
+ * 队列满时立即返回false，不阻塞调用方
+ */
+bool Runtime::post(ui_msg_cb_t cb, void* obj, int32_t value)
+{
+	if (ui_queue == NULL) return false;
+
+	UiMsg msg = { cb, obj, value };
+	if (xQueueSend(ui_queue, &msg, 0) != pdTRUE) return false;
+	wake(UI_WAKE_MSG);
+	return true;
+}
+
+/**
+ * 投递UI消息（中断上下文）
+ */
+bool Runtime::postFromISR(ui_msg_cb_t cb, void* obj, int32_t value)
+{
+	if (ui_queue == NULL) return false;
+
+	UiMsg msg = { cb, obj, value };
+	BaseType_t woken = pdFALSE;
+	BaseType_t ok = xQueueSendFromISR(ui_queue, &msg, &woken);
+	if (ok == pdTRUE) xTaskNotifyFromISR(ui_task, UI_WAKE_MSG, eSetBits, &woken);
+	if (woken) portYIELD_FROM_ISR();
+	return ok == pdTRUE;
+}
+
+/**
+ * 获取LVGL互斥锁（可重入）
+ * LVGL任务在每轮处理期间持有该锁
+ */
+void Runtime::lock()
+{
+	if (ui_mutex) xSemaphoreTakeRecursive(ui_mutex, portMAX_DELAY);
+}
+
+void Runtime::unlock()
+{
+	if (ui_mutex) xSemaphoreGiveRecursive(ui_mutex);
+}
+
+/**
+ * 提前唤醒LVGL任务（任务上下文）
+ * 通知位会保留到下一次等待，LVGL任务正在运行时调用也不会丢失
+ *
+ * @param reason UI_WAKE_*
+ */
+void Runtime::wake(uint32_t reason)
+{
+	if (ui_task) xTaskNotify(ui_task, reason, eSetBits);
+}
+
+/**
+ * 编码器事件写入后的唤醒回调（传感器任务）
+ * 同时作为用户活动通知电源管理，调暗/待机时恢复背光
+ */
+void Runtime::inputWake()
+{
+	power.activity();
+	runtime.wake(UI_WAKE_INPUT);
+}
+
+/**
+ * 设置界面的刷新周期（LVGL刷新任务的周期，即最高帧率）
+ * 必须在LVGL任务中调用；界面删除前应以period_ms=0移除
+ *
+ * @param scr       界面（屏幕对象）
+ * @param period_ms 刷新周期，0表示恢复默认值UI_REFR_DEFAULT_MS
+ * @return 表已满时返回false
+ */
+bool Runtime::setScreenRefresh(lv_obj_t* scr, uint16_t period_ms)
+{
+	uint8_t i = 0;
+	while (i < refr_count && refr[i].scr != scr) i++;
+
+	if (period_ms == 0)
+	{
+		if (i < refr_count) refr[i] = refr[--refr_count];
+	}
+	else if (i < refr_count)
+	{
+		refr[i].period = period_ms;
+	}
+	else if (refr_count < UI_REFR_SCREEN_MAX)
+	{
+		refr[refr_count].scr = scr;
+		refr[refr_count].period = period_ms;
+		refr_count++;
+	}
+	else
+	{
+		LOG_E("runtime", "界面刷新周期表已满");
+		return false;
+	}
+
+	// 下一轮重新应用（可能正是当前界面）
+	refr_scr = NULL;
+	return true;
+}
+
+/**
+ * 进入/退出待机（可在任意任务中调用）
+ * 待机时刷新周期不低于UI_REFR_STANDBY_MS，退出后恢复当前界面的设定
+ */
+void Runtime::setStandby(bool enable)
+{
+	if (standby == enable) return;
+	standby = enable;
+	// 下一轮重新应用
+	refr_scr = NULL;
+	wake(UI_WAKE_MSG);
+}
+
+/**
+ * 当前界面（或待机状态）变化时切换LVGL刷新任务的周期
+ */
+void Runtime::applyRefresh()
+{
+	lv_disp_t* d = lv_disp_get_default();
+	if (d == NULL || d->act_scr == refr_scr) return;
+	refr_scr = d->act_scr;
+
+	uint16_t period = UI_REFR_DEFAULT_MS;
+	for (uint8_t i = 0; i < refr_count; i++)
+	{
+		if (refr[i].scr == refr_scr) period = refr[i].period;
+	}
+	if (standby && period < UI_REFR_STANDBY_MS) period = UI_REFR_STANDBY_MS;
+	lv_task_set_period(d->refr_task, period);
+}
+
+TaskHandle_t Runtime::getUiTask()
+{
+	return ui_task;
+}
+
+/**
+ * LVGL任务被唤醒（休眠结束或被通知）的累计次数，可用于估算空闲程度
+ */
+uint32_t Runtime::getWakeups()
+{
+	return wakeups;
+}
+
+/**
+ * 在LVGL任务中执行队列内所有待处理的UI消息
+ */
+void Runtime::drainQueue()
+{
+	UiMsg msg;
+	while (xQueueReceive(ui_queue, &msg, 0) == pdTRUE)
+	{
+		if (msg.cb) msg.cb(&msg);
+	}
+}
+
+/**
+ * LVGL渲染任务
+ * 每轮先处理UI消息，再调用lv_task_handler完成动画、输入与刷新，
+ * 然后休眠到最近一个LVGL定时器到期（无效区域为空时刷新任务处于关闭状态，不参与计算）
+ */
+void Runtime::uiTaskEntry(void* arg)
+{
+	Runtime* self = (Runtime*)arg;
+	uint32_t reason = 0;
+
+	for (;;)
+	{
+		// 等锁的时间也计入：其他任务长时间持有LVGL锁同样会卡住界面
+		supervisor.enter(self->ui_sup);
+		power.busyBegin();
+		self->lock();
+		if (reason & UI_WAKE_INPUT) lv_port_indev_resume();
+		self->drainQueue();
+		self->applyRefresh();
+		uint32_t next = self->disp->routine();
+		self->unlock();
+		power.busyEnd();
+		supervisor.leave(self->ui_sup);
+
+		// 至少等待1个tick，保证同核心的低优先级任务能够运行
+		if (next > UI_IDLE_MAX_MS) next = UI_IDLE_MAX_MS;
+		TickType_t ticks = pdMS_TO_TICKS(next);
+		if (ticks == 0) ticks = 1;
+
+		reason = 0;
+		xTaskNotifyWait(0, UINT32_MAX, &reason, ticks);
+		self->wakeups++;
+	}
+}
+
+/**
+ * 读取一次IMU（计入传感器阶段的耗时）
+ */
+void Runtime::readImu()
+{
+	supervisor.enter(sensor_sup);
+	imu->update();
+	supervisor.leave(sensor_sup);
+}
+
+/**
+ * 传感器任务
+ * 每轮先由传感器总线提交到期的环境光读取，等待时间不超过下一次到期
+ * 轮询模式：以固定周期读取IMU并更新手势状态
+ * FIFO/DMP模式：等待数据就绪中断（或超时）后批量读出FIFO
+ * 运动唤醒期间（IMU::suspend）：等待运动中断或IMU_SLEEP_POLL_MS后检查一次运动标志
+ */
+void Runtime::sensorTaskEntry(void* arg)
+{
+	Runtime* self = (Runtime*)arg;
+	TickType_t last_wake = xTaskGetTickCount();
+
+	self->imu->attachTask(xTaskGetCurrentTaskHandle());
+	for (;;)
+	{
+		uint32_t due = sensorbus.poll(millis());
+		if (self->imu->isSuspended())
+		{
+			self->imu->waitData(pdMS_TO_TICKS(min(due, (uint32_t)IMU_SLEEP_POLL_MS)));
+			self->readImu();
+			last_wake = xTaskGetTickCount();
+			continue;
+		}
+		if (self->imu->getMode() != IMU_MODE_POLL)
+		{
+			self->imu->waitData(pdMS_TO_TICKS(min(due, (uint32_t)SENSOR_FIFO_WAIT_MS)));
+			self->readImu();
+			continue;
+		}
+		self->readImu();
+		vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SENSOR_TASK_PERIOD_MS));
+	}
+}
@@ -0,0 +1,240 @@
+/*
+ * HoloCubic 场景播放基准
+ *
+ * 功能说明：
+ * 1. 通过runtime.post在LVGL任务中启用渲染计时、创建顶层全屏图像并播放参考动画包，调用方等待执行完成
+ * 2. 预热后取一次累计值，等待计时窗口后再取一次，两次求差；各阶段的忙碌时间除以窗口时长即为占用率
+ * 3. 预读任务（sd_read）与LVGL任务（decode + 刷新任务）是两条串行的流水线，占用率较高的一条决定可持续帧率
+ * 4. 结果输出到串口，并追加一行到SD卡CSV（设备MAC作为第一列，多台设备的结果可直接合并比较）
+ *
+ * 数据流：
+ *   run --> uiStart（LVGL任务）--> 预热 --> snap --> 计时窗口 --> snap --> uiStop（LVGL任务）--> report：串口 + CSV
+ */
+
+#include "scene_bench.h"
+#include "sd_card.h"
+#include "sd_hotplug.h"
+#include "logger.h"
+
+SceneBench scenebench;
+
+SceneBench::SceneBench()
+{
+	player = NULL;
+	path[0] = '\0';
+	canvas = NULL;
+	ui_done = false;
+	opened = false;
+	prof_was = false;
+	seconds = SCENE_BENCH_SECONDS;
+	task = NULL;
+	running = false;
+	result_fps = 0;
+}
+
+/**
+ * 交给LVGL任务执行cb并等待完成（cb结束时置ui_done）
+ */
+bool SceneBench::callUi(ui_msg_cb_t cb)
+{
+	ui_done = false;
+	if (!runtime.post(cb, this)) return false;
+	for (uint32_t t = 0; !ui_done; t += 10)
+	{
+		if (t >= SCENE_BENCH_UI_TIMEOUT_MS) return false;
+		vTaskDelay(pdMS_TO_TICKS(10));
+	}
+	return true;
+}
+
+void SceneBench::uiStart(const UiMsg* msg)
+{
+	SceneBench* self = (SceneBench*)msg->obj;
+	self->prof_was = render_prof_is_enabled();
+	render_prof_enable(true);
+
+	// 顶层图像：任何界面下都可见且在最上方（满足直接写屏的条件），播放器按帧尺寸摆放
+	self->canvas = lv_img_create(lv_layer_top(), NULL);
+	self->opened = false;
+	if (self->canvas)
+	{
+		lv_obj_set_size(self->canvas, LV_HOR_RES, LV_VER_RES);
+		lv_obj_align(self->canvas, NULL, LV_ALIGN_CENTER, 0, 0);
+		self->player->close();
+		self->opened = self->player->open(self->path, 0, SCENE_BENCH_FPS);
+		if (self->opened) self->player->play(self->canvas);
+	}
+	self->ui_done = true;
+}
+
+void SceneBench::uiStop(const UiMsg* msg)
+{
+	SceneBench* self = (SceneBench*)msg->obj;
+	self->player->close();
+	if (self->canvas) lv_obj_del(self->canvas);
+	self->canvas = NULL;
+	if (!self->prof_was) render_prof_enable(false);
+	// 直接写屏的帧不经过LVGL，整屏重绘恢复原界面
+	lv_obj_invalidate(lv_scr_act());
+	self->ui_done = true;
+}
+
+void SceneBench::snap(SceneBenchSnap* s)
+{
+	s->t_us = micros();
+	s->refr = render_prof_get_totals(s->us);
+	player->getStats(&s->player);
+}
+
+static float per_frame(uint32_t us, uint32_t n)
+{
+	return n ? (float)us / n : 0;
+}
+
+static float occupancy(uint32_t us, uint32_t wall)
+{
+	return wall ? 100.0f * us / wall : 0;
+}
+
+void SceneBench::report(const SceneBenchSnap* a, const SceneBenchSnap* b)
+{
+	uint32_t wall = b->t_us - a->t_us;
+	uint32_t reads = b->player.reads - a->player.reads;
+	uint32_t read_us = b->player.read_us - a->player.read_us;
+	uint32_t read_bytes = b->player.read_bytes - a->player.read_bytes;
+	uint32_t shown = b->player.shown - a->player.shown;
+	uint32_t present_us = b->player.present_us - a->player.present_us;
+	uint32_t refr = b->refr - a->refr;
+	uint32_t draw_us = b->us[RENDER_PROF_DRAW] - a->us[RENDER_PROF_DRAW];
+	uint32_t spi_us = b->us[RENDER_PROF_SPI] - a->us[RENDER_PROF_SPI];
+	uint32_t frame_us = b->us[RENDER_PROF_FRAME] - a->us[RENDER_PROF_FRAME];
+	uint32_t wait_us = b->player.free_wait_us - a->player.free_wait_us;
+	uint32_t repeated = b->player.repeated - a->player.repeated;
+	uint32_t dropped = b->player.dropped - a->player.dropped;
+	uint32_t corrupt = b->player.corrupt - a->player.corrupt;
+	uint32_t depth_sum = b->player.depth_sum - a->player.depth_sum;
+
+	// 每帧耗时：读取按读取次数，其余按上屏帧数（刷新任务一次可能包含多帧中的最后一帧）
+	struct
+	{
+		const char* name;
+		float us;
+		float occ;
+	} stages[] = {
+		{ "sd_read",   per_frame(read_us, reads),              occupancy(read_us, wall) },
+		{ "decode",    per_frame(present_us, shown),           occupancy(present_us, wall) },
+		{ "lvgl_draw", per_frame(draw_us, shown),              occupancy(draw_us, wall) },
+		{ "spi",       per_frame(spi_us, shown),               occupancy(spi_us, wall) },
+		{ "lvgl_task", per_frame(frame_us + present_us, shown), occupancy(frame_us + present_us, wall) },
+	};
+	for (uint8_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++)
+		Serial.printf("SCENEBENCH,stage,%s,%.0f,%.1f\n", stages[i].name, stages[i].us, stages[i].occ);
+
+	float fps = wall ? shown * 1e6f / wall : 0;
+	float occ_sd = stages[0].occ;
+	float occ_lvgl = stages[4].occ;
+	float occ_max = LV_MATH_MAX(occ_sd, occ_lvgl);
+	float bound = occ_max > 0 ? fps * 100.0f / occ_max : 0;
+	// 瓶颈：SD读取，或LVGL任务中占用最高的阶段
+	const char* limit = "sd_read";
+	if (occ_lvgl > occ_sd)
+	{
+		uint8_t m = 1;
+		for (uint8_t i = 2; i <= 3; i++)
+			if (stages[i].occ > stages[m].occ) m = i;
+		limit = stages[m].name;
+	}
+	float depth_avg = shown ? (float)depth_sum / shown : 0;
+	float mbps = read_us ? (float)read_bytes / read_us : 0;
+
+	Serial.printf("SCENEBENCH,queue,%.2f,%u,%u\n", depth_avg, b->player.depth_max, b->player.slots);
+	Serial.printf("SCENEBENCH,stall,%.1f,%u,%u,%u\n", occupancy(wait_us, wall), repeated, dropped, corrupt);
+	Serial.printf("SCENEBENCH,sd,%.2f,MB/s,%u,max_us\n", mbps, b->player.read_max_us);
+	Serial.printf("SCENEBENCH,refr,%.1f,fps\n", wall ? refr * 1e6f / wall : 0);
+	Serial.printf("SCENEBENCH,result,%.1f,%.1f,%s\n", fps, bound, limit);
+	result_fps = bound;
+
+	if (!sdhotplug.beginIo()) return;
+	SD_FS.mkdir(SCENE_BENCH_DIR);
+	bool header = !SD_FS.exists(SCENE_BENCH_CSV_PATH);
+	File csv = SD_FS.open(SCENE_BENCH_CSV_PATH, FILE_APPEND);
+	if (csv)
+	{
+		if (header)
+			csv.print("unit,cpu_mhz,pack,seconds,fps,bound_fps,limit,sd_us,decode_us,draw_us,spi_us,"
+					  "sd_occ,lvgl_occ,ready_avg,ready_max,repeated,dropped,corrupt,sd_mbps\n");
+		csv.printf("%012llx,%u,%s,%u,%.1f,%.1f,%s,%.0f,%.0f,%.0f,%.0f,%.1f,%.1f,%.2f,%u,%u,%u,%u,%.2f\n",
+				   ESP.getEfuseMac(), getCpuFrequencyMhz(), path, seconds, fps, bound, limit, stages[0].us,
+				   stages[1].us, stages[2].us, stages[3].us, occ_sd, occ_lvgl, depth_avg, b->player.depth_max,
+				   repeated, dropped, corrupt, mbps);
+		csv.close();
+	}
+	sdhotplug.endIo();
+}
+
+bool SceneBench::run(ScenePlayer* scene, const char* pack, uint16_t secs)
+{
+	if (!scene || running) return false;
+	running = true;
+	player = scene;
+	// start()的任务以成员path调用
+	if (pack != path)
+	{
+		strncpy(path, pack, SCENE_PATH_MAX - 1);
+		path[SCENE_PATH_MAX - 1] = '\0';
+	}
+	seconds = secs ? secs : SCENE_BENCH_SECONDS;
+	result_fps = 0;
+
+	Serial.printf("SCENEBENCH,begin,%s,%u\n", path, seconds);
+	bool ok = callUi(uiStart);
+	if (!ok || !opened)
+	{
+		Serial.printf("SCENEBENCH,skip,%s\n", ok ? "open" : "ui_timeout");
+		if (ok) callUi(uiStop);
+		running = false;
+		return false;
+	}
+
+	vTaskDelay(pdMS_TO_TICKS(SCENE_BENCH_WARMUP_MS));
+	SceneBenchSnap a, b;
+	snap(&a);
+	vTaskDelay(pdMS_TO_TICKS((uint32_t)seconds * 1000));
+	snap(&b);
+	callUi(uiStop);
+
+	report(&a, &b);
+	Serial.println("SCENEBENCH,end");
+	LOG_I("scenebench", "%s：可持续%.1f FPS", path, result_fps);
+	running = false;
+	return true;
+}
+
+void SceneBench::taskEntry(void* arg)
+{
+	SceneBench* self = (SceneBench*)arg;
+	self->run(self->player, self->path, self->seconds);
+	self->task = NULL;
+	vTaskDelete(NULL);
+}
+
+bool SceneBench::start(ScenePlayer* scene, const char* pack, uint16_t secs)
+{
+	if (task || running) return false;
+	player = scene;
+	strncpy(path, pack, SCENE_PATH_MAX - 1);
+	path[SCENE_PATH_MAX - 1] = '\0';
+	seconds = secs;
+	return xTaskCreatePinnedToCore(taskEntry, "scenebench", SCENE_BENCH_TASK_STACK, this, SCENE_BENCH_TASK_PRIORITY,
+								   &task, SCENE_BENCH_TASK_CORE) == pdPASS;
+}
+
+bool SceneBench::isRunning()
+{
+	return running;
+}
+
+float SceneBench::getResult()
+{
+	return result_fps;
+}
@@ -0,0 +1,402 @@
+/*
+ * HoloCubic 场景索引
+ *
+ * 功能说明：
+ * 1. 把场景根目录下每个场景（帧目录或.holo动画包）的元数据保存为定长条目：
+ *    名称、帧数、分辨率、格式、时长、第一帧与动画包内各级缩略图的位置
+ * 2. 重建时按修改时间增量更新：未变化的场景沿用旧条目，不打开场景目录
+ * 3. 浏览界面按序号seek读取条目，翻页与场景总数无关
+ * 4. .holo动画包沿FAT链检查是否连续存放，碎片化的包在日志中提示重新上传
+ * 5. 保存播放器得出的帧校验结果（原位改写条目的verify字段），整包校验通过的场景之后不再校验
+ *
+ * 注意事项：
+ * - 重建先写SCENE_INDEX_TMP_FILE，完成后替换SCENE_INDEX_FILE，中途断电时旧索引仍可用
+ * - 重建可能在上传服务（httpd任务）与启动时的后台任务中同时发生，由互斥锁串行
+ */
+
+#include "scene_index.h"
+#include "sd_card.h"
+#include "logger.h"
+#include "telemetry.h"
+#include "quality_gov.h"
+
+static SemaphoreHandle_t build_lock = xSemaphoreCreateMutex();
+static volatile uint32_t index_generation = 0;
+
+SceneIndex::SceneIndex()
+{
+	count = 0;
+	header_size = 0;
+	entry_size = 0;
+	generation = 0;
+	sd_gen = 0;
+}
+
+SceneIndex::~SceneIndex()
+{
+	close();
+}
+
+/**
+ * 打开索引文件，校验文件头
+ * @return 文件不存在或格式不符时返回false（可调用build()重建）
+ */
+bool SceneIndex::open()
+{
+	close();
+	generation = index_generation;
+	sd_gen = tf.generation();
+	file = SD_FS.open(SCENE_INDEX_FILE);
+	if (!file) return false;
+
+	SceneIndexHeader h;
+	if (file.read((uint8_t*)&h, sizeof(h)) != sizeof(h) || memcmp(h.magic, SCENE_INDEX_MAGIC, 4) != 0 ||
+		h.version > SCENE_INDEX_VERSION || h.header_size < sizeof(h) || h.entry_size < sizeof(SceneIndexEntry))
+	{
+		file.close();
+		return false;
+	}
+	count = h.count;
+	header_size = h.header_size;
+	entry_size = h.entry_size;
+	return true;
+}
+
+void SceneIndex::close()
+{
+	if (file) file.close();
+	count = 0;
+}
+
+uint32_t SceneIndex::getCount()
+{
+	return count;
+}
+
+/**
+ * 读取第i个场景（一次seek加一次read）
+ */
+bool SceneIndex::get(uint32_t i, SceneIndexEntry* out)
+{
+	if (!file || i >= count) return false;
+	if (!file.seek(header_size + i * entry_size)) return false;
+	if (file.read((uint8_t*)out, sizeof(SceneIndexEntry)) != sizeof(SceneIndexEntry)) return false;
+	out->name[SCENE_INDEX_NAME_MAX - 1] = '\0';
+	telemetry_sd_io(sizeof(SceneIndexEntry), 0);
+	return true;
+}
+
+int32_t SceneIndex::find(const char* name)
+{
+	SceneIndexEntry e;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (get(i, &e) && strcmp(e.name, name) == 0) return i;
+	}
+	return -1;
+}
+
+/**
+ * 打开之后索引是否已被重建，或SD卡重新挂载过（需要重新打开）
+ */
+bool SceneIndex::isStale()
+{
+	return generation != index_generation || sd_gen != tf.generation();
+}
+
+uint32_t SceneIndex::getGeneration()
+{
+	return index_generation;
+}
+
+const char* SceneIndex::sceneName(const char* path)
+{
+	size_t root = sizeof(SCENE_ROOT) - 1;
+	if (strncmp(path, SCENE_ROOT, root) != 0 || path[root] != '/') return NULL;
+	const char* name = path + root + 1;
+	if (name[0] == '\0' || strchr(name, '/') || strlen(name) >= SCENE_INDEX_NAME_MAX) return NULL;
+	return name;
+}
+
+uint8_t SceneIndex::getVerify(const char* name, uint32_t mtime)
+{
+	SceneIndex idx;
+	SceneIndexEntry e;
+	int32_t i = idx.open() ? idx.find(name) : -1;
+	if (i < 0 || !idx.get(i, &e) || e.mtime != mtime) return SCENE_VERIFY_NONE;
+	return e.verify;
+}
+
+/**
+ * 原位改写条目中的校验字段（与重建互斥；重建中写入临时文件的条目随后沿用旧值，下次播放时重新得出）
+ */
+bool SceneIndex::setVerify(const char* name, uint32_t mtime, uint8_t state, uint16_t bad_frame)
+{
+	xSemaphoreTake(build_lock, portMAX_DELAY);
+	File f = SD_FS.exists(SCENE_INDEX_FILE) ? SD_FS.open(SCENE_INDEX_FILE, "r+") : File();
+	SceneIndexHeader h;
+	bool ok = f && f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && memcmp(h.magic, SCENE_INDEX_MAGIC, 4) == 0 &&
+			  h.version == SCENE_INDEX_VERSION && h.entry_size >= sizeof(SceneIndexEntry);
+	bool found = false;
+	for (uint32_t i = 0; ok && !found && i < h.count; i++)
+	{
+		SceneIndexEntry e;
+		uint32_t pos = h.header_size + i * h.entry_size;
+		if (!f.seek(pos) || f.read((uint8_t*)&e, sizeof(e)) != sizeof(e)) break;
+		e.name[SCENE_INDEX_NAME_MAX - 1] = '\0';
+		if (strcmp(e.name, name) != 0) continue;
+		found = true;
+		if (e.mtime != mtime)
+		{
+			ok = false;
+			break;
+		}
+		e.verify = state;
+		e.bad_frame = bad_frame;
+		uint32_t at = offsetof(SceneIndexEntry, verify);
+		uint32_t n = sizeof(SceneIndexEntry) - at;
+		ok = f.seek(pos + at) && f.write((const uint8_t*)&e + at, n) == n;
+		telemetry_sd_io(0, n);
+	}
+	if (f) f.close();
+	xSemaphoreGive(build_lock);
+	return ok && found;
+}
+
+/**
+ * 帧目录：统计frameNNN.bin（与ScenePlayer::probeFrames的命名一致），读取首帧图像头
+ */
+bool SceneIndex::probeFrames(File& dir, SceneIndexEntry* e)
+{
+	File f;
+	while ((f = dir.openNextFile()))
+	{
+		const char* n = strrchr(f.name(), '/');
+		n = n ? n + 1 : f.name();
+		if (strncmp(n, "frame", 5) == 0 && strlen(n) == 12 && strcmp(n + 8, ".bin") == 0) e->frame_count++;
+		f.close();
+	}
+	if (e->frame_count == 0) return false;
+
+	char path[SCENE_PATH_MAX + 16];
+	snprintf(path, sizeof(path), "%s/%s/frame000.bin", SCENE_ROOT, e->name);
+	f = SD_FS.open(path);
+	lv_img_header_t h;
+	if (f && f.read((uint8_t*)&h, sizeof(h)) == sizeof(h))
+	{
+		e->width = h.w;
+		e->height = h.h;
+		e->cf = h.cf;
+		e->thumb_size = f.size();
+	}
+	if (f) f.close();
+
+	e->format = SCENE_FORMAT_FRAMES;
+	e->duration_ms = e->frame_count * 1000 / SCENE_INDEX_DEFAULT_FPS;
+	return true;
+}
+
+/**
+ * .holo动画包：文件头与第一帧的索引
+ */
+bool SceneIndex::probePack(File& f, SceneIndexEntry* e)
+{
+	HoloHeader hdr;
+	if (f.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || memcmp(hdr.magic, HOLO_MAGIC, 4) != 0 ||
+		hdr.version > HOLO_VERSION || hdr.header_size < HOLO_HEADER_SIZE_MIN || hdr.frame_count == 0)
+		return false;
+	// 旧包的文件头较短，多读的部分是帧索引
+	if (hdr.header_size < sizeof(hdr))
+		memset((uint8_t*)&hdr + hdr.header_size, 0, sizeof(hdr) - hdr.header_size);
+
+	e->format = SCENE_FORMAT_HOLO;
+	e->flags = hdr.flags;
+	e->cf = hdr.cf;
+	e->fps = hdr.fps;
+	// 缩略图按完整画布生成，裁剪过的包也记录画布尺寸
+	bool crop = (hdr.flags & HOLO_FLAG_CROP) && hdr.full_w && hdr.full_h;
+	e->width = crop ? hdr.full_w : hdr.width;
+	e->height = crop ? hdr.full_h : hdr.height;
+	e->frame_count = hdr.frame_count;
+	e->duration_ms = hdr.frame_count * 1000 / (hdr.fps ? hdr.fps : SCENE_INDEX_DEFAULT_FPS);
+	e->verify = hdr.entry_size >= HOLO_ENTRY_SIZE_CRC ? SCENE_VERIFY_PENDING : SCENE_VERIFY_NONE;
+
+	HoloFrameEntry first;
+	if (f.seek(hdr.index_offset) && f.read((uint8_t*)&first, HOLO_ENTRY_SIZE_MIN) == HOLO_ENTRY_SIZE_MIN)
+	{
+		e->thumb_offset = first.offset;
+		e->thumb_size = first.size;
+	}
+
+	// 第一个关键帧的各级缩略图
+	HoloMipEntry mip;
+	uint8_t n = hdr.mip_entry_size < sizeof(mip) ? hdr.mip_entry_size : sizeof(mip);
+	int32_t key = -1;
+	for (uint16_t i = 0; hdr.mip_offset && n >= sizeof(mip) && i < hdr.mip_count; i++)
+	{
+		if (!f.seek(hdr.mip_offset + (uint32_t)i * hdr.mip_entry_size) || f.read((uint8_t*)&mip, n) != n) break;
+		if (key < 0) key = mip.frame;
+		if (mip.frame != key) break;
+		if (mip.level < 1 || mip.level > HOLO_MIP_LEVELS) continue;
+		e->mip_offset[mip.level - 1] = mip.offset;
+		e->mip_size[mip.level - 1] = mip.size;
+	}
+
+	// 连续存放的包播放时按扇区直接读取；碎片化的包只能沿FAT链读取
+	char path[SCENE_PATH_MAX + SCENE_INDEX_NAME_MAX];
+	snprintf(path, sizeof(path), "%s/%s", SCENE_ROOT, e->name);
+	int32_t frags = tf.countFragments(path);
+	e->fragments = frags > 0 ? (frags > 0xFFFF ? 0xFFFF : frags) : 0;
+	if (frags > 1) LOG_W("scene", "动画包不连续: %s（%d个片段），重新上传可改善读取速度", e->name, frags);
+	return true;
+}
+
+/**
+ * 按条目中记录的位置读取一级缩略图，不经过场景索引文件
+ */
+bool SceneIndex::readThumb(const SceneIndexEntry* e, uint16_t max_w, uint16_t max_h, uint8_t* buf, uint32_t cap,
+						   lv_img_dsc_t* out)
+{
+	// 从1/2尺寸起找第一个放得下的级；画质降低时跳过较大的级（没有更小的级时取最小的一级）
+	int8_t level = -1;
+	uint8_t first = LV_MATH_MIN(quality.getMipBias(), HOLO_MIP_LEVELS - 1);
+	for (uint8_t i = first; i < HOLO_MIP_LEVELS && level < 0; i++)
+	{
+		if (e->mip_size[i] && (e->width >> (i + 1)) <= max_w && (e->height >> (i + 1)) <= max_h) level = i;
+	}
+	if (level < 0 || e->mip_size[level] > cap || e->mip_size[level] < sizeof(lv_img_header_t)) return false;
+
+	char path[SCENE_PATH_MAX + SCENE_INDEX_NAME_MAX];
+	snprintf(path, sizeof(path), "%s/%s", SCENE_ROOT, e->name);
+	File f = SD_FS.open(path);
+	if (!f) return false;
+	uint32_t size = e->mip_size[level];
+	bool ok = f.seek(e->mip_offset[level]) && f.read(buf, size) == size;
+	f.close();
+	if (!ok) return false;
+
+	memset(out, 0, sizeof(lv_img_dsc_t));
+	memcpy(&out->header, buf, sizeof(lv_img_header_t));
+	out->data = buf + sizeof(lv_img_header_t);
+	out->data_size = size - sizeof(lv_img_header_t);
+	return out->header.cf == LV_IMG_CF_TRUE_COLOR;
+}
+
+/**
+ * 读取一个场景的元数据
+ * @return 不是场景（空目录、其他文件、名称过长）时返回false
+ */
+bool SceneIndex::probe(File& f, const char* name, SceneIndexEntry* e)
+{
+	size_t len = strlen(name);
+	if (len >= SCENE_INDEX_NAME_MAX) return false;
+
+	memset(e, 0, sizeof(SceneIndexEntry));
+	memcpy(e->name, name, len);
+	e->mtime = (uint32_t)f.getLastWrite();
+
+	if (f.isDirectory()) return probeFrames(f, e);
+	if (len > 5 && strcmp(name + len - 5, ".holo") == 0) return probePack(f, e);
+	return false;
+}
+
+/**
+ * 增量重建索引
+ *
+ * @param changed 内容已变化的场景名（如上传了其中的帧文件），即使修改时间相同也重新读取
+ * @param force   忽略旧索引，全部重新读取
+ * @return 根目录不存在或无法写入时返回false
+ */
+bool SceneIndex::build(const char* changed, bool force)
+{
+	xSemaphoreTake(build_lock, portMAX_DELAY);
+	uint32_t start = millis();
+
+	// 旧条目读入内存后关闭文件，遍历期间同时打开的文件不超过4个
+	SceneIndexEntry* old = NULL;
+	uint32_t old_count = 0;
+	if (!force)
+	{
+		SceneIndex prev;
+		if (prev.open())
+		{
+			old_count = prev.getCount() < SCENE_INDEX_CACHE_MAX ? prev.getCount() : SCENE_INDEX_CACHE_MAX;
+			old = old_count ? (SceneIndexEntry*)malloc(sizeof(SceneIndexEntry) * old_count) : NULL;
+			if (old == NULL) old_count = 0;
+			for (uint32_t i = 0; i < old_count; i++)
+			{
+				if (!prev.get(i, &old[i])) old[i].name[0] = '\0';
+			}
+		}
+	}
+
+	File root = SD_FS.open(SCENE_ROOT);
+	File out = root && root.isDirectory() ? SD_FS.open(SCENE_INDEX_TMP_FILE, FILE_WRITE) : File();
+	if (!out)
+	{
+		free(old);
+		if (root) root.close();
+		xSemaphoreGive(build_lock);
+		return false;
+	}
+
+	SceneIndexHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, SCENE_INDEX_MAGIC, 4);
+	h.version = SCENE_INDEX_VERSION;
+	h.header_size = sizeof(SceneIndexHeader);
+	h.entry_size = sizeof(SceneIndexEntry);
+	out.write((const uint8_t*)&h, sizeof(h));
+
+	uint32_t reused = 0;
+	uint32_t probed = 0;
+	File f;
+	while ((f = root.openNextFile()))
+	{
+		const char* name = strrchr(f.name(), '/');
+		name = name ? name + 1 : f.name();
+
+		SceneIndexEntry e;
+		bool ok = false;
+		uint32_t mtime = (uint32_t)f.getLastWrite();
+		if (changed == NULL || strcmp(name, changed) != 0)
+		{
+			for (uint32_t i = 0; i < old_count; i++)
+			{
+				if (old[i].mtime == mtime && strcmp(old[i].name, name) == 0)
+				{
+					e = old[i];
+					ok = true;
+					reused++;
+					break;
+				}
+			}
+		}
+		if (!ok && probe(f, name, &e))
+		{
+			ok = true;
+			probed++;
+		}
+		f.close();
+
+		if (ok)
+		{
+			out.write((const uint8_t*)&e, sizeof(e));
+			h.count++;
+		}
+	}
+	root.close();
+	free(old);
+
+	out.seek(0);
+	out.write((const uint8_t*)&h, sizeof(h));
+	out.close();
+
+	SD_FS.remove(SCENE_INDEX_FILE);
+	bool ok = SD_FS.rename(SCENE_INDEX_TMP_FILE, SCENE_INDEX_FILE);
+	if (ok) index_generation++;
+	xSemaphoreGive(build_lock);
+
+	LOG_I("scene", "场景索引已更新: %u个场景（沿用%u，读取%u），%u ms", h.count, reused, probed, millis() - start);
+	return ok;
+}
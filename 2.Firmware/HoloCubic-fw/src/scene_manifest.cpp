@@ -0,0 +1,272 @@
+/*
+ * HoloCubic 文件内容清单
+ *
+ * 功能说明：
+ * 1. 按SCENE_MANIFEST_CHUNK分块计算SD卡文件的CRC32，记录缓存在SCENE_MANIFEST_FILE中
+ * 2. 大小与修改时间不变的文件直接返回缓存的记录，不读取文件内容
+ * 3. 文件被改写（上传完成）后作废其记录；作废记录过多时压缩清单文件
+ *
+ * 注意事项：
+ * - 块CRC边计算边追加到清单文件，不在内存中保存整个文件的块列表
+ * - FAT修改时间精度为2秒，上传服务在写入完成时显式作废记录，不依赖修改时间
+ * - 清单文件损坏或块大小改变时整个重建（只是缓存，丢失后按需重新计算）
+ */
+
+#include "scene_manifest.h"
+#include "sd_card.h"
+#include "logger.h"
+#include <esp_rom_crc.h>
+
+static SemaphoreHandle_t manifest_lock = xSemaphoreCreateMutex();
+
+/**
+ * 打开清单文件（读写），不存在或格式不符时新建
+ */
+bool SceneManifest::openFile(File& f, SceneManifestHeader* h)
+{
+	f = SD_FS.exists(SCENE_MANIFEST_FILE) ? SD_FS.open(SCENE_MANIFEST_FILE, "r+") : File();
+	if (f && f.read((uint8_t*)h, sizeof(*h)) == sizeof(*h) && memcmp(h->magic, SCENE_MANIFEST_MAGIC, 4) == 0 &&
+		h->version == SCENE_MANIFEST_VERSION && h->chunk_size == SCENE_MANIFEST_CHUNK &&
+		h->header_size >= sizeof(*h) && h->header_size <= f.size())
+	{
+		return true;
+	}
+	if (f) f.close();
+
+	f = SD_FS.open(SCENE_MANIFEST_FILE, "w+");
+	if (!f) return false;
+	memset(h, 0, sizeof(*h));
+	memcpy(h->magic, SCENE_MANIFEST_MAGIC, 4);
+	h->version = SCENE_MANIFEST_VERSION;
+	h->header_size = sizeof(*h);
+	h->chunk_size = SCENE_MANIFEST_CHUNK;
+	return f.write((const uint8_t*)h, sizeof(*h)) == sizeof(*h);
+}
+
+/**
+ * 顺序查找路径的有效记录
+ * @return 记录在清单文件中的位置，没有时返回-1
+ */
+int32_t SceneManifest::findRecord(File& f, const SceneManifestHeader* h, const char* path, SceneManifestRecord* rec)
+{
+	uint8_t len = strlen(path);
+	uint32_t path_crc = esp_rom_crc32_le(0, (const uint8_t*)path, len);
+	uint32_t size = f.size();
+	uint32_t pos = h->header_size;
+	char name[256];
+
+	while (pos + sizeof(*rec) <= size)
+	{
+		if (!f.seek(pos) || f.read((uint8_t*)rec, sizeof(*rec)) != sizeof(*rec)) break;
+		if (rec->live && rec->path_crc == path_crc && rec->path_len == len &&
+			f.read((uint8_t*)name, len) == len && memcmp(name, path, len) == 0)
+		{
+			return pos;
+		}
+		pos += sizeof(*rec) + rec->path_len + (uint32_t)rec->chunk_count * 4;
+	}
+	return -1;
+}
+
+/**
+ * 作废一条记录
+ */
+void SceneManifest::kill(File& f, SceneManifestHeader* h, int32_t pos)
+{
+	uint8_t zero = 0;
+	f.seek(pos + offsetof(SceneManifestRecord, live));
+	f.write(&zero, 1);
+	if (h->live) h->live--;
+	h->dead++;
+}
+
+/**
+ * 读一遍文件，块CRC逐个追加到清单末尾，最后回写记录头
+ * 读取失败时记录保持作废（live为0），等下次压缩时丢弃
+ */
+bool SceneManifest::append(File& f, const char* path, File& src, SceneManifestRecord* rec)
+{
+	uint8_t len = strlen(path);
+	uint32_t size = src.size();
+	if (size > (uint32_t)SCENE_MANIFEST_CHUNKS_MAX * SCENE_MANIFEST_CHUNK) return false;
+
+	uint8_t* buf = (uint8_t*)malloc(SCENE_MANIFEST_READ_SIZE);
+	if (buf == NULL) return false;
+
+	memset(rec, 0, sizeof(*rec));
+	rec->path_crc = esp_rom_crc32_le(0, (const uint8_t*)path, len);
+	rec->size = size;
+	rec->mtime = (uint32_t)src.getLastWrite();
+	rec->chunk_count = (size + SCENE_MANIFEST_CHUNK - 1) / SCENE_MANIFEST_CHUNK;
+	rec->path_len = len;
+
+	uint32_t pos = f.size();
+	f.seek(pos);
+	f.write((const uint8_t*)rec, sizeof(*rec));
+	f.write((const uint8_t*)path, len);
+
+	uint32_t done = 0;
+	uint32_t chunk_crc = 0;
+	bool ok = true;
+	while (done < size)
+	{
+		uint32_t want = size - done;
+		if (want > SCENE_MANIFEST_READ_SIZE) want = SCENE_MANIFEST_READ_SIZE;
+		if (src.read(buf, want) != want)
+		{
+			ok = false;
+			break;
+		}
+		rec->crc32 = esp_rom_crc32_le(rec->crc32, buf, want);
+		chunk_crc = esp_rom_crc32_le(chunk_crc, buf, want);
+		done += want;
+		// READ_SIZE整除块大小，块边界总是落在一次读取的末尾
+		if (done % SCENE_MANIFEST_CHUNK == 0 || done == size)
+		{
+			f.write((const uint8_t*)&chunk_crc, 4);
+			chunk_crc = 0;
+		}
+	}
+	free(buf);
+
+	// 中途失败时补齐块CRC，保持记录长度与chunk_count一致
+	for (uint32_t i = done / SCENE_MANIFEST_CHUNK; !ok && i < rec->chunk_count; i++)
+		f.write((const uint8_t*)&chunk_crc, 4);
+	rec->live = ok;
+	f.seek(pos);
+	f.write((const uint8_t*)rec, sizeof(*rec));
+	return ok;
+}
+
+/**
+ * 作废记录多于有效记录时，只把有效记录复制到临时文件后替换
+ */
+bool SceneManifest::compact(File& f, SceneManifestHeader* h)
+{
+	if (h->dead <= h->live || h->dead < SCENE_MANIFEST_COMPACT_MIN) return true;
+
+	File out = SD_FS.open(SCENE_MANIFEST_TMP_FILE, FILE_WRITE);
+	if (!out) return false;
+	SceneManifestHeader nh = *h;
+	nh.header_size = sizeof(nh);
+	nh.live = 0;
+	nh.dead = 0;
+	out.write((const uint8_t*)&nh, sizeof(nh));
+
+	uint8_t buf[256];
+	uint32_t size = f.size();
+	uint32_t pos = h->header_size;
+	SceneManifestRecord rec;
+	while (pos + sizeof(rec) <= size && f.seek(pos) && f.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec))
+	{
+		uint32_t body = rec.path_len + (uint32_t)rec.chunk_count * 4;
+		if (rec.live)
+		{
+			out.write((const uint8_t*)&rec, sizeof(rec));
+			for (uint32_t left = body; left > 0;)
+			{
+				uint32_t n = left < sizeof(buf) ? left : sizeof(buf);
+				if (f.read(buf, n) != n) break;
+				out.write(buf, n);
+				left -= n;
+			}
+			nh.live++;
+		}
+		pos += sizeof(rec) + body;
+	}
+	out.seek(0);
+	out.write((const uint8_t*)&nh, sizeof(nh));
+	out.close();
+	f.close();
+
+	SD_FS.remove(SCENE_MANIFEST_FILE);
+	bool ok = SD_FS.rename(SCENE_MANIFEST_TMP_FILE, SCENE_MANIFEST_FILE);
+	LOG_I("scene", "文件清单已压缩: %u条记录（丢弃%u）", nh.live, h->dead);
+	return ok && openFile(f, h);
+}
+
+/**
+ * 取文件的清单
+ * 缓存的记录与文件的大小、修改时间都一致时直接返回，否则重新计算（读取整个文件）
+ */
+bool SceneManifest::lookup(const char* path, SceneManifestEntry* out)
+{
+	if (strlen(path) > 255) return false;
+	xSemaphoreTake(manifest_lock, portMAX_DELAY);
+
+	File src = SD_FS.open(path);
+	if (!src || src.isDirectory())
+	{
+		if (src) src.close();
+		xSemaphoreGive(manifest_lock);
+		return false;
+	}
+
+	File f;
+	SceneManifestHeader h;
+	bool ok = openFile(f, &h) && compact(f, &h);
+	if (ok)
+	{
+		SceneManifestRecord rec;
+		int32_t pos = findRecord(f, &h, path, &rec);
+		if (pos < 0 || rec.size != src.size() || rec.mtime != (uint32_t)src.getLastWrite())
+		{
+			if (pos >= 0) kill(f, &h, pos);
+			uint32_t start = millis();
+			pos = f.size();
+			ok = append(f, path, src, &rec);
+			if (ok) h.live++;
+			else if (f.size() > (uint32_t)pos) h.dead++;
+			f.seek(0);
+			f.write((const uint8_t*)&h, sizeof(h));
+			LOG_D("scene", "文件清单: %s %u字节 %u块, %u ms", path, rec.size, rec.chunk_count, millis() - start);
+		}
+		if (ok)
+		{
+			out->size = rec.size;
+			out->crc32 = rec.crc32;
+			out->chunk_count = rec.chunk_count;
+			out->chunks_pos = pos + sizeof(rec) + rec.path_len;
+		}
+	}
+	if (f) f.close();
+	src.close();
+	xSemaphoreGive(manifest_lock);
+	return ok;
+}
+
+/**
+ * 读取块CRC（位置来自lookup；其间清单被压缩时读到的可能是其他记录，调用方应在同一次请求内使用）
+ */
+bool SceneManifest::readChunks(const SceneManifestEntry* e, uint16_t first, uint16_t n, uint32_t* out)
+{
+	if ((uint32_t)first + n > e->chunk_count) return false;
+	xSemaphoreTake(manifest_lock, portMAX_DELAY);
+	File f = SD_FS.open(SCENE_MANIFEST_FILE);
+	bool ok = f && f.seek(e->chunks_pos + (uint32_t)first * 4) &&
+		f.read((uint8_t*)out, (size_t)n * 4) == (size_t)n * 4;
+	if (f) f.close();
+	xSemaphoreGive(manifest_lock);
+	return ok;
+}
+
+void SceneManifest::invalidate(const char* path)
+{
+	if (strlen(path) > 255 || !SD_FS.exists(SCENE_MANIFEST_FILE)) return;
+	xSemaphoreTake(manifest_lock, portMAX_DELAY);
+	File f;
+	SceneManifestHeader h;
+	if (openFile(f, &h))
+	{
+		SceneManifestRecord rec;
+		int32_t pos = findRecord(f, &h, path, &rec);
+		if (pos >= 0)
+		{
+			kill(f, &h, pos);
+			f.seek(0);
+			f.write((const uint8_t*)&h, sizeof(h));
+		}
+		f.close();
+	}
+	xSemaphoreGive(manifest_lock);
+}
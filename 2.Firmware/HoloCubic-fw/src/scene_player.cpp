@@ -0,0 +1,1358 @@
+/*
+ * HoloCubic 场景播放器模块
+ *
+ * 功能说明：
+ * 1. 按目标帧率播放SD卡中的帧序列（S:/Scenes/<场景>/frameNNN.bin）或.holo动画包
+ * 2. 后台预读任务把后续帧读入预分配的环形缓冲区
+ * 3. 每帧以内存图像（lv_img_dsc_t）交给LVGL，不再逐帧经过文件解码器打开/关闭
+ *
+ * 数据流：
+ *   free_q --> 预读任务(核心0) 读SD --> ready_q --> LVGL定时任务显示 --> 上一帧归还free_q
+ *
+ * 注意事项：
+ * - play()/stop()/close()会创建或删除lv_task，需在LVGL任务中（或运行时任务启动前）调用
+ * - 所有帧应为相同格式与尺寸，槽位大小取第一帧文件大小（.holo取索引中的最大帧）
+ * - .holo动画包只打开一次文件，每帧seek后单次read，省去逐帧打开文件与查找目录项；
+ *   连续存放的包（上传时预留连续空间）按扇区直接读取，读取速度不受FAT链查找影响
+ * - 差分动画包（HOLO_FLAG_DELTA）在常驻帧缓冲上覆盖变化分块，只重绘对应区域，
+ *   减少SD读取量与SPI刷新量；帧需按顺序应用，读取失败的帧会残留到下一次关键帧
+ * - MJPEG动画包（HOLO_FLAG_JPEG）逐MCU行解码并直接写屏，不经过LVGL绘制缓冲，
+ *   需要先setDisplay()，且场景控件应为全屏、上方没有其他会刷新的控件
+ * - 共用调色板的动画包（HOLO_FLAG_PALETTE）调色板常驻内存，帧内只有索引；
+ *   各帧调色板相同，切换帧时不必让图像缓存重新打开
+ * - 设置了显示对象时，与控件同尺寸的真彩色帧直接从槽位DMA写屏（SCENE_DIRECT_PRESENT），
+ *   要求与MJPEG相同：场景控件上方没有其他会刷新的控件，且没有缩放与旋转
+ * - Q565压缩动画包（HOLO_FLAG_Q565）槽位中只保存压缩数据，SD读取量随黑色面积减少；
+ *   直接写屏时按条带解码后DMA发送，否则由Q565解码器在LVGL绘制时逐行解码
+ * - 索引条目带校验值的动画包在每帧第一次读取后校验CRC32，损坏的帧跳过（不交给解码器），
+ *   整包校验通过后记录在场景索引中，之后的播放不再计算
+ * - 裁剪过的动画包（HOLO_FLAG_CROP）帧只有非黑内容的外接矩形，显示第一帧时控件缩小到帧尺寸并放到裁剪位置，
+ *   SD读取、解码与SPI写屏都只涉及该区域，面板其余部分保持黑色不再刷新
+ *
+ * 流水线（直接写屏时）：
+ *   预读任务  |读N+1(HSPI)|读N+2(HSPI)|...
+ *   LVGL任务  |写N(VSPI DMA)|写N+1(VSPI DMA)|...
+ *   两条SPI总线各自独立传输，pushFrame只排队不等待；槽位N在下一帧排队（DMA N已完成）后归还
+ *
+ * 播放节奏：
+ * - 每帧按时间轴序号带预定显示时刻（PTS），显示任务在PTS到达时上屏，读取与解码的快慢不改变播放速度
+ * - 落后时丢帧：预读任务按预计读取耗时跳过来不及显示的帧（差分帧必须依次读取，不跳过）；
+ *   显示时后一帧也已到期则丢弃当前帧（差分帧仍应用到帧缓冲，只是不单独显示）
+ * - 预读未跟上时重复当前帧；SD读取耗时以TCP估计往返时间的方式平滑，波动大时扩充环形缓冲
+ * - 显示偏差、丢帧/重复帧数、读取耗时与缓冲深度报告给遥测（telemetry.h）
+ * - 多设备同步（scene_sync.h）给出外部时间轴时，每显示一帧把时间轴原点向其移动一小步，
+ *   PTS随之提前或推后，丢帧与重复帧照常处理
+ *
+ * 实时画面（openLive）：
+ *   free_q --> 外部来源(如ESP-NOW接收回调) 直接写入槽位 --> ready_q --> LVGL定时任务显示最新一帧
+ *   没有预读任务与时间轴，积压的旧帧直接归还，帧到达后最多SCENE_LIVE_POLL_MS上屏
+ */
+
+#include "scene_player.h"
+#include "sd_card.h"
+#include "runtime.h"
+#include "telemetry.h"
+#include "logger.h"
+#include "buf_manager.h"
+#include "supervisor.h"
+#include "sd_hotplug.h"
+#include "scene_index.h"
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+
+/**
+ * 打开一个场景目录
+ *
+ * @param scene_dir  场景目录（SD路径，如"/Scenes/Holo3D"）或.holo文件路径
+ * @param frames     帧数，0表示自动探测frame000.bin起连续存在的文件数
+ * @param target_fps 目标帧率（.holo时为0表示使用包内帧率）
+ * @return 成功返回true
+ */
+bool ScenePlayer::open(const char* scene_dir, uint16_t frames, uint8_t target_fps)
+{
+	close();
+
+	strncpy(dir, scene_dir, SCENE_PATH_MAX - 1);
+	dir[SCENE_PATH_MAX - 1] = '\0';
+	fps = target_fps ? target_fps : 25;
+
+	uint32_t size = 0;
+	size_t dir_len = strlen(dir);
+	if (dir_len > 5 && strcmp(dir + dir_len - 5, ".holo") == 0)
+	{
+		if (!openPack(&size)) return false;
+		if (target_fps == 0 && pack_fps) fps = pack_fps;
+	}
+	else if (!probeFrames(frames, &size)) return false;
+
+	if (isJpeg() && display == NULL)
+	{
+		LOG_E("scene", "MJPEG动画需要先调用setDisplay()");
+		close();
+		return false;
+	}
+
+	if (!allocSlots(size) || (isDelta() && !allocFrameBuffer()))
+	{
+		close();
+		return false;
+	}
+
+	if (isQ565()) allocBands();
+
+	free_q = xQueueCreate(SCENE_RING_MAX, sizeof(uint8_t));
+	ready_q = xQueueCreate(SCENE_RING_MAX, sizeof(uint8_t));
+	next_read = 0;
+	shown_slot = -1;
+	last_frame = -1;
+	memset(&stats, 0, sizeof(stats));
+
+	LOG_I("scene", "场景已打开: %s, %d帧, %d FPS, 每帧最大%u字节", dir, frame_count, fps, size);
+	return true;
+}
+
+/**
+ * 打开实时画面：只分配槽位与队列，真彩色槽位预先写好图像头，来源每帧只写像素
+ */
+bool ScenePlayer::openLive(SceneLiveFormat format, uint16_t w, uint16_t h, uint32_t max_size)
+{
+	close();
+	if (w == 0 || h == 0 || w > LV_HOR_RES_MAX || h > LV_VER_RES_MAX) return false;
+	if (format == SCENE_LIVE_JPEG && (display == NULL || max_size == 0))
+	{
+		LOG_E("scene", "JPEG实时画面需要先调用setDisplay()并给出最大帧大小");
+		return false;
+	}
+
+	uint32_t size = format == SCENE_LIVE_JPEG ? max_size : sizeof(lv_img_header_t) + (uint32_t)w * h * sizeof(lv_color_t);
+	if (!allocSlots(size)) return false;
+	if (format == SCENE_LIVE_RAW)
+	{
+		lv_img_header_t hdr;
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.cf = LV_IMG_CF_TRUE_COLOR;
+		hdr.w = w;
+		hdr.h = h;
+		for (uint8_t i = 0; i < slot_count; i++) memcpy(slots[i].data, &hdr, sizeof(hdr));
+	}
+
+	live = true;
+	// 没有时间轴，帧率只作getFps()的标称值
+	fps = 30;
+	pack_flags = format == SCENE_LIVE_JPEG ? HOLO_FLAG_JPEG : 0;
+	pack_w = w;
+	pack_h = h;
+	free_q = xQueueCreate(SCENE_RING_MAX, sizeof(uint8_t));
+	ready_q = xQueueCreate(SCENE_RING_MAX, sizeof(uint8_t));
+	shown_slot = -1;
+	last_frame = -1;
+
+	LOG_I("scene", "实时画面已打开: %s %ux%u, 每帧最大%u字节", format == SCENE_LIVE_JPEG ? "JPEG" : "RGB565", w, h, size);
+	return true;
+}
+
+int8_t ScenePlayer::liveAcquire()
+{
+	uint8_t idx;
+	if (!live || !prefetching || xQueueReceive(free_q, &idx, 0) != pdTRUE) return -1;
+	return idx;
+}
+
+uint8_t* ScenePlayer::liveBuffer(int8_t slot)
+{
+	return slots[slot].data;
+}
+
+uint32_t ScenePlayer::liveCapacity()
+{
+	return slot_size;
+}
+
+/**
+ * 提交一帧：真彩色帧按预先写好的图像头填充描述，JPEG帧在显示时解码
+ */
+void ScenePlayer::liveCommit(int8_t slot, uint32_t len, uint16_t frame_id)
+{
+	uint8_t idx = slot;
+	SceneSlot* s = &slots[idx];
+	s->len = len;
+	if (isJpeg()) s->frame_id = frame_id;
+	else fillSlot(s, frame_id);
+	xQueueSend(ready_q, &idx, 0);
+}
+
+void ScenePlayer::liveRelease(int8_t slot)
+{
+	uint8_t idx = slot;
+	xQueueSend(free_q, &idx, 0);
+}
+
+/**
+ * 帧目录：统计帧数并以第一帧大小确定槽位大小
+ */
+bool ScenePlayer::probeFrames(uint16_t frames, uint32_t* max_size)
+{
+	char path[SCENE_PATH_MAX + 16];
+	frame_count = frames;
+	if (frame_count == 0)
+	{
+		framePath(path, 0);
+		while (SD_FS.exists(path))
+		{
+			frame_count++;
+			framePath(path, frame_count);
+		}
+	}
+	if (frame_count == 0)
+	{
+		LOG_W("scene", "场景目录无帧文件: %s", dir);
+		return false;
+	}
+
+	framePath(path, 0);
+	File f = SD_FS.open(path);
+	if (!f)
+	{
+		LOG_W("scene", "无法打开首帧: %s", path);
+		return false;
+	}
+	*max_size = f.size();
+	// 帧尺寸取首帧图像头（读取失败时不摆放控件）
+	lv_img_header_t h;
+	if (f.read((uint8_t*)&h, sizeof(h)) == sizeof(h))
+	{
+		pack_w = h.w;
+		pack_h = h.h;
+	}
+	f.close();
+	return true;
+}
+
+/**
+ * .holo动画包：校验文件头，把帧索引读入内存，并求最大帧大小
+ */
+bool ScenePlayer::openPack(uint32_t* max_size)
+{
+	sd_gen = tf.generation();
+	pack = SD_FS.open(dir);
+	if (!pack)
+	{
+		LOG_W("scene", "无法打开动画包: %s", dir);
+		return false;
+	}
+
+	HoloHeader hdr;
+	if (pack.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) ||
+		memcmp(hdr.magic, HOLO_MAGIC, 4) != 0 || hdr.version > HOLO_VERSION || hdr.header_size < HOLO_HEADER_SIZE_MIN ||
+		hdr.entry_size < HOLO_ENTRY_SIZE_MIN || hdr.frame_count == 0 || hdr.frame_count > 0xFFFF ||
+		((hdr.flags & HOLO_FLAG_PALETTE) && (hdr.version < HOLO_VERSION_PALETTE || hdr.palette_offset == 0 ||
+											 hdr.cf < LV_IMG_CF_INDEXED_1BIT || hdr.cf > LV_IMG_CF_INDEXED_8BIT)) ||
+		((hdr.flags & HOLO_FLAG_Q565) && (hdr.version < HOLO_VERSION_Q565 || hdr.flags != HOLO_FLAG_Q565 ||
+										  hdr.cf != LV_IMG_CF_TRUE_COLOR || LV_COLOR_DEPTH != 16)))
+	{
+		LOG_W("scene", "动画包格式错误: %s", dir);
+		close();
+		return false;
+	}
+	// 旧包的文件头较短，多读的部分是帧索引
+	if (hdr.header_size < sizeof(hdr))
+		memset((uint8_t*)&hdr + hdr.header_size, 0, sizeof(hdr) - hdr.header_size);
+	if ((hdr.flags & HOLO_FLAG_CROP) &&
+		(hdr.version < HOLO_VERSION_CROP || hdr.crop_x + hdr.width > hdr.full_w || hdr.crop_y + hdr.height > hdr.full_h))
+	{
+		LOG_W("scene", "动画包裁剪区域错误: %s", dir);
+		close();
+		return false;
+	}
+
+	index = (HoloFrameEntry*)malloc(hdr.frame_count * sizeof(HoloFrameEntry));
+	if (index == NULL)
+	{
+		LOG_E("scene", "帧索引分配失败: %u帧", hdr.frame_count);
+		close();
+		return false;
+	}
+
+	// 按entry_size步进读取，只取当前版本认识的字段
+	uint8_t entry[32];
+	uint8_t entry_size = hdr.entry_size;
+	pack.seek(hdr.index_offset);
+	*max_size = 0;
+	for (uint32_t i = 0; i < hdr.frame_count; i++)
+	{
+		uint8_t n = entry_size < sizeof(entry) ? entry_size : sizeof(entry);
+		if (pack.read(entry, n) != n)
+		{
+			LOG_W("scene", "帧索引读取失败: %s", dir);
+			close();
+			return false;
+		}
+		if (entry_size > n) pack.seek(entry_size - n, SeekCur);
+		memset(&index[i], 0, sizeof(HoloFrameEntry));
+		memcpy(&index[i], entry, n < sizeof(HoloFrameEntry) ? n : sizeof(HoloFrameEntry));
+		if (index[i].size > *max_size) *max_size = index[i].size;
+	}
+
+	if (hdr.flags & HOLO_FLAG_PALETTE)
+	{
+		palette_size = 4u << lv_img_cf_get_px_size((lv_img_cf_t)hdr.cf);
+		palette = (uint8_t*)malloc(palette_size);
+		if (palette == NULL || !pack.seek(hdr.palette_offset) || pack.read(palette, palette_size) != palette_size)
+		{
+			LOG_W("scene", "共用调色板读取失败: %s", dir);
+			close();
+			return false;
+		}
+		// 完整帧在槽位中还原为带调色板的.bin内容
+		*max_size += palette_size;
+	}
+
+	// 帧按扇区整读时末尾最多多读一个扇区，槽位相应加长
+	raw = tf.mapContiguous(dir, &extent);
+	if (raw) *max_size += extent.sector_size - 1;
+
+	frame_count = hdr.frame_count;
+	index_ambient = entry_size >= HOLO_ENTRY_SIZE_AMBIENT;
+	pack_fps = hdr.fps;
+	pack_w = hdr.width;
+	pack_h = hdr.height;
+	if (hdr.flags & HOLO_FLAG_CROP)
+	{
+		// 帧中心 = 画布左上角 + 裁剪位置 + 帧尺寸的一半（按LV_ALIGN_CENTER的取整方式）
+		place_dx = hdr.crop_x + hdr.width / 2 - hdr.full_w / 2;
+		place_dy = hdr.crop_y + hdr.height / 2 - hdr.full_h / 2;
+	}
+	pack_flags = hdr.flags;
+	if (entry_size >= HOLO_ENTRY_SIZE_CRC) beginVerify();
+	return true;
+}
+
+/**
+ * 开始帧校验：场景索引记录为已通过（且修改时间相同）时跳过，否则分配每帧一位的记录
+ * 打开时不读取帧数据，校验分摊在预读任务第一次读到各帧时
+ */
+void ScenePlayer::beginVerify()
+{
+	pack_mtime = (uint32_t)pack.getLastWrite();
+	const char* name = SceneIndex::sceneName(dir);
+	if (name && SceneIndex::getVerify(name, pack_mtime) == SCENE_VERIFY_OK) return;
+	verified = (uint8_t*)calloc((frame_count + 7) / 8, 1);
+	verified_cnt = 0;
+	verify_bad = false;
+	if (verified == NULL) LOG_W("scene", "帧校验记录分配失败，不校验: %s", dir);
+}
+
+/**
+ * 校验第一次读到的帧（预读任务，读取的字节即为包中保存的帧）
+ * 第一个损坏的帧与全部通过时写回场景索引
+ */
+bool ScenePlayer::verifyFrame(const uint8_t* data, uint32_t len, uint16_t id)
+{
+	uint8_t bit = 1 << (id & 7);
+	if (verified == NULL || (verified[id >> 3] & bit)) return true;
+
+	const char* name = SceneIndex::sceneName(dir);
+	if (esp_rom_crc32_le(0, data, len) != index[id].crc)
+	{
+		LOG_E("scene", "帧校验失败: %s 第%u帧", dir, id);
+		if (!verify_bad && name) SceneIndex::setVerify(name, pack_mtime, SCENE_VERIFY_BAD, id);
+		verify_bad = true;
+		return false;
+	}
+	verified[id >> 3] |= bit;
+	if (++verified_cnt < frame_count) return true;
+
+	// 每一帧都已通过：之后的读取不再计算，下次打开时也不再分配记录
+	free(verified);
+	verified = NULL;
+	if (name) SceneIndex::setVerify(name, pack_mtime, SCENE_VERIFY_OK);
+	LOG_I("scene", "动画包校验通过: %s（%u帧）", dir, frame_count);
+	return true;
+}
+
+bool ScenePlayer::isJpeg()
+{
+	return (index != NULL || live) && (pack_flags & HOLO_FLAG_JPEG);
+}
+
+bool ScenePlayer::isQ565()
+{
+	return index != NULL && (pack_flags & HOLO_FLAG_Q565);
+}
+
+/**
+ * Q565直接写屏的两个条带缓冲（片内可DMA内存，240宽时共15KB）
+ * 没有显示对象或内存不足时不分配，改由LVGL绘制时逐行解码
+ */
+void ScenePlayer::allocBands()
+{
+#if SCENE_DIRECT_PRESENT
+	if (display == NULL) return;
+	uint32_t bytes = (uint32_t)pack_w * SCENE_Q565_LINES * sizeof(lv_color_t);
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		q565_band[i] = (lv_color_t*)heap_caps_malloc(bytes, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+		if (q565_band[i] == NULL)
+		{
+			LOG_W("scene", "Q565条带缓冲分配失败，改由LVGL绘制");
+			heap_caps_free(q565_band[0]);
+			q565_band[0] = q565_band[1] = NULL;
+			return;
+		}
+	}
+#endif
+}
+
+/**
+ * 设置直接写屏所用的显示对象（MJPEG动画需要）
+ */
+void ScenePlayer::setDisplay(Display* disp)
+{
+	display = disp;
+}
+
+/**
+ * 播放时LED环境色跟随帧的平均色，停止后渐隐（NULL为不跟随）
+ */
+void ScenePlayer::setLeds(Pixel* pixel)
+{
+	leds = pixel;
+}
+
+bool ScenePlayer::ambientDue(uint16_t frame_id)
+{
+	return leds != NULL && frame_id % SCENE_AMBIENT_EVERY == 0;
+}
+
+/**
+ * 更新LED环境色（运行在LVGL任务中）
+ * 索引带平均色时直接使用（img可为NULL）；否则按网格采样，每帧最多SCENE_AMBIENT_GRID²个像素，
+ * 索引色经调色板取色，其他格式保持上一次的颜色
+ */
+void ScenePlayer::updateAmbient(const lv_img_dsc_t* img, uint16_t frame_id)
+{
+	if (!ambientDue(frame_id)) return;
+	if (index_ambient)
+	{
+		uint32_t c = index[frame_id].ambient;
+		leds->setAmbient((c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF);
+		return;
+	}
+	if (img == NULL || img->data == NULL) return;
+	lv_img_cf_t cf = (lv_img_cf_t)img->header.cf;
+	if (cf != LV_IMG_CF_TRUE_COLOR && cf != LV_IMG_CF_TRUE_COLOR_ALPHA &&
+		(cf < LV_IMG_CF_INDEXED_1BIT || cf > LV_IMG_CF_INDEXED_8BIT))
+	{
+		return;
+	}
+
+	uint32_t w = img->header.w, h = img->header.h;
+	if (w == 0 || h == 0 || img->data_size < lv_img_buf_get_img_size(w, h, cf)) return;
+
+	uint32_t r = 0, g = 0, b = 0;
+	for (uint32_t gy = 0; gy < SCENE_AMBIENT_GRID; gy++)
+	{
+		uint32_t y = (2 * gy + 1) * h / (2 * SCENE_AMBIENT_GRID);
+		for (uint32_t gx = 0; gx < SCENE_AMBIENT_GRID; gx++)
+		{
+			uint32_t x = (2 * gx + 1) * w / (2 * SCENE_AMBIENT_GRID);
+			lv_color32_t c;
+			c.full = lv_color_to32(lv_img_buf_get_px_color((lv_img_dsc_t*)img, x, y, LV_COLOR_BLACK));
+			r += c.ch.red;
+			g += c.ch.green;
+			b += c.ch.blue;
+		}
+	}
+	const uint32_t n = SCENE_AMBIENT_GRID * SCENE_AMBIENT_GRID;
+	leds->setAmbient(r / n, g / n, b / n);
+}
+
+/**
+ * MJPEG条带中落在采样网格上的像素累加到amb_sum（px为本机字节序RGB565）
+ */
+void ScenePlayer::sampleBand(uint16_t y, uint16_t w, uint16_t h, const uint16_t* px)
+{
+	uint32_t img_h = jpeg.getHeight();
+	for (uint32_t gy = 0; gy < SCENE_AMBIENT_GRID; gy++)
+	{
+		uint32_t sy = (2 * gy + 1) * img_h / (2 * SCENE_AMBIENT_GRID);
+		if (sy < y || sy >= (uint32_t)y + h) continue;
+		const uint16_t* row = px + (sy - y) * w;
+		for (uint32_t gx = 0; gx < SCENE_AMBIENT_GRID; gx++)
+		{
+			uint16_t c = row[(2 * gx + 1) * w / (2 * SCENE_AMBIENT_GRID)];
+			amb_sum[0] += (c >> 8) & 0xF8;
+			amb_sum[1] += (c >> 3) & 0xFC;
+			amb_sum[2] += (c << 3) & 0xF8;
+			amb_n++;
+		}
+	}
+}
+
+bool ScenePlayer::isDelta()
+{
+	return index != NULL && (pack_flags & HOLO_FLAG_DELTA);
+}
+
+/**
+ * 差分动画：分配常驻帧缓冲，大小为关键帧（帧0）大小
+ */
+bool ScenePlayer::allocFrameBuffer()
+{
+	fb_len = index[0].size + palette_size;
+	fb = (uint8_t*)buf_alloc(BUF_BULK, fb_len);
+	if (fb == NULL)
+	{
+		LOG_E("scene", "差分帧缓冲分配失败: %u字节", fb_len);
+		return false;
+	}
+	memset(&fb_dsc, 0, sizeof(fb_dsc));
+	return true;
+}
+
+/**
+ * 开始播放到指定的图像控件
+ */
+void ScenePlayer::play(lv_obj_t* img)
+{
+	if (playing || (!prefetching && !preroll())) return;
+
+	canvas = img;
+	playing = true;
+	placed = false;
+
+	uint32_t poll_ms = live ? SCENE_LIVE_POLL_MS : 1000 / fps / SCENE_PACE_POLL_DIV;
+	present_task = lv_task_create(presentCb, poll_ms ? poll_ms : 1, LV_TASK_PRIO_HIGH, this);
+	// 播放期间场景界面以60Hz刷新，帧到达后尽快上屏
+	runtime.setScreenRefresh(lv_obj_get_screen(img), UI_REFR_SCENE_MS);
+}
+
+/**
+ * 只启动预读，把随后的帧读入环形缓冲区而不显示（可在任意任务中调用）
+ * 之后的play()从已读入的帧开始，第一帧在下一次轮询时即可上屏；用于播放列表在切换前预载下一场景
+ */
+bool ScenePlayer::preroll()
+{
+	if (prefetching) return true;
+	if ((frame_count == 0 && !live) || free_q == NULL) return false;
+
+	// 时间轴从继续播放的帧开始，显示第一帧时对齐时钟
+	period_us = 1000000 / fps;
+	paced = false;
+	seq_base = next_read;
+	next_seq = 0;
+
+	for (uint8_t i = 0; i < slot_count; i++)
+	{
+		if ((int8_t)i != shown_slot) xQueueSend(free_q, &i, 0);
+	}
+	// 实时画面由来源填充槽位，不需要预读任务
+	if (live)
+	{
+		prefetching = true;
+		return true;
+	}
+
+	if (!supervised)
+	{
+		// 两个播放器（播放列表）各自登记，预读可能同时进行
+		static uint8_t players = 0;
+		char name[SUP_NAME_LEN];
+		snprintf(name, sizeof(name), "scene%u", players++);
+		sup_id = supervisor.add(name, SCENE_STALL_MS, recoverSd, this);
+		supervised = true;
+	}
+
+	prefetching = true;
+	if (xTaskCreatePinnedToCore(prefetchEntry, "scene", SCENE_TASK_STACK, this,
+								SCENE_TASK_PRIORITY, &prefetch_task, SCENE_TASK_CORE) != pdPASS)
+	{
+		prefetching = false;
+		prefetch_task = NULL;
+		uint8_t idx;
+		while (xQueueReceive(free_q, &idx, 0) == pdTRUE);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * 停止播放（或预读），当前显示的帧保持在屏幕上
+ */
+void ScenePlayer::stop()
+{
+	clearEpoch();
+	if (!playing && !prefetching) return;
+
+	prefetching = false;
+	if (playing)
+	{
+		playing = false;
+		if (present_task)
+		{
+			lv_task_del(present_task);
+			present_task = NULL;
+		}
+		if (leds) leds->clearAmbient();
+		runtime.setScreenRefresh(lv_obj_get_screen(canvas), 0);
+	}
+
+	// 直接写屏的最后一帧：等待发送完成，并交给LVGL作为图像源，之后重绘时内容一致
+	if (direct_shown)
+	{
+		display->frameWait();
+		if (shown_slot >= 0)
+		{
+			lv_img_cache_invalidate_src(&slots[shown_slot].dsc);
+			lv_img_set_src(canvas, &slots[shown_slot].dsc);
+		}
+		direct_shown = false;
+	}
+
+	// 等待预读任务在当前读取完成后退出
+	while (prefetch_task != NULL) vTaskDelay(1);
+
+	// 丢弃已预读但未显示的帧，下次播放从显示帧之后重新开始
+	uint8_t idx;
+	while (xQueueReceive(ready_q, &idx, 0) == pdTRUE);
+	while (xQueueReceive(free_q, &idx, 0) == pdTRUE);
+	if (last_frame >= 0 && frame_count) next_read = (last_frame + 1) % frame_count;
+}
+
+/**
+ * 关闭场景并释放所有缓冲区
+ */
+void ScenePlayer::close()
+{
+	stop();
+
+	// 控件已改为显示其他播放器的帧（播放列表切换场景）时不清空
+	if (canvas && shown_slot >= 0)
+	{
+		lv_img_cache_invalidate_src(&slots[shown_slot].dsc);
+		if (lv_img_get_src(canvas) == &slots[shown_slot].dsc) lv_img_set_src(canvas, NULL);
+	}
+	if (canvas && fb && last_frame >= 0)
+	{
+		lv_img_cache_invalidate_src(&fb_dsc);
+		if (lv_img_get_src(canvas) == &fb_dsc) lv_img_set_src(canvas, NULL);
+	}
+	if (palette)
+	{
+		// 共用调色板时各槽位的缓存项一直保留，槽位缓冲释放前全部失效
+		for (uint8_t i = 0; i < slot_count; i++) lv_img_cache_invalidate_src(&slots[i].dsc);
+	}
+	canvas = NULL;
+	shown_slot = -1;
+	last_frame = -1;
+
+	if (free_q) vQueueDelete(free_q);
+	if (ready_q) vQueueDelete(ready_q);
+	free_q = ready_q = NULL;
+
+	freeSlots();
+	if (pack) pack.close();
+	jpeg.release();
+	if (index) free(index);
+	index = NULL;
+	free(verified);
+	verified = NULL;
+	verified_cnt = 0;
+	verify_bad = false;
+	if (palette) free(palette);
+	palette = NULL;
+	palette_size = 0;
+	buf_free(fb);
+	fb = NULL;
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		heap_caps_free(q565_band[i]);
+		q565_band[i] = NULL;
+	}
+	pack_flags = 0;
+	pack_w = pack_h = 0;
+	place_dx = place_dy = 0;
+	live = false;
+	index_ambient = false;
+	raw = false;
+	frame_count = 0;
+}
+
+bool ScenePlayer::seek(uint16_t frame)
+{
+	if (prefetching || frame_count == 0 || isDelta()) return false;
+	next_read = frame % frame_count;
+	return true;
+}
+
+bool ScenePlayer::isPlaying()
+{
+	return playing;
+}
+
+int32_t ScenePlayer::getShownFrame()
+{
+	return last_frame;
+}
+
+uint16_t ScenePlayer::getFrameCount()
+{
+	return frame_count;
+}
+
+const char* ScenePlayer::getPath()
+{
+	return frame_count ? dir : NULL;
+}
+
+uint8_t ScenePlayer::getFps()
+{
+	return fps;
+}
+
+void ScenePlayer::getStats(ScenePlayerStats* out)
+{
+	memcpy(out, &stats, sizeof(stats));
+}
+
+/**
+ * 分配环形缓冲区
+ * 有PSRAM时放在PSRAM（由LVGL绘制，不直接DMA上屏），否则使用片内RAM
+ */
+bool ScenePlayer::allocSlots(uint32_t size)
+{
+	slot_count = SCENE_RING_DEPTH;
+	for (int i = 0; i < SCENE_RING_DEPTH; i++)
+	{
+		slots[i].data = (uint8_t*)buf_alloc(BUF_BULK, size);
+		slots[i].len = 0;
+		if (slots[i].data == NULL)
+		{
+			LOG_E("scene", "场景缓冲区分配失败: %d x %u字节", SCENE_RING_DEPTH, size);
+			freeSlots();
+			return false;
+		}
+	}
+	slot_size = size;
+	return true;
+}
+
+void ScenePlayer::freeSlots()
+{
+	for (int i = 0; i < SCENE_RING_MAX; i++)
+	{
+		buf_free(slots[i].data);
+		slots[i].data = NULL;
+	}
+	slot_size = 0;
+	slot_count = 0;
+	read_avg_us = read_dev_us = 0;
+	ring_full = false;
+}
+
+uint32_t ScenePlayer::ptsOf(uint32_t seq)
+{
+	return pace_origin + seq * period_us;
+}
+
+/**
+ * 外部时间轴（同步任务中调用）：只记录目标，由显示任务在显示帧后调整
+ */
+void ScenePlayer::setEpoch(uint32_t epoch_us)
+{
+	sync_epoch = epoch_us;
+	__sync_synchronize();
+	sync_valid = true;
+}
+
+void ScenePlayer::clearEpoch()
+{
+	sync_valid = false;
+	sync_err = 0;
+}
+
+/**
+ * 帧号0的显示时刻：时间轴序号0对应帧号seq_base，往前推seq_base个周期
+ */
+bool ScenePlayer::getEpoch(uint32_t* epoch_us)
+{
+	if (!playing || !paced || live || frame_count == 0) return false;
+	*epoch_us = pace_origin - (uint32_t)seq_base * period_us;
+	return true;
+}
+
+int32_t ScenePlayer::getSyncError()
+{
+	return sync_valid ? sync_err : 0;
+}
+
+/**
+ * 把时间轴调向外部时间轴（显示任务中，每显示一帧调用一次）
+ * 两条时间轴的差按动画周期（帧数 * 帧周期）取最近的一圈：误差不超过SCENE_SYNC_STEP_MS时
+ * 最多移动SCENE_SYNC_SLEW_US，PTS随之提前或推后，预读与丢帧逻辑不需要改变；超过时一次移到位
+ */
+void ScenePlayer::slewToEpoch()
+{
+	uint32_t cycle = (uint32_t)frame_count * period_us;
+	if (cycle == 0 || cycle > INT32_MAX) return;
+
+	uint32_t mine = pace_origin - (uint32_t)seq_base * period_us;
+	int32_t err = (int32_t)(sync_epoch - mine) % (int32_t)cycle;
+	if (err > (int32_t)(cycle / 2)) err -= cycle;
+	else if (err < -(int32_t)(cycle / 2)) err += cycle;
+	sync_err = err;
+
+	if (abs(err) > SCENE_SYNC_STEP_MS * 1000)
+	{
+		LOG_I("scene", "对齐外部时间轴，跳过%dms", err / 1000);
+		pace_origin += err;
+		return;
+	}
+	if (err > SCENE_SYNC_SLEW_US) err = SCENE_SYNC_SLEW_US;
+	if (err < -SCENE_SYNC_SLEW_US) err = -SCENE_SYNC_SLEW_US;
+	pace_origin += err;
+}
+
+/**
+ * 预计读取一帧所需时间：平滑均值加4倍平均偏差（覆盖绝大多数较慢的读取）
+ */
+uint32_t ScenePlayer::readLead()
+{
+	return read_avg_us + 4 * read_dev_us;
+}
+
+/**
+ * 按RFC 6298的方式更新读取耗时估计：均值增益1/8，平均偏差增益1/4
+ */
+void ScenePlayer::trackRead(uint32_t us)
+{
+	if (read_avg_us == 0)
+	{
+		read_avg_us = us;
+		read_dev_us = us / 2;
+		return;
+	}
+	int32_t err = (int32_t)(us - read_avg_us);
+	read_dev_us += ((err < 0 ? -err : err) - (int32_t)read_dev_us) / 4;
+	read_avg_us += err / 8;
+}
+
+/**
+ * 预读深度跟随读取耗时：预计耗时跨过的帧周期数 + 1（显示中的帧）个槽位，不超过SCENE_RING_MAX
+ * 运行在预读任务中；新槽位建好后才放入free_q，显示任务只访问从队列中取得的槽位
+ */
+void ScenePlayer::growRing()
+{
+	if (ring_full || slot_count >= SCENE_RING_MAX) return;
+	uint32_t need = readLead() / period_us + 2;
+	if (need <= slot_count) return;
+
+	uint8_t i = slot_count;
+	slots[i].data = (uint8_t*)buf_alloc(BUF_BULK, slot_size);
+	if (slots[i].data == NULL)
+	{
+		ring_full = true;
+		LOG_W("scene", "读取耗时波动较大（%u±%uus），内存不足以加深预读", read_avg_us, read_dev_us);
+		return;
+	}
+	slots[i].len = 0;
+	slot_count = i + 1;
+	LOG_I("scene", "读取耗时%u±%uus，预读深度增加到%u帧", read_avg_us, read_dev_us, slot_count);
+	xQueueSend(free_q, &i, 0);
+}
+
+void ScenePlayer::framePath(char* out, uint16_t id)
+{
+	sprintf(out, "%s/frame%03d.bin", dir, id);
+}
+
+/**
+ * 读取一帧到槽位，并据文件头填充lv_img_dsc_t
+ */
+bool ScenePlayer::readFrame(SceneSlot* slot, uint16_t id)
+{
+	if (index)
+	{
+		// 动画包：定位到对齐的帧起始处，一次读取整帧
+		uint32_t len = index[id].size;
+		bool delta = (isDelta() && id != 0) || isJpeg();
+		uint32_t min_len = delta ? sizeof(HoloDeltaHeader) : sizeof(lv_img_header_t) + 1;
+		uint32_t pal = delta ? 0 : palette_size;
+		bool direct = raw && index[id].offset % extent.sector_size == 0;
+		if (len + pal > slot_size || len < min_len || (!direct && !pack.seek(index[id].offset)))
+		{
+			LOG_W("scene", "帧索引异常: %d", id);
+			return false;
+		}
+		// 共用调色板时帧读到槽位偏后处，给调色板留出位置
+		uint8_t* dst = slot->data + pal;
+		if (direct)
+			slot->len = tf.readSectors(&extent, index[id].offset, dst, len) ? len : 0;
+		else
+			slot->len = pack.read(dst, len);
+		telemetry_sd_io(slot->len, 0);
+		if (slot->len != len) return false;
+		if (!verifyFrame(dst, len, id))
+		{
+			read_corrupt = true;
+			return false;
+		}
+		if (delta)
+		{
+			// 差分帧/JPEG帧在显示时才解码
+			slot->frame_id = id;
+			return true;
+		}
+		if (pal)
+		{
+			// 图像头移到槽位开头，其后插入调色板，紧接原有的索引数据
+			memcpy(slot->data, dst, sizeof(lv_img_header_t));
+			memcpy(slot->data + sizeof(lv_img_header_t), palette, pal);
+			slot->len += pal;
+		}
+		return fillSlot(slot, id);
+	}
+
+	char path[SCENE_PATH_MAX + 16];
+	framePath(path, id);
+
+	File f = SD_FS.open(path);
+	if (!f) return false;
+
+	uint32_t len = f.size();
+	if (len > slot_size || len <= sizeof(lv_img_header_t))
+	{
+		f.close();
+		LOG_W("scene", "帧大小异常: %s (%u字节)", path, len);
+		return false;
+	}
+
+	// 一次性读取整帧，由SD驱动拆分为多扇区传输
+	slot->len = f.read(slot->data, len);
+	f.close();
+	telemetry_sd_io(slot->len, 0);
+	if (slot->len != len) return false;
+	return fillSlot(slot, id);
+}
+
+/**
+ * 据帧数据开头的图像头填充lv_img_dsc_t
+ */
+bool ScenePlayer::fillSlot(SceneSlot* slot, uint16_t id)
+{
+	uint32_t len = slot->len;
+	slot->frame_id = id;
+	memcpy(&slot->dsc.header, slot->data, sizeof(lv_img_header_t));
+	slot->dsc.data = slot->data + sizeof(lv_img_header_t);
+	slot->dsc.data_size = len - sizeof(lv_img_header_t);
+	return true;
+}
+
+/**
+ * 重新挂载后重新打开动画包（帧索引与调色板仍在内存中），连续存放的包重新取得扇区位置
+ */
+bool ScenePlayer::reopenPack()
+{
+	pack.close();
+	pack = SD_FS.open(dir);
+	sd_gen = tf.generation();
+	if (raw) raw = tf.mapContiguous(dir, &extent);
+	return (bool)pack;
+}
+
+/**
+ * 任务监视器的恢复动作（在预读任务中执行）：SD读取连续失败时重新挂载SD卡。
+ * 另一个播放器已经重新挂载过（挂载次数变了）时只重新打开自己的文件；
+ * 热插拔检测运行时交给它确认并在后台重新挂载，挂载次数变化后预读任务重新打开动画包
+ */
+bool ScenePlayer::recoverSd(void* user)
+{
+	ScenePlayer* self = (ScenePlayer*)user;
+	if (sdhotplug.isRunning())
+	{
+		sdhotplug.reportError();
+		return true;
+	}
+	bool stale = self->index && self->sd_gen != tf.generation();
+	if (!stale && !tf.remount()) return false;
+	// 帧目录每帧重新打开文件，不持有句柄
+	if (self->index == NULL) return true;
+	return self->reopenPack();
+}
+
+/**
+ * 预读任务
+ * 取得空闲槽位后读取下一帧并按顺序放入ready_q；已对齐时钟时跳过按预计耗时读完也来不及显示的帧
+ */
+void ScenePlayer::prefetchEntry(void* arg)
+{
+	ScenePlayer* self = (ScenePlayer*)arg;
+	uint8_t idx;
+
+	while (self->prefetching)
+	{
+		uint32_t w0 = micros();
+		bool got = xQueueReceive(self->free_q, &idx, pdMS_TO_TICKS(100)) == pdTRUE;
+		self->stats.free_wait_us += micros() - w0;
+		if (!got) continue;
+		if (!sdhotplug.beginIo())
+		{
+			// SD卡正在重新挂载：槽位归还，恢复后按时钟跳到到期的帧继续
+			xQueueSendToFront(self->free_q, &idx, 0);
+			vTaskDelay(pdMS_TO_TICKS(SCENE_SD_WAIT_MS));
+			continue;
+		}
+		if (self->index && self->sd_gen != tf.generation()) self->reopenPack();
+
+		uint32_t seq = self->next_seq;
+		if (self->paced && !self->isDelta())
+		{
+			// 预计读完时已晚于PTS一个周期以上：跳到读完时刚好到期的帧
+			int32_t late = (int32_t)(micros() + self->readLead() - self->ptsOf(seq));
+			if (late >= (int32_t)self->period_us) seq += late / self->period_us;
+		}
+		self->next_seq = seq + 1;
+		uint16_t id = (self->seq_base + seq) % self->frame_count;
+		self->slots[idx].seq = seq;
+
+		supervisor.enter(self->sup_id);
+		uint32_t t0 = micros();
+		self->read_corrupt = false;
+		bool ok = self->readFrame(&self->slots[idx], id);
+		uint32_t us = micros() - t0;
+		// 校验失败的帧是包内容损坏，不触发SD卡恢复
+		supervisor.leave(self->sup_id, ok || self->read_corrupt);
+		sdhotplug.endIo();
+		self->trackRead(us);
+		telemetry_scene_read(us, self->slot_count);
+		self->stats.reads++;
+		self->stats.read_us += us;
+		if (us > self->stats.read_max_us) self->stats.read_max_us = us;
+		if (ok) self->stats.read_bytes += self->slots[idx].len;
+		if (self->read_corrupt) self->stats.corrupt++;
+
+		if (ok)
+		{
+			xQueueSend(self->ready_q, &idx, portMAX_DELAY);
+		}
+		else
+		{
+			// 读取或校验失败的帧直接跳过，槽位归还
+			xQueueSend(self->free_q, &idx, portMAX_DELAY);
+		}
+		self->growRing();
+	}
+
+	self->prefetch_task = NULL;
+	vTaskDelete(NULL);
+}
+
+/**
+ * 显示定时任务（运行在LVGL任务中，每帧周期轮询SCENE_PACE_POLL_DIV次）
+ * 队首的帧到达PTS时上屏；其后的帧也已到期时丢弃队首，落后过多时重新对齐时钟
+ */
+void ScenePlayer::presentCb(lv_task_t* task)
+{
+	ScenePlayer* self = (ScenePlayer*)task->user_data;
+	uint8_t idx;
+
+	if (self->live)
+	{
+		// 实时画面：只显示最新提交的一帧，之前积压的帧直接归还给来源
+		if (xQueueReceive(self->ready_q, &idx, 0) != pdTRUE) return;
+		uint8_t next;
+		while (xQueueReceive(self->ready_q, &next, 0) == pdTRUE)
+		{
+			xQueueSend(self->free_q, &idx, 0);
+			idx = next;
+		}
+		self->showSlot(idx);
+		return;
+	}
+
+	// 预读未跟上时保持当前帧，重复的周期数在下一帧显示时统计
+	if (xQueuePeek(self->ready_q, &idx, 0) != pdTRUE) return;
+
+	uint32_t now = micros();
+	uint32_t period = self->period_us;
+	if (!self->paced)
+	{
+		self->pace_origin = now - self->slots[idx].seq * period;
+		self->shown_seq = self->slots[idx].seq;
+		self->shown_us = now;
+		self->paced = true;
+	}
+	int32_t late = (int32_t)(now - self->ptsOf(self->slots[idx].seq));
+	// 不早于最近的一次轮询才显示
+	if (late < -(int32_t)(period / SCENE_PACE_POLL_DIV / 2)) return;
+	if (late > SCENE_PACE_RESYNC_MS * 1000)
+	{
+		LOG_W("scene", "播放落后%dms，重新对齐时钟", late / 1000);
+		self->pace_origin = now - self->slots[idx].seq * period;
+		late = 0;
+	}
+	xQueueReceive(self->ready_q, &idx, 0);
+
+	uint8_t next;
+	while (xQueuePeek(self->ready_q, &next, 0) == pdTRUE &&
+		   (int32_t)(now - self->ptsOf(self->slots[next].seq)) >= 0)
+	{
+		// 后一帧也已到期：差分帧叠加到帧缓冲后继续，其余帧直接归还
+		if (self->isDelta()) self->applyDelta(&self->slots[idx]);
+		xQueueSend(self->free_q, &idx, 0);
+		xQueueReceive(self->ready_q, &idx, 0);
+		late = (int32_t)(now - self->ptsOf(self->slots[idx].seq));
+	}
+
+	// 上一帧停留超过一个周期的部分为重复帧（四舍五入），时间轴上跳过的序号为丢帧（含预读时跳过的）
+	uint32_t seq = self->slots[idx].seq;
+	uint32_t held = (now - self->shown_us + period / 2) / period;
+	uint32_t span = seq - self->shown_seq;
+	telemetry_scene_frame(late, span > 1 ? span - 1 : 0, held > 1 ? held - 1 : 0);
+	self->shown_seq = seq;
+	self->shown_us = now;
+
+	uint8_t depth = uxQueueMessagesWaiting(self->ready_q);
+	ScenePlayerStats* st = &self->stats;
+	st->shown++;
+	st->dropped += span > 1 ? span - 1 : 0;
+	st->repeated += held > 1 ? held - 1 : 0;
+	st->depth_sum += depth;
+	if (depth > st->depth_max) st->depth_max = depth;
+	st->slots = self->slot_count;
+
+	uint32_t t0 = micros();
+	self->showSlot(idx);
+	st->present_us += micros() - t0;
+	if (self->sync_valid) self->slewToEpoch();
+}
+
+/**
+ * 显示一个已就绪的槽位，并把上一帧的槽位归还给预读任务
+ */
+void ScenePlayer::showSlot(uint8_t idx)
+{
+	SceneSlot* slot = &slots[idx];
+	last_frame = slot->frame_id;
+	if (!placed) placeCanvas();
+
+	if (isJpeg())
+	{
+		presentJpeg(slot);
+		updateAmbient(NULL, slot->frame_id);
+		xQueueSend(free_q, &idx, 0);
+		return;
+	}
+	if (isDelta())
+	{
+		// 差分动画：内容已拷入帧缓冲，槽位立即归还
+		applyDelta(slot);
+		updateAmbient(&fb_dsc, slot->frame_id);
+		xQueueSend(free_q, &idx, 0);
+		return;
+	}
+	updateAmbient(&slot->dsc, slot->frame_id);
+
+	// 直接写屏：排队后立即返回，上一帧的DMA已在排队前完成，其槽位可以归还
+	if (presentDirect(slot))
+	{
+		if (shown_slot >= 0)
+		{
+			uint8_t prev = shown_slot;
+			xQueueSend(free_q, &prev, 0);
+		}
+		shown_slot = idx;
+		return;
+	}
+
+	// 同一槽位的数据已被改写，需让图像缓存重新打开（索引色图像的调色板在打开时缓存）；
+	// 共用调色板时各帧调色板相同，缓存中的查找表仍然有效
+	if (palette == NULL) lv_img_cache_invalidate_src(&slot->dsc);
+	lv_img_set_src(canvas, &slot->dsc);
+
+	if (shown_slot >= 0)
+	{
+		uint8_t prev = shown_slot;
+		xQueueSend(free_q, &prev, 0);
+	}
+	shown_slot = idx;
+}
+
+/**
+ * 按帧尺寸摆放场景控件：画布在父对象中居中，裁剪过的动画包放在画布中的裁剪位置
+ * 在play之后显示第一帧时执行（播放列表切换时上一场景的帧保留到新场景的第一帧），
+ * 每个场景都重新摆放，裁剪过与未裁剪的场景交替播放时控件的尺寸与位置不残留
+ */
+void ScenePlayer::placeCanvas()
+{
+	placed = true;
+	if (pack_w == 0 || pack_h == 0) return;
+	lv_obj_set_size(canvas, pack_w, pack_h);
+	lv_obj_align(canvas, NULL, LV_ALIGN_CENTER, place_dx, place_dy);
+}
+
+/**
+ * 把一帧应用到差分帧缓冲（运行在LVGL任务中）
+ * 关键帧整体替换并重绘整幅图像；差分帧只覆盖变化的分块，并按行合并后局部重绘
+ */
+void ScenePlayer::applyDelta(SceneSlot* slot)
+{
+	if (slot->frame_id == 0)
+	{
+		uint32_t len = slot->len < fb_len ? slot->len : fb_len;
+		memcpy(fb, slot->data, len);
+		memcpy(&fb_dsc.header, fb, sizeof(lv_img_header_t));
+		fb_dsc.data = fb + sizeof(lv_img_header_t);
+		fb_dsc.data_size = len - sizeof(lv_img_header_t);
+		// 调色板可能变化（循环回到关键帧），重新打开图像
+		if (palette == NULL) lv_img_cache_invalidate_src(&fb_dsc);
+		lv_img_set_src(canvas, &fb_dsc);
+		lv_obj_invalidate(canvas);
+		return;
+	}
+	if (fb_dsc.data == NULL) return;   // 尚未收到关键帧
+
+	HoloDeltaHeader dh;
+	memcpy(&dh, slot->data, sizeof(dh));
+
+	uint16_t w = fb_dsc.header.w;
+	uint16_t h = fb_dsc.header.h;
+	uint8_t bpp = lv_img_cf_get_px_size(fb_dsc.header.cf);
+	if (dh.tile_w == 0 || dh.tile_h == 0 || w % dh.tile_w || h % dh.tile_h || (dh.tile_w * bpp) % 8) return;
+
+	uint32_t palette = (fb_dsc.header.cf >= LV_IMG_CF_INDEXED_1BIT && fb_dsc.header.cf <= LV_IMG_CF_INDEXED_8BIT)
+						   ? (4u << bpp) : 0;
+	uint32_t stride = (uint32_t)w * bpp / 8;
+	uint32_t tile_row = (uint32_t)dh.tile_w * bpp / 8;
+	uint32_t tile_bytes = tile_row * dh.tile_h;
+	uint16_t tiles_x = w / dh.tile_w;
+	uint16_t tiles_total = tiles_x * (h / dh.tile_h);
+
+	const uint8_t* ids = slot->data + sizeof(dh);
+	const uint8_t* src = ids + dh.tile_count * sizeof(uint16_t);
+	if (src + (uint32_t)dh.tile_count * tile_bytes > slot->data + slot->len) return;
+
+	uint8_t* pixels = (uint8_t*)fb_dsc.data + palette;
+
+	// 同一行中编号连续的分块合并为一个重绘区域，避免占满LVGL的无效区域缓冲
+	lv_area_t run = { 0, 0, 0, 0 };
+	int32_t run_end = -2;
+	for (uint16_t i = 0; i < dh.tile_count; i++, src += tile_bytes)
+	{
+		uint16_t id;
+		memcpy(&id, ids + i * sizeof(uint16_t), sizeof(id));
+		if (id >= tiles_total) continue;
+
+		uint16_t tx = id % tiles_x;
+		uint16_t ty = id / tiles_x;
+		uint8_t* dst = pixels + (uint32_t)ty * dh.tile_h * stride + tx * tile_row;
+		for (uint8_t r = 0; r < dh.tile_h; r++)
+		{
+			memcpy(dst + r * stride, src + r * tile_row, tile_row);
+		}
+
+		if (id == run_end + 1 && tx != 0)
+		{
+			run.x2 += dh.tile_w;
+		}
+		else
+		{
+			if (run_end >= 0) lv_obj_invalidate_area(canvas, &run);
+			run.x1 = canvas->coords.x1 + tx * dh.tile_w;
+			run.y1 = canvas->coords.y1 + ty * dh.tile_h;
+			run.x2 = run.x1 + dh.tile_w - 1;
+			run.y2 = run.y1 + dh.tile_h - 1;
+		}
+		run_end = id;
+	}
+	if (run_end >= 0) lv_obj_invalidate_area(canvas, &run);
+}
+
+/**
+ * 真彩色帧整幅DMA写屏（运行在LVGL任务中）
+ * @return 未设置显示对象、帧格式或尺寸不符、控件有缩放旋转或像素不能DMA时返回false，改由LVGL绘制
+ */
+bool ScenePlayer::presentDirect(SceneSlot* slot)
+{
+#if SCENE_DIRECT_PRESENT
+	if (q565_is_image(&slot->dsc)) return presentQ565(slot);
+	if (display == NULL || palette != NULL || slot->dsc.header.cf != LV_IMG_CF_TRUE_COLOR) return false;
+	if (lv_img_get_zoom(canvas) != LV_IMG_ZOOM_NONE || lv_img_get_angle(canvas) != 0) return false;
+
+	lv_area_t* c = &canvas->coords;
+	lv_coord_t w = slot->dsc.header.w;
+	lv_coord_t h = slot->dsc.header.h;
+	if (w != lv_area_get_width(c) || h != lv_area_get_height(c)) return false;
+
+	display->waitVsync();
+	if (!display->pushFrame(c->x1, c->y1, w, h, (const uint16_t*)slot->dsc.data)) return false;
+	direct_shown = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * Q565压缩帧按条带解码并直接写屏（运行在LVGL任务中）
+ * 两个条带缓冲交替使用：pushStrip排队DMA后立即解码下一条带，解码与面板写入重叠
+ * @return 条件与presentDirect相同，不满足、没有条带缓冲或面板需要交换字节序时返回false，
+ *         由Q565解码器在LVGL绘制时解码
+ */
+bool ScenePlayer::presentQ565(SceneSlot* slot)
+{
+#if LV_COLOR_16_SWAP
+	if (q565_band[0] == NULL) return false;
+	if (lv_img_get_zoom(canvas) != LV_IMG_ZOOM_NONE || lv_img_get_angle(canvas) != 0) return false;
+
+	lv_area_t* c = &canvas->coords;
+	lv_coord_t w = slot->dsc.header.w;
+	lv_coord_t h = slot->dsc.header.h;
+	if (w != pack_w || w != lv_area_get_width(c) || h != lv_area_get_height(c)) return false;
+
+	Q565State st;
+	if (!q565_begin(&st, slot->dsc.data, slot->dsc.data_size)) return false;
+
+	display->waitVsync();
+	display->beginStrips();
+	uint8_t b = 0;
+	for (lv_coord_t y = 0; y < h; y += SCENE_Q565_LINES, b ^= 1)
+	{
+		lv_coord_t n = h - y < SCENE_Q565_LINES ? h - y : SCENE_Q565_LINES;
+		// 数据截断时剩余部分保持上一帧的内容
+		if (q565_decode(&st, q565_band[b], (uint32_t)n * w) != (uint32_t)n * w) break;
+		display->pushStrip(c->x1, c->y1 + y, w, n, (uint16_t*)q565_band[b]);
+	}
+	display->endStrips();
+	direct_shown = true;
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * 解码一帧JPEG并按条带直接写屏（运行在LVGL任务中）
+ */
+void ScenePlayer::presentJpeg(SceneSlot* slot)
+{
+	if (!jpeg.open(slot->data, slot->len)) return;
+	// 索引不带平均色时顺带在解码条带中采样，不必再读一遍帧数据
+	amb_sampling = !index_ambient && ambientDue(slot->frame_id);
+	amb_sum[0] = amb_sum[1] = amb_sum[2] = 0;
+	amb_n = 0;
+	jpeg.decode(jpegBandCb, this);
+	if (amb_sampling && amb_n) leds->setAmbient(amb_sum[0] / amb_n, amb_sum[1] / amb_n, amb_sum[2] / amb_n);
+	amb_sampling = false;
+}
+
+bool ScenePlayer::jpegBandCb(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px)
+{
+	ScenePlayer* self = (ScenePlayer*)user;
+	lv_area_t* c = &self->canvas->coords;
+	// 每帧第一条带对齐到面板扫描起点（未开启垂直同步时不等待）
+	if (y == 0) self->display->waitVsync();
+	if (self->amb_sampling) self->sampleBand(y, w, h, px);
+	self->display->pushRect(c->x1, c->y1 + y, w, h, (uint16_t*)px);
+	return self->playing;
+}
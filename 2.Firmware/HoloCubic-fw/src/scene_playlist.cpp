@@ -0,0 +1,247 @@
+/*
+ * HoloCubic 场景播放列表
+ *
+ * 功能说明：
+ * 1. 从SD卡读取播放列表（S:/Scenes/playlist.txt），按顺序循环播放各场景
+ * 2. 当前场景结束前在后台预载下一场景（文件头、帧索引与前几帧），切换时没有空白与停顿
+ * 3. 切换方式：到时长立即切换，或等动画播完一个循环再切换
+ *
+ * 播放列表格式（每行一个场景，#开头为注释，时长/帧率/切换方式可省略）：
+ *   # 名称         秒数  帧率  切换
+ *   Holo3D         30    25    loop
+ *   galaxy.holo    20    0     cut
+ *
+ * 注意事项：
+ * - 预载任务中只调用未在播放的播放器的open与preroll，它们不访问LVGL对象
+ * - 预载未完成时当前场景继续播放，不提前中断（SD卡较慢时场景会略长于设定时长）
+ */
+
+#include "scene_playlist.h"
+#include "sd_card.h"
+#include "logger.h"
+
+// preload_state
+#define PRELOAD_IDLE 0
+#define PRELOAD_BUSY 1
+#define PRELOAD_READY 2
+#define PRELOAD_FAILED 3
+
+void ScenePlaylist::begin(ScenePlayer* a, ScenePlayer* b)
+{
+	players[0] = a;
+	players[1] = b;
+	cur = 0;
+	count = 0;
+	task = NULL;
+	preload_task = NULL;
+	preload_state = 0;
+	retire = false;
+}
+
+/**
+ * 读取播放列表文件，替换现有条目
+ * @return 文件不存在或没有有效条目时返回false
+ */
+bool ScenePlaylist::load(const char* path)
+{
+	File f = SD_FS.open(path);
+	if (!f) return false;
+
+	clear();
+	char line[96];
+	while (f.available())
+	{
+		size_t n = f.readBytesUntil('\n', line, sizeof(line) - 1);
+		line[n] = '\0';
+		char* p = line;
+		while (*p == ' ' || *p == '\t') p++;
+		if (*p == '#' || *p == '\r' || *p == '\0') continue;
+
+		PlaylistItem item;
+		memset(&item, 0, sizeof(item));
+		char name[SCENE_INDEX_NAME_MAX + 1];
+		char mode[8] = "";
+		unsigned sec = 0, fps = 0;
+		if (sscanf(p, "%36s %u %u %7s", name, &sec, &fps, mode) < 1 || strlen(name) >= SCENE_INDEX_NAME_MAX)
+		{
+			LOG_W("playlist", "无法识别: %s", p);
+			continue;
+		}
+		strcpy(item.name, name);
+		item.duration_ms = sec ? sec * 1000 : PLAYLIST_DEFAULT_MS;
+		item.fps = fps > 255 ? 255 : fps;
+		item.transition = strcmp(mode, "loop") == 0 ? PLAYLIST_LOOP_END : PLAYLIST_CUT;
+		if (!add(item)) break;
+	}
+	f.close();
+	LOG_I("playlist", "播放列表: %u个场景", count);
+	return count > 0;
+}
+
+bool ScenePlaylist::add(const PlaylistItem& item)
+{
+	if (count >= PLAYLIST_MAX) return false;
+	items[count++] = item;
+	return true;
+}
+
+void ScenePlaylist::clear()
+{
+	stop();
+	count = 0;
+}
+
+bool ScenePlaylist::openItem(ScenePlayer* p, uint8_t i)
+{
+	char path[SCENE_PATH_MAX];
+	snprintf(path, sizeof(path), "%s/%s", SCENE_ROOT, items[i].name);
+	return p->open(path, 0, items[i].fps);
+}
+
+/**
+ * 从第first个条目起，找到第一个能打开的条目开始播放
+ */
+bool ScenePlaylist::start(lv_obj_t* img, uint8_t first)
+{
+	stop();
+	canvas = img;
+	for (uint8_t k = 0; k < count; k++)
+	{
+		uint8_t i = (first + k) % count;
+		if (!openItem(players[cur], i)) continue;
+		cur_item = i;
+		players[cur]->play(canvas);
+		started_ms = millis();
+		task = lv_task_create(tickCb, PLAYLIST_TICK_MS, LV_TASK_PRIO_MID, this);
+		return true;
+	}
+	LOG_W("playlist", "没有可播放的场景");
+	return false;
+}
+
+/**
+ * 停止轮播并关闭两个播放器
+ */
+void ScenePlaylist::stop()
+{
+	if (task == NULL) return;
+	lv_task_del(task);
+	task = NULL;
+	while (preload_task != NULL) vTaskDelay(1);
+	preload_state = PRELOAD_IDLE;
+	retire = false;
+	players[cur ^ 1]->close();
+	players[cur]->close();
+}
+
+bool ScenePlaylist::isRunning()
+{
+	return task != NULL;
+}
+
+int ScenePlaylist::current()
+{
+	return task ? cur_item : -1;
+}
+
+/**
+ * 在后台任务中打开下一场景并启动预读
+ */
+void ScenePlaylist::startPreload()
+{
+	next_item = (cur_item + 1) % count;
+	preload_state = PRELOAD_BUSY;
+	if (xTaskCreatePinnedToCore(preloadEntry, "playlist", PLAYLIST_TASK_STACK, this,
+								PLAYLIST_TASK_PRIORITY, &preload_task, PLAYLIST_TASK_CORE) != pdPASS)
+	{
+		preload_task = NULL;
+		preload_state = PRELOAD_FAILED;
+	}
+}
+
+void ScenePlaylist::preloadEntry(void* arg)
+{
+	ScenePlaylist* self = (ScenePlaylist*)arg;
+	ScenePlayer* next = self->players[self->cur ^ 1];
+	bool ok = self->openItem(next, self->next_item) && next->preroll();
+	if (!ok)
+	{
+		// 多半是两个场景的缓冲区放不下，切换时先关闭当前场景再打开
+		next->close();
+		LOG_W("playlist", "无法预载%s，切换时会有停顿", self->items[self->next_item].name);
+	}
+	self->preload_state = ok ? PRELOAD_READY : PRELOAD_FAILED;
+	self->preload_task = NULL;
+	vTaskDelete(NULL);
+}
+
+/**
+ * 是否到了切换时刻
+ */
+bool ScenePlaylist::switchDue(uint32_t elapsed)
+{
+	const PlaylistItem* item = &items[cur_item];
+	if (elapsed < item->duration_ms) return false;
+	if (item->transition != PLAYLIST_LOOP_END || elapsed >= item->duration_ms + PLAYLIST_LOOP_WAIT_MS) return true;
+	ScenePlayer* p = players[cur];
+	return p->getShownFrame() == p->getFrameCount() - 1;
+}
+
+/**
+ * 切换到下一场景
+ */
+void ScenePlaylist::advance()
+{
+	ScenePlayer* p = players[cur];
+	ScenePlayer* q = players[cur ^ 1];
+	if (preload_state == PRELOAD_READY)
+	{
+		// 当前帧保留在屏幕上，新场景的第一帧已读入，下一次轮询即可上屏
+		p->stop();
+		q->play(canvas);
+		cur ^= 1;
+		retire = true;
+		cur_item = next_item;
+	}
+	else
+	{
+		// 退回：依次尝试之后的条目，都打不开时继续播放当前场景
+		p->close();
+		for (uint8_t k = 1; k <= count; k++)
+		{
+			uint8_t i = (cur_item + k) % count;
+			if (openItem(p, i))
+			{
+				cur_item = i;
+				break;
+			}
+		}
+		p->play(canvas);
+	}
+	LOG_I("playlist", "切换到场景: %s", items[cur_item].name);
+	preload_state = PRELOAD_IDLE;
+	started_ms = millis();
+}
+
+/**
+ * 调度定时任务（LVGL任务中）
+ */
+void ScenePlaylist::tickCb(lv_task_t* t)
+{
+	ScenePlaylist* self = (ScenePlaylist*)t->user_data;
+	if (self->count < 2) return;
+
+	// 新场景已显示第一帧，屏幕不再引用上一场景的缓冲区
+	if (self->retire && self->players[self->cur]->getShownFrame() >= 0)
+	{
+		self->players[self->cur ^ 1]->close();
+		self->retire = false;
+	}
+
+	uint32_t elapsed = millis() - self->started_ms;
+	uint32_t dur = self->items[self->cur_item].duration_ms;
+	if (self->preload_state == PRELOAD_IDLE && !self->retire && elapsed + PLAYLIST_PRELOAD_MS >= dur)
+		self->startPreload();
+	if (self->preload_state == PRELOAD_BUSY || self->retire || !self->switchDue(elapsed)) return;
+	self->advance();
+}
@@ -0,0 +1,370 @@
+/*
+ * HoloCubic 多设备场景同步
+ *
+ * 功能说明：
+ * 1. 同步任务（核心0）收发UDP包：接收超时兼作定时，到期时广播ANNOUNCE、向主机发送DELAY_REQ
+ * 2. 选举：组内MAC最小、且SYNC_LEADER_TIMEOUT_MS内发过ANNOUNCE的设备为主机，没有比本机小的即本机为主机
+ * 3. 时钟偏差：跟随方每SYNC_DELAY_REQ_MS测量一次，最近SYNC_FILTER_N次中往返最短的一次作为当前偏差
+ * 4. 场景对齐：主机的场景时间轴换算到本机时钟后交给正在播放的ScenePlayer::setEpoch
+ *
+ * 时间换算：
+ *   主机帧号0时刻E（主机时钟） --> 本机时刻 E - offset --> 低32位即ScenePlayer使用的micros()
+ *   ScenePlayer::getEpoch给出的32位时刻按当前64位时钟展开后广播（播放时间轴离当前时刻不超过半个回绕周期）
+ *
+ * 注意事项：
+ * - 收发都在同步任务中，成员只在该任务中写入；getter读取的是单个字段，不加锁
+ * - 切换场景时主机的ANNOUNCE最多晚SYNC_ANNOUNCE_MS，这段时间内跟随方保持原来的时间轴
+ */
+
+#include "scene_sync.h"
+#include "network.h"
+#include "logger.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <esp_timer.h>
+#include <esp_rom_crc.h>
+
+SceneSync scenesync;
+
+SceneSync::SceneSync()
+{
+	net = NULL;
+	players[0] = players[1] = NULL;
+	group = 0;
+	memset(mac, 0, sizeof(mac));
+	sock = -1;
+	task = NULL;
+	running = false;
+	has_leader = false;
+	memset(leader_mac, 0, sizeof(leader_mac));
+	leader_ip = 0;
+	leader_seen = 0;
+	memset(&leader_state, 0, sizeof(leader_state));
+	resetFilter();
+	announce_due = 0;
+	delay_due = 0;
+	aligning = false;
+}
+
+/**
+ * 打开同步端口并启动同步任务（重复调用直接返回）
+ */
+bool SceneSync::begin(Network* network, ScenePlayer* a, ScenePlayer* b, uint8_t group_id)
+{
+	if (running) return true;
+	if (group_id == 0 || a == NULL) return false;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(SYNC_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (sock < 0 || bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0)
+	{
+		LOG_W("sync", "同步端口%u绑定失败", SYNC_PORT);
+		if (sock >= 0) closesocket(sock);
+		sock = -1;
+		return false;
+	}
+	int on = 1;
+	setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+	timeval tv = { 0, SYNC_RECV_TIMEOUT_MS * 1000 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	net = network;
+	players[0] = a;
+	players[1] = b;
+	group = group_id;
+	WiFi.macAddress(mac);
+	has_leader = false;
+	aligning = false;
+	resetFilter();
+	announce_due = delay_due = millis();
+	if (net) net->acquire();
+
+	running = true;
+	if (xTaskCreatePinnedToCore(taskEntry, "sync", SYNC_TASK_STACK, this,
+								SYNC_TASK_PRIORITY, &task, SYNC_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		running = false;
+		closesocket(sock);
+		sock = -1;
+		if (net) net->release();
+		return false;
+	}
+	LOG_I("sync", "场景同步已启动: 组%u UDP %u", group, SYNC_PORT);
+	return true;
+}
+
+void SceneSync::end()
+{
+	if (!running) return;
+	running = false;
+	while (task != NULL) vTaskDelay(pdMS_TO_TICKS(10));
+	closesocket(sock);
+	sock = -1;
+	if (aligning)
+	{
+		for (uint8_t i = 0; i < 2; i++)
+			if (players[i]) players[i]->clearEpoch();
+		aligning = false;
+	}
+	if (net) net->release();
+}
+
+bool SceneSync::isRunning()
+{
+	return running;
+}
+
+bool SceneSync::isLeader()
+{
+	return running && !has_leader;
+}
+
+bool SceneSync::isLocked()
+{
+	return running && (!has_leader || locked);
+}
+
+int32_t SceneSync::getOffset()
+{
+	return has_leader ? (int32_t)offset : 0;
+}
+
+uint32_t SceneSync::getRtt()
+{
+	return has_leader ? rtt : 0;
+}
+
+void SceneSync::resetFilter()
+{
+	memset(samples, 0, sizeof(samples));
+	sample_count = 0;
+	sample_pos = 0;
+	pending_t1 = 0;
+	offset = 0;
+	rtt = 0;
+	locked = false;
+}
+
+/**
+ * 正在播放且已有时间轴的播放器（播放列表切换时两个播放器短暂重叠，取先找到的一个）
+ * @param scene_id 输出场景路径的CRC32
+ */
+ScenePlayer* SceneSync::activePlayer(uint32_t* scene_id)
+{
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		ScenePlayer* p = players[i];
+		uint32_t e;
+		if (p == NULL || !p->isPlaying() || !p->getEpoch(&e)) continue;
+		const char* path = p->getPath();
+		if (path == NULL) continue;
+		*scene_id = esp_rom_crc32_le(0, (const uint8_t*)path, strlen(path));
+		return p;
+	}
+	return NULL;
+}
+
+void SceneSync::send(uint8_t op, const void* payload, uint16_t len, uint32_t ip)
+{
+	uint8_t buf[sizeof(SyncHeader) + sizeof(SyncAnnounce)];
+	SyncHeader* h = (SyncHeader*)buf;
+	h->magic[0] = SYNC_MAGIC0;
+	h->magic[1] = SYNC_MAGIC1;
+	h->version = SYNC_VERSION;
+	h->op = op;
+	h->group = group;
+	h->reserved = 0;
+	memcpy(h->mac, mac, sizeof(mac));
+	memcpy(buf + sizeof(*h), payload, len);
+
+	sockaddr_in to = {};
+	to.sin_family = AF_INET;
+	to.sin_port = htons(SYNC_PORT);
+	to.sin_addr.s_addr = ip;
+	sendto(sock, buf, sizeof(*h) + len, 0, (sockaddr*)&to, sizeof(to));
+}
+
+/**
+ * 广播本机时钟与场景时间轴
+ * 32位的帧号0时刻按当前64位时钟展开：与当前时刻的差按有符号数解释
+ */
+void SceneSync::announce()
+{
+	SyncAnnounce a;
+	memset(&a, 0, sizeof(a));
+	a.time_us = esp_timer_get_time();
+
+	uint32_t id;
+	ScenePlayer* p = activePlayer(&id);
+	uint32_t e;
+	if (p && p->getEpoch(&e))
+	{
+		a.scene_id = id;
+		a.frame_count = p->getFrameCount();
+		a.period_us = 1000000 / p->getFps();
+		a.epoch_us = a.time_us + (int32_t)(e - (uint32_t)a.time_us);
+	}
+	send(SYNC_OP_ANNOUNCE, &a, sizeof(a), htonl(INADDR_BROADCAST));
+}
+
+/**
+ * 记录主机：MAC比本机小、且不大于当前主机的设备
+ * 主机改变时偏差重新测量
+ */
+void SceneSync::onAnnounce(const SyncHeader* h, const SyncAnnounce* a, uint32_t ip)
+{
+	if (memcmp(h->mac, mac, sizeof(mac)) >= 0) return;
+	if (has_leader && memcmp(h->mac, leader_mac, sizeof(leader_mac)) > 0) return;
+
+	if (!has_leader || memcmp(h->mac, leader_mac, sizeof(leader_mac)) != 0)
+	{
+		LOG_I("sync", "主机: %02x:%02x:%02x:%02x:%02x:%02x",
+			  h->mac[0], h->mac[1], h->mac[2], h->mac[3], h->mac[4], h->mac[5]);
+		memcpy(leader_mac, h->mac, sizeof(leader_mac));
+		has_leader = true;
+		resetFilter();
+		delay_due = millis();
+	}
+	leader_ip = ip;
+	leader_seen = millis();
+	leader_state = *a;
+	follow();
+}
+
+/**
+ * 回复时钟测量：t1原样带回，t2为接收时刻，t3为回复时刻
+ */
+void SceneSync::onDelayReq(const SyncDelay* d, uint32_t ip, int64_t rx)
+{
+	SyncDelay r;
+	r.t1 = d->t1;
+	r.t2 = rx;
+	r.t3 = esp_timer_get_time();
+	send(SYNC_OP_DELAY_RESP, &r, sizeof(r), ip);
+}
+
+/**
+ * 计算一次偏差并更新滤波窗口
+ * 往返时延越短，排队造成的去程/回程不对称越小，窗口内取往返最短的一次
+ */
+void SceneSync::onDelayResp(const SyncDelay* d, int64_t rx)
+{
+	if (!has_leader || d->t1 != pending_t1) return;
+	pending_t1 = 0;
+
+	int64_t r = (rx - d->t1) - (d->t3 - d->t2);
+	if (r < 0 || r > SYNC_MAX_RTT_US) return;
+
+	Sample* s = &samples[sample_pos];
+	s->offset = ((d->t2 - d->t1) + (d->t3 - rx)) / 2;
+	s->rtt = (uint32_t)r;
+	sample_pos = (sample_pos + 1) % SYNC_FILTER_N;
+	if (sample_count < SYNC_FILTER_N) sample_count++;
+
+	const Sample* best = &samples[0];
+	for (uint8_t i = 1; i < sample_count; i++)
+		if (samples[i].rtt < best->rtt) best = &samples[i];
+	offset = best->offset;
+	rtt = best->rtt;
+	if (!locked && sample_count >= SYNC_LOCK_MIN)
+	{
+		locked = true;
+		LOG_I("sync", "时钟已同步: 偏差%ldus 往返%luus", (long)offset, (unsigned long)rtt);
+	}
+	follow();
+}
+
+/**
+ * 把主机的时间轴交给播放同一场景的播放器；不满足条件时取消对齐
+ */
+void SceneSync::follow()
+{
+	ScenePlayer* p = NULL;
+	uint32_t id = 0;
+	if (has_leader && locked && leader_state.scene_id != 0) p = activePlayer(&id);
+	if (p && id == leader_state.scene_id && p->getFrameCount() == leader_state.frame_count &&
+		1000000 / p->getFps() == leader_state.period_us)
+	{
+		p->setEpoch((uint32_t)(leader_state.epoch_us - offset));
+		aligning = true;
+		return;
+	}
+	if (aligning)
+	{
+		for (uint8_t i = 0; i < 2; i++)
+			if (players[i]) players[i]->clearEpoch();
+		aligning = false;
+	}
+}
+
+/**
+ * 同步任务：接收、定时广播、定时测量
+ */
+void SceneSync::taskEntry(void* arg)
+{
+	SceneSync* self = (SceneSync*)arg;
+	uint8_t rx[sizeof(SyncHeader) + sizeof(SyncAnnounce)];
+
+	while (self->running)
+	{
+		sockaddr_in from;
+		socklen_t from_len = sizeof(from);
+		int n = recvfrom(self->sock, rx, sizeof(rx), 0, (sockaddr*)&from, &from_len);
+		int64_t rx_us = esp_timer_get_time();
+		const SyncHeader* h = (const SyncHeader*)rx;
+		const uint8_t* payload = rx + sizeof(SyncHeader);
+		if (n >= (int)sizeof(SyncHeader) && h->magic[0] == SYNC_MAGIC0 && h->magic[1] == SYNC_MAGIC1 &&
+			h->version == SYNC_VERSION && h->group == self->group &&
+			memcmp(h->mac, self->mac, sizeof(self->mac)) != 0)
+		{
+			int len = n - (int)sizeof(SyncHeader);
+			if (h->op == SYNC_OP_ANNOUNCE && len >= (int)sizeof(SyncAnnounce))
+			{
+				SyncAnnounce a;
+				memcpy(&a, payload, sizeof(a));
+				self->onAnnounce(h, &a, from.sin_addr.s_addr);
+			}
+			else if (h->op == SYNC_OP_DELAY_REQ && len >= (int)sizeof(SyncDelay))
+			{
+				SyncDelay d;
+				memcpy(&d, payload, sizeof(d));
+				self->onDelayReq(&d, from.sin_addr.s_addr, rx_us);
+			}
+			else if (h->op == SYNC_OP_DELAY_RESP && len >= (int)sizeof(SyncDelay))
+			{
+				SyncDelay d;
+				memcpy(&d, payload, sizeof(d));
+				self->onDelayResp(&d, rx_us);
+			}
+		}
+
+		uint32_t now = millis();
+		if (self->has_leader && now - self->leader_seen > SYNC_LEADER_TIMEOUT_MS)
+		{
+			LOG_I("sync", "主机超时，重新选举");
+			self->has_leader = false;
+			self->resetFilter();
+			self->follow();
+		}
+		if ((int32_t)(now - self->announce_due) >= 0)
+		{
+			self->announce();
+			self->announce_due = now + SYNC_ANNOUNCE_MS;
+		}
+		if (self->has_leader && (int32_t)(now - self->delay_due) >= 0)
+		{
+			SyncDelay d;
+			memset(&d, 0, sizeof(d));
+			d.t1 = esp_timer_get_time();
+			self->pending_t1 = d.t1;
+			self->send(SYNC_OP_DELAY_REQ, &d, sizeof(d), self->leader_ip);
+			self->delay_due = now + SYNC_DELAY_REQ_MS;
+		}
+	}
+	self->task = NULL;
+	vTaskDelete(NULL);
+}
@@ -0,0 +1,321 @@
+/**
+ * @file screen_manager.c
+ * @brief 按需创建/回收的屏幕管理
+ *
+ * 功能概述：
+ * 界面原先在setup_ui()中一次建好所有屏幕，所有屏幕的对象与样式常驻LVGL堆。
+ * 这里改为首次切换到某个屏幕时才调用其setup创建，离开后按最近使用顺序
+ * 保留SCR_MGR_WARM个，超出的删除并调用cleanup释放样式，
+ * LVGL堆占用随打开过的屏幕数而不是应用总数增长。
+ *
+ * 实现：
+ * 1. 切换使用lv_scr_load_anim（不使用auto_del）；正在显示或处于切换动画中的屏幕不删除，
+ *    切换动画结束后由一次性lv_task再回收一次
+ * 2. 屏幕根对象的LV_EVENT_DELETE中登记待清理，cleanup推迟到删除完成后执行
+ *    （事件发出时子对象尚未删除，仍引用着样式）
+ * 3. 界面文字变化（切换语言）时scr_mgr_rebuild删除离开的屏幕，当前屏幕在同一次调用中删除并重建
+ * 4. setup期间打开样式分配区：新建的样式属性表与本地样式从一块内存顺序分配，
+ *    不再逐个属性realloc，屏幕的对象全部删除后整块释放，切换屏幕不在LVGL堆中留下小碎片
+ *
+ * 仅在LVGL任务中调用
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "screen_manager.h"
+#include <string.h>
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+typedef struct
+{
+	lv_obj_t* scr;
+	uint32_t last_use;
+	bool pending;       // 已删除，cleanup尚未执行
+	bool stale;         // 内容已过时（scr_mgr_rebuild时不能删除），下次打开时重建
+} scr_slot_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static lv_obj_t** root_of(uint8_t id);
+static void build(uint8_t id);
+static void evict(void);
+static bool busy(lv_obj_t* scr);
+static lv_obj_t* target(void);
+static void evict_task(lv_task_t* task);
+static void rebuild_task(lv_task_t* task);
+static void run_pending(void* user_data);
+static void scr_event_cb(lv_obj_t* obj, lv_event_t event);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+static void* mgr_ctx;
+static const scr_mgr_def_t* mgr_defs;
+static uint8_t mgr_cnt;
+static scr_slot_t slots[SCR_MGR_MAX];
+static uint32_t use_tick;
+static bool async_queued;
+static bool rebuild_queued;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * 登记屏幕表
+ *
+ * @param ctx  传给setup/cleanup的上下文（GUI向导的lv_ui）
+ * @param defs 屏幕定义表，需长期有效
+ * @param cnt  屏幕数，超过SCR_MGR_MAX的部分忽略
+ */
+void scr_mgr_init(void* ctx, const scr_mgr_def_t* defs, uint8_t cnt)
+{
+	mgr_ctx = ctx;
+	mgr_defs = defs;
+	mgr_cnt = cnt > SCR_MGR_MAX ? SCR_MGR_MAX : cnt;
+	memset(slots, 0, sizeof(slots));
+	use_tick = 0;
+}
+
+/**
+ * 切换到屏幕
+ *
+ * @param id   屏幕编号（defs中的下标）
+ * @param anim 切换动画，LV_SCR_LOAD_ANIM_NONE时立即切换
+ * @param time 动画时长（ms）
+ * @return 屏幕对象；创建失败或id无效时返回NULL
+ */
+lv_obj_t* scr_mgr_open(uint8_t id, lv_scr_load_anim_t anim, uint32_t time)
+{
+	if (id >= mgr_cnt) return NULL;
+
+	run_pending(NULL);
+	if (slots[id].scr && slots[id].stale && !busy(slots[id].scr))
+	{
+		lv_obj_del(slots[id].scr);
+		run_pending(NULL);
+	}
+	if (slots[id].scr == NULL) build(id);
+	if (slots[id].scr == NULL) return NULL;
+	slots[id].last_use = ++use_tick;
+
+	if (target() == slots[id].scr) return slots[id].scr;
+
+	if (anim == LV_SCR_LOAD_ANIM_NONE) time = 0;
+	// 上一次切换的动画尚未开始时撤销它，否则它稍后仍会把屏幕切过去
+	lv_disp_t* d = lv_disp_get_default();
+	if (d->scr_to_load && d->scr_to_load != d->act_scr)
+	{
+		lv_anim_del(d->scr_to_load, NULL);
+		lv_obj_set_pos(d->scr_to_load, 0, 0);
+	}
+	lv_scr_load_anim(slots[id].scr, anim, time, 0, false);
+	evict();
+	// 离开的屏幕在动画结束后才能删除
+	lv_task_t* task = lv_task_create(evict_task, time + 1, LV_TASK_PRIO_LOW, NULL);
+	if (task) lv_task_set_repeat_count(task, 1);
+	return slots[id].scr;
+}
+
+lv_obj_t* scr_mgr_get(uint8_t id)
+{
+	return id < mgr_cnt ? slots[id].scr : NULL;
+}
+
+int scr_mgr_current(void)
+{
+	lv_obj_t* act = target();
+	for (uint8_t i = 0; i < mgr_cnt; i++)
+	{
+		if (slots[i].scr != NULL && slots[i].scr == act) return i;
+	}
+	return -1;
+}
+
+/**
+ * 删除除当前屏幕外所有可回收的屏幕
+ */
+void scr_mgr_trim(void)
+{
+	for (uint8_t i = 0; i < mgr_cnt; i++)
+	{
+		if (slots[i].scr == NULL || mgr_defs[i].keep || busy(slots[i].scr)) continue;
+		lv_obj_del(slots[i].scr);
+	}
+	run_pending(NULL);
+}
+
+/**
+ * 重建屏幕
+ * 离开的屏幕直接删除（下次打开时按新的内容创建）；当前屏幕先换上一个空屏幕，
+ * 删除、cleanup、setup与重新加载在同一次调用中完成，其间不会刷新，看不到空屏幕。
+ * 切换动画进行中时等动画结束后再重建；keep的屏幕不重建。
+ * 当前显示的是应用自己的屏幕时只标记已建好的屏幕，下次scr_mgr_open时重建
+ */
+void scr_mgr_rebuild(void)
+{
+	if (mgr_defs == NULL) return;
+	lv_disp_t* d = lv_disp_get_default();
+	if (d->scr_to_load || d->prev_scr)
+	{
+		if (rebuild_queued) return;
+		lv_task_t* task = lv_task_create(rebuild_task, SCR_MGR_ANIM_TIME, LV_TASK_PRIO_LOW, NULL);
+		if (task) lv_task_set_repeat_count(task, 1);
+		rebuild_queued = task != NULL;
+		return;
+	}
+
+	int id = scr_mgr_current();
+	if (id < 0)
+	{
+		// 当前是应用自己的屏幕，应用可能还引用着离开时的屏幕（返回时直接加载），不删除
+		for (uint8_t i = 0; i < mgr_cnt; i++)
+		{
+			if (slots[i].scr && !mgr_defs[i].keep) slots[i].stale = true;
+		}
+		return;
+	}
+	scr_mgr_trim();
+	if (mgr_defs[id].keep) return;
+
+	lv_obj_t* blank = lv_obj_create(NULL, NULL);
+	if (blank == NULL) return;
+	lv_disp_load_scr(blank);
+	lv_obj_del(slots[id].scr);
+	run_pending(NULL);
+	build(id);
+	// 创建失败时留在空屏幕上
+	if (slots[id].scr == NULL) return;
+	slots[id].last_use = ++use_tick;
+	lv_disp_load_scr(slots[id].scr);
+	lv_obj_del(blank);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static lv_obj_t** root_of(uint8_t id)
+{
+	return (lv_obj_t**)((uint8_t*)mgr_ctx + mgr_defs[id].root_ofs);
+}
+
+/**
+ * 调用setup创建屏幕，并挂上删除事件
+ */
+static void build(uint8_t id)
+{
+	lv_obj_t** root = root_of(id);
+	*root = NULL;
+#if LV_USE_STYLE_ARENA
+	lv_style_arena_t* arena = lv_style_arena_open(SCR_MGR_STYLE_ARENA);
+	mgr_defs[id].setup(mgr_ctx);
+	lv_style_arena_close(arena);
+#else
+	mgr_defs[id].setup(mgr_ctx);
+#endif
+	slots[id].scr = *root;
+	slots[id].pending = false;
+	slots[id].stale = false;
+	if (slots[id].scr == NULL)
+	{
+		LV_LOG_WARN("screen setup failed");
+		return;
+	}
+	lv_obj_set_event_cb(slots[id].scr, scr_event_cb);
+}
+
+/**
+ * 最后一次请求切换到的屏幕（切换动画尚未开始时lv_scr_act()仍是旧屏幕）
+ */
+static lv_obj_t* target(void)
+{
+	lv_disp_t* d = lv_disp_get_default();
+	return d->scr_to_load ? d->scr_to_load : d->act_scr;
+}
+
+/**
+ * 正在显示、即将显示或正在切换出去的屏幕
+ */
+static bool busy(lv_obj_t* scr)
+{
+	lv_disp_t* d = lv_obj_get_disp(scr);
+	return scr == d->act_scr || scr == d->prev_scr || scr == d->scr_to_load;
+}
+
+/**
+ * 按最近使用顺序回收屏幕，使当前屏幕之外保留的屏幕不超过SCR_MGR_WARM个
+ * 处于显示或切换中的屏幕暂不删除（计入保留数），切换结束后的下一次回收再处理
+ */
+static void evict(void)
+{
+	while (true)
+	{
+		uint8_t warm = 0;
+		int oldest = -1;
+		for (uint8_t i = 0; i < mgr_cnt; i++)
+		{
+			// 最近打开的是当前屏幕，不计入保留数
+			if (slots[i].scr == NULL || mgr_defs[i].keep || slots[i].last_use == use_tick) continue;
+			warm++;
+			if (busy(slots[i].scr)) continue;
+			if (oldest < 0 || slots[i].last_use < slots[oldest].last_use) oldest = i;
+		}
+		if (warm <= SCR_MGR_WARM || oldest < 0) break;
+		lv_obj_del(slots[oldest].scr);
+	}
+	run_pending(NULL);
+}
+
+static void evict_task(lv_task_t* task)
+{
+	(void)task;
+	evict();
+}
+
+static void rebuild_task(lv_task_t* task)
+{
+	(void)task;
+	rebuild_queued = false;
+	scr_mgr_rebuild();
+}
+
+/**
+ * 执行已删除屏幕的cleanup
+ */
+static void run_pending(void* user_data)
+{
+	(void)user_data;
+	async_queued = false;
+	for (uint8_t i = 0; i < mgr_cnt; i++)
+	{
+		if (!slots[i].pending) continue;
+		slots[i].pending = false;
+		if (mgr_defs[i].cleanup) mgr_defs[i].cleanup(mgr_ctx);
+	}
+}
+
+/**
+ * 屏幕被删除（回收，或被其他代码直接删除）
+ */
+static void scr_event_cb(lv_obj_t* obj, lv_event_t event)
+{
+	if (event != LV_EVENT_DELETE) return;
+
+	for (uint8_t i = 0; i < mgr_cnt; i++)
+	{
+		if (slots[i].scr != obj) continue;
+		slots[i].scr = NULL;
+		slots[i].pending = true;
+		*root_of(i) = NULL;
+		if (!async_queued) async_queued = lv_async_call(run_pending, NULL) == LV_RES_OK;
+		break;
+	}
+}
@@ -0,0 +1,349 @@
+/*
+ * HoloCubic 录屏
+ *
+ * 功能说明：
+ * 1. 在刷新回调上挂旁路，每个刷新区域逐行按REC_SEG_PX分段计算散列，与上次记录的散列比较
+ * 2. 变化的段按行合并为脏矩形（相邻行的变化段相同时合为一个矩形），连同像素写入后台SD写入流
+ * 3. 一次刷新的最后一个区域之后写帧标记（毫秒时间戳），主机端按时间戳还原为视频
+ *
+ * 数据流：
+ *   lv_refr --> Display刷新回调 --> tapCb（分段散列、合并脏矩形） --> SdWriter（内存缓冲） --> 写入任务 --> SD卡
+ */
+
+#include "screen_record.h"
+#include "sd_card.h"
+#include "logger.h"
+
+ScreenRecord screenrec;
+
+static void put_le16(uint8_t* p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t* p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+/**
+ * 一段像素的散列（FNV-1a），不返回0（0表示未知）
+ */
+static inline uint32_t seg_hash(const lv_color_t* px, lv_coord_t n)
+{
+	uint32_t h = 2166136261U;
+	for (lv_coord_t i = 0; i < n; i++)
+	{
+		h ^= px[i].full;
+		h *= 16777619U;
+	}
+	return h ? h : 1;
+}
+
+ScreenRecord::ScreenRecord()
+{
+	display = NULL;
+	lock = NULL;
+	done = NULL;
+	hashes = NULL;
+	packet = NULL;
+	active = false;
+	dirty = false;
+	width = 0;
+	height = 0;
+	segs = 0;
+	frames = 0;
+	rects = 0;
+	lost = 0;
+}
+
+/**
+ * 指定录屏的显示（只保存指针，开始录屏时才分配散列表）
+ */
+void ScreenRecord::begin(Display* disp)
+{
+	display = disp;
+	if (lock == NULL) lock = xSemaphoreCreateMutex();
+	if (done == NULL) done = xSemaphoreCreateBinary();
+}
+
+bool ScreenRecord::isRecording()
+{
+	return active;
+}
+
+/**
+ * 写出一个脏矩形（LVGL任务），超过REC_PACKET_MAX时按行拆分为多个包
+ * 缓冲已满整包丢弃时清除对应段的散列，下次刷新这些段时重新记录
+ */
+void ScreenRecord::emit(const lv_area_t* area, const lv_color_t* color_p, lv_coord_t x1, lv_coord_t x2, lv_coord_t y1, lv_coord_t y2)
+{
+	lv_coord_t w = x2 - x1 + 1;
+	lv_coord_t stride = lv_area_get_width(area);
+	lv_coord_t rows_max = (REC_PACKET_MAX - REC_RECT_HEADER) / (w * sizeof(lv_color_t));
+
+	for (lv_coord_t y = y1; y <= y2; y += rows_max)
+	{
+		lv_coord_t h = y2 - y + 1;
+		if (h > rows_max) h = rows_max;
+
+		packet[0] = 'R';
+		put_le16(packet + 1, x1);
+		put_le16(packet + 3, y);
+		put_le16(packet + 5, w);
+		put_le16(packet + 7, h);
+		uint8_t* p = packet + REC_RECT_HEADER;
+		for (lv_coord_t r = 0; r < h; r++)
+		{
+			memcpy(p, color_p + (uint32_t)(y + r - area->y1) * stride + (x1 - area->x1), w * sizeof(lv_color_t));
+			p += w * sizeof(lv_color_t);
+		}
+
+		if (out.write(packet, p - packet))
+		{
+			rects++;
+			dirty = true;
+			continue;
+		}
+		lost++;
+		for (lv_coord_t r = 0; r < h; r++)
+		{
+			uint32_t* hrow = hashes + (uint32_t)(y + r) * segs;
+			for (uint8_t s = x1 / REC_SEG_PX; s <= x2 / REC_SEG_PX; s++) hrow[s] = 0;
+		}
+	}
+}
+
+/**
+ * 刷新旁路（LVGL任务）：逐行求出变化段的掩码，掩码相同的相邻行合并，每段连续的变化段写出一个矩形
+ * 只部分落在区域内的段没有完整的像素可比较：直接记录区域内的部分，并把散列清除
+ */
+void ScreenRecord::tapCb(const lv_area_t* area, const lv_color_t* color_p, void* user)
+{
+	ScreenRecord* self = (ScreenRecord*)user;
+	if (!self->active) return;
+
+	lv_coord_t stride = lv_area_get_width(area);
+	lv_coord_t x2 = LV_MATH_MIN(area->x2, self->width - 1);
+	lv_coord_t y2 = LV_MATH_MIN(area->y2, self->height - 1);
+	if (area->x1 < 0 || area->y1 < 0 || area->x1 > x2 || area->y1 > y2) return;
+
+	uint8_t s1 = area->x1 / REC_SEG_PX;
+	uint8_t s2 = x2 / REC_SEG_PX;
+	uint16_t run_mask = 0;
+	lv_coord_t run_y = area->y1;
+
+	for (lv_coord_t y = area->y1; y <= y2 + 1; y++)
+	{
+		uint16_t mask = 0;
+		if (y <= y2)
+		{
+			const lv_color_t* row = color_p + (uint32_t)(y - area->y1) * stride;
+			uint32_t* hrow = self->hashes + (uint32_t)y * self->segs;
+			for (uint8_t s = s1; s <= s2; s++)
+			{
+				lv_coord_t sx1 = s * REC_SEG_PX;
+				lv_coord_t sx2 = LV_MATH_MIN(sx1 + REC_SEG_PX - 1, self->width - 1);
+				if (sx1 < area->x1 || sx2 > x2)
+				{
+					hrow[s] = 0;
+					mask |= 1U << s;
+					continue;
+				}
+				uint32_t h = seg_hash(row + (sx1 - area->x1), sx2 - sx1 + 1);
+				if (h != hrow[s])
+				{
+					hrow[s] = h;
+					mask |= 1U << s;
+				}
+			}
+			if (y > area->y1 && mask == run_mask) continue;
+		}
+
+		// 上一组行（run_y..y-1）的变化段按连续的段写出
+		for (uint8_t s = s1; s <= s2 && y > area->y1; s++)
+		{
+			if (!(run_mask & (1U << s))) continue;
+			uint8_t e = s;
+			while (e < s2 && (run_mask & (1U << (e + 1)))) e++;
+			lv_coord_t rx1 = LV_MATH_MAX(area->x1, s * REC_SEG_PX);
+			lv_coord_t rx2 = LV_MATH_MIN(x2, (e + 1) * REC_SEG_PX - 1);
+			self->emit(area, color_p, rx1, rx2, run_y, y - 1);
+			s = e;
+		}
+		run_mask = mask;
+		run_y = y;
+	}
+
+	if (lv_disp_flush_is_last(&self->display->getDisp()->driver) && self->dirty)
+	{
+		uint8_t frame[REC_FRAME_PACKET];
+		frame[0] = 'F';
+		put_le32(frame + 1, millis());
+		if (self->out.write(frame, sizeof(frame)))
+		{
+			self->frames++;
+			self->dirty = false;
+		}
+	}
+
+	if (self->out.getWritten() >= REC_FILE_MAX)
+	{
+		// 文件在stop时关闭，此前的数据已由写入任务定期同步
+		LOG_W("rec", "录屏文件达到上限，停止记录");
+		self->display->setFlushTap(NULL);
+		self->active = false;
+	}
+}
+
+/**
+ * 挂上旁路并整屏失效（LVGL任务），第一帧为完整画面
+ */
+void ScreenRecord::startCb(const UiMsg* msg)
+{
+	ScreenRecord* self = (ScreenRecord*)msg->obj;
+	// 旁路被占用（截图进行中）时不开始
+	if (self->display->getFlushTap() == NULL)
+	{
+		self->active = true;
+		self->display->setFlushTap(tapCb, self);
+		lv_obj_invalidate(lv_disp_get_scr_act(self->display->getDisp()));
+	}
+	xSemaphoreGive(self->done);
+}
+
+void ScreenRecord::stopCb(const UiMsg* msg)
+{
+	ScreenRecord* self = (ScreenRecord*)msg->obj;
+	if (self->display->getFlushTap() == tapCb) self->display->setFlushTap(NULL);
+	self->active = false;
+	xSemaphoreGive(self->done);
+}
+
+/**
+ * 在LVGL任务中执行并等待完成（已在LVGL任务中时直接调用）
+ */
+bool ScreenRecord::runOnUi(ui_msg_cb_t cb)
+{
+	if (xTaskGetCurrentTaskHandle() == runtime.getUiTask())
+	{
+		UiMsg msg = { cb, this, 0 };
+		cb(&msg);
+		xSemaphoreTake(done, 0);
+		return true;
+	}
+	if (!runtime.post(cb, this)) return false;
+	xSemaphoreTake(done, portMAX_DELAY);
+	return true;
+}
+
+void ScreenRecord::release()
+{
+	free(hashes);
+	free(packet);
+	hashes = NULL;
+	packet = NULL;
+}
+
+bool ScreenRecord::start(const char* path)
+{
+	if (display == NULL || display->getDisp() == NULL || lock == NULL) return false;
+	xSemaphoreTake(lock, portMAX_DELAY);
+	if (hashes != NULL)
+	{
+		xSemaphoreGive(lock);
+		return false;
+	}
+
+	lv_disp_t* d = display->getDisp();
+	width = lv_disp_get_hor_res(d);
+	height = lv_disp_get_ver_res(d);
+	segs = (width + REC_SEG_PX - 1) / REC_SEG_PX;
+	bool ok = width <= REC_WIDTH_MAX && height <= REC_HEIGHT_MAX;
+	if (ok)
+	{
+		hashes = (uint32_t*)calloc((uint32_t)height * segs, sizeof(uint32_t));
+		packet = (uint8_t*)malloc(REC_PACKET_MAX);
+		ok = hashes != NULL && packet != NULL;
+	}
+
+	char name[sizeof(REC_DIR) + 16];
+	if (ok && path == NULL)
+	{
+		SD_FS.mkdir(REC_DIR);
+		uint16_t i;
+		for (i = 1; i < 10000; i++)
+		{
+			snprintf(name, sizeof(name), REC_DIR "/rec_%04u.hrec", i);
+			if (!SD_FS.exists(name)) break;
+		}
+		ok = i < 10000;
+		path = name;
+	}
+	if (ok) ok = out.begin(path, false);
+	if (ok)
+	{
+		uint8_t head[REC_FILE_HEADER];
+		memcpy(head, "HREC", 4);
+		head[4] = REC_VERSION;
+		head[5] = LV_COLOR_16_SWAP ? 1 : 0;
+		put_le16(head + 6, width);
+		put_le16(head + 8, height);
+		put_le16(head + 10, REC_SEG_PX);
+		out.write(head, sizeof(head));
+
+		frames = 0;
+		rects = 0;
+		lost = 0;
+		dirty = false;
+		ok = runOnUi(startCb) && active;
+		if (!ok)
+		{
+			out.end();
+			SD_FS.remove(path);
+		}
+	}
+	if (!ok) release();
+	else LOG_I("rec", "开始录屏: %s", path);
+	xSemaphoreGive(lock);
+	return ok;
+}
+
+void ScreenRecord::stop()
+{
+	if (lock == NULL) return;
+	xSemaphoreTake(lock, portMAX_DELAY);
+	if (hashes != NULL)
+	{
+		// 旁路取下之后才能释放散列表
+		while (!runOnUi(stopCb)) vTaskDelay(pdMS_TO_TICKS(10));
+		out.end();
+		release();
+		LOG_I("rec", "录屏结束: %u帧 %u个矩形 丢弃%u个 %u字节", frames, rects, lost, out.getWritten());
+	}
+	xSemaphoreGive(lock);
+}
+
+uint32_t ScreenRecord::getFrames()
+{
+	return frames;
+}
+
+uint32_t ScreenRecord::getRects()
+{
+	return rects;
+}
+
+uint32_t ScreenRecord::getLost()
+{
+	return lost;
+}
+
+uint32_t ScreenRecord::getBytes()
+{
+	return out.getWritten();
+}
@@ -0,0 +1,404 @@
+/*
+ * HoloCubic 截图
+ *
+ * 功能说明：
+ * 1. 在刷新回调上挂旁路并使当前屏幕整屏失效，下一次刷新的条带在发送前逐行编码
+ * 2. 编码为16位BMP（位域RGB565，负高度表示自上而下，行按到达顺序直接写出）或QOI（流式编码，行之间保留游程）
+ * 3. 编码后的数据经字节流缓冲交给调用方任务写出，LVGL任务不访问SD卡与网络
+ *
+ * 数据流：
+ *   lv_refr --> Display刷新回调 --> tapCb（逐行编码） --> 字节流缓冲 --> capture（调用方任务） --> 文件/HTTP响应
+ */
+
+#include "screenshot.h"
+#include "sd_card.h"
+#include "logger.h"
+
+Screenshot screenshot;
+
+// BMP文件头（14）+ BITMAPINFOHEADER（40）+ 三个位域掩码（12）
+#define SHOT_BMP_HEADER 66
+#define SHOT_QOI_HEADER 14
+
+static void put_le16(uint8_t* p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t* p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static void put_be32(uint8_t* p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+Screenshot::Screenshot()
+{
+	display = NULL;
+	lock = NULL;
+	stream = NULL;
+	row = NULL;
+	state = SHOT_IDLE;
+	format = SHOT_BMP;
+	width = 0;
+	height = 0;
+	next_y = 0;
+	qoi_prev = 0;
+	qoi_run = 0;
+}
+
+/**
+ * 指定截图的显示（只保存指针，不分配缓冲）
+ */
+void Screenshot::begin(Display* disp)
+{
+	display = disp;
+	if (lock == NULL) lock = xSemaphoreCreateMutex();
+}
+
+bool Screenshot::available()
+{
+	return display != NULL && display->getDisp() != NULL && lock != NULL && state == SHOT_IDLE;
+}
+
+const char* Screenshot::extension(ShotFormat fmt)
+{
+	return fmt == SHOT_QOI ? "qoi" : "bmp";
+}
+
+/**
+ * 文件头（BMP为自上而下的RGB565位域格式，QOI为3通道sRGB）
+ */
+size_t Screenshot::header(uint8_t* out)
+{
+	if (format == SHOT_QOI)
+	{
+		memcpy(out, "qoif", 4);
+		put_be32(out + 4, width);
+		put_be32(out + 8, height);
+		out[12] = 3;
+		out[13] = 0;
+		return SHOT_QOI_HEADER;
+	}
+
+	uint32_t stride = ((uint32_t)width * 2 + 3) & ~3U;
+	uint32_t image = stride * height;
+	memset(out, 0, SHOT_BMP_HEADER);
+	out[0] = 'B';
+	out[1] = 'M';
+	put_le32(out + 2, SHOT_BMP_HEADER + image);
+	put_le32(out + 10, SHOT_BMP_HEADER);
+	put_le32(out + 14, 40);
+	put_le32(out + 18, width);
+	put_le32(out + 22, (uint32_t)-(int32_t)height);
+	put_le16(out + 26, 1);
+	put_le16(out + 28, 16);
+	put_le32(out + 30, 3);              // BI_BITFIELDS
+	put_le32(out + 34, image);
+	put_le32(out + 38, 2835);           // 72 DPI
+	put_le32(out + 42, 2835);
+	put_le32(out + 54, 0xF800);
+	put_le32(out + 58, 0x07E0);
+	put_le32(out + 62, 0x001F);
+	return SHOT_BMP_HEADER;
+}
+
+/**
+ * 编码一行（width个像素），返回写入out的字节数
+ * BMP：每像素2字节（小端RGB565），行补齐到4字节
+ * QOI：每像素最多5字节（结束上一段游程 + RGB），游程跨行延续
+ */
+size_t Screenshot::encodeRow(const lv_color_t* px, uint8_t* out)
+{
+	size_t n = 0;
+	if (format == SHOT_BMP)
+	{
+		for (lv_coord_t x = 0; x < width; x++)
+		{
+			uint16_t v = (LV_COLOR_GET_R(px[x]) << 11) | (LV_COLOR_GET_G(px[x]) << 5) | LV_COLOR_GET_B(px[x]);
+			put_le16(out + n, v);
+			n += 2;
+		}
+		while (n & 3) out[n++] = 0;
+		return n;
+	}
+
+	for (lv_coord_t x = 0; x < width; x++)
+	{
+		uint8_t r = LV_COLOR_GET_R(px[x]);
+		uint8_t g = LV_COLOR_GET_G(px[x]);
+		uint8_t b = LV_COLOR_GET_B(px[x]);
+		r = (r << 3) | (r >> 2);
+		g = (g << 2) | (g >> 4);
+		b = (b << 3) | (b >> 2);
+		uint32_t rgba = ((uint32_t)r << 24) | ((uint32_t)g << 16) | ((uint32_t)b << 8) | 0xFF;
+
+		if (rgba == qoi_prev)
+		{
+			if (++qoi_run == 62)
+			{
+				out[n++] = 0xC0 | (qoi_run - 1);
+				qoi_run = 0;
+			}
+			continue;
+		}
+		if (qoi_run)
+		{
+			out[n++] = 0xC0 | (qoi_run - 1);
+			qoi_run = 0;
+		}
+
+		uint8_t h = (r * 3 + g * 5 + b * 7 + 255 * 11) & 63;
+		if (qoi_index[h] == rgba)
+		{
+			out[n++] = h;
+		}
+		else
+		{
+			qoi_index[h] = rgba;
+			int8_t dr = (int8_t)(r - (uint8_t)(qoi_prev >> 24));
+			int8_t dg = (int8_t)(g - (uint8_t)(qoi_prev >> 16));
+			int8_t db = (int8_t)(b - (uint8_t)(qoi_prev >> 8));
+			int8_t dr_dg = (int8_t)(dr - dg);
+			int8_t db_dg = (int8_t)(db - dg);
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+			{
+				out[n++] = 0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+			}
+			else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+			{
+				out[n++] = 0x80 | (dg + 32);
+				out[n++] = ((dr_dg + 8) << 4) | (db_dg + 8);
+			}
+			else
+			{
+				out[n++] = 0xFE;
+				out[n++] = r;
+				out[n++] = g;
+				out[n++] = b;
+			}
+		}
+		qoi_prev = rgba;
+	}
+	return n;
+}
+
+/**
+ * 最后一行之后的数据：QOI结束未完成的游程并写入8字节结束标记
+ */
+size_t Screenshot::trailer(uint8_t* out)
+{
+	if (format != SHOT_QOI) return 0;
+	size_t n = 0;
+	if (qoi_run)
+	{
+		out[n++] = 0xC0 | (qoi_run - 1);
+		qoi_run = 0;
+	}
+	memset(out + n, 0, 7);
+	out[n + 7] = 1;
+	return n + 8;
+}
+
+/**
+ * 放入字节流缓冲（LVGL任务），写出端跟不上时最多等待SHOT_ROW_WAIT_MS
+ */
+bool Screenshot::send(const uint8_t* data, size_t len)
+{
+	return xStreamBufferSend(stream, data, len, pdMS_TO_TICKS(SHOT_ROW_WAIT_MS)) == len;
+}
+
+/**
+ * 刷新旁路（LVGL任务）：整屏失效后的刷新按条带自上而下到达，逐行编码
+ * 等待期间不是从第0行开始的整行区域跳过；开始之后区域不连续或不是整行时放弃
+ */
+void Screenshot::tapCb(const lv_area_t* area, const lv_color_t* color_p, void* user)
+{
+	Screenshot* self = (Screenshot*)user;
+	bool full = area->x1 == 0 && lv_area_get_width(area) == self->width;
+	if (self->state == SHOT_ARMED)
+	{
+		if (!full || area->y1 != 0) return;
+		self->state = SHOT_RUNNING;
+	}
+	if (self->state != SHOT_RUNNING || area->y2 < self->next_y) return;
+
+	if (!full || area->y1 > self->next_y)
+	{
+		self->display->setFlushTap(NULL);
+		self->state = SHOT_FAILED;
+		return;
+	}
+	for (lv_coord_t y = self->next_y; y <= area->y2 && y < self->height; y++)
+	{
+		size_t n = self->encodeRow(color_p + (uint32_t)(y - area->y1) * self->width, self->row);
+		if (y == self->height - 1) n += self->trailer(self->row + n);
+		if (!self->send(self->row, n))
+		{
+			self->display->setFlushTap(NULL);
+			self->state = SHOT_FAILED;
+			return;
+		}
+		self->next_y = y + 1;
+	}
+	if (self->next_y >= self->height)
+	{
+		self->display->setFlushTap(NULL);
+		self->state = SHOT_DONE;
+	}
+}
+
+/**
+ * 挂上旁路并整屏失效（LVGL任务），下一次刷新即为截图
+ */
+void Screenshot::startCb(const UiMsg* msg)
+{
+	Screenshot* self = (Screenshot*)msg->obj;
+	if (self->state != SHOT_ARMED) return;
+	// 旁路已被占用（录屏进行中）
+	if (self->display->getFlushTap() != NULL)
+	{
+		self->state = SHOT_FAILED;
+		return;
+	}
+	self->display->setFlushTap(tapCb, self);
+	lv_obj_invalidate(lv_disp_get_scr_act(self->display->getDisp()));
+}
+
+/**
+ * 超时或写出失败时取消（LVGL任务）
+ */
+void Screenshot::stopCb(const UiMsg* msg)
+{
+	Screenshot* self = (Screenshot*)msg->obj;
+	if (self->state != SHOT_ARMED && self->state != SHOT_RUNNING) return;
+	self->display->setFlushTap(NULL);
+	self->state = SHOT_FAILED;
+}
+
+bool Screenshot::capture(shot_write_t write, void* user, ShotFormat fmt)
+{
+	if (!available() || write == NULL) return false;
+	// LVGL任务中等待自己的刷新会死锁
+	if (xTaskGetCurrentTaskHandle() == runtime.getUiTask()) return false;
+	if (xSemaphoreTake(lock, 0) != pdTRUE) return false;
+
+	lv_disp_t* d = display->getDisp();
+	width = lv_disp_get_hor_res(d);
+	height = lv_disp_get_ver_res(d);
+	bool ok = width <= SHOT_WIDTH_MAX;
+	if (ok)
+	{
+		row = (uint8_t*)malloc((size_t)width * 5 + 16);
+		stream = xStreamBufferCreate(SHOT_STREAM_BYTES, 1);
+		ok = row != NULL && stream != NULL;
+	}
+	if (ok)
+	{
+		format = fmt;
+		next_y = 0;
+		memset(qoi_index, 0, sizeof(qoi_index));
+		qoi_prev = 0x000000FF;
+		qoi_run = 0;
+		ok = write(row, header(row), user);
+	}
+	if (ok)
+	{
+		state = SHOT_ARMED;
+		ok = runtime.post(startCb, this);
+		if (!ok) state = SHOT_IDLE;
+	}
+
+	// 写出直到旁路结束；写出失败或超时后取消，仍继续取出数据，刷新回调不会一直等待
+	bool settled = true;
+	if (ok)
+	{
+		uint8_t chunk[SHOT_CHUNK];
+		uint32_t start = millis();
+		bool stopping = false;
+		for (;;)
+		{
+			size_t n = xStreamBufferReceive(stream, chunk, sizeof(chunk), pdMS_TO_TICKS(20));
+			if (n)
+			{
+				if (ok && !write(chunk, n, user))
+				{
+					ok = false;
+					if (!stopping) stopping = runtime.post(stopCb, this);
+				}
+				continue;
+			}
+			if (state == SHOT_DONE || state == SHOT_FAILED)
+			{
+				while ((n = xStreamBufferReceive(stream, chunk, sizeof(chunk), 0)) > 0)
+				{
+					if (ok && !write(chunk, n, user)) ok = false;
+				}
+				break;
+			}
+			if (millis() - start < SHOT_TIMEOUT_MS) continue;
+			if (stopping)
+			{
+				// LVGL任务没有响应：旁路可能仍在使用缓冲，不释放，也不允许再次截图
+				settled = false;
+				break;
+			}
+			LOG_W("shot", "截图超时（没有整屏刷新）");
+			stopping = runtime.post(stopCb, this);
+			start = millis();
+		}
+		ok = ok && state == SHOT_DONE;
+	}
+	if (!settled) return false;
+
+	if (stream) vStreamBufferDelete(stream);
+	free(row);
+	stream = NULL;
+	row = NULL;
+	state = SHOT_IDLE;
+	xSemaphoreGive(lock);
+	return ok;
+}
+
+bool Screenshot::captureToFile(const char* path, ShotFormat fmt, char* out_path, size_t out_len)
+{
+	if (!available()) return false;
+	char name[sizeof(SHOT_DIR) + 16];
+	if (path == NULL)
+	{
+		SD_FS.mkdir(SHOT_DIR);
+		uint16_t i;
+		for (i = 1; i < 10000; i++)
+		{
+			snprintf(name, sizeof(name), SHOT_DIR "/shot_%04u.%s", i, extension(fmt));
+			if (!SD_FS.exists(name)) break;
+		}
+		if (i == 10000) return false;
+		path = name;
+	}
+
+	File f = SD_FS.open(path, FILE_WRITE);
+	if (!f) return false;
+	bool ok = capture([](const void* data, size_t len, void* user) {
+		return ((File*)user)->write((const uint8_t*)data, len) == len;
+	}, &f, fmt);
+	f.close();
+	if (!ok)
+	{
+		SD_FS.remove(path);
+		return false;
+	}
+	LOG_I("shot", "截图已保存: %s", path);
+	if (out_path) strlcpy(out_path, path, out_len);
+	return true;
+}
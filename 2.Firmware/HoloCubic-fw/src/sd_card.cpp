@@ -10,6 +10,7 @@
  * 
  * 硬件接口：
  * - SPI接口：使用HSPI总线（高速SPI）
+ * - 可选SDMMC主机（SD_USE_MMC=1，1线/4线模式），需对应改线
  * - 支持容量：最大32GB（FAT32格式）
  * - 传输速度：最高25MHz SPI时钟
  * - 兼容性：支持SD/SDHC卡
@@ -30,8 +31,16 @@
 
 #include "sd_card.h"
 #include "FS.h"         // ESP32文件系统抽象层
-#include "SD.h"         // SD卡驱动库
 #include "SPI.h"        // SPI通信库
+#include "ff.h"         // 连续分配与簇链检查直接调用FatFs
+#include "diskio.h"     // 连续文件按扇区直接读取
+#include "logger.h"
+
+// init时确定的总线时钟（重新挂载沿用）与挂载次数
+static uint32_t mount_freq = SD_SPI_FREQ;
+static volatile uint16_t mount_gen = 0;
+static volatile bool mounted_ok = false;
+static SemaphoreHandle_t remount_lock = xSemaphoreCreateMutex();
 
 
 /**
@@ -46,6 +55,7 @@
  * 硬件配置：
  * - 使用HSPI总线（高速SPI）
  * - CS引脚：GPIO 15
+ * - 时钟：默认40MHz，挂载失败时以4MHz重试（部分卡或长走线不支持高速）
  * - 支持的卡类型：MMC、SDSC、SDHC
  * 
  * 支持的卡类型：
@@ -53,13 +63,20 @@
  * - SDSC：标准容量SD卡（≤2GB）
  * - SDHC：高容量SD卡（2GB-32GB）
  */
-void SdCard::init()
+void SdCard::init(uint32_t freq)
 {
-	// 创建HSPI实例用于SD卡通信
-	SPIClass* sd_spi = new SPIClass(HSPI); // another SPI
-	
-	// 尝试初始化SD卡，CS引脚为GPIO 15
-	if (!SD.begin(15, *sd_spi)) // SD-Card SS pin is 15
+	mount_freq = freq;
+	bool mounted = mount(freq);
+	if (!mounted && freq > SD_SPI_FREQ_SAFE)
+	{
+		Serial.printf("SD卡%uHz挂载失败，降至%uHz重试\n", freq, SD_SPI_FREQ_SAFE);
+		SD_FS.end();
+		freq = SD_SPI_FREQ_SAFE;
+		mount_freq = freq;
+		mounted = mount(freq);
+	}
+	mounted_ok = mounted;
+	if (!mounted)
 	{
 		Serial.println("SD卡挂载失败！请检查：");
 		Serial.println("1. SD卡是否正确插入");
@@ -69,7 +86,7 @@ void SdCard::init()
 	}
 	
 	// 获取SD卡类型信息
-	uint8_t cardType = SD.cardType();
+	uint8_t cardType = SD_FS.cardType();
 
 	// 检查是否检测到SD卡
 	if (cardType == CARD_NONE)
@@ -98,12 +115,91 @@ void SdCard::init()
 	}
 
 	// 计算并显示SD卡容量（转换为MB）
-	uint64_t cardSize = SD.cardSize() / (1024 * 1024);
+	uint64_t cardSize = SD_FS.cardSize() / (1024 * 1024);
 	Serial.printf("SD卡容量: %lluMB\n", cardSize);
+	Serial.printf("SD卡时钟: %uHz, 后端: %s\n", freq,
+				  SD_USE_MMC ? (SD_MMC_1BIT ? "SDMMC 1线" : "SDMMC 4线") : "SPI");
 	
 	Serial.println("SD卡初始化完成！");
 }
 
+/**
+ * 按编译时选择的后端挂载SD卡
+ *
+ * @param freq 总线时钟（Hz）
+ */
+bool SdCard::mount(uint32_t freq)
+{
+#if SD_USE_MMC
+	// SDMMC时钟以kHz为单位
+	return SD_MMC.begin("/sdcard", SD_MMC_1BIT, false, freq / 1000);
+#else
+	// 创建HSPI实例用于SD卡通信，CS引脚为GPIO 15
+	static SPIClass* sd_spi = new SPIClass(HSPI); // another SPI
+	return SD.begin(SD_CS_PIN, *sd_spi, freq);
+#endif
+}
+
+/**
+ * 重新挂载SD卡
+ *
+ * 卡在读写中途掉电、接触不良或SPI时序出错后，FatFs与卡的状态可能不再一致，
+ * 之后的读写持续失败；卸载并重新初始化卡即可恢复，不需要重启。
+ * 多个任务同时发现故障时只重新挂载一次：调用方传入的句柄在此期间已失效，
+ * 以generation()判断别的任务是否已经完成了重新挂载
+ */
+bool SdCard::remount()
+{
+	xSemaphoreTake(remount_lock, portMAX_DELAY);
+	SD_FS.end();
+	bool ok = mount(mount_freq);
+	if (!ok && mount_freq > SD_SPI_FREQ_SAFE)
+	{
+		SD_FS.end();
+		mount_freq = SD_SPI_FREQ_SAFE;
+		ok = mount(mount_freq);
+	}
+	mounted_ok = ok;
+	mount_gen++;
+	xSemaphoreGive(remount_lock);
+
+	if (ok) LOG_W("sd", "SD卡已重新挂载（%uHz）", mount_freq);
+	else LOG_E("sd", "SD卡重新挂载失败");
+	return ok;
+}
+
+uint16_t SdCard::generation()
+{
+	return mount_gen;
+}
+
+bool SdCard::isMounted()
+{
+	return mounted_ok;
+}
+
+/**
+ * 直接读取卷的第一个扇区（与readSectors相同，以卷锁与FatFs的访问串行）
+ * 卡被拔出或状态出错时读取命令失败；FatFs的扇区窗口与目录缓存不会掩盖这种情况
+ */
+bool SdCard::probe()
+{
+	if (!mounted_ok) return false;
+	static uint8_t sector[FF_MAX_SS] __attribute__((aligned(4)));
+	DIR dir;
+	if (f_opendir(&dir, "/") != FR_OK) return false;
+	FATFS* fs = dir.obj.fs;
+	f_closedir(&dir);
+#if FF_FS_REENTRANT && FF_DEFINED < 80286
+	if (!ff_req_grant(fs->sobj)) return false;
+#endif
+	DRESULT res = disk_read(fs->pdrv, sector, fs->volbase, 1);
+#if FF_FS_REENTRANT && FF_DEFINED < 80286
+	ff_rel_grant(fs->sobj);
+#endif
+	return res == RES_OK;
+}
+
 
 
 /**
@@ -123,7 +219,7 @@ void SdCard::listDir(const char* dirname, uint8_t levels)
 	Serial.printf("正在列出目录: %s\n", dirname);
 
 	// 打开指定目录
-	File root = SD.open(dirname);
+	File root = SD_FS.open(dirname);
 	if (!root)
 	{
 		Serial.println("无法打开目录");
@@ -189,7 +285,7 @@ void SdCard::createDir(const char* path)
 	Serial.printf("正在创建目录: %s\n", path);
 	
 	// 尝试创建目录
-	if (SD.mkdir(path))
+	if (SD_FS.mkdir(path))
 	{
 		Serial.println("目录创建成功");
 	}
@@ -223,7 +319,7 @@ void SdCard::removeDir(const char* path)
 	Serial.printf("正在删除目录: %s\n", path);
 	
 	// 尝试删除目录
-	if (SD.rmdir(path))
+	if (SD_FS.rmdir(path))
 	{
 		Serial.println("目录删除成功");
 	}
@@ -257,7 +353,7 @@ void SdCard::readFile(const char* path)
 	Serial.printf("正在读取文件: %s\n", path);
 
 	// 以只读模式打开文件
-	File file = SD.open(path);
+	File file = SD_FS.open(path);
 	if (!file)
 	{
 		Serial.println("无法打开文件进行读取");
@@ -280,14 +376,16 @@ void SdCard::readFile(const char* path)
  * 读取文件指定行的内容
  * 
  * @param path 文件路径
- * @param num 行号（从1开始，默认为1）
- * @return 指定行的内容字符串，失败返回错误信息
+ * @param num 行号（从1开始）
+ * @param out 调用方提供的缓冲区，保存去除首尾空白后的行内容
+ * @param len 缓冲区大小（含结束符），超长的行截断
+ * @return 文件不存在或行号超出范围返回false（out为空字符串）
  * 
  * 功能说明：
  * 1. 打开文本文件并逐行解析
  * 2. 定位到指定行号
- * 3. 返回该行的完整内容
- * 4. 自动去除行首行尾空白字符
+ * 3. 把该行内容复制到out（最后一行可以没有换行符）
+ * 4. 自动去除行首行尾空白字符（含\r）
  * 
  * 应用场景：
  * - 读取配置文件的特定配置项
@@ -296,46 +394,57 @@ void SdCard::readFile(const char* path)
  * 
  * 注意事项：
  * - 行号从1开始计数
- * - 使用内部缓冲区存储行内容
- * - 文件不存在或行号超出范围返回错误信息
+ * - 不分配堆内存（原来返回String，长时间运行会产生堆碎片）
  */
-String SdCard::readFileLine(const char* path, int num = 1)
+bool SdCard::readFileLine(const char* path, int num, char* out, size_t len)
 {
-	Serial.printf("正在读取文件: %s 第%d行\n", path, num);
+	if (len == 0) return false;
+	out[0] = '\0';
+	if (num < 1) return false;
 
 	// 以只读模式打开文件
-	File file = SD.open(path);
+	File file = SD_FS.open(path);
 	if (!file)
 	{
-		return ("Failed to open file for reading");
+		Serial.printf("无法打开文件: %s\n", path);
+		return false;
 	}
 
-	// 使用内部缓冲区存储行内容
-	char* p = buf;
+	size_t n = 0;
+	bool found = false;
 	while (file.available())
 	{
-		char c = file.read();
+		int c = file.read();
+		if (c < 0) break;
 		if (c == '\n')  // 遇到换行符
 		{
-			num--;
-			if (num == 0)  // 找到目标行
+			if (--num == 0)  // 目标行结束
 			{
-				*(p++) = '\0';  // 添加字符串结束符
-				String s(buf);
-				s.trim();  // 去除首尾空白字符
-				file.close();
-				Serial.printf("成功读取第%d行内容\n", (num + 1));
-				return s;
+				found = true;
+				break;
 			}
 		}
-		else if (num == 1)  // 当前为目标行，存储字符
+		else if (num == 1 && n + 1 < len)  // 当前为目标行，存储字符（超出部分丢弃）
 		{
-			*(p++) = c;
+			out[n++] = (char)c;
 		}
 	}
 	file.close();
+	// 文件末尾没有换行符的最后一行
+	if (!found && num == 1 && n > 0) found = true;
+	if (!found)
+	{
+		out[0] = '\0';
+		return false;
+	}
 
-	return  String("error parameter!");
+	// 去除首尾空白字符
+	while (n > 0 && isspace((unsigned char)out[n - 1])) n--;
+	out[n] = '\0';
+	size_t start = 0;
+	while (start < n && isspace((unsigned char)out[start])) start++;
+	if (start > 0) memmove(out, out + start, n - start + 1);
+	return true;
 }
 
 /**
@@ -366,7 +475,7 @@ void SdCard::writeFile(const char* path, const char* message)
 	Serial.printf("正在写入文件: %s\n", path);
 
 	// 以写入模式打开文件（覆盖原有内容）
-	File file = SD.open(path, FILE_WRITE);
+	File file = SD_FS.open(path, FILE_WRITE);
 	if (!file)
 	{
 		Serial.println("无法打开文件进行写入");
@@ -407,7 +516,7 @@ void SdCard::writeFile(const char* path, const char* message)
  * 
  * 注意事项：
  * - 不会覆盖原有内容
- * - 适合连续数据记录
+ * - 每次调用都要打开文件、更新目录项并关闭，高频记录（传感器、轨迹）应使用SdWriter（sd_writer.h）
  * - 文件大小会逐渐增长
  */
 void SdCard::appendFile(const char* path, const char* message)
@@ -415,7 +524,7 @@ void SdCard::appendFile(const char* path, const char* message)
 	Serial.printf("正在追加内容到文件: %s\n", path);
 
 	// 以追加模式打开文件
-	File file = SD.open(path, FILE_APPEND);
+	File file = SD_FS.open(path, FILE_APPEND);
 	if (!file)
 	{
 		Serial.println("无法打开文件进行追加");
@@ -464,7 +573,7 @@ void SdCard::renameFile(const char* path1, const char* path2)
 	Serial.printf("正在重命名文件: %s -> %s\n", path1, path2);
 	
 	// 尝试重命名文件
-	if (SD.rename(path1, path2))
+	if (SD_FS.rename(path1, path2))
 	{
 		Serial.println("文件重命名成功");
 	}
@@ -506,7 +615,7 @@ void SdCard::deleteFile(const char* path)
 	Serial.printf("正在删除文件: %s\n", path);
 	
 	// 尝试删除文件
-	if (SD.remove(path))
+	if (SD_FS.remove(path))
 	{
 		Serial.println("文件删除成功");
 	}
@@ -529,7 +638,7 @@ void SdCard::deleteFile(const char* path)
  * 功能说明：
  * 1. 打开指定的二进制文件
  * 2. 将整个文件数据读取到指定缓冲区
- * 3. 支持大文件分块读取（每次512字节）
+ * 3. 支持大文件分块读取（每次SD_IO_CHUNK字节）
  * 4. 自动处理文件关闭和错误检查
  * 
  * 应用场景：
@@ -541,7 +650,7 @@ void SdCard::deleteFile(const char* path)
  * 
  * 注意事项：
  * - 确保缓冲区大小足够容纳整个文件
- * - 使用512字节分块读取提高效率
+ * - 使用4KB分块读取，驱动可合并为多扇区传输
  * - 自动获取文件大小进行完整读取
  * - 适合中等大小的二进制文件
  */
@@ -549,7 +658,7 @@ void SdCard::readBinFromSd(const char* path, uint8_t* buf)
 {
 	Serial.printf("正在读取二进制文件: %s\n", path);
 	
-	File file = SD.open(path);
+	File file = SD_FS.open(path);
 	size_t len = 0;
 	if (file)
 	{
@@ -557,14 +666,14 @@ void SdCard::readBinFromSd(const char* path, uint8_t* buf)
 		size_t flen = len;
 		Serial.printf("文件大小: %d 字节\n", flen);
 
-		// 分块读取文件数据，每次读取512字节
+		// 分块读取文件数据，每次读取SD_IO_CHUNK字节（多扇区连续传输）
 		uint8_t* bufPtr = buf;
 		while (len)
 		{
 			size_t toRead = len;
-			if (toRead > 512)
+			if (toRead > SD_IO_CHUNK)
 			{
-				toRead = 512;
+				toRead = SD_IO_CHUNK;
 			}
 			file.read(bufPtr, toRead);
 			bufPtr += toRead;
@@ -609,7 +718,7 @@ void SdCard::writeBinToSd(const char* path, uint8_t* buf)
 {
 	Serial.printf("正在写入二进制文件: %s\n", path);
 	
-	File file = SD.open(path, FILE_WRITE);
+	File file = SD_FS.open(path, FILE_WRITE);
 	if (!file)
 	{
 		Serial.println("无法打开文件进行二进制写入");
@@ -627,95 +736,113 @@ void SdCard::writeBinToSd(const char* path, uint8_t* buf)
 	file.close();
 }
 
-
 /**
- * 文件IO性能测试函数
- * 
- * @param path 测试文件路径
- * 
+ * 为文件预留一段连续的空闲簇
+ *
+ * @param path 文件路径（已存在时被清空）
+ * @param size 预计的文件大小
+ *
  * 功能说明：
- * 1. 测试SD卡文件读取性能
- * 2. 测试SD卡文件写入性能
- * 3. 统计读写操作耗时
- * 4. 输出性能测试结果
- * 
- * 测试流程：
- * 1. 读取测试：打开现有文件，分块读取全部内容
- * 2. 写入测试：创建新文件，写入1MB测试数据
- * 3. 性能统计：记录读写操作的时间消耗
- * 4. 结果输出：显示传输速度和耗时信息
- * 
- * 应用场景：
- * - SD卡性能基准测试
- * - 文件系统性能评估
- * - 硬件兼容性测试
- * - 系统优化参考
- * 
+ * 1. 以f_expand的“只准备”方式查找不小于size的连续空闲簇，把分配起点设到这段空间之前
+ * 2. 文件本身保持为空，之后用SD_FS.open(path, FILE_WRITE)顺序写入（含分段续传）时依次取用这段簇
+ *
  * 注意事项：
- * - 使用512字节缓冲区进行测试
- * - 测试会覆盖指定路径的文件
- * - 适合用于开发调试阶段
- * - 测试结果受SD卡类型和质量影响
+ * - 预留不改变文件大小，上传服务按文件大小判断续传位置的方式不受影响
+ * - 写入期间其他文件（如日志）分配簇时会占用其中一簇，文件随之多出一个片段，
+ *   完成后以countFragments()确认
+ * - FF_USE_EXPAND为0时返回false，文件按普通方式分配
  */
-void SdCard::fileIO(const char* path)
+bool SdCard::preallocate(const char* path, uint32_t size)
 {
-	Serial.printf("开始SD卡IO性能测试，文件: %s\n", path);
-	
-	File file = SD.open(path);
-	static uint8_t buf[512];
-	size_t len = 0;
-	uint32_t start = millis();
-	uint32_t end = start;
-	
-	// 读取性能测试
-	if (file)
-	{
-		len = file.size();
-		size_t flen = len;
-		Serial.printf("开始读取测试，文件大小: %u 字节\n", flen);
-		
-		start = millis();
-		while (len)
-		{
-			size_t toRead = len;
-			if (toRead > 512)
-			{
-				toRead = 512;
-			}
-			file.read(buf, toRead);
-			len -= toRead;
-		}
-		end = millis() - start;
-		Serial.printf("读取完成: %u 字节，耗时: %u 毫秒，速度: %.2f KB/s\n", 
-					  flen, end, (float)flen / end);
-		file.close();
-	}
-	else
-	{
-		Serial.println("无法打开文件进行读取测试");
-	}
+#if FF_USE_EXPAND
+	FIL fil;
+	if (f_open(&fil, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) return false;
+	FRESULT res = f_expand(&fil, size, 0);
+	f_close(&fil);
+	return res == FR_OK;
+#else
+	return false;
+#endif
+}
 
-	// 写入性能测试
-	Serial.println("开始写入测试...");
-	file = SD.open(path, FILE_WRITE);
-	if (!file)
-	{
-		Serial.println("无法打开文件进行写入测试");
-		return;
-	}
+/**
+ * 沿FAT链统计片段数，表中只放得下一个片段
+ * @return 片段数，无法判断时为-1；连续文件的第一个簇在tbl[2]
+ */
+static int32_t link_map(FIL* fil, DWORD* tbl)
+{
+#if FF_USE_FASTSEEK
+	tbl[0] = 4;
+	fil->cltbl = tbl;
+	FRESULT res = f_lseek(fil, CREATE_LINKMAP);
+	fil->cltbl = NULL;
+	// 表不够时tbl[0]仍为所需长度：2 + 每个片段2项
+	if (res != FR_OK && res != FR_NOT_ENOUGH_CORE) return -1;
+	return (tbl[0] - 2) / 2;
+#else
+	return -1;
+#endif
+}
 
-	size_t i;
-	start = millis();
-	for (i = 0; i < 2048; i++)
-	{
-		file.write(buf, 512);
-	}
-	end = millis() - start;
-	uint32_t totalBytes = 2048 * 512;
-	Serial.printf("写入完成: %u 字节，耗时: %u 毫秒，速度: %.2f KB/s\n", 
-				  totalBytes, end, (float)totalBytes / end);
-	file.close();
-	
-	Serial.println("SD卡IO性能测试完成");
+int32_t SdCard::countFragments(const char* path)
+{
+	FIL fil;
+	if (f_open(&fil, path, FA_READ) != FR_OK) return -1;
+	DWORD tbl[4];
+	int32_t n = link_map(&fil, tbl);
+	f_close(&fil);
+	return n;
 }
 
+/**
+ * 取连续文件的扇区位置
+ *
+ * 簇号换算为扇区：数据区起始扇区 + (簇号 - 2) * 每簇扇区数。
+ * 卡被重新挂载或文件被改写后位置失效，应重新调用
+ */
+bool SdCard::mapContiguous(const char* path, SdExtent* ext)
+{
+	FIL fil;
+	if (f_open(&fil, path, FA_READ) != FR_OK) return false;
+	DWORD tbl[4];
+	bool ok = link_map(&fil, tbl) == 1;
+	if (ok)
+	{
+		FATFS* fs = fil.obj.fs;
+		ext->fs = fs;
+		ext->pdrv = fs->pdrv;
+		ext->size = f_size(&fil);
+		ext->sector = fs->database + (DWORD)fs->csize * (tbl[2] - 2);
+#if FF_MAX_SS == FF_MIN_SS
+		ext->sector_size = FF_MAX_SS;
+#else
+		ext->sector_size = fs->ssize;
+#endif
+	}
+	f_close(&fil);
+	return ok;
+}
+
+/**
+ * 按扇区直接读取连续文件，不经过FatFs的簇查找与扇区窗口
+ *
+ * 注意事项：
+ * - 只用于读取：文件在此期间不能被改写
+ * - 与FatFs的访问以卷锁串行（FF_FS_REENTRANT），SD驱动本身也以单次命令完成整段多扇区传输
+ */
+bool SdCard::readSectors(const SdExtent* ext, uint32_t offset, uint8_t* buf, uint32_t len)
+{
+	if (ext->fs == NULL || offset % ext->sector_size != 0 || offset + len > ext->size) return false;
+	if (len == 0) return true;
+
+	uint32_t count = (len + ext->sector_size - 1) / ext->sector_size;
+#if FF_FS_REENTRANT && FF_DEFINED < 80286
+	FATFS* fs = (FATFS*)ext->fs;
+	if (!ff_req_grant(fs->sobj)) return false;
+#endif
+	DRESULT res = disk_read(ext->pdrv, buf, ext->sector + offset / ext->sector_size, count);
+#if FF_FS_REENTRANT && FF_DEFINED < 80286
+	ff_rel_grant(fs->sobj);
+#endif
+	return res == RES_OK;
+}
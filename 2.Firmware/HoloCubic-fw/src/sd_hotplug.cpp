@@ -0,0 +1,202 @@
+/*
+ * HoloCubic SD卡热插拔
+ *
+ * 功能说明：
+ * 1. 后台任务检查卡是否仍可用：有CD引脚时读取电平，没有时每SD_HOTPLUG_PROBE_MS读取一次引导扇区
+ * 2. 发现掉卡后关闭读写门、等待进行中的读写结束，然后在后台反复尝试重新挂载（退避重试）
+ * 3. 挂载成功后使LVGL的文件句柄缓存失效、打开读写门，并增量重建场景索引（可能换了一张卡）
+ *
+ * 恢复过程：
+ *   检查失败（再确认一次） --> 关闭读写门 --> 等待读写结束 --> [LVGL锁] tf.remount() + 句柄缓存失效 [解锁]
+ *   --> 成功：打开读写门，读取方按挂载次数重新打开文件 / 失败：读写门保持关闭，按退避间隔重试
+ *
+ * 注意事项：
+ * - 任务监视器发现SD读取连续失败时（场景预读）也交给本模块处理，不在预读任务中直接重新挂载
+ * - 卡不在时挂载尝试本身需要几十毫秒，期间持有LVGL锁，界面停顿一下
+ */
+
+#include "sd_hotplug.h"
+#include "sd_card.h"
+#include "runtime.h"
+#include "lv_port_fatfs.h"
+#include "scene_index.h"
+#include "logger.h"
+
+SdHotplug sdhotplug;
+
+SdHotplug::SdHotplug()
+{
+	task = NULL;
+	drained = NULL;
+	mux = portMUX_INITIALIZER_UNLOCKED;
+	state = SD_STATE_MOUNTED;
+	closed = false;
+	io_count = 0;
+	lost_count = 0;
+	retry_ms = SD_HOTPLUG_RETRY_MS;
+}
+
+bool SdHotplug::begin()
+{
+	if (task) return true;
+	drained = xSemaphoreCreateBinary();
+	if (drained == NULL) return false;
+#if SD_DETECT_PIN >= 0
+	pinMode(SD_DETECT_PIN, INPUT_PULLUP);
+#endif
+	// 启动时没有挂载成功：读写门保持关闭，插卡后挂载
+	if (!tf.isMounted())
+	{
+		state = SD_STATE_LOST;
+		closed = true;
+	}
+	if (xTaskCreatePinnedToCore(taskEntry, "sd_hotplug", SD_HOTPLUG_TASK_STACK, this,
+								SD_HOTPLUG_TASK_PRIORITY, &task, SD_HOTPLUG_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool SdHotplug::beginIo()
+{
+	portENTER_CRITICAL(&mux);
+	bool ok = !closed;
+	if (ok) io_count++;
+	portEXIT_CRITICAL(&mux);
+	return ok;
+}
+
+void SdHotplug::endIo()
+{
+	portENTER_CRITICAL(&mux);
+	if (io_count) io_count--;
+	bool last = closed && io_count == 0;
+	portEXIT_CRITICAL(&mux);
+	if (last) xSemaphoreGive(drained);
+}
+
+void SdHotplug::reportError()
+{
+	if (task && state == SD_STATE_MOUNTED) xTaskNotifyGive(task);
+}
+
+bool SdHotplug::isRunning()
+{
+	return task != NULL;
+}
+
+SdHotplugState SdHotplug::getState()
+{
+	return state;
+}
+
+bool SdHotplug::isAvailable()
+{
+	return state == SD_STATE_MOUNTED;
+}
+
+uint16_t SdHotplug::getLostCount()
+{
+	return lost_count;
+}
+
+/**
+ * CD引脚显示卡在位（没有CD引脚时总是true）
+ */
+static bool inserted()
+{
+#if SD_DETECT_PIN >= 0
+	if (digitalRead(SD_DETECT_PIN) == SD_DETECT_LEVEL) return true;
+	// 卡座触点抖动：隔一个短时间再读一次
+	vTaskDelay(pdMS_TO_TICKS(20));
+	return digitalRead(SD_DETECT_PIN) == SD_DETECT_LEVEL;
+#else
+	return true;
+#endif
+}
+
+/**
+ * 卡在位且引导扇区可读
+ */
+bool SdHotplug::present()
+{
+	return inserted() && tf.probe();
+}
+
+/**
+ * 关闭读写门并等待进行中的读写结束
+ */
+void SdHotplug::quiesce()
+{
+	xSemaphoreTake(drained, 0);
+	portENTER_CRITICAL(&mux);
+	closed = true;
+	uint16_t n = io_count;
+	portEXIT_CRITICAL(&mux);
+	if (n && xSemaphoreTake(drained, pdMS_TO_TICKS(SD_HOTPLUG_QUIESCE_MS)) != pdTRUE)
+		LOG_W("sd", "仍有%u段读写未结束，照常卸载", io_count);
+}
+
+/**
+ * 重新挂载（持有LVGL锁，S:盘的读取不会与之并发）
+ */
+bool SdHotplug::recover()
+{
+	runtime.lock();
+	bool ok = tf.remount();
+	lv_fs_if_invalidate();
+	runtime.unlock();
+	return ok;
+}
+
+void SdHotplug::taskEntry(void* arg)
+{
+	SdHotplug* self = (SdHotplug*)arg;
+	uint32_t wait = SD_DETECT_PIN >= 0 ? SD_HOTPLUG_POLL_MS : SD_HOTPLUG_PROBE_MS;
+
+	for (;;)
+	{
+		bool kicked = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait)) > 0;
+
+		if (self->state == SD_STATE_MOUNTED)
+		{
+			wait = SD_DETECT_PIN >= 0 ? SD_HOTPLUG_POLL_MS : SD_HOTPLUG_PROBE_MS;
+			// 有CD引脚时平时只看电平，读写方报告失败时再读扇区确认
+			bool ok = SD_DETECT_PIN >= 0 && !kicked ? inserted() : self->present();
+			// 再确认一次，避免一次偶发的读取失败就卸载
+			if (ok || self->present()) continue;
+
+			self->lost_count++;
+			self->state = SD_STATE_LOST;
+			LOG_W("sd", "SD卡不可用（第%u次），暂停读写", self->lost_count);
+			self->quiesce();
+			self->retry_ms = SD_HOTPLUG_RETRY_MS;
+			wait = 0;
+			continue;
+		}
+
+		// 已掉卡：卡不在位时只等待，在位时尝试重新挂载
+		if (!inserted())
+		{
+			wait = SD_HOTPLUG_POLL_MS;
+			continue;
+		}
+		if (!self->recover())
+		{
+			wait = self->retry_ms;
+			self->retry_ms = self->retry_ms * 2 < SD_HOTPLUG_RETRY_MAX_MS ? self->retry_ms * 2 : SD_HOTPLUG_RETRY_MAX_MS;
+			continue;
+		}
+
+		self->state = SD_STATE_MOUNTED;
+		portENTER_CRITICAL(&self->mux);
+		self->closed = false;
+		portEXIT_CRITICAL(&self->mux);
+		LOG_I("sd", "SD卡已恢复，继续读写");
+		// 可能换了一张卡：增量重建场景索引，已打开的索引按挂载次数重新打开
+		SceneIndex::build();
+		wait = SD_DETECT_PIN >= 0 ? SD_HOTPLUG_POLL_MS : SD_HOTPLUG_PROBE_MS;
+	}
+}
@@ -0,0 +1,314 @@
+/*
+ * HoloCubic SD卡后台写入流
+ *
+ * 功能说明：
+ * 1. 追加写入的数据先复制进SD_WRITER_BUFS块按簇大小分配的缓冲，调用方只做一次memcpy
+ * 2. 写入任务把写满的块按文件偏移对齐整块写入，每SD_WRITER_SYNC_MS写入未满的块并f_sync
+ * 3. 文件只在begin()/end()时打开与关闭，SdCard::appendFile每次调用的打开、更新目录项、关闭都省去
+ *
+ * 文件布局：
+ *   |<- 块0 ->|<- 块1 ->|...|<- cur块（未满）->|
+ *   每块从SD_WRITER_BUF_SIZE的整数倍偏移开始；未满的块在同步时写到原位置，写满后整块覆盖一次
+ *
+ * 注意事项：
+ * - 写入任务来不及时（SD卡写入停顿超过全部缓冲的时长）丢弃整次write并计数，不会写入半条记录
+ * - 直接使用FatFs（与LVGL的S:盘相同的路径），不经过SD_FS的stdio缓冲
+ * - 停止前断电时，最近一次同步之后的数据丢失，之前的内容完整
+ * - SD卡重新挂载期间（见sd_hotplug.h）不写入，缓冲写满后按来不及处理丢弃；重新挂载后文件句柄失效，之后的写入失败
+ */
+
+#include "sd_writer.h"
+#include "sd_hotplug.h"
+#include "logger.h"
+#include "telemetry.h"
+#include <esp_heap_caps.h>
+
+// 缓冲块切换可能来自多个任务，由自旋锁保护（临界区内只有memcpy与计数）
+static portMUX_TYPE writer_mux = portMUX_INITIALIZER_UNLOCKED;
+
+SdWriter::SdWriter()
+{
+	fil = NULL;
+	for (uint8_t i = 0; i < SD_WRITER_BUFS; i++) buf[i] = NULL;
+	open = false;
+	stopping = false;
+	sync_req = false;
+	writer = NULL;
+	done = NULL;
+	written = 0;
+	dropped = 0;
+}
+
+SdWriter::~SdWriter()
+{
+	end();
+}
+
+void SdWriter::release()
+{
+	for (uint8_t i = 0; i < SD_WRITER_BUFS; i++)
+	{
+		if (buf[i]) heap_caps_free(buf[i]);
+		buf[i] = NULL;
+	}
+	if (fil) heap_caps_free(fil);
+	fil = NULL;
+}
+
+/**
+ * 打开文件并启动写入任务
+ *
+ * @param path   文件路径
+ * @param append true时接在已有内容之后（先读回最后一个不完整的块），false时清空
+ * @return 已打开、内存不足或无法打开文件时返回false
+ */
+bool SdWriter::begin(const char* path, bool append)
+{
+	if (open || writer) return false;
+
+	fil = (FIL*)heap_caps_malloc(sizeof(FIL), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	bool ok = fil != NULL;
+	// 缓冲块可DMA，SD驱动直接传输，不再经过中转缓冲
+	for (uint8_t i = 0; i < SD_WRITER_BUFS && ok; i++)
+	{
+		buf[i] = (uint8_t*)heap_caps_malloc(SD_WRITER_BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+		ok = buf[i] != NULL;
+	}
+	if (!ok)
+	{
+		LOG_E("sd", "写入缓冲分配失败: %u x %u字节", SD_WRITER_BUFS, SD_WRITER_BUF_SIZE);
+		release();
+		return false;
+	}
+
+	if (f_open(fil, path, FA_READ | FA_WRITE | (append ? FA_OPEN_ALWAYS : FA_CREATE_ALWAYS)) != FR_OK)
+	{
+		LOG_W("sd", "无法打开写入文件: %s", path);
+		release();
+		return false;
+	}
+
+	uint32_t size = f_size(fil);
+	cur = 0;
+	pending = 0;
+	cur_base = size / SD_WRITER_BUF_SIZE * SD_WRITER_BUF_SIZE;
+	fill = size - cur_base;
+	synced_end = size;
+	UINT br = 0;
+	if (fill && (f_lseek(fil, cur_base) != FR_OK || f_read(fil, buf[0], fill, &br) != FR_OK || br != fill))
+	{
+		LOG_W("sd", "无法读回文件末尾: %s", path);
+		f_close(fil);
+		release();
+		return false;
+	}
+
+	if (done == NULL) done = xSemaphoreCreateBinary();
+	written = 0;
+	dropped = 0;
+	stopping = false;
+	sync_req = false;
+
+	if (done == NULL || xTaskCreatePinnedToCore(writerEntry, "sd_writer", SD_WRITER_TASK_STACK, this,
+										SD_WRITER_TASK_PRIORITY, &writer, SD_WRITER_TASK_CORE) != pdPASS)
+	{
+		writer = NULL;
+		f_close(fil);
+		release();
+		return false;
+	}
+
+	portENTER_CRITICAL(&writer_mux);
+	open = true;
+	portEXIT_CRITICAL(&writer_mux);
+	return true;
+}
+
+/**
+ * 关闭：写入剩余数据、同步并关闭文件（等待写入任务完成）
+ */
+void SdWriter::end()
+{
+	if (writer == NULL) return;
+
+	// 清除open后不会再有write进入临界区
+	portENTER_CRITICAL(&writer_mux);
+	open = false;
+	portEXIT_CRITICAL(&writer_mux);
+
+	stopping = true;
+	xTaskNotifyGive(writer);
+	xSemaphoreTake(done, portMAX_DELAY);
+	writer = NULL;
+	release();
+}
+
+bool SdWriter::isOpen()
+{
+	return open;
+}
+
+/**
+ * 追加数据（任意任务，不能在中断中调用）
+ * 当前块写满后立即交给写入任务；剩余空间不够整次写入时全部丢弃
+ */
+size_t SdWriter::write(const void* data, size_t len)
+{
+	if (!open || len == 0) return 0;
+
+	const uint8_t* p = (const uint8_t*)data;
+	bool notify = false;
+
+	portENTER_CRITICAL(&writer_mux);
+	uint32_t space = (SD_WRITER_BUF_SIZE - fill) + (uint32_t)(SD_WRITER_BUFS - 1 - pending) * SD_WRITER_BUF_SIZE;
+	if (!open || len > space)
+	{
+		if (open) dropped += len;
+		portEXIT_CRITICAL(&writer_mux);
+		return 0;
+	}
+	size_t left = len;
+	while (left)
+	{
+		// 上一次写满但当时没有空闲块的当前块，此时必有空闲块
+		if (fill == SD_WRITER_BUF_SIZE)
+		{
+			pending++;
+			cur = (cur + 1) % SD_WRITER_BUFS;
+			cur_base += SD_WRITER_BUF_SIZE;
+			fill = 0;
+			notify = true;
+		}
+		uint32_t n = SD_WRITER_BUF_SIZE - fill;
+		if (n > left) n = left;
+		memcpy(buf[cur] + fill, p, n);
+		fill += n;
+		p += n;
+		left -= n;
+	}
+	if (fill == SD_WRITER_BUF_SIZE && pending < SD_WRITER_BUFS - 1)
+	{
+		pending++;
+		cur = (cur + 1) % SD_WRITER_BUFS;
+		cur_base += SD_WRITER_BUF_SIZE;
+		fill = 0;
+		notify = true;
+	}
+	written += len;
+	portEXIT_CRITICAL(&writer_mux);
+
+	if (notify) xTaskNotifyGive(writer);
+	return len;
+}
+
+size_t SdWriter::printf(const char* fmt, ...)
+{
+	char line[SD_WRITER_LINE_MAX];
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+	if (n <= 0) return 0;
+	if (n > (int)sizeof(line) - 1) n = sizeof(line) - 1;
+	return write(line, n);
+}
+
+void SdWriter::sync()
+{
+	if (writer == NULL) return;
+	sync_req = true;
+	xTaskNotifyGive(writer);
+}
+
+uint32_t SdWriter::getWritten()
+{
+	return written;
+}
+
+uint32_t SdWriter::getDropped()
+{
+	return dropped;
+}
+
+/**
+ * 按顺序写入等待中的整块（写入任务中）
+ */
+void SdWriter::flushPending()
+{
+	while (true)
+	{
+		portENTER_CRITICAL(&writer_mux);
+		uint8_t n = pending;
+		uint8_t b = (cur + SD_WRITER_BUFS - n) % SD_WRITER_BUFS;
+		uint32_t base = cur_base - (uint32_t)n * SD_WRITER_BUF_SIZE;
+		portEXIT_CRITICAL(&writer_mux);
+		if (n == 0) return;
+
+		UINT bw = 0;
+		if (f_lseek(fil, base) == FR_OK) f_write(fil, buf[b], SD_WRITER_BUF_SIZE, &bw);
+		telemetry_sd_io(0, bw);
+		if (bw != SD_WRITER_BUF_SIZE) LOG_W("sd", "后台写入失败: 偏移%u", base);
+		if (base + SD_WRITER_BUF_SIZE > synced_end) synced_end = base + SD_WRITER_BUF_SIZE;
+
+		portENTER_CRITICAL(&writer_mux);
+		pending--;
+		portEXIT_CRITICAL(&writer_mux);
+	}
+}
+
+/**
+ * 把未满的当前块写到它的位置（写入任务中）
+ * 生产者只会在已取得的长度之后追加，与这里读取的部分不重叠
+ */
+void SdWriter::flushPartial()
+{
+	portENTER_CRITICAL(&writer_mux);
+	uint8_t b = cur;
+	uint16_t n = fill;
+	uint32_t base = cur_base;
+	portEXIT_CRITICAL(&writer_mux);
+	if (base + n <= synced_end) return;
+
+	UINT bw = 0;
+	if (f_lseek(fil, base) == FR_OK) f_write(fil, buf[b], n, &bw);
+	telemetry_sd_io(0, bw);
+	synced_end = base + bw;
+}
+
+/**
+ * 写入任务：写满的块随到随写；每SD_WRITER_SYNC_MS（或sync()、end()时）写入当前块并同步
+ */
+void SdWriter::writerEntry(void* arg)
+{
+	SdWriter* self = (SdWriter*)arg;
+	uint32_t last_sync = millis();
+
+	while (true)
+	{
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SD_WRITER_SYNC_MS));
+		// 停止时open已清除，不会再有追加
+		bool stop = self->stopping;
+		// SD卡正在重新挂载：暂不写入（停止时丢弃缓冲中的数据）
+		bool io = sdhotplug.beginIo();
+		if (io)
+		{
+			self->flushPending();
+			if (stop || self->sync_req || millis() - last_sync >= SD_WRITER_SYNC_MS)
+			{
+				self->sync_req = false;
+				self->flushPending();
+				self->flushPartial();
+				f_sync(self->fil);
+				last_sync = millis();
+			}
+			if (stop) f_close(self->fil);
+			sdhotplug.endIo();
+		}
+
+		if (stop)
+		{
+			xSemaphoreGive(self->done);
+			vTaskDelete(NULL);
+		}
+	}
+}
@@ -0,0 +1,128 @@
+/*
+ * HoloCubic 传感器总线
+ *
+ * 功能说明：
+ * 1. 运行时的传感器任务每轮调用poll()：IMU照常由imu.update()读取，环境光到期时提交一次异步读取，
+ *    返回值用于限制传感器任务的等待时间，IMU运动唤醒期间环境光仍按周期读取
+ * 2. 传感器的读取路径调用publish()：样本写入序列锁快照，再按抽取倍数回调订阅者
+ * 3. 读方调用get()复制快照，写方不等待读方
+ *
+ * 数据流：
+ *   传感器任务 --> imu.update() --> IMU::feed --> publish(SENSOR_IMU) --> 手势引擎/自动旋转
+ *             \-> poll() --> Ambient::sample() --> I2C总线任务 --> publish(SENSOR_AMBIENT)
+ *   任意任务 --> get() --> 电源/背光/相册/LED辉光/遥测
+ */
+
+#include "sensor_bus.h"
+#include "ambient.h"
+
+SensorBus sensorbus;
+
+SensorBus::SensorBus()
+{
+	amb = NULL;
+	memset(slots, 0, sizeof(slots));
+	sub_count = 0;
+	amb_due = 0;
+}
+
+void SensorBus::begin(Ambient* a)
+{
+	amb = a;
+	amb_due = millis();
+}
+
+/**
+ * 订阅：先写入表项再增加计数，发布方只遍历已计入的表项
+ */
+bool SensorBus::subscribe(SensorId sensor, uint16_t every, sensor_bus_cb_t cb, void* user)
+{
+	if (sensor >= SENSOR_COUNT || cb == NULL || sub_count >= SENSOR_BUS_MAX_SUBSCRIBERS) return false;
+
+	Subscriber* s = &subs[sub_count];
+	s->sensor = sensor;
+	s->every = every ? every : 1;
+	s->left = s->every;
+	s->cb = cb;
+	s->user = user;
+	__sync_synchronize();
+	sub_count++;
+	return true;
+}
+
+/**
+ * 更新快照并回调订阅者
+ * 序列号写前加一（变为奇数）、写后再加一，读方据此判断是否读到完整数据
+ */
+void SensorBus::publish(SensorId sensor, SensorSample* s)
+{
+	Slot* slot = &slots[sensor];
+	s->count = slot->data.count + 1;
+
+	slot->seq++;
+	__sync_synchronize();
+	slot->data = *s;
+	__sync_synchronize();
+	slot->seq++;
+
+	uint8_t n = sub_count;
+	for (uint8_t i = 0; i < n; i++)
+	{
+		Subscriber* sub = &subs[i];
+		if (sub->sensor != sensor || --sub->left) continue;
+		sub->left = sub->every;
+		sub->cb(s, sub->user);
+	}
+}
+
+/**
+ * 读取最新快照（任意任务可调用，不阻塞写方）
+ *
+ * @return 尚无数据时返回false
+ */
+bool SensorBus::get(SensorId sensor, SensorSample* out)
+{
+	if (sensor >= SENSOR_COUNT) return false;
+
+	Slot* slot = &slots[sensor];
+	uint32_t s;
+	do
+	{
+		s = slot->seq;
+		__sync_synchronize();
+		*out = slot->data;
+		__sync_synchronize();
+	} while ((s & 1) || s != slot->seq);
+
+	return out->count > 0;
+}
+
+/**
+ * 累计样本数（遥测据此计算实际采样率）
+ */
+uint32_t SensorBus::getCount(SensorId sensor)
+{
+	SensorSample s;
+	get(sensor, &s);
+	return s.count;
+}
+
+/**
+ * 提交到期的读取（传感器任务中执行）
+ * 到期时刻按周期累加，偶尔晚到不会使后续读取整体后移；落后超过一个周期时从现在重新计时
+ *
+ * @return 距下一次到期的毫秒数（没有需要调度的传感器时为UINT32_MAX）
+ */
+uint32_t SensorBus::poll(uint32_t now)
+{
+	if (amb == NULL) return UINT32_MAX;
+
+	uint32_t period = amb->getPeriod();
+	if ((int32_t)(now - amb_due) >= 0)
+	{
+		amb->sample();
+		amb_due += period;
+		if ((int32_t)(now - amb_due) >= 0) amb_due = now + period;
+	}
+	return amb_due - now;
+}
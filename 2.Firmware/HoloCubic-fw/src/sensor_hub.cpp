@@ -0,0 +1,270 @@
+/*
+ * HoloCubic 传感器中枢（Home Assistant）
+ *
+ * 功能说明：
+ * 1. 每SENSOR_HUB_TICK_MS取走环境光与IMU的统计窗口（只是复制几个整数，不访问总线），合并到当前上报周期
+ * 2. 各主题按各自的周期发布最小/最大/平均与样本数（JSON），周期内的峰值不会因低频上报而丢失
+ * 3. 有人/无人状态变化时立即发布（retain），HA中可直接作为自动化条件
+ * 4. 每次连上代理后发布Home Assistant发现配置（retain），断线重连或HA重启后实体自动恢复
+ *
+ * 开销：传感器侧每个样本只多几次整数比较与加法；上报任务每秒运行一次，只在发布时格式化几十字节的JSON，
+ * 发布进入esp-mqtt的发送队列后立即返回
+ */
+
+#include "sensor_hub.h"
+#include "config_store.h"
+#include "orientation.h"
+#include "logger.h"
+#include <esp_ota_ops.h>
+#include <math.h>
+
+SensorHub sensorhub;
+
+SensorHub::SensorHub()
+{
+	imu = NULL;
+	amb = NULL;
+	mq = NULL;
+	name[0] = '\0';
+	task = NULL;
+	running = false;
+	present = false;
+	published = 0;
+}
+
+bool SensorHub::begin(IMU* i, Ambient* a, MqttFeed* m, const char* device)
+{
+	if (task) return true;
+	if (m == NULL || device == NULL || device[0] == '\0') return false;
+
+	imu = i && i->isConnected() ? i : NULL;
+	amb = a;
+	mq = m;
+	strlcpy(name, device, sizeof(name));
+	lux_s = config.getInt(CFG_HUB_LUX_S);
+	motion_s = config.getInt(CFG_HUB_MOTION_S);
+	orient_s = config.getInt(CFG_HUB_ORIENT_S);
+	presence_s = config.getInt(CFG_HUB_PRESENCE_S);
+	discovery = config.getBool(CFG_HUB_DISCOVERY);
+
+	// 丢弃启动以来积累的窗口，第一个周期从现在开始
+	SensorWindow scratch[IMU_WINDOW_COUNT];
+	if (imu) imu->takeWindows(scratch);
+	if (amb) amb->takeWindow(scratch);
+	sensor_window_reset(&lux);
+	sensor_window_reset(&motion);
+	for (int k = 0; k < 3; k++) sensor_window_reset(&accel[k]);
+	uint32_t now = millis();
+	lux_ms = motion_ms = orient_ms = now;
+	// 开机视为有人（刚被放置或插上电源），presence_s内没有运动后变为无人
+	last_motion_ms = now;
+	present = imu != NULL;
+	announced = 0;
+
+	running = true;
+	if (xTaskCreatePinnedToCore(taskEntry, "sensor_hub", SENSOR_HUB_TASK_STACK, this,
+								SENSOR_HUB_TASK_PRIORITY, &task, SENSOR_HUB_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		running = false;
+		return false;
+	}
+	LOG_I("hub", "传感器中枢已启动: 照度%us 运动%us 姿态%us%s", lux_s, motion_s, orient_s,
+		  imu ? "" : "（没有IMU）");
+	return true;
+}
+
+void SensorHub::end()
+{
+	if (task == NULL) return;
+	running = false;
+	// 任务在下一个周期检查标志后自行删除
+	while (task) vTaskDelay(pdMS_TO_TICKS(10));
+}
+
+bool SensorHub::isPresent()
+{
+	return present;
+}
+
+uint32_t SensorHub::getPublishCount()
+{
+	return published;
+}
+
+void SensorHub::taskEntry(void* arg)
+{
+	SensorHub* self = (SensorHub*)arg;
+	TickType_t wake = xTaskGetTickCount();
+	while (self->running)
+	{
+		vTaskDelayUntil(&wake, pdMS_TO_TICKS(SENSOR_HUB_TICK_MS));
+		self->tick(millis());
+	}
+	self->task = NULL;
+	vTaskDelete(NULL);
+}
+
+/**
+ * 一个周期：取走窗口、更新有人状态、到期的主题发布
+ */
+void SensorHub::tick(uint32_t now)
+{
+	if (imu)
+	{
+		SensorWindow w[IMU_WINDOW_COUNT];
+		imu->takeWindows(w);
+		sensor_window_merge(&motion, &w[IMU_WINDOW_MOTION]);
+		for (int k = 0; k < 3; k++) sensor_window_merge(&accel[k], &w[IMU_WINDOW_AX + k]);
+
+		if (w[IMU_WINDOW_MOTION].count && w[IMU_WINDOW_MOTION].max >= SENSOR_HUB_MOTION_MG) last_motion_ms = now;
+		bool p = now - last_motion_ms < (uint32_t)presence_s * 1000;
+		if (p != present)
+		{
+			present = p;
+			publishPresence();
+		}
+	}
+	if (amb)
+	{
+		SensorWindow w;
+		amb->takeWindow(&w);
+		sensor_window_merge(&lux, &w);
+	}
+
+	if (!mq->isConnected()) return;
+	uint32_t c = mq->getConnectCount();
+	if (c != announced)
+	{
+		announced = c;
+		if (discovery) publishDiscovery();
+		if (imu) publishPresence();
+	}
+
+	// 周期到达时无论是否发布成功都重新开始统计
+	if (lux_s && now - lux_ms >= (uint32_t)lux_s * 1000)
+	{
+		lux_ms = now;
+		publishLux();
+		sensor_window_reset(&lux);
+	}
+	if (motion_s && now - motion_ms >= (uint32_t)motion_s * 1000)
+	{
+		motion_ms = now;
+		publishMotion();
+		sensor_window_reset(&motion);
+	}
+	if (orient_s && now - orient_ms >= (uint32_t)orient_s * 1000)
+	{
+		orient_ms = now;
+		publishOrientation();
+		for (int k = 0; k < 3; k++) sensor_window_reset(&accel[k]);
+	}
+}
+
+/**
+ * 发布到holocubic/<设备名>/<object>
+ */
+bool SensorHub::send(const char* object, const char* payload, bool retain)
+{
+	char topic[MQTT_TOPIC_LEN];
+	snprintf(topic, sizeof(topic), SENSOR_HUB_TOPIC_FMT, name, object);
+	if (!mq->publish(topic, payload, 0, 0, retain)) return false;
+	published++;
+	return true;
+}
+
+void SensorHub::publishLux()
+{
+	if (lux.count == 0) return;
+	char buf[96];
+	snprintf(buf, sizeof(buf), "{\"lux\":%d,\"min\":%d,\"max\":%d,\"n\":%u}",
+			 sensor_window_mean(&lux), lux.min, lux.max, lux.count);
+	send("lux", buf);
+}
+
+void SensorHub::publishMotion()
+{
+	if (motion.count == 0) return;
+	char buf[96];
+	snprintf(buf, sizeof(buf), "{\"mg\":%d,\"max\":%d,\"n\":%u}",
+			 sensor_window_mean(&motion), motion.max, motion.count);
+	send("motion", buf);
+}
+
+/**
+ * 姿态：周期内平均加速度（重力方向）的俯仰与横滚；每个周期只算一次，用浮点即可
+ */
+void SensorHub::publishOrientation()
+{
+	if (accel[0].count == 0) return;
+	float x = sensor_window_mean(&accel[0]);
+	float y = sensor_window_mean(&accel[1]);
+	float z = sensor_window_mean(&accel[2]);
+	float pitch = atan2f(-x, sqrtf(y * y + z * z)) * 180.0f / (float)M_PI;
+	float roll = atan2f(y, z) * 180.0f / (float)M_PI;
+
+	char buf[96];
+	int n = snprintf(buf, sizeof(buf), "{\"pitch\":%.1f,\"roll\":%.1f", pitch, roll);
+	OrientationData d;
+	if (orientation.isReady() && orientation.get(&d))
+		n += snprintf(buf + n, sizeof(buf) - n, ",\"yaw\":%.1f", d.ypr[0] * 180.0f / (float)M_PI);
+	snprintf(buf + n, sizeof(buf) - n, "}");
+	send("orientation", buf);
+}
+
+void SensorHub::publishPresence()
+{
+	send("presence", present ? "ON" : "OFF", true);
+}
+
+/**
+ * 一个实体的发现配置：homeassistant/<component>/<设备名>/<object>/config
+ * @param state 状态主题中的object（几个实体可共用一个JSON状态主题）
+ * @param extra 附加的JSON字段（以','开头）
+ * @param period_s 上报周期，非0时设置过期时间（设备离线后实体变为不可用），并把状态JSON作为属性
+ */
+void SensorHub::discover(const char* component, const char* object, const char* label, const char* state,
+						 const char* extra, uint16_t period_s)
+{
+	char topic[MQTT_TOPIC_LEN + 32];
+	snprintf(topic, sizeof(topic), SENSOR_HUB_DISCOVERY_PREFIX "/%s/%s/%s/config", component, name, object);
+
+	char stat_t[MQTT_TOPIC_LEN];
+	snprintf(stat_t, sizeof(stat_t), SENSOR_HUB_TOPIC_FMT, name, state);
+	char expire[MQTT_TOPIC_LEN + 48] = "";
+	if (period_s)
+		snprintf(expire, sizeof(expire), ",\"expire_after\":%u,\"json_attr_t\":\"%s\"",
+				 period_s * SENSOR_HUB_EXPIRE_FACTOR, stat_t);
+
+	char buf[512];
+	snprintf(buf, sizeof(buf),
+			 "{\"name\":\"%s\",\"uniq_id\":\"%s_%s\",\"stat_t\":\"%s\"%s%s,"
+			 "\"dev\":{\"ids\":[\"%s\"],\"name\":\"%s\",\"mdl\":\"HoloCubic\",\"sw\":\"%s\"}}",
+			 label, name, object, stat_t, expire, extra, name, name, esp_ota_get_app_description()->version);
+	if (mq->publish(topic, buf, 0, 1, true)) published++;
+}
+
+void SensorHub::publishDiscovery()
+{
+	if (amb && lux_s)
+		discover("sensor", "lux", "Illuminance", "lux",
+				 ",\"dev_cla\":\"illuminance\",\"unit_of_meas\":\"lx\",\"stat_cla\":\"measurement\","
+				 "\"val_tpl\":\"{{ value_json.lux }}\"", lux_s);
+	if (imu == NULL) return;
+	discover("binary_sensor", "presence", "Presence", "presence",
+			 ",\"dev_cla\":\"occupancy\",\"pl_on\":\"ON\",\"pl_off\":\"OFF\"", 0);
+	if (motion_s)
+		discover("sensor", "motion", "Motion", "motion",
+				 ",\"unit_of_meas\":\"mg\",\"stat_cla\":\"measurement\",\"val_tpl\":\"{{ value_json.mg }}\"",
+				 motion_s);
+	if (orient_s)
+	{
+		discover("sensor", "pitch", "Pitch", "orientation",
+				 ",\"unit_of_meas\":\"°\",\"stat_cla\":\"measurement\",\"val_tpl\":\"{{ value_json.pitch }}\"",
+				 orient_s);
+		discover("sensor", "roll", "Roll", "orientation",
+				 ",\"unit_of_meas\":\"°\",\"stat_cla\":\"measurement\",\"val_tpl\":\"{{ value_json.roll }}\"",
+				 orient_s);
+	}
+}
@@ -0,0 +1,507 @@
+/*
+ * HoloCubic 串口高速传输模块
+ *
+ * 功能说明：
+ * 1. 帧协议（帧头 + 长度 + CRC32），在同一个USB串口上与启动日志共存
+ * 2. 握手后切换到2M波特率，写文件按窗口流水发送，偏移不连续时主机回退重发
+ * 3. 读文件（日志、基准报告）由设备按窗口发送，主机确认偏移
+ * 4. 列目录，供主机比较后只推送有变化的文件
+ * 5. 握手前帧以外的字节交给串口诊断命令（console）
+ *
+ * 示例（PC端，见3.Software/HoloLink）：
+ *   python holo_link.py -p COM5 push ./Scenes /Scenes
+ *   python holo_link.py -p COM5 pull /log/holo.log
+ *
+ * 注意事项：
+ * - 没有硬件流控，接收缓冲（SERIAL_LINK_RX_BUF）须容纳整个窗口：SD卡写入时不读串口
+ * - 传输期间暂停日志的串口输出；直接调用Serial.printf的输出仍会混入，按帧头与CRC跳过
+ */
+
+#include "serial_link.h"
+#include "upload_server.h"
+#include "sd_card.h"
+#include "logger.h"
+#include "console.h"
+#include "lv_port_fatfs.h"
+#include <esp_rom_crc.h>
+#include <esp_heap_caps.h>
+
+SerialLink seriallink;
+
+SerialLink::SerialLink()
+{
+	task = NULL;
+	pm_lock = NULL;
+	active = false;
+	saved_sinks = LOG_SINK_UART;
+	tx_seq = 0;
+	last_rx_ms = 0;
+	in_len = 0;
+	in_pos = 0;
+	got = 0;
+	path[0] = '\0';
+	wbuf = NULL;
+	wfill = 0;
+	offset = 0;
+	size = 0;
+	crc = 0;
+	nak_sent = false;
+}
+
+/**
+ * 启动接收任务
+ */
+bool SerialLink::begin()
+{
+	if (task) return true;
+	// esp_pm未启用时没有浅睡眠，不需要锁
+	if (esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "serial_link", &pm_lock) != ESP_OK) pm_lock = NULL;
+	if (xTaskCreatePinnedToCore(taskEntry, "serial_link", SERIAL_LINK_TASK_STACK, this,
+								SERIAL_LINK_TASK_PRIORITY, &task, SERIAL_LINK_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool SerialLink::isActive()
+{
+	return active;
+}
+
+void SerialLink::taskEntry(void* arg)
+{
+	SerialLink* self = (SerialLink*)arg;
+	for (;;)
+	{
+		if (self->readFrame(self->active ? 100 : 1000)) self->handle();
+		if (self->active && millis() - self->last_rx_ms > SERIAL_LINK_IDLE_MS)
+		{
+			LOG_W("link", "主机无响应，退出传输模式");
+			self->closeFile(false);
+			self->leave();
+		}
+	}
+}
+
+/**
+ * 读入一个完整且CRC正确的帧到rx
+ * 串口数据整块读入，载荷按块复制，每个字节只在寻找帧头时逐个检查
+ */
+bool SerialLink::readFrame(uint32_t timeout_ms)
+{
+	uint8_t* raw = (uint8_t*)&rx;
+	uint32_t start = millis();
+
+	for (;;)
+	{
+		if (in_pos == in_len)
+		{
+			int n = Serial.available();
+			if (n <= 0)
+			{
+				if (millis() - start >= timeout_ms) return false;
+				// 握手前只需要响应HELLO，降低轮询频率
+				vTaskDelay(active ? 1 : pdMS_TO_TICKS(20));
+				continue;
+			}
+			in_len = Serial.read(in, n < (int)sizeof(in) ? n : sizeof(in));
+			in_pos = 0;
+			continue;
+		}
+
+		if (got < sizeof(LinkFrameHeader))
+		{
+			uint8_t c = in[in_pos++];
+			if (got == 0 && c != SERIAL_LINK_MAGIC0)
+			{
+				// 握手前帧以外的字节是终端输入的命令
+				if (!active) console.feed(c);
+				continue;
+			}
+			if (got == 1 && c != SERIAL_LINK_MAGIC1)
+			{
+				got = c == SERIAL_LINK_MAGIC0 ? 1 : 0;
+				continue;
+			}
+			raw[got++] = c;
+			if (got == sizeof(LinkFrameHeader) && rx.h.len > SERIAL_LINK_PAYLOAD_MAX) got = 0;
+			continue;
+		}
+
+		uint16_t total = sizeof(LinkFrameHeader) + rx.h.len + 4;
+		uint16_t n = total - got;
+		if (n > in_len - in_pos) n = in_len - in_pos;
+		memcpy(raw + got, in + in_pos, n);
+		in_pos += n;
+		got += n;
+		if (got < total) continue;
+
+		got = 0;
+		uint32_t expect;
+		memcpy(&expect, rx.payload + rx.h.len, 4);
+		if (esp_rom_crc32_le(0, raw + 2, sizeof(LinkFrameHeader) - 2 + rx.h.len) != expect) continue;
+		last_rx_ms = millis();
+		return true;
+	}
+}
+
+/**
+ * 发送一帧（payload可以指向tx.payload，此时不复制）
+ */
+void SerialLink::send(uint8_t type, uint8_t seq, const void* payload, uint16_t len)
+{
+	tx.h.magic[0] = SERIAL_LINK_MAGIC0;
+	tx.h.magic[1] = SERIAL_LINK_MAGIC1;
+	tx.h.type = type;
+	tx.h.seq = seq;
+	tx.h.len = len;
+	if (len && payload != tx.payload) memcpy(tx.payload, payload, len);
+	uint32_t c = esp_rom_crc32_le(0, (const uint8_t*)&tx + 2, sizeof(LinkFrameHeader) - 2 + len);
+	memcpy(tx.payload + len, &c, 4);
+	Serial.write((const uint8_t*)&tx, sizeof(LinkFrameHeader) + len + 4);
+}
+
+/**
+ * 回复当前请求（沿用rx的seq）
+ */
+void SerialLink::ack(uint8_t status, uint32_t value, const void* extra, uint16_t extra_len)
+{
+	if (extra_len > SERIAL_LINK_PAYLOAD_MAX - 5) extra_len = SERIAL_LINK_PAYLOAD_MAX - 5;
+	if (extra_len && extra != tx.payload + 5) memmove(tx.payload + 5, extra, extra_len);
+	tx.payload[0] = status;
+	memcpy(tx.payload + 1, &value, 4);
+	send(LINK_ACK, rx.h.seq, tx.payload, 5 + extra_len);
+}
+
+void SerialLink::handle()
+{
+	// 握手前只响应HELLO，避免误把其他数据当作命令
+	if (!active && rx.h.type != LINK_HELLO) return;
+
+	switch (rx.h.type)
+	{
+	case LINK_HELLO: onHello(); break;
+	case LINK_PUT:   onPut();   break;
+	case LINK_DATA:  onData();  break;
+	case LINK_END:   onEnd();   break;
+	case LINK_GET:   onGet();   break;
+	case LINK_LIST:  onList();  break;
+	case LINK_BYE:
+		closeFile(false);
+		ack(LINK_OK, 0);
+		leave();
+		break;
+	default:
+		ack(LINK_E_STATE, 0);
+		break;
+	}
+}
+
+/**
+ * 握手：以当前波特率确认，发送完毕后切换波特率（主机收到确认后切换）
+ */
+void SerialLink::onHello()
+{
+	uint32_t baud = 0;
+	if (rx.h.len >= 4) memcpy(&baud, rx.payload, 4);
+	if (baud == 0) baud = SERIAL_LINK_BAUD;
+
+	if (!active)
+	{
+		// 暂停日志的串口输出（setSinks等待正在进行的输出完成）
+		saved_sinks = logger.getSinks();
+		logger.setSinks(saved_sinks & ~LOG_SINK_UART);
+		if (pm_lock) esp_pm_lock_acquire(pm_lock);
+		active = true;
+	}
+	uint8_t info[4] = { SERIAL_LINK_VERSION, SERIAL_LINK_WINDOW, SERIAL_LINK_DATA_MAX & 0xFF, SERIAL_LINK_DATA_MAX >> 8 };
+	ack(LINK_OK, baud, info, sizeof(info));
+	Serial.flush();
+	Serial.updateBaudRate(baud);
+	in_len = in_pos = got = 0;
+}
+
+/**
+ * 回到握手波特率并恢复日志输出
+ */
+void SerialLink::leave()
+{
+	Serial.flush();
+	Serial.updateBaudRate(SERIAL_LINK_BOOT_BAUD);
+	in_len = in_pos = got = 0;
+	active = false;
+	if (pm_lock) esp_pm_lock_release(pm_lock);
+	logger.setSinks(saved_sinks);
+}
+
+/**
+ * 取载荷中的路径：绝对路径、不含".."，留出".part"的长度
+ */
+bool SerialLink::getPath(const uint8_t* p, uint16_t len, char* out)
+{
+	if (len == 0 || len >= SERIAL_LINK_PATH_MAX - 5 || p[0] != '/') return false;
+	memcpy(out, p, len);
+	out[len] = '\0';
+	return strlen(out) == len && strstr(out, "..") == NULL;
+}
+
+/**
+ * PUT：打开<path>.part（已知长度时预留连续空间）
+ */
+void SerialLink::onPut()
+{
+	closeFile(false);
+	if (rx.h.len < 5 || !getPath(rx.payload + 4, rx.h.len - 4, path)) return ack(LINK_E_PATH, 0);
+	memcpy(&size, rx.payload, 4);
+
+	char part[SERIAL_LINK_PATH_MAX];
+	snprintf(part, sizeof(part), "%s.part", path);
+	if (!UploadServer::makeParents(path)) return ack(LINK_E_IO, 0);
+	if (size > 0 && !tf.preallocate(part, size))
+		Serial.printf("串口传输: %s 未能预留%u字节的连续空间\n", path, size);
+
+	wbuf = (uint8_t*)heap_caps_malloc(UPLOAD_WRITE_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+	file = wbuf ? SD_FS.open(part, FILE_WRITE) : File();
+	if (!file)
+	{
+		closeFile(false);
+		return ack(LINK_E_IO, 0);
+	}
+	wfill = 0;
+	offset = 0;
+	crc = 0;
+	nak_sent = false;
+	ack(LINK_OK, 0);
+}
+
+/**
+ * DATA：只接收偏移连续的帧，每帧确认已接收的长度
+ * 丢帧后窗口内的后续帧都不连续，只对第一个回复E_OFFSET，主机据此回退一次
+ */
+void SerialLink::onData()
+{
+	if (!file) return ack(LINK_E_STATE, 0);
+	if (rx.h.len < 4) return ack(LINK_E_STATE, offset);
+
+	uint32_t at;
+	memcpy(&at, rx.payload, 4);
+	if (at != offset)
+	{
+		if (!nak_sent) ack(LINK_E_OFFSET, offset);
+		nak_sent = true;
+		return;
+	}
+	nak_sent = false;
+
+	const uint8_t* p = rx.payload + 4;
+	uint32_t n = rx.h.len - 4;
+	crc = esp_rom_crc32_le(crc, p, n);
+	offset += n;
+	while (n > 0)
+	{
+		uint32_t k = UPLOAD_WRITE_SIZE - wfill;
+		if (k > n) k = n;
+		memcpy(wbuf + wfill, p, k);
+		wfill += k;
+		p += k;
+		n -= k;
+		if (wfill == UPLOAD_WRITE_SIZE && !flushWrite())
+		{
+			closeFile(false);
+			return ack(LINK_E_IO, 0);
+		}
+	}
+	ack(LINK_OK, offset);
+}
+
+bool SerialLink::flushWrite()
+{
+	bool ok = wfill == 0 || file.write(wbuf, wfill) == wfill;
+	wfill = 0;
+	return ok;
+}
+
+/**
+ * 关闭正在写入的文件，keep为false时删除.part
+ */
+void SerialLink::closeFile(bool keep)
+{
+	if (file)
+	{
+		file.close();
+		if (!keep)
+		{
+			char part[SERIAL_LINK_PATH_MAX];
+			snprintf(part, sizeof(part), "%s.part", path);
+			SD_FS.remove(part);
+		}
+	}
+	if (wbuf) heap_caps_free(wbuf);
+	wbuf = NULL;
+	wfill = 0;
+}
+
+/**
+ * END：校验长度与CRC后改名为目标文件
+ */
+void SerialLink::onEnd()
+{
+	if (!file || rx.h.len < 8) return ack(LINK_E_STATE, 0);
+	uint32_t want_size, want_crc;
+	memcpy(&want_size, rx.payload, 4);
+	memcpy(&want_crc, rx.payload + 4, 4);
+	if (want_size != offset) return ack(LINK_E_OFFSET, offset);
+	if (!flushWrite())
+	{
+		closeFile(false);
+		return ack(LINK_E_IO, 0);
+	}
+	if (want_crc != crc)
+	{
+		LOG_W("link", "%s CRC不符: %08x != %08x", path, crc, want_crc);
+		closeFile(false);
+		return ack(LINK_E_CRC, crc);
+	}
+	closeFile(true);
+
+	char part[SERIAL_LINK_PATH_MAX];
+	snprintf(part, sizeof(part), "%s.part", path);
+	if (SD_FS.exists(path)) SD_FS.remove(path);
+	if (!SD_FS.rename(part, path)) return ack(LINK_E_IO, 0);
+	// 场景目录下的文件更新清单与索引，其他文件只需作废LVGL的文件句柄
+	if (strncmp(path, UPLOAD_ROOT, strlen(UPLOAD_ROOT)) == 0) UploadServer::finish(path);
+	else lv_fs_if_invalidate();
+	LOG_I("link", "已写入 %s（%u字节）", path, offset);
+	ack(LINK_OK, offset);
+}
+
+/**
+ * GET：先以ACK回复文件长度，再按窗口发送DATA帧，全部确认后发送END（长度与起始偏移后内容的CRC）
+ * 主机确认帧为ACK(OK, 已接收的偏移)；超时未确认时从最后确认的偏移重发
+ */
+void SerialLink::onGet()
+{
+	char name[SERIAL_LINK_PATH_MAX];
+	uint32_t start;
+	if (rx.h.len < 5 || !getPath(rx.payload + 4, rx.h.len - 4, name)) return ack(LINK_E_PATH, 0);
+	memcpy(&start, rx.payload, 4);
+
+	File f = SD_FS.open(name);
+	if (!f || f.isDirectory())
+	{
+		if (f) f.close();
+		return ack(LINK_E_PATH, 0);
+	}
+	uint32_t fsize = f.size();
+	if (start > fsize) start = fsize;
+	ack(LINK_OK, fsize);
+
+	uint32_t acked = start;
+	uint32_t sent = start;
+	uint32_t crc_pos = start;
+	uint32_t sum = 0;
+	uint32_t wait_ms = millis();
+	uint8_t retries = 0;
+	f.seek(start);
+
+	while (acked < fsize)
+	{
+		while (sent < fsize && sent - acked < (uint32_t)SERIAL_LINK_WINDOW * SERIAL_LINK_DATA_MAX)
+		{
+			uint32_t n = fsize - sent;
+			if (n > SERIAL_LINK_DATA_MAX) n = SERIAL_LINK_DATA_MAX;
+			if (f.read(tx.payload + 4, n) != n) break;
+			memcpy(tx.payload, &sent, 4);
+			// 重发的部分已计入CRC
+			if (sent == crc_pos)
+			{
+				sum = esp_rom_crc32_le(sum, tx.payload + 4, n);
+				crc_pos += n;
+			}
+			send(LINK_DATA, tx_seq++, tx.payload, 4 + n);
+			sent += n;
+		}
+
+		if (readFrame(SERIAL_LINK_ACK_MS))
+		{
+			// 主机中途发来其他请求：放弃本次发送
+			if (rx.h.type != LINK_ACK || rx.h.len < 5)
+			{
+				f.close();
+				return handle();
+			}
+			uint32_t v;
+			memcpy(&v, rx.payload + 1, 4);
+			if (v > acked && v <= sent)
+			{
+				acked = v;
+				retries = 0;
+				wait_ms = millis();
+			}
+		}
+		else if (millis() - wait_ms >= SERIAL_LINK_ACK_MS)
+		{
+			if (++retries > 10)
+			{
+				LOG_W("link", "读取 %s 无确认，放弃", name);
+				break;
+			}
+			sent = acked;
+			f.seek(acked);
+			wait_ms = millis();
+		}
+	}
+	f.close();
+
+	uint32_t end[2] = { acked, sum };
+	send(LINK_END, tx_seq++, end, sizeof(end));
+}
+
+/**
+ * LIST：从第start项起，尽量多地放入一个ACK（值为项数，0表示已列完）
+ */
+void SerialLink::onList()
+{
+	char name[SERIAL_LINK_PATH_MAX];
+	uint16_t start;
+	if (rx.h.len < 3 || !getPath(rx.payload + 2, rx.h.len - 2, name)) return ack(LINK_E_PATH, 0);
+	memcpy(&start, rx.payload, 2);
+
+	File dir = SD_FS.open(name);
+	if (!dir || !dir.isDirectory())
+	{
+		if (dir) dir.close();
+		return ack(LINK_E_PATH, 0);
+	}
+
+	char* text = (char*)tx.payload + 5;
+	uint16_t cap = SERIAL_LINK_PAYLOAD_MAX - 5;
+	uint16_t len = 0;
+	uint32_t count = 0;
+	uint16_t index = 0;
+	for (File e = dir.openNextFile(); e; e = dir.openNextFile())
+	{
+		if (index++ < start)
+		{
+			e.close();
+			continue;
+		}
+		char line[SERIAL_LINK_PATH_MAX + 16];
+		int n = snprintf(line, sizeof(line), "%s\t%d\n", e.name(), e.isDirectory() ? -1 : (int)e.size());
+		e.close();
+		// 过长的名称跳过（仍计入项数，主机按项数翻页）
+		if (n <= 0 || n >= (int)sizeof(line))
+		{
+			count++;
+			continue;
+		}
+		if (len + n > cap) break;
+		memcpy(text + len, line, n);
+		len += n;
+		count++;
+	}
+	dir.close();
+	ack(LINK_OK, count, text, len);
+}
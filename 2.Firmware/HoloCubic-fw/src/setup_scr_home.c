@@ -40,6 +40,18 @@
 #include "lvgl.h"        // LVGL图形库核心头文件
 #include <stdio.h>       // 标准输入输出库
 #include "gui_guider.h"  // GUI向导头文件
+#include "ui_tables.h"   // 由ui/home.json生成的常量表
+#include "palette_decoder.h"  // 索引色图像着色
+
+/**
+ * 颜色选择器变化时为索引色图像（场景动画、CF_INDEXED素材）着色
+ * 只重算调色板，不使用逐像素混合的image_recolor样式
+ */
+static void home_cpicker_event_cb(lv_obj_t* obj, lv_event_t event)
+{
+	if (event != LV_EVENT_VALUE_CHANGED) return;
+	palette_decoder_set_tint(lv_cpicker_get_color(obj), PALETTE_TINT_OPA);
+}
 
 /**
  * 主界面（Home）设置函数
@@ -58,7 +70,7 @@
  * - 选择器类型：圆盘式（DISC）颜色选择器
  * - 内边距：10像素，提供舒适的操作空间
  * 
- * 样式设计：
+ * 样式设计（见ui/home.json）：
  * - 现代化的圆形设计
  * - 清晰的颜色渐变显示
  * - 适合触摸和手势操作的尺寸
@@ -71,35 +83,17 @@
  */
 void setup_scr_home(lv_ui* ui)
 {
-	/* 创建主界面屏幕对象 */
-	/* 作为所有主界面控件的父容器 */
-	ui->home = lv_obj_create(NULL, NULL);
-
-	/* 创建圆形颜色选择器控件 */
-	/* 用于RGB LED颜色选择和控制 */
-	ui->home_cpicker0 = lv_cpicker_create(ui->home, NULL);
+	/* 屏幕对象与圆盘式颜色选择器按ui/home.json生成的常量表创建 */
+	/* 样式（内边距、刻度宽度各10像素）在flash中，不占LVGL堆 */
+	ui->home = ui_build(ui, &ui_scr_home);
+	if (ui->home_cpicker0) lv_obj_set_event_cb(ui->home_cpicker0, home_cpicker_event_cb);
+}
 
-	/* 配置颜色选择器的主要样式 */
-	static lv_style_t style_home_cpicker0_main;
-	lv_style_init(&style_home_cpicker0_main);  // 初始化样式对象
-
-	/* 设置颜色选择器的默认状态样式 */
-	/* 内边距：提供10像素的内部间距，改善视觉效果 */
-	lv_style_set_pad_inner(&style_home_cpicker0_main, LV_STATE_DEFAULT, 10);
-	/* 刻度宽度：设置颜色环的宽度为10像素 */
-	lv_style_set_scale_width(&style_home_cpicker0_main, LV_STATE_DEFAULT, 10);
-	
-	/* 应用样式到颜色选择器控件 */
-	lv_obj_add_style(ui->home_cpicker0, LV_CPICKER_PART_MAIN, &style_home_cpicker0_main);
-	
-	/* 设置颜色选择器的位置和尺寸 */
-	lv_obj_set_pos(ui->home_cpicker0, 15, 16);      // 位置：距离左上角(15,16)像素
-	lv_obj_set_size(ui->home_cpicker0, 200, 200);   // 尺寸：200x200像素的正方形
-	
-	/* 设置颜色选择器类型为圆盘式 */
-	/* 圆盘式提供更直观的颜色选择体验 */
-	lv_cpicker_set_type(ui->home_cpicker0, LV_CPICKER_TYPE_DISC);
-	
-	/* 颜色选择器现在已准备就绪，可以通过IMU手势进行操作 */
-	/* 选中的颜色将自动应用到RGB LED显示 */
-}
\ No newline at end of file
+/**
+ * 主界面回收后的清理（由屏幕管理器在屏幕对象删除后调用）
+ * 样式为常量表无需释放，只清空已失效的控件指针
+ */
+void cleanup_scr_home(lv_ui* ui)
+{
+	ui_unbuild(ui, &ui_scr_home);
+}
@@ -47,6 +47,7 @@
 #include "lvgl.h"        // LVGL图形库核心头文件
 #include <stdio.h>       // 标准输入输出库
 #include "gui_guider.h"  // GUI向导头文件
+#include "ui_tables.h"   // 由ui/scenes.json生成的常量表
 
 /**
  * 场景界面（Scenes）设置函数
@@ -71,7 +72,7 @@
  * - 图像格式：二进制格式，针对ESP32优化
  * - 显示模式：全屏居中显示
  * 
- * 样式设计：
+ * 样式设计（见ui/scenes.json）：
  * - 默认状态：黑色背景，突出动画内容
  * - 按压状态：灰色背景，提供交互反馈
  * - 聚焦状态：黑色背景，保持一致性
@@ -79,44 +80,22 @@
  * 
  * 注意事项：
  * - 需要SD卡中存在对应的动画文件
- * - 动画播放逻辑在主循环中实现
+ * - 动画播放由ScenePlayer（scene_player.cpp）预读并逐帧更新图像源
  * - 支持通过IMU手势切换到其他界面
  */
 void setup_scr_scenes(lv_ui* ui)
 {
-	/* 创建场景界面屏幕对象 */
-	/* 作为动画播放的主容器 */
-	ui->scenes = lv_obj_create(NULL, NULL);
+	/* 屏幕对象与居中的图像画布按ui/scenes.json生成的常量表创建 */
+	/* 背景样式应用在scenes对象而不是画布上，样式在flash中，不占LVGL堆 */
+	/* 动画播放由ScenePlayer以内存图像方式逐帧更新图像源 */
+	ui->scenes = ui_build(ui, &ui_scr_scenes);
+}
 
-	/* 创建图像控件作为动画画布 */
-	/* 用于显示从SD卡加载的动画帧 */
-	ui->scenes_canvas = lv_img_create(ui->scenes, NULL);
-
-	/* 配置动画画布的主要样式 */
-	static lv_style_t style_scenes_canvas_main;
-	lv_style_init(&style_scenes_canvas_main);  // 初始化样式对象
-	
-	/* 设置不同状态下的背景颜色 */
-	/* 默认状态：黑色背景，突出动画内容 */
-	lv_style_set_bg_color(&style_scenes_canvas_main, LV_STATE_DEFAULT, LV_COLOR_BLACK);
-	/* 按压状态：灰色背景，提供用户交互反馈 */
-	lv_style_set_bg_color(&style_scenes_canvas_main, LV_STATE_PRESSED, LV_COLOR_GRAY);
-	/* 聚焦状态：黑色背景，保持视觉一致性 */
-	lv_style_set_bg_color(&style_scenes_canvas_main, LV_STATE_FOCUSED, LV_COLOR_BLACK);
-
-	/* 应用样式到场景界面 */
-	/* 注意：这里应用到scenes对象而不是canvas对象 */
-	lv_obj_add_style(ui->scenes, LV_BTN_PART_MAIN, &style_scenes_canvas_main);
-	
-	/* 设置动画画布的初始图像源 */
-	/* 加载动画序列的第一帧作为默认显示 */
-	lv_img_set_src(ui->scenes_canvas, "S:/Scenes/Holo3D/frame000.bin");
-	
-	/* 设置画布在屏幕中央对齐 */
-	/* 确保动画内容完美居中显示 */
-	lv_obj_align(ui->scenes_canvas, NULL, LV_ALIGN_CENTER, 0, 0);
-	
-	/* 场景界面现在已准备就绪 */
-	/* 动画播放逻辑将在主循环中通过更新图像源实现 */
-	/* 用户可以通过IMU手势在不同界面间切换 */
-}
\ No newline at end of file
+/**
+ * 场景界面回收后的清理（由屏幕管理器在屏幕对象删除后调用）
+ * 样式为常量表无需释放，只清空已失效的画布指针
+ */
+void cleanup_scr_scenes(lv_ui* ui)
+{
+	ui_unbuild(ui, &ui_scr_scenes);
+}
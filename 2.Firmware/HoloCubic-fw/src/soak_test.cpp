@@ -0,0 +1,248 @@
+/*
+ * HoloCubic 长时间运行测试
+ *
+ * 功能说明：
+ * 1. 持续施加日常负载：场景索引中的场景轮流打开播放、界面来回切换（带动画）、定时刷新全部数据源
+ * 2. 每分钟记录系统堆/LVGL堆的空闲量与最大空闲块、碎片率、分配失败次数、最小栈余量与平均帧率
+ * 3. 最近SOAK_TREND_WINDOW次记录中持续下降的指标标记在CSV的flags列并输出警告
+ *
+ * 使用方法：
+ *   build_flags = -DSOAK_TEST_ON_BOOT=1，运行数天后取出SD卡/soak/soak.csv
+ *   （重启后继续追加，uptime_min归零处即为一次重启）
+ *
+ * 注意事项：
+ * - 负载在LVGL任务中执行（runtime.post），记录在核心0的低优先级任务中进行
+ * - 数据源刷新需要网络已初始化（wifi.init + fetcher.begin），否则只切换界面与场景
+ */
+
+#include "soak_test.h"
+#include "telemetry.h"
+#include "render_prof.h"
+#include "fetch_scheduler.h"
+#include "scene_index.h"
+#include "gui_guider.h"
+#include "sd_card.h"
+#include "logger.h"
+
+SoakTest soak;
+
+static const char* const metric_names[SOAK_METRIC_CNT] = {
+	"heap_free", "heap_largest", "lv_free", "lv_biggest", "stack_min", "fps"
+};
+
+SoakTest::SoakTest()
+{
+	task = NULL;
+	player = NULL;
+	running = false;
+}
+
+/**
+ * 开始测试（在setup中调用，需SD卡已挂载、运行时任务已启动）
+ */
+bool SoakTest::begin(ScenePlayer* scene_player)
+{
+	if (task) return true;
+	player = scene_player;
+
+	if (!telemetry.isRunning() && !telemetry.begin()) return false;
+
+	SD_FS.mkdir(SOAK_LOG_DIR);
+	bool fresh = !SD_FS.exists(SOAK_LOG_PATH);
+	if (!log.begin(SOAK_LOG_PATH)) return false;
+	if (fresh)
+	{
+		static const char header[] = "uptime_min,heap_free,heap_min,heap_largest,heap_frag,"
+			"lv_free,lv_biggest,lv_frag,lv_fail,stack_min,stack_task,fps,flags\n";
+		log.write(header, sizeof(header) - 1);
+	}
+
+	step = 0;
+	scene_pos = 0;
+	hist_len = 0;
+	hist_pos = 0;
+	uint32_t us[RENDER_PROF_PHASE_CNT];
+	mark_frames = render_prof_get_totals(us);
+	mark_ms = millis();
+
+	running = true;
+	if (xTaskCreatePinnedToCore(taskEntry, "soak", SOAK_TASK_STACK, this,
+								SOAK_TASK_PRIORITY, &task, SOAK_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		running = false;
+		log.end();
+		return false;
+	}
+	LOG_I("soak", "长时间运行测试开始，记录写入%s", SOAK_LOG_PATH);
+	return true;
+}
+
+/**
+ * 停止测试，写完记录并关闭文件（不能在LVGL任务中等待时调用）
+ */
+void SoakTest::end()
+{
+	if (task == NULL) return;
+	running = false;
+	while (task != NULL) vTaskDelay(pdMS_TO_TICKS(10));
+	log.end();
+}
+
+bool SoakTest::isRunning()
+{
+	return running;
+}
+
+/**
+ * 一步负载（LVGL任务中）：偶数步打开下一个场景，奇数步关闭场景回到主界面
+ */
+void SoakTest::stepCb(const UiMsg* msg)
+{
+	SoakTest* self = (SoakTest*)msg->obj;
+	if (!self->running) return;
+	uint32_t k = (uint32_t)msg->value;
+
+	if (k % SOAK_FETCH_EVERY == 0)
+		for (uint8_t i = 0; i < FETCH_MAX_SOURCES; i++) fetcher.refresh(i);
+
+	if (k & 1)
+	{
+		if (self->player) self->player->close();
+		gui_load(GUI_SCR_HOME, LV_SCR_LOAD_ANIM_MOVE_RIGHT);
+		return;
+	}
+
+	gui_load(GUI_SCR_SCENES, LV_SCR_LOAD_ANIM_MOVE_LEFT);
+	if (self->player == NULL) return;
+
+	SceneIndex index;
+	SceneIndexEntry e;
+	if (!index.open() || index.getCount() == 0) return;
+	if (!index.get(self->scene_pos++ % index.getCount(), &e)) return;
+
+	char path[SCENE_PATH_MAX];
+	snprintf(path, sizeof(path), SCENE_ROOT "/%s", e.name);
+	if (self->player->open(path, (uint16_t)e.frame_count, 0)) self->player->play(guider_ui.scenes_canvas);
+	else LOG_W("soak", "无法打开场景: %s", e.name);
+}
+
+/**
+ * 记录一次（后台任务中）
+ */
+void SoakTest::record()
+{
+	TelemetrySample s;
+	if (!telemetry.get(&s)) return;
+
+	// 帧率取整个记录周期的平均值（遥测采样为最近一秒）
+	uint32_t us[RENDER_PROF_PHASE_CNT];
+	uint32_t frames = render_prof_get_totals(us);
+	uint32_t now = millis();
+	uint32_t dt = now - mark_ms;
+	uint32_t fps_x10 = dt ? (uint32_t)((uint64_t)(frames - mark_frames) * 10000 / dt) : 0;
+	mark_frames = frames;
+	mark_ms = now;
+
+	uint32_t stack_min = UINT32_MAX;
+	const char* stack_task = "";
+	for (uint8_t i = 0; i < s.task_count; i++)
+	{
+		if (s.task[i].stack_free >= stack_min) continue;
+		stack_min = s.task[i].stack_free;
+		stack_task = s.task[i].name;
+	}
+	if (s.task_count == 0) stack_min = 0;
+
+	uint32_t heap_frag = s.heap_free ? 1000 - (uint32_t)((uint64_t)s.heap_largest * 1000 / s.heap_free) : 0;
+	uint32_t lv_frag = s.lv_free ? 1000 - (uint32_t)((uint64_t)s.lv_biggest * 1000 / s.lv_free) : 0;
+
+	uint32_t values[SOAK_METRIC_CNT];
+	values[SOAK_HEAP_FREE] = s.heap_free;
+	values[SOAK_HEAP_LARGEST] = s.heap_largest;
+	values[SOAK_LV_FREE] = s.lv_free;
+	values[SOAK_LV_BIGGEST] = s.lv_biggest;
+	values[SOAK_STACK_MIN] = stack_min;
+	values[SOAK_FPS] = fps_x10;
+	uint32_t falling = trends(values);
+
+	char flags[80] = "";
+	for (uint8_t m = 0; m < SOAK_METRIC_CNT; m++)
+	{
+		if (!(falling & (1u << m))) continue;
+		if (flags[0]) strlcat(flags, "|", sizeof(flags));
+		strlcat(flags, metric_names[m], sizeof(flags));
+	}
+
+	char line[192];
+	int n = snprintf(line, sizeof(line), "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%s,%u.%u,%s\n",
+		now / 60000, s.heap_free, s.heap_min_free, s.heap_largest, heap_frag,
+		s.lv_free, s.lv_biggest, lv_frag, s.lv_fail, stack_min, stack_task,
+		fps_x10 / 10, fps_x10 % 10, flags);
+	if (n > 0) log.write(line, (size_t)n < sizeof(line) ? n : sizeof(line) - 1);
+
+	LOG_I("soak", "heap %u/%u lv %u/%u stack %u(%s) fps %u.%u", s.heap_largest, s.heap_free,
+		s.lv_biggest, s.lv_free, stack_min, stack_task, fps_x10 / 10, fps_x10 % 10);
+	if (falling) LOG_W("soak", "最近%u分钟持续下降: %s", SOAK_TREND_WINDOW * SOAK_LOG_PERIOD_MS / 60000, flags);
+}
+
+/**
+ * 加入一次记录并判断趋势
+ * @return 持续下降的指标（1 << SoakMetric），记录数不足一个窗口时为0
+ */
+uint32_t SoakTest::trends(const uint32_t* values)
+{
+	for (uint8_t m = 0; m < SOAK_METRIC_CNT; m++) history[m][hist_pos] = values[m];
+	hist_pos = (hist_pos + 1) % SOAK_TREND_WINDOW;
+	if (hist_len < SOAK_TREND_WINDOW) hist_len++;
+	if (hist_len < SOAK_TREND_WINDOW) return 0;
+
+	// 窗口已满，hist_pos为最早的一次
+	uint32_t falling = 0;
+	for (uint8_t m = 0; m < SOAK_METRIC_CNT; m++)
+	{
+		const uint32_t* h = history[m];
+		uint16_t up = 0, down = 0;
+		uint32_t prev = h[hist_pos];
+		for (uint8_t i = 1; i < SOAK_TREND_WINDOW; i++)
+		{
+			uint32_t v = h[(hist_pos + i) % SOAK_TREND_WINDOW];
+			if (v < prev) down++;
+			else if (v > prev) up++;
+			prev = v;
+		}
+		uint16_t changes = up + down;
+		if (changes >= SOAK_TREND_MIN_STEPS && down * 100 >= SOAK_TREND_PERCENT * changes && prev < h[hist_pos])
+			falling |= 1u << m;
+	}
+	return falling;
+}
+
+/**
+ * 后台任务：按步长投递负载，按记录周期写入一行
+ */
+void SoakTest::taskEntry(void* arg)
+{
+	SoakTest* self = (SoakTest*)arg;
+	uint32_t last_step = millis() - SOAK_STEP_MS;
+	uint32_t last_log = millis();
+
+	while (self->running)
+	{
+		vTaskDelay(pdMS_TO_TICKS(1000));
+		uint32_t now = millis();
+		if (now - last_step >= SOAK_STEP_MS)
+		{
+			last_step = now;
+			runtime.post(stepCb, self, (int32_t)self->step++);
+		}
+		if (now - last_log >= SOAK_LOG_PERIOD_MS)
+		{
+			last_log = now;
+			self->record();
+		}
+	}
+
+	self->task = NULL;
+	vTaskDelete(NULL);
+}
@@ -0,0 +1,298 @@
+/*
+ * HoloCubic 存储基准测试模块
+ *
+ * 功能说明：
+ * 1. 顺序读取：块大小512B~64KB
+ * 2. 随机读取：同样的块大小，偏移按扇区对齐
+ * 3. 文件打开延迟与目录内文件数的关系
+ * 4. LVGL lv_fs_*（S:盘）路径与Arduino SD路径对比
+ * 5. 实际帧序列（frameNNN.bin）的每秒帧数
+ *
+ * 计时使用esp_timer_get_time()（微秒），结果按固定格式逐行输出到串口，
+ * 可用于出厂前批量验证SD卡。测试会在work_dir下创建并删除临时文件。
+ */
+
+#include "storage_bench.h"
+#include <lvgl.h>
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <esp_heap_caps.h>
+#include "buf_manager.h"
+
+static const uint32_t bench_chunks[] = { 512, 1024, 4096, 16384, 32768, 65536 };
+#define BENCH_CHUNK_COUNT (sizeof(bench_chunks) / sizeof(bench_chunks[0]))
+
+/**
+ * 运行全部测试
+ *
+ * @param dir       临时文件目录
+ * @param scene_dir 帧序列目录，不存在时跳过帧率测试
+ */
+void StorageBench::run(const char* dir, const char* scene_dir)
+{
+	work_dir = dir;
+
+	// 从64KB开始尝试分配测试缓冲区，片内RAM不足时逐次减半
+	buf_size = bench_chunks[BENCH_CHUNK_COUNT - 1];
+	buf = NULL;
+	while (buf_size >= 512 && buf == NULL)
+	{
+		buf = (uint8_t*)heap_caps_malloc(buf_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+		if (buf == NULL) buf_size /= 2;
+	}
+	if (buf == NULL)
+	{
+		Serial.println("BENCH,error,0,no_memory,-");
+		return;
+	}
+
+	Serial.printf("BENCH,begin,%u,%llu,MB\n", buf_size, SD_FS.cardSize() / (1024 * 1024));
+
+	char path[64];
+	SD_FS.mkdir(work_dir);
+	snprintf(path, sizeof(path), "%s/data.bin", work_dir);
+
+	if (prepareFile(path))
+	{
+		for (uint8_t i = 0; i < BENCH_CHUNK_COUNT; i++) seqRead(path, bench_chunks[i]);
+		for (uint8_t i = 0; i < BENCH_CHUNK_COUNT; i++) randomRead(path, bench_chunks[i]);
+		lvFsRead(path, 512);
+		lvFsRead(path, 4096);
+		SD_FS.remove(path);
+	}
+
+	openLatency();
+	frameRate(scene_dir);
+
+	SD_FS.rmdir(work_dir);
+	heap_caps_free(buf);
+	buf = NULL;
+	Serial.println("BENCH,end,0,0,-");
+}
+
+void StorageBench::report(const char* item, uint32_t param, float value, const char* unit)
+{
+	Serial.printf("BENCH,%s,%u,%.2f,%s\n", item, param, value, unit);
+}
+
+void StorageBench::skip(const char* item, uint32_t param, const char* reason)
+{
+	Serial.printf("BENCH,%s,%u,skip,%s\n", item, param, reason);
+}
+
+/**
+ * 写入测试文件，同时测量顺序写入速度
+ */
+bool StorageBench::prepareFile(const char* path)
+{
+	File f = SD_FS.open(path, FILE_WRITE);
+	if (!f)
+	{
+		skip("seq_write", buf_size, "open_failed");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < buf_size; i++) buf[i] = (uint8_t)esp_random();
+
+	int64_t t0 = esp_timer_get_time();
+	for (uint32_t done = 0; done < BENCH_FILE_SIZE; done += buf_size)
+	{
+		if (f.write(buf, buf_size) != buf_size)
+		{
+			f.close();
+			skip("seq_write", buf_size, "write_failed");
+			return false;
+		}
+	}
+	f.close();
+	int64_t us = esp_timer_get_time() - t0;
+
+	report("seq_write", buf_size, BENCH_FILE_SIZE * 1000000.0f / 1024 / us, "KB/s");
+	return true;
+}
+
+/**
+ * 顺序读取整个测试文件
+ */
+void StorageBench::seqRead(const char* path, uint32_t chunk)
+{
+	if (chunk > buf_size)
+	{
+		skip("seq_read", chunk, "no_memory");
+		return;
+	}
+
+	File f = SD_FS.open(path);
+	if (!f)
+	{
+		skip("seq_read", chunk, "open_failed");
+		return;
+	}
+
+	uint32_t total = 0;
+	int64_t t0 = esp_timer_get_time();
+	while (total < BENCH_FILE_SIZE)
+	{
+		size_t n = f.read(buf, chunk);
+		if (n == 0) break;
+		total += n;
+	}
+	int64_t us = esp_timer_get_time() - t0;
+	f.close();
+
+	report("seq_read", chunk, total * 1000000.0f / 1024 / us, "KB/s");
+}
+
+/**
+ * 随机偏移读取（512字节对齐），报告单次平均延迟与吞吐
+ */
+void StorageBench::randomRead(const char* path, uint32_t chunk)
+{
+	if (chunk > buf_size || chunk >= BENCH_FILE_SIZE)
+	{
+		skip("rand_read", chunk, "no_memory");
+		return;
+	}
+
+	File f = SD_FS.open(path);
+	if (!f)
+	{
+		skip("rand_read", chunk, "open_failed");
+		return;
+	}
+
+	int64_t t0 = esp_timer_get_time();
+	for (uint16_t i = 0; i < BENCH_RANDOM_READS; i++)
+	{
+		uint32_t off = (esp_random() % (BENCH_FILE_SIZE - chunk)) & ~511u;
+		f.seek(off);
+		f.read(buf, chunk);
+	}
+	int64_t us = esp_timer_get_time() - t0;
+	f.close();
+
+	report("rand_read_lat", chunk, (float)us / BENCH_RANDOM_READS, "us");
+	report("rand_read", chunk, (float)chunk * BENCH_RANDOM_READS * 1000000.0f / 1024 / us, "KB/s");
+}
+
+/**
+ * 文件打开延迟与目录规模
+ * 每轮在目录中补足到n个文件，然后测量打开（并关闭）最后一个文件的平均耗时
+ */
+void StorageBench::openLatency()
+{
+	static const uint16_t sizes[] = BENCH_DIR_SIZES;
+	char dir[48];
+	char path[64];
+
+	snprintf(dir, sizeof(dir), "%s/dir", work_dir);
+	SD_FS.mkdir(dir);
+
+	uint16_t created = 0;
+	for (uint8_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+	{
+		for (; created < sizes[s]; created++)
+		{
+			snprintf(path, sizeof(path), "%s/f%04u.txt", dir, created);
+			File f = SD_FS.open(path, FILE_WRITE);
+			if (!f) break;
+			f.write('x');
+			f.close();
+		}
+		if (created < sizes[s])
+		{
+			skip("open_lat", sizes[s], "create_failed");
+			break;
+		}
+
+		snprintf(path, sizeof(path), "%s/f%04u.txt", dir, created - 1);
+		int64_t t0 = esp_timer_get_time();
+		for (uint8_t i = 0; i < 16; i++)
+		{
+			File f = SD_FS.open(path);
+			f.close();
+		}
+		report("open_lat", sizes[s], (esp_timer_get_time() - t0) / 16.0f, "us");
+	}
+
+	for (uint16_t i = 0; i < created; i++)
+	{
+		snprintf(path, sizeof(path), "%s/f%04u.txt", dir, i);
+		SD_FS.remove(path);
+	}
+	SD_FS.rmdir(dir);
+}
+
+/**
+ * 通过LVGL文件系统接口（S:盘）顺序读取，与seq_read对比驱动层开销
+ */
+void StorageBench::lvFsRead(const char* path, uint32_t chunk)
+{
+	char lv_path[72];
+	snprintf(lv_path, sizeof(lv_path), "S:%s", path);
+
+	lv_fs_file_t f;
+	if (chunk > buf_size || lv_fs_open(&f, lv_path, LV_FS_MODE_RD) != LV_FS_RES_OK)
+	{
+		skip("lv_fs_read", chunk, "open_failed");
+		return;
+	}
+
+	uint32_t total = 0;
+	uint32_t br = 0;
+	int64_t t0 = esp_timer_get_time();
+	while (total < BENCH_FILE_SIZE)
+	{
+		if (lv_fs_read(&f, buf, chunk, &br) != LV_FS_RES_OK || br == 0) break;
+		total += br;
+	}
+	int64_t us = esp_timer_get_time() - t0;
+	lv_fs_close(&f);
+
+	report("lv_fs_read", chunk, total * 1000000.0f / 1024 / us, "KB/s");
+}
+
+/**
+ * 帧序列读取帧率：逐帧打开、整帧读取、关闭，与场景播放器的目录模式一致
+ */
+void StorageBench::frameRate(const char* scene_dir)
+{
+	char path[72];
+	uint32_t frames = 0;
+	uint32_t bytes = 0;
+	uint8_t* frame = NULL;
+	uint32_t frame_cap = 0;
+
+	int64_t t0 = esp_timer_get_time();
+	for (; frames < BENCH_MAX_FRAMES; frames++)
+	{
+		snprintf(path, sizeof(path), "%s/frame%03u.bin", scene_dir, frames);
+		File f = SD_FS.open(path);
+		if (!f) break;
+
+		uint32_t len = f.size();
+		if (len > frame_cap)
+		{
+			buf_free(frame);
+			frame = (uint8_t*)buf_alloc(BUF_BULK, len);
+			frame_cap = frame ? len : 0;
+		}
+		if (frame == NULL)
+		{
+			f.close();
+			break;
+		}
+		bytes += f.read(frame, len);
+		f.close();
+	}
+	int64_t us = esp_timer_get_time() - t0;
+	buf_free(frame);
+
+	if (frames == 0)
+	{
+		skip("frame_rate", 0, "no_frames");
+		return;
+	}
+	report("frame_rate", frames, frames * 1000000.0f / us, "fps");
+	report("frame_read", frames, bytes * 1000000.0f / 1024 / us, "KB/s");
+}
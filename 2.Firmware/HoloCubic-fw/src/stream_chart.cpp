@@ -0,0 +1,248 @@
+/*
+ * HoloCubic 实时曲线图控件
+ *
+ * 功能说明：
+ * 1. 像素环：第c列保存环中第c个采样的整列像素（背景、网格与各曲线的竖线段），最旧的一列由head指出
+ * 2. push只重画head一列并使控件失效；绘制回调按行分两段复制（[head, w)在左，[0, head)在右），
+ *    与Marquee的条带折回相同，显示效果为整体左移一列
+ * 3. 采样环保存每条曲线的原始值，修改纵轴范围时据此按时间顺序重画全部列
+ *
+ * 数据流：
+ *   push --> samples[head] --> drawColumn(head) --> head++ --> lv_obj_invalidate --> designCb：按行复制
+ */
+
+#include "stream_chart.h"
+#include "buf_manager.h"
+#include "logger.h"
+
+static lv_signal_cb_t ancestor_signal = NULL;
+
+/**
+ * 控件的扩展数据：指回所属的StreamChart
+ */
+struct StreamChartExt
+{
+	StreamChart* owner;
+};
+
+StreamChart::StreamChart()
+{
+	obj = NULL;
+	strip = NULL;
+	samples = NULL;
+	w = h = 0;
+	head = 0;
+	filled = 0;
+	bg = LV_COLOR_BLACK;
+	grid = LV_COLOR_GRAY;
+	series_count = 0;
+	min_v = 0;
+	max_v = 1;
+}
+
+bool StreamChart::create(lv_obj_t* parent, lv_coord_t width, lv_coord_t height, uint8_t series,
+						 const lv_color_t* series_colors, int16_t min_value, int16_t max_value, lv_color_t bg_color,
+						 lv_color_t grid_color)
+{
+	if (obj || width <= 0 || height <= 1 || series == 0 || series > SCHART_SERIES_MAX) return false;
+
+	uint32_t px_size = (uint32_t)width * height * sizeof(lv_color_t);
+	uint32_t size = px_size + (uint32_t)series * width * sizeof(int16_t);
+	if (size > SCHART_MAX_BYTES || (strip = (lv_color_t*)buf_alloc(BUF_BULK, size)) == NULL)
+	{
+		LOG_W("chart", "曲线缓冲分配失败: %d x %d, %u字节", width, height, size);
+		return false;
+	}
+	samples = (int16_t*)((uint8_t*)strip + px_size);
+
+	obj = lv_obj_create(parent, NULL);
+	StreamChartExt* ext = obj ? (StreamChartExt*)lv_obj_allocate_ext_attr(obj, sizeof(StreamChartExt)) : NULL;
+	if (ext == NULL)
+	{
+		if (obj) lv_obj_del(obj);
+		obj = NULL;
+		buf_free(strip);
+		strip = NULL;
+		samples = NULL;
+		return false;
+	}
+	ext->owner = this;
+
+	if (ancestor_signal == NULL) ancestor_signal = lv_obj_get_signal_cb(obj);
+	lv_obj_set_design_cb(obj, designCb);
+	lv_obj_set_signal_cb(obj, signalCb);
+	lv_obj_set_click(obj, false);
+	lv_obj_set_size(obj, width, height);
+
+	w = width;
+	h = height;
+	series_count = series;
+	memcpy(colors, series_colors, series * sizeof(lv_color_t));
+	bg = bg_color;
+	grid = grid_color;
+	min_v = min_value;
+	max_v = max_value > min_value ? max_value : min_value + 1;
+	clear();
+	return true;
+}
+
+/**
+ * 删除控件，释放缓冲
+ */
+void StreamChart::destroy()
+{
+	// 删除时的CLEANUP信号调用detach
+	if (obj) lv_obj_del(obj);
+}
+
+lv_obj_t* StreamChart::getObj()
+{
+	return obj;
+}
+
+void StreamChart::push(const int16_t* values)
+{
+	if (strip == NULL) return;
+	for (uint8_t s = 0; s < series_count; s++) samples[(uint32_t)s * w + head] = values[s];
+	drawColumn(head, filled > 0);
+	head = head + 1 < w ? head + 1 : 0;
+	if (filled < w) filled++;
+	lv_obj_invalidate(obj);
+}
+
+void StreamChart::push(int16_t value)
+{
+	int16_t values[SCHART_SERIES_MAX];
+	for (uint8_t s = 0; s < SCHART_SERIES_MAX; s++) values[s] = value;
+	push(values);
+}
+
+void StreamChart::setRange(int16_t min_value, int16_t max_value)
+{
+	if (max_value <= min_value) max_value = min_value + 1;
+	if (min_value == min_v && max_value == max_v) return;
+	min_v = min_value;
+	max_v = max_value;
+	redraw();
+}
+
+void StreamChart::clear()
+{
+	if (strip == NULL) return;
+	head = 0;
+	filled = 0;
+	redraw();
+}
+
+int16_t StreamChart::getLast(uint8_t series)
+{
+	if (strip == NULL || filled == 0 || series >= series_count) return 0;
+	return samples[(uint32_t)series * w + (head > 0 ? head - 1 : w - 1)];
+}
+
+void StreamChart::detach()
+{
+	if (strip) buf_free(strip);
+	strip = NULL;
+	samples = NULL;
+	obj = NULL;
+}
+
+/**
+ * 采样值到控件内的行号（max_v在第0行，min_v在最后一行）
+ */
+lv_coord_t StreamChart::toY(int16_t v)
+{
+	if (v <= min_v) return h - 1;
+	if (v >= max_v) return 0;
+	return (lv_coord_t)((int32_t)(max_v - v) * (h - 1) / (max_v - min_v));
+}
+
+/**
+ * 重画一列：背景与网格，有采样时再画各曲线（connect为true时从上一列的值连线）
+ */
+void StreamChart::drawColumn(lv_coord_t col, bool connect)
+{
+	lv_color_t* p = strip + col;
+	for (lv_coord_t y = 0; y < h; y++) p[(uint32_t)y * w] = bg;
+	for (uint8_t k = 1; k <= SCHART_GRID_LINES; k++) p[(uint32_t)(k * (h - 1) / (SCHART_GRID_LINES + 1)) * w] = grid;
+
+	lv_coord_t prev = col > 0 ? col - 1 : w - 1;
+	for (uint8_t s = 0; s < series_count; s++)
+	{
+		const int16_t* v = samples + (uint32_t)s * w;
+		lv_coord_t y1 = toY(v[col]);
+		lv_coord_t y0 = connect ? toY(v[prev]) : y1;
+		lv_coord_t top = LV_MATH_MIN(y0, y1);
+		lv_coord_t bottom = LV_MATH_MAX(y0, y1);
+		for (lv_coord_t y = top; y <= bottom; y++) p[(uint32_t)y * w] = colors[s];
+	}
+}
+
+/**
+ * 按时间顺序重画全部列（清空、修改纵轴范围时）
+ */
+void StreamChart::redraw()
+{
+	if (strip == NULL) return;
+	lv_coord_t start = (head - filled + w) % w;
+	for (lv_coord_t i = 0; i < filled; i++) drawColumn((start + i) % w, i > 0);
+	// 没有采样的列只有背景与网格
+	uint8_t saved = series_count;
+	series_count = 0;
+	for (lv_coord_t i = filled; i < w; i++) drawColumn((start + i) % w, false);
+	series_count = saved;
+	lv_obj_invalidate(obj);
+}
+
+StreamChart* StreamChart::of(lv_obj_t* o)
+{
+	StreamChartExt* ext = (StreamChartExt*)lv_obj_get_ext_attr(o);
+	return ext ? ext->owner : NULL;
+}
+
+/**
+ * 绘制回调：每行分两段复制像素环，最旧的一列在左端
+ */
+lv_design_res_t StreamChart::designCb(lv_obj_t* o, const lv_area_t* clip, lv_design_mode_t mode)
+{
+	StreamChart* c = of(o);
+	if (mode == LV_DESIGN_COVER_CHK)
+	{
+		if (c && c->strip && _lv_area_is_in(clip, &o->coords, 0)) return LV_DESIGN_RES_COVER;
+		return LV_DESIGN_RES_NOT_COVER;
+	}
+	if (mode != LV_DESIGN_DRAW_MAIN || c == NULL || c->strip == NULL) return LV_DESIGN_RES_OK;
+
+	lv_area_t area;
+	if (!_lv_area_intersect(&area, clip, &o->coords)) return LV_DESIGN_RES_OK;
+	lv_opa_t opa = lv_obj_get_style_opa_scale(o, LV_OBJ_PART_MAIN);
+	if (opa < LV_OPA_MIN) return LV_DESIGN_RES_OK;
+
+	area.x2 = LV_MATH_MIN(area.x2, o->coords.x1 + c->w - 1);
+	area.y2 = LV_MATH_MIN(area.y2, o->coords.y1 + c->h - 1);
+	for (lv_coord_t y = area.y1; y <= area.y2; y++)
+	{
+		const lv_color_t* row = c->strip + (uint32_t)(y - o->coords.y1) * c->w;
+		lv_coord_t x = area.x1;
+		while (x <= area.x2)
+		{
+			lv_coord_t col = (x - o->coords.x1 + c->head) % c->w;
+			lv_coord_t n = LV_MATH_MIN(c->w - col, area.x2 - x + 1);
+			lv_area_t seg = { x, y, (lv_coord_t)(x + n - 1), y };
+			_lv_blend_map(&seg, &seg, row + col, NULL, LV_DRAW_MASK_RES_FULL_COVER, opa, LV_BLEND_MODE_NORMAL);
+			x += n;
+		}
+	}
+	return LV_DESIGN_RES_OK;
+}
+
+lv_res_t StreamChart::signalCb(lv_obj_t* o, lv_signal_t sign, void* param)
+{
+	if (sign == LV_SIGNAL_CLEANUP)
+	{
+		StreamChart* c = of(o);
+		if (c) c->detach();
+	}
+	return ancestor_signal(o, sign, param);
+}
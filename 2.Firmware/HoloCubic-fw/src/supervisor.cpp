@@ -0,0 +1,211 @@
+/*
+ * HoloCubic 任务监视模块
+ *
+ * 功能说明：
+ * 1. 记录各子系统每段工作的耗时（对数直方图、最大值），由遥测输出
+ * 2. 检测卡住的阶段（超时未结束或连续失败），输出日志并在所属任务中执行恢复动作
+ * 3. 任务彻底卡死时热重启，界面状态由resume_state恢复
+ *
+ * 注意事项：
+ * - enter/leave只写本阶段的字段，开销为两次millis()与一次临界区
+ * - 检查任务只读取时间戳并设置恢复请求，不直接操作总线或文件系统
+ */
+
+#include "supervisor.h"
+#include "logger.h"
+#include <esp_system.h>
+
+static portMUX_TYPE sup_mux = portMUX_INITIALIZER_UNLOCKED;
+
+Supervisor supervisor;
+
+Supervisor::Supervisor()
+{
+	memset(stages, 0, sizeof(stages));
+	stage_count = 0;
+	task = NULL;
+}
+
+bool Supervisor::begin()
+{
+	if (task) return true;
+	return xTaskCreatePinnedToCore(taskEntry, "supervisor", SUP_TASK_STACK, this,
+		SUP_TASK_PRIORITY, &task, SUP_TASK_CORE) == pdPASS;
+}
+
+int8_t Supervisor::add(const char* name, uint32_t stall_ms, sup_recover_t recover, void* user)
+{
+	portENTER_CRITICAL(&sup_mux);
+	uint8_t id = stage_count;
+	if (id >= SUP_MAX_STAGES)
+	{
+		portEXIT_CRITICAL(&sup_mux);
+		LOG_W("sup", "阶段已满，%s不受监视", name);
+		return -1;
+	}
+	Stage* s = &stages[id];
+	strlcpy(s->name, name, sizeof(s->name));
+	s->stall_ms = stall_ms;
+	s->recover = recover;
+	s->user = user;
+	s->backoff_ms = SUP_BACKOFF_MS;
+	stage_count = id + 1;
+	portEXIT_CRITICAL(&sup_mux);
+	return id;
+}
+
+/**
+ * 开始一段工作；有恢复请求且已过退避间隔时先执行恢复动作
+ */
+void Supervisor::enter(int8_t id)
+{
+	if (id < 0 || id >= stage_count) return;
+	Stage* s = &stages[id];
+	uint32_t now = millis();
+
+	if (s->pending && s->recover && (int32_t)(now - s->retry_ms) >= 0)
+	{
+		s->pending = false;
+		s->fail_run = 0;
+		bool ok = s->recover(s->user);
+		now = millis();
+		portENTER_CRITICAL(&sup_mux);
+		s->recoveries++;
+		portEXIT_CRITICAL(&sup_mux);
+		// 恢复后仍不正常时等待更久再试，正常完成一段工作后退避重置
+		s->retry_ms = now + s->backoff_ms;
+		if (s->backoff_ms < SUP_BACKOFF_MAX_MS) s->backoff_ms *= 2;
+		LOG_W("sup", "%s已执行恢复动作（%s），下次最早%u毫秒后", s->name, ok ? "成功" : "失败", s->retry_ms - now);
+	}
+
+	s->start_ms = now;
+	s->busy = true;
+}
+
+void Supervisor::leave(int8_t id, bool ok)
+{
+	if (id < 0 || id >= stage_count) return;
+	Stage* s = &stages[id];
+	if (!s->busy) return;
+	uint32_t ms = millis() - s->start_ms;
+	s->busy = false;
+
+	uint8_t b = bucket(ms);
+	portENTER_CRITICAL(&sup_mux);
+	s->count++;
+	if (ms > s->max_ms) s->max_ms = ms;
+	if (s->hist[b] < UINT16_MAX) s->hist[b]++;
+	if (!ok) s->fails++;
+	portEXIT_CRITICAL(&sup_mux);
+
+	if (s->stalled)
+	{
+		s->stalled = false;
+		LOG_W("sup", "%s停顿%u毫秒后恢复", s->name, ms);
+	}
+
+	if (!ok)
+	{
+		if (s->fail_run < UINT8_MAX) s->fail_run++;
+		if (s->fail_run == SUP_FAIL_LIMIT)
+		{
+			LOG_W("sup", "%s连续%u次失败", s->name, SUP_FAIL_LIMIT);
+			s->pending = s->recover != NULL;
+		}
+	}
+	else if (!s->pending)
+	{
+		s->fail_run = 0;
+		s->backoff_ms = SUP_BACKOFF_MS;
+	}
+}
+
+void Supervisor::requestRecover(int8_t id)
+{
+	if (id < 0 || id >= stage_count) return;
+	stages[id].pending = stages[id].recover != NULL;
+}
+
+/**
+ * 检查一个阶段是否超时：首次超过stall_ms时记录停顿并请求恢复
+ */
+void Supervisor::check(Stage* s, uint32_t now)
+{
+	if (!s->busy) return;
+	uint32_t start = s->start_ms;
+	// enter写入start_ms与busy之间被打断时可能读到旧值，以有符号差值排除
+	int32_t ms = (int32_t)(now - start);
+	if (ms < 0 || !s->busy) return;
+
+	if (!s->stalled && (uint32_t)ms >= s->stall_ms)
+	{
+		s->stalled = true;
+		s->pending = s->recover != NULL;
+		portENTER_CRITICAL(&sup_mux);
+		s->stalls++;
+		portEXIT_CRITICAL(&sup_mux);
+		LOG_W("sup", "%s已%u毫秒未完成", s->name, ms);
+	}
+#if SUP_REBOOT_MS
+	if (s->stalled && (uint32_t)ms >= SUP_REBOOT_MS)
+	{
+		LOG_E("sup", "%s卡死%u毫秒，热重启", s->name, ms);
+		// 给日志任务一点时间输出
+		vTaskDelay(pdMS_TO_TICKS(200));
+		esp_restart();
+	}
+#endif
+}
+
+uint8_t Supervisor::bucket(uint32_t ms)
+{
+	if (ms == 0) return 0;
+	uint8_t b = 32 - __builtin_clz(ms);
+	return b < SUP_HIST_BUCKETS ? b : SUP_HIST_BUCKETS - 1;
+}
+
+uint8_t Supervisor::collect(SupervisorStats* out, uint8_t max)
+{
+	uint8_t n = stage_count < max ? stage_count : max;
+	uint32_t now = millis();
+	for (uint8_t i = 0; i < n; i++)
+	{
+		Stage* s = &stages[i];
+		SupervisorStats* o = &out[i];
+		strlcpy(o->name, s->name, sizeof(o->name));
+
+		portENTER_CRITICAL(&sup_mux);
+		o->max_ms = s->max_ms;
+		o->count = s->count;
+		o->fails = s->fails;
+		o->stalls = s->stalls;
+		o->recoveries = s->recoveries;
+		memcpy(o->hist, s->hist, sizeof(o->hist));
+		s->max_ms = 0;
+		s->count = 0;
+		s->fails = 0;
+		memset(s->hist, 0, sizeof(s->hist));
+		portEXIT_CRITICAL(&sup_mux);
+
+		o->stalled = s->stalled;
+		if (s->busy)
+		{
+			int32_t ms = (int32_t)(now - s->start_ms);
+			if (ms > 0 && (uint32_t)ms > o->max_ms) o->max_ms = ms;
+		}
+	}
+	return n;
+}
+
+void Supervisor::taskEntry(void* arg)
+{
+	Supervisor* self = (Supervisor*)arg;
+	TickType_t last_wake = xTaskGetTickCount();
+
+	for (;;)
+	{
+		vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SUP_PERIOD_MS));
+		uint32_t now = millis();
+		for (uint8_t i = 0; i < self->stage_count; i++) self->check(&self->stages[i], now);
+	}
+}
@@ -0,0 +1,415 @@
+/*
+ * HoloCubic 运行时遥测模块
+ *
+ * 功能说明：
+ * 1. 后台任务定时采样：系统堆、LVGL分配器、各任务CPU占用与栈余量、
+ *    帧率与每帧刷新/SPI耗时、SD卡读写吞吐、场景播放的显示偏差与丢帧、IMU采样率与照度、WiFi RSSI、
+ *    各部件的估计电流（energy.h）
+ * 2. 采样结果以JSON输出：上传服务的GET /telemetry，或每次采样后UDP推送给监控端
+ * 3. 不向串口打印，串口输出本身会占用LVGL任务与传感器任务的时间
+ *
+ * JSON格式：
+ *   {"t":ms,"dt":ms,"heap":{"free","min","largest"},"lv":{"used","max","free","biggest","fail"},
+ *    "fps":x,"flush_us":x,"spi_us":x,"sd":{"rd":B/s,"wr":B/s},
+ *    "scene":{"n":帧数,"jit":us,"jmax":us,"drop":n,"rep":n,"rd_us":us,"rd_max":us,"depth":n},
+ *    "sensors":{"imu":样本/秒,"lux":lx},"rssi":dBm,
+ *    "power":{"ma":合计mA,"board","cpu","bl","wifi","sd","led":各部件mA,"uah":累计微安时,
+ *             "load":[核0,核1]千分比,"bl_duty","radio","sd_busy","led_lvl":千分比},
+ *    "tasks":[{"n":名称,"c":核,"p":优先级,"cpu":千分比,"stack":字节},...],
+ *    "slow":最慢的阶段,"stages":[{"n":名称,"cnt":次数,"max":ms,"fail":n,"stall":累计,"rec":累计,"stuck":0/1,
+ *                               "h":[<1ms,<2ms,<4ms,...,>=1024ms]},...]}
+ *
+ * 示例（PC端）：
+ *   curl http://<设备IP>/telemetry
+ *   nc -ul 9125                       （调用setUdpTarget之后）
+ *
+ * 注意事项：
+ * - 各任务CPU占用需要FreeRTOS运行时统计（CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS），
+ *   Arduino预编译的SDK默认未开启，此时cpu为-1，只输出栈余量
+ * - 帧率在不启用渲染计时时也可用；刷新/SPI耗时需要渲染计时（TELEMETRY_RENDER_PROF）
+ */
+
+#include "telemetry.h"
+#include "lv_port_mem.h"
+#include "runtime.h"
+#include "sensor_bus.h"
+#include <WiFi.h>
+#include <esp_heap_caps.h>
+
+Telemetry telemetry;
+
+// SD卡累计字节数，多个任务写入，用原子加
+static uint32_t sd_read_total = 0;
+static uint32_t sd_write_total = 0;
+
+void telemetry_sd_io(uint32_t read, uint32_t written)
+{
+	if (read) __atomic_fetch_add(&sd_read_total, read, __ATOMIC_RELAXED);
+	if (written) __atomic_fetch_add(&sd_write_total, written, __ATOMIC_RELAXED);
+}
+
+// 场景播放节奏，采样时取出并清零；最大值各只有一个写入方（LVGL任务/预读任务），清零时的竞争只影响一次采样
+static uint32_t scene_frames = 0;
+static uint32_t scene_jitter_sum = 0;
+static uint32_t scene_jitter_max = 0;
+static uint32_t scene_dropped = 0;
+static uint32_t scene_repeated = 0;
+static uint32_t scene_reads = 0;
+static uint32_t scene_read_sum = 0;
+static uint32_t scene_read_max = 0;
+static uint8_t scene_depth = 0;
+
+void telemetry_scene_frame(int32_t late_us, uint32_t dropped, uint32_t repeated)
+{
+	uint32_t jit = late_us < 0 ? -late_us : late_us;
+	__atomic_fetch_add(&scene_frames, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&scene_jitter_sum, jit, __ATOMIC_RELAXED);
+	if (jit > __atomic_load_n(&scene_jitter_max, __ATOMIC_RELAXED)) __atomic_store_n(&scene_jitter_max, jit, __ATOMIC_RELAXED);
+	if (dropped) __atomic_fetch_add(&scene_dropped, dropped, __ATOMIC_RELAXED);
+	if (repeated) __atomic_fetch_add(&scene_repeated, repeated, __ATOMIC_RELAXED);
+}
+
+void telemetry_scene_read(uint32_t read_us, uint8_t depth)
+{
+	__atomic_fetch_add(&scene_reads, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&scene_read_sum, read_us, __ATOMIC_RELAXED);
+	if (read_us > __atomic_load_n(&scene_read_max, __ATOMIC_RELAXED))
+		__atomic_store_n(&scene_read_max, read_us, __ATOMIC_RELAXED);
+	scene_depth = depth;
+}
+
+static uint32_t take(uint32_t* v)
+{
+	return __atomic_exchange_n(v, 0, __ATOMIC_RELAXED);
+}
+
+Telemetry::Telemetry()
+{
+	memset(&last, 0, sizeof(last));
+	mark_count = 0;
+	task = NULL;
+	lock = NULL;
+	udp_port = 0;
+	json = NULL;
+}
+
+/**
+ * 启动采样任务（可在setup中调用，不依赖网络）
+ */
+bool Telemetry::begin()
+{
+	if (task) return true;
+
+	if (lock == NULL) lock = xSemaphoreCreateMutex();
+	if (json == NULL) json = (char*)malloc(TELEMETRY_JSON_SIZE);
+	if (lock == NULL || json == NULL)
+	{
+		Serial.println("遥测缓冲区分配失败");
+		return false;
+	}
+
+#if TELEMETRY_RENDER_PROF
+	render_prof_enable(true);
+#endif
+
+	// 第一次采样只建立基准
+	mark_count = 0;
+	mark_total = 0;
+	mark_frames = render_prof_get_totals(mark_us);
+	mark_sd_read = __atomic_load_n(&sd_read_total, __ATOMIC_RELAXED);
+	mark_sd_write = __atomic_load_n(&sd_write_total, __ATOMIC_RELAXED);
+	mark_imu = sensorbus.getCount(SENSOR_IMU);
+	energy.reset();
+	take(&scene_frames);
+	take(&scene_jitter_sum);
+	take(&scene_jitter_max);
+	take(&scene_dropped);
+	take(&scene_repeated);
+	take(&scene_reads);
+	take(&scene_read_sum);
+	take(&scene_read_max);
+	mark_ms = millis();
+
+	if (xTaskCreatePinnedToCore(taskEntry, "telemetry", TELEMETRY_TASK_STACK, this,
+								TELEMETRY_TASK_PRIORITY, &task, TELEMETRY_TASK_CORE) != pdPASS)
+	{
+		task = NULL;
+		return false;
+	}
+	return true;
+}
+
+void Telemetry::end()
+{
+	if (task == NULL) return;
+	xSemaphoreTake(lock, portMAX_DELAY);
+	vTaskDelete(task);
+	task = NULL;
+	xSemaphoreGive(lock);
+	udp.stop();
+}
+
+bool Telemetry::isRunning()
+{
+	return task != NULL;
+}
+
+/**
+ * 设置UDP推送目标；port为0时停止推送
+ */
+void Telemetry::setUdpTarget(IPAddress ip, uint16_t port)
+{
+	if (lock) xSemaphoreTake(lock, portMAX_DELAY);
+	udp_ip = ip;
+	udp_port = port;
+	if (lock) xSemaphoreGive(lock);
+}
+
+/**
+ * 取最近一次采样
+ * @return 尚未完成第一次采样时返回false
+ */
+bool Telemetry::get(TelemetrySample* out)
+{
+	if (lock == NULL) return false;
+	xSemaphoreTake(lock, portMAX_DELAY);
+	*out = last;
+	xSemaphoreGive(lock);
+	return out->interval_ms != 0;
+}
+
+/**
+ * 采样任务
+ */
+void Telemetry::taskEntry(void* arg)
+{
+	Telemetry* self = (Telemetry*)arg;
+	TickType_t wake = xTaskGetTickCount();
+
+	while (true)
+	{
+		vTaskDelayUntil(&wake, pdMS_TO_TICKS(TELEMETRY_PERIOD_MS));
+
+		xSemaphoreTake(self->lock, portMAX_DELAY);
+		self->sample(&self->last);
+		if (self->udp_port && WiFi.isConnected())
+		{
+			size_t n = format(&self->last, self->json, TELEMETRY_JSON_SIZE);
+			if (self->udp.beginPacket(self->udp_ip, self->udp_port))
+			{
+				self->udp.write((const uint8_t*)self->json, n);
+				self->udp.endPacket();
+			}
+		}
+		xSemaphoreGive(self->lock);
+	}
+}
+
+/**
+ * 采样一次（持有lock），速率类数值为距上一次采样的平均值
+ */
+void Telemetry::sample(TelemetrySample* s)
+{
+	uint32_t now = millis();
+	uint32_t dt = now - mark_ms;
+	if (dt == 0) dt = 1;
+	s->time_ms = now;
+	s->interval_ms = dt;
+	mark_ms = now;
+
+	s->heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+	s->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+	s->heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+
+	// LVGL分配器只在LVGL任务中修改，读取时持有LVGL锁（最多等待一帧）
+	lv_port_mem_stats_t mem;
+	runtime.lock();
+	lv_port_mem_get_stats(&mem);
+	runtime.unlock();
+	s->lv_used = mem.used_size;
+	s->lv_max_used = mem.max_used;
+	s->lv_free = mem.heap_free;
+	s->lv_biggest = mem.heap_biggest;
+	s->lv_fail = mem.fail_cnt;
+
+	uint32_t us[RENDER_PROF_PHASE_CNT];
+	uint32_t frames = render_prof_get_totals(us);
+	uint32_t df = frames - mark_frames;
+	s->fps_x10 = (uint16_t)((uint64_t)df * 10000 / dt);
+	s->flush_us = df ? (us[RENDER_PROF_FLUSH] - mark_us[RENDER_PROF_FLUSH]) / df : 0;
+	s->spi_us = df ? (us[RENDER_PROF_SPI] - mark_us[RENDER_PROF_SPI]) / df : 0;
+	mark_frames = frames;
+	memcpy(mark_us, us, sizeof(us));
+
+	uint32_t rd = __atomic_load_n(&sd_read_total, __ATOMIC_RELAXED);
+	uint32_t wr = __atomic_load_n(&sd_write_total, __ATOMIC_RELAXED);
+	uint32_t sd_rd = rd - mark_sd_read;
+	uint32_t sd_wr = wr - mark_sd_write;
+	s->sd_read_bps = (uint32_t)((uint64_t)sd_rd * 1000 / dt);
+	s->sd_write_bps = (uint32_t)((uint64_t)sd_wr * 1000 / dt);
+	mark_sd_read = rd;
+	mark_sd_write = wr;
+
+	sampleScene(s);
+
+	// 只读传感器总线的快照，不触发读取
+	uint32_t imu_n = sensorbus.getCount(SENSOR_IMU);
+	s->imu_sps = (uint16_t)((uint64_t)(imu_n - mark_imu) * 1000 / dt);
+	mark_imu = imu_n;
+	SensorSample amb;
+	s->lux = sensorbus.get(SENSOR_AMBIENT, &amb) ? amb.lux_avg : 0;
+
+	s->rssi = WiFi.isConnected() ? (int8_t)WiFi.RSSI() : 0;
+
+	sampleTasks(s);
+	energy.sample(&s->energy, sd_rd, sd_wr, s->task, s->task_count);
+
+	s->stage_count = supervisor.collect(s->stage, SUP_MAX_STAGES);
+	s->stage_slowest = -1;
+	for (uint8_t i = 0; i < s->stage_count; i++)
+	{
+		if (s->stage[i].max_ms > 0 && (s->stage_slowest < 0 || s->stage[i].max_ms > s->stage[s->stage_slowest].max_ms))
+			s->stage_slowest = i;
+	}
+}
+
+/**
+ * 取出两次采样之间的场景播放节奏统计
+ */
+void Telemetry::sampleScene(TelemetrySample* s)
+{
+	uint32_t frames = take(&scene_frames);
+	uint32_t jitter = take(&scene_jitter_sum);
+	uint32_t reads = take(&scene_reads);
+	uint32_t read_sum = take(&scene_read_sum);
+	s->scene_frames = (uint16_t)(frames < 0xFFFF ? frames : 0xFFFF);
+	s->scene_jitter_us = frames ? jitter / frames : 0;
+	s->scene_jitter_max_us = take(&scene_jitter_max);
+	s->scene_dropped = (uint16_t)take(&scene_dropped);
+	s->scene_repeated = (uint16_t)take(&scene_repeated);
+	s->scene_read_us = reads ? read_sum / reads : 0;
+	s->scene_read_max_us = take(&scene_read_max);
+	s->scene_depth = reads ? scene_depth : 0;
+}
+
+/**
+ * 各任务状态；运行时统计的计数器按任务句柄与上一次采样对应求差
+ */
+void Telemetry::sampleTasks(TelemetrySample* s)
+{
+	s->task_count = 0;
+#if configUSE_TRACE_FACILITY
+	TaskStatus_t* st = (TaskStatus_t*)malloc(sizeof(TaskStatus_t) * TELEMETRY_MAX_TASKS);
+	if (st == NULL) return;
+
+	uint32_t total = 0;
+	// 任务数超过TELEMETRY_MAX_TASKS时uxTaskGetSystemState返回0
+	UBaseType_t n = uxTaskGetSystemState(st, TELEMETRY_MAX_TASKS, &total);
+#if configGENERATE_RUN_TIME_STATS
+	// 计数器按时钟累加，两个核的空闲任务合计约为2倍总时间
+	uint32_t span = (total - mark_total) * portNUM_PROCESSORS;
+	TaskMark next[TELEMETRY_MAX_TASKS];
+#endif
+
+	for (UBaseType_t i = 0; i < n; i++)
+	{
+		TelemetryTask* t = &s->task[i];
+		strlcpy(t->name, st[i].pcTaskName, sizeof(t->name));
+		t->priority = (uint8_t)st[i].uxCurrentPriority;
+#if configTASKLIST_INCLUDE_COREID
+		t->core = st[i].xCoreID < portNUM_PROCESSORS ? (uint8_t)st[i].xCoreID : 2;
+#else
+		t->core = 2;
+#endif
+		t->stack_free = st[i].usStackHighWaterMark * sizeof(StackType_t);
+		t->cpu_permille = -1;
+
+#if configGENERATE_RUN_TIME_STATS
+		next[i].handle = st[i].xHandle;
+		next[i].runtime = st[i].ulRunTimeCounter;
+		for (uint8_t j = 0; j < mark_count && mark_total; j++)
+		{
+			if (marks[j].handle != st[i].xHandle) continue;
+			uint32_t d = st[i].ulRunTimeCounter - marks[j].runtime;
+			t->cpu_permille = span ? (int16_t)((uint64_t)d * 1000 / span) : 0;
+			break;
+		}
+#endif
+	}
+	s->task_count = (uint8_t)n;
+
+#if configGENERATE_RUN_TIME_STATS
+	memcpy(marks, next, sizeof(TaskMark) * n);
+	mark_count = (uint8_t)n;
+	mark_total = total;
+#endif
+	free(st);
+#endif
+}
+
+/**
+ * 以JSON输出最近一次采样（可在任意任务中调用，如httpd任务）
+ * @return 写入的字节数，尚未采样时返回0
+ */
+size_t Telemetry::toJson(char* buf, size_t len)
+{
+	TelemetrySample s;
+	if (!get(&s)) return 0;
+	return format(&s, buf, len);
+}
+
+/**
+ * 格式化一次采样，缓冲区不足时截断到最后一个完整的任务
+ */
+size_t Telemetry::format(const TelemetrySample* s, char* buf, size_t len)
+{
+	int n = snprintf(buf, len,
+		"{\"t\":%u,\"dt\":%u,\"heap\":{\"free\":%u,\"min\":%u,\"largest\":%u},"
+		"\"lv\":{\"used\":%u,\"max\":%u,\"free\":%u,\"biggest\":%u,\"fail\":%u},"
+		"\"fps\":%u.%u,\"flush_us\":%u,\"spi_us\":%u,\"sd\":{\"rd\":%u,\"wr\":%u},"
+		"\"scene\":{\"n\":%u,\"jit\":%u,\"jmax\":%u,\"drop\":%u,\"rep\":%u,\"rd_us\":%u,\"rd_max\":%u,\"depth\":%u},"
+		"\"sensors\":{\"imu\":%u,\"lux\":%u},\"rssi\":%d,",
+		s->time_ms, s->interval_ms, s->heap_free, s->heap_min_free, s->heap_largest,
+		s->lv_used, s->lv_max_used, s->lv_free, s->lv_biggest, s->lv_fail,
+		s->fps_x10 / 10, s->fps_x10 % 10, s->flush_us, s->spi_us, s->sd_read_bps, s->sd_write_bps,
+		s->scene_frames, s->scene_jitter_us, s->scene_jitter_max_us, s->scene_dropped, s->scene_repeated,
+		s->scene_read_us, s->scene_read_max_us, s->scene_depth, s->imu_sps, s->lux, s->rssi);
+	if (n < 0 || (size_t)n >= len) return 0;
+	int m = EnergyMeter::format(&s->energy, buf + n, len - n);
+	if (m < 0) return 0;
+	n += m;
+	m = snprintf(buf + n, len - n, ",\"tasks\":[");
+	if (m < 0 || (size_t)(n + m) >= len) return 0;
+	n += m;
+
+	for (uint8_t i = 0; i < s->task_count; i++)
+	{
+		const TelemetryTask* t = &s->task[i];
+		int m = snprintf(buf + n, len - n, "%s{\"n\":\"%s\",\"c\":%u,\"p\":%u,\"cpu\":%d,\"stack\":%u}",
+			i ? "," : "", t->name, t->core, t->priority, t->cpu_permille, t->stack_free);
+		if (m < 0 || (size_t)(n + m) >= len - 2) break;
+		n += m;
+	}
+
+	m = snprintf(buf + n, len - n, "],\"slow\":\"%s\",\"stages\":[",
+		s->stage_slowest >= 0 ? s->stage[s->stage_slowest].name : "");
+	if (m < 0 || (size_t)(n + m) >= len - 2) return 0;
+	n += m;
+	for (uint8_t i = 0; i < s->stage_count; i++)
+	{
+		const SupervisorStats* st = &s->stage[i];
+		char hist[SUP_HIST_BUCKETS * 6];
+		int h = 0;
+		for (uint8_t b = 0; b < SUP_HIST_BUCKETS; b++)
+			h += snprintf(hist + h, sizeof(hist) - h, "%s%u", b ? "," : "", st->hist[b]);
+		m = snprintf(buf + n, len - n, "%s{\"n\":\"%s\",\"cnt\":%u,\"max\":%u,\"fail\":%u,\"stall\":%u,\"rec\":%u,"
+			"\"stuck\":%u,\"h\":[%s]}",
+			i ? "," : "", st->name, st->count, st->max_ms, st->fails, st->stalls, st->recoveries, st->stalled, hist);
+		if (m < 0 || (size_t)(n + m) >= len - 2) break;
+		n += m;
+	}
+	buf[n++] = ']';
+	buf[n++] = '}';
+	buf[n] = '\0';
+	return n;
+}
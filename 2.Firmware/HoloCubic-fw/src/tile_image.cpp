@@ -0,0 +1,547 @@
+/*
+ * HoloCubic 分块大图
+ *
+ * 功能说明：
+ * 1. TileImage：按需读取.htl的索引条目与分块数据，解码为RGB565（RAW/Q565/JPEG）
+ * 2. TileViewer：视口缓冲 + LRU分块缓存，平移时只为新露出的条带解码分块，缩放在金字塔各级之间切换
+ * 3. 倾斜平移：定时器读取传感器总线的IMU快照，按相对进入时姿态的倾斜量移动视口
+ *
+ * 平移过程：
+ *   新位置 --> 视口缓冲中仍可见的部分整体移动（memmove） --> 新露出的行/列条带
+ *   --> 与条带相交的分块（缓存命中直接复制，否则读取并解码一块） --> 重绘图像对象
+ *
+ * 注意事项：
+ * - 内存只有视口缓冲（可由调用方提供，如相册的完整图像缓冲）、分块缓存与一块的读缓冲，与图像大小无关
+ * - 视口缓冲与分块缓存均为lv_color_t布局，面板字节序（LV_COLOR_16_SWAP）在解码时转换
+ */
+
+#include "tile_image.h"
+#include "q565_decoder.h"
+#include "buf_manager.h"
+#include "sd_card.h"
+#include "sensor_bus.h"
+#include "telemetry.h"
+#include "logger.h"
+#include <src/lv_gpu/lv_gpu_esp32.h>  // 面板字节序时的交换复制
+
+/**** TileImage ****/
+
+TileImage::TileImage()
+{
+	memset(&hdr, 0, sizeof(hdr));
+	memset(level_base, 0, sizeof(level_base));
+	rd_buf = NULL;
+	jpeg_out = NULL;
+}
+
+TileImage::~TileImage()
+{
+	close();
+}
+
+/**
+ * 检查文件头：标识、版本、分块尺寸与级数在读取端的上限以内
+ */
+static bool validHeader(const TileHeader* h)
+{
+	return memcmp(h->magic, TILE_MAGIC, 4) == 0 && h->version >= 1 && h->version <= TILE_VERSION &&
+		   h->header_size >= sizeof(TileHeader) && h->width && h->height &&
+		   h->tile_w && h->tile_w <= TILE_SIZE_MAX && h->tile_h && h->tile_h <= TILE_SIZE_MAX &&
+		   h->levels && h->levels <= TILE_LEVELS_MAX && h->entry_size >= TILE_ENTRY_SIZE_MIN &&
+		   h->max_tile_size;
+}
+
+bool TileImage::probe(File& f, uint16_t* w, uint16_t* h, uint8_t* levels)
+{
+	TileHeader th;
+	if (f.read((uint8_t*)&th, sizeof(th)) != sizeof(th) || !validHeader(&th)) return false;
+	*w = th.width;
+	*h = th.height;
+	*levels = th.levels;
+	return true;
+}
+
+bool TileImage::open(const char* path)
+{
+	close();
+	file = SD_FS.open(path);
+	if (!file) return false;
+	if (file.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || !validHeader(&hdr))
+	{
+		LOG_W("tile", "%s不是有效的分块图像", path);
+		close();
+		return false;
+	}
+
+	uint32_t n = 0;
+	for (uint8_t l = 0; l < hdr.levels; l++)
+	{
+		level_base[l] = n;
+		n += (uint32_t)getCols(l) * getRows(l);
+	}
+	// 最大一块不超过两倍原始大小（JPEG/Q565的最坏情况），防止损坏的文件头申请过大的缓冲
+	uint32_t raw = (uint32_t)hdr.tile_w * hdr.tile_h * sizeof(uint16_t);
+	if (n != hdr.tile_count || hdr.max_tile_size > raw * 2)
+	{
+		LOG_W("tile", "%s索引不完整: %u/%u块", path, hdr.tile_count, n);
+		close();
+		return false;
+	}
+	rd_buf = (uint8_t*)buf_alloc(BUF_DMA, hdr.max_tile_size);
+	if (rd_buf == NULL)
+	{
+		LOG_E("tile", "读缓冲分配失败: %u字节", hdr.max_tile_size);
+		close();
+		return false;
+	}
+	return true;
+}
+
+void TileImage::close()
+{
+	if (file) file.close();
+	buf_free(rd_buf);
+	rd_buf = NULL;
+	jpeg.release();
+	memset(&hdr, 0, sizeof(hdr));
+}
+
+bool TileImage::isOpen()
+{
+	return rd_buf != NULL;
+}
+
+uint8_t TileImage::getLevels()
+{
+	return hdr.levels;
+}
+
+uint16_t TileImage::getTileW()
+{
+	return hdr.tile_w;
+}
+
+uint16_t TileImage::getTileH()
+{
+	return hdr.tile_h;
+}
+
+uint16_t TileImage::getWidth(uint8_t level)
+{
+	uint16_t w = hdr.width >> level;
+	return w ? w : 1;
+}
+
+uint16_t TileImage::getHeight(uint8_t level)
+{
+	uint16_t h = hdr.height >> level;
+	return h ? h : 1;
+}
+
+uint16_t TileImage::getCols(uint8_t level)
+{
+	return (getWidth(level) + hdr.tile_w - 1) / hdr.tile_w;
+}
+
+uint16_t TileImage::getRows(uint8_t level)
+{
+	return (getHeight(level) + hdr.tile_h - 1) / hdr.tile_h;
+}
+
+/**
+ * 读取索引条目与分块数据，按编码解码
+ */
+bool TileImage::decodeTile(uint8_t level, uint16_t col, uint16_t row, lv_color_t* out)
+{
+	if (!isOpen() || level >= hdr.levels || col >= getCols(level) || row >= getRows(level)) return false;
+
+	TileEntry e;
+	memset(&e, 0, sizeof(e));
+	uint32_t idx = level_base[level] + (uint32_t)row * getCols(level) + col;
+	if (!file.seek(hdr.index_offset + idx * hdr.entry_size) ||
+		file.read((uint8_t*)&e, TILE_ENTRY_SIZE_MIN) != TILE_ENTRY_SIZE_MIN) return false;
+	if (e.size == 0 || e.size > hdr.max_tile_size) return false;
+	if (!file.seek(e.offset) || file.read(rd_buf, e.size) != e.size) return false;
+	telemetry_sd_io(e.size + TILE_ENTRY_SIZE_MIN, 0);
+
+	uint32_t px = (uint32_t)hdr.tile_w * hdr.tile_h;
+	switch (e.codec)
+	{
+	case TILE_CODEC_RAW:
+		if (e.size != px * sizeof(uint16_t)) return false;
+#if LV_COLOR_16_SWAP
+		lv_gpu_esp32_copy_swap(out, hdr.tile_w, (const lv_color_t*)rd_buf, hdr.tile_w, hdr.tile_w, hdr.tile_h);
+#else
+		memcpy(out, rd_buf, e.size);
+#endif
+		return true;
+	case TILE_CODEC_Q565:
+	{
+		Q565State st;
+		return q565_begin(&st, rd_buf, e.size) && q565_decode(&st, out, px) == px;
+	}
+	case TILE_CODEC_JPEG:
+		if (!jpeg.open(rd_buf, e.size) || jpeg.getWidth() != hdr.tile_w || jpeg.getHeight() != hdr.tile_h)
+			return false;
+		jpeg_out = out;
+		return jpeg.decode(jpegBand, this, 0);
+	default:
+		return false;
+	}
+}
+
+bool TileImage::jpegBand(void* user, uint16_t y, uint16_t w, uint16_t h, const uint16_t* px)
+{
+	TileImage* self = (TileImage*)user;
+	if (y >= self->hdr.tile_h) return true;
+	uint16_t rows = LV_MATH_MIN(h, self->hdr.tile_h - y);
+	lv_color_t* dst = self->jpeg_out + (uint32_t)y * self->hdr.tile_w;
+#if LV_COLOR_16_SWAP
+	lv_gpu_esp32_copy_swap(dst, self->hdr.tile_w, (const lv_color_t*)px, w, self->hdr.tile_w, rows);
+#else
+	for (uint16_t r = 0; r < rows; r++)
+	{
+		memcpy(dst + (uint32_t)r * self->hdr.tile_w, px + (uint32_t)r * w, self->hdr.tile_w * sizeof(uint16_t));
+	}
+#endif
+	return true;
+}
+
+/**
+ * 逐块解码一级并抽样：dst(x, y) = 第level级(x * step, y * step)
+ * 与dst不相交的分块不读取
+ */
+bool TileImage::renderLevel(uint8_t level, lv_color_t* dst, uint16_t dst_w, uint16_t dst_h, uint8_t step,
+							lv_color_t* tile, tile_abort_cb_t abort_cb, void* user)
+{
+	if (!isOpen() || level >= hdr.levels || step == 0) return false;
+	uint16_t lw = getWidth(level);
+	uint16_t lh = getHeight(level);
+	uint32_t need_w = LV_MATH_MIN((uint32_t)dst_w * step, lw);
+	uint32_t need_h = LV_MATH_MIN((uint32_t)dst_h * step, lh);
+
+	for (uint16_t row = 0; (uint32_t)row * hdr.tile_h < need_h; row++)
+	{
+		for (uint16_t col = 0; (uint32_t)col * hdr.tile_w < need_w; col++)
+		{
+			if (abort_cb && abort_cb(user)) return false;
+			if (!decodeTile(level, col, row, tile)) return false;
+
+			uint32_t tx = (uint32_t)col * hdr.tile_w;
+			uint32_t ty = (uint32_t)row * hdr.tile_h;
+			for (uint16_t y = 0; y < hdr.tile_h; y++)
+			{
+				uint32_t gy = ty + y;
+				if (gy >= need_h) break;
+				if (gy % step) continue;
+				lv_color_t* out = dst + gy / step * dst_w;
+				const lv_color_t* in = tile + (uint32_t)y * hdr.tile_w;
+				// 第一个落在抽样网格上的列
+				uint16_t x = (step - tx % step) % step;
+				for (; x < hdr.tile_w && tx + x < need_w; x += step) out[(tx + x) / step] = in[x];
+			}
+		}
+	}
+	return true;
+}
+
+/**** TileViewer ****/
+
+TileViewer::TileViewer()
+{
+	img = NULL;
+	memset(&dsc, 0, sizeof(dsc));
+	view = NULL;
+	own_view = false;
+	vw = vh = 0;
+	level = 0;
+	vx = vy = 0;
+	memset(slots, 0, sizeof(slots));
+	slot_count = 0;
+	stamp = 0;
+	decoded = 0;
+	hits = 0;
+	task = NULL;
+	base_ax = base_ay = 0;
+}
+
+/**
+ * 打开大图：分配视口与分块缓存（分块缓存按可分配的内存取MIN~MAX块），视口居中
+ */
+bool TileViewer::open(const char* path, lv_obj_t* parent, uint8_t first_level, lv_color_t* buf, uint32_t buf_size)
+{
+	close();
+	if (!image.open(path)) return false;
+
+	uint32_t need = (uint32_t)LV_HOR_RES_MAX * LV_VER_RES_MAX * sizeof(lv_color_t);
+	own_view = buf == NULL || buf_size < need;
+	view = own_view ? (lv_color_t*)buf_alloc(BUF_BULK, need) : buf;
+	uint32_t tile_size = (uint32_t)image.getTileW() * image.getTileH() * sizeof(lv_color_t);
+	slot_count = 0;
+	for (uint8_t i = 0; view && i < TILE_VIEW_CACHE_MAX; i++)
+	{
+		slots[i].buf = (lv_color_t*)buf_alloc(BUF_BULK, tile_size);
+		slots[i].valid = false;
+		if (slots[i].buf == NULL) break;
+		slot_count++;
+	}
+	if (view == NULL || slot_count < TILE_VIEW_CACHE_MIN)
+	{
+		LOG_E("tile", "查看器内存不足: 视口%s，分块缓存%u/%u块", view ? "已分配" : "失败",
+			  slot_count, TILE_VIEW_CACHE_MIN);
+		close();
+		return false;
+	}
+
+	img = lv_img_create(parent, NULL);
+	lv_obj_set_click(img, false);
+	level = first_level < image.getLevels() ? first_level : image.getLevels() - 1;
+	vw = LV_MATH_MIN(LV_HOR_RES_MAX, image.getWidth(level));
+	vh = LV_MATH_MIN(LV_VER_RES_MAX, image.getHeight(level));
+	vx = (image.getWidth(level) - vw) / 2;
+	vy = (image.getHeight(level) - vh) / 2;
+	decoded = 0;
+	hits = 0;
+	layout();
+	LOG_D("tile", "打开%s: 第%u级 %ux%u，分块缓存%u块", path, level, image.getWidth(level),
+		  image.getHeight(level), slot_count);
+	return true;
+}
+
+/**
+ * 关闭查看器（父对象删除之前调用）
+ */
+void TileViewer::close()
+{
+	setTilt(false);
+	if (img)
+	{
+		lv_img_cache_invalidate_src(&dsc);
+		lv_obj_del(img);
+		img = NULL;
+	}
+	for (uint8_t i = 0; i < TILE_VIEW_CACHE_MAX; i++)
+	{
+		buf_free(slots[i].buf);
+		slots[i].buf = NULL;
+		slots[i].valid = false;
+	}
+	slot_count = 0;
+	if (own_view) buf_free(view);
+	view = NULL;
+	own_view = false;
+	image.close();
+}
+
+bool TileViewer::isOpen()
+{
+	return img != NULL;
+}
+
+uint8_t TileViewer::getLevel()
+{
+	return level;
+}
+
+uint8_t TileViewer::getLevels()
+{
+	return image.getLevels();
+}
+
+void TileViewer::getStats(uint32_t* decodes, uint32_t* cache_hits)
+{
+	if (decodes) *decodes = decoded;
+	if (cache_hits) *cache_hits = hits;
+}
+
+void TileViewer::clampOrigin()
+{
+	int32_t max_x = image.getWidth(level) - vw;
+	int32_t max_y = image.getHeight(level) - vh;
+	vx = LV_MATH_MAX(0, LV_MATH_MIN(vx, max_x));
+	vy = LV_MATH_MAX(0, LV_MATH_MIN(vy, max_y));
+}
+
+/**
+ * 视口尺寸变化后重设图像描述并重画整个视口
+ */
+void TileViewer::layout()
+{
+	clampOrigin();
+	lv_img_cache_invalidate_src(&dsc);
+	memset(&dsc, 0, sizeof(dsc));
+	dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+	dsc.header.w = vw;
+	dsc.header.h = vh;
+	dsc.data_size = (uint32_t)vw * vh * sizeof(lv_color_t);
+	dsc.data = (const uint8_t*)view;
+	render(0, 0, vw, vh);
+	lv_img_set_src(img, &dsc);
+	lv_obj_align(img, NULL, LV_ALIGN_CENTER, 0, 0);
+	lv_obj_invalidate(img);
+}
+
+bool TileViewer::setLevel(uint8_t new_level)
+{
+	if (!isOpen() || new_level >= image.getLevels()) return false;
+	if (new_level == level) return true;
+
+	// 视口中心换算到原图坐标，再换算到新的一级
+	int32_t cx = ((vx + vw / 2) << level) >> new_level;
+	int32_t cy = ((vy + vh / 2) << level) >> new_level;
+	level = new_level;
+	vw = LV_MATH_MIN(LV_HOR_RES_MAX, image.getWidth(level));
+	vh = LV_MATH_MIN(LV_VER_RES_MAX, image.getHeight(level));
+	vx = cx - vw / 2;
+	vy = cy - vh / 2;
+	layout();
+	return true;
+}
+
+/**
+ * 取一块：先查缓存，未命中时解码到最久未用的槽位
+ * @return 解码失败时返回NULL（该块按黑色绘制）
+ */
+lv_color_t* TileViewer::getTile(uint16_t col, uint16_t row)
+{
+	Slot* victim = NULL;
+	for (uint8_t i = 0; i < slot_count; i++)
+	{
+		Slot* s = &slots[i];
+		if (s->valid && s->level == level && s->col == col && s->row == row)
+		{
+			s->stamp = ++stamp;
+			hits++;
+			return s->buf;
+		}
+		if (victim == NULL || !s->valid || (victim->valid && (int32_t)(s->stamp - victim->stamp) < 0)) victim = s;
+	}
+
+	victim->valid = image.decodeTile(level, col, row, victim->buf);
+	if (!victim->valid) return NULL;
+	victim->level = level;
+	victim->col = col;
+	victim->row = row;
+	victim->stamp = ++stamp;
+	decoded++;
+	return victim->buf;
+}
+
+/**
+ * 重画视口中的矩形[x0, x1) x [y0, y1)（视口坐标）
+ */
+void TileViewer::render(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+{
+	if (x0 >= x1 || y0 >= y1) return;
+	uint16_t tw = image.getTileW();
+	uint16_t th = image.getTileH();
+	int32_t gx0 = vx + x0, gx1 = vx + x1;
+	int32_t gy0 = vy + y0, gy1 = vy + y1;
+
+	for (int32_t row = gy0 / th; row * th < gy1; row++)
+	{
+		for (int32_t col = gx0 / tw; col * tw < gx1; col++)
+		{
+			const lv_color_t* t = getTile(col, row);
+			int32_t tx = col * tw, ty = row * th;
+			int32_t ix0 = LV_MATH_MAX(gx0, tx), ix1 = LV_MATH_MIN(gx1, tx + tw);
+			int32_t iy0 = LV_MATH_MAX(gy0, ty), iy1 = LV_MATH_MIN(gy1, ty + th);
+			uint32_t bytes = (ix1 - ix0) * sizeof(lv_color_t);
+			for (int32_t gy = iy0; gy < iy1; gy++)
+			{
+				lv_color_t* dst = view + (gy - vy) * vw + (ix0 - vx);
+				if (t) memcpy(dst, t + (gy - ty) * tw + (ix0 - tx), bytes);
+				else memset(dst, 0, bytes);
+			}
+		}
+	}
+}
+
+/**
+ * 视口缓冲内容移动：新的(x, y)为原来的(x + dx, y + dy)
+ * 向下取用（dy > 0）时从上往下逐行复制，反之从下往上，源行不会先被覆盖
+ */
+void TileViewer::shift(int32_t dx, int32_t dy)
+{
+	int32_t n = vw - LV_MATH_ABS(dx);
+	int32_t rows = vh - LV_MATH_ABS(dy);
+	int32_t dst_x = dx < 0 ? -dx : 0;
+	int32_t src_x = dx > 0 ? dx : 0;
+	for (int32_t k = 0; k < rows; k++)
+	{
+		int32_t y = dy >= 0 ? k : vh - 1 - k;
+		memmove(view + y * vw + dst_x, view + (y + dy) * vw + src_x, n * sizeof(lv_color_t));
+	}
+}
+
+void TileViewer::panBy(int32_t dx, int32_t dy)
+{
+	if (!isOpen()) return;
+	int32_t ox = vx, oy = vy;
+	vx += dx;
+	vy += dy;
+	clampOrigin();
+	dx = vx - ox;
+	dy = vy - oy;
+	if (dx == 0 && dy == 0) return;
+
+	if (LV_MATH_ABS(dx) >= vw || LV_MATH_ABS(dy) >= vh)
+	{
+		render(0, 0, vw, vh);
+	}
+	else
+	{
+		shift(dx, dy);
+		// 新露出的整行条带，再补上其余行中新露出的列条带
+		int32_t ry0 = dy > 0 ? vh - dy : 0;
+		int32_t ry1 = dy > 0 ? vh : -dy;
+		render(0, ry0, vw, ry1);
+		int32_t cy0 = dy > 0 ? 0 : -dy;
+		int32_t cy1 = dy > 0 ? vh - dy : vh;
+		if (dx > 0) render(vw - dx, cy0, vw, cy1);
+		else if (dx < 0) render(0, cy0, -dx, cy1);
+	}
+	lv_obj_invalidate(img);
+}
+
+/**
+ * 倾斜量（相对中性姿态）换算为本周期的位移：死区以外按TILE_VIEW_TILT_PER_PX线性增加
+ */
+int32_t TileViewer::tiltStep(int32_t over)
+{
+	int32_t a = LV_MATH_ABS(over) - TILE_VIEW_TILT_DEAD;
+	if (a <= 0) return 0;
+	int32_t v = LV_MATH_MIN(a / TILE_VIEW_TILT_PER_PX + 1, TILE_VIEW_PAN_MAX);
+	return over > 0 ? v : -v;
+}
+
+void TileViewer::setTilt(bool on)
+{
+	if (!on)
+	{
+		if (task) lv_task_del(task);
+		task = NULL;
+		return;
+	}
+	if (task || !isOpen()) return;
+	SensorSample s;
+	if (sensorbus.get(SENSOR_IMU, &s))
+	{
+		base_ax = s.accel[0];
+		base_ay = s.accel[1];
+	}
+	task = lv_task_create(taskCb, TILE_VIEW_PAN_MS, LV_TASK_PRIO_MID, this);
+}
+
+/**
+ * 倾斜平移：向左倾（AY增大）视口左移，向前倾（AX增大）视口下移
+ */
+void TileViewer::taskCb(lv_task_t* t)
+{
+	TileViewer* self = (TileViewer*)t->user_data;
+	SensorSample s;
+	if (!sensorbus.get(SENSOR_IMU, &s)) return;
+	int32_t dx = -tiltStep(s.accel[1] - self->base_ay);
+	int32_t dy = tiltStep(s.accel[0] - self->base_ax);
+	if (dx || dy) self->panBy(dx, dy);
+}
@@ -0,0 +1,366 @@
+/*
+ * HoloCubic 时间服务
+ *
+ * 功能说明：
+ * 1. 推算：epoch = 基准 + (esp_timer - 基准时刻) * (1 + 频偏)，频偏以Q32定点数保存
+ * 2. 校时：后台抓取的网络窗口中发送SNTP请求（RFC 4330客户端模式），服务器时间按往返时间的一半补偿；
+ *    与上次NTP校时相隔TIME_DRIFT_MIN_S以上时，把推算误差折算为频偏的修正量（取一半，抑制网络抖动）
+ * 3. RTC内存快照：epoch与RTC时钟（esp_clk_rtc_time）的对应关系，每TIME_RTC_SAVE_S刷新；
+ *    重启后按RTC时钟走过的时间推算，并设置系统时间
+ * 4. 当地时间：固定偏移TIME_TZ_OFFSET_S，当天的日期部分缓存，天内的时分秒由秒数换算
+ *
+ * 数据流：
+ *   begin --> restoreRtc --> rebase（TIME_SRC_RTC）
+ *   抓取任务 --> poll --> saveRtc
+ *           --> syncDue --> sync --> query（UDP） --> 频偏估计 --> rebase（TIME_SRC_NTP） --> settimeofday
+ *
+ * 注意事项：
+ * - 上电、掉电复位时RTC时钟清零，快照丢弃，等待第一次校时
+ * - RTC时钟为校准过的慢速时钟（约0.1%误差），只用于跨越重启的几秒到几十秒
+ */
+
+#include "time_service.h"
+#include "logger.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_rom_crc.h>
+#include <esp32/clk.h>
+#include <sys/time.h>
+
+// NTP时间戳（1900年起）与Unix时间的差
+#define NTP_UNIX_OFFSET 2208988800UL
+
+/**
+ * RTC内存中的快照（软件复位、看门狗、深度睡眠后保留，上电时内容随机）
+ */
+struct TimeRtc
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t size;
+	int64_t epoch_us;
+	uint64_t rtc_us;           // epoch_us对应的esp_clk_rtc_time()
+	int32_t drift_ppb;
+	uint32_t crc;
+};
+
+static RTC_NOINIT_ATTR TimeRtc rtc_time;
+
+TimeService timesvc;
+
+static uint32_t rtc_checksum(const TimeRtc* r)
+{
+	return esp_rom_crc32_le(0, (const uint8_t*)r, offsetof(TimeRtc, crc));
+}
+
+TimeService::TimeService()
+{
+	base_epoch_us = 0;
+	base_timer_us = 0;
+	drift_ppb = 0;
+	drift_q32 = 0;
+	mux = portMUX_INITIALIZER_UNLOCKED;
+	source = TIME_SRC_NONE;
+	last_ntp_timer_us = 0;
+	next_sync_ms = 0;
+	saved_ms = 0;
+	last_error_ms = 0;
+	last_rtt_ms = 0;
+	day_start = -1;
+	memset(&day_tm, 0, sizeof(day_tm));
+}
+
+void TimeService::begin()
+{
+	// POSIX TZ的符号与UTC偏移相反（东八区为"UTC-8"）
+	char tz[16];
+	int32_t off = TIME_TZ_OFFSET_S;
+	int32_t a = off < 0 ? -off : off;
+	snprintf(tz, sizeof(tz), "UTC%c%d:%02d", off >= 0 ? '-' : '+', a / 3600, a % 3600 / 60);
+	setenv("TZ", tz, 1);
+	tzset();
+
+	if (restoreRtc())
+	{
+		LOG_I("time", "重启前的时间已恢复: %ld（频偏%dppb）", (long)now(), drift_ppb);
+	}
+}
+
+/**
+ * 从RTC内存恢复：复位原因不保留RTC时钟、校验不符或RTC时钟倒退时放弃
+ */
+bool TimeService::restoreRtc()
+{
+	esp_reset_reason_t reason = esp_reset_reason();
+	if (reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT || reason == ESP_RST_UNKNOWN) return false;
+	if (rtc_time.magic != TIME_RTC_MAGIC || rtc_time.version != TIME_RTC_VERSION ||
+		rtc_time.size != sizeof(TimeRtc) || rtc_time.crc != rtc_checksum(&rtc_time))
+		return false;
+	uint64_t rtc = esp_clk_rtc_time();
+	if (rtc < rtc_time.rtc_us || rtc_time.epoch_us < (int64_t)TIME_VALID_EPOCH * 1000000) return false;
+
+	int64_t epoch = rtc_time.epoch_us + (int64_t)(rtc - rtc_time.rtc_us);
+	int32_t drift = constrain(rtc_time.drift_ppb, -TIME_DRIFT_MAX_PPB, TIME_DRIFT_MAX_PPB);
+	rebase(epoch, esp_timer_get_time(), drift);
+	source = TIME_SRC_RTC;
+
+	struct timeval tv = { (time_t)(epoch / 1000000), (suseconds_t)(epoch % 1000000) };
+	settimeofday(&tv, NULL);
+	saved_ms = millis();
+	return true;
+}
+
+void TimeService::saveRtc()
+{
+	if (source == TIME_SRC_NONE) return;
+	// 两个时钟尽量在同一时刻读取
+	uint64_t rtc = esp_clk_rtc_time();
+	int64_t epoch = epochAt(esp_timer_get_time());
+	rtc_time.magic = TIME_RTC_MAGIC;
+	rtc_time.version = TIME_RTC_VERSION;
+	rtc_time.size = sizeof(TimeRtc);
+	rtc_time.epoch_us = epoch;
+	rtc_time.rtc_us = rtc;
+	rtc_time.drift_ppb = drift_ppb;
+	rtc_time.crc = rtc_checksum(&rtc_time);
+	saved_ms = millis();
+}
+
+void TimeService::rebase(int64_t epoch_us, int64_t timer_us, int32_t drift)
+{
+	int64_t q = (int64_t)drift * 4294967296LL / 1000000000LL;
+	portENTER_CRITICAL(&mux);
+	base_epoch_us = epoch_us;
+	base_timer_us = timer_us;
+	drift_ppb = drift;
+	drift_q32 = q;
+	portEXIT_CRITICAL(&mux);
+}
+
+int64_t TimeService::epochAt(int64_t timer_us)
+{
+	portENTER_CRITICAL(&mux);
+	int64_t e = base_epoch_us;
+	int64_t t = base_timer_us;
+	int64_t q = drift_q32;
+	portEXIT_CRITICAL(&mux);
+	int64_t el = timer_us - t;
+	return e + el + ((el * q) >> 32);
+}
+
+int64_t TimeService::nowMs()
+{
+	if (source == TIME_SRC_NONE) return 0;
+	return epochAt(esp_timer_get_time()) / 1000;
+}
+
+time_t TimeService::now()
+{
+	if (source == TIME_SRC_NONE) return 0;
+	return (time_t)(epochAt(esp_timer_get_time()) / 1000000);
+}
+
+bool TimeService::isValid()
+{
+	return source != TIME_SRC_NONE;
+}
+
+TimeSource TimeService::getSource()
+{
+	return source;
+}
+
+/**
+ * 当地时间：与缓存的日期同一天时只填时分秒，否则gmtime_r一次并更新缓存
+ */
+bool TimeService::toLocal(time_t t, struct tm* out)
+{
+	if (t < TIME_VALID_EPOCH) return false;
+	time_t lt = t + TIME_TZ_OFFSET_S;
+	portENTER_CRITICAL(&mux);
+	time_t start = day_start;
+	bool hit = lt >= start && lt < start + 86400;
+	if (hit) *out = day_tm;
+	portEXIT_CRITICAL(&mux);
+	if (!hit)
+	{
+		start = lt - lt % 86400;
+		gmtime_r(&start, out);
+		portENTER_CRITICAL(&mux);
+		day_start = start;
+		day_tm = *out;
+		portEXIT_CRITICAL(&mux);
+	}
+	int32_t s = lt - start;
+	out->tm_hour = s / 3600;
+	out->tm_min = s / 60 % 60;
+	out->tm_sec = s % 60;
+	out->tm_isdst = 0;
+	return true;
+}
+
+bool TimeService::local(struct tm* out)
+{
+	return toLocal(now(), out);
+}
+
+const char* TimeService::format(TimeText* cache, const char* fmt)
+{
+	time_t t = now();
+	if (t == cache->sec) return cache->text;
+	struct tm tm;
+	if (!toLocal(t, &tm))
+	{
+		cache->text[0] = '\0';
+		cache->sec = 0;
+		return cache->text;
+	}
+	strftime(cache->text, sizeof(cache->text), fmt, &tm);
+	cache->sec = t;
+	return cache->text;
+}
+
+bool TimeService::syncDue()
+{
+	// 尚未校时的next_sync_ms为0（启动后立即到期），失败后为重试时间
+	return (int32_t)(millis() - next_sync_ms) >= 0;
+}
+
+uint32_t TimeService::msToSync()
+{
+	if (syncDue()) return 0;
+	return next_sync_ms - millis();
+}
+
+static int64_t ntp_to_us(const uint8_t* p)
+{
+	uint32_t sec = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+	uint32_t frac = ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 8) | p[7];
+	// 2036年之后NTP秒数回绕（第1纪元）
+	int64_t unix_s = sec >= NTP_UNIX_OFFSET ? (int64_t)(sec - NTP_UNIX_OFFSET) : (int64_t)sec + 4294967296LL - NTP_UNIX_OFFSET;
+	return unix_s * 1000000 + (int64_t)(((uint64_t)frac * 1000000) >> 32);
+}
+
+/**
+ * 一次SNTP请求：返回服务器在timer_us时刻的时间（补偿了单程延迟）
+ */
+bool TimeService::query(int64_t* server_us, int64_t* timer_us, uint16_t* rtt_ms)
+{
+	IPAddress ip;
+	if (!WiFi.hostByName(TIME_NTP_SERVER, ip)) return false;
+	int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) return false;
+	struct timeval tv = { TIME_NTP_TIMEOUT_MS / 1000, (TIME_NTP_TIMEOUT_MS % 1000) * 1000 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_port = htons(TIME_NTP_PORT);
+	to.sin_addr.s_addr = (uint32_t)ip;
+
+	// LI=0 VN=4 Mode=3；发送时间戳填本机计时（不是真实时间），应答的origin与之相同才采用
+	uint8_t pkt[48];
+	memset(pkt, 0, sizeof(pkt));
+	pkt[0] = 0x23;
+	int64_t t1 = esp_timer_get_time();
+	memcpy(pkt + 40, &t1, sizeof(t1));
+	uint8_t tag[8];
+	memcpy(tag, pkt + 40, sizeof(tag));
+
+	bool ok = false;
+	if (sendto(sock, pkt, sizeof(pkt), 0, (sockaddr*)&to, sizeof(to)) == (int)sizeof(pkt))
+	{
+		// 迟到的上一次应答等不符合的包最多跳过几个，之后按超时结束
+		for (uint8_t k = 0; k < 4; k++)
+		{
+			int n = recv(sock, pkt, sizeof(pkt), 0);
+			int64_t t4 = esp_timer_get_time();
+			if (n < 0) break;
+			if (n < 48 || (pkt[0] & 0x07) != 4 || pkt[1] == 0 || memcmp(pkt + 24, tag, sizeof(tag)) != 0) continue;
+			int64_t t2 = ntp_to_us(pkt + 32);
+			int64_t t3 = ntp_to_us(pkt + 40);
+			int64_t rtt = (t4 - t1) - (t3 - t2);
+			if (rtt < 0) rtt = 0;
+			*server_us = t3 + rtt / 2;
+			*timer_us = t4;
+			*rtt_ms = rtt / 1000 > 0xFFFF ? 0xFFFF : (uint16_t)(rtt / 1000);
+			ok = true;
+			break;
+		}
+	}
+	closesocket(sock);
+	return ok;
+}
+
+/**
+ * 校时：误差折算频偏，重设基准、系统时间与RTC快照
+ */
+bool TimeService::sync()
+{
+	int64_t server = 0, timer = 0;
+	uint16_t rtt = 0;
+	bool ok = false;
+	for (uint8_t i = 0; i < TIME_NTP_TRIES && !ok; i++)
+	{
+		ok = query(&server, &timer, &rtt) && rtt <= TIME_RTT_MAX_MS && server >= (int64_t)TIME_VALID_EPOCH * 1000000;
+	}
+	if (!ok)
+	{
+		next_sync_ms = millis() + TIME_RETRY_S * 1000UL;
+		LOG_W("time", "NTP校时失败，%u秒后重试", TIME_RETRY_S);
+		return false;
+	}
+
+	TimeSource prev = source;
+	int64_t err = prev == TIME_SRC_NONE ? 0 : server - epochAt(timer);
+	int32_t drift = drift_ppb;
+	int64_t span = timer - last_ntp_timer_us;
+	// 误差超过数秒时更可能是时间跳变（服务器或重启推算），不计入频偏
+	if (prev == TIME_SRC_NTP && last_ntp_timer_us && span >= (int64_t)TIME_DRIFT_MIN_S * 1000000 &&
+		err > -5000000 && err < 5000000)
+	{
+		int64_t meas = err * 1000000000LL / span;
+		drift = constrain(drift + meas / 2, (int64_t)-TIME_DRIFT_MAX_PPB, (int64_t)TIME_DRIFT_MAX_PPB);
+	}
+	rebase(server, timer, drift);
+	last_ntp_timer_us = timer;
+	source = TIME_SRC_NTP;
+	last_error_ms = constrain(err / 1000, -32768, 32767);
+	last_rtt_ms = rtt;
+	next_sync_ms = millis() + TIME_SYNC_INTERVAL_S * 1000UL;
+
+	int64_t e = epochAt(esp_timer_get_time());
+	struct timeval tv = { (time_t)(e / 1000000), (suseconds_t)(e % 1000000) };
+	settimeofday(&tv, NULL);
+	saveRtc();
+
+	if (prev == TIME_SRC_NONE)
+		LOG_I("time", "时钟已同步: %ld（millis=%u，往返%ums）", (long)tv.tv_sec, millis(), rtt);
+	else
+		LOG_I("time", "NTP校时: 误差%dms 往返%ums 频偏%dppb", last_error_ms, rtt, drift);
+	return true;
+}
+
+void TimeService::poll()
+{
+	if (source != TIME_SRC_NONE && millis() - saved_ms >= TIME_RTC_SAVE_S * 1000UL) saveRtc();
+}
+
+int32_t TimeService::getDriftPpb()
+{
+	return drift_ppb;
+}
+
+int16_t TimeService::getLastErrorMs()
+{
+	return last_error_ms;
+}
+
+uint16_t TimeService::getLastRttMs()
+{
+	return last_rtt_ms;
+}
@@ -0,0 +1,377 @@
+/*
+ * HoloCubic TLS客户端模块
+ *
+ * 功能说明：
+ * 1. 在WiFiClient的TCP连接上运行mbedtls，提供HTTPS
+ * 2. CA证书包从SD卡加载一次，之后所有连接共用
+ * 3. 按主机名缓存TLS会话，重复轮询同一API时恢复会话
+ *
+ * 与WiFiClientSecure的区别：后者每次connect都重新初始化mbedtls并完整握手，
+ * 且不提供会话复用接口
+ */
+
+#include "tls_client.h"
+#include "sd_card.h"
+
+// 所有连接共用的mbedtls状态
+static bool tls_inited;
+static mbedtls_entropy_context tls_entropy;
+static mbedtls_ctr_drbg_context tls_drbg;
+static mbedtls_ssl_config tls_conf;
+static mbedtls_x509_crt tls_ca;
+static bool tls_has_ca;
+
+// 会话缓存（所有TlsClient对象共用，连接只在网络任务中建立）
+struct TlsSessionSlot
+{
+	char host[48];
+	mbedtls_ssl_session session;
+	bool valid;
+	uint32_t used;
+};
+static TlsSessionSlot tls_sessions[TLS_SESSION_CACHE];
+
+static bool tlsInit()
+{
+	if (tls_inited) return true;
+
+	mbedtls_entropy_init(&tls_entropy);
+	mbedtls_ctr_drbg_init(&tls_drbg);
+	mbedtls_ssl_config_init(&tls_conf);
+	mbedtls_x509_crt_init(&tls_ca);
+	for (uint8_t i = 0; i < TLS_SESSION_CACHE; i++) mbedtls_ssl_session_init(&tls_sessions[i].session);
+
+	if (mbedtls_ctr_drbg_seed(&tls_drbg, mbedtls_entropy_func, &tls_entropy, NULL, 0) != 0) return false;
+	if (mbedtls_ssl_config_defaults(&tls_conf, MBEDTLS_SSL_IS_CLIENT,
+		MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) return false;
+
+	mbedtls_ssl_conf_rng(&tls_conf, mbedtls_ctr_drbg_random, &tls_drbg);
+	mbedtls_ssl_conf_authmode(&tls_conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+	mbedtls_ssl_conf_ca_chain(&tls_conf, &tls_ca, NULL);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	mbedtls_ssl_conf_session_tickets(&tls_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+	tls_inited = true;
+	return true;
+}
+
+/**
+ * 加载PEM格式的CA证书包（可多次调用追加）
+ *
+ * @param pem 证书文本，len包含结尾的'\0'
+ */
+bool TlsClient::loadCaBundle(const char* pem, size_t len)
+{
+	if (!tlsInit()) return false;
+
+	int ret = mbedtls_x509_crt_parse(&tls_ca, (const unsigned char*)pem, len);
+	// 返回值大于0表示部分证书无法解析，其余仍然可用
+	if (ret < 0)
+	{
+		Serial.printf("CA证书解析失败: -0x%04x\n", -ret);
+		return false;
+	}
+	tls_has_ca = true;
+	return true;
+}
+
+/**
+ * 从SD卡加载CA证书包
+ */
+bool TlsClient::loadCaFile(const char* path)
+{
+	File f = SD_FS.open(path);
+	if (!f) return false;
+
+	size_t len = f.size();
+	char* buf = (char*)malloc(len + 1);
+	if (buf == NULL)
+	{
+		f.close();
+		return false;
+	}
+	f.read((uint8_t*)buf, len);
+	f.close();
+	buf[len] = 0;
+
+	bool ok = loadCaBundle(buf, len + 1);
+	free(buf);
+	return ok;
+}
+
+bool TlsClient::hasCa()
+{
+	return tls_has_ca;
+}
+
+TlsClient::TlsClient()
+{
+	active = false;
+	peeked = -1;
+	host[0] = 0;
+	resumed = false;
+	resume_len = 0;
+}
+
+TlsClient::~TlsClient()
+{
+	stop();
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port)
+{
+	return connect(ip.toString().c_str(), port);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout)
+{
+	return connect(ip.toString().c_str(), port, timeout);
+}
+
+int TlsClient::connect(const char* host, uint16_t port)
+{
+	return connect(host, port, TLS_HANDSHAKE_TIMEOUT_MS);
+}
+
+/**
+ * 建立TCP连接并完成TLS握手
+ */
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeout)
+{
+	stop();
+	if (!tlsInit()) return 0;
+	if (!tls_has_ca)
+	{
+		Serial.println("未加载CA证书，拒绝建立HTTPS连接");
+		return 0;
+	}
+	if (!WiFiClient::connect(host, port, timeout)) return 0;
+
+	strlcpy(this->host, host, sizeof(this->host));
+	mbedtls_ssl_init(&ssl);
+	if (mbedtls_ssl_setup(&ssl, &tls_conf) != 0 || mbedtls_ssl_set_hostname(&ssl, host) != 0)
+	{
+		mbedtls_ssl_free(&ssl);
+		WiFiClient::stop();
+		return 0;
+	}
+	mbedtls_ssl_set_bio(&ssl, this, bioSend, bioRecv, NULL);
+	active = true;
+
+	resume_len = 0;
+	restoreSession();
+	if (!handshake())
+	{
+		stop();
+		return 0;
+	}
+	const mbedtls_ssl_session* cur = mbedtls_ssl_get_session_pointer(&ssl);
+	resumed = resume_len > 0 && cur && cur->id_len == resume_len && memcmp(cur->id, resume_id, resume_len) == 0;
+	saveSession();
+	return 1;
+}
+
+bool TlsClient::handshake()
+{
+	uint32_t start = millis();
+	int ret;
+	while ((ret = mbedtls_ssl_handshake(&ssl)) != 0)
+	{
+		if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+		{
+			Serial.printf("TLS握手失败(%s): -0x%04x\n", host, -ret);
+			// 恢复被拒绝后作废缓存，避免每次都带着旧会话重试
+			for (uint8_t i = 0; i < TLS_SESSION_CACHE; i++)
+				if (tls_sessions[i].valid && strcmp(tls_sessions[i].host, host) == 0) tls_sessions[i].valid = false;
+			return false;
+		}
+		if (millis() - start > TLS_HANDSHAKE_TIMEOUT_MS)
+		{
+			Serial.printf("TLS握手超时(%s)\n", host);
+			return false;
+		}
+		delay(1);
+	}
+	return true;
+}
+
+/**
+ * 握手前放入该主机上次的会话，服务器接受时走简化握手
+ */
+void TlsClient::restoreSession()
+{
+	for (uint8_t i = 0; i < TLS_SESSION_CACHE; i++)
+	{
+		TlsSessionSlot& s = tls_sessions[i];
+		if (s.valid && strcmp(s.host, host) == 0)
+		{
+			if (mbedtls_ssl_set_session(&ssl, &s.session) == 0)
+			{
+				resume_len = s.session.id_len;
+				memcpy(resume_id, s.session.id, resume_len);
+			}
+			s.used = millis();
+			return;
+		}
+	}
+}
+
+/**
+ * 握手成功后保存会话（同主机覆盖，缓存满时替换最久未用的一条）
+ */
+void TlsClient::saveSession()
+{
+	uint8_t slot = 0;
+	for (uint8_t i = 0; i < TLS_SESSION_CACHE; i++)
+	{
+		if (tls_sessions[i].valid && strcmp(tls_sessions[i].host, host) == 0)
+		{
+			slot = i;
+			break;
+		}
+		if (!tls_sessions[i].valid || tls_sessions[i].used < tls_sessions[slot].used) slot = i;
+	}
+
+	TlsSessionSlot& s = tls_sessions[slot];
+	mbedtls_ssl_session_free(&s.session);
+	mbedtls_ssl_session_init(&s.session);
+	s.valid = mbedtls_ssl_get_session(&ssl, &s.session) == 0;
+	strlcpy(s.host, host, sizeof(s.host));
+	s.used = millis();
+}
+
+/**
+ * 本次连接是否为恢复的会话（服务器接受复用时会回送同一个会话ID）
+ */
+bool TlsClient::isResumed()
+{
+	return active && resumed;
+}
+
+int TlsClient::bioSend(void* ctx, const unsigned char* buf, size_t len)
+{
+	TlsClient* self = (TlsClient*)ctx;
+	size_t n = self->WiFiClient::write(buf, len);
+	return n > 0 ? (int)n : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+/**
+ * 非阻塞接收：没有数据时返回WANT_READ，由上层决定等待还是返回
+ */
+int TlsClient::bioRecv(void* ctx, unsigned char* buf, size_t len)
+{
+	TlsClient* self = (TlsClient*)ctx;
+	if (self->WiFiClient::available() <= 0)
+		return self->WiFiClient::connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+
+	int n = self->WiFiClient::read(buf, len);
+	return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+size_t TlsClient::write(uint8_t data)
+{
+	return write(&data, 1);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size)
+{
+	if (!active) return 0;
+
+	size_t done = 0;
+	uint32_t start = millis();
+	while (done < size)
+	{
+		int ret = mbedtls_ssl_write(&ssl, buf + done, size - done);
+		if (ret > 0)
+		{
+			done += ret;
+			continue;
+		}
+		if ((ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) ||
+			millis() - start > TLS_HANDSHAKE_TIMEOUT_MS) break;
+		delay(1);
+	}
+	return done;
+}
+
+int TlsClient::available()
+{
+	if (!active) return 0;
+
+	int n = mbedtls_ssl_get_bytes_avail(&ssl);
+	if (n == 0)
+	{
+		// 处理已到达的记录，解密后的数据才计入可读字节
+		int ret = mbedtls_ssl_read(&ssl, NULL, 0);
+		if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+		{
+			if (peeked < 0) stop();
+			return peeked >= 0 ? 1 : 0;
+		}
+		n = mbedtls_ssl_get_bytes_avail(&ssl);
+	}
+	return n + (peeked >= 0 ? 1 : 0);
+}
+
+int TlsClient::read()
+{
+	uint8_t c;
+	return read(&c, 1) == 1 ? c : -1;
+}
+
+int TlsClient::read(uint8_t* buf, size_t size)
+{
+	if (size == 0) return 0;
+
+	int got = 0;
+	if (peeked >= 0)
+	{
+		buf[0] = peeked;
+		peeked = -1;
+		got = 1;
+		if (size == 1) return 1;
+	}
+	if (!active) return got ? got : -1;
+
+	int ret = mbedtls_ssl_read(&ssl, buf + got, size - got);
+	if (ret > 0) return got + ret;
+	if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) stop();
+	return got ? got : -1;
+}
+
+int TlsClient::peek()
+{
+	if (peeked < 0)
+	{
+		uint8_t c;
+		if (read(&c, 1) == 1) peeked = c;
+	}
+	return peeked;
+}
+
+void TlsClient::flush()
+{
+	// 丢弃未读数据，供HTTPClient复用连接前清空接收缓冲
+	uint8_t buf[64];
+	peeked = -1;
+	while (active && available() > 0) read(buf, sizeof(buf));
+}
+
+void TlsClient::stop()
+{
+	if (active)
+	{
+		mbedtls_ssl_close_notify(&ssl);
+		mbedtls_ssl_free(&ssl);
+		active = false;
+	}
+	peeked = -1;
+	WiFiClient::stop();
+}
+
+uint8_t TlsClient::connected()
+{
+	if (peeked >= 0 || (active && mbedtls_ssl_get_bytes_avail(&ssl) > 0)) return 1;
+	return active && WiFiClient::connected();
+}
@@ -0,0 +1,137 @@
+/**
+ * @file ui_builder.c
+ * @brief 由常量定义表创建界面
+ *
+ * 功能概述：
+ * 界面原先在setup_scr_*.c中逐个调用lv_*_create与lv_style_set_*创建，
+ * 每个static lv_style_t的属性表都在LVGL堆中分配，屏幕回收时再lv_style_reset释放。
+ * 现在界面描述（ui目录下的json）在构建时由scripts/ui_compile.py编译成ui_tables.c中的常量表：
+ * 样式是flash中的属性表（见UI_PROP），对象是按创建顺序排列的ui_obj_def_t。
+ * 这里只按表创建对象、引用样式、设置几何与控件参数，样式不占LVGL堆，
+ * 创建屏幕时也不再逐个属性查找/扩容样式表。
+ *
+ * 仅在LVGL任务中调用
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "ui_builder.h"
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+static lv_obj_t* create(const ui_obj_def_t* d, lv_obj_t* parent);
+static void setup(lv_obj_t* obj, const ui_obj_def_t* d, lv_obj_t* parent);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * 按定义表创建屏幕
+ *
+ * @param ctx GUI向导的lv_ui，对象指针写到各定义的slot偏移处
+ * @param def 屏幕定义，第0项为屏幕根对象
+ * @return 屏幕根对象；表无效或LVGL堆不足时返回NULL（已创建的部分被删除）
+ */
+lv_obj_t* ui_build(void* ctx, const ui_scr_def_t* def)
+{
+	lv_obj_t* objs[UI_BUILD_MAX];
+	uint8_t cnt = def->obj_cnt;
+	if(cnt == 0 || cnt > UI_BUILD_MAX || def->objs[0].parent != UI_NO_PARENT) return NULL;
+
+	uint8_t i;
+	for(i = 0; i < cnt; i++)
+	{
+		const ui_obj_def_t* d = &def->objs[i];
+		// 父对象必须在前面已创建
+		if(i > 0 && d->parent >= i) break;
+		lv_obj_t* parent = i > 0 ? objs[d->parent] : NULL;
+		objs[i] = create(d, parent);
+		if(objs[i] == NULL) break;
+		setup(objs[i], d, parent);
+	}
+	if(i < cnt)
+	{
+		LV_LOG_WARN("ui_build: failed to create object");
+		if(i > 0) lv_obj_del(objs[0]);
+		return NULL;
+	}
+
+	for(i = 0; i < cnt; i++)
+	{
+		const ui_obj_def_t* d = &def->objs[i];
+		if(d->slot != UI_NO_SLOT) *(lv_obj_t**)((uint8_t*)ctx + d->slot) = objs[i];
+	}
+	return objs[0];
+}
+
+/**
+ * 屏幕删除后清空子对象指针
+ */
+void ui_unbuild(void* ctx, const ui_scr_def_t* def)
+{
+	for(uint8_t i = 1; i < def->obj_cnt; i++)
+	{
+		const ui_obj_def_t* d = &def->objs[i];
+		if(d->slot != UI_NO_SLOT) *(lv_obj_t**)((uint8_t*)ctx + d->slot) = NULL;
+	}
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static lv_obj_t* create(const ui_obj_def_t* d, lv_obj_t* parent)
+{
+	switch(d->type)
+	{
+	case UI_OBJ_IMG: return lv_img_create(parent, NULL);
+	case UI_OBJ_LABEL: return lv_label_create(parent, NULL);
+#if LV_USE_CPICKER
+	case UI_OBJ_CPICKER: return lv_cpicker_create(parent, NULL);
+#endif
+	case UI_OBJ_BASE: return lv_obj_create(parent, NULL);
+	default: return NULL;
+	}
+}
+
+/**
+ * 样式、控件参数、尺寸、位置
+ * 控件参数（图像源、文字）先于尺寸与对齐设置，对齐按内容决定的尺寸计算
+ */
+static void setup(lv_obj_t* obj, const ui_obj_def_t* d, lv_obj_t* parent)
+{
+	// 常量样式只被引用，LVGL不会写入或释放非本地样式
+	for(uint8_t k = 0; k < d->style_cnt; k++)
+		lv_obj_add_style(obj, d->styles[k].part, (lv_style_t*)d->styles[k].style);
+
+	switch(d->type)
+	{
+	case UI_OBJ_IMG:
+		if(d->src) lv_img_set_src(obj, d->src);
+		break;
+	case UI_OBJ_LABEL:
+		if(d->src) lv_label_set_text_static(obj, (const char*)d->src);
+		break;
+#if LV_USE_CPICKER
+	case UI_OBJ_CPICKER:
+		lv_cpicker_set_type(obj, (lv_cpicker_type_t)d->arg);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	if(d->w > 0 && d->h > 0) lv_obj_set_size(obj, d->w, d->h);
+	if(parent != NULL)
+	{
+		if(d->align != UI_NO_ALIGN) lv_obj_align(obj, NULL, d->align, d->x, d->y);
+		else lv_obj_set_pos(obj, d->x, d->y);
+	}
+
+	if(d->flags & UI_F_HIDDEN) lv_obj_set_hidden(obj, true);
+	if(d->flags & UI_F_NO_CLICK) lv_obj_set_click(obj, false);
+}
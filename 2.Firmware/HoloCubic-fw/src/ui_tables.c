@@ -0,0 +1,48 @@
+/*
+ * 由scripts/ui_compile.py根据ui目录下的屏幕描述生成，请勿手工修改
+ */
+
+#include "ui_tables.h"
+#include "gui_guider.h"
+#include <stddef.h>
+
+/* home.json */
+
+static const uint8_t home_cpicker0_main_map[] = {
+	UI_PROP(LV_STYLE_PAD_INNER, LV_STATE_DEFAULT), UI_INT(10),
+	UI_PROP(LV_STYLE_SCALE_WIDTH, LV_STATE_DEFAULT), UI_INT(10),
+	UI_STYLE_END
+};
+static const lv_style_t home_cpicker0_main = UI_STYLE_INIT(home_cpicker0_main_map);
+
+static const ui_style_ref_t home_cpicker0_styles[] = {
+	{ LV_CPICKER_PART_MAIN, &home_cpicker0_main },
+};
+
+static const ui_obj_def_t home_objs[] = {
+	{ offsetof(lv_ui, home), UI_NO_PARENT, UI_OBJ_BASE, UI_NO_ALIGN, 0, 0, 0, 0, 0, 0, NULL, NULL, 0 },
+	{ offsetof(lv_ui, home_cpicker0), 0, UI_OBJ_CPICKER, UI_NO_ALIGN, 0, LV_CPICKER_TYPE_DISC, 15, 16, 200, 200, NULL, home_cpicker0_styles, 1 },
+};
+
+const ui_scr_def_t ui_scr_home = { "home", home_objs, 2 };
+
+/* scenes.json */
+
+static const uint8_t scenes_canvas_main_map[] = {
+	UI_PROP(LV_STYLE_BG_COLOR, LV_STATE_DEFAULT), UI_COLOR(0x000000),
+	UI_PROP(LV_STYLE_BG_COLOR, LV_STATE_PRESSED), UI_COLOR(0x808080),
+	UI_PROP(LV_STYLE_BG_COLOR, LV_STATE_FOCUSED), UI_COLOR(0x000000),
+	UI_STYLE_END
+};
+static const lv_style_t scenes_canvas_main = UI_STYLE_INIT(scenes_canvas_main_map);
+
+static const ui_style_ref_t scenes_styles[] = {
+	{ LV_OBJ_PART_MAIN, &scenes_canvas_main },
+};
+
+static const ui_obj_def_t scenes_objs[] = {
+	{ offsetof(lv_ui, scenes), UI_NO_PARENT, UI_OBJ_BASE, UI_NO_ALIGN, 0, 0, 0, 0, 0, 0, NULL, scenes_styles, 1 },
+	{ offsetof(lv_ui, scenes_canvas), 0, UI_OBJ_IMG, LV_ALIGN_CENTER, 0, 0, 0, 0, 0, 0, "S:/Scenes/Holo3D/frame000.bin", NULL, 0 },
+};
+
+const ui_scr_def_t ui_scr_scenes = { "scenes", scenes_objs, 2 };
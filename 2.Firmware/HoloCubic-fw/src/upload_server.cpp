@@ -0,0 +1,446 @@
+/*
+ * HoloCubic 无线上传模块
+ *
+ * 功能说明：
+ * 1. 通过HTTP PUT把场景文件（.holo动画包、帧文件、图片）直接写入SD卡
+ * 2. 请求体按UPLOAD_WRITE_SIZE分段接收，每段接收满后整段写入，内存占用与文件大小无关
+ * 3. 支持分段上传与断点续传，完成后重建场景索引
+ * 4. 接收固件镜像并边收边写入OTA分区
+ * 5. patch模式原地改写已有文件的一段（差量同步只上传变化的块，见scene_manifest.h）
+ *
+ * 示例（PC端）：
+ *   curl -T anim.holo "http://<设备IP>/upload?path=/Scenes/anim.holo"
+ *   curl -o shot.bmp "http://<设备IP>/screenshot"
+ */
+
+#include "upload_server.h"
+#include "scene_index.h"
+#include "scene_manifest.h"
+#include "sd_card.h"
+#include "telemetry.h"
+#include "screenshot.h"
+#include "lv_port_fatfs.h"
+#include <esp_heap_caps.h>
+
+UploadServer::UploadServer()
+{
+	server = NULL;
+	ota = NULL;
+}
+
+/**
+ * 启动服务（WiFi.mode()之后调用，联网前启动也可以，获取IP后即可访问）
+ */
+bool UploadServer::begin(uint16_t port)
+{
+	if (server) return true;
+
+	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+	config.server_port = port;
+	config.core_id = UPLOAD_TASK_CORE;
+	config.task_priority = UPLOAD_TASK_PRIORITY;
+	config.stack_size = UPLOAD_TASK_STACK;
+	config.lru_purge_enable = true;
+
+	if (httpd_start(&server, &config) != ESP_OK)
+	{
+		Serial.println("上传服务启动失败");
+		server = NULL;
+		return false;
+	}
+
+	httpd_uri_t put = { "/upload", HTTP_PUT, putHandler, this };
+	httpd_uri_t status = { "/upload", HTTP_GET, statusHandler, this };
+	httpd_uri_t scenes = { "/scenes", HTTP_GET, scenesHandler, this };
+	httpd_uri_t tele = { "/telemetry", HTTP_GET, telemetryHandler, this };
+	httpd_uri_t shot = { "/screenshot", HTTP_GET, screenshotHandler, this };
+	httpd_register_uri_handler(server, &put);
+	httpd_register_uri_handler(server, &status);
+	httpd_register_uri_handler(server, &scenes);
+	httpd_register_uri_handler(server, &tele);
+	httpd_register_uri_handler(server, &shot);
+	if (ota)
+	{
+		httpd_uri_t fw = { "/ota", HTTP_PUT, otaHandler, this };
+		httpd_register_uri_handler(server, &fw);
+	}
+
+	Serial.printf("上传服务已启动，端口%u\n", port);
+	return true;
+}
+
+void UploadServer::end()
+{
+	if (server == NULL) return;
+	httpd_stop(server);
+	server = NULL;
+}
+
+bool UploadServer::isRunning()
+{
+	return server != NULL;
+}
+
+/**
+ * 启用PUT /ota（需在begin之前调用）
+ */
+void UploadServer::setOta(OtaUpdate* updater)
+{
+	ota = updater;
+}
+
+/**
+ * URL解码（%XX与'+'），原地进行
+ */
+static void urlDecode(char* s)
+{
+	char* out = s;
+	while (*s)
+	{
+		if (*s == '%' && isxdigit((unsigned char)s[1]) && isxdigit((unsigned char)s[2]))
+		{
+			char hex[3] = { s[1], s[2], 0 };
+			*out++ = (char)strtol(hex, NULL, 16);
+			s += 3;
+		}
+		else
+		{
+			*out++ = *s == '+' ? ' ' : *s;
+			s++;
+		}
+	}
+	*out = 0;
+}
+
+/**
+ * 取出并校验path参数：必须位于UPLOAD_ROOT之下，且不能包含".."
+ */
+bool UploadServer::getPath(httpd_req_t* req, char* query, size_t query_len, char* path)
+{
+	if (httpd_req_get_url_query_str(req, query, query_len) != ESP_OK) return false;
+	if (httpd_query_key_value(query, "path", path, UPLOAD_PATH_MAX) != ESP_OK) return false;
+	urlDecode(path);
+	return strncmp(path, UPLOAD_ROOT, strlen(UPLOAD_ROOT)) == 0 &&
+		strstr(path, "..") == NULL && path[strlen(path) - 1] != '/';
+}
+
+/**
+ * 逐级创建目标文件的上级目录（上传帧目录中的文件时需要）
+ */
+bool UploadServer::makeParents(const char* path)
+{
+	char dir[UPLOAD_PATH_MAX];
+	strlcpy(dir, path, sizeof(dir));
+	for (char* p = dir + 1; *p; p++)
+	{
+		if (*p != '/') continue;
+		*p = 0;
+		if (!SD_FS.exists(dir) && !SD_FS.mkdir(dir)) return false;
+		*p = '/';
+	}
+	return true;
+}
+
+/**
+ * 接收请求体并写入f的当前位置：按UPLOAD_WRITE_SIZE攒满一整段再写，保证每次f_write都是整簇
+ * @return 接收或写入失败时返回false（已写入的部分保留）
+ */
+bool UploadServer::receive(httpd_req_t* req, File& f)
+{
+	uint8_t* buf = (uint8_t*)heap_caps_malloc(UPLOAD_WRITE_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+	if (buf == NULL) return false;
+
+	size_t left = req->content_len;
+	size_t fill = 0;
+	uint8_t retries = 0;
+	bool ok = true;
+	uint32_t start = millis();
+
+	while (left > 0)
+	{
+		size_t want = UPLOAD_WRITE_SIZE - fill;
+		if (want > left) want = left;
+		int n = httpd_req_recv(req, (char*)buf + fill, want);
+		if (n == HTTPD_SOCK_ERR_TIMEOUT && ++retries <= UPLOAD_RECV_RETRIES) continue;
+		if (n <= 0)
+		{
+			ok = false;
+			break;
+		}
+		retries = 0;
+		fill += n;
+		left -= n;
+
+		if (fill == UPLOAD_WRITE_SIZE || left == 0)
+		{
+			if (f.write(buf, fill) != fill)
+			{
+				ok = false;
+				break;
+			}
+			telemetry_sd_io(0, fill);
+			fill = 0;
+		}
+	}
+	heap_caps_free(buf);
+
+	uint32_t ms = millis() - start;
+	if (ok) Serial.printf("上传: %s +%u字节, %u ms (%u KB/s)\n", f.name(), req->content_len, ms,
+		ms ? req->content_len / ms : 0);
+	return ok;
+}
+
+/**
+ * 文件写入完成：作废清单记录、LVGL文件句柄，并更新所在场景的索引
+ */
+void UploadServer::finish(const char* path)
+{
+	SceneManifest::invalidate(path);
+	// LVGL缓存的只读句柄可能指向被替换文件的旧簇链
+	lv_fs_if_invalidate();
+	// 场景名为根目录下的第一级（.holo文件或帧目录），FAT不会更新帧目录的修改时间
+	char name[SCENE_INDEX_NAME_MAX];
+	strlcpy(name, path + strlen(UPLOAD_ROOT), sizeof(name));
+	char* slash = strchr(name, '/');
+	if (slash) *slash = '\0';
+	SceneIndex::build(name);
+}
+
+/**
+ * PUT /upload：边接收边写入<path>.part（patch=1时原地写入<path>）
+ */
+esp_err_t UploadServer::putHandler(httpd_req_t* req)
+{
+	char query[UPLOAD_PATH_MAX + 48];
+	char path[UPLOAD_PATH_MAX];
+	char part[UPLOAD_PATH_MAX + 5];
+	char val[16];
+
+	if (!getPath(req, query, sizeof(query), path))
+		return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid path");
+
+	uint32_t offset = 0;
+	bool final = true;
+	if (httpd_query_key_value(query, "offset", val, sizeof(val)) == ESP_OK) offset = strtoul(val, NULL, 10);
+	if (httpd_query_key_value(query, "final", val, sizeof(val)) == ESP_OK) final = val[0] != '0';
+	uint32_t total = 0;
+	if (httpd_query_key_value(query, "size", val, sizeof(val)) == ESP_OK) total = strtoul(val, NULL, 10);
+	bool patch = httpd_query_key_value(query, "patch", val, sizeof(val)) == ESP_OK && val[0] != '0';
+	snprintf(part, sizeof(part), "%s.part", path);
+
+	// patch：改写已有文件的[offset, offset + 长度)，offset不能超过当前长度（超出部分为追加）
+	if (patch)
+	{
+		File f = SD_FS.exists(path) ? SD_FS.open(path, "r+") : File();
+		if (!f || f.isDirectory())
+		{
+			if (f) f.close();
+			return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "no such file");
+		}
+		if (offset > f.size() || !f.seek(offset))
+		{
+			snprintf(val, sizeof(val), "%u", (uint32_t)f.size());
+			f.close();
+			httpd_resp_set_status(req, "409 Conflict");
+			return httpd_resp_sendstr(req, val);
+		}
+		// 写入期间内容与清单不符，先作废记录（中断后下次同步重新比较）
+		SceneManifest::invalidate(path);
+		bool ok = receive(req, f);
+		uint32_t size = f.size();
+		f.close();
+		if (!ok)
+		{
+			Serial.printf("改写中断: %s @%u\n", path, offset);
+			return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "receive failed");
+		}
+		if (final) finish(path);
+		snprintf(val, sizeof(val), "%u", size);
+		return httpd_resp_sendstr(req, val);
+	}
+
+	// 续传时offset必须与已接收长度一致
+	if (offset > 0)
+	{
+		File f = SD_FS.open(part);
+		uint32_t have = f ? f.size() : 0;
+		if (f) f.close();
+		if (have != offset)
+		{
+			snprintf(val, sizeof(val), "%u", have);
+			httpd_resp_set_status(req, "409 Conflict");
+			return httpd_resp_sendstr(req, val);
+		}
+	}
+
+	if (!makeParents(path))
+		return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "mkdir failed");
+
+	// 已知总长时先找一段连续空闲簇，场景包连续存放后可按扇区直接读取
+	if (offset == 0 && total > 0 && !tf.preallocate(part, total))
+		Serial.printf("上传: %s 未能预留%u字节的连续空间\n", path, total);
+
+	File f = SD_FS.open(part, offset > 0 ? FILE_APPEND : FILE_WRITE);
+	if (!f) return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "open failed");
+
+	bool ok = receive(req, f);
+	uint32_t size = f.size();
+	f.close();
+
+	if (!ok)
+	{
+		// 已写入的部分保留，客户端可用GET /upload查询长度后续传
+		Serial.printf("上传中断: %s, 已接收%u字节\n", path, size);
+		return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "receive failed");
+	}
+
+	if (final)
+	{
+		if (SD_FS.exists(path)) SD_FS.remove(path);
+		if (!SD_FS.rename(part, path))
+			return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "rename failed");
+		finish(path);
+	}
+
+	snprintf(val, sizeof(val), "%u", size);
+	return httpd_resp_sendstr(req, val);
+}
+
+/**
+ * GET /upload：返回<path>.part的当前长度（没有则为0）
+ */
+esp_err_t UploadServer::statusHandler(httpd_req_t* req)
+{
+	char query[UPLOAD_PATH_MAX + 48];
+	char path[UPLOAD_PATH_MAX];
+	char val[16];
+
+	if (!getPath(req, query, sizeof(query), path))
+		return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid path");
+
+	strlcat(path, ".part", sizeof(path));
+	File f = SD_FS.open(path);
+	snprintf(val, sizeof(val), "%u", f ? (uint32_t)f.size() : 0);
+	if (f) f.close();
+	return httpd_resp_sendstr(req, val);
+}
+
+/**
+ * GET /scenes：按场景索引逐行返回
+ * 每行：名称\t帧数\t帧率\t宽\t高\t格式（frames/holo）\t标志\t时长ms\t片段数，帧目录的帧率与片段数记为0
+ */
+esp_err_t UploadServer::scenesHandler(httpd_req_t* req)
+{
+	SceneIndex index;
+	if (!index.open() && !(SceneIndex::build() && index.open()))
+		return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "no index");
+
+	httpd_resp_set_type(req, "text/plain");
+	char buf[112];
+	SceneIndexEntry e;
+	for (uint32_t i = 0; i < index.getCount() && index.get(i, &e); i++)
+	{
+		int n = snprintf(buf, sizeof(buf), "%s\t%u\t%u\t%u\t%u\t%s\t%u\t%u\t%u\n", e.name, e.frame_count, e.fps,
+			e.width, e.height, e.format == SCENE_FORMAT_HOLO ? "holo" : "frames", e.flags, e.duration_ms, e.fragments);
+		if (httpd_resp_send_chunk(req, buf, n) != ESP_OK) break;
+	}
+	return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * GET /telemetry：返回最近一次遥测采样（JSON，见telemetry.cpp）
+ */
+esp_err_t UploadServer::telemetryHandler(httpd_req_t* req)
+{
+	if (!telemetry.isRunning()) return httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "telemetry off");
+
+	char* buf = (char*)malloc(TELEMETRY_JSON_SIZE);
+	if (buf == NULL) return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no memory");
+	size_t n = telemetry.toJson(buf, TELEMETRY_JSON_SIZE);
+	if (n == 0)
+	{
+		free(buf);
+		return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no sample yet");
+	}
+
+	httpd_resp_set_type(req, "application/json");
+	httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+	esp_err_t err = httpd_resp_send(req, buf, n);
+	free(buf);
+	return err;
+}
+
+/**
+ * GET /screenshot：截取下一次整屏刷新，边编码边以chunked响应发送（在httpd任务中等待刷新）
+ */
+esp_err_t UploadServer::screenshotHandler(httpd_req_t* req)
+{
+	if (!screenshot.available()) return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "screenshot busy");
+
+	char query[32];
+	char val[8];
+	ShotFormat fmt = SHOT_BMP;
+	if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+		httpd_query_key_value(query, "format", val, sizeof(val)) == ESP_OK && strcmp(val, "qoi") == 0)
+		fmt = SHOT_QOI;
+
+	httpd_resp_set_type(req, fmt == SHOT_QOI ? "image/qoi" : "image/bmp");
+	httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+	bool ok = screenshot.capture([](const void* data, size_t len, void* user) {
+		return httpd_resp_send_chunk((httpd_req_t*)user, (const char*)data, len) == ESP_OK;
+	}, req, fmt);
+	// 响应已经开始，失败时只能提前结束（客户端收到不完整的图像）
+	if (!ok) Serial.println("截图失败");
+	return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/**
+ * PUT /ota：按扇区接收固件并写入OTA分区，完成后需重启生效
+ * 在httpd任务中执行，写flash期间LVGL任务照常运行
+ */
+esp_err_t UploadServer::otaHandler(httpd_req_t* req)
+{
+	UploadServer* self = (UploadServer*)req->user_ctx;
+	char query[96];
+	char sha[65];
+	bool has_sha = httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+		httpd_query_key_value(query, "sha256", sha, sizeof(sha)) == ESP_OK;
+
+	if (!self->ota->begin(req->content_len, has_sha ? sha : NULL))
+		return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "ota begin failed");
+
+	uint8_t* buf = (uint8_t*)malloc(OTA_CHUNK_SIZE);
+	if (buf == NULL)
+	{
+		self->ota->abort();
+		return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "no memory");
+	}
+
+	size_t left = req->content_len;
+	size_t fill = 0;
+	uint8_t retries = 0;
+	while (left > 0)
+	{
+		size_t want = OTA_CHUNK_SIZE - fill;
+		if (want > left) want = left;
+		int n = httpd_req_recv(req, (char*)buf + fill, want);
+		if (n == HTTPD_SOCK_ERR_TIMEOUT && ++retries <= UPLOAD_RECV_RETRIES) continue;
+		if (n <= 0) break;
+		retries = 0;
+		fill += n;
+		left -= n;
+		if (fill == OTA_CHUNK_SIZE || left == 0)
+		{
+			if (!self->ota->write(buf, fill)) break;
+			fill = 0;
+		}
+	}
+	free(buf);
+
+	if (left > 0 || !self->ota->end())
+	{
+		self->ota->abort();
+		return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "ota failed");
+	}
+	return httpd_resp_sendstr(req, "OK, reboot to apply");
+}
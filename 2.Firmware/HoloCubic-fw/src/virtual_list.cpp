@@ -0,0 +1,353 @@
+/*
+ * HoloCubic 虚拟列表控件
+ *
+ * 功能说明：
+ * 1. 创建时按控件高度建立固定数量的行对象（每行一个背景对象、一个主文字标签、一个右侧附加文字标签）
+ * 2. 滚动时第i项由第i % row_count行显示，行对象只改变位置；显示的条目变化时调用取数据回调
+ * 3. 标签使用行内的静态缓冲（lv_label_set_text_static），换行内容时不在LVGL内存中分配文字
+ *
+ * 数据流：
+ *   setCount/滚动 --> layout：可见范围内每项 --> bind（条目变化时fetch） --> 行对象定位
+ */
+
+#include "virtual_list.h"
+#include "logger.h"
+
+static lv_signal_cb_t ancestor_signal = NULL;
+// 所有行共用一个样式（本地样式每行约占200字节）
+static lv_style_t row_style;
+static bool row_style_ready = false;
+
+/**
+ * 控件的扩展数据：指回所属的VirtualList
+ */
+struct VirtualListExt
+{
+	VirtualList* owner;
+};
+
+VirtualList::VirtualList()
+{
+	obj = NULL;
+	memset(rows, 0, sizeof(rows));
+	row_count = 0;
+	row_h = 1;
+	count = 0;
+	offset = 0;
+	selected = -1;
+	anim_from = anim_to = 0;
+	drag_sum = 0;
+	fetch = NULL;
+	on_select = NULL;
+	user = NULL;
+}
+
+/**
+ * 创建控件与行对象池
+ *
+ * @param row_h 行高（像素），行对象数为h / row_h + 2，最多VLIST_POOL_MAX
+ */
+bool VirtualList::create(lv_obj_t* parent, lv_coord_t w, lv_coord_t h, lv_coord_t rh)
+{
+	if (obj || rh <= 0) return false;
+
+	obj = lv_obj_create(parent, NULL);
+	if (obj == NULL) return false;
+	VirtualListExt* ext = (VirtualListExt*)lv_obj_allocate_ext_attr(obj, sizeof(VirtualListExt));
+	if (ext == NULL)
+	{
+		lv_obj_del(obj);
+		obj = NULL;
+		return false;
+	}
+	ext->owner = this;
+
+	if (ancestor_signal == NULL) ancestor_signal = lv_obj_get_signal_cb(obj);
+	lv_obj_set_signal_cb(obj, signalCb);
+	lv_obj_set_size(obj, w, h);
+	lv_obj_set_style_local_radius(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 0);
+
+	row_h = rh;
+	row_count = LV_MATH_MIN(h / rh + 2, VLIST_POOL_MAX);
+	if (h / rh + 2 > VLIST_POOL_MAX) LOG_W("vlist", "行对象池不足: %d行可见，只有%u行", h / rh + 1, VLIST_POOL_MAX);
+
+	if (!row_style_ready)
+	{
+		lv_style_init(&row_style);
+		lv_style_set_radius(&row_style, LV_STATE_DEFAULT, 0);
+		lv_style_set_border_width(&row_style, LV_STATE_DEFAULT, 0);
+		lv_style_set_bg_opa(&row_style, LV_STATE_DEFAULT, LV_OPA_TRANSP);
+		lv_style_set_bg_opa(&row_style, LV_STATE_CHECKED, LV_OPA_COVER);
+		lv_style_set_bg_color(&row_style, LV_STATE_CHECKED, lv_theme_get_color_primary());
+		row_style_ready = true;
+	}
+	for (uint8_t i = 0; i < row_count; i++)
+	{
+		Row* r = &rows[i];
+		r->index = -1;
+		r->obj = lv_obj_create(obj, NULL);
+		if (r->obj == NULL)
+		{
+			row_count = i;
+			LOG_W("vlist", "行对象创建失败，只有%u行", i);
+			break;
+		}
+		lv_obj_set_size(r->obj, w, rh);
+		lv_obj_set_click(r->obj, false);
+		lv_obj_set_hidden(r->obj, true);
+		lv_obj_add_style(r->obj, LV_OBJ_PART_MAIN, &row_style);
+
+		r->text = lv_label_create(r->obj, NULL);
+		r->detail = lv_label_create(r->obj, NULL);
+		lv_label_set_long_mode(r->text, LV_LABEL_LONG_CROP);
+		r->text_buf[0] = r->detail_buf[0] = '\0';
+		lv_label_set_text_static(r->text, r->text_buf);
+		lv_label_set_text_static(r->detail, r->detail_buf);
+	}
+	return true;
+}
+
+/**
+ * 删除控件与全部行对象
+ */
+void VirtualList::destroy()
+{
+	// 删除时的CLEANUP信号调用detach
+	if (obj) lv_obj_del(obj);
+}
+
+lv_obj_t* VirtualList::getObj()
+{
+	return obj;
+}
+
+void VirtualList::setSource(vlist_fetch_t f, vlist_select_t sel, void* u)
+{
+	fetch = f;
+	on_select = sel;
+	user = u;
+	refresh();
+}
+
+void VirtualList::setCount(uint32_t n)
+{
+	count = n;
+	if (selected >= (int32_t)count) selected = count ? count - 1 : -1;
+	if (offset > maxOffset()) offset = maxOffset();
+	refresh();
+}
+
+uint32_t VirtualList::getCount()
+{
+	return count;
+}
+
+void VirtualList::refresh()
+{
+	for (uint8_t i = 0; i < row_count; i++) rows[i].index = -1;
+	layout();
+}
+
+void VirtualList::select(int32_t index, bool anim)
+{
+	if (obj == NULL || count == 0) return;
+	index = LV_MATH_MAX(0, LV_MATH_MIN(index, (int32_t)count - 1));
+	if (index == selected) return;
+	selected = index;
+	layout();
+	scrollToSelected(anim);
+}
+
+int32_t VirtualList::getSelected()
+{
+	return selected;
+}
+
+void VirtualList::scrollTo(uint32_t index)
+{
+	if (obj == NULL) return;
+	lv_anim_del(this, animCb);
+	setOffset(index > (uint32_t)(maxOffset() / row_h) + 1 ? maxOffset() : (int32_t)index * row_h);
+}
+
+void VirtualList::detach()
+{
+	lv_anim_del(this, animCb);
+	memset(rows, 0, sizeof(rows));
+	row_count = 0;
+	obj = NULL;
+}
+
+int32_t VirtualList::maxOffset()
+{
+	int32_t h = obj ? lv_obj_get_height(obj) : 0;
+	int32_t total = (int32_t)LV_MATH_MIN(count, (uint32_t)(INT32_MAX / row_h)) * row_h;
+	return total > h ? total - h : 0;
+}
+
+void VirtualList::setOffset(int32_t ofs)
+{
+	ofs = LV_MATH_MAX(0, LV_MATH_MIN(ofs, maxOffset()));
+	if (ofs == offset) return;
+	offset = ofs;
+	layout();
+}
+
+/**
+ * 按滚动位置放置行对象：可见范围[offset / row_h, +row_count)内的每一项固定由index % row_count行显示
+ */
+void VirtualList::layout()
+{
+	if (obj == NULL || row_count == 0) return;
+	int32_t first = offset / row_h;
+	for (int32_t index = first; index < first + row_count; index++)
+	{
+		Row* r = &rows[index % row_count];
+		if (index >= (int32_t)count)
+		{
+			r->index = -1;
+			lv_obj_set_hidden(r->obj, true);
+			continue;
+		}
+		bind(r, index);
+		lv_obj_set_y(r->obj, (lv_coord_t)(index * row_h - offset));
+		lv_obj_set_hidden(r->obj, false);
+		if (index == selected) lv_obj_add_state(r->obj, LV_STATE_CHECKED);
+		else lv_obj_clear_state(r->obj, LV_STATE_CHECKED);
+	}
+}
+
+/**
+ * 行对象改为显示第index项：调用取数据回调写入行缓冲，重新排版两个标签
+ */
+void VirtualList::bind(Row* r, int32_t index)
+{
+	if (r->index == index) return;
+	r->index = index;
+	r->text_buf[0] = r->detail_buf[0] = '\0';
+	if (fetch && !fetch(index, r->text_buf, sizeof(r->text_buf), r->detail_buf, sizeof(r->detail_buf), user))
+	{
+		r->text_buf[0] = r->detail_buf[0] = '\0';
+	}
+	r->text_buf[sizeof(r->text_buf) - 1] = '\0';
+	r->detail_buf[sizeof(r->detail_buf) - 1] = '\0';
+
+	// 缓冲内容已改变，重新设置同一指针使标签重新排版
+	lv_label_set_text_static(r->detail, r->detail_buf);
+	lv_obj_align(r->detail, NULL, LV_ALIGN_IN_RIGHT_MID, -4, 0);
+	lv_label_set_text_static(r->text, r->text_buf);
+	lv_coord_t w = lv_obj_get_width(r->obj) - 12 - (r->detail_buf[0] ? lv_obj_get_width(r->detail) + 4 : 0);
+	lv_obj_set_width(r->text, LV_MATH_MAX(w, 0));
+	lv_obj_align(r->text, NULL, LV_ALIGN_IN_LEFT_MID, 4, 0);
+}
+
+/**
+ * 选中行不完全可见时滚动到可见（向上时位于顶端，向下时位于底端）
+ */
+void VirtualList::scrollToSelected(bool anim)
+{
+	if (selected < 0) return;
+	int32_t top = selected * row_h;
+	int32_t h = lv_obj_get_height(obj);
+	int32_t target = offset;
+	if (top < offset) target = top;
+	else if (top + row_h > offset + h) target = top + row_h - h;
+	target = LV_MATH_MAX(0, LV_MATH_MIN(target, maxOffset()));
+	if (target == offset) return;
+
+	lv_anim_del(this, animCb);
+	if (!anim)
+	{
+		setOffset(target);
+		return;
+	}
+	// 动画值为16位，按0~256的进度插值32位的滚动位置
+	anim_from = offset;
+	anim_to = target;
+	lv_anim_path_t path;
+	lv_anim_path_init(&path);
+	lv_anim_path_set_cb(&path, lv_anim_path_ease_out);
+	lv_anim_t a;
+	lv_anim_init(&a);
+	lv_anim_set_var(&a, this);
+	lv_anim_set_exec_cb(&a, animCb);
+	lv_anim_set_values(&a, 0, 256);
+	lv_anim_set_time(&a, VLIST_ANIM_MS);
+	lv_anim_set_path(&a, &path);
+	lv_anim_start(&a);
+}
+
+void VirtualList::animCb(void* var, lv_anim_value_t v)
+{
+	VirtualList* self = (VirtualList*)var;
+	self->setOffset(self->anim_from + (int32_t)((int64_t)(self->anim_to - self->anim_from) * v / 256));
+}
+
+void VirtualList::activate(int32_t index)
+{
+	if (index < 0 || index >= (int32_t)count) return;
+	if (index != selected) select(index);
+	if (on_select) on_select(index, user);
+}
+
+VirtualList* VirtualList::of(lv_obj_t* o)
+{
+	VirtualListExt* ext = (VirtualListExt*)lv_obj_get_ext_attr(o);
+	return ext ? ext->owner : NULL;
+}
+
+/**
+ * 信号：编码器与按键移动选中行，触摸拖动滚动、点击选中
+ */
+lv_res_t VirtualList::signalCb(lv_obj_t* o, lv_signal_t sign, void* param)
+{
+	VirtualList* self = of(o);
+	if (sign == LV_SIGNAL_CLEANUP)
+	{
+		if (self) self->detach();
+		return ancestor_signal(o, sign, param);
+	}
+	if (sign == LV_SIGNAL_GET_EDITABLE)
+	{
+		// 编码器进入编辑模式后左右倾斜作为LV_KEY_LEFT/RIGHT送到列表
+		*(bool*)param = true;
+		return LV_RES_OK;
+	}
+
+	lv_res_t res = ancestor_signal(o, sign, param);
+	if (res != LV_RES_OK || self == NULL) return res;
+
+	if (sign == LV_SIGNAL_CONTROL)
+	{
+		uint32_t key = *(const uint32_t*)param;
+		int32_t cur = self->selected < 0 ? 0 : self->selected;
+		if (key == LV_KEY_RIGHT || key == LV_KEY_DOWN) self->select(self->selected < 0 ? 0 : cur + 1);
+		else if (key == LV_KEY_LEFT || key == LV_KEY_UP) self->select(cur - 1);
+		else if (key == LV_KEY_ENTER) self->activate(self->selected);
+	}
+	else if (sign == LV_SIGNAL_PRESSED)
+	{
+		lv_anim_del(self, animCb);
+		self->drag_sum = 0;
+	}
+	else if (sign == LV_SIGNAL_PRESSING)
+	{
+		lv_indev_t* indev = (lv_indev_t*)param;
+		if (indev == NULL || lv_indev_get_type(indev) != LV_INDEV_TYPE_POINTER) return res;
+		lv_point_t v;
+		lv_indev_get_vect(indev, &v);
+		if (v.y == 0) return res;
+		self->drag_sum += LV_MATH_ABS(v.y);
+		self->setOffset(self->offset - v.y);
+	}
+	else if (sign == LV_SIGNAL_RELEASED)
+	{
+		lv_indev_t* indev = (lv_indev_t*)param;
+		if (indev == NULL || lv_indev_get_type(indev) != LV_INDEV_TYPE_POINTER) return res;
+		if (self->drag_sum > VLIST_DRAG_LIMIT) return res;
+		lv_point_t p;
+		lv_indev_get_point(indev, &p);
+		self->activate((p.y - o->coords.y1 + self->offset) / self->row_h);
+	}
+	return res;
+}
@@ -0,0 +1,394 @@
+/*
+ * HoloCubic 天气
+ *
+ * 功能说明：
+ * 1. 作为后台抓取的一个数据源，每WEATHER_INTERVAL_S秒请求一次Open-Meteo预报
+ * 2. 过滤文档只保留所需字段（响应约2KB，解析后的文档只有几百字节），解析为定长的WeatherData
+ * 3. 记录以二进制原样存入NVS，只有内容变化时才写入；开机读出后界面立即可用
+ * 4. 图标取自资源包中的一张图集：图标对象大小为一格，用图像偏移选择显示哪一格，
+ *    图集映射自flash，不经过SD卡、不占用堆内存
+ *
+ * 布局（240x240）：
+ *   [图标]  23 C          当前天气
+ *   Partly cloudy  45%
+ *   Updated 14:30         或Offline（超过有效期未刷新成功）
+ *   Today   Thu    Fri    三天预报：图标与最高/最低温度
+ *
+ * 注意事项：
+ * - 变化判断用记录内容的哈希（不含时间戳），作为数据源的值交给FetchScheduler比较
+ * - 资源包中没有图集时不显示图标，只显示文字
+ */
+
+#include "weather.h"
+#include "runtime.h"
+#include "asset_bundle.h"
+#include "i18n.h"
+#include "logger.h"
+#include "time_service.h"
+#include <Preferences.h>
+#include <math.h>
+
+Weather weather;
+
+static portMUX_TYPE weather_mux = portMUX_INITIALIZER_UNLOCKED;
+static JsonDocument weather_filter;
+
+Weather::Weather()
+{
+	memset(&data, 0, sizeof(data));
+	memset(&pending, 0, sizeof(pending));
+	has_data = false;
+	loaded = false;
+	source = -1;
+	scr = NULL;
+	prev_scr = NULL;
+	atlas = NULL;
+}
+
+/**
+ * 读取NVS缓存并注册后台抓取（需在fetcher.begin()之前或之后、配置加载之后调用）
+ *
+ * @param lat 纬度（字符串原样拼入URL）
+ * @param lon 经度
+ * @return 数据源已满时返回false（缓存仍可显示）
+ */
+bool Weather::begin(const char* lat, const char* lon)
+{
+	load();
+	if (source >= 0) return true;
+
+	weather_filter["current"]["temperature_2m"] = true;
+	weather_filter["current"]["relative_humidity_2m"] = true;
+	weather_filter["current"]["weather_code"] = true;
+	weather_filter["daily"]["weather_code"] = true;
+	weather_filter["daily"]["temperature_2m_max"] = true;
+	weather_filter["daily"]["temperature_2m_min"] = true;
+
+	FetchSource src = {
+		"weather", "", WEATHER_INTERVAL_S, WEATHER_TTL_S, &weather_filter, parse, onChange, this
+	};
+	if (snprintf(src.url, sizeof(src.url), WEATHER_URL, lat, lon) >= (int)sizeof(src.url)) return false;
+	source = fetcher.add(src);
+	return source >= 0;
+}
+
+/**
+ * 读取上次的记录（任意任务中调用）
+ * @return 还没有任何数据时返回false
+ */
+bool Weather::get(WeatherData* out)
+{
+	portENTER_CRITICAL(&weather_mux);
+	bool ok = has_data;
+	if (ok) *out = data;
+	portEXIT_CRITICAL(&weather_mux);
+	return ok;
+}
+
+void Weather::load()
+{
+	if (loaded) return;
+	loaded = true;
+
+	WeatherData d;
+	Preferences prefs;
+	if (!prefs.begin(WEATHER_NVS_NAMESPACE, true)) return;
+	size_t n = prefs.getBytes(WEATHER_NVS_KEY, &d, sizeof(d));
+	prefs.end();
+	if (n != sizeof(d) || d.version != WEATHER_DATA_VERSION || d.days > WEATHER_DAYS) return;
+
+	portENTER_CRITICAL(&weather_mux);
+	data = d;
+	has_data = true;
+	portEXIT_CRITICAL(&weather_mux);
+}
+
+void Weather::save(const WeatherData* d)
+{
+	Preferences prefs;
+	if (!prefs.begin(WEATHER_NVS_NAMESPACE, false)) return;
+	prefs.putBytes(WEATHER_NVS_KEY, d, sizeof(WeatherData));
+	prefs.end();
+}
+
+/**
+ * 记录内容的哈希（FNV-1a，不含时间戳）
+ */
+uint32_t Weather::hash(const WeatherData* d)
+{
+	WeatherData tmp = *d;
+	tmp.updated = 0;
+	const uint8_t* p = (const uint8_t*)&tmp;
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < sizeof(tmp); i++) h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+/**
+ * 解析过滤后的响应（网络任务）
+ * 结果暂存在pending，值为内容哈希；NVS中还没有记录时加'*'，保证第一次取得的数据一定被提交
+ */
+bool Weather::parse(JsonDocument* doc, char* out, size_t len)
+{
+	JsonObject cur = (*doc)["current"];
+	JsonObject daily = (*doc)["daily"];
+	if (!cur["temperature_2m"].is<float>() || !cur["weather_code"].is<int>()) return false;
+
+	WeatherData d;
+	memset(&d, 0, sizeof(d));
+	d.version = WEATHER_DATA_VERSION;
+	d.temp_x10 = lroundf(cur["temperature_2m"].as<float>() * 10);
+	d.humidity = cur["relative_humidity_2m"] | 0;
+	d.code = cur["weather_code"].as<int>();
+
+	JsonArray codes = daily["weather_code"];
+	JsonArray maxs = daily["temperature_2m_max"];
+	JsonArray mins = daily["temperature_2m_min"];
+	size_t days = LV_MATH_MIN(codes.size(), (size_t)WEATHER_DAYS);
+	days = LV_MATH_MIN(days, LV_MATH_MIN(maxs.size(), mins.size()));
+	for (size_t i = 0; i < days; i++)
+	{
+		d.day[i].code = codes[i] | 0;
+		d.day[i].t_max = lroundf(maxs[i] | 0.0f);
+		d.day[i].t_min = lroundf(mins[i] | 0.0f);
+	}
+	d.days = days;
+	d.updated = (uint32_t)timesvc.now();
+
+	portENTER_CRITICAL(&weather_mux);
+	weather.pending = d;
+	bool first = !weather.has_data;
+	portEXIT_CRITICAL(&weather_mux);
+
+	snprintf(out, len, "%08x%s", hash(&d), first ? "*" : "");
+	return true;
+}
+
+/**
+ * 内容变化（抓取任务）：提交记录、写NVS、通知界面
+ */
+void Weather::onChange(uint8_t id, const char* value, void* user)
+{
+	Weather* self = (Weather*)user;
+	WeatherData d;
+	portENTER_CRITICAL(&weather_mux);
+	d = self->pending;
+	self->data = d;
+	self->has_data = true;
+	portEXIT_CRITICAL(&weather_mux);
+
+	self->save(&d);
+	LOG_I("weather", "天气已更新: %d.%d C，代码%u", d.temp_x10 / 10, abs(d.temp_x10 % 10), d.code);
+	runtime.post(onUpdate, self);
+}
+
+void Weather::onUpdate(const UiMsg* msg)
+{
+	Weather* self = (Weather*)msg->obj;
+	if (self->isRunning()) self->refresh();
+}
+
+/**
+ * WMO天气代码对应的图标
+ */
+uint8_t Weather::iconOf(uint8_t code)
+{
+	if (code == 0) return WEATHER_ICON_CLEAR;
+	if (code <= 2) return WEATHER_ICON_PARTLY;
+	if (code == 3) return WEATHER_ICON_CLOUDY;
+	if (code == 45 || code == 48) return WEATHER_ICON_FOG;
+	if (code >= 51 && code <= 57) return WEATHER_ICON_DRIZZLE;
+	if ((code >= 71 && code <= 77) || code == 85 || code == 86) return WEATHER_ICON_SNOW;
+	if (code >= 95) return WEATHER_ICON_THUNDER;
+	return WEATHER_ICON_RAIN;
+}
+
+const char* Weather::describe(uint8_t code)
+{
+	// STR_WX_x与WEATHER_ICON_x顺序相同
+	return i18n.str((i18n_id_t)(STR_WX_CLEAR + iconOf(code)));
+}
+
+/**
+ * 图标对象：大小为图集的一格（不自动适应图集尺寸），没有图集时隐藏
+ */
+lv_obj_t* Weather::createIcon(lv_coord_t x, lv_coord_t y)
+{
+	lv_obj_t* img = lv_img_create(scr, NULL);
+	lv_obj_set_pos(img, x, y);
+	if (atlas == NULL)
+	{
+		lv_obj_set_hidden(img, true);
+		return img;
+	}
+	lv_img_set_src(img, atlas);
+	lv_img_set_auto_size(img, false);
+	lv_obj_set_size(img, atlas->header.h, atlas->header.h);
+	return img;
+}
+
+/**
+ * 显示图集中该天气代码对应的一格（负偏移把该格移到对象原点）
+ */
+void Weather::setIcon(lv_obj_t* img, uint8_t code)
+{
+	if (atlas == NULL) return;
+	lv_img_set_offset_x(img, -(lv_coord_t)(iconOf(code) * atlas->header.h));
+}
+
+/**
+ * 进入天气界面
+ */
+bool Weather::start()
+{
+	if (scr) return false;
+	load();
+
+	// 图集宽度不足WEATHER_ICON_COUNT格时视为没有图集
+	atlas = assets.getImage(WEATHER_ATLAS);
+	if (atlas && atlas->header.w < atlas->header.h * WEATHER_ICON_COUNT)
+	{
+		LOG_W("weather", "图标图集尺寸不符: %ux%u", atlas->header.w, atlas->header.h);
+		atlas = NULL;
+	}
+
+	prev_scr = lv_scr_act();
+	scr = lv_obj_create(NULL, NULL);
+	lv_obj_set_style_local_bg_color(scr, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+
+	icon = createIcon(24, 24);
+	temp = lv_label_create(scr, NULL);
+	lv_obj_set_style_local_text_font(temp, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, &lv_font_montserrat_48);
+	lv_obj_set_style_local_text_color(temp, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_WHITE);
+	unit = lv_label_create(scr, NULL);
+	lv_obj_set_style_local_text_color(unit, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_WHITE);
+	lv_label_set_text_static(unit, "C");
+	desc = lv_label_create(scr, NULL);
+	lv_obj_set_style_local_text_color(desc, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_WHITE);
+	lv_obj_set_style_local_text_font(desc, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, i18n.getFont());
+	lv_obj_set_pos(desc, 24, 84);
+	status = lv_label_create(scr, NULL);
+	lv_obj_set_style_local_text_color(status, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_GRAY);
+	lv_obj_set_style_local_text_font(status, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, i18n.getFont());
+	lv_obj_set_pos(status, 24, 104);
+
+	lv_coord_t col = LV_HOR_RES_MAX / WEATHER_DAYS;
+	lv_coord_t tile = atlas ? atlas->header.h : 0;
+	for (uint8_t i = 0; i < WEATHER_DAYS; i++)
+	{
+		day_name[i] = lv_label_create(scr, NULL);
+		lv_obj_set_style_local_text_color(day_name[i], LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_GRAY);
+		lv_obj_set_style_local_text_font(day_name[i], LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, i18n.getFont());
+		day_icon[i] = createIcon(i * col + (col - tile) / 2, 156);
+		day_temp[i] = lv_label_create(scr, NULL);
+		lv_obj_set_style_local_text_color(day_temp[i], LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_WHITE);
+	}
+
+	refresh();
+	lv_scr_load(scr);
+	return true;
+}
+
+/**
+ * 离开天气界面（后台抓取继续进行）
+ */
+void Weather::stop()
+{
+	if (scr == NULL) return;
+	if (prev_scr) lv_scr_load(prev_scr);
+	lv_obj_del(scr);
+	scr = NULL;
+}
+
+bool Weather::isRunning()
+{
+	return scr != NULL;
+}
+
+/**
+ * 按当前记录更新所有标签与图标
+ */
+void Weather::refresh()
+{
+	WeatherData d;
+	bool ok = get(&d);
+	lv_obj_set_hidden(icon, !ok || atlas == NULL);
+	lv_obj_set_hidden(unit, !ok);
+	if (!ok)
+	{
+		lv_label_set_text_static(temp, "");
+		lv_label_set_text_static(desc, "");
+		lv_label_set_text_static(status, i18n.str(source >= 0 ? STR_WEATHER_WAITING : STR_WEATHER_NO_DATA));
+		for (uint8_t i = 0; i < WEATHER_DAYS; i++)
+		{
+			lv_label_set_text_static(day_name[i], "");
+			lv_label_set_text_static(day_temp[i], "");
+			lv_obj_set_hidden(day_icon[i], true);
+		}
+		return;
+	}
+
+	setIcon(icon, d.code);
+	lv_label_set_text_fmt(temp, "%d", (int)lroundf(d.temp_x10 / 10.0f));
+	lv_obj_set_pos(temp, 88, 20);
+	lv_obj_align(unit, temp, LV_ALIGN_OUT_RIGHT_TOP, 4, 6);
+	snprintf(text[0], sizeof(text[0]), "%s  %u%%", describe(d.code), d.humidity);
+	lv_label_set_text_static(desc, text[0]);
+
+	// 抓取调度的值超过有效期时视为离线（记录只在内容变化时更新时间戳）
+	char value[FETCH_VALUE_LEN];
+	time_t now = timesvc.now();
+	bool valid = now != 0;
+	bool fresh = source >= 0 ? fetcher.get(source, value, sizeof(value))
+							 : (!valid || d.updated == 0 || now - d.updated <= WEATHER_TTL_S);
+	struct tm t;
+	timesvc.toLocal(d.updated, &t);
+	if (!fresh) strlcpy(text[1], i18n.str(STR_WEATHER_OFFLINE), sizeof(text[1]));
+	else if (d.updated) strftime(text[1], sizeof(text[1]), i18n.str(STR_WEATHER_UPDATED), &t);
+	else text[1][0] = '\0';
+	lv_label_set_text_static(status, text[1]);
+
+	lv_coord_t col = LV_HOR_RES_MAX / WEATHER_DAYS;
+	for (uint8_t i = 0; i < WEATHER_DAYS; i++)
+	{
+		bool has = i < d.days;
+		lv_obj_set_hidden(day_icon[i], !has || atlas == NULL);
+		if (!has)
+		{
+			lv_label_set_text_static(day_name[i], "");
+			lv_label_set_text_static(day_temp[i], "");
+			continue;
+		}
+		if (i == 0) lv_label_set_text_static(day_name[i], i18n.str(STR_WEATHER_TODAY));
+		else if (valid)
+		{
+			timesvc.toLocal(now + i * 86400, &t);
+			lv_label_set_text_static(day_name[i], i18n.str((i18n_id_t)(STR_WEEKDAY_SUN + t.tm_wday)));
+		}
+		else lv_label_set_text_fmt(day_name[i], "+%u", i);
+		lv_obj_align(day_name[i], NULL, LV_ALIGN_IN_TOP_LEFT, i * col + (col - lv_obj_get_width(day_name[i])) / 2, 136);
+
+		setIcon(day_icon[i], d.day[i].code);
+		lv_label_set_text_fmt(day_temp[i], "%d/%d", d.day[i].t_max, d.day[i].t_min);
+		lv_obj_align(day_temp[i], NULL, LV_ALIGN_IN_TOP_LEFT, i * col + (col - lv_obj_get_width(day_temp[i])) / 2, 212);
+	}
+}
+
+/**** 应用入口 ****/
+
+// 图标图集、温度数字与界面字体中的数字（日期、湿度、最高/最低温）
+static const AppAsset weather_assets[] = {
+	{ APP_ASSET_BUNDLE, WEATHER_ATLAS, NULL },
+	{ APP_ASSET_FONT, &lv_font_montserrat_48, "-0123456789" },
+	{ APP_ASSET_FONT, NULL, "+-/%0123456789" },
+};
+
+const App weather_app = {
+	"weather",
+	[](void* u) { weather.start(); },
+	NULL,
+	NULL,
+	[](void* u) { weather.stop(); },
+	16 * 1024, 0, 0, 0, NULL,
+	weather_assets, sizeof(weather_assets) / sizeof(weather_assets[0])
+};
@@ -0,0 +1,324 @@
+"""
+HoloCubic 应用模块汇编工具（格式见固件include/app_module_format.h）
+
+    holo_app.py tilt.s                 生成同名.ham，复制到SD卡/apps/后在设备上登记为应用
+    holo_app.py tilt.s -o mod_tilt     输出到指定文件（以mod_开头的文件可用holo_pack打入资源包）
+    holo_app.py tilt.ham --dump        反汇编已有模块
+
+源文件（每行一条，';'之后为注释）：
+    .name  Tilt                        应用名（最多15字节）
+    .period 50                         on_loop周期（毫秒）
+    .stack 32                          栈深度
+    .budget steps 5000                 单次回调指令数；另有ram（字节）、cpu（微秒）
+    .var   x                           全局变量（.var buf 8 为8个连续变量，loadi/storei按编号访问）
+    .string title "倾斜"                常量字符串（push title得到其偏移）
+    enter: / loop: / exit:             各回调入口（以ret或halt结束），其余为普通标号
+    push 3 / load x / store x / jz lbl / call fn / sys label ……
+
+push的操作数可以是数字、常量字符串名（偏移）、变量名（编号）或标号（代码偏移）。
+示例（随倾斜角移动的圆点与读数）：
+
+    .name Tilt
+    .period 50
+    .var dot
+    .var num
+    .string fmt "X %d mg"
+    enter:  push 110
+            push 110
+            sys label
+            store dot
+            load dot
+            push "o"              ; 也可以直接写字符串
+            sys text
+            push 60
+            push 200
+            sys label
+            store num
+            ret
+    loop:   load dot
+            push 0
+            sys accel
+            push 10
+            div
+            push 110
+            add
+            push 110
+            sys pos
+            load num
+            push fmt
+            push 0
+            sys accel
+            sys num
+            ret
+"""
+import argparse, os, re, struct, sys
+
+MAGIC = b"HAPM"
+VERSION = 1
+API_VERSION = 1
+NAME_LEN = 16
+NO_ENTRY = 0xFFFF
+HEADER = struct.Struct("<4sHH16sHHHHHHHHIIIII")
+CODE_MAX = 65535
+DATA_MAX = 16 * 1024
+GLOBALS_MAX = 256
+STACK_MAX = 256
+
+# 助记符 -> (操作码, 立即数: None / "i32" / "u16" / "u8")
+OPS = {
+    "nop": (0x00, None), "push": (0x01, "i32"), "push8": (0x02, "i8"),
+    "dup": (0x03, None), "drop": (0x04, None), "swap": (0x05, None), "over": (0x06, None),
+    "load": (0x08, "u16"), "store": (0x09, "u16"), "loadi": (0x0A, None), "storei": (0x0B, None),
+    "add": (0x10, None), "sub": (0x11, None), "mul": (0x12, None), "div": (0x13, None),
+    "mod": (0x14, None), "neg": (0x15, None), "and": (0x16, None), "or": (0x17, None),
+    "xor": (0x18, None), "shl": (0x19, None), "shr": (0x1A, None), "not": (0x1B, None),
+    "eq": (0x20, None), "ne": (0x21, None), "lt": (0x22, None), "le": (0x23, None),
+    "gt": (0x24, None), "ge": (0x25, None),
+    "jmp": (0x30, "u16"), "jz": (0x31, "u16"), "jnz": (0x32, "u16"), "call": (0x33, "u16"),
+    "ret": (0x34, None), "sys": (0x38, "u8"), "halt": (0x3F, None),
+}
+SYSCALLS = ["millis", "label", "text", "num", "color", "pos", "bar", "bar_set", "hide", "bg",
+            "accel", "gyro", "lux", "time", "rand", "log"]
+ENTRIES = ("enter", "loop", "exit")
+
+
+class AsmError(Exception):
+    pass
+
+
+def split_line(line):
+    """去掉注释（引号内的';'保留），返回(标号或None, 记号列表)"""
+    out, quote = "", False
+    for ch in line:
+        if ch == '"':
+            quote = not quote
+        elif ch == ";" and not quote:
+            break
+        out += ch
+    label = None
+    m = re.match(r"\s*([A-Za-z_]\w*):(.*)$", out)
+    if m:
+        label, out = m.group(1), m.group(2)
+    return label, re.findall(r'"(?:[^"\\]|\\.)*"|\S+', out)
+
+
+def unquote(tok):
+    return bytes(tok[1:-1], "utf-8").decode("unicode_escape").encode("latin-1")
+
+
+def number(tok):
+    try:
+        return int(tok, 0)
+    except ValueError:
+        return None
+
+
+class Assembler:
+    def __init__(self):
+        self.name = None
+        self.period = 0
+        self.stack = 32
+        self.budget = {"steps": 0, "ram": 0, "cpu": 0}
+        self.vars = {}
+        self.globals = 0
+        self.strings = {}
+        self.data = bytearray()
+        self.labels = {}
+        self.items = []     # (行号, 助记符, 操作数)
+
+    def add_string(self, raw):
+        # 相同内容只存一份
+        pos = (b"\0" + bytes(self.data)).find(b"\0" + raw + b"\0")
+        if pos >= 0:
+            return pos
+        off = len(self.data)
+        self.data += raw + b"\0"
+        return off
+
+    def parse(self, text):
+        for no, line in enumerate(text.splitlines(), 1):
+            label, toks = split_line(line)
+            if label:
+                self.items.append((no, ":", label))
+            if not toks:
+                continue
+            op, args = toks[0].lower(), toks[1:]
+            if op.startswith("."):
+                self.directive(no, op, args)
+            elif op in OPS:
+                if len(args) != (0 if OPS[op][1] is None else 1):
+                    raise AsmError("第{}行: {}的操作数个数不对".format(no, op))
+                self.items.append((no, op, args[0] if args else None))
+            else:
+                raise AsmError("第{}行: 未知指令{}".format(no, op))
+
+    def directive(self, no, op, args):
+        def need(n):
+            if len(args) != n:
+                raise AsmError("第{}行: {}需要{}个参数".format(no, op, n))
+        if op == ".name":
+            need(1)
+            self.name = args[0].strip('"').encode("utf-8")
+            if not self.name or len(self.name) >= NAME_LEN:
+                raise AsmError("第{}行: 应用名为1~{}字节".format(no, NAME_LEN - 1))
+        elif op in (".period", ".stack"):
+            need(1)
+            setattr(self, op[1:], int(args[0], 0))
+        elif op == ".budget":
+            need(2)
+            if args[0] not in self.budget:
+                raise AsmError("第{}行: 预算为steps、ram或cpu".format(no))
+            self.budget[args[0]] = int(args[1], 0)
+        elif op == ".var":
+            if len(args) not in (1, 2):
+                raise AsmError("第{}行: .var 名称 [个数]".format(no))
+            self.vars[args[0]] = self.globals
+            self.globals += int(args[1], 0) if len(args) == 2 else 1
+        elif op == ".string":
+            need(2)
+            if not args[1].startswith('"'):
+                raise AsmError("第{}行: 字符串需要引号".format(no))
+            self.strings[args[0]] = self.add_string(unquote(args[1]))
+        else:
+            raise AsmError("第{}行: 未知伪指令{}".format(no, op))
+
+    def value(self, no, tok):
+        """push/load等的操作数；返回(值, 是否为标号)，标号在第一遍时返回None"""
+        n = number(tok)
+        if n is not None:
+            return n, False
+        if tok.startswith('"'):
+            return self.add_string(unquote(tok)), False
+        if tok in self.strings:
+            return self.strings[tok], False
+        if tok in self.vars:
+            return self.vars[tok], False
+        if tok in self.labels or tok in self.all_labels:
+            return self.labels.get(tok), True
+        raise AsmError("第{}行: 未定义的名称{}".format(no, tok))
+
+    def size(self, no, op, arg):
+        kind = OPS[op][1]
+        if op == "push":
+            v, is_label = self.value(no, arg)
+            return 5 if is_label or not -128 <= v <= 127 else 2
+        return 1 + {None: 0, "i32": 4, "i8": 1, "u16": 2, "u8": 1}[kind]
+
+    def assemble(self):
+        if self.name is None:
+            raise AsmError("缺少.name")
+        self.all_labels = {arg for no, op, arg in self.items if op == ":"}
+        # 第一遍：标号地址（push选用的长度只取决于操作数，标号一律用5字节）
+        pc = 0
+        for no, op, arg in self.items:
+            if op == ":":
+                if arg in self.labels:
+                    raise AsmError("第{}行: 重复的标号{}".format(no, arg))
+                self.labels[arg] = pc
+            else:
+                pc += self.size(no, op, arg)
+        # 第二遍：生成代码
+        code = bytearray()
+        for no, op, arg in self.items:
+            if op == ":":
+                continue
+            opcode, kind = OPS[op]
+            if op == "push":
+                v, is_label = self.value(no, arg)
+                if is_label or not -128 <= v <= 127:
+                    code += struct.pack("<Bi", opcode, v)
+                else:
+                    code += struct.pack("<Bb", OPS["push8"][0], v)
+            elif kind is None:
+                code.append(opcode)
+            elif kind == "u8":
+                sid = SYSCALLS.index(arg.lower()) if arg.lower() in SYSCALLS else number(arg)
+                if sid is None or not 0 <= sid < 256:
+                    raise AsmError("第{}行: 未知的系统调用{}".format(no, arg))
+                code += struct.pack("<BB", opcode, sid)
+            else:
+                v, _ = self.value(no, arg)
+                if kind == "i8" and not -128 <= v <= 127 or kind == "u16" and not 0 <= v <= 0xFFFF:
+                    raise AsmError("第{}行: 操作数{}超出范围".format(no, arg))
+                code += struct.pack("<Bb" if kind == "i8" else "<BH", opcode, v)
+
+        if not code or len(code) > CODE_MAX:
+            raise AsmError("代码长度为1~{}字节".format(CODE_MAX))
+        if len(self.data) > DATA_MAX:
+            raise AsmError("常量数据超过{}字节".format(DATA_MAX))
+        if self.globals > GLOBALS_MAX or not 0 < self.stack <= STACK_MAX:
+            raise AsmError("全局变量最多{}个，栈深度为1~{}".format(GLOBALS_MAX, STACK_MAX))
+        entries = [self.labels.get(e, NO_ENTRY) for e in ENTRIES]
+        if entries == [NO_ENTRY] * 3:
+            raise AsmError("没有enter/loop/exit入口")
+        header = HEADER.pack(MAGIC, VERSION, HEADER.size, self.name, API_VERSION, self.globals, self.stack,
+                             self.period, entries[0], entries[1], entries[2], 0, len(code), len(self.data),
+                             self.budget["ram"], self.budget["cpu"], self.budget["steps"])
+        return header + bytes(code) + bytes(self.data)
+
+
+def dump(data):
+    if len(data) < HEADER.size:
+        raise AsmError("文件过短")
+    (magic, version, header_size, name, api, globals_, stack, period, e_enter, e_loop, e_exit, _,
+     code_size, data_size, ram, cpu, steps) = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise AsmError("不是.ham文件")
+    print(".name {}  ; 版本{} API{}".format(name.rstrip(b"\0").decode("utf-8", "replace"), version, api))
+    print(".period {}\n.stack {}\n; 全局变量{}个 代码{}字节 数据{}字节 预算 steps={} ram={} cpu={}".format(
+        period, stack, globals_, code_size, data_size, steps, ram, cpu))
+    code = data[header_size:header_size + code_size]
+    entries = {e_enter: "enter", e_loop: "loop", e_exit: "exit"}
+    names = {v[0]: k for k, v in OPS.items()}
+    pc = 0
+    while pc < len(code):
+        if pc in entries:
+            print("{}:".format(entries[pc]))
+        op = names.get(code[pc])
+        if op is None:
+            print("  {:5d}  .byte 0x{:02X}".format(pc, code[pc]))
+            pc += 1
+            continue
+        kind = OPS[op][1]
+        n = {None: 0, "i32": 4, "i8": 1, "u16": 2, "u8": 1}[kind]
+        raw = code[pc + 1:pc + 1 + n]
+        if len(raw) < n:
+            print("  {:5d}  {} <截断>".format(pc, op))
+            break
+        if kind == "u8":
+            arg = SYSCALLS[raw[0]] if raw[0] < len(SYSCALLS) else str(raw[0])
+        elif kind:
+            arg = str(struct.unpack({"i32": "<i", "i8": "<b", "u16": "<H"}[kind], raw)[0])
+        else:
+            arg = ""
+        print("  {:5d}  {} {}".format(pc, op, arg))
+        pc += 1 + n
+
+
+def main():
+    ap = argparse.ArgumentParser(description="HoloCubic 应用模块（.ham）汇编工具")
+    ap.add_argument("source", help="汇编源文件（--dump时为.ham文件）")
+    ap.add_argument("-o", "--output", help="输出文件（默认与源文件同名的.ham）")
+    ap.add_argument("--dump", action="store_true", help="反汇编")
+    args = ap.parse_args()
+    try:
+        if args.dump:
+            with open(args.source, "rb") as f:
+                dump(f.read())
+            return
+        with open(args.source, encoding="utf-8") as f:
+            asm = Assembler()
+            asm.parse(f.read())
+        image = asm.assemble()
+        out = args.output or os.path.splitext(args.source)[0] + ".ham"
+        with open(out, "wb") as f:
+            f.write(image)
+        print("{}: {}字节（代码{}，数据{}，全局变量{}）".format(out, len(image), len(image) - HEADER.size - len(asm.data),
+              len(asm.data), asm.globals))
+    except (AsmError, OSError, ValueError) as e:
+        print("错误: {}".format(e), file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,290 @@
+"""
+HoloCubic 多设备管理工具（协议见固件include/fleet.h）
+
+    holo_fleet.py discover                                  广播STATUS，列出网段内的设备
+    holo_fleet.py status  [-H 主机 ...]                      查询状态（不指定主机时广播发现）
+    holo_fleet.py config  -k 密钥 [-H ...] 路径=值 ...         写入配置项（如log.sinks=3 wifi.ssid=MyAP）
+    holo_fleet.py scene   -k 密钥 [-H ...] 场景名 [--fps N]     切换场景（空名称""为停止）
+    holo_fleet.py sync    -k 密钥 [-H ...] 本地目录              同步到/Scenes/：只上传新文件与已有文件中变化的块
+    holo_fleet.py restart -k 密钥 [-H ...]
+
+多台设备并发处理（--jobs）；密钥与设备上的fleet.key相同，只用于写操作的认证。
+"""
+import argparse, binascii, hashlib, hmac, os, socket, struct, sys, time, urllib.parse, urllib.request
+from concurrent.futures import ThreadPoolExecutor
+
+FLEET_PORT = 7010
+MAGIC = b"HF"
+VERSION = 1
+TAG_LEN = 8
+OP_STATUS, OP_CONFIG, OP_SCENE, OP_SYNC, OP_RESTART, OP_CHUNKS = 1, 2, 3, 4, 5, 6
+REPLY = 0x80
+ERRORS = {0: "成功", 1: "认证失败", 2: "格式错误", 3: "不支持的操作", 4: "设备忙"}
+
+HEADER = struct.Struct("<2sBBIIHBB")
+STATUS = struct.Struct("<6sbBIIIIIHH24s32s36s")
+SYNC_ENTRY = struct.Struct("<II")
+CHUNKS = struct.Struct("<IIIHHHH")
+PKT_MAX = 1024
+SYNC_MAX = 32
+UPLOAD_ROOT = "/Scenes/"
+# SYNC/CHUNKS可能需要设备读一遍修改过的文件来计算清单，等待时间取更长的值
+SCAN_TIMEOUT = 20.0
+
+
+def _cstr(b):
+    return b.split(b"\0", 1)[0].decode("utf-8", "replace")
+
+
+def parse_status(payload):
+    (mac, rssi, flags, uptime, heap_free, heap_min, frames, scenes, http_port, _,
+     name, fw, scene) = STATUS.unpack_from(payload)
+    return {"mac": ":".join("%02x" % b for b in mac), "rssi": rssi, "writable": bool(flags & 1),
+            "upload": bool(flags & 2), "uptime": uptime, "heap_free": heap_free, "heap_min": heap_min,
+            "frames": frames, "scenes": scenes, "http_port": http_port, "name": _cstr(name),
+            "firmware": _cstr(fw), "scene": _cstr(scene)}
+
+
+class Cube:
+    """一台设备：先经STATUS取得会话号，写操作按毫秒时间递增序号"""
+
+    def __init__(self, host, key=None, timeout=1.0, retries=3):
+        self.host = host
+        self.key = key.encode() if key else None
+        self.timeout = timeout
+        self.retries = retries
+        self.session = 0
+        self.seq = int(time.time() * 1000) & 0xFFFFFFFF
+        self.status = None
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(timeout)
+
+    def request(self, op, payload=b""):
+        """发送请求并等待回复，超时重试（设备计算CRC期间不响应）"""
+        for _ in range(self.retries):
+            self.seq = (self.seq + 1) & 0xFFFFFFFF
+            pkt = HEADER.pack(MAGIC, VERSION, op, self.session, self.seq, len(payload), 0, 0) + payload
+            if op != OP_STATUS:
+                if self.key is None:
+                    raise RuntimeError("写操作需要密钥（-k）")
+                pkt += hmac.new(self.key, pkt, hashlib.sha256).digest()[:TAG_LEN]
+            self.sock.sendto(pkt, (self.host, FLEET_PORT))
+            deadline = time.time() + (max(self.timeout, SCAN_TIMEOUT) if op in (OP_SYNC, OP_CHUNKS) else self.timeout)
+            while time.time() < deadline:
+                self.sock.settimeout(max(deadline - time.time(), 0.01))
+                try:
+                    data, _ = self.sock.recvfrom(PKT_MAX)
+                except socket.timeout:
+                    break
+                if len(data) < HEADER.size:
+                    continue
+                magic, ver, rop, session, seq, length, status, _ = HEADER.unpack_from(data)
+                if magic != MAGIC or rop != op | REPLY or seq != self.seq:
+                    continue
+                self.session = session
+                return status, data[HEADER.size:HEADER.size + length]
+        raise TimeoutError("{} 无响应".format(self.host))
+
+    def check(self, op, payload=b""):
+        status, reply = self.request(op, payload)
+        if status != 0:
+            raise RuntimeError("{}: {}".format(self.host, ERRORS.get(status, status)))
+        return reply
+
+    def get_status(self):
+        self.status = parse_status(self.check(OP_STATUS))
+        return self.status
+
+    def set_config(self, items):
+        payload = b"".join(p.encode() + b"\0" + v.encode() + b"\0" for p, v in items)
+        reply = self.check(OP_CONFIG, payload)
+        return reply[0], reply[1]
+
+    def set_scene(self, name, fps=0):
+        self.check(OP_SCENE, struct.pack("<B", fps) + name.encode() + b"\0")
+
+    def restart(self):
+        self.check(OP_RESTART)
+
+    def diff(self, manifest):
+        """manifest为[(设备路径, 大小, crc32)]，返回需要上传的条目"""
+        need = []
+        batch = []
+        for entry in manifest + [None]:
+            if entry is not None:
+                item = SYNC_ENTRY.pack(entry[1], entry[2]) + entry[0].encode() + b"\0"
+                if len(batch) < SYNC_MAX and HEADER.size + sum(len(b[1]) for b in batch) + len(item) + TAG_LEN <= PKT_MAX:
+                    batch.append((entry, item))
+                    continue
+            if batch:
+                reply = self.check(OP_SYNC, b"".join(b[1] for b in batch))
+                for i, (e, _) in enumerate(batch[:reply[0]]):
+                    if reply[1 + i // 8] & (1 << (i % 8)):
+                        need.append(e)
+            batch = [(entry, item)] if entry is not None else []
+        return need
+
+    def chunks(self, path):
+        """取设备上文件的块CRC，返回(文件大小, 块大小, [crc, ...])；文件不存在时返回None"""
+        crcs = []
+        while True:
+            status, reply = self.request(OP_CHUNKS, struct.pack("<H", len(crcs)) + path.encode() + b"\0")
+            if status == 2:
+                return None
+            if status != 0:
+                raise RuntimeError("{}: {}".format(self.host, ERRORS.get(status, status)))
+            size, _, chunk_size, count, first, n, _ = CHUNKS.unpack_from(reply)
+            crcs += struct.unpack_from("<{}I".format(n), reply, CHUNKS.size)
+            if n == 0 or len(crcs) >= count:
+                return size, chunk_size, crcs
+
+    def put(self, data, **params):
+        """PUT /upload（设备边收边写SD卡）"""
+        port = self.status["http_port"] if self.status else 80
+        url = "http://{}:{}/upload?{}".format(self.host, port, urllib.parse.urlencode(params))
+        req = urllib.request.Request(url, data=data, method="PUT", headers={"Content-Length": str(len(data))})
+        with urllib.request.urlopen(req, timeout=60) as r:
+            r.read()
+
+    def upload(self, local, path, size):
+        """整个上传一个文件，返回上传的字节数"""
+        port = self.status["http_port"] if self.status else 80
+        url = "http://{}:{}/upload?{}".format(self.host, port, urllib.parse.urlencode({"path": path, "size": size}))
+        with open(local, "rb") as f:
+            req = urllib.request.Request(url, data=f, method="PUT", headers={"Content-Length": str(size)})
+            with urllib.request.urlopen(req, timeout=60) as r:
+                r.read()
+        return size
+
+    def patch(self, local, path, size):
+        """差量上传：比较块CRC，只改写变化的块与新增的尾部，返回上传的字节数
+        设备上没有该文件或本地文件更短（patch不能截短文件）时整个上传"""
+        remote = self.chunks(path)
+        if remote is None or size < remote[0] or remote[1] == 0:
+            return self.upload(local, path, size)
+        _, chunk_size, crcs = remote
+        pending = []
+        with open(local, "rb") as f:
+            for i in range((size + chunk_size - 1) // chunk_size):
+                data = f.read(chunk_size)
+                if i >= len(crcs) or binascii.crc32(data) & 0xFFFFFFFF != crcs[i]:
+                    pending.append((i * chunk_size, data))
+        # 按偏移递增写入，追加的块总是从设备文件的当前末尾开始；最后一块带final更新场景索引
+        for n, (offset, data) in enumerate(pending):
+            self.put(data, path=path, patch=1, offset=offset, final=int(n == len(pending) - 1))
+        return sum(len(d) for _, d in pending)
+
+
+def discover(timeout=1.0):
+    """广播STATUS，返回{IP: 状态}"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    sock.settimeout(timeout)
+    sock.sendto(HEADER.pack(MAGIC, VERSION, OP_STATUS, 0, 0, 0, 0, 0), ("255.255.255.255", FLEET_PORT))
+    found = {}
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            data, addr = sock.recvfrom(PKT_MAX)
+        except socket.timeout:
+            break
+        if len(data) >= HEADER.size + STATUS.size and data[:2] == MAGIC and data[3] == OP_STATUS | REPLY:
+            found[addr[0]] = parse_status(data[HEADER.size:])
+    return found
+
+
+def build_manifest(root):
+    manifest = []
+    for d, _, files in os.walk(root):
+        for name in sorted(files):
+            local = os.path.join(d, name)
+            rel = os.path.relpath(local, root).replace(os.sep, "/")
+            crc = 0
+            with open(local, "rb") as f:
+                for chunk in iter(lambda: f.read(1 << 16), b""):
+                    crc = binascii.crc32(chunk, crc)
+            manifest.append((UPLOAD_ROOT + rel, os.path.getsize(local), crc & 0xFFFFFFFF, local))
+    return manifest
+
+
+def print_status(host, s):
+    print("{:<15} {:<24} {} RSSI {:>4} 运行{}s 堆{}/{} 帧{} 场景{} 固件{} {}{}".format(
+        host, s["name"], s["mac"], s["rssi"], s["uptime"], s["heap_free"], s["heap_min"],
+        s["frames"], s["scenes"], s["firmware"], s["scene"] or "-", "" if s["writable"] else " (只读)"))
+
+
+def run(args, host):
+    cube = Cube(host, args.key, args.timeout)
+    s = cube.get_status()
+    if args.cmd == "status":
+        return s
+    if args.cmd == "config":
+        items = [i.split("=", 1) for i in args.items]
+        applied, rejected = cube.set_config(items)
+        return "写入{}项，拒绝{}项".format(applied, rejected)
+    if args.cmd == "scene":
+        cube.set_scene(args.name, args.fps)
+        return "已切换到{}".format(args.name or "（停止）")
+    if args.cmd == "restart":
+        cube.restart()
+        return "正在重启"
+    if args.cmd == "sync":
+        if not s["upload"]:
+            raise RuntimeError("{}: 上传服务未运行".format(host))
+        need = cube.diff([m[:3] for m in args.manifest])
+        locals_ = {m[0]: m[3] for m in args.manifest}
+        sent = 0
+        for path, size, _ in need:
+            sent += (cube.patch if args.delta else cube.upload)(locals_[path], path, size)
+        total = sum(m[1] for m in args.manifest)
+        return "共{}个文件，{}个有变化，上传{}/{}字节".format(len(args.manifest), len(need), sent, total)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="HoloCubic 多设备管理")
+    parser.add_argument("cmd", choices=["discover", "status", "config", "scene", "sync", "restart"])
+    parser.add_argument("args", nargs="*")
+    parser.add_argument("-H", "--host", action="append", help="设备IP或<name>.local，可重复；不指定时广播发现")
+    parser.add_argument("-k", "--key", help="共享密钥（fleet.key）")
+    parser.add_argument("--fps", type=int, default=0, help="scene: 播放帧率，0为场景默认")
+    parser.add_argument("--jobs", type=int, default=8, help="同时处理的设备数")
+    parser.add_argument("--no-delta", dest="delta", action="store_false", help="sync: 有变化的文件整个上传")
+    parser.add_argument("--timeout", type=float, default=1.0)
+    args = parser.parse_args()
+
+    if args.cmd == "discover":
+        for host, s in sorted(discover(args.timeout).items()):
+            print_status(host, s)
+        sys.exit(0)
+
+    if args.cmd == "config":
+        args.items = args.args
+        if not args.items or any("=" not in i for i in args.items):
+            parser.error("config需要 路径=值 参数")
+    elif args.cmd == "scene":
+        args.name = args.args[0] if args.args else ""
+    elif args.cmd == "sync":
+        if len(args.args) != 1 or not os.path.isdir(args.args[0]):
+            parser.error("sync需要一个本地目录")
+        args.manifest = build_manifest(args.args[0])
+
+    hosts = args.host or sorted(discover(args.timeout))
+    if not hosts:
+        print("没有发现设备")
+        sys.exit(1)
+
+    failed = 0
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = {host: pool.submit(run, args, host) for host in hosts}
+        for host, fut in futures.items():
+            try:
+                result = fut.result()
+            except Exception as e:
+                print("{:<15} 失败: {}".format(host, e))
+                failed += 1
+                continue
+            if isinstance(result, dict):
+                print_status(host, result)
+            else:
+                print("{:<15} {}".format(host, result))
+    sys.exit(1 if failed else 0)
@@ -0,0 +1,314 @@
+"""
+HoloCubic 串口传输工具（协议见固件include/serial_link.h，代替HoloTool.exe）
+
+    holo_link.py -p 端口 push  本地文件或目录 [远端路径]     写入SD卡（目录默认推送到/Scenes/）
+    holo_link.py -p 端口 pull  远端路径 [本地路径]           读取文件（如/log/holo.log）
+    holo_link.py -p 端口 logs  [本地目录]                   拉取/log/下的日志
+    holo_link.py -p 端口 bench [本地目录]                   拉取/bench/下的基准报告
+    holo_link.py -p 端口 ls    [远端目录]
+
+-p可重复，多台设备并发传输；本地目录为多台设备时按端口名分子目录。
+握手后切换到--baud（默认2M），窗口内的帧连续发送，丢帧时从设备确认的偏移重发。
+依赖pyserial（pip install pyserial）。
+"""
+import argparse, binascii, os, struct, sys, time
+from concurrent.futures import ThreadPoolExecutor
+
+import serial
+
+BOOT_BAUD = 115200
+LINK_BAUD = 2000000
+MAGIC = b"\xa5\x5a"
+HELLO, PUT, DATA, END, GET, LIST, BYE, ACK = 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80
+OK, E_OFFSET = 0, 1
+ERRORS = {1: "偏移不连续", 2: "路径无效", 3: "SD卡读写失败", 4: "CRC不符", 5: "状态错误"}
+
+HEADER = struct.Struct("<2sBBH")
+PAYLOAD_MAX = 1028
+# 写入确认超时（设备写SD卡期间不读串口，取较长的值）
+ACK_TIMEOUT = 0.5
+# END需要改名并更新场景索引
+END_TIMEOUT = 15.0
+RETRIES = 10
+
+
+class LinkError(Exception):
+    pass
+
+
+class Link:
+    """一个串口上的一台设备"""
+
+    def __init__(self, port, baud=LINK_BAUD):
+        self.port = port
+        self.ser = serial.Serial()
+        self.ser.port = port
+        self.ser.baudrate = BOOT_BAUD
+        self.ser.timeout = 0.02
+        # 不拉DTR/RTS（自动下载电路会复位ESP32）
+        self.ser.dtr = False
+        self.ser.rts = False
+        self.ser.open()
+        self.buf = bytearray()
+        self.seq = 0
+        self.window = 8
+        self.data_max = 1024
+        self.hello(baud)
+
+    def close(self):
+        try:
+            self.request(BYE, b"", retries=1)
+        except LinkError:
+            pass
+        self.ser.close()
+
+    def send(self, type_, payload, seq=None):
+        if seq is None:
+            seq = self.seq = (self.seq + 1) & 0xFF
+        body = struct.pack("<BBH", type_, seq, len(payload)) + payload
+        self.ser.write(MAGIC + body + struct.pack("<I", binascii.crc32(body) & 0xFFFFFFFF))
+        return seq
+
+    def recv(self, timeout):
+        """读一个CRC正确的帧，返回(type, seq, payload)，超时返回None；帧之外的字节（设备日志）丢弃"""
+        deadline = time.time() + timeout
+        while True:
+            i = self.buf.find(MAGIC)
+            if i < 0:
+                del self.buf[:max(0, len(self.buf) - 1)]
+            else:
+                del self.buf[:i]
+                if len(self.buf) >= HEADER.size:
+                    _, type_, seq, n = HEADER.unpack_from(self.buf)
+                    if n > PAYLOAD_MAX:
+                        del self.buf[:2]
+                        continue
+                    total = HEADER.size + n + 4
+                    if len(self.buf) >= total:
+                        frame = bytes(self.buf[:total])
+                        crc, = struct.unpack_from("<I", frame, total - 4)
+                        if binascii.crc32(frame[2:total - 4]) & 0xFFFFFFFF == crc:
+                            del self.buf[:total]
+                            return type_, seq, frame[HEADER.size:total - 4]
+                        del self.buf[:2]
+                        continue
+            if time.time() >= deadline:
+                return None
+            self.buf += self.ser.read(max(1, self.ser.in_waiting))
+
+    def request(self, type_, payload, timeout=1.0, retries=3):
+        """发送请求并等待对应seq的ACK，返回(值, 附加数据)"""
+        for _ in range(retries):
+            seq = self.send(type_, payload)
+            deadline = time.time() + timeout
+            while time.time() < deadline:
+                f = self.recv(deadline - time.time())
+                if f and f[0] == ACK and f[1] == seq and len(f[2]) >= 5:
+                    status, value = struct.unpack_from("<BI", f[2])
+                    if status != OK:
+                        raise LinkError("{}（{}）".format(ERRORS.get(status, status), value))
+                    return value, f[2][5:]
+        raise LinkError("设备无响应")
+
+    def hello(self, baud):
+        # 设备可能已处于传输模式（上次异常退出），两种波特率都尝试
+        for _ in range(6):
+            for b in (BOOT_BAUD, baud):
+                self.ser.baudrate = b
+                self.ser.reset_input_buffer()
+                self.buf.clear()
+                try:
+                    value, info = self.request(HELLO, struct.pack("<I", baud), timeout=0.5, retries=1)
+                except LinkError:
+                    continue
+                _, self.window, self.data_max = struct.unpack_from("<BBH", info)
+                self.ser.baudrate = value
+                return
+        raise LinkError("{}: 握手失败".format(self.port))
+
+    def put(self, local, remote):
+        with open(local, "rb") as f:
+            data = f.read()
+        size = len(data)
+        self.request(PUT, struct.pack("<I", size) + remote.encode())
+
+        acked = sent = 0
+        timeouts = 0
+        span = self.window * self.data_max
+        while acked < size:
+            while sent < size and sent - acked < span:
+                n = min(self.data_max, size - sent)
+                self.send(DATA, struct.pack("<I", sent) + data[sent:sent + n])
+                sent += n
+            f = self.recv(ACK_TIMEOUT)
+            if f is None:
+                timeouts += 1
+                if timeouts > RETRIES:
+                    raise LinkError("{}: 写入无确认".format(remote))
+                sent = acked
+                continue
+            if f[0] != ACK or len(f[2]) < 5:
+                continue
+            status, value = struct.unpack_from("<BI", f[2])
+            if status == OK:
+                acked = max(acked, min(value, sent))
+                timeouts = 0
+            elif status == E_OFFSET:
+                # go-back-N：从设备期望的偏移重发
+                acked = sent = value
+            else:
+                raise LinkError("{}: {}".format(remote, ERRORS.get(status, status)))
+
+        self.request(END, struct.pack("<II", size, binascii.crc32(data) & 0xFFFFFFFF), timeout=END_TIMEOUT, retries=1)
+        return size
+
+    def get(self, remote, start=0):
+        size, _ = self.request(GET, struct.pack("<I", start) + remote.encode())
+        out = bytearray()
+        pos = start
+        silent = 0
+        while True:
+            f = self.recv(1.0)
+            if f is None:
+                # 设备超时后自行重发
+                silent += 1
+                if silent > RETRIES:
+                    raise LinkError("{}: 读取无响应".format(remote))
+                continue
+            silent = 0
+            type_, seq, p = f
+            if type_ == DATA and len(p) >= 4:
+                off, = struct.unpack_from("<I", p)
+                if off == pos:
+                    out += p[4:]
+                    pos += len(p) - 4
+                self.send(ACK, struct.pack("<BI", OK, pos), seq)
+            elif type_ == END and len(p) >= 8:
+                total, crc = struct.unpack_from("<II", p)
+                if total != size or pos != size:
+                    raise LinkError("{}: 读取中断（{}/{}）".format(remote, pos, size))
+                if binascii.crc32(out) & 0xFFFFFFFF != crc:
+                    raise LinkError("{}: CRC不符".format(remote))
+                return bytes(out)
+
+    def list(self, remote):
+        """返回[(名称, 长度)]，目录的长度为-1"""
+        items = []
+        while True:
+            count, text = self.request(LIST, struct.pack("<H", len(items)) + remote.encode())
+            if count == 0:
+                return items
+            for line in text.decode("utf-8", "replace").splitlines():
+                name, n = line.rsplit("\t", 1)
+                items.append((name, int(n)))
+            # 过长的名称被跳过但计入项数
+            items += [("", 0)] * (count - len(text.splitlines()))
+
+
+def push(link, local, remote, update):
+    if os.path.isfile(local):
+        files = [(local, remote or "/Scenes/" + os.path.basename(local))]
+    else:
+        root = (remote or "/Scenes").rstrip("/")
+        files = []
+        for d, _, names in os.walk(local):
+            for name in sorted(names):
+                path = os.path.join(d, name)
+                files.append((path, root + "/" + os.path.relpath(path, local).replace(os.sep, "/")))
+
+    remote_sizes = {}
+    sent = skipped = 0
+    start = time.time()
+    for path, dst in files:
+        if update:
+            parent, name = dst.rsplit("/", 1)
+            if parent not in remote_sizes:
+                try:
+                    remote_sizes[parent] = dict(link.list(parent or "/"))
+                except LinkError:
+                    remote_sizes[parent] = {}
+            if remote_sizes[parent].get(name) == os.path.getsize(path):
+                skipped += 1
+                continue
+        t = time.time()
+        n = link.put(path, dst)
+        sent += n
+        print("{} {} {}字节 {:.0f} KB/s".format(link.port, dst, n, n / 1024 / max(time.time() - t, 1e-3)))
+    elapsed = max(time.time() - start, 1e-3)
+    return "推送{}个文件（跳过{}），{}字节，平均{:.0f} KB/s".format(len(files) - skipped, skipped, sent, sent / 1024 / elapsed)
+
+
+def pull(link, remote, local):
+    t = time.time()
+    data = link.get(remote)
+    if os.path.dirname(local):
+        os.makedirs(os.path.dirname(local), exist_ok=True)
+    with open(local, "wb") as f:
+        f.write(data)
+    return "{} -> {} {}字节 {:.0f} KB/s".format(remote, local, len(data), len(data) / 1024 / max(time.time() - t, 1e-3))
+
+
+def pull_dir(link, remote, local):
+    results = []
+    for name, size in link.list(remote):
+        if name and size >= 0:
+            results.append(pull(link, remote + "/" + name, os.path.join(local, name)))
+    return "\n".join(results) or "{}为空".format(remote)
+
+
+def run(args, port):
+    link = Link(port, args.baud)
+    try:
+        local = args.local
+        if local and len(args.port) > 1:
+            local = os.path.join(local, os.path.basename(port))
+        if args.cmd == "push":
+            return push(link, args.local, args.remote, args.update)
+        if args.cmd == "pull":
+            return pull(link, args.remote, local or os.path.basename(args.remote))
+        if args.cmd == "logs":
+            return pull_dir(link, "/log", local or "log")
+        if args.cmd == "bench":
+            return pull_dir(link, "/bench", local or "bench")
+        if args.cmd == "ls":
+            return "\n".join("{:>10} {}".format("<DIR>" if n < 0 else n, name)
+                             for name, n in link.list(args.remote or "/") if name)
+    finally:
+        link.close()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="HoloCubic 串口传输")
+    parser.add_argument("cmd", choices=["push", "pull", "logs", "bench", "ls"])
+    parser.add_argument("args", nargs="*")
+    parser.add_argument("-p", "--port", action="append", required=True, help="串口（COM5、/dev/ttyUSB0），可重复")
+    parser.add_argument("--baud", type=int, default=LINK_BAUD, help="握手后的波特率")
+    parser.add_argument("--update", action="store_true", help="push: 跳过设备上长度相同的文件")
+    args = parser.parse_args()
+
+    args.local = args.remote = None
+    if args.cmd == "push":
+        if not args.args or not os.path.exists(args.args[0]):
+            parser.error("push需要本地文件或目录")
+        args.local = args.args[0]
+        args.remote = args.args[1] if len(args.args) > 1 else None
+    elif args.cmd == "pull":
+        if not args.args:
+            parser.error("pull需要远端路径")
+        args.remote = args.args[0]
+        args.local = args.args[1] if len(args.args) > 1 else None
+    elif args.cmd in ("logs", "bench"):
+        args.local = args.args[0] if args.args else None
+    elif args.cmd == "ls":
+        args.remote = args.args[0] if args.args else None
+
+    failed = 0
+    with ThreadPoolExecutor(max_workers=len(args.port)) as pool:
+        futures = {port: pool.submit(run, args, port) for port in args.port}
+        for port, fut in futures.items():
+            try:
+                print("{} {}".format(port, fut.result()))
+            except (LinkError, serial.SerialException, OSError) as e:
+                print("{} 失败: {}".format(port, e))
+                failed += 1
+    sys.exit(1 if failed else 0)
@@ -0,0 +1,126 @@
+"""
+HoloCubic 传感器数据记录转换工具（格式见固件include/data_log_format.h）
+
+    holo_log.py log_00001.hdl                 转换为同名.csv
+    holo_log.py log_*.hdl -o room.csv         按文件序号依次合并为一个CSV（轮换生成的连续文件）
+    holo_log.py log_00001.hdl --info          只输出采样率、样本数、时长与丢块间隔
+
+CSV列：t_s（相对第一个文件开始的秒数）, epoch（时钟已同步时的Unix时间）, ax ay az（g）, gx gy gz（°/s）, lux
+环境光每块只有一个读数（约每秒8次），没有新读数的行lux为空。
+丢弃的块（设备上SD卡写入来不及）表现为时间间隔变大，--info中列出超过3个采样周期的间隔。
+"""
+import argparse, glob, os, struct, sys
+
+MAGIC = b"HDLG"
+VERSION = 1
+HEADER = struct.Struct("<4sHHHHIIBBH")
+BLOCK = struct.Struct("<BBHI")
+SAMPLE = struct.Struct("<H6h")
+BLOCK_TAG = 0xB1
+LUX_NONE = 0xFFFF
+ACCEL_LSB = 16384.0
+GYRO_LSB = 131.0
+
+
+class LogError(Exception):
+    pass
+
+
+def read_header(data):
+    if len(data) < HEADER.size:
+        raise LogError("文件过短")
+    magic, version, header_size, rate, seq, start_ms, epoch, block_size, sample_size, _ = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise LogError("不是.hdl文件")
+    if version > VERSION:
+        raise LogError("不支持的版本{}".format(version))
+    if block_size < BLOCK.size or sample_size < SAMPLE.size:
+        raise LogError("块或样本长度无效")
+    return dict(rate=rate, seq=seq, start_ms=start_ms, epoch=epoch, header_size=header_size,
+                block_size=block_size, sample_size=sample_size)
+
+
+def read_samples(data, h):
+    """依次返回(t_us, lux或None, [ax ay az gx gy gz])，t_us相对文件开始；文件末尾不完整的块忽略"""
+    pos = h["header_size"]
+    while pos + h["block_size"] <= len(data):
+        tag, count, lux, t_us = BLOCK.unpack_from(data, pos)
+        if tag != BLOCK_TAG:
+            raise LogError("偏移{}处的块标记无效: 0x{:02X}".format(pos, tag))
+        pos += h["block_size"]
+        if pos + count * h["sample_size"] > len(data):
+            return
+        for i in range(count):
+            dt, *v = SAMPLE.unpack_from(data, pos)
+            pos += h["sample_size"]
+            t_us += dt
+            # 环境光记在块中最后一个样本上
+            yield t_us, (lux if lux != LUX_NONE and i == count - 1 else None), v
+
+
+def open_log(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    return read_header(data), data
+
+
+def info(paths):
+    for path in paths:
+        h, data = open_log(path)
+        n, last, gaps = 0, None, []
+        period = 1e6 / h["rate"] if h["rate"] else 0
+        for t, lux, v in read_samples(data, h):
+            if last is not None and period and t - last > 3 * period:
+                gaps.append((last / 1e6, (t - last) / 1e3))
+            last = t
+            n += 1
+        dur = last / 1e6 if last is not None else 0
+        print("{}: 序号{} {}Hz 样本{} 时长{:.1f}s{}".format(os.path.basename(path), h["seq"], h["rate"], n, dur,
+              " 开始于{}".format(h["epoch"]) if h["epoch"] else ""))
+        for at, ms in gaps[:20]:
+            print("  间隔 {:.3f}s处 {:.1f}ms".format(at, ms))
+        if len(gaps) > 20:
+            print("  ……共{}处".format(len(gaps)))
+
+
+def convert(paths, out_path):
+    logs = sorted((open_log(p) for p in paths), key=lambda l: l[0]["seq"])
+    base_ms = logs[0][0]["start_ms"]
+    with open(out_path, "w") as out:
+        out.write("t_s,epoch,ax,ay,az,gx,gy,gz,lux\n")
+        rows = 0
+        for h, data in logs:
+            # 各文件的开始时间按millis()对齐到第一个文件（模2^32）
+            offset_us = ((h["start_ms"] - base_ms) & 0xFFFFFFFF) * 1000
+            for t, lux, v in read_samples(data, h):
+                t_s = (offset_us + t) / 1e6
+                epoch = "{:.3f}".format(h["epoch"] + t / 1e6) if h["epoch"] else ""
+                out.write("{:.4f},{},{:.4f},{:.4f},{:.4f},{:.2f},{:.2f},{:.2f},{}\n".format(
+                    t_s, epoch, v[0] / ACCEL_LSB, v[1] / ACCEL_LSB, v[2] / ACCEL_LSB,
+                    v[3] / GYRO_LSB, v[4] / GYRO_LSB, v[5] / GYRO_LSB, "" if lux is None else lux))
+                rows += 1
+    print("{}: {}行（{}个文件）".format(out_path, rows, len(logs)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="HoloCubic .hdl传感器记录转换为CSV")
+    ap.add_argument("files", nargs="+", help=".hdl文件（可用通配符）")
+    ap.add_argument("-o", "--output", help="输出CSV（默认与第一个文件同名）")
+    ap.add_argument("--info", action="store_true", help="只输出统计")
+    args = ap.parse_args()
+
+    paths = []
+    for p in args.files:
+        paths += sorted(glob.glob(p)) or [p]
+    try:
+        if args.info:
+            info(paths)
+        else:
+            convert(paths, args.output or os.path.splitext(paths[0])[0] + ".csv")
+    except (LogError, OSError) as e:
+        print("错误: {}".format(e), file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
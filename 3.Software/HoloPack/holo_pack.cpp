@@ -0,0 +1,1156 @@
+/*
+ * HoloPack 主机端素材编译工具
+ *
+ * 功能说明：
+ * 1. 把图片帧转换为LVGL .bin，或打包为.holo动画包（完整帧或分块差分帧）
+ * 2. 像素格式不另写一份：直接编译固件的lvgl（2.Firmware/HoloCubic-fw/lib/lvgl及其lv_conf.h），
+ *    图像头、数据大小、像素写入与颜色换算都使用lv_img_buf/lv_color的实现，
+ *    字节序（LV_COLOR_16_SWAP）与颜色深度随固件配置变化；.holo布局使用固件的holo_format.h
+ * 3. 多帧按批读入，批内按帧分给各CPU核并行转换，按输入顺序写出
+ * 4. 16位真彩色的颜色换算有SSE2路径（每次8像素），启动时逐一与lv_color_make比对，
+ *    结果不一致则退回lv_color_make
+ * 5. .holo的16位真彩色帧可以Q565压缩（--q565，格式见固件的q565_decoder.h）
+ * 6. 界面叠加层可输出为预乘alpha图像（--cf premul_alpha，格式见固件的premul_decoder.h）
+ * 7. .holo可内嵌关键帧的1/2、1/4、1/8缩略图（--mips、--mip-every），供场景浏览界面直接显示
+ *
+ * 输入为PAM(P7)/PPM(P6)/PGM(P5)，8位通道；一个文件（或标准输入"-"）中可以连续存放多帧。
+ * PNG/GIF/MP4等先由ffmpeg解码并缩放，例如：
+ *   ffmpeg -i in.mp4 -vf scale=240:240 -c:v pam -f image2pipe - | holo_pack --holo out.holo -
+ *   ffmpeg -i logo.png -c:v pam -f image2pipe logo.pam && holo_pack --cf true_color_alpha logo.pam
+ *
+ * 与ImageToHolo的区别：真彩色按lv_color_make截断取高位、不做抖动，与固件运行时换算一致；
+ * 不生成索引色格式（需要调色板量化，仍使用ImageToHolo）
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "lvgl.h"
+#include "holo_format.h"
+#include "q565_decoder.h"
+#include "premul_decoder.h"
+
+#if (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && LV_COLOR_DEPTH == 16
+#include <emmintrin.h>
+#define HOLO_PACK_SSE2 1
+#else
+#define HOLO_PACK_SSE2 0
+#endif
+
+namespace fs = std::filesystem;
+
+// 每批读入的帧数 = 线程数 * HOLO_PACK_BATCH，批内并行转换，内存占用与批大小成正比
+#define HOLO_PACK_BATCH 8
+#define HOLO_PACK_DEFAULT_ALIGN 4096
+#define HOLO_PACK_DEFAULT_TILE 16
+// lv_img_header_t中宽高各11位
+#define HOLO_PACK_MAX_SIZE 2047
+
+/**
+ * 一帧：读入的RGBA8888像素与转换结果（完整的.bin内容）
+ */
+struct Frame
+{
+	std::string name;          // 输出.bin的文件名（不含扩展名）
+	uint16_t w;
+	uint16_t h;
+	std::vector<uint8_t> rgba;
+	std::vector<uint8_t> bin;
+	uint32_t ambient;          // 平均色0x00RRGGBB，写入.holo帧索引
+	bool key;                  // 生成缩略图的关键帧
+	std::vector<std::vector<uint8_t>> mips;    // 各级缩略图的.bin内容，依次为1/2、1/4、1/8尺寸
+};
+
+struct ColorFormat
+{
+	const char* name;
+	lv_img_cf_t cf;
+};
+
+static const ColorFormat color_formats[] = {
+	{ "true_color", LV_IMG_CF_TRUE_COLOR },
+	{ "true_color_alpha", LV_IMG_CF_TRUE_COLOR_ALPHA },
+	{ "alpha_1", LV_IMG_CF_ALPHA_1BIT },
+	{ "alpha_2", LV_IMG_CF_ALPHA_2BIT },
+	{ "alpha_4", LV_IMG_CF_ALPHA_4BIT },
+	{ "alpha_8", LV_IMG_CF_ALPHA_8BIT },
+	{ "premul_alpha", LV_IMG_CF_RAW_ALPHA },   // 预乘alpha图像的图像头cf
+};
+
+static bool simd_ok = HOLO_PACK_SSE2;
+
+/**
+ * 读取一个PNM记号：跳过空白与#注释，读到空白为止（结束的那个空白字符被吃掉，
+ * 正好符合P5/P6中maxval后只有一个空白字符再接像素数据的规定）
+ */
+static bool readToken(FILE* fp, char* buf, size_t n)
+{
+	int c = fgetc(fp);
+	while (c != EOF && (isspace(c) || c == '#'))
+	{
+		if (c == '#')
+		{
+			while (c != EOF && c != '\n') c = fgetc(fp);
+		}
+		c = fgetc(fp);
+	}
+	size_t len = 0;
+	while (c != EOF && !isspace(c))
+	{
+		if (len + 1 < n) buf[len++] = (char)c;
+		c = fgetc(fp);
+	}
+	buf[len] = 0;
+	return len > 0;
+}
+
+static bool readNumber(FILE* fp, uint32_t* out)
+{
+	char tok[32];
+	if (!readToken(fp, tok, sizeof(tok))) return false;
+	char* end;
+	unsigned long v = strtoul(tok, &end, 10);
+	if (*end) return false;
+	*out = (uint32_t)v;
+	return true;
+}
+
+/**
+ * 从流中读取下一幅PAM/PPM/PGM图像，转为RGBA8888
+ * @return 1 读到一帧，0 流结束，-1 格式错误
+ */
+static int readFrame(FILE* fp, Frame* f)
+{
+	char tok[32];
+	if (!readToken(fp, tok, sizeof(tok))) return 0;
+
+	uint32_t w = 0, h = 0, depth = 0, maxval = 0;
+	if (strcmp(tok, "P7") == 0)
+	{
+		while (readToken(fp, tok, sizeof(tok)) && strcmp(tok, "ENDHDR") != 0)
+		{
+			if (strcmp(tok, "WIDTH") == 0) readNumber(fp, &w);
+			else if (strcmp(tok, "HEIGHT") == 0) readNumber(fp, &h);
+			else if (strcmp(tok, "DEPTH") == 0) readNumber(fp, &depth);
+			else if (strcmp(tok, "MAXVAL") == 0) readNumber(fp, &maxval);
+			else if (strcmp(tok, "TUPLTYPE") == 0) readToken(fp, tok, sizeof(tok));
+			else return -1;
+		}
+	}
+	else if (strcmp(tok, "P6") == 0 || strcmp(tok, "P5") == 0)
+	{
+		depth = tok[1] == '6' ? 3 : 1;
+		if (!readNumber(fp, &w) || !readNumber(fp, &h) || !readNumber(fp, &maxval)) return -1;
+	}
+	else
+	{
+		return -1;
+	}
+
+	if (maxval != 255 || depth < 1 || depth > 4) return -1;
+	if (w == 0 || h == 0 || w > HOLO_PACK_MAX_SIZE || h > HOLO_PACK_MAX_SIZE) return -1;
+
+	std::vector<uint8_t> raw((size_t)w * h * depth);
+	if (fread(raw.data(), 1, raw.size(), fp) != raw.size()) return -1;
+
+	// 1：灰度，2：灰度+alpha，3：RGB，4：RGBA
+	f->w = (uint16_t)w;
+	f->h = (uint16_t)h;
+	f->rgba.resize((size_t)w * h * 4);
+	const uint8_t* s = raw.data();
+	uint8_t* d = f->rgba.data();
+	for (size_t i = 0; i < (size_t)w * h; i++, s += depth, d += 4)
+	{
+		d[0] = s[0];
+		d[1] = depth >= 3 ? s[1] : s[0];
+		d[2] = depth >= 3 ? s[2] : s[0];
+		d[3] = depth == 4 ? s[3] : depth == 2 ? s[1] : 0xFF;
+	}
+	return 1;
+}
+
+/**
+ * 流中是否还有数据（只跳过空白，不消耗下一帧）
+ */
+static bool hasMore(FILE* fp)
+{
+	int c;
+	while ((c = fgetc(fp)) != EOF && isspace(c));
+	if (c == EOF) return false;
+	ungetc(c, fp);
+	return true;
+}
+
+#if HOLO_PACK_SSE2
+/**
+ * 4个RGBA8888像素（各占一个32位通道）转为16位颜色，结果在每个通道的低16位
+ * 与LV_COLOR_MAKE相同：各分量截断取高位，LV_COLOR_16_SWAP时交换两个字节
+ */
+static inline __m128i pack565(__m128i v)
+{
+	const __m128i m5 = _mm_set1_epi32(0x1F);
+	const __m128i m6 = _mm_set1_epi32(0x3F);
+	__m128i r = _mm_and_si128(_mm_srli_epi32(v, 3), m5);
+	__m128i g = _mm_and_si128(_mm_srli_epi32(v, 10), m6);
+	__m128i b = _mm_and_si128(_mm_srli_epi32(v, 19), m5);
+	__m128i c = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 11), _mm_slli_epi32(g, 5)), b);
+#if LV_COLOR_16_SWAP
+	c = _mm_or_si128(_mm_srli_epi32(c, 8), _mm_and_si128(_mm_slli_epi32(c, 8), _mm_set1_epi32(0xFF00)));
+#endif
+	// 符号扩展到32位，_mm_packs_epi32的有符号饱和就不会改变数值
+	return _mm_srai_epi32(_mm_slli_epi32(c, 16), 16);
+}
+#endif
+
+/**
+ * 一行RGBA8888像素转为lv_color_t
+ */
+static void convertRow(const uint8_t* rgba, uint32_t n, lv_color_t* out)
+{
+	uint32_t i = 0;
+#if HOLO_PACK_SSE2
+	if (simd_ok)
+	{
+		for (; i + 8 <= n; i += 8)
+		{
+			__m128i a = pack565(_mm_loadu_si128((const __m128i*)(rgba + i * 4)));
+			__m128i b = pack565(_mm_loadu_si128((const __m128i*)(rgba + i * 4 + 16)));
+			_mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+		}
+	}
+#endif
+	for (; i < n; i++) out[i] = lv_color_make(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+}
+
+/**
+ * SIMD路径与lv_color_make逐像素比对：R、G各取遍0~255的组合，B用交错序列取遍0~255
+ */
+static void checkSimd()
+{
+#if HOLO_PACK_SSE2
+	const uint32_t n = 65536;
+	std::vector<uint8_t> rgba(n * 4);
+	for (uint32_t i = 0; i < n; i++)
+	{
+		rgba[i * 4] = i & 0xFF;
+		rgba[i * 4 + 1] = i >> 8;
+		rgba[i * 4 + 2] = (uint8_t)(i * 37 + (i >> 8));
+		rgba[i * 4 + 3] = 0xFF;
+	}
+	std::vector<lv_color_t> out(n);
+	convertRow(rgba.data(), n, out.data());
+	for (uint32_t i = 0; i < n; i++)
+	{
+		lv_color_t ref = lv_color_make(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+		if (out[i].full != ref.full)
+		{
+			fprintf(stderr, "SSE2颜色换算与lv_color_make不一致，改用lv_color_make\n");
+			simd_ok = false;
+			return;
+		}
+	}
+#endif
+}
+
+/**
+ * TRUE_COLOR_ALPHA的.bin改写为预乘alpha图像：每行按alpha分为全透明、不透明、半透明片段，
+ * 半透明像素的565各分量乘以alpha / 255（向下取整，固件的混合核依此保证不进位）
+ */
+static void encodePremul(Frame* f)
+{
+	const uint8_t* px = f->bin.data() + sizeof(lv_img_header_t);
+	uint32_t base = PREMUL_MAGIC_SIZE + (uint32_t)f->h * sizeof(uint32_t);
+	std::vector<uint32_t> offsets(f->h);
+	std::vector<uint8_t> spans;
+	auto put16 = [&](uint16_t v) {
+		spans.push_back((uint8_t)v);
+		spans.push_back((uint8_t)(v >> 8));
+	};
+
+	for (uint32_t y = 0; y < f->h; y++)
+	{
+		offsets[y] = base + (uint32_t)spans.size();
+		const uint8_t* row = px + (size_t)y * f->w * LV_IMG_PX_SIZE_ALPHA_BYTE;
+		for (uint32_t x = 0; x < f->w;)
+		{
+			auto type = [&](uint32_t i) {
+				uint8_t a = row[i * LV_IMG_PX_SIZE_ALPHA_BYTE + 2];
+				return a == 0 ? PREMUL_SPAN_SKIP : a == 255 ? PREMUL_SPAN_COPY : PREMUL_SPAN_BLEND;
+			};
+			uint32_t t = type(x);
+			uint32_t n = 1;
+			while (x + n < f->w && n < 0x3FFF && type(x + n) == t) n++;
+			put16((uint16_t)((t << 14) | n));
+
+			const uint8_t* p = row + x * LV_IMG_PX_SIZE_ALPHA_BYTE;
+			for (uint32_t i = 0; t != PREMUL_SPAN_SKIP && i < n; i++, p += LV_IMG_PX_SIZE_ALPHA_BYTE)
+			{
+				uint16_t c = p[0] | (p[1] << 8);
+				if (t == PREMUL_SPAN_BLEND)
+				{
+#if LV_COLOR_16_SWAP
+					c = (uint16_t)((c >> 8) | (c << 8));
+#endif
+					uint32_t a = p[2];
+					uint32_t r = (c >> 11) * a / 255, g = ((c >> 5) & 0x3F) * a / 255, b = (c & 0x1F) * a / 255;
+					c = (uint16_t)((r << 11) | (g << 5) | b);
+#if LV_COLOR_16_SWAP
+					c = (uint16_t)((c >> 8) | (c << 8));
+#endif
+				}
+				put16(c);
+			}
+			if (t == PREMUL_SPAN_BLEND)
+			{
+				p = row + x * LV_IMG_PX_SIZE_ALPHA_BYTE;
+				for (uint32_t i = 0; i < n; i++) spans.push_back(p[i * LV_IMG_PX_SIZE_ALPHA_BYTE + 2]);
+				if (n & 1) spans.push_back(0);
+			}
+			x += n;
+		}
+	}
+
+	lv_img_header_t header;
+	memcpy(&header, f->bin.data(), sizeof(header));
+	header.cf = LV_IMG_CF_RAW_ALPHA;
+	std::vector<uint8_t> out(sizeof(header) + base);
+	memcpy(out.data(), &header, sizeof(header));
+	memcpy(out.data() + sizeof(header), PREMUL_MAGIC, PREMUL_MAGIC_SIZE);
+	memcpy(out.data() + sizeof(header) + PREMUL_MAGIC_SIZE, offsets.data(), offsets.size() * sizeof(uint32_t));
+	out.insert(out.end(), spans.begin(), spans.end());
+	f->bin.swap(out);
+}
+
+/**
+ * 关键帧的各级缩略图：先按alpha合成到黑色（屏幕背景），每级对上一级做2x2平均（尺寸向下取整），
+ * 输出为LV_IMG_CF_TRUE_COLOR的.bin，与帧的颜色格式无关
+ */
+static void makeMips(Frame* f)
+{
+	uint32_t w = f->w, h = f->h;
+	std::vector<uint8_t> rgb((size_t)w * h * 3);
+	const uint8_t* p = f->rgba.data();
+	for (size_t i = 0; i < (size_t)w * h; i++, p += 4)
+	{
+		for (int c = 0; c < 3; c++) rgb[i * 3 + c] = (uint8_t)((p[c] * p[3] + 127) / 255);
+	}
+
+	f->mips.clear();
+	for (int level = 1; level <= HOLO_MIP_LEVELS && w >= 2 && h >= 2; level++)
+	{
+		uint32_t mw = w / 2, mh = h / 2;
+		std::vector<uint8_t> next((size_t)mw * mh * 3);
+		for (uint32_t y = 0; y < mh; y++)
+		{
+			const uint8_t* r0 = rgb.data() + (size_t)y * 2 * w * 3;
+			const uint8_t* r1 = r0 + (size_t)w * 3;
+			for (uint32_t x = 0; x < mw; x++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					uint32_t i = x * 6 + c;
+					next[((size_t)y * mw + x) * 3 + c] = (uint8_t)((r0[i] + r0[i + 3] + r1[i] + r1[i + 3] + 2) >> 2);
+				}
+			}
+		}
+		rgb.swap(next);
+		w = mw;
+		h = mh;
+
+		lv_img_header_t header;
+		memset(&header, 0, sizeof(header));
+		header.cf = LV_IMG_CF_TRUE_COLOR;
+		header.w = w;
+		header.h = h;
+		uint32_t size = lv_img_buf_get_img_size(w, h, LV_IMG_CF_TRUE_COLOR);
+		std::vector<uint8_t> bin(sizeof(header) + size, 0);
+		memcpy(bin.data(), &header, sizeof(header));
+		lv_img_dsc_t dsc;
+		memset(&dsc, 0, sizeof(dsc));
+		dsc.header = header;
+		dsc.data_size = size;
+		dsc.data = bin.data() + sizeof(header);
+		for (lv_coord_t y = 0; y < (lv_coord_t)h; y++)
+		{
+			for (lv_coord_t x = 0; x < (lv_coord_t)w; x++)
+			{
+				const uint8_t* c = rgb.data() + ((size_t)y * w + x) * 3;
+				lv_img_buf_set_px_color(&dsc, x, y, lv_color_make(c[0], c[1], c[2]));
+			}
+		}
+		f->mips.push_back(std::move(bin));
+	}
+}
+
+/**
+ * 按颜色格式生成.bin内容：lv_img_header_t + lv_img_buf_get_img_size字节的数据
+ * 16位真彩色整行换算后按lv_img_buf_set_px_color的布局写入；其余格式与--no-simd时
+ * 逐像素调用lv_img_buf_set_px_color/lv_img_buf_set_px_alpha
+ */
+static void convertFrame(Frame* f, lv_img_cf_t cf)
+{
+	// 预乘alpha图像先按TRUE_COLOR_ALPHA换算，再改写为片段
+	bool premul = cf == LV_IMG_CF_RAW_ALPHA;
+	if (premul) cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+
+	lv_img_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.cf = cf;
+	header.w = f->w;
+	header.h = f->h;
+
+	uint32_t size = lv_img_buf_get_img_size(f->w, f->h, cf);
+	f->bin.assign(sizeof(header) + size, 0);
+	memcpy(f->bin.data(), &header, sizeof(header));
+
+	lv_img_dsc_t dsc;
+	memset(&dsc, 0, sizeof(dsc));
+	dsc.header = header;
+	dsc.data_size = size;
+	dsc.data = f->bin.data() + sizeof(header);
+	uint8_t* data = f->bin.data() + sizeof(header);
+
+	bool true_color = cf == LV_IMG_CF_TRUE_COLOR || cf == LV_IMG_CF_TRUE_COLOR_ALPHA;
+	if (true_color && simd_ok)
+	{
+		uint8_t px_size = lv_img_cf_get_px_size(cf) >> 3;
+		std::vector<lv_color_t> row(f->w);
+		for (uint32_t y = 0; y < f->h; y++)
+		{
+			const uint8_t* src = f->rgba.data() + (size_t)y * f->w * 4;
+			uint8_t* dst = data + (size_t)y * f->w * px_size;
+			convertRow(src, f->w, row.data());
+			if (cf == LV_IMG_CF_TRUE_COLOR)
+			{
+				memcpy(dst, row.data(), f->w * sizeof(lv_color_t));
+				continue;
+			}
+			for (uint32_t x = 0; x < f->w; x++, dst += px_size)
+			{
+				memcpy(dst, &row[x], sizeof(lv_color_t));
+				dst[px_size - 1] = src[x * 4 + 3];
+			}
+		}
+	}
+	else
+	{
+		const uint8_t* src = f->rgba.data();
+		for (lv_coord_t y = 0; y < f->h; y++)
+		{
+			for (lv_coord_t x = 0; x < f->w; x++, src += 4)
+			{
+				if (true_color) lv_img_buf_set_px_color(&dsc, x, y, lv_color_make(src[0], src[1], src[2]));
+				if (cf != LV_IMG_CF_TRUE_COLOR) lv_img_buf_set_px_alpha(&dsc, x, y, src[3]);
+			}
+		}
+	}
+
+	// 平均色（透明像素按黑色计，与holo.py的ambient_color一致）
+	uint64_t sum[3] = { 0, 0, 0 };
+	const uint8_t* p = f->rgba.data();
+	for (size_t i = 0, n = (size_t)f->w * f->h; i < n; i++, p += 4)
+	{
+		for (int c = 0; c < 3; c++) sum[c] += p[c] * p[3];
+	}
+	uint64_t div = (uint64_t)f->w * f->h * 255;
+	f->ambient = 0;
+	for (int c = 0; div && c < 3; c++) f->ambient = (f->ambient << 8) | (uint32_t)((sum[c] + div / 2) / div);
+
+	if (premul) encodePremul(f);
+	if (f->key) makeMips(f);
+
+	// 像素已不再需要，批内帧较多时尽早释放
+	std::vector<uint8_t>().swap(f->rgba);
+}
+
+/**
+ * 批内并行转换：各线程从共享计数器领取下一帧
+ */
+static void convertBatch(std::vector<Frame>& frames, lv_img_cf_t cf, unsigned jobs)
+{
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t i; (i = next++) < frames.size();) convertFrame(&frames[i], cf);
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < jobs && t < frames.size(); t++) pool.emplace_back(worker);
+	worker();
+	for (auto& t : pool) t.join();
+}
+
+/**
+ * .holo写入：帧数据先顺序写入临时文件，结束时按帧数确定索引长度，
+ * 再按align对齐拼成最终文件（与ImageToHolo/convertor/holo.py的pack_holo布局相同）
+ */
+class HoloWriter
+{
+private:
+	std::string path;
+	std::string tmp_path;
+	FILE* body;
+	std::vector<uint32_t> sizes;
+	std::vector<uint32_t> ambient;
+	std::vector<uint8_t> prev;
+	// 缩略图表与各级内容（体积小，结束时写在帧索引之后、帧0之前）
+	std::vector<HoloMipEntry> mips;
+	std::vector<std::vector<uint8_t>> mip_data;
+	uint16_t w;
+	uint16_t h;
+	uint8_t cf;
+	bool delta;
+	bool q565;
+	uint8_t tile;
+
+	/**
+	 * .bin的像素部分切成行优先的分块（跳过图像头与索引色调色板，与scene_player.cpp一致）
+	 */
+	void tiles(const std::vector<uint8_t>& bin, std::vector<const uint8_t*>& out)
+	{
+		uint8_t bpp = lv_img_cf_get_px_size((lv_img_cf_t)cf);
+		uint32_t palette = (cf >= LV_IMG_CF_INDEXED_1BIT && cf <= LV_IMG_CF_INDEXED_8BIT) ? (4u << bpp) : 0;
+		const uint8_t* px = bin.data() + sizeof(lv_img_header_t) + palette;
+		uint32_t stride = (uint32_t)w * bpp / 8;
+		uint32_t row = (uint32_t)tile * bpp / 8;
+		out.clear();
+		for (uint32_t ty = 0; ty < h / tile; ty++)
+		{
+			for (uint32_t tx = 0; tx < w / tile; tx++) out.push_back(px + ty * tile * stride + tx * row);
+		}
+	}
+
+	std::vector<uint8_t> encodeDelta(const std::vector<uint8_t>& cur)
+	{
+		uint8_t bpp = lv_img_cf_get_px_size((lv_img_cf_t)cf);
+		uint32_t stride = (uint32_t)w * bpp / 8;
+		uint32_t row = (uint32_t)tile * bpp / 8;
+		std::vector<const uint8_t*> a, b;
+		tiles(prev, a);
+		tiles(cur, b);
+
+		std::vector<uint16_t> changed;
+		for (size_t i = 0; i < b.size(); i++)
+		{
+			for (uint32_t r = 0; r < tile; r++)
+			{
+				if (memcmp(a[i] + r * stride, b[i] + r * stride, row) != 0)
+				{
+					changed.push_back((uint16_t)i);
+					break;
+				}
+			}
+		}
+
+		HoloDeltaHeader dh;
+		dh.tile_w = tile;
+		dh.tile_h = tile;
+		dh.tile_count = (uint16_t)changed.size();
+		std::vector<uint8_t> out(sizeof(dh) + changed.size() * sizeof(uint16_t));
+		memcpy(out.data(), &dh, sizeof(dh));
+		memcpy(out.data() + sizeof(dh), changed.data(), changed.size() * sizeof(uint16_t));
+		for (uint16_t id : changed)
+		{
+			for (uint32_t r = 0; r < tile; r++) out.insert(out.end(), b[id] + r * stride, b[id] + r * stride + row);
+		}
+		return out;
+	}
+
+	/**
+	 * Q565压缩一帧真彩色.bin：输出[lv_img_header_t（cf改为LV_IMG_CF_RAW）][Q565_MAGIC][操作码]
+	 * 贪心编码：与prev相同时计入RUN，否则依次尝试INDEX、DIFF、LUMA，都不行时写RGB
+	 */
+	std::vector<uint8_t> encodeQ565(const std::vector<uint8_t>& bin)
+	{
+		lv_img_header_t header;
+		memcpy(&header, bin.data(), sizeof(header));
+		header.cf = LV_IMG_CF_RAW;
+		std::vector<uint8_t> out(sizeof(header) + Q565_MAGIC_SIZE);
+		memcpy(out.data(), &header, sizeof(header));
+		memcpy(out.data() + sizeof(header), Q565_MAGIC, Q565_MAGIC_SIZE);
+
+		uint16_t index[Q565_INDEX_SIZE] = { 0 };
+		uint16_t prev = 0;
+		uint32_t run = 0;
+		auto flush = [&]() {
+			if (run == 0) return;
+			if (run <= 62) out.push_back((uint8_t)(0xC0 | (run - 1)));
+			else
+			{
+				out.push_back(0xFF);
+				out.push_back((uint8_t)(run - 1));
+				out.push_back((uint8_t)((run - 1) >> 8));
+			}
+			run = 0;
+		};
+
+		const uint8_t* px = bin.data() + sizeof(lv_img_header_t);
+		for (uint32_t i = 0; i < (uint32_t)w * h; i++)
+		{
+			// 取本机RGB565（LV_COLOR_16_SWAP时.bin中为高字节在前）
+#if LV_COLOR_16_SWAP
+			uint16_t p = (uint16_t)((px[i * 2] << 8) | px[i * 2 + 1]);
+#else
+			uint16_t p = (uint16_t)(px[i * 2] | (px[i * 2 + 1] << 8));
+#endif
+			if (p == prev)
+			{
+				if (++run == 0x10000) flush();
+				continue;
+			}
+			flush();
+
+			uint8_t hash = ((p >> 11) * 3 + ((p >> 5) & 0x3F) * 5 + (p & 0x1F) * 7) & (Q565_INDEX_SIZE - 1);
+			if (index[hash] == p)
+			{
+				out.push_back(hash);
+				prev = p;
+				continue;
+			}
+
+			// 分量差按5/6位回绕到有符号范围
+			int32_t dr = (((p >> 11) - (prev >> 11) + 16) & 0x1F) - 16;
+			int32_t dg = ((((p >> 5) & 0x3F) - ((prev >> 5) & 0x3F) + 32) & 0x3F) - 32;
+			int32_t db = (((p & 0x1F) - (prev & 0x1F) + 16) & 0x1F) - 16;
+			int32_t dr_dg = ((dr - (dg >> 1) + 16) & 0x1F) - 16;
+			int32_t db_dg = ((db - (dg >> 1) + 16) & 0x1F) - 16;
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+			{
+				out.push_back((uint8_t)(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+			}
+			else if (dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+			{
+				out.push_back((uint8_t)(0x80 | (dg + 32)));
+				out.push_back((uint8_t)(((dr_dg + 8) << 4) | (db_dg + 8)));
+			}
+			else
+			{
+				out.push_back(0xFE);
+				out.push_back((uint8_t)p);
+				out.push_back((uint8_t)(p >> 8));
+			}
+			index[hash] = p;
+			prev = p;
+		}
+		flush();
+		return out;
+	}
+
+public:
+	HoloWriter() : body(NULL), w(0), h(0), cf(0), delta(false), q565(false), tile(HOLO_PACK_DEFAULT_TILE)
+	{
+	}
+
+	~HoloWriter()
+	{
+		if (body)
+		{
+			fclose(body);
+			remove(tmp_path.c_str());
+		}
+	}
+
+	bool open(const std::string& out_path, bool use_delta, bool use_q565, uint8_t tile_size)
+	{
+		path = out_path;
+		tmp_path = out_path + ".part";
+		delta = use_delta;
+		q565 = use_q565;
+		tile = tile_size;
+		body = fopen(tmp_path.c_str(), "wb+");
+		if (body == NULL) fprintf(stderr, "无法创建 %s\n", tmp_path.c_str());
+		return body != NULL;
+	}
+
+	bool add(const Frame& f)
+	{
+		lv_img_header_t header;
+		memcpy(&header, f.bin.data(), sizeof(header));
+		if (sizes.empty())
+		{
+			w = f.w;
+			h = f.h;
+			cf = header.cf;
+			uint8_t bpp = lv_img_cf_get_px_size((lv_img_cf_t)cf);
+			if (delta && (w % tile || h % tile || (tile * bpp) % 8 || (w / tile) * (h / tile) > 0xFFFF))
+			{
+				printf("  图像尺寸不是分块大小%u的整数倍，改为输出完整帧\n", tile);
+				delta = false;
+			}
+			if (q565 && (cf != LV_IMG_CF_TRUE_COLOR || LV_COLOR_DEPTH != 16))
+			{
+				printf("  Q565只支持16位真彩色，改为输出未压缩的帧\n");
+				q565 = false;
+			}
+		}
+		else if (f.w != w || f.h != h)
+		{
+			fprintf(stderr, "%s: 尺寸%ux%u与首帧%ux%u不同\n", f.name.c_str(), f.w, f.h, w, h);
+			return false;
+		}
+
+		std::vector<uint8_t> payload;
+		const std::vector<uint8_t>* data = &f.bin;
+		if (delta && !sizes.empty())
+		{
+			payload = encodeDelta(f.bin);
+			data = &payload;
+		}
+		else if (q565)
+		{
+			// 压缩后反而变大的帧保持原样，播放端按帧头的cf区分
+			payload = encodeQ565(f.bin);
+			if (payload.size() < f.bin.size()) data = &payload;
+		}
+		if (delta) prev = f.bin;
+
+		if (fwrite(data->data(), 1, data->size(), body) != data->size())
+		{
+			fprintf(stderr, "写入 %s 失败\n", tmp_path.c_str());
+			return false;
+		}
+		for (size_t i = 0; i < f.mips.size(); i++)
+		{
+			HoloMipEntry m;
+			memset(&m, 0, sizeof(m));
+			m.size = (uint32_t)f.mips[i].size();
+			m.frame = (uint16_t)sizes.size();
+			m.level = (uint8_t)(i + 1);
+			mips.push_back(m);
+			mip_data.push_back(f.mips[i]);
+		}
+		sizes.push_back((uint32_t)data->size());
+		ambient.push_back(f.ambient);
+		return true;
+	}
+
+	bool finish(uint8_t fps, uint32_t align)
+	{
+		FILE* out = fopen(path.c_str(), "wb");
+		if (out == NULL)
+		{
+			fprintf(stderr, "无法创建 %s\n", path.c_str());
+			return false;
+		}
+
+		std::vector<HoloFrameEntry> index(sizes.size());
+		uint64_t pos = sizeof(HoloHeader) + sizeof(HoloFrameEntry) * sizes.size();
+		uint32_t mip_offset = mips.empty() ? 0 : (uint32_t)pos;
+		pos += sizeof(HoloMipEntry) * mips.size();
+		for (size_t i = 0; i < mips.size(); i++)
+		{
+			mips[i].offset = (uint32_t)pos;
+			pos += mips[i].size;
+		}
+		uint64_t body_start = pos;
+		for (size_t i = 0; i < sizes.size(); i++)
+		{
+			uint64_t offset = align > 1 ? (pos + align - 1) / align * align : pos;
+			index[i].offset = (uint32_t)offset;
+			index[i].size = sizes[i];
+			index[i].ambient = ambient[i];
+			pos = offset + sizes[i];
+		}
+		if (pos > UINT32_MAX)
+		{
+			fprintf(stderr, "动画包超过4GB，请分成多个文件\n");
+			fclose(out);
+			return false;
+		}
+
+		HoloHeader hh;
+		memset(&hh, 0, sizeof(hh));
+		memcpy(hh.magic, HOLO_MAGIC, 4);
+		// 不使用共用调色板（HOLO_FLAG_PALETTE），未压缩时旧固件也能播放
+		hh.version = q565 ? HOLO_VERSION_Q565 : 1;
+		hh.header_size = sizeof(HoloHeader);
+		hh.width = w;
+		hh.height = h;
+		hh.cf = cf;
+		hh.flags = delta ? HOLO_FLAG_DELTA : q565 ? HOLO_FLAG_Q565 : 0;
+		hh.fps = fps;
+		hh.entry_size = sizeof(HoloFrameEntry);
+		hh.frame_count = (uint32_t)sizes.size();
+		hh.index_offset = sizeof(HoloHeader);
+		hh.align = align;
+		hh.mip_offset = mip_offset;
+		hh.mip_count = (uint16_t)mips.size();
+		hh.mip_entry_size = sizeof(HoloMipEntry);
+
+		bool ok = fwrite(&hh, sizeof(hh), 1, out) == 1;
+		ok = ok && fwrite(index.data(), sizeof(HoloFrameEntry), index.size(), out) == index.size();
+		ok = ok && fwrite(mips.data(), sizeof(HoloMipEntry), mips.size(), out) == mips.size();
+		for (size_t i = 0; ok && i < mip_data.size(); i++)
+			ok = fwrite(mip_data[i].data(), 1, mip_data[i].size(), out) == mip_data[i].size();
+
+		// 按索引偏移补零后从临时文件复制各帧
+		fseek(body, 0, SEEK_SET);
+		pos = body_start;
+		std::vector<uint8_t> buf(1 << 16);
+		static const uint8_t zeros[HOLO_PACK_DEFAULT_ALIGN] = { 0 };
+		for (size_t i = 0; ok && i < sizes.size(); i++)
+		{
+			for (uint64_t pad = index[i].offset - pos; ok && pad > 0;)
+			{
+				size_t n = (size_t)std::min<uint64_t>(pad, sizeof(zeros));
+				ok = fwrite(zeros, 1, n, out) == n;
+				pad -= n;
+			}
+			for (uint32_t left = sizes[i]; ok && left > 0;)
+			{
+				size_t n = std::min<size_t>(left, buf.size());
+				ok = fread(buf.data(), 1, n, body) == n && fwrite(buf.data(), 1, n, out) == n;
+				left -= (uint32_t)n;
+			}
+			pos = (uint64_t)index[i].offset + sizes[i];
+		}
+
+		ok = fclose(out) == 0 && ok;
+		fclose(body);
+		body = NULL;
+		remove(tmp_path.c_str());
+		if (!ok) fprintf(stderr, "写入 %s 失败\n", path.c_str());
+		return ok;
+	}
+
+	uint32_t count()
+	{
+		return (uint32_t)sizes.size();
+	}
+
+	bool isDelta()
+	{
+		return delta;
+	}
+
+	bool isQ565()
+	{
+		return q565;
+	}
+
+	uint32_t mipCount()
+	{
+		return (uint32_t)mips.size();
+	}
+
+	uint64_t bodySize()
+	{
+		uint64_t n = 0;
+		for (uint32_t s : sizes) n += s;
+		return n;
+	}
+};
+
+/**
+ * 输入源：逐个打开输入文件（文件夹展开为其中的PAM/PPM/PGM文件，按文件名排序），
+ * 连续读出其中的所有帧
+ */
+class FrameSource
+{
+private:
+	std::vector<std::string> paths;
+	size_t next_path;
+	FILE* fp;
+	std::string base;
+	uint32_t index;
+
+	bool openNext()
+	{
+		if (fp && fp != stdin) fclose(fp);
+		fp = NULL;
+		if (next_path >= paths.size()) return false;
+
+		const std::string& p = paths[next_path++];
+		index = 0;
+		if (p == "-")
+		{
+#ifdef _WIN32
+			_setmode(_fileno(stdin), _O_BINARY);
+#endif
+			fp = stdin;
+			base = "frame";
+			return true;
+		}
+		fp = fopen(p.c_str(), "rb");
+		if (fp == NULL)
+		{
+			fprintf(stderr, "无法打开 %s\n", p.c_str());
+			return false;
+		}
+		// 与ImageToHolo相同，输出名取文件名第一个'.'之前的部分
+		base = fs::path(p).filename().string();
+		base = base.substr(0, base.find('.'));
+		return true;
+	}
+
+public:
+	FrameSource() : next_path(0), fp(NULL), index(0)
+	{
+	}
+
+	~FrameSource()
+	{
+		if (fp && fp != stdin) fclose(fp);
+	}
+
+	bool add(const std::string& p)
+	{
+		if (p != "-" && fs::is_directory(p))
+		{
+			std::vector<std::string> names;
+			for (const auto& e : fs::directory_iterator(p))
+			{
+				std::string ext = e.path().extension().string();
+				std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+				if (ext == ".pam" || ext == ".ppm" || ext == ".pgm" || ext == ".pnm") names.push_back(e.path().string());
+			}
+			std::sort(names.begin(), names.end());
+			paths.insert(paths.end(), names.begin(), names.end());
+			return true;
+		}
+		if (p != "-" && !fs::exists(p))
+		{
+			fprintf(stderr, "找不到 %s\n", p.c_str());
+			return false;
+		}
+		paths.push_back(p);
+		return true;
+	}
+
+	/**
+	 * @return 1 读到一帧，0 全部输入结束，-1 出错
+	 */
+	int read(Frame* f)
+	{
+		while (fp == NULL || !hasMore(fp))
+		{
+			if (next_path >= paths.size()) return 0;
+			if (!openNext()) return -1;
+		}
+
+		int r = readFrame(fp, f);
+		if (r <= 0)
+		{
+			fprintf(stderr, "%s: 第%u帧不是8位PAM/PPM/PGM图像\n", base.c_str(), index);
+			return -1;
+		}
+		// 文件中只有一帧时直接用文件名，多帧时加序号
+		if (index == 0 && !hasMore(fp)) f->name = base;
+		else
+		{
+			char num[16];
+			snprintf(num, sizeof(num), "_%04u", index);
+			f->name = base + num;
+		}
+		index++;
+		return 1;
+	}
+};
+
+static void usage()
+{
+	printf("用法: holo_pack [选项] <PAM/PPM/PGM文件、文件夹或 - ...>\n");
+	printf("  --cf FORMAT     颜色格式：true_color（默认）、true_color_alpha、alpha_1/2/4/8、\n");
+	printf("                  premul_alpha（预乘alpha，用于叠加在动画上的界面层，只输出.bin）\n");
+	printf("  --out DIR       .bin输出目录（默认当前目录）\n");
+	printf("  --holo FILE     把全部帧打包为一个.holo动画文件\n");
+	printf("  --fps N         动画帧率（默认25）\n");
+	printf("  --align N       帧对齐字节数，SD卡簇大小（默认4096）\n");
+	printf("  --delta         除首帧外只保存变化的分块\n");
+	printf("  --tile N        差分分块边长（像素，默认16）\n");
+	printf("  --q565          每帧Q565压缩（16位真彩色，不能与--delta同时使用）\n");
+	printf("  --mips          在.holo中内嵌首帧的1/2、1/4、1/8缩略图（场景浏览界面使用）\n");
+	printf("  --mip-every N   每隔N帧再取一个关键帧生成缩略图（隐含--mips）\n");
+	printf("  --jobs N        并行转换的线程数（默认为CPU核数）\n");
+	printf("  --no-simd       逐像素调用lv_img_buf_set_px_color（用于核对SSE2路径）\n");
+	printf("示例: ffmpeg -i in.mp4 -vf scale=240:240 -c:v pam -f image2pipe - | holo_pack --holo out.holo --delta -\n");
+}
+
+int main(int argc, char** argv)
+{
+	lv_img_cf_t cf = LV_IMG_CF_TRUE_COLOR;
+	std::string out_dir = ".";
+	std::string holo_path;
+	uint32_t fps = 25;
+	uint32_t align = HOLO_PACK_DEFAULT_ALIGN;
+	uint32_t tile = HOLO_PACK_DEFAULT_TILE;
+	bool delta = false;
+	bool q565 = false;
+	bool mips = false;
+	uint32_t mip_every = 0;
+	unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+	FrameSource source;
+	bool has_input = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		bool has_value = i + 1 < argc;
+		if (a == "--cf" && has_value)
+		{
+			std::string name = argv[++i];
+			bool found = false;
+			for (const ColorFormat& c : color_formats)
+			{
+				if (name == c.name)
+				{
+					cf = c.cf;
+					found = true;
+				}
+			}
+			if (!found)
+			{
+				fprintf(stderr, "不支持的颜色格式 %s\n", name.c_str());
+				return 1;
+			}
+		}
+		else if (a == "--out" && has_value) out_dir = argv[++i];
+		else if (a == "--holo" && has_value) holo_path = argv[++i];
+		else if (a == "--fps" && has_value) fps = (uint32_t)atoi(argv[++i]);
+		else if (a == "--align" && has_value) align = (uint32_t)atoi(argv[++i]);
+		else if (a == "--tile" && has_value) tile = (uint32_t)atoi(argv[++i]);
+		else if (a == "--jobs" && has_value) jobs = (unsigned)std::max(1, atoi(argv[++i]));
+		else if (a == "--delta") delta = true;
+		else if (a == "--q565") q565 = true;
+		else if (a == "--mips") mips = true;
+		else if (a == "--mip-every" && has_value)
+		{
+			mip_every = (uint32_t)std::max(0, atoi(argv[++i]));
+			mips = true;
+		}
+		else if (a == "--no-simd") simd_ok = false;
+		else if (a == "-h" || a == "--help")
+		{
+			usage();
+			return 0;
+		}
+		else if (a.size() > 1 && a[0] == '-' && a != "-")
+		{
+			fprintf(stderr, "未知选项 %s\n", a.c_str());
+			usage();
+			return 1;
+		}
+		else
+		{
+			if (!source.add(a)) return 1;
+			has_input = true;
+		}
+	}
+	if (!has_input)
+	{
+		usage();
+		return 1;
+	}
+	if (fps == 0 || fps > 255 || tile == 0 || tile > 255)
+	{
+		fprintf(stderr, "fps与tile须在1~255之间\n");
+		return 1;
+	}
+	if (cf == LV_IMG_CF_RAW_ALPHA && (!holo_path.empty() || LV_COLOR_DEPTH != 16))
+	{
+		fprintf(stderr, "premul_alpha只支持16位颜色的.bin输出\n");
+		return 1;
+	}
+	if (mips && holo_path.empty())
+	{
+		fprintf(stderr, "--mips只用于.holo输出\n");
+		return 1;
+	}
+	if (delta && q565)
+	{
+		fprintf(stderr, "--delta与--q565不能同时使用\n");
+		return 1;
+	}
+
+	if (simd_ok) checkSimd();
+
+	HoloWriter holo;
+	if (!holo_path.empty() && !holo.open(holo_path, delta, q565, (uint8_t)tile)) return 1;
+	if (holo_path.empty())
+	{
+		std::error_code ec;
+		fs::create_directories(out_dir, ec);
+	}
+
+	uint32_t total = 0;
+	uint64_t bytes = 0;
+	std::vector<Frame> batch;
+	for (bool end = false; !end;)
+	{
+		batch.clear();
+		while (batch.size() < (size_t)jobs * HOLO_PACK_BATCH)
+		{
+			Frame f;
+			int r = source.read(&f);
+			if (r < 0) return 1;
+			if (r == 0)
+			{
+				end = true;
+				break;
+			}
+			uint32_t id = total + (uint32_t)batch.size();
+			f.key = mips && (id == 0 || (mip_every && id % mip_every == 0));
+			batch.push_back(std::move(f));
+		}
+
+		convertBatch(batch, cf, jobs);
+
+		// 按输入顺序写出
+		for (const Frame& f : batch)
+		{
+			if (!holo_path.empty())
+			{
+				if (!holo.add(f)) return 1;
+			}
+			else
+			{
+				std::string p = (fs::path(out_dir) / (f.name + ".bin")).string();
+				FILE* fp = fopen(p.c_str(), "wb");
+				bool ok = fp && fwrite(f.bin.data(), 1, f.bin.size(), fp) == f.bin.size();
+				if (fp) ok = fclose(fp) == 0 && ok;
+				if (!ok)
+				{
+					fprintf(stderr, "写入 %s 失败\n", p.c_str());
+					return 1;
+				}
+			}
+			bytes += f.bin.size();
+			total++;
+		}
+		if (!batch.empty()) printf("  已转换%u帧\n", total);
+	}
+
+	if (total == 0)
+	{
+		fprintf(stderr, "没有可用的帧\n");
+		return 1;
+	}
+	if (!holo_path.empty())
+	{
+		if (!holo.finish((uint8_t)fps, align)) return 1;
+		printf("已生成 %s，共%u帧%s\n", holo_path.c_str(), holo.count(), holo.isDelta() ? "（差分）" : "");
+		if (holo.mipCount()) printf("缩略图：%u幅\n", holo.mipCount());
+		if (holo.isQ565())
+		{
+			printf("Q565压缩：%llu -> %llu字节（%.1f%%）\n", (unsigned long long)bytes,
+				   (unsigned long long)holo.bodySize(), bytes ? holo.bodySize() * 100.0 / bytes : 0.0);
+		}
+	}
+	else
+	{
+		printf("已生成%u个.bin，共%llu字节\n", total, (unsigned long long)bytes);
+	}
+	return 0;
+}
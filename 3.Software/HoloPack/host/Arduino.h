@@ -0,0 +1,19 @@
+#ifndef HOLO_PACK_ARDUINO_H
+#define HOLO_PACK_ARDUINO_H
+
+/**
+ * 主机端替身：固件lv_conf.h的LV_TICK_CUSTOM_INCLUDE为"Arduino.h"，只需要millis()
+ */
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t millis(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
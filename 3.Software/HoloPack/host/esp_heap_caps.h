@@ -0,0 +1,18 @@
+#ifndef HOLO_PACK_ESP_HEAP_CAPS_H
+#define HOLO_PACK_ESP_HEAP_CAPS_H
+
+/**
+ * 主机端替身：固件lv_conf.h中图片缓存、取色器环缓存的分配器，直接使用malloc/free
+ */
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+#define heap_caps_malloc(size, caps) malloc(size)
+#define heap_caps_malloc_prefer(size, num, ...) malloc(size)
+#define heap_caps_free(p) free(p)
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * 主机端移植层
+ *
+ * 固件的lvgl（lib/lvgl及其lv_conf.h）原样编译，这里只替换依赖ESP32的钩子：
+ * 1. lv_port_mem：LV_MEM_CUSTOM指向的TLSF堆，主机上直接使用malloc/free
+ * 2. millis：LV_TICK_CUSTOM的时间源
+ * 3. render_prof：LV_USE_REFR_PROFILER的计时钩子，主机上不计时
+ * 4. draw_split：LV_USE_DRAW_SPLIT的钩子，主机上不拆分
+ * 5. premul_decoder_draw：LV_USE_PREMUL_DRAW的钩子，HoloPack只生成图像、不绘制
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lv_port_mem.h"
+#include "render_prof.h"
+#include "draw_split.h"
+#include "premul_decoder.h"
+#include "Arduino.h"
+
+void lv_port_mem_init(void)
+{
+}
+
+void* lv_port_mem_alloc(size_t size)
+{
+	return malloc(size);
+}
+
+void lv_port_mem_free(void* ptr)
+{
+	free(ptr);
+}
+
+void lv_port_mem_monitor(lv_mem_monitor_t* mon)
+{
+	memset(mon, 0, sizeof(*mon));
+}
+
+uint32_t millis(void)
+{
+	return (uint32_t)((uint64_t)clock() * 1000 / CLOCKS_PER_SEC);
+}
+
+void render_prof_begin(render_prof_phase_t phase)
+{
+	(void)phase;
+}
+
+void render_prof_end(render_prof_phase_t phase)
+{
+	(void)phase;
+}
+
+void render_prof_frame_end(uint32_t px)
+{
+	(void)px;
+}
+
+bool draw_split_ready(uint32_t px)
+{
+	(void)px;
+	return false;
+}
+
+void draw_split_run(draw_split_cb_t cb, void* ctx, int32_t rows)
+{
+	cb(ctx, 0, rows - 1);
+}
+
+bool premul_decoder_draw(const void* src, const lv_area_t* coords, const lv_area_t* clip_area,
+						 const lv_draw_img_dsc_t* draw_dsc)
+{
+	(void)src;
+	(void)coords;
+	(void)clip_area;
+	(void)draw_dsc;
+	return false;
+}
@@ -0,0 +1,184 @@
+"""
+HoloCubic 录屏还原工具（格式见固件include/screen_record.h）
+
+    holo_rec.py 录屏文件.hrec 输出.mp4      按时间戳还原为视频（需要ffmpeg，扩展名决定格式，如.mkv/.gif）
+    holo_rec.py 录屏文件.hrec 输出目录      每帧保存为frame_00001.ppm……（不需要ffmpeg）
+    holo_rec.py 录屏文件.hrec --info        只输出帧数、时长、脏矩形统计
+
+录屏文件只包含变化的矩形：从黑屏开始依次贴上每个矩形，遇到帧标记输出一帧。
+视频按--fps重采样（两次刷新之间重复上一帧），设备上丢弃的矩形到下次刷新该区域时补上。
+"""
+import argparse, os, struct, subprocess, sys
+
+MAGIC = b"HREC"
+VERSION = 1
+FILE_HEADER = struct.Struct("<4sBBHHH")
+RECT = struct.Struct("<HHHH")
+FRAME = struct.Struct("<I")
+FLAG_SWAP = 0x01
+
+
+class RecError(Exception):
+    pass
+
+
+def read_packets(data):
+    """依次返回("R", x, y, w, h, 像素字节)与("F", 毫秒)，文件末尾不完整的包忽略"""
+    pos = FILE_HEADER.size
+    while pos < len(data):
+        kind = data[pos:pos + 1]
+        pos += 1
+        if kind == b"R":
+            if pos + RECT.size > len(data):
+                return
+            x, y, w, h = RECT.unpack_from(data, pos)
+            pos += RECT.size
+            n = w * h * 2
+            if pos + n > len(data):
+                return
+            yield ("R", x, y, w, h, data[pos:pos + n])
+            pos += n
+        elif kind == b"F":
+            if pos + FRAME.size > len(data):
+                return
+            yield ("F", FRAME.unpack_from(data, pos)[0])
+            pos += FRAME.size
+        else:
+            raise RecError("偏移{}处的数据包类型无效: {!r}".format(pos - 1, kind))
+
+
+class Canvas:
+    """RGB888画面，按矩形更新"""
+
+    def __init__(self, width, height, swap):
+        self.width, self.height, self.swap = width, height, swap
+        self.rgb = bytearray(width * height * 3)
+        # RGB565到RGB888的查找表（按文件中的字节顺序取16位值）
+        self.lut = []
+        for v in range(65536):
+            if swap:
+                v = ((v & 0xFF) << 8) | (v >> 8)
+            r, g, b = v >> 11, (v >> 5) & 0x3F, v & 0x1F
+            self.lut.append(bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2))))
+
+    def paste(self, x, y, w, h, pixels):
+        if x + w > self.width or y + h > self.height:
+            raise RecError("矩形超出画面: {},{} {}x{}".format(x, y, w, h))
+        values = struct.unpack("<{}H".format(w * h), pixels)
+        lut = self.lut
+        for r in range(h):
+            row = b"".join(lut[v] for v in values[r * w:(r + 1) * w])
+            start = ((y + r) * self.width + x) * 3
+            self.rgb[start:start + w * 3] = row
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < FILE_HEADER.size:
+        raise RecError("文件太短")
+    magic, version, flags, width, height, seg = FILE_HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise RecError("不是录屏文件或版本不支持")
+    return data, width, height, bool(flags & FLAG_SWAP), seg
+
+
+def frames(data, canvas):
+    """依次返回(毫秒, RGB888画面)"""
+    for p in read_packets(data):
+        if p[0] == "R":
+            canvas.paste(*p[1:])
+        else:
+            yield p[1], bytes(canvas.rgb)
+
+
+def resample(source, fps):
+    """按固定帧率输出：每个输出时刻取此前最后一帧"""
+    step = 1000.0 / fps
+    t0 = None
+    last = None
+    n = 0
+    for ms, rgb in source:
+        if t0 is None:
+            t0 = ms
+        while last is not None and t0 + n * step < ms:
+            yield last
+            n += 1
+        last = rgb
+    if last is not None:
+        yield last
+
+
+def info(path):
+    data, width, height, swap, seg = load(path)
+    count = rects = pixels = 0
+    first = last = None
+    for p in read_packets(data):
+        if p[0] == "R":
+            rects += 1
+            pixels += p[3] * p[4]
+        else:
+            count += 1
+            first = p[1] if first is None else first
+            last = p[1]
+    print("{}x{} 分段{}像素 {}字节".format(width, height, seg, len(data)))
+    if count:
+        secs = (last - first) / 1000.0
+        print("{}帧 {:.1f}秒 平均{:.1f}个矩形/帧".format(count, secs, rects / count))
+        print("平均每帧{:.1f}%的像素变化".format(100.0 * pixels / count / (width * height)))
+
+
+def to_ppm(path, out_dir):
+    data, width, height, swap, _ = load(path)
+    os.makedirs(out_dir, exist_ok=True)
+    count = 0
+    for ms, rgb in frames(data, Canvas(width, height, swap)):
+        count += 1
+        with open(os.path.join(out_dir, "frame_{:05d}.ppm".format(count)), "wb") as f:
+            f.write(b"P6\n%d %d\n255\n" % (width, height))
+            f.write(rgb)
+    print("{}帧 -> {}".format(count, out_dir))
+
+
+def to_video(path, out_path, fps, scale):
+    data, width, height, swap, _ = load(path)
+    cmd = ["ffmpeg", "-loglevel", "error", "-y", "-f", "rawvideo", "-pix_fmt", "rgb24",
+           "-s", "{}x{}".format(width, height), "-r", str(fps), "-i", "-"]
+    if scale != 1:
+        cmd += ["-vf", "scale=iw*{0}:ih*{0}:flags=neighbor".format(scale)]
+    if not out_path.lower().endswith(".gif"):
+        cmd += ["-pix_fmt", "yuv420p"]
+    cmd.append(out_path)
+    try:
+        proc = subprocess.Popen(cmd, stdin=subprocess.PIPE)
+    except OSError:
+        raise RecError("没有找到ffmpeg，可改为输出到目录")
+    count = 0
+    for rgb in resample(frames(data, Canvas(width, height, swap)), fps):
+        proc.stdin.write(rgb)
+        count += 1
+    proc.stdin.close()
+    if proc.wait() != 0:
+        raise RecError("ffmpeg失败")
+    print("{}帧（{}fps） -> {}".format(count, fps, out_path))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="HoloCubic 录屏还原")
+    parser.add_argument("input", help="录屏文件（设备SD卡/rec/下的.hrec，可用HoloLink的pull命令拉取）")
+    parser.add_argument("output", nargs="?", help="视频文件或目录")
+    parser.add_argument("--info", action="store_true", help="只输出统计")
+    parser.add_argument("--fps", type=int, default=30, help="视频帧率")
+    parser.add_argument("--scale", type=int, default=2, help="视频放大倍数（最近邻）")
+    args = parser.parse_args()
+
+    try:
+        if args.info or not args.output:
+            info(args.input)
+        elif os.path.splitext(args.output)[1]:
+            to_video(args.input, args.output, args.fps, args.scale)
+        else:
+            to_ppm(args.input, args.output)
+    except (RecError, OSError) as e:
+        print("失败: {}".format(e))
+        sys.exit(1)
@@ -0,0 +1,81 @@
+"""
+资源包格式（与固件 include/asset_bundle.h 保持一致）
+
+文件布局（小端）：
+    [文件头 16字节][目录 count * 32字节][资源0][资源1]...
+
+- 每个资源是一份完整的 LVGL .bin 内容（4字节 lv_img_header_t + 数据），起始偏移4字节对齐
+- 目录项：名称（24字节，'\\0'结尾，不含扩展名）、偏移、长度
+- 输入中的 .lang 翻译文件编译为语言包（格式见 convertor/i18n.py），资源名为"lang_<代码>"
+- 生成的文件直接烧录到 assets 分区（esptool.py write_flash 0x290000 assets.bin），
+  固件经 esp_partition_mmap 映射后原地引用，不拷贝到 RAM
+"""
+import os.path
+import struct
+from typing import *
+
+from convertor.core import Convertor
+from convertor.fast import convert_many
+
+ASSET_MAGIC = b"HOLA"
+ASSET_VERSION = 1
+ASSET_HEADER_FMT = "<4sHHI4x"
+ASSET_HEADER_SIZE = struct.calcsize(ASSET_HEADER_FMT)
+ASSET_ENTRY_FMT = "<24sII"
+ASSET_ENTRY_SIZE = struct.calcsize(ASSET_ENTRY_FMT)
+ASSET_NAME_LEN = 24
+ASSET_ALIGN = 4
+ASSET_PARTITION_SIZE = 0x158000
+
+
+def pack_assets(items: Iterable[Tuple[str, bytes]]) -> bytes:
+    """把 (名称, .bin内容) 列表打包为资源包内容"""
+    items = list(items)
+    pos = ASSET_HEADER_SIZE + ASSET_ENTRY_SIZE * len(items)
+
+    entries = []
+    body = bytearray()
+    for name, data in items:
+        name_b = name.encode("utf-8")
+        if len(name_b) >= ASSET_NAME_LEN:
+            raise ValueError("资源名过长（最多{}字节）: {}".format(ASSET_NAME_LEN - 1, name))
+        offset = (pos + ASSET_ALIGN - 1) // ASSET_ALIGN * ASSET_ALIGN
+        body.extend(b"\x00" * (offset - pos))
+        body.extend(data)
+        entries.append((name_b, offset, len(data)))
+        pos = offset + len(data)
+
+    header = struct.pack(ASSET_HEADER_FMT, ASSET_MAGIC, ASSET_VERSION, len(items), pos)
+    index = b"".join(struct.pack(ASSET_ENTRY_FMT, n, o, s) for n, o, s in entries)
+    return header + index + bytes(body)
+
+
+def make_assets(inputs: List[str], out_path: str,
+                config=Convertor.FLAG.CF_INDEXED_4_BIT, dith=True, jobs: Optional[int] = None,
+                lang_font: Optional[str] = None, lang_size: int = 14, black: int = 0) -> int:
+    """把图片（或已转换好的 .bin）打包为资源包，资源名取文件名，返回资源数；jobs 为并行转换的进程数
+    .lang 翻译文件编译为语言包，lang_font 为语言包字形所用的字体文件（None 时不带字体）
+    dith 与 black 见 convert_bytes"""
+    images = [p for p in inputs if not p.lower().endswith((".bin", ".lang"))]
+    converted = dict(zip(images, convert_many(images, config, dith, jobs=jobs, black=black)))
+
+    items = []
+    for path in inputs:
+        name = os.path.splitext(os.path.basename(path))[0]
+        if path.lower().endswith(".lang"):
+            from convertor.i18n import compile_lang
+            name, data = compile_lang(path, lang_font, lang_size)
+        elif path in converted:
+            data = converted[path]
+        else:
+            with open(path, "rb") as f:
+                data = f.read()
+        print("  {} ({} 字节)".format(name, len(data)))
+        items.append((name, data))
+
+    data = pack_assets(items)
+    if len(data) > ASSET_PARTITION_SIZE:
+        raise RuntimeError("资源包{}字节，超过分区大小{}字节".format(len(data), ASSET_PARTITION_SIZE))
+    with open(out_path, "wb") as f:
+        f.write(data)
+    return len(items)
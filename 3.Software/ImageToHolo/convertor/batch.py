@@ -0,0 +1,135 @@
+"""
+批量转换：增量、并行、原子写出
+
+- 每个输入的缓存键为 SHA-256(文件内容 + 转换参数 + BATCH_CACHE_VERSION)，
+  记录在输出目录的 BATCH_MANIFEST 中；键相同且输出文件仍在（长度一致）时跳过，不再解码图片
+- 需要转换的文件按完成顺序从进程池取回（每个文件一个任务，所有CPU核同时转换），边转换边报告进度
+- 输出先写到同目录的临时文件再 os.replace，中断或失败时不会留下半个 .bin；
+  清单同样原子写出，每完成一批就更新，中断后已完成的部分下次仍然跳过
+- 转换结果与 convert_bytes 逐字节一致；转换核心变化（输出格式不同）时提高 BATCH_CACHE_VERSION
+"""
+import hashlib
+import json
+import multiprocessing
+import os
+import tempfile
+import time
+from typing import *
+
+from convertor.core import Convertor
+from convertor.fast import convert_bytes
+
+BATCH_MANIFEST = ".holo_cache.json"
+BATCH_CACHE_VERSION = 1
+# 每转换完这么多个文件写一次清单
+BATCH_MANIFEST_EVERY = 32
+
+
+def output_name(path: str) -> str:
+    """输出文件名：输入文件名去掉扩展名加 .bin（与逐个转换时相同）"""
+    return os.path.basename(path).split(".")[0] + ".bin"
+
+
+def cache_key(path: str, options: Sequence) -> str:
+    h = hashlib.sha256()
+    h.update(repr((BATCH_CACHE_VERSION, tuple(options))).encode("utf-8"))
+    with open(path, "rb") as f:
+        for block in iter(lambda: f.read(1 << 20), b""):
+            h.update(block)
+    return h.hexdigest()
+
+
+def write_atomic(path: str, data: bytes) -> None:
+    """写到同目录的临时文件后替换，目标文件要么是旧内容要么是完整的新内容"""
+    fd, tmp = tempfile.mkstemp(prefix=".tmp-", dir=os.path.dirname(os.path.abspath(path)))
+    try:
+        with os.fdopen(fd, "wb") as f:
+            f.write(data)
+        os.replace(tmp, path)
+    except BaseException:
+        os.unlink(tmp)
+        raise
+
+
+def _load_manifest(out_dir: str) -> Dict[str, dict]:
+    try:
+        with open(os.path.join(out_dir, BATCH_MANIFEST), encoding="utf-8") as f:
+            data = json.load(f)
+        return data if isinstance(data, dict) else {}
+    except (OSError, ValueError):
+        return {}
+
+
+def _save_manifest(out_dir: str, manifest: Dict[str, dict]) -> None:
+    text = json.dumps(manifest, ensure_ascii=False, indent=1, sort_keys=True)
+    write_atomic(os.path.join(out_dir, BATCH_MANIFEST), text.encode("utf-8"))
+
+
+def _keyed_job(args):
+    index, task = args
+    return index, convert_bytes(*task)
+
+
+def convert_batch(inputs: List[str], out_dir: str = ".", config=Convertor.FLAG.CF_INDEXED_4_BIT, dith=True,
+                  black: int = 0, jobs: Optional[int] = None, force: bool = False) -> Tuple[int, int]:
+    """
+    把 inputs 转换为 out_dir 中的 .bin，跳过未变化的文件；返回 (转换数, 跳过数)
+    jobs 为进程数，默认取 CPU 核数；force 为忽略缓存全部重新转换
+    """
+    os.makedirs(out_dir, exist_ok=True)
+    manifest = _load_manifest(out_dir)
+    options = (config, dith, black)
+
+    names = [output_name(p) for p in inputs]
+    seen = {}
+    for p, n in zip(inputs, names):
+        if n in seen and seen[n] != p:
+            raise RuntimeError("输出文件名重复: {} 与 {} 都会写成 {}".format(seen[n], p, n))
+        seen[n] = p
+
+    todo = []
+    skipped = 0
+    for i, (path, name) in enumerate(zip(inputs, names)):
+        key = cache_key(path, options)
+        entry = manifest.get(name)
+        out_path = os.path.join(out_dir, name)
+        if not force and entry and entry.get("key") == key and os.path.isfile(out_path) and \
+                os.path.getsize(out_path) == entry.get("size"):
+            skipped += 1
+            continue
+        todo.append((i, key))
+
+    total = len(todo)
+    print("  {}个文件未变化，跳过；需要转换{}个".format(skipped, total))
+    if not total:
+        return 0, skipped
+
+    tasks = [(i, (inputs[i], config, dith, None, black)) for i, _ in todo]
+    keys = dict(todo)
+    jobs = min(jobs or os.cpu_count() or 1, total)
+    start = time.time()
+    done = 0
+
+    def finish(i: int, data: bytes):
+        nonlocal done
+        name = names[i]
+        write_atomic(os.path.join(out_dir, name), data)
+        manifest[name] = {"key": keys[i], "size": len(data), "src": os.path.basename(inputs[i])}
+        done += 1
+        print("  [{}/{}] {} ({} 字节)".format(done, total, name, len(data)))
+        if done % BATCH_MANIFEST_EVERY == 0:
+            _save_manifest(out_dir, manifest)
+
+    try:
+        if jobs <= 1:
+            for t in tasks:
+                finish(*_keyed_job(t))
+        else:
+            with multiprocessing.Pool(jobs) as pool:
+                for i, data in pool.imap_unordered(_keyed_job, tasks):
+                    finish(i, data)
+    finally:
+        _save_manifest(out_dir, manifest)
+
+    print("  用时{:.1f}秒（{}个进程）".format(time.time() - start, jobs))
+    return total, skipped
@@ -54,10 +54,31 @@ class _const:
         raise self.ConstError(f"Can't rebind const {name}")
 
 
+def bin_header(cf: int, w: int, h: int) -> bytes:
+    """LVGL .bin 文件的4字节 lv_img_header_t（转换器颜色格式映射到 LittlevGL 颜色格式）"""
+    F = Convertor.FLAG
+    lv_cf = {  # Color format in LittlevGL
+        F.CF_TRUE_COLOR: 4,
+        F.CF_TRUE_COLOR_ALPHA: 5,
+        F.CF_TRUE_COLOR_CHROMA: 6,
+        F.CF_INDEXED_1_BIT: 7,
+        F.CF_INDEXED_2_BIT: 8,
+        F.CF_INDEXED_4_BIT: 9,
+        F.CF_INDEXED_8_BIT: 10,
+        F.CF_ALPHA_1_BIT: 11,
+        F.CF_ALPHA_2_BIT: 12,
+        F.CF_ALPHA_4_BIT: 13,
+        F.CF_ALPHA_8_BIT: 14
+    }.get(cf, 4)
+    return struct.pack("<L", lv_cf + (w << 10) + (h << 21))
+
+
 class Convertor(object):
     FLAG = _const()
 
-    def __init__(self, path, config=FLAG.CF_INDEXED_4_BIT, dith=True):
+    def __init__(self, path, config=FLAG.CF_INDEXED_4_BIT, dith=True, name=None, palette=None):
+        # path 可以是图片路径，也可以直接是 PIL.Image（打包动画时逐帧传入，此时用 name 命名输出）
+        # palette 为 P 模式的 PIL.Image，索引色格式下使用其固定调色板（差分动画要求各帧调色板一致）
 
         self.dith = None  # Dithering enable/disable
         self.w = None  # Image width
@@ -67,8 +88,11 @@ class Convertor(object):
         self.chroma = None  # Chroma keyed?
         self.d_out = None  # Output data (result)
         self.img = None  # Image resource
-        self.out_name = os.path.basename(path).split(".")[0]  # Name of the output file
+        if name is None:
+            name = os.path.basename(path).split(".")[0] if isinstance(path, str) else "frame"
+        self.out_name = name  # Name of the output file
         self.path = None  # Path to the image file
+        self.palette = palette  # Fixed palette image for indexed formats
 
         # Helper variables
         self.r_act = 0
@@ -90,7 +114,8 @@ class Convertor(object):
 
         if self.cf == "raw" or self.cf == "raw_alpha" or self.cf == "raw_chroma":
             return
-        self.img: Image.Image = Image.open(path).convert("RGBA")
+        src = path if isinstance(path, Image.Image) else Image.open(path)
+        self.img: Image.Image = src.convert("RGBA")
         self.w, self.h = self.img.size
 
         if self.dith:
@@ -124,8 +149,12 @@ class Convertor(object):
         if palette_size:
             img_tmp = Image.new("RGB", (self.w, self.h))
             img_tmp.paste(img_tmp, self.img)
-            self.img = self.img.convert(mode="P", colors=palette_size)
-            real_palette_size = len(self.img.getcolors())  # The real number of colors in the image's palette
+            if self.palette is not None:
+                self.img = self.img.convert("RGB").quantize(palette=self.palette, dither=0)
+                real_palette_size = palette_size
+            else:
+                self.img = self.img.convert(mode="P", colors=palette_size)
+                real_palette_size = len(self.img.getcolors())  # The real number of colors in the image's palette
             real_palette = self.img.getpalette()
             # self.img.show()
             for i in range(palette_size):
@@ -314,31 +343,22 @@ const lv_img_dsc_t {self.out_name} = {{
         return out
 
     def get_bin_file(self, cf=-1, content=None) -> bytes:
+        data = self.get_bin_bytes(cf, content)
+
+        with open(self.out_name + ".bin", "wb") as f:
+            f.write(data)
+            f.close()
+
+        return data
+
+    def get_bin_bytes(self, cf=-1, content=None) -> bytes:
+        """返回 LVGL .bin 文件内容（4字节头 + 数据），不写文件"""
         if not content: content = self.d_out
         if cf < 0: cf = self.cf
 
-        lv_cf = {  # Color format in LittlevGL
-            self.FLAG.CF_TRUE_COLOR: 4,
-            self.FLAG.CF_TRUE_COLOR_ALPHA: 5,
-            self.FLAG.CF_TRUE_COLOR_CHROMA: 6,
-            self.FLAG.CF_INDEXED_1_BIT: 7,
-            self.FLAG.CF_INDEXED_2_BIT: 8,
-            self.FLAG.CF_INDEXED_4_BIT: 9,
-            self.FLAG.CF_INDEXED_8_BIT: 10,
-            self.FLAG.CF_ALPHA_1_BIT: 11,
-            self.FLAG.CF_ALPHA_2_BIT: 12,
-            self.FLAG.CF_ALPHA_4_BIT: 13,
-            self.FLAG.CF_ALPHA_8_BIT: 14
-        }.get(cf, 4)
-
-        header = lv_cf + (self.w << 10) + (self.h << 21)
-        header_bin = struct.pack("<L", header)
+        header_bin = bin_header(cf, self.w, self.h)
         content = struct.pack(f"<{len(content)}B", *content)
 
-        with open(self.out_name + ".bin", "wb") as f:
-            f.write(header_bin + content)
-            f.close()
-
         return header_bin + content
 
     def _conv_px(self, x, y):
@@ -0,0 +1,307 @@
+"""
+矢量化转换核心（NumPy），输出与 Convertor.get_bin_bytes() 逐字节一致
+
+- 颜色量化（向上取整到通道位数并截断）、RGB332/565/888 打包、索引色/alpha 按位打包
+  都在整幅图像的数组上一次完成，不再逐像素 getpixel
+- Floyd–Steinberg 抖动中每个像素依赖同一行前一个像素的误差，无法跨像素矢量化：
+  三个通道互不影响，逐通道、逐行在整数列表上计算（误差分配与舍入与 Convertor._dith_next 相同，
+  按误差查表），结果再交给 NumPy 打包
+- 有序抖动（ordered 为8x8 Bayer，bluenoise 为平铺的蓝噪声阈值表）每个像素只与自己的位置有关，整幅矢量化；
+  画面静止的部分各帧完全相同，差分（--delta）与Q565编码比误差扩散小得多
+- 黑位压低（black）：分光棱镜上暗部会显出一块灰底，转换前按查找表把不高于black的通道值压到0，其余线性拉伸
+- convert_many 用进程池并行转换多帧/多个文件，结果按输入顺序返回
+- 未安装 NumPy 或格式不在以下范围（RAW）时退回 Convertor 逐像素转换
+"""
+import functools
+import multiprocessing
+import os
+from typing import *
+
+from PIL import Image
+
+from convertor.core import Convertor, bin_header
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+F = Convertor.FLAG
+
+PALETTE_SIZE = {F.CF_INDEXED_1_BIT: 2, F.CF_INDEXED_2_BIT: 4, F.CF_INDEXED_4_BIT: 16, F.CF_INDEXED_8_BIT: 256}
+INDEX_BITS = {F.CF_INDEXED_1_BIT: 1, F.CF_INDEXED_2_BIT: 2, F.CF_INDEXED_4_BIT: 4, F.CF_INDEXED_8_BIT: 8}
+ALPHA_BITS = {F.CF_ALPHA_1_BIT: 1, F.CF_ALPHA_2_BIT: 2, F.CF_ALPHA_4_BIT: 4, F.CF_ALPHA_8_BIT: 8}
+# 真彩色格式 R/G/B 各通道位数（与 Convertor._classify_pixel 的参数一致）
+CHANNEL_BITS = {
+    F.CF_TRUE_COLOR_332: (3, 3, 2),
+    F.CF_TRUE_COLOR_565: (5, 6, 5),
+    F.CF_TRUE_COLOR_565_SWAP: (5, 6, 5),
+    F.CF_TRUE_COLOR_888: (8, 8, 8),
+}
+
+# 抖动方式（dith 参数）：True 等同 "fs"，False 等同 "none"；索引色格式不抖动
+DITHER_MODES = ("fs", "ordered", "bluenoise", "none")
+BLUE_NOISE_SIZE = 32
+
+# Floyd–Steinberg 分给右、左下、正下、右下的误差（7/16、3/16、5/16、1/16），按误差+256查表
+# 与 Convertor 的 round(k * err / 16) 相同（Python round 为银行家舍入）
+_FS_TABLES = tuple(tuple(round(k * e / 16) for e in range(-256, 256)) for k in (7, 3, 5, 1))
+
+
+def _quant_params(bits: int) -> Tuple[int, int]:
+    """向上取整的掩码与截断上限：5位为(7, 0xF8)，6位为(3, 0xFC)，8位为(0, 0xFF)"""
+    m = (1 << (8 - bits)) - 1
+    return m, 255 - m
+
+
+def _quantize(v, bits: int):
+    """不抖动：按 Convertor._classify_pixel 向上取整到 2^(8-bits) 的倍数并截断（v 为 0~255）"""
+    m, top = _quant_params(bits)
+    return np.minimum((v + m) & ~m, top)
+
+
+def _dither_channel(src: bytes, w: int, h: int, bits: int) -> bytearray:
+    """
+    单个通道的抖动量化，逐像素复现 Convertor._dith_next：
+    - 下一行误差数组 earr 在读取后清零，同一行前一个像素写入的1/16也会被当前像素读到
+    - 每行开始时只清零行内误差 nerr，earr 跨行保留
+    - 误差取原始值与量化值之差（不含累积误差）
+    """
+    t7, t3, t5, t1 = _FS_TABLES
+    m, top = _quant_params(bits)
+    nm = ~m
+    out = bytearray(w * h)
+    earr = [0] * (w + 2)
+    i = 0
+    for _ in range(h):
+        nerr = 0
+        for x in range(w):
+            v = src[i]
+            act = v + nerr + earr[x + 1]
+            if act <= 0:
+                act = 0
+            else:
+                act = (act + m) & nm
+                if act > top:
+                    act = top
+            out[i] = act
+            e = v - act + 256
+            nerr = t7[e]
+            earr[x] += t3[e]
+            earr[x + 1] = t5[e]
+            earr[x + 2] += t1[e]
+            i += 1
+    return out
+
+
+def dither_mode(dith: Union[bool, str, None]) -> str:
+    """把 dith 参数规范为 DITHER_MODES 之一"""
+    if dith is True:
+        return "fs"
+    if dith is False or dith is None:
+        return "none"
+    if dith not in DITHER_MODES:
+        raise ValueError("未知的抖动方式: {}".format(dith))
+    return dith
+
+
+def black_lut(black: int) -> List[int]:
+    """黑位压低查找表：不高于 black 的值为0，black~255 线性拉伸到 0~255"""
+    if not 0 <= black < 255:
+        raise ValueError("黑位应为0~254: {}".format(black))
+    return [0 if v <= black else (v - black) * 255 // (255 - black) for v in range(256)]
+
+
+def crush_black(img: Image.Image, black: int) -> Image.Image:
+    """对 R/G/B 通道应用 black_lut（alpha 不变），black 为0时原样返回"""
+    if not black:
+        return img
+    img = img.convert("RGBA")
+    return img.point(black_lut(black) * 3 + list(range(256)))
+
+
+def _bayer(n: int):
+    """n x n（2的幂）Bayer 矩阵，取值 0 ~ n*n-1"""
+    m = np.zeros((1, 1), np.int32)
+    while m.shape[0] < n:
+        m = np.block([[4 * m, 4 * m + 2], [4 * m + 3, 4 * m + 1]])
+    return m
+
+
+@functools.lru_cache(maxsize=None)
+def _blue_noise(n: int = BLUE_NOISE_SIZE, sigma: float = 1.5):
+    """
+    n x n 蓝噪声阈值表（void-and-cluster，环绕边界，固定种子），取值 0 ~ n*n-1
+    每一步用高斯滤波后的能量找最密的点（cluster）和最大的空隙（void）；每个进程只生成一次
+    """
+    rng = np.random.RandomState(1)
+    d = np.minimum(np.arange(n), n - np.arange(n))
+    kernel = np.fft.rfft2(np.exp(-(d[:, None] ** 2 + d[None, :] ** 2) / (2.0 * sigma * sigma)))
+
+    def energy(bits):
+        return np.fft.irfft2(np.fft.rfft2(bits) * kernel, s=(n, n)).ravel()
+
+    def cluster(bits):
+        return int(np.argmax(np.where(bits.ravel() > 0, energy(bits), -np.inf)))
+
+    def void(bits):
+        return int(np.argmin(np.where(bits.ravel() > 0, np.inf, energy(bits))))
+
+    # 初始图案：随机的10%，反复把最密的点移到最大的空隙直到稳定
+    proto = np.zeros((n, n))
+    proto.ravel()[rng.choice(n * n, n * n // 10, replace=False)] = 1
+    for _ in range(n * n):
+        c = cluster(proto)
+        proto.ravel()[c] = 0
+        v = void(proto)
+        proto.ravel()[v] = 1
+        if v == c:
+            break
+
+    rank = np.zeros(n * n, np.int32)
+    ones = int(proto.sum())
+    bits = proto.copy()
+    for r in range(ones - 1, -1, -1):
+        c = cluster(bits)
+        bits.ravel()[c] = 0
+        rank[c] = r
+    bits = proto.copy()
+    for r in range(ones, n * n):
+        v = void(bits)
+        bits.ravel()[v] = 1
+        rank[v] = r
+    return rank.reshape(n, n)
+
+
+def _ordered_channel(v, w: int, h: int, bits: int, mode: str):
+    """
+    有序抖动量化：阈值 t = (T + 0.5) / N 平铺到整幅图像，结果为 floor(v / q + t) * q 并截断（q = 2^(8-bits)）
+    三个通道共用阈值表，抖动图案不带彩色噪点；8位通道不变
+    """
+    m = _bayer(8) if mode == "ordered" else _blue_noise()
+    n = m.shape[0]
+    t = np.tile(m, ((h + n - 1) // n, (w + n - 1) // n))[:h, :w].ravel()
+    q = 1 << (8 - bits)
+    cnt = n * n
+    out = (2 * v * cnt + (2 * t + 1) * q) // (2 * q * cnt) * q
+    return np.minimum(out, 255 - (q - 1))
+
+
+def _pack_bits(vals, w: int, h: int, bpp: int) -> bytes:
+    """按行把每像素 bpp 位的值打包为字节，高位在前，行尾不足一字节补0"""
+    if bpp == 8:
+        return vals.astype(np.uint8).tobytes()
+    ppb = 8 // bpp
+    wb = (w + ppb - 1) // ppb
+    padded = np.zeros((h, wb * ppb), np.uint8)
+    padded[:, :w] = vals.reshape(h, w)
+    padded = padded.reshape(h, wb, ppb)
+    out = np.zeros((h, wb), np.uint8)
+    for k in range(ppb):
+        out |= padded[:, :, k] << (8 - bpp * (k + 1))
+    return out.tobytes()
+
+
+def _indexed(img: Image.Image, config: int, palette: Optional[Image.Image]) -> bytes:
+    """索引色：调色板（每色 RGBA 4 字节）+ 按位打包的索引，量化方式与 Convertor.convert 相同"""
+    size = PALETTE_SIZE[config]
+    if palette is not None:
+        pimg = img.convert("RGB").quantize(palette=palette, dither=0)
+        real = size
+    else:
+        pimg = img.convert(mode="P", colors=size)
+        real = len(pimg.getcolors())
+    pal = pimg.getpalette()
+    head = bytearray()
+    for i in range(size):
+        if i < real:
+            head.extend(pal[3 * i + k] for k in range(3))
+            head.append(0xFF)
+        else:
+            head.extend(b"\xff\xff\xff\xff")
+
+    w, h = img.size
+    idx = np.frombuffer(pimg.tobytes(), dtype=np.uint8)
+    bpp = INDEX_BITS[config]
+    return bytes(head) + _pack_bits(idx & ((1 << bpp) - 1), w, h, bpp)
+
+
+def _alpha(rgba, w: int, h: int, config: int) -> bytes:
+    """alpha 格式：只保存 alpha 通道，1位格式以大于0x80为不透明"""
+    a = rgba[3::4]
+    bpp = ALPHA_BITS[config]
+    if bpp == 1:
+        a = (a > 0x80).astype(np.uint8)
+    else:
+        a = a >> (8 - bpp)
+    return _pack_bits(a, w, h, bpp)
+
+
+def _true_color(raw: bytes, rgba, w: int, h: int, config: int, dith: str) -> bytes:
+    bits = CHANNEL_BITS[config]
+    if dith in ("ordered", "bluenoise"):
+        r, g, b = (_ordered_channel(rgba[c::4].astype(np.int32), w, h, bits[c], dith) for c in range(3))
+    elif dith == "fs":
+        r, g, b = (np.frombuffer(bytes(_dither_channel(raw[c::4], w, h, bits[c])), dtype=np.uint8).astype(np.int32)
+                   for c in range(3))
+    else:
+        r, g, b = (_quantize(rgba[c::4].astype(np.int32), bits[c]) for c in range(3))
+
+    if config == F.CF_TRUE_COLOR_332:
+        return (r | (g >> 3) | (b >> 6)).astype(np.uint8).tobytes()
+    if config == F.CF_TRUE_COLOR_888:
+        return np.stack([b, g, r, rgba[3::4].astype(np.int32)], axis=-1).astype(np.uint8).tobytes()
+    c16 = (r << 8) | (g << 3) | (b >> 3)
+    lo, hi = c16 & 0xFF, c16 >> 8
+    pair = [lo, hi] if config == F.CF_TRUE_COLOR_565 else [hi, lo]
+    return np.stack(pair, axis=-1).astype(np.uint8).tobytes()
+
+
+def convert_bytes(src: Union[str, Image.Image], config=F.CF_INDEXED_4_BIT, dith=True,
+                  palette: Optional[Image.Image] = None, black: int = 0) -> bytes:
+    """
+    返回 LVGL .bin 文件内容（4字节头 + 数据），dith 为 True/"fs" 时等价于
+    Convertor(src, config, dith, palette=palette).get_bin_bytes()
+    src 为图片路径或 PIL.Image；palette 为 P 模式图像，索引色格式下使用其固定调色板
+    dith 见 DITHER_MODES；black 非0时先压低黑位（见 black_lut）
+    """
+    dith = dither_mode(dith)
+    known = config in PALETTE_SIZE or config in ALPHA_BITS or config in CHANNEL_BITS
+    if np is None or not known:
+        if dith in ("ordered", "bluenoise"):
+            raise RuntimeError("有序抖动需要NumPy")
+        if black:
+            src = crush_black(src if isinstance(src, Image.Image) else Image.open(src), black)
+        return Convertor(src, config, dith == "fs", palette=palette).get_bin_bytes()
+
+    img = crush_black((src if isinstance(src, Image.Image) else Image.open(src)).convert("RGBA"), black)
+    w, h = img.size
+    if config in PALETTE_SIZE:
+        data = _indexed(img, config, palette)
+    else:
+        raw = img.tobytes()
+        rgba = np.frombuffer(raw, dtype=np.uint8)
+        if config in ALPHA_BITS:
+            data = _alpha(rgba, w, h, config)
+        else:
+            data = _true_color(raw, rgba, w, h, config, dith)
+    return bin_header(config, w, h) + data
+
+
+def _convert_job(args) -> bytes:
+    return convert_bytes(*args)
+
+
+def convert_many(sources: Iterable[Union[str, Image.Image]], config=F.CF_INDEXED_4_BIT, dith=True,
+                 palette: Optional[Image.Image] = None, jobs: Optional[int] = None, black: int = 0) -> List[bytes]:
+    """
+    并行转换多帧或多个文件，按输入顺序返回各自的 .bin 内容
+    jobs 为进程数，默认取 CPU 核数；为1或只有一项时在当前进程中转换
+    """
+    tasks = [(s, config, dith, palette, black) for s in sources]
+    jobs = jobs or os.cpu_count() or 1
+    if jobs <= 1 or len(tasks) < 2:
+        return [convert_bytes(*t) for t in tasks]
+    jobs = min(jobs, len(tasks))
+    with multiprocessing.Pool(jobs) as pool:
+        return pool.map(_convert_job, tasks, chunksize=max(1, len(tasks) // (jobs * 4)))
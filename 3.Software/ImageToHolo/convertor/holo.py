@@ -0,0 +1,406 @@
+"""
+.holo 动画包格式（与固件 include/holo_format.h 保持一致）
+
+文件布局（小端）：
+    [文件头 40字节][帧索引 frame_count * entry_size][共用调色板][缩略图表][缩略图][填充][帧0][填充][帧1]...
+
+- 每帧是一份完整的 LVGL .bin 内容（4字节 lv_img_header_t + 数据）
+- 每帧起始偏移按 align 对齐（默认4096，即FAT簇大小），固件 seek 后一次 read 读完整帧
+- entry_size 记录单条索引长度，后续版本可在条目末尾追加字段而不破坏旧固件
+- 索引条目为 [offset u32][size u32][ambient u32][crc u32]，ambient 为帧的平均色 0x00RRGGBB（透明像素按黑色计），
+  固件播放时用作LED环境色；crc 为帧在文件中的字节（size 字节）的 CRC32（与 zlib.crc32 相同），
+  固件在每帧第一次读取时校验；旧固件只读前8/12字节
+- flags & HOLO_FLAG_DELTA：帧0为关键帧，其余帧只保存相对上一帧变化的分块
+    [tile_w u8][tile_h u8][tile_count u16][tile_id u16 * n][分块数据 * n]
+- flags & HOLO_FLAG_JPEG：每帧为一幅基线JPEG（固件用ROM tjpgd逐MCU行解码直接写屏）
+- flags & HOLO_FLAG_PALETTE（版本2）：索引色动画全部帧共用一个调色板，只在 palette_offset 处保存一份，
+  完整帧（含差分的关键帧）为 [lv_img_header_t][索引数据]，固件读取时把调色板插回图像头之后
+- flags & HOLO_FLAG_Q565（版本3）：16位真彩色帧为 [lv_img_header_t（cf为RAW）]["Q565"][操作码]，
+  格式见固件 include/q565_decoder.h；压缩后不小于原始大小的帧保持原样
+- 文件头末尾的 mip_offset/mip_count/mip_entry_size 指向缩略图表，条目为 [offset u32][size u32][frame u16][level u8][0]：
+  关键帧的1/2、1/4、1/8尺寸缩略图，每幅为16位真彩色 .bin（透明像素合成到黑色），供固件场景浏览界面一次读出直接显示；
+  缩略图不影响播放，不提高版本号（旧固件只读前32字节）
+- flags & HOLO_FLAG_CROP（版本4）：文件头末尾追加 crop_x/crop_y/full_w/full_h（u16），
+  帧只保存整段动画非黑内容的外接矩形（width/height 为裁剪后的尺寸），其余部分全黑，
+  固件把场景控件放到画布中的 (crop_x, crop_y) 处，SD读取与SPI写屏都只涉及该区域；缩略图与平均色仍按完整画布
+"""
+import io
+import os.path
+import struct
+import zlib
+from typing import *
+
+from PIL import Image, ImageSequence, ImageStat
+
+from convertor.core import Convertor
+from convertor.fast import PALETTE_SIZE, convert_bytes, convert_many, crush_black
+
+HOLO_MAGIC = b"HOLO"
+HOLO_VERSION = 4  # 只有用到对应标志的包才写为较高版本，其余仍写为版本1，旧固件可以播放
+HOLO_VERSION_PALETTE = 2
+HOLO_VERSION_Q565 = 3
+HOLO_VERSION_CROP = 4
+HOLO_HEADER_FMT = "<4sHHHHBBBBIIIIIHBBHHHH"
+HOLO_HEADER_SIZE = struct.calcsize(HOLO_HEADER_FMT)
+HOLO_ENTRY_FMT = "<IIII"  # offset, size, ambient, crc
+HOLO_ENTRY_SIZE = struct.calcsize(HOLO_ENTRY_FMT)
+HOLO_MIP_FMT = "<IIHBB"  # offset, size, frame, level, reserved
+HOLO_MIP_SIZE = struct.calcsize(HOLO_MIP_FMT)
+HOLO_MIP_LEVELS = 3
+HOLO_DEFAULT_ALIGN = 4096
+HOLO_FLAG_DELTA = 0x01
+HOLO_FLAG_JPEG = 0x02
+HOLO_FLAG_PALETTE = 0x04
+HOLO_FLAG_Q565 = 0x08
+HOLO_FLAG_CROP = 0x10
+HOLO_DELTA_HEADER_FMT = "<BBH"
+HOLO_DEFAULT_TILE = 16
+# 拼图量化共用调色板时的像素上限，帧数多时每帧等比缩小，所有帧都参与统计
+HOLO_PALETTE_SHEET_PIXELS = 2 * 1024 * 1024
+
+LV_CF_BPP = {4: 16, 7: 1, 8: 2, 9: 4, 10: 8}  # LVGL 颜色格式 -> 每像素位数
+LV_CF_TRUE_COLOR = 4
+LV_CF_RAW = 1
+Q565_MAGIC = b"Q565"
+
+IMAGE_EXTS = (".png", ".jpg", ".jpeg", ".bmp", ".gif")
+VIDEO_EXTS = (".mp4", ".avi", ".mov", ".mkv")
+
+
+def _align_up(v: int, align: int) -> int:
+    return (v + align - 1) // align * align if align > 1 else v
+
+
+def iter_frames(src: str) -> Iterator[Image.Image]:
+    """按顺序产生源的每一帧：GIF、视频文件或图片文件夹"""
+    if os.path.isdir(src):
+        names = sorted(n for n in os.listdir(src) if n.lower().endswith(IMAGE_EXTS))
+        for n in names:
+            yield Image.open(os.path.join(src, n))
+        return
+
+    ext = os.path.splitext(src)[1].lower()
+    if ext in VIDEO_EXTS:
+        try:
+            import cv2
+        except ImportError:
+            raise RuntimeError("读取视频需要安装 opencv-python")
+        cap = cv2.VideoCapture(src)
+        while True:
+            ok, frame = cap.read()
+            if not ok:
+                break
+            yield Image.fromarray(cv2.cvtColor(frame, cv2.COLOR_BGR2RGB))
+        cap.release()
+        return
+
+    img = Image.open(src)
+    for frame in ImageSequence.Iterator(img):
+        yield frame.copy()
+
+
+def _tiles(data: bytes, w: int, h: int, bpp: int, tile: int) -> List[bytes]:
+    """把 .bin 内容的像素部分（跳过图像头与调色板）切成行优先的分块"""
+    palette = (4 << bpp) if bpp <= 8 else 0
+    px = data[4 + palette:]
+    stride = w * bpp // 8
+    row = tile * bpp // 8
+    out = []
+    for ty in range(h // tile):
+        for tx in range(w // tile):
+            base = ty * tile * stride + tx * row
+            out.append(b"".join(px[base + r * stride: base + r * stride + row] for r in range(tile)))
+    return out
+
+
+def encode_delta(prev: bytes, cur: bytes, w: int, h: int, bpp: int, tile: int = HOLO_DEFAULT_TILE) -> bytes:
+    """编码相对上一帧的差分帧，只保存内容变化的分块"""
+    a, b = _tiles(prev, w, h, bpp, tile), _tiles(cur, w, h, bpp, tile)
+    changed = [i for i in range(len(b)) if a[i] != b[i]]
+    head = struct.pack(HOLO_DELTA_HEADER_FMT, tile, tile, len(changed))
+    ids = b"".join(struct.pack("<H", i) for i in changed)
+    return head + ids + b"".join(b[i] for i in changed)
+
+
+def encode_q565(data: bytes, swap: bool) -> bytes:
+    """
+    Q565压缩一帧16位真彩色 .bin 内容（与 HoloPack 的 encodeQ565 相同的贪心编码）
+    swap 为 .bin 中像素高字节在前（rgb565_swap）
+    """
+    header = struct.unpack("<L", data[:4])[0]
+    out = bytearray(struct.pack("<L", (header & ~0x1F) | LV_CF_RAW) + Q565_MAGIC)
+    px = memoryview(data)[4:]
+    count = len(px) // 2
+    pixels = struct.unpack((">" if swap else "<") + "%dH" % count, px[:count * 2])
+
+    index = [0] * 64
+    prev = 0
+    run = 0
+
+    def flush():
+        if run <= 62:
+            out.append(0xC0 | (run - 1))
+        else:
+            out.extend(struct.pack("<BH", 0xFF, run - 1))
+
+    for p in pixels:
+        if p == prev:
+            run += 1
+            if run == 0x10000:
+                flush()
+                run = 0
+            continue
+        if run:
+            flush()
+            run = 0
+
+        r, g, b = p >> 11, (p >> 5) & 0x3F, p & 0x1F
+        h = (r * 3 + g * 5 + b * 7) & 63
+        if index[h] == p:
+            out.append(h)
+            prev = p
+            continue
+
+        # 分量差按5/6位回绕到有符号范围
+        dr = ((r - (prev >> 11) + 16) & 0x1F) - 16
+        dg = ((g - ((prev >> 5) & 0x3F) + 32) & 0x3F) - 32
+        db = ((b - (prev & 0x1F) + 16) & 0x1F) - 16
+        dr_dg = ((dr - (dg >> 1) + 16) & 0x1F) - 16
+        db_dg = ((db - (dg >> 1) + 16) & 0x1F) - 16
+        if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+            out.append(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2))
+        elif -8 <= dr_dg <= 7 and -8 <= db_dg <= 7:
+            out.append(0x80 | (dg + 32))
+            out.append(((dr_dg + 8) << 4) | (db_dg + 8))
+        else:
+            out.extend(struct.pack("<BH", 0xFE, p))
+        index[h] = p
+        prev = p
+    if run:
+        flush()
+    return bytes(out)
+
+
+def shared_palette(frames: List[Image.Image], colors: int = 16,
+                   max_pixels: int = HOLO_PALETTE_SHEET_PIXELS) -> Image.Image:
+    """
+    把所有帧拼成一张图做中位切分量化，得到全部帧共用的调色板
+    总像素超过 max_pixels 时每帧按面积等比缩小（BOX 取平均，保留各帧颜色占比）
+    """
+    w, h = frames[0].size
+    scale = min(1.0, (max_pixels / float(w * h * len(frames))) ** 0.5)
+    tw, th = max(1, int(w * scale)), max(1, int(h * scale))
+    sheet = Image.new("RGB", (tw, th * len(frames)))
+    for i, f in enumerate(frames):
+        f = f.convert("RGB")
+        if (tw, th) != f.size:
+            f = f.resize((tw, th), Image.BOX)
+        sheet.paste(f, (0, i * th))
+    return sheet.quantize(colors=colors)
+
+
+def strip_palette(data: bytes, bpp: int) -> bytes:
+    """去掉 .bin 内容中图像头之后的调色板（4 << bpp 字节），用于共用调色板的动画包"""
+    return data[:4] + data[4 + (4 << bpp):]
+
+
+def remove_background(img: Image.Image, threshold: int = 0) -> Image.Image:
+    """透明像素合成到黑色，各通道都不高于 threshold 的像素（背景）改为纯黑，返回 RGB 图像"""
+    img = img.convert("RGBA")
+    img = Image.alpha_composite(Image.new("RGBA", img.size, (0, 0, 0, 255)), img).convert("RGB")
+    if threshold <= 0:
+        return img
+    mask = img.point([0 if v <= threshold else 255 for v in range(256)] * 3).convert("L").point(
+        [0 if v == 0 else 255 for v in range(256)])
+    return Image.composite(img, Image.new("RGB", img.size), mask)
+
+
+def content_box(images: Sequence[Image.Image], align: int = 2) -> Optional[Tuple[int, int, int, int]]:
+    """
+    整段动画非黑内容的外接矩形 (x1, y1, x2, y2)（x2/y2 不含），各帧应已经过 remove_background；
+    左上角向下、右下角向上对齐到 align 的倍数（不超出图像），全黑时返回 None
+    """
+    box = None
+    for img in images:
+        b = img.getbbox()
+        if b is None:
+            continue
+        box = b if box is None else (min(box[0], b[0]), min(box[1], b[1]), max(box[2], b[2]), max(box[3], b[3]))
+    if box is None:
+        return None
+    w, h = images[0].size
+    x1, y1 = box[0] // align * align, box[1] // align * align
+    return x1, y1, min(_align_up(box[2], align), w), min(_align_up(box[3], align), h)
+
+
+def ambient_color(img: Image.Image) -> int:
+    """帧的平均色 0x00RRGGBB，透明像素按黑色（屏幕背景）计"""
+    img = img.convert("RGBA")
+    black = Image.new("RGBA", img.size, (0, 0, 0, 255))
+    r, g, b = (int(round(v)) for v in ImageStat.Stat(Image.alpha_composite(black, img).convert("RGB")).mean)
+    return (r << 16) | (g << 8) | b
+
+
+def make_mips(img: Image.Image, config=Convertor.FLAG.CF_TRUE_COLOR_565_SWAP) -> List[bytes]:
+    """关键帧的1/2、1/4、1/8尺寸缩略图（BOX 取平均，透明像素合成到黑色），返回各级的 .bin 内容"""
+    img = img.convert("RGBA")
+    img = Image.alpha_composite(Image.new("RGBA", img.size, (0, 0, 0, 255)), img).convert("RGB")
+    w, h = img.size
+    out = []
+    for level in range(1, HOLO_MIP_LEVELS + 1):
+        mw, mh = w >> level, h >> level
+        if not mw or not mh:
+            break
+        out.append(convert_bytes(img.resize((mw, mh), Image.BOX), config, dith=False))
+    return out
+
+
+def pack_holo(frames: Iterable[bytes], w: int, h: int, cf: int, fps: int,
+              align: int = HOLO_DEFAULT_ALIGN, flags: int = 0, palette: bytes = b"",
+              ambient: Optional[Sequence[int]] = None,
+              mips: Optional[Sequence[Tuple[int, List[bytes]]]] = None,
+              crop: Optional[Tuple[int, int, int, int]] = None) -> bytes:
+    """
+    把若干 .bin 帧内容打包为 .holo 文件内容；palette 非空时作为共用调色板写在帧索引之后
+    ambient 为各帧的平均色（见 ambient_color），省略时写0
+    mips 为按帧号升序的 (关键帧号, make_mips 的结果)，写在调色板之后、帧0之前
+    crop 为 (crop_x, crop_y, full_w, full_h)：帧（w x h）是完整画布中该位置裁剪出的区域
+    """
+    frames = list(frames)
+    index_offset = HOLO_HEADER_SIZE
+    palette_offset = index_offset + HOLO_ENTRY_SIZE * len(frames) if palette else 0
+    pos = index_offset + HOLO_ENTRY_SIZE * len(frames) + len(palette)
+    if palette:
+        flags |= HOLO_FLAG_PALETTE
+    if crop:
+        flags |= HOLO_FLAG_CROP
+
+    mip_items = [(frame, level + 1, data) for frame, levels in (mips or []) for level, data in enumerate(levels)]
+    mip_offset = pos if mip_items else 0
+    pos += HOLO_MIP_SIZE * len(mip_items)
+    mip_table = bytearray()
+    for frame, level, data in mip_items:
+        mip_table.extend(struct.pack(HOLO_MIP_FMT, pos, len(data), frame, level, 0))
+        pos += len(data)
+    mip_body = b"".join(data for _, _, data in mip_items)
+
+    entries = []
+    body = bytearray()
+    for data in frames:
+        offset = _align_up(pos, align)
+        body.extend(b"\x00" * (offset - pos))
+        body.extend(data)
+        entries.append((offset, len(data), zlib.crc32(data)))
+        pos = offset + len(data)
+
+    version = 1
+    if flags & HOLO_FLAG_CROP:
+        version = HOLO_VERSION_CROP
+    elif flags & HOLO_FLAG_Q565:
+        version = HOLO_VERSION_Q565
+    elif flags & HOLO_FLAG_PALETTE:
+        version = HOLO_VERSION_PALETTE
+    header = struct.pack(HOLO_HEADER_FMT, HOLO_MAGIC, version, HOLO_HEADER_SIZE,
+                         w, h, cf, flags, fps, HOLO_ENTRY_SIZE, len(frames), index_offset, align, palette_offset,
+                         mip_offset, len(mip_items), HOLO_MIP_SIZE, 0, *(crop or (0, 0, 0, 0)))
+    ambient = list(ambient) if ambient is not None else [0] * len(entries)
+    index = b"".join(struct.pack(HOLO_ENTRY_FMT, o, s, a, c) for (o, s, c), a in zip(entries, ambient))
+    return header + index + palette + bytes(mip_table) + mip_body + bytes(body)
+
+
+def make_holo(src: str, out_path: str, fps: int = 25, align: int = HOLO_DEFAULT_ALIGN,
+              size: Optional[Tuple[int, int]] = (240, 240),
+              config=Convertor.FLAG.CF_INDEXED_4_BIT, dith=True,
+              delta: bool = False, tile: int = HOLO_DEFAULT_TILE, jpeg_quality: int = 0,
+              jobs: Optional[int] = None, q565: bool = False, mips: bool = False, mip_every: int = 0,
+              black: int = 0, crop: Optional[int] = None) -> int:
+    """
+    把 GIF/视频/图片文件夹转换为 .holo 动画包，返回帧数；jobs 为并行转换的进程数
+    dith 见 fast.DITHER_MODES（ordered/bluenoise 各帧静止部分相同，差分与Q565更小）
+    black 非0时所有帧先压低黑位（平均色、缩略图与JPEG帧也按压低后的图像）
+    q565 为每帧Q565压缩（只用于16位真彩色，不与 delta 同时使用）
+    mips 为内嵌首帧的缩略图，mip_every 非0时每隔这么多帧再取一个关键帧（隐含 mips）
+    """
+    images = []
+    for img in iter_frames(src):
+        if size and img.size != size:
+            img = img.convert("RGBA").resize(size)
+        images.append(crush_black(img, black))
+    if not images:
+        raise RuntimeError("没有可用的帧: " + src)
+
+    w, h = images[0].size
+    ambient = [ambient_color(img) for img in images]
+    # 缩略图与帧同一字节序；索引色/JPEG的包按固件默认的面板字节序（LV_COLOR_16_SWAP 1）
+    mip_config = config if config == Convertor.FLAG.CF_TRUE_COLOR_565 else Convertor.FLAG.CF_TRUE_COLOR_565_SWAP
+    mip_frames = [i for i in range(len(images)) if i == 0 or (mip_every and i % mip_every == 0)] \
+        if mips or mip_every else []
+    thumbs = [(i, make_mips(images[i], mip_config)) for i in mip_frames]
+
+    # 裁剪：缩略图与平均色已按完整画布生成；外接矩形按差分分块或JPEG的MCU对齐
+    crop_info = None
+    if crop is not None:
+        images = [remove_background(img, crop) for img in images]
+        box = content_box(images, tile if delta else (16 if jpeg_quality else 2))
+        if box is None:
+            print("  所有帧都是黑色，不裁剪")
+        elif box != (0, 0, w, h):
+            images = [img.crop(box) for img in images]
+            crop_info = (box[0], box[1], w, h)
+            w, h = box[2] - box[0], box[3] - box[1]
+            print("  裁剪到 {}x{}（位置 {},{}），帧面积为原来的{:.0%}".format(w, h, box[0], box[1],
+                                                                 w * h / (crop_info[2] * crop_info[3])))
+    if jpeg_quality:
+        payloads = []
+        for img in images:
+            buf = io.BytesIO()
+            # 基线JPEG、4:2:0采样，ROM tjpgd不支持渐进式
+            img.convert("RGB").save(buf, "JPEG", quality=jpeg_quality, progressive=False, subsampling=2)
+            payloads.append(buf.getvalue())
+        for i, data in enumerate(payloads):
+            print("  帧 {} ({} 字节)".format(i, len(data)))
+        with open(out_path, "wb") as f:
+            f.write(pack_holo(payloads, w, h, 0, fps, align, HOLO_FLAG_JPEG, ambient=ambient, mips=thumbs,
+                              crop=crop_info))
+        return len(payloads)
+
+    if delta and (w % tile or h % tile):
+        print("  图像尺寸不是分块大小{}的整数倍，改为输出完整帧".format(tile))
+        delta = False
+    if q565 and config not in (Convertor.FLAG.CF_TRUE_COLOR_565, Convertor.FLAG.CF_TRUE_COLOR_565_SWAP):
+        print("  Q565只支持rgb565/rgb565_swap，改为输出未压缩的帧")
+        q565 = False
+    if q565 and delta:
+        raise RuntimeError("delta与q565不能同时使用")
+
+    # 索引色：所有帧按同一调色板量化，调色板只在包中保存一份
+    palette = None
+    if config in PALETTE_SIZE:
+        palette = shared_palette(images, PALETTE_SIZE[config])
+
+    bins = convert_many(images, config, dith, palette=palette, jobs=jobs)
+
+    lv_cf = struct.unpack("<L", bins[0][:4])[0] & 0x1F
+    bpp = LV_CF_BPP.get(lv_cf, 16)
+    flags = 0
+    payloads = bins
+    if delta:
+        payloads = [bins[0]] + [encode_delta(bins[i - 1], bins[i], w, h, bpp, tile) for i in range(1, len(bins))]
+        flags |= HOLO_FLAG_DELTA
+    elif q565:
+        swap = config == Convertor.FLAG.CF_TRUE_COLOR_565_SWAP
+        payloads = [min(encode_q565(b, swap), b, key=len) for b in bins]
+        flags |= HOLO_FLAG_Q565
+
+    pal = b""
+    if palette is not None:
+        pal = bins[0][4:4 + (4 << bpp)]
+        full = 1 if delta else len(payloads)
+        payloads = [strip_palette(p, bpp) for p in payloads[:full]] + payloads[full:]
+
+    for i, data in enumerate(payloads):
+        print("  帧 {} ({} 字节)".format(i, len(data)))
+
+    with open(out_path, "wb") as f:
+        f.write(pack_holo(payloads, w, h, lv_cf, fps, align, flags, pal, ambient, thumbs, crop_info))
+    return len(bins)
@@ -0,0 +1,168 @@
+"""
+语言包格式（与固件 include/i18n.h 保持一致）
+
+文件布局（小端，各部分4字节对齐）：
+    [文件头 40字节][文字偏移 count * 4字节][UTF-8文字，'\\0'结尾 ...][字体（可选）]
+
+- 文字按固件 include/i18n_strings.h 中的编号顺序排列，偏移为0表示该项未翻译（固件使用内置英文）
+- 字体只包含翻译中用到的字符与可打印ASCII，字形位图为LVGL格式（逐行连续、高位在前）：
+    [字体头 12字节][码位 uint32 * n（升序）][字形 12字节 * n][位图]
+- 语言包作为资源包中名为"lang_<代码>"的一项，固件映射后原地引用
+
+翻译文件（.lang，UTF-8）每行"编号 = 文字"，'#'开头为注释，\\n与\\\\为转义；
+"@code = zh"、"@name = 中文"给出语言代码与名称（没有@code时取文件名）。
+"""
+import os.path
+import re
+import struct
+from typing import *
+
+I18N_MAGIC = b"HOLI"
+I18N_VERSION = 1
+I18N_HEADER_FMT = "<4sHH8s16sII"
+I18N_HEADER_SIZE = struct.calcsize(I18N_HEADER_FMT)
+I18N_FONT_HEADER_FMT = "<HhHBbB3x"
+I18N_GLYPH_FMT = "<IHBBbb2x"
+I18N_CODE_LEN = 8
+I18N_NAME_LEN = 16
+I18N_ASSET_PREFIX = "lang_"
+I18N_FONT_BPP = 4
+
+# 固件中的文字表（编号顺序以它为准）
+I18N_IDS_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..",
+                             "2.Firmware", "HoloCubic-fw", "include", "i18n_strings.h")
+
+_ID_RE = re.compile(r'^\s*I18N_STRING\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', re.M)
+
+
+def load_ids(path: str = I18N_IDS_PATH) -> List[str]:
+    """按顺序返回固件文字表中的编号"""
+    with open(path, encoding="utf-8") as f:
+        ids = [m.group(1) for m in _ID_RE.finditer(f.read())]
+    if not ids:
+        raise RuntimeError("{}中没有I18N_STRING".format(path))
+    return ids
+
+
+def _unescape(s: str) -> str:
+    return re.sub(r"\\(.)", lambda m: "\n" if m.group(1) == "n" else m.group(1), s)
+
+
+def parse_lang(path: str) -> Tuple[str, str, Dict[str, str]]:
+    """读取翻译文件，返回(语言代码, 语言名称, {编号: 文字})"""
+    code = os.path.splitext(os.path.basename(path))[0]
+    name = code
+    texts = {}
+    with open(path, encoding="utf-8-sig") as f:
+        for n, line in enumerate(f, 1):
+            line = line.rstrip("\r\n")
+            if not line.strip() or line.lstrip().startswith("#"):
+                continue
+            if "=" not in line:
+                raise ValueError("{}:{}: 缺少'='".format(path, n))
+            key, text = line.split("=", 1)
+            key, text = key.strip(), _unescape(text.strip())
+            if key == "@code":
+                code = text
+            elif key == "@name":
+                name = text
+            else:
+                texts[key] = text
+    if not code or len(code.encode("utf-8")) >= I18N_CODE_LEN:
+        raise ValueError("{}: 语言代码为空或过长（最多{}字节）".format(path, I18N_CODE_LEN - 1))
+    if len(name.encode("utf-8")) >= I18N_NAME_LEN:
+        raise ValueError("{}: 语言名称过长（最多{}字节）".format(path, I18N_NAME_LEN - 1))
+    return code, name, texts
+
+
+def _pack_bits(values: Iterable[int], bpp: int) -> bytes:
+    """按LVGL字形位图的方式连续打包（高位在前，行之间不补齐）"""
+    out = bytearray()
+    acc = bits = 0
+    for v in values:
+        acc = (acc << bpp) | v
+        bits += bpp
+        if bits == 8:
+            out.append(acc)
+            acc = bits = 0
+    if bits:
+        out.append(acc << (8 - bits))
+    return bytes(out)
+
+
+def make_font(chars: Iterable[str], font_path: str, size: int, bpp: int = I18N_FONT_BPP) -> bytes:
+    """把字符集栅格化为语言包中的字体块（需要Pillow 8以上）"""
+    from PIL import Image, ImageDraw, ImageFont
+
+    font = ImageFont.truetype(font_path, size)
+    ascent, descent = font.getmetrics()
+    codes = sorted(set(ord(c) for c in chars if c >= " "))
+
+    glyphs = []
+    bitmaps = bytearray()
+    for cp in codes:
+        ch = chr(cp)
+        adv = int(round(font.getlength(ch) * 16))
+        x0, y0, x1, y1 = font.getbbox(ch, anchor="ls")
+        w, h = max(0, x1 - x0), max(0, y1 - y0)
+        if w == 0 or h == 0:
+            w = h = x0 = y1 = 0
+            data = b""
+        else:
+            if w > 255 or h > 255:
+                raise ValueError("字形过大: U+{:04X}".format(cp))
+            img = Image.new("L", (w, h), 0)
+            ImageDraw.Draw(img).text((-x0, -y0), ch, font=font, fill=255, anchor="ls")
+            data = _pack_bits((v >> (8 - bpp) for v in img.getdata()), bpp)
+        glyphs.append((len(bitmaps), adv, w, h, x0, -y1))
+        bitmaps.extend(data)
+
+    head_size = struct.calcsize(I18N_FONT_HEADER_FMT)
+    bitmap_base = head_size + len(codes) * (4 + struct.calcsize(I18N_GLYPH_FMT))
+    out = bytearray(struct.pack(I18N_FONT_HEADER_FMT, ascent + descent, descent, len(codes), bpp,
+                                -max(1, descent // 2), max(1, size // 14)))
+    out.extend(struct.pack("<{}I".format(len(codes)), *codes))
+    for off, adv, w, h, ox, oy in glyphs:
+        out.extend(struct.pack(I18N_GLYPH_FMT, bitmap_base + off, adv, w, h, ox, oy))
+    out.extend(bitmaps)
+    return bytes(out)
+
+
+def compile_lang(path: str, font_path: Optional[str] = None, size: int = 14,
+                 ids_path: str = I18N_IDS_PATH) -> Tuple[str, bytes]:
+    """把翻译文件编译为语言包，返回(资源名, 内容)；font_path为None时不带字体（固件使用内置字体）"""
+    ids = load_ids(ids_path)
+    code, name, texts = parse_lang(path)
+    unknown = sorted(set(texts) - set(ids))
+    if unknown:
+        raise ValueError("{}: 固件文字表中没有这些编号: {}".format(path, ", ".join(unknown)))
+    missing = [i for i in ids if i not in texts]
+    if missing:
+        print("  {}: {}项未翻译，使用内置文字: {}".format(code, len(missing), ", ".join(missing)))
+
+    start = I18N_HEADER_SIZE + 4 * len(ids)
+    offsets = []
+    body = bytearray()
+    for i in ids:
+        if i not in texts:
+            offsets.append(0)
+            continue
+        offsets.append(start + len(body))
+        body.extend(texts[i].encode("utf-8") + b"\0")
+    if not body:
+        body.append(0)
+    end = start + len(body)
+
+    font = b""
+    font_off = 0
+    if font_path:
+        chars = "".join(texts.values()) + "".join(chr(c) for c in range(0x20, 0x7F))
+        font = make_font(chars, font_path, size)
+        font_off = (end + 3) // 4 * 4
+        body.extend(b"\0" * (font_off - end))
+
+    total = start + len(body) + len(font)
+    header = struct.pack(I18N_HEADER_FMT, I18N_MAGIC, I18N_VERSION, len(ids), code.encode("utf-8"),
+                         name.encode("utf-8"), font_off, total)
+    data = header + struct.pack("<{}I".format(len(ids)), *offsets) + bytes(body) + font
+    return I18N_ASSET_PREFIX + code, data
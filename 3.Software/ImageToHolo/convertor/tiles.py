@@ -0,0 +1,116 @@
+"""
+.htl 分块大图格式（与固件 include/tile_format.h 保持一致）
+
+文件布局（小端）：
+    [文件头 32字节][分块索引 tile_count * entry_size][分块数据...]
+
+- 多级金字塔：第0级为原图，第n级为 (w >> n, h >> n)（BOX 取平均），最后一级不大于 240x240，
+  相册平时显示最后一级，按下后由固件的 TileViewer 平移、逐级放大
+- 索引按级别、行、列排列，条目为 [offset u32][size u32][codec u8][0 0 0]；
+  右、下边缘的分块同样是完整尺寸，图像以外的部分为黑色
+- 每块单独选择编码：TILE_CODEC_Q565（"Q565" + 操作码）小于原始大小时使用，否则为小端 RGB565 原始像素；
+  指定 JPEG 质量时改为基线 JPEG（照片类全景图），不小于原始大小的分块仍保存原始像素
+- 整级一次抖动后再切块，分块之间没有接缝
+"""
+import io
+import struct
+from typing import *
+
+from PIL import Image
+
+from convertor.core import Convertor
+from convertor.fast import convert_bytes, crush_black
+from convertor.holo import encode_q565
+
+TILE_MAGIC = b"HTIL"
+TILE_VERSION = 1
+TILE_HEADER_FMT = "<4sHHHHHHBBHIII"
+TILE_HEADER_SIZE = struct.calcsize(TILE_HEADER_FMT)
+TILE_ENTRY_FMT = "<IIB3x"  # offset, size, codec
+TILE_ENTRY_SIZE = struct.calcsize(TILE_ENTRY_FMT)
+TILE_SIZE_MAX = 64  # 固件分块缓存按此分配
+TILE_LEVELS_MAX = 8
+TILE_DEFAULT_SIZE = 64
+TILE_OVERVIEW_MAX = 240
+TILE_CODEC_RAW = 0
+TILE_CODEC_Q565 = 1
+TILE_CODEC_JPEG = 2
+
+
+def pyramid_levels(w: int, h: int) -> int:
+    """级数：逐级减半直到不大于 TILE_OVERVIEW_MAX"""
+    levels = 1
+    while max(w >> (levels - 1), h >> (levels - 1)) > TILE_OVERVIEW_MAX:
+        levels += 1
+    return levels
+
+
+def encode_tile(img: Image.Image, raw: bytes, jpeg_quality: int) -> Tuple[int, bytes]:
+    """选择一块的编码，raw 为小端 RGB565 像素，img 为对应的 RGB 图像（JPEG 用）"""
+    if jpeg_quality:
+        buf = io.BytesIO()
+        # 基线JPEG、4:2:0采样，ROM tjpgd不支持渐进式
+        img.save(buf, "JPEG", quality=jpeg_quality, progressive=False, subsampling=2)
+        data = buf.getvalue()
+        return (TILE_CODEC_JPEG, data) if len(data) < len(raw) else (TILE_CODEC_RAW, raw)
+    # encode_q565 的输入输出带4字节图像头，分块中只保存 "Q565" + 操作码
+    q = encode_q565(b"\0\0\0\0" + raw, swap=False)[4:]
+    return (TILE_CODEC_Q565, q) if len(q) < len(raw) else (TILE_CODEC_RAW, raw)
+
+
+def make_tiled(src: str, out_path: str, tile: int = TILE_DEFAULT_SIZE, jpeg_quality: int = 0,
+               dith="fs", black: int = 0) -> Tuple[int, int]:
+    """
+    把一张大图（全景图等）转换为 .htl 分块大图
+    tile 为分块边长（不超过 TILE_SIZE_MAX，JPEG 分块需为16的倍数）；dith/black 见 convert_bytes
+    返回 (级数, 分块总数)
+    """
+    if not 0 < tile <= TILE_SIZE_MAX:
+        raise ValueError("分块边长应为1~{}".format(TILE_SIZE_MAX))
+    if jpeg_quality and tile % 16:
+        raise ValueError("JPEG分块边长应为16的倍数")
+
+    img = Image.open(src).convert("RGBA")
+    img = Image.alpha_composite(Image.new("RGBA", img.size, (0, 0, 0, 255)), img)
+    img = crush_black(img, black).convert("RGB")
+    w, h = img.size
+    if w > 0xFFFF or h > 0xFFFF:
+        raise ValueError("图像尺寸超出65535")
+    levels = pyramid_levels(w, h)
+    if levels > TILE_LEVELS_MAX:
+        raise ValueError("图像过大：需要{}级（最多{}级）".format(levels, TILE_LEVELS_MAX))
+
+    entries = []
+    payloads = []
+    for level in range(levels):
+        lw, lh = max(w >> level, 1), max(h >> level, 1)
+        cols, rows = (lw + tile - 1) // tile, (lh + tile - 1) // tile
+        scaled = img if level == 0 else img.resize((lw, lh), Image.BOX)
+        padded = Image.new("RGB", (cols * tile, rows * tile))
+        padded.paste(scaled, (0, 0))
+        # 小端RGB565（与固件RAW分块一致），跳过4字节图像头
+        px = convert_bytes(padded, Convertor.FLAG.CF_TRUE_COLOR_565, dith=dith)[4:]
+        stride = cols * tile * 2
+        for r in range(rows):
+            for c in range(cols):
+                base = r * tile * stride + c * tile * 2
+                raw = b"".join(px[base + y * stride: base + y * stride + tile * 2] for y in range(tile))
+                box = (c * tile, r * tile, (c + 1) * tile, (r + 1) * tile)
+                codec, data = encode_tile(padded.crop(box) if jpeg_quality else None, raw, jpeg_quality)
+                entries.append(codec)
+                payloads.append(data)
+
+    index_offset = TILE_HEADER_SIZE
+    offset = index_offset + len(entries) * TILE_ENTRY_SIZE
+    index = bytearray()
+    for codec, data in zip(entries, payloads):
+        index += struct.pack(TILE_ENTRY_FMT, offset, len(data), codec)
+        offset += len(data)
+    header = struct.pack(TILE_HEADER_FMT, TILE_MAGIC, TILE_VERSION, TILE_HEADER_SIZE, w, h, tile, tile,
+                         levels, TILE_ENTRY_SIZE, 0, index_offset, len(entries), max(len(p) for p in payloads))
+    with open(out_path, "wb") as f:
+        f.write(header)
+        f.write(index)
+        for data in payloads:
+            f.write(data)
+    return levels, len(entries)
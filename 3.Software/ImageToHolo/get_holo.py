@@ -1,15 +1,84 @@
-import os.path, sys, time
+import argparse, multiprocessing, os.path, sys, time
 from convertor.core import Convertor
+from convertor.batch import convert_batch
+from convertor.fast import DITHER_MODES
+
+COLOR_FORMATS = {
+    "indexed4": Convertor.FLAG.CF_INDEXED_4_BIT,
+    "indexed8": Convertor.FLAG.CF_INDEXED_8_BIT,
+    "rgb565": Convertor.FLAG.CF_TRUE_COLOR_565,
+    "rgb565_swap": Convertor.FLAG.CF_TRUE_COLOR_565_SWAP,
+}
 
 if __name__ == '__main__':
+    multiprocessing.freeze_support()  # 打包为.exe后子进程需要
 
     if len(sys.argv) < 2:
         print("用法: 把要转换的 JPG/PNG/BMP 文件拖到.exe图标上即可")
+        print("      打包动画: get_holo --holo out.holo [--fps 25] [--align 4096] [--delta | --jpeg 80 | --q565] [--mips] [--crop [N]] <GIF/MP4/图片文件夹>")
+        print("      分块大图: get_holo --tiled out.htl [--tile-size 64] [--jpeg 80] <大图>（相册中平移、放大浏览）")
+        print("      资源包:   get_holo --assets assets.bin <图片或.bin ...>（esptool.py write_flash 0x290000 assets.bin）")
+        print("      语言包:   资源包输入中加入lang/zh.lang等翻译文件，--lang-font 字体.ttf [--lang-size 14]")
+        print("      颜色格式: --color indexed4|indexed8|rgb565|rgb565_swap（真彩色固件默认使用rgb565_swap）")
+        print("      抖动方式: --dither fs|ordered|bluenoise|none（ordered/bluenoise的动画差分与压缩更小）")
+        print("      黑位压低: --black N（不高于N的通道值压到0，减轻棱镜上的灰底）")
+        print("      并行转换: --jobs N（默认使用全部CPU核）；--out 目录，未变化的输入跳过（--force 全部重新转换）")
         time.sleep(3)
         sys.exit(0)
 
-    for i, img_path in enumerate(sys.argv[1:]):
-        print("正在转换图片{} ...".format(os.path.basename(img_path)))
-        c = Convertor(img_path)
-        c.get_bin_file()
-        # c.get_c_code_file()
+    parser = argparse.ArgumentParser()
+    parser.add_argument("inputs", nargs="+")
+    parser.add_argument("--holo", help="把输入打包为单个 .holo 动画文件")
+    parser.add_argument("--fps", type=int, default=25)
+    parser.add_argument("--align", type=int, default=4096, help="帧对齐字节数（SD卡簇大小）")
+    parser.add_argument("--delta", action="store_true", help="除首帧外只保存变化的分块（共用调色板）")
+    parser.add_argument("--tile", type=int, default=16, help="差分分块边长（像素）")
+    parser.add_argument("--tiled", help="把输入转换为 .htl 分块大图（放到SD卡/Photos下）")
+    parser.add_argument("--tile-size", type=int, default=64, help="分块大图的分块边长（像素，最大64）")
+    parser.add_argument("--assets", help="把输入打包为flash资源包（烧录到assets分区）")
+    parser.add_argument("--lang-font", help="资源包中语言包（.lang）的字形所用的TTF/TTC/OTF字体")
+    parser.add_argument("--lang-size", type=int, default=14, help="语言包字形的像素大小")
+    parser.add_argument("--q565", action="store_true", help="每帧Q565压缩（需要--color rgb565_swap或rgb565）")
+    parser.add_argument("--mips", action="store_true", help="内嵌首帧的1/2、1/4、1/8缩略图（场景浏览界面使用）")
+    parser.add_argument("--mip-every", type=int, default=0, metavar="N", help="每隔N帧再取一个关键帧生成缩略图")
+    parser.add_argument("--crop", type=int, nargs="?", const=0, default=None, metavar="N",
+                        help="去除背景（各通道不高于N的像素改为纯黑）并把帧裁剪到非黑内容的外接矩形，N默认0")
+    parser.add_argument("--jpeg", type=int, default=0, metavar="QUALITY", help="每帧保存为JPEG（MJPEG），指定质量1~95")
+    parser.add_argument("--color", choices=sorted(COLOR_FORMATS), default="indexed4",
+                        help="颜色格式；rgb565_swap为面板字节序，与固件LV_COLOR_16_SWAP 1配套，rgb565对应LV_COLOR_16_SWAP 0")
+    parser.add_argument("--dither", choices=DITHER_MODES, default="fs",
+                        help="真彩色格式的抖动方式：fs误差扩散，ordered为Bayer有序抖动，bluenoise为蓝噪声有序抖动")
+    parser.add_argument("--black", type=int, default=0, metavar="N",
+                        help="黑位压低：不高于N的通道值压到0，其余线性拉伸（分光棱镜上暗部显灰时使用）")
+    parser.add_argument("--jobs", type=int, default=None, help="并行转换的进程数，默认为CPU核数")
+    parser.add_argument("--out", default=".", help="逐个转换时 .bin 的输出目录（其中的.holo_cache.json记录已转换的输入）")
+    parser.add_argument("--force", action="store_true", help="忽略缓存，全部重新转换")
+    args = parser.parse_args()
+    config = COLOR_FORMATS[args.color]
+
+    if args.holo:
+        from convertor.holo import make_holo
+        print("正在打包动画{} ...".format(os.path.basename(args.inputs[0])))
+        n = make_holo(args.inputs[0], args.holo, args.fps, args.align, config=config,
+                      delta=args.delta, tile=args.tile, jpeg_quality=args.jpeg, jobs=args.jobs, q565=args.q565,
+                      mips=args.mips, mip_every=args.mip_every, dith=args.dither, black=args.black, crop=args.crop)
+        print("已生成 {}，共{}帧".format(args.holo, n))
+        sys.exit(0)
+
+    if args.tiled:
+        from convertor.tiles import make_tiled
+        levels, n = make_tiled(args.inputs[0], args.tiled, args.tile_size, jpeg_quality=args.jpeg,
+                               dith=args.dither, black=args.black)
+        print("已生成 {}，{}级，共{}块".format(args.tiled, levels, n))
+        sys.exit(0)
+
+    if args.assets:
+        from convertor.assets import make_assets
+        n = make_assets(args.inputs, args.assets, config, jobs=args.jobs,
+                        dith=args.dither, lang_font=args.lang_font, lang_size=args.lang_size, black=args.black)
+        print("已生成 {}，共{}个资源".format(args.assets, n))
+        sys.exit(0)
+
+    print("正在转换{}张图片 ...".format(len(args.inputs)))
+    convert_batch(args.inputs, args.out, config, args.dither, args.black, jobs=args.jobs, force=args.force)
+    # Convertor(img_path, config).get_c_code_file()
@@ -0,0 +1,893 @@
+/*
+ * LvglBench 主机端界面渲染基准
+ *
+ * 功能说明：
+ * 1. 原样编译固件的lvgl（lib/lvgl及其lv_conf.h）与界面代码：lv_cubic_gui.c、gui_guider.c、
+ *    setup_scr_*.c、屏幕管理器，以及LVGL堆（lv_port_mem.c）、编码器端口（lv_port_indev.c）
+ *    和手势引擎（gesture.cpp）、预乘alpha绘制（premul_decoder.cpp），显示驱动换成内存帧缓冲
+ * 2. 按轨迹文件回放：IMU样本经手势引擎转换为编码器事件，与设备上的输入路径相同；
+ *    时钟为虚拟时间，同一份轨迹每次产生相同的帧序列与画面（每帧输出帧缓冲CRC32）
+ * 3. 每帧记录lv_refr中render_prof钩子测得的合并/绘制/刷新耗时，以及LVGL堆与系统堆的用量峰值，
+ *    可设置上限，超出时返回非0，便于在烧录前发现渲染性能回退
+ *
+ * 4. ESP32时序模型：按条带把主机上测得的绘制耗时乘以CPU系数，刷新按SPI时钟与字节数计算发送时间
+ *    （DMA模式下与下一条带的绘制重叠），SD卡读取按次数与字节数计算，得到每帧在设备上的预计耗时；
+ *    再按LV_DISP_DEF_REFR_PERIOD排出设备上的帧时间线，报告预计帧率与超出帧预算（--fps）的帧数，
+ *    逐帧数值写入CSV的pred_*列。CPU系数需在设备上用render_prof的绘制耗时与同一画面的回放结果校准
+ *
+ * 5. 手势评估模式（--gesture）：把设备录制的.imt轨迹送入固件的手势回放评估（gesture_replay.cpp），
+ *    输出每类手势的识别延迟、漏检与误触发；--rules可换用待调整的规则表，不需要界面
+ *
+ * 用法：
+ *   lvgl_bench [--sd DIR] [--lines N] [--csv FILE] [--snap-dir DIR] [--split]
+ *              [--spi-mhz N] [--cpu-scale X] [--sd-latency-us N] [--sd-mhz N] [--flush dma|blocking] [--fps N]
+ *              [--max-frame-us N] [--max-pred-us N] [--max-mem BYTES] traces/navigate.trace
+ *   lvgl_bench [--rules FILE] [--max-fp N] [--max-miss N] --gesture a.imt [--gesture b.imt ...]
+ *
+ * 轨迹文件每行为“时间(ms) 命令 参数...”，时间不得递减，#开头为注释：
+ *   logo                        lv_holo_cubic_gui()，与main.cpp启动时相同
+ *   ui                          setup_ui()，登记GUI向导界面并显示场景界面
+ *   load home|scenes [动画]     gui_load()，动画为none/left/right/top/bottom/fade
+ *   imu ax ay az gx gy gz       IMU原始样本，此后每BENCH_IMU_PERIOD_MS送入手势引擎一次，直到下一条imu
+ *   imu off                     停止送入样本
+ *   imutrace 文件               按录制时的时间间隔送入.imt轨迹中的全部样本（从该命令的时间开始）
+ *   enc 步数 / press / release  直接写入编码器事件
+ *   focus                       把主界面的取色器加入编码器组并进入编辑状态（固件尚未绑定控件组，
+ *                               用于测量旋转时的交互重绘）
+ *   snap 名称                   把当前画面保存为<snap-dir>/<名称>.ppm
+ *   end                         回放结束时间（缺省为最后一行的时间）
+ *
+ * 规则文件每行一条GestureRule，#开头为注释（字段同gesture.cpp中的默认规则表）：
+ *   手势 信号 进入 退出 保持ms 重复ms 不应期ms     例：tilt_left ay 3000 1500 60 400 150
+ *   信号为ax/ay/jerk/rotation
+ *
+ * 注意事项：
+ * - 耗时为主机CPU上的实测值，只用于同一台机器上前后比较，不代表设备上的绝对耗时；
+ *   预计耗时是按上述模型的估算，用于在上机前判断界面能否保持目标帧率，不能代替设备上的render_prof
+ * - 堆用量按设备的分配器与无PSRAM的分配策略统计，与设备上的数值可以直接比较
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "lvgl.h"
+#include "lv_port_mem.h"
+#include "lv_port_indev.h"
+#include "lv_cubic_gui.h"
+#include "gui_guider.h"
+#include "gesture.h"
+#include "gesture_replay.h"
+#include "imu_trace_format.h"
+#include "render_prof.h"
+#include "draw_split.h"
+#include "premul_decoder.h"
+#include "lv_port_host.h"
+
+// 默认绘制缓冲行数（与固件display.h的DISP_BUF_LINES一致）
+#define BENCH_BUF_LINES 10
+// 回放步长：每步推进虚拟时钟并调用一次lv_task_handler
+#define BENCH_STEP_MS 5
+// IMU样本间隔（与固件imu.h的IMU_FIFO_RATE_HZ一致）
+#define BENCH_IMU_PERIOD_MS 10
+
+// ESP32时序模型的默认参数（可用命令行覆盖）
+// 显示SPI时钟（display.h的SPI_FREQUENCY；写时钟自检通过时为80）
+#define BENCH_ESP32_SPI_MHZ 40
+// 设备上绘制耗时与主机实测值之比（240MHz双核、无PSRAM，字体与图片在flash中经cache读取）
+#define BENCH_ESP32_CPU_SCALE 12.0
+// 每条带的窗口命令与DMA排队开销
+#define BENCH_ESP32_FLUSH_SETUP_US 15
+// SD卡每次读取的命令与等待，以及去掉FATFS开销后的有效位速率（sd_card.h的SD_SPI_FREQ为40MHz）
+#define BENCH_ESP32_SD_LATENCY_US 400
+#define BENCH_ESP32_SD_MHZ 20
+// 帧预算（帧率目标）
+#define BENCH_ESP32_FPS 30
+
+lv_ui guider_ui;
+
+/**
+ * 轨迹中的一条命令
+ */
+struct TraceEvent
+{
+	uint32_t time;
+	std::string cmd;
+	std::vector<std::string> args;
+	int line;
+};
+
+/**
+ * 一帧的记录（耗时单位微秒）
+ */
+struct FrameRecord
+{
+	uint32_t time_ms;
+	uint32_t px;
+	uint32_t us[RENDER_PROF_PHASE_CNT];
+	uint32_t pred_us;       // ESP32时序模型：预计帧耗时及其中的CPU、SPI发送、SD读取部分
+	uint32_t pred_cpu_us;
+	uint32_t pred_spi_us;
+	uint32_t pred_sd_us;
+	uint32_t lv_used;
+	uint32_t lv_peak;
+	uint32_t sys_peak;
+	uint32_t crc;
+};
+
+static lv_color_t framebuffer[LV_HOR_RES_MAX * LV_VER_RES_MAX];
+static std::vector<FrameRecord> frames;
+static int64_t phase_start[RENDER_PROF_PHASE_CNT];
+static uint32_t phase_acc[RENDER_PROF_PHASE_CNT];
+static bool input_wake;
+
+/**
+ * ESP32时序模型
+ * 一帧内按设备上的时间线推进：CPU时间线cpu与DMA发送结束时刻dma_end，均相对帧开始（微秒）。
+ * 每次刷新前把距上次记录以来的主机耗时（扣除主机读文件的耗时）乘以cpu_scale计入CPU时间线，
+ * SD读取按模型耗时计入；DMA模式下条带等上一条带发送完才能开始发送，CPU随后即可绘制下一条带
+ */
+struct Esp32Model
+{
+	uint32_t spi_mhz;
+	double cpu_scale;
+	uint32_t sd_latency_us;
+	uint32_t sd_mhz;
+	bool dma;
+	uint32_t fps;
+
+	int64_t mark;
+	host_fs_stats_t fs;
+	double cpu;
+	double dma_end;
+	double cpu_sum;
+	double spi_sum;
+	double sd_sum;
+};
+
+static Esp32Model model = { BENCH_ESP32_SPI_MHZ, BENCH_ESP32_CPU_SCALE, BENCH_ESP32_SD_LATENCY_US, BENCH_ESP32_SD_MHZ,
+							true, BENCH_ESP32_FPS };
+
+static int64_t now_us()
+{
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t crc32(const void* data, size_t len)
+{
+	static uint32_t table[256];
+	if (table[1] == 0)
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+	}
+	uint32_t crc = 0xFFFFFFFFu;
+	const uint8_t* p = (const uint8_t*)data;
+	for (size_t i = 0; i < len; i++) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFFu;
+}
+
+/*------------------
+ * render_prof钩子（lv_refr.c与lv_port_indev.c调用）
+ * -----------------*/
+
+/**
+ * 把距上次记录以来的主机耗时与SD读取计入CPU时间线
+ */
+static void model_advance()
+{
+	int64_t now = now_us();
+	host_fs_stats_t fs;
+	host_get_fs_stats(&fs);
+	double host = (double)(now - model.mark) - (double)(fs.host_us - model.fs.host_us);
+	double cpu = std::max(host, 0.0) * model.cpu_scale;
+	double sd = (double)(fs.reads - model.fs.reads) * model.sd_latency_us +
+				(double)(fs.bytes - model.fs.bytes) * 8.0 / model.sd_mhz;
+	model.cpu += cpu + sd;
+	model.cpu_sum += cpu;
+	model.sd_sum += sd;
+	model.fs = fs;
+	model.mark = now;
+}
+
+/**
+ * 一帧开始：两帧之间LVGL任务中的SD读取（如场景播放器读帧）在刷新之前完成，计入本帧
+ */
+static void model_frame_begin()
+{
+	model.cpu = 0;
+	model.dma_end = 0;
+	model.cpu_sum = 0;
+	model.spi_sum = 0;
+	model.sd_sum = 0;
+	model.mark = now_us();
+	host_fs_stats_t fs;
+	host_get_fs_stats(&fs);
+	model.fs.host_us = fs.host_us;
+	model_advance();
+}
+
+/**
+ * 一条带的刷新：发送时间为字节数按SPI时钟计算，DMA模式下与下一条带的绘制重叠
+ */
+static void model_flush(uint32_t px)
+{
+	model_advance();
+	double spi = (double)px * sizeof(lv_color_t) * 8.0 / model.spi_mhz;
+	if (model.dma)
+	{
+		double start = std::max(model.cpu, model.dma_end);
+		model.dma_end = start + spi;
+		model.cpu = start + BENCH_ESP32_FLUSH_SETUP_US;
+	}
+	else
+	{
+		model.cpu += BENCH_ESP32_FLUSH_SETUP_US + spi;
+		model.dma_end = model.cpu;
+	}
+	model.spi_sum += spi;
+}
+
+extern "C" void render_prof_begin(render_prof_phase_t phase)
+{
+	phase_start[phase] = now_us();
+	if (phase == RENDER_PROF_FRAME) model_frame_begin();
+}
+
+extern "C" void render_prof_end(render_prof_phase_t phase)
+{
+	phase_acc[phase] += (uint32_t)(now_us() - phase_start[phase]);
+}
+
+/**
+ * 一次有重绘的刷新结束：写入帧记录（帧缓冲CRC在计时之后计算，不计入耗时）
+ */
+extern "C" void render_prof_frame_end(uint32_t px)
+{
+	FrameRecord f;
+	memset(&f, 0, sizeof(f));
+	f.time_ms = millis();
+	f.px = px;
+	memcpy(f.us, phase_acc, sizeof(f.us));
+	f.us[RENDER_PROF_FRAME] = (uint32_t)(now_us() - phase_start[RENDER_PROF_FRAME]);
+	memset(phase_acc, 0, sizeof(phase_acc));
+
+	model_advance();
+	f.pred_us = (uint32_t)std::max(model.cpu, model.dma_end);
+	f.pred_cpu_us = (uint32_t)model.cpu_sum;
+	f.pred_spi_us = (uint32_t)model.spi_sum;
+	f.pred_sd_us = (uint32_t)model.sd_sum;
+
+	lv_port_mem_stats_t mem;
+	lv_port_mem_get_stats(&mem);
+	host_heap_stats_t sys;
+	host_get_heap_stats(&sys);
+	f.lv_used = mem.used_size;
+	f.lv_peak = mem.max_used;
+	f.sys_peak = sys.peak;
+	f.crc = crc32(framebuffer, sizeof(framebuffer));
+	frames.push_back(f);
+}
+
+/*------------------
+ * 内存显示驱动
+ * -----------------*/
+
+static void bench_flush(lv_disp_drv_t* disp, const lv_area_t* area, lv_color_t* color_p)
+{
+	int32_t w = lv_area_get_width(area);
+	model_flush((uint32_t)lv_area_get_size(area));
+	for (int32_t y = area->y1; y <= area->y2; y++)
+	{
+		memcpy(&framebuffer[y * LV_HOR_RES_MAX + area->x1], color_p, w * sizeof(lv_color_t));
+		color_p += w;
+	}
+	// 复制到帧缓冲在设备上由DMA完成，不计入CPU时间线
+	model.mark = now_us();
+	lv_disp_flush_ready(disp);
+}
+
+static void display_init(uint16_t lines)
+{
+	static lv_disp_buf_t disp_buf;
+	lv_color_t* buf = (lv_color_t*)malloc(LV_HOR_RES_MAX * lines * sizeof(lv_color_t));
+	lv_disp_buf_init(&disp_buf, buf, NULL, LV_HOR_RES_MAX * lines);
+
+	lv_disp_drv_t drv;
+	lv_disp_drv_init(&drv);
+	drv.hor_res = LV_HOR_RES_MAX;
+	drv.ver_res = LV_VER_RES_MAX;
+	drv.flush_cb = bench_flush;
+	drv.buffer = &disp_buf;
+	lv_disp_drv_register(&drv);
+}
+
+static bool save_ppm(const std::string& path)
+{
+	FILE* f = fopen(path.c_str(), "wb");
+	if (f == NULL) return false;
+	fprintf(f, "P6\n%d %d\n255\n", LV_HOR_RES_MAX, LV_VER_RES_MAX);
+	for (uint32_t i = 0; i < LV_HOR_RES_MAX * LV_VER_RES_MAX; i++)
+	{
+		lv_color32_t c;
+		c.full = lv_color_to32(framebuffer[i]);
+		uint8_t rgb[3] = { c.ch.red, c.ch.green, c.ch.blue };
+		fwrite(rgb, 1, 3, f);
+	}
+	fclose(f);
+	return true;
+}
+
+/*------------------
+ * 轨迹
+ * -----------------*/
+
+static bool load_trace(const char* path, std::vector<TraceEvent>* out)
+{
+	FILE* f = fopen(path, "r");
+	if (f == NULL)
+	{
+		fprintf(stderr, "无法打开轨迹: %s\n", path);
+		return false;
+	}
+
+	char line[512];
+	int no = 0;
+	uint32_t last = 0;
+	while (fgets(line, sizeof(line), f))
+	{
+		no++;
+		char* hash = strchr(line, '#');
+		if (hash) *hash = '\0';
+
+		std::vector<std::string> tok;
+		for (char* t = strtok(line, " \t\r\n"); t; t = strtok(NULL, " \t\r\n")) tok.push_back(t);
+		if (tok.empty()) continue;
+
+		char* end = NULL;
+		unsigned long ms = strtoul(tok[0].c_str(), &end, 10);
+		if (*end != '\0' || tok.size() < 2 || ms < last)
+		{
+			fprintf(stderr, "%s:%d: 格式错误（时间不得递减）\n", path, no);
+			fclose(f);
+			return false;
+		}
+		last = (uint32_t)ms;
+
+		TraceEvent ev;
+		ev.time = last;
+		ev.cmd = tok[1];
+		ev.args.assign(tok.begin() + 2, tok.end());
+		ev.line = no;
+		out->push_back(ev);
+	}
+	fclose(f);
+	return true;
+}
+
+static lv_scr_load_anim_t parse_anim(const std::string& name)
+{
+	if (name == "left") return LV_SCR_LOAD_ANIM_MOVE_LEFT;
+	if (name == "right") return LV_SCR_LOAD_ANIM_MOVE_RIGHT;
+	if (name == "top") return LV_SCR_LOAD_ANIM_MOVE_TOP;
+	if (name == "bottom") return LV_SCR_LOAD_ANIM_MOVE_BOTTOM;
+	if (name == "fade") return LV_SCR_LOAD_ANIM_FADE_ON;
+	return LV_SCR_LOAD_ANIM_NONE;
+}
+
+/*------------------
+ * IMU轨迹与规则表
+ * -----------------*/
+
+/**
+ * 读取.imt轨迹（格式见固件imu_trace_format.h），末尾不完整的记录忽略
+ */
+static bool load_imt(const char* path, uint32_t* start_ms, std::vector<ImuTraceRecord>* out)
+{
+	FILE* f = fopen(path, "rb");
+	if (f == NULL)
+	{
+		fprintf(stderr, "无法打开IMU轨迹: %s\n", path);
+		return false;
+	}
+
+	ImuTraceHeader h;
+	if (fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, IMU_TRACE_MAGIC, 4) != 0 ||
+		h.version > IMU_TRACE_VERSION || h.header_size < sizeof(h))
+	{
+		fprintf(stderr, "%s: 不是IMU轨迹文件\n", path);
+		fclose(f);
+		return false;
+	}
+	fseek(f, h.header_size, SEEK_SET);
+	*start_ms = h.start_ms;
+
+	ImuTraceRecord r;
+	while (fread(&r, sizeof(r), 1, f) == 1) out->push_back(r);
+	fclose(f);
+	return true;
+}
+
+static bool load_rules(const char* path, std::vector<GestureRule>* out)
+{
+	static const char* const signal_names[GESTURE_SIG_COUNT] = { "ax", "ay", "jerk", "rotation" };
+
+	FILE* f = fopen(path, "r");
+	if (f == NULL)
+	{
+		fprintf(stderr, "无法打开规则文件: %s\n", path);
+		return false;
+	}
+
+	char line[256];
+	int no = 0;
+	while (fgets(line, sizeof(line), f))
+	{
+		no++;
+		char* hash = strchr(line, '#');
+		if (hash) *hash = '\0';
+
+		char type[32], sig[32];
+		int enter, exit, hold, repeat, refractory;
+		int n = sscanf(line, "%31s %31s %d %d %d %d %d", type, sig, &enter, &exit, &hold, &repeat, &refractory);
+		if (n <= 0) continue;
+
+		int s = -1;
+		for (int i = 0; i < GESTURE_SIG_COUNT; i++)
+		{
+			if (strcmp(sig, signal_names[i]) == 0) s = i;
+		}
+		GestureType t = gesture_from_name(type);
+		if (n != 7 || t == GESTURE_NONE || s < 0)
+		{
+			fprintf(stderr, "%s:%d: 规则格式错误\n", path, no);
+			fclose(f);
+			return false;
+		}
+		if (out->size() >= GESTURE_MAX_RULES)
+		{
+			fprintf(stderr, "%s:%d: 规则超过%d条\n", path, no, GESTURE_MAX_RULES);
+			fclose(f);
+			return false;
+		}
+
+		GestureRule r = { t, (GestureSignal)s, (int16_t)enter, (int16_t)exit,
+						  (uint16_t)hold, (uint16_t)repeat, (uint16_t)refractory };
+		out->push_back(r);
+	}
+	fclose(f);
+	return true;
+}
+
+/**
+ * 手势评估：回放一条.imt轨迹并打印报告
+ * @return 读取失败时返回false；漏检与误触发累加到*misses与*false_pos
+ */
+static bool run_gesture(const char* path, const std::vector<GestureRule>& rules, uint32_t* misses, uint32_t* false_pos)
+{
+	uint32_t start_ms;
+	std::vector<ImuTraceRecord> recs;
+	if (!load_imt(path, &start_ms, &recs)) return false;
+
+	GestureReplay* rp = new GestureReplay();
+	rp->begin(start_ms, rules.empty() ? NULL : rules.data(), (uint8_t)rules.size());
+	for (const ImuTraceRecord& r : recs) rp->feed(&r);
+	GestureReplayReport rep;
+	rp->finish(&rep);
+	delete rp;
+
+	printf("轨迹: %s（样本%u，%u ms，标注%u，识别%u，超出统计上限%u）\n", path, rep.samples, rep.duration_ms,
+		   rep.labels, rep.events, rep.dropped);
+	printf("  %-14s %6s %6s %6s %8s %10s %10s\n", "手势", "标注", "命中", "漏检", "误触发", "平均延迟ms", "最大延迟ms");
+	for (int i = 1; i < GESTURE_TYPE_COUNT; i++)
+	{
+		const GestureReplayStats& s = rep.type[i];
+		if (s.labels == 0 && s.hits == 0 && s.false_pos == 0) continue;
+		printf("  %-14s %6u %6u %6u %8u %10u %10u\n", gesture_name((GestureType)i), s.labels, s.hits, s.misses,
+			   s.false_pos, s.hits ? s.latency_sum_ms / s.hits : 0, s.latency_max_ms);
+		*misses += s.misses;
+		*false_pos += s.false_pos;
+	}
+	return true;
+}
+
+static void input_wake_cb(void)
+{
+	input_wake = true;
+}
+
+/**
+ * 回放器：IMU样本保持到下一条imu命令，按固定间隔送入手势引擎
+ */
+struct Replay
+{
+	GestureEngine gesture;
+	bool imu_on;
+	int16_t imu[6];
+	std::vector<ImuTraceRecord> imt;
+	size_t imt_next;
+	uint32_t imt_time;
+	lv_indev_state_t enc_state;
+	lv_group_t* group;
+	std::string snap_dir;
+
+	bool apply(const TraceEvent& ev, uint32_t now)
+	{
+		const std::vector<std::string>& a = ev.args;
+		if (ev.cmd == "logo")
+		{
+			lv_holo_cubic_gui();
+		}
+		else if (ev.cmd == "ui")
+		{
+			setup_ui(&guider_ui);
+		}
+		else if (ev.cmd == "load" && !a.empty() && (a[0] == "home" || a[0] == "scenes"))
+		{
+			gui_load(a[0] == "home" ? GUI_SCR_HOME : GUI_SCR_SCENES, parse_anim(a.size() > 1 ? a[1] : "none"));
+		}
+		else if (ev.cmd == "imu" && a.size() == 1 && a[0] == "off")
+		{
+			imu_on = false;
+		}
+		else if (ev.cmd == "imutrace" && a.size() == 1)
+		{
+			uint32_t start_ms;
+			imt.clear();
+			if (!load_imt(a[0].c_str(), &start_ms, &imt)) return false;
+			imt_next = 0;
+			imt_time = now;
+			imu_on = false;
+		}
+		else if (ev.cmd == "imu" && a.size() == 6)
+		{
+			for (int i = 0; i < 6; i++) imu[i] = (int16_t)atoi(a[i].c_str());
+			imu_on = true;
+		}
+		else if (ev.cmd == "enc" && a.size() == 1)
+		{
+			lv_port_indev_push((int16_t)atoi(a[0].c_str()), enc_state, now);
+		}
+		else if (ev.cmd == "press" || ev.cmd == "release")
+		{
+			enc_state = ev.cmd == "press" ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+			lv_port_indev_push(0, enc_state, now);
+		}
+		else if (ev.cmd == "focus")
+		{
+			if (group == NULL)
+			{
+				group = lv_group_create();
+				lv_indev_set_group(indev_encoder, group);
+			}
+			lv_group_remove_all_objs(group);
+			if (guider_ui.home_cpicker0) lv_group_add_obj(group, guider_ui.home_cpicker0);
+			lv_group_set_editing(group, true);
+		}
+		else if (ev.cmd == "snap" && a.size() == 1)
+		{
+			std::string path = snap_dir + "/" + a[0] + ".ppm";
+			if (!save_ppm(path)) fprintf(stderr, "无法写入截图: %s\n", path.c_str());
+		}
+		else if (ev.cmd != "end")
+		{
+			return false;
+		}
+		return true;
+	}
+
+	void tick(uint32_t now)
+	{
+		if (imu_on && now % BENCH_IMU_PERIOD_MS == 0)
+		{
+			gesture.feed(imu[0], imu[1], imu[2], imu[3], imu[4], imu[5], now);
+		}
+		// .imt样本按录制的间隔送入，标注记录只用于--gesture评估
+		while (imt_next < imt.size())
+		{
+			const ImuTraceRecord& r = imt[imt_next];
+			if (r.dt_ms != IMU_TRACE_LABEL)
+			{
+				if (imt_time + r.dt_ms > now) break;
+				imt_time += r.dt_ms;
+				gesture.feed(r.v[0], r.v[1], r.v[2], r.v[3], r.v[4], r.v[5], imt_time);
+			}
+			imt_next++;
+		}
+	}
+};
+
+/*------------------
+ * 报告
+ * -----------------*/
+
+static uint32_t percentile(std::vector<uint32_t> v, uint32_t pct)
+{
+	if (v.empty()) return 0;
+	std::sort(v.begin(), v.end());
+	size_t i = (v.size() - 1) * pct / 100;
+	return v[i];
+}
+
+/**
+ * 设备上的帧时间线：刷新任务每LV_DISP_DEF_REFR_PERIOD运行一次，
+ * 一帧在回放时刻与上一帧在设备上结束两者中较晚的时刻开始（单位微秒）
+ * @param late 输出各帧在设备上结束时刻相对回放时刻的滞后
+ * @return 各帧在设备上的开始时刻
+ */
+static std::vector<uint64_t> device_timeline(std::vector<uint32_t>* late)
+{
+	std::vector<uint64_t> start;
+	uint64_t end = 0;
+	for (const FrameRecord& r : frames)
+	{
+		uint64_t t = std::max((uint64_t)r.time_ms * 1000, end);
+		start.push_back(t);
+		end = t + r.pred_us;
+		late->push_back((uint32_t)(end - (uint64_t)r.time_ms * 1000));
+	}
+	return start;
+}
+
+static bool write_csv(const char* path)
+{
+	FILE* f = fopen(path, "w");
+	if (f == NULL) return false;
+	std::vector<uint32_t> late;
+	std::vector<uint64_t> start = device_timeline(&late);
+	fprintf(f, "frame,time_ms,px,frame_us,join_us,draw_us,flush_us,pred_us,pred_cpu_us,pred_spi_us,pred_sd_us,"
+			   "pred_start_us,pred_late_us,lv_used,lv_peak,sys_peak,crc32\n");
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		const FrameRecord& r = frames[i];
+		fprintf(f, "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%llu,%u,%u,%u,%u,%08x\n", (unsigned)i, r.time_ms, r.px,
+				r.us[RENDER_PROF_FRAME], r.us[RENDER_PROF_JOIN], r.us[RENDER_PROF_DRAW], r.us[RENDER_PROF_FLUSH],
+				r.pred_us, r.pred_cpu_us, r.pred_spi_us, r.pred_sd_us, (unsigned long long)start[i], late[i],
+				r.lv_used, r.lv_peak, r.sys_peak, r.crc);
+	}
+	fclose(f);
+	return true;
+}
+
+static void usage()
+{
+	fprintf(stderr,
+			"用法: lvgl_bench [选项] <轨迹文件>\n"
+			"  --sd DIR           'S:'盘对应的目录（默认sd）\n"
+			"  --lines N          绘制缓冲行数（默认%d）\n"
+			"  --csv FILE         逐帧记录写入CSV\n"
+			"  --snap-dir DIR     snap命令的截图目录（默认.）\n"
+			"  --split            按行拆分逐像素绘制（双核绘制，主机上两半依次执行，CRC应与不拆分时相同）\n"
+			"  --max-frame-us N   单帧耗时上限，超出时返回2\n"
+			"ESP32时序模型:\n"
+			"  --spi-mhz N        显示SPI时钟（默认%d）\n"
+			"  --cpu-scale X      设备与主机绘制耗时之比（默认%.1f）\n"
+			"  --sd-latency-us N  SD卡每次读取的延迟（默认%d）\n"
+			"  --sd-mhz N         SD卡有效位速率（默认%d）\n"
+			"  --flush MODE       dma（发送与绘制重叠，默认）或blocking\n"
+			"  --fps N            帧率目标，报告超出帧预算的帧数（默认%d）\n"
+			"  --max-pred-us N    预计单帧耗时上限，超出时返回2\n"
+			"  --max-mem BYTES    LVGL堆峰值上限，超出时返回2\n"
+			"手势评估（不运行界面）:\n"
+			"  --gesture FILE     回放.imt轨迹并统计识别延迟、漏检与误触发，可重复\n"
+			"  --rules FILE       使用规则文件代替默认规则表\n"
+			"  --max-fp N         误触发总数上限，超出时返回2\n"
+			"  --max-miss N       漏检总数上限，超出时返回2\n",
+			BENCH_BUF_LINES, BENCH_ESP32_SPI_MHZ, BENCH_ESP32_CPU_SCALE, BENCH_ESP32_SD_LATENCY_US, BENCH_ESP32_SD_MHZ,
+			BENCH_ESP32_FPS);
+}
+
+int main(int argc, char** argv)
+{
+	const char* sd = "sd";
+	const char* csv = NULL;
+	const char* trace = NULL;
+	uint16_t lines = BENCH_BUF_LINES;
+	uint32_t max_frame_us = 0;
+	uint32_t max_mem = 0;
+	uint32_t max_pred_us = 0;
+	Replay replay;
+	replay.snap_dir = ".";
+	std::vector<const char*> gesture_traces;
+	const char* rules_path = NULL;
+	long max_fp = -1;
+	long max_miss = -1;
+	bool split = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string opt = argv[i];
+		bool has_val = i + 1 < argc;
+		if (opt == "--sd" && has_val) sd = argv[++i];
+		else if (opt == "--lines" && has_val) lines = (uint16_t)std::min(std::max(atoi(argv[++i]), 1), LV_VER_RES_MAX);
+		else if (opt == "--csv" && has_val) csv = argv[++i];
+		else if (opt == "--snap-dir" && has_val) replay.snap_dir = argv[++i];
+		else if (opt == "--max-frame-us" && has_val) max_frame_us = strtoul(argv[++i], NULL, 10);
+		else if (opt == "--max-mem" && has_val) max_mem = strtoul(argv[++i], NULL, 10);
+		else if (opt == "--gesture" && has_val) gesture_traces.push_back(argv[++i]);
+		else if (opt == "--rules" && has_val) rules_path = argv[++i];
+		else if (opt == "--max-fp" && has_val) max_fp = strtol(argv[++i], NULL, 10);
+		else if (opt == "--max-miss" && has_val) max_miss = strtol(argv[++i], NULL, 10);
+		else if (opt == "--spi-mhz" && has_val) model.spi_mhz = std::max(atoi(argv[++i]), 1);
+		else if (opt == "--cpu-scale" && has_val) model.cpu_scale = std::max(atof(argv[++i]), 0.0);
+		else if (opt == "--sd-latency-us" && has_val) model.sd_latency_us = strtoul(argv[++i], NULL, 10);
+		else if (opt == "--sd-mhz" && has_val) model.sd_mhz = std::max(atoi(argv[++i]), 1);
+		else if (opt == "--fps" && has_val) model.fps = std::max(atoi(argv[++i]), 1);
+		else if (opt == "--max-pred-us" && has_val) max_pred_us = strtoul(argv[++i], NULL, 10);
+		else if (opt == "--flush" && has_val && (!strcmp(argv[i + 1], "dma") || !strcmp(argv[i + 1], "blocking")))
+			model.dma = !strcmp(argv[++i], "dma");
+		else if (opt == "--split") split = true;
+		else if (opt[0] != '-' && trace == NULL) trace = argv[i];
+		else
+		{
+			usage();
+			return 1;
+		}
+	}
+
+	std::vector<GestureRule> rules;
+	if (rules_path && !load_rules(rules_path, &rules)) return 1;
+	if (!gesture_traces.empty())
+	{
+		uint32_t misses = 0, false_pos = 0;
+		for (const char* path : gesture_traces)
+		{
+			if (!run_gesture(path, rules, &misses, &false_pos)) return 1;
+		}
+		printf("合计: 漏检 %u，误触发 %u\n", misses, false_pos);
+		int ret = 0;
+		if (max_miss >= 0 && misses > (uint32_t)max_miss)
+		{
+			printf("失败: 漏检%u次超过上限%ld\n", misses, max_miss);
+			ret = 2;
+		}
+		if (max_fp >= 0 && false_pos > (uint32_t)max_fp)
+		{
+			printf("失败: 误触发%u次超过上限%ld\n", false_pos, max_fp);
+			ret = 2;
+		}
+		return ret;
+	}
+
+	if (trace == NULL)
+	{
+		usage();
+		return 1;
+	}
+
+	std::vector<TraceEvent> events;
+	if (!load_trace(trace, &events) || events.empty()) return 1;
+
+	lv_port_mem_init();
+	lv_init();
+	premul_decoder_lv_init();
+	display_init(lines);
+	host_fs_init(sd);
+	draw_split_enable(split);
+	lv_port_indev_init();
+	lv_port_indev_set_wake_cb(input_wake_cb);
+	replay.gesture.init(rules.empty() ? NULL : rules.data(), (uint8_t)rules.size());
+	replay.imu_on = false;
+	replay.imt_next = 0;
+	replay.imt_time = 0;
+	replay.enc_state = LV_INDEV_STATE_REL;
+	replay.group = NULL;
+
+	uint32_t end_ms = events.back().time;
+	size_t next = 0;
+	for (uint32_t t = 0; t <= end_ms; t += BENCH_STEP_MS)
+	{
+		host_set_time(t);
+		while (next < events.size() && events[next].time <= t)
+		{
+			if (!replay.apply(events[next], t))
+			{
+				fprintf(stderr, "%s:%d: 未知命令 %s\n", trace, events[next].line, events[next].cmd.c_str());
+				return 1;
+			}
+			next++;
+		}
+		for (uint32_t s = t; s < t + BENCH_STEP_MS; s++) replay.tick(s);
+		// 与运行时任务相同：有输入唤醒时先恢复编码器读取
+		if (input_wake)
+		{
+			input_wake = false;
+			lv_port_indev_resume();
+		}
+		lv_task_handler();
+	}
+
+	if (csv && !write_csv(csv)) fprintf(stderr, "无法写入CSV: %s\n", csv);
+
+	std::vector<uint32_t> total, draw, flush, pred;
+	uint64_t px = 0;
+	uint64_t pred_cpu = 0, pred_spi = 0, pred_sd = 0;
+	for (const FrameRecord& r : frames)
+	{
+		total.push_back(r.us[RENDER_PROF_FRAME]);
+		draw.push_back(r.us[RENDER_PROF_DRAW]);
+		flush.push_back(r.us[RENDER_PROF_FLUSH]);
+		pred.push_back(r.pred_us);
+		px += r.px;
+		pred_cpu += r.pred_cpu_us;
+		pred_spi += r.pred_spi_us;
+		pred_sd += r.pred_sd_us;
+	}
+	uint32_t max_us = total.empty() ? 0 : *std::max_element(total.begin(), total.end());
+	uint32_t max_pred = pred.empty() ? 0 : *std::max_element(pred.begin(), pred.end());
+
+	// 连续重绘（相邻两帧的回放间隔不超过一个刷新周期）时设备上的帧间隔：刷新周期与预计耗时中较长者
+	uint32_t budget = 1000000 / model.fps;
+	uint32_t over = 0;
+	uint64_t anim_us = 0;
+	uint32_t anim_frames = 0;
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		if (frames[i].pred_us > budget) over++;
+		if (i == 0) continue;
+		uint32_t gap = frames[i].time_ms - frames[i - 1].time_ms;
+		if (gap > LV_DISP_DEF_REFR_PERIOD + BENCH_STEP_MS) continue;
+		anim_us += std::max<uint64_t>((uint64_t)gap * 1000, frames[i].pred_us);
+		anim_frames++;
+	}
+	std::vector<uint32_t> late;
+	device_timeline(&late);
+	uint32_t max_late = late.empty() ? 0 : *std::max_element(late.begin(), late.end());
+
+	lv_port_mem_stats_t mem;
+	lv_port_mem_get_stats(&mem);
+	host_heap_stats_t sys;
+	host_get_heap_stats(&sys);
+	lv_port_indev_stats_t in;
+	lv_port_indev_get_stats(&in);
+	uint32_t crc = crc32(framebuffer, sizeof(framebuffer));
+
+	printf("轨迹: %s（%u ms，绘制缓冲%u行）\n", trace, end_ms, lines);
+	printf("帧数: %u，像素: %llu\n", (unsigned)frames.size(), (unsigned long long)px);
+	printf("帧耗时(us): p50 %u, p95 %u, max %u\n", percentile(total, 50), percentile(total, 95), max_us);
+	printf("绘制(us):   p50 %u, p95 %u；刷新(us): p50 %u, p95 %u\n",
+		   percentile(draw, 50), percentile(draw, 95), percentile(flush, 50), percentile(flush, 95));
+	printf("ESP32预计(us): p50 %u, p95 %u, max %u（SPI %u MHz/%s，CPU系数%.1f；合计CPU %llu，SPI %llu，SD %llu）\n",
+		   percentile(pred, 50), percentile(pred, 95), max_pred, model.spi_mhz, model.dma ? "DMA" : "阻塞",
+		   model.cpu_scale, (unsigned long long)pred_cpu, (unsigned long long)pred_spi, (unsigned long long)pred_sd);
+	printf("ESP32预计: 连续重绘%.1f FPS（%u帧），超出%u FPS帧预算%u帧，最大滞后%u us\n",
+		   anim_us ? anim_frames * 1e6 / anim_us : 0.0, anim_frames, model.fps, over, max_late);
+	printf("LVGL堆: 峰值 %u 字节，当前 %u 字节，追加区域 %u，分配失败 %u，池满转TLSF %u\n",
+		   mem.max_used, mem.used_size, mem.grow_cnt, mem.fail_cnt, mem.pool_fallback);
+	printf("系统堆: 峰值 %u 字节（拒绝PSRAM申请 %u 次）\n", sys.peak, sys.spiram_refused);
+	printf("编码器: 交付 %u，过期 %u，溢出 %u\n", in.delivered, in.expired, in.overflow);
+	printf("最终画面CRC32: %08x\n", crc);
+
+	int ret = 0;
+	if (mem.fail_cnt)
+	{
+		printf("失败: LVGL堆分配失败%u次\n", mem.fail_cnt);
+		ret = 2;
+	}
+	if (max_frame_us && max_us > max_frame_us)
+	{
+		printf("失败: 单帧耗时%u us超过上限%u us\n", max_us, max_frame_us);
+		ret = 2;
+	}
+	if (max_pred_us && max_pred > max_pred_us)
+	{
+		printf("失败: 预计单帧耗时%u us超过上限%u us\n", max_pred, max_pred_us);
+		ret = 2;
+	}
+	if (max_mem && mem.max_used > max_mem)
+	{
+		printf("失败: LVGL堆峰值%u字节超过上限%u字节\n", mem.max_used, max_mem);
+		ret = 2;
+	}
+	return ret;
+}
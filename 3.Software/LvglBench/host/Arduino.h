@@ -0,0 +1,23 @@
+#ifndef LVGL_BENCH_ARDUINO_H
+#define LVGL_BENCH_ARDUINO_H
+
+/**
+ * 主机端替身：固件lv_conf.h的LV_TICK_CUSTOM_INCLUDE以及手势引擎、编码器端口用到的接口
+ * millis()返回回放的虚拟时间，与运行耗时无关，同一份轨迹每次产生相同的帧序列
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t millis(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
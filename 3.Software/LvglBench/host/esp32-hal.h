@@ -0,0 +1,9 @@
+#ifndef LVGL_BENCH_ESP32_HAL_H
+#define LVGL_BENCH_ESP32_HAL_H
+
+/**
+ * 主机端替身：lv_port_indev.c只用到millis()
+ */
+#include "Arduino.h"
+
+#endif
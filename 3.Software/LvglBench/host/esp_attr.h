@@ -0,0 +1,10 @@
+#ifndef LVGL_BENCH_ESP_ATTR_H
+#define LVGL_BENCH_ESP_ATTR_H
+
+/**
+ * 主机端替身：IRAM_ATTR等放置属性在主机上为空
+ */
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#endif
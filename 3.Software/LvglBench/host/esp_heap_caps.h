@@ -0,0 +1,27 @@
+#ifndef LVGL_BENCH_ESP_HEAP_CAPS_H
+#define LVGL_BENCH_ESP_HEAP_CAPS_H
+
+/**
+ * 主机端替身：按ESP32-PICO-D4（无PSRAM）的行为分配
+ * 申请MALLOC_CAP_SPIRAM时返回NULL，lv_port_mem与图片缓存走与设备相同的退路
+ */
+#include <stddef.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* heap_caps_malloc(size_t size, unsigned int caps);
+void* heap_caps_malloc_prefer(size_t size, size_t num, ...);
+void heap_caps_free(void* ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * 主机端移植层
+ *
+ * 固件的lvgl（lib/lvgl及其lv_conf.h）与界面代码原样编译，这里只替换依赖ESP32的部分：
+ * 1. millis：回放的虚拟时间，由bench按轨迹推进
+ * 2. heap_caps_*：按无PSRAM的设备分配，并统计系统堆峰值
+ * 3. asset_image：没有flash资源包，界面使用内置资源
+ * 4. 'S'盘：stdio实现的LVGL文件系统驱动，代替SD卡上的FATFS，统计读取次数与字节数（ESP32时序模型）
+ * 5. draw_split：LV_USE_DRAW_SPLIT的钩子，启用时两半在同一线程依次执行（检查按行拆分不改变画面）
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lvgl.h"
+#include "esp_heap_caps.h"
+#include "asset_bundle.h"
+#include "draw_split.h"
+#include "lv_port_host.h"
+
+/* 分配块前的记录头，保存大小用于统计释放量；16字节保持malloc的对齐 */
+#define HEAP_HEAD 16
+
+static uint32_t now_ms;
+static host_heap_stats_t heap_stats;
+static char fs_root[256];
+static host_fs_stats_t fs_stats;
+
+uint32_t millis(void)
+{
+	return now_ms;
+}
+
+void host_set_time(uint32_t ms)
+{
+	now_ms = ms;
+}
+
+void* heap_caps_malloc(size_t size, unsigned int caps)
+{
+	if (caps & MALLOC_CAP_SPIRAM)
+	{
+		heap_stats.spiram_refused++;
+		return NULL;
+	}
+
+	uint8_t* p = (uint8_t*)malloc(size + HEAP_HEAD);
+	if (p == NULL) return NULL;
+	*(size_t*)p = size;
+	heap_stats.used += size;
+	heap_stats.allocs++;
+	if (heap_stats.used > heap_stats.peak) heap_stats.peak = heap_stats.used;
+	return p + HEAP_HEAD;
+}
+
+/**
+ * 依次尝试各组能力（与ESP-IDF相同），直到分配成功
+ */
+void* heap_caps_malloc_prefer(size_t size, size_t num, ...)
+{
+	va_list args;
+	void* p = NULL;
+	va_start(args, num);
+	while (num-- && p == NULL) p = heap_caps_malloc(size, va_arg(args, unsigned int));
+	va_end(args);
+	return p;
+}
+
+void heap_caps_free(void* ptr)
+{
+	if (ptr == NULL) return;
+	uint8_t* p = (uint8_t*)ptr - HEAP_HEAD;
+	heap_stats.used -= *(size_t*)p;
+	free(p);
+}
+
+void host_get_heap_stats(host_heap_stats_t* stats)
+{
+	*stats = heap_stats;
+}
+
+const lv_img_dsc_t* asset_image(const char* name)
+{
+	(void)name;
+	return NULL;
+}
+
+/*------------------
+ * 'S'盘（stdio）
+ * -----------------*/
+
+typedef FILE* file_t;
+
+static uint64_t host_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static lv_fs_res_t fs_open(lv_fs_drv_t* drv, void* file_p, const char* path, lv_fs_mode_t mode)
+{
+	char full[512];
+	snprintf(full, sizeof(full), "%s/%s", fs_root, path[0] == '/' ? path + 1 : path);
+	FILE* f = fopen(full, mode == LV_FS_MODE_WR ? "wb" : (mode & LV_FS_MODE_WR) ? "rb+" : "rb");
+	if (f == NULL) return LV_FS_RES_NOT_EX;
+	*(file_t*)file_p = f;
+	return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_close(lv_fs_drv_t* drv, void* file_p)
+{
+	fclose(*(file_t*)file_p);
+	return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_read(lv_fs_drv_t* drv, void* file_p, void* buf, uint32_t btr, uint32_t* br)
+{
+	uint64_t start = host_us();
+	*br = (uint32_t)fread(buf, 1, btr, *(file_t*)file_p);
+	fs_stats.host_us += host_us() - start;
+	fs_stats.reads++;
+	fs_stats.bytes += *br;
+	return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_write(lv_fs_drv_t* drv, void* file_p, const void* buf, uint32_t btw, uint32_t* bw)
+{
+	*bw = (uint32_t)fwrite(buf, 1, btw, *(file_t*)file_p);
+	return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_seek(lv_fs_drv_t* drv, void* file_p, uint32_t pos)
+{
+	return fseek(*(file_t*)file_p, pos, SEEK_SET) == 0 ? LV_FS_RES_OK : LV_FS_RES_UNKNOWN;
+}
+
+static lv_fs_res_t fs_tell(lv_fs_drv_t* drv, void* file_p, uint32_t* pos_p)
+{
+	*pos_p = (uint32_t)ftell(*(file_t*)file_p);
+	return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_size(lv_fs_drv_t* drv, void* file_p, uint32_t* size_p)
+{
+	FILE* f = *(file_t*)file_p;
+	long pos = ftell(f);
+	fseek(f, 0, SEEK_END);
+	*size_p = (uint32_t)ftell(f);
+	fseek(f, pos, SEEK_SET);
+	return LV_FS_RES_OK;
+}
+
+void host_fs_init(const char* root)
+{
+	strncpy(fs_root, root, sizeof(fs_root) - 1);
+
+	static lv_fs_drv_t drv;
+	lv_fs_drv_init(&drv);
+	drv.letter = 'S';
+	drv.file_size = sizeof(file_t);
+	drv.open_cb = fs_open;
+	drv.close_cb = fs_close;
+	drv.read_cb = fs_read;
+	drv.write_cb = fs_write;
+	drv.seek_cb = fs_seek;
+	drv.tell_cb = fs_tell;
+	drv.size_cb = fs_size;
+	lv_fs_drv_register(&drv);
+}
+
+void host_get_fs_stats(host_fs_stats_t* stats)
+{
+	*stats = fs_stats;
+}
+
+static bool split_enabled;
+static bool split_busy;
+static draw_split_stats_t split_stats;
+
+bool draw_split_enable(bool en)
+{
+	split_enabled = en;
+	return true;
+}
+
+bool draw_split_is_enabled(void)
+{
+	return split_enabled;
+}
+
+bool draw_split_ready(uint32_t px)
+{
+	return split_enabled && !split_busy && px >= DRAW_SPLIT_MIN_PX;
+}
+
+void draw_split_run(draw_split_cb_t cb, void* ctx, int32_t rows)
+{
+	if (rows < 2 || !draw_split_ready(DRAW_SPLIT_MIN_PX))
+	{
+		cb(ctx, 0, rows - 1);
+		return;
+	}
+
+	/* 与设备相同：前一半执行期间的嵌套调用不再拆分 */
+	split_busy = true;
+	cb(ctx, 0, rows / 2 - 1);
+	cb(ctx, rows / 2, rows - 1);
+	split_busy = false;
+	split_stats.jobs++;
+}
+
+void draw_split_get_stats(draw_split_stats_t* out)
+{
+	*out = split_stats;
+}
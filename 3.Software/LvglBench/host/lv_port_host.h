@@ -0,0 +1,39 @@
+#ifndef LVGL_BENCH_LV_PORT_HOST_H
+#define LVGL_BENCH_LV_PORT_HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	/* 系统堆（heap_caps_malloc）统计：lv_port_mem的堆区域、图片缓存、取色器缓存都计入 */
+	typedef struct
+	{
+		uint32_t used;
+		uint32_t peak;
+		uint32_t allocs;
+		uint32_t spiram_refused;  // 申请PSRAM被拒绝的次数（设备无PSRAM）
+	} host_heap_stats_t;
+
+	/* 'S'盘读取统计：ESP32时序模型按次数与字节数估算SD卡耗时，主机上的读取耗时从绘制时间中扣除 */
+	typedef struct
+	{
+		uint32_t reads;
+		uint32_t bytes;
+		uint64_t host_us;  // 主机上fread的累计耗时
+	} host_fs_stats_t;
+
+	// 回放时钟（millis()的返回值）
+	void host_set_time(uint32_t ms);
+	void host_get_heap_stats(host_heap_stats_t* stats);
+	// 注册LVGL文件系统驱动'S'，路径映射到主机目录root下（对应SD卡根目录）
+	void host_fs_init(const char* root);
+	void host_get_fs_stats(host_fs_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif